@@ -31,15 +31,114 @@ benchmark_c_flags = \
 
 benchmark_src_files = \
     benchmark_main.cpp \
+    dns_benchmark.cpp \
+    execinfo_benchmark.cpp \
+    linker_benchmark.cpp \
+    malloc_benchmark.cpp \
     math_benchmark.cpp \
+    math_matrix_benchmark.cpp \
+    mntent_benchmark.cpp \
     property_benchmark.cpp \
     pthread_benchmark.cpp \
+    regex_benchmark.cpp \
     semaphore_benchmark.cpp \
+    startup_benchmark.cpp \
     stdio_benchmark.cpp \
+    stdlib_benchmark.cpp \
     string_benchmark.cpp \
+    string_matrix_benchmark.cpp \
     time_benchmark.cpp \
     unistd_benchmark.cpp \
 
+# The benchmarks that don't depend on bionic, for comparison with glibc. The
+# others need system properties, bionic's resolver, or executables that only
+# exist in a bionic build.
+benchmark_src_files_glibc = $(filter-out \
+    dns_benchmark.cpp \
+    linker_benchmark.cpp \
+    property_benchmark.cpp \
+    startup_benchmark.cpp \
+    ,$(benchmark_src_files))
+
+# -----------------------------------------------------------------------------
+# Synthetic libraries and executable for linker_benchmark.cpp.
+# -----------------------------------------------------------------------------
+
+# $(1): module name, $(2): cflags, $(3): shared libraries.
+define linker-benchmark-library
+include $$(CLEAR_VARS)
+LOCAL_MODULE := $(1)
+LOCAL_MODULE_TAGS := optional
+LOCAL_MULTILIB := both
+LOCAL_ADDITIONAL_DEPENDENCIES := $$(LOCAL_PATH)/Android.mk
+LOCAL_CFLAGS += $$(benchmark_c_flags) $(2)
+LOCAL_SHARED_LIBRARIES := $(3)
+LOCAL_SRC_FILES := linker_benchmark_library.cpp
+include $$(BUILD_SHARED_LIBRARY)
+endef
+
+$(eval $(call linker-benchmark-library,libbionic-benchmark-linker-symbols-100,-DBENCH_SYMBOLS=BENCH_R100,))
+$(eval $(call linker-benchmark-library,libbionic-benchmark-linker-symbols-1000,-DBENCH_SYMBOLS=BENCH_R1000,))
+$(eval $(call linker-benchmark-library,libbionic-benchmark-linker-symbols-10000,-DBENCH_SYMBOLS=BENCH_R10000,))
+
+# A chain of DT_NEEDED libraries: depth-N needs depth-(N-1).
+$(eval $(call linker-benchmark-library,libbionic-benchmark-linker-depth-1,-DBENCH_SYMBOLS=BENCH_R100 -DBENCH_DEPTH=1,))
+$(foreach depth,2 3 4 5 6 7 8, \
+  $(eval $(call linker-benchmark-library,libbionic-benchmark-linker-depth-$(depth), \
+      -DBENCH_SYMBOLS=BENCH_R100 -DBENCH_DEPTH=$(depth) -DBENCH_DEPTH_PREVIOUS=$(shell expr $(depth) - 1), \
+      libbionic-benchmark-linker-depth-$(shell expr $(depth) - 1))))
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := bionic-benchmark-linker-exec
+LOCAL_MODULE_STEM_32 := bionic-benchmark-linker-exec32
+LOCAL_MODULE_STEM_64 := bionic-benchmark-linker-exec64
+LOCAL_MODULE_TAGS := optional
+LOCAL_MULTILIB := both
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
+LOCAL_CFLAGS += $(benchmark_c_flags)
+LOCAL_SHARED_LIBRARIES := libbionic-benchmark-linker-depth-8 libbionic-benchmark-linker-symbols-1000
+LOCAL_SRC_FILES := linker_benchmark_exec.cpp
+include $(BUILD_EXECUTABLE)
+
+linker_benchmark_exec_modules := \
+    bionic-benchmark-linker-exec \
+
+linker_benchmark_modules := \
+    $(linker_benchmark_exec_modules) \
+    libbionic-benchmark-linker-symbols-100 \
+    libbionic-benchmark-linker-symbols-1000 \
+    libbionic-benchmark-linker-symbols-10000 \
+    $(foreach depth,1 2 3 4 5 6 7 8,libbionic-benchmark-linker-depth-$(depth)) \
+
+# -----------------------------------------------------------------------------
+# Minimal executables for startup_benchmark.cpp.
+# -----------------------------------------------------------------------------
+
+# $(1): module name, $(2): true for a static executable.
+define startup-benchmark-exec
+include $$(CLEAR_VARS)
+LOCAL_MODULE := $(1)
+LOCAL_MODULE_STEM_32 := $(1)32
+LOCAL_MODULE_STEM_64 := $(1)64
+LOCAL_MODULE_TAGS := optional
+LOCAL_MULTILIB := both
+LOCAL_ADDITIONAL_DEPENDENCIES := $$(LOCAL_PATH)/Android.mk
+LOCAL_CFLAGS += $$(benchmark_c_flags)
+LOCAL_FORCE_STATIC_EXECUTABLE := $(2)
+ifeq ($(2),true)
+LOCAL_STATIC_LIBRARIES := libc
+endif
+LOCAL_SRC_FILES := startup_benchmark_exec.cpp
+include $$(BUILD_EXECUTABLE)
+endef
+
+$(eval $(call startup-benchmark-exec,bionic-benchmark-startup-static,true))
+$(eval $(call startup-benchmark-exec,bionic-benchmark-startup-dynamic,false))
+
+startup_benchmark_modules := \
+    bionic-benchmark-startup-dynamic \
+    bionic-benchmark-startup-static \
+
 # Build benchmarks for the device (with bionic's .so). Run with:
 #   adb shell bionic-benchmarks
 include $(CLEAR_VARS)
@@ -49,20 +148,54 @@ LOCAL_MODULE_STEM_64 := bionic-benchmarks64
 LOCAL_MULTILIB := both
 LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
 LOCAL_CFLAGS += $(benchmark_c_flags)
-LOCAL_C_INCLUDES += external/stlport/stlport bionic/ bionic/libstdc++/include
-LOCAL_SHARED_LIBRARIES += libstlport
+LOCAL_C_INCLUDES += external/stlport/stlport bionic/ bionic/libstdc++/include bionic/libc/dns/include
+LOCAL_SHARED_LIBRARIES += libdl libstlport
 LOCAL_SRC_FILES := $(benchmark_src_files)
+LOCAL_REQUIRED_MODULES := $(linker_benchmark_modules) $(startup_benchmark_modules)
 include $(BUILD_EXECUTABLE)
 
 ifeq ($(HOST_OS)-$(HOST_ARCH),$(filter $(HOST_OS)-$(HOST_ARCH),linux-x86 linux-x86_64))
-ifeq ($(TARGET_ARCH),x86)
-LINKER = linker
-NATIVE_SUFFIX=32
-else
+
+# -----------------------------------------------------------------------------
+# The same benchmarks built for the host and linked against glibc, to compare
+# with bionic on the same machine. Run with:
+#   cd bionic/benchmarks; mm bionic-benchmarks-glibc-run
+# -----------------------------------------------------------------------------
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := bionic-benchmarks-glibc
+LOCAL_MODULE_STEM_32 := bionic-benchmarks-glibc32
+LOCAL_MODULE_STEM_64 := bionic-benchmarks-glibc64
+LOCAL_MODULE_TAGS := optional
+LOCAL_MULTILIB := both
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
+LOCAL_CFLAGS += $(benchmark_c_flags)
+LOCAL_LDLIBS += -lrt -ldl -lpthread
+LOCAL_SRC_FILES := $(benchmark_src_files_glibc)
+include $(BUILD_HOST_EXECUTABLE)
+
+ifneq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),arm mips x86))
 LINKER = linker64
 NATIVE_SUFFIX=64
+else
+LINKER = linker
+NATIVE_SUFFIX=32
 endif
 
+# BIONIC_BENCHMARKS_FLAGS is either empty or it comes from the user.
+bionic-benchmarks-glibc-run: bionic-benchmarks-glibc
+	$(HOST_OUT_EXECUTABLES)/bionic-benchmarks-glibc$(NATIVE_SUFFIX) $(BIONIC_BENCHMARKS_FLAGS)
+
+# -----------------------------------------------------------------------------
+# Run the benchmarks built against x86 bionic on an x86 host, with the linker
+# and libraries from the build rather than a device. Run with:
+#   cd bionic/benchmarks; mm bionic-benchmarks-run-on-host
+# and, with an x86_64 target, bionic-benchmarks-run-on-host32 for the 32-bit
+# build. The executables the linker and startup benchmarks run are expected
+# in /system/bin, so they're copied there along with the linker.
+# -----------------------------------------------------------------------------
+
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86 x86_64))
 bionic-benchmarks-run-on-host: bionic-benchmarks $(TARGET_OUT_EXECUTABLES)/$(LINKER) $(TARGET_OUT_EXECUTABLES)/sh
 	if [ ! -d /system -o ! -d /system/bin ]; then \
 	  echo "Attempting to create /system/bin"; \
@@ -71,10 +204,31 @@ bionic-benchmarks-run-on-host: bionic-benchmarks $(TARGET_OUT_EXECUTABLES)/$(LIN
 	mkdir -p $(TARGET_OUT_DATA)/local/tmp
 	cp $(TARGET_OUT_EXECUTABLES)/$(LINKER) /system/bin
 	cp $(TARGET_OUT_EXECUTABLES)/sh /system/bin
+	cp $(foreach m,$(linker_benchmark_exec_modules) $(startup_benchmark_modules), \
+	    $(TARGET_OUT_EXECUTABLES)/$(m)$(NATIVE_SUFFIX)) /system/bin
 	ANDROID_DATA=$(TARGET_OUT_DATA) \
 	ANDROID_ROOT=$(TARGET_OUT) \
 	LD_LIBRARY_PATH=$(TARGET_OUT_SHARED_LIBRARIES) \
 		$(TARGET_OUT_EXECUTABLES)/bionic-benchmarks$(NATIVE_SUFFIX) $(BIONIC_BENCHMARKS_FLAGS)
+endif
+
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86_64))
+bionic-benchmarks-run-on-host32: bionic-benchmarks_32 $(TARGET_OUT_EXECUTABLES)/linker $(TARGET_OUT_EXECUTABLES)/sh
+	if [ ! -d /system -o ! -d /system/bin ]; then \
+	  echo "Attempting to create /system/bin"; \
+	  sudo mkdir -p -m 0777 /system/bin; \
+	fi
+	mkdir -p $(TARGET_OUT_DATA)/local/tmp
+	cp $(TARGET_OUT_EXECUTABLES)/linker /system/bin
+	cp $(TARGET_OUT_EXECUTABLES)/sh /system/bin
+	cp $(foreach m,$(linker_benchmark_exec_modules) $(startup_benchmark_modules), \
+	    $(TARGET_OUT_EXECUTABLES)/$(m)32) /system/bin
+	ANDROID_DATA=$(TARGET_OUT_DATA) \
+	ANDROID_ROOT=$(TARGET_OUT) \
+	LD_LIBRARY_PATH=$(2ND_TARGET_OUT_SHARED_LIBRARIES) \
+		$(TARGET_OUT_EXECUTABLES)/bionic-benchmarks32 $(BIONIC_BENCHMARKS_FLAGS)
+endif
+
 endif # linux-x86
 
 endif # !BUILD_TINY_ANDROID
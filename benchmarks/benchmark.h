@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <vector>
@@ -32,6 +33,15 @@ class Benchmark {
 
   Benchmark* Arg(int x);
 
+  // Runs the benchmark on this many threads at once, each pinned to its own
+  // CPU, rather than on the calling thread. Call it once per thread count to
+  // see how the benchmark scales. Each thread runs the whole benchmark body with the same iteration count;
+  // ns/op is then per thread, and the aggregate throughput is reported too.
+  // Anything the threads should contend on must be shared: a static, say.
+  Benchmark* Threads(int n);
+  // Threads(n) for the number of CPUs we're allowed to run on.
+  Benchmark* ThreadPerCpu();
+
   const char* Name();
 
   bool ShouldRun(int argc, char* argv[]);
@@ -44,15 +54,23 @@ class Benchmark {
   void (*fn_range_)(int, int);
 
   std::vector<int> args_;
+  std::vector<int> thread_counts_;
 
   void Register(const char* name, void (*fn)(int), void (*fn_range)(int, int));
-  void RunRepeatedlyWithArg(int iterations, int arg);
-  void RunWithArg(int arg);
+  void RunRepeatedlyWithArg(int iterations, int arg, int threads);
+  void RunOnThreads(int iterations, int arg, int threads);
+  void RunWithArg(int arg, int threads);
 };
 
 }  // namespace testing
 
+// Like the timing calls below, these apply to the calling thread; with
+// Threads(), each thread's bytes are added up.
 void SetBenchmarkBytesProcessed(int64_t);
+// For operations whose cost varies from call to call: records how long one
+// took, so the median, 90th and 99th percentiles are reported too. Call it
+// from the benchmark's own thread.
+void AddBenchmarkLatency(int64_t ns);
 void StopBenchmarkTiming();
 void StartBenchmarkTiming();
 
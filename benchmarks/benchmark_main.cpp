@@ -16,24 +16,93 @@
 
 #include "benchmark.h"
 
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <math.h>
+#include <pthread.h>
 #include <regex.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <string>
 #include <map>
+#include <vector>
 
 #include <inttypes.h>
+#include <limits.h>
 
-static int64_t g_bytes_processed;
-static int64_t g_benchmark_total_time_ns;
-static int64_t g_benchmark_start_time_ns;
+// The hardware counters read around each run. Cycles are counted whenever
+// the kernel lets us; the rest only with --counters, since each one costs
+// another read(2) in every Start/StopBenchmarkTiming.
+enum Counter {
+  kCycles,
+  kInstructions,
+  kCacheMisses,
+  kBranchMisses,
+  kCounterCount
+};
+
+struct CounterInfo {
+  uint64_t config;
+  const char* name;  // For text output.
+  const char* key;  // For JSON and CSV output.
+};
+
+static const CounterInfo kCounterInfo[kCounterCount] = {
+  { PERF_COUNT_HW_CPU_CYCLES, "cycles", "cycles_per_op" },
+  { PERF_COUNT_HW_INSTRUCTIONS, "insns", "instructions_per_op" },
+  { PERF_COUNT_HW_CACHE_MISSES, "cache-misses", "cache_misses_per_op" },
+  { PERF_COUNT_HW_BRANCH_MISSES, "branch-misses", "branch_misses_per_op" },
+};
+
+static int g_counter_count = 1;
+
+// Each thread of a Threads() benchmark keeps its own time and counts.
+static __thread int64_t g_bytes_processed;
+static __thread int64_t g_benchmark_total_time_ns;
+static __thread int64_t g_benchmark_start_time_ns;
+static __thread int64_t g_benchmark_total_counts[kCounterCount];
+static __thread int64_t g_benchmark_start_counts[kCounterCount];
+static __thread int g_counter_fds[kCounterCount] = { -1, -1, -1, -1 };
+static __thread std::vector<int64_t>* g_latencies_ns;
+static std::vector<int64_t> g_main_thread_latencies_ns;
+
+// How long the slowest thread of the last run took; the same as
+// g_benchmark_total_time_ns when the benchmark runs on the calling thread.
+static int64_t g_benchmark_wall_time_ns;
+
+// The CPUs threaded benchmarks are spread over: all those we could run on
+// at startup, not just the one --cpu pins the main thread to.
+static std::vector<int> g_benchmark_cpus;
 
 typedef std::map<std::string, ::testing::Benchmark*> BenchmarkMap;
 typedef BenchmarkMap::iterator BenchmarkMapIt;
 static BenchmarkMap g_benchmarks;
 static int g_name_column_width = 20;
 
+// How many times each benchmark is measured once its iteration count is settled.
+static int g_repetitions = 1;
+
+enum OutputFormat {
+  kOutputText,
+  kOutputJson,
+  kOutputCsv,
+};
+static OutputFormat g_output_format = kOutputText;
+static FILE* g_out;
+static bool g_need_header = true;
+
+// A difference is only reported as significant if it's at least this big...
+static double g_threshold_percent = 5;
+// ...and this unlikely to be chance.
+static const double kSignificanceLevel = 0.05;
+
 static int Round(int n) {
   int base = 1;
   while (base*10 < n) {
@@ -55,6 +124,244 @@ static int64_t NanoTime() {
   return static_cast<int64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
 }
 
+// Counts user-space events for this thread, if the kernel lets us. The
+// counters form one group, so the kernel only ever runs them all together
+// and the counts are comparable.
+static void OpenCounters() {
+  for (int i = 0; i < g_counter_count; ++i) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = kCounterInfo[i].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int group_fd = (i == kCycles) ? -1 : g_counter_fds[kCycles];
+    g_counter_fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+  }
+}
+
+static void CloseCounters() {
+  for (int i = 0; i < g_counter_count; ++i) {
+    if (g_counter_fds[i] != -1) {
+      close(g_counter_fds[i]);
+      g_counter_fds[i] = -1;
+    }
+  }
+}
+
+// Counters we couldn't open read as 0, and so go unreported.
+static void ReadCounters(int64_t* counts) {
+  for (int i = 0; i < g_counter_count; ++i) {
+    uint64_t count;
+    if (g_counter_fds[i] == -1 || read(g_counter_fds[i], &count, sizeof(count)) != sizeof(count)) {
+      counts[i] = 0;
+    } else {
+      counts[i] = static_cast<int64_t>(count);
+    }
+  }
+}
+
+static double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return (n % 2 == 1) ? values[n/2] : (values[n/2 - 1] + values[n/2]) / 2;
+}
+
+// The CPUs we're allowed to run on.
+static std::vector<int> AvailableCpus() {
+  std::vector<int> cpus;
+  cpu_set_t available;
+  if (sched_getaffinity(0, sizeof(available), &available) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &available)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+static double Mean(const std::vector<double>& values) {
+  double sum = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    sum += values[i];
+  }
+  return sum / values.size();
+}
+
+// The sample standard deviation.
+static double Stddev(const std::vector<double>& values) {
+  if (values.size() < 2) {
+    return 0;
+  }
+  double mean = Mean(values);
+  double sum = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    sum += (values[i] - mean) * (values[i] - mean);
+  }
+  return sqrt(sum / (values.size() - 1));
+}
+
+struct BenchmarkResult {
+  std::string name;
+  int iterations;
+  std::vector<double> ns_per_op;  // One per repetition.
+  double counts_per_op[kCounterCount];  // Medians, or 0 without the counter.
+  double bytes_per_second;  // Median, or 0 if the benchmark doesn't say.
+  double bytes_per_cycle;  // Median, or 0 if either of the above is 0.
+  std::vector<int64_t> latencies_ns;  // Sorted, from all repetitions.
+  int threads;  // 0 if run on the calling thread.
+  double ops_per_second;  // Median, from all threads together.
+};
+
+static void ReportText(const BenchmarkResult& r) {
+  if (g_need_header) {
+    fprintf(g_out, "%-*s %10s %10s\n", g_name_column_width, "", "iterations", "ns/op");
+    g_need_header = false;
+  }
+
+  // With repetitions, ns/op is the median, and we say how much it varied.
+  double median = Median(r.ns_per_op);
+  char spread[64];
+  spread[0] = '\0';
+  if (r.ns_per_op.size() > 1) {
+    snprintf(spread, sizeof(spread), " +-%5.1f%% min %.0f",
+             (median > 0) ? 100 * Stddev(r.ns_per_op) / median : 0.0,
+             *std::min_element(r.ns_per_op.begin(), r.ns_per_op.end()));
+  }
+
+  // Cheap calls take a few nanoseconds, so cycles are the finer measure.
+  char counts[160];
+  counts[0] = '\0';
+  for (int i = 0; i < kCounterCount; ++i) {
+    if (r.counts_per_op[i] > 0) {
+      // Misses are usually rare, so they need more places.
+      size_t used = strlen(counts);
+      snprintf(counts + used, sizeof(counts) - used, " %8.*f %s/op",
+               (i == kCycles || i == kInstructions) ? 1 : 3, r.counts_per_op[i],
+               kCounterInfo[i].name);
+    }
+  }
+
+  char throughput[100];
+  throughput[0] = '\0';
+  if (r.bytes_per_second > 0) {
+    snprintf(throughput, sizeof(throughput), " %8.2f MiB/s", r.bytes_per_second/1e6);
+    if (r.bytes_per_cycle > 0) {
+      size_t used = strlen(throughput);
+      snprintf(throughput + used, sizeof(throughput) - used, " %6.2f B/cycle", r.bytes_per_cycle);
+    }
+  }
+
+  char aggregate[64];
+  aggregate[0] = '\0';
+  if (r.threads > 0) {
+    snprintf(aggregate, sizeof(aggregate), " %10.3f Mops/s total", r.ops_per_second/1e6);
+  }
+
+  char latencies[100];
+  latencies[0] = '\0';
+  if (!r.latencies_ns.empty()) {
+    size_t n = r.latencies_ns.size();
+    snprintf(latencies, sizeof(latencies), " p50 %" PRId64 " p90 %" PRId64 " p99 %" PRId64 " ns",
+             r.latencies_ns[n/2], r.latencies_ns[n*9/10], r.latencies_ns[n*99/100]);
+  }
+
+  fprintf(g_out, "%-*s %10d %10.0f%s%s%s%s%s\n", g_name_column_width, r.name.c_str(),
+          r.iterations, median, spread, counts, throughput, aggregate, latencies);
+}
+
+// Writes one benchmark per line, which is what --compare relies on.
+static void ReportJson(const BenchmarkResult& r) {
+  fprintf(g_out, "%s    {\"name\": \"", g_need_header ? "{\n  \"benchmarks\": [\n" : ",\n");
+  g_need_header = false;
+  for (size_t i = 0; i < r.name.size(); ++i) {
+    if (r.name[i] == '"' || r.name[i] == '\\') {
+      fputc('\\', g_out);
+    }
+    fputc(r.name[i], g_out);
+  }
+  fprintf(g_out, "\", \"iterations\": %d, \"repetitions\": %zu", r.iterations, r.ns_per_op.size());
+  fprintf(g_out, ", \"ns_per_op\": %.3f, \"mean_ns_per_op\": %.3f, \"stddev_ns_per_op\": %.3f",
+          Median(r.ns_per_op), Mean(r.ns_per_op), Stddev(r.ns_per_op));
+  fprintf(g_out, ", \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f",
+          *std::min_element(r.ns_per_op.begin(), r.ns_per_op.end()),
+          *std::max_element(r.ns_per_op.begin(), r.ns_per_op.end()));
+  fprintf(g_out, ", \"samples\": [");
+  for (size_t i = 0; i < r.ns_per_op.size(); ++i) {
+    fprintf(g_out, "%s%.3f", (i == 0) ? "" : ", ", r.ns_per_op[i]);
+  }
+  fprintf(g_out, "]");
+  for (int i = 0; i < kCounterCount; ++i) {
+    if (r.counts_per_op[i] > 0) {
+      fprintf(g_out, ", \"%s\": %.3f", kCounterInfo[i].key, r.counts_per_op[i]);
+    }
+  }
+  if (r.bytes_per_second > 0) {
+    fprintf(g_out, ", \"bytes_per_second\": %.0f", r.bytes_per_second);
+  }
+  if (r.threads > 0) {
+    fprintf(g_out, ", \"threads\": %d, \"ops_per_second\": %.0f", r.threads, r.ops_per_second);
+  }
+  if (!r.latencies_ns.empty()) {
+    size_t n = r.latencies_ns.size();
+    fprintf(g_out, ", \"latency_ns\": {\"p50\": %" PRId64 ", \"p90\": %" PRId64
+            ", \"p99\": %" PRId64 "}",
+            r.latencies_ns[n/2], r.latencies_ns[n*9/10], r.latencies_ns[n*99/100]);
+  }
+  fprintf(g_out, "}");
+}
+
+static void ReportCsv(const BenchmarkResult& r) {
+  if (g_need_header) {
+    fprintf(g_out, "name,iterations,repetitions,ns_per_op,mean_ns_per_op,stddev_ns_per_op,"
+            "min_ns_per_op,max_ns_per_op,cycles_per_op,bytes_per_second,p50_ns,p90_ns,p99_ns,"
+            "threads,ops_per_second,instructions_per_op,cache_misses_per_op,"
+            "branch_misses_per_op\n");
+    g_need_header = false;
+  }
+  fprintf(g_out, "%s,%d,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,", r.name.c_str(), r.iterations,
+          r.ns_per_op.size(), Median(r.ns_per_op), Mean(r.ns_per_op), Stddev(r.ns_per_op),
+          *std::min_element(r.ns_per_op.begin(), r.ns_per_op.end()),
+          *std::max_element(r.ns_per_op.begin(), r.ns_per_op.end()));
+  if (r.counts_per_op[kCycles] > 0) {
+    fprintf(g_out, "%.3f", r.counts_per_op[kCycles]);
+  }
+  fprintf(g_out, ",");
+  if (r.bytes_per_second > 0) {
+    fprintf(g_out, "%.0f", r.bytes_per_second);
+  }
+  if (!r.latencies_ns.empty()) {
+    size_t n = r.latencies_ns.size();
+    fprintf(g_out, ",%" PRId64 ",%" PRId64 ",%" PRId64,
+            r.latencies_ns[n/2], r.latencies_ns[n*9/10], r.latencies_ns[n*99/100]);
+  } else {
+    fprintf(g_out, ",,,");
+  }
+  if (r.threads > 0) {
+    fprintf(g_out, ",%d,%.0f", r.threads, r.ops_per_second);
+  } else {
+    fprintf(g_out, ",,");
+  }
+  for (int i = kInstructions; i < kCounterCount; ++i) {
+    fprintf(g_out, ",");
+    if (r.counts_per_op[i] > 0) {
+      fprintf(g_out, "%.3f", r.counts_per_op[i]);
+    }
+  }
+  fprintf(g_out, "\n");
+}
+
+static void Report(const BenchmarkResult& r) {
+  switch (g_output_format) {
+    case kOutputText: ReportText(r); break;
+    case kOutputJson: ReportJson(r); break;
+    case kOutputCsv: ReportCsv(r); break;
+  }
+  fflush(g_out);
+}
+
 namespace testing {
 
 Benchmark* Benchmark::Arg(int arg) {
@@ -62,6 +369,19 @@ Benchmark* Benchmark::Arg(int arg) {
   return this;
 }
 
+Benchmark* Benchmark::Threads(int n) {
+  if (n < 1) {
+    fprintf(stderr, "%s: bad thread count %d\n", name_, n);
+    exit(EXIT_FAILURE);
+  }
+  thread_counts_.push_back(n);
+  return this;
+}
+
+Benchmark* Benchmark::ThreadPerCpu() {
+  return Threads(std::max(1, static_cast<int>(AvailableCpus().size())));
+}
+
 const char* Benchmark::Name() {
   return name_;
 }
@@ -101,37 +421,144 @@ void Benchmark::Register(const char* name, void (*fn)(int), void (*fn_range)(int
 }
 
 void Benchmark::Run() {
+  std::vector<int> args(args_);
   if (fn_ != NULL) {
-    RunWithArg(0);
-  } else {
-    if (args_.empty()) {
-      fprintf(stderr, "%s: no args!\n", name_);
-      exit(EXIT_FAILURE);
+    args.assign(1, 0);
+  } else if (args.empty()) {
+    fprintf(stderr, "%s: no args!\n", name_);
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (thread_counts_.empty()) {
+      RunWithArg(args[i], 0);
     }
-    for (size_t i = 0; i < args_.size(); ++i) {
-      RunWithArg(args_[i]);
+    for (size_t j = 0; j < thread_counts_.size(); ++j) {
+      RunWithArg(args[i], thread_counts_[j]);
     }
   }
 }
 
-void Benchmark::RunRepeatedlyWithArg(int iterations, int arg) {
+void Benchmark::RunRepeatedlyWithArg(int iterations, int arg, int threads) {
+  if (threads > 0) {
+    RunOnThreads(iterations, arg, threads);
+    return;
+  }
   g_bytes_processed = 0;
+  g_latencies_ns = &g_main_thread_latencies_ns;
+  g_latencies_ns->clear();
   g_benchmark_total_time_ns = 0;
+  memset(g_benchmark_total_counts, 0, sizeof(g_benchmark_total_counts));
+  ReadCounters(g_benchmark_start_counts);
   g_benchmark_start_time_ns = NanoTime();
   if (fn_ != NULL) {
     fn_(iterations);
   } else {
     fn_range_(iterations, arg);
   }
-  if (g_benchmark_start_time_ns != 0) {
-    g_benchmark_total_time_ns += NanoTime() - g_benchmark_start_time_ns;
+  StopBenchmarkTiming();
+  g_benchmark_wall_time_ns = g_benchmark_total_time_ns;
+}
+
+struct BenchmarkThread {
+  void (*fn)(int);
+  void (*fn_range)(int, int);
+  int iterations;
+  int arg;
+  int cpu;  // Or -1 to leave it to the scheduler.
+  pthread_barrier_t* start;
+
+  int64_t time_ns;
+  int64_t counts[kCounterCount];
+  int64_t bytes;
+  std::vector<int64_t> latencies_ns;
+};
+
+static void* BenchmarkThreadFn(void* arg) {
+  BenchmarkThread* t = reinterpret_cast<BenchmarkThread*>(arg);
+  if (t->cpu != -1) {
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(t->cpu, &pinned);
+    sched_setaffinity(0, sizeof(pinned), &pinned);
   }
+  OpenCounters();
+  g_latencies_ns = &t->latencies_ns;
+
+  // Don't start the clock until every thread is ready to go.
+  pthread_barrier_wait(t->start);
+  ReadCounters(g_benchmark_start_counts);
+  g_benchmark_start_time_ns = NanoTime();
+  if (t->fn != NULL) {
+    t->fn(t->iterations);
+  } else {
+    t->fn_range(t->iterations, t->arg);
+  }
+  StopBenchmarkTiming();
+
+  t->time_ns = g_benchmark_total_time_ns;
+  memcpy(t->counts, g_benchmark_total_counts, sizeof(t->counts));
+  t->bytes = g_bytes_processed;
+  CloseCounters();
+  return NULL;
 }
 
-void Benchmark::RunWithArg(int arg) {
+// Runs the benchmark on 'threads' threads at once, and leaves the per-thread
+// means (and the total bytes) where RunWithArg expects to find them.
+void Benchmark::RunOnThreads(int iterations, int arg, int threads) {
+  const std::vector<int>& cpus = g_benchmark_cpus;
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, threads);
+
+  std::vector<BenchmarkThread> state(threads);
+  std::vector<pthread_t> ids(threads);
+  for (int i = 0; i < threads; ++i) {
+    BenchmarkThread& t = state[i];
+    t.fn = fn_;
+    t.fn_range = fn_range_;
+    t.iterations = iterations;
+    t.arg = arg;
+    t.cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    t.start = &start;
+    t.time_ns = t.bytes = 0;
+    memset(t.counts, 0, sizeof(t.counts));
+    int error = pthread_create(&ids[i], NULL, BenchmarkThreadFn, &t);
+    if (error != 0) {
+      fprintf(stderr, "%s: couldn't create thread %d of %d: %s\n", name_, i + 1, threads,
+              strerror(error));
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  int64_t total_time_ns = 0;
+  int64_t total_counts[kCounterCount] = {};
+  g_bytes_processed = 0;
+  g_benchmark_wall_time_ns = 0;
+  g_main_thread_latencies_ns.clear();
+  for (int i = 0; i < threads; ++i) {
+    pthread_join(ids[i], NULL);
+    const BenchmarkThread& t = state[i];
+    total_time_ns += t.time_ns;
+    for (int j = 0; j < kCounterCount; ++j) {
+      total_counts[j] += t.counts[j];
+    }
+    g_bytes_processed += t.bytes;
+    g_benchmark_wall_time_ns = std::max(g_benchmark_wall_time_ns, t.time_ns);
+    g_main_thread_latencies_ns.insert(g_main_thread_latencies_ns.end(),
+                                      t.latencies_ns.begin(), t.latencies_ns.end());
+  }
+  pthread_barrier_destroy(&start);
+
+  g_benchmark_total_time_ns = total_time_ns / threads;
+  for (int i = 0; i < kCounterCount; ++i) {
+    g_benchmark_total_counts[i] = total_counts[i] / threads;
+  }
+  g_latencies_ns = &g_main_thread_latencies_ns;
+}
+
+void Benchmark::RunWithArg(int arg, int threads) {
   // run once in case it's expensive
   int iterations = 1;
-  RunRepeatedlyWithArg(iterations, arg);
+  RunRepeatedlyWithArg(iterations, arg, threads);
   while (g_benchmark_total_time_ns < 1e9 && iterations < 1e9) {
     int last = iterations;
     if (g_benchmark_total_time_ns/iterations == 0) {
@@ -141,16 +568,49 @@ void Benchmark::RunWithArg(int arg) {
     }
     iterations = std::max(last + 1, std::min(iterations + iterations/2, 100*last));
     iterations = Round(iterations);
-    RunRepeatedlyWithArg(iterations, arg);
+    RunRepeatedlyWithArg(iterations, arg, threads);
   }
 
-  char throughput[100];
-  throughput[0] = '\0';
-  if (g_benchmark_total_time_ns > 0 && g_bytes_processed > 0) {
-    double mib_processed = static_cast<double>(g_bytes_processed)/1e6;
-    double seconds = static_cast<double>(g_benchmark_total_time_ns)/1e9;
-    snprintf(throughput, sizeof(throughput), " %8.2f MiB/s", mib_processed/seconds);
+  BenchmarkResult result;
+  result.iterations = iterations;
+  result.threads = threads;
+
+  // The last calibration run counts as the first repetition.
+  std::vector<double> counts[kCounterCount];
+  std::vector<double> bytes_per_second;
+  std::vector<double> bytes_per_cycle;
+  std::vector<double> ops_per_second;
+  for (int repetition = 0; repetition < g_repetitions; ++repetition) {
+    if (repetition > 0) {
+      RunRepeatedlyWithArg(iterations, arg, threads);
+    }
+    result.ns_per_op.push_back(static_cast<double>(g_benchmark_total_time_ns)/iterations);
+    for (int i = 0; i < kCounterCount; ++i) {
+      if (g_benchmark_total_counts[i] > 0) {
+        counts[i].push_back(static_cast<double>(g_benchmark_total_counts[i])/iterations);
+      }
+    }
+    // With threads, throughput is everyone's work over the slowest thread's time.
+    int thread_count = std::max(threads, 1);
+    if (g_benchmark_wall_time_ns > 0 && g_bytes_processed > 0) {
+      bytes_per_second.push_back(static_cast<double>(g_bytes_processed)*1e9/g_benchmark_wall_time_ns);
+      if (g_benchmark_total_counts[kCycles] > 0) {
+        bytes_per_cycle.push_back(static_cast<double>(g_bytes_processed)/
+                                  (thread_count*g_benchmark_total_counts[kCycles]));
+      }
+    }
+    if (g_benchmark_wall_time_ns > 0) {
+      ops_per_second.push_back(static_cast<double>(thread_count)*iterations*1e9/g_benchmark_wall_time_ns);
+    }
+    result.latencies_ns.insert(result.latencies_ns.end(), g_latencies_ns->begin(), g_latencies_ns->end());
+  }
+  for (int i = 0; i < kCounterCount; ++i) {
+    result.counts_per_op[i] = counts[i].empty() ? 0 : Median(counts[i]);
   }
+  result.bytes_per_second = bytes_per_second.empty() ? 0 : Median(bytes_per_second);
+  result.bytes_per_cycle = bytes_per_cycle.empty() ? 0 : Median(bytes_per_cycle);
+  result.ops_per_second = ops_per_second.empty() ? 0 : Median(ops_per_second);
+  std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
 
   char full_name[100];
   if (fn_range_ != NULL) {
@@ -164,10 +624,13 @@ void Benchmark::RunWithArg(int arg) {
   } else {
     snprintf(full_name, sizeof(full_name), "%s", name_);
   }
+  if (threads > 0) {
+    size_t used = strlen(full_name);
+    snprintf(full_name + used, sizeof(full_name) - used, "/threads:%d", threads);
+  }
+  result.name = full_name;
 
-  printf("%-*s %10d %10" PRId64 "%s\n", g_name_column_width, full_name,
-         iterations, g_benchmark_total_time_ns/iterations, throughput);
-  fflush(stdout);
+  Report(result);
 }
 
 }  // namespace testing
@@ -176,44 +639,324 @@ void SetBenchmarkBytesProcessed(int64_t x) {
   g_bytes_processed = x;
 }
 
+void AddBenchmarkLatency(int64_t ns) {
+  g_latencies_ns->push_back(ns);
+}
+
 void StopBenchmarkTiming() {
   if (g_benchmark_start_time_ns != 0) {
     g_benchmark_total_time_ns += NanoTime() - g_benchmark_start_time_ns;
+    int64_t counts[kCounterCount];
+    ReadCounters(counts);
+    for (int i = 0; i < g_counter_count; ++i) {
+      g_benchmark_total_counts[i] += counts[i] - g_benchmark_start_counts[i];
+    }
   }
   g_benchmark_start_time_ns = 0;
 }
 
 void StartBenchmarkTiming() {
   if (g_benchmark_start_time_ns == 0) {
+    ReadCounters(g_benchmark_start_counts);
     g_benchmark_start_time_ns = NanoTime();
   }
 }
 
+// Reads the samples for each benchmark from a file written with --format=json.
+static bool ReadJsonResults(const char* path, std::map<std::string, std::vector<double> >* results) {
+  FILE* fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "couldn't open \"%s\": %s\n", path, strerror(errno));
+    return false;
+  }
+  char* line = NULL;
+  size_t capacity = 0;
+  while (getline(&line, &capacity, fp) != -1) {
+    const char* name = strstr(line, "{\"name\": \"");
+    const char* samples = strstr(line, "\"samples\": [");
+    if (name == NULL || samples == NULL) {
+      continue;
+    }
+    std::string key;
+    for (const char* p = name + strlen("{\"name\": \""); *p != '\0' && *p != '"'; ++p) {
+      if (*p == '\\' && p[1] != '\0') {
+        ++p;
+      }
+      key += *p;
+    }
+    std::vector<double>& values = (*results)[key];
+    values.clear();
+    char* p = const_cast<char*>(samples + strlen("\"samples\": ["));
+    while (*p != ']' && *p != '\0') {
+      char* end;
+      double value = strtod(p, &end);
+      if (end == p) {
+        break;
+      }
+      values.push_back(value);
+      p = end + strspn(end, ", ");
+    }
+  }
+  free(line);
+  fclose(fp);
+  if (results->empty()) {
+    fprintf(stderr, "no benchmark results in \"%s\"\n", path);
+    return false;
+  }
+  return true;
+}
+
+// The two-sided p-value of the Mann-Whitney U test: how likely samples as
+// different as these would be if both came from the same distribution.
+// Timings are rarely normally distributed, so this is the usual choice.
+static double MannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b) {
+  size_t n = a.size();
+  size_t m = b.size();
+  if (n == 0 || m == 0) {
+    return 1;
+  }
+
+  // U counts the pairs in which a's sample is the bigger, with ties counting half.
+  double u = 0;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < m; ++j) {
+      u += (a[i] > b[j]) ? 1 : (a[i] == b[j]) ? 0.5 : 0;
+    }
+  }
+
+  size_t max_u = n * m;
+  if (n + m > 50) {
+    // The normal approximation, with a continuity correction.
+    double mean = max_u / 2.0;
+    double sd = sqrt(max_u * (n + m + 1) / 12.0);
+    double z = std::max(0.0, fabs(u - mean) - 0.5) / sd;
+    return erfc(z / sqrt(2.0));
+  }
+
+  // The exact distribution. ways[j][k] counts the orderings of i a-samples
+  // and j b-samples in which U is k: the biggest of them is either an a,
+  // which beats all j b-samples, or a b, which adds nothing.
+  std::vector<std::vector<double> > ways(m + 1, std::vector<double>(max_u + 1, 0));
+  for (size_t j = 0; j <= m; ++j) {
+    ways[j][0] = 1;  // No a-samples.
+  }
+  for (size_t i = 1; i <= n; ++i) {
+    std::vector<std::vector<double> > next(m + 1, std::vector<double>(max_u + 1, 0));
+    next[0][0] = 1;  // No b-samples.
+    for (size_t j = 1; j <= m; ++j) {
+      for (size_t k = 0; k <= max_u; ++k) {
+        next[j][k] = next[j - 1][k] + ((k >= j) ? ways[j][k - j] : 0);
+      }
+    }
+    ways.swap(next);
+  }
+
+  double total = 0;
+  double at_most = 0;
+  double at_least = 0;
+  for (size_t k = 0; k <= max_u; ++k) {
+    total += ways[m][k];
+    if (k <= u) {
+      at_most += ways[m][k];
+    }
+    if (k >= u) {
+      at_least += ways[m][k];
+    }
+  }
+  return std::min(1.0, 2 * std::min(at_most, at_least) / total);
+}
+
+// Compares two files written with --format=json, and fails if any benchmark
+// got significantly slower.
+static int Compare(const char* old_path, const char* new_path) {
+  std::map<std::string, std::vector<double> > old_results;
+  std::map<std::string, std::vector<double> > new_results;
+  if (!ReadJsonResults(old_path, &old_results) || !ReadJsonResults(new_path, &new_results)) {
+    return EXIT_FAILURE;
+  }
+
+  int name_width = g_name_column_width;
+  for (std::map<std::string, std::vector<double> >::iterator it = new_results.begin();
+       it != new_results.end(); ++it) {
+    name_width = std::max(name_width, static_cast<int>(it->first.size()));
+  }
+
+  printf("%-*s %12s %12s %8s %8s\n", name_width, "", "old ns/op", "new ns/op", "change", "p");
+  int slower = 0;
+  int faster = 0;
+  for (std::map<std::string, std::vector<double> >::iterator it = new_results.begin();
+       it != new_results.end(); ++it) {
+    std::map<std::string, std::vector<double> >::iterator old_it = old_results.find(it->first);
+    if (old_it == old_results.end() || old_it->second.empty() || it->second.empty()) {
+      printf("%-*s (not in %s)\n", name_width, it->first.c_str(), old_path);
+      continue;
+    }
+    double old_median = Median(old_it->second);
+    double new_median = Median(it->second);
+    double change = (old_median > 0) ? 100 * (new_median - old_median) / old_median : 0;
+    double p = MannWhitneyPValue(old_it->second, it->second);
+
+    const char* verdict = "";
+    if (p < kSignificanceLevel && fabs(change) >= g_threshold_percent) {
+      if (change > 0) {
+        verdict = " SLOWER";
+        ++slower;
+      } else {
+        verdict = " faster";
+        ++faster;
+      }
+    }
+    printf("%-*s %12.1f %12.1f %+7.1f%% %8.3f%s\n", name_width, it->first.c_str(),
+           old_median, new_median, change, p, verdict);
+  }
+
+  printf("%d significantly slower, %d significantly faster (p < %.2f, change >= %.1f%%)\n",
+         slower, faster, kSignificanceLevel, g_threshold_percent);
+  return (slower > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Frequency scaling makes ns/op depend on what ran just before, so warn
+// about any CPU we'll run on that isn't held at one frequency.
+static void WarnAboutCpuFrequency(const std::vector<int>& cpus) {
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpus[i]);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+      continue;
+    }
+    char governor[64];
+    if (fgets(governor, sizeof(governor), fp) != NULL) {
+      governor[strcspn(governor, "\n")] = '\0';
+      if (strcmp(governor, "performance") != 0) {
+        fprintf(stderr, "warning: cpu%d's frequency governor is \"%s\", not \"performance\"; "
+                "results may not be comparable\n", cpus[i], governor);
+      }
+    }
+    fclose(fp);
+  }
+}
+
+static void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--repetitions=N] [--format=text|json|csv] [--out=FILE]\n"
+          "          [--cpu=N] [--counters] [REGEX...]\n"
+          "       %s --compare OLD.json NEW.json [--threshold=PERCENT]\n"
+          "\n"
+          "Runs the benchmarks whose names match any of the regular expressions (or all of\n"
+          "them), measuring each N times and reporting the median and spread.\n"
+          "\n"
+          "--cpu pins the benchmarks to the given CPU (threaded benchmarks still get a CPU\n"
+          "per thread). --counters reports instructions, cache misses and branch\n"
+          "mispredicts per iteration as well as cycles, where the kernel allows.\n"
+          "\n"
+          "--compare reports the change in each benchmark's median between two runs saved\n"
+          "with --format=json, and uses a Mann-Whitney U test to say whether it's more than\n"
+          "noise. It fails if any benchmark got significantly slower by at least PERCENT\n"
+          "(default 5). Significance needs samples: use --repetitions=5 or more.\n",
+          program, program);
+}
+
 int main(int argc, char* argv[]) {
   if (g_benchmarks.empty()) {
     fprintf(stderr, "No benchmarks registered!\n");
     exit(EXIT_FAILURE);
   }
 
+  // Everything that isn't an option is a regular expression for ShouldRun.
+  std::vector<char*> patterns;
+  patterns.push_back(argv[0]);
+  const char* out_path = NULL;
+  const char* compare_old = NULL;
+  const char* compare_new = NULL;
+  int cpu = -1;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--", 2) != 0) {
+      patterns.push_back(argv[i]);
+    } else if (strncmp(arg, "--repetitions=", strlen("--repetitions=")) == 0) {
+      g_repetitions = atoi(arg + strlen("--repetitions="));
+      if (g_repetitions < 1) {
+        Usage(argv[0]);
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--format=text") == 0) {
+      g_output_format = kOutputText;
+    } else if (strcmp(arg, "--format=json") == 0) {
+      g_output_format = kOutputJson;
+    } else if (strcmp(arg, "--format=csv") == 0) {
+      g_output_format = kOutputCsv;
+    } else if (strncmp(arg, "--cpu=", strlen("--cpu=")) == 0) {
+      cpu = atoi(arg + strlen("--cpu="));
+    } else if (strcmp(arg, "--counters") == 0) {
+      g_counter_count = kCounterCount;
+    } else if (strncmp(arg, "--out=", strlen("--out=")) == 0) {
+      out_path = arg + strlen("--out=");
+    } else if (strncmp(arg, "--threshold=", strlen("--threshold=")) == 0) {
+      g_threshold_percent = strtod(arg + strlen("--threshold="), NULL);
+    } else if (strcmp(arg, "--compare") == 0 && i + 2 < argc) {
+      compare_old = argv[++i];
+      compare_new = argv[++i];
+    } else if (strcmp(arg, "--help") == 0) {
+      Usage(argv[0]);
+      return 0;
+    } else {
+      Usage(argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (compare_old != NULL) {
+    return Compare(compare_old, compare_new);
+  }
+
+  g_out = stdout;
+  if (out_path != NULL) {
+    g_out = fopen(out_path, "w");
+    if (g_out == NULL) {
+      fprintf(stderr, "couldn't open \"%s\": %s\n", out_path, strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+  }
+
   for (BenchmarkMapIt it = g_benchmarks.begin(); it != g_benchmarks.end(); ++it) {
     int name_width = static_cast<int>(strlen(it->second->Name()));
     g_name_column_width = std::max(g_name_column_width, name_width);
   }
 
-  bool need_header = true;
+  g_benchmark_cpus = AvailableCpus();
+  if (cpu != -1) {
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(cpu, &pinned);
+    if (std::find(g_benchmark_cpus.begin(), g_benchmark_cpus.end(), cpu) == g_benchmark_cpus.end() ||
+        sched_setaffinity(0, sizeof(pinned), &pinned) == -1) {
+      fprintf(stderr, "couldn't run on cpu%d\n", cpu);
+      exit(EXIT_FAILURE);
+    }
+    WarnAboutCpuFrequency(std::vector<int>(1, cpu));
+  } else {
+    WarnAboutCpuFrequency(g_benchmark_cpus);
+  }
+
+  OpenCounters();
+  for (int i = 0; i < g_counter_count && g_counter_count > 1; ++i) {
+    if (g_counter_fds[i] == -1) {
+      fprintf(stderr, "warning: can't count %s (see /proc/sys/kernel/perf_event_paranoid)\n",
+              kCounterInfo[i].name);
+    }
+  }
+
+  bool ran_any = false;
   for (BenchmarkMapIt it = g_benchmarks.begin(); it != g_benchmarks.end(); ++it) {
     ::testing::Benchmark* b = it->second;
-    if (b->ShouldRun(argc, argv)) {
-      if (need_header) {
-        printf("%-*s %10s %10s\n", g_name_column_width, "", "iterations", "ns/op");
-        fflush(stdout);
-        need_header = false;
-      }
+    if (b->ShouldRun(patterns.size(), &patterns[0])) {
       b->Run();
+      ran_any = true;
     }
   }
 
-  if (need_header) {
+  if (!ran_any) {
     fprintf(stderr, "No matching benchmarks!\n");
     fprintf(stderr, "Available benchmarks:\n");
     for (BenchmarkMapIt it = g_benchmarks.begin(); it != g_benchmarks.end(); ++it) {
@@ -222,5 +965,11 @@ int main(int argc, char* argv[]) {
     exit(EXIT_FAILURE);
   }
 
+  if (g_output_format == kOutputJson) {
+    fprintf(g_out, "\n  ]\n}\n");
+  }
+  if (g_out != stdout) {
+    fclose(g_out);
+  }
   return 0;
 }
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <resolv_netid.h>
+
+#include <algorithm>
+#include <vector>
+
+// The resolver can't be told to use a port other than 53, so the fake server
+// listens there on a loopback address of its own, which needs root.
+#define FAKE_DNS_ADDRESS "127.0.100.53"
+
+// Only the benchmarks use this network, so they start with its cache to themselves.
+static const unsigned kNetId = 1053;
+
+static int64_t NowNs() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<int64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
+// How the fake server misbehaves.
+struct DnsFaults {
+  DnsFaults() : latency_ms(0), aaaa_latency_ms(0), loss_percent(0), truncate(false) {}
+
+  int latency_ms;       // Before every answer.
+  int aaaa_latency_ms;  // Added before AAAA answers.
+  int loss_percent;     // Of queries over UDP, dropped without an answer.
+  bool truncate;        // Answers over UDP are truncated, so the client retries over TCP.
+};
+
+// A DNS server running on a thread of this process. It answers every A
+// query with 192.0.2.1, every AAAA query with 2001:db8::1, every PTR query
+// with host.example, and every other type with no records. While it's running, the resolver's kNetId uses it.
+class FakeDnsServer {
+ public:
+  explicit FakeDnsServer(const DnsFaults& faults)
+      : valid(false), faults_(faults), udp_fd_(-1), tcp_fd_(-1) {
+    stop_fds_[0] = stop_fds_[1] = -1;
+
+    sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(53);
+    inet_pton(AF_INET, FAKE_DNS_ADDRESS, &sin.sin_addr);
+    const sockaddr* sa = reinterpret_cast<const sockaddr*>(&sin);
+
+    int on = 1;
+    udp_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    tcp_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (udp_fd_ == -1 || tcp_fd_ == -1 ||
+        setsockopt(tcp_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1 ||
+        bind(udp_fd_, sa, sizeof(sin)) == -1 || bind(tcp_fd_, sa, sizeof(sin)) == -1 ||
+        listen(tcp_fd_, 16) == -1 || pipe2(stop_fds_, O_CLOEXEC) == -1) {
+      printf("couldn't serve DNS on %s:53 (these benchmarks must run as root): %s\n",
+             FAKE_DNS_ADDRESS, strerror(errno));
+      return;
+    }
+    if (pthread_create(&thread_, NULL, Run, this) != 0) {
+      printf("couldn't start the fake DNS server\n");
+      return;
+    }
+
+    // Fewer retries, and sooner, so that lost queries cost seconds rather than minutes.
+    setenv("RES_OPTIONS", "timeout:1 attempts:2", 1);
+    // Resolve in this process rather than asking netd.
+    setenv("ANDROID_DNS_MODE", "local", 1);
+    const char* servers[] = { FAKE_DNS_ADDRESS };
+    _resolv_set_nameservers_for_net(kNetId, servers, 1, "");
+    _resolv_flush_cache_for_net(kNetId);
+    valid = true;
+  }
+
+  ~FakeDnsServer() {
+    if (valid) {
+      write(stop_fds_[1], "", 1);
+      pthread_join(thread_, NULL);
+    }
+    for (size_t i = 0; i < tcp_clients_.size(); ++i) {
+      close(tcp_clients_[i]);
+    }
+    close(udp_fd_);
+    close(tcp_fd_);
+    close(stop_fds_[0]);
+    close(stop_fds_[1]);
+  }
+
+  bool valid;
+
+ private:
+  struct Reply {
+    int64_t due_ns;
+    int fd;             // The TCP connection, or -1 to reply over UDP.
+    sockaddr_storage to;
+    socklen_t to_len;
+    std::vector<uint8_t> message;
+  };
+
+  DnsFaults faults_;
+  int udp_fd_;
+  int tcp_fd_;
+  int stop_fds_[2];
+  pthread_t thread_;
+  std::vector<int> tcp_clients_;
+  std::vector<Reply> replies_;
+
+  static void* Run(void* arg) {
+    reinterpret_cast<FakeDnsServer*>(arg)->Serve();
+    return NULL;
+  }
+
+  void Serve() {
+    unsigned seed = 1;
+    while (true) {
+      int timeout_ms = -1;
+      int64_t now = NowNs();
+      for (size_t i = 0; i < replies_.size(); ++i) {
+        int ms = (replies_[i].due_ns > now) ? (replies_[i].due_ns - now + 999999) / 1000000 : 0;
+        if (timeout_ms == -1 || ms < timeout_ms) {
+          timeout_ms = ms;
+        }
+      }
+
+      std::vector<pollfd> fds;
+      pollfd fd = { stop_fds_[0], POLLIN, 0 };
+      fds.push_back(fd);
+      fd.fd = udp_fd_;
+      fds.push_back(fd);
+      fd.fd = tcp_fd_;
+      fds.push_back(fd);
+      for (size_t i = 0; i < tcp_clients_.size(); ++i) {
+        fd.fd = tcp_clients_[i];
+        fds.push_back(fd);
+      }
+      if (poll(&fds[0], fds.size(), timeout_ms) == -1 && errno != EINTR) {
+        return;
+      }
+      if (fds[0].revents != 0) {
+        return;
+      }
+
+      uint8_t buf[512];
+      if (fds[1].revents != 0) {
+        Reply reply;
+        reply.fd = -1;
+        reply.to_len = sizeof(reply.to);
+        ssize_t n = recvfrom(udp_fd_, buf, sizeof(buf), 0,
+                             reinterpret_cast<sockaddr*>(&reply.to), &reply.to_len);
+        if (n > 0 && static_cast<int>(rand_r(&seed) % 100) >= faults_.loss_percent) {
+          Answer(buf, n, faults_.truncate, &reply);
+        }
+      }
+      if (fds[2].revents != 0) {
+        int client = accept4(tcp_fd_, NULL, NULL, SOCK_CLOEXEC);
+        if (client != -1) {
+          tcp_clients_.push_back(client);
+        }
+      }
+      for (size_t i = 3; i < fds.size(); ++i) {
+        if (fds[i].revents == 0) {
+          continue;
+        }
+        // The resolver writes the length and the query together.
+        ssize_t n = read(fds[i].fd, buf, sizeof(buf));
+        if (n <= 2 || ((buf[0] << 8) | buf[1]) != n - 2) {
+          DropTcpClient(fds[i].fd);
+          continue;
+        }
+        Reply reply;
+        reply.fd = fds[i].fd;
+        Answer(buf + 2, n - 2, false, &reply);
+      }
+
+      now = NowNs();
+      for (size_t i = 0; i < replies_.size(); ) {
+        const Reply& reply = replies_[i];
+        if (reply.due_ns > now) {
+          ++i;
+          continue;
+        }
+        if (reply.fd == -1) {
+          sendto(udp_fd_, &reply.message[0], reply.message.size(), 0,
+                 reinterpret_cast<const sockaddr*>(&reply.to), reply.to_len);
+        } else {
+          uint8_t len[2] = { static_cast<uint8_t>(reply.message.size() >> 8),
+                             static_cast<uint8_t>(reply.message.size()) };
+          send(reply.fd, len, sizeof(len), MSG_NOSIGNAL | MSG_MORE);
+          send(reply.fd, &reply.message[0], reply.message.size(), MSG_NOSIGNAL);
+        }
+        replies_.erase(replies_.begin() + i);
+      }
+    }
+  }
+
+  // Closes a TCP connection and forgets the replies it was waiting for.
+  void DropTcpClient(int fd) {
+    for (size_t i = 0; i < replies_.size(); ) {
+      if (replies_[i].fd == fd) {
+        replies_.erase(replies_.begin() + i);
+      } else {
+        ++i;
+      }
+    }
+    tcp_clients_.erase(std::find(tcp_clients_.begin(), tcp_clients_.end(), fd));
+    close(fd);
+  }
+
+  // Queues the answer to 'query' to be sent once the faults' latency has passed.
+  void Answer(const uint8_t* query, size_t len, bool truncate, Reply* reply) {
+    // Skip the question's name to find its type.
+    size_t end = 12;
+    while (end < len && query[end] != 0) {
+      end += query[end] + 1;
+    }
+    if (end + 5 > len) {
+      return;
+    }
+    int type = (query[end + 1] << 8) | query[end + 2];
+    end += 5;
+
+    std::vector<uint8_t>& m = reply->message;
+    m.assign(query, query + end);
+    m[2] = 0x80 | (query[2] & 0x01) | (truncate ? 0x02 : 0);  // QR, TC and the query's RD.
+    m[3] = 0x80;                                                // RA, NOERROR.
+    memset(&m[6], 0, 6);                                        // No records, yet.
+    if (!truncate && (type == 1 || type == 28)) {
+      static const uint8_t kA[] = { 0xc0, 12, 0, 1, 0, 1, 0, 0, 1, 0x2c, 0, 4,
+                                    192, 0, 2, 1 };
+      static const uint8_t kAAAA[] = { 0xc0, 12, 0, 28, 0, 1, 0, 0, 1, 0x2c, 0, 16,
+                                       0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+      if (type == 1) {
+        m.insert(m.end(), kA, kA + sizeof(kA));
+      } else {
+        m.insert(m.end(), kAAAA, kAAAA + sizeof(kAAAA));
+      }
+      m[7] = 1;
+    } else if (!truncate && type == 12) {
+      static const uint8_t kPTR[] = { 0xc0, 12, 0, 12, 0, 1, 0, 0, 1, 0x2c, 0, 14,
+                                      4, 'h', 'o', 's', 't', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0 };
+      m.insert(m.end(), kPTR, kPTR + sizeof(kPTR));
+      m[7] = 1;
+    }
+
+    int64_t latency_ms = faults_.latency_ms + ((type == 28) ? faults_.aaaa_latency_ms : 0);
+    reply->due_ns = NowNs() + latency_ms * 1000000LL;
+    replies_.push_back(*reply);
+  }
+};
+
+// Looks up 'name', which must resolve unless 'may_fail'.
+static void Resolve(const char* name, int family, bool may_fail = false) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = family;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result;
+  int error = android_getaddrinfofornet(name, NULL, &hints, kNetId, MARK_UNSET, &result);
+  if (error == 0) {
+    freeaddrinfo(result);
+  } else if (!may_fail) {
+    fprintf(stderr, "getaddrinfo(\"%s\") failed: %s\n", name, gai_strerror(error));
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Looks up a name that's never been looked up before, so it isn't cached.
+static void ResolveNewName(int family, bool may_fail = false) {
+  static int generation = 0;
+  char name[64];
+  snprintf(name, sizeof(name), "host%d.bench.test", ++generation);
+  Resolve(name, family, may_fail);
+}
+
+// Looks up 'iters' names the cache has never seen, each answered after 'ms' milliseconds.
+static void BM_dns_getaddrinfo_uncached(int iters, int ms) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  faults.latency_ms = ms;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  for (int i = 0; i < iters; i++) {
+    int64_t start = NowNs();
+    StartBenchmarkTiming();
+    ResolveNewName(AF_INET);
+    StopBenchmarkTiming();
+    AddBenchmarkLatency(NowNs() - start);
+  }
+}
+BENCHMARK(BM_dns_getaddrinfo_uncached)->Arg(0)->Arg(1)->Arg(10);
+
+// As above, but 'percent' of the queries are lost and have to be retried.
+// Those lost every time fail.
+static void BM_dns_getaddrinfo_loss(int iters, int percent) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  faults.loss_percent = percent;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  for (int i = 0; i < iters; i++) {
+    int64_t start = NowNs();
+    StartBenchmarkTiming();
+    ResolveNewName(AF_INET, true);
+    StopBenchmarkTiming();
+    AddBenchmarkLatency(NowNs() - start);
+  }
+}
+BENCHMARK(BM_dns_getaddrinfo_loss)->Arg(1)->Arg(10);
+
+// Every answer over UDP is truncated, so every lookup is retried over TCP.
+static void BM_dns_getaddrinfo_truncated(int iters) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  faults.truncate = true;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  for (int i = 0; i < iters; i++) {
+    int64_t start = NowNs();
+    StartBenchmarkTiming();
+    ResolveNewName(AF_INET);
+    StopBenchmarkTiming();
+    AddBenchmarkLatency(NowNs() - start);
+  }
+}
+BENCHMARK(BM_dns_getaddrinfo_truncated);
+
+// Looks up both A and AAAA records, with AAAA answers 'ms' milliseconds
+// slower than A: a lookup should take as long as the slower of the two.
+static void BM_dns_getaddrinfo_dual_stack(int iters, int ms) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  faults.latency_ms = 1;
+  faults.aaaa_latency_ms = ms;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  for (int i = 0; i < iters; i++) {
+    int64_t start = NowNs();
+    StartBenchmarkTiming();
+    ResolveNewName(AF_UNSPEC);
+    StopBenchmarkTiming();
+    AddBenchmarkLatency(NowNs() - start);
+  }
+}
+BENCHMARK(BM_dns_getaddrinfo_dual_stack)->Arg(0)->Arg(10)->Arg(100);
+
+static const int kCachedNames = 64;
+
+struct CachedLookups {
+  int iters;
+  int first_name;
+};
+
+static void* ResolveCachedNames(void* arg) {
+  CachedLookups* lookups = reinterpret_cast<CachedLookups*>(arg);
+  char name[64];
+  for (int i = 0; i < lookups->iters; i++) {
+    snprintf(name, sizeof(name), "cached%d.bench.test",
+             (lookups->first_name + i) % kCachedNames);
+    Resolve(name, AF_INET);
+  }
+  return NULL;
+}
+
+// Looks up kCachedNames names, all already cached, from 'threads' threads at once.
+static void BM_dns_getaddrinfo_cached_threads(int iters, int threads) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  CachedLookups warm_up = { kCachedNames, 0 };
+  ResolveCachedNames(&warm_up);
+
+  std::vector<pthread_t> ids(threads);
+  std::vector<CachedLookups> lookups(threads);
+  StartBenchmarkTiming();
+  for (int i = 0; i < threads; i++) {
+    lookups[i].iters = iters / threads + ((i < iters % threads) ? 1 : 0);
+    lookups[i].first_name = i * kCachedNames / threads;
+    pthread_create(&ids[i], NULL, ResolveCachedNames, &lookups[i]);
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_dns_getaddrinfo_cached_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+// Reverse lookups of one address, all but the first answered from the cache.
+static void BM_dns_getnameinfo_cached(int iters) {
+  StopBenchmarkTiming();
+  DnsFaults faults;
+  FakeDnsServer server(faults);
+  if (!server.valid) return;
+
+  sockaddr_in sin;
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family = AF_INET;
+  inet_pton(AF_INET, "192.0.2.1", &sin.sin_addr);
+  const sockaddr* sa = reinterpret_cast<const sockaddr*>(&sin);
+  char host[NI_MAXHOST];
+  if (android_getnameinfofornet(sa, sizeof(sin), host, sizeof(host), NULL, 0,
+                                NI_NAMEREQD, kNetId, MARK_UNSET) != 0) {
+    fprintf(stderr, "getnameinfo(192.0.2.1) failed\n");
+    return;
+  }
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; i++) {
+    android_getnameinfofornet(sa, sizeof(sin), host, sizeof(host), NULL, 0,
+                              NI_NAMEREQD, kNetId, MARK_UNSET);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_dns_getnameinfo_cached);
+
+// A service name lookup in the built-in services table.
+static void BM_dns_getservbyname(int iters) {
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; i++) {
+    getservbyname("https", "tcp");
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_dns_getservbyname);
+
+// getaddrinfo with a numeric host but a named service, so all the time goes
+// on the service lookup rather than the resolver.
+static void BM_dns_getaddrinfo_service(int iters) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICHOST;
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; i++) {
+    addrinfo* result = NULL;
+    if (getaddrinfo("127.0.0.1", "https", &hints, &result) == 0) {
+      freeaddrinfo(result);
+    }
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_dns_getaddrinfo_service);
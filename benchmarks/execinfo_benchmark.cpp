@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <execinfo.h>
+#include <stdlib.h>
+
+// Recurses to get a stack of about the given depth, so the cost per frame
+// is visible.
+static int __attribute__((noinline)) CaptureAtDepth(int depth, void** frames, int size) {
+  if (depth > 0) {
+    volatile int frame_count = CaptureAtDepth(depth - 1, frames, size);
+    return frame_count;
+  }
+  return backtrace(frames, size);
+}
+
+static void BM_execinfo_backtrace(int iters, int depth) {
+  void* frames[64];
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    CaptureAtDepth(depth, frames, 64);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_execinfo_backtrace)->Arg(1)->Arg(8)->Arg(32);
+
+static void BM_execinfo_backtrace_symbols(int iters, int depth) {
+  void* frames[64];
+  int frame_count = CaptureAtDepth(depth, frames, 64);
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    free(backtrace_symbols(frames, frame_count));
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_execinfo_backtrace_symbols)->Arg(1)->Arg(8)->Arg(32);
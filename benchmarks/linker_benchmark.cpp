@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.h"
+
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The libraries are built from linker_benchmark_library.cpp; see Android.mk.
+#define SYMBOL_COUNTS Arg(100)->Arg(1000)->Arg(10000)
+#define DEPTHS Arg(1)->Arg(4)->Arg(8)
+
+static void* OpenSymbolsLibrary(int symbols) {
+  char name[64];
+  snprintf(name, sizeof(name), "libbionic-benchmark-linker-symbols-%d.so", symbols);
+  void* handle = dlopen(name, RTLD_NOW);
+  if (handle == NULL) {
+    fprintf(stderr, "%s\n", dlerror());
+    abort();
+  }
+  return handle;
+}
+
+// The last of bench_symbol_0.. bench_symbol_<symbols - 1>, zero-padded the
+// way the macros in linker_benchmark_library.cpp spell them.
+static void LastSymbolName(int symbols, char* name, size_t size) {
+  int digits = 0;
+  for (int n = symbols; n > 1; n /= 10) {
+    ++digits;
+  }
+  snprintf(name, size, "bench_symbol_%0*d", digits, symbols - 1);
+}
+
+static void BM_linker_dlopen_dlclose(int iters, int symbols) {
+  char name[64];
+  snprintf(name, sizeof(name), "libbionic-benchmark-linker-symbols-%d.so", symbols);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    void* handle = dlopen(name, RTLD_NOW);
+    dlclose(handle);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_linker_dlopen_dlclose)->SYMBOL_COUNTS;
+
+static void BM_linker_dlopen_dlclose_depth(int iters, int depth) {
+  char name[64];
+  snprintf(name, sizeof(name), "libbionic-benchmark-linker-depth-%d.so", depth);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    void* handle = dlopen(name, RTLD_NOW);
+    dlclose(handle);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_linker_dlopen_dlclose_depth)->DEPTHS;
+
+static void BM_linker_dlsym(int iters, int symbols) {
+  void* handle = OpenSymbolsLibrary(symbols);
+  char name[64];
+  LastSymbolName(symbols, name, sizeof(name));
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    dlsym(handle, name);
+  }
+  StopBenchmarkTiming();
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlsym)->SYMBOL_COUNTS;
+
+static void BM_linker_dlsym_default(int iters, int symbols) {
+  void* handle = OpenSymbolsLibrary(symbols);
+  char name[64];
+  LastSymbolName(symbols, name, sizeof(name));
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    dlsym(RTLD_DEFAULT, name);
+  }
+  StopBenchmarkTiming();
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlsym_default)->SYMBOL_COUNTS;
+
+// A name no loaded library defines, which has to be ruled out in every one.
+static void BM_linker_dlsym_default_miss(int iters, int symbols) {
+  void* handle = OpenSymbolsLibrary(symbols);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    dlsym(RTLD_DEFAULT, "bench_symbol_missing");
+  }
+  StopBenchmarkTiming();
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlsym_default_miss)->SYMBOL_COUNTS;
+
+static void BM_linker_dladdr(int iters, int symbols) {
+  void* handle = OpenSymbolsLibrary(symbols);
+  char name[64];
+  LastSymbolName(symbols, name, sizeof(name));
+  void* addr = dlsym(handle, name);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    Dl_info info;
+    dladdr(addr, &info);
+  }
+  StopBenchmarkTiming();
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dladdr)->SYMBOL_COUNTS;
+
+static int CountPhdrs(dl_phdr_info* info, size_t, void* data) {
+  *reinterpret_cast<size_t*>(data) += info->dlpi_phnum;
+  return 0;
+}
+
+static void BM_linker_dl_iterate_phdr(int iters) {
+  size_t count = 0;
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    dl_iterate_phdr(CountPhdrs, &count);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_linker_dl_iterate_phdr);
+
+// fork, exec and exit of an executable that does nothing but depend on
+// the depth-8 chain and the 1000-symbol library.
+static void BM_linker_exec_to_main(int iters) {
+#if defined(__LP64__)
+  const char* path = "/system/bin/bionic-benchmark-linker-exec64";
+#else
+  const char* path = "/system/bin/bionic-benchmark-linker-exec32";
+#endif
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execl(path, path, NULL);
+      _exit(127);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+  }
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_linker_exec_to_main);
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Run by BM_linker_exec_to_main: all the work is the linker's, loading the
+// dependencies this is linked against.
+
+extern "C" int bench_depth_8();
+
+int main(int argc, char**) {
+  // Keep the dependency on the chain of libraries without calling into it.
+  return (argc > 1) ? bench_depth_8() : 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Synthetic libraries for linker_benchmark.cpp, built from this one file
+// with different flags (see Android.mk):
+//
+//   BENCH_SYMBOLS=BENCH_R<N>  defines N exported functions, bench_symbol_0..,
+//                             plus a table of pointers to them, which costs
+//                             N symbol lookups and relocations at load time.
+//   BENCH_DEPTH=<d>           defines bench_depth_<d>(), which calls
+//   BENCH_DEPTH_PREVIOUS=<d-1>  bench_depth_<d-1>() in the DT_NEEDED library
+//                             below it in the chain.
+
+#define BENCH_R10(M, n) \
+    M(n##0) M(n##1) M(n##2) M(n##3) M(n##4) M(n##5) M(n##6) M(n##7) M(n##8) M(n##9)
+#define BENCH_R100(M, n) \
+    BENCH_R10(M, n##0) BENCH_R10(M, n##1) BENCH_R10(M, n##2) BENCH_R10(M, n##3) \
+    BENCH_R10(M, n##4) BENCH_R10(M, n##5) BENCH_R10(M, n##6) BENCH_R10(M, n##7) \
+    BENCH_R10(M, n##8) BENCH_R10(M, n##9)
+#define BENCH_R1000(M, n) \
+    BENCH_R100(M, n##0) BENCH_R100(M, n##1) BENCH_R100(M, n##2) BENCH_R100(M, n##3) \
+    BENCH_R100(M, n##4) BENCH_R100(M, n##5) BENCH_R100(M, n##6) BENCH_R100(M, n##7) \
+    BENCH_R100(M, n##8) BENCH_R100(M, n##9)
+#define BENCH_R10000(M, n) \
+    BENCH_R1000(M, n##0) BENCH_R1000(M, n##1) BENCH_R1000(M, n##2) BENCH_R1000(M, n##3) \
+    BENCH_R1000(M, n##4) BENCH_R1000(M, n##5) BENCH_R1000(M, n##6) BENCH_R1000(M, n##7) \
+    BENCH_R1000(M, n##8) BENCH_R1000(M, n##9)
+
+#define BENCH_FUNCTION(n) extern "C" int bench_symbol_##n() { return 0; }
+#define BENCH_POINTER(n) reinterpret_cast<void*>(bench_symbol_##n),
+
+BENCH_SYMBOLS(BENCH_FUNCTION, )
+
+void* bench_symbol_table[] = { BENCH_SYMBOLS(BENCH_POINTER, ) };
+
+#if defined(BENCH_DEPTH)
+#define BENCH_CONCAT(a, b) a##b
+#define BENCH_DEPTH_FUNCTION(d) BENCH_CONCAT(bench_depth_, d)
+
+#if defined(BENCH_DEPTH_PREVIOUS)
+extern "C" int BENCH_DEPTH_FUNCTION(BENCH_DEPTH_PREVIOUS)();
+#endif
+
+extern "C" int BENCH_DEPTH_FUNCTION(BENCH_DEPTH)() {
+#if defined(BENCH_DEPTH_PREVIOUS)
+  return BENCH_DEPTH_FUNCTION(BENCH_DEPTH_PREVIOUS)() + 1;
+#else
+  return 1;
+#endif
+}
+#endif
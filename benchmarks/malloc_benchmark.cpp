@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// These measure whichever allocator libc was built with (dlmalloc or
+// jemalloc), through whichever dispatch table is installed, so the same
+// binary also measures the debug levels:
+//   adb shell setprop libc.debug.malloc 1
+//   adb shell bionic-benchmarks BM_malloc
+
+#define KB 1024
+#define MB 1024*KB
+
+#define AT_SIZE_CLASSES \
+    Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Arg(1*KB)->Arg(4*KB)->Arg(16*KB)->Arg(64*KB)->Arg(256*KB)
+
+#define AT_THREAD_COUNTS \
+    Arg(1)->Arg(2)->Arg(4)->Arg(8)
+
+// Stops each allocation being optimized away, or hoisted out of its loop.
+/* Must not be static! */ void* volatile g_malloc_benchmark_sink;
+
+static void BM_malloc_free(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = malloc(nbytes);
+    g_malloc_benchmark_sink = ptr;
+    free(ptr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_free)->AT_SIZE_CLASSES;
+
+// BM_malloc_free on several threads at once: an allocator that scales keeps
+// per-thread ns/op flat as threads are added.
+static void BM_malloc_free_threads(int iters, int nbytes) {
+  // Not g_malloc_benchmark_sink, or the threads would fight over its cache line.
+  void* volatile sink;
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = malloc(nbytes);
+    sink = ptr;
+    free(ptr);
+  }
+  (void) sink;
+}
+BENCHMARK(BM_malloc_free_threads)->Arg(64)->Arg(4*KB)->Threads(1)->Threads(2)->Threads(4)->Threads(8);
+
+// Unlike BM_malloc_free, this keeps a working set of live blocks, so frees
+// don't just hand the last allocation straight back.
+static void BM_malloc_free_batch(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  const int kBatch = 256;
+  void* ptrs[kBatch];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; i += kBatch) {
+    for (int j = 0; j < kBatch; ++j) {
+      ptrs[j] = malloc(nbytes);
+    }
+    for (int j = 0; j < kBatch; ++j) {
+      free(ptrs[j]);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_free_batch)->AT_SIZE_CLASSES;
+
+#if defined(__BIONIC__)
+// BM_malloc_free_batch, freeing as C++'s sized operator delete does.
+static void BM_malloc_free_sized_batch(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  const int kBatch = 256;
+  void* ptrs[kBatch];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; i += kBatch) {
+    for (int j = 0; j < kBatch; ++j) {
+      ptrs[j] = malloc(nbytes);
+    }
+    for (int j = 0; j < kBatch; ++j) {
+      free_sized(ptrs[j], nbytes);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_free_sized_batch)->AT_SIZE_CLASSES;
+#endif
+
+static void BM_malloc_calloc(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = calloc(1, nbytes);
+    g_malloc_benchmark_sink = ptr;
+    free(ptr);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+}
+BENCHMARK(BM_malloc_calloc)->Arg(4*KB)->Arg(64*KB)->Arg(256*KB)->Arg(1*MB)->Arg(4*MB);
+
+static void BM_malloc_memalign(int iters, int alignment) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = memalign(alignment, 128);
+    g_malloc_benchmark_sink = ptr;
+    free(ptr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_memalign)->Arg(16)->Arg(64)->Arg(256)->Arg(4*KB);
+
+#if defined(__BIONIC__)
+// Allocates, touches and frees a huge-page region; after the first iteration
+// the region comes back from android_malloc_huge's cache already faulted in.
+static void BM_malloc_huge_reuse(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    char* ptr = reinterpret_cast<char*>(android_malloc_huge(nbytes));
+    for (int offset = 0; offset < nbytes; offset += 4*KB) {
+      ptr[offset] = 1;
+    }
+    android_free_huge(ptr);
+  }
+
+  StopBenchmarkTiming();
+  malloc_trim(0);
+}
+BENCHMARK(BM_malloc_huge_reuse)->Arg(2*MB)->Arg(8*MB)->Arg(32*MB);
+#endif
+
+// Grows a block from nothing to nbytes, the way a string or vector built up
+// one element at a time would.
+static void BM_malloc_realloc_grow_by_one(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = NULL;
+    for (int size = 1; size <= nbytes; ++size) {
+      ptr = realloc(ptr, size);
+    }
+    free(ptr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_realloc_grow_by_one)->Arg(64)->Arg(512)->Arg(4*KB);
+
+// Grows a block from 16 bytes to nbytes, doubling each time.
+static void BM_malloc_realloc_grow_doubling(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* ptr = NULL;
+    for (int size = 16; size <= nbytes; size *= 2) {
+      ptr = realloc(ptr, size);
+      // Touch the new part, as a real user would.
+      memset(reinterpret_cast<char*>(ptr) + size / 2, 0, size / 2);
+    }
+    free(ptr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_realloc_grow_doubling)->Arg(4*KB)->Arg(64*KB)->Arg(1*MB)->Arg(16*MB)->Arg(64*MB);
+
+// Producer/consumer pairs: each producer allocates blocks that its consumer
+// frees, so every free is of memory allocated by another thread.
+struct CrossThreadQueue {
+  static const size_t kSize = 1024;
+  void* slots[kSize];
+  size_t head;  // Written only by the consumer.
+  size_t tail;  // Written only by the producer.
+  int count;
+};
+
+static void* CrossThreadProducer(void* arg) {
+  CrossThreadQueue* q = reinterpret_cast<CrossThreadQueue*>(arg);
+  for (int i = 0; i < q->count; ++i) {
+    size_t tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    while (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == CrossThreadQueue::kSize) {
+      sched_yield();
+    }
+    q->slots[tail % CrossThreadQueue::kSize] = malloc(16 + (i % 8) * 16);
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+static void* CrossThreadConsumer(void* arg) {
+  CrossThreadQueue* q = reinterpret_cast<CrossThreadQueue*>(arg);
+  for (int i = 0; i < q->count; ++i) {
+    size_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == head) {
+      sched_yield();
+    }
+    free(q->slots[head % CrossThreadQueue::kSize]);
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+static void BM_malloc_cross_thread_free(int iters, int npairs) {
+  StopBenchmarkTiming();
+  CrossThreadQueue* queues = new CrossThreadQueue[npairs];
+  pthread_t* threads = new pthread_t[2 * npairs];
+  for (int i = 0; i < npairs; ++i) {
+    queues[i].head = queues[i].tail = 0;
+    queues[i].count = iters;
+  }
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < npairs; ++i) {
+    pthread_create(&threads[2 * i], NULL, CrossThreadProducer, &queues[i]);
+    pthread_create(&threads[2 * i + 1], NULL, CrossThreadConsumer, &queues[i]);
+  }
+  for (int i = 0; i < 2 * npairs; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+  delete[] queues;
+}
+BENCHMARK(BM_malloc_cross_thread_free)->AT_THREAD_COUNTS;
+
+// The same work as BM_malloc_cross_thread_free, with each thread freeing its
+// own blocks, for comparison.
+static void* SameThreadWorker(void* arg) {
+  int count = *reinterpret_cast<int*>(arg);
+  for (int i = 0; i < count; ++i) {
+    void* ptr = malloc(16 + (i % 8) * 16);
+    g_malloc_benchmark_sink = ptr;
+    free(ptr);
+  }
+  return NULL;
+}
+
+static void BM_malloc_same_thread_free(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, SameThreadWorker, &iters);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+}
+BENCHMARK(BM_malloc_same_thread_free)->AT_THREAD_COUNTS;
@@ -19,6 +19,10 @@
 #include <fenv.h>
 #include <math.h>
 
+#if defined(__BIONIC__)
+#include <android/array_math.h>
+#endif
+
 // Avoid optimization.
 double d;
 double v;
@@ -158,6 +162,86 @@ static void BM_math_sin_fesetenv(int iters) {
 }
 BENCHMARK(BM_math_sin_fesetenv);
 
+static void BM_math_feholdexcept_feupdateenv(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fenv_t env;
+    feholdexcept(&env);
+    feupdateenv(&env);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_feholdexcept_feupdateenv);
+
+static void BM_math_sin_large(int iters) {
+  StartBenchmarkTiming();
+
+  d = 1.0;
+  v = 1e22;
+  for (int i = 0; i < iters; ++i) {
+    d += sin(v + d);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sin_large);
+
+static void BM_math_sincos(int iters) {
+  StartBenchmarkTiming();
+
+  d = 1.0;
+  for (int i = 0; i < iters; ++i) {
+    double s, c;
+    sincos(d, &s, &c);
+    d += s + c;
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sincos);
+
+static void BM_math_sincosf(int iters) {
+  StartBenchmarkTiming();
+
+  volatile float f = 1.0f;
+  for (int i = 0; i < iters; ++i) {
+    float s, c;
+    sincosf(f, &s, &c);
+    f += s + c;
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sincosf);
+
+static void BM_math_pow(int iters) {
+  StartBenchmarkTiming();
+
+  d = 0.5;
+  v = 0.75;
+  for (int i = 0; i < iters; ++i) {
+    d = pow(d + 1.5, v);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_pow);
+
+static void BM_math_powl(int iters) {
+  StartBenchmarkTiming();
+
+  volatile long double dl = 0.5L;
+  volatile long double vl = 0.75L;
+  for (int i = 0; i < iters; ++i) {
+    dl = powl(dl + 1.5L, vl);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_powl);
+
 static void BM_math_fpclassify_NORMAL(int iters) {
   StartBenchmarkTiming();
 
@@ -209,3 +293,196 @@ static void BM_math_fpclassify_ZERO(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_math_fpclassify_ZERO);
+
+// The float functions have a throughput benchmark, where the calls are
+// independent and can overlap, and a latency benchmark, where each call's
+// argument depends on the previous result.
+float f;
+
+static void BM_math_expf_throughput(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.0f;
+  for (int i = 0; i < iters; ++i) {
+    f += expf(-4.0f + (i & 1023) * 0.01f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_expf_throughput);
+
+static void BM_math_expf_latency(int iters) {
+  StartBenchmarkTiming();
+
+  f = -4.0f;
+  for (int i = 0; i < iters; ++i) {
+    f = expf(-f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_expf_latency);
+
+static void BM_math_logf_throughput(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.0f;
+  for (int i = 0; i < iters; ++i) {
+    f += logf(1.0f + (i & 1023) * 0.01f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_logf_throughput);
+
+static void BM_math_logf_latency(int iters) {
+  StartBenchmarkTiming();
+
+  f = 1.0f;
+  for (int i = 0; i < iters; ++i) {
+    f = logf(f + 3.0f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_logf_latency);
+
+static void BM_math_powf_throughput(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.0f;
+  for (int i = 0; i < iters; ++i) {
+    f += powf(1.0f + (i & 1023) * 0.01f, 1.25f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_powf_throughput);
+
+static void BM_math_powf_latency(int iters) {
+  StartBenchmarkTiming();
+
+  f = 1.0f;
+  for (int i = 0; i < iters; ++i) {
+    f = powf(f + 1.5f, 1.25f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_powf_latency);
+
+static void BM_math_sinf_throughput(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.0f;
+  for (int i = 0; i < iters; ++i) {
+    f += sinf(0.5f + (i & 1023) * 0.01f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sinf_throughput);
+
+static void BM_math_sinf_latency(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.5f;
+  for (int i = 0; i < iters; ++i) {
+    f = sinf(f + 1.0f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sinf_latency);
+
+static void BM_math_cosf_throughput(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.0f;
+  for (int i = 0; i < iters; ++i) {
+    f += cosf(0.5f + (i & 1023) * 0.01f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_cosf_throughput);
+
+static void BM_math_cosf_latency(int iters) {
+  StartBenchmarkTiming();
+
+  f = 0.5f;
+  for (int i = 0; i < iters; ++i) {
+    f = cosf(f);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_cosf_latency);
+
+// A 4096-sample block, as audio and sensor code process them, done with
+// scalar calls and with the array functions.
+static const size_t kBlockSize = 4096;
+static float g_block_in[kBlockSize];
+static float g_block_out[kBlockSize];
+
+static void FillBlock() {
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    g_block_in[i] = -4.0f + (i & 1023) * 0.01f;
+  }
+}
+
+static void BM_math_expf_block(int iters) {
+  FillBlock();
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    for (size_t j = 0; j < kBlockSize; ++j) {
+      g_block_out[j] = expf(g_block_in[j]);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_expf_block);
+
+#if defined(__BIONIC__)
+static void BM_math_expf_array(int iters) {
+  FillBlock();
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_math_expf_array(g_block_in, g_block_out, kBlockSize);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_expf_array);
+#endif
+
+static void BM_math_sinf_block(int iters) {
+  FillBlock();
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    for (size_t j = 0; j < kBlockSize; ++j) {
+      g_block_out[j] = sinf(g_block_in[j]);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sinf_block);
+
+#if defined(__BIONIC__)
+static void BM_math_sinf_array(int iters) {
+  FillBlock();
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_math_sinf_array(g_block_in, g_block_out, kBlockSize);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_math_sinf_array);
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+// The common libm functions over realistic input ranges, each measured two
+// ways. Names are
+//   BM_math_matrix/<function>/<range>/throughput
+//   BM_math_matrix/<function>/<range>/latency
+// where throughput calls are independent of each other, and each latency
+// call's argument depends on the previous result: it's the next input plus
+// the result times zero, which adds a multiply and an add to every call.
+// Compare kernels with, for example,
+//   bionic-benchmarks 'matrix/sinf/.*/latency'
+
+typedef double (*Double1)(double);
+typedef double (*Double2)(double, double);
+typedef float (*Float1)(float);
+typedef float (*Float2)(float, float);
+
+// The other matrix benchmark has types of the same names, so keep these to
+// ourselves: in one binary they'd otherwise silently share a std::vector<Config>.
+namespace {
+
+// Inputs drawn from [lo, hi], uniformly in the exponent rather than the
+// value if log_scale is set.
+struct Range {
+  double lo;
+  double hi;
+  bool log_scale;
+};
+
+struct Function {
+  const char* name;
+  const char* range_name;
+  Double1 d1;
+  Double2 d2;
+  Float1 f1;
+  Float2 f2;
+  Range x;
+  Range y;
+};
+
+}  // namespace
+
+#define D1(f, range_name, x) { #f, range_name, f, NULL, NULL, NULL, x, kNone }
+#define D2(f, range_name, x, y) { #f, range_name, NULL, f, NULL, NULL, x, y }
+#define F1(f, range_name, x) { #f, range_name, NULL, NULL, f, NULL, x, kNone }
+#define F2(f, range_name, x, y) { #f, range_name, NULL, NULL, NULL, f, x, y }
+
+static const Range kNone = { 0, 0, false };
+static const Range kPiOver4 = { -M_PI_4, M_PI_4, false };
+static const Range kHundred = { -100, 100, false };
+static const Range kHugeTrig = { 1e6, 1e300, true };
+static const Range kHugeTrigF = { 1e6, 1e38, true };
+static const Range kUnit = { -1, 1, false };
+static const Range kTen = { -10, 10, false };
+static const Range kExpWide = { -700, 700, false };
+static const Range kExpWideF = { -87, 88, false };
+static const Range kNearOne = { 0.5, 2, false };
+static const Range kLogWide = { 1e-300, 1e300, true };
+static const Range kLogWideF = { 1e-37, 1e38, true };
+static const Range kLog1p = { -0.5, 1, false };
+static const Range kPowX = { 0.1, 10, false };
+static const Range kPowXWide = { 1e-10, 1e10, true };
+static const Range kPowYWide = { -20, 20, false };
+static const Range kSqrt = { 0, 1e10, false };
+static const Range kCbrt = { -1e10, 1e10, false };
+static const Range kHypot = { -1e3, 1e3, false };
+static const Range kFmodX = { -1e6, 1e6, false };
+static const Range kFmodY = { 1, 100, false };
+
+static const Function kFunctions[] = {
+  D1(sin, "pio4", kPiOver4),
+  D1(sin, "100", kHundred),
+  D1(sin, "huge", kHugeTrig),
+  D1(cos, "pio4", kPiOver4),
+  D1(cos, "100", kHundred),
+  D1(cos, "huge", kHugeTrig),
+  D1(tan, "pio4", kPiOver4),
+  D1(tan, "100", kHundred),
+  D1(tan, "huge", kHugeTrig),
+  D1(asin, "unit", kUnit),
+  D1(acos, "unit", kUnit),
+  D1(atan, "10", kTen),
+  D2(atan2, "10", kTen, kTen),
+  D1(sinh, "10", kTen),
+  D1(cosh, "10", kTen),
+  D1(tanh, "10", kTen),
+  D1(exp, "10", kTen),
+  D1(exp, "wide", kExpWide),
+  D1(exp2, "10", kTen),
+  D1(expm1, "unit", kUnit),
+  D1(log, "near1", kNearOne),
+  D1(log, "wide", kLogWide),
+  D1(log2, "wide", kLogWide),
+  D1(log10, "wide", kLogWide),
+  D1(log1p, "small", kLog1p),
+  D2(pow, "10", kPowX, kTen),
+  D2(pow, "wide", kPowXWide, kPowYWide),
+  D1(sqrt, "wide", kSqrt),
+  D1(cbrt, "wide", kCbrt),
+  D2(hypot, "1000", kHypot, kHypot),
+  D2(fmod, "wide", kFmodX, kFmodY),
+
+  F1(sinf, "pio4", kPiOver4),
+  F1(sinf, "100", kHundred),
+  F1(sinf, "huge", kHugeTrigF),
+  F1(cosf, "pio4", kPiOver4),
+  F1(cosf, "100", kHundred),
+  F1(cosf, "huge", kHugeTrigF),
+  F1(tanf, "100", kHundred),
+  F1(atanf, "10", kTen),
+  F1(tanhf, "10", kTen),
+  F1(expf, "10", kTen),
+  F1(expf, "wide", kExpWideF),
+  F1(exp2f, "10", kTen),
+  F1(logf, "near1", kNearOne),
+  F1(logf, "wide", kLogWideF),
+  F1(log2f, "wide", kLogWideF),
+  F2(powf, "10", kPowX, kTen),
+  F1(sqrtf, "wide", kSqrt),
+};
+
+static const size_t kValueCount = 1024;  // A power of two.
+
+namespace {
+
+struct Config {
+  const Function* function;
+  bool latency;
+  std::vector<double> x;
+  std::vector<double> y;
+  char name[64];
+};
+
+}  // namespace
+
+static std::vector<Config> g_configs;
+
+// A small fixed-seed generator, so every run sees the same inputs.
+static uint32_t NextRandom(uint32_t* state) {
+  *state = *state * 1103515245 + 12345;
+  return *state >> 16;
+}
+
+static double RandomIn(const Range& range, uint32_t* state) {
+  double u = ((NextRandom(state) << 16) | NextRandom(state)) / 4294967296.0;
+  if (!range.log_scale) {
+    return range.lo + u * (range.hi - range.lo);
+  }
+  return exp(log(range.lo) + u * (log(range.hi) - log(range.lo)));
+}
+
+static void BuildConfigs() {
+  uint32_t random = 1;
+  for (size_t f = 0; f < sizeof(kFunctions)/sizeof(kFunctions[0]); ++f) {
+    const Function& function = kFunctions[f];
+    std::vector<double> x(kValueCount);
+    std::vector<double> y(kValueCount);
+    for (size_t i = 0; i < kValueCount; ++i) {
+      x[i] = RandomIn(function.x, &random);
+      y[i] = RandomIn(function.y, &random);
+    }
+    for (int latency = 0; latency < 2; ++latency) {
+      Config config;
+      config.function = &function;
+      config.latency = latency;
+      config.x = x;
+      config.y = y;
+      snprintf(config.name, sizeof(config.name), "BM_math_matrix/%s/%s/%s",
+               function.name, function.range_name, latency ? "latency" : "throughput");
+      g_configs.push_back(config);
+    }
+  }
+}
+
+// Keeps the results live.
+static volatile double g_sink;
+
+static void RunDouble(const Config& config, int iters) {
+  const double* x = &config.x[0];
+  const double* y = &config.y[0];
+  Double1 d1 = config.function->d1;
+  Double2 d2 = config.function->d2;
+  double sum = 0.0;
+  double r = 0.0;
+  StartBenchmarkTiming();
+  if (config.latency) {
+    for (int i = 0; i < iters; ++i) {
+      double a = x[i & (kValueCount - 1)] + r * 0.0;
+      r = (d1 != NULL) ? d1(a) : d2(a, y[i & (kValueCount - 1)]);
+    }
+    sum = r;
+  } else {
+    for (int i = 0; i < iters; ++i) {
+      sum += (d1 != NULL) ? d1(x[i & (kValueCount - 1)])
+                          : d2(x[i & (kValueCount - 1)], y[i & (kValueCount - 1)]);
+    }
+  }
+  StopBenchmarkTiming();
+  g_sink = sum;
+}
+
+static void RunFloat(const Config& config, int iters) {
+  // Convert up front, so the loops only touch floats.
+  std::vector<float> xf(config.x.begin(), config.x.end());
+  std::vector<float> yf(config.y.begin(), config.y.end());
+  const float* x = &xf[0];
+  const float* y = &yf[0];
+  Float1 f1 = config.function->f1;
+  Float2 f2 = config.function->f2;
+  float sum = 0.0f;
+  float r = 0.0f;
+  StartBenchmarkTiming();
+  if (config.latency) {
+    for (int i = 0; i < iters; ++i) {
+      float a = x[i & (kValueCount - 1)] + r * 0.0f;
+      r = (f1 != NULL) ? f1(a) : f2(a, y[i & (kValueCount - 1)]);
+    }
+    sum = r;
+  } else {
+    for (int i = 0; i < iters; ++i) {
+      sum += (f1 != NULL) ? f1(x[i & (kValueCount - 1)])
+                          : f2(x[i & (kValueCount - 1)], y[i & (kValueCount - 1)]);
+    }
+  }
+  StopBenchmarkTiming();
+  g_sink = sum;
+}
+
+static void RunMatrix(const Config& config, int iters) {
+  StopBenchmarkTiming();
+  if (config.function->d1 != NULL || config.function->d2 != NULL) {
+    RunDouble(config, iters);
+  } else {
+    RunFloat(config, iters);
+  }
+}
+
+// The benchmark harness only hands us the iteration count, so each row of
+// the matrix gets its own instantiation that knows its index in g_configs.
+static const size_t kMaxConfigs = 128;
+
+template <size_t kIndex>
+static void BM_math_matrix(int iters) {
+  RunMatrix(g_configs[kIndex], iters);
+}
+
+template <size_t kCount>
+struct Registrar {
+  static void Register() {
+    Registrar<kCount - 1>::Register();
+    if (kCount - 1 < g_configs.size()) {
+      new ::testing::Benchmark(g_configs[kCount - 1].name, BM_math_matrix<kCount - 1>);
+    }
+  }
+};
+
+template <>
+struct Registrar<0> {
+  static void Register() {}
+};
+
+static bool RegisterMatrix() {
+  BuildConfigs();
+  if (g_configs.size() > kMaxConfigs) {
+    fprintf(stderr, "BM_math_matrix: %zu configurations, but only room for %zu\n",
+            g_configs.size(), kMaxConfigs);
+    exit(EXIT_FAILURE);
+  }
+  Registrar<kMaxConfigs>::Register();
+  return true;
+}
+
+static bool g_matrix_registered __attribute__((unused)) = RegisterMatrix();
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.h"
+
+#include <mntent.h>
+
+// Disk usage monitors scan the whole mount table, which can run to thousands
+// of lines on hosts with many bind mounts.
+static void BM_mntent_getmntent(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    FILE* fp = setmntent("/proc/self/mounts", "r");
+    while (getmntent(fp) != NULL) {
+    }
+    endmntent(fp);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_mntent_getmntent);
+
+#if defined(__BIONIC__)
+static int CountMount(const android_mountinfo*, void* arg) {
+  ++*reinterpret_cast<int*>(arg);
+  return 0;
+}
+
+static void BM_mntent_android_mountinfo_iterate(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    int count = 0;
+    android_mountinfo_iterate(CountMount, &count);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_mntent_android_mountinfo_iterate);
+#endif
@@ -16,8 +16,11 @@
 
 #include "benchmark.h"
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 
 #define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
@@ -231,3 +234,259 @@ static void BM_property_serial(int iters, int nprops)
     delete[] pinfo;
 }
 BENCHMARK(BM_property_serial)->TEST_NUM_PROPS;
+
+static void BM_property_read_handle(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    srandom(iters * nprops);
+    prop_handle* handles = new prop_handle[nprops];
+    char** values = new char*[nprops];
+    unsigned* serials = new unsigned[nprops];
+
+    for (int i = 0; i < nprops; i++) {
+        handles[i].name = pa.names[i];
+        handles[i].pi = NULL;
+        values[i] = new char[PROP_VALUE_MAX];
+        values[i][0] = '\0';
+        serials[i] = 0;
+    }
+
+    StartBenchmarkTiming();
+    for (int i = 0; i < iters; i++) {
+        int n = random() % nprops;
+        __system_property_read_handle(&handles[n], values[n], &serials[n]);
+    }
+    StopBenchmarkTiming();
+
+    for (int i = 0; i < nprops; i++) {
+        delete[] values[i];
+    }
+    delete[] values;
+    delete[] serials;
+    delete[] handles;
+}
+BENCHMARK(BM_property_read_handle)->TEST_NUM_PROPS;
+
+static void foreach_read_fn(const prop_info *pi, void *cookie)
+{
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+
+    __system_property_read(pi, name, value);
+    (*reinterpret_cast<int*>(cookie))++;
+}
+
+static void BM_property_foreach_read(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    int count = 0;
+
+    StartBenchmarkTiming();
+    for (int i = 0; i < iters; i++) {
+        __system_property_foreach(foreach_read_fn, &count);
+    }
+    StopBenchmarkTiming();
+}
+BENCHMARK(BM_property_foreach_read)->TEST_NUM_PROPS;
+
+static void BM_property_snapshot(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    const size_t size = nprops * (PROP_NAME_MAX + PROP_VALUE_MAX);
+    char* buf = new char[size];
+
+    StartBenchmarkTiming();
+    for (int i = 0; i < iters; i++) {
+        __system_property_snapshot("", buf, size, NULL);
+    }
+    StopBenchmarkTiming();
+
+    delete[] buf;
+}
+BENCHMARK(BM_property_snapshot)->TEST_NUM_PROPS;
+
+static int64_t NowNs()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<int64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
+}
+
+struct UpdaterState {
+    LocalPropertyTestState* pa;
+    prop_info** pinfo;
+    volatile bool stop;
+};
+
+// Updates random properties as fast as it can until told to stop.
+static void* UpdateProperties(void* arg)
+{
+    UpdaterState* state = reinterpret_cast<UpdaterState*>(arg);
+    unsigned seed = 1;
+    while (!state->stop) {
+        int n = rand_r(&seed) % state->pa->nprops;
+        __system_property_update(state->pinfo[n], state->pa->values[n], state->pa->value_lens[n]);
+    }
+    return NULL;
+}
+
+// Reads while another thread updates: the fewer properties, the more often
+// a read meets an update and has to retry.
+static void BM_property_read_contended(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    UpdaterState state;
+    state.pa = &pa;
+    state.pinfo = new prop_info*[nprops];
+    state.stop = false;
+    for (int i = 0; i < nprops; i++) {
+        state.pinfo[i] = const_cast<prop_info*>(__system_property_find(pa.names[i]));
+    }
+
+    srandom(iters * nprops);
+    const prop_info** pinfo = new const prop_info*[iters];
+    char propvalue[PROP_VALUE_MAX];
+
+    for (int i = 0; i < iters; i++) {
+        pinfo[i] = state.pinfo[random() % nprops];
+    }
+
+    pthread_t updater;
+    pthread_create(&updater, NULL, UpdateProperties, &state);
+
+    StartBenchmarkTiming();
+    for (int i = 0; i < iters; i++) {
+        __system_property_read(pinfo[i], 0, propvalue);
+    }
+    StopBenchmarkTiming();
+
+    state.stop = true;
+    pthread_join(updater, NULL);
+    delete[] pinfo;
+    delete[] state.pinfo;
+}
+BENCHMARK(BM_property_read_contended)->Arg(1)->Arg(16)->Arg(512);
+
+struct NotifierState {
+    prop_info* pi;
+    int request_fd;
+    volatile int64_t update_ns;
+};
+
+// Updates the property each time it's asked to, once the waiter has had
+// time to go to sleep.
+static void* NotifyWaiter(void* arg)
+{
+    NotifierState* state = reinterpret_cast<NotifierState*>(arg);
+    char c;
+    while (read(state->request_fd, &c, 1) == 1) {
+        usleep(100);
+        state->update_ns = NowNs();
+        __system_property_update(state->pi, c == 'a' ? "a" : "b", 1);
+    }
+    return NULL;
+}
+
+// Time from __system_property_update to a waiter waking up, waiting on the
+// one property (1) or on any property (0).
+static void BM_property_wait_latency(int iters, int specific)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(1);
+
+    if (!pa.valid)
+        return;
+
+    int fds[2];
+    if (pipe(fds) == -1)
+        return;
+
+    NotifierState state;
+    state.pi = const_cast<prop_info*>(__system_property_find(pa.names[0]));
+    state.request_fd = fds[0];
+    state.update_ns = 0;
+
+    pthread_t notifier;
+    pthread_create(&notifier, NULL, NotifyWaiter, &state);
+
+    unsigned int area_serial = __system_property_wait_any(0);
+    for (int i = 0; i < iters; i++) {
+        unsigned int serial = __system_property_serial(state.pi);
+        char c = (i % 2) ? 'a' : 'b';
+        if (write(fds[1], &c, 1) != 1)
+            break;
+
+        StartBenchmarkTiming();
+        if (specific) {
+            __system_property_wait(state.pi, serial);
+        } else {
+            area_serial = __system_property_wait_any(area_serial);
+        }
+        int64_t woken_ns = NowNs();
+        StopBenchmarkTiming();
+        AddBenchmarkLatency(woken_ns - state.update_ns);
+    }
+
+    close(fds[1]);
+    pthread_join(notifier, NULL);
+    close(fds[0]);
+}
+BENCHMARK(BM_property_wait_latency)->Arg(0)->Arg(1);
+
+// What a new process pays for its first lookup: mapping the area and
+// faulting in the pages the lookup touches.
+static void BM_property_find_cold(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    void* writer_pa = __system_property_area__;
+    srandom(iters * nprops);
+
+    for (int i = 0; i < iters; i++) {
+        const char* name = pa.names[random() % nprops];
+
+        StartBenchmarkTiming();
+        int result = __system_properties_init();
+        __system_property_find(name);
+        StopBenchmarkTiming();
+
+        if (result != 0) {
+            // Only areas that root wrote get mapped read-only.
+            printf("Failed to map the property area read-only, terminating...\n");
+            exit(1);
+        }
+        munmap(__system_property_area__, PA_SIZE);
+        __system_property_area__ = writer_pa;
+    }
+}
+BENCHMARK(BM_property_find_cold)->TEST_NUM_PROPS;
@@ -17,6 +17,14 @@
 #include "benchmark.h"
 
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#if !defined(__BIONIC__)
+// glibc only has the non-portable names for these.
+#define PTHREAD_ERRORCHECK_MUTEX_INITIALIZER PTHREAD_ERRORCHECK_MUTEX_INITIALIZER_NP
+#define PTHREAD_RECURSIVE_MUTEX_INITIALIZER PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+#endif
 
 // Stop GCC optimizing out our pure function.
 /* Must not be static! */ pthread_t (*pthread_self_fp)() = pthread_self;
@@ -47,6 +55,123 @@ static void BM_pthread_getspecific(int iters) {
 }
 BENCHMARK(BM_pthread_getspecific);
 
+static void BM_pthread_key_create_delete(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_key_t key;
+    pthread_key_create(&key, NULL);
+    pthread_key_delete(key);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_key_create_delete);
+
+// Runtimes ask this for the bounds of the stack they're scanning. On the
+// main thread, the stack's top has to be found in /proc/self/maps.
+static void BM_pthread_attr_getstack_main_thread(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_attr_t attr;
+    pthread_getattr_np(pthread_self(), &attr);
+    void* stack_base;
+    size_t stack_size;
+    pthread_attr_getstack(&attr, &stack_base, &stack_size);
+    pthread_attr_destroy(&attr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_attr_getstack_main_thread);
+
+#if defined(__BIONIC__)
+// A daemon sampling its threads' stack depth calls this for each of them.
+static void BM_pthread_get_stack_usage(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    size_t used;
+    size_t size;
+    android_pthread_get_stack_usage(pthread_self(), &used, &size);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_get_stack_usage);
+#endif
+
+// Pins the calling thread to the n'th CPU (modulo the number available) of
+// its current affinity mask, so that results don't depend on where the
+// scheduler happens to put the threads.
+static void PinToCpu(int n) {
+  cpu_set_t available;
+  if (sched_getaffinity(0, sizeof(available), &available) == -1 || CPU_COUNT(&available) == 0) {
+    return;
+  }
+  n %= CPU_COUNT(&available);
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &available) && n-- == 0) {
+      cpu_set_t pinned;
+      CPU_ZERO(&pinned);
+      CPU_SET(cpu, &pinned);
+      sched_setaffinity(0, sizeof(pinned), &pinned);
+      return;
+    }
+  }
+}
+
+static void* EmptyThreadFn(void*) {
+  return NULL;
+}
+
+static void BM_pthread_create_join(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, EmptyThreadFn, NULL);
+    pthread_join(thread, NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_create_join);
+
+// Keeps up to kDetachedThreadsInFlight detached threads running at once,
+// as a server handing each request to a short-lived thread would.
+static const int kDetachedThreadsInFlight = 64;
+
+static void* DetachedThreadFn(void* arg) {
+  sem_post(reinterpret_cast<sem_t*>(arg));
+  return NULL;
+}
+
+static void BM_pthread_create_detached(int iters) {
+  StopBenchmarkTiming();
+  sem_t slots;
+  sem_init(&slots, 0, kDetachedThreadsInFlight);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    sem_wait(&slots);
+    pthread_t thread;
+    pthread_create(&thread, &attr, DetachedThreadFn, &slots);
+  }
+  for (int i = 0; i < kDetachedThreadsInFlight; ++i) {
+    sem_wait(&slots);
+  }
+
+  StopBenchmarkTiming();
+  pthread_attr_destroy(&attr);
+  sem_destroy(&slots);
+}
+BENCHMARK(BM_pthread_create_detached);
+
 static void DummyPthreadOnceInitFunction() {
 }
 
@@ -78,6 +203,20 @@ static void BM_pthread_mutex_lock(int iters) {
 }
 BENCHMARK(BM_pthread_mutex_lock);
 
+static void BM_pthread_mutex_lock_ADAPTIVE(int iters) {
+  StopBenchmarkTiming();
+  pthread_mutex_t mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_mutex_lock_ADAPTIVE);
+
 static void BM_pthread_mutex_lock_ERRORCHECK(int iters) {
   StopBenchmarkTiming();
   pthread_mutex_t mutex = PTHREAD_ERRORCHECK_MUTEX_INITIALIZER;
@@ -105,3 +244,464 @@ static void BM_pthread_mutex_lock_RECURSIVE(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_pthread_mutex_lock_RECURSIVE);
+
+// Several threads take turns at a short critical section, so most lock
+// calls find the mutex held by a thread that's about to release it.
+struct ContendedMutexArgs {
+  pthread_mutex_t* mutex;
+  int iters;
+  volatile int* counter;
+};
+
+static void* ContendedMutexFn(void* arg) {
+  ContendedMutexArgs* args = reinterpret_cast<ContendedMutexArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    pthread_mutex_lock(args->mutex);
+    for (int j = 0; j < 16; ++j) {
+      ++*args->counter;
+    }
+    pthread_mutex_unlock(args->mutex);
+  }
+  return NULL;
+}
+
+static void RunContendedMutexBenchmark(pthread_mutex_t* mutex, int iters, int nthreads) {
+  StopBenchmarkTiming();
+  volatile int counter = 0;
+  ContendedMutexArgs args = { mutex, iters / nthreads, &counter };
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, ContendedMutexFn, &args);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+}
+
+static void BM_pthread_mutex_lock_contended(int iters, int nthreads) {
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  RunContendedMutexBenchmark(&mutex, iters, nthreads);
+}
+BENCHMARK(BM_pthread_mutex_lock_contended)->Arg(2)->Arg(4)->Arg(8);
+
+static void BM_pthread_mutex_lock_contended_ADAPTIVE(int iters, int nthreads) {
+  pthread_mutex_t mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  RunContendedMutexBenchmark(&mutex, iters, nthreads);
+}
+BENCHMARK(BM_pthread_mutex_lock_contended_ADAPTIVE)->Arg(2)->Arg(4)->Arg(8);
+
+struct PinnedContendedMutexArgs {
+  ContendedMutexArgs* args;
+  int cpu;
+};
+
+static void* PinnedContendedMutexFn(void* arg) {
+  PinnedContendedMutexArgs* pinned = reinterpret_cast<PinnedContendedMutexArgs*>(arg);
+  PinToCpu(pinned->cpu);
+  return ContendedMutexFn(pinned->args);
+}
+
+// Like BM_pthread_mutex_lock_contended, but with each thread on a CPU of its own
+// (as far as there are enough), so the lock really does bounce between CPUs.
+static void BM_pthread_mutex_lock_contended_pinned(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  volatile int counter = 0;
+  ContendedMutexArgs args = { &mutex, iters / nthreads, &counter };
+  PinnedContendedMutexArgs* pinned = new PinnedContendedMutexArgs[nthreads];
+  pthread_t* threads = new pthread_t[nthreads];
+  for (int i = 0; i < nthreads; ++i) {
+    pinned[i].args = &args;
+    pinned[i].cpu = i;
+  }
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, PinnedContendedMutexFn, &pinned[i]);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+  delete[] pinned;
+}
+BENCHMARK(BM_pthread_mutex_lock_contended_pinned)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+// The harness runs this on several pinned threads at once, so unlike the
+// benchmarks above it reports per-thread latency and total throughput.
+static pthread_mutex_t g_shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int g_shared_mutex_counter;
+
+static void BM_pthread_mutex_lock_shared(int iters) {
+  for (int i = 0; i < iters; ++i) {
+    pthread_mutex_lock(&g_shared_mutex);
+    for (int j = 0; j < 16; ++j) {
+      ++g_shared_mutex_counter;
+    }
+    pthread_mutex_unlock(&g_shared_mutex);
+  }
+}
+BENCHMARK(BM_pthread_mutex_lock_shared)->Threads(1)->Threads(2)->Threads(4)->Threads(8);
+
+static void BM_pthread_rwlock_read(int iters) {
+  StopBenchmarkTiming();
+  pthread_rwlock_t lock;
+  pthread_rwlock_init(&lock, NULL);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_rwlock_rdlock(&lock);
+    pthread_rwlock_unlock(&lock);
+  }
+
+  StopBenchmarkTiming();
+  pthread_rwlock_destroy(&lock);
+}
+BENCHMARK(BM_pthread_rwlock_read);
+
+static void BM_pthread_rwlock_write(int iters) {
+  StopBenchmarkTiming();
+  pthread_rwlock_t lock;
+  pthread_rwlock_init(&lock, NULL);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_rwlock_wrlock(&lock);
+    pthread_rwlock_unlock(&lock);
+  }
+
+  StopBenchmarkTiming();
+  pthread_rwlock_destroy(&lock);
+}
+BENCHMARK(BM_pthread_rwlock_write);
+
+// Every thread mostly reads, taking the write lock once in 'write_interval'
+// iterations (never, if it's 0), as a read-mostly cache would.
+struct ContendedRwlockArgs {
+  pthread_rwlock_t* lock;
+  int iters;
+  int write_interval;
+};
+
+static void* ContendedRwlockFn(void* arg) {
+  ContendedRwlockArgs* args = reinterpret_cast<ContendedRwlockArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    if (args->write_interval != 0 && i % args->write_interval == 0) {
+      pthread_rwlock_wrlock(args->lock);
+    } else {
+      pthread_rwlock_rdlock(args->lock);
+    }
+    pthread_rwlock_unlock(args->lock);
+  }
+  return NULL;
+}
+
+static void RunContendedRwlockBenchmark(int iters, int nthreads, int write_interval) {
+  StopBenchmarkTiming();
+  pthread_rwlock_t lock;
+  pthread_rwlock_init(&lock, NULL);
+  ContendedRwlockArgs args = { &lock, iters / nthreads, write_interval };
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, ContendedRwlockFn, &args);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+  pthread_rwlock_destroy(&lock);
+}
+
+static void BM_pthread_rwlock_read_contended(int iters, int nthreads) {
+  RunContendedRwlockBenchmark(iters, nthreads, 0);
+}
+BENCHMARK(BM_pthread_rwlock_read_contended)->Arg(2)->Arg(4)->Arg(8);
+
+static void BM_pthread_rwlock_read_mostly_contended(int iters, int nthreads) {
+  RunContendedRwlockBenchmark(iters, nthreads, 64);
+}
+BENCHMARK(BM_pthread_rwlock_read_mostly_contended)->Arg(2)->Arg(4)->Arg(8);
+
+static void BM_pthread_cond_signal_no_waiters(int iters) {
+  StopBenchmarkTiming();
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_cond_signal(&cond);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_cond_signal_no_waiters);
+
+// 'nthreads' threads meet at a barrier built from a mutex and a condition
+// variable; the last to arrive broadcasts to the rest.
+struct CondBarrier {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int nthreads;
+  int arrived;
+  int generation;
+};
+
+static void CondBarrierWait(CondBarrier* barrier) {
+  pthread_mutex_lock(&barrier->mutex);
+  int generation = barrier->generation;
+  if (++barrier->arrived == barrier->nthreads) {
+    barrier->arrived = 0;
+    ++barrier->generation;
+    pthread_cond_broadcast(&barrier->cond);
+  } else {
+    while (generation == barrier->generation) {
+      pthread_cond_wait(&barrier->cond, &barrier->mutex);
+    }
+  }
+  pthread_mutex_unlock(&barrier->mutex);
+}
+
+struct CondBarrierArgs {
+  CondBarrier* barrier;
+  int iters;
+};
+
+static void* CondBarrierFn(void* arg) {
+  CondBarrierArgs* args = reinterpret_cast<CondBarrierArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    CondBarrierWait(args->barrier);
+  }
+  return NULL;
+}
+
+static void BM_pthread_cond_broadcast_barrier(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  CondBarrier barrier = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, nthreads, 0, 0 };
+  CondBarrierArgs args = { &barrier, iters };
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, CondBarrierFn, &args);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+}
+BENCHMARK(BM_pthread_cond_broadcast_barrier)->Arg(4)->Arg(16)->Arg(64);
+
+// Two threads hand a token back and forth through a condition variable, so
+// every iteration is two wakeups: this measures wakeup latency rather than
+// throughput. The argument says where the threads run: 0 leaves it to the
+// scheduler, 1 pins both to the same CPU and 2 pins them to different CPUs.
+struct PingPongArgs {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int turn;
+  int iters;
+  int placement;
+};
+
+static void PingPongPlace(PingPongArgs* args, int player) {
+  if (args->placement == 1) {
+    PinToCpu(0);
+  } else if (args->placement == 2) {
+    PinToCpu(player);
+  }
+}
+
+static void PingPongPlay(PingPongArgs* args, int player) {
+  for (int i = 0; i < args->iters; ++i) {
+    pthread_mutex_lock(&args->mutex);
+    while (args->turn != player) {
+      pthread_cond_wait(&args->cond, &args->mutex);
+    }
+    args->turn = 1 - player;
+    pthread_cond_signal(&args->cond);
+    pthread_mutex_unlock(&args->mutex);
+  }
+}
+
+static void* PingPongFn(void* arg) {
+  PingPongArgs* args = reinterpret_cast<PingPongArgs*>(arg);
+  PingPongPlace(args, 1);
+  PingPongPlay(args, 1);
+  return NULL;
+}
+
+static void BM_pthread_cond_ping_pong(int iters, int placement) {
+  StopBenchmarkTiming();
+  PingPongArgs args = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, iters, placement };
+  cpu_set_t original;
+  sched_getaffinity(0, sizeof(original), &original);
+  PingPongPlace(&args, 0);
+  StartBenchmarkTiming();
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, PingPongFn, &args);
+  PingPongPlay(&args, 0);
+  pthread_join(thread, NULL);
+
+  StopBenchmarkTiming();
+  sched_setaffinity(0, sizeof(original), &original);
+}
+BENCHMARK(BM_pthread_cond_ping_pong)->Arg(0)->Arg(1)->Arg(2);
+
+// One thread broadcasts to 'nthreads' waiters and waits for all of them to
+// have woken before the next round, so each iteration is one fan-out.
+struct FanOutArgs {
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  int round;
+  int woken;
+  int iters;
+};
+
+static void* FanOutWaiterFn(void* arg) {
+  FanOutArgs* args = reinterpret_cast<FanOutArgs*>(arg);
+  pthread_mutex_lock(&args->mutex);
+  for (int round = 1; round <= args->iters; ++round) {
+    while (args->round < round) {
+      pthread_cond_wait(&args->start, &args->mutex);
+    }
+    ++args->woken;
+    pthread_cond_signal(&args->done);
+  }
+  pthread_mutex_unlock(&args->mutex);
+  return NULL;
+}
+
+static void BM_pthread_cond_broadcast_fan_out(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  FanOutArgs args = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                      0, 0, iters };
+  pthread_t* threads = new pthread_t[nthreads];
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, FanOutWaiterFn, &args);
+  }
+  StartBenchmarkTiming();
+
+  pthread_mutex_lock(&args.mutex);
+  for (int i = 0; i < iters; ++i) {
+    args.woken = 0;
+    ++args.round;
+    pthread_cond_broadcast(&args.start);
+    while (args.woken < nthreads) {
+      pthread_cond_wait(&args.done, &args.mutex);
+    }
+  }
+  pthread_mutex_unlock(&args.mutex);
+
+  StopBenchmarkTiming();
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  delete[] threads;
+}
+BENCHMARK(BM_pthread_cond_broadcast_fan_out)->Arg(4)->Arg(16)->Arg(64);
+
+struct BarrierArgs {
+  pthread_barrier_t* barrier;
+  int iters;
+};
+
+static void* BarrierFn(void* arg) {
+  BarrierArgs* args = reinterpret_cast<BarrierArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    pthread_barrier_wait(args->barrier);
+  }
+  return NULL;
+}
+
+// Compare with BM_pthread_cond_broadcast_barrier.
+static void BM_pthread_barrier_wait(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  pthread_barrier_t barrier;
+  pthread_barrier_init(&barrier, NULL, nthreads);
+  BarrierArgs args = { &barrier, iters };
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, BarrierFn, &args);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+  pthread_barrier_destroy(&barrier);
+}
+BENCHMARK(BM_pthread_barrier_wait)->Arg(4)->Arg(16)->Arg(64);
+
+static void BM_pthread_spin_lock(int iters) {
+  StopBenchmarkTiming();
+  pthread_spinlock_t lock;
+  pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_spin_lock(&lock);
+    pthread_spin_unlock(&lock);
+  }
+
+  StopBenchmarkTiming();
+  pthread_spin_destroy(&lock);
+}
+BENCHMARK(BM_pthread_spin_lock);
+
+struct ContendedSpinlockArgs {
+  pthread_spinlock_t* lock;
+  int iters;
+  volatile int* counter;
+};
+
+static void* ContendedSpinlockFn(void* arg) {
+  ContendedSpinlockArgs* args = reinterpret_cast<ContendedSpinlockArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    pthread_spin_lock(args->lock);
+    for (int j = 0; j < 16; ++j) {
+      ++*args->counter;
+    }
+    pthread_spin_unlock(args->lock);
+  }
+  return NULL;
+}
+
+// Compare with BM_pthread_mutex_lock_contended.
+static void BM_pthread_spin_lock_contended(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  pthread_spinlock_t lock;
+  pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE);
+  volatile int counter = 0;
+  ContendedSpinlockArgs args = { &lock, iters / nthreads, &counter };
+  pthread_t* threads = new pthread_t[nthreads];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, ContendedSpinlockFn, &args);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+  pthread_spin_destroy(&lock);
+}
+BENCHMARK(BM_pthread_spin_lock_contended)->Arg(2)->Arg(4)->Arg(8);
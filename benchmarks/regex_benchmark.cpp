@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <regex.h>
+#include <stdlib.h>
+
+// Log filtering: one pattern tried against a stream of lines.
+static const char* kLines[] = {
+  "10-15 12:34:56.789  1234  5678 I ActivityManager: Start proc 4321:com.example.app/u0a123 for activity",
+  "10-15 12:34:56.801  1234  1299 W ActivityManager: Slow operation: 142ms so far, now at startProcess",
+  "10-15 12:34:57.002   987   987 E AndroidRuntime: FATAL EXCEPTION: main, connection timeout after 5000ms",
+  "10-15 12:34:57.113  2222  2230 D ConnectivityService: notifyType CAP_CHANGED for NetworkAgentInfo",
+  "10-15 12:34:57.514  1234  5678 I chatty  : uid=1000(system) Binder:1234_5 expire 4 lines",
+  "10-15 12:34:58.000  3333  3333 V MailClient: fetched 12 messages for someone@example.com",
+};
+
+static void RegexBenchmark(int iters, const char* pattern, int cflags, size_t nmatch) {
+  StopBenchmarkTiming();
+  regex_t re;
+  if (regcomp(&re, pattern, cflags) != 0) {
+    abort();
+  }
+  regmatch_t matches[4];
+  size_t line_count = sizeof(kLines) / sizeof(kLines[0]);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    regexec(&re, kLines[i % line_count], nmatch, matches, 0);
+  }
+  StopBenchmarkTiming();
+
+  regfree(&re);
+}
+
+static void BM_regex_literal(int iters) {
+  RegexBenchmark(iters, "ActivityManager", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_literal);
+
+static void BM_regex_prefix(int iters) {
+  RegexBenchmark(iters, "timeout after [0-9]+ms", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_prefix);
+
+static void BM_regex_anchored(int iters) {
+  RegexBenchmark(iters, "^[0-9-]+ [0-9:.]+ +[0-9]+ +[0-9]+ [EW] ", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_anchored);
+
+static void BM_regex_alternation(int iters) {
+  RegexBenchmark(iters, "(Activity|Connectivity|Mail)[A-Za-z]*: .*(proc|fetched)", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_alternation);
+
+static void BM_regex_classes(int iters) {
+  RegexBenchmark(iters, "[a-z]+@[a-z]+\\.com", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_classes);
+
+static void BM_regex_word_boundaries(int iters) {
+  RegexBenchmark(iters, "[[:<:]][0-9]+ms[[:>:]]", REG_EXTENDED | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_word_boundaries);
+
+static void BM_regex_icase(int iters) {
+  RegexBenchmark(iters, "fatal|slow", REG_EXTENDED | REG_ICASE | REG_NOSUB, 0);
+}
+BENCHMARK(BM_regex_icase);
+
+static void BM_regex_submatches(int iters) {
+  RegexBenchmark(iters, "([0-9]+)  *([0-9]+) ([VDIWE]) ([A-Za-z]+)", REG_EXTENDED, 4);
+}
+BENCHMARK(BM_regex_submatches);
+
+static void BM_regex_backreference(int iters) {
+  RegexBenchmark(iters, "\\(1[0-9]\\)-\\1", 0, 0);
+}
+BENCHMARK(BM_regex_backreference);
@@ -16,6 +16,7 @@
 
 #include "benchmark.h"
 
+#include <pthread.h>
 #include <semaphore.h>
 
 static void BM_semaphore_sem_getvalue(int iters) {
@@ -47,3 +48,42 @@ static void BM_semaphore_sem_wait_sem_post(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_semaphore_sem_wait_sem_post);
+
+// A producer hands items one at a time to a consumer through a pair of
+// semaphores, so most waits find the semaphore empty and have to sleep.
+struct ProducerConsumerArgs {
+  sem_t items;
+  sem_t slots;
+  int iters;
+};
+
+static void* ProducerFn(void* arg) {
+  ProducerConsumerArgs* args = reinterpret_cast<ProducerConsumerArgs*>(arg);
+  for (int i = 0; i < args->iters; ++i) {
+    sem_wait(&args->slots);
+    sem_post(&args->items);
+  }
+  return NULL;
+}
+
+static void BM_semaphore_producer_consumer(int iters) {
+  StopBenchmarkTiming();
+  ProducerConsumerArgs args;
+  sem_init(&args.items, 0, 0);
+  sem_init(&args.slots, 0, 1);
+  args.iters = iters;
+  StartBenchmarkTiming();
+
+  pthread_t producer;
+  pthread_create(&producer, NULL, ProducerFn, &args);
+  for (int i = 0; i < iters; ++i) {
+    sem_wait(&args.items);
+    sem_post(&args.slots);
+  }
+  pthread_join(producer, NULL);
+
+  StopBenchmarkTiming();
+  sem_destroy(&args.items);
+  sem_destroy(&args.slots);
+}
+BENCHMARK(BM_semaphore_producer_consumer);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "benchmark.h"
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// How long from exec to main, for an executable built from
+// startup_benchmark_exec.cpp that does nothing else.
+static void ExecToMain(int iters, const char* name) {
+  char path[PATH_MAX];
+#if defined(__LP64__)
+  snprintf(path, sizeof(path), "/system/bin/%s64", name);
+#else
+  snprintf(path, sizeof(path), "/system/bin/%s32", name);
+#endif
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+      perror("pipe");
+      abort();
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      dup2(fds[1], STDOUT_FILENO);
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      int64_t now = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+      char start[32];
+      snprintf(start, sizeof(start), "%" PRId64, now);
+      execl(path, path, start, NULL);
+      _exit(127);
+    }
+    close(fds[1]);
+
+    int64_t latency;
+    ssize_t n = read(fds[0], &latency, sizeof(latency));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (n != sizeof(latency)) {
+      fprintf(stderr, "%s didn't report its startup time\n", path);
+      abort();
+    }
+    AddBenchmarkLatency(latency);
+  }
+  StopBenchmarkTiming();
+}
+
+static void BM_startup_exec_to_main_static(int iters) {
+  ExecToMain(iters, "bionic-benchmark-startup-static");
+}
+BENCHMARK(BM_startup_exec_to_main_static);
+
+static void BM_startup_exec_to_main_dynamic(int iters) {
+  ExecToMain(iters, "bionic-benchmark-startup-dynamic");
+}
+BENCHMARK(BM_startup_exec_to_main_dynamic);
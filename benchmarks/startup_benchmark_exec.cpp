@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Run by the startup benchmarks, built both static and dynamic. Given the
+// CLOCK_MONOTONIC time its parent called exec at, writes how long it took to
+// get to main to stdout. Run by hand with LIBC_STARTUP_TRACE set, prints how
+// that time was spent instead.
+
+#include <android/startup_trace.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char* kPhaseNames[ANDROID_STARTUP_PHASE_COUNT] = {
+  "linker start", "linker load", "linker link", "libc init",
+  "libc properties", "libc vdso", "constructors", "main",
+};
+
+static int PrintTrace() {
+  uint64_t timestamps[ANDROID_STARTUP_PHASE_COUNT];
+  if (android_get_startup_trace(timestamps, ANDROID_STARTUP_PHASE_COUNT) == 0) {
+    fprintf(stderr, "run with LIBC_STARTUP_TRACE=1 to see where startup time goes\n");
+    return 1;
+  }
+  uint64_t previous = 0;
+  for (size_t i = 0; i < ANDROID_STARTUP_PHASE_COUNT; ++i) {
+    if (timestamps[i] == 0) {
+      continue;
+    }
+    if (previous != 0) {
+      printf("%-16s +%" PRIu64 " ns\n", kPhaseNames[i], timestamps[i] - previous);
+    } else {
+      printf("%-16s\n", kPhaseNames[i]);
+    }
+    previous = timestamps[i];
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  if (argc < 2) {
+    return PrintTrace();
+  }
+
+  int64_t now = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+  int64_t latency = now - strtoll(argv[1], NULL, 10);
+  return (write(STDOUT_FILENO, &latency, sizeof(latency)) == sizeof(latency)) ? 0 : 1;
+}
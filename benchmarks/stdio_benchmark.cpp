@@ -16,7 +16,9 @@
 
 #include "benchmark.h"
 
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define KB 1024
 #define MB 1024*KB
@@ -59,3 +61,195 @@ static void BM_stdio_fwrite(int iters, int chunk_size) {
   fclose(fp);
 }
 BENCHMARK(BM_stdio_fwrite)->AT_COMMON_SIZES;
+
+// Unlike /dev/zero, regular files get the larger default stdio buffer.
+#define FILE_BENCHMARK_SIZE (1*MB)
+
+static void BM_stdio_fread_file(int iters, int chunk_size) {
+  StopBenchmarkTiming();
+  FILE* fp = tmpfile();
+  char* buf = new char[chunk_size];
+  for (int i = 0; i < FILE_BENCHMARK_SIZE / KB; ++i) {
+    fwrite(buf, KB, 1, fp);
+  }
+  rewind(fp);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    if (fread(buf, chunk_size, 1, fp) != 1) {
+      rewind(fp);
+    }
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(chunk_size));
+  delete[] buf;
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fread_file)->AT_COMMON_SIZES;
+
+static void BM_stdio_fwrite_file(int iters, int chunk_size) {
+  StopBenchmarkTiming();
+  FILE* fp = tmpfile();
+  char* buf = new char[chunk_size];
+  long written = 0;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fwrite(buf, chunk_size, 1, fp);
+    written += chunk_size;
+    if (written >= FILE_BENCHMARK_SIZE) {
+      rewind(fp);
+      written = 0;
+    }
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(chunk_size));
+  delete[] buf;
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fwrite_file)->AT_COMMON_SIZES;
+
+static void BM_stdio_snprintf_log_line(int iters) {
+  char buf[128];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    snprintf(buf, sizeof(buf), "%d %s %llx\n", i, "a log message", 0x7f00deadbeefULL + i);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_snprintf_log_line);
+
+static void BM_stdio_snprintf_width(int iters) {
+  char buf[128];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    snprintf(buf, sizeof(buf), "%8d %-16s %016llx\n", i, "a log message", 0x7f00deadbeefULL + i);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_snprintf_width);
+
+static void BM_stdio_snprintf_double(int iters) {
+  char buf[128];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    snprintf(buf, sizeof(buf), "%f %g %.17g", 1.0 + i * 0.001, 3.14159 * i, 0.1 * i);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_snprintf_double);
+
+static void BM_stdio_fprintf_log_line(int iters) {
+  StopBenchmarkTiming();
+  FILE* fp = fopen("/dev/null", "w");
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fprintf(fp, "%d %s %llx\n", i, "a log message", 0x7f00deadbeefULL + i);
+  }
+
+  StopBenchmarkTiming();
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fprintf_log_line);
+
+static void BM_stdio_fflush_NULL_after_churn(int iters) {
+  StopBenchmarkTiming();
+  // Leave a long trail of glue behind, as a process that has opened and
+  // closed many files over its lifetime would.
+  FILE* fps[1000];
+  for (int i = 0; i < 1000; ++i) {
+    fps[i] = fopen("/dev/null", "w");
+  }
+  for (int i = 0; i < 1000; ++i) {
+    fclose(fps[i]);
+  }
+  FILE* fp = fopen("/dev/null", "w");
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fputc('x', fp);
+    fflush(NULL);
+  }
+
+  StopBenchmarkTiming();
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fflush_NULL_after_churn);
+
+static void FgetsFile(int iters, const char* mode) {
+  StopBenchmarkTiming();
+  FILE* fp = tmpfile();
+  int64_t file_size = 0;
+  for (int i = 0; file_size < FILE_BENCHMARK_SIZE; ++i) {
+    file_size += fprintf(fp, "%d: %s\n", i, "a line of text to be read back");
+  }
+  fflush(fp);
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "/proc/self/fd/%d", fileno(fp));
+  char line[128];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    FILE* in = fopen(path, mode);
+    while (fgets(line, sizeof(line), in) != NULL) {
+    }
+    fclose(in);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * file_size);
+  fclose(fp);
+}
+
+static void BM_stdio_fgets_file(int iters) {
+  FgetsFile(iters, "re");
+}
+BENCHMARK(BM_stdio_fgets_file);
+
+static void BM_stdio_fgets_file_mmap(int iters) {
+  FgetsFile(iters, "rem");
+}
+BENCHMARK(BM_stdio_fgets_file_mmap);
+
+static void BM_stdio_open_memstream_fprintf(int iters) {
+  StopBenchmarkTiming();
+  char* buf;
+  size_t size;
+  FILE* fp = open_memstream(&buf, &size);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fprintf(fp, "%d: %s\n", i, "a line of formatted output");
+    if (i % 10000 == 9999) {
+      rewind(fp);
+    }
+  }
+  fflush(fp);
+
+  StopBenchmarkTiming();
+  fclose(fp);
+  free(buf);
+}
+BENCHMARK(BM_stdio_open_memstream_fprintf);
+
+static void BM_stdio_tmpfile(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    FILE* fp = tmpfile();
+    fputc('x', fp);
+    fclose(fp);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_tmpfile);
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <limits.h>
+#include <search.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char* kDoubles[] = {
+  "3.14159", "0.001234", "123456.789", "2.718281828459045", "-42.5e-7", "1.7976931348623157e308",
+};
+
+static void BM_stdlib_strtod(int iters) {
+  StartBenchmarkTiming();
+
+  volatile double sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += strtod(kDoubles[i % 6], NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtod);
+
+static void BM_stdlib_strtof(int iters) {
+  StartBenchmarkTiming();
+
+  volatile float sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += strtof(kDoubles[i % 5], NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtof);
+
+static const char* kIntegers[] = {
+  "7", "42", "-1234", "65535", "12345678", "-2147483648", "1234567890123", "9223372036854775807",
+};
+
+static void BM_stdlib_strtol(int iters) {
+  StartBenchmarkTiming();
+
+  volatile long sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += strtol(kIntegers[i % 6], NULL, 10);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtol);
+
+static void BM_stdlib_strtoll(int iters) {
+  StartBenchmarkTiming();
+
+  volatile long long sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += strtoll(kIntegers[i % 8], NULL, 10);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtoll);
+
+static void BM_stdlib_atoi(int iters) {
+  StartBenchmarkTiming();
+
+  volatile int sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += atoi(kIntegers[i % 6]);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_atoi);
+
+static int qsort_int_compare(const void* lhs, const void* rhs) {
+  int l = *reinterpret_cast<const int*>(lhs);
+  int r = *reinterpret_cast<const int*>(rhs);
+  return (l < r) ? -1 : (l > r);
+}
+
+static void BM_stdlib_qsort(int iters, int n) {
+  StopBenchmarkTiming();
+  int* values = new int[n];
+  int* a = new int[n];
+  srandom(1);
+  for (int i = 0; i < n; ++i) {
+    values[i] = random();
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    memcpy(a, values, n * sizeof(int));
+    StartBenchmarkTiming();
+    qsort(a, n, sizeof(int), qsort_int_compare);
+    StopBenchmarkTiming();
+  }
+
+  delete[] values;
+  delete[] a;
+}
+BENCHMARK(BM_stdlib_qsort)->Arg(16)->Arg(1024)->Arg(1024*1024)->Arg(10*1024*1024);
+
+static void BM_stdlib_getenv(int iters) {
+  StopBenchmarkTiming();
+
+  // A large environment, as some processes have.
+  char name[32];
+  for (int i = 0; i < 200; ++i) {
+    snprintf(name, sizeof(name), "BM_STDLIB_GETENV_%d", i);
+    setenv(name, "value", 1);
+  }
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    getenv("BM_STDLIB_GETENV_NONE");
+  }
+  StopBenchmarkTiming();
+
+  for (int i = 0; i < 200; ++i) {
+    snprintf(name, sizeof(name), "BM_STDLIB_GETENV_%d", i);
+    unsetenv(name);
+  }
+}
+BENCHMARK(BM_stdlib_getenv);
+
+extern "C" int __cxa_atexit(void (*)(void*), void*, void*);
+extern "C" void __cxa_finalize(void*);
+
+static void nop_handler(void*) {
+}
+
+static void BM_stdlib_cxa_finalize(int iters) {
+  StopBenchmarkTiming();
+
+  // Handlers from lots of other libraries, as in a plugin host.
+  const int kOtherCount = 1000;
+  static char others[kOtherCount][sizeof(void*)];
+  for (int i = 0; i < kOtherCount; ++i) {
+    __cxa_atexit(nop_handler, NULL, others[i]);
+  }
+
+  static char handle[sizeof(void*)];
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      __cxa_atexit(nop_handler, NULL, handle);
+    }
+    StartBenchmarkTiming();
+    __cxa_finalize(handle);
+    StopBenchmarkTiming();
+  }
+
+  for (int i = 0; i < kOtherCount; ++i) {
+    __cxa_finalize(others[i]);
+  }
+}
+BENCHMARK(BM_stdlib_cxa_finalize);
+
+static void BM_stdlib_mb_cur_max(int iters) {
+  StartBenchmarkTiming();
+
+  volatile size_t sum = 0;
+  for (int i = 0; i < iters; ++i) {
+    sum += MB_CUR_MAX;
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_mb_cur_max);
+
+static void BM_stdlib_tsearch_sorted(int iters, int n) {
+  StopBenchmarkTiming();
+  int* keys = new int[n];
+  for (int i = 0; i < n; ++i) {
+    keys[i] = i;
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    void* root = NULL;
+    StartBenchmarkTiming();
+    // Keys in order, as most callers insert them.
+    for (int j = 0; j < n; ++j) {
+      tsearch(&keys[j], &root, qsort_int_compare);
+    }
+    for (int j = 0; j < n; ++j) {
+      tfind(&keys[j], &root, qsort_int_compare);
+    }
+    StopBenchmarkTiming();
+    tdestroy(root, nop_handler);
+  }
+
+  delete[] keys;
+}
+BENCHMARK(BM_stdlib_tsearch_sorted)->Arg(16)->Arg(1024)->Arg(16*1024);
+
+static void BM_stdlib_hsearch(int iters, int n) {
+  StopBenchmarkTiming();
+  char (*keys)[16] = new char[n][16];
+  for (int i = 0; i < n; ++i) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    hsearch_data htab;
+    memset(&htab, 0, sizeof(htab));
+    StartBenchmarkTiming();
+    // Far fewer entries than end up in the table.
+    hcreate_r(16, &htab);
+    ENTRY e;
+    ENTRY* result;
+    for (int j = 0; j < n; ++j) {
+      e.key = keys[j];
+      e.data = NULL;
+      hsearch_r(e, ENTER, &result, &htab);
+    }
+    for (int j = 0; j < n; ++j) {
+      e.key = keys[j];
+      hsearch_r(e, FIND, &result, &htab);
+    }
+    StopBenchmarkTiming();
+    hdestroy_r(&htab);
+  }
+
+  delete[] keys;
+}
+BENCHMARK(BM_stdlib_hsearch)->Arg(16)->Arg(1024)->Arg(16*1024);
+
+// Build tools resolve paths like this by the million.
+static void BM_stdlib_realpath(int iters) {
+  StopBenchmarkTiming();
+  char cwd[PATH_MAX];
+  getcwd(cwd, sizeof(cwd));
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/./../%s", cwd, strrchr(cwd, '/') + 1);
+  char resolved[PATH_MAX];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    realpath(path, resolved);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_realpath);
@@ -17,6 +17,8 @@
 #include "benchmark.h"
 
 #include <string.h>
+#include <strings.h>
+#include <wchar.h>
 
 #define KB 1024
 #define MB 1024*KB
@@ -24,6 +26,11 @@
 #define AT_COMMON_SIZES \
     Arg(8)->Arg(64)->Arg(512)->Arg(1*KB)->Arg(8*KB)->Arg(16*KB)->Arg(32*KB)->Arg(64*KB)
 
+// Bigger than most last level caches, where memcpy and memset switch to
+// non-temporal stores.
+#define AT_LARGE_SIZES \
+    Arg(1*MB)->Arg(8*MB)->Arg(64*MB)
+
 // TODO: test unaligned operation too? (currently everything will be 8-byte aligned by malloc.)
 
 static void BM_string_memcmp(int iters, int nbytes) {
@@ -60,7 +67,7 @@ static void BM_string_memcpy(int iters, int nbytes) {
   delete[] src;
   delete[] dst;
 }
-BENCHMARK(BM_string_memcpy)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memcpy)->AT_COMMON_SIZES->AT_LARGE_SIZES;
 
 static void BM_string_memmove(int iters, int nbytes) {
   StopBenchmarkTiming();
@@ -91,7 +98,7 @@ static void BM_string_memset(int iters, int nbytes) {
   SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
   delete[] dst;
 }
-BENCHMARK(BM_string_memset)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memset)->AT_COMMON_SIZES->AT_LARGE_SIZES;
 
 static void BM_string_strlen(int iters, int nbytes) {
   StopBenchmarkTiming();
@@ -131,3 +138,346 @@ static void BM_string_strchr(int iters, int nbytes) {
   delete[] s;
 }
 BENCHMARK(BM_string_strchr)->AT_COMMON_SIZES;
+
+static void BM_string_memchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (memchr(s, 'y', nbytes) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_memchr)->AT_COMMON_SIZES;
+
+static void BM_string_strspn(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += strspn(s, " \t\r\nx");
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strspn)->AT_COMMON_SIZES;
+
+static void BM_string_strspn_unaligned(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* buf = new char[nbytes + 1];
+  char* s = buf + 1;
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += strspn(s, " \t\r\nx");
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] buf;
+}
+BENCHMARK(BM_string_strspn_unaligned)->AT_COMMON_SIZES;
+
+static void BM_string_strcspn(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += strcspn(s, " \t\r\n,;");
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strcspn)->AT_COMMON_SIZES;
+
+static void BM_string_strpbrk(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (strpbrk(s, "0123456789") != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strpbrk)->AT_COMMON_SIZES;
+
+static void BM_string_memrchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* buf = new char[nbytes + 1];
+  char* s = buf + 1;
+  memset(s, 'x', nbytes);
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (memrchr(s, 'y', nbytes) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] buf;
+}
+BENCHMARK(BM_string_memrchr)->AT_COMMON_SIZES;
+
+static void BM_string_strstr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (strstr(s, "needle") != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strstr)->AT_COMMON_SIZES;
+
+// A repetitive haystack and a needle that almost matches everywhere: the
+// worst case for a naive search.
+static void BM_string_strstr_repetitive(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'a', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (strstr(s, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab") != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strstr_repetitive)->AT_COMMON_SIZES;
+
+static void BM_string_memmem_repetitive(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'a', nbytes);
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (memmem(s, nbytes, "aaaaaaab", 8) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_memmem_repetitive)->AT_COMMON_SIZES;
+
+static void BM_string_strcasestr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (strcasestr(s, "Needle") != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strcasestr)->AT_COMMON_SIZES;
+
+static void BM_string_wcslen(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  size_t n = nbytes / sizeof(wchar_t);
+  wchar_t* s = new wchar_t[n + 1];
+  wmemset(s, L'x', n);
+  s[n] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += wcslen(s);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_wcslen)->AT_COMMON_SIZES;
+
+static void BM_string_wcschr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  size_t n = nbytes / sizeof(wchar_t);
+  wchar_t* s = new wchar_t[n + 1];
+  wmemset(s, L'x', n);
+  s[n] = 0;
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (wcschr(s, L'y') != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_wcschr)->AT_COMMON_SIZES;
+
+static void BM_string_wcscmp(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  size_t n = nbytes / sizeof(wchar_t);
+  wchar_t* s1 = new wchar_t[n + 1];
+  wchar_t* s2 = new wchar_t[n + 1];
+  wmemset(s1, L'x', n);
+  wmemset(s2, L'x', n);
+  s1[n] = s2[n] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += wcscmp(s1, s2);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s1;
+  delete[] s2;
+}
+BENCHMARK(BM_string_wcscmp)->AT_COMMON_SIZES;
+
+static void BM_string_wmemchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  size_t n = nbytes / sizeof(wchar_t);
+  wchar_t* s = new wchar_t[n];
+  wmemset(s, L'x', n);
+  StartBenchmarkTiming();
+
+  volatile int d __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    d += (wmemchr(s, L'y', n) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_wmemchr)->AT_COMMON_SIZES;
+
+static void BM_string_mbsrtowcs(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  wchar_t* dst = new wchar_t[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    const char* src = s;
+    mbstate_t ps = {};
+    mbsrtowcs(dst, &src, nbytes, &ps);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+  delete[] dst;
+}
+BENCHMARK(BM_string_mbsrtowcs)->AT_COMMON_SIZES;
+
+static void BM_string_wcsrtombs(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  wchar_t* s = new wchar_t[nbytes];
+  char* dst = new char[nbytes];
+  wmemset(s, L'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    const wchar_t* src = s;
+    mbstate_t ps = {};
+    wcsrtombs(dst, &src, nbytes, &ps);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+  delete[] dst;
+}
+BENCHMARK(BM_string_wcsrtombs)->AT_COMMON_SIZES;
+
+static void BM_string_strcasecmp(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s1 = new char[nbytes];
+  char* s2 = new char[nbytes];
+  memset(s1, 'x', nbytes - 1);
+  memset(s2, 'X', nbytes - 1);
+  s1[nbytes - 1] = s2[nbytes - 1] = '\0';
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strcasecmp(s1, s2);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s1;
+  delete[] s2;
+}
+BENCHMARK(BM_string_strcasecmp)->AT_COMMON_SIZES;
+
+// Looking a header up by name: short keys that mostly differ early.
+static void BM_string_strcasecmp_headers(int iters) {
+  static const char* const kHeaders[] = {
+    "Host", "User-Agent", "Accept", "Accept-Encoding", "Accept-Language",
+    "Connection", "Cache-Control", "Cookie", "Content-Type", "Content-Length",
+  };
+  const size_t kCount = sizeof(kHeaders) / sizeof(kHeaders[0]);
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    for (size_t j = 0; j < kCount; ++j) {
+      c += strcasecmp(kHeaders[j], "content-length");
+      c += strncasecmp(kHeaders[j], "ACCEPT-", 7);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_string_strcasecmp_headers);
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+// Every mem*/str* routine with an optimized implementation, over a matrix of
+// source/destination alignments, lengths and working-set sizes. Names are
+//   BM_string_matrix/<function>/<alignment>/<lengths>/<working set>
+// so a regular expression can pick out a row or a column, for example
+//   bionic-benchmarks 'matrix/memcpy/.*/trace'
+//
+// Each call works on a different part of a buffer the size of the working
+// set, so 16K stays in L1, 256K in L2 and 64M comes from DRAM. Every buffer
+// holds the same bytes in the same places: runs of 'x' each followed by a
+// NUL, which no routine below changes.
+
+#define KB 1024
+#define MB 1024*KB
+
+#define AT_WORKING_SETS \
+    Arg(16*KB)->Arg(256*KB)->Arg(64*MB)
+
+typedef uintptr_t (*StringOp)(char* dst, const char* src, size_t n);
+
+enum Buffers { kSrc, kDst, kBoth };
+
+// The other matrix benchmark has types of the same names, so keep these to
+// ourselves: in one binary they'd otherwise silently share a std::vector<Config>.
+namespace {
+
+struct Function {
+  const char* name;
+  StringOp op;
+  Buffers buffers;
+};
+
+}  // namespace
+
+static uintptr_t Memcpy(char* dst, const char* src, size_t n) {
+  return reinterpret_cast<uintptr_t>(memcpy(dst, src, n));
+}
+static uintptr_t Memmove(char* dst, const char* src, size_t n) {
+  return reinterpret_cast<uintptr_t>(memmove(dst, src, n));
+}
+static uintptr_t Memset(char* dst, const char*, size_t n) {
+  return reinterpret_cast<uintptr_t>(memset(dst, 'x', n));
+}
+static uintptr_t Memcmp(char* dst, const char* src, size_t n) {
+  return memcmp(dst, src, n);
+}
+static uintptr_t Memchr(char*, const char* src, size_t n) {
+  return reinterpret_cast<uintptr_t>(memchr(src, 'y', n));
+}
+static uintptr_t Memrchr(char*, const char* src, size_t n) {
+  return reinterpret_cast<uintptr_t>(memrchr(src, 'y', n));
+}
+static uintptr_t Strlen(char*, const char* src, size_t) {
+  return strlen(src);
+}
+static uintptr_t Strnlen(char*, const char* src, size_t n) {
+  return strnlen(src, n + 1);
+}
+static uintptr_t Strchr(char*, const char* src, size_t) {
+  return reinterpret_cast<uintptr_t>(strchr(src, 'y'));
+}
+static uintptr_t Strrchr(char*, const char* src, size_t) {
+  return reinterpret_cast<uintptr_t>(strrchr(src, 'y'));
+}
+static uintptr_t Strcmp(char* dst, const char* src, size_t) {
+  return strcmp(dst, src);
+}
+static uintptr_t Strncmp(char* dst, const char* src, size_t n) {
+  return strncmp(dst, src, n + 1);
+}
+static uintptr_t Strcpy(char* dst, const char* src, size_t) {
+  return reinterpret_cast<uintptr_t>(strcpy(dst, src));
+}
+static uintptr_t Stpcpy(char* dst, const char* src, size_t) {
+  return reinterpret_cast<uintptr_t>(stpcpy(dst, src));
+}
+static uintptr_t Strncpy(char* dst, const char* src, size_t n) {
+  return reinterpret_cast<uintptr_t>(strncpy(dst, src, n));
+}
+
+static const Function kFunctions[] = {
+  { "memcpy", Memcpy, kBoth },
+  { "memmove", Memmove, kBoth },
+  { "memset", Memset, kDst },
+  { "memcmp", Memcmp, kBoth },
+  { "memchr", Memchr, kSrc },
+  { "memrchr", Memrchr, kSrc },
+  { "strlen", Strlen, kSrc },
+  { "strnlen", Strnlen, kSrc },
+  { "strchr", Strchr, kSrc },
+  { "strrchr", Strrchr, kSrc },
+  { "strcmp", Strcmp, kBoth },
+  { "strncmp", Strncmp, kBoth },
+  { "strcpy", Strcpy, kBoth },
+  { "stpcpy", Stpcpy, kBoth },
+  { "strncpy", Strncpy, kBoth },
+};
+
+// Offsets from a 64-byte boundary. A routine that only looks at one buffer
+// runs with each distinct offset for that buffer.
+static const struct {
+  int src;
+  int dst;
+} kAlignments[] = {
+  { 0, 0 },
+  { 1, 1 },
+  { 0, 7 },
+  { 13, 0 },
+};
+
+// A length of 0 means lengths drawn from kTraceLengths.
+static const size_t kLengths[] = { 0, 8, 64, 512, 4*KB };
+
+// The lengths of string calls in application traces: most are shorter than
+// 64 bytes, but the long tail carries a good share of the bytes. Each bucket
+// is [previous limit + 1, limit], weighted in percent.
+static const struct {
+  size_t limit;
+  int percent;
+} kTraceLengths[] = {
+  { 8, 28 },
+  { 16, 22 },
+  { 32, 20 },
+  { 64, 15 },
+  { 128, 7 },
+  { 256, 4 },
+  { 1*KB, 3 },
+  { 4*KB, 1 },
+};
+
+namespace {
+
+struct Config {
+  const Function* function;
+  int src_align;
+  int dst_align;
+  size_t length;
+  char name[64];
+};
+
+}  // namespace
+
+static std::vector<Config> g_configs;
+
+static void BuildConfigs() {
+  for (size_t f = 0; f < sizeof(kFunctions)/sizeof(kFunctions[0]); ++f) {
+    const Function& function = kFunctions[f];
+    for (size_t a = 0; a < sizeof(kAlignments)/sizeof(kAlignments[0]); ++a) {
+      int src_align = kAlignments[a].src;
+      int dst_align = kAlignments[a].dst;
+      char align_name[16];
+      if (function.buffers == kBoth) {
+        snprintf(align_name, sizeof(align_name), "s%dd%d", src_align, dst_align);
+      } else {
+        // Skip offsets we've already done for the one buffer that matters.
+        bool seen = false;
+        for (size_t b = 0; b < a; ++b) {
+          if (function.buffers == kSrc ? kAlignments[b].src == src_align
+                                       : kAlignments[b].dst == dst_align) {
+            seen = true;
+          }
+        }
+        if (seen) {
+          continue;
+        }
+        if (function.buffers == kSrc) {
+          snprintf(align_name, sizeof(align_name), "s%d", src_align);
+        } else {
+          snprintf(align_name, sizeof(align_name), "d%d", dst_align);
+        }
+      }
+      for (size_t l = 0; l < sizeof(kLengths)/sizeof(kLengths[0]); ++l) {
+        Config config;
+        config.function = &function;
+        config.src_align = src_align;
+        config.dst_align = dst_align;
+        config.length = kLengths[l];
+        if (kLengths[l] == 0) {
+          snprintf(config.name, sizeof(config.name), "BM_string_matrix/%s/%s/trace",
+                   function.name, align_name);
+        } else {
+          snprintf(config.name, sizeof(config.name), "BM_string_matrix/%s/%s/%zu",
+                   function.name, align_name, kLengths[l]);
+        }
+        g_configs.push_back(config);
+      }
+    }
+  }
+}
+
+// A small fixed-seed generator, so every run sees the same lengths.
+static uint32_t NextRandom(uint32_t* state) {
+  *state = *state * 1103515245 + 12345;
+  return *state >> 16;
+}
+
+static size_t TraceLength(uint32_t* state) {
+  int r = NextRandom(state) % 100;
+  size_t low = 1;
+  for (size_t i = 0; i < sizeof(kTraceLengths)/sizeof(kTraceLengths[0]); ++i) {
+    if (r < kTraceLengths[i].percent) {
+      return low + NextRandom(state) % (kTraceLengths[i].limit - low + 1);
+    }
+    r -= kTraceLengths[i].percent;
+    low = kTraceLengths[i].limit + 1;
+  }
+  return low - 1;
+}
+
+struct Call {
+  uint32_t offset;
+  uint32_t length;
+};
+
+static void RunMatrix(const Config& config, int iters, int working_set) {
+  StopBenchmarkTiming();
+  // Half the working set for each buffer, whether or not the routine uses both.
+  size_t buffer_size = working_set / 2;
+  char* src_buffer = reinterpret_cast<char*>(memalign(64, buffer_size));
+  char* dst_buffer = reinterpret_cast<char*>(memalign(64, buffer_size));
+  memset(src_buffer, 'x', buffer_size);
+  memset(dst_buffer, 'x', buffer_size);
+
+  // Lay the calls out one after another, each starting on a new cache line.
+  std::vector<Call> calls;
+  uint32_t random = 1;
+  size_t align = (config.src_align > config.dst_align) ? config.src_align : config.dst_align;
+  for (size_t offset = 0; ; ) {
+    size_t length = (config.length != 0) ? config.length : TraceLength(&random);
+    size_t end = offset + align + length + 1;
+    if (end > buffer_size) {
+      break;
+    }
+    src_buffer[offset + config.src_align + length] = '\0';
+    dst_buffer[offset + config.dst_align + length] = '\0';
+    Call call = { static_cast<uint32_t>(offset), static_cast<uint32_t>(length) };
+    calls.push_back(call);
+    offset = (end + 63) & ~63;
+  }
+  if (calls.empty()) {
+    fprintf(stderr, "%s: a %d byte working set is too small\n", config.name, working_set);
+    exit(EXIT_FAILURE);
+  }
+
+  StringOp op = config.function->op;
+  const Call* call = &calls[0];
+  const Call* calls_end = call + calls.size();
+  int64_t bytes = 0;
+  volatile uintptr_t sink __attribute__((unused)) = 0;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    sink += op(dst_buffer + call->offset + config.dst_align,
+               src_buffer + call->offset + config.src_align, call->length);
+    bytes += call->length;
+    if (++call == calls_end) {
+      call = &calls[0];
+    }
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(bytes);
+  free(src_buffer);
+  free(dst_buffer);
+}
+
+// The benchmark harness only hands us (iterations, arg), so each row of the
+// matrix gets its own instantiation that knows its index in g_configs.
+static const size_t kMaxConfigs = 320;
+
+template <size_t kIndex>
+static void BM_string_matrix(int iters, int working_set) {
+  RunMatrix(g_configs[kIndex], iters, working_set);
+}
+
+template <size_t kCount>
+struct Registrar {
+  static void Register() {
+    Registrar<kCount - 1>::Register();
+    if (kCount - 1 < g_configs.size()) {
+      (new ::testing::Benchmark(g_configs[kCount - 1].name,
+                                BM_string_matrix<kCount - 1>))->AT_WORKING_SETS;
+    }
+  }
+};
+
+template <>
+struct Registrar<0> {
+  static void Register() {}
+};
+
+static bool RegisterMatrix() {
+  BuildConfigs();
+  if (g_configs.size() > kMaxConfigs) {
+    fprintf(stderr, "BM_string_matrix: %zu configurations, but only room for %zu\n",
+            g_configs.size(), kMaxConfigs);
+    exit(EXIT_FAILURE);
+  }
+  Registrar<kMaxConfigs>::Register();
+  return true;
+}
+
+static bool g_matrix_registered __attribute__((unused)) = RegisterMatrix();
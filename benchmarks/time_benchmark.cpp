@@ -16,8 +16,15 @@
 
 #include "benchmark.h"
 
+#include <string.h>
 #include <sys/syscall.h>
+#include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
+
+#if defined(__BIONIC__)
+#include <android/fast_clock.h>
+#endif
 
 static void BM_time_clock_gettime(int iters) {
   StartBenchmarkTiming();
@@ -43,6 +50,53 @@ static void BM_time_clock_gettime_syscall(int iters) {
 }
 BENCHMARK(BM_time_clock_gettime_syscall);
 
+static void BM_time_clock_gettime_coarse(int iters) {
+  StartBenchmarkTiming();
+
+  timespec t;
+  for (int i = 0; i < iters; ++i) {
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &t);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_clock_gettime_coarse);
+
+#if defined(__BIONIC__)
+static void BM_time_android_coarse_monotonic_ns(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_coarse_monotonic_ns();
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_android_coarse_monotonic_ns);
+
+static void BM_time_android_fast_clock_ticks(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_fast_clock_ticks();
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_android_fast_clock_ticks);
+
+static void BM_time_android_fast_clock_ns(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_fast_clock_ns();
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_android_fast_clock_ns);
+#endif
+
 static void BM_time_gettimeofday(int iters) {
   StartBenchmarkTiming();
 
@@ -77,3 +131,77 @@ static void BM_time_time(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_time_time);
+
+static void BM_time_localtime_r(int iters) {
+  StartBenchmarkTiming();
+
+  time_t t = time(NULL);
+  tm broken_down;
+  for (int i = 0; i < iters; ++i) {
+    localtime_r(&t, &broken_down);
+    ++t;
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_localtime_r);
+
+static void BM_time_strftime_iso8601(int iters) {
+  StartBenchmarkTiming();
+
+  time_t t = 1388534400; // 2014-01-01T00:00:00Z.
+  tm broken_down;
+  gmtime_r(&t, &broken_down);
+  char buf[32];
+  for (int i = 0; i < iters; ++i) {
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &broken_down);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_strftime_iso8601);
+
+static void BM_time_strftime_syslog(int iters) {
+  StartBenchmarkTiming();
+
+  time_t t = 1388534400; // 2014-01-01T00:00:00Z.
+  tm broken_down;
+  gmtime_r(&t, &broken_down);
+  char buf[32];
+  for (int i = 0; i < iters; ++i) {
+    strftime(buf, sizeof(buf), "%b %e %H:%M:%S", &broken_down);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_strftime_syslog);
+
+static void BM_time_strptime_iso8601(int iters) {
+  StartBenchmarkTiming();
+
+  tm broken_down;
+  for (int i = 0; i < iters; ++i) {
+    strptime("2014-01-01T12:34:56", "%Y-%m-%dT%H:%M:%S", &broken_down);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_strptime_iso8601);
+
+static void BM_time_mktime(int iters) {
+  StartBenchmarkTiming();
+
+  tm broken_down;
+  memset(&broken_down, 0, sizeof(broken_down));
+  broken_down.tm_year = 114;
+  for (int i = 0; i < iters; ++i) {
+    broken_down.tm_mon = i % 12;
+    broken_down.tm_mday = 1 + i % 28;
+    broken_down.tm_hour = 12;
+    broken_down.tm_isdst = -1;
+    mktime(&broken_down);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_mktime);
@@ -16,6 +16,10 @@
 
 #include "benchmark.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/auxv.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
@@ -65,3 +69,94 @@ static void BM_unistd_gettid_syscall(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_unistd_gettid_syscall);
+
+// Stop GCC hoisting the pure __errno call out of the loop.
+static void __attribute__((noinline)) set_errno(int value) {
+  errno = value;
+}
+
+static void BM_unistd_errno(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    set_errno(i);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_errno);
+
+// Defined in pthread_benchmark.cpp.
+extern pthread_t (*pthread_self_fp)();
+
+// The per-thread state that much of libc touches, which all lives in the first
+// cache line of the TLS array.
+static void BM_unistd_thread_state(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_self_fp();
+    getpid();
+    gettid_fp();
+    set_errno(i);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_thread_state);
+
+static void BM_unistd_sched_getcpu(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    sched_getcpu();
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_sched_getcpu);
+
+static void BM_unistd_getcpu_syscall(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    unsigned cpu;
+    syscall(__NR_getcpu, &cpu, NULL, NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_getcpu_syscall);
+
+static void BM_unistd_getauxval(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    getauxval(AT_HWCAP);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_getauxval);
+
+static void BM_unistd_sysconf_nprocessors_onln(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_sysconf_nprocessors_onln);
+
+static void BM_unistd_sysconf_phys_pages(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    sysconf(_SC_PHYS_PAGES);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_unistd_sysconf_phys_pages);
@@ -22,9 +22,11 @@ endif
 # crt obj files
 # ========================================================
 # crtbrand.c needs <stdint.h> and a #define for the platform SDK version.
+# crtbegin must be position-independent for static-PIE executables to use it.
 libc_crt_target_cflags := \
     -I$(LOCAL_PATH)/include \
     -DPLATFORM_SDK_VERSION=$(PLATFORM_SDK_VERSION) \
+    -fPIE \
 
 my_2nd_arch_prefix :=
 include $(LOCAL_PATH)/crt.mk
@@ -50,7 +52,6 @@ libc_common_src_files := \
     bionic/initgroups.c \
     bionic/ioctl.c \
     bionic/isatty.c \
-    bionic/memmem.c \
     bionic/pathconf.c \
     bionic/pututline.c \
     bionic/sched_cpualloc.c \
@@ -60,10 +61,25 @@ libc_common_src_files := \
     bionic/siginterrupt.c \
     bionic/sigsetmask.c \
     bionic/system_properties_compat.c \
+    stdio/fclose.c \
+    stdio/fflush.c \
+    stdio/fgets.c \
     stdio/findfp.c \
+    stdio/flags.c \
+    stdio/fmemopen.c \
+    stdio/fmmap.c \
+    stdio/fopen.c \
     stdio/fread.c \
+    stdio/fvwrite.c \
+    stdio/fwrite.c \
+    stdio/makebuf.c \
+    stdio/open_memstream.c \
+    stdio/open_wmemstream.c \
+    stdio/refill.c \
     stdio/snprintf.c\
     stdio/sprintf.c \
+    stdio/vfprintf_fast.c \
+    stdio/wsetup.c \
 
 ifeq ($(TARGET_NEEDS_BIONIC_MD5),true)
 libc_common_src_files += bionic/md5.c
@@ -94,7 +110,10 @@ libc_bionic_src_files := \
     bionic/accept.cpp \
     bionic/accept4.cpp \
     bionic/access.cpp \
+    bionic/arc4random.c \
     bionic/assert.cpp \
+    bionic/async_io.cpp \
+    bionic/atexit.cpp \
     bionic/atof.cpp \
     bionic/bionic_time_conversions.cpp \
     bionic/brk.cpp \
@@ -107,15 +126,19 @@ libc_bionic_src_files := \
     bionic/clone.cpp \
     bionic/__cmsg_nxthdr.cpp \
     bionic/connect.cpp \
+    bionic/copy_fd_range.cpp \
+    bionic/cpu_features.cpp \
     bionic/ctype.cpp \
     bionic/dirent.cpp \
     bionic/dup2.cpp \
+    bionic/elf_tls.cpp \
     bionic/epoll_create.cpp \
     bionic/epoll_pwait.cpp \
     bionic/epoll_wait.cpp \
     bionic/__errno.cpp \
     bionic/eventfd_read.cpp \
     bionic/eventfd_write.cpp \
+    bionic/fast_clock.cpp \
     bionic/ffs.cpp \
     bionic/flockfile.cpp \
     bionic/fork.cpp \
@@ -124,9 +147,11 @@ libc_bionic_src_files := \
     bionic/getauxval.cpp \
     bionic/getcwd.cpp \
     bionic/getentropy_linux.c \
+    bionic/getenv.cpp \
     bionic/getpgrp.cpp \
     bionic/getpid.cpp \
     bionic/gettid.cpp \
+    bionic/hsearch.cpp \
     bionic/inotify_init.cpp \
     bionic/lchown.cpp \
     bionic/lfs64_support.cpp \
@@ -138,23 +163,31 @@ libc_bionic_src_files := \
     bionic/link.cpp \
     bionic/locale.cpp \
     bionic/lstat.cpp \
+    bionic/malloc_huge.cpp \
     bionic/mbrtoc16.cpp \
     bionic/mbrtoc32.cpp \
     bionic/mbstate.cpp \
+    bionic/memmem.cpp \
     bionic/mkdir.cpp \
     bionic/mkfifo.cpp \
     bionic/mknod.cpp \
+    bionic/mmsg_arena.cpp \
     bionic/mntent.cpp \
     bionic/NetdClientDispatch.cpp \
     bionic/open.cpp \
+    bionic/parallel.cpp \
     bionic/pause.cpp \
+    bionic/percpu.cpp \
     bionic/pipe.cpp \
     bionic/poll.cpp \
+    bionic/popen.cpp \
     bionic/posix_fadvise.cpp \
     bionic/posix_fallocate.cpp \
     bionic/posix_timers.cpp \
+    bionic/preadv_pwritev.cpp \
     bionic/pthread_atfork.cpp \
     bionic/pthread_attr.cpp \
+    bionic/pthread_barrier.cpp \
     bionic/pthread_cond.cpp \
     bionic/pthread_create.cpp \
     bionic/pthread_detach.cpp \
@@ -174,23 +207,31 @@ libc_bionic_src_files := \
     bionic/pthread_setname_np.cpp \
     bionic/pthread_setschedparam.cpp \
     bionic/pthread_sigmask.cpp \
+    bionic/pthread_spinlock.cpp \
     bionic/ptrace.cpp \
     bionic/pty.cpp \
+    bionic/qsort.cpp \
     bionic/raise.cpp \
     bionic/rand.cpp \
     bionic/readlink.cpp \
+    bionic/realpath.cpp \
     bionic/reboot.cpp \
     bionic/recv.cpp \
+    bionic/recvmmsg.cpp \
     bionic/rename.cpp \
     bionic/rmdir.cpp \
     bionic/scandir.cpp \
     bionic/sched_getaffinity.cpp \
     bionic/sched_getcpu.cpp \
+    bionic/sched_topology.cpp \
     bionic/send.cpp \
+    bionic/sendmmsg.cpp \
     bionic/setegid.cpp \
     bionic/__set_errno.cpp \
     bionic/seteuid.cpp \
     bionic/setpgrp.cpp \
+    bionic/sha.cpp \
+    bionic/shared_memory.cpp \
     bionic/sigaction.cpp \
     bionic/sigaddset.cpp \
     bionic/sigdelset.cpp \
@@ -204,13 +245,20 @@ libc_bionic_src_files := \
     bionic/sigsuspend.cpp \
     bionic/sigwait.cpp \
     bionic/socket.cpp \
+    bionic/spawn.cpp \
+    bionic/startup_trace.cpp \
     bionic/stat.cpp \
     bionic/statvfs.cpp \
+    bionic/stdio_ext.cpp \
+    bionic/strcasecmp_l.cpp \
+    bionic/strcasestr.cpp \
     bionic/strcoll_l.cpp \
     bionic/strerror.cpp \
     bionic/strerror_r.cpp \
     bionic/strftime_l.cpp \
     bionic/strsignal.cpp \
+    bionic/strstr.cpp \
+    bionic/strtol.cpp \
     bionic/strtold.cpp \
     bionic/strtold_l.cpp \
     bionic/strtoll_l.cpp \
@@ -222,17 +270,21 @@ libc_bionic_src_files := \
     bionic/syslog.cpp \
     bionic/sys_siglist.c \
     bionic/sys_signame.c \
+    bionic/system.cpp \
     bionic/system_properties.cpp \
     bionic/tdestroy.cpp \
     bionic/termios.cpp \
     bionic/thread_private.cpp \
     bionic/tmpfile.cpp \
+    bionic/tree_walk.cpp \
+    bionic/tsearch.cpp \
     bionic/umount.cpp \
     bionic/unlink.cpp \
     bionic/utimes.cpp \
     bionic/vdso.cpp \
     bionic/wait.cpp \
     bionic/wchar.cpp \
+    bionic/wcsstr.cpp \
     bionic/wctype.cpp \
 
 libc_cxa_src_files := \
@@ -244,16 +296,12 @@ libc_upstream_freebsd_src_files := \
     upstream-freebsd/lib/libc/gen/ldexp.c \
     upstream-freebsd/lib/libc/gen/sleep.c \
     upstream-freebsd/lib/libc/gen/usleep.c \
-    upstream-freebsd/lib/libc/stdio/fclose.c \
-    upstream-freebsd/lib/libc/stdio/flags.c \
-    upstream-freebsd/lib/libc/stdio/fopen.c \
     upstream-freebsd/lib/libc/stdlib/abs.c \
     upstream-freebsd/lib/libc/stdlib/getopt_long.c \
     upstream-freebsd/lib/libc/stdlib/imaxabs.c \
     upstream-freebsd/lib/libc/stdlib/imaxdiv.c \
     upstream-freebsd/lib/libc/stdlib/labs.c \
     upstream-freebsd/lib/libc/stdlib/llabs.c \
-    upstream-freebsd/lib/libc/stdlib/qsort.c \
     upstream-freebsd/lib/libc/stdlib/quick_exit.c \
     upstream-freebsd/lib/libc/stdlib/realpath.c \
     upstream-freebsd/lib/libc/string/wcpcpy.c \
@@ -264,22 +312,19 @@ libc_upstream_freebsd_src_files := \
     upstream-freebsd/lib/libc/string/wcslcat.c \
     upstream-freebsd/lib/libc/string/wcsncasecmp.c \
     upstream-freebsd/lib/libc/string/wcsncat.c \
-    upstream-freebsd/lib/libc/string/wcsncmp.c \
     upstream-freebsd/lib/libc/string/wcsncpy.c \
-    upstream-freebsd/lib/libc/string/wcsnlen.c \
     upstream-freebsd/lib/libc/string/wcspbrk.c \
     upstream-freebsd/lib/libc/string/wcsspn.c \
     upstream-freebsd/lib/libc/string/wcstok.c \
-    upstream-freebsd/lib/libc/string/wmemchr.c \
     upstream-freebsd/lib/libc/string/wmemcpy.c \
     upstream-freebsd/lib/libc/string/wmemset.c \
 
 libc_upstream_netbsd_src_files := \
+    upstream-netbsd/android/regex_dfa.c \
     upstream-netbsd/common/lib/libc/stdlib/random.c \
     upstream-netbsd/lib/libc/gen/ftw.c \
     upstream-netbsd/lib/libc/gen/nftw.c \
     upstream-netbsd/lib/libc/gen/nice.c \
-    upstream-netbsd/lib/libc/gen/popen.c \
     upstream-netbsd/lib/libc/gen/psignal.c \
     upstream-netbsd/lib/libc/gen/utime.c \
     upstream-netbsd/lib/libc/gen/utmp.c \
@@ -305,12 +350,12 @@ libc_upstream_netbsd_src_files := \
     upstream-netbsd/lib/libc/stdlib/seed48.c \
     upstream-netbsd/lib/libc/stdlib/srand48.c \
     upstream-netbsd/lib/libc/string/memccpy.c \
-    upstream-netbsd/lib/libc/string/strcasestr.c \
     upstream-netbsd/lib/libc/string/strcoll.c \
     upstream-netbsd/lib/libc/string/strxfrm.c \
     upstream-netbsd/lib/libc/unistd/killpg.c \
 
 libc_upstream_openbsd_gdtoa_src_files := \
+    upstream-openbsd/android/gdtoa_fast.c \
     upstream-openbsd/android/gdtoa_support.cpp \
     upstream-openbsd/lib/libc/gdtoa/dmisc.c \
     upstream-openbsd/lib/libc/gdtoa/dtoa.c \
@@ -338,7 +383,6 @@ libc_upstream_openbsd_gdtoa_src_files_64 := \
     upstream-openbsd/lib/libc/gdtoa/strtorQ.c \
 
 libc_upstream_openbsd_src_files := \
-    upstream-openbsd/lib/libc/crypt/arc4random.c \
     upstream-openbsd/lib/libc/crypt/arc4random_uniform.c \
     upstream-openbsd/lib/libc/gen/alarm.c \
     upstream-openbsd/lib/libc/gen/ctype_.c \
@@ -348,7 +392,6 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/gen/getprogname.c \
     upstream-openbsd/lib/libc/gen/isctype.c \
     upstream-openbsd/lib/libc/gen/setprogname.c \
-    upstream-openbsd/lib/libc/gen/time.c \
     upstream-openbsd/lib/libc/gen/tolower_.c \
     upstream-openbsd/lib/libc/gen/toupper_.c \
     upstream-openbsd/lib/libc/locale/btowc.c \
@@ -387,11 +430,9 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/stdio/fdopen.c \
     upstream-openbsd/lib/libc/stdio/feof.c \
     upstream-openbsd/lib/libc/stdio/ferror.c \
-    upstream-openbsd/lib/libc/stdio/fflush.c \
     upstream-openbsd/lib/libc/stdio/fgetc.c \
     upstream-openbsd/lib/libc/stdio/fgetln.c \
     upstream-openbsd/lib/libc/stdio/fgetpos.c \
-    upstream-openbsd/lib/libc/stdio/fgets.c \
     upstream-openbsd/lib/libc/stdio/fgetwc.c \
     upstream-openbsd/lib/libc/stdio/fgetws.c \
     upstream-openbsd/lib/libc/stdio/fileno.c \
@@ -407,11 +448,9 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/stdio/fsetpos.c \
     upstream-openbsd/lib/libc/stdio/ftell.c \
     upstream-openbsd/lib/libc/stdio/funopen.c \
-    upstream-openbsd/lib/libc/stdio/fvwrite.c \
     upstream-openbsd/lib/libc/stdio/fwalk.c \
     upstream-openbsd/lib/libc/stdio/fwide.c \
     upstream-openbsd/lib/libc/stdio/fwprintf.c \
-    upstream-openbsd/lib/libc/stdio/fwrite.c \
     upstream-openbsd/lib/libc/stdio/fwscanf.c \
     upstream-openbsd/lib/libc/stdio/getc.c \
     upstream-openbsd/lib/libc/stdio/getchar.c \
@@ -420,7 +459,6 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/stdio/gets.c \
     upstream-openbsd/lib/libc/stdio/getwc.c \
     upstream-openbsd/lib/libc/stdio/getwchar.c \
-    upstream-openbsd/lib/libc/stdio/makebuf.c \
     upstream-openbsd/lib/libc/stdio/mktemp.c \
     upstream-openbsd/lib/libc/stdio/perror.c \
     upstream-openbsd/lib/libc/stdio/printf.c \
@@ -429,7 +467,6 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/stdio/puts.c \
     upstream-openbsd/lib/libc/stdio/putwc.c \
     upstream-openbsd/lib/libc/stdio/putwchar.c \
-    upstream-openbsd/lib/libc/stdio/refill.c \
     upstream-openbsd/lib/libc/stdio/remove.c \
     upstream-openbsd/lib/libc/stdio/rewind.c \
     upstream-openbsd/lib/libc/stdio/rget.c \
@@ -463,35 +500,17 @@ libc_upstream_openbsd_src_files := \
     upstream-openbsd/lib/libc/stdio/wbuf.c \
     upstream-openbsd/lib/libc/stdio/wprintf.c \
     upstream-openbsd/lib/libc/stdio/wscanf.c \
-    upstream-openbsd/lib/libc/stdio/wsetup.c \
-    upstream-openbsd/lib/libc/stdlib/atexit.c \
     upstream-openbsd/lib/libc/stdlib/atoi.c \
     upstream-openbsd/lib/libc/stdlib/atol.c \
     upstream-openbsd/lib/libc/stdlib/atoll.c \
     upstream-openbsd/lib/libc/stdlib/exit.c \
-    upstream-openbsd/lib/libc/stdlib/getenv.c \
     upstream-openbsd/lib/libc/stdlib/lsearch.c \
     upstream-openbsd/lib/libc/stdlib/setenv.c \
-    upstream-openbsd/lib/libc/stdlib/strtoimax.c \
-    upstream-openbsd/lib/libc/stdlib/strtol.c \
-    upstream-openbsd/lib/libc/stdlib/strtoll.c \
-    upstream-openbsd/lib/libc/stdlib/strtoul.c \
-    upstream-openbsd/lib/libc/stdlib/strtoull.c \
-    upstream-openbsd/lib/libc/stdlib/strtoumax.c \
-    upstream-openbsd/lib/libc/stdlib/system.c \
-    upstream-openbsd/lib/libc/stdlib/tfind.c \
-    upstream-openbsd/lib/libc/stdlib/tsearch.c \
-    upstream-openbsd/lib/libc/string/strcasecmp.c \
-    upstream-openbsd/lib/libc/string/strcspn.c \
     upstream-openbsd/lib/libc/string/strdup.c \
     upstream-openbsd/lib/libc/string/strndup.c \
-    upstream-openbsd/lib/libc/string/strpbrk.c \
     upstream-openbsd/lib/libc/string/strsep.c \
-    upstream-openbsd/lib/libc/string/strspn.c \
-    upstream-openbsd/lib/libc/string/strstr.c \
     upstream-openbsd/lib/libc/string/strtok.c \
     upstream-openbsd/lib/libc/string/wcslcpy.c \
-    upstream-openbsd/lib/libc/string/wcsstr.c \
     upstream-openbsd/lib/libc/string/wcswidth.c \
 
 libc_arch_static_src_files := \
@@ -525,7 +544,10 @@ endif
 
 ifeq ($(MALLOC_IMPL),dlmalloc)
   libc_common_cflags += -DUSE_DLMALLOC
-  libc_malloc_src := bionic/dlmalloc.c
+  libc_malloc_src := \
+      bionic/dlmalloc.c \
+      bionic/malloc_thread_cache.cpp \
+
 else
   libc_common_cflags += -DUSE_JEMALLOC
   libc_malloc_src := bionic/jemalloc_wrapper.cpp
@@ -1058,9 +1080,11 @@ LOCAL_C_INCLUDES := $(libc_common_c_includes)
 LOCAL_SRC_FILES := \
     $(libc_arch_dynamic_src_files) \
     $(libc_static_common_src_files) \
+    bionic/execinfo.cpp \
     bionic/malloc_debug_common.cpp \
     bionic/libc_init_dynamic.cpp \
     bionic/NetdClient.cpp \
+    bionic/pthread_mutex_contention.cpp \
 
 LOCAL_MODULE := libc
 LOCAL_CLANG := $(use_clang)
@@ -1120,6 +1144,7 @@ include $(CLEAR_VARS)
 LOCAL_CFLAGS := \
     $(libc_common_cflags) \
     -DMALLOC_LEAK_CHECK \
+    -fno-omit-frame-pointer \
 
 LOCAL_CONLYFLAGS := $(libc_common_conlyflags)
 LOCAL_CPPFLAGS := $(libc_common_cppflags)
@@ -1129,17 +1154,18 @@ LOCAL_C_INCLUDES := \
     $(libc_common_c_includes) \
 
 LOCAL_SRC_FILES := \
-    bionic/debug_mapinfo.cpp \
     bionic/debug_stacktrace.cpp \
     bionic/libc_logging.cpp \
     bionic/malloc_debug_leak.cpp \
     bionic/malloc_debug_check.cpp \
+    bionic/malloc_debug_guard.cpp \
+    bionic/pthread_mutex_contention_debug.cpp \
 
 LOCAL_MODULE := libc_malloc_debug_leak
 LOCAL_CLANG := $(use_clang)
 LOCAL_ADDITIONAL_DEPENDENCIES := $(libc_common_additional_dependencies)
 
-LOCAL_SHARED_LIBRARIES := libc libdl
+LOCAL_SHARED_LIBRARIES := libc libdl libm
 LOCAL_SYSTEM_SHARED_LIBRARIES :=
 # Only need this for arm since libc++ uses its own unwind code that
 # doesn't mix with the other default unwind code.
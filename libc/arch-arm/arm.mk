@@ -39,12 +39,19 @@ libc_freebsd_src_files_arm += \
     upstream-freebsd/lib/libc/string/wcscmp.c \
     upstream-freebsd/lib/libc/string/wcscpy.c \
     upstream-freebsd/lib/libc/string/wcslen.c \
+    upstream-freebsd/lib/libc/string/wcsncmp.c \
+    upstream-freebsd/lib/libc/string/wcsnlen.c \
     upstream-freebsd/lib/libc/string/wcsrchr.c \
+    upstream-freebsd/lib/libc/string/wmemchr.c \
     upstream-freebsd/lib/libc/string/wmemcmp.c \
     upstream-freebsd/lib/libc/string/wmemmove.c \
 
 libc_openbsd_src_files_arm += \
+    upstream-openbsd/lib/libc/string/strcasecmp.c \
+    upstream-openbsd/lib/libc/string/strcspn.c \
     upstream-openbsd/lib/libc/string/strncmp.c \
+    upstream-openbsd/lib/libc/string/strpbrk.c \
+    upstream-openbsd/lib/libc/string/strspn.c \
 
 #
 # Inherently architecture-specific code.
@@ -92,6 +99,36 @@ libc_common_additional_dependencies += $(cpu_variant_mk)
 
 cpu_variant_mk :=
 
+# On ARMv7, libc.so chooses memcpy, memset, strcmp and strlen at run time
+# from all the variants (see arch-arm/dynamic_function_dispatch.cpp).
+# libc.a and the dynamic linker use the TARGET_CPU_VARIANT ones.
+ifneq ($(filter armv7-a%, $(TARGET_$(my_2nd_arch_prefix)ARCH_VARIANT)),)
+libc_arch_static_src_files_arm += $(libc_dispatch_default_src_files_arm)
+libc_arch_dynamic_src_files_arm += \
+    arch-arm/dynamic_function_dispatch.cpp \
+    arch-arm/dispatch/memcpy_a15.S \
+    arch-arm/dispatch/memcpy_a9.S \
+    arch-arm/dispatch/memcpy_denver.S \
+    arch-arm/dispatch/memcpy_generic.S \
+    arch-arm/dispatch/memcpy_krait.S \
+    arch-arm/dispatch/memset_a15.S \
+    arch-arm/dispatch/memset_a9.S \
+    arch-arm/dispatch/memset_denver.S \
+    arch-arm/dispatch/memset_generic.S \
+    arch-arm/dispatch/memset_krait.S \
+    arch-arm/dispatch/strcmp_a15.S \
+    arch-arm/dispatch/strcmp_a9.S \
+    arch-arm/dispatch/strcmp_generic.S \
+    arch-arm/dispatch/strcmp_krait.S \
+    arch-arm/dispatch/strlen_a15.S \
+    arch-arm/dispatch/strlen_a9.S \
+    arch-arm/dispatch/strlen_generic.c \
+
+else
+libc_bionic_src_files_arm += $(libc_dispatch_default_src_files_arm)
+endif
+libc_dispatch_default_src_files_arm :=
+
 
 libc_crt_target_cflags_arm := \
     -I$(LOCAL_PATH)/arch-arm/include \
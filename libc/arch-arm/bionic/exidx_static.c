@@ -41,6 +41,8 @@ extern unsigned __exidx_start;
 _Unwind_Ptr __gnu_Unwind_Find_exidx(_Unwind_Ptr pc __attribute__((unused)), 
                                     int *pcount)
 {
-	*pcount = (__exidx_end-__exidx_start)/8;
-	return (_Unwind_Ptr)__exidx_start;
+	/* Each entry is two words. These are addresses, which in a
+	 * static-PIE executable depend on where it was loaded. */
+	*pcount = (&__exidx_end - &__exidx_start) / 2;
+	return (_Unwind_Ptr)&__exidx_start;
 }
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+#include <sys/syscall.h>
+#include <asm/hwcap.h>
+
+// In libc.so, memcpy, memset, strcmp and strlen (and the __memcpy_chk,
+// __memset_chk and bzero that share their code) are IFUNCs. The dynamic
+// linker calls the resolvers below with AT_HWCAP, and they pick whichever
+// of the cortex-a9, cortex-a15, krait and denver routines TARGET_CPU_VARIANT
+// would have chosen for the CPU we're actually running on. libc.a and the
+// dynamic linker itself still use the build-time choice.
+//
+// The resolvers run while libc.so is being relocated, so they mustn't call
+// anything through the PLT: /proc/cpuinfo is read with raw system calls into
+// static storage.
+
+enum cpu_variant {
+  kUnknown = 0,
+  kGeneric,
+  kCortexA9,
+  kCortexA15,
+  kKrait,
+  kScorpion,
+  kDenver,
+};
+
+static cpu_variant g_cpu_variant;
+static char g_cpuinfo[1024];
+
+static long ifunc_syscall(long nr, long arg0, long arg1, long arg2) {
+  register long r0 __asm__("r0") = arg0;
+  register long r1 __asm__("r1") = arg1;
+  register long r2 __asm__("r2") = arg2;
+  // r7 may be the Thumb frame pointer, so we can't just ask for it.
+  __asm__ __volatile__("push {r7}\n"
+                       "mov r7, %4\n"
+                       "swi #0\n"
+                       "pop {r7}"
+                       : "=r"(r0)
+                       : "0"(r0), "r"(r1), "r"(r2), "r"(nr)
+                       : "memory");
+  return r0;
+}
+
+// Returns the value of the first "key : 0x..." line in g_cpuinfo, or -1.
+static long cpuinfo_field(const char* key) {
+  for (const char* line = g_cpuinfo; *line != '\0'; ) {
+    const char* p = line;
+    const char* k = key;
+    while (*k != '\0' && *p == *k) {
+      ++p;
+      ++k;
+    }
+    if (*k == '\0') {
+      while (*p == ' ' || *p == '\t' || *p == ':') {
+        ++p;
+      }
+      if (p[0] == '0' && p[1] == 'x') {
+        long value = 0;
+        for (p += 2; ; ++p) {
+          if (*p >= '0' && *p <= '9') {
+            value = value * 16 + (*p - '0');
+          } else if (*p >= 'a' && *p <= 'f') {
+            value = value * 16 + (*p - 'a' + 10);
+          } else {
+            return value;
+          }
+        }
+      }
+    }
+    while (*line != '\0' && *line++ != '\n') {
+    }
+  }
+  return -1;
+}
+
+static cpu_variant detect_cpu_variant(unsigned long hwcap) {
+  // Everything but the generic routines needs NEON.
+  if ((hwcap & HWCAP_NEON) == 0) {
+    return kGeneric;
+  }
+
+  long fd = ifunc_syscall(__NR_openat, AT_FDCWD, reinterpret_cast<long>("/proc/cpuinfo"), O_RDONLY);
+  if (fd < 0) {
+    return kGeneric;
+  }
+  size_t n = 0;
+  while (n < sizeof(g_cpuinfo) - 1) {
+    long rc = ifunc_syscall(__NR_read, fd, reinterpret_cast<long>(g_cpuinfo + n),
+                            sizeof(g_cpuinfo) - 1 - n);
+    if (rc <= 0) {
+      break;
+    }
+    n += rc;
+  }
+  g_cpuinfo[n] = '\0';
+  ifunc_syscall(__NR_close, fd, 0, 0);
+
+  long implementer = cpuinfo_field("CPU implementer");
+  long part = cpuinfo_field("CPU part");
+  switch (implementer) {
+    case 0x41: // ARM
+      // The cortex-a7, cortex-a8 and cortex-a53 variants use the a15 routines too.
+      return (part == 0xc09) ? kCortexA9 : kCortexA15;
+    case 0x4e: // NVIDIA
+      return kDenver;
+    case 0x51: // Qualcomm
+      if (part == 0x00f || part == 0x02d) {
+        return kScorpion;
+      }
+      if (part == 0x04d || part == 0x06f) {
+        return kKrait;
+      }
+      return kCortexA15;
+    default:
+      return kGeneric;
+  }
+}
+
+static cpu_variant get_cpu_variant(unsigned long hwcap) {
+  if (g_cpu_variant == kUnknown) {
+    g_cpu_variant = detect_cpu_variant(hwcap);
+  }
+  return g_cpu_variant;
+}
+
+// The variants are global in their own objects, but hidden here so we can take
+// their addresses without going through the GOT.
+#define DECLARE_VARIANT(name) \
+  extern "C" __LIBC_HIDDEN__ void name()
+
+#define DEFINE_IFUNC(name, resolver, ret, args) \
+  extern "C" ret name args __attribute__((ifunc(#resolver)))
+
+DECLARE_VARIANT(__memcpy_generic);
+DECLARE_VARIANT(__memcpy_a9);
+DECLARE_VARIANT(__memcpy_a15);
+DECLARE_VARIANT(__memcpy_krait);
+DECLARE_VARIANT(__memcpy_denver);
+DECLARE_VARIANT(__memcpy_chk_generic);
+DECLARE_VARIANT(__memcpy_chk_a9);
+DECLARE_VARIANT(__memcpy_chk_a15);
+DECLARE_VARIANT(__memcpy_chk_krait);
+DECLARE_VARIANT(__memcpy_chk_denver);
+DECLARE_VARIANT(__memset_generic);
+DECLARE_VARIANT(__memset_a9);
+DECLARE_VARIANT(__memset_a15);
+DECLARE_VARIANT(__memset_krait);
+DECLARE_VARIANT(__memset_denver);
+DECLARE_VARIANT(__memset_chk_generic);
+DECLARE_VARIANT(__memset_chk_a9);
+DECLARE_VARIANT(__memset_chk_a15);
+DECLARE_VARIANT(__memset_chk_krait);
+DECLARE_VARIANT(__memset_chk_denver);
+DECLARE_VARIANT(__bzero_generic);
+DECLARE_VARIANT(__bzero_a9);
+DECLARE_VARIANT(__bzero_a15);
+DECLARE_VARIANT(__bzero_krait);
+DECLARE_VARIANT(__bzero_denver);
+DECLARE_VARIANT(__strcmp_generic);
+DECLARE_VARIANT(__strcmp_a9);
+DECLARE_VARIANT(__strcmp_a15);
+DECLARE_VARIANT(__strcmp_krait);
+DECLARE_VARIANT(__strlen_generic);
+DECLARE_VARIANT(__strlen_a9);
+DECLARE_VARIANT(__strlen_a15);
+
+// Each routine comes from the same variant its CPU's .mk file picked.
+#define MEMCPY_LIKE_RESOLVER(name) \
+  extern "C" __LIBC_HIDDEN__ void* name ## _resolver(unsigned long hwcap) { \
+    switch (get_cpu_variant(hwcap)) { \
+      case kCortexA9: return reinterpret_cast<void*>(__ ## name ## _a9); \
+      case kCortexA15: return reinterpret_cast<void*>(__ ## name ## _a15); \
+      case kKrait: return reinterpret_cast<void*>(__ ## name ## _krait); \
+      case kScorpion: return reinterpret_cast<void*>(__ ## name ## _a15); \
+      case kDenver: return reinterpret_cast<void*>(__ ## name ## _denver); \
+      default: return reinterpret_cast<void*>(__ ## name ## _generic); \
+    } \
+  }
+
+#define MEMSET_LIKE_RESOLVER(name) \
+  extern "C" __LIBC_HIDDEN__ void* name ## _resolver(unsigned long hwcap) { \
+    switch (get_cpu_variant(hwcap)) { \
+      case kCortexA9: return reinterpret_cast<void*>(__ ## name ## _a9); \
+      case kCortexA15: return reinterpret_cast<void*>(__ ## name ## _a15); \
+      case kKrait: return reinterpret_cast<void*>(__ ## name ## _krait); \
+      case kScorpion: return reinterpret_cast<void*>(__ ## name ## _krait); \
+      case kDenver: return reinterpret_cast<void*>(__ ## name ## _denver); \
+      default: return reinterpret_cast<void*>(__ ## name ## _generic); \
+    } \
+  }
+
+MEMCPY_LIKE_RESOLVER(memcpy)
+DEFINE_IFUNC(memcpy, memcpy_resolver, void*, (void*, const void*, size_t));
+
+MEMCPY_LIKE_RESOLVER(memcpy_chk)
+DEFINE_IFUNC(__memcpy_chk, memcpy_chk_resolver, void*, (void*, const void*, size_t, size_t));
+
+MEMSET_LIKE_RESOLVER(memset)
+DEFINE_IFUNC(memset, memset_resolver, void*, (void*, int, size_t));
+
+MEMSET_LIKE_RESOLVER(memset_chk)
+DEFINE_IFUNC(__memset_chk, memset_chk_resolver, void*, (void*, int, size_t, size_t));
+
+MEMSET_LIKE_RESOLVER(bzero)
+DEFINE_IFUNC(bzero, bzero_resolver, void, (void*, size_t));
+
+extern "C" __LIBC_HIDDEN__ void* strcmp_resolver(unsigned long hwcap) {
+  switch (get_cpu_variant(hwcap)) {
+    case kCortexA9: return reinterpret_cast<void*>(__strcmp_a9);
+    case kKrait:
+    case kScorpion: return reinterpret_cast<void*>(__strcmp_krait);
+    case kCortexA15:
+    case kDenver: return reinterpret_cast<void*>(__strcmp_a15);
+    default: return reinterpret_cast<void*>(__strcmp_generic);
+  }
+}
+DEFINE_IFUNC(strcmp, strcmp_resolver, int, (const char*, const char*));
+
+extern "C" __LIBC_HIDDEN__ void* strlen_resolver(unsigned long hwcap) {
+  switch (get_cpu_variant(hwcap)) {
+    case kCortexA9: return reinterpret_cast<void*>(__strlen_a9);
+    case kCortexA15:
+    case kKrait:
+    case kScorpion:
+    case kDenver: return reinterpret_cast<void*>(__strlen_a15);
+    default: return reinterpret_cast<void*>(__strlen_generic);
+  }
+}
+DEFINE_IFUNC(strlen, strlen_resolver, size_t, (const char*));
@@ -1,11 +1,13 @@
 libc_bionic_src_files_arm += \
     bionic/memchr.c \
-    arch-arm/generic/bionic/memcpy.S \
-    arch-arm/generic/bionic/memset.S \
-    arch-arm/generic/bionic/strcmp.S \
     arch-arm/generic/bionic/strcpy.S \
-    arch-arm/generic/bionic/strlen.c \
     bionic/memmove.c \
     bionic/__strcat_chk.cpp \
     bionic/__strcpy_chk.cpp \
     upstream-darwin/lib/libc/string/strcat.c \
+
+libc_dispatch_default_src_files_arm += \
+    arch-arm/generic/bionic/memcpy.S \
+    arch-arm/generic/bionic/memset.S \
+    arch-arm/generic/bionic/strcmp.S \
+    arch-arm/generic/bionic/strlen.c \
@@ -1,17 +1,19 @@
 libc_bionic_src_files_arm += \
     arch-arm/cortex-a15/bionic/memchr.S \
-    arch-arm/krait/bionic/memset.S \
-    arch-arm/krait/bionic/strcmp.S \
     arch-arm/krait/bionic/__strcat_chk.S \
     arch-arm/krait/bionic/__strcpy_chk.S \
     arch-arm/krait/bionic/memmove.S
 
+libc_dispatch_default_src_files_arm += \
+    arch-arm/krait/bionic/memset.S \
+    arch-arm/krait/bionic/strcmp.S \
+
 #For some targets we don't need this optimization
 ifeq ($(TARGET_CPU_MEMCPY_BASE_OPT_DISABLE),true)
-libc_bionic_src_files_arm += \
+libc_dispatch_default_src_files_arm += \
     arch-arm/cortex-a15/bionic/memcpy.S
 else
-libc_bionic_src_files_arm += \
+libc_dispatch_default_src_files_arm += \
     arch-arm/krait/bionic/memcpy.S
 endif
 
@@ -20,4 +22,6 @@ libc_bionic_src_files_arm += \
     arch-arm/cortex-a15/bionic/stpcpy.S \
     arch-arm/cortex-a15/bionic/strcat.S \
     arch-arm/cortex-a15/bionic/strcpy.S \
+
+libc_dispatch_default_src_files_arm += \
     arch-arm/cortex-a15/bionic/strlen.S \
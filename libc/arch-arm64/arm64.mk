@@ -8,7 +8,6 @@ libc_bionic_src_files_arm64 += \
     bionic/__memset_chk.cpp \
     bionic/__strcpy_chk.cpp \
     bionic/__strcat_chk.cpp \
-    bionic/memrchr.c \
 
 libc_darwin_src_files_arm64 += \
     upstream-darwin/lib/libc/string/stpncpy.c \
@@ -20,14 +19,7 @@ libc_darwin_src_files_arm64 += \
 
 libc_freebsd_src_files_arm64 += \
     upstream-freebsd/lib/libc/string/wcscat.c \
-    upstream-freebsd/lib/libc/string/wcschr.c \
-    upstream-freebsd/lib/libc/string/wcscmp.c \
-    upstream-freebsd/lib/libc/string/wcscpy.c \
-    upstream-freebsd/lib/libc/string/wcslen.c \
     upstream-freebsd/lib/libc/string/wcsrchr.c \
-    upstream-freebsd/lib/libc/string/wmemcmp.c \
-
-libc_openbsd_src_files_arm64 += \
 
 #
 # Inherently architecture-specific code.
@@ -35,6 +27,7 @@ libc_openbsd_src_files_arm64 += \
 
 libc_bionic_src_files_arm64 += \
     arch-arm64/bionic/__bionic_clone.S \
+    arch-arm64/bionic/cache_info.cpp \
     arch-arm64/bionic/_exit_with_stack_teardown.S \
     arch-arm64/bionic/_setjmp.S \
     arch-arm64/bionic/setjmp.S \
@@ -65,3 +58,16 @@ include $(cpu_variant_mk)
 libc_common_additional_dependencies += $(cpu_variank_mk)
 
 cpu_variant_mk :=
+
+# libc.so chooses memcpy and memset at run time from all the variants (see
+# arch-arm64/dynamic_function_dispatch.cpp). libc.a and the dynamic linker
+# use the TARGET_CPU_VARIANT ones.
+libc_arch_static_src_files_arm64 += $(libc_dispatch_default_src_files_arm64)
+libc_arch_dynamic_src_files_arm64 += \
+    arch-arm64/dynamic_function_dispatch.cpp \
+    arch-arm64/dispatch/memcpy_denver64.S \
+    arch-arm64/dispatch/memcpy_generic.S \
+    arch-arm64/dispatch/memset_denver64.S \
+    arch-arm64/dispatch/memset_generic.S \
+
+libc_dispatch_default_src_files_arm64 :=
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <unistd.h>
+
+#include "../../bionic/libc_init_common.h"
+
+// memcpy and memset use non-temporal stores for anything at least this
+// big, so that a huge copy doesn't evict everything else. Nothing is that
+// big until __libc_init_cache_info has found the size of the last level
+// cache. The cache geometry registers can't be read from user space, so
+// it comes from sysfs.
+extern "C" {
+__LIBC_HIDDEN__ uint64_t __arm64_nontemporal_threshold = UINT64_MAX;
+}
+
+// Reads /sys/devices/system/cpu/cpu0/cache/index<index>/<name> into buf.
+static bool read_cache_attribute(int index, const char* name, char* buf, size_t size) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, name);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  ssize_t n = TEMP_FAILURE_RETRY(read(fd, buf, size - 1));
+  close(fd);
+  if (n <= 0) {
+    return false;
+  }
+  buf[n] = '\0';
+  return true;
+}
+
+// Parses a size such as "32K" or "2048K" or "8M".
+static uint64_t parse_cache_size(const char* s) {
+  uint64_t size = 0;
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    size = size * 10 + (*s - '0');
+  }
+  if (*s == 'K') {
+    size *= 1024;
+  } else if (*s == 'M') {
+    size *= 1024 * 1024;
+  }
+  return size;
+}
+
+void __libc_init_cache_info() {
+  uint64_t shared_size = 0;
+  int shared_level = 0;
+  char buf[32];
+  for (int i = 0; read_cache_attribute(i, "level", buf, sizeof(buf)); ++i) {
+    int level = buf[0] - '0';
+    if (level <= shared_level || !read_cache_attribute(i, "type", buf, sizeof(buf)) ||
+        strncmp(buf, "Instruction", 11) == 0 ||
+        !read_cache_attribute(i, "size", buf, sizeof(buf))) {
+      continue;
+    }
+    shared_level = level;
+    shared_size = parse_cache_size(buf);
+  }
+  if (shared_size != 0) {
+    __arm64_nontemporal_threshold = shared_size;
+  }
+}
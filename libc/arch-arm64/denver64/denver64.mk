@@ -1,14 +1,22 @@
 libc_bionic_src_files_arm64 += \
     arch-arm64/generic/bionic/memchr.S \
     arch-arm64/generic/bionic/memcmp.S \
-    arch-arm64/denver64/bionic/memcpy.S \
     arch-arm64/generic/bionic/memmove.S \
-    arch-arm64/denver64/bionic/memset.S \
+    arch-arm64/generic/bionic/memrchr.S \
+    arch-arm64/generic/bionic/neon-strcasecmp.c \
+    arch-arm64/generic/bionic/neon-wcs.c \
     arch-arm64/generic/bionic/stpcpy.S \
     arch-arm64/generic/bionic/strchr.S \
     arch-arm64/generic/bionic/strcmp.S \
     arch-arm64/generic/bionic/strcpy.S \
+    arch-arm64/generic/bionic/strcspn.S \
     arch-arm64/generic/bionic/strlen.S \
     arch-arm64/generic/bionic/strncmp.S \
     arch-arm64/generic/bionic/strnlen.S \
+    arch-arm64/generic/bionic/strpbrk.S \
+    arch-arm64/generic/bionic/strspn.S \
     arch-arm64/generic/bionic/wmemmove.S
+
+libc_dispatch_default_src_files_arm64 += \
+    arch-arm64/denver64/bionic/memcpy.S \
+    arch-arm64/denver64/bionic/memset.S \
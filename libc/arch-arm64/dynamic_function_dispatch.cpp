@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+#include <sys/syscall.h>
+
+// In libc.so, memcpy and memset (and the __memcpy_chk that shares memcpy's
+// code) are IFUNCs whose resolvers pick the denver64 routines on NVIDIA's
+// cores and the generic ones elsewhere, as TARGET_CPU_VARIANT would have.
+// libc.a and the dynamic linker itself still use the build-time choice.
+// See arch-arm/dynamic_function_dispatch.cpp for why the resolvers read
+// /proc/cpuinfo the hard way.
+
+enum cpu_variant {
+  kUnknown = 0,
+  kGeneric,
+  kDenver64,
+};
+
+static cpu_variant g_cpu_variant;
+static char g_cpuinfo[1024];
+
+static long ifunc_syscall(long nr, long arg0, long arg1, long arg2) {
+  register long x0 __asm__("x0") = arg0;
+  register long x1 __asm__("x1") = arg1;
+  register long x2 __asm__("x2") = arg2;
+  register long x8 __asm__("x8") = nr;
+  __asm__ __volatile__("svc #0"
+                       : "=r"(x0)
+                       : "0"(x0), "r"(x1), "r"(x2), "r"(x8)
+                       : "memory");
+  return x0;
+}
+
+// Returns the value of the first "key : 0x..." line in g_cpuinfo, or -1.
+static long cpuinfo_field(const char* key) {
+  for (const char* line = g_cpuinfo; *line != '\0'; ) {
+    const char* p = line;
+    const char* k = key;
+    while (*k != '\0' && *p == *k) {
+      ++p;
+      ++k;
+    }
+    if (*k == '\0') {
+      while (*p == ' ' || *p == '\t' || *p == ':') {
+        ++p;
+      }
+      if (p[0] == '0' && p[1] == 'x') {
+        long value = 0;
+        for (p += 2; ; ++p) {
+          if (*p >= '0' && *p <= '9') {
+            value = value * 16 + (*p - '0');
+          } else if (*p >= 'a' && *p <= 'f') {
+            value = value * 16 + (*p - 'a' + 10);
+          } else {
+            return value;
+          }
+        }
+      }
+    }
+    while (*line != '\0' && *line++ != '\n') {
+    }
+  }
+  return -1;
+}
+
+static cpu_variant detect_cpu_variant() {
+  long fd = ifunc_syscall(__NR_openat, AT_FDCWD, reinterpret_cast<long>("/proc/cpuinfo"), O_RDONLY);
+  if (fd < 0) {
+    return kGeneric;
+  }
+  size_t n = 0;
+  while (n < sizeof(g_cpuinfo) - 1) {
+    long rc = ifunc_syscall(__NR_read, fd, reinterpret_cast<long>(g_cpuinfo + n),
+                            sizeof(g_cpuinfo) - 1 - n);
+    if (rc <= 0) {
+      break;
+    }
+    n += rc;
+  }
+  g_cpuinfo[n] = '\0';
+  ifunc_syscall(__NR_close, fd, 0, 0);
+
+  return (cpuinfo_field("CPU implementer") == 0x4e) ? kDenver64 : kGeneric;
+}
+
+static cpu_variant get_cpu_variant() {
+  if (g_cpu_variant == kUnknown) {
+    g_cpu_variant = detect_cpu_variant();
+  }
+  return g_cpu_variant;
+}
+
+// The variants are global in their own objects, but hidden here so we can take
+// their addresses without going through the GOT.
+#define DECLARE_VARIANT(name) \
+  extern "C" __LIBC_HIDDEN__ void name()
+
+#define DEFINE_IFUNC(name, resolver, ret, args) \
+  extern "C" ret name args __attribute__((ifunc(#resolver)))
+
+#define RESOLVER(name) \
+  extern "C" __LIBC_HIDDEN__ void* name ## _resolver(unsigned long) { \
+    if (get_cpu_variant() == kDenver64) { \
+      return reinterpret_cast<void*>(__ ## name ## _denver64); \
+    } \
+    return reinterpret_cast<void*>(__ ## name ## _generic); \
+  }
+
+DECLARE_VARIANT(__memcpy_generic);
+DECLARE_VARIANT(__memcpy_denver64);
+DECLARE_VARIANT(__memcpy_chk_generic);
+DECLARE_VARIANT(__memcpy_chk_denver64);
+DECLARE_VARIANT(__memset_generic);
+DECLARE_VARIANT(__memset_denver64);
+
+RESOLVER(memcpy)
+DEFINE_IFUNC(memcpy, memcpy_resolver, void*, (void*, const void*, size_t));
+
+RESOLVER(memcpy_chk)
+DEFINE_IFUNC(__memcpy_chk, memcpy_chk_resolver, void*, (void*, const void*, size_t, size_t));
+
+RESOLVER(memset)
+DEFINE_IFUNC(memset, memset_resolver, void*, (void*, int, size_t));
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * NEON wcslen, wcsnlen, wcschr, wcscmp, wcsncmp, wmemchr, wmemcmp and
+ * wcscpy. NEON has no movemask; narrowing each 32-bit lane of a compare
+ * by four bits (shrn) leaves a 64-bit mask with four bits per byte.
+ */
+
+#include <arm_neon.h>
+
+#define	FUNC(name)	name
+
+#define	VEC_SIZE	16
+#define	VEC_TARGET
+typedef uint32x4_t vec_t;
+typedef uint64_t vmask_t;
+
+#define	MASK_BITS_PER_BYTE	4
+#define	MASK_ALL		UINT64_MAX
+
+#define	vec_load(p)		vld1q_u32((const uint32_t *)(p))
+#define	vec_loadu(p)		vld1q_u32((const uint32_t *)(p))
+#define	vec_set1(c)		vdupq_n_u32((uint32_t)(c))
+#define	vec_zero()		vdupq_n_u32(0)
+#define	vec_cmpeq(a, b)		vceqq_u32(a, b)
+#define	vec_or(a, b)		vorrq_u32(a, b)
+#define	vec_mask(v) \
+    vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u32(v), 4)), 0)
+#define	vec_ctz(m)		__builtin_ctzll(m)
+
+#include "../../../arch-common/string/wcs_vec.h"
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * strcasecmp and strncasecmp, folding ASCII case a vector at a time. bionic's
+ * locales all share the C locale's case mapping, so these also serve
+ * strcasecmp_l and strncasecmp_l. The including file defines FUNC(name) to
+ * name the functions, VEC_SIZE, vec_t, VEC_TARGET, and:
+ *
+ *	vec_loadu(p), vec_zero()
+ *	vec_cmpeq(a, b)	on bytes
+ *	vec_fold(v)	v with 'A' to 'Z' changed to 'a' to 'z'
+ *	vec_mask(v)	a vmask_t with MASK_BITS_PER_BYTE bits for each byte
+ *			of v, lowest address first; MASK_ALL has them all set
+ *	vec_ctz(m)	the number of trailing zero bits in a vmask_t
+ *
+ * The strings can't both be aligned, so we go a byte at a time near the
+ * end of a page rather than load from one we might not be able to read.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define	MASK_INDEX(m)	(vec_ctz(m) / MASK_BITS_PER_BYTE)
+#define	NEAR_PAGE_END(p) \
+    (((uintptr_t)(p) & (4096 - 1)) > 4096 - VEC_SIZE)
+
+static inline int
+fold(unsigned char c)
+{
+	return ((unsigned int)(c - 'A') < 26 ? c + ('a' - 'A') : c);
+}
+
+/*
+ * The mask of the bytes where a and b differ once folded, or a ends, for
+ * the vectors at a and b.
+ */
+VEC_TARGET static inline vmask_t
+case_stop(const char *a, const char *b)
+{
+	vec_t va = vec_loadu(a);
+	vec_t vb = vec_loadu(b);
+
+	return ((~vec_mask(vec_cmpeq(vec_fold(va), vec_fold(vb))) & MASK_ALL) |
+	    vec_mask(vec_cmpeq(va, vec_zero())));
+}
+
+VEC_TARGET int
+FUNC(strcasecmp)(const char *s1, const char *s2)
+{
+	const unsigned char *a = (const unsigned char *)s1;
+	const unsigned char *b = (const unsigned char *)s2;
+	vmask_t mask;
+	size_t i;
+
+	for (;;) {
+		if (NEAR_PAGE_END(a) || NEAR_PAGE_END(b)) {
+			if (fold(*a) != fold(*b))
+				return (fold(*a) - fold(*b));
+			if (*a == '\0')
+				return (0);
+			a++;
+			b++;
+			continue;
+		}
+		mask = case_stop((const char *)a, (const char *)b);
+		if (mask != 0) {
+			i = MASK_INDEX(mask);
+			return (fold(a[i]) - fold(b[i]));
+		}
+		a += VEC_SIZE;
+		b += VEC_SIZE;
+	}
+}
+
+VEC_TARGET int
+FUNC(strncasecmp)(const char *s1, const char *s2, size_t n)
+{
+	const unsigned char *a = (const unsigned char *)s1;
+	const unsigned char *b = (const unsigned char *)s2;
+	vmask_t mask;
+	size_t i;
+
+	while (n != 0) {
+		if (NEAR_PAGE_END(a) || NEAR_PAGE_END(b)) {
+			if (fold(*a) != fold(*b))
+				return (fold(*a) - fold(*b));
+			if (*a == '\0')
+				return (0);
+			a++;
+			b++;
+			n--;
+			continue;
+		}
+		mask = case_stop((const char *)a, (const char *)b);
+		/* Most calls are for a short prefix: mask off the rest. */
+		if (n < VEC_SIZE)
+			mask &= ((vmask_t)1 << (n * MASK_BITS_PER_BYTE)) - 1;
+		if (mask != 0) {
+			i = MASK_INDEX(mask);
+			return (fold(a[i]) - fold(b[i]));
+		}
+		if (n <= VEC_SIZE)
+			return (0);
+		a += VEC_SIZE;
+		b += VEC_SIZE;
+		n -= VEC_SIZE;
+	}
+	return (0);
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * wcslen, wcsnlen, wcschr, wcscmp, wcsncmp, wmemchr, wmemcmp and wcscpy,
+ * written once for any vector of 32-bit lanes. The including file defines
+ * FUNC(name) to name the functions, VEC_SIZE, vec_t, VEC_TARGET, and:
+ *
+ *	vec_load(p), vec_loadu(p)	aligned and unaligned loads
+ *	vec_set1(c), vec_zero()
+ *	vec_cmpeq(a, b), vec_or(a, b)	on 32-bit lanes
+ *	vec_mask(v)	a vmask_t with MASK_BITS_PER_BYTE bits for each byte
+ *			of v, lowest address first; MASK_ALL has them all set
+ *	vec_ctz(m)	the number of trailing zero bits in a vmask_t
+ *
+ * Scans of a single string use aligned loads, which never cross into a
+ * page the string doesn't touch. Comparisons can't align both strings,
+ * so they go one character at a time near the end of a page.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+
+#define	WCHARS_PER_VEC	(VEC_SIZE / sizeof(wchar_t))
+#define	WVEC_ALIGN(p) \
+    ((const wchar_t *)((uintptr_t)(p) & ~(uintptr_t)(VEC_SIZE - 1)))
+
+/* The mask bits for n characters, and the first character a mask reports. */
+#define	MASK_SHIFT(n)	((n) * sizeof(wchar_t) * MASK_BITS_PER_BYTE)
+#define	MASK_INDEX(m)	(vec_ctz(m) / (sizeof(wchar_t) * MASK_BITS_PER_BYTE))
+
+/* Whether an unaligned vector load at p might reach into the next page. */
+#define	NEAR_PAGE_END(p) \
+    (((uintptr_t)(p) & (4096 - 1)) > 4096 - VEC_SIZE)
+
+VEC_TARGET static inline vmask_t
+wmatch(const wchar_t *p, vec_t c)
+{
+	return vec_mask(vec_cmpeq(vec_load(p), c));
+}
+
+/* What wcscmp and wcsncmp return for a pair of characters that differ. */
+static inline int
+wdiff(wchar_t a, wchar_t b)
+{
+	return ((unsigned int)a - (unsigned int)b);
+}
+
+VEC_TARGET size_t
+FUNC(wcslen)(const wchar_t *s)
+{
+	const wchar_t *p = WVEC_ALIGN(s);
+	vec_t zero = vec_zero();
+	vmask_t mask;
+
+	mask = wmatch(p, zero) >> MASK_SHIFT(s - p);
+	if (mask != 0)
+		return (MASK_INDEX(mask));
+
+	/* Single vectors up to a 4 * VEC_SIZE boundary, then four at a time. */
+	for (;;) {
+		p += WCHARS_PER_VEC;
+		if (((uintptr_t)p & (4 * VEC_SIZE - 1)) == 0)
+			break;
+		mask = wmatch(p, zero);
+		if (mask != 0)
+			return (p + MASK_INDEX(mask) - s);
+	}
+	for (;; p += 4 * WCHARS_PER_VEC) {
+		vec_t m0 = vec_cmpeq(vec_load(p), zero);
+		vec_t m1 = vec_cmpeq(vec_load(p + WCHARS_PER_VEC), zero);
+		vec_t m2 = vec_cmpeq(vec_load(p + 2 * WCHARS_PER_VEC), zero);
+		vec_t m3 = vec_cmpeq(vec_load(p + 3 * WCHARS_PER_VEC), zero);
+		if (vec_mask(vec_or(vec_or(m0, m1), vec_or(m2, m3))) != 0)
+			break;
+	}
+	for (;; p += WCHARS_PER_VEC) {
+		mask = wmatch(p, zero);
+		if (mask != 0)
+			return (p + MASK_INDEX(mask) - s);
+	}
+}
+
+VEC_TARGET wchar_t *
+FUNC(wmemchr)(const wchar_t *s, wchar_t ch, size_t n)
+{
+	const wchar_t *p = WVEC_ALIGN(s);
+	size_t off = s - p;
+	vec_t c = vec_set1(ch);
+	vmask_t mask;
+
+	if (n == 0)
+		return (NULL);
+	mask = wmatch(p, c) >> MASK_SHIFT(off);
+	if (mask != 0) {
+		off = MASK_INDEX(mask);
+		return (off < n ? (wchar_t *)s + off : NULL);
+	}
+	if (n <= WCHARS_PER_VEC - off)
+		return (NULL);
+	n -= WCHARS_PER_VEC - off;
+	p += WCHARS_PER_VEC;
+
+	/*
+	 * wcsnlen passes SIZE_MAX, so don't look past a 4 * VEC_SIZE boundary
+	 * four vectors at a time until we know there's no match before it.
+	 */
+	for (;;) {
+		mask = wmatch(p, c);
+		if (mask != 0) {
+			off = MASK_INDEX(mask);
+			return (off < n ? (wchar_t *)p + off : NULL);
+		}
+		if (n <= WCHARS_PER_VEC)
+			return (NULL);
+		n -= WCHARS_PER_VEC;
+		p += WCHARS_PER_VEC;
+
+		if (((uintptr_t)p & (4 * VEC_SIZE - 1)) != 0)
+			continue;
+		/* On a match, go back to single vectors to find it. */
+		while (n > 4 * WCHARS_PER_VEC) {
+			vec_t m0 = vec_cmpeq(vec_load(p), c);
+			vec_t m1 = vec_cmpeq(vec_load(p + WCHARS_PER_VEC), c);
+			vec_t m2 = vec_cmpeq(vec_load(p + 2 * WCHARS_PER_VEC), c);
+			vec_t m3 = vec_cmpeq(vec_load(p + 3 * WCHARS_PER_VEC), c);
+			if (vec_mask(vec_or(vec_or(m0, m1),
+			    vec_or(m2, m3))) != 0)
+				break;
+			n -= 4 * WCHARS_PER_VEC;
+			p += 4 * WCHARS_PER_VEC;
+		}
+	}
+}
+
+VEC_TARGET size_t
+FUNC(wcsnlen)(const wchar_t *s, size_t maxlen)
+{
+	const wchar_t *p = FUNC(wmemchr)(s, L'\0', maxlen);
+
+	return (p != NULL ? (size_t)(p - s) : maxlen);
+}
+
+VEC_TARGET wchar_t *
+FUNC(wcschr)(const wchar_t *s, wchar_t ch)
+{
+	const wchar_t *p = WVEC_ALIGN(s);
+	vec_t c = vec_set1(ch);
+	vec_t zero = vec_zero();
+	vmask_t mask;
+	vec_t v;
+
+	v = vec_load(p);
+	mask = vec_mask(vec_or(vec_cmpeq(v, c), vec_cmpeq(v, zero)));
+	mask >>= MASK_SHIFT(s - p);
+	if (mask != 0) {
+		p = s + MASK_INDEX(mask);
+		return (*p == ch ? (wchar_t *)p : NULL);
+	}
+	for (;;) {
+		p += WCHARS_PER_VEC;
+		v = vec_load(p);
+		mask = vec_mask(vec_or(vec_cmpeq(v, c), vec_cmpeq(v, zero)));
+		if (mask != 0) {
+			p += MASK_INDEX(mask);
+			return (*p == ch ? (wchar_t *)p : NULL);
+		}
+	}
+}
+
+/*
+ * The mask of the characters where a and b differ or a ends, for the
+ * vectors at a and b.
+ */
+VEC_TARGET static inline vmask_t
+wstop(const wchar_t *a, const wchar_t *b, vec_t zero)
+{
+	vec_t va = vec_loadu(a);
+
+	return ((~vec_mask(vec_cmpeq(va, vec_loadu(b))) & MASK_ALL) |
+	    vec_mask(vec_cmpeq(va, zero)));
+}
+
+VEC_TARGET int
+FUNC(wcscmp)(const wchar_t *a, const wchar_t *b)
+{
+	vec_t zero = vec_zero();
+	vmask_t mask;
+	size_t i;
+
+	for (;;) {
+		if (NEAR_PAGE_END(a) || NEAR_PAGE_END(b)) {
+			if (*a != *b)
+				return (wdiff(*a, *b));
+			if (*a == L'\0')
+				return (0);
+			a++;
+			b++;
+			continue;
+		}
+		mask = wstop(a, b, zero);
+		if (mask != 0) {
+			i = MASK_INDEX(mask);
+			return (a[i] == b[i] ? 0 : wdiff(a[i], b[i]));
+		}
+		a += WCHARS_PER_VEC;
+		b += WCHARS_PER_VEC;
+	}
+}
+
+VEC_TARGET int
+FUNC(wcsncmp)(const wchar_t *a, const wchar_t *b, size_t n)
+{
+	vec_t zero = vec_zero();
+	vmask_t mask;
+	size_t i;
+
+	while (n != 0) {
+		if (n < WCHARS_PER_VEC || NEAR_PAGE_END(a) || NEAR_PAGE_END(b)) {
+			if (*a != *b)
+				return (wdiff(*a, *b));
+			if (*a == L'\0')
+				return (0);
+			a++;
+			b++;
+			n--;
+			continue;
+		}
+		mask = wstop(a, b, zero);
+		if (mask != 0) {
+			i = MASK_INDEX(mask);
+			return (a[i] == b[i] ? 0 : wdiff(a[i], b[i]));
+		}
+		a += WCHARS_PER_VEC;
+		b += WCHARS_PER_VEC;
+		n -= WCHARS_PER_VEC;
+	}
+	return (0);
+}
+
+VEC_TARGET int
+FUNC(wmemcmp)(const wchar_t *a, const wchar_t *b, size_t n)
+{
+	vmask_t mask;
+	size_t i;
+
+	for (; n >= WCHARS_PER_VEC; n -= WCHARS_PER_VEC) {
+		mask = ~vec_mask(vec_cmpeq(vec_loadu(a), vec_loadu(b))) &
+		    MASK_ALL;
+		if (mask != 0) {
+			i = MASK_INDEX(mask);
+			return (a[i] > b[i] ? 1 : -1);
+		}
+		a += WCHARS_PER_VEC;
+		b += WCHARS_PER_VEC;
+	}
+	for (; n != 0; n--, a++, b++) {
+		if (*a != *b)
+			return (*a > *b ? 1 : -1);
+	}
+	return (0);
+}
+
+VEC_TARGET wchar_t *
+FUNC(wcscpy)(wchar_t * __restrict dst, const wchar_t * __restrict src)
+{
+	memcpy(dst, src, (FUNC(wcslen)(src) + 1) * sizeof(wchar_t));
+	return (dst);
+}
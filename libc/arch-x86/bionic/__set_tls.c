@@ -47,7 +47,9 @@ __LIBC_HIDDEN__ void __init_user_desc(struct user_desc* result, bool allocate, v
 
   result->base_addr = (uintptr_t) base_addr;
 
-  result->limit = PAGE_SIZE;
+  // Cover the whole address space: ELF TLS variables live at negative offsets
+  // from the thread pointer, which wrap around past the end of the segment.
+  result->limit = 0xfffff;
 
   result->seg_32bit = 1;
   result->contents = MODIFY_LDT_CONTENTS_DATA;
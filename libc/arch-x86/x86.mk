@@ -29,8 +29,17 @@ libc_common_src_files_x86 += \
     bionic/__strcat_chk.cpp \
 
 libc_freebsd_src_files_x86 += \
+    upstream-freebsd/lib/libc/string/wcsncmp.c \
+    upstream-freebsd/lib/libc/string/wcsnlen.c \
+    upstream-freebsd/lib/libc/string/wmemchr.c \
     upstream-freebsd/lib/libc/string/wmemmove.c \
 
+libc_openbsd_src_files_x86 += \
+    upstream-openbsd/lib/libc/string/strcasecmp.c \
+    upstream-openbsd/lib/libc/string/strcspn.c \
+    upstream-openbsd/lib/libc/string/strpbrk.c \
+    upstream-openbsd/lib/libc/string/strspn.c \
+
 #
 # Inherently architecture-specific functions.
 #
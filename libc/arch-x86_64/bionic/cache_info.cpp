@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cpuid.h>
+#include <string.h>
+#include <sys/cdefs.h>
+
+#include "../string/cache.h"
+#include "../../bionic/libc_init_common.h"
+
+// memcpy, memmove and memset switch to non-temporal stores above a size
+// based on the shared cache, so that a huge copy doesn't evict everything
+// else, and memcmp tunes its loop to the data cache. These start out with
+// the build-time guesses from cache.h, and __libc_init_cache_info replaces
+// them with what CPUID says before main runs.
+extern "C" {
+__LIBC_HIDDEN__ long __x86_64_data_cache_size = DEFAULT_DATA_CACHE_SIZE;
+__LIBC_HIDDEN__ long __x86_64_data_cache_size_half = DEFAULT_DATA_CACHE_SIZE / 2;
+__LIBC_HIDDEN__ long __x86_64_shared_cache_size = DEFAULT_SHARED_CACHE_SIZE;
+__LIBC_HIDDEN__ long __x86_64_shared_cache_size_half = DEFAULT_SHARED_CACHE_SIZE / 2;
+}
+
+void __libc_init_cache_info() {
+  unsigned int eax, ebx, ecx, edx;
+  char vendor[12];
+
+  // Intel describes its caches with leaf 4 and AMD with leaf 0x8000001d;
+  // the two use the same layout.
+  __cpuid(0, eax, ebx, ecx, edx);
+  unsigned int max_leaf = eax;
+  memcpy(vendor, &ebx, 4);
+  memcpy(vendor + 4, &edx, 4);
+  memcpy(vendor + 8, &ecx, 4);
+  unsigned int leaf;
+  if (memcmp(vendor, "GenuineIntel", 12) == 0 && max_leaf >= 4) {
+    leaf = 4;
+  } else if (memcmp(vendor, "AuthenticAMD", 12) == 0 &&
+             __get_cpuid_max(0x80000000, NULL) >= 0x8000001d) {
+    leaf = 0x8000001d;
+  } else {
+    return;
+  }
+
+  long data_size = 0;
+  long shared_size = 0;
+  unsigned int shared_level = 0;
+  for (unsigned int i = 0; i < 16; ++i) {
+    __cpuid_count(leaf, i, eax, ebx, ecx, edx);
+    unsigned int type = eax & 0x1f;
+    if (type == 0) {
+      break;
+    }
+    if (type == 2) {
+      continue; // Instruction cache.
+    }
+    unsigned int level = (eax >> 5) & 7;
+    long ways = (ebx >> 22) + 1;
+    long partitions = ((ebx >> 12) & 0x3ff) + 1;
+    long line_size = (ebx & 0xfff) + 1;
+    long sets = static_cast<long>(ecx) + 1;
+    long size = ways * partitions * line_size * sets;
+    if (level == 1) {
+      data_size = size;
+    }
+    if (level > shared_level) {
+      shared_level = level;
+      shared_size = size;
+    }
+  }
+
+  if (data_size != 0) {
+    __x86_64_data_cache_size = data_size;
+    __x86_64_data_cache_size_half = data_size / 2;
+  }
+  if (shared_size != 0) {
+    __x86_64_shared_cache_size = shared_size;
+    __x86_64_shared_cache_size_half = shared_size / 2;
+  }
+}
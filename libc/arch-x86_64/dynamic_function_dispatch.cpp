@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cpuid.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+// In libc.so, memchr, memrchr, strchr, strrchr, strlen, strnlen, strcasecmp,
+// strncasecmp and the wide character wcslen, wcsnlen, wcschr, wcscmp,
+// wcsncmp, wmemchr, wmemcmp and wcscpy are IFUNCs choosing between SSE2 and
+// AVX2 routines, and strspn and strcspn between generic and SSE4.2 ones,
+// according to CPUID. libc.a and the dynamic linker use the SSE2 and generic
+// routines, which every x86-64 CPU can run.
+
+enum {
+  kFeaturesKnown = 1,
+  kSse42 = 2,
+  kAvx2 = 4,
+};
+
+static int g_cpu_features;
+
+static int detect_cpu_features() {
+  int features = kFeaturesKnown;
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+    return features;
+  }
+  if ((ecx & bit_SSE4_2) != 0) {
+    features |= kSse42;
+  }
+
+  // AVX2 also needs the kernel to be saving the YMM registers.
+  if ((ecx & (bit_OSXSAVE | bit_AVX)) != (bit_OSXSAVE | bit_AVX)) {
+    return features;
+  }
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0_lo & 6) != 6 || __get_cpuid_max(0, NULL) < 7) {
+    return features;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  if ((ebx & bit_AVX2) != 0) {
+    features |= kAvx2;
+  }
+  return features;
+}
+
+static int get_cpu_features() {
+  if (g_cpu_features == 0) {
+    g_cpu_features = detect_cpu_features();
+  }
+  return g_cpu_features;
+}
+
+// The variants are global in their own objects, but hidden here so we can take
+// their addresses without going through the GOT.
+#define DECLARE_VARIANT(name) \
+  extern "C" __LIBC_HIDDEN__ void name()
+
+#define DEFINE_IFUNC(name, resolver, ret, args) \
+  extern "C" ret name args __attribute__((ifunc(#resolver)))
+
+#define RESOLVER(name, feature, fast, slow) \
+  DECLARE_VARIANT(__ ## name ## _ ## fast); \
+  DECLARE_VARIANT(__ ## name ## _ ## slow); \
+  extern "C" __LIBC_HIDDEN__ void* name ## _resolver() { \
+    if ((get_cpu_features() & feature) != 0) { \
+      return reinterpret_cast<void*>(__ ## name ## _ ## fast); \
+    } \
+    return reinterpret_cast<void*>(__ ## name ## _ ## slow); \
+  }
+
+RESOLVER(memchr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(memchr, memchr_resolver, void*, (const void*, int, size_t));
+
+RESOLVER(memrchr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(memrchr, memrchr_resolver, void*, (const void*, int, size_t));
+
+RESOLVER(strchr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strchr, strchr_resolver, char*, (const char*, int));
+
+RESOLVER(strrchr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strrchr, strrchr_resolver, char*, (const char*, int));
+
+RESOLVER(strlen, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strlen, strlen_resolver, size_t, (const char*));
+
+RESOLVER(strnlen, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strnlen, strnlen_resolver, size_t, (const char*, size_t));
+
+RESOLVER(strcasecmp, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strcasecmp, strcasecmp_resolver, int, (const char*, const char*));
+
+RESOLVER(strncasecmp, kAvx2, avx2, sse2)
+DEFINE_IFUNC(strncasecmp, strncasecmp_resolver, int, (const char*, const char*, size_t));
+
+RESOLVER(strspn, kSse42, sse42, generic)
+DEFINE_IFUNC(strspn, strspn_resolver, size_t, (const char*, const char*));
+
+RESOLVER(strcspn, kSse42, sse42, generic)
+DEFINE_IFUNC(strcspn, strcspn_resolver, size_t, (const char*, const char*));
+
+RESOLVER(wcslen, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcslen, wcslen_resolver, size_t, (const wchar_t*));
+
+RESOLVER(wcsnlen, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcsnlen, wcsnlen_resolver, size_t, (const wchar_t*, size_t));
+
+RESOLVER(wcschr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcschr, wcschr_resolver, wchar_t*, (const wchar_t*, wchar_t));
+
+RESOLVER(wcscmp, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcscmp, wcscmp_resolver, int, (const wchar_t*, const wchar_t*));
+
+RESOLVER(wcsncmp, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcsncmp, wcsncmp_resolver, int, (const wchar_t*, const wchar_t*, size_t));
+
+RESOLVER(wmemchr, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wmemchr, wmemchr_resolver, wchar_t*, (const wchar_t*, wchar_t, size_t));
+
+RESOLVER(wmemcmp, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wmemcmp, wmemcmp_resolver, int, (const wchar_t*, const wchar_t*, size_t));
+
+RESOLVER(wcscpy, kAvx2, avx2, sse2)
+DEFINE_IFUNC(wcscpy, wcscpy_resolver, wchar_t*, (wchar_t*, const wchar_t*));
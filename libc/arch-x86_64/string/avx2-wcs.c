@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * AVX2 wcslen, wcsnlen, wcschr, wcscmp, wcsncmp, wmemchr, wmemcmp and
+ * wcscpy, chosen at run time by libc.so (see ../dynamic_function_dispatch.cpp).
+ */
+
+#include <immintrin.h>
+
+#define	FUNC(name)	__ ## name ## _avx2
+
+#define	VEC_SIZE	32
+#define	VEC_TARGET	__attribute__((target("avx2")))
+typedef __m256i vec_t;
+typedef unsigned int vmask_t;
+
+#define	MASK_BITS_PER_BYTE	1
+#define	MASK_ALL		0xffffffffU
+
+#define	vec_load(p)		_mm256_load_si256((const __m256i *)(p))
+#define	vec_loadu(p)		_mm256_loadu_si256((const __m256i *)(p))
+#define	vec_set1(c)		_mm256_set1_epi32(c)
+#define	vec_zero()		_mm256_setzero_si256()
+#define	vec_cmpeq(a, b)		_mm256_cmpeq_epi32(a, b)
+#define	vec_or(a, b)		_mm256_or_si256(a, b)
+#define	vec_mask(v)		((unsigned int)_mm256_movemask_epi8(v))
+#define	vec_ctz(m)		__builtin_ctz(m)
+
+#include "../../arch-common/string/wcs_vec.h"
@@ -28,9 +28,9 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-/* Values are optimized for Silvermont */
-#define SHARED_CACHE_SIZE	(1024*1024)			/* Silvermont L2 Cache */
-#define DATA_CACHE_SIZE		(24*1024)			/* Silvermont L1 Data Cache */
-
-#define SHARED_CACHE_SIZE_HALF	(SHARED_CACHE_SIZE / 2)
-#define DATA_CACHE_SIZE_HALF	(DATA_CACHE_SIZE / 2)
+/* Values are optimized for Silvermont. They're only used until
+   __libc_init_cache_info (see arch-x86_64/bionic/cache_info.cpp) has asked
+   CPUID for the real sizes: the string routines compare against the
+   __x86_64_*_cache_size* variables it sets.  */
+#define DEFAULT_SHARED_CACHE_SIZE	(1024*1024)			/* Silvermont L2 Cache */
+#define DEFAULT_DATA_CACHE_SIZE		(24*1024)			/* Silvermont L1 Data Cache */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * SSE2 strcasecmp and strncasecmp. SSE2 is part of x86-64, so these are
+ * the defaults; libc.so builds them again under their own names (see
+ * ../dynamic_function_dispatch.cpp).
+ */
+
+#include <emmintrin.h>
+
+#ifndef FUNC
+#define	FUNC(name)	name
+#endif
+
+#define	VEC_SIZE	16
+#define	VEC_TARGET
+typedef __m128i vec_t;
+typedef unsigned int vmask_t;
+
+#define	MASK_BITS_PER_BYTE	1
+#define	MASK_ALL		0xffffU
+
+#define	vec_loadu(p)		_mm_loadu_si128((const __m128i *)(p))
+#define	vec_zero()		_mm_setzero_si128()
+#define	vec_cmpeq(a, b)		_mm_cmpeq_epi8(a, b)
+#define	vec_mask(v)		((unsigned int)_mm_movemask_epi8(v))
+#define	vec_ctz(m)		__builtin_ctz(m)
+
+/*
+ * SSE2 only compares signed bytes, so 'A' to 'Z' are moved to the bottom
+ * of the signed range to test them with one comparison.
+ */
+static inline __m128i
+vec_fold(__m128i v)
+{
+	__m128i upper = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8(0x80 - 'A')),
+	    _mm_set1_epi8(-0x80 + 26));
+
+	return (_mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+}
+
+#include "../../arch-common/string/strcasecmp_vec.h"
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * SSE2 memchr, memrchr, strchr, strrchr and strnlen. SSE2 is part
+ * of x86-64, so these are the defaults; libc.so builds them again under
+ * their own names (see ../dynamic_function_dispatch.cpp). strlen itself
+ * comes from sse2-strlen-slm.S.
+ */
+
+#include <emmintrin.h>
+
+#ifndef FUNC
+#define	FUNC(name)	name
+#endif
+
+#define	VEC_SIZE	16
+#define	VEC_TARGET
+typedef __m128i vec_t;
+
+#define	vec_load(p)		_mm_load_si128((const __m128i *)(p))
+#define	vec_set1(c)		_mm_set1_epi8(c)
+#define	vec_zero()		_mm_setzero_si128()
+#define	vec_cmpeq(a, b)		_mm_cmpeq_epi8(a, b)
+#define	vec_or(a, b)		_mm_or_si128(a, b)
+#define	vec_min(a, b)		_mm_min_epu8(a, b)
+#define	vec_movemask(v)		((unsigned int)_mm_movemask_epi8(v))
+
+#include "string_vec.h"
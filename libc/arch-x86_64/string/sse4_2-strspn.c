@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * SSE4.2 strspn and strcspn, chosen at run time by libc.so (see
+ * ../dynamic_function_dispatch.cpp). pcmpestrm tests sixteen bytes of the
+ * string against a set of up to sixteen characters at once; longer sets
+ * go to the generic code.
+ *
+ * The first, aligned, load may have a NUL before the string starts, so
+ * it is compared with explicit lengths; after that, pcmpistrm stops at
+ * the terminator by itself. The terminator is never in the set, so it
+ * always ends the span.
+ */
+
+#include <nmmintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#define	SSE42	__attribute__((target("sse4.2")))
+
+size_t __strspn_generic(const char *, const char *);
+size_t __strcspn_generic(const char *, const char *);
+
+/* Load a set of at most 16 characters, zero-padded. */
+SSE42 static __m128i
+load_set(const char *set, size_t len)
+{
+	char buf[16] __attribute__((aligned(16)));
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = set[i];
+	for (; i < sizeof(buf); i++)
+		buf[i] = '\0';
+	return (_mm_load_si128((const __m128i *)buf));
+}
+
+#define	SPAN_MODE	(_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | \
+			    _SIDD_BIT_MASK | _SIDD_NEGATIVE_POLARITY)
+#define	CSPAN_MODE	(_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK)
+
+/* Bit i of the result is set if p[i] ends the span. */
+#define	SPAN_END_FIRST(set, setlen, p, mode, zero) \
+	((unsigned int)_mm_cvtsi128_si32(_mm_cmpestrm(set, setlen, \
+	    _mm_load_si128((const __m128i *)(p)), 16, mode)) | \
+	    (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8( \
+	    _mm_load_si128((const __m128i *)(p)), zero)))
+#define	SPAN_END(set, p, mode, zero) \
+	((unsigned int)_mm_cvtsi128_si32(_mm_cmpistrm(set, \
+	    _mm_load_si128((const __m128i *)(p)), mode)) | \
+	    (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8( \
+	    _mm_load_si128((const __m128i *)(p)), zero)))
+
+SSE42 size_t
+__strspn_sse42(const char *s, const char *accept)
+{
+	const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+	size_t setlen = strlen(accept);
+	__m128i zero = _mm_setzero_si128();
+	__m128i set;
+	unsigned int mask;
+
+	if (setlen == 0)
+		return (0);
+	if (setlen > 16)
+		return (__strspn_generic(s, accept));
+	set = load_set(accept, setlen);
+
+	mask = SPAN_END_FIRST(set, setlen, p, SPAN_MODE, zero) >> (s - p);
+	if (mask != 0)
+		return (__builtin_ctz(mask));
+	for (;;) {
+		p += 16;
+		mask = SPAN_END(set, p, SPAN_MODE, zero);
+		if (mask != 0)
+			return (p + __builtin_ctz(mask) - s);
+	}
+}
+
+SSE42 size_t
+__strcspn_sse42(const char *s, const char *reject)
+{
+	const char *p = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+	size_t setlen = strlen(reject);
+	__m128i zero = _mm_setzero_si128();
+	__m128i set;
+	unsigned int mask;
+
+	if (setlen == 0)
+		return (strlen(s));
+	if (setlen > 16)
+		return (__strcspn_generic(s, reject));
+	set = load_set(reject, setlen);
+
+	mask = SPAN_END_FIRST(set, setlen, p, CSPAN_MODE, zero) >> (s - p);
+	if (mask != 0)
+		return (__builtin_ctz(mask));
+	for (;;) {
+		p += 16;
+		mask = SPAN_END(set, p, CSPAN_MODE, zero);
+		if (mask != 0)
+			return (p + __builtin_ctz(mask) - s);
+	}
+}
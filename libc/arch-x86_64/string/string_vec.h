@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * memchr, memrchr, strchr, strrchr, strnlen and (if VEC_STRLEN is defined)
+ * strlen, written once for any vector width. The including file defines
+ * FUNC(name) to name the functions, VEC_SIZE, vec_t, VEC_TARGET and the
+ * vec_* operations.
+ *
+ * All loads are aligned to VEC_SIZE, so they never cross into a page the
+ * string doesn't touch; bytes outside the string are masked off.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VEC_ALIGN(p) \
+    ((const char *)((uintptr_t)(p) & ~(uintptr_t)(VEC_SIZE - 1)))
+
+/* The mask of the low n bits, for n in [0, VEC_SIZE]. */
+static inline unsigned int
+low_bits(size_t n)
+{
+	return (n >= 32) ? ~0U : (1U << n) - 1;
+}
+
+static inline unsigned int
+high_bit(unsigned int mask)
+{
+	return 31 - __builtin_clz(mask);
+}
+
+VEC_TARGET static inline unsigned int
+match(const char *p, vec_t c)
+{
+	return vec_movemask(vec_cmpeq(vec_load(p), c));
+}
+
+VEC_TARGET void *
+FUNC(memchr)(const void *s, int ch, size_t n)
+{
+	const char *p = VEC_ALIGN(s);
+	size_t off = (const char *)s - p;
+	vec_t c = vec_set1((char)ch);
+	unsigned int mask;
+
+	if (n == 0)
+		return (NULL);
+	mask = match(p, c) >> off;
+	if (mask != 0) {
+		off = __builtin_ctz(mask);
+		return (off < n ? (char *)s + off : NULL);
+	}
+	if (n <= VEC_SIZE - off)
+		return (NULL);
+	n -= VEC_SIZE - off;
+	p += VEC_SIZE;
+
+	/*
+	 * strnlen passes SIZE_MAX, so don't look past a 4 * VEC_SIZE boundary
+	 * four vectors at a time until we know there's no match before it.
+	 */
+	for (;;) {
+		mask = match(p, c);
+		if (mask != 0) {
+			off = __builtin_ctz(mask);
+			return (off < n ? (char *)p + off : NULL);
+		}
+		if (n <= VEC_SIZE)
+			return (NULL);
+		n -= VEC_SIZE;
+		p += VEC_SIZE;
+
+		if (((uintptr_t)p & (4 * VEC_SIZE - 1)) != 0)
+			continue;
+		/* On a match, go back to single vectors to find it. */
+		while (n > 4 * VEC_SIZE) {
+			vec_t m0 = vec_cmpeq(vec_load(p), c);
+			vec_t m1 = vec_cmpeq(vec_load(p + VEC_SIZE), c);
+			vec_t m2 = vec_cmpeq(vec_load(p + 2 * VEC_SIZE), c);
+			vec_t m3 = vec_cmpeq(vec_load(p + 3 * VEC_SIZE), c);
+			if (vec_movemask(vec_or(vec_or(m0, m1),
+			    vec_or(m2, m3))) != 0)
+				break;
+			n -= 4 * VEC_SIZE;
+			p += 4 * VEC_SIZE;
+		}
+	}
+}
+
+VEC_TARGET void *
+FUNC(memrchr)(const void *s, int ch, size_t n)
+{
+	const char *end = (const char *)s + n;
+	const char *p;
+	vec_t c = vec_set1((char)ch);
+	unsigned int mask;
+
+	if (n == 0)
+		return (NULL);
+	p = VEC_ALIGN(end - 1);
+	mask = match(p, c) & low_bits(end - p);
+	for (;;) {
+		if (p <= (const char *)s) {
+			mask &= ~low_bits((const char *)s - p);
+			return (mask != 0 ? (char *)p + high_bit(mask) : NULL);
+		}
+		if (mask != 0)
+			return ((char *)p + high_bit(mask));
+		p -= VEC_SIZE;
+		mask = match(p, c);
+	}
+}
+
+VEC_TARGET char *
+FUNC(strchr)(const char *s, int ch)
+{
+	const char *p = VEC_ALIGN(s);
+	vec_t c = vec_set1((char)ch);
+	vec_t zero = vec_zero();
+	unsigned int mask;
+	vec_t v;
+
+	v = vec_load(p);
+	mask = vec_movemask(vec_or(vec_cmpeq(v, c), vec_cmpeq(v, zero)));
+	mask >>= s - p;
+	if (mask != 0) {
+		p = s + __builtin_ctz(mask);
+		return (*p == (char)ch ? (char *)p : NULL);
+	}
+	for (;;) {
+		p += VEC_SIZE;
+		v = vec_load(p);
+		mask = vec_movemask(vec_or(vec_cmpeq(v, c), vec_cmpeq(v, zero)));
+		if (mask != 0) {
+			p += __builtin_ctz(mask);
+			return (*p == (char)ch ? (char *)p : NULL);
+		}
+	}
+}
+
+VEC_TARGET char *
+FUNC(strrchr)(const char *s, int ch)
+{
+	const char *p = VEC_ALIGN(s);
+	const char *base = s;
+	const char *last = NULL;
+	vec_t c = vec_set1((char)ch);
+	vec_t zero = vec_zero();
+	unsigned int cmask, zmask;
+	size_t off = s - p;
+	vec_t v;
+
+	/* Bits are relative to base, which is s for the first vector. */
+	v = vec_load(p);
+	cmask = vec_movemask(vec_cmpeq(v, c)) >> off;
+	zmask = vec_movemask(vec_cmpeq(v, zero)) >> off;
+	for (;;) {
+		if (zmask != 0) {
+			/* Keep matches up to and including the terminator. */
+			cmask &= zmask ^ (zmask - 1);
+			if (cmask != 0)
+				last = base + high_bit(cmask);
+			return ((char *)last);
+		}
+		if (cmask != 0)
+			last = base + high_bit(cmask);
+		p += VEC_SIZE;
+		base = p;
+		v = vec_load(p);
+		cmask = vec_movemask(vec_cmpeq(v, c));
+		zmask = vec_movemask(vec_cmpeq(v, zero));
+	}
+}
+
+#ifdef VEC_STRLEN
+VEC_TARGET size_t
+FUNC(strlen)(const char *s)
+{
+	const char *p = VEC_ALIGN(s);
+	vec_t zero = vec_zero();
+	unsigned int mask;
+
+	mask = match(p, zero) >> (s - p);
+	if (mask != 0)
+		return (__builtin_ctz(mask));
+
+	/* Single vectors up to a 4 * VEC_SIZE boundary, then four at a time. */
+	for (;;) {
+		p += VEC_SIZE;
+		if (((uintptr_t)p & (4 * VEC_SIZE - 1)) == 0)
+			break;
+		mask = match(p, zero);
+		if (mask != 0)
+			return (p + __builtin_ctz(mask) - s);
+	}
+	for (;; p += 4 * VEC_SIZE) {
+		vec_t v0 = vec_load(p);
+		vec_t v1 = vec_load(p + VEC_SIZE);
+		vec_t v2 = vec_load(p + 2 * VEC_SIZE);
+		vec_t v3 = vec_load(p + 3 * VEC_SIZE);
+		vec_t min = vec_min(vec_min(v0, v1), vec_min(v2, v3));
+		if (vec_movemask(vec_cmpeq(min, zero)) != 0)
+			break;
+	}
+	for (;; p += VEC_SIZE) {
+		mask = match(p, zero);
+		if (mask != 0)
+			return (p + __builtin_ctz(mask) - s);
+	}
+}
+#endif
+
+VEC_TARGET size_t
+FUNC(strnlen)(const char *s, size_t maxlen)
+{
+	const char *p = FUNC(memchr)(s, '\0', maxlen);
+
+	return (p != NULL ? (size_t)(p - s) : maxlen);
+}
@@ -9,11 +9,6 @@ libc_bionic_src_files_x86_64 += \
     bionic/__memset_chk.cpp \
     bionic/__strcpy_chk.cpp \
     bionic/__strcat_chk.cpp \
-    bionic/memchr.c \
-    bionic/memrchr.c \
-    bionic/strchr.cpp \
-    bionic/strnlen.c \
-    bionic/strrchr.cpp \
 
 libc_darwin_src_files_x86_64 += \
     upstream-darwin/lib/libc/string/strlcat.c \
@@ -21,20 +16,19 @@ libc_darwin_src_files_x86_64 += \
 
 libc_freebsd_src_files_x86_64 += \
     upstream-freebsd/lib/libc/string/wcscat.c \
-    upstream-freebsd/lib/libc/string/wcschr.c \
-    upstream-freebsd/lib/libc/string/wcscmp.c \
-    upstream-freebsd/lib/libc/string/wcscpy.c \
-    upstream-freebsd/lib/libc/string/wcslen.c \
     upstream-freebsd/lib/libc/string/wcsrchr.c \
-    upstream-freebsd/lib/libc/string/wmemcmp.c \
     upstream-freebsd/lib/libc/string/wmemmove.c \
 
+libc_openbsd_src_files_x86_64 += \
+    upstream-openbsd/lib/libc/string/strpbrk.c \
+
 #
 # Inherently architecture-specific code.
 #
 
 libc_bionic_src_files_x86_64 += \
     arch-x86_64/bionic/__bionic_clone.S \
+    arch-x86_64/bionic/cache_info.cpp \
     arch-x86_64/bionic/_exit_with_stack_teardown.S \
     arch-x86_64/bionic/__restore_rt.S \
     arch-x86_64/bionic/_setjmp.S \
@@ -56,13 +50,38 @@ libc_bionic_src_files_x86_64 += \
     arch-x86_64/string/sse2-stpncpy-slm.S \
     arch-x86_64/string/sse2-strcat-slm.S \
     arch-x86_64/string/sse2-strcpy-slm.S \
-    arch-x86_64/string/sse2-strlen-slm.S \
     arch-x86_64/string/sse2-strncat-slm.S \
     arch-x86_64/string/sse2-strncpy-slm.S \
     arch-x86_64/string/sse4-memcmp-slm.S \
     arch-x86_64/string/ssse3-strcmp-slm.S \
     arch-x86_64/string/ssse3-strncmp-slm.S \
 
+# libc.so chooses memchr, memrchr, strchr, strrchr, strlen, strnlen, strspn,
+# strcspn, strcasecmp, strncasecmp and the wide character wcslen, wcsnlen,
+# wcschr, wcscmp, wcsncmp, wmemchr, wmemcmp and wcscpy at run time by CPUID
+# (see arch-x86_64/dynamic_function_dispatch.cpp). libc.a and the dynamic
+# linker use the SSE2 and generic versions.
+libc_arch_static_src_files_x86_64 += \
+    arch-x86_64/string/sse2-strcasecmp.c \
+    arch-x86_64/string/sse2-string.c \
+    arch-x86_64/string/sse2-strlen-slm.S \
+    arch-x86_64/string/sse2-wcs.c \
+    upstream-openbsd/lib/libc/string/strcspn.c \
+    upstream-openbsd/lib/libc/string/strspn.c \
+
+libc_arch_dynamic_src_files_x86_64 += \
+    arch-x86_64/dynamic_function_dispatch.cpp \
+    arch-x86_64/dispatch/sse2-strcasecmp.c \
+    arch-x86_64/dispatch/sse2-string.c \
+    arch-x86_64/dispatch/sse2-strlen-slm.S \
+    arch-x86_64/dispatch/sse2-wcs.c \
+    arch-x86_64/dispatch/strcspn_generic.c \
+    arch-x86_64/dispatch/strspn_generic.c \
+    arch-x86_64/string/avx2-strcasecmp.c \
+    arch-x86_64/string/avx2-string.c \
+    arch-x86_64/string/avx2-wcs.c \
+    arch-x86_64/string/sse4_2-strspn.c \
+
 libc_crt_target_cflags_x86_64 += \
     -m64 \
     -I$(LOCAL_PATH)/arch-x86_64/include \
@@ -47,6 +47,10 @@ static void netdClientInitImpl() {
     netdClientInitFunction(netdClientHandle, "netdClientInitNetIdForResolv",
                            &__netdClientDispatch.netIdForResolv);
     netdClientInitFunction(netdClientHandle, "netdClientInitSocket", &__netdClientDispatch.socket);
+    netdClientInitFunction(netdClientHandle, "netdClientInitSendmmsg",
+                           &__netdClientDispatch.sendmmsg);
+    netdClientInitFunction(netdClientHandle, "netdClientInitRecvmmsg",
+                           &__netdClientDispatch.recvmmsg);
 }
 
 static pthread_once_t netdClientInitOnce = PTHREAD_ONCE_INIT;
@@ -25,6 +25,8 @@
 extern "C" __socketcall int __accept4(int, sockaddr*, socklen_t*, int);
 extern "C" __socketcall int __connect(int, const sockaddr*, socklen_t);
 extern "C" __socketcall int __socket(int, int, int);
+extern "C" __socketcall int __sendmmsg(int, const mmsghdr*, unsigned int, int);
+extern "C" __socketcall int __recvmmsg(int, mmsghdr*, unsigned int, int, const timespec*);
 
 static unsigned fallBackNetIdForResolv(unsigned netId) {
     return netId;
@@ -36,5 +38,7 @@ __LIBC_HIDDEN__ NetdClientDispatch __netdClientDispatch __attribute__((aligned(3
     __accept4,
     __connect,
     __socket,
+    __sendmmsg,
+    __recvmmsg,
     fallBackNetIdForResolv,
 };
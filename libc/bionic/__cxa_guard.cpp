@@ -14,10 +14,11 @@
  * limitations under the License.
  */
 
-#include <stddef.h>
 #include <endian.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stddef.h>
 
-#include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 
 // This file contains C++ ABI support functions for one time
@@ -49,7 +50,7 @@
 // values. The LSB is tested by the compiler-generated code before calling
 // __cxa_guard_acquire.
 union _guard_t {
-    int volatile state;
+    atomic_int state;
     int32_t aligner;
 };
 
@@ -62,7 +63,7 @@ const static int waiting = 0x6;
 // guard variables are 64-bit aligned, 64-bit values. The LSB is tested by
 // the compiler-generated code before calling __cxa_guard_acquire.
 union _guard_t {
-    int volatile state;
+    atomic_int state;
     int64_t aligner;
 };
 
@@ -71,44 +72,61 @@ const static int pending   = letoh32(0x100);
 const static int waiting   = letoh32(0x10000);
 #endif
 
+// Guard variables are never shared between processes, so the futex
+// operations are all private. Only a constructor that somebody else is
+// waiting on (the "waiting" state) costs a wake syscall.
+
 extern "C" int __cxa_guard_acquire(_guard_t* gv) {
     // 0 -> pending, return 1
-    // pending -> waiting, wait and return 0
-    // waiting: untouched, wait and return 0
+    // pending -> waiting, wait and try again
+    // waiting: untouched, wait and try again
     // ready: untouched, return 0
+    int old_value = atomic_load_explicit(&gv->state, memory_order_acquire);
 
-retry:
-    if (__bionic_cmpxchg(0, pending, &gv->state) == 0) {
-        ANDROID_MEMBAR_FULL();
-        return 1;
-    }
-    __bionic_cmpxchg(pending, waiting, &gv->state); // Indicate there is a waiter
-    __futex_wait(&gv->state, waiting, NULL);
+    while (true) {
+        if (old_value == ready) {
+            return 0;
+        }
 
-    if (gv->state != ready) {
-        // __cxa_guard_abort was called, let every thread try since there is no return code for this condition
-        goto retry;
-    }
+        if (old_value == 0) {
+            if (!atomic_compare_exchange_weak_explicit(&gv->state, &old_value, pending,
+                                                       memory_order_acquire,
+                                                       memory_order_acquire)) {
+                continue;
+            }
+            return 1;
+        }
 
-    ANDROID_MEMBAR_FULL();
-    return 0;
+        if (old_value == pending) {
+            // Indicate there is a waiter.
+            if (!atomic_compare_exchange_weak_explicit(&gv->state, &old_value, waiting,
+                                                       memory_order_acquire,
+                                                       memory_order_acquire)) {
+                continue;
+            }
+        }
+
+        // If __cxa_guard_abort was called, every thread gets to try again
+        // since there is no return code for this condition.
+        __futex_wait_ex(&gv->state, false, waiting, NULL);
+        old_value = atomic_load_explicit(&gv->state, memory_order_acquire);
+    }
 }
 
 extern "C" void __cxa_guard_release(_guard_t* gv) {
     // pending -> ready
     // waiting -> ready, and wake
-
-    ANDROID_MEMBAR_FULL();
-    if (__bionic_cmpxchg(pending, ready, &gv->state) == 0) {
-        return;
+    int old_value = atomic_exchange_explicit(&gv->state, ready, memory_order_release);
+    if (old_value == waiting) {
+        __futex_wake_ex(&gv->state, false, INT_MAX);
     }
-
-    gv->state = ready;
-    __futex_wake(&gv->state, 0x7fffffff);
 }
 
 extern "C" void __cxa_guard_abort(_guard_t* gv) {
-    ANDROID_MEMBAR_FULL();
-    gv->state= 0;
-    __futex_wake(&gv->state, 0x7fffffff);
+    // pending -> 0
+    // waiting -> 0, and wake
+    int old_value = atomic_exchange_explicit(&gv->state, 0, memory_order_release);
+    if (old_value == waiting) {
+        __futex_wake_ex(&gv->state, false, INT_MAX);
+    }
 }
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 1996, David Mazieres <dm@uun.org>
+ * Copyright (c) 2008, Damien Miller <djm@openbsd.org>
+ * Copyright (c) 2013, Markus Friedl <markus@openbsd.org>
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * OpenBSD's ChaCha based arc4random, with the generator state kept per
+ * thread so that threads don't serialize on a single lock. Each thread's
+ * state is seeded by getentropy (getrandom(2) where the kernel has it) the
+ * first time the thread asks for random data, and is wiped and reseeded
+ * in fork children (which a pthread_atfork handler tells us about, with a
+ * change of pid as a backstop). If a thread's state can't be allocated, the thread
+ * falls back to a shared state under the arc4random lock.
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "private/thread_private.h"
+
+/* The upstream ChaCha code doesn't build cleanly with our warnings. */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#define KEYSTREAM_ONLY
+#include "upstream-openbsd/lib/libc/crypt/chacha_private.h"
+#pragma GCC diagnostic pop
+
+/* From getentropy_linux.c; no header mentions it. */
+__LIBC_HIDDEN__ extern int getentropy(void*, size_t);
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+#define KEYSZ	32
+#define IVSZ	8
+#define BLOCKSZ	64
+#define RSBUFSZ	(16*BLOCKSZ)
+
+/* How many bytes a state hands out before it's reseeded. */
+#define RSCOUNT	1600000
+
+struct arc4_state {
+	pid_t		pid;		/* process that seeded it, 0 if never */
+	unsigned	forks;		/* g_arc4_forks when it was seeded */
+	size_t		have;		/* valid bytes at end of buf */
+	size_t		count;		/* bytes till reseed */
+	chacha_ctx	chacha;		/* chacha context for random keystream */
+	u_char		buf[RSBUFSZ];	/* keystream blocks */
+};
+
+static pthread_once_t g_arc4_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_arc4_key;
+static int g_arc4_key_valid;
+
+/* Used under _ARC4_LOCK by threads that can't have their own state. */
+static struct arc4_state g_arc4_shared;
+
+/* Incremented in every fork child. */
+static volatile unsigned g_arc4_forks;
+static int g_arc4_fork_handler_registered;
+
+static void
+_arc4_fork_child(void)
+{
+	g_arc4_forks++;
+}
+
+/*
+ * Not with pthread_once: pthread_atfork allocates, and an allocator that
+ * calls arc4random would deadlock on the once. A thread that gets here
+ * before the handler is in place still has the pid check.
+ */
+static void
+_arc4_register_fork_handler(void)
+{
+	if (g_arc4_fork_handler_registered ||
+	    !__sync_bool_compare_and_swap(&g_arc4_fork_handler_registered, 0, 1))
+		return;
+	if (pthread_atfork(NULL, NULL, _arc4_fork_child) != 0)
+		g_arc4_fork_handler_registered = 0;
+}
+
+static void
+_arc4_state_destroy(void *arg)
+{
+	struct arc4_state *st = arg;
+
+	memset(st, 0, sizeof(*st));
+	munmap(st, sizeof(*st));
+}
+
+static void
+_arc4_key_create(void)
+{
+	g_arc4_key_valid =
+	    (pthread_key_create(&g_arc4_key, _arc4_state_destroy) == 0);
+}
+
+/* Returns the calling thread's state, or NULL to use the shared one. */
+static struct arc4_state *
+_arc4_thread_state(void)
+{
+	struct arc4_state *st;
+
+	_arc4_register_fork_handler();
+	pthread_once(&g_arc4_once, _arc4_key_create);
+	if (!g_arc4_key_valid)
+		return NULL;
+
+	st = pthread_getspecific(g_arc4_key);
+	if (st != NULL)
+		return st;
+
+	/* mmap rather than malloc: malloc implementations call arc4random. */
+	st = mmap(NULL, sizeof(*st), PROT_READ|PROT_WRITE,
+	    MAP_ANON|MAP_PRIVATE, -1, 0);
+	if (st == MAP_FAILED)
+		return NULL;
+	if (pthread_setspecific(g_arc4_key, st) != 0) {
+		munmap(st, sizeof(*st));
+		return NULL;
+	}
+	return st;
+}
+
+static void
+_rs_init(struct arc4_state *st, u_char *buf, size_t n)
+{
+	if (n < KEYSZ + IVSZ)
+		return;
+
+	chacha_keysetup(&st->chacha, buf, KEYSZ * 8, 0);
+	chacha_ivsetup(&st->chacha, buf + KEYSZ);
+}
+
+static void
+_rs_rekey(struct arc4_state *st, u_char *dat, size_t datlen)
+{
+	/* fill buf with the keystream */
+	chacha_encrypt_bytes(&st->chacha, st->buf, st->buf, sizeof(st->buf));
+	/* mix in optional user provided data */
+	if (dat) {
+		size_t i, m;
+
+		m = min(datlen, KEYSZ + IVSZ);
+		for (i = 0; i < m; i++)
+			st->buf[i] ^= dat[i];
+	}
+	/* immediately reinit for backtracking resistance */
+	_rs_init(st, st->buf, KEYSZ + IVSZ);
+	memset(st->buf, 0, KEYSZ + IVSZ);
+	st->have = sizeof(st->buf) - KEYSZ - IVSZ;
+}
+
+static void
+_rs_stir(struct arc4_state *st)
+{
+	u_char rnd[KEYSZ + IVSZ];
+
+	if (getentropy(rnd, sizeof(rnd)) == -1)
+		raise(SIGKILL);
+
+	if (st->pid == 0)
+		_rs_init(st, rnd, sizeof(rnd));
+	else
+		_rs_rekey(st, rnd, sizeof(rnd));
+	memset(rnd, 0, sizeof(rnd));	/* discard source seed */
+
+	/* invalidate buf */
+	st->have = 0;
+	memset(st->buf, 0, sizeof(st->buf));
+
+	st->count = RSCOUNT;
+}
+
+static void
+_rs_stir_if_needed(struct arc4_state *st, size_t len)
+{
+	pid_t pid = getpid();
+	unsigned forks = g_arc4_forks;
+
+	/*
+	 * A fork child inherits its parent's state, and mustn't repeat the
+	 * parent's output: forget everything and start over. The pid alone
+	 * isn't enough, since a descendant can be given a pid that was used
+	 * before.
+	 */
+	if (st->forks != forks || st->pid != pid) {
+		memset(st, 0, sizeof(*st));
+		_rs_stir(st);
+		st->pid = pid;
+		st->forks = forks;
+	} else if (st->count <= len) {
+		_rs_stir(st);
+	}
+	if (st->count <= len)
+		st->count = 0;
+	else
+		st->count -= len;
+}
+
+static void
+_rs_random_buf(struct arc4_state *st, void *_buf, size_t n)
+{
+	u_char *buf = (u_char *)_buf;
+	u_char *keystream;
+	size_t m;
+
+	_rs_stir_if_needed(st, n);
+	while (n > 0) {
+		if (st->have > 0) {
+			m = min(n, st->have);
+			keystream = st->buf + sizeof(st->buf) - st->have;
+			memcpy(buf, keystream, m);
+			memset(keystream, 0, m);
+			buf += m;
+			n -= m;
+			st->have -= m;
+		}
+		if (st->have == 0)
+			_rs_rekey(st, NULL, 0);
+	}
+}
+
+static void
+_rs_random_u32(struct arc4_state *st, uint32_t *val)
+{
+	u_char *keystream;
+
+	_rs_stir_if_needed(st, sizeof(*val));
+	if (st->have < sizeof(*val))
+		_rs_rekey(st, NULL, 0);
+	keystream = st->buf + sizeof(st->buf) - st->have;
+	memcpy(val, keystream, sizeof(*val));
+	memset(keystream, 0, sizeof(*val));
+	st->have -= sizeof(*val);
+}
+
+uint32_t
+arc4random(void)
+{
+	struct arc4_state *st = _arc4_thread_state();
+	uint32_t val;
+
+	if (st != NULL) {
+		_rs_random_u32(st, &val);
+		return val;
+	}
+	_ARC4_LOCK();
+	_rs_random_u32(&g_arc4_shared, &val);
+	_ARC4_UNLOCK();
+	return val;
+}
+
+void
+arc4random_buf(void *buf, size_t n)
+{
+	struct arc4_state *st = _arc4_thread_state();
+
+	if (st != NULL) {
+		_rs_random_buf(st, buf, n);
+		return;
+	}
+	_ARC4_LOCK();
+	_rs_random_buf(&g_arc4_shared, buf, n);
+	_ARC4_UNLOCK();
+}
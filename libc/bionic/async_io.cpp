@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/async_io.h>
+
+#include <errno.h>
+#include <time.h>
+
+extern "C" int __io_setup(unsigned, aio_context_t*);
+extern "C" int __io_destroy(aio_context_t);
+extern "C" int __io_submit(aio_context_t, long, iocb**);
+extern "C" int __io_getevents(aio_context_t, long, long, io_event*, timespec*);
+extern "C" int __io_cancel(aio_context_t, iocb*, io_event*);
+
+int android_aio_setup(unsigned max_events, aio_context_t* ctx) {
+  // The kernel insists on a zeroed context.
+  *ctx = 0;
+  return __io_setup(max_events, ctx);
+}
+
+int android_aio_destroy(aio_context_t ctx) {
+  return __io_destroy(ctx);
+}
+
+int android_aio_submit(aio_context_t ctx, iocb** iocbs, size_t count) {
+  // io_submit stops short at a request it can't submit without saying why,
+  // so carry on from there: either the kernel takes more this time, or it
+  // fails that request and sets errno.
+  size_t submitted = 0;
+  while (submitted < count) {
+    int rc = __io_submit(ctx, count - submitted, iocbs + submitted);
+    if (rc <= 0) {
+      break;
+    }
+    submitted += rc;
+  }
+  return (submitted > 0 || count == 0) ? static_cast<int>(submitted) : -1;
+}
+
+int android_aio_getevents(aio_context_t ctx, size_t min_events, size_t max_events,
+                          io_event* events, const timespec* timeout) {
+  // The kernel doesn't write to the timeout.
+  return __io_getevents(ctx, min_events, max_events, events, const_cast<timespec*>(timeout));
+}
+
+int android_aio_cancel(aio_context_t ctx, iocb* iocb, io_event* result) {
+  return __io_cancel(ctx, iocb, result);
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2002 Daniel Hartmeier
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *    - Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    - Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "private/bionic_macros.h"
+#include "private/libc_logging.h"
+#include "private/thread_private.h"
+
+// Handlers registered with __cxa_atexit are kept in one array, oldest first,
+// which exit runs backwards. Every shared object that dlclose might unload
+// registers its handlers with its own __dso_handle, so the handlers for each
+// handle are also chained together, newest first, from a hash table of the
+// handles: __cxa_finalize for one library only visits that library's
+// handlers rather than everybody's. The slots of handlers that have been run
+// are reclaimed once they're the majority.
+//
+// As in OpenBSD, the first slot is reserved for stdio's cleanup function so
+// that it's run last, and outside these functions the array is mprotected
+// read-only to guard it against stray writes, a page at a time. The table
+// isn't, to save the system calls: it only holds indexes into the array, and
+// each handler found through it is checked against the array.
+
+extern "C" int __cxa_atexit(void (*)(void*), void*, void*);
+extern "C" void __cxa_finalize(void*);
+extern "C" void __atexit_register_cleanup(void (*)(void));
+
+struct AtexitEntry {
+  void (*fn)(void*);
+  void* arg;
+  void* dso;
+  size_t older; // The previous handler for the same dso, or 0 for none.
+};
+
+struct DsoSlot {
+  void* dso;
+  size_t newest; // The newest handler for dso.
+};
+
+// Marks a table slot whose dso has been finalized. Real handles are the
+// addresses of pointers, so they're never odd.
+static void* const kDeletedDso = reinterpret_cast<void*>(1);
+
+// Don't bother reclaiming slots until there are at least this many to reclaim.
+static const size_t kMinReclaimCount = 64;
+
+static AtexitEntry* g_entries;
+static size_t g_entries_mapped_size;
+static size_t g_entry_capacity;
+static size_t g_entry_count;
+static size_t g_called_count;
+
+static DsoSlot* g_dsos;
+static size_t g_dsos_mapped_size;
+static size_t g_dso_mask;
+static size_t g_dso_count; // Including deleted slots.
+
+static unsigned g_registration_count;
+static int g_call_depth;
+
+static void* map(size_t size) {
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+  return (p == MAP_FAILED) ? NULL : p;
+}
+
+// Changes the protection of just the pages holding [p, p + size), so that
+// the cost of a write doesn't grow with the number of handlers.
+static bool set_writable(void* p, size_t size, bool writable) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(PAGE_SIZE - 1);
+  uintptr_t end = BIONIC_ALIGN(reinterpret_cast<uintptr_t>(p) + size, PAGE_SIZE);
+  int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  return mprotect(reinterpret_cast<void*>(start), end - start, prot) == 0;
+}
+
+static size_t hash_dso(void* dso) {
+  uintptr_t h = reinterpret_cast<uintptr_t>(dso) >> 3;
+  return h ^ (h >> 7) ^ (h >> 17);
+}
+
+// Returns dso's table slot, or the slot it would go in. Called with the
+// table allocated.
+static DsoSlot* find_dso_slot(void* dso) {
+  DsoSlot* deleted = NULL;
+  for (size_t i = hash_dso(dso);; ++i) {
+    DsoSlot* slot = &g_dsos[i & g_dso_mask];
+    if (slot->dso == dso) {
+      return slot;
+    }
+    if (slot->dso == NULL) {
+      return (deleted != NULL) ? deleted : slot;
+    }
+    if (slot->dso == kDeletedDso && deleted == NULL) {
+      deleted = slot;
+    }
+  }
+}
+
+static DsoSlot* find_dso(void* dso) {
+  if (g_dsos == NULL) {
+    return NULL;
+  }
+  DsoSlot* slot = find_dso_slot(dso);
+  return (slot->dso == dso) ? slot : NULL;
+}
+
+// Chains the handler in slot 'i' onto the newest one for its dso, in 'slot'.
+// Called with the handler writable.
+static void link_entry(size_t i, DsoSlot* slot) {
+  AtexitEntry* entry = &g_entries[i];
+  if (slot->dso != entry->dso) {
+    if (slot->dso == NULL) {
+      ++g_dso_count;
+    }
+    slot->dso = entry->dso;
+    slot->newest = 0;
+  }
+  entry->older = slot->newest;
+  slot->newest = i;
+}
+
+// Relinks every handler that hasn't been run into a new table big enough for
+// all their dsos plus one more, dropping deleted slots.
+static bool rebuild_dsos() {
+  size_t live_count = 1;
+  for (size_t i = 0; g_dsos != NULL && i <= g_dso_mask; ++i) {
+    if (g_dsos[i].dso != NULL && g_dsos[i].dso != kDeletedDso) {
+      ++live_count;
+    }
+  }
+  // Keep the table at most half full.
+  size_t slot_count = 16;
+  while (slot_count < 2 * live_count) {
+    slot_count *= 2;
+  }
+  size_t mapped_size = BIONIC_ALIGN(slot_count * sizeof(DsoSlot), PAGE_SIZE);
+  DsoSlot* dsos = reinterpret_cast<DsoSlot*>(map(mapped_size));
+  if (dsos == NULL) {
+    return false;
+  }
+  size_t entries_size = g_entry_count * sizeof(AtexitEntry);
+  if (!set_writable(g_entries, entries_size, true)) {
+    munmap(dsos, mapped_size);
+    return false;
+  }
+  if (g_dsos != NULL) {
+    munmap(g_dsos, g_dsos_mapped_size);
+  }
+  g_dsos = dsos;
+  g_dsos_mapped_size = mapped_size;
+  g_dso_mask = mapped_size / sizeof(DsoSlot) - 1;
+  g_dso_count = 0;
+
+  // Relinking oldest first leaves every chain in the same order.
+  for (size_t i = 1; i < g_entry_count; ++i) {
+    if (g_entries[i].fn != NULL && g_entries[i].dso != NULL) {
+      link_entry(i, find_dso_slot(g_entries[i].dso));
+    }
+  }
+  set_writable(g_entries, entries_size, false);
+  return true;
+}
+
+// Makes room for one more handler.
+static bool reserve_entry() {
+  if (g_entry_count < g_entry_capacity) {
+    return true;
+  }
+  size_t mapped_size = (g_entries == NULL) ? PAGE_SIZE : 2 * g_entries_mapped_size;
+  AtexitEntry* entries = reinterpret_cast<AtexitEntry*>(map(mapped_size));
+  if (entries == NULL) {
+    return false;
+  }
+  if (g_entries != NULL) {
+    memcpy(entries, g_entries, g_entry_count * sizeof(AtexitEntry));
+    munmap(g_entries, g_entries_mapped_size);
+  } else {
+    // Slot 0 is the cleanup function's.
+    g_entry_count = 1;
+  }
+  g_entries = entries;
+  g_entries_mapped_size = mapped_size;
+  g_entry_capacity = mapped_size / sizeof(AtexitEntry);
+  set_writable(g_entries, g_entries_mapped_size, false);
+  return true;
+}
+
+// Squeezes out the slots of handlers that have been run once they're the
+// majority. Only called when nobody's walking the array.
+static void reclaim_entries() {
+  if (g_called_count < kMinReclaimCount || 2 * g_called_count < g_entry_count) {
+    return;
+  }
+  size_t entries_size = g_entry_count * sizeof(AtexitEntry);
+  if (!set_writable(g_entries, entries_size, true)) {
+    return;
+  }
+  size_t count = 1;
+  for (size_t i = 1; i < g_entry_count; ++i) {
+    if (g_entries[i].fn != NULL) {
+      g_entries[count++] = g_entries[i];
+    }
+  }
+  g_entry_count = count;
+  g_called_count = 0;
+  set_writable(g_entries, entries_size, false);
+
+  if (g_dsos != NULL && !rebuild_dsos()) {
+    // Keep the old table but clear it: it has room for everything.
+    if (set_writable(g_entries, entries_size, true)) {
+      memset(g_dsos, 0, g_dsos_mapped_size);
+      g_dso_count = 0;
+      for (size_t i = 1; i < g_entry_count; ++i) {
+        if (g_entries[i].dso != NULL) {
+          link_entry(i, find_dso_slot(g_entries[i].dso));
+        }
+      }
+    }
+    set_writable(g_entries, entries_size, false);
+  }
+}
+
+static void release_all() {
+  if (g_entries != NULL) {
+    munmap(g_entries, g_entries_mapped_size);
+  }
+  if (g_dsos != NULL) {
+    munmap(g_dsos, g_dsos_mapped_size);
+  }
+  g_entries = NULL;
+  g_entries_mapped_size = g_entry_capacity = g_entry_count = g_called_count = 0;
+  g_dsos = NULL;
+  g_dsos_mapped_size = g_dso_mask = g_dso_count = 0;
+}
+
+/*
+ * Register a function to be performed at exit or when a shared object
+ * with the given dso handle is unloaded dynamically.  Also used as
+ * the backend for atexit().  For more info on this API, see:
+ *
+ *	http://www.codesourcery.com/cxx-abi/abi.html#dso-dtor
+ */
+int __cxa_atexit(void (*func)(void*), void* arg, void* dso) {
+  int result = -1;
+  _ATEXIT_LOCK();
+  // Keep the table at most half full, counting deleted slots.
+  if (!reserve_entry() ||
+      (dso != NULL && (g_dsos == NULL || 2 * (g_dso_count + 1) > g_dso_mask + 1) &&
+       !rebuild_dsos())) {
+    _ATEXIT_UNLOCK();
+    return -1;
+  }
+
+  size_t i = g_entry_count;
+  AtexitEntry* entry = &g_entries[i];
+  if (set_writable(entry, sizeof(*entry), true)) {
+    entry->fn = func;
+    entry->arg = arg;
+    entry->dso = dso;
+    entry->older = 0;
+    if (dso != NULL) {
+      link_entry(i, find_dso_slot(dso));
+    }
+    ++g_entry_count;
+    ++g_registration_count;
+    result = 0;
+    set_writable(entry, sizeof(*entry), false);
+  }
+  _ATEXIT_UNLOCK();
+  return result;
+}
+
+// Takes the handler in slot 'i' so that it's only ever run once. Returns
+// false if it's already been run.
+static bool take_entry(size_t i, AtexitEntry* entry) {
+  if (g_entries[i].fn == NULL) {
+    return false;
+  }
+  *entry = g_entries[i];
+  if (set_writable(&g_entries[i], sizeof(AtexitEntry), true)) {
+    g_entries[i].fn = NULL;
+    ++g_called_count;
+    set_writable(&g_entries[i], sizeof(AtexitEntry), false);
+  }
+  return true;
+}
+
+// Runs the handlers registered for 'dso', newest first, including any they
+// register for it themselves.
+static void finalize_dso(void* dso) {
+  DsoSlot* slot;
+  while ((slot = find_dso(dso)) != NULL) {
+    // Unchain the newest. Handlers that exit has already run are just skipped.
+    size_t i = slot->newest;
+    if (i == 0 || i >= g_entry_count || g_entries[i].dso != dso) {
+      __libc_fatal("__cxa_finalize: corrupt handler table for %p", dso);
+    }
+    slot->newest = g_entries[i].older;
+    if (slot->newest == 0) {
+      slot->dso = kDeletedDso;
+    }
+
+    AtexitEntry entry;
+    if (take_entry(i, &entry)) {
+      _ATEXIT_UNLOCK();
+      (*entry.fn)(entry.arg);
+      _ATEXIT_LOCK();
+    }
+  }
+}
+
+// Runs every handler that's left, newest first, starting again from the
+// newest whenever a handler registers another.
+static void finalize_all() {
+  size_t i = g_entry_count;
+  while (i-- > 0) {
+    AtexitEntry entry;
+    if (!take_entry(i, &entry)) {
+      continue;
+    }
+    unsigned registration_count = g_registration_count;
+    _ATEXIT_UNLOCK();
+    (*entry.fn)(entry.arg);
+    _ATEXIT_LOCK();
+    if (g_registration_count != registration_count) {
+      i = g_entry_count;
+    }
+  }
+}
+
+/*
+ * Call all handlers registered with __cxa_atexit() for the shared
+ * object owning 'dso'.
+ * Note: if 'dso' is NULL, then all remaining handlers are called.
+ */
+void __cxa_finalize(void* dso) {
+  _ATEXIT_LOCK();
+  ++g_call_depth;
+  if (dso != NULL) {
+    finalize_dso(dso);
+  } else {
+    finalize_all();
+  }
+  --g_call_depth;
+
+  if (g_call_depth == 0) {
+    if (dso == NULL) {
+      // Called via exit, so everything has been run.
+      release_all();
+    } else {
+      reclaim_entries();
+    }
+  }
+  _ATEXIT_UNLOCK();
+}
+
+/*
+ * Register the cleanup function
+ */
+void __atexit_register_cleanup(void (*func)(void)) {
+  _ATEXIT_LOCK();
+  if (reserve_entry() && set_writable(&g_entries[0], sizeof(AtexitEntry), true)) {
+    g_entries[0].fn = reinterpret_cast<void (*)(void*)>(func);
+    g_entries[0].arg = NULL;
+    g_entries[0].dso = NULL;
+    set_writable(&g_entries[0], sizeof(AtexitEntry), false);
+    ++g_registration_count;
+  }
+  _ATEXIT_UNLOCK();
+}
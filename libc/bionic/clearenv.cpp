@@ -29,7 +29,10 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+extern __LIBC_HIDDEN__ void __libc_environ_changed();
+
 int clearenv() {
+  __libc_environ_changed();
   char** e = environ;
   if (e != NULL) {
     for (; *e; ++e) {
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/copy_fd_range.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+
+// How much to move per system call. A pipe holds this much by default.
+static const size_t kChunkSize = 64 * 1024;
+
+// The pipe a thread splices through when neither end is a pipe. Data read
+// into it is always written out again before a copy returns, unless writing
+// fails, in which case the pipe is thrown away so that nobody writes stale
+// data out of it later.
+struct SplicePipe {
+  pid_t pid; // A forked child makes its own rather than share its parent's.
+  int fds[2];
+};
+
+static pthread_key_t g_splice_pipe_key;
+static pthread_once_t g_splice_pipe_once = PTHREAD_ONCE_INIT;
+
+static void SplicePipeDestroy(void* arg) {
+  SplicePipe* p = reinterpret_cast<SplicePipe*>(arg);
+  close(p->fds[0]);
+  close(p->fds[1]);
+  free(p);
+}
+
+static void SplicePipeKeyInit() {
+  if (pthread_key_create(&g_splice_pipe_key, SplicePipeDestroy) != 0) {
+    g_splice_pipe_key = static_cast<pthread_key_t>(-1);
+  }
+}
+
+static SplicePipe* GetSplicePipe() {
+  pthread_once(&g_splice_pipe_once, SplicePipeKeyInit);
+  if (g_splice_pipe_key == static_cast<pthread_key_t>(-1)) {
+    return NULL;
+  }
+  SplicePipe* p = reinterpret_cast<SplicePipe*>(pthread_getspecific(g_splice_pipe_key));
+  if (p != NULL && p->pid == getpid()) {
+    return p;
+  }
+  // Don't close a pipe inherited across fork: the child may already have
+  // closed those fds and reused the numbers. They're close-on-exec.
+  if (p == NULL) {
+    p = reinterpret_cast<SplicePipe*>(malloc(sizeof(SplicePipe)));
+    if (p == NULL) {
+      return NULL;
+    }
+  }
+  if (pipe2(p->fds, O_CLOEXEC) == -1) {
+    free(p);
+    pthread_setspecific(g_splice_pipe_key, NULL);
+    return NULL;
+  }
+  p->pid = getpid();
+  pthread_setspecific(g_splice_pipe_key, p);
+  return p;
+}
+
+static void DiscardSplicePipe(SplicePipe* p) {
+  pthread_setspecific(g_splice_pipe_key, NULL);
+  SplicePipeDestroy(p);
+}
+
+static bool IsPipe(int fd) {
+  struct stat sb;
+  return fstat(fd, &sb) == 0 && S_ISFIFO(sb.st_mode);
+}
+
+static bool WaitWritable(int fd) {
+  pollfd pfd = { fd, POLLOUT, 0 };
+  return TEMP_FAILURE_RETRY(poll(&pfd, 1, -1)) == 1;
+}
+
+// Writes all 'count' bytes of 'buf' to 'fd'. Returns false if it can't.
+static bool WriteFully(int fd, const char* buf, size_t count) {
+  while (count > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(write(fd, buf, count));
+    if (n == -1 && errno == EAGAIN && WaitWritable(fd)) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    buf += n;
+    count -= n;
+  }
+  return true;
+}
+
+// Writes everything in 'p' to 'out_fd'. Returns false if it can't.
+static bool DrainSplicePipe(SplicePipe* p, int out_fd, size_t pending) {
+  while (pending > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(splice(p->fds[0], NULL, out_fd, NULL, pending,
+                                          SPLICE_F_MOVE | SPLICE_F_MORE));
+    if (n == -1 && errno == EAGAIN && WaitWritable(out_fd)) {
+      continue;
+    }
+    if (n == -1 && errno == EINVAL) {
+      // 'out_fd' can't be spliced to, but what's been read mustn't be lost.
+      char buf[BUFSIZ];
+      n = TEMP_FAILURE_RETRY(read(p->fds[0], buf, (pending < sizeof(buf)) ? pending : sizeof(buf)));
+      if (n <= 0 || !WriteFully(out_fd, buf, n)) {
+        return false;
+      }
+    }
+    if (n <= 0) {
+      return false;
+    }
+    pending -= n;
+  }
+  return true;
+}
+
+// The methods, cheapest first. Each returns what one system call moved, or
+// -1 with errno set; EINVAL means the method doesn't work for these fds.
+static ssize_t CopyWithSendfile(int in_fd, off64_t* offset, int out_fd, size_t count) {
+  return TEMP_FAILURE_RETRY(sendfile64(out_fd, in_fd, offset, count));
+}
+
+static ssize_t CopyWithSplice(int in_fd, off64_t* offset, int out_fd, size_t count) {
+  return TEMP_FAILURE_RETRY(splice(in_fd, offset, out_fd, NULL, count, SPLICE_F_MOVE | SPLICE_F_MORE));
+}
+
+static ssize_t CopyThroughPipe(int in_fd, off64_t* offset, int out_fd, size_t count) {
+  SplicePipe* p = GetSplicePipe();
+  if (p == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t n = TEMP_FAILURE_RETRY(splice(in_fd, offset, p->fds[1], NULL, count, SPLICE_F_MOVE));
+  if (n > 0 && !DrainSplicePipe(p, out_fd, n)) {
+    // What was read is lost, so report the write's error rather than let
+    // the caller try another way.
+    ErrnoRestorer errno_restorer;
+    DiscardSplicePipe(p);
+    return -1;
+  }
+  return n;
+}
+
+static ssize_t CopyThroughBuffer(int in_fd, off64_t* offset, int out_fd, size_t count) {
+  char buf[BUFSIZ];
+  if (count > sizeof(buf)) {
+    count = sizeof(buf);
+  }
+  ssize_t n = (offset != NULL) ? TEMP_FAILURE_RETRY(pread64(in_fd, buf, count, *offset))
+                               : TEMP_FAILURE_RETRY(read(in_fd, buf, count));
+  if (n <= 0) {
+    return n;
+  }
+  if (!WriteFully(out_fd, buf, n)) {
+    return -1;
+  }
+  if (offset != NULL) {
+    *offset += n;
+  }
+  return n;
+}
+
+ssize_t android_copy_fd_range(int in_fd, off64_t* offset, int out_fd, size_t count) {
+  ssize_t (*copy)(int, off64_t*, int, size_t);
+  if (IsPipe(in_fd) || IsPipe(out_fd)) {
+    // splice can't take an offset for a pipe, but the kernel will say so.
+    copy = CopyWithSplice;
+  } else {
+    copy = CopyWithSendfile;
+  }
+
+  size_t copied = 0;
+  while (copied < count) {
+    size_t chunk = count - copied;
+    if (chunk > kChunkSize) {
+      chunk = kChunkSize;
+    }
+    ssize_t n = copy(in_fd, offset, out_fd, chunk);
+    if (n == -1 && (errno == EINVAL || errno == ENOSYS) && copied == 0) {
+      // Try the next method.
+      if (copy == CopyWithSendfile) {
+        copy = CopyThroughPipe;
+        continue;
+      } else if (copy != CopyThroughBuffer) {
+        copy = CopyThroughBuffer;
+        continue;
+      }
+    }
+    if (n == -1) {
+      return (copied > 0) ? static_cast<ssize_t>(copied) : -1;
+    }
+    if (n == 0) {
+      break;
+    }
+    copied += n;
+  }
+  return copied;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/cpu_features.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/auxv.h>
+
+#if defined(__arm__) || defined(__aarch64__)
+#include <asm/hwcap.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+// The ifunc resolvers in libc.so run before libc is initialized, so they
+// can't use this; they do their own smaller detection.
+
+static pthread_once_t g_cpu_features_once = PTHREAD_ONCE_INIT;
+static struct android_cpu_features g_cpu_features;
+
+#if defined(__arm__) || defined(__aarch64__)
+
+#if defined(__arm__)
+// Our kernel headers predate the 32-bit ARMv8 AT_HWCAP2 bits.
+#define ARM_HWCAP2_AES (1 << 0)
+#define ARM_HWCAP2_PMULL (1 << 1)
+#define ARM_HWCAP2_SHA1 (1 << 2)
+#define ARM_HWCAP2_SHA2 (1 << 3)
+#define ARM_HWCAP2_CRC32 (1 << 4)
+#endif
+
+// Applications can't read MIDR themselves, but the kernel shows its fields
+// for each CPU in /proc/cpuinfo. We take the first CPU's.
+static uint32_t read_midr() {
+  FILE* fp = fopen("/proc/cpuinfo", "re");
+  if (fp == NULL) {
+    return 0;
+  }
+  unsigned implementer = 0, variant = 0, part = 0, revision = 0;
+  bool have_implementer = false, have_variant = false, have_part = false, have_revision = false;
+  char line[256];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (!have_implementer && sscanf(line, "CPU implementer : %x", &implementer) == 1) {
+      have_implementer = true;
+    } else if (!have_variant && sscanf(line, "CPU variant : %x", &variant) == 1) {
+      have_variant = true;
+    } else if (!have_part && sscanf(line, "CPU part : %x", &part) == 1) {
+      have_part = true;
+    } else if (!have_revision && sscanf(line, "CPU revision : %u", &revision) == 1) {
+      have_revision = true;
+    }
+  }
+  fclose(fp);
+  if (!have_implementer || !have_part) {
+    return 0;
+  }
+  // The architecture field is always 0xf on the CPUs that have these.
+  return ((implementer & 0xff) << 24) | ((variant & 0xf) << 20) | (0xf << 16) |
+      ((part & 0xfff) << 4) | (revision & 0xf);
+}
+
+static void decode_cpu_features() {
+  unsigned long hwcap = getauxval(AT_HWCAP);
+  uint64_t flags = 0;
+#if defined(__arm__)
+  unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  if ((hwcap & HWCAP_NEON) != 0) flags |= ANDROID_CPU_FEATURE_NEON;
+  if ((hwcap & HWCAP_VFPv3) != 0) flags |= ANDROID_CPU_FEATURE_VFPV3;
+  if ((hwcap & HWCAP_VFPv4) != 0) flags |= ANDROID_CPU_FEATURE_VFPV4;
+  if ((hwcap & HWCAP_IDIV) == HWCAP_IDIV) flags |= ANDROID_CPU_FEATURE_IDIV;
+  if ((hwcap2 & ARM_HWCAP2_AES) != 0) flags |= ANDROID_CPU_FEATURE_AES;
+  if ((hwcap2 & ARM_HWCAP2_PMULL) != 0) flags |= ANDROID_CPU_FEATURE_PMULL;
+  if ((hwcap2 & ARM_HWCAP2_SHA1) != 0) flags |= ANDROID_CPU_FEATURE_SHA1;
+  if ((hwcap2 & ARM_HWCAP2_SHA2) != 0) flags |= ANDROID_CPU_FEATURE_SHA2;
+  if ((hwcap2 & ARM_HWCAP2_CRC32) != 0) flags |= ANDROID_CPU_FEATURE_CRC32;
+#else
+  // ARMv8 always has VFPv4-equivalent floating point and integer division.
+  flags |= ANDROID_CPU_FEATURE_VFPV3 | ANDROID_CPU_FEATURE_VFPV4 | ANDROID_CPU_FEATURE_IDIV;
+  if ((hwcap & HWCAP_ASIMD) != 0) flags |= ANDROID_CPU_FEATURE_NEON;
+  if ((hwcap & HWCAP_AES) != 0) flags |= ANDROID_CPU_FEATURE_AES;
+  if ((hwcap & HWCAP_PMULL) != 0) flags |= ANDROID_CPU_FEATURE_PMULL;
+  if ((hwcap & HWCAP_SHA1) != 0) flags |= ANDROID_CPU_FEATURE_SHA1;
+  if ((hwcap & HWCAP_SHA2) != 0) flags |= ANDROID_CPU_FEATURE_SHA2;
+  if ((hwcap & HWCAP_CRC32) != 0) flags |= ANDROID_CPU_FEATURE_CRC32;
+#endif
+  g_cpu_features.flags = flags;
+  g_cpu_features.midr = read_midr();
+}
+
+#elif defined(__i386__) || defined(__x86_64__)
+
+// Older <cpuid.h>s don't have this leaf 7 EBX bit.
+#if !defined(bit_SHA)
+#define bit_SHA (1 << 29)
+#endif
+
+static void decode_cpu_features() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+    return;
+  }
+  g_cpu_features.x86_signature = eax;
+
+  uint64_t flags = 0;
+  if ((ecx & bit_SSSE3) != 0) flags |= ANDROID_CPU_FEATURE_SSSE3;
+  if ((ecx & bit_SSE4_1) != 0) flags |= ANDROID_CPU_FEATURE_SSE4_1;
+  if ((ecx & bit_SSE4_2) != 0) flags |= ANDROID_CPU_FEATURE_SSE4_2;
+  if ((ecx & bit_POPCNT) != 0) flags |= ANDROID_CPU_FEATURE_POPCNT;
+  if ((ecx & bit_MOVBE) != 0) flags |= ANDROID_CPU_FEATURE_MOVBE;
+  if ((ecx & bit_PCLMUL) != 0) flags |= ANDROID_CPU_FEATURE_PCLMULQDQ;
+  if ((ecx & bit_AES) != 0) flags |= ANDROID_CPU_FEATURE_AES;
+
+  unsigned int leaf7_ebx = 0;
+  if (__get_cpuid_max(0, NULL) >= 7) {
+    unsigned int leaf7_eax, leaf7_ecx, leaf7_edx;
+    __cpuid_count(7, 0, leaf7_eax, leaf7_ebx, leaf7_ecx, leaf7_edx);
+  }
+  // The SHA extensions use the XMM registers, so they don't need AVX's check.
+  if ((leaf7_ebx & bit_SHA) != 0) {
+    flags |= ANDROID_CPU_FEATURE_SHA1 | ANDROID_CPU_FEATURE_SHA2;
+  }
+
+  // AVX also needs the kernel to be saving the YMM registers.
+  if ((ecx & (bit_OSXSAVE | bit_AVX)) == (bit_OSXSAVE | bit_AVX)) {
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 6) == 6) {
+      flags |= ANDROID_CPU_FEATURE_AVX;
+      if ((leaf7_ebx & bit_AVX2) != 0) flags |= ANDROID_CPU_FEATURE_AVX2;
+    }
+  }
+  g_cpu_features.flags = flags;
+}
+
+#else
+
+static void decode_cpu_features() {
+}
+
+#endif
+
+const struct android_cpu_features* android_cpu_features() {
+  pthread_once(&g_cpu_features_once, decode_cpu_features);
+  return &g_cpu_features;
+}
@@ -30,11 +30,13 @@
 
 #include <dlfcn.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/system_properties.h>
 #include <unistd.h>
 #include <unwind.h>
 #include <sys/types.h>
 
-#include "debug_mapinfo.h"
 #include "malloc_debug_disable.h"
 #include "private/libc_logging.h"
 
@@ -51,15 +53,107 @@ typedef struct _Unwind_Context __unwind_context;
 typedef _Unwind_Context __unwind_context;
 #endif
 
-static mapinfo_t* g_map_info = NULL;
 static void* g_demangler;
 typedef char* (*DemanglerFn)(const char*, char*, size_t*, int*);
 static DemanglerFn g_demangler_fn = NULL;
 
+// On these architectures, code built with frame pointers keeps a chain of
+// {previous frame pointer, return address} records on the stack, which is
+// far cheaper to follow than unwinding with .eh_frame. Setting
+// libc.debug.malloc.frame_pointers to 1 selects that for get_backtrace. It
+// only sees frames that keep a frame pointer, and stops at the first one
+// that doesn't.
+#if defined(__aarch64__) || defined(__i386__) || defined(__x86_64__)
+#define HAVE_FRAME_POINTER_UNWINDING 1
+#endif
+
+#if defined(HAVE_FRAME_POINTER_UNWINDING)
+struct frame_record_t {
+  const frame_record_t* next;
+  uintptr_t return_address;
+};
+
+struct stack_bounds_t {
+  uintptr_t base;
+  uintptr_t top;
+};
+
+static bool g_frame_pointer_unwinding = false;
+static pthread_key_t g_stack_bounds_key;
+
+static void free_stack_bounds(void* bounds) {
+  ScopedDisableDebugCalls disable;
+  free(bounds);
+}
+
+static const stack_bounds_t* thread_stack_bounds() {
+  stack_bounds_t* bounds = static_cast<stack_bounds_t*>(pthread_getspecific(g_stack_bounds_key));
+  if (bounds == NULL) {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+      return NULL;
+    }
+    void* stack_base;
+    size_t stack_size;
+    pthread_attr_getstack(&attr, &stack_base, &stack_size);
+    pthread_attr_destroy(&attr);
+
+    bounds = static_cast<stack_bounds_t*>(malloc(sizeof(*bounds)));
+    if (bounds == NULL) {
+      return NULL;
+    }
+    bounds->base = reinterpret_cast<uintptr_t>(stack_base);
+    bounds->top = bounds->base + stack_size;
+    pthread_setspecific(g_stack_bounds_key, bounds);
+  }
+  return bounds;
+}
+
+// Follows the frame record chain starting at 'record', or returns -1 if it
+// can't be trusted (we aren't on the thread's own stack, for example in a
+// signal handler on the alternate signal stack).
+static int frame_pointer_backtrace(const frame_record_t* record, uintptr_t* frames, size_t max_depth) {
+  const stack_bounds_t* bounds = thread_stack_bounds();
+  if (bounds == NULL) {
+    return -1;
+  }
+  uintptr_t address = reinterpret_cast<uintptr_t>(record);
+  if (address < bounds->base || address >= bounds->top) {
+    return -1;
+  }
+
+  size_t frame_count = 0;
+  while (frame_count < max_depth) {
+    address = reinterpret_cast<uintptr_t>(record);
+    if ((address % sizeof(uintptr_t)) != 0 || address + sizeof(*record) > bounds->top) {
+      break;
+    }
+    if (record->return_address == 0) {
+      break;
+    }
+    frames[frame_count++] = record->return_address;
+    // Records must move towards the top of the stack, or we've lost the chain.
+    if (record->next <= record) {
+      break;
+    }
+    record = record->next;
+  }
+  return frame_count;
+}
+#endif
+
 __LIBC_HIDDEN__ void backtrace_startup() {
   ScopedDisableDebugCalls disable;
 
-  g_map_info = mapinfo_create(getpid());
+#if defined(HAVE_FRAME_POINTER_UNWINDING)
+  char env[PROP_VALUE_MAX];
+  if (__system_property_get("libc.debug.malloc.frame_pointers", env) && atoi(env) != 0 &&
+      pthread_key_create(&g_stack_bounds_key, free_stack_bounds) == 0) {
+    g_frame_pointer_unwinding = true;
+    __libc_format_log(ANDROID_LOG_INFO, "libc", "using frame pointers for backtraces\n");
+  }
+#endif
+
   g_demangler = dlopen("libgccdemangle.so", RTLD_NOW);
   if (g_demangler != NULL) {
     void* sym = dlsym(g_demangler, "__cxa_demangle");
@@ -70,7 +164,6 @@ __LIBC_HIDDEN__ void backtrace_startup() {
 __LIBC_HIDDEN__ void backtrace_shutdown() {
   ScopedDisableDebugCalls disable;
 
-  mapinfo_destroy(g_map_info);
   dlclose(g_demangler);
 }
 
@@ -128,6 +221,18 @@ static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg)
 __LIBC_HIDDEN__ int get_backtrace(uintptr_t* frames, size_t max_depth) {
   ScopedDisableDebugCalls disable;
 
+#if defined(HAVE_FRAME_POINTER_UNWINDING)
+  if (g_frame_pointer_unwinding) {
+    // Our own frame record holds our caller's return address, so this skips
+    // get_backtrace itself just like trace_function does.
+    const frame_record_t* record = static_cast<const frame_record_t*>(__builtin_frame_address(0));
+    int frame_count = frame_pointer_backtrace(record, frames, max_depth);
+    if (frame_count >= 0) {
+      return frame_count;
+    }
+  }
+#endif
+
   stack_crawl_state_t state(frames, max_depth);
   _Unwind_Backtrace(trace_function, &state);
   return state.frame_count;
@@ -148,16 +253,19 @@ __LIBC_HIDDEN__ void log_backtrace(uintptr_t* frames, size_t frame_count) {
   for (size_t i = 0 ; i < frame_count; ++i) {
     uintptr_t offset = 0;
     const char* symbol = NULL;
+    const char* soname = NULL;
+    uintptr_t rel_pc = frames[i];
 
+    // dladdr looks in the linker's own index of loaded libraries, so unlike
+    // a snapshot of /proc/self/maps it knows about libraries dlopen()ed
+    // since startup.
     Dl_info info;
-    if (dladdr((void*) frames[i], &info) != 0) {
+    if (dladdr(reinterpret_cast<void*>(frames[i]), &info) != 0) {
       offset = reinterpret_cast<uintptr_t>(info.dli_saddr);
       symbol = info.dli_sname;
+      soname = info.dli_fname;
+      rel_pc -= reinterpret_cast<uintptr_t>(info.dli_fbase);
     }
-
-    uintptr_t rel_pc = offset;
-    const mapinfo_t* mi = (g_map_info != NULL) ? mapinfo_find(g_map_info, frames[i], &rel_pc) : NULL;
-    const char* soname = (mi != NULL) ? mi->name : info.dli_fname;
     if (soname == NULL) {
       soname = "<unknown>";
     }
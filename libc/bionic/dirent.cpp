@@ -39,23 +39,44 @@
 
 extern "C" int __getdents64(unsigned int, dirent*, unsigned int);
 
+// Most directories fit in the smallest buffer. Each time a bigger one fills
+// the buffer, the buffer doubles, up to the largest size, so walking a
+// directory of 100k entries doesn't take a system call per dozen of them.
+static const size_t kMinBufferSize = 4096;
+static const size_t kMaxBufferSize = 64 * 1024;
+
 struct DIR {
   int fd_;
   size_t available_bytes_;
   dirent* next_;
   pthread_mutex_t mutex_;
-  dirent buff_[15];
+  bool buff_full_; // Whether the last read filled the buffer.
+  size_t buff_size_;
+  dirent* buff_;
 };
 
-static DIR* __allocate_DIR(int fd) {
+// 'size_hint' is the directory's st_size if we know it, or 0.
+static DIR* __allocate_DIR(int fd, off_t size_hint) {
+  size_t buff_size = kMinBufferSize;
+  while (buff_size < kMaxBufferSize && static_cast<off_t>(buff_size) < size_hint) {
+    buff_size *= 2;
+  }
+
   DIR* d = reinterpret_cast<DIR*>(malloc(sizeof(DIR)));
   if (d == NULL) {
     return NULL;
   }
+  d->buff_ = reinterpret_cast<dirent*>(malloc(buff_size));
+  if (d->buff_ == NULL) {
+    free(d);
+    return NULL;
+  }
   d->fd_ = fd;
   d->available_bytes_ = 0;
   d->next_ = NULL;
   pthread_mutex_init(&d->mutex_, NULL);
+  d->buff_full_ = false;
+  d->buff_size_ = buff_size;
   return d;
 }
 
@@ -74,20 +95,32 @@ DIR* fdopendir(int fd) {
     return NULL;
   }
 
-  return __allocate_DIR(fd);
+  return __allocate_DIR(fd, sb.st_size);
 }
 
 DIR* opendir(const char* path) {
   int fd = open(path, O_RDONLY | O_DIRECTORY);
-  return (fd != -1) ? __allocate_DIR(fd) : NULL;
+  return (fd != -1) ? __allocate_DIR(fd, 0) : NULL;
 }
 
 static bool __fill_DIR(DIR* d) {
-  int rc = TEMP_FAILURE_RETRY(__getdents64(d->fd_, d->buff_, sizeof(d->buff_)));
+  // If the last read filled the buffer there's probably plenty more to come.
+  // The entries it returned are no longer valid, so now's when we can grow.
+  if (d->buff_full_ && d->buff_size_ < kMaxBufferSize) {
+    dirent* bigger = reinterpret_cast<dirent*>(malloc(2 * d->buff_size_));
+    if (bigger != NULL) {
+      free(d->buff_);
+      d->buff_ = bigger;
+      d->buff_size_ *= 2;
+    }
+  }
+
+  int rc = TEMP_FAILURE_RETRY(__getdents64(d->fd_, d->buff_, d->buff_size_));
   if (rc <= 0) {
     return false;
   }
   d->available_bytes_ = rc;
+  d->buff_full_ = (d->buff_size_ - rc < sizeof(dirent));
   d->next_ = d->buff_;
   return true;
 }
@@ -138,6 +171,7 @@ int closedir(DIR* d) {
 
   int fd = d->fd_;
   pthread_mutex_destroy(&d->mutex_);
+  free(d->buff_);
   free(d);
   return close(fd);
 }
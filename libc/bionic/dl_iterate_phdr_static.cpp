@@ -52,6 +52,18 @@ int dl_iterate_phdr(int (*cb)(struct dl_phdr_info* info, size_t size, void* data
   exe_info.dlpi_name = NULL;
   exe_info.dlpi_phdr = reinterpret_cast<ElfW(Phdr)*>(reinterpret_cast<uintptr_t>(ehdr) + ehdr->e_phoff);
   exe_info.dlpi_phnum = ehdr->e_phnum;
+  // A static-PIE executable is loaded wherever the kernel chose, and
+  // unwinders need to know where that is. The ELF header is at the start of
+  // the segment that maps the start of the file.
+  for (size_t i = 0; i < exe_info.dlpi_phnum; ++i) {
+    if (exe_info.dlpi_phdr[i].p_type == PT_LOAD && exe_info.dlpi_phdr[i].p_offset == 0) {
+      exe_info.dlpi_addr = reinterpret_cast<ElfW(Addr)>(ehdr) - exe_info.dlpi_phdr[i].p_vaddr;
+      break;
+    }
+  }
+  // Nothing is ever loaded or unloaded.
+  exe_info.dlpi_adds = 1;
+  exe_info.dlpi_subs = 0;
 
 #if defined(AT_SYSINFO_EHDR)
   // Try the executable first.
@@ -72,6 +84,8 @@ int dl_iterate_phdr(int (*cb)(struct dl_phdr_info* info, size_t size, void* data
   vdso_info.dlpi_name = NULL;
   vdso_info.dlpi_phdr = reinterpret_cast<ElfW(Phdr)*>(reinterpret_cast<char*>(ehdr_vdso) + ehdr_vdso->e_phoff);
   vdso_info.dlpi_phnum = ehdr_vdso->e_phnum;
+  vdso_info.dlpi_adds = 1;
+  vdso_info.dlpi_subs = 0;
   for (size_t i = 0; i < vdso_info.dlpi_phnum; ++i) {
     if (vdso_info.dlpi_phdr[i].p_type == PT_LOAD) {
       vdso_info.dlpi_addr = (ElfW(Addr)) ehdr_vdso - vdso_info.dlpi_phdr[i].p_vaddr;
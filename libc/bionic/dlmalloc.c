@@ -31,6 +31,9 @@ static void* named_anonymous_mmap(size_t length);
 #define MMAP(s) named_anonymous_mmap(s)
 #define DIRECT_MMAP(s) named_anonymous_mmap(s)
 
+// Run by dlmalloc's own fork child handler, for mallopt(M_SEGREGATE_ON_FORK).
+static void segregate_heap_after_fork(void);
+
 // Ugly inclusion of C file so that bionic specific #defines configure dlmalloc.
 #include "../upstream-dlmalloc/malloc.c"
 
@@ -46,6 +49,189 @@ static void __bionic_heap_usage_error(const char* function, void* address) {
   *((int**) 0xdeadbaad) = (int*) address;
 }
 
+void dlmalloc_disable(void) {
+  ensure_initialization();
+  ACQUIRE_LOCK(&(gm)->mutex);
+}
+
+void dlmalloc_enable(void) {
+  RELEASE_LOCK(&(gm)->mutex);
+}
+
+struct iterate_state {
+  uintptr_t base;
+  uintptr_t end;
+  void (*callback)(uintptr_t, size_t, void*);
+  void* arg;
+};
+
+static void iterate_handler(void* start, void* end __unused, size_t used_bytes, void* arg) {
+  struct iterate_state* state = (struct iterate_state*) arg;
+  uintptr_t address = (uintptr_t) start;
+  if (used_bytes != 0 && address >= state->base && address < state->end) {
+    state->callback(address, used_bytes, state->arg);
+  }
+}
+
+// The caller holds the heap lock through dlmalloc_disable, so this walks the
+// heap directly rather than through dlmalloc_inspect_all. Chunks that
+// dlmalloc mmapped directly aren't linked into the heap, so they aren't seen.
+int dlmalloc_iterate(uintptr_t base, size_t size,
+                     void (*callback)(uintptr_t, size_t, void*), void* arg) {
+  struct iterate_state state;
+  state.base = base;
+  state.end = (base + size < base) ? UINTPTR_MAX : base + size;
+  state.callback = callback;
+  state.arg = arg;
+  internal_inspect_all(gm, iterate_handler, &state);
+  return 0;
+}
+
+static void release_free_pages_handler(void* start, void* end, size_t used_bytes, void* arg) {
+  if (used_bytes != 0) {
+    return;
+  }
+  // The chunk's own bookkeeping is before start and the next chunk's header
+  // is at end, so everything in between can be thrown away.
+  uintptr_t page_start = ((uintptr_t) start + mparams.page_size - 1) & ~(mparams.page_size - 1);
+  uintptr_t page_end = (uintptr_t) end & ~(mparams.page_size - 1);
+  if (page_start < page_end) {
+    madvise((void*) page_start, page_end - page_start, MADV_DONTNEED);
+    *(size_t*) arg += page_end - page_start;
+  }
+}
+
+// Unlike dlmalloc_trim, which can only shrink the top of each segment, this
+// drops the pages inside free chunks anywhere in the heap. Returns the number
+// of bytes released.
+size_t dlmalloc_release_free_pages(void) {
+  size_t released = 0;
+  dlmalloc_inspect_all(release_free_pages_handler, &released);
+  return released;
+}
+
+// Chunks are counted in power-of-two size classes, [2^i, 2^(i+1)).
+#define INFO_SIZE_CLASS_COUNT (sizeof(size_t) * 8)
+
+struct info_size_class {
+  size_t used_count;
+  size_t used_bytes;
+  size_t free_count;
+  size_t free_bytes;
+};
+
+static void info_handler(void* start, void* end, size_t used_bytes, void* arg) {
+  struct info_size_class* classes = (struct info_size_class*) arg;
+  size_t bytes = (used_bytes != 0) ? used_bytes : (size_t) ((char*) end - (char*) start);
+  size_t i = (sizeof(size_t) * 8 - 1) - __builtin_clzl(bytes | 1);
+  if (used_bytes != 0) {
+    classes[i].used_count++;
+    classes[i].used_bytes += bytes;
+  } else {
+    classes[i].free_count++;
+    classes[i].free_bytes += bytes;
+  }
+}
+
+int dlmalloc_info(int options, FILE* fp) {
+  if (options != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Gather everything first: we can't write (and so perhaps allocate) while
+  // dlmalloc_inspect_all holds the heap lock.
+  struct info_size_class classes[INFO_SIZE_CLASS_COUNT];
+  memset(classes, 0, sizeof(classes));
+  dlmalloc_inspect_all(info_handler, classes);
+  struct mallinfo info = dlmallinfo();
+
+  fprintf(fp, "dlmalloc heap\n");
+  fprintf(fp, "  system bytes:     %zu\n", info.arena);
+  fprintf(fp, "  mmapped bytes:    %zu\n", info.hblkhd);
+  fprintf(fp, "  in use bytes:     %zu\n", info.uordblks);
+  fprintf(fp, "  free bytes:       %zu\n", info.fordblks);
+  fprintf(fp, "  releasable bytes: %zu\n", info.keepcost);
+  fprintf(fp, "  %-24s %10s %12s %10s %12s\n", "size", "in use", "bytes", "free", "bytes");
+  for (size_t i = 0; i < INFO_SIZE_CLASS_COUNT; ++i) {
+    const struct info_size_class* c = &classes[i];
+    if (c->used_count == 0 && c->free_count == 0) {
+      continue;
+    }
+    char range[32];
+    snprintf(range, sizeof(range), "[%zu, %zu)", (size_t) 1 << i, (size_t) 2 << i);
+    fprintf(fp, "  %-24s %10zu %12zu %10zu %12zu\n", range,
+            c->used_count, c->used_bytes, c->free_count, c->free_bytes);
+  }
+  return ferror(fp) ? -1 : 0;
+}
+
+// Segments the heap had before it was segregated from a parent's.
+#define SEGREGATED_SEGMENT_MAX 32
+static struct {
+  uintptr_t base;
+  uintptr_t end;
+} segregated_segments[SEGREGATED_SEGMENT_MAX];
+static size_t segregated_segment_count;
+
+static volatile int segregate_on_fork;
+
+void dlmalloc_set_segregate_on_fork(int value) {
+  // The work is done by dlmalloc's fork handlers, which this registers if
+  // nothing has been allocated yet.
+  ensure_initialization();
+  segregate_on_fork = value;
+}
+
+// Makes dlmalloc forget every segment it has, along with all the free chunks
+// and the top chunk inside them, so that nothing it allocates from now on
+// shares a page with anything allocated before. The old segments stay mapped
+// and their chunks stay usable, but they must never be freed (see
+// dlmalloc_is_segregated). If there are too many segments to keep track of,
+// the heap is left alone.
+//
+// This runs in the child as the only thread, just after the lock has been
+// reinitialized; the parent held it across the fork, so the heap is
+// consistent.
+static void segregate_heap_after_fork(void) {
+  if (!segregate_on_fork || !is_initialized(gm)) {
+    return;
+  }
+  size_t count = 0;
+  for (msegmentptr sp = &gm->seg; sp != 0; sp = sp->next) {
+    ++count;
+  }
+  if (segregated_segment_count + count > SEGREGATED_SEGMENT_MAX) {
+    return;
+  }
+  for (msegmentptr sp = &gm->seg; sp != 0; sp = sp->next) {
+    segregated_segments[segregated_segment_count].base = (uintptr_t) sp->base;
+    segregated_segments[segregated_segment_count].end = (uintptr_t) sp->base + sp->size;
+    ++segregated_segment_count;
+  }
+  // With no top chunk, the next allocation reinitializes the heap in
+  // fresh memory. Chunks mmapped by dlmalloc aren't in any segment and
+  // are still freed as usual.
+  gm->smallmap = 0;
+  gm->treemap = 0;
+  memset(gm->treebins, 0, sizeof(gm->treebins));
+  gm->dv = 0;
+  gm->dvsize = 0;
+  gm->top = 0;
+  gm->topsize = 0;
+  memset(&gm->seg, 0, sizeof(gm->seg));
+}
+
+int dlmalloc_is_segregated(const void* mem) {
+  uintptr_t address = (uintptr_t) mem;
+  for (size_t i = 0; i < segregated_segment_count; ++i) {
+    if (address >= segregated_segments[i].base && address < segregated_segments[i].end) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 static void* named_anonymous_mmap(size_t length) {
   void* map = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
   if (map == MAP_FAILED) {
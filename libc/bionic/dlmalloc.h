@@ -31,6 +31,9 @@
 #define USE_RECURSIVE_LOCK 0
 #define USE_SPIN_LOCKS 0
 #define DEFAULT_MMAP_THRESHOLD (64U * 1024U)
+/* Grow and shrink mmapped chunks with mremap, which moves page tables rather than copying
+ * data. dlmalloc only turns this on by itself if the compiler happens to define "linux". */
+#define HAVE_MREMAP 1
 
 #define malloc_getpagesize getpagesize()
 
@@ -50,6 +53,23 @@ int dlmalloc_trim(size_t) __LIBC_ABI_PUBLIC__;
 void dlmalloc_inspect_all(void (*handler)(void*, void*, size_t, void*), void*) __LIBC_ABI_PUBLIC__;
 __END_DECLS
 
+/* Heap introspection behind malloc_info, malloc_disable, malloc_enable and malloc_iterate. */
+#include <stdint.h>
+#include <stdio.h>
+__BEGIN_DECLS
+void dlmalloc_disable(void);
+void dlmalloc_enable(void);
+int dlmalloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*);
+int dlmalloc_info(int, FILE*);
+size_t dlmalloc_release_free_pages(void);
+__END_DECLS
+
+/* Starting the heap afresh in fork children, for mallopt(M_SEGREGATE_ON_FORK). */
+__BEGIN_DECLS
+void dlmalloc_set_segregate_on_fork(int);
+int dlmalloc_is_segregated(const void*);
+__END_DECLS
+
 /* Include the proper definitions. */
 #include "../upstream-dlmalloc/malloc.h"
 
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_elf_tls.h"
+
+#include <limits.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "private/bionic_macros.h"
+#include "private/bionic_tls.h"
+#include "private/KernelArgumentBlock.h"
+#include "private/libc_logging.h"
+#include "private/ScopedPthreadMutexLocker.h"
+#include "pthread_internal.h"
+
+extern "C" int __set_tls(void* ptr);
+
+TlsModules* __libc_tls_modules;
+
+bool __bionic_get_tls_segment(const ElfW(Phdr)* phdr, size_t phnum,
+                              ElfW(Addr) load_bias, TlsSegment* out) {
+  for (size_t i = 0; i < phnum; ++i) {
+    if (phdr[i].p_type == PT_TLS) {
+      out->size = phdr[i].p_memsz;
+      out->alignment = (phdr[i].p_align > 1) ? phdr[i].p_align : 1;
+      out->init_ptr = reinterpret_cast<const void*>(load_bias + phdr[i].p_vaddr);
+      out->init_size = phdr[i].p_filesz;
+      return true;
+    }
+  }
+  return false;
+}
+
+void __bionic_add_static_tls_module(TlsModules* modules, TlsModule* module) {
+  // Each block goes below the ones before it. The executable's, which comes
+  // first, therefore ends up exactly where local-exec code expects it.
+  size_t alignment = module->segment.alignment;
+  size_t offset = BIONIC_ALIGN(modules->static_size + module->segment.size, alignment);
+  module->is_static = true;
+  module->static_offset = -static_cast<intptr_t>(offset);
+  modules->static_size = offset;
+  if (alignment > modules->static_alignment) {
+    modules->static_alignment = alignment;
+  }
+}
+
+void** __bionic_layout_thread_tls(uint8_t* top, uint8_t** bottom) {
+  uintptr_t tls = reinterpret_cast<uintptr_t>(top) - BIONIC_TLS_SLOTS * sizeof(void*);
+  tls &= ~static_cast<uintptr_t>(BIONIC_TLS_ALIGNMENT - 1);
+  size_t static_size = 0;
+  TlsModules* modules = __libc_tls_modules;
+  if (modules != NULL && modules->static_size != 0) {
+    // The thread pointer has to be aligned for every block below it.
+    tls &= ~(modules->static_alignment - 1);
+    static_size = modules->static_size;
+  }
+  *bottom = reinterpret_cast<uint8_t*>((tls - static_size) & ~static_cast<uintptr_t>(15));
+  return reinterpret_cast<void**>(tls);
+}
+
+static void InitBlock(void* block, const TlsSegment& segment) {
+  memcpy(block, segment.init_ptr, segment.init_size);
+  memset(reinterpret_cast<uint8_t*>(block) + segment.init_size, 0,
+         segment.size - segment.init_size);
+}
+
+void __bionic_init_static_tls(void** tls) {
+  TlsModules* modules = __libc_tls_modules;
+  if (modules == NULL || modules->static_size == 0) {
+    return;
+  }
+
+  ScopedPthreadMutexLocker locker(&modules->lock);
+  for (size_t i = 0; i < modules->module_count; ++i) {
+    const TlsModule& module = modules->modules[i];
+    if (module.generation != 0 && module.is_static) {
+      InitBlock(reinterpret_cast<uint8_t*>(tls) + module.static_offset, module.segment);
+    }
+  }
+}
+
+bool __bionic_init_main_thread_static_tls() {
+  TlsModules* modules = __libc_tls_modules;
+  if (modules == NULL || modules->static_size == 0) {
+    return true;
+  }
+
+  // The main thread's TLS slots start out in static storage with nothing
+  // reserved below them, so they have to move.
+  size_t slots_size = BIONIC_TLS_SLOTS * sizeof(void*);
+  size_t mmap_size = BIONIC_ALIGN(modules->static_size + modules->static_alignment + slots_size,
+                                  PAGE_SIZE);
+  void* space = mmap(NULL, mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (space == MAP_FAILED) {
+    return false;
+  }
+
+  uint8_t* bottom;
+  void** tls = __bionic_layout_thread_tls(reinterpret_cast<uint8_t*>(space) + mmap_size, &bottom);
+  pthread_internal_t* thread = __get_thread();
+  memcpy(tls, thread->tls, slots_size);
+  tls[TLS_SLOT_SELF] = tls;
+  __bionic_init_static_tls(tls);
+
+  thread->tls = tls;
+  __set_tls(tls);
+  return true;
+}
+
+// Brings the calling thread's DTV up to date with the module table: makes
+// room for every module and throws away blocks belonging to modules that
+// have been unloaded since the DTV was last looked at.
+static TlsDtv* UpdateDtvLocked(TlsModules* modules) {
+  void** tls = __get_tls();
+  TlsDtv* dtv = reinterpret_cast<TlsDtv*>(tls[TLS_SLOT_DTV]);
+
+  if (dtv == NULL || dtv->count < modules->module_count) {
+    size_t count = modules->module_count;
+    TlsDtv* new_dtv = reinterpret_cast<TlsDtv*>(calloc(1, sizeof(TlsDtv) + count * sizeof(void*)));
+    if (new_dtv == NULL) {
+      __libc_fatal("couldn't allocate the DTV for %zu TLS modules", count);
+    }
+    new_dtv->count = count;
+    if (dtv != NULL) {
+      new_dtv->generation = dtv->generation;
+      memcpy(new_dtv->blocks, dtv->blocks, dtv->count * sizeof(void*));
+      free(dtv);
+    }
+    dtv = new_dtv;
+    tls[TLS_SLOT_DTV] = dtv;
+  }
+
+  if (dtv->generation != modules->generation) {
+    for (size_t i = 0; i < dtv->count; ++i) {
+      // A slot that was freed, or freed and given to another module, since
+      // our last look means the block belongs to a module that's gone.
+      // Static modules are never unloaded, so such a block was ours to free.
+      const TlsModule& module = modules->modules[i];
+      if (dtv->blocks[i] != NULL && (module.generation == 0 || module.generation > dtv->generation)) {
+        free(dtv->blocks[i]);
+        dtv->blocks[i] = NULL;
+      }
+    }
+    dtv->generation = modules->generation;
+  }
+  return dtv;
+}
+
+static void* __tls_get_addr_slow(const TlsIndex* ti) {
+  TlsModules* modules = __libc_tls_modules;
+  if (modules == NULL) {
+    __libc_fatal("__tls_get_addr called without any TLS modules");
+  }
+
+  ScopedPthreadMutexLocker locker(&modules->lock);
+  if (ti->module == 0 || ti->module > modules->module_count ||
+      modules->modules[ti->module - 1].generation == 0) {
+    __libc_fatal("__tls_get_addr called for invalid TLS module %zu", ti->module);
+  }
+
+  TlsDtv* dtv = UpdateDtvLocked(modules);
+  void*& block = dtv->blocks[ti->module - 1];
+  if (block == NULL) {
+    const TlsModule& module = modules->modules[ti->module - 1];
+    if (module.is_static) {
+      block = reinterpret_cast<uint8_t*>(__get_tls()) + module.static_offset;
+    } else {
+      // Allocate lazily, so threads only pay for the modules they use.
+      block = memalign(module.segment.alignment, module.segment.size > 0 ? module.segment.size : 1);
+      if (block == NULL) {
+        __libc_fatal("couldn't allocate %zu bytes of TLS for module %zu",
+                     module.segment.size, ti->module);
+      }
+      InitBlock(block, module.segment);
+    }
+  }
+  return reinterpret_cast<uint8_t*>(block) + ti->offset;
+}
+
+void* __tls_get_addr(const TlsIndex* ti) {
+  TlsDtv* dtv = reinterpret_cast<TlsDtv*>(__get_tls()[TLS_SLOT_DTV]);
+  if (__predict_true(dtv != NULL && dtv->generation == __libc_tls_modules->generation &&
+                     ti->module - 1 < dtv->count)) {
+    void* block = dtv->blocks[ti->module - 1];
+    if (__predict_true(block != NULL)) {
+      return reinterpret_cast<uint8_t*>(block) + ti->offset;
+    }
+  }
+  return __tls_get_addr_slow(ti);
+}
+
+#if defined(__i386__)
+// The GNU flavor of the x86 ABI passes the argument in %eax.
+extern "C" __attribute__((__regparm__(1))) void* ___tls_get_addr(const TlsIndex* ti) {
+  return __tls_get_addr(ti);
+}
+#endif
+
+void __bionic_free_dynamic_tls() {
+  void** tls = __get_tls();
+  TlsDtv* dtv = reinterpret_cast<TlsDtv*>(tls[TLS_SLOT_DTV]);
+  if (dtv == NULL) {
+    return;
+  }
+  tls[TLS_SLOT_DTV] = NULL;
+
+  TlsModules* modules = __libc_tls_modules;
+  {
+    ScopedPthreadMutexLocker locker(&modules->lock);
+    for (size_t i = 0; i < dtv->count; ++i) {
+      if (dtv->blocks[i] != NULL && !modules->modules[i].is_static) {
+        free(dtv->blocks[i]);
+      }
+    }
+  }
+  free(dtv);
+}
+
+#if defined(BIONIC_STATIC_TLS)
+static TlsModules g_static_tls_modules;
+#endif
+static TlsModule g_static_tls_module;
+
+void __libc_init_static_tls(KernelArgumentBlock& args, ElfW(Addr) load_bias) {
+  const ElfW(Phdr)* phdr = reinterpret_cast<const ElfW(Phdr)*>(args.getauxval(AT_PHDR));
+  size_t phnum = args.getauxval(AT_PHNUM);
+
+  // A static executable has at most one TLS segment, its own.
+  TlsModule& module = g_static_tls_module;
+  if (!__bionic_get_tls_segment(phdr, phnum, load_bias, &module.segment)) {
+    return;
+  }
+#if defined(BIONIC_STATIC_TLS)
+  TlsModules& modules = g_static_tls_modules;
+  pthread_mutex_init(&modules.lock, NULL);
+  modules.generation = 1;
+  modules.modules = &module;
+  modules.module_count = modules.module_capacity = 1;
+  modules.static_alignment = 1;
+  module.generation = 1;
+  __bionic_add_static_tls_module(&modules, &module);
+
+  __libc_tls_modules = &modules;
+  args.tls_modules = &modules;
+  if (!__bionic_init_main_thread_static_tls()) {
+    __libc_fatal("couldn't allocate the main thread's static TLS");
+  }
+#else
+  __libc_fatal("static executables with a TLS segment aren't supported on this architecture");
+#endif
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <execinfo.h>
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <unwind.h>
+
+// backtrace(3) and friends. Symbolization goes through dladdr(3), which
+// looks the address up in the linker's own index of loaded libraries and
+// their symbols. That index is updated as libraries are loaded and
+// unloaded, so unlike reading /proc/self/maps it's never stale and costs a
+// couple of binary searches per frame.
+
+struct backtrace_state_t {
+  void** frames;
+  int frame_count;
+  int max_depth;
+  bool have_skipped_self;
+};
+
+static _Unwind_Reason_Code trace_function(_Unwind_Context* context, void* arg) {
+  backtrace_state_t* state = static_cast<backtrace_state_t*>(arg);
+
+  uintptr_t ip = _Unwind_GetIP(context);
+
+  // The first stack frame is backtrace itself. Skip it.
+  if (!state->have_skipped_self) {
+    state->have_skipped_self = true;
+    return _URC_NO_REASON;
+  }
+  if (ip == 0 || state->frame_count >= state->max_depth) {
+    return _URC_END_OF_STACK;
+  }
+
+  state->frames[state->frame_count++] = reinterpret_cast<void*>(ip);
+  return (state->frame_count >= state->max_depth) ? _URC_END_OF_STACK : _URC_NO_REASON;
+}
+
+int backtrace(void** buffer, int size) {
+  if (buffer == NULL || size <= 0) {
+    return 0;
+  }
+  backtrace_state_t state = { buffer, 0, size, false };
+  _Unwind_Backtrace(trace_function, &state);
+  return state.frame_count;
+}
+
+// Formats one frame the way glibc does, returning the snprintf(3) result.
+static int format_frame(char* buf, size_t size, const void* address, bool found, const Dl_info& info) {
+  if (!found || info.dli_fname == NULL) {
+    return snprintf(buf, size, "[%p]", address);
+  }
+  uintptr_t pc = reinterpret_cast<uintptr_t>(address);
+  if (info.dli_sname != NULL && info.dli_saddr != NULL) {
+    return snprintf(buf, size, "%s(%s+0x%" PRIxPTR ") [%p]", info.dli_fname, info.dli_sname,
+                    pc - reinterpret_cast<uintptr_t>(info.dli_saddr), address);
+  }
+  return snprintf(buf, size, "%s(+0x%" PRIxPTR ") [%p]", info.dli_fname,
+                  pc - reinterpret_cast<uintptr_t>(info.dli_fbase), address);
+}
+
+char** backtrace_symbols(void* const* buffer, int size) {
+  if (size < 0) {
+    size = 0;
+  }
+
+  // Look everything up once, and size the strings before formatting them,
+  // so the array and the strings can share a single allocation.
+  Dl_info* infos = reinterpret_cast<Dl_info*>(malloc((size + 1) * sizeof(Dl_info)));
+  bool* found = reinterpret_cast<bool*>(malloc(size + 1));
+  if (infos == NULL || found == NULL) {
+    free(infos);
+    free(found);
+    return NULL;
+  }
+  size_t string_bytes = 0;
+  for (int i = 0; i < size; ++i) {
+    found[i] = (dladdr(buffer[i], &infos[i]) != 0);
+    string_bytes += format_frame(NULL, 0, buffer[i], found[i], infos[i]) + 1;
+  }
+
+  char** result = reinterpret_cast<char**>(malloc(size * sizeof(char*) + string_bytes + 1));
+  if (result != NULL) {
+    char* p = reinterpret_cast<char*>(result + size);
+    char* end = p + string_bytes;
+    for (int i = 0; i < size; ++i) {
+      result[i] = p;
+      p += format_frame(p, end - p, buffer[i], found[i], infos[i]) + 1;
+    }
+  }
+  free(infos);
+  free(found);
+  return result;
+}
+
+void backtrace_symbols_fd(void* const* buffer, int size, int fd) {
+  for (int i = 0; i < size; ++i) {
+    Dl_info info;
+    bool found = (dladdr(buffer[i], &info) != 0);
+
+    // Very long symbol names get truncated rather than allocating.
+    char line[512];
+    size_t length = format_frame(line, sizeof(line) - 1, buffer[i], found, info);
+    if (length > sizeof(line) - 2) {
+      length = sizeof(line) - 2;
+    }
+    line[length++] = '\n';
+    TEMP_FAILURE_RETRY(write(fd, line, length));
+  }
+}
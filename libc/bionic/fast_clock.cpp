@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/fast_clock.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+static int64_t monotonic_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// read_counter reads the counter, in program order with the code around it.
+// counter_frequency returns its frequency in Hz, or 0 if we have to measure it.
+#if defined(__aarch64__)
+
+// The generic timer runs at a constant rate, and Linux always lets EL0 read it.
+static inline uint64_t read_counter() {
+  uint64_t value;
+  __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(value) : : "memory");
+  return value;
+}
+
+static bool counter_is_invariant() {
+  return true;
+}
+
+static uint64_t counter_frequency() {
+  uint64_t frequency;
+  __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+  return frequency;
+}
+
+#elif defined(__x86_64__)
+
+static inline uint64_t read_counter() {
+  uint32_t lo, hi;
+  __asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+// Only an invariant TSC (CPUID.80000007H:EDX[8]) keeps a constant rate
+// through frequency changes and deep sleep states. Most hypervisors don't
+// report one.
+static bool counter_is_invariant() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) {
+    return false;
+  }
+  __cpuid(0x80000007, eax, ebx, ecx, edx);
+  return (edx & (1U << 8)) != 0;
+}
+
+// Newer Intel CPUs give the TSC's ratio to the crystal clock in leaf 0x15.
+static uint64_t counter_frequency() {
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, NULL) < 0x15) {
+    return 0;
+  }
+  __cpuid(0x15, eax, ebx, ecx, edx);
+  if (eax == 0 || ebx == 0 || ecx == 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ecx) * ebx / eax;
+}
+
+#else
+
+static inline uint64_t read_counter() {
+  return monotonic_ns();
+}
+
+static bool counter_is_invariant() {
+  return false;
+}
+
+static uint64_t counter_frequency() {
+  return 0;
+}
+
+#endif
+
+// -1 until the first call works it out.
+static atomic_int g_use_counter = ATOMIC_VAR_INIT(-1);
+
+static bool use_counter() {
+  int use = atomic_load_explicit(&g_use_counter, memory_order_relaxed);
+  if (__predict_false(use == -1)) {
+    use = counter_is_invariant();
+    atomic_store_explicit(&g_use_counter, use, memory_order_relaxed);
+  }
+  return use;
+}
+
+// ns = base_ns + (ticks - base_ticks) * mult / 2^32. Without a counter,
+// ticks are already nanoseconds and mult is zero.
+struct FastClockCalibration {
+  uint64_t base_ticks;
+  int64_t base_ns;
+  uint64_t mult;
+};
+
+static pthread_once_t g_calibration_once = PTHREAD_ONCE_INIT;
+static FastClockCalibration g_calibration;
+
+// Reads the counter and CLOCK_MONOTONIC as close together as we can, by
+// keeping the tightest of a few tries.
+static void read_counter_and_monotonic(uint64_t* ticks, int64_t* ns) {
+  uint64_t best = UINT64_MAX;
+  for (int i = 0; i < 8; ++i) {
+    uint64_t before = read_counter();
+    int64_t now = monotonic_ns();
+    uint64_t after = read_counter();
+    if (after - before < best) {
+      best = after - before;
+      *ticks = before + (after - before) / 2;
+      *ns = now;
+    }
+  }
+}
+
+static void calibrate() {
+  if (!use_counter()) {
+    return;
+  }
+
+  uint64_t ticks0;
+  int64_t ns0;
+  read_counter_and_monotonic(&ticks0, &ns0);
+
+  uint64_t frequency = counter_frequency();
+  uint64_t mult;
+  if (frequency != 0) {
+    mult = (1000000000ULL << 32) / frequency;
+  } else {
+    // Measure the rate over 10ms, which is good to a few parts per million.
+    uint64_t ticks1;
+    int64_t ns1;
+    do {
+      read_counter_and_monotonic(&ticks1, &ns1);
+    } while (ns1 - ns0 < 10000000);
+    mult = (static_cast<uint64_t>(ns1 - ns0) << 32) / (ticks1 - ticks0);
+  }
+
+  g_calibration.base_ticks = ticks0;
+  g_calibration.base_ns = ns0;
+  g_calibration.mult = mult;
+}
+
+// Returns delta * mult / 2^32 without a 128-bit multiply.
+static inline uint64_t scale(uint64_t delta, uint64_t mult) {
+  uint64_t delta_hi = delta >> 32;
+  uint64_t delta_lo = delta & 0xffffffff;
+  uint64_t mult_hi = mult >> 32;
+  uint64_t mult_lo = mult & 0xffffffff;
+  return delta * mult_hi + delta_hi * mult_lo + ((delta_lo * mult_lo) >> 32);
+}
+
+static inline int64_t convert(const FastClockCalibration& c, uint64_t ticks) {
+  if (c.mult == 0) {
+    return ticks;
+  }
+  // Ticks from before calibration are fine too.
+  if (ticks >= c.base_ticks) {
+    return c.base_ns + scale(ticks - c.base_ticks, c.mult);
+  }
+  return c.base_ns - scale(c.base_ticks - ticks, c.mult);
+}
+
+int android_fast_clock_is_counter() {
+  return use_counter();
+}
+
+uint64_t android_fast_clock_ticks() {
+  return use_counter() ? read_counter() : monotonic_ns();
+}
+
+int64_t android_fast_clock_ticks_to_ns(uint64_t ticks) {
+  pthread_once(&g_calibration_once, calibrate);
+  return convert(g_calibration, ticks);
+}
+
+void android_fast_clock_ticks_to_ns_batch(const uint64_t* ticks, int64_t* ns, size_t n) {
+  pthread_once(&g_calibration_once, calibrate);
+  const FastClockCalibration c = g_calibration;
+  for (size_t i = 0; i < n; ++i) {
+    ns[i] = convert(c, ticks[i]);
+  }
+}
+
+int64_t android_fast_clock_ns() {
+  return android_fast_clock_ticks_to_ns(android_fast_clock_ticks());
+}
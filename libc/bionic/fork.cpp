@@ -34,7 +34,7 @@
 #define FORK_FLAGS (CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID | SIGCHLD)
 
 int fork() {
-  __bionic_atfork_run_prepare();
+  size_t atfork_handler_count = __bionic_atfork_run_prepare();
 
   pthread_internal_t* self = __get_thread();
 
@@ -47,11 +47,13 @@ int fork() {
   int result = syscall(__NR_clone, FORK_FLAGS, NULL, NULL, NULL, &(self->tid));
 #endif
   if (result == 0) {
-    self->set_cached_pid(gettid());
-    __bionic_atfork_run_child();
+    // CLONE_CHILD_SETTID gave us our new tid.
+    self->set_tls_tid();
+    self->set_cached_pid(self->tid);
+    __bionic_atfork_run_child(atfork_handler_count);
   } else {
     self->set_cached_pid(parent_pid);
-    __bionic_atfork_run_parent();
+    __bionic_atfork_run_parent(atfork_handler_count);
   }
   return result;
 }
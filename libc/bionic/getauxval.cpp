@@ -34,7 +34,24 @@
 
 __LIBC_HIDDEN__ ElfW(auxv_t)* __libc_auxv = NULL;
 
+// Every type the kernel currently passes is small, so they're looked up
+// directly; anything bigger falls back to searching the auxv.
+static const size_t kAuxvTableSize = 48;
+static unsigned long g_auxv_table[kAuxvTableSize];
+
+void __libc_init_auxv(ElfW(auxv_t)* auxv) {
+  __libc_auxv = auxv;
+  for (ElfW(auxv_t)* v = auxv; v->a_type != AT_NULL; ++v) {
+    if (v->a_type < kAuxvTableSize) {
+      g_auxv_table[v->a_type] = v->a_un.a_val;
+    }
+  }
+}
+
 extern "C" unsigned long int getauxval(unsigned long int type) {
+  if (type < kAuxvTableSize) {
+    return g_auxv_table[type];
+  }
   for (ElfW(auxv_t)* v = __libc_auxv; v->a_type != AT_NULL; ++v) {
     if (v->a_type == type) {
       return v->a_un.a_val;
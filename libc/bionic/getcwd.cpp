@@ -28,6 +28,9 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 extern "C" int __getcwd(char* buf, size_t size);
 
@@ -38,16 +41,27 @@ char* getcwd(char* buf, size_t size) {
     return NULL;
   }
 
+  // With size 0 we can't know how big a buffer to allocate until we have the answer,
+  // so get it into a buffer on the stack and copy it. The Linux kernel won't return
+  // more than PATH_MAX bytes.
+  // TODO: if we need to support paths longer than that, we'll have to walk the tree ourselves.
+  if (buf == NULL && size == 0) {
+    char tmp[PATH_MAX];
+    if (__getcwd(tmp, sizeof(tmp)) == -1) {
+      // __getcwd set errno.
+      return NULL;
+    }
+    buf = strdup(tmp);
+    if (buf == NULL) {
+      errno = ENOMEM;
+    }
+    return buf;
+  }
+
   // Allocate a buffer if necessary.
   char* allocated_buf = NULL;
-  size_t allocated_size = size;
   if (buf == NULL) {
-    if (size == 0) {
-      // The Linux kernel won't return more than a page, so translate size 0 to 4KiB.
-      // TODO: if we need to support paths longer than that, we'll have to walk the tree ourselves.
-      allocated_size = getpagesize();
-    }
-    buf = allocated_buf = static_cast<char*>(malloc(allocated_size));
+    buf = allocated_buf = static_cast<char*>(malloc(size));
     if (buf == NULL) {
       // malloc should set errno, but valgrind's malloc wrapper doesn't.
       errno = ENOMEM;
@@ -56,22 +70,12 @@ char* getcwd(char* buf, size_t size) {
   }
 
   // Ask the kernel to fill our buffer.
-  int rc = __getcwd(buf, allocated_size);
+  int rc = __getcwd(buf, size);
   if (rc == -1) {
     free(allocated_buf);
     // __getcwd set errno.
     return NULL;
   }
 
-  // If we allocated a whole page, only return as large an allocation as necessary.
-  if (allocated_buf != NULL) {
-    if (size == 0) {
-      buf = strdup(allocated_buf);
-      free(allocated_buf);
-    } else {
-      buf = allocated_buf;
-    }
-  }
-
   return buf;
 }
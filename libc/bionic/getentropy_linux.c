@@ -58,6 +58,25 @@
 #endif
 #include <sys/vfs.h>
 
+/*
+ * The kernel headers we build against predate getrandom(2), which needs no
+ * file descriptor and works in a chroot. Older kernels fail it with ENOSYS,
+ * and we fall back to /dev/urandom.
+ */
+#if defined(__aarch64__)
+#define SYS__getrandom 278
+#elif defined(__arm__)
+#define SYS__getrandom 384
+#elif defined(__i386__)
+#define SYS__getrandom 355
+#elif defined(__x86_64__)
+#define SYS__getrandom 318
+#elif defined(__mips__) && defined(__LP64__)
+#define SYS__getrandom 5313
+#elif defined(__mips__)
+#define SYS__getrandom 4353
+#endif
+
 #define REPEAT 5
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 
@@ -198,29 +217,19 @@ gotdata(char *buf, size_t len)
 static int
 getentropy_getrandom(void *buf, size_t len)
 {
-#if 0
-
-/* Hand-definitions until the API becomes commonplace */
-#ifndef SYS__getrandom
-#ifdef __LP64__
-#define SYS__getrandom 317
-#else
-#define SYS__getrandom 354
-#endif
-#endif
-	struct __getrandom_args args = {
-		.buf = buf;
-		.len = len;
-		.flags = 0;
-	};
+	int pre_errno = errno;
+	int ret;
 
 	if (len > 256)
 		return (-1);
-	ret = syscall(SYS__getrandom, &args);
-	if (ret == len)
-		return (0);
-#endif
-	return -1;
+	do {
+		ret = syscall(SYS__getrandom, buf, len, 0);
+	} while (ret == -1 && errno == EINTR);
+
+	if (ret != (int)len)
+		return (-1);
+	errno = pre_errno;
+	return (0);
 }
 #endif
 
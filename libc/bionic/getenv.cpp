@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "private/bionic_macros.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+// Processes can be started with hundreds of environment variables, and a
+// linear search for each getenv adds up. Large environments get a hash index
+// of the names in environ, built by the first getenv that needs it. It's
+// thrown away whenever environ might have changed: when environ itself is
+// replaced, or when putenv, setenv, unsetenv or clearenv is called. Programs
+// may also write to environ's array directly, so each lookup first checks the
+// array still holds the same entry pointers the index was built from, and
+// each hit is checked against the entry it points to, so an entry rewritten
+// in place is noticed too. Comparing pointers is still far cheaper than
+// comparing names.
+
+// Below this, a linear search is as quick as hashing.
+static const size_t kMinIndexedCount = 32;
+
+struct EnvSlot {
+  uint32_t hash;
+  uint32_t offset; // Plus one, so that 0 marks an empty slot.
+};
+
+struct EnvIndex {
+  char** environ;
+  unsigned generation;
+  size_t mapped_size;
+  size_t count;
+  char** entries; // The 'count' pointers environ held when this was built.
+  size_t mask;
+  EnvSlot slots[0];
+};
+
+static atomic_uint g_environ_generation = ATOMIC_VAR_INIT(0);
+static atomic_uintptr_t g_environ_index = ATOMIC_VAR_INIT(0);
+static pthread_mutex_t g_environ_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Called by whatever's about to modify environ.
+__LIBC_HIDDEN__ void __libc_environ_changed() {
+  atomic_fetch_add_explicit(&g_environ_generation, 1, memory_order_release);
+}
+
+static uint32_t hash_name(const char* name, size_t len) {
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(name[i])) * 16777619u;
+  }
+  return hash;
+}
+
+// Returns the value of 'entry' if it's the definition of the 'len'-byte 'name'.
+static char* match_entry(char* entry, const char* name, size_t len) {
+  if (strncmp(entry, name, len) == 0 && entry[len] == '=') {
+    return entry + len + 1;
+  }
+  return NULL;
+}
+
+static void free_index(EnvIndex* index) {
+  if (index != NULL) {
+    munmap(index, index->mapped_size);
+  }
+}
+
+// Indexes 'env', reusing the old index's memory if it's big enough.
+static EnvIndex* build_index(char** env, unsigned generation, EnvIndex* old) {
+  size_t count = 0;
+  while (env[count] != NULL) {
+    ++count;
+  }
+  if (count < kMinIndexedCount || count > UINT32_MAX - 1) {
+    free_index(old);
+    return NULL;
+  }
+
+  // Keep the table at most half full.
+  size_t slot_count = 1;
+  while (slot_count < 2 * count) {
+    slot_count *= 2;
+  }
+  size_t entries_offset = BIONIC_ALIGN(sizeof(EnvIndex) + slot_count * sizeof(EnvSlot),
+                                      sizeof(char*));
+  size_t size = BIONIC_ALIGN(entries_offset + count * sizeof(char*), PAGE_SIZE);
+  EnvIndex* index;
+  if (old != NULL && old->mapped_size >= size) {
+    index = old;
+    size = old->mapped_size;
+    memset(index->slots, 0, slot_count * sizeof(EnvSlot));
+  } else {
+    free_index(old);
+    // Not malloc: malloc implementations read their options with getenv.
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      return NULL;
+    }
+    index = reinterpret_cast<EnvIndex*>(map);
+  }
+  index->environ = env;
+  index->generation = generation;
+  index->mapped_size = size;
+  index->count = count;
+  index->entries = reinterpret_cast<char**>(reinterpret_cast<char*>(index) + entries_offset);
+  memcpy(index->entries, env, count * sizeof(char*));
+  index->mask = slot_count - 1;
+  for (size_t i = 0; i < count; ++i) {
+    const char* entry = env[i];
+    const char* eq = strchr(entry, '=');
+    if (eq == NULL) {
+      continue; // getenv can never find this.
+    }
+    size_t len = eq - entry;
+    uint32_t hash = hash_name(entry, len);
+    for (size_t slot = hash & index->mask; ; slot = (slot + 1) & index->mask) {
+      EnvSlot& s = index->slots[slot];
+      if (s.offset == 0) {
+        s.hash = hash;
+        s.offset = i + 1;
+        break;
+      }
+      // If a name is defined more than once, getenv returns the first.
+      if (s.hash == hash && match_entry(env[s.offset - 1], entry, len) != NULL) {
+        break;
+      }
+    }
+  }
+  return index;
+}
+
+// Returns an index that's up to date with environ, or NULL to search linearly.
+static EnvIndex* get_index() {
+  char** env = environ;
+  unsigned generation = atomic_load_explicit(&g_environ_generation, memory_order_acquire);
+  EnvIndex* index =
+      reinterpret_cast<EnvIndex*>(atomic_load_explicit(&g_environ_index, memory_order_acquire));
+  if (index != NULL && index->environ == env && index->generation == generation) {
+    return index;
+  }
+  if (env == NULL) {
+    return NULL;
+  }
+
+  ScopedPthreadMutexLocker locker(&g_environ_index_lock);
+  index = reinterpret_cast<EnvIndex*>(atomic_load_explicit(&g_environ_index, memory_order_relaxed));
+  if (index != NULL && index->environ == env && index->generation == generation) {
+    return index; // Another thread beat us to it.
+  }
+  // Nothing may be using the old index: the environment has been modified,
+  // and POSIX doesn't allow that to race with getenv.
+  index = build_index(env, generation, index);
+  atomic_store_explicit(&g_environ_index, reinterpret_cast<uintptr_t>(index), memory_order_release);
+  return index;
+}
+
+/*
+ * Returns pointer to value associated with name, if any, else NULL.
+ * Starts searching within the environmental array at offset.
+ * Sets offset to be the offset of the name/value combination in the
+ * environmental array, for use by putenv(3), setenv(3) and unsetenv(3),
+ * which are its only callers now that getenv has its own search.
+ */
+extern "C" __LIBC_HIDDEN__ char* __findenv(const char* name, int len, int* offset) {
+  // Our callers are all about to change environ.
+  __libc_environ_changed();
+
+  if (name == NULL || environ == NULL) {
+    return NULL;
+  }
+  for (char** p = environ + *offset; *p != NULL; ++p) {
+    char* value = match_entry(*p, name, len);
+    if (value != NULL) {
+      *offset = p - environ;
+      return value;
+    }
+  }
+  return NULL;
+}
+
+// Checks that 'env' still holds the pointers 'index' was built from.
+static bool index_matches(const EnvIndex* index, char** env) {
+  // Stop at the first difference: if the array has shrunk, its terminating
+  // NULL differs from the saved pointer, so we never read past it.
+  for (size_t i = 0; i < index->count; ++i) {
+    if (env[i] != index->entries[i]) {
+      return false;
+    }
+  }
+  return env[index->count] == NULL;
+}
+
+static char* find_linearly(char** env, const char* name, size_t len) {
+  for (char** p = env; *p != NULL; ++p) {
+    char* value = match_entry(*p, name, len);
+    if (value != NULL) {
+      return value;
+    }
+  }
+  return NULL;
+}
+
+char* getenv(const char* name) {
+  size_t len = strcspn(name, "=");
+  char** env = environ;
+  if (env == NULL) {
+    return NULL;
+  }
+
+  EnvIndex* index = get_index();
+  if (index == NULL || !index_matches(index, env)) {
+    return find_linearly(env, name, len);
+  }
+
+  uint32_t hash = hash_name(name, len);
+  for (size_t slot = hash & index->mask; ; slot = (slot + 1) & index->mask) {
+    const EnvSlot& s = index->slots[slot];
+    if (s.offset == 0) {
+      return NULL;
+    }
+    if (s.hash == hash) {
+      char* entry = index->entries[s.offset - 1];
+      char* value = match_entry(entry, name, len);
+      if (value != NULL) {
+        return value;
+      }
+      // The slot's entry has been rewritten in place, so don't trust the index.
+      const char* eq = strchr(entry, '=');
+      if (eq == NULL || hash_name(entry, eq - entry) != hash) {
+        return find_linearly(env, name, len);
+      }
+    }
+  }
+}
@@ -33,11 +33,10 @@
 extern "C" pid_t __getpid();
 
 pid_t getpid() {
-  pthread_internal_t* self = __get_thread();
-
-  // Do we have a valid cached pid?
-  pid_t cached_pid;
-  if (__predict_true(self->get_cached_pid(&cached_pid))) {
+  // Do we have a valid cached pid? It's in the same cache line as errno, so we
+  // don't go through __get_thread().
+  pid_t cached_pid = *__tls_pid_slot(__get_tls(), TLS_SLOT_CACHED_PID);
+  if (__predict_true(cached_pid != 0)) {
     return cached_pid;
   }
 
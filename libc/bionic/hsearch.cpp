@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <search.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// hcreate(3) and friends, plus the GNU reentrant versions. The size given
+// to hcreate is only a hint: the table doubles whenever it gets half full,
+// rather than refusing new entries as the traditional implementations do.
+// Entries live in chunks that never move, so the ENTRY pointers hsearch
+// returns stay good as the table grows.
+
+struct hsearch_slot {
+  size_t hash;
+  ENTRY* entry;
+};
+
+struct hsearch_chunk {
+  hsearch_chunk* next;
+  size_t used;
+  size_t capacity;
+  ENTRY entries[0];
+};
+
+struct __hsearch {
+  hsearch_slot* slots;
+  size_t slot_count;  // Always a power of two.
+  size_t entry_count;
+  hsearch_chunk* chunks;
+};
+
+// Don't believe callers who ask for a table bigger than this up front.
+static const size_t kMaxInitialSlots = 1 << 20;
+
+static size_t hash_key(const char* key) {
+  // FNV-1a.
+  size_t h = static_cast<size_t>(2166136261u);
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(key); *p != '\0'; ++p) {
+    h = (h ^ *p) * 16777619u;
+  }
+  return h;
+}
+
+static bool grow_slots(__hsearch* table) {
+  size_t new_count = table->slot_count * 2;
+  hsearch_slot* new_slots = reinterpret_cast<hsearch_slot*>(calloc(new_count, sizeof(hsearch_slot)));
+  if (new_slots == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < table->slot_count; ++i) {
+    const hsearch_slot& slot = table->slots[i];
+    if (slot.entry != NULL) {
+      size_t j = slot.hash & (new_count - 1);
+      while (new_slots[j].entry != NULL) {
+        j = (j + 1) & (new_count - 1);
+      }
+      new_slots[j] = slot;
+    }
+  }
+  free(table->slots);
+  table->slots = new_slots;
+  table->slot_count = new_count;
+  return true;
+}
+
+static ENTRY* new_entry(__hsearch* table) {
+  hsearch_chunk* chunk = table->chunks;
+  if (chunk == NULL || chunk->used == chunk->capacity) {
+    // Each chunk is as big as all the others put together.
+    size_t capacity = (chunk == NULL) ? 16 : table->entry_count;
+    hsearch_chunk* new_chunk =
+        reinterpret_cast<hsearch_chunk*>(malloc(sizeof(hsearch_chunk) + capacity * sizeof(ENTRY)));
+    if (new_chunk == NULL) {
+      return NULL;
+    }
+    new_chunk->next = chunk;
+    new_chunk->used = 0;
+    new_chunk->capacity = capacity;
+    table->chunks = chunk = new_chunk;
+  }
+  return &chunk->entries[chunk->used++];
+}
+
+int hcreate_r(size_t nel, hsearch_data* htab) {
+  if (htab == NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+  if (htab->__hsearch != NULL) {
+    return 0;
+  }
+
+  __hsearch* table = reinterpret_cast<__hsearch*>(calloc(1, sizeof(__hsearch)));
+  if (table == NULL) {
+    return 0;
+  }
+  table->slot_count = 16;
+  while (table->slot_count < kMaxInitialSlots && table->slot_count / 2 < nel) {
+    table->slot_count *= 2;
+  }
+  table->slots = reinterpret_cast<hsearch_slot*>(calloc(table->slot_count, sizeof(hsearch_slot)));
+  if (table->slots == NULL) {
+    free(table);
+    return 0;
+  }
+  htab->__hsearch = table;
+  return 1;
+}
+
+void hdestroy_r(hsearch_data* htab) {
+  if (htab == NULL || htab->__hsearch == NULL) {
+    return;
+  }
+  __hsearch* table = htab->__hsearch;
+  hsearch_chunk* chunk = table->chunks;
+  while (chunk != NULL) {
+    hsearch_chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(table->slots);
+  free(table);
+  htab->__hsearch = NULL;
+}
+
+int hsearch_r(ENTRY item, ACTION action, ENTRY** retval, hsearch_data* htab) {
+  __hsearch* table = (htab != NULL) ? htab->__hsearch : NULL;
+  if (table == NULL) {
+    *retval = NULL;
+    errno = EINVAL;
+    return 0;
+  }
+
+  size_t hash = hash_key(item.key);
+  size_t mask = table->slot_count - 1;
+  size_t i = hash & mask;
+  while (table->slots[i].entry != NULL) {
+    const hsearch_slot& slot = table->slots[i];
+    if (slot.hash == hash && strcmp(slot.entry->key, item.key) == 0) {
+      *retval = slot.entry;
+      return 1;
+    }
+    i = (i + 1) & mask;
+  }
+
+  if (action == FIND) {
+    *retval = NULL;
+    errno = ESRCH;
+    return 0;
+  }
+
+  if ((table->entry_count + 1) * 2 > table->slot_count) {
+    if (!grow_slots(table)) {
+      *retval = NULL;
+      errno = ENOMEM;
+      return 0;
+    }
+    mask = table->slot_count - 1;
+    i = hash & mask;
+    while (table->slots[i].entry != NULL) {
+      i = (i + 1) & mask;
+    }
+  }
+  ENTRY* entry = new_entry(table);
+  if (entry == NULL) {
+    *retval = NULL;
+    errno = ENOMEM;
+    return 0;
+  }
+  *entry = item;
+  table->slots[i].hash = hash;
+  table->slots[i].entry = entry;
+  ++table->entry_count;
+  *retval = entry;
+  return 1;
+}
+
+// The traditional interface's single table.
+static hsearch_data g_htab;
+
+int hcreate(size_t nel) {
+  return hcreate_r(nel, &g_htab);
+}
+
+void hdestroy() {
+  hdestroy_r(&g_htab);
+}
+
+ENTRY* hsearch(ENTRY item, ACTION action) {
+  ENTRY* result;
+  return hsearch_r(item, action, &result, &g_htab) ? result : NULL;
+}
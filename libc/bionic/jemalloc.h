@@ -18,16 +18,26 @@
 #define LIBC_BIONIC_JEMALLOC_H_
 
 #include <jemalloc/jemalloc.h>
+#include <stdint.h>
+#include <stdio.h>
 
 // Need to wrap memalign since je_memalign fails on non-power of 2 alignments.
 #define je_memalign je_memalign_round_up_boundary
 
 __BEGIN_DECLS
 
+void je_free_sized(void*, size_t);
 struct mallinfo je_mallinfo();
 void* je_memalign_round_up_boundary(size_t, size_t);
 void* je_pvalloc(size_t);
 
+void je_malloc_disable();
+void je_malloc_enable();
+int je_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*);
+int je_malloc_info(int, FILE*);
+int je_malloc_trim(size_t);
+int je_mallopt(int, int);
+
 __END_DECLS
 
 #endif  // LIBC_BIONIC_DLMALLOC_H_
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <sys/param.h>
 #include <unistd.h>
 
@@ -29,6 +33,13 @@ void* je_pvalloc(size_t bytes) {
   return je_memalign(pagesize, size);
 }
 
+// sdallocx goes straight to the size class rather than looking the pointer up.
+void je_free_sized(void* mem, size_t bytes) {
+  if (mem != NULL) {
+    je_sdallocx(mem, bytes, 0);
+  }
+}
+
 #ifdef je_memalign
 #undef je_memalign
 #endif
@@ -46,3 +57,96 @@ void* je_memalign_round_up_boundary(size_t boundary, size_t size) {
   }
   return je_memalign(boundary, size);
 }
+
+// jemalloc's fork handlers take and release every one of its locks.
+extern "C" void je_jemalloc_prefork();
+extern "C" void je_jemalloc_postfork_parent();
+
+void je_malloc_disable() {
+  je_jemalloc_prefork();
+}
+
+void je_malloc_enable() {
+  je_jemalloc_postfork_parent();
+}
+
+// jemalloc has no interface for walking its extents and runs.
+int je_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*) {
+  errno = ENOTSUP;
+  return -1;
+}
+
+static void write_to_file(void* fp, const char* s) {
+  fputs(s, reinterpret_cast<FILE*>(fp));
+}
+
+// jemalloc's own statistics report already breaks usage down by arena and bin.
+int je_malloc_info(int options, FILE* fp) {
+  if (options != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  je_malloc_stats_print(write_to_file, fp, NULL);
+  return ferror(fp) ? -1 : 0;
+}
+
+// jemalloc keeps no top-of-heap to trim, so pad is ignored: purging drops
+// every unused dirty page of every arena.
+int je_malloc_trim(size_t) {
+  // Purging the arena numbered narenas purges them all.
+  unsigned narenas;
+  size_t size = sizeof(narenas);
+  if (je_mallctl("arenas.narenas", &narenas, &size, NULL, 0) != 0) {
+    return 0;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "arena.%u.purge", narenas);
+  return (je_mallctl(name, NULL, NULL, NULL, 0) == 0) ? 1 : 0;
+}
+
+static volatile bool g_segregate_on_fork = false;
+
+// jemalloc frees a block into the arena it came from, wherever it's freed,
+// so blocks from the parent's arenas still dirty their pages when the child
+// frees them. What the child allocates from here on goes to a fresh arena,
+// though. Threads the child creates later are spread across the existing
+// arenas as usual.
+static void je_segregate_heap() {
+  if (!g_segregate_on_fork) {
+    return;
+  }
+  unsigned arena;
+  size_t size = sizeof(arena);
+  if (je_mallctl("arenas.extend", &arena, &size, NULL, 0) == 0) {
+    je_mallctl("thread.arena", NULL, NULL, &arena, sizeof(arena));
+  }
+}
+
+static pthread_once_t g_fork_handler_once = PTHREAD_ONCE_INIT;
+static bool g_fork_handler_registered = false;
+
+static void register_fork_handler() {
+  g_fork_handler_registered = (pthread_atfork(NULL, NULL, je_segregate_heap) == 0);
+}
+
+int je_mallopt(int param, int value) {
+  switch (param) {
+    case M_PURGE:
+      return je_malloc_trim(0);
+    case M_THREAD_CACHE: {
+      bool enabled = (value != 0);
+      return (je_mallctl("thread.tcache.enabled", NULL, NULL, &enabled, sizeof(enabled)) == 0) ? 1 : 0;
+    }
+    case M_SEGREGATE_ON_FORK:
+      pthread_once(&g_fork_handler_once, register_fork_handler);
+      if (!g_fork_handler_registered) {
+        return 0;
+      }
+      g_segregate_on_fork = (value != 0);
+      return 1;
+    default:
+      // The arena count is fixed when jemalloc initializes, and the
+      // dlmalloc thresholds have no jemalloc equivalent.
+      return 0;
+  }
+}
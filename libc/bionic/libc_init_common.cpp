@@ -39,7 +39,10 @@
 #include <unistd.h>
 
 #include "private/bionic_auxv.h"
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_percpu.h"
 #include "private/bionic_ssp.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
 #include "pthread_internal.h"
@@ -72,16 +75,15 @@ uintptr_t __stack_chk_guard = 0;
  * picked up by the libc constructor.
  */
 void __libc_init_tls(KernelArgumentBlock& args) {
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
 
-  static void* tls[BIONIC_TLS_SLOTS];
+  static void* tls[BIONIC_TLS_SLOTS] __attribute__((aligned(BIONIC_TLS_ALIGNMENT)));
   static pthread_internal_t main_thread;
   main_thread.tls = tls;
 
   // Tell the kernel to clear our tid field when we exit, so we're like any other pthread.
   // As a side-effect, this tells us our pid (which is the same as the main thread's tid).
   main_thread.tid = __set_tid_address(&main_thread.tid);
-  main_thread.set_cached_pid(main_thread.tid);
 
   // We don't want to free the main thread's stack even when the main thread exits
   // because things like environment variables with global scope live on it.
@@ -95,8 +97,11 @@ void __libc_init_tls(KernelArgumentBlock& args) {
 
   __init_thread(&main_thread, false);
   __init_tls(&main_thread);
+  main_thread.set_tls_tid();
+  main_thread.set_cached_pid(main_thread.tid);
   __set_tls(main_thread.tls);
   tls[TLS_SLOT_BIONIC_PREINIT] = &args;
+  __rseq_register_current_thread();
 
   __init_alternate_signal_stack(&main_thread);
 }
@@ -105,9 +110,13 @@ void __libc_init_common(KernelArgumentBlock& args) {
   // Initialize various globals.
   environ = args.envp;
   errno = 0;
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
   __progname = args.argv[0] ? args.argv[0] : "<unknown>";
   __abort_message_ptr = args.abort_message_ptr;
+  __libc_tls_modules = args.tls_modules;
+  if (__libc_tls_modules != NULL) {
+    __libc_tls_modules->get_addr = __tls_get_addr;
+  }
 
   // AT_RANDOM is a pointer to 16 bytes of randomness on the stack.
   __stack_chk_guard = *reinterpret_cast<uintptr_t*>(getauxval(AT_RANDOM));
@@ -116,9 +125,15 @@ void __libc_init_common(KernelArgumentBlock& args) {
   pthread_internal_t* main_thread = __get_thread();
   _pthread_internal_add(main_thread);
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_LIBC_PROPERTIES);
   __system_properties_init(); // Requires 'environ'.
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_LIBC_VDSO);
   __libc_init_vdso();
+
+#if defined(__aarch64__) || defined(__x86_64__)
+  __libc_init_cache_info();
+#endif
 }
 
 /* This function will be called during normal program termination
@@ -51,6 +51,9 @@ __END_DECLS
 #if defined(__cplusplus)
 class KernelArgumentBlock;
 __LIBC_HIDDEN__ void __libc_init_common(KernelArgumentBlock& args);
+#if defined(__aarch64__) || defined(__x86_64__)
+__LIBC_HIDDEN__ void __libc_init_cache_info();
+#endif
 #endif
 
 #endif
@@ -50,12 +50,16 @@
 #include <elf.h>
 #include "libc_init_common.h"
 
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
+#include "private/libc_logging.h"
 
 extern "C" {
   extern void malloc_debug_init(void);
   extern void malloc_debug_fini(void);
+  extern void mutex_contention_init(void);
+  extern void mutex_contention_fini(void);
   extern void netdClientInit(void);
   extern int __cxa_atexit(void (*)(void *), void *, void *);
 };
@@ -74,16 +78,24 @@ __attribute__((constructor)) static void __libc_preinit() {
   // __libc_init_common() will change the TLS area so the old one won't be accessible anyway.
   *args_slot = NULL;
 
+  __libc_startup_trace_init(*args);
+  __libc_startup_trace_mark(ANDROID_STARTUP_LIBC_INIT);
   __libc_init_common(*args);
 
   // Hooks for various libraries to let them know that we're starting up.
   malloc_debug_init();
+  mutex_contention_init();
   netdClientInit();
+  __libc_async_log_init();
+
+  __libc_startup_trace_mark(ANDROID_STARTUP_CONSTRUCTORS);
 }
 
 __LIBC_HIDDEN__ void __libc_postfini() {
-  // A hook for the debug malloc library to let it know that we're shutting down.
+  // Hooks for the debug libraries to let them know that we're shutting down.
+  mutex_contention_fini();
   malloc_debug_fini();
+  __libc_async_log_fini();
 }
 
 // This function is called from the executable's _start entry point
@@ -110,5 +122,6 @@ __noreturn void __libc_init(void* raw_args,
     __cxa_atexit(__libc_fini,structors->fini_array,NULL);
   }
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_MAIN);
   exit(slingshot(args.argc, args.argv, args.envp));
 }
@@ -35,6 +35,10 @@
  *
  * The 'structors' parameter contains pointers to various initializer
  * arrays that must be run before the program's 'main' routine is launched.
+ *
+ * Static executables may also be PIE ("static-PIE"): the kernel loads them
+ * at a random address like any other ET_DYN, and there's no dynamic linker
+ * to relocate them, so __libc_init does that itself before anything else.
  */
 
 #include <elf.h>
@@ -49,6 +53,9 @@
 #include "libc_init_common.h"
 #include "pthread_internal.h"
 
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_ifunc.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
 
@@ -68,7 +75,7 @@ static void call_array(void(**list)()) {
   }
 }
 
-static void apply_gnu_relro() {
+static void apply_gnu_relro(ElfW(Addr) load_bias) {
   ElfW(Phdr)* phdr_start = reinterpret_cast<ElfW(Phdr)*>(getauxval(AT_PHDR));
   unsigned long int phdr_ct = getauxval(AT_PHNUM);
 
@@ -77,27 +84,181 @@ static void apply_gnu_relro() {
       continue;
     }
 
-    ElfW(Addr) seg_page_start = PAGE_START(phdr->p_vaddr);
-    ElfW(Addr) seg_page_end = PAGE_END(phdr->p_vaddr + phdr->p_memsz);
+    ElfW(Addr) seg_page_start = PAGE_START(phdr->p_vaddr + load_bias);
+    ElfW(Addr) seg_page_end = PAGE_END(phdr->p_vaddr + phdr->p_memsz + load_bias);
 
     // Check return value here? What do we do if we fail?
     mprotect(reinterpret_cast<void*>(seg_page_start), seg_page_end - seg_page_start, PROT_READ);
   }
 }
 
-__noreturn void __libc_init(void* raw_args,
-                            void (*onexit)(void) __unused,
-                            int (*slingshot)(int, char**, char**),
-                            structors_array_t const * const structors) {
+// Android uses RELA for aarch64 and x86_64. mips static executables can't be PIE.
+#if defined(__aarch64__) || defined(__x86_64__)
+#define USE_RELA 1
+#endif
+
+#if defined(__LP64__)
+#define ELFW(what) ELF64_ ## what
+#else
+#define ELFW(what) ELF32_ ## what
+#endif
+
+#if defined(__aarch64__)
+#define R_STATIC_RELATIVE R_AARCH64_RELATIVE
+#define R_STATIC_IRELATIVE R_AARCH64_IRELATIVE
+#elif defined(__arm__)
+#define R_STATIC_RELATIVE R_ARM_RELATIVE
+#define R_STATIC_IRELATIVE R_ARM_IRELATIVE
+#elif defined(__i386__)
+#define R_STATIC_RELATIVE R_386_RELATIVE
+#define R_STATIC_IRELATIVE R_386_IRELATIVE
+#elif defined(__x86_64__)
+#define R_STATIC_RELATIVE R_X86_64_RELATIVE
+#define R_STATIC_IRELATIVE R_X86_64_IRELATIVE
+#endif
+
+#if defined(R_STATIC_RELATIVE)
+
+#if defined(USE_RELA)
+typedef ElfW(Rela) static_rel_t;
+#define DT_STATIC_REL DT_RELA
+#define DT_STATIC_RELSZ DT_RELASZ
+// The static linker brackets a non-PIE static executable's IRELATIVE
+// relocations with these.
+extern "C" const static_rel_t __rela_iplt_start[] __attribute__((weak, visibility("hidden")));
+extern "C" const static_rel_t __rela_iplt_end[] __attribute__((weak, visibility("hidden")));
+#define IPLT_START __rela_iplt_start
+#define IPLT_END __rela_iplt_end
+#else
+typedef ElfW(Rel) static_rel_t;
+#define DT_STATIC_REL DT_REL
+#define DT_STATIC_RELSZ DT_RELSZ
+extern "C" const static_rel_t __rel_iplt_start[] __attribute__((weak, visibility("hidden")));
+extern "C" const static_rel_t __rel_iplt_end[] __attribute__((weak, visibility("hidden")));
+#define IPLT_START __rel_iplt_start
+#define IPLT_END __rel_iplt_end
+#endif
+
+// Defined by the static linker at the start of the first PT_LOAD. It has to be
+// hidden and not weak, so that taking its address doesn't need the GOT.
+extern "C" const char __executable_start[] __attribute__((visibility("hidden")));
+
+// Everything from here to relocate_static_executable runs before the
+// executable's relocations have been applied: it mustn't touch global data,
+// take the address of a function, or call anything that might. That's also
+// why the auxv is parsed by hand rather than with KernelArgumentBlock, whose
+// address being taken would earn __libc_init a stack protector check.
+
+static unsigned long find_auxval(void* raw_args, unsigned long type) {
+  uintptr_t* args = reinterpret_cast<uintptr_t*>(raw_args);
+  char** envp = reinterpret_cast<char**>(args + 1 + *args + 1);
+  while (*envp != NULL) {
+    ++envp;
+  }
+  for (ElfW(auxv_t)* v = reinterpret_cast<ElfW(auxv_t)*>(envp + 1); v->a_type != AT_NULL; ++v) {
+    if (v->a_type == type) {
+      return v->a_un.a_val;
+    }
+  }
+  return 0;
+}
+
+static void apply_static_relocations(const static_rel_t* begin, const static_rel_t* end,
+                                     ElfW(Addr) load_bias, unsigned long hwcap, bool irelative) {
+  for (const static_rel_t* rel = begin; rel != end; ++rel) {
+    ElfW(Addr)* target = reinterpret_cast<ElfW(Addr)*>(rel->r_offset + load_bias);
+    unsigned type = ELFW(R_TYPE)(rel->r_info);
+#if defined(USE_RELA)
+    ElfW(Addr) addend = rel->r_addend;
+#else
+    ElfW(Addr) addend = *target;
+#endif
+    if (!irelative && type == R_STATIC_RELATIVE) {
+      *target = addend + load_bias;
+    } else if (irelative && type == R_STATIC_IRELATIVE) {
+      *target = __bionic_call_ifunc_resolver(addend + load_bias, hwcap);
+    }
+  }
+}
+
+// Applies a static-PIE executable's relocative relocations, and any static
+// executable's IRELATIVE ones. Returns the load bias. The static linker
+// resolves everything else, so that's all there can be; packed relocations
+// are only ever produced for the dynamic linker to apply.
+static ElfW(Addr) relocate_static_executable(void* raw_args) {
+  const ElfW(Phdr)* phdr = reinterpret_cast<const ElfW(Phdr)*>(find_auxval(raw_args, AT_PHDR));
+  size_t phnum = find_auxval(raw_args, AT_PHNUM);
+  unsigned long hwcap = find_auxval(raw_args, AT_HWCAP);
+
+  // There's not necessarily a PT_PHDR without a PT_INTERP, so the load bias
+  // comes from where the first PT_LOAD actually is.
+  const ElfW(Phdr)* dynamic_phdr = NULL;
+  ElfW(Addr) load_bias = 0;
+  for (size_t i = 0; i < phnum; ++i) {
+    if (phdr[i].p_type == PT_DYNAMIC) {
+      dynamic_phdr = &phdr[i];
+    } else if (phdr[i].p_type == PT_LOAD && phdr[i].p_offset == 0) {
+      load_bias = reinterpret_cast<ElfW(Addr)>(__executable_start) - phdr[i].p_vaddr;
+    }
+  }
+  if (dynamic_phdr == NULL) {
+    // Not PIE: only the IFUNCs need resolving.
+    apply_static_relocations(IPLT_START, IPLT_END, 0, hwcap, true);
+    return 0;
+  }
+
+  // The IRELATIVE relocations are usually in the PLT's table rather than the
+  // main one, which is why both are looked for.
+  const static_rel_t* rel = NULL;
+  size_t rel_size = 0;
+  const static_rel_t* plt_rel = NULL;
+  size_t plt_rel_size = 0;
+  const ElfW(Dyn)* dynamic = reinterpret_cast<const ElfW(Dyn)*>(dynamic_phdr->p_vaddr + load_bias);
+  for (const ElfW(Dyn)* d = dynamic; d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_STATIC_REL) {
+      rel = reinterpret_cast<const static_rel_t*>(d->d_un.d_ptr + load_bias);
+    } else if (d->d_tag == DT_STATIC_RELSZ) {
+      rel_size = d->d_un.d_val;
+    } else if (d->d_tag == DT_JMPREL) {
+      plt_rel = reinterpret_cast<const static_rel_t*>(d->d_un.d_ptr + load_bias);
+    } else if (d->d_tag == DT_PLTRELSZ) {
+      plt_rel_size = d->d_un.d_val;
+    }
+  }
+  const static_rel_t* rel_end = rel + rel_size / sizeof(static_rel_t);
+  const static_rel_t* plt_rel_end = plt_rel + plt_rel_size / sizeof(static_rel_t);
+
+  // IFUNC resolvers may use relocated data, so they go last.
+  apply_static_relocations(rel, rel_end, load_bias, hwcap, false);
+  apply_static_relocations(plt_rel, plt_rel_end, load_bias, hwcap, false);
+  apply_static_relocations(rel, rel_end, load_bias, hwcap, true);
+  apply_static_relocations(plt_rel, plt_rel_end, load_bias, hwcap, true);
+  return load_bias;
+}
+
+#else
+
+static ElfW(Addr) relocate_static_executable(void*) {
+  return 0;
+}
+
+#endif
+
+__attribute__((noinline))
+static __noreturn void __real_libc_init(void* raw_args,
+                                        int (*slingshot)(int, char**, char**),
+                                        structors_array_t const * const structors,
+                                        ElfW(Addr) load_bias) {
   KernelArgumentBlock args(raw_args);
   __libc_init_tls(args);
+  __libc_startup_trace_init(args);
+  __libc_startup_trace_mark(ANDROID_STARTUP_LIBC_INIT);
+  __libc_init_static_tls(args, load_bias);
   __libc_init_common(args);
 
-  apply_gnu_relro();
-
-  // Several Linux ABIs don't pass the onexit pointer, and the ones that
-  // do never use it.  Therefore, we ignore it.
+  apply_gnu_relro(load_bias);
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_CONSTRUCTORS);
   call_array(structors->preinit_array);
   call_array(structors->init_array);
 
@@ -108,5 +269,18 @@ __noreturn void __libc_init(void* raw_args,
     __cxa_atexit(__libc_fini,structors->fini_array,NULL);
   }
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_MAIN);
   exit(slingshot(args.argc, args.argv, args.envp));
 }
+
+// Nothing but the relocation may happen here, and only once it's done can
+// __real_libc_init take the address of anything.
+__noreturn void __libc_init(void* raw_args,
+                            void (*onexit)(void) __unused,
+                            int (*slingshot)(int, char**, char**),
+                            structors_array_t const * const structors) {
+  // Several Linux ABIs don't pass the onexit pointer, and the ones that
+  // do never use it.  Therefore, we ignore it.
+  ElfW(Addr) load_bias = relocate_static_executable(raw_args);
+  __real_libc_init(raw_args, slingshot, structors, load_bias);
+}
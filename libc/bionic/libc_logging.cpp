@@ -28,6 +28,7 @@
 
 #include "../private/libc_logging.h" // Relative path so we can #include this .cpp file for testing.
 #include "../private/ScopedPthreadMutexLocker.h"
+#include "../private/bionic_futex.h"
 
 #include <android/set_abort_message.h>
 #include <assert.h>
@@ -35,11 +36,14 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/system_properties.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <sys/un.h>
@@ -446,6 +450,19 @@ static int __libc_write_stderr(const char* tag, const char* msg) {
 }
 
 #ifdef TARGET_USES_LOGD
+static int __libc_connect_log_socket(int log_fd) {
+  union {
+    struct sockaddr    addr;
+    struct sockaddr_un addrUn;
+  } u;
+  memset(&u, 0, sizeof(u));
+  u.addrUn.sun_family = AF_UNIX;
+  strlcpy(u.addrUn.sun_path, "/dev/socket/logdw", sizeof(u.addrUn.sun_path));
+
+  return TEMP_FAILURE_RETRY(connect(log_fd, &u.addr, sizeof(u.addrUn)));
+}
+
+// Returns a new blocking socket connected to logd, or -1.
 static int __libc_open_log_socket()
 {
   // ToDo: Ideally we want this to fail if the gid of the current
@@ -459,40 +476,355 @@ static int __libc_open_log_socket()
     return -1;
   }
 
-  if (fcntl(log_fd, F_SETFL, O_NONBLOCK) == -1) {
+  if (__libc_connect_log_socket(log_fd) != 0) {
     close(log_fd);
     return -1;
   }
 
-  union {
-    struct sockaddr    addr;
-    struct sockaddr_un addrUn;
-  } u;
-  memset(&u, 0, sizeof(u));
-  u.addrUn.sun_family = AF_UNIX;
-  strlcpy(u.addrUn.sun_path, "/dev/socket/logdw", sizeof(u.addrUn.sun_path));
+  return log_fd;
+}
 
-  if (TEMP_FAILURE_RETRY(connect(log_fd, &u.addr, sizeof(u.addrUn))) != 0) {
-    close(log_fd);
+// The socket that synchronous log writes share, opened by the first of them,
+// the process that opened it, and its inode. A forked child opens its own
+// rather than trust that the inherited descriptor hasn't been closed and
+// reused; the inherited one is close-on-exec, and closing it might close
+// something else. Likewise, code that closes descriptors it doesn't own can
+// leave the number naming some other file, so each use checks that it's
+// still the same socket; if not, it's left alone and a new one opened.
+static atomic_int g_log_fd = ATOMIC_VAR_INIT(-1);
+static atomic_int g_log_fd_pid = ATOMIC_VAR_INIT(0);
+static atomic_ullong g_log_fd_ino = ATOMIC_VAR_INIT(0);
+
+static bool __libc_is_log_socket(int log_fd) {
+  struct stat sb;
+  return fstat(log_fd, &sb) == 0 && S_ISSOCK(sb.st_mode) &&
+      sb.st_ino == atomic_load(&g_log_fd_ino);
+}
+
+static int __libc_get_log_socket() {
+  pid_t pid = getpid();
+  int log_fd = atomic_load(&g_log_fd);
+  if (__predict_true(log_fd != -1 && atomic_load(&g_log_fd_pid) == pid &&
+                     __libc_is_log_socket(log_fd))) {
+    return log_fd;
+  }
+
+  int new_fd = __libc_open_log_socket();
+  if (new_fd == -1) {
     return -1;
   }
+  struct stat sb;
+  if (fstat(new_fd, &sb) == -1) {
+    close(new_fd);
+    return -1;
+  }
+  atomic_store(&g_log_fd_pid, pid);
+  atomic_store(&g_log_fd_ino, static_cast<unsigned long long>(sb.st_ino));
+  if (!atomic_compare_exchange_strong(&g_log_fd, &log_fd, new_fd)) {
+    // Another thread got there first.
+    close(new_fd);
+    return log_fd;
+  }
+  return new_fd;
+}
 
-  return log_fd;
+// Writes one message to logd without blocking: if logd is behind, the
+// message is dropped. If logd has restarted, the shared socket is reconnected
+// in place, so no other thread can find its descriptor closed underneath it.
+static int __libc_send_log(iovec* vec, size_t count) {
+  int log_fd = __libc_get_log_socket();
+  if (log_fd == -1) {
+    return -1;
+  }
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = vec;
+  msg.msg_iovlen = count;
+  int result = TEMP_FAILURE_RETRY(sendmsg(log_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL));
+  if (result == -1 && (errno == ECONNREFUSED || errno == EPIPE || errno == ENOTCONN)) {
+    if (__libc_connect_log_socket(log_fd) == 0) {
+      result = TEMP_FAILURE_RETRY(sendmsg(log_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL));
+    }
+  }
+  return result;
 }
 
 struct log_time { // Wire format
   uint32_t tv_sec;
   uint32_t tv_nsec;
 };
+
+// Opt-in asynchronous logging: setting libc.debug.async_log (or
+// LIBC_DEBUG_ASYNC_LOG in the environment) to 1 makes callers copy messages
+// into a lock-free ring rather than making a system call each, and a
+// background thread sends them to logd in batches over a socket of its own.
+// Messages that find the ring full are dropped and counted, and the count is
+// logged once there's room. Fatal messages are
+// still written synchronously since the process is about to die, and a forked
+// child goes back to writing synchronously. Only libc.so turns this on: the
+// other copies of this file, such as the linker's, always write synchronously.
+
+// A power of two.
+static const unsigned kAsyncLogSlots = 64;
+// How many messages the drainer sends with one sendmmsg.
+static const unsigned kAsyncLogBatch = 16;
+// Room for a tag and a message as __libc_format_log formats it.
+static const size_t kAsyncLogTextSize = 1024 + 64;
+
+struct AsyncLogSlot {
+  // Vyukov's bounded queue: a slot is free for the producer at position p
+  // when seq == p, and full for the consumer when seq == p + 1.
+  atomic_uint seq;
+  char log_id;
+  char priority;
+  uint16_t tid;
+  log_time realtime_ts;
+  uint16_t tag_size; // Including the terminating NUL, like msg_size.
+  uint16_t msg_size;
+  char text[kAsyncLogTextSize];
+};
+
+struct AsyncLog {
+  atomic_uint tail;
+  atomic_uint head; // Only the drainer moves it.
+  atomic_int drainer_sleeping;
+  atomic_uint dropped;
+  int fd; // The drainer's, or -1.
+  AsyncLogSlot slots[kAsyncLogSlots];
+};
+
+static AsyncLog* g_async_log;
+
+static int __libc_async_log_write(AsyncLog* log, int priority, const char* tag, const char* msg) {
+  unsigned pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+  AsyncLogSlot* slot;
+  while (true) {
+    slot = &log->slots[pos & (kAsyncLogSlots - 1)];
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    int diff = static_cast<int>(seq - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&log->tail, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Full.
+      atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+      return -1;
+    } else {
+      pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+    }
+  }
+
+  slot->log_id = LOG_ID_MAIN;
+  slot->priority = priority;
+  slot->tid = gettid();
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  slot->realtime_ts.tv_sec = ts.tv_sec;
+  slot->realtime_ts.tv_nsec = ts.tv_nsec;
+  size_t tag_size = strlcpy(slot->text, tag, 64) + 1;
+  if (tag_size > 64) {
+    tag_size = 64;
+  }
+  size_t msg_size = strlcpy(slot->text + tag_size, msg, kAsyncLogTextSize - tag_size) + 1;
+  if (msg_size > kAsyncLogTextSize - tag_size) {
+    msg_size = kAsyncLogTextSize - tag_size;
+  }
+  slot->tag_size = tag_size;
+  slot->msg_size = msg_size;
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+  if (atomic_exchange(&log->drainer_sleeping, 0) == 1) {
+    __futex_wake(&log->drainer_sleeping, 1);
+  }
+  return msg_size - 1;
+}
+
+static void __libc_async_log_fill_iovec(iovec* vec, AsyncLogSlot* slot) {
+  vec[0].iov_base = &slot->log_id;
+  vec[0].iov_len = sizeof(slot->log_id);
+  vec[1].iov_base = &slot->tid;
+  vec[1].iov_len = sizeof(slot->tid);
+  vec[2].iov_base = &slot->realtime_ts;
+  vec[2].iov_len = sizeof(slot->realtime_ts);
+  vec[3].iov_base = &slot->priority;
+  vec[3].iov_len = 1;
+  vec[4].iov_base = slot->text;
+  vec[4].iov_len = slot->tag_size;
+  vec[5].iov_base = slot->text + slot->tag_size;
+  vec[5].iov_len = slot->msg_size;
+}
+
+// Sends 'count' messages, reconnecting once if logd has gone away. Messages
+// that can't be sent are counted as dropped.
+static void __libc_async_log_send(AsyncLog* log, mmsghdr* msgs, unsigned count) {
+  unsigned sent = 0;
+  bool reconnected = false;
+  while (sent < count) {
+    if (log->fd == -1) {
+      // Unlike callers, the drainer can afford to wait for logd, so it has
+      // a blocking socket of its own.
+      log->fd = __libc_open_log_socket();
+      if (log->fd == -1) {
+        break;
+      }
+    }
+    int rc = TEMP_FAILURE_RETRY(sendmmsg(log->fd, msgs + sent, count - sent, 0));
+    if (rc > 0) {
+      sent += rc;
+    } else {
+      close(log->fd);
+      log->fd = -1;
+      if (reconnected) {
+        break;
+      }
+      reconnected = true;
+    }
+  }
+  if (sent < count) {
+    atomic_fetch_add_explicit(&log->dropped, count - sent, memory_order_relaxed);
+  }
+}
+
+static void* __libc_async_log_drain(void* arg) {
+  AsyncLog* log = reinterpret_cast<AsyncLog*>(arg);
+  mmsghdr msgs[kAsyncLogBatch + 1];
+  iovec vecs[kAsyncLogBatch + 1][6];
+  AsyncLogSlot dropped_slot;
+  memset(msgs, 0, sizeof(msgs));
+  for (unsigned i = 0; i <= kAsyncLogBatch; ++i) {
+    msgs[i].msg_hdr.msg_iov = vecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 6;
+  }
+
+  while (true) {
+    unsigned count = 0;
+
+    unsigned dropped = atomic_exchange_explicit(&log->dropped, 0, memory_order_relaxed);
+    if (dropped != 0) {
+      dropped_slot.log_id = LOG_ID_MAIN;
+      dropped_slot.priority = ANDROID_LOG_WARN;
+      dropped_slot.tid = gettid();
+      timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      dropped_slot.realtime_ts.tv_sec = ts.tv_sec;
+      dropped_slot.realtime_ts.tv_nsec = ts.tv_nsec;
+      strcpy(dropped_slot.text, "libc");
+      dropped_slot.tag_size = 5;
+      dropped_slot.msg_size = __libc_format_buffer(dropped_slot.text + 5, kAsyncLogTextSize - 5,
+                                                   "%u log messages dropped", dropped) + 1;
+      __libc_async_log_fill_iovec(vecs[count++], &dropped_slot);
+    }
+
+    unsigned head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    unsigned taken = 0;
+    while (taken < kAsyncLogBatch) {
+      AsyncLogSlot* slot = &log->slots[(head + taken) & (kAsyncLogSlots - 1)];
+      if (atomic_load_explicit(&slot->seq, memory_order_acquire) != head + taken + 1) {
+        break;
+      }
+      __libc_async_log_fill_iovec(vecs[count++], slot);
+      ++taken;
+    }
+
+    if (count == 0) {
+      // Tell producers to wake us, then look again in case one just missed it.
+      atomic_store(&log->drainer_sleeping, 1);
+      AsyncLogSlot* slot = &log->slots[head & (kAsyncLogSlots - 1)];
+      if (atomic_load(&slot->seq) == head + 1 ||
+          atomic_load_explicit(&log->dropped, memory_order_relaxed) != 0) {
+        atomic_store(&log->drainer_sleeping, 0);
+        continue;
+      }
+      __futex_wait(&log->drainer_sleeping, 1, NULL);
+      continue;
+    }
+
+    __libc_async_log_send(log, msgs, count);
+
+    // Only now can producers reuse the slots.
+    for (unsigned i = 0; i < taken; ++i) {
+      AsyncLogSlot* slot = &log->slots[(head + i) & (kAsyncLogSlots - 1)];
+      atomic_store_explicit(&slot->seq, head + i + kAsyncLogSlots, memory_order_release);
+    }
+    atomic_store_explicit(&log->head, head + taken, memory_order_release);
+  }
+  return NULL;
+}
+
+static void __libc_async_log_child() {
+  // The drainer didn't survive the fork.
+  g_async_log = NULL;
+}
+
+void __libc_async_log_init() {
+  char value[PROP_VALUE_MAX];
+  const char* enable = getenv("LIBC_DEBUG_ASYNC_LOG");
+  if (enable == NULL) {
+    if (!__system_property_get("libc.debug.async_log", value)) {
+      return;
+    }
+    enable = value;
+  }
+  if (atoi(enable) == 0) {
+    return;
+  }
+
+  void* map = mmap(NULL, sizeof(AsyncLog), PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+  if (map == MAP_FAILED) {
+    return;
+  }
+  AsyncLog* log = reinterpret_cast<AsyncLog*>(map);
+  for (unsigned i = 0; i < kAsyncLogSlots; ++i) {
+    atomic_init(&log->slots[i].seq, i);
+  }
+  log->fd = -1;
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_t drainer;
+  int rc = pthread_create(&drainer, &attr, __libc_async_log_drain, log);
+  pthread_attr_destroy(&attr);
+  if (rc != 0 || pthread_atfork(NULL, NULL, __libc_async_log_child) != 0) {
+    // Without a drainer nothing would be logged; a drainer that's started
+    // just sleeps.
+    if (rc != 0) {
+      munmap(map, sizeof(AsyncLog));
+    }
+    return;
+  }
+  g_async_log = log;
+}
+
+void __libc_async_log_fini() {
+  AsyncLog* log = g_async_log;
+  if (log == NULL) {
+    return;
+  }
+  // Give the drainer a moment to send what's queued.
+  for (int i = 0; i < 100; ++i) {
+    if (atomic_load(&log->head) == atomic_load(&log->tail)) {
+      break;
+    }
+    usleep(1000);
+  }
+}
+#else
+void __libc_async_log_init() {
+}
+
+void __libc_async_log_fini() {
+}
 #endif
 
 static int __libc_write_log(int priority, const char* tag, const char* msg) {
 #ifdef TARGET_USES_LOGD
-  int main_log_fd = __libc_open_log_socket();
-
-  if (main_log_fd == -1) {
-    // Try stderr instead.
-    return __libc_write_stderr(tag, msg);
+  AsyncLog* async_log = g_async_log;
+  if (async_log != NULL && priority != ANDROID_LOG_FATAL) {
+    return __libc_async_log_write(async_log, priority, tag, msg);
   }
 
   iovec vec[6];
@@ -516,6 +848,13 @@ static int __libc_write_log(int priority, const char* tag, const char* msg) {
   vec[4].iov_len = strlen(tag) + 1;
   vec[5].iov_base = const_cast<char*>(msg);
   vec[5].iov_len = strlen(msg) + 1;
+
+  int result = __libc_send_log(vec, sizeof(vec) / sizeof(vec[0]));
+  if (result == -1 && errno != EAGAIN) {
+    // Try stderr instead.
+    return __libc_write_stderr(tag, msg);
+  }
+  return result;
 #else
   int main_log_fd = TEMP_FAILURE_RETRY(open("/dev/log/main", O_CLOEXEC | O_WRONLY));
   if (main_log_fd == -1) {
@@ -533,11 +872,11 @@ static int __libc_write_log(int priority, const char* tag, const char* msg) {
   vec[1].iov_len = strlen(tag) + 1;
   vec[2].iov_base = const_cast<char*>(msg);
   vec[2].iov_len = strlen(msg) + 1;
-#endif
 
   int result = TEMP_FAILURE_RETRY(writev(main_log_fd, vec, sizeof(vec) / sizeof(vec[0])));
   close(main_log_fd);
   return result;
+#endif
 }
 
 int __libc_format_log_va_list(int priority, const char* tag, const char* format, va_list args) {
@@ -579,7 +918,7 @@ static int __libc_android_log_event(int32_t tag, char type, const void* payload,
   vec[5].iov_base = const_cast<void*>(payload);
   vec[5].iov_len = len;
 
-  int event_log_fd = __libc_open_log_socket();
+  return __libc_send_log(vec, sizeof(vec) / sizeof(vec[0]));
 #else
   iovec vec[3];
   vec[0].iov_base = &tag;
@@ -590,14 +929,13 @@ static int __libc_android_log_event(int32_t tag, char type, const void* payload,
   vec[2].iov_len = len;
 
   int event_log_fd = TEMP_FAILURE_RETRY(open("/dev/log/events", O_CLOEXEC | O_WRONLY));
-#endif
-
   if (event_log_fd == -1) {
     return -1;
   }
   int result = TEMP_FAILURE_RETRY(writev(event_log_fd, vec, sizeof(vec) / sizeof(vec[0])));
   close(event_log_fd);
   return result;
+#endif
 }
 
 void __libc_android_log_event_int(int32_t tag, int value) {
@@ -31,6 +31,7 @@
 #include <stdlib.h>
 
 #include "private/bionic_macros.h"
+#include "private/bionic_tls.h"
 
 // We currently support a single locale, the "C" locale (also known as "POSIX").
 
@@ -56,10 +57,10 @@ struct __locale_t {
 static pthread_once_t g_locale_once = PTHREAD_ONCE_INIT;
 static lconv g_locale;
 
-// We don't use pthread_once for this so that we know when the resource (a TLS slot) will be taken.
-static pthread_key_t g_uselocale_key;
-__attribute__((constructor)) static void __bionic_tls_uselocale_key_init() {
-  pthread_key_create(&g_uselocale_key, NULL);
+// uselocale(3)'s locale lives in a TLS slot of its own rather than a pthread key, so that
+// MB_CUR_MAX, which the multibyte functions check all the time, is just a load.
+static inline locale_t __get_thread_locale() {
+  return reinterpret_cast<locale_t>(__get_tls()[TLS_SLOT_LOCALE]);
 }
 
 static void __locale_init() {
@@ -93,7 +94,7 @@ static void __locale_init() {
 }
 
 size_t __ctype_get_mb_cur_max() {
-  locale_t l = reinterpret_cast<locale_t>(pthread_getspecific(g_uselocale_key));
+  locale_t l = __get_thread_locale();
   if (l == nullptr || l == LC_GLOBAL_LOCALE) {
     return __bionic_current_locale_is_utf8 ? 4 : 1;
   } else {
@@ -158,7 +159,7 @@ char* setlocale(int category, const char* locale_name) {
 }
 
 locale_t uselocale(locale_t new_locale) {
-  locale_t old_locale = static_cast<locale_t>(pthread_getspecific(g_uselocale_key));
+  locale_t old_locale = __get_thread_locale();
 
   // If this is the first call to uselocale(3) on this thread, we return LC_GLOBAL_LOCALE.
   if (old_locale == NULL) {
@@ -166,7 +167,7 @@ locale_t uselocale(locale_t new_locale) {
   }
 
   if (new_locale != NULL) {
-    pthread_setspecific(g_uselocale_key, new_locale);
+    __get_tls()[TLS_SLOT_LOCALE] = new_locale;
   }
 
   return old_locale;
@@ -47,7 +47,6 @@
 #include <unwind.h>
 #include <signal.h>
 
-#include "debug_mapinfo.h"
 #include "debug_stacktrace.h"
 #include "malloc_debug_backtrace.h"
 #include "malloc_debug_common.h"
@@ -60,6 +59,10 @@ extern unsigned int malloc_sig_enabled;
 extern unsigned int min_allocation_report_limit;
 extern unsigned int max_allocation_limit;
 extern char* process_name;
+extern size_t malloc_sample_interval;
+extern void init_allocation_sampling();
+extern size_t malloc_guard_slot_count;
+extern bool init_guard_pool();
 static size_t total_count = 0;
 static bool isDumped = false;
 static bool sigHandled = false;
@@ -622,6 +625,14 @@ extern "C" struct mallinfo chk_mallinfo() {
   return g_malloc_dispatch->mallinfo();
 }
 
+extern "C" int chk_malloc_trim(size_t pad) {
+  return g_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int chk_mallopt(int param, int value) {
+  return g_malloc_dispatch->mallopt(param, value);
+}
+
 extern "C" int chk_posix_memalign(void** memptr, size_t alignment, size_t size) {
   if (DebugCallsDisabled()) {
     return g_malloc_dispatch->posix_memalign(memptr, alignment, size);
@@ -695,6 +706,17 @@ static void ReportMemoryLeaks() {
 }
 
 pthread_key_t g_debug_calls_disabled;
+static pthread_once_t g_debug_calls_disabled_once = PTHREAD_ONCE_INIT;
+
+static void debug_calls_key_create() {
+  pthread_key_create(&g_debug_calls_disabled, NULL);
+}
+
+// Both malloc debugging and the mutex contention profiler use the key, and
+// either, or both, may be initialized.
+void debug_calls_init() {
+  pthread_once(&g_debug_calls_disabled_once, debug_calls_key_create);
+}
 
 #define DEBUG_SIGNAL SIGWINCH
 
@@ -702,7 +724,17 @@ extern "C" bool malloc_debug_initialize(HashTable* hash_table, const MallocDebug
   g_hash_table = hash_table;
   g_malloc_dispatch = malloc_dispatch;
 
-  pthread_key_create(&g_debug_calls_disabled, NULL);
+  debug_calls_init();
+
+  if (malloc_sample_interval != 0) {
+    info_log("%s: sampling allocations every %zu bytes on average\n", getprogname(),
+             malloc_sample_interval);
+    init_allocation_sampling();
+  }
+
+  if (malloc_guard_slot_count != 0 && !init_guard_pool()) {
+    return false;
+  }
 
   char debug_backlog[PROP_VALUE_MAX];
   if (__system_property_get("libc.debug.malloc.backlog", debug_backlog)) {
@@ -40,18 +40,24 @@
 
 #include "malloc_debug_common.h"
 
+#include <errno.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <unistd.h>
 
-#include "private/ScopedPthreadMutexLocker.h"
+#include "malloc_huge.h"
+#include "pthread_internal.h"
 
 #if defined(USE_JEMALLOC)
 #include "jemalloc.h"
 #define Malloc(function)  je_ ## function
+#define CachedMalloc(function)  je_ ## function
 #elif defined(USE_DLMALLOC)
 #include "dlmalloc.h"
+#include "malloc_thread_cache.h"
 #define Malloc(function)  dl ## function
+// Small allocations go through the per-thread caches.
+#define CachedMalloc(function)  thread_cache_ ## function
 #else
 #error "Either one of USE_DLMALLOC or USE_JEMALLOC must be defined."
 #endif
@@ -64,17 +70,20 @@ static HashTable g_hash_table;
 // Support for malloc debugging.
 // Table for dispatching malloc calls, initialized with default dispatchers.
 static const MallocDebug __libc_malloc_default_dispatch __attribute__((aligned(32))) = {
-  Malloc(calloc),
-  Malloc(free),
+  CachedMalloc(calloc),
+  CachedMalloc(free),
+  CachedMalloc(free_sized),
   Malloc(mallinfo),
-  Malloc(malloc),
+  CachedMalloc(malloc),
   Malloc(malloc_usable_size),
+  CachedMalloc(malloc_trim),
+  CachedMalloc(mallopt),
   Malloc(memalign),
   Malloc(posix_memalign),
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
   Malloc(pvalloc),
 #endif
-  Malloc(realloc),
+  CachedMalloc(realloc),
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
   Malloc(valloc),
 #endif
@@ -88,10 +97,14 @@ static const MallocDebug* __libc_malloc_dispatch = &__libc_malloc_default_dispat
 // when libc.debug.malloc environment variable contains value other than
 // zero:
 // 1  - For memory leak detections.
+// 2  - For memory leak detection that only records a sample of allocations,
+//      on average one every libc.debug.malloc.sample_interval bytes.
 // 5  - For filling allocated / freed memory with patterns defined by
 //      CHK_SENTINEL_VALUE, and CHK_FILL_FREE macros.
 // 10 - For adding pre-, and post- allocation stubs in order to detect
 //      buffer overruns.
+// 30 - For placing a sample of allocations between guard pages, to catch
+//      buffer overruns and use after free as they happen.
 // Note that emulator's memory allocation instrumentation is not controlled by
 // libc.debug.malloc value, but rather by emulator, started with -memcheck
 // option. Note also, that if emulator has started with -memcheck option,
@@ -179,60 +192,70 @@ extern "C" void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
   }
   *totalMemory = 0;
 
-  ScopedPthreadMutexLocker locker(&g_hash_table.lock);
-  if (g_hash_table.count == 0) {
-    *info = NULL;
-    *overallSize = 0;
-    *infoSize = 0;
-    *backtraceSize = 0;
-    return;
+  // Hold every segment's lock so that the snapshot is consistent. Writers only
+  // ever hold one segment lock at a time, so taking them in order can't deadlock.
+  size_t count = 0;
+  for (size_t i = 0; i < HASHTABLE_SEGMENT_COUNT; ++i) {
+    pthread_mutex_lock(&g_hash_table.segments[i].lock);
+    count += g_hash_table.segments[i].count;
   }
 
-  HashEntry** list = static_cast<HashEntry**>(Malloc(malloc)(sizeof(void*) * g_hash_table.count));
-
-  // Get the entries into an array to be sorted.
-  size_t index = 0;
-  for (size_t i = 0 ; i < HASHTABLE_SIZE ; ++i) {
-    HashEntry* entry = g_hash_table.slots[i];
-    while (entry != NULL) {
-      list[index] = entry;
-      *totalMemory = *totalMemory + ((entry->size & ~SIZE_FLAG_MASK) * entry->allocations);
-      index++;
-      entry = entry->next;
-    }
-  }
-
-  // XXX: the protocol doesn't allow variable size for the stack trace (yet)
-  *infoSize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * BACKTRACE_SIZE);
-  *overallSize = *infoSize * g_hash_table.count;
-  *backtraceSize = BACKTRACE_SIZE;
-
-  // now get a byte array big enough for this
-  *info = static_cast<uint8_t*>(Malloc(malloc)(*overallSize));
-  if (*info == NULL) {
-    *overallSize = 0;
-    Malloc(free)(list);
-    return;
+  *info = NULL;
+  *overallSize = 0;
+  *infoSize = 0;
+  *backtraceSize = 0;
+  HashEntry** list = NULL;
+  if (count != 0) {
+    list = static_cast<HashEntry**>(Malloc(malloc)(sizeof(void*) * count));
   }
+  if (list != NULL) {
+    // Get the entries into an array to be sorted.
+    size_t index = 0;
+    for (size_t i = 0; i < HASHTABLE_SEGMENT_COUNT; ++i) {
+      const HashTableSegment* segment = &g_hash_table.segments[i];
+      for (size_t j = 0; j < segment->size; ++j) {
+        HashEntry* entry = segment->slots[j];
+        while (entry != NULL) {
+          list[index] = entry;
+          *totalMemory = *totalMemory + ((entry->size & ~SIZE_FLAG_MASK) * entry->allocations);
+          index++;
+          entry = entry->next;
+        }
+      }
+    }
 
-  qsort(list, g_hash_table.count, sizeof(void*), hash_entry_compare);
+    // XXX: the protocol doesn't allow variable size for the stack trace (yet)
+    *infoSize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * BACKTRACE_SIZE);
+    *overallSize = *infoSize * count;
+    *backtraceSize = BACKTRACE_SIZE;
 
-  uint8_t* head = *info;
-  const size_t count = g_hash_table.count;
-  for (size_t i = 0 ; i < count ; ++i) {
-    HashEntry* entry = list[i];
-    size_t entrySize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * entry->numEntries);
-    if (entrySize < *infoSize) {
-      // We're writing less than a full entry, clear out the rest.
-      memset(head + entrySize, 0, *infoSize - entrySize);
+    // now get a byte array big enough for this
+    *info = static_cast<uint8_t*>(Malloc(malloc)(*overallSize));
+    if (*info == NULL) {
+      *overallSize = 0;
     } else {
-      // Make sure the amount we're copying doesn't exceed the limit.
-      entrySize = *infoSize;
+      qsort(list, count, sizeof(void*), hash_entry_compare);
+
+      uint8_t* head = *info;
+      for (size_t i = 0 ; i < count ; ++i) {
+        HashEntry* entry = list[i];
+        size_t entrySize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * entry->numEntries);
+        if (entrySize < *infoSize) {
+          // We're writing less than a full entry, clear out the rest.
+          memset(head + entrySize, 0, *infoSize - entrySize);
+        } else {
+          // Make sure the amount we're copying doesn't exceed the limit.
+          entrySize = *infoSize;
+        }
+        memcpy(head, &(entry->size), entrySize);
+        head += *infoSize;
+      }
     }
-    memcpy(head, &(entry->size), entrySize);
-    head += *infoSize;
   }
 
+  for (size_t i = HASHTABLE_SEGMENT_COUNT; i > 0; --i) {
+    pthread_mutex_unlock(&g_hash_table.segments[i - 1].lock);
+  }
   Malloc(free)(list);
 }
 
@@ -251,6 +274,10 @@ extern "C" void free(void* mem) {
   __libc_malloc_dispatch->free(mem);
 }
 
+extern "C" void free_sized(void* mem, size_t bytes) {
+  __libc_malloc_dispatch->free_sized(mem, bytes);
+}
+
 extern "C" struct mallinfo mallinfo() {
   return __libc_malloc_dispatch->mallinfo();
 }
@@ -263,6 +290,18 @@ extern "C" size_t malloc_usable_size(const void* mem) {
   return __libc_malloc_dispatch->malloc_usable_size(mem);
 }
 
+extern "C" int malloc_trim(size_t pad) {
+  // The stacks kept for reuse by new threads are free memory too.
+  __trim_thread_cache();
+  // And so are the regions android_malloc_huge is keeping.
+  __trim_huge_cache();
+  return __libc_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int mallopt(int param, int value) {
+  return __libc_malloc_dispatch->mallopt(param, value);
+}
+
 extern "C" void* memalign(size_t alignment, size_t bytes) {
   return __libc_malloc_dispatch->memalign(alignment, bytes);
 }
@@ -271,6 +310,16 @@ extern "C" int posix_memalign(void** memptr, size_t alignment, size_t size) {
   return __libc_malloc_dispatch->posix_memalign(memptr, alignment, size);
 }
 
+extern "C" void* aligned_alloc(size_t alignment, size_t size) {
+  // C11 leaves non-power-of-two alignments undefined; reject them like posix_memalign does,
+  // rather than letting memalign round them up.
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+  return __libc_malloc_dispatch->memalign(alignment, size);
+}
+
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 extern "C" void* pvalloc(size_t bytes) {
   return __libc_malloc_dispatch->pvalloc(bytes);
@@ -287,6 +336,25 @@ extern "C" void* valloc(size_t bytes) {
 }
 #endif
 
+// Heap introspection goes straight to the allocator, whatever the debug
+// level, so it sees any debug headers as part of the allocations.
+extern "C" int malloc_info(int options, FILE* fp) {
+  return Malloc(malloc_info)(options, fp);
+}
+
+extern "C" void malloc_disable() {
+  Malloc(malloc_disable)();
+}
+
+extern "C" void malloc_enable() {
+  Malloc(malloc_enable)();
+}
+
+extern "C" int malloc_iterate(uintptr_t base, size_t size,
+                              void (*callback)(uintptr_t, size_t, void*), void* arg) {
+  return Malloc(malloc_iterate)(base, size, callback, arg);
+}
+
 // We implement malloc debugging only in libc.so, so the code below
 // must be excluded if we compile this file for static libc.a
 #ifndef LIBC_STATIC
@@ -299,6 +367,9 @@ unsigned int malloc_sig_enabled = 0;
 unsigned int max_allocation_limit;
 unsigned int min_allocation_report_limit;
 const char* process_name;
+size_t malloc_sample_interval;
+size_t malloc_guard_sample_rate;
+size_t malloc_guard_slot_count;
 
 template<typename FunctionType>
 static void InitMallocFunction(void* malloc_impl_handler, FunctionType* func, const char* prefix, const char* suffix) {
@@ -310,15 +381,23 @@ static void InitMallocFunction(void* malloc_impl_handler, FunctionType* func, co
   }
 }
 
+// The debug libraries have to see every free, and have no use for the size.
+static void debug_free_sized(void* mem, size_t) {
+  __libc_malloc_dispatch->free(mem);
+}
+
 static void InitMalloc(void* malloc_impl_handler, MallocDebug* table, const char* prefix) {
   __libc_format_log(ANDROID_LOG_INFO, "libc", "%s: using libc.debug.malloc %d (%s)\n",
                     getprogname(), g_malloc_debug_level, prefix);
 
   InitMallocFunction<MallocDebugCalloc>(malloc_impl_handler, &table->calloc, prefix, "calloc");
   InitMallocFunction<MallocDebugFree>(malloc_impl_handler, &table->free, prefix, "free");
+  table->free_sized = debug_free_sized;
   InitMallocFunction<MallocDebugMallinfo>(malloc_impl_handler, &table->mallinfo, prefix, "mallinfo");
   InitMallocFunction<MallocDebugMalloc>(malloc_impl_handler, &table->malloc, prefix, "malloc");
   InitMallocFunction<MallocDebugMallocUsableSize>(malloc_impl_handler, &table->malloc_usable_size, prefix, "malloc_usable_size");
+  InitMallocFunction<MallocDebugMallocTrim>(malloc_impl_handler, &table->malloc_trim, prefix, "malloc_trim");
+  InitMallocFunction<MallocDebugMallopt>(malloc_impl_handler, &table->mallopt, prefix, "mallopt");
   InitMallocFunction<MallocDebugMemalign>(malloc_impl_handler, &table->memalign, prefix, "memalign");
   InitMallocFunction<MallocDebugPosixMemalign>(malloc_impl_handler, &table->posix_memalign, prefix, "posix_memalign");
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
@@ -387,6 +466,26 @@ static void malloc_init_impl() {
     case 10:
       so_name = "libc_malloc_debug_leak.so";
       break;
+    case 2:
+      char debug_sample_interval[PROP_VALUE_MAX];
+      if (__system_property_get("libc.debug.malloc.sample_interval", debug_sample_interval))
+        malloc_sample_interval = strtoul(debug_sample_interval, NULL, 0);
+      if (malloc_sample_interval == 0)
+        malloc_sample_interval = 512 * 1024; // In Bytes [Default is 512 KB]
+      so_name = "libc_malloc_debug_leak.so";
+      break;
+    case 30:
+      char debug_guard[PROP_VALUE_MAX];
+      if (__system_property_get("libc.debug.malloc.guard_rate", debug_guard))
+        malloc_guard_sample_rate = strtoul(debug_guard, NULL, 0);
+      if (malloc_guard_sample_rate == 0)
+        malloc_guard_sample_rate = 1000; // One allocation in 1000 by default
+      if (__system_property_get("libc.debug.malloc.guard_slots", debug_guard))
+        malloc_guard_slot_count = strtoul(debug_guard, NULL, 0);
+      if (malloc_guard_slot_count == 0)
+        malloc_guard_slot_count = 64; // 64 slots (128 pages of address space) by default
+      so_name = "libc_malloc_debug_leak.so";
+      break;
     case 20:
       // Quick check: debug level 20 can only be handled in emulator.
       if (!qemu_running) {
@@ -461,10 +560,11 @@ static void malloc_init_impl() {
   }
 
   // No need to init the dispatch table because we can only get
-  // here if debug level is 1, 5, 10, or 20.
+  // here if debug level is 1, 2, 5, 10, 20, 30, or 40.
   static MallocDebug malloc_dispatch_table __attribute__((aligned(32)));
   switch (g_malloc_debug_level) {
     case 1:
+    case 2:
       InitMalloc(malloc_impl_handle, &malloc_dispatch_table, "leak");
       break;
     case 5:
@@ -476,6 +576,9 @@ static void malloc_init_impl() {
     case 20:
       InitMalloc(malloc_impl_handle, &malloc_dispatch_table, "qemu_instrumented");
       break;
+    case 30:
+      InitMalloc(malloc_impl_handle, &malloc_dispatch_table, "guard");
+      break;
     case 40:
       InitMalloc(malloc_impl_handle, &malloc_dispatch_table, "chk");
       break;
@@ -489,6 +592,8 @@ static void malloc_init_impl() {
       (malloc_dispatch_table.mallinfo == NULL) ||
       (malloc_dispatch_table.malloc == NULL) ||
       (malloc_dispatch_table.malloc_usable_size == NULL) ||
+      (malloc_dispatch_table.malloc_trim == NULL) ||
+      (malloc_dispatch_table.mallopt == NULL) ||
       (malloc_dispatch_table.memalign == NULL) ||
       (malloc_dispatch_table.posix_memalign == NULL) ||
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
@@ -40,7 +40,11 @@
 #include "private/bionic_config.h"
 #include "private/libc_logging.h"
 
-#define HASHTABLE_SIZE      1543
+// The table is split into independently locked segments, chosen by the low
+// bits of the mixed backtrace hash. Each segment's slot array starts at
+// HASHTABLE_INITIAL_SEGMENT_SIZE entries and doubles as it fills.
+#define HASHTABLE_SEGMENT_COUNT         16
+#define HASHTABLE_INITIAL_SEGMENT_SIZE  256
 #define BACKTRACE_SIZE      32
 /* flag definitions, currently sharing storage with "size" */
 #define SIZE_FLAG_ZYGOTE_CHILD  (1<<31)
@@ -56,7 +60,7 @@
 // =============================================================================
 
 struct HashEntry {
-    size_t slot;
+    size_t hash;
     HashEntry* prev;
     HashEntry* next;
     size_t numEntries;
@@ -66,18 +70,47 @@ struct HashEntry {
     uintptr_t backtrace[0];
 };
 
-struct HashTable {
+struct HashTableSegment {
     pthread_mutex_t lock;
     size_t count;
-    HashEntry* slots[HASHTABLE_SIZE];
+    // The number of slots; zero until the first entry is added.
+    size_t size;
+    HashEntry** slots;
+};
+
+struct HashTable {
+    HashTableSegment segments[HASHTABLE_SEGMENT_COUNT];
 };
 
+// Spreads the bits of a backtrace hash so that both the segment and the
+// slot within it can be taken from it by masking.
+static inline size_t mix_hash(size_t hash) {
+    uint32_t h = static_cast<uint32_t>(hash);
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+static inline HashTableSegment* hash_table_segment(HashTable* table, size_t hash) {
+    return &table->segments[mix_hash(hash) % HASHTABLE_SEGMENT_COUNT];
+}
+
+static inline size_t hash_table_slot(const HashTableSegment* segment, size_t hash) {
+    return (mix_hash(hash) / HASHTABLE_SEGMENT_COUNT) & (segment->size - 1);
+}
+
 /* Entry in malloc dispatch table. */
 typedef void* (*MallocDebugCalloc)(size_t, size_t);
 typedef void (*MallocDebugFree)(void*);
+typedef void (*MallocDebugFreeSized)(void*, size_t);
 typedef struct mallinfo (*MallocDebugMallinfo)();
 typedef void* (*MallocDebugMalloc)(size_t);
 typedef size_t (*MallocDebugMallocUsableSize)(const void*);
+typedef int (*MallocDebugMallocTrim)(size_t);
+typedef int (*MallocDebugMallopt)(int, int);
 typedef void* (*MallocDebugMemalign)(size_t, size_t);
 typedef int (*MallocDebugPosixMemalign)(void**, size_t, size_t);
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
@@ -91,9 +124,12 @@ typedef void* (*MallocDebugValloc)(size_t);
 struct MallocDebug {
   MallocDebugCalloc calloc;
   MallocDebugFree free;
+  MallocDebugFreeSized free_sized;
   MallocDebugMallinfo mallinfo;
   MallocDebugMalloc malloc;
   MallocDebugMallocUsableSize malloc_usable_size;
+  MallocDebugMallocTrim malloc_trim;
+  MallocDebugMallopt mallopt;
   MallocDebugMemalign memalign;
   MallocDebugPosixMemalign posix_memalign;
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
@@ -38,6 +38,9 @@
 // =============================================================================
 extern pthread_key_t g_debug_calls_disabled;
 
+// Creates g_debug_calls_disabled. Safe to call more than once.
+__LIBC_HIDDEN__ void debug_calls_init();
+
 static inline bool DebugCallsDisabled() {
   return pthread_getspecific(g_debug_calls_disabled) != NULL;
 }
@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Sampled guard-page allocation (libc.debug.malloc=30).
+//
+// One in every libc.debug.malloc.guard_rate allocations of up to a page is
+// placed in a pool of libc.debug.malloc.guard_slots page-sized slots, each
+// with an inaccessible page on either side. The allocation is pushed up
+// against the end of its page, so running off the end of it faults at once.
+// Freed slots are made inaccessible until they're reused, so a use after
+// free faults as well. Everything else goes straight to the underlying
+// allocator, so only the sampled allocations pay for this. A fault in the
+// pool is logged with the allocating and freeing backtraces before the
+// process is allowed to crash.
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <unistd.h>
+
+#include "debug_stacktrace.h"
+#include "malloc_debug_backtrace.h"
+#include "malloc_debug_common.h"
+#include "malloc_debug_disable.h"
+
+#include "private/bionic_macros.h"
+#include "private/bionic_prctl.h"
+#include "private/libc_logging.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+extern const MallocDebug* g_malloc_dispatch;
+extern size_t malloc_guard_sample_rate;
+extern size_t malloc_guard_slot_count;
+
+#define GUARD_BACKTRACE_SIZE 16
+
+struct GuardSlot {
+  bool allocated;
+  uintptr_t ptr;
+  size_t size;
+  pid_t alloc_tid;
+  size_t alloc_frame_count;
+  uintptr_t alloc_frames[GUARD_BACKTRACE_SIZE];
+  pid_t free_tid;
+  size_t free_frame_count;
+  uintptr_t free_frames[GUARD_BACKTRACE_SIZE];
+};
+
+// The pool is 2 * g_slot_count + 1 pages: slot i is page 2 * i + 1, and the
+// even-numbered pages are the guards.
+static uintptr_t g_pool_start;
+static uintptr_t g_pool_end;
+static size_t g_slot_count;
+static GuardSlot* g_slots;
+
+// Free slots are handed out oldest first, to keep a freed slot inaccessible
+// for as long as possible.
+static size_t* g_free_slots;
+static size_t g_free_head;
+static size_t g_free_count;
+
+static pthread_mutex_t g_guard_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Each thread counts down the allocations until its next sample.
+static pthread_key_t g_guard_countdown_key;
+
+static struct sigaction g_previous_sigsegv;
+
+static inline bool in_pool(const void* mem) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(mem);
+  return address >= g_pool_start && address < g_pool_end;
+}
+
+// Returns g_slot_count for the guard page at the end of the pool.
+static inline size_t slot_index(const void* mem) {
+  return (reinterpret_cast<uintptr_t>(mem) - g_pool_start) / PAGE_SIZE / 2;
+}
+
+static inline uintptr_t slot_page(size_t index) {
+  return g_pool_start + (2 * index + 1) * PAGE_SIZE;
+}
+
+static void* map_guard_memory(size_t size, int prot, const char* name) {
+  void* map = mmap(NULL, size, prot, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, size, name);
+  return map;
+}
+
+static bool should_guard(size_t bytes) {
+  if (bytes == 0 || bytes > PAGE_SIZE || g_slot_count == 0) {
+    return false;
+  }
+  uintptr_t countdown = reinterpret_cast<uintptr_t>(pthread_getspecific(g_guard_countdown_key));
+  if (countdown == 0) {
+    // Start each thread at a different point in the cycle.
+    countdown = (static_cast<uintptr_t>(gettid()) * 2654435761U) % malloc_guard_sample_rate + 1;
+  }
+  bool sample = (--countdown == 0);
+  if (sample) {
+    countdown = malloc_guard_sample_rate;
+  }
+  pthread_setspecific(g_guard_countdown_key, reinterpret_cast<void*>(countdown));
+  return sample;
+}
+
+static void* guard_allocate(size_t bytes, size_t alignment) {
+  uintptr_t frames[GUARD_BACKTRACE_SIZE];
+  size_t frame_count = GET_BACKTRACE(frames, GUARD_BACKTRACE_SIZE);
+
+  ScopedPthreadMutexLocker locker(&g_guard_lock);
+  if (g_free_count == 0) {
+    return NULL;
+  }
+  size_t index = g_free_slots[g_free_head];
+  uintptr_t page = slot_page(index);
+  if (mprotect(reinterpret_cast<void*>(page), PAGE_SIZE, PROT_READ|PROT_WRITE) != 0) {
+    return NULL;
+  }
+  g_free_head = (g_free_head + 1) % g_slot_count;
+  g_free_count--;
+
+  GuardSlot* slot = &g_slots[index];
+  slot->allocated = true;
+  slot->ptr = (page + PAGE_SIZE - bytes) & ~(alignment - 1);
+  slot->size = bytes;
+  slot->alloc_tid = gettid();
+  slot->alloc_frame_count = frame_count;
+  memcpy(slot->alloc_frames, frames, frame_count * sizeof(uintptr_t));
+  slot->free_frame_count = 0;
+  return reinterpret_cast<void*>(slot->ptr);
+}
+
+static void log_frames(const char* what, pid_t tid, const uintptr_t* frames, size_t frame_count) {
+  __libc_format_log(ANDROID_LOG_ERROR, "libc", "%s by thread %d:\n", what, tid);
+  for (size_t i = 0; i < frame_count; ++i) {
+    __libc_format_log(ANDROID_LOG_ERROR, "libc", "    #%02zu pc %p\n",
+                      i, reinterpret_cast<void*>(frames[i]));
+  }
+}
+
+static void log_slot(const GuardSlot* slot) {
+  log_frames("allocated", slot->alloc_tid, slot->alloc_frames, slot->alloc_frame_count);
+  if (!slot->allocated && slot->free_frame_count != 0) {
+    log_frames("freed", slot->free_tid, slot->free_frames, slot->free_frame_count);
+  }
+}
+
+static void guard_release(void* mem) {
+  uintptr_t frames[GUARD_BACKTRACE_SIZE];
+  size_t frame_count = GET_BACKTRACE(frames, GUARD_BACKTRACE_SIZE);
+
+  size_t index = slot_index(mem);
+  if (index >= g_slot_count) {
+    // Not something we handed out; let the real free complain about it.
+    g_malloc_dispatch->free(mem);
+    return;
+  }
+
+  ScopedPthreadMutexLocker locker(&g_guard_lock);
+  GuardSlot* slot = &g_slots[index];
+  if (!slot->allocated || slot->ptr != reinterpret_cast<uintptr_t>(mem)) {
+    __libc_format_log(ANDROID_LOG_ERROR, "libc", "*** %s of guarded pointer %p\n",
+                      slot->allocated ? "invalid free" : "double free", mem);
+    log_slot(slot);
+    log_frames("now being freed", gettid(), frames, frame_count);
+    abort();
+  }
+
+  slot->allocated = false;
+  slot->free_tid = gettid();
+  slot->free_frame_count = frame_count;
+  memcpy(slot->free_frames, frames, frame_count * sizeof(uintptr_t));
+
+  void* page = reinterpret_cast<void*>(slot_page(index));
+  madvise(page, PAGE_SIZE, MADV_DONTNEED);
+  mprotect(page, PAGE_SIZE, PROT_NONE);
+  g_free_slots[(g_free_head + g_free_count) % g_slot_count] = index;
+  g_free_count++;
+}
+
+// Explains a fault in the pool. Only async-signal-safe logging is used, so
+// the frames are left for the reader to symbolize against the tombstone's
+// memory map.
+static void report_fault(uintptr_t address) {
+  size_t page = (address - g_pool_start) / PAGE_SIZE;
+  if ((page % 2) == 1) {
+    const GuardSlot* slot = &g_slots[page / 2];
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "*** use after free of guarded %zu-byte allocation %p (access at %p)\n",
+                      slot->size, reinterpret_cast<void*>(slot->ptr),
+                      reinterpret_cast<void*>(address));
+    log_slot(slot);
+    return;
+  }
+
+  // A guard page: blame the allocation running into it from below, then
+  // the one above.
+  size_t guard = page / 2;
+  if (guard > 0 && g_slots[guard - 1].allocated) {
+    const GuardSlot* slot = &g_slots[guard - 1];
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "*** buffer overflow of guarded %zu-byte allocation %p (access at %p)\n",
+                      slot->size, reinterpret_cast<void*>(slot->ptr),
+                      reinterpret_cast<void*>(address));
+    log_slot(slot);
+  } else if (guard < g_slot_count && g_slots[guard].allocated) {
+    const GuardSlot* slot = &g_slots[guard];
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "*** buffer underflow of guarded %zu-byte allocation %p (access at %p)\n",
+                      slot->size, reinterpret_cast<void*>(slot->ptr),
+                      reinterpret_cast<void*>(address));
+    log_slot(slot);
+  } else {
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "*** wild access to guarded allocation pool at %p\n",
+                      reinterpret_cast<void*>(address));
+  }
+}
+
+// Faults in the pool are explained first; every fault then goes on to
+// whatever handled SIGSEGV before us (usually debuggerd's).
+static void guard_sigsegv_handler(int signal_number, siginfo_t* info, void* context) {
+  if (in_pool(info->si_addr)) {
+    report_fault(reinterpret_cast<uintptr_t>(info->si_addr));
+  }
+  if ((g_previous_sigsegv.sa_flags & SA_SIGINFO) != 0) {
+    g_previous_sigsegv.sa_sigaction(signal_number, info, context);
+  } else if (g_previous_sigsegv.sa_handler != SIG_DFL &&
+             g_previous_sigsegv.sa_handler != SIG_IGN) {
+    g_previous_sigsegv.sa_handler(signal_number);
+  } else {
+    // Returning retries the access, which now gets the previous disposition.
+    sigaction(SIGSEGV, &g_previous_sigsegv, NULL);
+  }
+}
+
+bool init_guard_pool() {
+  size_t slot_count = malloc_guard_slot_count;
+  size_t pool_size = (2 * slot_count + 1) * PAGE_SIZE;
+  void* pool = map_guard_memory(pool_size, PROT_NONE, "malloc_debug_guard");
+  g_slots = static_cast<GuardSlot*>(map_guard_memory(slot_count * sizeof(GuardSlot),
+                                                     PROT_READ|PROT_WRITE, "malloc_debug"));
+  g_free_slots = static_cast<size_t*>(map_guard_memory(slot_count * sizeof(size_t),
+                                                       PROT_READ|PROT_WRITE, "malloc_debug"));
+  if (pool == NULL || g_slots == NULL || g_free_slots == NULL ||
+      pthread_key_create(&g_guard_countdown_key, NULL) != 0) {
+    error_log("%s: couldn't set up a pool of %zu guarded slots", getprogname(), slot_count);
+    return false;
+  }
+  for (size_t i = 0; i < slot_count; ++i) {
+    g_free_slots[i] = i;
+  }
+  g_free_count = slot_count;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = guard_sigsegv_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  if (sigaction(SIGSEGV, &sa, &g_previous_sigsegv) != 0) {
+    error_log("%s: couldn't install the guarded pool's SIGSEGV handler", getprogname());
+    return false;
+  }
+
+  g_pool_start = reinterpret_cast<uintptr_t>(pool);
+  g_pool_end = g_pool_start + pool_size;
+  g_slot_count = slot_count;
+  info_log("%s: guarding one in %zu allocations in %zu slots\n", getprogname(),
+           malloc_guard_sample_rate, slot_count);
+  return true;
+}
+
+// =============================================================================
+// guard allocation functions
+// =============================================================================
+
+extern "C" void* guard_malloc(size_t bytes) {
+  if (!DebugCallsDisabled() && should_guard(bytes)) {
+    void* ptr = guard_allocate(bytes, MALLOC_ALIGNMENT);
+    if (ptr != NULL) {
+      return ptr;
+    }
+  }
+  return g_malloc_dispatch->malloc(bytes);
+}
+
+extern "C" void guard_free(void* mem) {
+  // Pool pointers have to go back to the pool whether or not debug calls
+  // are currently disabled.
+  if (in_pool(mem)) {
+    guard_release(mem);
+  } else {
+    g_malloc_dispatch->free(mem);
+  }
+}
+
+extern "C" void* guard_calloc(size_t n_elements, size_t elem_size) {
+  if (n_elements != 0 && SIZE_MAX / n_elements >= elem_size &&
+      !DebugCallsDisabled() && should_guard(n_elements * elem_size)) {
+    // Slots are zeroed when they're freed.
+    void* ptr = guard_allocate(n_elements * elem_size, MALLOC_ALIGNMENT);
+    if (ptr != NULL) {
+      return ptr;
+    }
+  }
+  return g_malloc_dispatch->calloc(n_elements, elem_size);
+}
+
+extern "C" size_t guard_malloc_usable_size(const void* mem) {
+  if (in_pool(mem)) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(mem);
+    return BIONIC_ALIGN(address + 1, PAGE_SIZE) - address;
+  }
+  return g_malloc_dispatch->malloc_usable_size(mem);
+}
+
+extern "C" void* guard_realloc(void* mem, size_t bytes) {
+  if (!in_pool(mem) || slot_index(mem) >= g_slot_count) {
+    return g_malloc_dispatch->realloc(mem, bytes);
+  }
+  if (bytes == 0) {
+    guard_release(mem);
+    return NULL;
+  }
+  void* new_mem = guard_malloc(bytes);
+  if (new_mem != NULL) {
+    size_t old_size = g_slots[slot_index(mem)].size;
+    memcpy(new_mem, mem, MIN(old_size, bytes));
+    guard_release(mem);
+  }
+  return new_mem;
+}
+
+extern "C" void* guard_memalign(size_t alignment, size_t bytes) {
+  if (alignment <= PAGE_SIZE && powerof2(alignment) &&
+      !DebugCallsDisabled() && should_guard(bytes)) {
+    void* ptr = guard_allocate(bytes, MAX(alignment, MALLOC_ALIGNMENT));
+    if (ptr != NULL) {
+      return ptr;
+    }
+  }
+  return g_malloc_dispatch->memalign(alignment, bytes);
+}
+
+extern "C" int guard_posix_memalign(void** memptr, size_t alignment, size_t size) {
+  if (!powerof2(alignment)) {
+    return EINVAL;
+  }
+  int saved_errno = errno;
+  *memptr = guard_memalign(alignment, size);
+  errno = saved_errno;
+  return (*memptr != NULL) ? 0 : ENOMEM;
+}
+
+#if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
+extern "C" void* guard_pvalloc(size_t bytes) {
+  return g_malloc_dispatch->pvalloc(bytes);
+}
+
+extern "C" void* guard_valloc(size_t size) {
+  return g_malloc_dispatch->valloc(size);
+}
+#endif
+
+extern "C" struct mallinfo guard_mallinfo() {
+  return g_malloc_dispatch->mallinfo();
+}
+
+extern "C" int guard_malloc_trim(size_t pad) {
+  return g_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int guard_mallopt(int param, int value) {
+  return g_malloc_dispatch->mallopt(param, value);
+}
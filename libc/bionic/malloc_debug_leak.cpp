@@ -30,6 +30,7 @@
 #include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
 #include <pthread.h>
 #include <stdarg.h>
 #include <stddef.h>
@@ -37,12 +38,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/system_properties.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 #include <unwind.h>
 
@@ -52,6 +55,7 @@
 #include "malloc_debug_disable.h"
 
 #include "private/bionic_macros.h"
+#include "private/bionic_prctl.h"
 #include "private/libc_logging.h"
 #include "private/ScopedPthreadMutexLocker.h"
 
@@ -65,6 +69,7 @@
 extern int gMallocLeakZygoteChild;
 extern HashTable* g_hash_table;
 extern const MallocDebug* g_malloc_dispatch;
+extern size_t malloc_sample_interval;
 
 // =============================================================================
 // stack trace functions
@@ -97,7 +102,7 @@ static inline const AllocationEntry* const_to_header(const void* mem) {
 static uint32_t get_hash(uintptr_t* backtrace, size_t numEntries) {
     if (backtrace == NULL) return 0;
 
-    int hash = 0;
+    uint32_t hash = 0;
     size_t i;
     for (i = 0 ; i < numEntries ; i++) {
         hash = (hash * 33) + (backtrace[i] >> 2);
@@ -106,9 +111,99 @@ static uint32_t get_hash(uintptr_t* backtrace, size_t numEntries) {
     return hash;
 }
 
-static HashEntry* find_entry(HashTable* table, int slot,
+// HashEntry records come from per-segment arenas of anonymous memory rather
+// than from the heap being tracked, and are recycled through free lists kept
+// by backtrace length. Each arena is protected by its segment's lock.
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+struct HashEntryArena {
+    uint8_t* next;
+    uint8_t* end;
+    HashEntry* free_lists[BACKTRACE_SIZE + 1];
+};
+
+static HashEntryArena g_entry_arenas[HASHTABLE_SEGMENT_COUNT];
+
+static void* map_debug_memory(size_t size) {
+    void* map = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, size, "malloc_debug");
+    return map;
+}
+
+static HashEntryArena* segment_arena(HashTableSegment* segment) {
+    return &g_entry_arenas[segment - g_hash_table->segments];
+}
+
+static HashEntry* alloc_entry(HashTableSegment* segment, size_t numEntries) {
+    HashEntryArena* arena = segment_arena(segment);
+    HashEntry* entry = arena->free_lists[numEntries];
+    if (entry != NULL) {
+        arena->free_lists[numEntries] = entry->next;
+        return entry;
+    }
+
+    size_t size = BIONIC_ALIGN(sizeof(HashEntry) + numEntries * sizeof(uintptr_t), sizeof(uintptr_t));
+    if (static_cast<size_t>(arena->end - arena->next) < size) {
+        uint8_t* chunk = static_cast<uint8_t*>(map_debug_memory(ARENA_CHUNK_SIZE));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        // Whatever was left of the previous chunk is abandoned.
+        arena->next = chunk;
+        arena->end = chunk + ARENA_CHUNK_SIZE;
+    }
+    entry = reinterpret_cast<HashEntry*>(arena->next);
+    arena->next += size;
+    return entry;
+}
+
+static void free_entry(HashTableSegment* segment, HashEntry* entry) {
+    HashEntryArena* arena = segment_arena(segment);
+    entry->next = arena->free_lists[entry->numEntries];
+    arena->free_lists[entry->numEntries] = entry;
+}
+
+// Doubles the segment's slot array once its load factor passes one. If the
+// new array can't be mapped we carry on with longer chains.
+static void grow_segment(HashTableSegment* segment) {
+    size_t new_size = (segment->size == 0) ? HASHTABLE_INITIAL_SEGMENT_SIZE : segment->size * 2;
+    HashEntry** new_slots = static_cast<HashEntry**>(map_debug_memory(new_size * sizeof(HashEntry*)));
+    if (new_slots == NULL) {
+        return;
+    }
+
+    HashEntry** old_slots = segment->slots;
+    size_t old_size = segment->size;
+    segment->slots = new_slots;
+    segment->size = new_size;
+    for (size_t i = 0; i < old_size; ++i) {
+        HashEntry* entry = old_slots[i];
+        while (entry != NULL) {
+            HashEntry* next = entry->next;
+            size_t slot = hash_table_slot(segment, entry->hash);
+            entry->prev = NULL;
+            entry->next = new_slots[slot];
+            if (entry->next != NULL) {
+                entry->next->prev = entry;
+            }
+            new_slots[slot] = entry;
+            entry = next;
+        }
+    }
+    if (old_slots != NULL) {
+        munmap(old_slots, old_size * sizeof(HashEntry*));
+    }
+}
+
+static HashEntry* find_entry(HashTableSegment* segment, size_t hash,
                              uintptr_t* backtrace, size_t numEntries, size_t size) {
-    HashEntry* entry = table->slots[slot];
+    if (segment->size == 0) {
+        return NULL;
+    }
+    HashEntry* entry = segment->slots[hash_table_slot(segment, hash)];
     while (entry != NULL) {
         //debug_log("backtrace: %p, entry: %p entry->backtrace: %p\n",
         //        backtrace, entry, (entry != NULL) ? entry->backtrace : NULL);
@@ -116,7 +211,7 @@ static HashEntry* find_entry(HashTable* table, int slot,
          * See if the entry matches exactly.  We compare the "size" field,
          * including the flag bits.
          */
-        if (entry->size == size && entry->numEntries == numEntries &&
+        if (entry->hash == hash && entry->size == size && entry->numEntries == numEntries &&
                 !memcmp(backtrace, entry->backtrace, numEntries * sizeof(uintptr_t))) {
             return entry;
         }
@@ -127,10 +222,11 @@ static HashEntry* find_entry(HashTable* table, int slot,
     return NULL;
 }
 
-static HashEntry* record_backtrace(uintptr_t* backtrace, size_t numEntries, size_t size) {
-    size_t hash = get_hash(backtrace, numEntries);
-    size_t slot = hash % HASHTABLE_SIZE;
-
+// Records one (weighted) allocation with this backtrace. Must be called with
+// the lock of the segment the hash selects held.
+static HashEntry* record_backtrace(HashTableSegment* segment, size_t hash,
+                                   uintptr_t* backtrace, size_t numEntries, size_t size,
+                                   size_t weight) {
     if (size & SIZE_FLAG_MASK) {
         debug_log("malloc_debug: allocation %zx exceeds bit width\n", size);
         abort();
@@ -140,33 +236,41 @@ static HashEntry* record_backtrace(uintptr_t* backtrace, size_t numEntries, size
         size |= SIZE_FLAG_ZYGOTE_CHILD;
     }
 
-    HashEntry* entry = find_entry(g_hash_table, slot, backtrace, numEntries, size);
+    HashEntry* entry = find_entry(segment, hash, backtrace, numEntries, size);
 
     if (entry != NULL) {
-        entry->allocations++;
+        entry->allocations += weight;
     } else {
+        if (segment->count >= segment->size) {
+            grow_segment(segment);
+            if (segment->size == 0) {
+                return NULL;
+            }
+        }
+
         // create a new entry
-        entry = static_cast<HashEntry*>(g_malloc_dispatch->malloc(sizeof(HashEntry) + numEntries*sizeof(uintptr_t)));
+        entry = alloc_entry(segment, numEntries);
         if (!entry) {
             return NULL;
         }
-        entry->allocations = 1;
-        entry->slot = slot;
+        size_t slot = hash_table_slot(segment, hash);
+        entry->allocations = weight;
+        entry->hash = hash;
         entry->prev = NULL;
-        entry->next = g_hash_table->slots[slot];
+        entry->next = segment->slots[slot];
         entry->numEntries = numEntries;
         entry->size = size;
 
         memcpy(entry->backtrace, backtrace, numEntries * sizeof(uintptr_t));
 
-        g_hash_table->slots[slot] = entry;
+        segment->slots[slot] = entry;
 
         if (entry->next != NULL) {
             entry->next->prev = entry;
         }
 
-        // we just added an entry, increase the size of the hashtable
-        g_hash_table->count++;
+        // we just added an entry, increase the size of the segment
+        segment->count++;
     }
 
     return entry;
@@ -174,20 +278,25 @@ static HashEntry* record_backtrace(uintptr_t* backtrace, size_t numEntries, size
 
 static int is_valid_entry(HashEntry* entry) {
   if (entry != NULL) {
-    for (size_t i = 0; i < HASHTABLE_SIZE; ++i) {
-      HashEntry* e1 = g_hash_table->slots[i];
-      while (e1 != NULL) {
-        if (e1 == entry) {
-          return 1;
+    for (size_t i = 0; i < HASHTABLE_SEGMENT_COUNT; ++i) {
+      HashTableSegment* segment = &g_hash_table->segments[i];
+      ScopedPthreadMutexLocker locker(&segment->lock);
+      for (size_t j = 0; j < segment->size; ++j) {
+        HashEntry* e1 = segment->slots[j];
+        while (e1 != NULL) {
+          if (e1 == entry) {
+            return 1;
+          }
+          e1 = e1->next;
         }
-        e1 = e1->next;
       }
     }
   }
   return 0;
 }
 
-static void remove_entry(HashEntry* entry) {
+// Must be called with the segment's lock held.
+static void remove_entry(HashTableSegment* segment, HashEntry* entry) {
   HashEntry* prev = entry->prev;
   HashEntry* next = entry->next;
 
@@ -196,11 +305,92 @@ static void remove_entry(HashEntry* entry) {
 
   if (prev == NULL) {
     // we are the head of the list. set the head to be next
-    g_hash_table->slots[entry->slot] = entry->next;
+    segment->slots[hash_table_slot(segment, entry->hash)] = entry->next;
   }
 
-  // we just removed and entry, decrease the size of the hashtable
-  g_hash_table->count--;
+  // we just removed and entry, decrease the size of the segment
+  segment->count--;
+  free_entry(segment, entry);
+}
+
+// =============================================================================
+// Allocation sampling functions
+// =============================================================================
+
+// When malloc_sample_interval is non-zero (libc.debug.malloc=2), only some
+// allocations are recorded: each thread counts down the bytes it allocates,
+// and the allocation that takes the count past zero is sampled and a new
+// exponentially distributed interval drawn. That makes the byte offsets of
+// the samples a Poisson process, so an allocation of size s is sampled with
+// probability 1 - exp(-s / interval) whichever thread makes it. Each sample
+// is counted as 1 / that probability allocations in the hash table, which
+// keeps get_malloc_leak_info's counts and totals unbiased.
+
+struct SampleState {
+    uint64_t random;
+    size_t bytes_until_sample;
+};
+
+static pthread_key_t g_sample_state_key;
+
+static void free_sample_state(void* state) {
+    g_malloc_dispatch->free(state);
+}
+
+void init_allocation_sampling() {
+    pthread_key_create(&g_sample_state_key, free_sample_state);
+}
+
+static size_t next_sample_interval(SampleState* state) {
+    // xorshift64*
+    state->random ^= state->random >> 12;
+    state->random ^= state->random << 25;
+    state->random ^= state->random >> 27;
+    uint64_t bits = state->random * UINT64_C(2685821657736338717);
+    // A uniform value in (0, 1].
+    double u = (static_cast<double>(bits >> 11) + 1.0) / 9007199254740992.0;
+    double interval = -log(u) * malloc_sample_interval;
+    if (interval >= SIZE_MAX) {
+        return SIZE_MAX;
+    }
+    return static_cast<size_t>(interval) + 1;
+}
+
+static bool should_sample(size_t bytes) {
+    SampleState* state = static_cast<SampleState*>(pthread_getspecific(g_sample_state_key));
+    if (state == NULL) {
+        state = static_cast<SampleState*>(g_malloc_dispatch->malloc(sizeof(SampleState)));
+        if (state == NULL) {
+            return false;
+        }
+        state->random = (static_cast<uint64_t>(gettid()) << 32) ^ time(NULL) ^
+            reinterpret_cast<uintptr_t>(state);
+        if (state->random == 0) {
+            state->random = 1;
+        }
+        state->bytes_until_sample = next_sample_interval(state);
+        pthread_setspecific(g_sample_state_key, state);
+    }
+
+    if (bytes < state->bytes_until_sample) {
+        state->bytes_until_sample -= bytes;
+        return false;
+    }
+    state->bytes_until_sample = next_sample_interval(state);
+    return true;
+}
+
+// The number of allocations of the given size that each sample stands for.
+static size_t sample_weight(size_t size) {
+    if (malloc_sample_interval == 0) {
+        return 1;
+    }
+    size &= ~SIZE_FLAG_MASK;
+    double probability = -expm1(-static_cast<double>(size) / malloc_sample_interval);
+    if (probability <= 0.0) {
+        return 1;
+    }
+    return static_cast<size_t>(1.0 / probability + 0.5);
 }
 
 // =============================================================================
@@ -259,6 +449,14 @@ extern "C" struct mallinfo fill_mallinfo() {
   return g_malloc_dispatch->mallinfo();
 }
 
+extern "C" int fill_malloc_trim(size_t pad) {
+  return g_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int fill_mallopt(int param, int value) {
+  return g_malloc_dispatch->mallopt(param, value);
+}
+
 extern "C" int fill_posix_memalign(void** memptr, size_t alignment, size_t size) {
   if (!powerof2(alignment)) {
     return EINVAL;
@@ -309,15 +507,21 @@ extern "C" void* leak_malloc(size_t bytes) {
 
     void* base = g_malloc_dispatch->malloc(size);
     if (base != NULL) {
-        ScopedPthreadMutexLocker locker(&g_hash_table->lock);
-
-        uintptr_t backtrace[BACKTRACE_SIZE];
-        size_t numEntries = GET_BACKTRACE(backtrace, BACKTRACE_SIZE);
-
         AllocationEntry* header = reinterpret_cast<AllocationEntry*>(base);
-        header->entry = record_backtrace(backtrace, numEntries, bytes);
+        header->entry = NULL;
         header->guard = GUARD;
 
+        if (malloc_sample_interval == 0 || should_sample(bytes)) {
+            uintptr_t backtrace[BACKTRACE_SIZE];
+            size_t numEntries = GET_BACKTRACE(backtrace, BACKTRACE_SIZE);
+            size_t hash = get_hash(backtrace, numEntries);
+
+            HashTableSegment* segment = hash_table_segment(g_hash_table, hash);
+            ScopedPthreadMutexLocker locker(&segment->lock);
+            header->entry = record_backtrace(segment, hash, backtrace, numEntries, bytes,
+                                             sample_weight(bytes));
+        }
+
         // now increment base to point to after our header.
         // this should just work since our header is 8 bytes.
         base = reinterpret_cast<AllocationEntry*>(base) + 1;
@@ -335,27 +539,34 @@ extern "C" void leak_free(void* mem) {
     return;
   }
 
-  ScopedPthreadMutexLocker locker(&g_hash_table->lock);
-
   // check the guard to make sure it is valid
   AllocationEntry* header = to_header(mem);
 
-  if (header->guard != GUARD) {
-    // could be a memaligned block
-    if (header->guard == MEMALIGN_GUARD) {
-      // For memaligned blocks, header->entry points to the memory
-      // allocated through leak_malloc.
-      header = to_header(header->entry);
-    }
+  // could be a memaligned block
+  if (header->guard == MEMALIGN_GUARD) {
+    // For memaligned blocks, header->entry points to the memory
+    // allocated through leak_malloc.
+    header = to_header(header->entry);
+  }
+
+  // Allocations that weren't sampled (or that we failed to record) have
+  // nothing in the hash table.
+  if (header->guard == GUARD && header->entry == NULL) {
+    g_malloc_dispatch->free(header);
+    return;
   }
 
   if (header->guard == GUARD || is_valid_entry(header->entry)) {
-    // decrement the allocations
+    // decrement the allocations. Our allocation keeps the entry alive, so its
+    // hash can be read before taking the lock.
     HashEntry* entry = header->entry;
-    entry->allocations--;
-    if (entry->allocations <= 0) {
-      remove_entry(entry);
-      g_malloc_dispatch->free(entry);
+    HashTableSegment* segment = hash_table_segment(g_hash_table, entry->hash);
+    ScopedPthreadMutexLocker locker(&segment->lock);
+    size_t weight = sample_weight(entry->size);
+    if (entry->allocations <= weight) {
+      remove_entry(segment, entry);
+    } else {
+      entry->allocations -= weight;
     }
 
     // now free the memory!
@@ -496,6 +707,14 @@ extern "C" struct mallinfo leak_mallinfo() {
   return g_malloc_dispatch->mallinfo();
 }
 
+extern "C" int leak_malloc_trim(size_t pad) {
+  return g_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int leak_mallopt(int param, int value) {
+  return g_malloc_dispatch->mallopt(param, value);
+}
+
 extern "C" int leak_posix_memalign(void** memptr, size_t alignment, size_t size) {
   if (DebugCallsDisabled()) {
     return g_malloc_dispatch->posix_memalign(memptr, alignment, size);
@@ -583,6 +583,8 @@ extern "C" void  qemu_instrumented_free(void*);
 extern "C" struct mallinfo qemu_instrumented_mallinfo();
 extern "C" void* qemu_instrumented_malloc(size_t);
 extern "C" size_t qemu_instrumented_malloc_usable_size(const void*);
+extern "C" int qemu_instrumented_malloc_trim(size_t);
+extern "C" int qemu_instrumented_mallopt(int, int);
 extern "C" void* qemu_instrumented_memalign(size_t, size_t);
 extern "C" int qemu_instrumented_posix_memalign(void**, size_t, size_t);
 extern "C" void* qemu_instrumented_pvalloc(size_t);
@@ -1040,6 +1042,14 @@ extern "C" struct mallinfo qemu_instrumented_mallinfo() {
   return g_malloc_dispatch->mallinfo();
 }
 
+extern "C" int qemu_instrumented_malloc_trim(size_t pad) {
+  return g_malloc_dispatch->malloc_trim(pad);
+}
+
+extern "C" int qemu_instrumented_mallopt(int param, int value) {
+  return g_malloc_dispatch->mallopt(param, value);
+}
+
 extern "C" int qemu_instrumented_posix_memalign(void** memptr, size_t alignment, size_t size) {
   if ((alignment & (alignment - 1)) != 0) {
     qemu_error_log("<libc_pid=%03u, pid=%03u> posix_memalign(%p, %zu, %zu): invalid alignment.",
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <malloc.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/user.h>
+
+#include "malloc_huge.h"
+#include "private/ScopedPthreadMutexLocker.h"
+#include "private/libc_logging.h"
+
+// android_malloc_huge hands out whole 2 MiB pages, mapped so that the kernel
+// can back them with transparent huge pages. Regions are mapped directly rather
+// than carved out of the heap, so none of the alignment slack is wasted. Freed
+// regions stay mapped, up to a limit, and are handed out again, which saves
+// faulting them in and waiting for the kernel to compact memory into huge
+// pages all over again.
+
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Don't hold on to more than this much freed memory.
+static const size_t kMaxCachedBytes = 64 * 1024 * 1024;
+
+struct huge_region_t {
+  huge_region_t* next;
+  void* base;
+  size_t size;
+};
+
+static pthread_mutex_t g_huge_lock = PTHREAD_MUTEX_INITIALIZER;
+static huge_region_t* g_huge_in_use;
+static huge_region_t* g_huge_cached;
+static size_t g_huge_cached_bytes;
+
+static void* map_huge_region(size_t size) {
+  // Map enough to be sure of finding an aligned region inside, then unmap the rest.
+  size_t padded = size + kHugePageSize - PAGE_SIZE;
+  void* map = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(map);
+  uintptr_t base = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  if (base != start) {
+    munmap(map, base - start);
+  }
+  uintptr_t end = start + padded;
+  if (end != base + size) {
+    munmap(reinterpret_cast<void*>(base + size), end - (base + size));
+  }
+  // This fails harmlessly on kernels without transparent huge pages.
+  madvise(reinterpret_cast<void*>(base), size, MADV_HUGEPAGE);
+  return reinterpret_cast<void*>(base);
+}
+
+// Takes the smallest cached region that fits, unless it's more than twice the
+// size asked for. Called with g_huge_lock held.
+static huge_region_t* take_cached_region(size_t size) {
+  huge_region_t** best = NULL;
+  for (huge_region_t** p = &g_huge_cached; *p != NULL; p = &(*p)->next) {
+    size_t candidate = (*p)->size;
+    if (candidate >= size && candidate / 2 < size && (best == NULL || candidate < (*best)->size)) {
+      best = p;
+    }
+  }
+  if (best == NULL) {
+    return NULL;
+  }
+  huge_region_t* region = *best;
+  *best = region->next;
+  g_huge_cached_bytes -= region->size;
+  return region;
+}
+
+void* android_malloc_huge(size_t size) {
+  if (size > SIZE_MAX - 2 * kHugePageSize) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  size = (size == 0) ? kHugePageSize : (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+
+  {
+    ScopedPthreadMutexLocker locker(&g_huge_lock);
+    huge_region_t* region = take_cached_region(size);
+    if (region != NULL) {
+      region->next = g_huge_in_use;
+      g_huge_in_use = region;
+      return region->base;
+    }
+  }
+
+  // Don't hold the lock across the system calls.
+  huge_region_t* region = reinterpret_cast<huge_region_t*>(malloc(sizeof(huge_region_t)));
+  if (region == NULL) {
+    return NULL;
+  }
+  region->base = map_huge_region(size);
+  if (region->base == NULL) {
+    free(region);
+    errno = ENOMEM;
+    return NULL;
+  }
+  region->size = size;
+
+  ScopedPthreadMutexLocker locker(&g_huge_lock);
+  region->next = g_huge_in_use;
+  g_huge_in_use = region;
+  return region->base;
+}
+
+void android_free_huge(void* p) {
+  if (p == NULL) {
+    return;
+  }
+
+  huge_region_t* region = NULL;
+  {
+    ScopedPthreadMutexLocker locker(&g_huge_lock);
+    for (huge_region_t** q = &g_huge_in_use; *q != NULL; q = &(*q)->next) {
+      if ((*q)->base == p) {
+        region = *q;
+        *q = region->next;
+        break;
+      }
+    }
+    if (region == NULL) {
+      __libc_fatal("android_free_huge: %p wasn't returned by android_malloc_huge", p);
+    }
+    if (g_huge_cached_bytes + region->size <= kMaxCachedBytes) {
+      region->next = g_huge_cached;
+      g_huge_cached = region;
+      g_huge_cached_bytes += region->size;
+      return;
+    }
+  }
+
+  munmap(region->base, region->size);
+  free(region);
+}
+
+void __trim_huge_cache() {
+  huge_region_t* region;
+  {
+    ScopedPthreadMutexLocker locker(&g_huge_lock);
+    region = g_huge_cached;
+    g_huge_cached = NULL;
+    g_huge_cached_bytes = 0;
+  }
+
+  while (region != NULL) {
+    huge_region_t* next = region->next;
+    munmap(region->base, region->size);
+    free(region);
+    region = next;
+  }
+}
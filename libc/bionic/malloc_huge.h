@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LIBC_BIONIC_MALLOC_HUGE_H_
+#define LIBC_BIONIC_MALLOC_HUGE_H_
+
+#include <sys/cdefs.h>
+
+// Unmaps the freed regions android_malloc_huge is keeping for reuse.
+// Called by malloc_trim.
+__LIBC_HIDDEN__ void __trim_huge_cache();
+
+#endif  // LIBC_BIONIC_MALLOC_HUGE_H_
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "malloc_thread_cache.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+#include "dlmalloc.h"
+
+#include "private/bionic_prctl.h"
+#include "private/bionic_tls.h"
+
+// Requests up to kMaxCachedSize bytes are served from the cache, in size
+// classes kSizeClassGranule bytes apart. Class c holds blocks whose usable
+// size is at least (c + 1) * kSizeClassGranule, so any of them satisfies a
+// request that rounds up to that class.
+static const size_t kSizeClassGranule = 16;
+static const size_t kMaxCachedSize = 128;
+static const size_t kSizeClassCount = kMaxCachedSize / kSizeClassGranule;
+
+// Each magazine holds at most kMagazineSize blocks, which bounds the memory
+// a thread can hold back from the heap. Refills and flushes move half a
+// magazine at a time, under a single acquisition of the dlmalloc lock.
+static const size_t kMagazineSize = 32;
+static const size_t kBatchSize = kMagazineSize / 2;
+
+struct ThreadCacheBin {
+  size_t count;
+  void* blocks[kMagazineSize];
+};
+
+struct ThreadCache {
+  ThreadCacheBin bins[kSizeClassCount];
+};
+
+// Cleared by mallopt(M_THREAD_CACHE, 0). Each thread empties its own cache
+// the next time it allocates or frees.
+static volatile bool g_thread_cache_enabled = true;
+
+// Set by mallopt(M_SEGREGATE_ON_FORK, 1), and checked in the fork child.
+static volatile bool g_segregate_on_fork = false;
+
+// Set in a child whose heap has been segregated from its parent's. Blocks
+// from the parent's heap are never freed from then on, since doing so would
+// write to pages the child would otherwise go on sharing with its parent.
+static bool g_heap_segregated = false;
+
+// Stored in the TLS slot of a thread that has drained its cache, or that
+// failed to map one, so that it goes straight to dlmalloc from then on.
+static ThreadCache* const kThreadCacheDisabled = reinterpret_cast<ThreadCache*>(UINTPTR_MAX);
+
+static void thread_cache_flush_all(ThreadCache* cache) {
+  for (size_t c = 0; c < kSizeClassCount; ++c) {
+    dlbulk_free(cache->bins[c].blocks, cache->bins[c].count);
+    cache->bins[c].count = 0;
+  }
+}
+
+static ThreadCache* thread_cache_get() {
+  void** slot = &__get_tls()[TLS_SLOT_MALLOC_CACHE];
+  ThreadCache* cache = reinterpret_cast<ThreadCache*>(*slot);
+  if (__predict_true(cache != NULL)) {
+    if (cache == kThreadCacheDisabled) {
+      return NULL;
+    }
+    if (__predict_false(!g_thread_cache_enabled)) {
+      thread_cache_flush_all(cache);
+      return NULL;
+    }
+    return cache;
+  }
+  if (!g_thread_cache_enabled) {
+    return NULL;
+  }
+
+  // The cache can't come from the heap it sits in front of.
+  void* map = mmap(NULL, sizeof(ThreadCache), PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    *slot = kThreadCacheDisabled;
+    return NULL;
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, sizeof(ThreadCache), "libc_malloc");
+  *slot = map;
+  return reinterpret_cast<ThreadCache*>(map);
+}
+
+// Allocates kBatchSize blocks for size class c in one call into dlmalloc.
+static bool thread_cache_refill(ThreadCacheBin* bin, size_t c) {
+  size_t sizes[kBatchSize];
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    sizes[i] = (c + 1) * kSizeClassGranule;
+  }
+  if (dlindependent_comalloc(kBatchSize, sizes, bin->blocks) == NULL) {
+    return false;
+  }
+  bin->count = kBatchSize;
+  return true;
+}
+
+// Returns the oldest kBatchSize blocks to dlmalloc in one call, keeping the
+// most recently freed (and most likely still cache-hot) ones.
+static void thread_cache_flush(ThreadCacheBin* bin) {
+  dlbulk_free(bin->blocks, kBatchSize);
+  memmove(&bin->blocks[0], &bin->blocks[kBatchSize], (bin->count - kBatchSize) * sizeof(void*));
+  bin->count -= kBatchSize;
+}
+
+void* thread_cache_malloc(size_t bytes) {
+  if (bytes <= kMaxCachedSize) {
+    ThreadCache* cache = thread_cache_get();
+    if (cache != NULL) {
+      size_t c = (bytes == 0) ? 0 : (bytes - 1) / kSizeClassGranule;
+      ThreadCacheBin* bin = &cache->bins[c];
+      if (bin->count > 0 || thread_cache_refill(bin, c)) {
+        return bin->blocks[--bin->count];
+      }
+    }
+  }
+  return dlmalloc(bytes);
+}
+
+void* thread_cache_calloc(size_t n_elements, size_t elem_size) {
+  // Anything that might overflow is left to dlcalloc to reject.
+  if (n_elements <= kMaxCachedSize && elem_size <= kMaxCachedSize) {
+    size_t bytes = n_elements * elem_size;
+    if (bytes <= kMaxCachedSize) {
+      void* mem = thread_cache_malloc(bytes);
+      if (mem != NULL) {
+        memset(mem, 0, bytes);
+      }
+      return mem;
+    }
+  }
+  return dlcalloc(n_elements, elem_size);
+}
+
+void thread_cache_free(void* mem) {
+  if (mem == NULL) {
+    return;
+  }
+  if (__predict_false(g_heap_segregated) && dlmalloc_is_segregated(mem)) {
+    return;
+  }
+
+  size_t usable = dlmalloc_usable_size(mem);
+  if (usable >= kSizeClassGranule && usable < kMaxCachedSize + kSizeClassGranule) {
+    ThreadCache* cache = thread_cache_get();
+    if (cache != NULL) {
+      ThreadCacheBin* bin = &cache->bins[usable / kSizeClassGranule - 1];
+      if (bin->count == kMagazineSize) {
+        thread_cache_flush(bin);
+      }
+      bin->blocks[bin->count++] = mem;
+      return;
+    }
+  }
+  dlfree(mem);
+}
+
+// A block that was asked for with this many bytes has at least that much
+// usable space, so it can go in the bin that size rounds down to without
+// reading its chunk header. It may really belong in a bigger bin, but a bin
+// never hands out less than its class promises.
+void thread_cache_free_sized(void* mem, size_t bytes) {
+  if (mem == NULL || bytes < kSizeClassGranule || bytes >= kMaxCachedSize + kSizeClassGranule ||
+      __predict_false(g_heap_segregated)) {
+    thread_cache_free(mem);
+    return;
+  }
+
+  ThreadCache* cache = thread_cache_get();
+  if (cache == NULL) {
+    dlfree(mem);
+    return;
+  }
+  ThreadCacheBin* bin = &cache->bins[bytes / kSizeClassGranule - 1];
+  if (bin->count == kMagazineSize) {
+    thread_cache_flush(bin);
+  }
+  bin->blocks[bin->count++] = mem;
+}
+
+void* thread_cache_realloc(void* mem, size_t bytes) {
+  if (__predict_false(g_heap_segregated) && mem != NULL && dlmalloc_is_segregated(mem)) {
+    // Resizing in place would update the parent's heap, so always move.
+    if (bytes == 0) {
+      return NULL;
+    }
+    void* new_mem = thread_cache_malloc(bytes);
+    if (new_mem != NULL) {
+      memcpy(new_mem, mem, MIN(bytes, dlmalloc_usable_size(mem)));
+    }
+    return new_mem;
+  }
+  return dlrealloc(mem, bytes);
+}
+
+void thread_cache_drain() {
+  void** slot = &__get_tls()[TLS_SLOT_MALLOC_CACHE];
+  ThreadCache* cache = reinterpret_cast<ThreadCache*>(*slot);
+  *slot = kThreadCacheDisabled;
+  if (cache == NULL || cache == kThreadCacheDisabled) {
+    return;
+  }
+
+  thread_cache_flush_all(cache);
+  munmap(cache, sizeof(ThreadCache));
+}
+
+int thread_cache_malloc_trim(size_t pad) {
+  // Other threads' caches can't be touched from here.
+  ThreadCache* cache = reinterpret_cast<ThreadCache*>(__get_tls()[TLS_SLOT_MALLOC_CACHE]);
+  if (cache != NULL && cache != kThreadCacheDisabled) {
+    thread_cache_flush_all(cache);
+  }
+  int trimmed = dlmalloc_trim(pad);
+  return (dlmalloc_release_free_pages() != 0 || trimmed) ? 1 : 0;
+}
+
+// Runs in the child after every fork, as the only thread. dlmalloc's own
+// fork handlers segregate the heap itself, under its lock. The blocks in the
+// calling thread's cache belong to the parent's heap, so they're dropped
+// rather than flushed.
+static void thread_cache_segregate_heap() {
+  if (!g_segregate_on_fork) {
+    return;
+  }
+  ThreadCache* cache = reinterpret_cast<ThreadCache*>(__get_tls()[TLS_SLOT_MALLOC_CACHE]);
+  if (cache != NULL && cache != kThreadCacheDisabled) {
+    for (size_t c = 0; c < kSizeClassCount; ++c) {
+      cache->bins[c].count = 0;
+    }
+  }
+  g_heap_segregated = true;
+}
+
+static pthread_once_t g_fork_handler_once = PTHREAD_ONCE_INIT;
+static bool g_fork_handler_registered = false;
+
+static void register_fork_handler() {
+  g_fork_handler_registered = (pthread_atfork(NULL, NULL, thread_cache_segregate_heap) == 0);
+}
+
+int thread_cache_mallopt(int param, int value) {
+  switch (param) {
+    case M_ARENA_MAX:
+      // There's only ever the one heap.
+      return (value >= 1) ? 1 : 0;
+    case M_PURGE:
+      thread_cache_malloc_trim(0);
+      return 1;
+    case M_THREAD_CACHE:
+      g_thread_cache_enabled = (value != 0);
+      return 1;
+    case M_SEGREGATE_ON_FORK:
+      pthread_once(&g_fork_handler_once, register_fork_handler);
+      if (!g_fork_handler_registered) {
+        return 0;
+      }
+      g_segregate_on_fork = (value != 0);
+      dlmalloc_set_segregate_on_fork(value != 0);
+      return 1;
+    default:
+      return dlmallopt(param, value);
+  }
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
+#define LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
+
+#include <sys/cdefs.h>
+#include <stddef.h>
+
+// Per-thread caches of small blocks in front of dlmalloc. Each thread keeps
+// a bounded magazine of free blocks per size class, refilled from and
+// flushed to the shared heap in batches so that most small malloc/free
+// calls never take the global dlmalloc lock. Cached blocks are ordinary
+// in-use dlmalloc chunks, so dlmalloc_usable_size, dlrealloc and dlfree
+// all work on any pointer these functions return.
+
+__BEGIN_DECLS
+
+__LIBC_HIDDEN__ void* thread_cache_calloc(size_t n_elements, size_t elem_size);
+__LIBC_HIDDEN__ void thread_cache_free(void* mem);
+__LIBC_HIDDEN__ void thread_cache_free_sized(void* mem, size_t bytes);
+__LIBC_HIDDEN__ void* thread_cache_malloc(size_t bytes);
+__LIBC_HIDDEN__ void* thread_cache_realloc(void* mem, size_t bytes);
+
+// dlmalloc_trim, after emptying the calling thread's cache, followed by
+// releasing the pages inside free chunks.
+__LIBC_HIDDEN__ int thread_cache_malloc_trim(size_t pad);
+
+// dlmallopt, plus the parameters that concern the caches and the heap
+// segregation after fork (see <malloc.h>).
+__LIBC_HIDDEN__ int thread_cache_mallopt(int param, int value);
+
+// Returns the calling thread's cached blocks to the heap and stops caching
+// for the rest of the thread's life. Called by pthread_exit.
+__LIBC_HIDDEN__ void thread_cache_drain();
+
+__END_DECLS
+
+#endif  // LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
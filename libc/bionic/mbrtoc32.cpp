@@ -32,6 +32,7 @@
 #include <wchar.h>
 
 #include "private/bionic_mbstate.h"
+#include "private/bionic_utf8.h"
 
 size_t mbrtoc32(char32_t* pc32, const char* s, size_t n, mbstate_t* ps) {
   static mbstate_t __private_state;
@@ -62,6 +63,17 @@ size_t mbrtoc32(char32_t* pc32, const char* s, size_t n, mbstate_t* ps) {
     }
     return (ch != '\0' ? 1 : 0);
   }
+  if (mbsinit(state)) {
+    // Fast path for complete, valid multibyte characters.
+    char32_t c32;
+    size_t length = utf8_decode_multibyte(s, n, &c32);
+    if (length != 0) {
+      if (pc32 != NULL) {
+        *pc32 = c32;
+      }
+      return length;
+    }
+  }
 
   // Determine the number of octets that make up this character
   // from the first octet, and a mask that extracts the
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "private/bionic_two_way.h"
+
+// Short needles are first looked for a word at a time: a position is only
+// a candidate if both the needle's first and last bytes are there, which
+// rules out nearly all of them in ordinary text. Repetitive input can make
+// nearly all of them candidates, so after too many near misses the rest of
+// the haystack is searched with Two-Way, which is linear however bad the
+// input. Longer needles go straight to Two-Way, whose bad character skips
+// get longer with the needle.
+static const size_t kFilterMaxNeedle = 32;
+
+static const unsigned char* memmem_filter(const unsigned char* h, size_t n,
+                                          const unsigned char* x, size_t m) {
+  const unsigned long ones = ~0UL / 0xff;
+  const unsigned long highs = ones << 7;
+  const unsigned long first = ones * x[0];
+  const unsigned long last = ones * x[m - 1];
+  const size_t last_candidate = n - m;
+  size_t misses = 0;
+  size_t i = 0;
+
+  for (; i + sizeof(unsigned long) <= last_candidate + 1; i += sizeof(unsigned long)) {
+    unsigned long a, b;
+    memcpy(&a, h + i, sizeof(a));
+    memcpy(&b, h + i + m - 1, sizeof(b));
+    // v has a zero byte for each candidate, and found its high bit.
+    unsigned long v = (a ^ first) | (b ^ last);
+    unsigned long found = ~(((v & ~highs) + ~highs) | v) & highs;
+    while (found != 0) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      size_t j = i + __builtin_ctzl(found) / 8;
+      found &= found - 1;
+#else
+      size_t j = i + __builtin_clzl(found) / 8;
+      found &= ~(1UL << (sizeof(found) * 8 - 1 - __builtin_clzl(found)));
+#endif
+      if (memcmp(h + j + 1, x + 1, m - 2) == 0) {
+        return h + j;
+      }
+      if (++misses > i / 8 + 64) {
+        return two_way_search(h + j + 1, n - j - 1, x, m, IdentityFold<unsigned char>());
+      }
+    }
+  }
+  for (; i <= last_candidate; ++i) {
+    if (h[i] == x[0] && h[i + m - 1] == x[m - 1] && memcmp(h + i + 1, x + 1, m - 2) == 0) {
+      return h + i;
+    }
+  }
+  return NULL;
+}
+
+void* memmem(const void* haystack, size_t n, const void* needle, size_t m) {
+  if (m > n || !m || !n) {
+    return NULL;
+  }
+
+  const unsigned char* h = static_cast<const unsigned char*>(haystack);
+  const unsigned char* x = static_cast<const unsigned char*>(needle);
+  if (m == 1) {
+    return const_cast<void*>(memchr(h, x[0], n));
+  }
+  const unsigned char* result = (m <= kFilterMaxNeedle) ?
+      memmem_filter(h, n, x, m) : two_way_search(h, n, x, m, IdentityFold<unsigned char>());
+  return const_cast<unsigned char*>(result);
+}
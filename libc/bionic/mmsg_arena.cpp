@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/mmsg_arena.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// The addresses, headers and iovecs, followed by the buffers, all in the
+// one allocation.
+struct android_mmsg_arena {
+  size_t count;
+  size_t buffer_size;
+  mmsghdr* msgs;
+  iovec* iovs;
+  sockaddr_storage* addrs;
+  char* buffers;
+};
+
+android_mmsg_arena_t* android_mmsg_arena_create(size_t count, size_t buffer_size) {
+  size_t per_message = sizeof(mmsghdr) + sizeof(iovec) + sizeof(sockaddr_storage);
+  if (count == 0 || count > UINT_MAX ||
+      (buffer_size != 0 && count > (SIZE_MAX - sizeof(android_mmsg_arena)) / (per_message + buffer_size))) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  char* p = reinterpret_cast<char*>(calloc(1, sizeof(android_mmsg_arena) + count * (per_message + buffer_size)));
+  if (p == NULL) {
+    return NULL;
+  }
+  android_mmsg_arena_t* arena = reinterpret_cast<android_mmsg_arena_t*>(p);
+  arena->count = count;
+  arena->buffer_size = buffer_size;
+  arena->addrs = reinterpret_cast<sockaddr_storage*>(p + sizeof(android_mmsg_arena));
+  arena->msgs = reinterpret_cast<mmsghdr*>(arena->addrs + count);
+  arena->iovs = reinterpret_cast<iovec*>(arena->msgs + count);
+  arena->buffers = reinterpret_cast<char*>(arena->iovs + count);
+  for (size_t i = 0; i < count; ++i) {
+    arena->iovs[i].iov_base = arena->buffers + i * buffer_size;
+    arena->iovs[i].iov_len = buffer_size;
+    arena->msgs[i].msg_hdr.msg_iov = &arena->iovs[i];
+    arena->msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  return arena;
+}
+
+void android_mmsg_arena_destroy(android_mmsg_arena_t* arena) {
+  free(arena);
+}
+
+mmsghdr* android_mmsg_arena_msgs(android_mmsg_arena_t* arena) {
+  return arena->msgs;
+}
+
+void* android_mmsg_arena_buffer(android_mmsg_arena_t* arena, size_t i) {
+  return arena->buffers + i * arena->buffer_size;
+}
+
+int android_mmsg_arena_set_message(android_mmsg_arena_t* arena, size_t i, size_t length,
+                                   const sockaddr* addr, socklen_t addr_length) {
+  if (i >= arena->count || length > arena->buffer_size ||
+      (addr != NULL && addr_length > sizeof(sockaddr_storage))) {
+    errno = EINVAL;
+    return -1;
+  }
+  msghdr* hdr = &arena->msgs[i].msg_hdr;
+  arena->iovs[i].iov_len = length;
+  if (addr != NULL) {
+    memcpy(&arena->addrs[i], addr, addr_length);
+    hdr->msg_name = &arena->addrs[i];
+    hdr->msg_namelen = addr_length;
+  } else {
+    hdr->msg_name = NULL;
+    hdr->msg_namelen = 0;
+  }
+  hdr->msg_control = NULL;
+  hdr->msg_controllen = 0;
+  hdr->msg_flags = 0;
+  return 0;
+}
+
+int android_mmsg_arena_recv(android_mmsg_arena_t* arena, int fd, int flags, const timespec* timeout) {
+  // recvmmsg shrinks the lengths to what it received, so restore them.
+  for (size_t i = 0; i < arena->count; ++i) {
+    msghdr* hdr = &arena->msgs[i].msg_hdr;
+    arena->iovs[i].iov_len = arena->buffer_size;
+    hdr->msg_name = &arena->addrs[i];
+    hdr->msg_namelen = sizeof(sockaddr_storage);
+    hdr->msg_control = NULL;
+    hdr->msg_controllen = 0;
+    hdr->msg_flags = 0;
+    arena->msgs[i].msg_len = 0;
+  }
+  return recvmmsg(fd, arena->msgs, arena->count, flags, timeout);
+}
+
+int android_mmsg_arena_send(android_mmsg_arena_t* arena, int fd, size_t count, int flags) {
+  if (count > arena->count) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t sent = 0;
+  while (sent < count) {
+    int rc = sendmmsg(fd, arena->msgs + sent, count - sent, flags);
+    if (rc == -1 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return (sent > 0) ? static_cast<int>(sent) : -1;
+    }
+    sent += rc;
+  }
+  return sent;
+}
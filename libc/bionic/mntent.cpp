@@ -28,14 +28,120 @@
 
 #include <mntent.h>
 
-mntent* getmntent(FILE*) {
-  return NULL;
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include "private/ScopedFd.h"
+#include "private/ThreadLocalBuffer.h"
+
+struct getmntent_buffer_t {
+  mntent entry;
+  char strings[BUFSIZ];
+};
+
+GLOBAL_INIT_THREAD_LOCAL_BUFFER(getmntent);
+
+// Splits off the next field of a line, NUL-terminating it in place and leaving
+// *p just past it. Returns NULL at the end of the line.
+static char* next_field(char** p) {
+  char* s = *p;
+  while (*s == ' ' || *s == '\t') {
+    ++s;
+  }
+  if (*s == '\0' || *s == '\n') {
+    *p = s;
+    return NULL;
+  }
+  char* field = s;
+  while (*s != '\0' && *s != ' ' && *s != '\t' && *s != '\n') {
+    ++s;
+  }
+  if (*s != '\0') {
+    *s++ = '\0';
+  }
+  *p = s;
+  return field;
 }
 
-mntent* getmntent_r(FILE*, struct mntent*, char*, int) {
+// The kernel escapes spaces, tabs, newlines and backslashes in paths as \040 and so on.
+static char* unescape(char* s) {
+  char* out = s;
+  for (const char* in = s; *in != '\0'; ++in) {
+    if (in[0] == '\\' && in[1] >= '0' && in[1] <= '3' && in[2] >= '0' && in[2] <= '7' &&
+        in[3] >= '0' && in[3] <= '7') {
+      *out++ = ((in[1] - '0') << 6) | ((in[2] - '0') << 3) | (in[3] - '0');
+      in += 3;
+    } else {
+      *out++ = *in;
+    }
+  }
+  *out = '\0';
+  return s;
+}
+
+static unsigned parse_unsigned(const char* s, const char** end) {
+  unsigned result = 0;
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    result = result * 10 + (*s - '0');
+  }
+  if (end != NULL) {
+    *end = s;
+  }
+  return result;
+}
+
+mntent* getmntent_r(FILE* fp, struct mntent* e, char* buf, int buf_len) {
+  if (fp == NULL || e == NULL || buf == NULL || buf_len <= 0) {
+    return NULL;
+  }
+
+  while (fgets(buf, buf_len, fp) != NULL) {
+    if (strchr(buf, '\n') == NULL) {
+      // Use as much of an overlong line as fits, and skip the rest.
+      int ch;
+      while ((ch = getc(fp)) != EOF && ch != '\n') {
+      }
+    }
+
+    char* p = buf;
+    char* fsname = next_field(&p);
+    if (fsname == NULL || fsname[0] == '#') {
+      continue;
+    }
+    char* dir = next_field(&p);
+    char* type = next_field(&p);
+    char* opts = next_field(&p);
+    if (dir == NULL || type == NULL || opts == NULL) {
+      continue;
+    }
+    char* freq = next_field(&p);
+    char* passno = (freq != NULL) ? next_field(&p) : NULL;
+
+    e->mnt_fsname = unescape(fsname);
+    e->mnt_dir = unescape(dir);
+    e->mnt_type = unescape(type);
+    e->mnt_opts = unescape(opts);
+    e->mnt_freq = (freq != NULL) ? parse_unsigned(freq, NULL) : 0;
+    e->mnt_passno = (passno != NULL) ? parse_unsigned(passno, NULL) : 0;
+    return e;
+  }
   return NULL;
 }
 
+mntent* getmntent(FILE* fp) {
+  LOCAL_INIT_THREAD_LOCAL_BUFFER(getmntent_buffer_t*, getmntent, sizeof(getmntent_buffer_t));
+  if (getmntent_tls_buffer == NULL) {
+    return NULL;
+  }
+  return getmntent_r(fp, &getmntent_tls_buffer->entry,
+                     getmntent_tls_buffer->strings, sizeof(getmntent_tls_buffer->strings));
+}
+
 FILE* setmntent(const char* path, const char* mode) {
   return fopen(path, mode);
 }
@@ -46,3 +152,114 @@ int endmntent(FILE* fp) {
   }
   return 1;
 }
+
+// A line of /proc/self/mountinfo (see proc(5)) looks like this, with any
+// number of optional fields before the "-":
+//   36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+static bool parse_mountinfo_line(char* line, android_mountinfo* info) {
+  char* p = line;
+  char* mount_id = next_field(&p);
+  char* parent_id = next_field(&p);
+  char* dev = next_field(&p);
+  char* root = next_field(&p);
+  char* mount_point = next_field(&p);
+  char* mount_options = next_field(&p);
+  if (mount_options == NULL) {
+    return false;
+  }
+  char* field;
+  while ((field = next_field(&p)) != NULL && strcmp(field, "-") != 0) {
+  }
+  if (field == NULL) {
+    return false;
+  }
+  char* fs_type = next_field(&p);
+  char* source = next_field(&p);
+  char* super_options = next_field(&p);
+  if (super_options == NULL) {
+    return false;
+  }
+
+  const char* minor;
+  unsigned major = parse_unsigned(dev, &minor);
+  if (*minor != ':') {
+    return false;
+  }
+  info->mount_id = parse_unsigned(mount_id, NULL);
+  info->parent_id = parse_unsigned(parent_id, NULL);
+  info->dev = makedev(major, parse_unsigned(minor + 1, NULL));
+  info->root = unescape(root);
+  info->mount_point = unescape(mount_point);
+  info->mount_options = mount_options;
+  info->fs_type = unescape(fs_type);
+  info->source = unescape(source);
+  info->super_options = super_options;
+  return true;
+}
+
+int android_mountinfo_iterate(int (*callback)(const struct android_mountinfo*, void*), void* arg) {
+  ScopedFd fd(open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return -1;
+  }
+
+  // Read the table in big chunks rather than a line at a time through stdio. The
+  // buffer only has to grow if a single line doesn't fit.
+  size_t capacity = 64 * 1024;
+  char* buf = reinterpret_cast<char*>(malloc(capacity));
+  if (buf == NULL) {
+    return -1;
+  }
+  size_t used = 0;
+  int result = 0;
+  while (result == 0) {
+    if (used == capacity) {
+      char* new_buf = reinterpret_cast<char*>(realloc(buf, capacity * 2));
+      if (new_buf == NULL) {
+        result = -1;
+        break;
+      }
+      buf = new_buf;
+      capacity *= 2;
+    }
+    ssize_t n = TEMP_FAILURE_RETRY(read(fd.get(), buf + used, capacity - used));
+    if (n <= 0) {
+      if (n == -1) {
+        result = -1;
+      }
+      break;
+    }
+    used += n;
+
+    char* line = buf;
+    char* end = buf + used;
+    char* newline;
+    while (result == 0 &&
+           (newline = reinterpret_cast<char*>(memchr(line, '\n', end - line))) != NULL) {
+      *newline = '\0';
+      android_mountinfo info;
+      if (parse_mountinfo_line(line, &info)) {
+        result = callback(&info, arg);
+      }
+      line = newline + 1;
+    }
+    used = end - line;
+    memmove(buf, line, used);
+  }
+  free(buf);
+  return result;
+}
+
+int android_mounts_changed(int fd, int timeout_ms) {
+  // The kernel flags the mount table files POLLPRI | POLLERR when the table has
+  // changed since the file was opened or the last poll that reported a change.
+  pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLPRI;
+  pfd.revents = 0;
+  int rc = TEMP_FAILURE_RETRY(poll(&pfd, 1, timeout_ms));
+  if (rc == -1) {
+    return -1;
+  }
+  return (pfd.revents & (POLLPRI | POLLERR)) != 0;
+}
@@ -15,6 +15,7 @@
  */
 
 #include <errno.h>
+#include <malloc.h>
 #include <new>
 #include <stdlib.h>
 
@@ -61,3 +62,64 @@ void  operator delete(void* ptr, const std::nothrow_t&) {
 void  operator delete[](void* ptr, const std::nothrow_t&) {
     free(ptr);
 }
+
+// The size tells the allocator which size class the block is in, which it would
+// otherwise have to read from the block's header.
+void  operator delete(void* ptr, std::size_t size) {
+    free_sized(ptr, size);
+}
+
+void  operator delete[](void* ptr, std::size_t size) {
+    free_sized(ptr, size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* p = memalign(static_cast<std::size_t>(alignment), size);
+    if (p == NULL) {
+        __libc_fatal("new failed to allocate %zu bytes aligned to %zu",
+                     size, static_cast<std::size_t>(alignment));
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    void* p = memalign(static_cast<std::size_t>(alignment), size);
+    if (p == NULL) {
+        __libc_fatal("new[] failed to allocate %zu bytes aligned to %zu",
+                     size, static_cast<std::size_t>(alignment));
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) {
+    return memalign(static_cast<std::size_t>(alignment), size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) {
+    return memalign(static_cast<std::size_t>(alignment), size);
+}
+
+// memalign's blocks are carved out of bigger ones, so their sizes aren't worth passing on.
+void  operator delete(void* ptr, std::align_val_t) {
+    free(ptr);
+}
+
+void  operator delete[](void* ptr, std::align_val_t) {
+    free(ptr);
+}
+
+void  operator delete(void* ptr, std::size_t, std::align_val_t) {
+    free(ptr);
+}
+
+void  operator delete[](void* ptr, std::size_t, std::align_val_t) {
+    free(ptr);
+}
+
+void  operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) {
+    free(ptr);
+}
+
+void  operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) {
+    free(ptr);
+}
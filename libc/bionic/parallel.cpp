@@ -0,0 +1,472 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/parallel.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "private/bionic_futex.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+extern __LIBC_HIDDEN__ int __sched_online_cpu_count();
+
+// Tasks are heap-allocated by whoever submits them and freed by whoever runs
+// them. User tasks and android_parallel_for's range tasks share the struct so
+// that each costs a single allocation.
+struct Task {
+  void (*run)(Task*);
+  android_task_group_t* group;
+  Task* next; // Only used on the injection queue.
+
+  void (*fn)(void*);
+  void* arg;
+
+  struct ParallelFor* parallel_for;
+  size_t begin;
+  size_t end;
+};
+
+struct android_task_group {
+  // The futex android_task_group_wait sleeps on: woken when it drops to 0.
+  atomic_int pending;
+};
+
+// A fixed-size Chase-Lev deque. Only the owning worker pushes and pops, at
+// the bottom; everybody else steals from the top.
+static const long kDequeCapacity = 4096;
+
+struct WorkDeque {
+  atomic_long top;
+  atomic_long bottom;
+  atomic_uintptr_t tasks[kDequeCapacity];
+} __attribute__((aligned(64)));
+
+static bool DequePush(WorkDeque* deque, Task* task) {
+  long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  if (b - t >= kDequeCapacity) {
+    return false;
+  }
+  atomic_store_explicit(&deque->tasks[b & (kDequeCapacity - 1)], reinterpret_cast<uintptr_t>(task),
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static Task* DequePop(WorkDeque* deque) {
+  long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+  if (t > b) {
+    // Empty.
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return NULL;
+  }
+  Task* task = reinterpret_cast<Task*>(
+      atomic_load_explicit(&deque->tasks[b & (kDequeCapacity - 1)], memory_order_relaxed));
+  if (t == b) {
+    // The last task: race any thieves for it.
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+      task = NULL;
+    }
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  }
+  return task;
+}
+
+static Task* DequeSteal(WorkDeque* deque) {
+  long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (t >= b) {
+    return NULL;
+  }
+  Task* task = reinterpret_cast<Task*>(
+      atomic_load_explicit(&deque->tasks[t & (kDequeCapacity - 1)], memory_order_relaxed));
+  if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                               memory_order_seq_cst, memory_order_relaxed)) {
+    // Lost the race to the owner or another thief.
+    return NULL;
+  }
+  return task;
+}
+
+struct Worker {
+  WorkDeque deque;
+  pthread_t thread;
+};
+
+// More workers than this would only contend; big machines can use more
+// threads of their own.
+static const int kMaxWorkers = 31;
+
+struct ThreadPool {
+  pid_t pid; // The process that started the workers; 0 until then.
+  bool fork_handlers_registered;
+  Worker* workers;
+  atomic_int worker_count;
+
+  // Tasks submitted from threads that aren't workers.
+  pthread_mutex_t injection_lock;
+  Task* injection_head;
+  Task* injection_tail;
+  atomic_int injection_count;
+
+  // Idle workers sleep on sleep_seq, which every submission bumps.
+  atomic_int sleep_seq;
+  atomic_int sleepers;
+
+  bool current_worker_key_created;
+  pthread_key_t current_worker_key;
+};
+
+static ThreadPool g_pool;
+static pthread_mutex_t g_pool_start_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static Worker* CurrentWorker() {
+  if (!g_pool.current_worker_key_created) {
+    return NULL;
+  }
+  return reinterpret_cast<Worker*>(pthread_getspecific(g_pool.current_worker_key));
+}
+
+static void InjectTask(Task* task) {
+  ScopedPthreadMutexLocker locker(&g_pool.injection_lock);
+  task->next = NULL;
+  if (g_pool.injection_tail == NULL) {
+    g_pool.injection_head = task;
+  } else {
+    g_pool.injection_tail->next = task;
+  }
+  g_pool.injection_tail = task;
+  atomic_fetch_add_explicit(&g_pool.injection_count, 1, memory_order_relaxed);
+}
+
+static Task* TakeInjectedTask() {
+  // Look before taking the lock; workers come here every time they run dry.
+  if (atomic_load_explicit(&g_pool.injection_count, memory_order_relaxed) == 0) {
+    return NULL;
+  }
+  ScopedPthreadMutexLocker locker(&g_pool.injection_lock);
+  Task* task = g_pool.injection_head;
+  if (task != NULL) {
+    g_pool.injection_head = task->next;
+    if (g_pool.injection_head == NULL) {
+      g_pool.injection_tail = NULL;
+    }
+    atomic_fetch_sub_explicit(&g_pool.injection_count, 1, memory_order_relaxed);
+  }
+  return task;
+}
+
+static Task* FindTask(Worker* self) {
+  Task* task;
+  if (self != NULL && (task = DequePop(&self->deque)) != NULL) {
+    return task;
+  }
+  if ((task = TakeInjectedTask()) != NULL) {
+    return task;
+  }
+  int count = atomic_load_explicit(&g_pool.worker_count, memory_order_acquire);
+  int start = (self != NULL) ? (self - g_pool.workers) + 1 : 0;
+  for (int i = 0; i < count; ++i) {
+    Worker* victim = &g_pool.workers[(start + i) % count];
+    if (victim != self && (task = DequeSteal(&victim->deque)) != NULL) {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+static void RunTask(Task* task) {
+  android_task_group_t* group = task->group;
+  task->run(task);
+  free(task);
+  if (atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release) == 1) {
+    __futex_wake_ex(&group->pending, false, INT_MAX);
+  }
+}
+
+static void NotifyWorkers() {
+  atomic_fetch_add_explicit(&g_pool.sleep_seq, 1, memory_order_seq_cst);
+  if (atomic_load_explicit(&g_pool.sleepers, memory_order_seq_cst) > 0) {
+    __futex_wake_ex(&g_pool.sleep_seq, false, 1);
+  }
+}
+
+static void* WorkerMain(void* arg) {
+  Worker* self = reinterpret_cast<Worker*>(arg);
+  pthread_setspecific(g_pool.current_worker_key, self);
+
+  while (true) {
+    int seq = atomic_load_explicit(&g_pool.sleep_seq, memory_order_seq_cst);
+    Task* task = FindTask(self);
+    if (task != NULL) {
+      RunTask(task);
+      continue;
+    }
+    // Nothing to do. Any submission after we read 'seq' changes it, so we
+    // can't sleep through one.
+    atomic_fetch_add_explicit(&g_pool.sleepers, 1, memory_order_seq_cst);
+    __futex_wait_ex(&g_pool.sleep_seq, false, seq, NULL);
+    atomic_fetch_sub_explicit(&g_pool.sleepers, 1, memory_order_seq_cst);
+  }
+  return NULL;
+}
+
+// Nobody may be starting the pool or queueing a task while we fork, or the
+// child would inherit a lock that's never unlocked.
+static void PoolPrepareFork() {
+  pthread_mutex_lock(&g_pool_start_lock);
+  pthread_mutex_lock(&g_pool.injection_lock);
+}
+
+static void PoolParentFork() {
+  pthread_mutex_unlock(&g_pool.injection_lock);
+  pthread_mutex_unlock(&g_pool_start_lock);
+}
+
+// The workers don't exist in the child, and neither do the tasks they were
+// running, so the child forgets the parent's pool and starts its own when it
+// first needs one. Tasks queued but not yet run in the parent aren't run.
+static void PoolChildFork() {
+  pthread_mutex_init(&g_pool_start_lock, NULL);
+  pthread_mutex_init(&g_pool.injection_lock, NULL);
+  g_pool.injection_head = g_pool.injection_tail = NULL;
+  atomic_init(&g_pool.injection_count, 0);
+  atomic_init(&g_pool.sleep_seq, 0);
+  atomic_init(&g_pool.sleepers, 0);
+  atomic_init(&g_pool.worker_count, 0);
+  free(g_pool.workers);
+  g_pool.workers = NULL;
+  g_pool.pid = 0;
+  // The forking thread may have been one of the parent's workers.
+  if (g_pool.current_worker_key_created) {
+    pthread_setspecific(g_pool.current_worker_key, NULL);
+  }
+}
+
+// Returns the number of workers, starting them if this is the first use of the
+// pool in this process.
+static int StartPool() {
+  pid_t pid = getpid();
+  if (__predict_true(*reinterpret_cast<volatile pid_t*>(&g_pool.pid) == pid)) {
+    return atomic_load_explicit(&g_pool.worker_count, memory_order_acquire);
+  }
+
+  ScopedPthreadMutexLocker locker(&g_pool_start_lock);
+  if (g_pool.pid == pid) {
+    return atomic_load_explicit(&g_pool.worker_count, memory_order_acquire);
+  }
+
+  // Without the fork handlers a child could inherit held locks, so a pool
+  // that can't have them doesn't get any workers.
+  if (!g_pool.fork_handlers_registered) {
+    g_pool.fork_handlers_registered =
+        (pthread_atfork(PoolPrepareFork, PoolParentFork, PoolChildFork) == 0);
+  }
+
+  // The calling thread does its share while it waits, so one worker per
+  // remaining CPU keeps every CPU busy without oversubscribing.
+  int wanted = __sched_online_cpu_count() - 1;
+  if (wanted > kMaxWorkers) {
+    wanted = kMaxWorkers;
+  }
+  if (!g_pool.fork_handlers_registered) {
+    wanted = 0;
+  }
+
+  if (!g_pool.current_worker_key_created) {
+    g_pool.current_worker_key_created =
+        (pthread_key_create(&g_pool.current_worker_key, NULL) == 0);
+  }
+  if (!g_pool.current_worker_key_created) {
+    wanted = 0;
+  }
+  if (wanted > 0) {
+    g_pool.workers = reinterpret_cast<Worker*>(calloc(wanted, sizeof(Worker)));
+    if (g_pool.workers == NULL) {
+      wanted = 0;
+    }
+  }
+
+  int started = 0;
+  while (started < wanted) {
+    Worker* worker = &g_pool.workers[started];
+    if (pthread_create(&worker->thread, NULL, WorkerMain, worker) != 0) {
+      break;
+    }
+    pthread_detach(worker->thread);
+    char name[16];
+    snprintf(name, sizeof(name), "parallel-%d", started);
+    pthread_setname_np(worker->thread, name);
+    atomic_store_explicit(&g_pool.worker_count, ++started, memory_order_release);
+  }
+  g_pool.pid = pid;
+  return started;
+}
+
+static void SubmitTask(Task* task) {
+  atomic_fetch_add_explicit(&task->group->pending, 1, memory_order_relaxed);
+  if (StartPool() == 0) {
+    // With nobody to hand it to, just run it.
+    RunTask(task);
+    return;
+  }
+  Worker* self = CurrentWorker();
+  if (self != NULL) {
+    if (!DequePush(&self->deque, task)) {
+      // Our deque is full, which means there's more than enough to go round.
+      RunTask(task);
+      return;
+    }
+  } else {
+    InjectTask(task);
+  }
+  NotifyWorkers();
+}
+
+android_task_group_t* android_task_group_create() {
+  android_task_group_t* group =
+      reinterpret_cast<android_task_group_t*>(calloc(1, sizeof(android_task_group_t)));
+  if (group != NULL) {
+    atomic_init(&group->pending, 0);
+  }
+  return group;
+}
+
+void android_task_group_destroy(android_task_group_t* group) {
+  free(group);
+}
+
+static void RunUserTask(Task* task) {
+  task->fn(task->arg);
+}
+
+int android_task_submit(android_task_group_t* group, void (*fn)(void*), void* arg) {
+  if (group == NULL || fn == NULL) {
+    return EINVAL;
+  }
+  Task* task = reinterpret_cast<Task*>(malloc(sizeof(Task)));
+  if (task == NULL) {
+    fn(arg);
+    return 0;
+  }
+  task->run = RunUserTask;
+  task->group = group;
+  task->fn = fn;
+  task->arg = arg;
+  SubmitTask(task);
+  return 0;
+}
+
+void android_task_group_wait(android_task_group_t* group) {
+  Worker* self = CurrentWorker();
+  while (true) {
+    int pending = atomic_load_explicit(&group->pending, memory_order_acquire);
+    if (pending == 0) {
+      return;
+    }
+    // Help rather than block while there's anything to do; it may even be
+    // one of our own tasks.
+    Task* task = FindTask(self);
+    if (task != NULL) {
+      RunTask(task);
+      continue;
+    }
+    // Whatever's left is already running elsewhere.
+    __futex_wait_ex(&group->pending, false, pending, NULL);
+  }
+}
+
+struct ParallelFor {
+  void (*fn)(size_t, size_t, void*);
+  void* arg;
+  size_t grain;
+  android_task_group_t group;
+};
+
+static void ParallelForRange(ParallelFor* pf, size_t begin, size_t end);
+
+static void RunRangeTask(Task* task) {
+  ParallelForRange(task->parallel_for, task->begin, task->end);
+}
+
+static void ParallelForRange(ParallelFor* pf, size_t begin, size_t end) {
+  // Split off the top half for someone else until what's left is small enough,
+  // so idle workers steal big chunks and split them further themselves.
+  while (end - begin > pf->grain) {
+    size_t mid = begin + (end - begin) / 2;
+    Task* task = reinterpret_cast<Task*>(malloc(sizeof(Task)));
+    if (task == NULL) {
+      break;
+    }
+    task->run = RunRangeTask;
+    task->group = &pf->group;
+    task->parallel_for = pf;
+    task->begin = mid;
+    task->end = end;
+    SubmitTask(task);
+    end = mid;
+  }
+  pf->fn(begin, end, pf->arg);
+}
+
+int android_parallel_for(size_t begin, size_t end, size_t grain,
+                         void (*fn)(size_t, size_t, void*), void* arg) {
+  if (fn == NULL) {
+    return EINVAL;
+  }
+  if (end <= begin) {
+    return 0;
+  }
+  if (grain == 0) {
+    // A few chunks per thread lets the stealing even out uneven chunks.
+    size_t chunks = 4 * (StartPool() + 1);
+    grain = (end - begin + chunks - 1) / chunks;
+  }
+
+  ParallelFor pf;
+  pf.fn = fn;
+  pf.arg = arg;
+  pf.grain = grain;
+  atomic_init(&pf.group.pending, 0);
+  ParallelForRange(&pf, begin, end);
+  android_task_group_wait(&pf.group);
+  return 0;
+}
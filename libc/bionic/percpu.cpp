@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_percpu.h"
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "pthread_internal.h"
+#include "private/bionic_rseq.h"
+
+void __rseq_register_current_thread() {
+#if defined(__NR_rseq)
+  // On kernels without rseq this fails with ENOSYS and cpu_id stays
+  // BIONIC_RSEQ_CPU_ID_UNINITIALIZED, so __bionic_getcpu falls back to getcpu(2).
+  int saved_errno = errno;
+  syscall(__NR_rseq, &__get_thread()->rseq, sizeof(bionic_rseq), 0, BIONIC_RSEQ_SIG);
+  errno = saved_errno;
+#endif
+}
+
+void __rseq_unregister_current_thread() {
+#if defined(__NR_rseq)
+  pthread_internal_t* thread = __get_thread();
+  if (thread->rseq.cpu_id >= 0) {
+    int saved_errno = errno;
+    syscall(__NR_rseq, &thread->rseq, sizeof(bionic_rseq), BIONIC_RSEQ_FLAG_UNREGISTER,
+            BIONIC_RSEQ_SIG);
+    errno = saved_errno;
+    thread->rseq.cpu_id = BIONIC_RSEQ_CPU_ID_UNINITIALIZED;
+  }
+#endif
+}
+
+int __bionic_getcpu() {
+  int cpu = *reinterpret_cast<volatile int32_t*>(&__get_thread()->rseq.cpu_id);
+  if (__predict_true(cpu >= 0)) {
+    return cpu;
+  }
+  return __libc_getcpu();
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <paths.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+
+// popen and system start the shell with posix_spawn rather than vfork: the
+// child never runs our signal handlers, and however big we are it costs the
+// same, with no page tables copied and no atfork handlers run.
+
+struct PopenEntry {
+  PopenEntry* next;
+  FILE* fp;
+  int fd;
+  pid_t pid;
+};
+
+// Every stream popen has returned and pclose hasn't closed yet. POSIX says
+// none of them may be open in later popen children.
+static PopenEntry* g_popen_list = NULL;
+static pthread_mutex_t g_popen_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Parses popen's 'type': "r" or "w", optionally followed by 'e' for
+// close-on-exec and, as NetBSD allows, '+' for a two-way stream.
+static bool parse_popen_type(const char* type, bool* reading, bool* two_way, bool* cloexec) {
+  if (type == NULL || (type[0] != 'r' && type[0] != 'w')) {
+    return false;
+  }
+  *reading = (type[0] == 'r');
+  *two_way = *cloexec = false;
+  for (const char* p = type + 1; *p != '\0'; ++p) {
+    bool* flag;
+    if (*p == 'e') {
+      flag = cloexec;
+    } else if (*p == '+') {
+      flag = two_way;
+    } else {
+      return false;
+    }
+    if (*flag) {
+      return false;
+    }
+    *flag = true;
+  }
+  *reading = *reading || *two_way;
+  return true;
+}
+
+FILE* popen(const char* command, const char* type) {
+  bool reading, two_way, cloexec;
+  if (!parse_popen_type(type, &reading, &two_way, &cloexec)) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  // Both ends are close-on-exec until the child has started, so no child
+  // started concurrently (by us or by anyone else) inherits them.
+  int fds[2];
+  if (two_way) {
+    if (socketpair(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+      return NULL;
+    }
+  } else if (pipe2(fds, O_CLOEXEC) == -1) {
+    return NULL;
+  }
+  int parent_fd = reading ? fds[0] : fds[1];
+  int child_fd = reading ? fds[1] : fds[0];
+
+  PopenEntry* entry = reinterpret_cast<PopenEntry*>(malloc(sizeof(PopenEntry)));
+  FILE* fp = (entry != NULL) ? fdopen(parent_fd, two_way ? "r+" : (reading ? "r" : "w")) : NULL;
+  if (fp == NULL) {
+    ErrnoRestorer errno_restorer;
+    free(entry);
+    close(fds[0]);
+    close(fds[1]);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&g_popen_lock);
+
+  posix_spawn_file_actions_t actions;
+  int error = posix_spawn_file_actions_init(&actions);
+  for (PopenEntry* e = g_popen_list; error == 0 && e != NULL; e = e->next) {
+    error = posix_spawn_file_actions_addclose(&actions, e->fd);
+  }
+  if (error == 0) {
+    error = posix_spawn_file_actions_adddup2(&actions, child_fd, reading ? STDOUT_FILENO : STDIN_FILENO);
+  }
+  if (error == 0 && two_way) {
+    error = posix_spawn_file_actions_adddup2(&actions, child_fd, STDIN_FILENO);
+  }
+  pid_t pid;
+  if (error == 0) {
+    const char* argv[] = { "sh", "-c", command, NULL };
+    error = posix_spawn(&pid, _PATH_BSHELL, &actions, NULL, const_cast<char**>(argv), environ);
+  }
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (error != 0) {
+    pthread_mutex_unlock(&g_popen_lock);
+    fclose(fp);
+    close(child_fd);
+    free(entry);
+    errno = error;
+    return NULL;
+  }
+
+  close(child_fd);
+  if (!cloexec) {
+    fcntl(parent_fd, F_SETFD, 0);
+  }
+  entry->fp = fp;
+  entry->fd = parent_fd;
+  entry->pid = pid;
+  entry->next = g_popen_list;
+  g_popen_list = entry;
+  pthread_mutex_unlock(&g_popen_lock);
+  return fp;
+}
+
+int pclose(FILE* fp) {
+  pthread_mutex_lock(&g_popen_lock);
+  PopenEntry** link = &g_popen_list;
+  while (*link != NULL && (*link)->fp != fp) {
+    link = &(*link)->next;
+  }
+  PopenEntry* entry = *link;
+  if (entry == NULL) {
+    pthread_mutex_unlock(&g_popen_lock);
+    errno = ECHILD;
+    return -1;
+  }
+  *link = entry->next;
+  // Close it under the lock, so a concurrent popen never tries to close
+  // a reused fd number in its child.
+  fclose(fp);
+  pthread_mutex_unlock(&g_popen_lock);
+
+  int status;
+  pid_t pid = TEMP_FAILURE_RETRY(waitpid(entry->pid, &status, 0));
+  free(entry);
+  return (pid == -1) ? -1 : status;
+}
@@ -29,10 +29,15 @@
 #include "pthread_internal.h"
 #include "private/bionic_futex.h"
 #include "private/kernel_sigset_t.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
+#include <android/parallel.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // System calls.
 extern "C" int __rt_sigtimedwait(const sigset_t*, siginfo_t*, const struct timespec*, size_t);
@@ -45,6 +50,11 @@ extern "C" int __timer_settime(__kernel_timer_t, int, const itimerspec*, itimers
 // Most POSIX timers are handled directly by the kernel. We translate SIGEV_THREAD timers
 // into SIGEV_THREAD_ID timers so the kernel handles all the time-related stuff and we just
 // need to worry about running user code on a thread.
+//
+// SIGEV_THREAD timers without thread attributes all signal one dispatcher thread, with the
+// timer in si_value, and it runs their callbacks on the shared pool from <android/parallel.h>.
+// A timer's callbacks never overlap, just as when each timer had a thread of its own. A timer
+// with thread attributes still gets its own thread with those attributes.
 
 // We can't use SIGALRM because too many other C library functions throw that around, and since
 // they don't send to a specific thread, all threads are eligible to handle the signal and we can
@@ -53,16 +63,29 @@ extern "C" int __timer_settime(__kernel_timer_t, int, const itimerspec*, itimers
 // reason to use anything else, we use that too.
 static const int TIMER_SIGNAL = (__SIGRTMIN + 0);
 
+// The si_errno timer_delete uses to tell the dispatcher that no more signals are coming for a
+// timer, so it can drop its reference.
+static const int TIMER_DELETED_MAGIC = 0x7d31e7ed;
+
 struct PosixTimer {
   __kernel_timer_t kernel_timer_id;
 
   int sigev_notify;
 
   // These fields are only needed for a SIGEV_THREAD timer.
-  pthread_t callback_thread;
+  pthread_t callback_thread; // Only for a timer with a thread of its own.
   void (*callback)(sigval_t);
   sigval_t callback_argument;
   volatile bool armed;
+
+  // These fields are only needed for a SIGEV_THREAD timer on the dispatcher.
+  bool dispatched;
+  volatile bool deleted;
+  // Expirations the dispatcher has seen whose callbacks haven't finished yet.
+  atomic_int pending;
+  // One for the dispatcher until timer_delete's message arrives, and one while callbacks
+  // are queued or running.
+  atomic_int references;
 };
 
 static __kernel_timer_t to_kernel_timer_id(timer_t timer) {
@@ -102,6 +125,117 @@ static void __timer_thread_stop(PosixTimer* timer) {
   pthread_kill(timer->callback_thread, TIMER_SIGNAL);
 }
 
+static struct {
+  pid_t pid; // The process the dispatcher below belongs to.
+  pid_t tid;
+  android_task_group_t* group;
+} g_dispatcher;
+
+static pthread_mutex_t g_dispatcher_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void __timer_unref(PosixTimer* timer) {
+  if (atomic_fetch_sub_explicit(&timer->references, 1, memory_order_acq_rel) == 1) {
+    free(timer);
+  }
+}
+
+static void __timer_run_callbacks(void* arg) {
+  PosixTimer* timer = reinterpret_cast<PosixTimer*>(arg);
+  do {
+    if (timer->armed && !timer->deleted) {
+      timer->callback(timer->callback_argument);
+    }
+  } while (atomic_fetch_sub_explicit(&timer->pending, 1, memory_order_acq_rel) > 1);
+  __timer_unref(timer);
+}
+
+static void* __timer_dispatcher_start(void*) {
+  kernel_sigset_t sigset;
+  sigaddset(sigset.get(), TIMER_SIGNAL);
+
+  while (true) {
+    siginfo_t si;
+    memset(&si, 0, sizeof(si));
+    int rc = __rt_sigtimedwait(sigset.get(), &si, NULL, sizeof(sigset));
+    if (rc == -1) {
+      continue;
+    }
+
+    PosixTimer* timer = reinterpret_cast<PosixTimer*>(si.si_value.sival_ptr);
+    if (si.si_code == SI_TIMER) {
+      // Queue the callback unless it's already queued or running, in which case
+      // that task runs it again when it's done.
+      if (timer->armed && !timer->deleted &&
+          atomic_fetch_add_explicit(&timer->pending, 1, memory_order_acq_rel) == 0) {
+        atomic_fetch_add_explicit(&timer->references, 1, memory_order_relaxed);
+        android_task_submit(g_dispatcher.group, __timer_run_callbacks, timer);
+      }
+    } else if (si.si_code == SI_QUEUE && si.si_errno == TIMER_DELETED_MAGIC) {
+      // Realtime signals arrive in order, so this comes after any the timer sent.
+      __timer_unref(timer);
+    }
+  }
+  return NULL;
+}
+
+// Returns the dispatcher's tid, starting it if this is the first dispatched timer in this
+// process, or -1 with errno set on failure. A forked child gets a dispatcher of its own.
+static pid_t __timer_dispatcher_tid() {
+  pid_t pid = getpid();
+  ScopedPthreadMutexLocker locker(&g_dispatcher_lock);
+  if (g_dispatcher.pid == pid) {
+    return g_dispatcher.tid;
+  }
+
+  if (g_dispatcher.group == NULL) {
+    g_dispatcher.group = android_task_group_create();
+    if (g_dispatcher.group == NULL) {
+      return -1;
+    }
+  }
+
+  pthread_attr_t thread_attributes;
+  pthread_attr_init(&thread_attributes);
+  pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
+
+  // The thread inherits TIMER_SIGNAL blocked (see timer_create).
+  kernel_sigset_t sigset;
+  sigaddset(sigset.get(), TIMER_SIGNAL);
+  kernel_sigset_t old_sigset;
+  pthread_sigmask(SIG_BLOCK, sigset.get(), old_sigset.get());
+
+  pthread_t thread;
+  int rc = pthread_create(&thread, &thread_attributes, __timer_dispatcher_start, NULL);
+
+  pthread_sigmask(SIG_SETMASK, old_sigset.get(), NULL);
+
+  if (rc != 0) {
+    errno = rc;
+    return -1;
+  }
+  pthread_setname_np(thread, "POSIX timers");
+
+  g_dispatcher.tid = pthread_gettid_np(thread);
+  g_dispatcher.pid = pid;
+  return g_dispatcher.tid;
+}
+
+// Tells the dispatcher there will be no more signals for 'timer'. If even that can't be
+// queued (the process is at RLIMIT_SIGPENDING), the timer's few bytes are leaked.
+static void __timer_dispatcher_release(PosixTimer* timer) {
+  timer->deleted = true;
+
+  siginfo_t si;
+  memset(&si, 0, sizeof(si));
+  si.si_signo = TIMER_SIGNAL;
+  si.si_errno = TIMER_DELETED_MAGIC;
+  si.si_code = SI_QUEUE;
+  si.si_pid = getpid();
+  si.si_uid = getuid();
+  si.si_value.sival_ptr = timer;
+  syscall(__NR_rt_tgsigqueueinfo, g_dispatcher.pid, g_dispatcher.tid, TIMER_SIGNAL, &si);
+}
+
 // http://pubs.opengroup.org/onlinepubs/9699919799/functions/timer_create.html
 int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
   PosixTimer* timer = reinterpret_cast<PosixTimer*>(malloc(sizeof(PosixTimer)));
@@ -126,6 +260,10 @@ int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
   timer->callback = evp->sigev_notify_function;
   timer->callback_argument = evp->sigev_value;
   timer->armed = false;
+  timer->dispatched = (evp->sigev_notify_attributes == NULL);
+  timer->deleted = false;
+  atomic_init(&timer->pending, 0);
+  atomic_init(&timer->references, 1);
 
   // Check arguments that the kernel doesn't care about but we do.
   if (timer->callback == NULL) {
@@ -134,13 +272,29 @@ int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
     return -1;
   }
 
-  // Create this timer's thread.
-  pthread_attr_t thread_attributes;
-  if (evp->sigev_notify_attributes == NULL) {
-    pthread_attr_init(&thread_attributes);
-  } else {
-    thread_attributes = *reinterpret_cast<pthread_attr_t*>(evp->sigev_notify_attributes);
+  if (timer->dispatched) {
+    pid_t tid = __timer_dispatcher_tid();
+    if (tid == -1) {
+      free(timer);
+      return -1;
+    }
+
+    sigevent se = *evp;
+    se.sigev_signo = TIMER_SIGNAL;
+    se.sigev_notify = SIGEV_THREAD_ID;
+    se.sigev_notify_thread_id = tid;
+    se.sigev_value.sival_ptr = timer;
+    if (__timer_create(clock_id, &se, &timer->kernel_timer_id) == -1) {
+      free(timer);
+      return -1;
+    }
+
+    *timer_id = timer;
+    return 0;
   }
+
+  // Create this timer's thread.
+  pthread_attr_t thread_attributes = *reinterpret_cast<pthread_attr_t*>(evp->sigev_notify_attributes);
   pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
 
   // We start the thread with TIMER_SIGNAL blocked by blocking the signal here and letting it
@@ -187,7 +341,10 @@ int timer_delete(timer_t id) {
   }
 
   PosixTimer* timer = reinterpret_cast<PosixTimer*>(id);
-  if (timer->sigev_notify == SIGEV_THREAD) {
+  if (timer->sigev_notify == SIGEV_THREAD && timer->dispatched) {
+    // The timer data is freed once the dispatcher and any callbacks are done with it.
+    __timer_dispatcher_release(timer);
+  } else if (timer->sigev_notify == SIGEV_THREAD) {
     // Stopping the timer's thread frees the timer data when it's safe.
     __timer_thread_stop(timer);
   } else {
@@ -206,15 +363,15 @@ int timer_gettime(timer_t id, itimerspec* ts) {
 // http://pubs.opengroup.org/onlinepubs/9699919799/functions/timer_getoverrun.html
 int timer_settime(timer_t id, int flags, const itimerspec* ts, itimerspec* ots) {
   PosixTimer* timer= reinterpret_cast<PosixTimer*>(id);
+  // Mark the timer as either being armed or disarmed. This avoids the
+  // callback being called after the disarm for SIGEV_THREAD timers only.
+  // It's done first because a timer set to a time that's already passed
+  // fires before __timer_settime returns.
+  bool was_armed = timer->armed;
+  timer->armed = (ts->it_value.tv_sec != 0 || ts->it_value.tv_nsec != 0);
   int rc = __timer_settime(timer->kernel_timer_id, flags, ts, ots);
-  if (rc == 0) {
-    // Mark the timer as either being armed or disarmed. This avoids the
-    // callback being called after the disarm for SIGEV_THREAD timers only.
-    if (ts->it_value.tv_sec != 0 || ts->it_value.tv_nsec != 0) {
-      timer->armed = true;
-    } else {
-      timer->armed = false;
-    }
+  if (rc == -1) {
+    timer->armed = was_armed;
   }
   return rc;
 }
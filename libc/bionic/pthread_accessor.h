@@ -24,9 +24,10 @@
 
 class pthread_accessor {
  public:
-  explicit pthread_accessor(pthread_t desired_thread) {
+  explicit pthread_accessor(pthread_t desired_thread)
+      : bucket_(__get_thread_bucket(desired_thread)) {
     Lock();
-    for (thread_ = g_thread_list; thread_ != NULL; thread_ = thread_->next) {
+    for (thread_ = bucket_->threads; thread_ != NULL; thread_ = thread_->bucket_next) {
       if (thread_ == reinterpret_cast<pthread_internal_t*>(desired_thread)) {
         break;
       }
@@ -41,7 +42,7 @@ class pthread_accessor {
     if (is_locked_) {
       is_locked_ = false;
       thread_ = NULL;
-      pthread_mutex_unlock(&g_thread_list_lock);
+      pthread_mutex_unlock(&bucket_->lock);
     }
   }
 
@@ -50,11 +51,12 @@ class pthread_accessor {
   pthread_internal_t* get() const { return thread_; }
 
  private:
+  pthread_thread_bucket_t* bucket_;
   pthread_internal_t* thread_;
   bool is_locked_;
 
   void Lock() {
-    pthread_mutex_lock(&g_thread_list_lock);
+    pthread_mutex_lock(&bucket_->lock);
     is_locked_ = true;
   }
 
@@ -28,85 +28,111 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 
-struct atfork_t {
-  atfork_t* next;
-  atfork_t* prev;
+#include "pthread_internal.h"
+
+// The handlers live in an array that's only ever appended to. Registration is serialized
+// by g_atfork_list_mutex, but fork never takes that lock: it notes how many handlers there
+// are when it starts, and runs exactly those, so that handlers and other threads can
+// register more handlers while a fork is in progress without anyone blocking.
 
+struct atfork_t {
   void (*prepare)(void);
   void (*child)(void);
   void (*parent)(void);
 };
 
-struct atfork_list_t {
-  atfork_t* first;
-  atfork_t* last;
+struct atfork_array_t {
+  size_t capacity;
+  atfork_t handlers[0];
 };
 
-static pthread_mutex_t g_atfork_list_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
-static atfork_list_t g_atfork_list = { NULL, NULL };
+static pthread_mutex_t g_atfork_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-void __bionic_atfork_run_prepare() {
-  // We lock the atfork list here, unlock it in the parent, and reset it in the child.
-  // This ensures that nobody can modify the handler array between the calls
-  // to the prepare and parent/child handlers.
-  //
-  // TODO: If a handler tries to mutate the list, they'll block. We should probably copy
-  // the list before forking, and have prepare, parent, and child all work on the consistent copy.
-  pthread_mutex_lock(&g_atfork_list_mutex);
+// When the array fills up, its handlers are copied into one twice the size. The old one is
+// never freed, since a fork in another thread may still be reading it; the arrays' sizes are
+// a geometric series, so together they're never more than twice the size of the last one.
+static atomic_uintptr_t g_atfork_array = ATOMIC_VAR_INIT(0);
+
+// Published after the handler it counts, and after any new array.
+static atomic_size_t g_atfork_count = ATOMIC_VAR_INIT(0);
+
+// Every array ever published holds the first count handlers, so any of them will do.
+static const atfork_t* __atfork_handlers(size_t count) {
+  if (count == 0) {
+    return NULL;
+  }
+  return reinterpret_cast<atfork_array_t*>(
+      atomic_load_explicit(&g_atfork_array, memory_order_acquire))->handlers;
+}
+
+size_t __bionic_atfork_run_prepare() {
+  size_t count = atomic_load_explicit(&g_atfork_count, memory_order_acquire);
+  const atfork_t* handlers = __atfork_handlers(count);
 
   // Call pthread_atfork() prepare handlers. POSIX states that the prepare
   // handlers should be called in the reverse order of the parent/child
   // handlers, so we iterate backwards.
-  for (atfork_t* it = g_atfork_list.last; it != NULL; it = it->prev) {
-    if (it->prepare != NULL) {
-      it->prepare();
+  for (size_t i = count; i > 0; --i) {
+    if (handlers[i - 1].prepare != NULL) {
+      handlers[i - 1].prepare();
     }
   }
+  return count;
 }
 
-void __bionic_atfork_run_child() {
-  for (atfork_t* it = g_atfork_list.first; it != NULL; it = it->next) {
-    if (it->child != NULL) {
-      it->child();
+void __bionic_atfork_run_child(size_t count) {
+  const atfork_t* handlers = __atfork_handlers(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (handlers[i].child != NULL) {
+      handlers[i].child();
     }
   }
 
-  g_atfork_list_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
+  // Another thread may have been registering a handler as we forked. It never got to
+  // publish it, so all we need to do is let the next registration in.
+  g_atfork_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 }
 
-void __bionic_atfork_run_parent() {
-  for (atfork_t* it = g_atfork_list.first; it != NULL; it = it->next) {
-    if (it->parent != NULL) {
-      it->parent();
+void __bionic_atfork_run_parent(size_t count) {
+  const atfork_t* handlers = __atfork_handlers(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (handlers[i].parent != NULL) {
+      handlers[i].parent();
     }
   }
-
-  pthread_mutex_unlock(&g_atfork_list_mutex);
 }
 
 int pthread_atfork(void (*prepare)(void), void (*parent)(void), void(*child)(void)) {
-  atfork_t* entry = reinterpret_cast<atfork_t*>(malloc(sizeof(atfork_t)));
-  if (entry == NULL) {
-    return ENOMEM;
+  pthread_mutex_lock(&g_atfork_list_mutex);
+
+  size_t count = atomic_load_explicit(&g_atfork_count, memory_order_relaxed);
+  atfork_array_t* array =
+      reinterpret_cast<atfork_array_t*>(atomic_load_explicit(&g_atfork_array, memory_order_relaxed));
+  if (array == NULL || count == array->capacity) {
+    size_t capacity = (array == NULL) ? 8 : array->capacity * 2;
+    atfork_array_t* new_array =
+        reinterpret_cast<atfork_array_t*>(malloc(sizeof(atfork_array_t) + capacity * sizeof(atfork_t)));
+    if (new_array == NULL) {
+      pthread_mutex_unlock(&g_atfork_list_mutex);
+      return ENOMEM;
+    }
+    new_array->capacity = capacity;
+    if (count != 0) {
+      memcpy(new_array->handlers, array->handlers, count * sizeof(atfork_t));
+    }
+    atomic_store_explicit(&g_atfork_array, reinterpret_cast<uintptr_t>(new_array), memory_order_release);
+    array = new_array;
   }
 
+  atfork_t* entry = &array->handlers[count];
   entry->prepare = prepare;
   entry->parent = parent;
   entry->child = child;
-
-  pthread_mutex_lock(&g_atfork_list_mutex);
-
-  // Append 'entry' to the list.
-  entry->next = NULL;
-  entry->prev = g_atfork_list.last;
-  if (entry->prev != NULL) {
-    entry->prev->next = entry;
-  }
-  if (g_atfork_list.first == NULL) {
-    g_atfork_list.first = entry;
-  }
-  g_atfork_list.last = entry;
+  atomic_store_explicit(&g_atfork_count, count + 1, memory_order_release);
 
   pthread_mutex_unlock(&g_atfork_list_mutex);
 
@@ -29,10 +29,13 @@
 #include <pthread.h>
 
 #include <inttypes.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <unistd.h>
 
+#include "private/bionic_macros.h"
 #include "private/bionic_string_utils.h"
 #include "private/ErrnoRestorer.h"
 #include "private/libc_logging.h"
@@ -114,19 +117,11 @@ int pthread_attr_setstack(pthread_attr_t* attr, void* stack_base, size_t stack_s
   return 0;
 }
 
-static int __pthread_attr_getstack_main_thread(void** stack_base, size_t* stack_size) {
-  ErrnoRestorer errno_restorer;
-
-  rlimit stack_limit;
-  if (getrlimit(RLIMIT_STACK, &stack_limit) == -1) {
-    return errno;
-  }
-
-  // If the current RLIMIT_STACK is RLIM_INFINITY, only admit to an 8MiB stack for sanity's sake.
-  if (stack_limit.rlim_cur == RLIM_INFINITY) {
-    stack_limit.rlim_cur = 8 * 1024 * 1024;
-  }
+// The top of the main thread's stack mapping never moves (the stack grows down from
+// it), so we only need to find it once. Zero until then.
+static atomic_uintptr_t g_main_thread_stack_top = ATOMIC_VAR_INIT(0);
 
+static int __find_main_thread_stack_top(uintptr_t* stack_top) {
   // It shouldn't matter which thread we are because we're just looking for "[stack]", but
   // valgrind seems to mess with the stack enough that the kernel will report "[stack:pid]"
   // instead if you look in /proc/self/maps, so we need to look in /proc/pid/task/pid/maps.
@@ -141,8 +136,7 @@ static int __pthread_attr_getstack_main_thread(void** stack_base, size_t* stack_
     if (ends_with(line, " [stack]\n")) {
       uintptr_t lo, hi;
       if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR, &lo, &hi) == 2) {
-        *stack_size = stack_limit.rlim_cur;
-        *stack_base = reinterpret_cast<void*>(hi - *stack_size);
+        *stack_top = hi;
         fclose(fp);
         return 0;
       }
@@ -151,6 +145,35 @@ static int __pthread_attr_getstack_main_thread(void** stack_base, size_t* stack_
   __libc_fatal("No [stack] line found in \"%s\"!", path);
 }
 
+static int __pthread_attr_getstack_main_thread(void** stack_base, size_t* stack_size) {
+  ErrnoRestorer errno_restorer;
+
+  // RLIMIT_STACK can change at any time, so we ask for it every time.
+  rlimit stack_limit;
+  if (getrlimit(RLIMIT_STACK, &stack_limit) == -1) {
+    return errno;
+  }
+
+  // If the current RLIMIT_STACK is RLIM_INFINITY, only admit to an 8MiB stack for sanity's sake.
+  if (stack_limit.rlim_cur == RLIM_INFINITY) {
+    stack_limit.rlim_cur = 8 * 1024 * 1024;
+  }
+
+  // Threads racing to find the top all find the same value, so it doesn't matter who wins.
+  uintptr_t stack_top = atomic_load_explicit(&g_main_thread_stack_top, memory_order_relaxed);
+  if (stack_top == 0) {
+    int error = __find_main_thread_stack_top(&stack_top);
+    if (error != 0) {
+      return error;
+    }
+    atomic_store_explicit(&g_main_thread_stack_top, stack_top, memory_order_relaxed);
+  }
+
+  *stack_size = stack_limit.rlim_cur;
+  *stack_base = reinterpret_cast<void*>(stack_top - *stack_size);
+  return 0;
+}
+
 int pthread_attr_getstack(const pthread_attr_t* attr, void** stack_base, size_t* stack_size) {
   if ((attr->flags & PTHREAD_ATTR_FLAG_MAIN_THREAD) != 0) {
     return __pthread_attr_getstack_main_thread(stack_base, stack_size);
@@ -175,6 +198,62 @@ int pthread_getattr_np(pthread_t t, pthread_attr_t* attr) {
   return 0;
 }
 
+int android_pthread_get_stack_usage(pthread_t t, size_t* used, size_t* size) {
+  ErrnoRestorer errno_restorer;
+
+  pthread_attr_t attr;
+  pthread_getattr_np(t, &attr);
+  void* stack_base;
+  size_t stack_size;
+  int error = pthread_attr_getstack(&attr, &stack_base, &stack_size);
+  if (error != 0) {
+    return error;
+  }
+
+  // Stack pages are only committed when first touched, so the lowest resident page shows
+  // how far down the stack has ever grown. Look at the whole stack rather than stopping at
+  // the first page that isn't resident: a frame can skip pages it never writes to.
+  uintptr_t bottom = BIONIC_ALIGN(reinterpret_cast<uintptr_t>(stack_base), PAGE_SIZE);
+  uintptr_t top = reinterpret_cast<uintptr_t>(stack_base) + stack_size;
+  uintptr_t lowest = top;
+  unsigned char residency[256];
+  uintptr_t chunk_top = top & ~(PAGE_SIZE - 1);
+  while (chunk_top > bottom) {
+    size_t pages = (chunk_top - bottom) / PAGE_SIZE;
+    if (pages > sizeof(residency)) {
+      pages = sizeof(residency);
+    }
+    uintptr_t chunk_bottom = chunk_top - pages * PAGE_SIZE;
+    if (mincore(reinterpret_cast<void*>(chunk_bottom), pages * PAGE_SIZE, residency) == -1) {
+      if (errno != ENOMEM) {
+        return errno;
+      }
+      // The main thread's stack is only mapped as far down as it has grown, and its
+      // size comes from RLIMIT_STACK, so its bottom may well not be mapped at all.
+      // Go a page at a time until we fall off the end of the mapping.
+      while (chunk_top > chunk_bottom &&
+             mincore(reinterpret_cast<void*>(chunk_top - PAGE_SIZE), PAGE_SIZE, residency) == 0) {
+        chunk_top -= PAGE_SIZE;
+        if ((residency[0] & 1) != 0) {
+          lowest = chunk_top;
+        }
+      }
+      break;
+    }
+    for (size_t i = 0; i < pages; ++i) {
+      if ((residency[i] & 1) != 0) {
+        lowest = chunk_bottom + i * PAGE_SIZE;
+        break;
+      }
+    }
+    chunk_top = chunk_bottom;
+  }
+
+  *used = top - lowest;
+  *size = stack_size;
+  return 0;
+}
+
 int pthread_attr_setscope(pthread_attr_t*, int scope) {
   if (scope == PTHREAD_SCOPE_SYSTEM) {
     return 0;
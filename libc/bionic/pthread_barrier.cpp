@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+
+#include "private/bionic_futex.h"
+
+/* A barrier counts the threads that have arrived in the current round.
+ * The last to arrive resets the count and bumps the generation, which is
+ * the futex word the others sleep on, so the whole round is released with
+ * a single FUTEX_WAKE.
+ *
+ * Threads released from a round may still be reading the generation after
+ * the last thread has returned, so 'leaving' counts those that haven't
+ * finished with the barrier yet, and pthread_barrier_destroy waits for it
+ * to drop to zero.
+ */
+
+#define BARRIERATTR_SHARED_MASK 0x1
+
+int pthread_barrierattr_init(pthread_barrierattr_t* attr) {
+  *attr = 0;
+  return 0;
+}
+
+int pthread_barrierattr_destroy(pthread_barrierattr_t* attr) {
+  *attr = -1;
+  return 0;
+}
+
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t* attr, int* pshared) {
+  *pshared = (*attr & BARRIERATTR_SHARED_MASK) ? PTHREAD_PROCESS_SHARED : PTHREAD_PROCESS_PRIVATE;
+  return 0;
+}
+
+int pthread_barrierattr_setpshared(pthread_barrierattr_t* attr, int pshared) {
+  switch (pshared) {
+    case PTHREAD_PROCESS_PRIVATE:
+      *attr &= ~BARRIERATTR_SHARED_MASK;
+      return 0;
+    case PTHREAD_PROCESS_SHARED:
+      *attr |= BARRIERATTR_SHARED_MASK;
+      return 0;
+    default:
+      return EINVAL;
+  }
+}
+
+int pthread_barrier_init(pthread_barrier_t* barrier, const pthread_barrierattr_t* attr, unsigned count) {
+  if (count == 0 || count > INT_MAX) {
+    return EINVAL;
+  }
+  barrier->generation = 0;
+  barrier->arrived = 0;
+  barrier->leaving = 0;
+  barrier->count = count;
+  barrier->attr = (attr != NULL) ? (*attr & BARRIERATTR_SHARED_MASK) : 0;
+  return 0;
+}
+
+int pthread_barrier_destroy(pthread_barrier_t* barrier) {
+  if (barrier->arrived != 0) {
+    return EBUSY;
+  }
+  while (barrier->leaving != 0) {
+    sched_yield();
+  }
+  barrier->count = 0;
+  return 0;
+}
+
+int pthread_barrier_wait(pthread_barrier_t* barrier) {
+  bool shared = (barrier->attr & BARRIERATTR_SHARED_MASK) != 0;
+
+  // The generation has to be read before we arrive: once we have, the last
+  // thread may release the round at any time.
+  int32_t generation = barrier->generation;
+  if (__sync_add_and_fetch(&barrier->arrived, 1) == barrier->count) {
+    // The next round's threads can't arrive until they've seen the new
+    // generation, and the full barriers below order the reset before it.
+    barrier->arrived = 0;
+    __sync_fetch_and_add(&barrier->leaving, barrier->count - 1);
+    __sync_fetch_and_add(&barrier->generation, 1);  // C++11 memory_order_release
+    if (barrier->count > 1) {
+      __futex_wake_ex(&barrier->generation, shared, INT_MAX);
+    }
+    return PTHREAD_BARRIER_SERIAL_THREAD;
+  }
+
+  while (barrier->generation == generation) {
+    __futex_wait_ex(&barrier->generation, shared, generation, NULL);
+  }
+  // This is our last access to the barrier.
+  __sync_fetch_and_sub(&barrier->leaving, 1);  // C++11 memory_order_acq_rel
+  return 0;
+}
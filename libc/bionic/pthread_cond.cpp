@@ -30,28 +30,33 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "pthread_internal.h"
 
-#include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_time_conversions.h"
 #include "private/bionic_tls.h"
 
 // We use one bit in pthread_condattr_t (long) values as the 'shared' flag
 // and one bit for the clock type (CLOCK_REALTIME is ((clockid_t) 1), and
-// CLOCK_MONOTONIC is ((clockid_t) 0).). The rest of the bits are a counter.
+// CLOCK_MONOTONIC is ((clockid_t) 0).).
 //
-// The 'value' field pthread_cond_t has the same layout.
+// The 'value' field pthread_cond_t has the same two bits, then a bit that
+// waiters set so that signal and broadcast can skip the futex wake when
+// nobody has waited since the last broadcast. The rest of the bits are a counter.
 
 #define COND_SHARED_MASK 0x0001
 #define COND_CLOCK_MASK 0x0002
-#define COND_COUNTER_STEP 0x0004
+#define COND_WAITERS_FLAG 0x0004
+#define COND_COUNTER_STEP 0x0008
 #define COND_FLAGS_MASK (COND_SHARED_MASK | COND_CLOCK_MASK)
-#define COND_COUNTER_MASK (~COND_FLAGS_MASK)
+#define COND_COUNTER_MASK (~(COND_FLAGS_MASK | COND_WAITERS_FLAG))
 
 #define COND_IS_SHARED(c) (((c) & COND_SHARED_MASK) != 0)
 #define COND_GET_CLOCK(c) (((c) & COND_CLOCK_MASK) >> 1)
@@ -106,12 +111,41 @@ int pthread_condattr_destroy(pthread_condattr_t* attr) {
 // XXX before thread A is scheduled again and calls futex_wait(),
 // XXX then the signal will be lost.
 
+// On LP64, waiters leave their mutex in the reserved space so that
+// broadcast can requeue them onto it. Only a program that waits with two
+// different mutexes at once, which POSIX leaves undefined, could see a
+// mix of two pointers here. Waiters also count themselves in and out
+// (while holding the mutex), and the last one out forgets the mutex, so
+// that a broadcast never touches a mutex that may since have been destroyed.
+#if defined(__LP64__)
+static inline pthread_mutex_t* __pthread_cond_get_mutex(const pthread_cond_t* cond) {
+  pthread_mutex_t* mutex;
+  memcpy(&mutex, cond->__reserved, sizeof(mutex));
+  return mutex;
+}
+
+static inline void __pthread_cond_set_mutex(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+  memcpy(cond->__reserved, &mutex, sizeof(mutex));
+}
+
+static inline volatile atomic_int* __pthread_cond_waiter_count(pthread_cond_t* cond) {
+  static_assert((offsetof(pthread_cond_t, __reserved) + sizeof(pthread_mutex_t*)) %
+                    __alignof__(atomic_int) == 0,
+                "waiter count should be aligned");
+  return reinterpret_cast<volatile atomic_int*>(cond->__reserved + sizeof(pthread_mutex_t*));
+}
+#endif
+
 int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr) {
   if (attr != NULL) {
     cond->value = (*attr & COND_FLAGS_MASK);
   } else {
     cond->value = 0;
   }
+#if defined(__LP64__)
+  __pthread_cond_set_mutex(cond, NULL);
+  atomic_init(__pthread_cond_waiter_count(cond), 0);
+#endif
 
   return 0;
 }
@@ -121,41 +155,106 @@ int pthread_cond_destroy(pthread_cond_t* cond) {
   return 0;
 }
 
+// cond->value is an atomic_int in all but name (<pthread.h> can't use <stdatomic.h>).
+static inline volatile atomic_int* __pthread_cond_atomic(pthread_cond_t* cond) {
+  static_assert(sizeof(atomic_int) == sizeof(cond->value), "atomic_int should be an int");
+  return reinterpret_cast<volatile atomic_int*>(&cond->value);
+}
+
 // This function is used by pthread_cond_broadcast and
 // pthread_cond_signal to atomically decrement the counter
 // then wake up 'counter' threads.
 static int __pthread_cond_pulse(pthread_cond_t* cond, int counter) {
   int flags = (cond->value & COND_FLAGS_MASK);
+  int new_value;
   while (true) {
     int old_value = cond->value;
-    int new_value = ((old_value - COND_COUNTER_STEP) & COND_COUNTER_MASK) | flags;
-    if (__bionic_cmpxchg(old_value, new_value, &cond->value) == 0) {
+    if ((old_value & COND_WAITERS_FLAG) == 0) {
+      // Nobody has waited since the last broadcast.
+      return 0;
+    }
+    // A broadcast wakes everyone, so the next waiter has to set the flag again.
+    // A signal leaves it set: a waiter may have set it and not be asleep yet.
+    new_value = ((old_value - COND_COUNTER_STEP) & COND_COUNTER_MASK) | flags;
+    if (counter == 1) {
+      new_value |= COND_WAITERS_FLAG;
+    }
+    // Release ordering makes all memory accesses previously made by this
+    // thread visible to the woken thread(s).  On the other side, locking
+    // the mutex provides the acquire.
+    //
+    // This may not strictly be necessary -- if the caller follows
+    // recommended practice and holds the mutex before signaling the cond
+    // var, the mutex ops will provide correct semantics.  If they don't
+    // hold the mutex, they're subject to race conditions anyway.
+    if (atomic_compare_exchange_strong_explicit(__pthread_cond_atomic(cond), &old_value, new_value,
+                                                memory_order_release, memory_order_relaxed)) {
       break;
     }
   }
 
-  // Ensure that all memory accesses previously made by this thread are
-  // visible to the woken thread(s).  On the other side, the "wait"
-  // code will issue any necessary barriers when locking the mutex.
-  //
-  // This may not strictly be necessary -- if the caller follows
-  // recommended practice and holds the mutex before signaling the cond
-  // var, the mutex ops will provide correct semantics.  If they don't
-  // hold the mutex, they're subject to race conditions anyway.
-  ANDROID_MEMBAR_FULL();
-
-  __futex_wake_ex(&cond->value, COND_IS_SHARED(cond->value), counter);
+  bool shared = COND_IS_SHARED(flags);
+  if (counter == 1) {
+    __futex_wake_ex(&cond->value, shared, 1);
+    return 0;
+  }
+
+#if defined(__LP64__)
+  // Rather than wake every waiter only for all but one to go back to sleep
+  // on the mutex, wake one and move the rest straight onto the mutex's
+  // futex, where each unlock passes the mutex on to the next.
+  // A process-shared condition variable's waiters may have the mutex mapped
+  // at a different address to ours, so they're just woken.
+  pthread_mutex_t* mutex = NULL;
+  if (!shared && atomic_load_explicit(__pthread_cond_waiter_count(cond), memory_order_acquire) > 0) {
+    mutex = __pthread_cond_get_mutex(cond);
+  }
+  if (mutex != NULL && __pthread_mutex_can_requeue_to(mutex, shared) &&
+      __futex_cmp_requeue_ex(&cond->value, shared, 1, INT_MAX, &mutex->value, new_value) >= 0) {
+    return 0;
+  }
+#endif
+  __futex_wake_ex(&cond->value, shared, counter);
   return 0;
 }
 
 __LIBC_HIDDEN__
 int __pthread_cond_timedwait_relative(pthread_cond_t* cond, pthread_mutex_t* mutex, const timespec* reltime) {
+  // Set the waiters flag before unlocking the mutex, so that any signal
+  // made after we've released the mutex knows to wake us.
+  // (Unlocking the mutex orders this before anything the signaller sees.)
   int old_value = cond->value;
+  while ((old_value & COND_WAITERS_FLAG) == 0) {
+    if (atomic_compare_exchange_weak_explicit(__pthread_cond_atomic(cond), &old_value,
+                                              old_value | COND_WAITERS_FLAG,
+                                              memory_order_relaxed, memory_order_relaxed)) {
+      old_value |= COND_WAITERS_FLAG;
+      break;
+    }
+  }
+#if defined(__LP64__)
+  __pthread_cond_set_mutex(cond, mutex);
+  atomic_fetch_add_explicit(__pthread_cond_waiter_count(cond), 1, memory_order_release);
+#endif
 
   pthread_mutex_unlock(mutex);
-  int status = __futex_wait_ex(&cond->value, COND_IS_SHARED(cond->value), old_value, reltime);
-  pthread_mutex_lock(mutex);
+  int status = __futex_wait_ex(&cond->value, COND_IS_SHARED(old_value), old_value, reltime);
+  int lock_error = pthread_mutex_lock(mutex);
+#if defined(__LP64__)
+  // We may have been requeued onto the mutex behind other waiters, who'll
+  // only be woken if our unlock sees the mutex as contended.
+  if (status != -EWOULDBLOCK && __pthread_mutex_can_requeue_to(mutex, COND_IS_SHARED(old_value))) {
+    __pthread_mutex_mark_contended(mutex);
+  }
+  if (atomic_fetch_sub_explicit(__pthread_cond_waiter_count(cond), 1, memory_order_relaxed) == 1) {
+    __pthread_cond_set_mutex(cond, NULL);
+  }
+#endif
 
+  // A robust mutex's previous owner may have died while we waited.
+  if (lock_error == EOWNERDEAD || lock_error == ENOTRECOVERABLE) {
+    return lock_error;
+  }
   if (status == -ETIMEDOUT) {
     return ETIMEDOUT;
   }
@@ -29,6 +29,7 @@
 #include <pthread.h>
 
 #include <errno.h>
+#include <malloc.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -37,6 +38,8 @@
 #include "private/bionic_macros.h"
 #include "private/bionic_ssp.h"
 #include "private/bionic_tls.h"
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_percpu.h"
 #include "private/libc_logging.h"
 #include "private/ErrnoRestorer.h"
 #include "private/ScopedPthreadMutexLocker.h"
@@ -61,12 +64,21 @@ void __init_tls(pthread_internal_t* thread) {
   thread->tls[TLS_SLOT_THREAD_ID] = thread;
   // GCC looks in the TLS for the stack guard on x86, so copy it there from our global.
   thread->tls[TLS_SLOT_STACK_GUARD] = (void*) __stack_chk_guard;
+
+  // Until the thread registers it, the rseq area mustn't claim to know the CPU.
+  thread->rseq.cpu_id = BIONIC_RSEQ_CPU_ID_UNINITIALIZED;
+  // Nor has it registered a robust list yet.
+  thread->robust_list_tid = 0;
 }
 
 void __init_alternate_signal_stack(pthread_internal_t* thread) {
-  // Create and set an alternate signal stack.
+  // Threads whose stacks we allocated have their signal stack in the same mapping
+  // (see __allocate_thread). Others need one of their own.
   stack_t ss;
-  ss.ss_sp = mmap(NULL, SIGSTKSZ, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  ss.ss_sp = thread->alternate_signal_stack;
+  if (ss.ss_sp == NULL) {
+    ss.ss_sp = mmap(NULL, SIGSTKSZ, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  }
   if (ss.ss_sp != MAP_FAILED) {
     ss.ss_size = SIGSTKSZ;
     ss.ss_flags = 0;
@@ -101,34 +113,12 @@ int __init_thread(pthread_internal_t* thread, bool add_to_thread_list) {
   return error;
 }
 
-static void* __create_thread_stack(pthread_internal_t* thread) {
-  // Create a new private anonymous map.
-  int prot = PROT_READ | PROT_WRITE;
-  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
-  void* stack = mmap(NULL, thread->attr.stack_size, prot, flags, -1, 0);
-  if (stack == MAP_FAILED) {
-    __libc_format_log(ANDROID_LOG_WARN,
-                      "libc",
-                      "pthread_create failed: couldn't allocate %zd-byte stack: %s",
-                      thread->attr.stack_size, strerror(errno));
-    return NULL;
-  }
-
-  // Set the guard region at the end of the stack to PROT_NONE.
-  if (mprotect(stack, thread->attr.guard_size, PROT_NONE) == -1) {
-    __libc_format_log(ANDROID_LOG_WARN, "libc",
-                      "pthread_create failed: couldn't mprotect PROT_NONE %zd-byte stack guard region: %s",
-                      thread->attr.guard_size, strerror(errno));
-    munmap(stack, thread->attr.stack_size);
-    return NULL;
-  }
-
-  return stack;
-}
-
 static int __pthread_start(void* arg) {
   pthread_internal_t* thread = reinterpret_cast<pthread_internal_t*>(arg);
 
+  // CLONE_PARENT_SETTID wrote our tid before we started running.
+  thread->set_tls_tid();
+
   // Wait for our creating thread to release us. This lets it have time to
   // notify gdb about this thread before we start doing anything.
   // This also provides the memory barrier needed to ensure that all memory
@@ -137,6 +127,7 @@ static int __pthread_start(void* arg) {
   pthread_mutex_destroy(&thread->startup_handshake_mutex);
 
   __init_alternate_signal_stack(thread);
+  __rseq_register_current_thread();
 
   void* result = thread->start_routine(thread->start_routine_arg);
   pthread_exit(result);
@@ -158,43 +149,49 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
   // Inform the rest of the C library that at least one thread was created.
   __isthreaded = 1;
 
-  pthread_internal_t* thread = reinterpret_cast<pthread_internal_t*>(calloc(sizeof(*thread), 1));
-  if (thread == NULL) {
-    __libc_format_log(ANDROID_LOG_WARN, "libc", "pthread_create failed: couldn't allocate thread");
-    return EAGAIN;
-  }
-
+  pthread_attr_t thread_attr;
   if (attr == NULL) {
-    pthread_attr_init(&thread->attr);
+    pthread_attr_init(&thread_attr);
   } else {
-    thread->attr = *attr;
+    thread_attr = *attr;
     attr = NULL; // Prevent misuse below.
   }
 
   // Make sure the stack size and guard size are multiples of PAGE_SIZE.
-  thread->attr.stack_size = BIONIC_ALIGN(thread->attr.stack_size, PAGE_SIZE);
-  thread->attr.guard_size = BIONIC_ALIGN(thread->attr.guard_size, PAGE_SIZE);
-
-  if (thread->attr.stack_base == NULL) {
-    // The caller didn't provide a stack, so allocate one.
-    thread->attr.stack_base = __create_thread_stack(thread);
-    if (thread->attr.stack_base == NULL) {
-      free(thread);
+  thread_attr.stack_size = BIONIC_ALIGN(thread_attr.stack_size, PAGE_SIZE);
+  thread_attr.guard_size = BIONIC_ALIGN(thread_attr.guard_size, PAGE_SIZE);
+
+  pthread_internal_t* thread;
+  if (thread_attr.stack_base == NULL) {
+    // The caller didn't provide a stack, so allocate one, with the thread alongside it.
+    thread = __allocate_thread(thread_attr.stack_size, thread_attr.guard_size);
+    if (thread == NULL) {
       return EAGAIN;
     }
+    thread_attr.stack_base = reinterpret_cast<uint8_t*>(thread->mmap_base) + SIGSTKSZ;
   } else {
+    // The rseq area has to be suitably aligned, which calloc doesn't promise.
+    thread = reinterpret_cast<pthread_internal_t*>(memalign(__alignof__(pthread_internal_t),
+                                                            sizeof(pthread_internal_t)));
+    if (thread == NULL) {
+      __libc_format_log(ANDROID_LOG_WARN, "libc", "pthread_create failed: couldn't allocate thread");
+      return EAGAIN;
+    }
+    memset(thread, 0, sizeof(pthread_internal_t));
     // The caller did provide a stack, so remember we're not supposed to free it.
-    thread->attr.flags |= PTHREAD_ATTR_FLAG_USER_ALLOCATED_STACK;
+    thread_attr.flags |= PTHREAD_ATTR_FLAG_USER_ALLOCATED_STACK;
   }
+  thread->attr = thread_attr;
 
-  // Make room for the TLS area.
-  // The child stack is the same address, just growing in the opposite direction.
+  // Make room for the TLS area at the top of the stack.
   // At offsets >= 0, we have the TLS slots.
-  // At offsets < 0, we have the child stack.
-  thread->tls = reinterpret_cast<void**>(reinterpret_cast<uint8_t*>(thread->attr.stack_base) +
-                                         thread->attr.stack_size - BIONIC_TLS_SLOTS * sizeof(void*));
-  void* child_stack = thread->tls;
+  // Just below them is the static ELF TLS area, if there is one.
+  // Below that, we have the child stack, growing in the opposite direction.
+  uint8_t* child_stack;
+  thread->tls = __bionic_layout_thread_tls(reinterpret_cast<uint8_t*>(thread->attr.stack_base) +
+                                           thread->attr.stack_size, &child_stack);
   __init_tls(thread);
+  __bionic_init_static_tls(thread->tls);
 
   // Create a mutex for the thread in TLS to wait on once it starts so we can keep
   // it from doing anything until after we notify the debugger about it
@@ -227,10 +224,7 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
     // be unblocked, but we're about to unmap the memory the mutex is stored in, so this serves as a
     // reminder that you can't rewrite this function to use a ScopedPthreadMutexLocker.
     pthread_mutex_unlock(&thread->startup_handshake_mutex);
-    if (!thread->user_allocated_stack()) {
-      munmap(thread->attr.stack_base, thread->attr.stack_size);
-    }
-    free(thread);
+    __free_thread(thread);
     __libc_format_log(ANDROID_LOG_WARN, "libc", "pthread_create failed: clone failed: %s", strerror(errno));
     return clone_errno;
   }
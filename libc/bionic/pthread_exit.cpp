@@ -33,6 +33,12 @@
 #include <sys/mman.h>
 
 #include "pthread_internal.h"
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_percpu.h"
+
+#if defined(USE_DLMALLOC)
+#include "malloc_thread_cache.h"
+#endif
 
 extern "C" __noreturn void _exit_with_stack_teardown(void*, size_t);
 extern "C" __noreturn void __exit(int);
@@ -82,35 +88,52 @@ void pthread_exit(void* return_value) {
     ss.ss_flags = SS_DISABLE;
     sigaltstack(&ss, NULL);
 
-    // Free it.
-    munmap(thread->alternate_signal_stack, SIGSTKSZ);
-    thread->alternate_signal_stack = NULL;
+    // Free it, unless it's part of the mapping holding the rest of the thread.
+    if (thread->mmap_base == NULL) {
+      munmap(thread->alternate_signal_stack, SIGSTKSZ);
+      thread->alternate_signal_stack = NULL;
+    }
   }
 
-  // Keep track of what we need to know about the stack before we lose the pthread_internal_t.
-  void* stack_base = thread->attr.stack_base;
-  size_t stack_size = thread->attr.stack_size;
-  bool user_allocated_stack = thread->user_allocated_stack();
+  // Our robust list lives in the pthread_internal_t too, so rather than leave the
+  // kernel to walk it after we exit, let go of any robust mutexes we still hold now.
+  __pthread_mutex_abandon_robust_list(thread);
 
-  pthread_mutex_lock(&g_thread_list_lock);
+  // The kernel mustn't write to the rseq area once this thread's
+  // pthread_internal_t has been freed or reused, which may happen before we exit.
+  __rseq_unregister_current_thread();
+
+  // Keep track of what we need to know about the stack before we lose the pthread_internal_t.
+  void* mmap_base = thread->mmap_base;
+  size_t mmap_size = thread->mmap_size;
+  uintptr_t stack_bottom = reinterpret_cast<uintptr_t>(thread->attr.stack_base) + thread->attr.guard_size;
+  bool joinable = false;
+  bool unmap_stack = false;
+
+  pthread_thread_bucket_t* bucket = __get_thread_bucket(reinterpret_cast<pthread_t>(thread));
+  pthread_mutex_lock(&bucket->lock);
   if ((thread->attr.flags & PTHREAD_ATTR_FLAG_DETACHED) != 0) {
-    // The thread is detached, so we can free the pthread_internal_t.
-    // First make sure that the kernel does not try to clear the tid field
-    // because we'll have freed the memory before the thread actually exits.
-    __set_tid_address(NULL);
-    _pthread_internal_remove_locked(thread);
-  } else {
-    // Make sure that the pthread_internal_t doesn't have stale pointers to a stack that
-    // will be unmapped after the exit call below.
-    if (!user_allocated_stack) {
-      thread->attr.stack_base = NULL;
-      thread->attr.stack_size = 0;
-      thread->tls = NULL;
+    _pthread_internal_remove_locked(thread, false);
+    if (mmap_base == NULL) {
+      // The thread is detached, so we can free the pthread_internal_t.
+      // First make sure that the kernel does not try to clear the tid field
+      // because we'll have freed the memory before the thread actually exits.
+      __set_tid_address(NULL);
+      free(thread);
+    } else if (!__cache_thread(thread)) {
+      // The pthread_internal_t goes away with the stack, so the same applies.
+      __set_tid_address(NULL);
+      unmap_stack = true;
     }
-    // pthread_join is responsible for destroying the pthread_internal_t for non-detached threads.
+    // Otherwise the kernel's clearing of the tid field when we exit is what
+    // tells pthread_create that our stack is free for reuse.
+  } else {
+    // pthread_join is responsible for destroying the pthread_internal_t for non-detached threads,
+    // and the stack along with it if we allocated it.
     // The kernel will futex_wake on the pthread_internal_t::tid field to wake pthread_join.
+    joinable = true;
   }
-  pthread_mutex_unlock(&g_thread_list_lock);
+  pthread_mutex_unlock(&bucket->lock);
 
   // Perform a second key cleanup. When using jemalloc, a call to free from
   // _pthread_internal_remove_locked causes the memory associated with a key
@@ -118,9 +141,29 @@ void pthread_exit(void* return_value) {
   // TODO: When b/16847284 is fixed this call can be removed.
   pthread_key_clean_all();
 
-  if (user_allocated_stack) {
+  // The TLS destructors may have used __thread variables, so this comes last.
+  __bionic_free_dynamic_tls();
+
+#if defined(USE_DLMALLOC)
+  // Nothing below frees memory, so give this thread's cached blocks back to
+  // the heap now rather than leaking them with the thread.
+  thread_cache_drain();
+#endif
+
+  if (mmap_base == NULL) {
     // Cleaning up this thread's stack is the creator's responsibility, not ours.
     __exit(0);
+  } else if (!unmap_stack) {
+    if (joinable) {
+      // Our stack lives on until we're joined, which may be never. Give back
+      // the pages we've finished with, leaving plenty for what's left to run here.
+      uintptr_t sp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+      uintptr_t unused_top = (sp & ~(PAGE_SIZE - 1)) - PTHREAD_STACK_MIN;
+      if (unused_top > stack_bottom && unused_top < sp) {
+        madvise(reinterpret_cast<void*>(stack_bottom), unused_top - stack_bottom, MADV_DONTNEED);
+      }
+    }
+    __exit(0);
   } else {
     // We need to munmap the stack we're running on before calling exit.
     // That's not something we can do in C.
@@ -131,6 +174,6 @@ void pthread_exit(void* return_value) {
     sigfillset(&mask);
     sigprocmask(SIG_SETMASK, &mask, NULL);
 
-    _exit_with_stack_teardown(stack_base, stack_size);
+    _exit_with_stack_teardown(mmap_base, mmap_size);
   }
 }
@@ -28,8 +28,12 @@
 #ifndef _PTHREAD_INTERNAL_H_
 #define _PTHREAD_INTERNAL_H_
 
+#include <linux/futex.h>
 #include <pthread.h>
 
+#include "private/bionic_rseq.h"
+#include "private/bionic_tls.h"
+
 /* Has the thread been detached by a pthread_join or pthread_detach call? */
 #define PTHREAD_ATTR_FLAG_DETACHED 0x00000001
 
@@ -42,16 +46,28 @@
 /* Is this the main thread? */
 #define PTHREAD_ATTR_FLAG_MAIN_THREAD 0x80000000
 
+// TLS_SLOT_TID and TLS_SLOT_CACHED_PID hold a pid_t rather than a pointer.
+static inline pid_t* __tls_pid_slot(void** tls, int slot) {
+  return reinterpret_cast<pid_t*>(&tls[slot]);
+}
+
 struct pthread_internal_t {
   struct pthread_internal_t* next;
   struct pthread_internal_t* prev;
 
+  // The next thread in the same pthread_thread_bucket_t.
+  struct pthread_internal_t* bucket_next;
+
   pid_t tid;
 
- private:
-  pid_t cached_pid_;
+  // Copies tid to the thread's TLS, where gettid(2) reads it. Only the thread itself
+  // calls this, once the kernel has written tid.
+  void set_tls_tid() {
+    *__tls_pid_slot(tls, TLS_SLOT_TID) = tid;
+  }
 
- public:
+  // The cached pid lives in the thread's TLS too, next to errno, so that getpid(2)
+  // doesn't have to touch this structure at all.
   pid_t invalidate_cached_pid() {
     pid_t old_value;
     get_cached_pid(&old_value);
@@ -60,11 +76,11 @@ struct pthread_internal_t {
   }
 
   void set_cached_pid(pid_t value) {
-    cached_pid_ = value;
+    *__tls_pid_slot(tls, TLS_SLOT_CACHED_PID) = value;
   }
 
   bool get_cached_pid(pid_t* cached_pid) {
-    *cached_pid = cached_pid_;
+    *cached_pid = *__tls_pid_slot(tls, TLS_SLOT_CACHED_PID);
     return (*cached_pid != 0);
   }
 
@@ -84,8 +100,22 @@ struct pthread_internal_t {
 
   void* alternate_signal_stack;
 
+  // The mapping holding this thread's signal stack, guard, stack and this
+  // structure, or NULL if the structure was allocated on its own (the main
+  // thread, and threads running on stacks their creators provided).
+  void* mmap_base;
+  size_t mmap_size;
+
   pthread_mutex_t startup_handshake_mutex;
 
+  // Kept up to date by the kernel once the thread has registered it (see bionic/percpu.cpp).
+  bionic_rseq rseq;
+
+  // The robust mutexes this thread holds, registered with the kernel when it
+  // first takes one; robust_list_tid is the tid it was registered for.
+  robust_list_head robust_list;
+  pid_t robust_list_tid;
+
   /*
    * The dynamic linker implements dlerror(3), which makes it hard for us to implement this
    * per-thread buffer by simply using malloc(3) and free(3).
@@ -103,7 +133,21 @@ __LIBC_HIDDEN__ void _pthread_internal_add(pthread_internal_t* thread);
 extern "C" __LIBC64_HIDDEN__ pthread_internal_t* __get_thread(void);
 
 __LIBC_HIDDEN__ void pthread_key_clean_all(void);
-__LIBC_HIDDEN__ void _pthread_internal_remove_locked(pthread_internal_t* thread);
+/* The caller holds the thread's bucket lock. */
+__LIBC_HIDDEN__ void _pthread_internal_remove_locked(pthread_internal_t* thread, bool free_thread);
+
+/*
+ * Threads whose stacks we allocate are allocated in the same mapping as their
+ * stacks, and exited threads' mappings are kept for reuse by later threads
+ * with the same stack and guard sizes.
+ */
+__LIBC_HIDDEN__ pthread_internal_t* __allocate_thread(size_t stack_size, size_t guard_size);
+/* Keeps the mapping of a thread that's exiting, until the kernel clears its tid. */
+__LIBC_HIDDEN__ bool __cache_thread(pthread_internal_t* thread);
+/* Frees a thread that's no longer running, or that never ran. */
+__LIBC_HIDDEN__ void __free_thread(pthread_internal_t* thread);
+/* Unmaps every cached thread that can be reused. Called by malloc_trim. */
+__LIBC_HIDDEN__ void __trim_thread_cache();
 
 /*
  * Traditionally we gave threads a 1MiB stack. When we started
@@ -114,14 +158,46 @@ __LIBC_HIDDEN__ void _pthread_internal_remove_locked(pthread_internal_t* thread)
  */
 #define PTHREAD_STACK_SIZE_DEFAULT ((1 * 1024 * 1024) - SIGSTKSZ)
 
+/*
+ * Every live thread is in g_thread_list, for the rare callers that need to visit them all,
+ * and in one of the buckets of a hash table keyed by its pthread_internal_t's address. Looking
+ * a pthread_t up (see pthread_accessor.h) only takes its bucket's lock, so threads using
+ * different pthread_ts rarely contend, however many threads there are.
+ *
+ * Adding or removing a thread takes its bucket's lock and then g_thread_list_lock.
+ */
 __LIBC_HIDDEN__ extern pthread_internal_t* g_thread_list;
 __LIBC_HIDDEN__ extern pthread_mutex_t g_thread_list_lock;
 
+#define PTHREAD_THREAD_BUCKET_COUNT 256
+
+struct pthread_thread_bucket_t {
+  pthread_mutex_t lock;
+  pthread_internal_t* threads;
+};
+
+__LIBC_HIDDEN__ pthread_thread_bucket_t* __get_thread_bucket(pthread_t t);
+
 __LIBC_HIDDEN__ int __timespec_from_absolute(timespec*, const timespec*, clockid_t);
 
-/* Needed by fork. */
-__LIBC_HIDDEN__ extern void __bionic_atfork_run_prepare();
-__LIBC_HIDDEN__ extern void __bionic_atfork_run_child();
-__LIBC_HIDDEN__ extern void __bionic_atfork_run_parent();
+/*
+ * Used by pthread_cond_broadcast to move waiters straight onto the mutex's futex. Waiters can
+ * only be requeued onto a non-PI mutex with the same process-shared setting as the condition
+ * variable, and once back, a waiter has to mark the mutex contended so that its unlock wakes
+ * the next one.
+ */
+__LIBC_HIDDEN__ bool __pthread_mutex_can_requeue_to(const pthread_mutex_t* mutex, bool shared);
+__LIBC_HIDDEN__ void __pthread_mutex_mark_contended(pthread_mutex_t* mutex);
+
+/* Called by pthread_exit to release the robust mutexes the thread still holds as if it had died. */
+__LIBC_HIDDEN__ void __pthread_mutex_abandon_robust_list(pthread_internal_t* thread);
+
+/*
+ * Needed by fork. The prepare handlers' count of handlers is passed on to the child or
+ * parent handlers, so that the same ones run even if more are registered in between.
+ */
+__LIBC_HIDDEN__ extern size_t __bionic_atfork_run_prepare();
+__LIBC_HIDDEN__ extern void __bionic_atfork_run_child(size_t handler_count);
+__LIBC_HIDDEN__ extern void __bionic_atfork_run_parent(size_t handler_count);
 
 #endif /* _PTHREAD_INTERNAL_H_ */
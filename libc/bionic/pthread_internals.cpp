@@ -28,14 +28,179 @@
 
 #include "pthread_internal.h"
 
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "private/bionic_elf_tls.h"
 #include "private/bionic_futex.h"
+#include "private/bionic_macros.h"
 #include "private/bionic_tls.h"
+#include "private/libc_logging.h"
 #include "private/ScopedPthreadMutexLocker.h"
 
 pthread_internal_t* g_thread_list = NULL;
 pthread_mutex_t g_thread_list_lock = PTHREAD_MUTEX_INITIALIZER;
 
-void _pthread_internal_remove_locked(pthread_internal_t* thread) {
+// Zero-initialized, which is PTHREAD_MUTEX_INITIALIZER for the locks.
+static pthread_thread_bucket_t g_thread_buckets[PTHREAD_THREAD_BUCKET_COUNT];
+
+pthread_thread_bucket_t* __get_thread_bucket(pthread_t t) {
+  // pthread_internal_ts are at least 16-byte aligned, and the ones we
+  // allocate alongside their stacks are page aligned, so mix in the high bits.
+  uint32_t hash = static_cast<uint32_t>(t >> 4) ^ static_cast<uint32_t>(t >> 12);
+  hash *= 2654435761U;
+  return &g_thread_buckets[hash >> 24];
+}
+
+// Exited threads, linked through their next fields, with their mappings
+// still in place. Reusing one saves pthread_create the mmap and mprotect
+// calls for a new stack and the page faults on it, and saves the munmap
+// call on exit.
+static const size_t kThreadCacheMax = 16;
+static pthread_internal_t* g_thread_cache = NULL;
+static size_t g_thread_cache_count = 0;
+static pthread_mutex_t g_thread_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void __unmap_thread(pthread_internal_t* thread) {
+  // The alternate signal stack is part of the same mapping.
+  munmap(thread->mmap_base, thread->mmap_size);
+}
+
+// The kernel clears the tid of a thread that was cached as it exited once
+// the thread is gone, so it's only then that the stack can be reused.
+static bool __thread_has_exited(pthread_internal_t* thread) {
+  return *reinterpret_cast<volatile pid_t*>(&thread->tid) == 0;
+}
+
+static pthread_internal_t* __reuse_cached_thread(size_t stack_size, size_t guard_size) {
+  ScopedPthreadMutexLocker locker(&g_thread_cache_lock);
+  for (pthread_internal_t** it = &g_thread_cache; *it != NULL; it = &(*it)->next) {
+    pthread_internal_t* thread = *it;
+    if (thread->attr.stack_size == stack_size && thread->attr.guard_size == guard_size &&
+        __thread_has_exited(thread)) {
+      *it = thread->next;
+      --g_thread_cache_count;
+
+      void* mmap_base = thread->mmap_base;
+      size_t mmap_size = thread->mmap_size;
+      void* alternate_signal_stack = thread->alternate_signal_stack;
+      memset(thread, 0, sizeof(*thread));
+      thread->mmap_base = mmap_base;
+      thread->mmap_size = mmap_size;
+      thread->alternate_signal_stack = alternate_signal_stack;
+
+      // A new mapping's TLS slots would be zero.
+      uint8_t* bottom;
+      void** tls = __bionic_layout_thread_tls(reinterpret_cast<uint8_t*>(mmap_base) + SIGSTKSZ +
+                                              stack_size, &bottom);
+      memset(tls, 0, BIONIC_TLS_SLOTS * sizeof(void*));
+      return thread;
+    }
+  }
+  return NULL;
+}
+
+pthread_internal_t* __allocate_thread(size_t stack_size, size_t guard_size) {
+  pthread_internal_t* thread = __reuse_cached_thread(stack_size, guard_size);
+  if (thread != NULL) {
+    return thread;
+  }
+
+  // One mapping holds, from the bottom up, the alternate signal stack, the
+  // guard, the stack, and the pthread_internal_t in its own page(s). Putting
+  // the signal stack below the guard means a stack overflow runs into the guard
+  // rather than into the signal stack we need to report it, and saves each
+  // thread an mmap, a munmap and a VMA of its own.
+  size_t mmap_size = SIGSTKSZ + stack_size + BIONIC_ALIGN(sizeof(pthread_internal_t), PAGE_SIZE);
+  int prot = PROT_READ | PROT_WRITE;
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+  void* mmap_base = mmap(NULL, mmap_size, prot, flags, -1, 0);
+  if (mmap_base == MAP_FAILED) {
+    __libc_format_log(ANDROID_LOG_WARN,
+                      "libc",
+                      "pthread_create failed: couldn't allocate %zd-byte stack: %s",
+                      stack_size, strerror(errno));
+    return NULL;
+  }
+
+  // Set the guard region at the end of the stack to PROT_NONE.
+  uint8_t* stack_base = reinterpret_cast<uint8_t*>(mmap_base) + SIGSTKSZ;
+  if (mprotect(stack_base, guard_size, PROT_NONE) == -1) {
+    __libc_format_log(ANDROID_LOG_WARN, "libc",
+                      "pthread_create failed: couldn't mprotect PROT_NONE %zd-byte stack guard region: %s",
+                      guard_size, strerror(errno));
+    munmap(mmap_base, mmap_size);
+    return NULL;
+  }
+
+  thread = reinterpret_cast<pthread_internal_t*>(stack_base + stack_size);
+  thread->mmap_base = mmap_base;
+  thread->mmap_size = mmap_size;
+  thread->alternate_signal_stack = mmap_base;
+  return thread;
+}
+
+bool __cache_thread(pthread_internal_t* thread) {
+  ScopedPthreadMutexLocker locker(&g_thread_cache_lock);
+  if (g_thread_cache_count == kThreadCacheMax) {
+    return false;
+  }
+  thread->next = g_thread_cache;
+  g_thread_cache = thread;
+  ++g_thread_cache_count;
+  return true;
+}
+
+void __free_thread(pthread_internal_t* thread) {
+  // The main thread is not heap-allocated. See __libc_init_tls for the declaration,
+  // and __libc_init_common for the point where it's added to the thread list.
+  if ((thread->attr.flags & PTHREAD_ATTR_FLAG_MAIN_THREAD) != 0) {
+    return;
+  }
+  if (thread->mmap_base == NULL) {
+    free(thread);
+  } else if (!__cache_thread(thread)) {
+    __unmap_thread(thread);
+  }
+}
+
+void __trim_thread_cache() {
+  pthread_internal_t* unmap_list = NULL;
+  {
+    ScopedPthreadMutexLocker locker(&g_thread_cache_lock);
+    pthread_internal_t** it = &g_thread_cache;
+    while (*it != NULL) {
+      pthread_internal_t* thread = *it;
+      if (__thread_has_exited(thread)) {
+        *it = thread->next;
+        --g_thread_cache_count;
+        thread->next = unmap_list;
+        unmap_list = thread;
+      } else {
+        it = &thread->next;
+      }
+    }
+  }
+  while (unmap_list != NULL) {
+    pthread_internal_t* thread = unmap_list;
+    unmap_list = thread->next;
+    __unmap_thread(thread);
+  }
+}
+
+void _pthread_internal_remove_locked(pthread_internal_t* thread, bool free_thread) {
+  pthread_thread_bucket_t* bucket = __get_thread_bucket(reinterpret_cast<pthread_t>(thread));
+  for (pthread_internal_t** it = &bucket->threads; *it != NULL; it = &(*it)->bucket_next) {
+    if (*it == thread) {
+      *it = thread->bucket_next;
+      break;
+    }
+  }
+
+  pthread_mutex_lock(&g_thread_list_lock);
   if (thread->next != NULL) {
     thread->next->prev = thread->prev;
   }
@@ -44,15 +209,19 @@ void _pthread_internal_remove_locked(pthread_internal_t* thread) {
   } else {
     g_thread_list = thread->next;
   }
+  pthread_mutex_unlock(&g_thread_list_lock);
 
-  // The main thread is not heap-allocated. See __libc_init_tls for the declaration,
-  // and __libc_init_common for the point where it's added to the thread list.
-  if ((thread->attr.flags & PTHREAD_ATTR_FLAG_MAIN_THREAD) == 0) {
-    free(thread);
+  if (free_thread) {
+    __free_thread(thread);
   }
 }
 
 void _pthread_internal_add(pthread_internal_t* thread) {
+  pthread_thread_bucket_t* bucket = __get_thread_bucket(reinterpret_cast<pthread_t>(thread));
+  ScopedPthreadMutexLocker bucket_locker(&bucket->lock);
+  thread->bucket_next = bucket->threads;
+  bucket->threads = thread;
+
   ScopedPthreadMutexLocker locker(&g_thread_list_lock);
 
   // We insert at the head.
@@ -27,6 +27,7 @@
  */
 
 #include <pthread.h>
+#include <stdlib.h>
 
 #include "private/bionic_tls.h"
 #include "pthread_internal.h"
@@ -56,6 +57,18 @@
  * all created threads. As mandated by Posix, it is the responsibility of
  * the caller of pthread_key_delete() to properly reclaim the objects that
  * were pointed to by these data fields (either before or after the call).
+ *
+ * Keys beyond the TLS array ("dynamic" keys, BIONIC_TLS_SLOTS and up) work
+ * differently, in the same way as glibc's second-level keys. Each one has a
+ * sequence number in the global map that is odd while the key is allocated
+ * and is bumped by both pthread_key_create() and pthread_key_delete(). A
+ * thread's values for these keys live in blocks of BIONIC_DYNAMIC_KEY_BLOCK_SIZE
+ * entries hung off TLS_SLOT_PTHREAD_KEY_DATA, allocated the first time the
+ * thread stores a value in that block, and each entry records the sequence
+ * number it was stored under. A value stored under an older sequence number
+ * is simply ignored, so deleting a dynamic key doesn't need to visit all the
+ * other threads. Each block also has a bitmap of the entries that have been
+ * set, so the destructor pass at thread exit only looks at those.
  */
 
 #define TLSMAP_BITS       32
@@ -67,6 +80,14 @@ static inline bool IsValidUserKey(pthread_key_t key) {
   return (key >= TLS_SLOT_FIRST_USER_SLOT && key < BIONIC_TLS_SLOTS);
 }
 
+static inline bool IsDynamicKey(pthread_key_t key) {
+  return (key >= BIONIC_TLS_SLOTS && key < BIONIC_TLS_SLOTS + BIONIC_DYNAMIC_KEYS);
+}
+
+static inline bool IsSequenceInUse(uintptr_t seq) {
+  return (seq & 1) != 0;
+}
+
 typedef void (*key_destructor_t)(void*);
 
 struct tls_map_t {
@@ -76,8 +97,34 @@ struct tls_map_t {
   uint32_t map[TLSMAP_WORDS];
 
   key_destructor_t key_destructors[BIONIC_TLS_SLOTS];
+
+  /* sequence numbers and destructors of the dynamic keys */
+  volatile uintptr_t dynamic_key_seqs[BIONIC_DYNAMIC_KEYS];
+  key_destructor_t dynamic_key_destructors[BIONIC_DYNAMIC_KEYS];
+
+  /* where to start looking for a free dynamic key */
+  size_t dynamic_key_hint;
+};
+
+struct key_data_t {
+  uintptr_t seq;
+  void* data;
 };
 
+struct key_data_block_t {
+  /* bitmap of entries that have been set since the last destructor pass */
+  uint32_t used;
+  key_data_t entries[BIONIC_DYNAMIC_KEY_BLOCK_SIZE];
+};
+
+struct thread_key_data_t {
+  key_data_block_t* blocks[BIONIC_DYNAMIC_KEY_BLOCKS];
+};
+
+static inline thread_key_data_t* GetThreadKeyData() {
+  return reinterpret_cast<thread_key_data_t*>(__get_tls()[TLS_SLOT_PTHREAD_KEY_DATA]);
+}
+
 class ScopedTlsMapAccess {
  public:
   ScopedTlsMapAccess() {
@@ -111,10 +158,45 @@ class ScopedTlsMapAccess {
       }
     }
 
-    // We hit PTHREAD_KEYS_MAX. POSIX says EAGAIN for this case.
+    // The TLS array is full, so hand out a dynamic key. Start looking where we
+    // last found one so that creating lots of keys doesn't go quadratic.
+    for (size_t i = 0; i < BIONIC_DYNAMIC_KEYS; ++i) {
+      size_t index = (s_tls_map_.dynamic_key_hint + i) % BIONIC_DYNAMIC_KEYS;
+      uintptr_t seq = s_tls_map_.dynamic_key_seqs[index];
+      // Retire a key rather than let its sequence number wrap, since stale
+      // values stored under the old numbers would become visible again.
+      if (IsSequenceInUse(seq) || seq + 2 < seq) {
+        continue;
+      }
+      s_tls_map_.dynamic_key_destructors[index] = key_destructor;
+      s_tls_map_.dynamic_key_seqs[index] = seq + 1;
+      s_tls_map_.dynamic_key_hint = index + 1;
+      *result = BIONIC_TLS_SLOTS + index;
+      return 0;
+    }
+
+    // We hit _SC_THREAD_KEYS_MAX. POSIX says EAGAIN for this case.
     return EAGAIN;
   }
 
+  void DeleteDynamicKey(pthread_key_t key) {
+    size_t index = key - BIONIC_TLS_SLOTS;
+    s_tls_map_.dynamic_key_destructors[index] = NULL;
+    s_tls_map_.dynamic_key_seqs[index] += 1;
+  }
+
+  // Returns the sequence number of an allocated dynamic key, or 0 if the key isn't allocated.
+  uintptr_t GetDynamicKeySeq(pthread_key_t key) {
+    uintptr_t seq = s_tls_map_.dynamic_key_seqs[key - BIONIC_TLS_SLOTS];
+    return IsSequenceInUse(seq) ? seq : 0;
+  }
+
+  // Unlike the other accessors, this doesn't need the lock, because a stale
+  // sequence number can only make a value invisible.
+  static uintptr_t PeekDynamicKeySeq(pthread_key_t key) {
+    return s_tls_map_.dynamic_key_seqs[key - BIONIC_TLS_SLOTS];
+  }
+
   void DeleteKey(pthread_key_t key) {
     TLSMAP_WORD(s_tls_map_, key) &= ~TLSMAP_MASK(key);
     s_tls_map_.key_destructors[key] = NULL;
@@ -165,6 +247,8 @@ class ScopedTlsMapAccess {
         }
       }
 
+      called_destructor_count += CleanDynamicKeys();
+
       // If we didn't call any destructors, there is no need to check the TLS data again.
       if (called_destructor_count == 0) {
         break;
@@ -174,6 +258,47 @@ class ScopedTlsMapAccess {
 
  private:
   static tls_map_t s_tls_map_;
+
+  // One destructor pass over this thread's dynamic key values. Only entries
+  // that have been set since the last pass are looked at.
+  size_t CleanDynamicKeys() {
+    size_t called_destructor_count = 0;
+    for (size_t block_index = 0; block_index < BIONIC_DYNAMIC_KEY_BLOCKS; ++block_index) {
+      // Re-read everything each time round: a destructor may have set a value
+      // in a block that didn't exist before.
+      thread_key_data_t* thread_data = GetThreadKeyData();
+      if (thread_data == NULL) {
+        break;
+      }
+      key_data_block_t* block = thread_data->blocks[block_index];
+      if (block == NULL) {
+        continue;
+      }
+
+      // Entries set again by the destructors we call are left for the next round.
+      uint32_t used = block->used;
+      block->used = 0;
+      while (used != 0) {
+        size_t entry_index = __builtin_ctz(used);
+        used &= ~(1U << entry_index);
+
+        size_t index = block_index * BIONIC_DYNAMIC_KEY_BLOCK_SIZE + entry_index;
+        key_data_t* entry = &block->entries[entry_index];
+        void* data = entry->data;
+        key_destructor_t key_destructor = s_tls_map_.dynamic_key_destructors[index];
+        if (entry->seq == s_tls_map_.dynamic_key_seqs[index] && IsSequenceInUse(entry->seq) &&
+            data != NULL && key_destructor != NULL) {
+          entry->data = NULL;
+          Unlock();
+          (*key_destructor)(data);
+          Lock();
+          ++called_destructor_count;
+        }
+      }
+    }
+    return called_destructor_count;
+  }
+
   static pthread_mutex_t s_tls_map_lock_;
 
   void Lock() {
@@ -189,8 +314,22 @@ __LIBC_HIDDEN__ tls_map_t ScopedTlsMapAccess::s_tls_map_;
 __LIBC_HIDDEN__ pthread_mutex_t ScopedTlsMapAccess::s_tls_map_lock_;
 
 __LIBC_HIDDEN__ void pthread_key_clean_all() {
-  ScopedTlsMapAccess tls_map;
-  tls_map.CleanAll();
+  {
+    ScopedTlsMapAccess tls_map;
+    tls_map.CleanAll();
+  }
+
+  // Free the dynamic key values outside the lock, because free(3) may itself
+  // use pthread keys. Anything a destructor stores after this is allocated
+  // afresh and freed by the next cleanup.
+  thread_key_data_t* thread_data = GetThreadKeyData();
+  if (thread_data != NULL) {
+    __get_tls()[TLS_SLOT_PTHREAD_KEY_DATA] = NULL;
+    for (size_t i = 0; i < BIONIC_DYNAMIC_KEY_BLOCKS; ++i) {
+      free(thread_data->blocks[i]);
+    }
+    free(thread_data);
+  }
 }
 
 int pthread_key_create(pthread_key_t* key, void (*key_destructor)(void*)) {
@@ -205,6 +344,15 @@ int pthread_key_create(pthread_key_t* key, void (*key_destructor)(void*)) {
 int pthread_key_delete(pthread_key_t key) {
   ScopedTlsMapAccess tls_map;
 
+  if (IsDynamicKey(key)) {
+    if (tls_map.GetDynamicKeySeq(key) == 0) {
+      return EINVAL;
+    }
+    // Bumping the sequence number hides every thread's value at once.
+    tls_map.DeleteDynamicKey(key);
+    return 0;
+  }
+
   if (!IsValidUserKey(key) || !tls_map.IsInUse(key)) {
     return EINVAL;
   }
@@ -230,7 +378,71 @@ int pthread_key_delete(pthread_key_t key) {
   return 0;
 }
 
+static void* GetDynamicSpecific(pthread_key_t key) {
+  thread_key_data_t* thread_data = GetThreadKeyData();
+  if (thread_data == NULL) {
+    return NULL;
+  }
+  size_t index = key - BIONIC_TLS_SLOTS;
+  key_data_block_t* block = thread_data->blocks[index / BIONIC_DYNAMIC_KEY_BLOCK_SIZE];
+  if (block == NULL) {
+    return NULL;
+  }
+  key_data_t* entry = &block->entries[index % BIONIC_DYNAMIC_KEY_BLOCK_SIZE];
+  if (entry->seq != ScopedTlsMapAccess::PeekDynamicKeySeq(key)) {
+    return NULL;
+  }
+  return entry->data;
+}
+
+static int SetDynamicSpecific(pthread_key_t key, const void* ptr) {
+  uintptr_t seq;
+  {
+    ScopedTlsMapAccess tls_map;
+    seq = tls_map.GetDynamicKeySeq(key);
+  }
+  if (seq == 0) {
+    return EINVAL;
+  }
+
+  // Only this thread ever touches its own key data, so none of what follows
+  // needs the lock. The allocations in particular mustn't be made with it held,
+  // since malloc(3) may use pthread keys itself.
+  size_t index = key - BIONIC_TLS_SLOTS;
+  thread_key_data_t* thread_data = GetThreadKeyData();
+  if (thread_data == NULL) {
+    if (ptr == NULL) {
+      return 0;
+    }
+    thread_data = reinterpret_cast<thread_key_data_t*>(calloc(1, sizeof(thread_key_data_t)));
+    if (thread_data == NULL) {
+      return ENOMEM;
+    }
+    __get_tls()[TLS_SLOT_PTHREAD_KEY_DATA] = thread_data;
+  }
+  key_data_block_t*& block = thread_data->blocks[index / BIONIC_DYNAMIC_KEY_BLOCK_SIZE];
+  if (block == NULL) {
+    if (ptr == NULL) {
+      return 0;
+    }
+    block = reinterpret_cast<key_data_block_t*>(calloc(1, sizeof(key_data_block_t)));
+    if (block == NULL) {
+      return ENOMEM;
+    }
+  }
+
+  size_t entry_index = index % BIONIC_DYNAMIC_KEY_BLOCK_SIZE;
+  block->entries[entry_index].seq = seq;
+  block->entries[entry_index].data = const_cast<void*>(ptr);
+  block->used |= (1U << entry_index);
+  return 0;
+}
+
 void* pthread_getspecific(pthread_key_t key) {
+  if (IsDynamicKey(key)) {
+    return GetDynamicSpecific(key);
+  }
+
   if (!IsValidUserKey(key)) {
     return NULL;
   }
@@ -243,6 +455,10 @@ void* pthread_getspecific(pthread_key_t key) {
 }
 
 int pthread_setspecific(pthread_key_t key, const void* ptr) {
+  if (IsDynamicKey(key)) {
+    return SetDynamicSpecific(key, ptr);
+  }
+
   ScopedTlsMapAccess tls_map;
 
   if (!IsValidUserKey(key) || !tls_map.IsInUse(key)) {
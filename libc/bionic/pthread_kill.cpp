@@ -27,6 +27,8 @@
  */
 
 #include <errno.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #include "private/ErrnoRestorer.h"
@@ -34,17 +36,33 @@
 
 extern "C" int tgkill(int tgid, int tid, int sig);
 
-int pthread_kill(pthread_t t, int sig) {
-  ErrnoRestorer errno_restorer;
+// Returns the tid of 't', or 0 if there's no such thread. A thread signalling
+// itself, as profilers and signal handlers mostly do, doesn't need the thread
+// looked up, and so doesn't take its bucket's lock either. That keeps the
+// common case async-signal-safe: a handler that interrupted a thread holding
+// that lock would otherwise deadlock.
+static pid_t __pthread_tid(pthread_t t) {
+  pthread_internal_t* self = __get_thread();
+  if (t == reinterpret_cast<pthread_t>(self)) {
+    return self->tid;
+  }
 
   pthread_accessor thread(t);
   if (thread.get() == NULL) {
-    return ESRCH;
+    return 0;
   }
 
   // There's a race here, but it's one we share with all other C libraries.
-  pid_t tid = thread->tid;
-  thread.Unlock();
+  return thread->tid;
+}
+
+int pthread_kill(pthread_t t, int sig) {
+  ErrnoRestorer errno_restorer;
+
+  pid_t tid = __pthread_tid(t);
+  if (tid == 0) {
+    return ESRCH;
+  }
 
   int rc = tgkill(getpid(), tid, sig);
   if (rc == -1) {
@@ -53,3 +71,28 @@ int pthread_kill(pthread_t t, int sig) {
 
   return 0;
 }
+
+int pthread_sigqueue(pthread_t t, int sig, const union sigval value) {
+  ErrnoRestorer errno_restorer;
+
+  pid_t tid = __pthread_tid(t);
+  if (tid == 0) {
+    return ESRCH;
+  }
+
+  // The same siginfo sigqueue(3) would send, but to a single thread.
+  siginfo_t info;
+  memset(&info, 0, sizeof(info));
+  info.si_signo = sig;
+  info.si_code = SI_QUEUE;
+  info.si_pid = getpid();
+  info.si_uid = getuid();
+  info.si_value = value;
+
+  int rc = syscall(__NR_rt_tgsigqueueinfo, info.si_pid, tid, sig, &info);
+  if (rc == -1) {
+    return errno;
+  }
+
+  return 0;
+}
@@ -30,14 +30,17 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
 #include "pthread_internal.h"
+#include "pthread_mutex_contention.h"
 
 #include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_tls.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
 extern void pthread_debug_mutex_lock_check(pthread_mutex_t *mutex);
 extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
@@ -50,6 +53,8 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
  * 13        shared   process-shared flag
  * 12-2      counter  counter of recursive mutexes
  * 1-0       state    lock state (0, 1 or 2)
+ *
+ * Priority-inheritance mutexes are the exception, see MUTEX_PI_BITS below.
  */
 
 /* Convenience macro, creates a mask of 'bits' bits that starts from
@@ -80,8 +85,8 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
 #define  MUTEX_STATE_TO_BITS(v)     FIELD_TO_BITS(v, MUTEX_STATE_SHIFT, MUTEX_STATE_LEN)
 
 #define  MUTEX_STATE_UNLOCKED            0   /* must be 0 to match __PTHREAD_MUTEX_INIT_VALUE */
-#define  MUTEX_STATE_LOCKED_UNCONTENDED  1   /* must be 1 due to atomic dec in unlock operation */
-#define  MUTEX_STATE_LOCKED_CONTENDED    2   /* must be 1 + LOCKED_UNCONTENDED due to atomic dec */
+#define  MUTEX_STATE_LOCKED_UNCONTENDED  1
+#define  MUTEX_STATE_LOCKED_CONTENDED    2
 
 #define  MUTEX_STATE_FROM_BITS(v)    FIELD_FROM_BITS(v, MUTEX_STATE_SHIFT, MUTEX_STATE_LEN)
 #define  MUTEX_STATE_TO_BITS(v)      FIELD_TO_BITS(v, MUTEX_STATE_SHIFT, MUTEX_STATE_LEN)
@@ -128,7 +133,8 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
 
 /* Mutex type:
  *
- * We support normal, recursive and errorcheck mutexes.
+ * We support normal, recursive, errorcheck and adaptive mutexes. Adaptive
+ * mutexes are normal mutexes that spin for a while before sleeping.
  *
  * The constants defined here *cannot* be changed because they must match
  * the C library ABI which defines the following initialization values in
@@ -137,6 +143,7 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
  *   __PTHREAD_MUTEX_INIT_VALUE
  *   __PTHREAD_RECURSIVE_MUTEX_VALUE
  *   __PTHREAD_ERRORCHECK_MUTEX_INIT_VALUE
+ *   __PTHREAD_ADAPTIVE_MUTEX_INIT_VALUE
  */
 #define  MUTEX_TYPE_SHIFT      14
 #define  MUTEX_TYPE_LEN        2
@@ -145,12 +152,14 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
 #define  MUTEX_TYPE_NORMAL          0  /* Must be 0 to match __PTHREAD_MUTEX_INIT_VALUE */
 #define  MUTEX_TYPE_RECURSIVE       1
 #define  MUTEX_TYPE_ERRORCHECK      2
+#define  MUTEX_TYPE_ADAPTIVE        3
 
 #define  MUTEX_TYPE_TO_BITS(t)       FIELD_TO_BITS(t, MUTEX_TYPE_SHIFT, MUTEX_TYPE_LEN)
 
 #define  MUTEX_TYPE_BITS_NORMAL      MUTEX_TYPE_TO_BITS(MUTEX_TYPE_NORMAL)
 #define  MUTEX_TYPE_BITS_RECURSIVE   MUTEX_TYPE_TO_BITS(MUTEX_TYPE_RECURSIVE)
 #define  MUTEX_TYPE_BITS_ERRORCHECK  MUTEX_TYPE_TO_BITS(MUTEX_TYPE_ERRORCHECK)
+#define  MUTEX_TYPE_BITS_ADAPTIVE    MUTEX_TYPE_TO_BITS(MUTEX_TYPE_ADAPTIVE)
 
 /* Mutex owner field:
  *
@@ -186,6 +195,23 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
 #define  MUTEX_OWNER_FROM_BITS(v)    FIELD_FROM_BITS(v,MUTEX_OWNER_SHIFT,MUTEX_OWNER_LEN)
 #define  MUTEX_OWNER_TO_BITS(v)      FIELD_TO_BITS(v,MUTEX_OWNER_SHIFT,MUTEX_OWNER_LEN)
 
+/* Priority-inheritance and robust mutexes:
+ *
+ * The kernel's FUTEX_LOCK_PI and FUTEX_UNLOCK_PI operations, and its
+ * cleanup of robust mutexes, need a futex word holding nothing but the
+ * owner's tid and the FUTEX_WAITERS and FUTEX_OWNER_DIED bits, so the
+ * state of such a mutex lives in a separate pi_mutex_t. On LP64 that's the reserved space of the pthread_mutex_t;
+ * on 32-bit there's no room, so it's an entry in a process-wide table
+ * whose index is kept in the owner field.
+ *
+ * The mutex value is then fixed to a normal type with all counter bits
+ * set, a pattern no other mutex ever has, plus the shared flag.
+ */
+#define  MUTEX_PI_BITS               MUTEX_COUNTER_MASK
+#define  MUTEX_PI_MASK               (MUTEX_TYPE_MASK | MUTEX_COUNTER_MASK | MUTEX_STATE_MASK)
+
+#define  MUTEX_BITS_ARE_PI(v)        (((v) & MUTEX_PI_MASK) == MUTEX_PI_BITS)
+
 /* Convenience macros.
  *
  * These are used to form or modify the bit pattern of a given mutex value
@@ -198,9 +224,13 @@ extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
  * bits:     name       description
  * 0-3       type       type of mutex
  * 4         shared     process-shared flag
+ * 5         protocol   priority-inheritance flag
+ * 6         robust     robustness flag
  */
 #define  MUTEXATTR_TYPE_MASK   0x000f
 #define  MUTEXATTR_SHARED_MASK 0x0010
+#define  MUTEXATTR_PI_MASK     0x0020
+#define  MUTEXATTR_ROBUST_MASK 0x0040
 
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
@@ -219,7 +249,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 {
     int type = (*attr & MUTEXATTR_TYPE_MASK);
 
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -229,7 +259,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK ) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -248,9 +278,9 @@ int pthread_mutexattr_setpshared(pthread_mutexattr_t *attr, int  pshared)
 
     case PTHREAD_PROCESS_SHARED:
         /* our current implementation of pthread actually supports shared
-         * mutexes but won't cleanup if a process dies with the mutex held.
-         * Nevertheless, it's better than nothing. Shared mutexes are used
-         * by surfaceflinger and audioflinger.
+         * mutexes but only robust ones get cleaned up if a process dies with
+         * the mutex held. Shared mutexes are used by surfaceflinger and
+         * audioflinger.
          */
         *attr |= MUTEXATTR_SHARED_MASK;
         return 0;
@@ -263,6 +293,495 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
     return 0;
 }
 
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t* attr, int protocol) {
+    switch (protocol) {
+    case PTHREAD_PRIO_NONE:
+        *attr &= ~MUTEXATTR_PI_MASK;
+        return 0;
+
+    case PTHREAD_PRIO_INHERIT:
+        *attr |= MUTEXATTR_PI_MASK;
+        return 0;
+
+    case PTHREAD_PRIO_PROTECT:
+        return ENOTSUP;
+    }
+    return EINVAL;
+}
+
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t* attr, int* protocol) {
+    *protocol = (*attr & MUTEXATTR_PI_MASK) ? PTHREAD_PRIO_INHERIT : PTHREAD_PRIO_NONE;
+    return 0;
+}
+
+int pthread_mutexattr_setrobust(pthread_mutexattr_t* attr, int robust) {
+    switch (robust) {
+    case PTHREAD_MUTEX_STALLED:
+        *attr &= ~MUTEXATTR_ROBUST_MASK;
+        return 0;
+
+    case PTHREAD_MUTEX_ROBUST:
+        *attr |= MUTEXATTR_ROBUST_MASK;
+        return 0;
+    }
+    return EINVAL;
+}
+
+int pthread_mutexattr_getrobust(const pthread_mutexattr_t* attr, int* robust) {
+    *robust = (*attr & MUTEXATTR_ROBUST_MASK) ? PTHREAD_MUTEX_ROBUST : PTHREAD_MUTEX_STALLED;
+    return 0;
+}
+
+/* The futex words here are atomic_ints in all but name (<pthread.h> can't
+ * use <stdatomic.h>), and these are how the racing accesses to them are
+ * made. Taking a lock needs acquire ordering and dropping it needs release
+ * ordering, nothing stronger: that costs nothing extra on x86, and on ARM
+ * it avoids a full dmb on both sides of every critical section.
+ */
+static inline __always_inline volatile atomic_int* _atomic(volatile int* p) {
+    static_assert(sizeof(atomic_int) == sizeof(int), "atomic_int should be an int");
+    return reinterpret_cast<volatile atomic_int*>(p);
+}
+
+/* Returns true if it made the swap. */
+static inline __always_inline bool _cas(volatile int* p, int old_value, int new_value,
+                                        memory_order order) {
+    return atomic_compare_exchange_strong_explicit(_atomic(p), &old_value, new_value,
+                                                   order, memory_order_relaxed);
+}
+
+/* Returns the previous value. */
+static inline __always_inline int _swap(volatile int* p, int new_value, memory_order order) {
+    return atomic_exchange_explicit(_atomic(p), new_value, order);
+}
+
+#define  PI_MUTEX_FLAG_PRIO_INHERIT    0x01  /* FUTEX_LOCK_PI rather than FUTEX_WAIT */
+#define  PI_MUTEX_FLAG_ROBUST          0x02  /* on the owner's robust list */
+#define  PI_MUTEX_FLAG_OWNER_DIED      0x04  /* the last owner called pthread_exit holding it */
+#define  PI_MUTEX_FLAG_INCONSISTENT    0x08  /* EOWNERDEAD was returned, no pthread_mutex_consistent yet */
+#define  PI_MUTEX_FLAG_NOTRECOVERABLE  0x10  /* unlocked while inconsistent, fails until re-initialized */
+#define  PI_MUTEX_FLAG_SHARED          0x20  /* process-shared */
+
+/* The link and prev fields are only used by robust mutexes. The structure
+ * is only 4-byte aligned because the reserved space of a pthread_mutex_t is.
+ */
+struct __attribute__((packed, aligned(4))) pi_mutex_t {
+    volatile int32_t owner;  /* the futex word */
+    uint16_t counter;        /* recursion count, only changed by the owner */
+    uint8_t type;            /* PTHREAD_MUTEX_NORMAL, _RECURSIVE or _ERRORCHECK */
+    uint8_t flags;           /* PI_MUTEX_FLAG_*, only changed by the owner */
+    robust_list link;        /* the kernel-visible entry in the owner's robust list */
+    robust_list* prev;       /* whatever points to 'link' */
+};
+
+#if !defined(__LP64__)
+/* The table grows a page at a time, up to one entry per possible value
+ * of the owner field. Free entries are chained through their owner word.
+ */
+#define  PI_MUTEXES_PER_CHUNK   (PAGE_SIZE / sizeof(pi_mutex_t))
+#define  PI_MUTEX_CHUNK_COUNT   ((1 << MUTEX_OWNER_LEN) / PI_MUTEXES_PER_CHUNK)
+
+static pthread_mutex_t g_pi_mutex_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static pi_mutex_t* g_pi_mutex_chunks[PI_MUTEX_CHUNK_COUNT];
+static size_t g_pi_mutex_chunk_count = 0;
+static int g_pi_mutex_free_list = -1;
+
+static inline pi_mutex_t* _pi_mutex_from_id(int id) {
+    return &g_pi_mutex_chunks[id / PI_MUTEXES_PER_CHUNK][id % PI_MUTEXES_PER_CHUNK];
+}
+
+static int _pi_mutex_alloc_id() {
+    ScopedPthreadMutexLocker locker(&g_pi_mutex_table_lock);
+
+    if (g_pi_mutex_free_list == -1) {
+        if (g_pi_mutex_chunk_count == PI_MUTEX_CHUNK_COUNT) {
+            return -1;
+        }
+        void* chunk = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (chunk == MAP_FAILED) {
+            return -1;
+        }
+        pi_mutex_t* entries = reinterpret_cast<pi_mutex_t*>(chunk);
+        int first_id = g_pi_mutex_chunk_count * PI_MUTEXES_PER_CHUNK;
+        for (size_t i = 0; i < PI_MUTEXES_PER_CHUNK; ++i) {
+            entries[i].owner = (i + 1 < PI_MUTEXES_PER_CHUNK) ? first_id + i + 1 : -1;
+        }
+        g_pi_mutex_chunks[g_pi_mutex_chunk_count++] = entries;
+        g_pi_mutex_free_list = first_id;
+    }
+
+    int id = g_pi_mutex_free_list;
+    g_pi_mutex_free_list = _pi_mutex_from_id(id)->owner;
+    return id;
+}
+
+static void _pi_mutex_free_id(int id) {
+    ScopedPthreadMutexLocker locker(&g_pi_mutex_table_lock);
+    _pi_mutex_from_id(id)->owner = g_pi_mutex_free_list;
+    g_pi_mutex_free_list = id;
+}
+#endif
+
+static inline pi_mutex_t* _pi_mutex(pthread_mutex_t* mutex) {
+#if defined(__LP64__)
+    return reinterpret_cast<pi_mutex_t*>(mutex->__reserved);
+#else
+    return _pi_mutex_from_id(MUTEX_OWNER_FROM_BITS(mutex->value));
+#endif
+}
+
+static int _pi_mutex_init(pthread_mutex_t* mutex, int shared, int type, int flags) {
+    int value = shared | MUTEX_PI_BITS;
+#if defined(__LP64__)
+    static_assert(sizeof(pi_mutex_t) <= sizeof(mutex->__reserved), "pi_mutex_t doesn't fit");
+    pi_mutex_t* pi = reinterpret_cast<pi_mutex_t*>(mutex->__reserved);
+#else
+    /* The table isn't visible to other processes. */
+    if (shared) {
+        return ENOTSUP;
+    }
+    int id = _pi_mutex_alloc_id();
+    if (id == -1) {
+        return EAGAIN;
+    }
+    pi_mutex_t* pi = _pi_mutex_from_id(id);
+    value |= MUTEX_OWNER_TO_BITS(id);
+#endif
+    pi->owner = 0;
+    pi->counter = 0;
+    /* The kernel does the waiting, so there's nothing to spin for. */
+    pi->type = (type == PTHREAD_MUTEX_ADAPTIVE_NP) ? PTHREAD_MUTEX_NORMAL : type;
+    pi->flags = flags | (shared ? PI_MUTEX_FLAG_SHARED : 0);
+    pi->link.next = NULL;
+    pi->prev = NULL;
+    mutex->value = value;
+    return 0;
+}
+
+/* Robust mutexes:
+ *
+ * These keep the tid-and-flags futex word of PI mutexes, with or without
+ * the priority inheritance. Each thread tells the kernel, with
+ * set_robust_list(2), where to find a list of the robust mutexes it holds;
+ * if it dies holding any, the kernel sets FUTEX_OWNER_DIED in their futex
+ * words and wakes a waiter, so the next owner gets EOWNERDEAD rather than
+ * waiting forever. 'list_op_pending' covers a thread dying between taking
+ * or dropping a mutex and updating the list. This works across processes
+ * as long as the mutex lives in shared memory.
+ *
+ * pthread_exit doesn't leave this to the kernel: an exiting thread's
+ * pthread_internal_t may be freed before the kernel gets to walk the list,
+ * so __pthread_mutex_abandon_robust_list does the same job beforehand.
+ */
+static const long kRobustFutexOffset = static_cast<long>(offsetof(pi_mutex_t, owner)) -
+                                       static_cast<long>(offsetof(pi_mutex_t, link));
+
+static inline robust_list* _robust_node(pi_mutex_t* pi) {
+    return reinterpret_cast<robust_list*>(reinterpret_cast<uintptr_t>(pi) + offsetof(pi_mutex_t, link));
+}
+
+/* Entries of PI futexes have their low bit set, as the kernel expects. */
+static inline robust_list* _robust_entry(pi_mutex_t* pi) {
+    uintptr_t entry = reinterpret_cast<uintptr_t>(_robust_node(pi));
+    if ((pi->flags & PI_MUTEX_FLAG_PRIO_INHERIT) != 0) {
+        entry |= 1;
+    }
+    return reinterpret_cast<robust_list*>(entry);
+}
+
+static inline pi_mutex_t* _robust_entry_mutex(robust_list* entry) {
+    uintptr_t link = reinterpret_cast<uintptr_t>(entry) & ~static_cast<uintptr_t>(1);
+    return reinterpret_cast<pi_mutex_t*>(link - offsetof(pi_mutex_t, link));
+}
+
+/* Returns the calling thread's robust list, registering it the first time. A
+ * forked child has to register afresh, and the parent's entries aren't its own.
+ */
+static robust_list_head* _robust_list_head() {
+    pthread_internal_t* thread = __get_thread();
+    robust_list_head* head = &thread->robust_list;
+    if (__predict_false(thread->robust_list_tid != thread->tid)) {
+        head->list.next = &head->list;
+        head->futex_offset = kRobustFutexOffset;
+        head->list_op_pending = NULL;
+        int saved_errno = errno;
+        syscall(__NR_set_robust_list, head, sizeof(*head));
+        errno = saved_errno;
+        thread->robust_list_tid = thread->tid;
+    }
+    return head;
+}
+
+/* The kernel reads the list only when this thread dies, so the compiler
+ * just has to keep these stores in program order around the futex word.
+ */
+static inline void _robust_set_pending(robust_list_head* head, robust_list* entry) {
+    atomic_signal_fence(memory_order_seq_cst);
+    head->list_op_pending = entry;
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+static void _robust_link(robust_list_head* head, pi_mutex_t* pi) {
+    robust_list* first = head->list.next;
+    pi->link.next = first;
+    pi->prev = &head->list;
+    if (first != &head->list) {
+        _robust_entry_mutex(first)->prev = _robust_node(pi);
+    }
+    atomic_signal_fence(memory_order_seq_cst);
+    head->list.next = _robust_entry(pi);
+}
+
+static void _robust_unlink(robust_list_head* head, pi_mutex_t* pi) {
+    robust_list* next = pi->link.next;
+    if ((reinterpret_cast<uintptr_t>(next) & ~static_cast<uintptr_t>(1)) !=
+        reinterpret_cast<uintptr_t>(&head->list)) {
+        _robust_entry_mutex(next)->prev = pi->prev;
+    }
+    pi->prev->next = next;
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+/* Drops a mutex held by 'tid' with a zero count. */
+static void _pi_release(pi_mutex_t* pi, int shared, int tid) {
+    if ((pi->flags & PI_MUTEX_FLAG_PRIO_INHERIT) != 0) {
+        /* If FUTEX_WAITERS is set, the kernel has to pick the next owner. */
+        atomic_thread_fence(memory_order_release);
+        if (!_cas(&pi->owner, tid, 0, memory_order_relaxed)) {
+            __futex(&pi->owner, shared ? FUTEX_UNLOCK_PI : FUTEX_UNLOCK_PI_PRIVATE, 0, NULL);
+        }
+    } else if ((_swap(&pi->owner, 0, memory_order_release) & FUTEX_WAITERS) != 0) {
+        __futex_wake_ex(&pi->owner, shared, 1);
+    }
+}
+
+/* Called with the mutex just taken. Clears any sign of a dead previous owner,
+ * links a robust mutex into our list and works out what to return.
+ */
+static int _pi_acquired(pi_mutex_t* pi, int shared, int tid, robust_list_head* head) {
+    if (head == NULL) {
+        return 0;
+    }
+    if (__predict_false((pi->flags & PI_MUTEX_FLAG_NOTRECOVERABLE) != 0)) {
+        _pi_release(pi, shared, tid);
+        _robust_set_pending(head, NULL);
+        return ENOTRECOVERABLE;
+    }
+
+    bool owner_died = (pi->flags & PI_MUTEX_FLAG_OWNER_DIED) != 0;
+    int owner = pi->owner;
+    while ((owner & FUTEX_OWNER_DIED) != 0) {
+        owner_died = true;
+        if (_cas(&pi->owner, owner, owner & ~FUTEX_OWNER_DIED, memory_order_relaxed)) {
+            break;
+        }
+        owner = pi->owner;
+    }
+
+    _robust_link(head, pi);
+    _robust_set_pending(head, NULL);
+    if (__predict_false(owner_died)) {
+        pi->counter = 0;
+        pi->flags = (pi->flags & ~PI_MUTEX_FLAG_OWNER_DIED) | PI_MUTEX_FLAG_INCONSISTENT;
+        return EOWNERDEAD;
+    }
+    return 0;
+}
+
+/* Lock a mutex with a tid futex word. For a priority-inheritance mutex we
+ * wait in FUTEX_LOCK_PI, where the kernel runs the owner at our priority if
+ * that's higher than its own, and hands the mutex to waiters in priority
+ * order. Otherwise this is the usual FUTEX_WAIT loop, with FUTEX_WAITERS
+ * telling the owner to wake us.
+ */
+static int _pi_lock(pthread_mutex_t* mutex, int shared, const timespec* abs_timeout, clockid_t clock) {
+    pi_mutex_t* pi = _pi_mutex(mutex);
+    int tid = __get_thread()->tid;
+    robust_list_head* head = NULL;
+
+    if ((pi->flags & PI_MUTEX_FLAG_ROBUST) != 0) {
+        if ((pi->flags & PI_MUTEX_FLAG_NOTRECOVERABLE) != 0) {
+            return ENOTRECOVERABLE;
+        }
+        head = _robust_list_head();
+        _robust_set_pending(head, _robust_entry(pi));
+    }
+
+    if (__predict_true(_cas(&pi->owner, 0, tid, memory_order_acquire))) {
+        return _pi_acquired(pi, shared, tid, head);
+    }
+
+    if ((pi->owner & FUTEX_TID_MASK) == tid) {
+        int result = 0;
+        if (pi->type != PTHREAD_MUTEX_RECURSIVE) {
+            result = EDEADLK;
+        } else if (pi->counter == 0xffff) {
+            result = EAGAIN;
+        } else {
+            ++pi->counter;
+        }
+        if (head != NULL) {
+            _robust_set_pending(head, NULL);
+        }
+        return result;
+    }
+
+    int result;
+    if ((pi->flags & PI_MUTEX_FLAG_PRIO_INHERIT) != 0) {
+        // FUTEX_LOCK_PI only takes CLOCK_REALTIME timeouts, so convert.
+        timespec realtime_timeout;
+        if (abs_timeout != NULL && clock != CLOCK_REALTIME) {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &realtime_timeout);
+            if (__timespec_from_absolute(&ts, abs_timeout, clock) >= 0) {
+                realtime_timeout.tv_sec += ts.tv_sec;
+                realtime_timeout.tv_nsec += ts.tv_nsec;
+                if (realtime_timeout.tv_nsec >= 1000000000) {
+                    realtime_timeout.tv_sec++;
+                    realtime_timeout.tv_nsec -= 1000000000;
+                }
+            }
+            abs_timeout = &realtime_timeout;
+        }
+        do {
+            result = __futex(&pi->owner, shared ? FUTEX_LOCK_PI : FUTEX_LOCK_PI_PRIVATE, 0, abs_timeout);
+        } while (result == -EINTR);
+        /* The kernel took the lock for us. */
+        atomic_thread_fence(memory_order_acquire);
+    } else {
+        result = 0;
+        while (true) {
+            int owner = pi->owner;
+            if ((owner & FUTEX_TID_MASK) == 0) {
+                /* Free, or its owner died. Others may be waiting too. */
+                if (_cas(&pi->owner, owner, tid | FUTEX_WAITERS | (owner & FUTEX_OWNER_DIED),
+                         memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            if ((owner & FUTEX_WAITERS) == 0) {
+                if (!_cas(&pi->owner, owner, owner | FUTEX_WAITERS, memory_order_relaxed)) {
+                    continue;
+                }
+                owner |= FUTEX_WAITERS;
+            }
+            int ret = __futex_wait_abs_ex(&pi->owner, shared, owner, clock == CLOCK_REALTIME, abs_timeout);
+            if (ret == -ETIMEDOUT || ret == -EINVAL) {
+                result = ret;
+                break;
+            }
+        }
+    }
+
+    if (result != 0) {
+        if (head != NULL) {
+            _robust_set_pending(head, NULL);
+        }
+        return -result;
+    }
+    return _pi_acquired(pi, shared, tid, head);
+}
+
+static int _pi_trylock(pthread_mutex_t* mutex, int shared) {
+    pi_mutex_t* pi = _pi_mutex(mutex);
+    int tid = __get_thread()->tid;
+    robust_list_head* head = NULL;
+
+    if ((pi->flags & PI_MUTEX_FLAG_ROBUST) != 0) {
+        if ((pi->flags & PI_MUTEX_FLAG_NOTRECOVERABLE) != 0) {
+            return ENOTRECOVERABLE;
+        }
+        head = _robust_list_head();
+        _robust_set_pending(head, _robust_entry(pi));
+    }
+
+    if (__predict_true(_cas(&pi->owner, 0, tid, memory_order_acquire))) {
+        return _pi_acquired(pi, shared, tid, head);
+    }
+
+    int result = EBUSY;
+    int owner = pi->owner;
+    if ((owner & FUTEX_TID_MASK) == tid) {
+        if (pi->type == PTHREAD_MUTEX_ERRORCHECK) {
+            result = EDEADLK;
+        } else if (pi->type == PTHREAD_MUTEX_RECURSIVE) {
+            if (pi->counter == 0xffff) {
+                result = EAGAIN;
+            } else {
+                ++pi->counter;
+                result = 0;
+            }
+        }
+    } else if ((owner & FUTEX_TID_MASK) == 0) {
+        if ((pi->flags & PI_MUTEX_FLAG_PRIO_INHERIT) != 0) {
+            /* A mutex whose owner died with waiters queued can only be taken by
+             * the kernel, which knows how to clean up after it.
+             */
+            if (__futex(&pi->owner, shared ? FUTEX_TRYLOCK_PI : FUTEX_TRYLOCK_PI_PRIVATE, 0, NULL) == 0) {
+                atomic_thread_fence(memory_order_acquire);
+                return _pi_acquired(pi, shared, tid, head);
+            }
+        } else if (_cas(&pi->owner, owner, tid | owner, memory_order_acquire)) {
+            return _pi_acquired(pi, shared, tid, head);
+        }
+    }
+
+    if (head != NULL) {
+        _robust_set_pending(head, NULL);
+    }
+    return result;
+}
+
+static int _pi_unlock(pthread_mutex_t* mutex, int shared) {
+    pi_mutex_t* pi = _pi_mutex(mutex);
+    int tid = __get_thread()->tid;
+
+    /* Unlike a normal mutex, the kernel insists on the owner unlocking. */
+    if ((pi->owner & FUTEX_TID_MASK) != tid) {
+        return EPERM;
+    }
+    if (pi->counter != 0) {
+        --pi->counter;
+        return 0;
+    }
+
+    if ((pi->flags & PI_MUTEX_FLAG_ROBUST) == 0) {
+        _pi_release(pi, shared, tid);
+        return 0;
+    }
+
+    /* Whatever the dead owner was protecting is still broken, so make sure
+     * nobody else gets to use it.
+     */
+    if ((pi->flags & PI_MUTEX_FLAG_INCONSISTENT) != 0) {
+        pi->flags = (pi->flags & ~PI_MUTEX_FLAG_INCONSISTENT) | PI_MUTEX_FLAG_NOTRECOVERABLE;
+    }
+    robust_list_head* head = _robust_list_head();
+    _robust_set_pending(head, _robust_entry(pi));
+    _robust_unlink(head, pi);
+    _pi_release(pi, shared, tid);
+    _robust_set_pending(head, NULL);
+    return 0;
+}
+
+void __pthread_mutex_abandon_robust_list(pthread_internal_t* thread) {
+    if (thread->robust_list_tid != thread->tid) {
+        return;
+    }
+    robust_list_head* head = &thread->robust_list;
+    while (head->list.next != &head->list) {
+        pi_mutex_t* pi = _robust_entry_mutex(head->list.next);
+        int shared = (pi->flags & PI_MUTEX_FLAG_SHARED) != 0;
+        _robust_set_pending(head, _robust_entry(pi));
+        _robust_unlink(head, pi);
+        pi->counter = 0;
+        pi->flags |= PI_MUTEX_FLAG_OWNER_DIED;
+        _pi_release(pi, shared, thread->tid);
+        _robust_set_pending(head, NULL);
+    }
+}
+
 int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr) {
     if (__predict_true(attr == NULL)) {
         mutex->value = MUTEX_TYPE_BITS_NORMAL;
@@ -284,15 +803,79 @@ int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
     case PTHREAD_MUTEX_ERRORCHECK:
         value |= MUTEX_TYPE_BITS_ERRORCHECK;
         break;
+    case PTHREAD_MUTEX_ADAPTIVE_NP:
+        value |= MUTEX_TYPE_BITS_ADAPTIVE;
+        break;
     default:
         return EINVAL;
     }
 
+    if ((*attr & (MUTEXATTR_PI_MASK | MUTEXATTR_ROBUST_MASK)) != 0) {
+        int flags = 0;
+        if ((*attr & MUTEXATTR_PI_MASK) != 0) {
+            flags |= PI_MUTEX_FLAG_PRIO_INHERIT;
+        }
+        if ((*attr & MUTEXATTR_ROBUST_MASK) != 0) {
+            flags |= PI_MUTEX_FLAG_ROBUST;
+        }
+        return _pi_mutex_init(mutex, value & MUTEX_SHARED_MASK, *attr & MUTEXATTR_TYPE_MASK, flags);
+    }
+
     mutex->value = value;
     return 0;
 }
 
 
+/* An adaptive mutex's owner is most likely running, and about to release
+ * it, so rather than sleep straight away a locker spins for up to
+ * MUTEX_ADAPTIVE_SPIN_COUNT reads of the mutex, backing off exponentially
+ * between them to keep the cache line quiet.
+ */
+#define  MUTEX_ADAPTIVE_SPIN_COUNT      100
+#define  MUTEX_ADAPTIVE_MAX_BACKOFF     64
+
+static inline bool _adaptive_spin(pthread_mutex_t* mutex, int unlocked, int locked_uncontended) {
+    int backoff = 1;
+    for (int i = 0; i < MUTEX_ADAPTIVE_SPIN_COUNT; ++i) {
+        int mvalue = mutex->value;
+        if (mvalue == unlocked) {
+            if (_cas(&mutex->value, unlocked, locked_uncontended, memory_order_acquire)) {
+                return true;
+            }
+        } else if (MUTEX_STATE_BITS_IS_LOCKED_CONTENDED(mvalue)) {
+            /* Others are already asleep waiting; don't jump the queue. */
+            return false;
+        }
+        for (int j = 0; j < backoff; ++j) {
+            __bionic_cpu_relax();
+        }
+        if (backoff < MUTEX_ADAPTIVE_MAX_BACKOFF) {
+            backoff *= 2;
+        }
+    }
+    return false;
+}
+
+/* Set when mutex contention profiling is enabled (see pthread_mutex_contention.cpp). */
+const MutexContentionDispatch* g_mutex_contention_dispatch = NULL;
+
+/* Called before the first sleep of a contended lock. Returns the sample to pass
+ * to _contention_end(), which is NULL unless this wait is being profiled.
+ */
+static inline void* _contention_begin(pthread_mutex_t* mutex, pid_t owner_tid) {
+    const MutexContentionDispatch* dispatch = g_mutex_contention_dispatch;
+    if (__predict_true(dispatch == NULL)) {
+        return NULL;
+    }
+    return dispatch->begin(mutex, owner_tid);
+}
+
+static inline void _contention_end(void* sample) {
+    if (__predict_false(sample != NULL)) {
+        g_mutex_contention_dispatch->end(sample);
+    }
+}
+
 /*
  * Lock a non-recursive mutex.
  *
@@ -302,27 +885,30 @@ int pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
  *   2 (locked, contention)
  *
  * Non-recursive mutexes don't use the thread-id or counter fields, and the
- * "type" value is zero, so the only bits that will be set are the ones in
- * the lock state field.
+ * "type" value is zero (or the adaptive type, which is otherwise the same),
+ * so the only bits that change are the ones in the lock state field.
  */
-static inline void _normal_lock(pthread_mutex_t* mutex, int shared) {
+static inline void _normal_lock(pthread_mutex_t* mutex, int shared, int mtype) {
     /* convenience shortcuts */
-    const int unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const int locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+    const int unlocked           = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const int locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
     /*
      * The common case is an unlocked mutex, so we begin by trying to
      * change the lock's state from 0 (UNLOCKED) to 1 (LOCKED).
-     * __bionic_cmpxchg() returns 0 if it made the swap successfully.
-     * If the result is nonzero, this lock is already held by another thread.
+     * If that fails, this lock is already held by another thread.
      */
-    if (__bionic_cmpxchg(unlocked, locked_uncontended, &mutex->value) != 0) {
-        const int locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    if (!_cas(&mutex->value, unlocked, locked_uncontended, memory_order_acquire)) {
+        if (mtype == MUTEX_TYPE_BITS_ADAPTIVE &&
+            _adaptive_spin(mutex, unlocked, locked_uncontended)) {
+            return;
+        }
+        const int locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
         /*
          * We want to go to sleep until the mutex is available, which
          * requires promoting it to state 2 (CONTENDED). We need to
          * swap in the new state value and then wait until somebody wakes us up.
          *
-         * __bionic_swap() returns the previous value.  We swap 2 in and
+         * _swap() returns the previous value.  We swap 2 in and
          * see if we got zero back; if so, we have acquired the lock.  If
          * not, another thread still holds the lock and we wait again.
          *
@@ -333,42 +919,29 @@ static inline void _normal_lock(pthread_mutex_t* mutex, int shared) {
          * that the mutex is in state 2 when we go to sleep on it, which
          * guarantees a wake-up call.
          */
-        while (__bionic_swap(locked_contended, &mutex->value) != unlocked) {
-            __futex_wait_ex(&mutex->value, shared, locked_contended, NULL);
+        if (_swap(&mutex->value, locked_contended, memory_order_acquire) != unlocked) {
+            void* sample = _contention_begin(mutex, 0);
+            do {
+                __futex_wait_ex(&mutex->value, shared, locked_contended, NULL);
+            } while (_swap(&mutex->value, locked_contended, memory_order_acquire) != unlocked);
+            _contention_end(sample);
         }
     }
-    ANDROID_MEMBAR_FULL();
 }
 
 /*
  * Release a non-recursive mutex.  The caller is responsible for determining
  * that we are in fact the owner of this lock.
  */
-static inline void _normal_unlock(pthread_mutex_t* mutex, int shared) {
-    ANDROID_MEMBAR_FULL();
+static inline void _normal_unlock(pthread_mutex_t* mutex, int shared, int mtype) {
+    const int unlocked         = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const int locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     /*
-     * The mutex state will be 1 or (rarely) 2.  We use an atomic decrement
-     * to release the lock.  __bionic_atomic_dec() returns the previous value;
-     * if it wasn't 1 we have to do some additional work.
+     * The mutex state will be 1 or (rarely) 2.  We release the lock by
+     * swapping in 0, which also tells us whether it was contended.
      */
-    if (__bionic_atomic_dec(&mutex->value) != (shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED)) {
-        /*
-         * Start by releasing the lock.  The decrement changed it from
-         * "contended lock" to "uncontended lock", which means we still
-         * hold it, and anybody who tries to sneak in will push it back
-         * to state 2.
-         *
-         * Once we set it to zero the lock is up for grabs.  We follow
-         * this with a __futex_wake() to ensure that one of the waiting
-         * threads has a chance to grab it.
-         *
-         * This doesn't cause a race with the swap/wait pair in
-         * _normal_lock(), because the __futex_wait() call there will
-         * return immediately if the mutex value isn't 2.
-         */
-        mutex->value = shared;
-
+    if (_swap(&mutex->value, unlocked, memory_order_release) == locked_contended) {
         /*
          * Wake up one waiting thread.  We don't know which thread will be
          * woken or when it'll start executing -- futexes make no guarantees
@@ -381,14 +954,18 @@ static inline void _normal_unlock(pthread_mutex_t* mutex, int shared) {
          * anyone without requiring us to track the number of sleepers.
          *
          * It's possible for another thread to sneak in and grab the lock
-         * between the zero assignment above and the wake call below.  If
-         * the new thread is "slow" and holds the lock for a while, we'll
+         * between the swap above and the wake call below.  If the new
+         * thread is "slow" and holds the lock for a while, we'll
          * wake up a sleeper, which will swap in a 2 and then go back to
          * sleep since the lock is still held.  If the new thread is "fast",
          * running to completion before we call wake, the thread we
          * eventually wake will find an unlocked mutex and will execute.
          * Either way we have correct behavior and nobody is orphaned on
          * the wait queue.
+         *
+         * This doesn't cause a race with the swap/wait pair in
+         * _normal_lock(), because the __futex_wait() call there will
+         * return immediately if the mutex value isn't 2.
          */
         __futex_wake_ex(&mutex->value, shared, 1);
     }
@@ -399,8 +976,7 @@ static inline void _normal_unlock(pthread_mutex_t* mutex, int shared) {
  *
  * For errorcheck mutexes, it will return EDEADLK
  * If the counter overflows, it will return EAGAIN
- * Otherwise, it atomically increments the counter and returns 0
- * after providing an acquire barrier.
+ * Otherwise, it atomically increments the counter and returns 0.
  *
  * mtype is the current mutex type
  * mvalue is the current mutex value (already loaded)
@@ -427,7 +1003,7 @@ static inline __always_inline int _recursive_increment(pthread_mutex_t* mutex, i
     for (;;) {
         /* increment counter, overflow was already checked */
         int newval = mvalue + MUTEX_COUNTER_BITS_ONE;
-        if (__predict_true(__bionic_cmpxchg(mvalue, newval, &mutex->value) == 0)) {
+        if (__predict_true(_cas(&mutex->value, mvalue, newval, memory_order_relaxed))) {
             /* mutex is still locked, not need for a memory barrier */
             return 0;
         }
@@ -453,8 +1029,11 @@ int pthread_mutex_lock(pthread_mutex_t* mutex) {
     shared = (mvalue & MUTEX_SHARED_MASK);
 
     /* Handle non-recursive case first */
-    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) ) {
-        _normal_lock(mutex, shared);
+    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL || mtype == MUTEX_TYPE_BITS_ADAPTIVE) ) {
+        if (__predict_false(MUTEX_BITS_ARE_PI(mvalue))) {
+            return _pi_lock(mutex, shared, NULL, CLOCK_REALTIME);
+        }
+        _normal_lock(mutex, shared, mtype);
         return 0;
     }
 
@@ -471,14 +1050,15 @@ int pthread_mutex_lock(pthread_mutex_t* mutex) {
      * indicate locked with no contention */
     if (mvalue == mtype) {
         int newval = MUTEX_OWNER_TO_BITS(tid) | mtype | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
-        if (__bionic_cmpxchg(mvalue, newval, &mutex->value) == 0) {
-            ANDROID_MEMBAR_FULL();
+        if (_cas(&mutex->value, mvalue, newval, memory_order_acquire)) {
             return 0;
         }
         /* argh, the value changed, reload before entering the loop */
         mvalue = mutex->value;
     }
 
+    void* sample = NULL;
+    bool waited = false;
     for (;;) {
         int newval;
 
@@ -490,15 +1070,11 @@ int pthread_mutex_lock(pthread_mutex_t* mutex) {
          */
         if (mvalue == mtype) {
             newval = MUTEX_OWNER_TO_BITS(tid) | mtype | MUTEX_STATE_BITS_LOCKED_CONTENDED;
-            /* TODO: Change this to __bionic_cmpxchg_acquire when we
-             *        implement it to get rid of the explicit memory
-             *        barrier below.
-             */
-            if (__predict_false(__bionic_cmpxchg(mvalue, newval, &mutex->value) != 0)) {
+            if (__predict_false(!_cas(&mutex->value, mvalue, newval, memory_order_acquire))) {
                 mvalue = mutex->value;
                 continue;
             }
-            ANDROID_MEMBAR_FULL();
+            _contention_end(sample);
             return 0;
         }
 
@@ -506,7 +1082,7 @@ int pthread_mutex_lock(pthread_mutex_t* mutex) {
          * we will change it to 2 to indicate contention. */
         if (MUTEX_STATE_BITS_IS_LOCKED_UNCONTENDED(mvalue)) {
             newval = MUTEX_STATE_BITS_FLIP_CONTENTION(mvalue); /* locked state 1 => state 2 */
-            if (__predict_false(__bionic_cmpxchg(mvalue, newval, &mutex->value) != 0)) {
+            if (__predict_false(!_cas(&mutex->value, mvalue, newval, memory_order_relaxed))) {
                 mvalue = mutex->value;
                 continue;
             }
@@ -514,6 +1090,10 @@ int pthread_mutex_lock(pthread_mutex_t* mutex) {
         }
 
         /* wait until the mutex is unlocked */
+        if (!waited) {
+            sample = _contention_begin(mutex, MUTEX_OWNER_FROM_BITS(mvalue));
+            waited = true;
+        }
         __futex_wait_ex(&mutex->value, shared, mvalue, NULL);
 
         mvalue = mutex->value;
@@ -535,8 +1115,11 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex) {
     shared = (mvalue & MUTEX_SHARED_MASK);
 
     /* Handle common case first */
-    if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        _normal_unlock(mutex, shared);
+    if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL || mtype == MUTEX_TYPE_BITS_ADAPTIVE)) {
+        if (__predict_false(MUTEX_BITS_ARE_PI(mvalue))) {
+            return _pi_unlock(mutex, shared);
+        }
+        _normal_unlock(mutex, shared, mtype);
         return 0;
     }
 
@@ -552,7 +1135,7 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex) {
     if (!MUTEX_COUNTER_BITS_IS_ZERO(mvalue)) {
         for (;;) {
             int newval = mvalue - MUTEX_COUNTER_BITS_ONE;
-            if (__predict_true(__bionic_cmpxchg(mvalue, newval, &mutex->value) == 0)) {
+            if (__predict_true(_cas(&mutex->value, mvalue, newval, memory_order_relaxed))) {
                 /* success: we still own the mutex, so no memory barrier */
                 return 0;
             }
@@ -565,12 +1148,8 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex) {
      * its value to 'unlocked'. We need to perform a swap in order
      * to read the current state, which will be 2 if there are waiters
      * to awake.
-     *
-     * TODO: Change this to __bionic_swap_release when we implement it
-     *        to get rid of the explicit memory barrier below.
      */
-    ANDROID_MEMBAR_FULL();  /* RELEASE BARRIER */
-    mvalue = __bionic_swap(mtype | shared | MUTEX_STATE_BITS_UNLOCKED, &mutex->value);
+    mvalue = _swap(&mutex->value, mtype | shared | MUTEX_STATE_BITS_UNLOCKED, memory_order_release);
 
     /* Wake one waiting thread, if any */
     if (MUTEX_STATE_BITS_IS_LOCKED_CONTENDED(mvalue)) {
@@ -587,12 +1166,13 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex) {
     shared = (mvalue & MUTEX_SHARED_MASK);
 
     /* Handle common case first */
-    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) )
+    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL || mtype == MUTEX_TYPE_BITS_ADAPTIVE) )
     {
-        if (__bionic_cmpxchg(shared|MUTEX_STATE_BITS_UNLOCKED,
-                             shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED,
-                             &mutex->value) == 0) {
-            ANDROID_MEMBAR_FULL();
+        if (__predict_false(MUTEX_BITS_ARE_PI(mvalue))) {
+            return _pi_trylock(mutex, shared);
+        }
+        if (_cas(&mutex->value, mtype|shared|MUTEX_STATE_BITS_UNLOCKED,
+                 mtype|shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED, memory_order_acquire)) {
             return 0;
         }
 
@@ -611,8 +1191,7 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex) {
     mtype |= shared | MUTEX_STATE_BITS_UNLOCKED;
     mvalue = MUTEX_OWNER_TO_BITS(tid) | mtype | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
 
-    if (__predict_true(__bionic_cmpxchg(mtype, mvalue, &mutex->value) == 0)) {
-        ANDROID_MEMBAR_FULL();
+    if (__predict_true(_cas(&mutex->value, mtype, mvalue, memory_order_acquire))) {
         return 0;
     }
 
@@ -627,25 +1206,31 @@ static int __pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs
   int shared = (mvalue & MUTEX_SHARED_MASK);
 
   // Handle common case first.
-  if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-    const int unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const int locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
-    const int locked_contended   = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+  if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL || mtype == MUTEX_TYPE_BITS_ADAPTIVE)) {
+    if (__predict_false(MUTEX_BITS_ARE_PI(mvalue))) {
+      return _pi_lock(mutex, shared, abs_timeout, clock);
+    }
+
+    const int unlocked           = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const int locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+    const int locked_contended   = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     // Fast path for uncontended lock. Note: MUTEX_TYPE_BITS_NORMAL is 0.
-    if (__bionic_cmpxchg(unlocked, locked_uncontended, &mutex->value) == 0) {
-      ANDROID_MEMBAR_FULL();
+    if (_cas(&mutex->value, unlocked, locked_uncontended, memory_order_acquire)) {
+      return 0;
+    }
+
+    if (mtype == MUTEX_TYPE_BITS_ADAPTIVE && _adaptive_spin(mutex, unlocked, locked_uncontended)) {
       return 0;
     }
 
     // Loop while needed.
-    while (__bionic_swap(locked_contended, &mutex->value) != unlocked) {
+    while (_swap(&mutex->value, locked_contended, memory_order_acquire) != unlocked) {
       if (__timespec_from_absolute(&ts, abs_timeout, clock) < 0) {
         return ETIMEDOUT;
       }
       __futex_wait_ex(&mutex->value, shared, locked_contended, &ts);
     }
-    ANDROID_MEMBAR_FULL();
     return 0;
   }
 
@@ -663,8 +1248,7 @@ static int __pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs
   // First try a quick lock.
   if (mvalue == mtype) {
     mvalue = MUTEX_OWNER_TO_BITS(tid) | mtype | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
-    if (__predict_true(__bionic_cmpxchg(mtype, mvalue, &mutex->value) == 0)) {
-      ANDROID_MEMBAR_FULL();
+    if (__predict_true(_cas(&mutex->value, mtype, mvalue, memory_order_acquire))) {
       return 0;
     }
     mvalue = mutex->value;
@@ -675,8 +1259,7 @@ static int __pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs
     // NOTE: put state to 2 since we know there is contention.
     if (mvalue == mtype) { // Unlocked.
       mvalue = MUTEX_OWNER_TO_BITS(tid) | mtype | MUTEX_STATE_BITS_LOCKED_CONTENDED;
-      if (__bionic_cmpxchg(mtype, mvalue, &mutex->value) == 0) {
-        ANDROID_MEMBAR_FULL();
+      if (_cas(&mutex->value, mtype, mvalue, memory_order_acquire)) {
         return 0;
       }
       // The value changed before we could lock it. We need to check
@@ -693,7 +1276,7 @@ static int __pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs
     // to 'contented' to ensure we get woken up later.
     if (MUTEX_STATE_BITS_IS_LOCKED_UNCONTENDED(mvalue)) {
       int newval = MUTEX_STATE_BITS_FLIP_CONTENTION(mvalue);
-      if (__bionic_cmpxchg(mvalue, newval, &mutex->value) != 0) {
+      if (!_cas(&mutex->value, mvalue, newval, memory_order_relaxed)) {
         // This failed because the value changed, reload it.
         mvalue = mutex->value;
       } else {
@@ -739,6 +1322,23 @@ extern "C" int pthread_mutex_lock_timeout_np(pthread_mutex_t* mutex, unsigned ms
 }
 #endif
 
+bool __pthread_mutex_can_requeue_to(const pthread_mutex_t* mutex, bool shared) {
+  int mvalue = mutex->value;
+  if (MUTEX_BITS_ARE_PI(mvalue)) {
+    return false;
+  }
+  return ((mvalue & MUTEX_SHARED_MASK) != 0) == shared;
+}
+
+void __pthread_mutex_mark_contended(pthread_mutex_t* mutex) {
+  // Other threads can only move a held mutex from uncontended to contended,
+  // so if the cmpxchg fails, someone else did it for us.
+  int mvalue = mutex->value;
+  if (MUTEX_STATE_BITS_IS_LOCKED_UNCONTENDED(mvalue)) {
+    _cas(&mutex->value, mvalue, MUTEX_STATE_BITS_FLIP_CONTENTION(mvalue), memory_order_relaxed);
+  }
+}
+
 int pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs_timeout) {
   return __pthread_mutex_timedlock(mutex, abs_timeout, CLOCK_REALTIME);
 }
@@ -746,9 +1346,32 @@ int pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* abs_timeout)
 int pthread_mutex_destroy(pthread_mutex_t* mutex) {
   // Use trylock to ensure that the mutex is valid and not already locked.
   int error = pthread_mutex_trylock(mutex);
-  if (error != 0) {
+  // A robust mutex nobody can take any more is as good as unlocked.
+  if (error != 0 && error != ENOTRECOVERABLE) {
     return error;
   }
+  if (MUTEX_BITS_ARE_PI(mutex->value)) {
+    // A robust mutex mustn't be left on our robust list.
+    if (error == 0) {
+      _pi_unlock(mutex, mutex->value & MUTEX_SHARED_MASK);
+    }
+#if !defined(__LP64__)
+    _pi_mutex_free_id(MUTEX_OWNER_FROM_BITS(mutex->value));
+#endif
+  }
   mutex->value = 0xdead10cc;
   return 0;
 }
+
+int pthread_mutex_consistent(pthread_mutex_t* mutex) {
+  if (!MUTEX_BITS_ARE_PI(mutex->value)) {
+    return EINVAL;
+  }
+  pi_mutex_t* pi = _pi_mutex(mutex);
+  if ((pi->flags & PI_MUTEX_FLAG_INCONSISTENT) == 0 ||
+      (pi->owner & FUTEX_TID_MASK) != __get_thread()->tid) {
+    return EINVAL;
+  }
+  pi->flags &= ~PI_MUTEX_FLAG_INCONSISTENT;
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#if defined(LIBC_STATIC)
+#error pthread_mutex_contention.cpp should NOT be included in static libc builds.
+#endif
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/system_properties.h>
+
+#include "pthread_mutex_contention.h"
+#include "private/libc_logging.h"
+
+// Opt-in profiling of contended pthread_mutex_lock calls.
+//
+// Setting libc.debug.mutex_contention (or LIBC_DEBUG_MUTEX_CONTENTION in the
+// environment) to N records one in every N waits on a contended mutex. The
+// waits are aggregated per mutex address along with the longest wait's
+// backtrace and owner, and the table is logged when the process exits or
+// written on demand by dump_mutex_contention_info. As with malloc debugging,
+// libc.debug.mutex_contention.program restricts this to matching processes.
+
+static void* g_mutex_contention_handle;
+
+static void mutex_contention_init_impl() {
+  char value[PROP_VALUE_MAX];
+  const char* interval = getenv("LIBC_DEBUG_MUTEX_CONTENTION");
+  if (interval == NULL) {
+    if (!__system_property_get("libc.debug.mutex_contention", value)) {
+      return;
+    }
+    interval = value;
+  }
+  unsigned sample_interval = strtoul(interval, NULL, 0);
+  if (sample_interval == 0) {
+    return;
+  }
+
+  if (__system_property_get("libc.debug.mutex_contention.program", value) &&
+      strstr(getprogname(), value) == NULL) {
+    return;
+  }
+
+  void* handle = dlopen("libc_malloc_debug_leak.so", RTLD_NOW);
+  if (handle == NULL) {
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "%s: Missing module libc_malloc_debug_leak.so required for mutex contention "
+                      "profiling: %s", getprogname(), dlerror());
+    return;
+  }
+
+  MutexContentionInit mutex_contention_initialize =
+      reinterpret_cast<MutexContentionInit>(dlsym(handle, "mutex_contention_initialize"));
+  const MutexContentionDispatch* dispatch = NULL;
+  if (mutex_contention_initialize != NULL) {
+    dispatch = mutex_contention_initialize(sample_interval);
+  }
+  if (dispatch == NULL) {
+    __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                      "%s: Unable to initialize mutex contention profiling", getprogname());
+    dlclose(handle);
+    return;
+  }
+
+  g_mutex_contention_handle = handle;
+  g_mutex_contention_dispatch = dispatch;
+}
+
+extern "C" __LIBC_HIDDEN__ void mutex_contention_init() {
+  static pthread_once_t mutex_contention_init_once = PTHREAD_ONCE_INIT;
+  pthread_once(&mutex_contention_init_once, mutex_contention_init_impl);
+}
+
+extern "C" __LIBC_HIDDEN__ void mutex_contention_fini() {
+  // The module stays loaded: other threads may still be in the hooks.
+  if (g_mutex_contention_handle != NULL) {
+    g_mutex_contention_dispatch->dump(-1);
+  }
+}
+
+// =============================================================================
+// Exported for use by debugging tools.
+// =============================================================================
+extern "C" void dump_mutex_contention_info(int fd) {
+  if (g_mutex_contention_dispatch != NULL) {
+    g_mutex_contention_dispatch->dump(fd);
+  }
+}
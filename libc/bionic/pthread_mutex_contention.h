@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Contains declarations shared by the mutex contention profiler hooks in
+ * libc and the profiler itself in libc_malloc_debug_leak.so.
+ */
+#ifndef PTHREAD_MUTEX_CONTENTION_H
+#define PTHREAD_MUTEX_CONTENTION_H
+
+#include <pthread.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+struct MutexContentionDispatch {
+  // Called just before pthread_mutex_lock goes to sleep on a contended mutex
+  // for the first time. owner_tid is 0 if the mutex type doesn't record its
+  // owner. Returns NULL if this wait isn't being sampled.
+  void* (*begin)(pthread_mutex_t* mutex, pid_t owner_tid);
+
+  // Called once the mutex has been acquired, with the result of begin.
+  void (*end)(void* sample);
+
+  // Writes the per-mutex table to fd, or to the log if fd is negative.
+  void (*dump)(int fd);
+};
+
+// Profiler entry point looked up by libc when libc.debug.mutex_contention is
+// set. Returns NULL if the profiler couldn't be initialized.
+typedef const MutexContentionDispatch* (*MutexContentionInit)(unsigned sample_interval);
+
+// Set once during libc initialization, before any other thread exists.
+__LIBC_HIDDEN__ extern const MutexContentionDispatch* g_mutex_contention_dispatch;
+
+#endif  // PTHREAD_MUTEX_CONTENTION_H
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// Mutex contention profiler (libc.debug.mutex_contention).
+//
+// libc calls mutex_contention_begin before it first sleeps on a contended
+// mutex and mutex_contention_end once it has the mutex. One in every
+// sample_interval such waits is timed and recorded. The backtrace is taken
+// before sleeping, while the caller doesn't yet hold the mutex, because the
+// unwinder may need other locks. Samples are aggregated per mutex address in
+// a fixed-size table so that nothing here needs to allocate.
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug_stacktrace.h"
+#include "malloc_debug_disable.h"
+#include "pthread_mutex_contention.h"
+
+#include "private/libc_logging.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+#define MUTEX_CONTENTION_BACKTRACE_SIZE 16
+
+// Number of waits that can be in flight at once; further waits go unrecorded.
+#define MUTEX_CONTENTION_SAMPLE_COUNT 64
+
+// Number of distinct mutexes tracked. Must be a power of two.
+#define MUTEX_CONTENTION_TABLE_SIZE 1024
+
+struct ContentionSample {
+  atomic_bool in_use;
+  pthread_mutex_t* mutex;
+  pid_t owner_tid;
+  uint64_t start_ns;
+  size_t frame_count;
+  uintptr_t frames[MUTEX_CONTENTION_BACKTRACE_SIZE];
+};
+
+struct ContentionEntry {
+  pthread_mutex_t* mutex;
+  uint64_t wait_count;
+  uint64_t total_wait_ns;
+  uint64_t max_wait_ns;
+  // The owner and backtrace of the longest wait.
+  pid_t max_wait_owner_tid;
+  size_t frame_count;
+  uintptr_t frames[MUTEX_CONTENTION_BACKTRACE_SIZE];
+};
+
+static unsigned g_sample_interval;
+static atomic_uint g_contended_waits;
+static ContentionSample g_samples[MUTEX_CONTENTION_SAMPLE_COUNT];
+
+static pthread_mutex_t g_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static ContentionEntry g_table[MUTEX_CONTENTION_TABLE_SIZE];
+static size_t g_table_count;
+static uint64_t g_dropped_count;
+
+static uint64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static ContentionEntry* find_entry_locked(pthread_mutex_t* mutex) {
+  uintptr_t hash = (reinterpret_cast<uintptr_t>(mutex) >> 2) * 2654435761u;
+  for (size_t i = 0; i < MUTEX_CONTENTION_TABLE_SIZE; ++i) {
+    ContentionEntry* entry = &g_table[(hash + i) & (MUTEX_CONTENTION_TABLE_SIZE - 1)];
+    if (entry->mutex == mutex) {
+      return entry;
+    }
+    if (entry->mutex == NULL) {
+      // Keep a few free slots so that probe sequences stay short.
+      if (g_table_count >= MUTEX_CONTENTION_TABLE_SIZE - MUTEX_CONTENTION_TABLE_SIZE / 8) {
+        return NULL;
+      }
+      entry->mutex = mutex;
+      ++g_table_count;
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void* mutex_contention_begin(pthread_mutex_t* mutex, pid_t owner_tid) {
+  unsigned wait = atomic_fetch_add_explicit(&g_contended_waits, 1, memory_order_relaxed);
+  if ((wait % g_sample_interval) != 0) {
+    return NULL;
+  }
+  // Don't record contention on the locks taken by the profiler itself, or by
+  // the unwinder on its behalf.
+  if (DebugCallsDisabled()) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < MUTEX_CONTENTION_SAMPLE_COUNT; ++i) {
+    ContentionSample* sample = &g_samples[i];
+    if (!atomic_load_explicit(&sample->in_use, memory_order_relaxed) &&
+        !atomic_exchange_explicit(&sample->in_use, true, memory_order_acquire)) {
+      ScopedDisableDebugCalls disable;
+      sample->mutex = mutex;
+      sample->owner_tid = owner_tid;
+      sample->frame_count = get_backtrace(sample->frames, MUTEX_CONTENTION_BACKTRACE_SIZE);
+      // Start the clock after unwinding so that its cost isn't counted.
+      sample->start_ns = now_ns();
+      return sample;
+    }
+  }
+  return NULL;
+}
+
+static void mutex_contention_end(void* arg) {
+  ContentionSample* sample = static_cast<ContentionSample*>(arg);
+  uint64_t wait_ns = now_ns() - sample->start_ns;
+
+  {
+    ScopedDisableDebugCalls disable;
+    ScopedPthreadMutexLocker locker(&g_table_lock);
+
+    ContentionEntry* entry = find_entry_locked(sample->mutex);
+    if (entry == NULL) {
+      ++g_dropped_count;
+    } else {
+      ++entry->wait_count;
+      entry->total_wait_ns += wait_ns;
+      if (wait_ns >= entry->max_wait_ns) {
+        entry->max_wait_ns = wait_ns;
+        entry->max_wait_owner_tid = sample->owner_tid;
+        entry->frame_count = sample->frame_count;
+        memcpy(entry->frames, sample->frames, sample->frame_count * sizeof(uintptr_t));
+      }
+    }
+  }
+
+  atomic_store_explicit(&sample->in_use, false, memory_order_release);
+}
+
+static int entry_compare(const void* lhs, const void* rhs) {
+  const ContentionEntry* e1 = *static_cast<ContentionEntry* const*>(lhs);
+  const ContentionEntry* e2 = *static_cast<ContentionEntry* const*>(rhs);
+  // Worst offenders first.
+  if (e1->total_wait_ns != e2->total_wait_ns) {
+    return (e1->total_wait_ns > e2->total_wait_ns) ? -1 : 1;
+  }
+  return 0;
+}
+
+#define dump_printf(fd, ...) \
+    (((fd) < 0) ? __libc_format_log(ANDROID_LOG_INFO, "libc", __VA_ARGS__) \
+                : __libc_format_fd((fd), __VA_ARGS__))
+
+static void mutex_contention_dump(int fd) {
+  ScopedDisableDebugCalls disable;
+  ScopedPthreadMutexLocker locker(&g_table_lock);
+
+  static ContentionEntry* sorted[MUTEX_CONTENTION_TABLE_SIZE];
+  size_t count = 0;
+  for (size_t i = 0; i < MUTEX_CONTENTION_TABLE_SIZE; ++i) {
+    if (g_table[i].mutex != NULL) {
+      sorted[count++] = &g_table[i];
+    }
+  }
+  qsort(sorted, count, sizeof(ContentionEntry*), entry_compare);
+
+  dump_printf(fd, "%s: mutex contention, 1 in %u contended waits sampled, %u waits, "
+              "%zu mutexes, %" PRIu64 " samples dropped\n",
+              getprogname(), g_sample_interval,
+              atomic_load_explicit(&g_contended_waits, memory_order_relaxed),
+              count, g_dropped_count);
+  for (size_t i = 0; i < count; ++i) {
+    const ContentionEntry* entry = sorted[i];
+    dump_printf(fd, "  mutex %p: %" PRIu64 " waits, total %" PRIu64 " us, max %" PRIu64
+                " us (owner tid %d)\n",
+                entry->mutex, entry->wait_count, entry->total_wait_ns / 1000,
+                entry->max_wait_ns / 1000, entry->max_wait_owner_tid);
+    for (size_t j = 0; j < entry->frame_count; ++j) {
+      Dl_info info;
+      if (dladdr(reinterpret_cast<void*>(entry->frames[j]), &info) != 0 &&
+          info.dli_sname != NULL) {
+        dump_printf(fd, "    #%02zu  pc %" PRIxPTR "  %s (%s+%" PRIuPTR ")\n",
+                    j, entry->frames[j], info.dli_fname, info.dli_sname,
+                    entry->frames[j] - reinterpret_cast<uintptr_t>(info.dli_saddr));
+      } else {
+        dump_printf(fd, "    #%02zu  pc %" PRIxPTR "\n", j, entry->frames[j]);
+      }
+    }
+  }
+}
+
+static const MutexContentionDispatch g_mutex_contention_hooks = {
+  mutex_contention_begin,
+  mutex_contention_end,
+  mutex_contention_dump,
+};
+
+extern "C" const MutexContentionDispatch* mutex_contention_initialize(unsigned sample_interval) {
+  g_sample_interval = sample_interval;
+  debug_calls_init();
+  __libc_format_log(ANDROID_LOG_INFO, "libc",
+                    "%s: profiling mutex contention, sampling 1 in %u contended waits\n",
+                    getprogname(), sample_interval);
+  return &g_mutex_contention_hooks;
+}
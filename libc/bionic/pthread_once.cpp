@@ -27,74 +27,76 @@
  */
 
 #include <pthread.h>
+#include <stdatomic.h>
 
-#include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 
 #define ONCE_INITIALIZING           (1 << 0)
 #define ONCE_COMPLETED              (1 << 1)
+#define ONCE_WAITERS                (1 << 2)
 
 /* NOTE: this implementation doesn't support a init function that throws a C++ exception
  *       or calls fork()
  */
 int pthread_once(pthread_once_t* once_control, void (*init_routine)(void)) {
-  volatile pthread_once_t* once_control_ptr = once_control;
+  static_assert(sizeof(atomic_int) == sizeof(pthread_once_t),
+                "pthread_once_t should actually be atomic_int in implementation.");
+
+  // pthread_once_t can't be atomic_int in the public header without
+  // dragging <stdatomic.h> into <pthread.h>, so cast here instead.
+  volatile atomic_int* once_control_ptr = reinterpret_cast<volatile atomic_int*>(once_control);
 
   // PTHREAD_ONCE_INIT is 0, we use the following bit flags
   //   bit 0 set  -> initialization is under way
   //   bit 1 set  -> initialization is complete
+  //   bit 2 set  -> someone is waiting for the initialization to complete
 
   // First check if the once is already initialized. This will be the common
-  // case and we want to make this as fast as possible. Note that this still
-  // requires a load_acquire operation here to ensure that all the
-  // stores performed by the initialization function are observable on
-  // this CPU after we exit.
-  if (__predict_true((*once_control_ptr & ONCE_COMPLETED) != 0)) {
-    ANDROID_MEMBAR_FULL();
-    return 0;
-  }
+  // case and we want to make this as fast as possible. The acquire load
+  // ensures that all the stores performed by the initialization function
+  // are observable on this CPU after we exit.
+  int old_value = atomic_load_explicit(once_control_ptr, memory_order_acquire);
 
   while (true) {
-    // Try to atomically set the INITIALIZING flag.
-    // This requires a cmpxchg loop, and we may need
-    // to exit prematurely if we detect that
-    // COMPLETED is now set.
-    int32_t  old_value, new_value;
+    if (__predict_true(old_value == ONCE_COMPLETED)) {
+      return 0;
+    }
 
-    do {
-      old_value = *once_control_ptr;
-      if ((old_value & ONCE_COMPLETED) != 0) {
-        break;
+    if (old_value == 0) {
+      // Try to claim the initialization. If this fails, old_value has been
+      // refreshed and we go round again.
+      if (!atomic_compare_exchange_weak_explicit(once_control_ptr, &old_value,
+                                                 ONCE_INITIALIZING,
+                                                 memory_order_acquire,
+                                                 memory_order_acquire)) {
+        continue;
       }
 
-      new_value = old_value | ONCE_INITIALIZING;
-    } while (__bionic_cmpxchg(old_value, new_value, once_control_ptr) != 0);
+      // We got there first, so call the initialization function.
+      (*init_routine)();
 
-    if ((old_value & ONCE_COMPLETED) != 0) {
-      // We detected that COMPLETED was set while in our loop.
-      ANDROID_MEMBAR_FULL();
+      // Publish its stores, and only pay for the wake syscall if someone
+      // actually went to sleep waiting for us.
+      old_value = atomic_exchange_explicit(once_control_ptr, ONCE_COMPLETED, memory_order_release);
+      if ((old_value & ONCE_WAITERS) != 0) {
+        __futex_wake_ex(once_control_ptr, 0, INT_MAX);
+      }
       return 0;
     }
 
-    if ((old_value & ONCE_INITIALIZING) == 0) {
-      // We got there first, we can jump out of the loop to handle the initialization.
-      break;
+    // Another thread is running the initialization. Tell it that it will
+    // have to wake us before we go to sleep.
+    if ((old_value & ONCE_WAITERS) == 0) {
+      if (!atomic_compare_exchange_weak_explicit(once_control_ptr, &old_value,
+                                                 old_value | ONCE_WAITERS,
+                                                 memory_order_acquire,
+                                                 memory_order_acquire)) {
+        continue;
+      }
+      old_value |= ONCE_WAITERS;
     }
 
-    // Another thread is running the initialization and hasn't completed
-    // yet, so wait for it, then try again.
     __futex_wait_ex(once_control_ptr, 0, old_value, NULL);
+    old_value = atomic_load_explicit(once_control_ptr, memory_order_acquire);
   }
-
-  // Call the initialization function.
-  (*init_routine)();
-
-  // Do a store_release indicating that initialization is complete.
-  ANDROID_MEMBAR_FULL();
-  *once_control_ptr = ONCE_COMPLETED;
-
-  // Wake up any waiters, if any.
-  __futex_wake_ex(once_control_ptr, 0, INT_MAX);
-
-  return 0;
 }
@@ -51,22 +51,62 @@
  *  - This implementation will return EDEADLK in "write after write" and "read after
  *    write" cases and will deadlock in write after read case.
  *
+ * The whole lock state is the single word 'state':
+ *
+ * bits:     name             description
+ * 31-3      readers          number of readers holding the lock
+ * 2         pending writers  a writer may be waiting on writer_wakeup_serial
+ * 1         pending readers  readers may be waiting on reader_wakeup_serial
+ * 0         writer           the lock is held by a writer
+ *
+ * so taking or dropping an uncontended lock is a single compare-and-swap.
+ * Readers and writers wait on separate futexes, which lets an unlock wake
+ * just the threads it's letting in: all the readers, or a single writer.
+ * A waiter reads its wakeup serial before setting its pending bit, and the
+ * unlock that clears the bit bumps the serial before waking, so a waiter
+ * can't miss the wakeup meant for it.
+ *
+ * pending_readers and pending_writers count the waiters, which lets the
+ * unlock that wakes one writer leave the pending writers bit set for the
+ * others.
+ *
+ * When both readers and writers are waiting, the kind chosen with
+ * pthread_rwlockattr_setkind_np decides who goes first. Readers are
+ * preferred by default. When writers are preferred, a new reader also waits
+ * while a writer is pending, so a thread that takes the read lock
+ * recursively can deadlock.
+ *
  * TODO: VERY CAREFULLY convert this to use C++11 atomics when possible. All volatile
  * members of pthread_rwlock_t should be converted to atomics<> and __sync_bool_compare_and_swap
  * should be changed to compare_exchange_strong accompanied by the proper ordering
- * constraints (comments have been added with the intending ordering across the code).
- *
- * TODO: As it stands now, pending_readers and pending_writers could be merged into a
- * a single waiters variable.  Keeping them separate adds a bit of clarity and keeps
- * the door open for a writer-biased implementation.
- *
+ * constraints.
  */
 
+#define STATE_WRITER_OWNED           0x1
+#define STATE_PENDING_READERS        0x2
+#define STATE_PENDING_WRITERS        0x4
+#define STATE_READER_COUNT_SHIFT     3
+#define STATE_READER_ONE             (1 << STATE_READER_COUNT_SHIFT)
+
+#define STATE_OWNERS_MASK            (STATE_WRITER_OWNED | ~(STATE_READER_ONE - 1))
+
 #define RWLOCKATTR_DEFAULT     0
+#define RWLOCKATTR_KIND_MASK   0x000f
 #define RWLOCKATTR_SHARED_MASK 0x0010
 
 static inline bool rwlock_is_shared(const pthread_rwlock_t* rwlock) {
-  return rwlock->attr == PTHREAD_PROCESS_SHARED;
+  return (rwlock->attr & RWLOCKATTR_SHARED_MASK) != 0;
+}
+
+static inline bool rwlock_prefers_writers(const pthread_rwlock_t* rwlock) {
+  return (rwlock->attr & RWLOCKATTR_KIND_MASK) == PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP;
+}
+
+static inline bool state_can_read(const pthread_rwlock_t* rwlock, int32_t state) {
+  if ((state & STATE_WRITER_OWNED) != 0) {
+    return false;
+  }
+  return !((state & STATE_PENDING_WRITERS) != 0 && rwlock_prefers_writers(rwlock));
 }
 
 static bool timespec_from_absolute(timespec* rel_timeout, const timespec* abs_timeout) {
@@ -79,7 +119,7 @@ static bool timespec_from_absolute(timespec* rel_timeout, const timespec* abs_ti
 }
 
 int pthread_rwlockattr_init(pthread_rwlockattr_t* attr) {
-  *attr = PTHREAD_PROCESS_PRIVATE;
+  *attr = RWLOCKATTR_DEFAULT;
   return 0;
 }
 
@@ -91,8 +131,10 @@ int pthread_rwlockattr_destroy(pthread_rwlockattr_t* attr) {
 int pthread_rwlockattr_setpshared(pthread_rwlockattr_t* attr, int pshared) {
   switch (pshared) {
     case PTHREAD_PROCESS_PRIVATE:
+      *attr &= ~RWLOCKATTR_SHARED_MASK;
+      return 0;
     case PTHREAD_PROCESS_SHARED:
-      *attr = pshared;
+      *attr |= RWLOCKATTR_SHARED_MASK;
       return 0;
     default:
       return EINVAL;
@@ -100,37 +142,97 @@ int pthread_rwlockattr_setpshared(pthread_rwlockattr_t* attr, int pshared) {
 }
 
 int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t* attr, int* pshared) {
-  *pshared = *attr;
+  *pshared = (*attr & RWLOCKATTR_SHARED_MASK) ? PTHREAD_PROCESS_SHARED : PTHREAD_PROCESS_PRIVATE;
+  return 0;
+}
+
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t* attr, int pref) {
+  switch (pref) {
+    case PTHREAD_RWLOCK_PREFER_READER_NP:
+    case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:
+      *attr = (*attr & ~RWLOCKATTR_KIND_MASK) | pref;
+      return 0;
+    default:
+      return EINVAL;
+  }
+}
+
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t* attr, int* pref) {
+  *pref = (*attr & RWLOCKATTR_KIND_MASK);
   return 0;
 }
 
 int pthread_rwlock_init(pthread_rwlock_t* rwlock, const pthread_rwlockattr_t* attr) {
+  rwlock->attr = RWLOCKATTR_DEFAULT;
   if (attr != NULL) {
-    switch (*attr) {
-      case PTHREAD_PROCESS_SHARED:
-      case PTHREAD_PROCESS_PRIVATE:
-        rwlock->attr= *attr;
-        break;
-      default:
-        return EINVAL;
+    if ((*attr & ~(RWLOCKATTR_KIND_MASK | RWLOCKATTR_SHARED_MASK)) != 0) {
+      return EINVAL;
     }
+    rwlock->attr = *attr;
   }
 
   rwlock->state = 0;
   rwlock->pending_readers = 0;
   rwlock->pending_writers = 0;
   rwlock->writer_thread_id = 0;
+  rwlock->reader_wakeup_serial = 0;
+  rwlock->writer_wakeup_serial = 0;
 
   return 0;
 }
 
 int pthread_rwlock_destroy(pthread_rwlock_t* rwlock) {
-  if (rwlock->state != 0) {
+  if ((rwlock->state & STATE_OWNERS_MASK) != 0) {
     return EBUSY;
   }
   return 0;
 }
 
+// Takes 'owner' (STATE_WRITER_OWNED, STATE_READER_ONE or 0) out of the
+// state and, if that leaves the lock unowned, wakes whoever goes next.
+// Passing 0 only does the wakeup, for a waiter giving up after it may have
+// been the one woken.
+static void __pthread_rwlock_release(pthread_rwlock_t* rwlock, int32_t owner) {
+  bool wake_readers;
+  bool wake_writer;
+  int32_t cur_state;
+  int32_t new_state;
+  do {
+    cur_state = rwlock->state;  // C++11 relaxed atomic read
+    new_state = cur_state - owner;
+    wake_readers = false;
+    wake_writer = false;
+    if (__predict_false((new_state & STATE_OWNERS_MASK) == 0 &&
+                        (new_state & (STATE_PENDING_READERS | STATE_PENDING_WRITERS)) != 0)) {
+      // The pending writers bit can outlive the writer that set it if that
+      // writer timed out, so only believe it while the count agrees.
+      int32_t pending_writers = rwlock->pending_writers;
+      if (pending_writers == 0) {
+        new_state &= ~STATE_PENDING_WRITERS;
+      }
+      if ((new_state & STATE_PENDING_WRITERS) != 0 &&
+          ((new_state & STATE_PENDING_READERS) == 0 || rwlock_prefers_writers(rwlock))) {
+        wake_writer = true;
+        // Leave the bit set if other writers are still waiting.
+        if (pending_writers == 1) {
+          new_state &= ~STATE_PENDING_WRITERS;
+        }
+      } else if ((new_state & STATE_PENDING_READERS) != 0) {
+        wake_readers = true;
+        new_state &= ~STATE_PENDING_READERS;
+      }
+    }
+  } while (!__sync_bool_compare_and_swap(&rwlock->state, cur_state, new_state));  // C++11 memory_order_release
+
+  if (wake_writer) {
+    __sync_fetch_and_add(&rwlock->writer_wakeup_serial, 1);
+    __futex_wake_ex(&rwlock->writer_wakeup_serial, rwlock_is_shared(rwlock), 1);
+  } else if (wake_readers) {
+    __sync_fetch_and_add(&rwlock->reader_wakeup_serial, 1);
+    __futex_wake_ex(&rwlock->reader_wakeup_serial, rwlock_is_shared(rwlock), INT_MAX);
+  }
+}
+
 static int __pthread_rwlock_timedrdlock(pthread_rwlock_t* rwlock, const timespec* abs_timeout) {
   if (__predict_false(__get_thread()->tid == rwlock->writer_thread_id)) {
     return EDEADLK;
@@ -138,32 +240,35 @@ static int __pthread_rwlock_timedrdlock(pthread_rwlock_t* rwlock, const timespec
 
   timespec ts;
   timespec* rel_timeout = (abs_timeout == NULL) ? NULL : &ts;
-  bool done = false;
-  do {
+  while (true) {
     // This is actually a race read as there's nothing that guarantees the atomicity of integer
     // reads / writes. However, in practice this "never" happens so until we switch to C++11 this
     // should work fine. The same applies in the other places this idiom is used.
     int32_t cur_state = rwlock->state;  // C++11 relaxed atomic read
-    if (__predict_true(cur_state >= 0)) {
+    if (__predict_true(state_can_read(rwlock, cur_state))) {
       // Add as an extra reader.
-      done = __sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state + 1);  // C++11 memory_order_aquire
-    } else {
-      if (!timespec_from_absolute(rel_timeout, abs_timeout)) {
-        return ETIMEDOUT;
-      }
-      // Owner holds it in write mode, hang up.
-      // To avoid losing wake ups the pending_readers update and the state read should be
-      // sequentially consistent. (currently enforced by __sync_fetch_and_add which creates a full barrier)
-      __sync_fetch_and_add(&rwlock->pending_readers, 1);  // C++11 memory_order_relaxed (if the futex_wait ensures the ordering)
-      int ret = __futex_wait_ex(&rwlock->state, rwlock_is_shared(rwlock), cur_state, rel_timeout);
-      __sync_fetch_and_sub(&rwlock->pending_readers, 1);  // C++11 memory_order_relaxed
-      if (ret == -ETIMEDOUT) {
-        return ETIMEDOUT;
+      if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state + STATE_READER_ONE)) {  // C++11 memory_order_acquire
+        return 0;
       }
+      continue;
     }
-  } while (!done);
 
-  return 0;
+    if (!timespec_from_absolute(rel_timeout, abs_timeout)) {
+      return ETIMEDOUT;
+    }
+    // Read the serial before the compare-and-swap that tells unlockers we're waiting.
+    int32_t serial = rwlock->reader_wakeup_serial;
+    __sync_fetch_and_add(&rwlock->pending_readers, 1);
+    int ret = 0;
+    if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state | STATE_PENDING_READERS)) {
+      ret = __futex_wait_ex(&rwlock->reader_wakeup_serial, rwlock_is_shared(rwlock), serial, rel_timeout);
+    }
+    __sync_fetch_and_sub(&rwlock->pending_readers, 1);
+    if (ret == -ETIMEDOUT) {
+      __pthread_rwlock_release(rwlock, 0);
+      return ETIMEDOUT;
+    }
+  }
 }
 
 static int __pthread_rwlock_timedwrlock(pthread_rwlock_t* rwlock, const timespec* abs_timeout) {
@@ -174,30 +279,33 @@ static int __pthread_rwlock_timedwrlock(pthread_rwlock_t* rwlock, const timespec
 
   timespec ts;
   timespec* rel_timeout = (abs_timeout == NULL) ? NULL : &ts;
-  bool done = false;
-  do {
-    int32_t cur_state = rwlock->state;
-    if (__predict_true(cur_state == 0)) {
-      // Change state from 0 to -1.
-      done =  __sync_bool_compare_and_swap(&rwlock->state, 0 /* cur state */, -1 /* new state */);  // C++11 memory_order_aquire
-    } else {
-      if (!timespec_from_absolute(rel_timeout, abs_timeout)) {
-        return ETIMEDOUT;
-      }
-      // Failed to acquire, hang up.
-      // To avoid losing wake ups the pending_writers update and the state read should be
-      // sequentially consistent. (currently enforced by __sync_fetch_and_add which creates a full barrier)
-      __sync_fetch_and_add(&rwlock->pending_writers, 1);  // C++11 memory_order_relaxed (if the futex_wait ensures the ordering)
-      int ret = __futex_wait_ex(&rwlock->state, rwlock_is_shared(rwlock), cur_state, rel_timeout);
-      __sync_fetch_and_sub(&rwlock->pending_writers, 1);  // C++11 memory_order_relaxed
-      if (ret == -ETIMEDOUT) {
-        return ETIMEDOUT;
+  while (true) {
+    int32_t cur_state = rwlock->state;  // C++11 relaxed atomic read
+    if (__predict_true((cur_state & STATE_OWNERS_MASK) == 0)) {
+      if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state | STATE_WRITER_OWNED)) {  // C++11 memory_order_acquire
+        rwlock->writer_thread_id = tid;
+        return 0;
       }
+      continue;
     }
-  } while (!done);
 
-  rwlock->writer_thread_id = tid;
-  return 0;
+    if (!timespec_from_absolute(rel_timeout, abs_timeout)) {
+      return ETIMEDOUT;
+    }
+    // Read the serial before the compare-and-swap that tells unlockers we're waiting.
+    int32_t serial = rwlock->writer_wakeup_serial;
+    __sync_fetch_and_add(&rwlock->pending_writers, 1);
+    int ret = 0;
+    if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state | STATE_PENDING_WRITERS)) {
+      ret = __futex_wait_ex(&rwlock->writer_wakeup_serial, rwlock_is_shared(rwlock), serial, rel_timeout);
+    }
+    __sync_fetch_and_sub(&rwlock->pending_writers, 1);
+    if (ret == -ETIMEDOUT) {
+      // If we were the writer an unlock chose to wake, pass that on.
+      __pthread_rwlock_release(rwlock, 0);
+      return ETIMEDOUT;
+    }
+  }
 }
 
 int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) {
@@ -210,9 +318,11 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t* rwlock, const timespec* abs_tim
 
 int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock) {
   int32_t cur_state = rwlock->state;
-  if ((cur_state >= 0) &&
-      __sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state + 1)) {  // C++11 memory_order_acquire
-    return 0;
+  while (state_can_read(rwlock, cur_state)) {
+    if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state + STATE_READER_ONE)) {  // C++11 memory_order_acquire
+      return 0;
+    }
+    cur_state = rwlock->state;
   }
   return EBUSY;
 }
@@ -228,53 +338,31 @@ int pthread_rwlock_timedwrlock(pthread_rwlock_t* rwlock, const timespec* abs_tim
 int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock) {
   int tid = __get_thread()->tid;
   int32_t cur_state = rwlock->state;
-  if ((cur_state == 0) &&
-      __sync_bool_compare_and_swap(&rwlock->state, 0 /* cur state */, -1 /* new state */)) {  // C++11 memory_order_acquire
-    rwlock->writer_thread_id = tid;
-    return 0;
+  while ((cur_state & STATE_OWNERS_MASK) == 0) {
+    if (__sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state | STATE_WRITER_OWNED)) {  // C++11 memory_order_acquire
+      rwlock->writer_thread_id = tid;
+      return 0;
+    }
+    cur_state = rwlock->state;
   }
   return EBUSY;
 }
 
 
 int pthread_rwlock_unlock(pthread_rwlock_t* rwlock) {
-  int tid = __get_thread()->tid;
-  bool done = false;
-  do {
-    int32_t cur_state = rwlock->state;
-    if (cur_state == 0) {
+  int32_t cur_state = rwlock->state;
+  if ((cur_state & STATE_WRITER_OWNED) != 0) {
+    if (rwlock->writer_thread_id != __get_thread()->tid) {
       return EPERM;
     }
-    if (cur_state == -1) {
-      if (rwlock->writer_thread_id != tid) {
-        return EPERM;
-      }
-      // We're no longer the owner.
-      rwlock->writer_thread_id = 0;
-      // Change state from -1 to 0.
-      // We use __sync_bool_compare_and_swap to achieve sequential consistency of the state store and
-      // the following pendingX loads. A simple store with memory_order_release semantics
-      // is not enough to guarantee that the pendingX loads are not reordered before the
-      // store (which may lead to a lost wakeup).
-      __sync_bool_compare_and_swap( &rwlock->state, -1 /* cur state*/, 0 /* new state */);  // C++11 maybe memory_order_seq_cst?
-
-      // Wake any waiters.
-      if (__predict_false(rwlock->pending_readers > 0 || rwlock->pending_writers > 0)) {
-        __futex_wake_ex(&rwlock->state, rwlock_is_shared(rwlock), INT_MAX);
-      }
-      done = true;
-    } else { // cur_state > 0
-      // Reduce state by 1.
-      // See the comment above on why we need __sync_bool_compare_and_swap.
-      done = __sync_bool_compare_and_swap(&rwlock->state, cur_state, cur_state - 1);  // C++11 maybe memory_order_seq_cst?
-      if (done && (cur_state - 1) == 0) {
-        // There are no more readers, wake any waiters.
-        if (__predict_false(rwlock->pending_readers > 0 || rwlock->pending_writers > 0)) {
-          __futex_wake_ex(&rwlock->state, rwlock_is_shared(rwlock), INT_MAX);
-        }
-      }
-    }
-  } while (!done);
-
+    // We're no longer the owner.
+    rwlock->writer_thread_id = 0;
+    __pthread_rwlock_release(rwlock, STATE_WRITER_OWNED);
+    return 0;
+  }
+  if ((cur_state & STATE_OWNERS_MASK) == 0) {
+    return EPERM;
+  }
+  __pthread_rwlock_release(rwlock, STATE_READER_ONE);
   return 0;
 }
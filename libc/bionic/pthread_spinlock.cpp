@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+
+#include <errno.h>
+
+#include "private/bionic_atomic_inline.h"
+
+/* Test-and-test-and-set spinlocks. A thread that finds the lock taken
+ * spins on plain reads, which hit its own cached copy of the line, and
+ * only retries the atomic exchange once the lock looks free. That keeps
+ * waiters from bouncing the cache line between cores while the owner is
+ * trying to finish.
+ *
+ * Spinlocks never sleep in the kernel, so they work the same whether or
+ * not they're process-shared.
+ */
+
+int pthread_spin_init(pthread_spinlock_t* lock, int pshared) {
+  if (pshared != PTHREAD_PROCESS_PRIVATE && pshared != PTHREAD_PROCESS_SHARED) {
+    return EINVAL;
+  }
+  *lock = 0;
+  return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t* lock) {
+  return (*lock != 0) ? EBUSY : 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t* lock) {
+  while (__predict_false(__sync_lock_test_and_set(lock, 1) != 0)) {  // C++11 memory_order_acquire
+    while (*lock != 0) {
+      __bionic_cpu_relax();
+    }
+  }
+  return 0;
+}
+
+int pthread_spin_trylock(pthread_spinlock_t* lock) {
+  if (*lock == 0 && __sync_lock_test_and_set(lock, 1) == 0) {  // C++11 memory_order_acquire
+    return 0;
+  }
+  return EBUSY;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t* lock) {
+  __sync_lock_release(lock);  // C++11 memory_order_release
+  return 0;
+}
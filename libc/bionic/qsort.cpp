@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// qsort and qsort_r are pattern-defeating quicksort (Orson Peters' pdqsort):
+//
+//  - Partitions of fewer than kInsertionSortThreshold elements are finished
+//    with insertion sort.
+//  - The pivot is the median of three, or of three medians of three (Tukey's
+//    ninther) for larger partitions.
+//  - A partition that moved nothing is probably already sorted, so we try a
+//    bounded insertion sort on both sides before recursing.
+//  - A pivot equal to the one before it means there's a run of equal
+//    elements; they all go left in one pass and are never looked at again.
+//  - Badly unbalanced partitions shuffle a few elements to break up the
+//    pattern that caused them, and after log2(n) of those we give up and
+//    heapsort, so the worst case is O(n log n).
+//
+// The sort is generic over how elements are swapped: 4, 8 and 16-byte
+// elements (most arrays of ints, longs, pointers and doubles, and pairs of
+// them) are swapped as whole words, anything else a word at a time.
+
+static const size_t kInsertionSortThreshold = 24;
+static const size_t kNintherThreshold = 128;
+static const size_t kPartialInsertionSortLimit = 8;
+
+// An array of elements of type T, which are swapped as a whole.
+template <typename T>
+class FixedSizeElements {
+ public:
+  FixedSizeElements(void* base, size_t) : base_(static_cast<char*>(base)) {}
+
+  char* operator[](size_t i) const { return base_ + i * sizeof(T); }
+
+  void swap(size_t i, size_t j) const {
+    T a, b;
+    memcpy(&a, (*this)[i], sizeof(T));
+    memcpy(&b, (*this)[j], sizeof(T));
+    memcpy((*this)[i], &b, sizeof(T));
+    memcpy((*this)[j], &a, sizeof(T));
+  }
+
+ private:
+  char* base_;
+};
+
+struct Pair64 {
+  uint64_t lo, hi;
+};
+
+// An array of elements of any size.
+class VariableSizeElements {
+ public:
+  VariableSizeElements(void* base, size_t size) : base_(static_cast<char*>(base)), size_(size) {}
+
+  char* operator[](size_t i) const { return base_ + i * size_; }
+
+  void swap(size_t i, size_t j) const {
+    char* a = (*this)[i];
+    char* b = (*this)[j];
+    size_t n = size_;
+    for (; n >= sizeof(uint64_t); n -= sizeof(uint64_t)) {
+      uint64_t t, u;
+      memcpy(&t, a, sizeof(t));
+      memcpy(&u, b, sizeof(u));
+      memcpy(a, &u, sizeof(u));
+      memcpy(b, &t, sizeof(t));
+      a += sizeof(t);
+      b += sizeof(t);
+    }
+    for (; n > 0; --n) {
+      char t = *a;
+      *a++ = *b;
+      *b++ = t;
+    }
+  }
+
+ private:
+  char* base_;
+  size_t size_;
+};
+
+// qsort's comparison function...
+class Compare {
+ public:
+  explicit Compare(int (*compar)(const void*, const void*)) : compar_(compar) {}
+  int operator()(const void* a, const void* b) const { return compar_(a, b); }
+
+ private:
+  int (*compar_)(const void*, const void*);
+};
+
+// ...and qsort_r's, which takes an extra argument.
+class CompareWithArg {
+ public:
+  CompareWithArg(int (*compar)(const void*, const void*, void*), void* arg)
+      : compar_(compar), arg_(arg) {}
+  int operator()(const void* a, const void* b) const { return compar_(a, b, arg_); }
+
+ private:
+  int (*compar_)(const void*, const void*, void*);
+  void* arg_;
+};
+
+template <typename Elements, typename Comparator>
+class PdqSort {
+ public:
+  PdqSort(const Elements& a, const Comparator& compar) : a_(a), compar_(compar) {}
+
+  void Sort(size_t n) const {
+    size_t log2_n = 0;
+    for (size_t i = n; i > 1; i >>= 1) {
+      ++log2_n;
+    }
+    Loop(0, n, log2_n, true);
+  }
+
+ private:
+  bool Less(size_t i, size_t j) const { return compar_(a_[i], a_[j]) < 0; }
+
+  void Sort2(size_t i, size_t j) const {
+    if (Less(j, i)) {
+      a_.swap(i, j);
+    }
+  }
+
+  // Leaves the elements at i, j and k in order.
+  void Sort3(size_t i, size_t j, size_t k) const {
+    Sort2(i, j);
+    Sort2(j, k);
+    Sort2(i, j);
+  }
+
+  void InsertionSort(size_t first, size_t last) const {
+    for (size_t i = first + 1; i < last; ++i) {
+      for (size_t j = i; j > first && Less(j, j - 1); --j) {
+        a_.swap(j, j - 1);
+      }
+    }
+  }
+
+  // Insertion sort that gives up (returning false) once it has moved
+  // elements more than kPartialInsertionSortLimit places in all.
+  bool PartialInsertionSort(size_t first, size_t last) const {
+    size_t moves = 0;
+    for (size_t i = first + 1; i < last; ++i) {
+      size_t j = i;
+      for (; j > first && Less(j, j - 1); --j) {
+        a_.swap(j, j - 1);
+      }
+      moves += i - j;
+      if (moves > kPartialInsertionSortLimit) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void SiftDown(size_t first, size_t root, size_t n) const {
+    for (size_t child; (child = 2 * root + 1) < n; root = child) {
+      if (child + 1 < n && Less(first + child, first + child + 1)) {
+        ++child;
+      }
+      if (!Less(first + root, first + child)) {
+        return;
+      }
+      a_.swap(first + root, first + child);
+    }
+  }
+
+  void HeapSort(size_t first, size_t last) const {
+    size_t n = last - first;
+    for (size_t i = n / 2; i > 0; --i) {
+      SiftDown(first, i - 1, n);
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+      a_.swap(first, first + i);
+      SiftDown(first, 0, i);
+    }
+  }
+
+  // Partitions [first, last) around the pivot at first: smaller elements
+  // go before it and the rest after. Returns the pivot's new position, and
+  // whether no elements needed to be moved. The choice of pivot means the
+  // scans always find an element to stop at, but a comparator that isn't a
+  // consistent ordering can break that, so they're bounded anyway: such a
+  // comparator gets an unsorted array rather than memory corruption.
+  size_t PartitionRight(size_t first, size_t last, bool* already_partitioned) const {
+    size_t i = first;
+    size_t j = last;
+    while (++i < last && Less(i, first)) {
+    }
+    // If nothing was smaller, there's no element to stop the scan below.
+    if (i - 1 == first) {
+      while (i < j && !Less(--j, first)) {
+      }
+    } else {
+      while (--j > first && !Less(j, first)) {
+      }
+    }
+    *already_partitioned = (i >= j);
+    while (i < j) {
+      a_.swap(i, j);
+      while (++i < last && Less(i, first)) {
+      }
+      while (--j > first && !Less(j, first)) {
+      }
+    }
+    size_t pivot = i - 1;
+    a_.swap(first, pivot);
+    return pivot;
+  }
+
+  // Partitions [first, last) around the pivot at first, which is known to be
+  // no smaller than anything before first: elements equal to it go before it
+  // and greater ones after. Returns the pivot's new position. The scans are
+  // bounded for the same reason as PartitionRight's.
+  size_t PartitionLeft(size_t first, size_t last) const {
+    size_t i = first;
+    size_t j = last;
+    while (--j > first && Less(first, j)) {
+    }
+    if (j + 1 == last) {
+      while (i < j && !Less(first, ++i)) {
+      }
+    } else {
+      while (++i < last && !Less(first, i)) {
+      }
+    }
+    while (i < j) {
+      a_.swap(i, j);
+      while (--j > first && Less(first, j)) {
+      }
+      while (++i < last && !Less(first, i)) {
+      }
+    }
+    a_.swap(first, j);
+    return j;
+  }
+
+  // Shuffles a few elements of [first, first + n) to break up patterns.
+  void BreakPatterns(size_t first, size_t n) const {
+    size_t last = first + n;
+    a_.swap(first, first + n / 4);
+    a_.swap(last - 1, last - n / 4);
+    if (n > kNintherThreshold) {
+      a_.swap(first + 1, first + (n / 4 + 1));
+      a_.swap(first + 2, first + (n / 4 + 2));
+      a_.swap(last - 2, last - (n / 4 + 1));
+      a_.swap(last - 3, last - (n / 4 + 2));
+    }
+  }
+
+  // Sorts [first, last). leftmost is true if there's nothing before first;
+  // otherwise the element before first is no greater than anything in the
+  // range. We recurse on the smaller side of each partition and loop on the
+  // larger, so the stack stays O(log n).
+  void Loop(size_t first, size_t last, size_t bad_allowed, bool leftmost) const {
+    for (;;) {
+      size_t n = last - first;
+      if (n < kInsertionSortThreshold) {
+        InsertionSort(first, last);
+        return;
+      }
+
+      // Move the pivot to first.
+      size_t half = n / 2;
+      if (n > kNintherThreshold) {
+        Sort3(first, first + half, last - 1);
+        Sort3(first + 1, first + (half - 1), last - 2);
+        Sort3(first + 2, first + (half + 1), last - 3);
+        Sort3(first + (half - 1), first + half, first + (half + 1));
+        a_.swap(first, first + half);
+      } else {
+        Sort3(first + half, first, last - 1);
+      }
+
+      // A pivot equal to the element before the range means the last pivot
+      // was repeated. Everything equal to it is in its final place.
+      if (!leftmost && !Less(first - 1, first)) {
+        first = PartitionLeft(first, last) + 1;
+        continue;
+      }
+
+      bool already_partitioned;
+      size_t pivot = PartitionRight(first, last, &already_partitioned);
+      size_t left_n = pivot - first;
+      size_t right_n = last - (pivot + 1);
+
+      if (left_n < n / 8 || right_n < n / 8) {
+        if (--bad_allowed == 0) {
+          HeapSort(first, last);
+          return;
+        }
+        if (left_n >= kInsertionSortThreshold) {
+          BreakPatterns(first, left_n);
+        }
+        if (right_n >= kInsertionSortThreshold) {
+          BreakPatterns(pivot + 1, right_n);
+        }
+      } else if (already_partitioned && PartialInsertionSort(first, pivot) &&
+                 PartialInsertionSort(pivot + 1, last)) {
+        return;
+      }
+
+      if (left_n < right_n) {
+        Loop(first, pivot, bad_allowed, leftmost);
+        first = pivot + 1;
+        leftmost = false;
+      } else {
+        Loop(pivot + 1, last, bad_allowed, false);
+        last = pivot;
+      }
+    }
+  }
+
+  const Elements a_;
+  const Comparator compar_;
+};
+
+template <typename Elements, typename Comparator>
+static void pdqsort(void* base, size_t nmemb, size_t size, const Comparator& compar) {
+  PdqSort<Elements, Comparator>(Elements(base, size), compar).Sort(nmemb);
+}
+
+template <typename Comparator>
+static void sort(void* base, size_t nmemb, size_t size, const Comparator& compar) {
+  if (nmemb < 2 || size == 0) {
+    return;
+  }
+  switch (size) {
+    case 4:
+      pdqsort<FixedSizeElements<uint32_t>>(base, nmemb, size, compar);
+      break;
+    case 8:
+      pdqsort<FixedSizeElements<uint64_t>>(base, nmemb, size, compar);
+      break;
+    case 16:
+      pdqsort<FixedSizeElements<Pair64>>(base, nmemb, size, compar);
+      break;
+    default:
+      pdqsort<VariableSizeElements>(base, nmemb, size, compar);
+      break;
+  }
+}
+
+void qsort(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*)) {
+  sort(base, nmemb, size, Compare(compar));
+}
+
+void qsort_r(void* base, size_t nmemb, size_t size,
+             int (*compar)(const void*, const void*, void*), void* arg) {
+  sort(base, nmemb, size, CompareWithArg(compar, arg));
+}
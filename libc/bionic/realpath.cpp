@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/ScopedFd.h"
+
+// FreeBSD's realpath, renamed by freebsd-compat.h. It walks the path a component
+// at a time, with an lstat for each and a readlink for each symbolic link.
+extern "C" char* __freebsd_realpath(const char* path, char* resolved);
+
+static const char kDeletedSuffix[] = " (deleted)";
+
+// Lets the kernel resolve the whole path in one go: open it (O_PATH needs no permission
+// to read the file itself), and ask /proc what was opened. That's three system calls
+// however deep the path is. Returns false if we didn't get an answer we can trust.
+static bool fast_realpath(const char* path, char* resolved) {
+  ScopedFd fd(open(path, O_PATH | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return false;
+  }
+
+  char proc_path[64];
+  snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd.get());
+  ssize_t count = readlink(proc_path, resolved, PATH_MAX);
+  // /proc may not be mounted, or the name may be too long.
+  if (count <= 0 || count >= PATH_MAX) {
+    return false;
+  }
+  resolved[count] = '\0';
+
+  // The kernel can't give a usable name to a file that was deleted after we opened it,
+  // or to one that isn't reachable from our root directory. (A file whose name really
+  // does end in " (deleted)" just takes the slow path.)
+  size_t suffix_length = sizeof(kDeletedSuffix) - 1;
+  if (resolved[0] != '/' ||
+      (static_cast<size_t>(count) >= suffix_length &&
+       strcmp(resolved + count - suffix_length, kDeletedSuffix) == 0)) {
+    return false;
+  }
+  return true;
+}
+
+char* realpath(const char* path, char* resolved) {
+  if (path == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+  if (path[0] == '\0') {
+    errno = ENOENT;
+    return NULL;
+  }
+
+  char buf[PATH_MAX];
+  bool found;
+  {
+    // Leave it to the slow path to report any errors.
+    ErrnoRestorer errno_restorer;
+    found = fast_realpath(path, buf);
+  }
+  if (!found) {
+    return __freebsd_realpath(path, resolved);
+  }
+
+  if (resolved == NULL) {
+    return strdup(buf);
+  }
+  strcpy(resolved, buf);
+  return resolved;
+}
@@ -48,7 +48,9 @@ class ScandirResult {
 
   bool Add(dirent* entry) {
     if (size_ >= capacity_) {
-      size_t new_capacity = capacity_ + 32;
+      // Grow geometrically: big directories shouldn't cost a copy of the
+      // whole list every few dozen entries.
+      size_t new_capacity = (capacity_ == 0) ? 32 : 2 * capacity_;
       dirent** new_names = (dirent**) realloc(names_, new_capacity * sizeof(dirent*));
       if (new_names == NULL) {
         return false;
@@ -81,6 +83,9 @@ class ScandirResult {
     // Allocate the minimum number of bytes necessary, rounded up to a 4-byte boundary.
     size_t size = ((original->d_reclen + 3) & ~3);
     dirent* copy = (dirent*) malloc(size);
+    if (copy == NULL) {
+      return NULL;
+    }
     memcpy(copy, original, original->d_reclen);
     return copy;
   }
@@ -29,13 +29,8 @@
 #define _GNU_SOURCE 1
 #include <sched.h>
 
-extern "C" int __getcpu(unsigned*, unsigned*, void*);
+#include "private/bionic_percpu.h"
 
 int sched_getcpu() {
-  unsigned cpu;
-  int rc = __getcpu(&cpu, NULL, NULL);
-  if (rc == -1) {
-    return -1; // errno is already set.
-  }
-  return cpu;
+  return __bionic_getcpu(); // errno is already set on failure.
 }
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE 1
+#include <sched.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private/ScopedFd.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+// The online CPUs are split into clusters of CPUs that are in the same
+// package (the kernel's core_siblings) and have the same capacity. Capacity
+// comes from cpu_capacity where the kernel has it and otherwise from
+// cpuinfo_max_freq, so it's only meaningful relative to other clusters.
+//
+// Reading all of this from sysfs is far too slow to do each time, so the
+// result is cached along with the contents of /sys/devices/system/cpu/online
+// it was built from. Each query rereads just that file and only rebuilds the
+// topology if a CPU has been hotplugged since.
+
+#define CPU_SYSFS_DIR "/sys/devices/system/cpu"
+
+// Enough for any phone, and for multi-socket servers.
+#define MAX_CLUSTERS 32
+
+// Caches are listed as index0, index1, ... and there are rarely more than four.
+#define MAX_CACHE_INDEXES 8
+
+struct cpu_topology_t {
+  char online[512];
+  int online_count;
+  size_t cluster_count;
+  sched_cpu_cluster_t clusters[MAX_CLUSTERS];
+};
+
+static pthread_mutex_t g_topology_lock = PTHREAD_MUTEX_INITIALIZER;
+static cpu_topology_t g_topology;
+
+// Reads a small sysfs file into 'buf' as a NUL-terminated string.
+static bool read_sysfs(const char* path, char* buf, size_t buf_size) {
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)));
+  if (fd.get() == -1) {
+    return false;
+  }
+  ssize_t n = TEMP_FAILURE_RETRY(read(fd.get(), buf, buf_size - 1));
+  if (n <= 0) {
+    return false;
+  }
+  buf[n] = '\0';
+  return true;
+}
+
+static bool read_cpu_file(int cpu, const char* name, char* buf, size_t buf_size) {
+  char path[128];
+  snprintf(path, sizeof(path), CPU_SYSFS_DIR "/cpu%d/%s", cpu, name);
+  return read_sysfs(path, buf, buf_size);
+}
+
+static unsigned long read_cpu_ulong(int cpu, const char* name) {
+  char buf[32];
+  return read_cpu_file(cpu, name, buf, sizeof(buf)) ? strtoul(buf, NULL, 10) : 0;
+}
+
+// Parses a kernel CPU list such as "0-3,6,8-11" into 'set'.
+static bool parse_cpu_list(const char* s, cpu_set_t* set) {
+  CPU_ZERO(set);
+  while (*s != '\0' && *s != '\n') {
+    char* end;
+    unsigned long first = strtoul(s, &end, 10);
+    if (end == s) {
+      return false;
+    }
+    unsigned long last = first;
+    if (*end == '-') {
+      s = end + 1;
+      last = strtoul(s, &end, 10);
+      if (end == s || last < first) {
+        return false;
+      }
+    }
+    for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, set);
+    }
+    s = end;
+    if (*s == ',') {
+      ++s;
+    }
+  }
+  return true;
+}
+
+static bool cpu_set_contains(const cpu_set_t* outer, const cpu_set_t* inner) {
+  cpu_set_t both;
+  CPU_AND(&both, outer, inner);
+  return CPU_EQUAL(&both, inner);
+}
+
+// Finds the highest-level cache that all of the cluster's CPUs share.
+static void find_shared_cache(sched_cpu_cluster_t* cluster, int cpu) {
+  for (int i = 0; i < MAX_CACHE_INDEXES; ++i) {
+    char name[64];
+    char buf[sizeof(g_topology.online)];
+
+    snprintf(name, sizeof(name), "cache/index%d/shared_cpu_list", i);
+    cpu_set_t shared;
+    if (!read_cpu_file(cpu, name, buf, sizeof(buf)) || !parse_cpu_list(buf, &shared)) {
+      break;
+    }
+    snprintf(name, sizeof(name), "cache/index%d/type", i);
+    if (read_cpu_file(cpu, name, buf, sizeof(buf)) && strncmp(buf, "Instruction", 11) == 0) {
+      continue;
+    }
+    snprintf(name, sizeof(name), "cache/index%d/level", i);
+    unsigned level = read_cpu_ulong(cpu, name);
+    if (level <= cluster->cache_level || !cpu_set_contains(&shared, &cluster->cpus)) {
+      continue;
+    }
+
+    // The size is given in kilobytes or megabytes, such as "512K".
+    snprintf(name, sizeof(name), "cache/index%d/size", i);
+    if (!read_cpu_file(cpu, name, buf, sizeof(buf))) {
+      continue;
+    }
+    char* suffix;
+    size_t size = strtoul(buf, &suffix, 10);
+    if (*suffix == 'K') {
+      size *= 1024;
+    } else if (*suffix == 'M') {
+      size *= 1024 * 1024;
+    }
+    cluster->cache_level = level;
+    cluster->cache_size = size;
+  }
+}
+
+static int cluster_compare(const void* lhs, const void* rhs) {
+  const sched_cpu_cluster_t* c1 = reinterpret_cast<const sched_cpu_cluster_t*>(lhs);
+  const sched_cpu_cluster_t* c2 = reinterpret_cast<const sched_cpu_cluster_t*>(rhs);
+  if (c1->capacity != c2->capacity) {
+    return (c1->capacity < c2->capacity) ? -1 : 1;
+  }
+  // Otherwise keep them in CPU order. Clusters never overlap.
+  for (size_t i = 0; i < CPU_SETSIZE; ++i) {
+    bool in1 = CPU_ISSET(i, &c1->cpus);
+    bool in2 = CPU_ISSET(i, &c2->cpus);
+    if (in1 != in2) {
+      return in1 ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+static void build_topology_locked(const char* online) {
+  cpu_topology_t* t = &g_topology;
+  memset(t, 0, sizeof(*t));
+  strlcpy(t->online, online, sizeof(t->online));
+
+  cpu_set_t online_cpus;
+  if (!parse_cpu_list(online, &online_cpus)) {
+    return;
+  }
+  t->online_count = CPU_COUNT(&online_cpus);
+
+  // Use one source of capacities for all CPUs, so that they can be compared.
+  const char* capacity_file = "cpu_capacity";
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &online_cpus) && read_cpu_ulong(cpu, capacity_file) == 0) {
+      capacity_file = "cpufreq/cpuinfo_max_freq";
+      break;
+    }
+  }
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &online_cpus)) {
+      continue;
+    }
+
+    char buf[sizeof(t->online)];
+    cpu_set_t siblings;
+    if (!read_cpu_file(cpu, "topology/core_siblings_list", buf, sizeof(buf)) ||
+        !parse_cpu_list(buf, &siblings)) {
+      siblings = online_cpus;
+    }
+    unsigned capacity = read_cpu_ulong(cpu, capacity_file);
+
+    // Join the first cluster with the same package and capacity.
+    sched_cpu_cluster_t* cluster = NULL;
+    for (size_t i = 0; i < t->cluster_count; ++i) {
+      int first = 0;
+      while (!CPU_ISSET(first, &t->clusters[i].cpus)) {
+        ++first;
+      }
+      if (t->clusters[i].capacity == capacity && CPU_ISSET(first, &siblings)) {
+        cluster = &t->clusters[i];
+        break;
+      }
+    }
+    if (cluster == NULL) {
+      if (t->cluster_count == MAX_CLUSTERS) {
+        // Lump any excess into the last cluster rather than lose the CPUs.
+        cluster = &t->clusters[MAX_CLUSTERS - 1];
+      } else {
+        cluster = &t->clusters[t->cluster_count++];
+        cluster->capacity = capacity;
+      }
+    }
+    CPU_SET(cpu, &cluster->cpus);
+  }
+
+  for (size_t i = 0; i < t->cluster_count; ++i) {
+    int first = 0;
+    while (!CPU_ISSET(first, &t->clusters[i].cpus)) {
+      ++first;
+    }
+    find_shared_cache(&t->clusters[i], first);
+  }
+  qsort(t->clusters, t->cluster_count, sizeof(t->clusters[0]), cluster_compare);
+}
+
+// Returns the cached topology after rebuilding it if the online CPUs have
+// changed. Returns NULL if sysfs isn't available.
+static const cpu_topology_t* get_topology_locked() {
+  char online[sizeof(g_topology.online)];
+  if (!read_sysfs(CPU_SYSFS_DIR "/online", online, sizeof(online))) {
+    return NULL;
+  }
+  if (g_topology.online_count == 0 || strcmp(online, g_topology.online) != 0) {
+    build_topology_locked(online);
+  }
+  return &g_topology;
+}
+
+__LIBC_HIDDEN__ int __sched_online_cpu_count() {
+  // This is what sysconf(_SC_NPROCESSORS_ONLN) calls, so it doesn't need the
+  // rest of the topology; parsing the online list is enough.
+  char online[sizeof(g_topology.online)];
+  cpu_set_t online_cpus;
+  if (!read_sysfs(CPU_SYSFS_DIR "/online", online, sizeof(online)) ||
+      !parse_cpu_list(online, &online_cpus)) {
+    return -1;
+  }
+  return CPU_COUNT(&online_cpus);
+}
+
+int sched_getclusters_np(sched_cpu_cluster_t* clusters, size_t count) {
+  ScopedPthreadMutexLocker locker(&g_topology_lock);
+  const cpu_topology_t* t = get_topology_locked();
+  if (t == NULL || t->cluster_count == 0) {
+    errno = ENOSYS;
+    return -1;
+  }
+  if (clusters != NULL) {
+    size_t n = (count < t->cluster_count) ? count : t->cluster_count;
+    memcpy(clusters, t->clusters, n * sizeof(clusters[0]));
+  }
+  return t->cluster_count;
+}
+
+int sched_setcluster_np(size_t index) {
+  cpu_set_t cpus;
+  {
+    ScopedPthreadMutexLocker locker(&g_topology_lock);
+    const cpu_topology_t* t = get_topology_locked();
+    if (t == NULL || t->cluster_count == 0) {
+      errno = ENOSYS;
+      return -1;
+    }
+    if (index >= t->cluster_count) {
+      errno = EINVAL;
+      return -1;
+    }
+    cpus = t->clusters[index].cpus;
+  }
+  return sched_setaffinity(0, sizeof(cpus), &cpus);
+}
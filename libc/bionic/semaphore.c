@@ -30,58 +30,54 @@
 #include <sys/time.h>
 #include <time.h>
 #include <limits.h>
+#include <stdatomic.h>
 
-#include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 
-/* In this implementation, a semaphore contains a
- * 31-bit signed value and a 1-bit 'shared' flag
- * (for process-sharing purpose).
+/* In this implementation, a semaphore is a single 32-bit word:
  *
- * We use the value -1 to indicate contention on the
- * semaphore, 0 or more to indicate uncontended state,
- * any value lower than -2 is invalid at runtime.
+ * bits:     name     description
+ * 31-8      value    the semaphore's value, never negative
+ * 7-1       waiters  number of threads waiting for the value to become positive
+ * 0         shared   process-shared flag
  *
- * State diagram:
+ * A thread that finds the value at 0 adds itself to the waiter count
+ * before it sleeps, and takes itself out again with the same
+ * compare-and-swap that takes the semaphore (or when it gives up). So
+ * sem_post() knows whether anybody is waiting. It only makes the
+ * FUTEX_WAKE system call if somebody is, and then wakes a single thread.
  *
- * post(1)  ==> 2
- * post(0)  ==> 1
- * post(-1) ==> 1, then wake all waiters
+ * Because the waiter count is part of the word that the futex compares,
+ * a post that comes in between a waiter registering and going to sleep
+ * makes the FUTEX_WAIT return immediately, so no wake-up is ever lost.
  *
- * wait(2)  ==> 1
- * wait(1)  ==> 0
- * wait(0)  ==> -1 then wait for a wake up + loop
- * wait(-1) ==> -1 then wait for a wake up + loop
- *
- */
-
-/* Use the upper 31-bits for the counter, and the lower one
- * for the shared flag.
+ * If more threads wait at once than the waiter field can count, it
+ * saturates at SEMCOUNT_WAITERS_MAX and stays there: from then on, nobody
+ * changes the count and every sem_post() wakes all waiters.
  */
 #define SEMCOUNT_SHARED_MASK      0x00000001
-#define SEMCOUNT_VALUE_MASK       0xfffffffe
-#define SEMCOUNT_VALUE_SHIFT      1
+#define SEMCOUNT_WAITERS_MASK     0x000000fe
+#define SEMCOUNT_WAITERS_SHIFT    1
+#define SEMCOUNT_VALUE_MASK       0xffffff00
+#define SEMCOUNT_VALUE_SHIFT      8
 
-/* Maximum unsigned value that can be stored in the semaphore.
- * One bit is used for the shared flag, another one for the
- * sign bit, leaving us with only 30 bits.
+/* Maximum value that can be stored in the semaphore (see SYSTEM_SEM_VALUE_MAX
+ * in sysconf.cpp).
  */
-#define SEM_MAX_VALUE             0x3fffffff
+#define SEM_MAX_VALUE             (SEMCOUNT_VALUE_MASK >> SEMCOUNT_VALUE_SHIFT)
+
+#define SEMCOUNT_WAITERS_MAX      (SEMCOUNT_WAITERS_MASK >> SEMCOUNT_WAITERS_SHIFT)
 
 /* convert a value into the corresponding sem->count bit pattern */
 #define SEMCOUNT_FROM_VALUE(val)    (((val) << SEMCOUNT_VALUE_SHIFT) & SEMCOUNT_VALUE_MASK)
 
-/* convert a sem->count bit pattern into the corresponding signed value */
-#define SEMCOUNT_TO_VALUE(sval)  ((int)(sval) >> SEMCOUNT_VALUE_SHIFT)
-
-/* the value +1 as a sem->count bit-pattern. */
-#define SEMCOUNT_ONE              SEMCOUNT_FROM_VALUE(1)
+/* extract the value and the waiter count from a sem->count bit pattern */
+#define SEMCOUNT_TO_VALUE(sval)     ((sval) >> SEMCOUNT_VALUE_SHIFT)
+#define SEMCOUNT_TO_WAITERS(sval)   (((sval) & SEMCOUNT_WAITERS_MASK) >> SEMCOUNT_WAITERS_SHIFT)
 
-/* the value -1 as a sem->count bit-pattern. */
-#define SEMCOUNT_MINUS_ONE        SEMCOUNT_FROM_VALUE(-1)
-
-#define SEMCOUNT_DECREMENT(sval)    (((sval) - (1U << SEMCOUNT_VALUE_SHIFT)) & SEMCOUNT_VALUE_MASK)
-#define SEMCOUNT_INCREMENT(sval)    (((sval) + (1U << SEMCOUNT_VALUE_SHIFT)) & SEMCOUNT_VALUE_MASK)
+/* the value +1 and a single waiter as sem->count bit patterns. */
+#define SEMCOUNT_ONE              (1U << SEMCOUNT_VALUE_SHIFT)
+#define SEMCOUNT_ONE_WAITER       (1U << SEMCOUNT_WAITERS_SHIFT)
 
 /* return the shared bitflag from a semaphore */
 #define SEM_GET_SHARED(sem)       ((sem)->count & SEMCOUNT_SHARED_MASK)
@@ -110,14 +106,15 @@ int sem_init(sem_t *sem, int pshared, unsigned int value)
 
 int sem_destroy(sem_t *sem)
 {
-    int count;
+    unsigned int waiters;
 
     if (sem == NULL) {
         errno = EINVAL;
         return -1;
     }
-    count = SEMCOUNT_TO_VALUE(sem->count);
-    if (count < 0) {
+    /* A saturated count doesn't tell us whether anybody is still waiting. */
+    waiters = SEMCOUNT_TO_WAITERS(sem->count);
+    if (waiters != 0 && waiters != SEMCOUNT_WAITERS_MAX) {
         errno = EBUSY;
         return -1;
     }
@@ -151,119 +148,110 @@ int sem_unlink(const char* name __unused)
 }
 
 
-/* Decrement a semaphore's value atomically,
- * and return the old one. As a special case,
- * this returns immediately if the value is
- * negative (i.e. -1)
- */
-static int
-__sem_dec(volatile unsigned int *pvalue)
+static inline __attribute__((always_inline)) volatile atomic_uint *
+__sem_atomic(sem_t *sem)
 {
-    unsigned int shared = (*pvalue & SEMCOUNT_SHARED_MASK);
-    unsigned int old, new;
-    int          ret;
-
-    do {
-        old = (*pvalue & SEMCOUNT_VALUE_MASK);
-        ret = SEMCOUNT_TO_VALUE(old);
-        if (ret < 0)
-            break;
-
-        new = SEMCOUNT_DECREMENT(old);
-    }
-    while (__bionic_cmpxchg((int)(old|shared),
-                            (int)(new|shared),
-                            (volatile int *)pvalue) != 0);
-    return ret;
+    return (volatile atomic_uint *)&sem->count;
 }
 
-/* Same as __sem_dec, but will not touch anything if the
- * value is already negative *or* 0. Returns the old value.
+/* Compare-and-swap on the count, with the given ordering on success.
+ * Taking the semaphore needs acquire ordering and posting it needs
+ * release ordering, so no full barriers are needed. Returns true if it
+ * made the swap, and otherwise reloads *old.
  */
-static int
-__sem_trydec(volatile unsigned int *pvalue)
+static inline __attribute__((always_inline)) bool
+__sem_cas(volatile atomic_uint *pcount, unsigned int *old, unsigned int new,
+          memory_order order)
 {
-    unsigned int shared = (*pvalue & SEMCOUNT_SHARED_MASK);
-    unsigned int old, new;
-    int          ret;
+    return atomic_compare_exchange_weak_explicit(pcount, old, new, order,
+                                                 memory_order_relaxed);
+}
 
-    do {
-        old = (*pvalue & SEMCOUNT_VALUE_MASK);
-        ret = SEMCOUNT_TO_VALUE(old);
-        if (ret <= 0)
-            break;
+/* Take the semaphore if its value is positive. Returns true if it did. */
+static bool
+__sem_trydec(volatile atomic_uint *pcount)
+{
+    unsigned int old = atomic_load_explicit(pcount, memory_order_relaxed);
 
-        new = SEMCOUNT_DECREMENT(old);
+    while (SEMCOUNT_TO_VALUE(old) > 0) {
+        if (__sem_cas(pcount, &old, old - SEMCOUNT_ONE, memory_order_acquire))
+            return true;
     }
-    while (__bionic_cmpxchg((int)(old|shared),
-                            (int)(new|shared),
-                            (volatile int *)pvalue) != 0);
-
-    return ret;
+    return false;
 }
 
-
-/* "Increment" the value of a semaphore atomically and
- * return its old value. Note that this implements
- * the special case of "incrementing" any negative
- * value to +1 directly.
+/* Take the semaphore, sleeping until its value is positive. If 'abs_timeout'
+ * isn't NULL, it's an absolute time on CLOCK_REALTIME if 'use_realtime_clock'
+ * is true and on CLOCK_MONOTONIC otherwise. If 'interruptible' is true,
+ * a signal makes this give up with EINTR.
  *
- * NOTE: The value will _not_ wrap above SEM_VALUE_MAX
+ * Returns 0 or an errno value.
  */
 static int
-__sem_inc(volatile unsigned int *pvalue)
+__sem_wait(sem_t *sem, bool use_realtime_clock, const struct timespec *abs_timeout,
+           bool interruptible)
 {
-    unsigned int  shared = (*pvalue & SEMCOUNT_SHARED_MASK);
-    unsigned int  old, new;
-    int           ret;
+    volatile atomic_uint *pcount = __sem_atomic(sem);
+    unsigned int shared = SEM_GET_SHARED(sem);
+    unsigned int old = atomic_load_explicit(pcount, memory_order_relaxed);
+    bool registered = false;
+    int error = 0;
 
-    do {
-        old = (*pvalue & SEMCOUNT_VALUE_MASK);
-        ret = SEMCOUNT_TO_VALUE(old);
-
-        /* Can't go higher than SEM_MAX_VALUE */
-        if (ret == SEM_MAX_VALUE)
-            break;
-
-        /* If the counter is negative, go directly to +1,
-         * otherwise just increment */
-        if (ret < 0)
-            new = SEMCOUNT_ONE;
-        else
-            new = SEMCOUNT_INCREMENT(old);
-    }
-    while ( __bionic_cmpxchg((int)(old|shared),
-                             (int)(new|shared),
-                             (volatile int*)pvalue) != 0);
+    for (;;) {
+        unsigned int waiters = SEMCOUNT_TO_WAITERS(old);
+        /* What to subtract to take ourselves out of the waiter count. */
+        unsigned int leave = (registered && waiters != SEMCOUNT_WAITERS_MAX) ? SEMCOUNT_ONE_WAITER : 0;
+        int ret;
+
+        /* Even after a timeout, take the value if a post came in meanwhile:
+         * the post may have woken nobody else on our behalf.
+         */
+        if (SEMCOUNT_TO_VALUE(old) > 0) {
+            if (__sem_cas(pcount, &old, old - SEMCOUNT_ONE - leave, memory_order_acquire))
+                return 0;
+            continue;
+        }
+
+        if (error != 0) {
+            if (__sem_cas(pcount, &old, old - leave, memory_order_relaxed))
+                return error;
+            continue;
+        }
+
+        if (!registered) {
+            unsigned int join = (waiters != SEMCOUNT_WAITERS_MAX) ? SEMCOUNT_ONE_WAITER : 0;
+            if (!__sem_cas(pcount, &old, old + join, memory_order_relaxed))
+                continue;
+            registered = true;
+            old += join;
+        }
 
-    return ret;
+        ret = __futex_wait_abs_ex(pcount, shared, old, use_realtime_clock, abs_timeout);
+        if (ret == -ETIMEDOUT || (ret == -EINTR && interruptible))
+            error = -ret;
+        old = atomic_load_explicit(pcount, memory_order_relaxed);
+    }
 }
 
 /* lock a semaphore */
 int sem_wait(sem_t *sem)
 {
-    unsigned shared;
-
     if (sem == NULL) {
         errno = EINVAL;
         return -1;
     }
 
-    shared = SEM_GET_SHARED(sem);
-
-    for (;;) {
-        if (__sem_dec(&sem->count) > 0)
-            break;
+    if (__sem_trydec(__sem_atomic(sem)))
+        return 0;
 
-        __futex_wait_ex(&sem->count, shared, shared|SEMCOUNT_MINUS_ONE, NULL);
-    }
-    ANDROID_MEMBAR_FULL();
+    __sem_wait(sem, false, NULL, false);
     return 0;
 }
 
-int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
+static int
+__sem_timedwait(sem_t *sem, const struct timespec *abs_timeout, bool use_realtime_clock)
 {
-    unsigned int shared;
+    int ret;
 
     if (sem == NULL) {
         errno = EINVAL;
@@ -271,11 +259,9 @@ int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
     }
 
     /* POSIX says we need to try to decrement the semaphore
-     * before checking the timeout value. Note that if the
-     * value is currently 0, __sem_trydec() does nothing.
+     * before checking the timeout value.
      */
-    if (__sem_trydec(&sem->count) > 0) {
-        ANDROID_MEMBAR_FULL();
+    if (__sem_trydec(__sem_atomic(sem))) {
         return 0;
     }
 
@@ -289,66 +275,55 @@ int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
         return -1;
     }
 
-    shared = SEM_GET_SHARED(sem);
-
-    for (;;) {
-        struct timespec ts;
-        int             ret;
-
-        /* Posix mandates CLOCK_REALTIME here */
-        clock_gettime( CLOCK_REALTIME, &ts );
-        ts.tv_sec  = abs_timeout->tv_sec - ts.tv_sec;
-        ts.tv_nsec = abs_timeout->tv_nsec - ts.tv_nsec;
-        if (ts.tv_nsec < 0) {
-            ts.tv_nsec += 1000000000;
-            ts.tv_sec  -= 1;
-        }
-
-        if (ts.tv_sec < 0 || ts.tv_nsec < 0) {
-            errno = ETIMEDOUT;
-            return -1;
-        }
-
-        /* Try to grab the semaphore. If the value was 0, this
-         * will also change it to -1 */
-        if (__sem_dec(&sem->count) > 0) {
-            ANDROID_MEMBAR_FULL();
-            break;
-        }
-
-        /* Contention detected. wait for a wakeup event */
-        ret = __futex_wait_ex(&sem->count, shared, shared|SEMCOUNT_MINUS_ONE, &ts);
-
-        /* return in case of timeout or interrupt */
-        if (ret == -ETIMEDOUT || ret == -EINTR) {
-            errno = -ret;
-            return -1;
-        }
+    /* The kernel measures the absolute timeout against the right clock,
+     * so changes to the wall clock are taken into account.
+     */
+    ret = __sem_wait(sem, use_realtime_clock, abs_timeout, true);
+    if (ret != 0) {
+        errno = ret;
+        return -1;
     }
     return 0;
 }
 
+int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
+{
+    /* Posix mandates CLOCK_REALTIME here */
+    return __sem_timedwait(sem, abs_timeout, true);
+}
+
+int sem_timedwait_monotonic_np(sem_t *sem, const struct timespec *abs_timeout)
+{
+    return __sem_timedwait(sem, abs_timeout, false);
+}
+
 /* Unlock a semaphore */
 int sem_post(sem_t *sem)
 {
-    unsigned int shared;
-    int          old;
+    volatile atomic_uint *pcount;
+    unsigned int shared, old, waiters;
 
     if (sem == NULL)
         return EINVAL;
 
+    pcount = __sem_atomic(sem);
     shared = SEM_GET_SHARED(sem);
 
-    ANDROID_MEMBAR_FULL();
-    old = __sem_inc(&sem->count);
-    if (old < 0) {
-        /* contention on the semaphore, wake up all waiters */
-        __futex_wake_ex(&sem->count, shared, INT_MAX);
-    }
-    else if (old == SEM_MAX_VALUE) {
-        /* overflow detected */
-        errno = EOVERFLOW;
-        return -1;
+    old = atomic_load_explicit(pcount, memory_order_relaxed);
+    do {
+        if (SEMCOUNT_TO_VALUE(old) == SEM_MAX_VALUE) {
+            /* overflow detected */
+            errno = EOVERFLOW;
+            return -1;
+        }
+    } while (!__sem_cas(pcount, &old, old + SEMCOUNT_ONE, memory_order_release));
+
+    /* Only pay for the system call if somebody is waiting. One post can
+     * only satisfy one waiter, unless we've lost count of them.
+     */
+    waiters = SEMCOUNT_TO_WAITERS(old);
+    if (waiters != 0) {
+        __futex_wake_ex(pcount, shared, (waiters == SEMCOUNT_WAITERS_MAX) ? INT_MAX : 1);
     }
 
     return 0;
@@ -361,8 +336,7 @@ int  sem_trywait(sem_t *sem)
         return -1;
     }
 
-    if (__sem_trydec(&sem->count) > 0) {
-        ANDROID_MEMBAR_FULL();
+    if (__sem_trydec(__sem_atomic(sem))) {
         return 0;
     } else {
         errno = EAGAIN;
@@ -382,17 +356,11 @@ int  sem_trywait(sem_t *sem)
  */
 int  sem_getvalue(sem_t *sem, int *sval)
 {
-    int  val;
-
     if (sem == NULL || sval == NULL) {
         errno = EINVAL;
         return -1;
     }
 
-    val = SEMCOUNT_TO_VALUE(sem->count);
-    if (val < 0)
-        val = 0;
-
-    *sval = val;
+    *sval = SEMCOUNT_TO_VALUE(sem->count);
     return 0;
 }
@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_sha.h"
+
+#include <android/cpu_features.h>
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Each block function consumes 'blocks' 64-byte blocks of 'data'.
+typedef void (*sha_blocks_fn)(uint32_t* state, const uint8_t* data, size_t blocks);
+
+static const uint32_t kSha256K[64] __attribute__((aligned(16))) = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotl(uint32_t x, int n) {
+  return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t rotr(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+      (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static void sha1_blocks_c(uint32_t* state, const uint8_t* data, size_t blocks) {
+  for (; blocks > 0; --blocks, data += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      w[i] = load_be32(data + 4 * i);
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+      uint32_t t = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = t;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+}
+
+static void sha256_blocks_c(uint32_t* state, const uint8_t* data, size_t blocks) {
+  for (; blocks > 0; --blocks, data += 64) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+      w[i] = load_be32(data + 4 * i);
+    }
+    for (int i = 16; i < 64; ++i) {
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + s1 + ch + kSha256K[i] + w[i];
+      uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = s0 + maj;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#if defined(__aarch64__)
+
+// The ARMv8 cryptography extension. The registers hold, for SHA-1:
+//   v0-v3: the round constants   v4, v5: message plus constant, alternately
+//   v6, v7: the state (ABCD, E)  v8-v11: the message schedule
+//   v12-v14: the working state (ABCD, and E for alternate rounds)
+// and for SHA-256:
+//   v0-v15: the round constants  v16-v19: the message schedule
+//   v20, v21: the state          v22, v23: message plus constant, alternately
+//   v24-v26: the working state
+// Each step does four rounds, and computes the next step's message plus
+// constant while it's at it.
+
+#define SHA1_EVEN(op, rc, s, dg1) \
+  "add v5.4s, v" #s ".4s, v" #rc ".4s\n" \
+  "sha1h s14, s12\n" \
+  "sha1" #op " q12, " dg1 ", v4.4s\n"
+#define SHA1_ODD(op, rc, s) \
+  "add v4.4s, v" #s ".4s, v" #rc ".4s\n" \
+  "sha1h s13, s12\n" \
+  "sha1" #op " q12, s14, v5.4s\n"
+#define SHA1_ODD_LAST(op) \
+  "sha1h s13, s12\n" \
+  "sha1" #op " q12, s14, v5.4s\n"
+#define SHA1_UPDATE_EVEN(op, rc, s0, s1, s2, s3, dg1) \
+  "sha1su0 v" #s0 ".4s, v" #s1 ".4s, v" #s2 ".4s\n" \
+  SHA1_EVEN(op, rc, s1, dg1) \
+  "sha1su1 v" #s0 ".4s, v" #s3 ".4s\n"
+#define SHA1_UPDATE_ODD(op, rc, s0, s1, s2, s3) \
+  "sha1su0 v" #s0 ".4s, v" #s1 ".4s, v" #s2 ".4s\n" \
+  SHA1_ODD(op, rc, s1) \
+  "sha1su1 v" #s0 ".4s, v" #s3 ".4s\n"
+#define SHA1_LOAD_CONSTANT(v, hi, lo) \
+  "movz %w[tmp], #" #lo "\n" \
+  "movk %w[tmp], #" #hi ", lsl #16\n" \
+  "dup v" #v ".4s, %w[tmp]\n"
+
+static void sha1_blocks_ce(uint32_t* state, const uint8_t* data, size_t blocks) {
+  uint32_t tmp;
+  __asm__ __volatile__(
+      ".arch armv8-a+crypto\n"
+      SHA1_LOAD_CONSTANT(0, 0x5a82, 0x7999)
+      SHA1_LOAD_CONSTANT(1, 0x6ed9, 0xeba1)
+      SHA1_LOAD_CONSTANT(2, 0x8f1b, 0xbcdc)
+      SHA1_LOAD_CONSTANT(3, 0xca62, 0xc1d6)
+      "ld1 {v6.4s}, [%[state]]\n"
+      "ldr s7, [%[state], #16]\n"
+      "1:\n"
+      "ld1 {v8.4s-v11.4s}, [%[data]], #64\n"
+      "sub %[blocks], %[blocks], #1\n"
+      "rev32 v8.16b, v8.16b\n"
+      "rev32 v9.16b, v9.16b\n"
+      "rev32 v10.16b, v10.16b\n"
+      "rev32 v11.16b, v11.16b\n"
+      "add v4.4s, v8.4s, v0.4s\n"
+      "mov v12.16b, v6.16b\n"
+      SHA1_UPDATE_EVEN(c, 0, 8, 9, 10, 11, "s7")
+      SHA1_UPDATE_ODD(c, 0, 9, 10, 11, 8)
+      SHA1_UPDATE_EVEN(c, 0, 10, 11, 8, 9, "s13")
+      SHA1_UPDATE_ODD(c, 0, 11, 8, 9, 10)
+      SHA1_UPDATE_EVEN(c, 1, 8, 9, 10, 11, "s13")
+      SHA1_UPDATE_ODD(p, 1, 9, 10, 11, 8)
+      SHA1_UPDATE_EVEN(p, 1, 10, 11, 8, 9, "s13")
+      SHA1_UPDATE_ODD(p, 1, 11, 8, 9, 10)
+      SHA1_UPDATE_EVEN(p, 1, 8, 9, 10, 11, "s13")
+      SHA1_UPDATE_ODD(p, 2, 9, 10, 11, 8)
+      SHA1_UPDATE_EVEN(m, 2, 10, 11, 8, 9, "s13")
+      SHA1_UPDATE_ODD(m, 2, 11, 8, 9, 10)
+      SHA1_UPDATE_EVEN(m, 2, 8, 9, 10, 11, "s13")
+      SHA1_UPDATE_ODD(m, 2, 9, 10, 11, 8)
+      SHA1_UPDATE_EVEN(m, 3, 10, 11, 8, 9, "s13")
+      SHA1_UPDATE_ODD(p, 3, 11, 8, 9, 10)
+      SHA1_EVEN(p, 3, 9, "s13")
+      SHA1_ODD(p, 3, 10)
+      SHA1_EVEN(p, 3, 11, "s13")
+      SHA1_ODD_LAST(p)
+      "add v7.2s, v7.2s, v13.2s\n"
+      "add v6.4s, v6.4s, v12.4s\n"
+      "cbnz %[blocks], 1b\n"
+      "st1 {v6.4s}, [%[state]]\n"
+      "str s7, [%[state], #16]\n"
+      : [data] "+r"(data), [blocks] "+r"(blocks), [tmp] "=&r"(tmp)
+      : [state] "r"(state)
+      : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9", "v10", "v11", "v12", "v13",
+        "v14", "memory");
+}
+
+#define SHA256_EVEN(rc, s) \
+  "mov v26.16b, v24.16b\n" \
+  "add v23.4s, v" #s ".4s, v" #rc ".4s\n" \
+  "sha256h q24, q25, v22.4s\n" \
+  "sha256h2 q25, q26, v22.4s\n"
+#define SHA256_ODD(rc, s) \
+  "mov v26.16b, v24.16b\n" \
+  "add v22.4s, v" #s ".4s, v" #rc ".4s\n" \
+  "sha256h q24, q25, v23.4s\n" \
+  "sha256h2 q25, q26, v23.4s\n"
+#define SHA256_ODD_LAST \
+  "mov v26.16b, v24.16b\n" \
+  "sha256h q24, q25, v23.4s\n" \
+  "sha256h2 q25, q26, v23.4s\n"
+#define SHA256_UPDATE(ROUND, rc, s0, s1, s2, s3) \
+  "sha256su0 v" #s0 ".4s, v" #s1 ".4s\n" \
+  ROUND(rc, s1) \
+  "sha256su1 v" #s0 ".4s, v" #s2 ".4s, v" #s3 ".4s\n"
+
+static void sha256_blocks_ce(uint32_t* state, const uint8_t* data, size_t blocks) {
+  const uint32_t* k = kSha256K;
+  __asm__ __volatile__(
+      ".arch armv8-a+crypto\n"
+      "ld1 {v0.4s-v3.4s}, [%[k]], #64\n"
+      "ld1 {v4.4s-v7.4s}, [%[k]], #64\n"
+      "ld1 {v8.4s-v11.4s}, [%[k]], #64\n"
+      "ld1 {v12.4s-v15.4s}, [%[k]]\n"
+      "ld1 {v20.4s, v21.4s}, [%[state]]\n"
+      "1:\n"
+      "ld1 {v16.4s-v19.4s}, [%[data]], #64\n"
+      "sub %[blocks], %[blocks], #1\n"
+      "rev32 v16.16b, v16.16b\n"
+      "rev32 v17.16b, v17.16b\n"
+      "rev32 v18.16b, v18.16b\n"
+      "rev32 v19.16b, v19.16b\n"
+      "add v22.4s, v16.4s, v0.4s\n"
+      "mov v24.16b, v20.16b\n"
+      "mov v25.16b, v21.16b\n"
+      SHA256_UPDATE(SHA256_EVEN, 1, 16, 17, 18, 19)
+      SHA256_UPDATE(SHA256_ODD, 2, 17, 18, 19, 16)
+      SHA256_UPDATE(SHA256_EVEN, 3, 18, 19, 16, 17)
+      SHA256_UPDATE(SHA256_ODD, 4, 19, 16, 17, 18)
+      SHA256_UPDATE(SHA256_EVEN, 5, 16, 17, 18, 19)
+      SHA256_UPDATE(SHA256_ODD, 6, 17, 18, 19, 16)
+      SHA256_UPDATE(SHA256_EVEN, 7, 18, 19, 16, 17)
+      SHA256_UPDATE(SHA256_ODD, 8, 19, 16, 17, 18)
+      SHA256_UPDATE(SHA256_EVEN, 9, 16, 17, 18, 19)
+      SHA256_UPDATE(SHA256_ODD, 10, 17, 18, 19, 16)
+      SHA256_UPDATE(SHA256_EVEN, 11, 18, 19, 16, 17)
+      SHA256_UPDATE(SHA256_ODD, 12, 19, 16, 17, 18)
+      SHA256_EVEN(13, 17)
+      SHA256_ODD(14, 18)
+      SHA256_EVEN(15, 19)
+      SHA256_ODD_LAST
+      "add v20.4s, v20.4s, v24.4s\n"
+      "add v21.4s, v21.4s, v25.4s\n"
+      "cbnz %[blocks], 1b\n"
+      "st1 {v20.4s, v21.4s}, [%[state]]\n"
+      : [data] "+r"(data), [blocks] "+r"(blocks), [k] "+r"(k)
+      : [state] "r"(state)
+      : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9", "v10", "v11", "v12", "v13",
+        "v14", "v15", "v16", "v17", "v18", "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26",
+        "memory");
+}
+
+#elif defined(__i386__) || defined(__x86_64__)
+
+// The x86 SHA extensions. SHA-1's rounds keep A-D in one register and E in
+// another; SHA-256's keep ABEF and CDGH. The message schedule lives in
+// msg[0..3], and is updated four steps ahead of its use.
+
+#define SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+
+// Four SHA-1 rounds, i from 0 to 19. e and e_next alternate between e0 and e1.
+#define SHA1_NI_STEP(i, e, e_next) \
+  do { \
+    __m128i& cur = msg[(i) & 3]; \
+    if ((i) < 4) { \
+      cur = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * (i))), \
+                             kSha1ByteSwap); \
+    } \
+    e = ((i) == 0) ? _mm_add_epi32(e, cur) : _mm_sha1nexte_epu32(e, cur); \
+    e_next = abcd; \
+    if ((i) >= 3 && (i) <= 18) msg[((i) + 1) & 3] = _mm_sha1msg2_epu32(msg[((i) + 1) & 3], cur); \
+    abcd = _mm_sha1rnds4_epu32(abcd, e, (i) / 5); \
+    if ((i) >= 1 && (i) <= 16) msg[((i) - 1) & 3] = _mm_sha1msg1_epu32(msg[((i) - 1) & 3], cur); \
+    if ((i) >= 2 && (i) <= 17) msg[((i) + 2) & 3] = _mm_xor_si128(msg[((i) + 2) & 3], cur); \
+  } while (0)
+
+SHA_NI_TARGET static void sha1_blocks_ni(uint32_t* state, const uint8_t* data, size_t blocks) {
+  const __m128i kSha1ByteSwap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  __m128i e1;
+  __m128i msg[4];
+
+  for (; blocks > 0; --blocks, data += 64) {
+    __m128i abcd_save = abcd;
+    __m128i e0_save = e0;
+    SHA1_NI_STEP(0, e0, e1);
+    SHA1_NI_STEP(1, e1, e0);
+    SHA1_NI_STEP(2, e0, e1);
+    SHA1_NI_STEP(3, e1, e0);
+    SHA1_NI_STEP(4, e0, e1);
+    SHA1_NI_STEP(5, e1, e0);
+    SHA1_NI_STEP(6, e0, e1);
+    SHA1_NI_STEP(7, e1, e0);
+    SHA1_NI_STEP(8, e0, e1);
+    SHA1_NI_STEP(9, e1, e0);
+    SHA1_NI_STEP(10, e0, e1);
+    SHA1_NI_STEP(11, e1, e0);
+    SHA1_NI_STEP(12, e0, e1);
+    SHA1_NI_STEP(13, e1, e0);
+    SHA1_NI_STEP(14, e0, e1);
+    SHA1_NI_STEP(15, e1, e0);
+    SHA1_NI_STEP(16, e0, e1);
+    SHA1_NI_STEP(17, e1, e0);
+    SHA1_NI_STEP(18, e0, e1);
+    SHA1_NI_STEP(19, e1, e0);
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+// Four SHA-256 rounds, i from 0 to 15.
+#define SHA256_NI_STEP(i) \
+  do { \
+    __m128i& cur = msg[(i) & 3]; \
+    if ((i) < 4) { \
+      cur = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * (i))), \
+                             kSha256ByteSwap); \
+    } \
+    __m128i wk = _mm_add_epi32(cur, _mm_load_si128(reinterpret_cast<const __m128i*>(&kSha256K[4 * (i)]))); \
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk); \
+    if ((i) >= 3 && (i) <= 14) { \
+      __m128i& next = msg[((i) + 1) & 3]; \
+      next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[((i) - 1) & 3], 4)); \
+      next = _mm_sha256msg2_epu32(next, cur); \
+    } \
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0e)); \
+    if ((i) >= 1 && (i) <= 12) msg[((i) - 1) & 3] = _mm_sha256msg1_epu32(msg[((i) - 1) & 3], cur); \
+  } while (0)
+
+SHA_NI_TARGET static void sha256_blocks_ni(uint32_t* state, const uint8_t* data, size_t blocks) {
+  const __m128i kSha256ByteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  // Rearrange ABCD EFGH into the ABEF and CDGH the instructions want.
+  __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xb1);
+  __m128i hgfe = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1b);
+  __m128i abef = _mm_alignr_epi8(dcba, hgfe, 8);
+  __m128i cdgh = _mm_blend_epi16(hgfe, dcba, 0xf0);
+  __m128i msg[4];
+
+  for (; blocks > 0; --blocks, data += 64) {
+    __m128i abef_save = abef;
+    __m128i cdgh_save = cdgh;
+    SHA256_NI_STEP(0);
+    SHA256_NI_STEP(1);
+    SHA256_NI_STEP(2);
+    SHA256_NI_STEP(3);
+    SHA256_NI_STEP(4);
+    SHA256_NI_STEP(5);
+    SHA256_NI_STEP(6);
+    SHA256_NI_STEP(7);
+    SHA256_NI_STEP(8);
+    SHA256_NI_STEP(9);
+    SHA256_NI_STEP(10);
+    SHA256_NI_STEP(11);
+    SHA256_NI_STEP(12);
+    SHA256_NI_STEP(13);
+    SHA256_NI_STEP(14);
+    SHA256_NI_STEP(15);
+    abef = _mm_add_epi32(abef, abef_save);
+    cdgh = _mm_add_epi32(cdgh, cdgh_save);
+  }
+
+  __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+  __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(feba, dchg, 0xf0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#endif
+
+static sha_blocks_fn g_sha1_blocks = sha1_blocks_c;
+static sha_blocks_fn g_sha256_blocks = sha256_blocks_c;
+static pthread_once_t g_sha_blocks_once = PTHREAD_ONCE_INIT;
+
+static void choose_sha_blocks() {
+  uint64_t flags = android_cpu_features()->flags;
+#if defined(__aarch64__)
+  if ((flags & ANDROID_CPU_FEATURE_SHA1) != 0) g_sha1_blocks = sha1_blocks_ce;
+  if ((flags & ANDROID_CPU_FEATURE_SHA2) != 0) g_sha256_blocks = sha256_blocks_ce;
+#elif defined(__i386__) || defined(__x86_64__)
+  // The SHA extensions came after SSE4.1, but check rather than assume.
+  if ((flags & ANDROID_CPU_FEATURE_SSE4_1) != 0) {
+    if ((flags & ANDROID_CPU_FEATURE_SHA1) != 0) g_sha1_blocks = sha1_blocks_ni;
+    if ((flags & ANDROID_CPU_FEATURE_SHA2) != 0) g_sha256_blocks = sha256_blocks_ni;
+  }
+#else
+  (void) flags;
+#endif
+}
+
+// The Merkle-Damgard padding and buffering both digests share.
+template <typename Ctx>
+static void sha_update(Ctx* ctx, const void* data, size_t length, sha_blocks_fn blocks) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  size_t used = ctx->length % 64;
+  ctx->length += length;
+  if (used != 0) {
+    size_t n = (64 - used < length) ? 64 - used : length;
+    memcpy(ctx->buffer + used, p, n);
+    p += n;
+    length -= n;
+    if (used + n < 64) {
+      return;
+    }
+    blocks(ctx->state, ctx->buffer, 1);
+  }
+  if (length >= 64) {
+    blocks(ctx->state, p, length / 64);
+    p += length & ~static_cast<size_t>(63);
+    length %= 64;
+  }
+  memcpy(ctx->buffer, p, length);
+}
+
+template <typename Ctx>
+static void sha_final(Ctx* ctx, uint8_t* digest, size_t digest_words, sha_blocks_fn blocks) {
+  uint64_t bits = ctx->length * 8;
+  size_t used = ctx->length % 64;
+  ctx->buffer[used++] = 0x80;
+  if (used > 56) {
+    memset(ctx->buffer + used, 0, 64 - used);
+    blocks(ctx->state, ctx->buffer, 1);
+    used = 0;
+  }
+  memset(ctx->buffer + used, 0, 56 - used);
+  for (int i = 0; i < 8; ++i) {
+    ctx->buffer[56 + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+  }
+  blocks(ctx->state, ctx->buffer, 1);
+
+  for (size_t i = 0; i < digest_words; ++i) {
+    digest[4 * i + 0] = static_cast<uint8_t>(ctx->state[i] >> 24);
+    digest[4 * i + 1] = static_cast<uint8_t>(ctx->state[i] >> 16);
+    digest[4 * i + 2] = static_cast<uint8_t>(ctx->state[i] >> 8);
+    digest[4 * i + 3] = static_cast<uint8_t>(ctx->state[i]);
+  }
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+void __sha1_init(bionic_sha1_t* ctx) {
+  pthread_once(&g_sha_blocks_once, choose_sha_blocks);
+  static const uint32_t kInitialState[5] = {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+  };
+  memcpy(ctx->state, kInitialState, sizeof(kInitialState));
+  ctx->length = 0;
+}
+
+void __sha1_update(bionic_sha1_t* ctx, const void* data, size_t length) {
+  sha_update(ctx, data, length, g_sha1_blocks);
+}
+
+void __sha1_final(bionic_sha1_t* ctx, uint8_t digest[BIONIC_SHA1_DIGEST_LENGTH]) {
+  sha_final(ctx, digest, 5, g_sha1_blocks);
+}
+
+void __sha1(const void* data, size_t length, uint8_t digest[BIONIC_SHA1_DIGEST_LENGTH]) {
+  bionic_sha1_t ctx;
+  __sha1_init(&ctx);
+  __sha1_update(&ctx, data, length);
+  __sha1_final(&ctx, digest);
+}
+
+void __sha256_init(bionic_sha256_t* ctx) {
+  pthread_once(&g_sha_blocks_once, choose_sha_blocks);
+  static const uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(ctx->state, kInitialState, sizeof(kInitialState));
+  ctx->length = 0;
+}
+
+void __sha256_update(bionic_sha256_t* ctx, const void* data, size_t length) {
+  sha_update(ctx, data, length, g_sha256_blocks);
+}
+
+void __sha256_final(bionic_sha256_t* ctx, uint8_t digest[BIONIC_SHA256_DIGEST_LENGTH]) {
+  sha_final(ctx, digest, 8, g_sha256_blocks);
+}
+
+void __sha256(const void* data, size_t length, uint8_t digest[BIONIC_SHA256_DIGEST_LENGTH]) {
+  bionic_sha256_t ctx;
+  __sha256_init(&ctx);
+  __sha256_update(&ctx, data, length);
+  __sha256_final(&ctx, digest);
+}
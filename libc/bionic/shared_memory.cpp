@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/shared_memory.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/ashmem.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/user.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+
+// Regions are ashmem. This kernel has no memfd_create, but ashmem gives the
+// same guarantees: its size is fixed by the first mmap, and its protection
+// mask can only shrink.
+
+int android_shm_create(const char* name, size_t size) {
+  int fd = open("/dev/ashmem", O_RDWR | O_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+  char buf[ASHMEM_NAME_LEN];
+  strlcpy(buf, (name != NULL) ? name : "", sizeof(buf));
+  if (ioctl(fd, ASHMEM_SET_NAME, buf) == -1 || ioctl(fd, ASHMEM_SET_SIZE, size) == -1) {
+    ErrnoRestorer errno_restorer;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int android_shm_seal(int fd, int prot) {
+  return (ioctl(fd, ASHMEM_SET_PROT_MASK, static_cast<unsigned long>(prot)) == -1) ? -1 : 0;
+}
+
+ssize_t android_shm_size(int fd) {
+  return ioctl(fd, ASHMEM_GET_SIZE, NULL);
+}
+
+static const uint32_t kRingMagic = 0x676e6972; // "ring"
+static const size_t kMaxRingCapacity = 1 << 30;
+
+// The first page of a ring's region. The positions only ever increase, and
+// wrap at 2^32; their difference is how much is in the ring. Each is written
+// by one side only, and they're kept apart so the two sides don't fight over
+// a cache line.
+struct RingHeader {
+  uint32_t magic;
+  uint32_t capacity;
+  alignas(64) atomic_uint_least32_t head; // Written by the writer.
+  alignas(64) atomic_uint_least32_t tail; // Written by the reader.
+};
+
+struct android_shm_ring {
+  int fd;
+  size_t capacity;
+  RingHeader* header;
+  char* data;
+};
+
+static android_shm_ring_t* MapRing(int fd, size_t capacity) {
+  android_shm_ring_t* ring = reinterpret_cast<android_shm_ring_t*>(malloc(sizeof(android_shm_ring_t)));
+  if (ring == NULL) {
+    return NULL;
+  }
+  void* p = mmap(NULL, PAGE_SIZE + capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    free(ring);
+    return NULL;
+  }
+  ring->fd = fd;
+  ring->capacity = capacity;
+  ring->header = reinterpret_cast<RingHeader*>(p);
+  ring->data = reinterpret_cast<char*>(p) + PAGE_SIZE;
+  return ring;
+}
+
+android_shm_ring_t* android_shm_ring_create(const char* name, size_t capacity) {
+  if (capacity == 0 || capacity > kMaxRingCapacity || (capacity & (capacity - 1)) != 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+  int fd = android_shm_create(name, PAGE_SIZE + capacity);
+  if (fd == -1) {
+    return NULL;
+  }
+  // Both sides write to the ring, but nobody should execute it.
+  android_shm_ring_t* ring = NULL;
+  if (android_shm_seal(fd, PROT_READ | PROT_WRITE) == 0) {
+    ring = MapRing(fd, capacity);
+  }
+  if (ring == NULL) {
+    ErrnoRestorer errno_restorer;
+    close(fd);
+    return NULL;
+  }
+  ring->header->magic = kRingMagic;
+  ring->header->capacity = capacity;
+  atomic_init(&ring->header->head, 0);
+  atomic_init(&ring->header->tail, 0);
+  return ring;
+}
+
+android_shm_ring_t* android_shm_ring_map(int fd) {
+  // Only trust the header as far as the region's real size allows.
+  ssize_t size = android_shm_size(fd);
+  if (size == -1) {
+    return NULL;
+  }
+  size_t capacity = size - PAGE_SIZE;
+  if (static_cast<size_t>(size) <= PAGE_SIZE || capacity > kMaxRingCapacity || (capacity & (capacity - 1)) != 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+  int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (dup_fd == -1) {
+    return NULL;
+  }
+  android_shm_ring_t* ring = MapRing(dup_fd, capacity);
+  if (ring == NULL) {
+    ErrnoRestorer errno_restorer;
+    close(dup_fd);
+    return NULL;
+  }
+  if (ring->header->magic != kRingMagic || ring->header->capacity != capacity) {
+    android_shm_ring_destroy(ring);
+    errno = EINVAL;
+    return NULL;
+  }
+  return ring;
+}
+
+int android_shm_ring_fd(android_shm_ring_t* ring) {
+  return ring->fd;
+}
+
+void android_shm_ring_destroy(android_shm_ring_t* ring) {
+  munmap(ring->header, PAGE_SIZE + ring->capacity);
+  close(ring->fd);
+  free(ring);
+}
+
+size_t android_shm_ring_write(android_shm_ring_t* ring, const void* data, size_t length) {
+  uint32_t head = atomic_load_explicit(&ring->header->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&ring->header->tail, memory_order_acquire);
+  uint32_t used = head - tail;
+  if (used > ring->capacity) {
+    return 0; // The reader has scribbled on the tail.
+  }
+  size_t n = ring->capacity - used;
+  if (length < n) {
+    n = length;
+  }
+  size_t offset = head & (ring->capacity - 1);
+  size_t first = ring->capacity - offset;
+  if (first > n) {
+    first = n;
+  }
+  memcpy(ring->data + offset, data, first);
+  memcpy(ring->data, reinterpret_cast<const char*>(data) + first, n - first);
+  atomic_store_explicit(&ring->header->head, head + n, memory_order_release);
+  return n;
+}
+
+ssize_t android_shm_ring_read(android_shm_ring_t* ring, void* buf, size_t length) {
+  uint32_t tail = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&ring->header->head, memory_order_acquire);
+  uint32_t used = head - tail;
+  if (used > ring->capacity) {
+    errno = EIO;
+    return -1;
+  }
+  size_t n = (length < used) ? length : used;
+  size_t offset = tail & (ring->capacity - 1);
+  size_t first = ring->capacity - offset;
+  if (first > n) {
+    first = n;
+  }
+  memcpy(buf, ring->data + offset, first);
+  memcpy(reinterpret_cast<char*>(buf) + first, ring->data, n - first);
+  atomic_store_explicit(&ring->header->tail, tail + n, memory_order_release);
+  return n;
+}
@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <spawn.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/kernel_sigset_t.h"
+
+extern "C" pid_t __bionic_clone(uint32_t flags, void* child_stack, int* parent_tid, void* tls, int* child_tid, int (*fn)(void*), void* arg);
+extern "C" int __rt_sigprocmask(int, const kernel_sigset_t*, kernel_sigset_t*, size_t);
+
+// The child only needs enough stack to apply the file actions and attributes
+// and to search PATH; execvpe uses alloca for its PATH copy. Pages we never
+// touch aren't backed, so being generous costs nothing.
+#define SPAWN_CHILD_STACK_SIZE (128 * 1024)
+
+struct __posix_spawnattr {
+  short flags;
+  pid_t pgroup;
+  sigset_t sigmask;
+  sigset_t sigdefault;
+  int schedpolicy;
+  sched_param schedparam;
+};
+
+enum SpawnFileActionKind {
+  kSpawnFileActionOpen,
+  kSpawnFileActionClose,
+  kSpawnFileActionDup2,
+};
+
+struct __posix_spawn_file_action {
+  __posix_spawn_file_action* next;
+  SpawnFileActionKind kind;
+  int fd;
+  int new_fd;
+  char* path;
+  int flags;
+  mode_t mode;
+};
+
+struct __posix_spawn_file_actions {
+  __posix_spawn_file_action* head;
+  __posix_spawn_file_action* last;
+};
+
+struct SpawnArgs {
+  const char* path;
+  char* const* argv;
+  char* const* env;
+  const posix_spawn_file_actions_t* actions;
+  const posix_spawnattr_t* attr;
+  bool use_path;
+  kernel_sigset_t parent_mask;
+  // Written by the child if it fails before or during exec.
+  volatile int error;
+};
+
+static int ApplyFileAction(const __posix_spawn_file_action* action) {
+  switch (action->kind) {
+    case kSpawnFileActionOpen: {
+      int fd = TEMP_FAILURE_RETRY(open(action->path, action->flags, action->mode));
+      if (fd == -1) {
+        return -1;
+      }
+      if (fd != action->fd) {
+        if (TEMP_FAILURE_RETRY(dup2(fd, action->fd)) == -1) {
+          return -1;
+        }
+        close(fd);
+      }
+      return 0;
+    }
+    case kSpawnFileActionClose:
+      // POSIX allows closing an fd that isn't open to be treated as success.
+      if (close(action->fd) == -1 && errno != EBADF) {
+        return -1;
+      }
+      return 0;
+    case kSpawnFileActionDup2:
+      // dup2 on the same fd is a no-op, but POSIX wants FD_CLOEXEC cleared.
+      if (action->fd == action->new_fd) {
+        int flags = fcntl(action->fd, F_GETFD);
+        return (flags == -1) ? -1 : fcntl(action->fd, F_SETFD, flags & ~FD_CLOEXEC);
+      }
+      return TEMP_FAILURE_RETRY(dup2(action->fd, action->new_fd)) == -1 ? -1 : 0;
+  }
+  errno = EINVAL;
+  return -1;
+}
+
+static int ApplyAttributes(const __posix_spawnattr* attr) {
+  // The child has its own copy of the signal dispositions, but it still shares
+  // our memory: none of our handlers may run in it, so everything that isn't
+  // being ignored goes back to SIG_DFL. exec would reset them anyway.
+  for (int sig = 1; sig < _NSIG; ++sig) {
+    struct sigaction sa;
+    if (sigaction(sig, NULL, &sa) == -1) {
+      continue;
+    }
+    bool reset = (sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN);
+    if (attr != NULL && (attr->flags & POSIX_SPAWN_SETSIGDEF) != 0 &&
+        static_cast<size_t>(sig) <= 8 * sizeof(sigset_t) && sigismember(&attr->sigdefault, sig) == 1) {
+      reset = true;
+    }
+    if (reset) {
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = SIG_DFL;
+      sigaction(sig, &sa, NULL);
+    }
+  }
+
+  if (attr == NULL) {
+    return 0;
+  }
+  if ((attr->flags & POSIX_SPAWN_SETPGROUP) != 0 && setpgid(0, attr->pgroup) == -1) {
+    return -1;
+  }
+  if ((attr->flags & POSIX_SPAWN_SETSCHEDULER) != 0) {
+    if (sched_setscheduler(0, attr->schedpolicy, &attr->schedparam) == -1) {
+      return -1;
+    }
+  } else if ((attr->flags & POSIX_SPAWN_SETSCHEDPARAM) != 0) {
+    if (sched_setparam(0, &attr->schedparam) == -1) {
+      return -1;
+    }
+  }
+  if ((attr->flags & POSIX_SPAWN_RESETIDS) != 0) {
+    if (setegid(getgid()) == -1 || seteuid(getuid()) == -1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Runs on its own stack in a child that shares our address space (and our
+// TLS, so errno is the parent thread's). The parent is suspended until we
+// exec or exit, so nothing here may allocate or touch shared libc state.
+static int __posix_spawn_child(void* arg) {
+  SpawnArgs* args = reinterpret_cast<SpawnArgs*>(arg);
+  const __posix_spawnattr* attr = (args->attr != NULL) ? *args->attr : NULL;
+
+  if (ApplyAttributes(attr) == -1) {
+    args->error = errno;
+    return 127;
+  }
+
+  if (args->actions != NULL) {
+    for (const __posix_spawn_file_action* action = (*args->actions)->head; action != NULL;
+         action = action->next) {
+      if (ApplyFileAction(action) == -1) {
+        args->error = errno;
+        return 127;
+      }
+    }
+  }
+
+  kernel_sigset_t mask(args->parent_mask);
+  if (attr != NULL && (attr->flags & POSIX_SPAWN_SETSIGMASK) != 0) {
+    mask.set(&attr->sigmask);
+  }
+  __rt_sigprocmask(SIG_SETMASK, &mask, NULL, sizeof(mask));
+
+  if (args->use_path) {
+    execvpe(args->path, args->argv, args->env);
+  } else {
+    execve(args->path, args->argv, args->env);
+  }
+  args->error = errno;
+  return 127;
+}
+
+static int __posix_spawn(pid_t* pid_out, const char* path, const posix_spawn_file_actions_t* actions,
+                         const posix_spawnattr_t* attr, char* const argv[], char* const env[],
+                         bool use_path) {
+  // The child writes to our errno, and we report errors by return value anyway.
+  ErrnoRestorer errno_restorer;
+
+  void* stack = mmap(NULL, SPAWN_CHILD_STACK_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (stack == MAP_FAILED) {
+    return errno;
+  }
+
+  SpawnArgs args;
+  args.path = path;
+  args.argv = argv;
+  args.env = (env != NULL) ? env : environ;
+  args.actions = actions;
+  args.attr = attr;
+  args.use_path = use_path;
+  args.error = 0;
+
+  // Block everything so no signal handler of ours runs in the child before it
+  // has reset its dispositions. The child restores the right mask before exec.
+  kernel_sigset_t all;
+  memset(&all, 0xff, sizeof(all));
+  __rt_sigprocmask(SIG_SETMASK, &all, &args.parent_mask, sizeof(all));
+
+  // Unlike fork, we don't copy the page tables or run the atfork handlers, so
+  // this costs the same however big the parent is. CLONE_VFORK suspends us
+  // until the child has exec'ed or exited.
+  void* child_stack = reinterpret_cast<void*>(
+      (reinterpret_cast<uintptr_t>(stack) + SPAWN_CHILD_STACK_SIZE) & ~static_cast<uintptr_t>(0xf));
+  pid_t pid = __bionic_clone(CLONE_VM | CLONE_VFORK | SIGCHLD, child_stack, NULL, NULL, NULL,
+                             __posix_spawn_child, &args);
+  int error = (pid == -1) ? errno : args.error;
+
+  __rt_sigprocmask(SIG_SETMASK, &args.parent_mask, NULL, sizeof(args.parent_mask));
+  munmap(stack, SPAWN_CHILD_STACK_SIZE);
+
+  if (error != 0) {
+    if (pid != -1) {
+      // The child has already exited, so reap it rather than leave a zombie.
+      TEMP_FAILURE_RETRY(waitpid(pid, NULL, 0));
+    }
+    return error;
+  }
+  if (pid_out != NULL) {
+    *pid_out = pid;
+  }
+  return 0;
+}
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* actions,
+                const posix_spawnattr_t* attr, char* const argv[], char* const env[]) {
+  return __posix_spawn(pid, path, actions, attr, argv, env, false);
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* actions,
+                 const posix_spawnattr_t* attr, char* const argv[], char* const env[]) {
+  return __posix_spawn(pid, file, actions, attr, argv, env, true);
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr) {
+  *attr = reinterpret_cast<__posix_spawnattr*>(calloc(1, sizeof(__posix_spawnattr)));
+  if (*attr == NULL) {
+    return errno;
+  }
+  (*attr)->schedpolicy = SCHED_OTHER;
+  return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t* attr) {
+  free(*attr);
+  *attr = NULL;
+  return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags) {
+  if ((flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |
+                 POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSCHEDPARAM | POSIX_SPAWN_SETSCHEDULER)) != 0) {
+    return EINVAL;
+  }
+  (*attr)->flags = flags;
+  return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags) {
+  *flags = (*attr)->flags;
+  return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t* attr, pid_t pgroup) {
+  (*attr)->pgroup = pgroup;
+  return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t* attr, pid_t* pgroup) {
+  *pgroup = (*attr)->pgroup;
+  return 0;
+}
+
+int posix_spawnattr_setsigmask(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigmask = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigmask(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigmask;
+  return 0;
+}
+
+int posix_spawnattr_setsigdefault(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigdefault = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigdefault(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigdefault;
+  return 0;
+}
+
+int posix_spawnattr_setschedparam(posix_spawnattr_t* attr, const struct sched_param* param) {
+  (*attr)->schedparam = *param;
+  return 0;
+}
+
+int posix_spawnattr_getschedparam(const posix_spawnattr_t* attr, struct sched_param* param) {
+  *param = (*attr)->schedparam;
+  return 0;
+}
+
+int posix_spawnattr_setschedpolicy(posix_spawnattr_t* attr, int policy) {
+  (*attr)->schedpolicy = policy;
+  return 0;
+}
+
+int posix_spawnattr_getschedpolicy(const posix_spawnattr_t* attr, int* policy) {
+  *policy = (*attr)->schedpolicy;
+  return 0;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* actions) {
+  *actions = reinterpret_cast<__posix_spawn_file_actions*>(calloc(1, sizeof(__posix_spawn_file_actions)));
+  return (*actions == NULL) ? errno : 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* actions) {
+  __posix_spawn_file_action* action = (*actions)->head;
+  while (action != NULL) {
+    __posix_spawn_file_action* next = action->next;
+    free(action->path);
+    free(action);
+    action = next;
+  }
+  free(*actions);
+  *actions = NULL;
+  return 0;
+}
+
+static int __posix_spawn_add_file_action(posix_spawn_file_actions_t* actions, SpawnFileActionKind kind,
+                                         int fd, int new_fd, const char* path, int flags, mode_t mode) {
+  if (fd < 0 || new_fd < 0) {
+    return EBADF;
+  }
+  __posix_spawn_file_action* action =
+      reinterpret_cast<__posix_spawn_file_action*>(calloc(1, sizeof(__posix_spawn_file_action)));
+  if (action == NULL) {
+    return errno;
+  }
+  if (path != NULL) {
+    // Copy the path now: the child mustn't allocate.
+    action->path = strdup(path);
+    if (action->path == NULL) {
+      free(action);
+      return errno;
+    }
+  }
+  action->kind = kind;
+  action->fd = fd;
+  action->new_fd = new_fd;
+  action->flags = flags;
+  action->mode = mode;
+
+  if ((*actions)->last == NULL) {
+    (*actions)->head = action;
+  } else {
+    (*actions)->last->next = action;
+  }
+  (*actions)->last = action;
+  return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int fd, const char* path,
+                                     int flags, mode_t mode) {
+  return __posix_spawn_add_file_action(actions, kSpawnFileActionOpen, fd, 0, path, flags, mode);
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd) {
+  return __posix_spawn_add_file_action(actions, kSpawnFileActionClose, fd, 0, NULL, 0, 0);
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int fd, int new_fd) {
+  return __posix_spawn_add_file_action(actions, kSpawnFileActionDup2, fd, new_fd, NULL, 0, 0);
+}
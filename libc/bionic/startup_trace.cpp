@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_startup_trace.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "private/KernelArgumentBlock.h"
+
+// The system call rather than clock_gettime: clock_gettime remembers the
+// first implementation it's called with, and this is called before the
+// vDSO is looked up.
+extern "C" int __clock_gettime(int, timespec*);
+
+StartupTrace __libc_startup_trace;
+
+void __libc_startup_trace_init(KernelArgumentBlock& args) {
+  if (args.startup_trace != NULL) {
+    __libc_startup_trace = *args.startup_trace;
+    return;
+  }
+  for (char** env = args.envp; *env != NULL; ++env) {
+    if (strncmp(*env, "LIBC_STARTUP_TRACE=", 19) == 0) {
+      __libc_startup_trace.enabled = true;
+      return;
+    }
+  }
+}
+
+void __libc_startup_trace_record(android_startup_phase phase) {
+  timespec ts;
+  __clock_gettime(CLOCK_MONOTONIC, &ts);
+  __libc_startup_trace.timestamps[phase] = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+size_t android_get_startup_trace(uint64_t* timestamps, size_t count) {
+  if (!__libc_startup_trace.enabled) {
+    return 0;
+  }
+  if (count > ANDROID_STARTUP_PHASE_COUNT) {
+    count = ANDROID_STARTUP_PHASE_COUNT;
+  }
+  memcpy(timestamps, __libc_startup_trace.timestamps, count * sizeof(uint64_t));
+  return ANDROID_STARTUP_PHASE_COUNT;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2008 The Android Open Source Project
+ * Copyright (C) 2014 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -25,40 +25,23 @@
  * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
-/*
- * This uses the "Not So Naive" algorithm, a very simple but
- * usually effective algorithm, see:
- * http://www-igm.univ-mlv.fr/~lecroq/string/
- */
+
+#include <ctype.h>
 #include <string.h>
 
-void *memmem(const void *haystack, size_t n, const void *needle, size_t m)
-{
-    if (m > n || !m || !n)
-        return NULL;
+#include "private/bionic_two_way.h"
 
-    if (__builtin_expect((m > 1), 1)) {
-        const unsigned char*  y = (const unsigned char*) haystack;
-        const unsigned char*  x = (const unsigned char*) needle;
-        size_t                j = 0;
-        size_t                k = 1, l = 2;
+struct LowerFold {
+  unsigned char operator()(unsigned char c) const { return tolower(c); }
+};
 
-        if (x[0] == x[1]) {
-            k = 2;
-            l = 1;
-        }
-        while (j <= n-m) {
-            if (x[1] != y[j+1]) {
-                j += k;
-            } else {
-                if (!memcmp(x+2, y+j+2, m-2) && x[0] == y[j])
-                    return (void*) &y[j];
-                j += l;
-            }
-        }
-    } else {
-        /* degenerate case */
-        return memchr(haystack, ((unsigned char*)needle)[0], n);
-    }
-    return NULL;
+char* strcasestr(const char* haystack, const char* needle) {
+  size_t m = strlen(needle);
+  if (m == 0) {
+    return const_cast<char*>(haystack);
+  }
+  const unsigned char* result =
+      two_way_search(reinterpret_cast<const unsigned char*>(haystack), strlen(haystack),
+                     reinterpret_cast<const unsigned char*>(needle), m, LowerFold());
+  return reinterpret_cast<char*>(const_cast<unsigned char*>(result));
 }
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The strtol family (and so atoi, atol and atoll) as one template per
+// signedness. Each instantiation behaves exactly as the OpenBSD function it
+// replaces did, down to which of them reject a bad base. Base 10, by far the
+// most common, skips the general digit loop: it converts eight digits at a
+// time where it can, and only checks for overflow once per chunk.
+
+static inline bool IsSpace(int c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// A digit's value in any base up to 36, or -1 if 'c' isn't alphanumeric.
+static inline int DigitValue(int c) {
+  if (static_cast<unsigned>(c - '0') < 10) {
+    return c - '0';
+  }
+  if (static_cast<unsigned>((c | 0x20) - 'a') < 26) {
+    return (c | 0x20) - 'a' + 10;
+  }
+  return -1;
+}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Returns true if the eight bytes at 's' are all decimal digits, and sets
+// 'value' to the number they spell.
+static inline bool ParseEightDigits(const char* s, uint64_t* value) {
+  uint64_t x;
+  memcpy(&x, s, sizeof(x));
+  // Every byte is 0x30-0x3f, and stays below 0x40 when six is added.
+  if ((x & 0xf0f0f0f0f0f0f0f0ULL) != 0x3030303030303030ULL ||
+      ((x + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) != 0x3030303030303030ULL) {
+    return false;
+  }
+  // The first digit is in the lowest byte: combine pairs, then quads, then halves.
+  x -= 0x3030303030303030ULL;
+  x = (x * 10 + (x >> 8)) & 0x00ff00ff00ff00ffULL;
+  x = (x * 100 + (x >> 16)) & 0x0000ffff0000ffffULL;
+  x = (x * 10000 + (x >> 32)) & 0x00000000ffffffffULL;
+  *value = x;
+  return true;
+}
+#endif
+
+// Converts the decimal digits starting at 's' into their magnitude. Returns
+// the end of the digits. If their value is more than 'limit', sets
+// 'overflow' instead (the digits are all consumed regardless).
+static const char* ParseDecimal(const char* s, uint64_t limit, uint64_t* magnitude,
+                                bool* overflow) {
+  uint64_t acc = 0;
+  *overflow = false;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Eight bytes at a time, as long as that doesn't read into the next page
+  // (the digits may be the last thing before it) and can't overflow.
+  const uint64_t chunk_limit = (limit - 99999999) / 100000000;
+  uint64_t chunk;
+  while ((reinterpret_cast<uintptr_t>(s) & (PAGE_SIZE - 1)) <= PAGE_SIZE - 8 &&
+         acc <= chunk_limit && ParseEightDigits(s, &chunk)) {
+    acc = acc * 100000000 + chunk;
+    s += 8;
+  }
+#endif
+
+  const uint64_t cutoff = limit / 10;
+  const int cutlim = limit % 10;
+  for (;; ++s) {
+    int c = *s - '0';
+    if (static_cast<unsigned>(c) >= 10) {
+      break;
+    }
+    if (*overflow) {
+      continue;
+    }
+    if (acc > cutoff || (acc == cutoff && c > cutlim)) {
+      *overflow = true;
+    } else {
+      acc = acc * 10 + c;
+    }
+  }
+  *magnitude = acc;
+  return s;
+}
+
+// Skips leading white space, a sign and a base prefix. Returns the first
+// character that may be a digit, and updates 'base' as the prefix says.
+static const char* ParsePrefix(const char* s, int* base, bool* neg) {
+  while (IsSpace(static_cast<unsigned char>(*s))) {
+    ++s;
+  }
+  *neg = false;
+  if (*s == '-') {
+    *neg = true;
+    ++s;
+  } else if (*s == '+') {
+    ++s;
+  }
+  if ((*base == 0 || *base == 16) && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+    s += 2;
+    *base = 16;
+  }
+  if (*base == 0) {
+    *base = (*s == '0') ? 8 : 10;
+  }
+  return s;
+}
+
+template <typename T, T Min, T Max>
+static T StrToSigned(const char* nptr, char** endptr, int base) {
+  bool neg;
+  const char* s = ParsePrefix(nptr, &base, &neg);
+
+  if (base == 10) {
+    uint64_t limit = neg ? static_cast<uint64_t>(Max) + 1 : static_cast<uint64_t>(Max);
+    uint64_t magnitude;
+    bool overflow;
+    const char* end = ParseDecimal(s, limit, &magnitude, &overflow);
+    if (endptr != NULL) {
+      *endptr = const_cast<char*>(end != s ? end : nptr);
+    }
+    if (overflow) {
+      errno = ERANGE;
+      return neg ? Min : Max;
+    }
+    return neg ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+  }
+
+  // The cutoff between legal and illegal values, as in the OpenBSD code:
+  // the most negative or positive value divided by the base, and the last
+  // digit allowed when the accumulated value equals it.
+  T cutoff = neg ? Min : Max;
+  int cutlim = cutoff % base;
+  cutoff /= base;
+  if (neg) {
+    if (cutlim > 0) {
+      cutlim -= base;
+      cutoff += 1;
+    }
+    cutlim = -cutlim;
+  }
+
+  T acc = 0;
+  int any = 0;  // Negative after an overflow.
+  for (;; ++s) {
+    int c = DigitValue(static_cast<unsigned char>(*s));
+    if (c == -1 || c >= base) {
+      break;
+    }
+    if (any < 0) {
+      continue;
+    }
+    if (neg) {
+      if (acc < cutoff || (acc == cutoff && c > cutlim)) {
+        any = -1;
+        acc = Min;
+        errno = ERANGE;
+      } else {
+        any = 1;
+        acc *= base;
+        acc -= c;
+      }
+    } else {
+      if (acc > cutoff || (acc == cutoff && c > cutlim)) {
+        any = -1;
+        acc = Max;
+        errno = ERANGE;
+      } else {
+        any = 1;
+        acc *= base;
+        acc += c;
+      }
+    }
+  }
+  if (endptr != NULL) {
+    *endptr = const_cast<char*>(any ? s : nptr);
+  }
+  return acc;
+}
+
+template <typename T, T Max>
+static T StrToUnsigned(const char* nptr, char** endptr, int base) {
+  bool neg;
+  const char* s = ParsePrefix(nptr, &base, &neg);
+
+  if (base == 10) {
+    uint64_t magnitude;
+    bool overflow;
+    const char* end = ParseDecimal(s, Max, &magnitude, &overflow);
+    if (endptr != NULL) {
+      *endptr = const_cast<char*>(end != s ? end : nptr);
+    }
+    if (overflow) {
+      errno = ERANGE;
+      return Max;
+    }
+    // A minus sign negates the value in the unsigned type.
+    return neg ? static_cast<T>(0 - static_cast<T>(magnitude)) : static_cast<T>(magnitude);
+  }
+
+  T cutoff = Max / static_cast<T>(base);
+  int cutlim = Max % static_cast<T>(base);
+  T acc = 0;
+  int any = 0;  // Negative after an overflow.
+  for (;; ++s) {
+    int c = DigitValue(static_cast<unsigned char>(*s));
+    if (c == -1 || c >= base) {
+      break;
+    }
+    if (any < 0) {
+      continue;
+    }
+    if (acc > cutoff || (acc == cutoff && c > cutlim)) {
+      any = -1;
+      acc = Max;
+      errno = ERANGE;
+    } else {
+      any = 1;
+      acc *= static_cast<T>(base);
+      acc += c;
+    }
+  }
+  if (neg && any > 0) {
+    acc = -acc;
+  }
+  if (endptr != NULL) {
+    *endptr = const_cast<char*>(any ? s : nptr);
+  }
+  return acc;
+}
+
+long strtol(const char* nptr, char** endptr, int base) {
+  // Only strtol has ever checked its base.
+  if (base != 0 && (base < 2 || base > 36)) {
+    if (endptr != NULL) {
+      *endptr = const_cast<char*>(nptr);
+    }
+    errno = EINVAL;
+    return 0;
+  }
+  return StrToSigned<long, LONG_MIN, LONG_MAX>(nptr, endptr, base);
+}
+
+long long strtoll(const char* nptr, char** endptr, int base) {
+  return StrToSigned<long long, LLONG_MIN, LLONG_MAX>(nptr, endptr, base);
+}
+__strong_alias(strtoq, strtoll);
+
+intmax_t strtoimax(const char* nptr, char** endptr, int base) {
+  return StrToSigned<intmax_t, INTMAX_MIN, INTMAX_MAX>(nptr, endptr, base);
+}
+
+unsigned long strtoul(const char* nptr, char** endptr, int base) {
+  return StrToUnsigned<unsigned long, ULONG_MAX>(nptr, endptr, base);
+}
+
+unsigned long long strtoull(const char* nptr, char** endptr, int base) {
+  return StrToUnsigned<unsigned long long, ULLONG_MAX>(nptr, endptr, base);
+}
+__strong_alias(strtouq, strtoull);
+
+uintmax_t strtoumax(const char* nptr, char** endptr, int base) {
+  return StrToUnsigned<uintmax_t, UINTMAX_MAX>(nptr, endptr, base);
+}
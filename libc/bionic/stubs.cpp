@@ -33,8 +33,10 @@
 #include <netdb.h>
 #include <pthread.h>
 #include <pwd.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "private/android_filesystem_config.h"
@@ -52,6 +54,10 @@ struct stubs_state_t {
   char group_name_buffer_[32];
   char dir_buffer_[32];
   char sh_buffer_[32];
+  // Whether passwd_ and group_ still hold what getpwuid and getgrgid last
+  // returned, so that looking the same id up again costs nothing.
+  bool passwd_by_uid_;
+  bool group_by_gid_;
 };
 
 static int do_getpw_r(int by_name, const char* name, uid_t uid,
@@ -117,6 +123,7 @@ static stubs_state_t* stubs_state_alloc() {
   stubs_state_t*  s = static_cast<stubs_state_t*>(calloc(1, sizeof(*s)));
   if (s != NULL) {
     s->group_.gr_mem = s->group_members_;
+    strcpy(s->sh_buffer_, "/system/bin/sh");
   }
   return s;
 }
@@ -148,10 +155,102 @@ static stubs_state_t* __stubs_state() {
   return s;
 }
 
+// android_ids is looked up by both id and name, and isn't sorted by either,
+// so the first lookup sorts an index for each and the rest binary search.
+// Where entries share an id or name, the first one wins, as it always has.
+static pthread_once_t g_android_ids_index_once = PTHREAD_ONCE_INIT;
+static uint16_t g_android_ids_by_aid[android_id_count];
+static uint16_t g_android_ids_by_name[android_id_count];
+static size_t g_android_ids_by_aid_count;
+static size_t g_android_ids_by_name_count;
+
+static int android_id_aid_compare(const void* lhs, const void* rhs) {
+  uint16_t l = *static_cast<const uint16_t*>(lhs);
+  uint16_t r = *static_cast<const uint16_t*>(rhs);
+  if (android_ids[l].aid != android_ids[r].aid) {
+    return (android_ids[l].aid < android_ids[r].aid) ? -1 : 1;
+  }
+  return l - r;
+}
+
+static int android_id_name_compare(const void* lhs, const void* rhs) {
+  uint16_t l = *static_cast<const uint16_t*>(lhs);
+  uint16_t r = *static_cast<const uint16_t*>(rhs);
+  int result = strcmp(android_ids[l].name, android_ids[r].name);
+  return (result != 0) ? result : l - r;
+}
+
+// Sorts 'index' and drops all but the first of each run of equal entries.
+static size_t sort_android_ids_index(uint16_t* index, int (*compare)(const void*, const void*),
+                                     bool (*same)(const android_id_info&, const android_id_info&)) {
+  for (size_t n = 0; n < android_id_count; ++n) {
+    index[n] = n;
+  }
+  qsort(index, android_id_count, sizeof(index[0]), compare);
+  size_t count = 0;
+  for (size_t n = 0; n < android_id_count; ++n) {
+    if (count == 0 || !same(android_ids[index[count - 1]], android_ids[index[n]])) {
+      index[count++] = index[n];
+    }
+  }
+  return count;
+}
+
+static bool same_aid(const android_id_info& lhs, const android_id_info& rhs) {
+  return lhs.aid == rhs.aid;
+}
+
+static bool same_name(const android_id_info& lhs, const android_id_info& rhs) {
+  return strcmp(lhs.name, rhs.name) == 0;
+}
+
+static void android_ids_index_init() {
+  g_android_ids_by_aid_count =
+      sort_android_ids_index(g_android_ids_by_aid, android_id_aid_compare, same_aid);
+  g_android_ids_by_name_count =
+      sort_android_ids_index(g_android_ids_by_name, android_id_name_compare, same_name);
+}
+
+static const android_id_info* find_android_id(unsigned id) {
+  pthread_once(&g_android_ids_index_once, android_ids_index_init);
+  size_t lo = 0;
+  size_t hi = g_android_ids_by_aid_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const android_id_info* info = &android_ids[g_android_ids_by_aid[mid]];
+    if (info->aid == id) {
+      return info;
+    } else if (info->aid < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return NULL;
+}
+
+static const android_id_info* find_android_name(const char* name) {
+  pthread_once(&g_android_ids_index_once, android_ids_index_init);
+  size_t lo = 0;
+  size_t hi = g_android_ids_by_name_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const android_id_info* info = &android_ids[g_android_ids_by_name[mid]];
+    int cmp = strcmp(info->name, name);
+    if (cmp == 0) {
+      return info;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return NULL;
+}
+
 static passwd* android_iinfo_to_passwd(stubs_state_t* state,
                                        const android_id_info* iinfo) {
-  snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
-  snprintf(state->sh_buffer_, sizeof(state->sh_buffer_), "/system/bin/sh");
+  strcpy(state->dir_buffer_, "/");
 
   passwd* pw = &state->passwd_;
   pw->pw_name  = (char*) iinfo->name;
@@ -172,39 +271,40 @@ static group* android_iinfo_to_group(group* gr,
 }
 
 static passwd* android_id_to_passwd(stubs_state_t* state, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id(id);
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static passwd* android_name_to_passwd(stubs_state_t* state, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_name(name);
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static group* android_id_to_group(group* gr, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_group(gr, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id(id);
+  return (iinfo != NULL) ? android_iinfo_to_group(gr, iinfo) : NULL;
 }
 
 static group* android_name_to_group(group* gr, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_group(gr, android_ids + n);
+  const android_id_info* iinfo = find_android_name(name);
+  return (iinfo != NULL) ? android_iinfo_to_group(gr, iinfo) : NULL;
+}
+
+// Parses the decimal number at the start of 's', which must be no more than
+// 'max'. Returns a pointer past it, or NULL if there's no such number.
+static const char* parse_id(const char* s, unsigned max, unsigned* value) {
+  if (*s < '0' || *s > '9') {
+    return NULL;
+  }
+  unsigned result = 0;
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    result = result * 10 + (*s - '0');
+    if (result > max) {
+      return NULL;
     }
   }
-  return NULL;
+  *value = result;
+  return s;
 }
 
 // Translate a user/group name to the corresponding user/group id.
@@ -213,54 +313,34 @@ static group* android_name_to_group(group* gr, const char* name) {
 // u1_system -> 1 * AID_USER + android_ids['system']
 // returns 0 and sets errno to ENOENT in case of error
 static unsigned app_id_from_name(const char* name) {
-  if (name[0] != 'u' || !isdigit(name[1])) {
-    errno = ENOENT;
-    return 0;
-  }
-
-  char* end;
-  unsigned long userid = strtoul(name+1, &end, 10);
-  if (end[0] != '_' || end[1] == 0) {
+  unsigned userid;
+  const char* end = (name[0] == 'u') ? parse_id(name + 1, 1000, &userid) : NULL;
+  if (end == NULL || end[0] != '_' || end[1] == '\0') {
     errno = ENOENT;
     return 0;
   }
 
-  unsigned long appid = 0;
-  if (end[1] == 'a' && isdigit(end[2])) {
-    // end will point to \0 if the strtoul below succeeds.
-    appid = strtoul(end+2, &end, 10) + AID_APP;
-  } else if (end[1] == 'i' && isdigit(end[2])) {
-    // end will point to \0 if the strtoul below succeeds.
-    appid = strtoul(end+2, &end, 10) + AID_ISOLATED_START;
+  const char* suffix = end + 1;
+  unsigned appid;
+  if (suffix[0] == 'a' && isdigit(suffix[1])) {
+    end = parse_id(suffix + 1, AID_USER - AID_APP - 1, &appid);
+    appid += AID_APP;
+  } else if (suffix[0] == 'i' && isdigit(suffix[1])) {
+    end = parse_id(suffix + 1, AID_USER - AID_ISOLATED_START - 1, &appid);
+    appid += AID_ISOLATED_START;
   } else {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (!strcmp(android_ids[n].name, end + 1)) {
-        appid = android_ids[n].aid;
-        // Move the end pointer to the null terminator.
-        end += strlen(android_ids[n].name) + 1;
-      }
-    }
+    const android_id_info* iinfo = find_android_name(suffix);
+    end = (iinfo != NULL) ? "" : NULL;
+    appid = (iinfo != NULL) ? iinfo->aid : 0;
   }
 
   // Check that the entire string was consumed by one of the 3 cases above.
-  if (end[0] != 0) {
+  if (end == NULL || end[0] != '\0') {
     errno = ENOENT;
     return 0;
   }
 
-  // Check that user id won't overflow.
-  if (userid > 1000) {
-    errno = ENOENT;
-    return 0;
-  }
-
-  // Check that app id is within range.
-  if (appid >= AID_USER) {
-    errno = ENOENT;
-    return 0;
-  }
-
-  return (unsigned)(appid + userid*AID_USER);
+  return appid + userid * AID_USER;
 }
 
 static void print_app_name_from_appid_userid(const uid_t appid,
@@ -270,11 +350,9 @@ static void print_app_name_from_appid_userid(const uid_t appid,
   } else if (userid == 0 && appid >= AID_SHARED_GID_START) {
     snprintf(buffer, bufferlen, "all_a%u", appid - AID_SHARED_GID_START);
   } else if (appid < AID_APP) {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (android_ids[n].aid == appid) {
-        snprintf(buffer, bufferlen, "u%u_%s", userid, android_ids[n].name);
-        return;
-      }
+    const android_id_info* iinfo = find_android_id(appid);
+    if (iinfo != NULL) {
+      snprintf(buffer, bufferlen, "u%u_%s", userid, iinfo->name);
     }
   } else {
     snprintf(buffer, bufferlen, "u%u_a%u", userid, appid - AID_APP);
@@ -307,13 +385,7 @@ static passwd* app_id_to_passwd(uid_t uid, stubs_state_t* state) {
   print_app_name_from_appid_userid(appid, userid, state->app_name_buffer_,
                                    sizeof(state->app_name_buffer_));
 
-  if (appid < AID_APP) {
-      snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
-  } else {
-      snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/data");
-  }
-
-  snprintf(state->sh_buffer_, sizeof(state->sh_buffer_), "/system/bin/sh");
+  strcpy(state->dir_buffer_, (appid < AID_APP) ? "/" : "/data");
 
   pw->pw_name  = state->app_name_buffer_;
   pw->pw_dir   = state->dir_buffer_;
@@ -349,12 +421,16 @@ passwd* getpwuid(uid_t uid) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  if (state->passwd_by_uid_ && state->passwd_.pw_uid == uid) {
+    return &state->passwd_;
+  }
 
   passwd* pw = android_id_to_passwd(state, uid);
-  if (pw != NULL) {
-    return pw;
+  if (pw == NULL) {
+    pw = app_id_to_passwd(uid, state);
   }
-  return app_id_to_passwd(uid, state);
+  state->passwd_by_uid_ = (pw != NULL);
+  return pw;
 }
 
 passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
@@ -362,6 +438,7 @@ passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  state->passwd_by_uid_ = false;
 
   passwd* pw = android_name_to_passwd(state, login);
   if (pw != NULL) {
@@ -390,13 +467,16 @@ group* getgrgid(gid_t gid) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  if (state->group_by_gid_ && state->group_.gr_gid == gid) {
+    return &state->group_;
+  }
 
   group* gr = android_id_to_group(&state->group_, gid);
-  if (gr != NULL) {
-    return gr;
+  if (gr == NULL) {
+    gr = app_id_to_group(gid, state);
   }
-
-  return app_id_to_group(gid, state);
+  state->group_by_gid_ = (gr != NULL);
+  return gr;
 }
 
 group* getgrnam(const char* name) { // NOLINT: implementing bad function.
@@ -404,6 +484,7 @@ group* getgrnam(const char* name) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  state->group_by_gid_ = false;
 
   if (android_name_to_group(&state->group_, name) != 0) {
     return &state->group_;
@@ -26,15 +26,20 @@
  * SUCH DAMAGE.
  */
 
+#include <android/fast_clock.h>
+
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>  // For FOPEN_MAX.
 #include <string.h>
 #include <sys/sysconf.h>
+#include <sys/sysinfo.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -49,7 +54,7 @@
 #define  SYSTEM_MQ_OPEN_MAX     8
 #define  SYSTEM_MQ_PRIO_MAX     32768
 #define  SYSTEM_SEM_NSEMS_MAX   256
-#define  SYSTEM_SEM_VALUE_MAX   0x3fffffff  /* see bionic/semaphore.c */
+#define  SYSTEM_SEM_VALUE_MAX   0x00ffffff  /* see bionic/semaphore.c */
 #define  SYSTEM_SIGQUEUE_MAX    32
 #define  SYSTEM_TIMER_MAX       32
 #define  SYSTEM_LOGIN_NAME_MAX  256
@@ -69,6 +74,8 @@
 #define  SYSTEM_2_UPE        -1       /* No UPE for you ! (User Portability Utilities) */
 #define  SYSTEM_2_VERSION    -1       /* No posix command-line tools */
 
+extern __LIBC_HIDDEN__ int __sched_online_cpu_count();
+
 static bool __matches_cpuN(const char* s) {
   // The %c trick is to ensure that we have the anchored match "^cpu[0-9]+$".
   unsigned cpu;
@@ -77,6 +84,12 @@ static bool __matches_cpuN(const char* s) {
 }
 
 static int __sysconf_nprocessors_conf() {
+  // CPUs are almost never physically added or removed, so only count them once.
+  static int result = 0;
+  if (result != 0) {
+    return result;
+  }
+
   // On x86 kernels you can use /proc/cpuinfo for this, but on ARM kernels offline CPUs disappear
   // from there. This method works on both.
   ScopedReaddir reader("/sys/devices/system/cpu");
@@ -84,64 +97,60 @@ static int __sysconf_nprocessors_conf() {
     return 1;
   }
 
-  int result = 0;
+  int count = 0;
   dirent* entry;
   while ((entry = reader.ReadEntry()) != NULL) {
     if (entry->d_type == DT_DIR && __matches_cpuN(entry->d_name)) {
-      ++result;
+      ++count;
     }
   }
+  result = count;
   return result;
 }
 
+// CPUs go online and offline often on phones, but callers sizing thread pools
+// ask for the count far more often than that, so it's kept for a while.
+#define ONLINE_CPU_CACHE_NS (50 * 1000000LL)
+
+static atomic_int g_online_cpus = ATOMIC_VAR_INIT(0);
+static atomic_int_least64_t g_online_cpus_expiry = ATOMIC_VAR_INIT(0);
+
 static int __sysconf_nprocessors_onln() {
-  FILE* fp = fopen("/proc/stat", "r");
-  if (fp == NULL) {
-    return 1;
+  int64_t now = android_coarse_monotonic_ns();
+  int result = atomic_load_explicit(&g_online_cpus, memory_order_relaxed);
+  if (result != 0 && now < atomic_load_explicit(&g_online_cpus_expiry, memory_order_relaxed)) {
+    return result;
   }
 
-  int result = 0;
-  char buf[256];
-  while (fgets(buf, sizeof(buf), fp) != NULL) {
-    // Extract just the first word from the line.
-    // 'cpu0 7976751 1364388 3116842 469770388 8629405 0 49047 0 0 0'
-    char* p = strchr(buf, ' ');
-    if (p != NULL) {
-      *p = 0;
-    }
-    if (__matches_cpuN(buf)) {
-      ++result;
-    }
+  // Parses /sys/devices/system/cpu/online (see sched_topology.cpp), which is much
+  // cheaper than scanning /proc/stat.
+  result = __sched_online_cpu_count();
+  if (result <= 0) {
+    return 1;
   }
-  fclose(fp);
+  // Racing callers may briefly overwrite a newer answer with an older one,
+  // but either was true a moment ago.
+  atomic_store_explicit(&g_online_cpus, result, memory_order_relaxed);
+  atomic_store_explicit(&g_online_cpus_expiry, now + ONLINE_CPU_CACHE_NS, memory_order_relaxed);
   return result;
 }
 
-static int __get_meminfo(const char* pattern) {
-  FILE* fp = fopen("/proc/meminfo", "r");
-  if (fp == NULL) {
+// sysinfo(2) has the same numbers as /proc/meminfo's MemTotal and MemFree,
+// for one system call rather than formatting and parsing the whole file.
+static long __sysconf_phys_pages() {
+  struct sysinfo si;
+  if (sysinfo(&si) == -1) {
     return -1;
   }
-
-  int result = -1;
-  char buf[256];
-  while (fgets(buf, sizeof(buf), fp) != NULL) {
-    long total;
-    if (sscanf(buf, pattern, &total) == 1) {
-      result = (int) (total / (PAGE_SIZE/1024));
-      break;
-    }
-  }
-  fclose(fp);
-  return result;
+  return static_cast<long>((static_cast<uint64_t>(si.totalram) * si.mem_unit) / PAGE_SIZE);
 }
 
-static int __sysconf_phys_pages() {
-  return __get_meminfo("MemTotal: %ld kB");
-}
-
-static int __sysconf_avphys_pages() {
-  return __get_meminfo("MemFree: %ld kB");
+static long __sysconf_avphys_pages() {
+  struct sysinfo si;
+  if (sysinfo(&si) == -1) {
+    return -1;
+  }
+  return static_cast<long>((static_cast<uint64_t>(si.freeram) * si.mem_unit) / PAGE_SIZE);
 }
 
 static int __sysconf_monotonic_clock() {
@@ -309,7 +318,8 @@ long sysconf(int name) {
       return _POSIX_THREAD_DESTRUCTOR_ITERATIONS;
 
     case _SC_THREAD_KEYS_MAX:
-      return (BIONIC_TLS_SLOTS - TLS_SLOT_FIRST_USER_SLOT - BIONIC_TLS_RESERVED_SLOTS);
+      return (BIONIC_TLS_SLOTS - TLS_SLOT_FIRST_USER_SLOT - BIONIC_TLS_RESERVED_SLOTS) +
+          BIONIC_DYNAMIC_KEYS;
 
     case _SC_THREAD_STACK_MIN:    return PTHREAD_STACK_MIN;
     case _SC_THREAD_THREADS_MAX:  return SYSTEM_THREAD_THREADS_MAX;
@@ -36,8 +36,10 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 
 #include <sys/mman.h>
+#include <sys/param.h>
 
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -54,6 +56,7 @@
 #include "private/bionic_atomic_inline.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_macros.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
 static const char property_service_socket[] = "/dev/socket/" PROP_SERVICE_NAME;
 
@@ -100,16 +103,41 @@ private:
     DISALLOW_COPY_AND_ASSIGN(prop_bt);
 };
 
+/*
+ * Readers can also find a property through an index of full names, an
+ * open-addressed hash table of (hash, prop_info offset) slots that the
+ * property service fills as it adds properties. A lookup then costs a hash
+ * and, almost always, one string compare, rather than a binary tree search
+ * for each '.'-delimited token. Older property services leave the index
+ * fields of prop_area zeroed, and older readers never look at them, so the
+ * index doesn't change the area's version.
+ */
+struct prop_index_slot {
+    volatile uint32_t hash;
+    volatile uint32_t prop;  // 0 if the slot is free.
+};
+
+// A power of two. Properties past 3/4 of it aren't indexed, and lookups of
+// names not in the index fall back to the trie once that happens.
+#define PA_INDEX_SLOTS 1024
+#define PA_INDEX_MAX_COUNT (PA_INDEX_SLOTS * 3 / 4)
+
 struct prop_area {
     uint32_t bytes_used;
     volatile uint32_t serial;
     uint32_t magic;
     uint32_t version;
-    uint32_t reserved[28];
+    uint32_t index;                // Offset of the index, or 0 if there's none.
+    uint32_t index_slots;
+    uint32_t index_count;          // Used slots.
+    volatile uint32_t index_full;  // Some properties aren't in the index.
+    uint32_t partitions;           // Offset of the partition table, or 0 if there's none.
+    uint32_t reserved[23];
     char data[0];
 
     prop_area(const uint32_t magic, const uint32_t version) :
-        serial(0), magic(magic), version(version) {
+        serial(0), magic(magic), version(version),
+        index(0), index_slots(0), index_count(0), index_full(0), partitions(0) {
         memset(reserved, 0, sizeof(reserved));
         // Allocate enough space for the root node.
         bytes_used = sizeof(prop_bt);
@@ -119,6 +147,35 @@ private:
     DISALLOW_COPY_AND_ASSIGN(prop_area);
 };
 
+/*
+ * The property service can give the properties under a prefix an area of
+ * their own, in a file next to the main one with the partition's number
+ * appended, so that one area needn't hold every property and readers only
+ * map and fault in the areas with the prefixes they use. The main area
+ * lists the partitions, and keeps every property outside them; a property
+ * belongs to the partition with the longest prefix of its name. Readers
+ * older than partitions don't see partitioned properties. The main area's
+ * serial counts updates in every area.
+ */
+#define PA_MAX_PARTITIONS 16
+
+struct prop_partition {
+    uint8_t prefix_len;
+    char prefix[PROP_NAME_MAX];
+};
+
+struct prop_partition_table {
+    volatile uint32_t count;  // Bumped once the new partition's area exists.
+    prop_partition partitions[PA_MAX_PARTITIONS];
+};
+
+// An area as this process has it mapped.
+struct mapped_area {
+    prop_area * volatile pa;
+    size_t data_size;
+    prop_area *owner;  // For a partition, the main area listing it.
+};
+
 struct prop_info {
     volatile uint32_t serial;
     char value[PROP_VALUE_MAX];
@@ -155,6 +212,17 @@ static size_t pa_size;
 // requires it.
 prop_area *__system_property_area__ = NULL;
 
+// Partitions' areas, mapped on first use. The main area only changes
+// under tests, which is when 'owner' tells stale mappings apart.
+static mapped_area partition_areas[PA_MAX_PARTITIONS];
+static pthread_mutex_t partition_areas_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static mapped_area main_area()
+{
+    mapped_area area = { __system_property_area__, pa_data_size, NULL };
+    return area;
+}
+
 static int get_fd_from_env(void)
 {
     // This environment variable consistes of two decimal integer
@@ -170,12 +238,18 @@ static int get_fd_from_env(void)
     return atoi(env);
 }
 
-static int map_prop_area_rw()
+static void *allocate_obj(const mapped_area *area, const size_t size, uint32_t *const off);
+
+/*
+ * Creates, maps and initializes a new area in 'filename'. Fails if the file
+ * exists already.
+ */
+static int create_area(const char *filename, mapped_area *area)
 {
     /* dev is a tmpfs that we can use to carve a shared workspace
      * out of, so let's do that...
      */
-    const int fd = open(property_filename,
+    const int fd = open(filename,
                         O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC | O_EXCL, 0444);
 
     if (fd < 0) {
@@ -201,26 +275,46 @@ static int map_prop_area_rw()
         return -1;
     }
 
-    pa_size = PA_SIZE;
-    pa_data_size = pa_size - sizeof(prop_area);
-    compat_mode = false;
-
-    void *const memory_area = mmap(NULL, pa_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void *const memory_area = mmap(NULL, PA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (memory_area == MAP_FAILED) {
         close(fd);
         return -1;
     }
+    close(fd);
 
-    prop_area *pa = new(memory_area) prop_area(PROP_AREA_MAGIC, PROP_AREA_VERSION);
+    area->pa = new(memory_area) prop_area(PROP_AREA_MAGIC, PROP_AREA_VERSION);
+    area->data_size = PA_SIZE - sizeof(prop_area);
 
-    /* plug into the lib property services */
-    __system_property_area__ = pa;
+    // The area is zero-filled, so the index starts with every slot free.
+    uint32_t index_offset;
+    if (allocate_obj(area, PA_INDEX_SLOTS * sizeof(prop_index_slot), &index_offset)) {
+        area->pa->index_slots = PA_INDEX_SLOTS;
+        area->pa->index = index_offset;
+    }
+    return 0;
+}
 
-    close(fd);
+static int map_prop_area_rw()
+{
+    mapped_area area;
+    if (create_area(property_filename, &area) < 0)
+        return -1;
+
+    pa_size = PA_SIZE;
+    pa_data_size = area.data_size;
+    compat_mode = false;
+
+    /* plug into the lib property services */
+    __system_property_area__ = area.pa;
     return 0;
 }
 
-static int map_fd_ro(const int fd) {
+/*
+ * Maps the area in 'fd' read-only, after checking that only root could
+ * have written it. Fills in 'area', and sets *version.
+ */
+static int map_area_ro(const int fd, mapped_area *area, uint32_t *version)
+{
     struct stat fd_stat;
     if (fstat(fd, &fd_stat) < 0) {
         return -1;
@@ -233,10 +327,8 @@ static int map_fd_ro(const int fd) {
         return -1;
     }
 
-    pa_size = fd_stat.st_size;
-    pa_data_size = pa_size - sizeof(prop_area);
-
-    void* const map_result = mmap(NULL, pa_size, PROT_READ, MAP_SHARED, fd, 0);
+    const size_t size = fd_stat.st_size;
+    void* const map_result = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
     if (map_result == MAP_FAILED) {
         return -1;
     }
@@ -244,15 +336,30 @@ static int map_fd_ro(const int fd) {
     prop_area* pa = reinterpret_cast<prop_area*>(map_result);
     if ((pa->magic != PROP_AREA_MAGIC) || (pa->version != PROP_AREA_VERSION &&
                 pa->version != PROP_AREA_VERSION_COMPAT)) {
-        munmap(pa, pa_size);
+        munmap(pa, size);
         return -1;
     }
 
-    if (pa->version == PROP_AREA_VERSION_COMPAT) {
+    area->pa = pa;
+    area->data_size = size - sizeof(prop_area);
+    *version = pa->version;
+    return 0;
+}
+
+static int map_fd_ro(const int fd) {
+    mapped_area area;
+    uint32_t version;
+    if (map_area_ro(fd, &area, &version) < 0) {
+        return -1;
+    }
+
+    pa_size = area.data_size + sizeof(prop_area);
+    pa_data_size = area.data_size;
+    if (version == PROP_AREA_VERSION_COMPAT) {
         compat_mode = true;
     }
 
-    __system_property_area__ = pa;
+    __system_property_area__ = area.pa;
     return 0;
 }
 
@@ -295,11 +402,100 @@ static int map_prop_area()
     return map_result;
 }
 
-static void *allocate_obj(const size_t size, uint32_t *const off)
+static void partition_filename(unsigned n, char *filename)
+{
+    snprintf(filename, PATH_MAX, "%s.%u", property_filename, n);
+}
+
+static prop_partition_table *partition_table()
 {
     prop_area *pa = __system_property_area__;
+    if (!pa || compat_mode || !pa->partitions)
+        return NULL;
+    if (pa->partitions > pa_data_size ||
+            sizeof(prop_partition_table) > pa_data_size - pa->partitions)
+        return NULL;
+
+    return reinterpret_cast<prop_partition_table*>(pa->data + pa->partitions);
+}
+
+// How many partitions there are, or 0 if there's no table.
+static uint32_t partition_count(const prop_partition_table *table)
+{
+    if (!table)
+        return 0;
+    const uint32_t count = table->count;
+    // The entries are filled in before the count covers them.
+    ANDROID_MEMBAR_FULL();
+    return (count <= PA_MAX_PARTITIONS) ? count : 0;
+}
+
+// Returns partition n's area, mapping it if this is its first use, or NULL.
+static const mapped_area *partition_area(unsigned n)
+{
+    prop_area *const owner = __system_property_area__;
+    mapped_area *area = &partition_areas[n];
+    if (area->pa && area->owner == owner)
+        return area;
+
+    ScopedPthreadMutexLocker locker(&partition_areas_lock);
+    if (area->pa && area->owner == owner)
+        return area;
+
+    char filename[PATH_MAX];
+    partition_filename(n, filename);
+    const int fd = open(filename, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    // A stale mapping from a replaced main area is left alone: someone may
+    // still be reading it.
+    mapped_area mapped;
+    uint32_t version;
+    const int map_result = map_area_ro(fd, &mapped, &version);
+    close(fd);
+    if (map_result < 0 || version != PROP_AREA_VERSION)
+        return NULL;
+
+    area->data_size = mapped.data_size;
+    area->owner = owner;
+    ANDROID_MEMBAR_FULL();
+    area->pa = mapped.pa;
+    return area;
+}
+
+// Returns the number of the partition 'name' belongs to, or -1 if it's in
+// the main area.
+static int find_partition(const prop_partition_table *table, const char *name,
+        size_t namelen)
+{
+    const uint32_t count = partition_count(table);
+    int best = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        const prop_partition *partition = &table->partitions[i];
+        const uint8_t len = partition->prefix_len;
+        if (len <= namelen && len < PROP_NAME_MAX &&
+                (best < 0 || len > table->partitions[best].prefix_len) &&
+                !strncmp(name, partition->prefix, len))
+            best = i;
+    }
+    return best;
+}
+
+// Returns the area holding 'name', whether or not it exists, or NULL.
+static const mapped_area *area_for_name(const char *name, size_t namelen,
+        mapped_area *main)
+{
+    *main = main_area();
+    const int n = find_partition(partition_table(), name, namelen);
+    return (n < 0) ? main : partition_area(n);
+}
+
+static void *allocate_obj(const mapped_area *area, const size_t size, uint32_t *const off)
+{
+    prop_area *pa = area->pa;
     const size_t aligned = BIONIC_ALIGN(size, sizeof(uint32_t));
-    if (pa->bytes_used + aligned > pa_data_size) {
+    if (pa->bytes_used + aligned > area->data_size) {
         return NULL;
     }
 
@@ -308,10 +504,11 @@ static void *allocate_obj(const size_t size, uint32_t *const off)
     return pa->data + *off;
 }
 
-static prop_bt *new_prop_bt(const char *name, uint8_t namelen, uint32_t *const off)
+static prop_bt *new_prop_bt(const mapped_area *area, const char *name, uint8_t namelen,
+        uint32_t *const off)
 {
     uint32_t new_offset;
-    void *const offset = allocate_obj(sizeof(prop_bt) + namelen + 1, &new_offset);
+    void *const offset = allocate_obj(area, sizeof(prop_bt) + namelen + 1, &new_offset);
     if (offset) {
         prop_bt* bt = new(offset) prop_bt(name, namelen);
         *off = new_offset;
@@ -321,11 +518,11 @@ static prop_bt *new_prop_bt(const char *name, uint8_t namelen, uint32_t *const o
     return NULL;
 }
 
-static prop_info *new_prop_info(const char *name, uint8_t namelen,
+static prop_info *new_prop_info(const mapped_area *area, const char *name, uint8_t namelen,
         const char *value, uint8_t valuelen, uint32_t *const off)
 {
     uint32_t off_tmp;
-    void* const offset = allocate_obj(sizeof(prop_info) + namelen + 1, &off_tmp);
+    void* const offset = allocate_obj(area, sizeof(prop_info) + namelen + 1, &off_tmp);
     if (offset) {
         prop_info* info = new(offset) prop_info(name, namelen, value, valuelen);
         *off = off_tmp;
@@ -335,19 +532,19 @@ static prop_info *new_prop_info(const char *name, uint8_t namelen,
     return NULL;
 }
 
-static void *to_prop_obj(const uint32_t off)
+static void *to_prop_obj(const mapped_area *area, const uint32_t off)
 {
-    if (off > pa_data_size)
+    if (off > area->data_size)
         return NULL;
-    if (!__system_property_area__)
+    if (!area->pa)
         return NULL;
 
-    return (__system_property_area__->data + off);
+    return (area->pa->data + off);
 }
 
-static prop_bt *root_node()
+static prop_bt *root_node(const mapped_area *area)
 {
-    return reinterpret_cast<prop_bt*>(to_prop_obj(0));
+    return reinterpret_cast<prop_bt*>(to_prop_obj(area, 0));
 }
 
 static int cmp_prop_name(const char *one, uint8_t one_len, const char *two,
@@ -361,7 +558,7 @@ static int cmp_prop_name(const char *one, uint8_t one_len, const char *two,
         return strncmp(one, two, one_len);
 }
 
-static prop_bt *find_prop_bt(prop_bt *const bt, const char *name,
+static prop_bt *find_prop_bt(const mapped_area *area, prop_bt *const bt, const char *name,
                              uint8_t namelen, bool alloc_if_needed)
 {
 
@@ -378,7 +575,7 @@ static prop_bt *find_prop_bt(prop_bt *const bt, const char *name,
 
         if (ret < 0) {
             if (current->left) {
-                current = reinterpret_cast<prop_bt*>(to_prop_obj(current->left));
+                current = reinterpret_cast<prop_bt*>(to_prop_obj(area, current->left));
             } else {
                 if (!alloc_if_needed) {
                    return NULL;
@@ -389,7 +586,7 @@ static prop_bt *find_prop_bt(prop_bt *const bt, const char *name,
                 // that allocates new nodes. Though "bt->left" is volatile, it can't
                 // have changed since the last value was last read.
                 uint32_t new_offset = 0;
-                prop_bt* new_bt = new_prop_bt(name, namelen, &new_offset);
+                prop_bt* new_bt = new_prop_bt(area, name, namelen, &new_offset);
                 if (new_bt) {
                     current->left = new_offset;
                 }
@@ -397,14 +594,14 @@ static prop_bt *find_prop_bt(prop_bt *const bt, const char *name,
             }
         } else {
             if (current->right) {
-                current = reinterpret_cast<prop_bt*>(to_prop_obj(current->right));
+                current = reinterpret_cast<prop_bt*>(to_prop_obj(area, current->right));
             } else {
                 if (!alloc_if_needed) {
                    return NULL;
                 }
 
                 uint32_t new_offset;
-                prop_bt* new_bt = new_prop_bt(name, namelen, &new_offset);
+                prop_bt* new_bt = new_prop_bt(area, name, namelen, &new_offset);
                 if (new_bt) {
                     current->right = new_offset;
                 }
@@ -414,7 +611,7 @@ static prop_bt *find_prop_bt(prop_bt *const bt, const char *name,
     }
 }
 
-static const prop_info *find_property(prop_bt *const trie, const char *name,
+static const prop_info *find_property(const mapped_area *area, prop_bt *const trie, const char *name,
         uint8_t namelen, const char *value, uint8_t valuelen,
         bool alloc_if_needed)
 {
@@ -434,10 +631,10 @@ static const prop_info *find_property(prop_bt *const trie, const char *name,
 
         prop_bt* root = NULL;
         if (current->children) {
-            root = reinterpret_cast<prop_bt*>(to_prop_obj(current->children));
+            root = reinterpret_cast<prop_bt*>(to_prop_obj(area, current->children));
         } else if (alloc_if_needed) {
             uint32_t new_bt_offset;
-            root = new_prop_bt(remaining_name, substr_size, &new_bt_offset);
+            root = new_prop_bt(area, remaining_name, substr_size, &new_bt_offset);
             if (root) {
                 current->children = new_bt_offset;
             }
@@ -447,7 +644,7 @@ static const prop_info *find_property(prop_bt *const trie, const char *name,
             return NULL;
         }
 
-        current = find_prop_bt(root, remaining_name, substr_size, alloc_if_needed);
+        current = find_prop_bt(area, root, remaining_name, substr_size, alloc_if_needed);
         if (!current) {
             return NULL;
         }
@@ -459,10 +656,10 @@ static const prop_info *find_property(prop_bt *const trie, const char *name,
     }
 
     if (current->prop) {
-        return reinterpret_cast<prop_info*>(to_prop_obj(current->prop));
+        return reinterpret_cast<prop_info*>(to_prop_obj(area, current->prop));
     } else if (alloc_if_needed) {
         uint32_t new_info_offset;
-        prop_info* new_info = new_prop_info(name, namelen, value, valuelen, &new_info_offset);
+        prop_info* new_info = new_prop_info(area, name, namelen, value, valuelen, &new_info_offset);
         if (new_info) {
             current->prop = new_info_offset;
         }
@@ -473,7 +670,98 @@ static const prop_info *find_property(prop_bt *const trie, const char *name,
     }
 }
 
-static int send_prop_msg(const prop_msg *msg)
+static uint32_t prop_name_hash(const char *name, uint8_t namelen)
+{
+    // FNV-1a.
+    uint32_t hash = 2166136261u;
+    for (uint8_t i = 0; i < namelen; i++) {
+        hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+    }
+    return hash;
+}
+
+static prop_index_slot *index_slots(const mapped_area *area)
+{
+    const prop_area *pa = area->pa;
+    if (!pa || !pa->index)
+        return NULL;
+
+    // Don't trust the area's writer: check the index fits and is sized right.
+    const uint32_t slots = pa->index_slots;
+    if (slots == 0 || (slots & (slots - 1)) != 0 || pa->index > area->data_size ||
+            slots > (area->data_size - pa->index) / sizeof(prop_index_slot))
+        return NULL;
+
+    return reinterpret_cast<prop_index_slot*>(to_prop_obj(area, pa->index));
+}
+
+/*
+ * Looks a property up in the index. Returns true, with *pi set to the
+ * property or NULL if there's no such property, if the index knows;
+ * returns false if the trie has to be searched instead.
+ */
+static bool find_indexed_property(const mapped_area *area, const char *name, uint8_t namelen,
+        const prop_info **pi)
+{
+    prop_index_slot *slots = index_slots(area);
+    if (!slots)
+        return false;
+
+    const uint32_t mask = area->pa->index_slots - 1;
+    const uint32_t hash = prop_name_hash(name, namelen);
+    for (uint32_t i = hash & mask, probes = 0; probes <= mask; i = (i + 1) & mask, probes++) {
+        const uint32_t off = slots[i].prop;
+        if (!off)
+            break;
+        // The property service fills in the hash, and the prop_info, first.
+        ANDROID_MEMBAR_FULL();
+        if (slots[i].hash != hash)
+            continue;
+        const prop_info *candidate = reinterpret_cast<prop_info*>(to_prop_obj(area, off));
+        if (candidate && strncmp(candidate->name, name, namelen) == 0 &&
+                candidate->name[namelen] == '\0') {
+            *pi = candidate;
+            return true;
+        }
+    }
+
+    if (area->pa->index_full)
+        return false;
+    *pi = NULL;
+    return true;
+}
+
+/* Adds a property that's in the trie to the index, if it isn't already. */
+static void index_property(const mapped_area *area, const char *name, uint8_t namelen,
+        const prop_info *pi)
+{
+    prop_area *pa = area->pa;
+    prop_index_slot *slots = index_slots(area);
+    if (!slots)
+        return;
+
+    const uint32_t off = reinterpret_cast<const char*>(pi) - pa->data;
+    const uint32_t mask = pa->index_slots - 1;
+    const uint32_t hash = prop_name_hash(name, namelen);
+    uint32_t i = hash & mask;
+    // The table is never more than 3/4 full, so this finds a free slot.
+    while (slots[i].prop) {
+        if (slots[i].prop == off)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    if (pa->index_count >= PA_INDEX_MAX_COUNT) {
+        pa->index_full = 1;
+        return;
+    }
+    slots[i].hash = hash;
+    ANDROID_MEMBAR_FULL();
+    slots[i].prop = off;
+    pa->index_count++;
+}
+
+static int connect_prop_service()
 {
     const int fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (fd == -1) {
@@ -491,6 +779,15 @@ static int send_prop_msg(const prop_msg *msg)
         close(fd);
         return -1;
     }
+    return fd;
+}
+
+static int send_prop_msg(const prop_msg *msg)
+{
+    const int fd = connect_prop_service();
+    if (fd == -1) {
+        return -1;
+    }
 
     const int num_bytes = TEMP_FAILURE_RETRY(send(fd, msg, sizeof(prop_msg), 0));
 
@@ -528,6 +825,83 @@ static int send_prop_msg(const prop_msg *msg)
     return result;
 }
 
+struct prop_connection {
+    int fd;       // -1 until the next batch needs it.
+    bool legacy;  // The property service takes one set per connection.
+};
+
+static bool send_all(const int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        const ssize_t num_bytes = TEMP_FAILURE_RETRY(send(fd, buf, len, MSG_NOSIGNAL));
+        if (num_bytes <= 0)
+            return false;
+        buf += num_bytes;
+        len -= num_bytes;
+    }
+    return true;
+}
+
+static void drop_connection(prop_connection *conn)
+{
+    if (conn->fd != -1) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+}
+
+/*
+ * Sends one batch of at most PROP_MSG_BATCH_MAX sets, in 'msgs' after room
+ * for the header, and waits for the reply. Returns 0 on success, -1 on
+ * failure, or 1 if the property service hung up without setting anything
+ * because it doesn't take batches.
+ */
+static int send_prop_batch(prop_connection *conn, prop_msg *msgs, size_t count)
+{
+    if (conn->fd == -1) {
+        conn->fd = connect_prop_service();
+        if (conn->fd == -1)
+            return -1;
+    }
+
+    static_assert(sizeof(prop_msg_batch) == sizeof(prop_msg), "batch header isn't a prop_msg");
+    prop_msg_batch *header = reinterpret_cast<prop_msg_batch*>(msgs);
+    memset(header, 0, sizeof(*header));
+    header->cmd = PROP_MSG_SETPROP_BATCH;
+    header->count = count;
+    if (!send_all(conn->fd, reinterpret_cast<const char*>(msgs), (count + 1) * sizeof(prop_msg))) {
+        // A service that doesn't take batches may hang up before we're done.
+        drop_connection(conn);
+        return 1;
+    }
+
+    // As with single sets, the property service may be slow to get round
+    // to us, and a reply that doesn't come in time is taken as success.
+    // The connection is then out of step, though, so it's dropped.
+    pollfd pollfds[1];
+    pollfds[0].fd = conn->fd;
+    pollfds[0].events = POLLIN;
+    const int poll_result = TEMP_FAILURE_RETRY(poll(pollfds, 1, 250 /* ms */));
+    if (poll_result != 1) {
+        drop_connection(conn);
+        return 0;
+    }
+
+    unsigned applied;
+    const ssize_t num_bytes = TEMP_FAILURE_RETRY(recv(conn->fd, &applied, sizeof(applied),
+                                                      MSG_WAITALL));
+    if (num_bytes <= 0) {
+        // Hanging up with the rest of the batch unread resets the connection.
+        drop_connection(conn);
+        return 1;
+    }
+    if (num_bytes != sizeof(applied)) {
+        drop_connection(conn);
+        return -1;
+    }
+    return (applied == count) ? 0 : -1;
+}
+
 static void find_nth_fn(const prop_info *pi, void *ptr)
 {
     find_nth_cookie *cookie = reinterpret_cast<find_nth_cookie*>(ptr);
@@ -538,31 +912,31 @@ static void find_nth_fn(const prop_info *pi, void *ptr)
     cookie->count++;
 }
 
-static int foreach_property(const uint32_t off,
+static int foreach_property(const mapped_area *area, const uint32_t off,
         void (*propfn)(const prop_info *pi, void *cookie), void *cookie)
 {
-    prop_bt *trie = reinterpret_cast<prop_bt*>(to_prop_obj(off));
+    prop_bt *trie = reinterpret_cast<prop_bt*>(to_prop_obj(area, off));
     if (!trie)
         return -1;
 
     if (trie->left) {
-        const int err = foreach_property(trie->left, propfn, cookie);
+        const int err = foreach_property(area, trie->left, propfn, cookie);
         if (err < 0)
             return -1;
     }
     if (trie->prop) {
-        prop_info *info = reinterpret_cast<prop_info*>(to_prop_obj(trie->prop));
+        prop_info *info = reinterpret_cast<prop_info*>(to_prop_obj(area, trie->prop));
         if (!info)
             return -1;
         propfn(info, cookie);
     }
     if (trie->children) {
-        const int err = foreach_property(trie->children, propfn, cookie);
+        const int err = foreach_property(area, trie->children, propfn, cookie);
         if (err < 0)
             return -1;
     }
     if (trie->right) {
-        const int err = foreach_property(trie->right, propfn, cookie);
+        const int err = foreach_property(area, trie->right, propfn, cookie);
         if (err < 0)
             return -1;
     }
@@ -570,6 +944,170 @@ static int foreach_property(const uint32_t off,
     return 0;
 }
 
+// Returns the trie node for a name of whole '.'-delimited tokens, or NULL if
+// there's none. The root stands for the empty name.
+static prop_bt *find_prefix_node(const mapped_area *area, const char *prefix, size_t len)
+{
+    const char *end = prefix + len;
+    prop_bt *current = root_node(area);
+    if (!len)
+        return current;
+
+    while (current) {
+        const char *sep = reinterpret_cast<const char*>(memchr(prefix, '.', end - prefix));
+        if (!sep)
+            sep = end;
+        if (sep == prefix || !current->children)
+            return NULL;
+        current = find_prop_bt(area,
+                               reinterpret_cast<prop_bt*>(to_prop_obj(area, current->children)),
+                               prefix, sep - prefix, false);
+        if (sep == end)
+            break;
+        prefix = sep + 1;
+    }
+    return current;
+}
+
+// Visits the properties under the siblings at 'off' whose tokens start with
+// 'partial', and everything below them.
+static int foreach_matching_property(const mapped_area *area, const uint32_t off,
+        const char *partial, uint8_t partial_len,
+        void (*propfn)(const prop_info *pi, void *cookie), void *cookie)
+{
+    prop_bt *trie = reinterpret_cast<prop_bt*>(to_prop_obj(area, off));
+    if (!trie)
+        return -1;
+
+    // Siblings are ordered by length first, so a token shorter than 'partial'
+    // only has shorter ones to its left.
+    const bool long_enough = (trie->namelen >= partial_len);
+    if (trie->left && long_enough) {
+        const int err = foreach_matching_property(area, trie->left, partial, partial_len,
+                propfn, cookie);
+        if (err < 0)
+            return -1;
+    }
+    if (long_enough && !strncmp(trie->name, partial, partial_len)) {
+        if (trie->prop) {
+            prop_info *info = reinterpret_cast<prop_info*>(to_prop_obj(area, trie->prop));
+            if (!info)
+                return -1;
+            propfn(info, cookie);
+        }
+        if (trie->children) {
+            const int err = foreach_property(area, trie->children, propfn, cookie);
+            if (err < 0)
+                return -1;
+        }
+    }
+    if (trie->right) {
+        const int err = foreach_matching_property(area, trie->right, partial, partial_len,
+                propfn, cookie);
+        if (err < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+// Visits the properties in one area whose names start with 'prefix'.
+static int foreach_prefix_in_area(const mapped_area *area, const char *prefix, size_t len,
+        void (*propfn)(const prop_info *pi, void *cookie), void *cookie)
+{
+    // Whole tokens lead to a single node; a trailing partial one may match
+    // several of that node's children.
+    const char *last_dot = reinterpret_cast<const char*>(memrchr(prefix, '.', len));
+    const size_t whole_len = last_dot ? last_dot - prefix : 0;
+    const char *partial = last_dot ? last_dot + 1 : prefix;
+    const uint8_t partial_len = len - (partial - prefix);
+
+    if (last_dot && whole_len == 0)
+        return 0;
+    prop_bt *node = find_prefix_node(area, prefix, whole_len);
+    if (!node || !node->children)
+        return 0;
+
+    if (partial_len == 0)
+        return foreach_property(area, node->children, propfn, cookie);
+    return foreach_matching_property(area, node->children, partial, partial_len,
+            propfn, cookie);
+}
+
+struct compat_prefix_cookie {
+    const char *prefix;
+    size_t prefix_len;
+    void (*propfn)(const prop_info *pi, void *cookie);
+    void *cookie;
+};
+
+static void compat_prefix_fn(const prop_info *pi, void *ptr)
+{
+    compat_prefix_cookie *cookie = reinterpret_cast<compat_prefix_cookie*>(ptr);
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+
+    __system_property_read(pi, name, value);
+    if (!strncmp(name, cookie->prefix, cookie->prefix_len))
+        cookie->propfn(pi, cookie->cookie);
+}
+
+static void count_fn(const prop_info *, void *ptr)
+{
+    (*reinterpret_cast<size_t*>(ptr))++;
+}
+
+struct snapshot_cookie {
+    char *buf;
+    size_t size;
+    size_t used;
+    int count;
+    bool torn;  // A property changed while it was being copied.
+};
+
+static void snapshot_fn(const prop_info *pi, void *ptr)
+{
+    snapshot_cookie *cookie = reinterpret_cast<snapshot_cookie*>(ptr);
+    char compat_name[PROP_NAME_MAX];
+    char compat_value[PROP_VALUE_MAX];
+    const char *name;
+    const char *value;
+    size_t value_len;
+    uint32_t serial = 0;
+
+    if (__predict_false(compat_mode)) {
+        value_len = __system_property_read(pi, compat_name, compat_value);
+        name = compat_name;
+        value = compat_value;
+    } else {
+        serial = pi->serial;
+        if (SERIAL_DIRTY(serial)) {
+            cookie->torn = true;
+            return;
+        }
+        name = pi->name;
+        value = pi->value;
+        value_len = SERIAL_VALUE_LEN(serial);
+    }
+
+    const size_t name_size = strlen(name) + 1;
+    const size_t size = name_size + value_len + 1;
+    if (cookie->used + size <= cookie->size) {
+        char *out = cookie->buf + cookie->used;
+        memcpy(out, name, name_size);
+        memcpy(out + name_size, value, value_len);
+        out[name_size + value_len] = '\0';
+    }
+    cookie->used += size;
+    cookie->count++;
+
+    if (!compat_mode) {
+        ANDROID_MEMBAR_FULL();
+        if (serial != pi->serial)
+            cookie->torn = true;
+    }
+}
+
 int __system_properties_init()
 {
     return map_prop_area();
@@ -595,7 +1133,20 @@ const prop_info *__system_property_find(const char *name)
     if (__predict_false(compat_mode)) {
         return __system_property_find_compat(name);
     }
-    return find_property(root_node(), name, strlen(name), NULL, 0, false);
+
+    const size_t namelen = strlen(name);
+    if (namelen >= PROP_NAME_MAX)
+        return NULL;
+
+    mapped_area main;
+    const mapped_area *area = area_for_name(name, namelen, &main);
+    if (!area)
+        return NULL;
+
+    const prop_info *pi;
+    if (find_indexed_property(area, name, namelen, &pi))
+        return pi;
+    return find_property(area, root_node(area), name, namelen, NULL, 0, false);
 }
 
 int __system_property_read(const prop_info *pi, char *name, char *value)
@@ -618,6 +1169,41 @@ int __system_property_read(const prop_info *pi, char *name, char *value)
     }
 }
 
+int __system_property_read_handle(prop_handle *handle, char *value, unsigned *serial)
+{
+    const prop_info *pi = handle->pi;
+    if (!pi) {
+        // Two threads may both find it: they store the same pointer.
+        pi = __system_property_find(handle->name);
+        if (!pi) {
+            value[0] = '\0';
+            *serial = 0;
+            return -1;
+        }
+        handle->pi = pi;
+    }
+
+    if (__predict_false(compat_mode)) {
+        __system_property_read(pi, 0, value);
+        return 1;
+    }
+
+    // A serial being updated is odd, so it never matches a reader's.
+    if (pi->serial == *serial)
+        return 0;
+
+    while (true) {
+        uint32_t current = __system_property_serial(pi);
+        size_t len = SERIAL_VALUE_LEN(current);
+        memcpy(value, pi->value, len + 1);
+        ANDROID_MEMBAR_FULL();
+        if (current == pi->serial) {
+            *serial = current;
+            return 1;
+        }
+    }
+}
+
 int __system_property_get(const char *name, char *value)
 {
     const prop_info *pi = __system_property_find(name);
@@ -651,6 +1237,79 @@ int __system_property_set(const char *key, const char *value)
     return 0;
 }
 
+prop_connection *__system_property_connect(void)
+{
+    prop_connection *conn = reinterpret_cast<prop_connection*>(malloc(sizeof(prop_connection)));
+    if (conn) {
+        conn->fd = -1;
+        conn->legacy = false;
+    }
+    return conn;
+}
+
+void __system_property_disconnect(prop_connection *conn)
+{
+    if (conn) {
+        drop_connection(conn);
+        free(conn);
+    }
+}
+
+int __system_property_connection_set_batch(prop_connection *conn,
+        const char * const *keys, const char * const *values, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (keys[i] == 0 || strlen(keys[i]) >= PROP_NAME_MAX) return -1;
+        if (values[i] != 0 && strlen(values[i]) >= PROP_VALUE_MAX) return -1;
+    }
+
+    prop_msg *msgs = NULL;
+    if (!conn->legacy) {
+        const size_t max = MIN(count, PROP_MSG_BATCH_MAX);
+        msgs = reinterpret_cast<prop_msg*>(calloc(max + 1, sizeof(prop_msg)));
+        if (!msgs)
+            return -1;
+    }
+
+    size_t done = 0;
+    while (done < count && !conn->legacy) {
+        const size_t n = MIN(count - done, PROP_MSG_BATCH_MAX);
+        for (size_t i = 0; i < n; i++) {
+            prop_msg *msg = &msgs[i + 1];
+            memset(msg, 0, sizeof(*msg));
+            msg->cmd = PROP_MSG_SETPROP;
+            strlcpy(msg->name, keys[done + i], sizeof msg->name);
+            strlcpy(msg->value, values[done + i] ? values[done + i] : "", sizeof msg->value);
+        }
+
+        const int result = send_prop_batch(conn, msgs, n);
+        if (result < 0) {
+            free(msgs);
+            return -1;
+        }
+        if (result > 0)
+            conn->legacy = true;
+        else
+            done += n;
+    }
+    free(msgs);
+
+    for (; done < count; done++) {
+        if (__system_property_set(keys[done], values[done]) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int __system_property_set_batch(const char * const *keys,
+        const char * const *values, size_t count)
+{
+    prop_connection conn = { -1, false };
+    const int result = __system_property_connection_set_batch(&conn, keys, values, count);
+    drop_connection(&conn);
+    return result;
+}
+
 int __system_property_update(prop_info *pi, const char *value, unsigned int len)
 {
     prop_area *pa = __system_property_area__;
@@ -684,9 +1343,15 @@ int __system_property_add(const char *name, unsigned int namelen,
     if (namelen < 1)
         return -1;
 
-    pi = find_property(root_node(), name, namelen, value, valuelen, true);
+    mapped_area main;
+    const mapped_area *area = area_for_name(name, namelen, &main);
+    if (!area)
+        return -1;
+
+    pi = find_property(area, root_node(area), name, namelen, value, valuelen, true);
     if (!pi)
         return -1;
+    index_property(area, name, namelen, pi);
 
     pa->serial++;
     __futex_wake(&pa->serial, INT32_MAX);
@@ -714,6 +1379,43 @@ unsigned int __system_property_wait_any(unsigned int serial)
     return pa->serial;
 }
 
+int __system_property_wait_timeout(const prop_info *pi, unsigned int old_serial,
+        const timespec *relative_timeout, unsigned int *new_serial)
+{
+    // The kernel tracks an absolute deadline for us, so spurious wakeups
+    // and updates that leave the serial dirty don't stretch the timeout.
+    timespec deadline;
+    if (relative_timeout) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += relative_timeout->tv_sec;
+        deadline.tv_nsec += relative_timeout->tv_nsec;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    while (true) {
+        uint32_t serial = pi->serial;
+        if (serial != old_serial && !SERIAL_DIRTY(serial)) {
+            *new_serial = serial;
+            return 0;
+        }
+        // __system_property_update wakes pi->serial once the new value is in place.
+        if (__futex_wait_abs_ex(const_cast<volatile uint32_t*>(&pi->serial), true, serial,
+                                false, relative_timeout ? &deadline : NULL) == -ETIMEDOUT) {
+            return -1;
+        }
+    }
+}
+
+unsigned int __system_property_wait(const prop_info *pi, unsigned int old_serial)
+{
+    unsigned int new_serial;
+    __system_property_wait_timeout(pi, old_serial, NULL, &new_serial);
+    return new_serial;
+}
+
 const prop_info *__system_property_find_nth(unsigned n)
 {
     find_nth_cookie cookie(n);
@@ -733,5 +1435,138 @@ int __system_property_foreach(void (*propfn)(const prop_info *pi, void *cookie),
         return __system_property_foreach_compat(propfn, cookie);
     }
 
-    return foreach_property(0, propfn, cookie);
+    const mapped_area main = main_area();
+    if (foreach_property(&main, 0, propfn, cookie) < 0)
+        return -1;
+
+    // Partitions this process can't map are left out.
+    const prop_partition_table *table = partition_table();
+    const uint32_t count = partition_count(table);
+    for (uint32_t i = 0; i < count; i++) {
+        const mapped_area *area = partition_area(i);
+        if (area && foreach_property(area, 0, propfn, cookie) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int __system_property_foreach_prefix(const char *prefix,
+        void (*propfn)(const prop_info *pi, void *cookie), void *cookie)
+{
+    const size_t len = strlen(prefix);
+
+    if (__predict_false(compat_mode)) {
+        compat_prefix_cookie compat_cookie = { prefix, len, propfn, cookie };
+        return __system_property_foreach_compat(compat_prefix_fn, &compat_cookie);
+    }
+
+    if (len >= PROP_NAME_MAX)
+        return 0;
+
+    // Only areas whose partition prefix and 'prefix' overlap can have
+    // matches, and the main area has none if 'prefix' is in a partition.
+    const prop_partition_table *table = partition_table();
+    const uint32_t count = partition_count(table);
+    if (find_partition(table, prefix, len) < 0) {
+        const mapped_area main = main_area();
+        if (foreach_prefix_in_area(&main, prefix, len, propfn, cookie) < 0)
+            return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const prop_partition *partition = &table->partitions[i];
+        const size_t common = MIN(len, partition->prefix_len);
+        if (strncmp(prefix, partition->prefix, common))
+            continue;
+        const mapped_area *area = partition_area(i);
+        if (area && foreach_prefix_in_area(area, prefix, len, propfn, cookie) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+int __system_property_add_partition(const char *prefix)
+{
+    prop_area *pa = __system_property_area__;
+    const size_t len = strlen(prefix);
+
+    if (len < 1 || len >= PROP_NAME_MAX)
+        return -1;
+    if (!pa || compat_mode)
+        return -1;
+
+    if (!pa->partitions) {
+        const mapped_area main = main_area();
+        uint32_t table_offset;
+        if (!allocate_obj(&main, sizeof(prop_partition_table), &table_offset))
+            return -1;
+        pa->partitions = table_offset;
+    }
+    prop_partition_table *table = partition_table();
+    if (!table)
+        return -1;
+
+    const uint32_t n = table->count;
+    if (n >= PA_MAX_PARTITIONS)
+        return -1;
+    for (uint32_t i = 0; i < n; i++) {
+        if (table->partitions[i].prefix_len == len &&
+                !strncmp(table->partitions[i].prefix, prefix, len))
+            return -1;
+    }
+
+    // Properties already added under the prefix would be hidden.
+    size_t existing = 0;
+    __system_property_foreach_prefix(prefix, count_fn, &existing);
+    if (existing)
+        return -1;
+
+    char filename[PATH_MAX];
+    partition_filename(n, filename);
+    mapped_area area;
+    if (create_area(filename, &area) < 0)
+        return -1;
+
+    {
+        ScopedPthreadMutexLocker locker(&partition_areas_lock);
+        partition_areas[n].data_size = area.data_size;
+        partition_areas[n].owner = pa;
+        ANDROID_MEMBAR_FULL();
+        partition_areas[n].pa = area.pa;
+    }
+
+    prop_partition *partition = &table->partitions[n];
+    memcpy(partition->prefix, prefix, len);
+    partition->prefix[len] = '\0';
+    partition->prefix_len = len;
+    ANDROID_MEMBAR_FULL();
+    table->count = n + 1;
+    return 0;
+}
+
+int __system_property_snapshot(const char *prefix, char *buf, size_t size, size_t *needed)
+{
+    prop_area *pa = __system_property_area__;
+
+    // Any update or addition bumps the area serial once it's done, and one
+    // still in progress leaves its property's serial changed or dirty, so a
+    // pass during which neither happens saw every property at once.
+    while (true) {
+        const uint32_t area_serial = pa->serial;
+        ANDROID_MEMBAR_FULL();
+
+        snapshot_cookie cookie = { buf, size, 0, 0, false };
+        if (__system_property_foreach_prefix(prefix, snapshot_fn, &cookie) < 0)
+            return -1;
+
+        ANDROID_MEMBAR_FULL();
+        if (!cookie.torn && (compat_mode || area_serial == pa->serial)) {
+            if (needed)
+                *needed = cookie.used;
+            return (cookie.used <= size) ? cookie.count : -1;
+        }
+        if (cookie.torn) {
+            // Don't spin while the property service is mid-update.
+            __system_property_wait_any(area_serial);
+        }
+    }
 }
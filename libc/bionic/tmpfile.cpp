@@ -31,6 +31,7 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -56,10 +57,20 @@ class ScopedSignalBlocker {
   sigset_t old_set_;
 };
 
-static FILE* __tmpfile_dir(const char* tmp_dir) {
+// Creates an unnamed file in tmp_dir with O_TMPFILE, which needs Linux 3.11 and a file
+// system that supports it. There's no name to make up, retry or unlink, and the file
+// never appears in the directory, so there's nothing for a signal handler to leave behind.
+static int __tmpfile_fd_unnamed(const char* tmp_dir) {
+  // Kernels that don't know O_TMPFILE see O_DIRECTORY and fail with EISDIR; file systems that
+  // don't support it fail with EOPNOTSUPP. Either way the caller falls back to mkstemp.
+  ErrnoRestorer errno_restorer;
+  return open(tmp_dir, O_TMPFILE | O_RDWR, 0600);
+}
+
+static int __tmpfile_fd_named(const char* tmp_dir) {
   char* path = NULL;
   if (asprintf(&path, "%s/tmp.XXXXXXXXXX", tmp_dir) == -1) {
-    return NULL;
+    return -1;
   }
 
   int fd;
@@ -68,7 +79,7 @@ static FILE* __tmpfile_dir(const char* tmp_dir) {
     fd = mkstemp(path);
     if (fd == -1) {
       free(path);
-      return NULL;
+      return -1;
     }
 
     // Unlink the file now so that it's removed when closed.
@@ -82,6 +93,17 @@ static FILE* __tmpfile_dir(const char* tmp_dir) {
     if (rc == -1) {
       ErrnoRestorer errno_restorer;
       close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
+
+static FILE* __tmpfile_dir(const char* tmp_dir) {
+  int fd = __tmpfile_fd_unnamed(tmp_dir);
+  if (fd == -1) {
+    fd = __tmpfile_fd_named(tmp_dir);
+    if (fd == -1) {
       return NULL;
     }
   }
@@ -92,7 +114,7 @@ static FILE* __tmpfile_dir(const char* tmp_dir) {
     return fp;
   }
 
-  // Failure. Clean up. We already unlinked, so we just need to close.
+  // Failure. Clean up. The file has no name, so we just need to close.
   ErrnoRestorer errno_restorer;
   close(fd);
   return NULL;
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/tree_walk.h>
+
+#include <android/parallel.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct TreeWalk {
+  int flags;
+  int (*fn)(const android_walk_entry*, void*);
+  void* cookie;
+  dev_t root_dev;
+  android_task_group_t* group;
+  // The value that stopped the walk, or 0.
+  atomic_int result;
+};
+
+// A directory still to be visited and read. Directories are found by path
+// rather than kept open, so that a wide tree can't run us out of fds.
+struct DirectoryTask {
+  TreeWalk* walk;
+  int depth;
+  char path[0];
+};
+
+// The DT_ values are the S_IF values shifted down.
+static unsigned char TypeOf(mode_t mode) {
+  return (mode & S_IFMT) >> 12;
+}
+
+static const char* NameOf(const char* path) {
+  const char* slash = strrchr(path, '/');
+  return (slash != NULL && slash[1] != '\0') ? slash + 1 : path;
+}
+
+static bool Stopped(TreeWalk* walk) {
+  return atomic_load_explicit(&walk->result, memory_order_relaxed) != 0;
+}
+
+// Returns what the callback did, having recorded it if it stops the walk.
+static int Visit(TreeWalk* walk, const android_walk_entry* entry) {
+  int rc = walk->fn(entry, walk->cookie);
+  if (rc != 0 && rc != ANDROID_WALK_SKIP) {
+    int expected = 0;
+    atomic_compare_exchange_strong(&walk->result, &expected, rc);
+  }
+  return rc;
+}
+
+static void ReadDirectory(void* arg);
+
+// Queues the directory 'path' to be visited and read, or visits it with an
+// error if it can't be queued.
+static void SubmitDirectory(TreeWalk* walk, const char* path, size_t path_length, int depth) {
+  DirectoryTask* task = reinterpret_cast<DirectoryTask*>(malloc(sizeof(DirectoryTask) + path_length + 1));
+  if (task == NULL) {
+    android_walk_entry entry;
+    entry.path = path;
+    entry.name = NameOf(path);
+    entry.depth = depth;
+    entry.type = DT_DIR;
+    entry.error = ENOMEM;
+    entry.st = NULL;
+    Visit(walk, &entry);
+    return;
+  }
+  task->walk = walk;
+  task->depth = depth;
+  memcpy(task->path, path, path_length + 1);
+  android_task_submit(walk->group, ReadDirectory, task);
+}
+
+static void ReadDirectory(void* arg) {
+  DirectoryTask* task = reinterpret_cast<DirectoryTask*>(arg);
+  TreeWalk* walk = task->walk;
+  if (Stopped(walk)) {
+    free(task);
+    return;
+  }
+
+  android_walk_entry entry;
+  entry.path = task->path;
+  entry.name = NameOf(task->path);
+  entry.depth = task->depth;
+  entry.type = DT_DIR;
+  entry.error = 0;
+  entry.st = NULL;
+
+  // Only the root may be reached through a symbolic link.
+  int fd = open(task->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (task->depth > 0 ? O_NOFOLLOW : 0));
+  struct stat sb;
+  bool descend = true;
+  if (fd == -1) {
+    entry.error = errno;
+    descend = false;
+  } else if ((walk->flags & (ANDROID_WALK_STAT | ANDROID_WALK_XDEV)) != 0) {
+    if (fstat(fd, &sb) == -1) {
+      entry.error = errno;
+    } else {
+      if ((walk->flags & ANDROID_WALK_STAT) != 0) {
+        entry.st = &sb;
+      }
+      if ((walk->flags & ANDROID_WALK_XDEV) != 0 && sb.st_dev != walk->root_dev) {
+        descend = false;
+      }
+    }
+  }
+
+  if (Visit(walk, &entry) != 0 || !descend) {
+    if (fd != -1) {
+      close(fd);
+    }
+    free(task);
+    return;
+  }
+
+  DIR* dir = fdopendir(fd);
+  if (dir == NULL) {
+    close(fd);
+    free(task);
+    return;
+  }
+
+  char path[PATH_MAX];
+  size_t prefix_length = strlen(task->path);
+  memcpy(path, task->path, prefix_length);
+  if (prefix_length == 0 || path[prefix_length - 1] != '/') {
+    path[prefix_length++] = '/';
+  }
+
+  dirent* e;
+  while (!Stopped(walk) && (e = readdir(dir)) != NULL) {
+    const char* name = e->d_name;
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+      continue;
+    }
+
+    android_walk_entry child;
+    child.path = path;
+    child.name = path + prefix_length;
+    child.depth = task->depth + 1;
+    child.type = e->d_type;
+    child.error = 0;
+    child.st = NULL;
+
+    size_t name_length = strlen(name);
+    if (prefix_length + name_length >= sizeof(path)) {
+      // Report what we can.
+      child.path = child.name = name;
+      child.error = ENAMETOOLONG;
+      Visit(walk, &child);
+      continue;
+    }
+    memcpy(path + prefix_length, name, name_length + 1);
+
+    if (child.type == DT_UNKNOWN || (walk->flags & ANDROID_WALK_STAT) != 0) {
+      // Relative to the directory, so the kernel doesn't walk 'path' again.
+      if (fstatat(dirfd(dir), name, &sb, AT_SYMLINK_NOFOLLOW) == -1) {
+        child.error = errno;
+      } else {
+        child.type = TypeOf(sb.st_mode);
+        if ((walk->flags & ANDROID_WALK_STAT) != 0) {
+          child.st = &sb;
+        }
+      }
+    }
+
+    if (child.type == DT_DIR && child.error == 0) {
+      // Visited when it's read.
+      SubmitDirectory(walk, path, prefix_length + name_length, child.depth);
+    } else {
+      Visit(walk, &child);
+    }
+  }
+
+  closedir(dir);
+  free(task);
+}
+
+int android_walk_tree(const char* root, int flags,
+                      int (*fn)(const android_walk_entry*, void*), void* cookie) {
+  if (root == NULL || fn == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct stat sb;
+  if (stat(root, &sb) == -1) {
+    return -1;
+  }
+  if (!S_ISDIR(sb.st_mode)) {
+    android_walk_entry entry;
+    entry.path = root;
+    entry.name = NameOf(root);
+    entry.depth = 0;
+    entry.type = TypeOf(sb.st_mode);
+    entry.error = 0;
+    entry.st = (flags & ANDROID_WALK_STAT) ? &sb : NULL;
+    int rc = fn(&entry, cookie);
+    return (rc == ANDROID_WALK_SKIP) ? 0 : rc;
+  }
+
+  TreeWalk walk;
+  walk.flags = flags;
+  walk.fn = fn;
+  walk.cookie = cookie;
+  walk.root_dev = sb.st_dev;
+  atomic_init(&walk.result, 0);
+  walk.group = android_task_group_create();
+  if (walk.group == NULL) {
+    return -1;
+  }
+
+  SubmitDirectory(&walk, root, strlen(root), 0);
+  android_task_group_wait(walk.group);
+  android_task_group_destroy(walk.group);
+  return atomic_load(&walk.result);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define _SEARCH_PRIVATE
+#include <search.h>
+#include <stdlib.h>
+
+// tsearch(3) and friends, as an AVL tree. The old unbalanced tree turned
+// into a linked list when keys were inserted in order, which is how most
+// callers insert them. Nodes never move or change key once made, so the
+// node pointers callers hold stay good across other insertions and
+// deletions.
+
+// An AVL tree of height h has at least fib(h + 2) - 1 nodes, so no tree
+// that fits in memory is anywhere near this tall.
+static const size_t kMaxHeight = 128;
+
+static inline int height(const node_t* n) {
+  return (n != NULL) ? n->height : 0;
+}
+
+static inline void update_height(node_t* n) {
+  int l = height(n->llink);
+  int r = height(n->rlink);
+  n->height = ((l > r) ? l : r) + 1;
+}
+
+static node_t* rotate_left(node_t* n) {
+  node_t* r = n->rlink;
+  n->rlink = r->llink;
+  r->llink = n;
+  update_height(n);
+  update_height(r);
+  return r;
+}
+
+static node_t* rotate_right(node_t* n) {
+  node_t* l = n->llink;
+  n->llink = l->rlink;
+  l->rlink = n;
+  update_height(n);
+  update_height(l);
+  return l;
+}
+
+// Restores the balance of the subtree at *link after one of its children
+// changed height by one. Returns whether the subtree's height changed.
+static bool rebalance(node_t** link) {
+  node_t* n = *link;
+  int old_height = n->height;
+  int balance = height(n->llink) - height(n->rlink);
+  if (balance > 1) {
+    if (height(n->llink->llink) < height(n->llink->rlink)) {
+      n->llink = rotate_left(n->llink);
+    }
+    *link = rotate_right(n);
+  } else if (balance < -1) {
+    if (height(n->rlink->rlink) < height(n->rlink->llink)) {
+      n->rlink = rotate_right(n->rlink);
+    }
+    *link = rotate_left(n);
+  } else {
+    update_height(n);
+  }
+  return (*link)->height != old_height;
+}
+
+void* tfind(const void* key, void* const* rootp, int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+  node_t* n = reinterpret_cast<node_t*>(*rootp);
+  while (n != NULL) {
+    int r = compar(key, n->key);
+    if (r == 0) {
+      return n;
+    }
+    n = (r < 0) ? n->llink : n->rlink;
+  }
+  return NULL;
+}
+
+void* tsearch(const void* key, void** rootp, int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+
+  // Remember the links we follow so we can rebalance on the way back up.
+  node_t** path[kMaxHeight];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(rootp);
+  while (*link != NULL) {
+    int r = compar(key, (*link)->key);
+    if (r == 0) {
+      return *link;
+    }
+    path[depth++] = link;
+    link = (r < 0) ? &(*link)->llink : &(*link)->rlink;
+  }
+
+  node_t* n = reinterpret_cast<node_t*>(malloc(sizeof(node_t)));
+  if (n == NULL) {
+    return NULL;
+  }
+  n->key = const_cast<char*>(reinterpret_cast<const char*>(key));
+  n->llink = n->rlink = NULL;
+  n->height = 1;
+  *link = n;
+
+  while (depth > 0 && rebalance(path[--depth])) {
+  }
+  return n;
+}
+
+void* tdelete(const void* __restrict key, void** __restrict rootp,
+              int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+
+  node_t** path[kMaxHeight];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(rootp);
+  while (true) {
+    if (*link == NULL) {
+      return NULL;
+    }
+    int r = compar(key, (*link)->key);
+    if (r == 0) {
+      break;
+    }
+    path[depth++] = link;
+    link = (r < 0) ? &(*link)->llink : &(*link)->rlink;
+  }
+
+  // Like the old implementation, we return the deleted node's parent, or
+  // some other non-NULL pointer if the deleted node was the root.
+  void* result = (depth > 0) ? *path[depth - 1] : reinterpret_cast<void*>(1);
+
+  node_t* victim = *link;
+  if (victim->llink == NULL || victim->rlink == NULL) {
+    *link = (victim->llink != NULL) ? victim->llink : victim->rlink;
+  } else {
+    // Move the successor node (not just its key) into the victim's place,
+    // so that callers' pointers to it stay good.
+    size_t victim_depth = depth;
+    path[depth++] = link;
+    node_t** successor_link = &victim->rlink;
+    while ((*successor_link)->llink != NULL) {
+      path[depth++] = successor_link;
+      successor_link = &(*successor_link)->llink;
+    }
+    node_t* successor = *successor_link;
+    *successor_link = successor->rlink;
+    successor->llink = victim->llink;
+    successor->rlink = victim->rlink;
+    successor->height = victim->height;
+    *link = successor;
+    // The path went through the victim's right link, which is now the successor's.
+    if (depth > victim_depth + 1) {
+      path[victim_depth + 1] = &successor->rlink;
+    }
+  }
+  free(victim);
+
+  while (depth > 0 && rebalance(path[--depth])) {
+  }
+  return result;
+}
+
+static void trecurse(const node_t* n, void (*action)(const void*, VISIT, int), int level) {
+  if (n->llink == NULL && n->rlink == NULL) {
+    action(n, leaf, level);
+  } else {
+    action(n, preorder, level);
+    if (n->llink != NULL) {
+      trecurse(n->llink, action, level + 1);
+    }
+    action(n, postorder, level);
+    if (n->rlink != NULL) {
+      trecurse(n->rlink, action, level + 1);
+    }
+    action(n, endorder, level);
+  }
+}
+
+void twalk(const void* root, void (*action)(const void*, VISIT, int)) {
+  if (root != NULL && action != NULL) {
+    trecurse(reinterpret_cast<const node_t*>(root), action, 0);
+  }
+}
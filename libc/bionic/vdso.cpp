@@ -14,25 +14,42 @@
  * limitations under the License.
  */
 
+#include <android/fast_clock.h>
+#include <errno.h>
 #include <link.h>
+#include <string.h>
 #include <sys/auxv.h>
+#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
-// x86 has a vdso, but there's nothing useful to us in it.
-#if defined(__aarch64__) || defined(__x86_64__)
+#include "private/bionic_percpu.h"
 
+extern "C" int __clock_getres(int, timespec*);
+extern "C" int __clock_gettime(int, timespec*);
+extern "C" int __getcpu(unsigned*, unsigned*, void*);
+extern "C" int __gettimeofday(timeval*, struct timezone*);
+
+// The symbols each architecture's vdso may export. Older kernels export
+// fewer of them (32-bit arm only got a vdso in 4.1, and most only added
+// clock_getres in 5.x), and whatever we don't find falls back to the system
+// call. Only x86 has a vdso time, so elsewhere time reads the coarse clock.
 #if defined(__aarch64__)
+#define VDSO_CLOCK_GETRES_SYMBOL  "__kernel_clock_getres"
 #define VDSO_CLOCK_GETTIME_SYMBOL "__kernel_clock_gettime"
 #define VDSO_GETTIMEOFDAY_SYMBOL  "__kernel_gettimeofday"
-#elif defined(__x86_64__)
+#else
+#define VDSO_CLOCK_GETRES_SYMBOL  "__vdso_clock_getres"
 #define VDSO_CLOCK_GETTIME_SYMBOL "__vdso_clock_gettime"
 #define VDSO_GETTIMEOFDAY_SYMBOL  "__vdso_gettimeofday"
 #endif
-
-#include <time.h>
-
-extern "C" int __clock_gettime(int, timespec*);
-extern "C" int __gettimeofday(timeval*, struct timezone*);
+#if defined(__i386__) || defined(__x86_64__)
+#define VDSO_GETCPU_SYMBOL        "__vdso_getcpu"
+#define VDSO_TIME_SYMBOL          "__vdso_time"
+#else
+#define VDSO_GETCPU_SYMBOL        NULL
+#define VDSO_TIME_SYMBOL          NULL
+#endif
 
 struct vdso_entry {
   const char* name;
@@ -40,26 +57,93 @@ struct vdso_entry {
 };
 
 enum {
-  VDSO_CLOCK_GETTIME = 0,
+  VDSO_CLOCK_GETRES = 0,
+  VDSO_CLOCK_GETTIME,
+  VDSO_GETCPU,
   VDSO_GETTIMEOFDAY,
+  VDSO_TIME,
   VDSO_END
 };
 
 static vdso_entry vdso_entries[] = {
+  [VDSO_CLOCK_GETRES] = { VDSO_CLOCK_GETRES_SYMBOL, reinterpret_cast<void*>(__clock_getres) },
   [VDSO_CLOCK_GETTIME] = { VDSO_CLOCK_GETTIME_SYMBOL, reinterpret_cast<void*>(__clock_gettime) },
+  [VDSO_GETCPU] = { VDSO_GETCPU_SYMBOL, reinterpret_cast<void*>(__getcpu) },
   [VDSO_GETTIMEOFDAY] = { VDSO_GETTIMEOFDAY_SYMBOL, reinterpret_cast<void*>(__gettimeofday) },
+  [VDSO_TIME] = { VDSO_TIME_SYMBOL, NULL },
 };
 
+// The vdso functions return -errno, as the raw system call would; the
+// fallbacks are our system call stubs, which have already set errno.
+static inline int vdso_result(bool is_vdso, int rc) {
+  if (is_vdso && rc < 0) {
+    errno = -rc;
+    return -1;
+  }
+  return rc;
+}
+
+int clock_getres(int clock_id, timespec* tp) {
+  static int (*vdso_clock_getres)(int, timespec*) =
+      (int (*)(int, timespec*)) vdso_entries[VDSO_CLOCK_GETRES].fn;
+  int rc = vdso_clock_getres(clock_id, tp);
+  return vdso_result(vdso_clock_getres != __clock_getres, rc);
+}
+
 int clock_gettime(int clock_id, timespec* tp) {
   static int (*vdso_clock_gettime)(int, timespec*) =
       (int (*)(int, timespec*)) vdso_entries[VDSO_CLOCK_GETTIME].fn;
-  return vdso_clock_gettime(clock_id, tp);
+  int rc = vdso_clock_gettime(clock_id, tp);
+  return vdso_result(vdso_clock_gettime != __clock_gettime, rc);
 }
 
 int gettimeofday(timeval* tv, struct timezone* tz) {
   static int (*vdso_gettimeofday)(timeval*, struct timezone*) =
       (int (*)(timeval*, struct timezone*)) vdso_entries[VDSO_GETTIMEOFDAY].fn;
-  return vdso_gettimeofday(tv, tz);
+  int rc = vdso_gettimeofday(tv, tz);
+  return vdso_result(vdso_gettimeofday != __gettimeofday, rc);
+}
+
+time_t time(time_t* t) {
+  static time_t (*vdso_time)(time_t*) =
+      (time_t (*)(time_t*)) vdso_entries[VDSO_TIME].fn;
+  if (vdso_time != NULL) {
+    return vdso_time(t);
+  }
+
+  // The coarse clock is the one the kernel's own time(2) reads.
+  timespec ts;
+  if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == -1) {
+    return -1;
+  }
+  if (t != NULL) {
+    *t = ts.tv_sec;
+  }
+  return ts.tv_sec;
+}
+
+static int64_t vdso_clock_ns(clockid_t clock_id) {
+  static int (*vdso_clock_gettime)(int, timespec*) =
+      (int (*)(int, timespec*)) vdso_entries[VDSO_CLOCK_GETTIME].fn;
+  timespec ts;
+  vdso_clock_gettime(clock_id, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t android_coarse_monotonic_ns() {
+  return vdso_clock_ns(CLOCK_MONOTONIC_COARSE);
+}
+
+int64_t android_coarse_realtime_ns() {
+  return vdso_clock_ns(CLOCK_REALTIME_COARSE);
+}
+
+int __libc_getcpu() {
+  static int (*vdso_getcpu)(unsigned*, unsigned*, void*) =
+      (int (*)(unsigned*, unsigned*, void*)) vdso_entries[VDSO_GETCPU].fn;
+  unsigned cpu;
+  int rc = vdso_getcpu(&cpu, NULL, NULL);
+  return (rc < 0) ? -1 : cpu;
 }
 
 void __libc_init_vdso() {
@@ -114,16 +198,11 @@ void __libc_init_vdso() {
   // Are there any symbols we want?
   for (size_t i = 0; i < symbol_count; ++i) {
     for (size_t j = 0; j < VDSO_END; ++j) {
-      if (strcmp(vdso_entries[j].name, strtab + symtab[i].st_name) == 0) {
+      if (vdso_entries[j].name != NULL &&
+          strcmp(vdso_entries[j].name, strtab + symtab[i].st_name) == 0) {
         vdso_entries[j].fn = reinterpret_cast<void*>(vdso_addr + symtab[i].st_value);
       }
     }
   }
 }
 
-#else
-
-void __libc_init_vdso() {
-}
-
-#endif
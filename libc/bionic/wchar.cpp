@@ -33,6 +33,7 @@
 #include <uchar.h>
 
 #include "private/bionic_mbstate.h"
+#include "private/bionic_utf8.h"
 
 //
 // This file is basically OpenBSD's citrus_utf8.c but rewritten to not require a
@@ -52,6 +53,10 @@
 // We also implement the POSIX interface directly rather than being accessed via
 // function pointers.
 //
+// The string conversions skip runs of ASCII in bulk and decode complete
+// multibyte characters inline (see private/bionic_utf8.h), only calling
+// mbrtowc and wcrtomb for partial sequences, errors and carried-over state.
+//
 
 int mbsinit(const mbstate_t* ps) {
   return (ps == NULL || ps->__seq32 == 0);
@@ -81,6 +86,13 @@ size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstat
       return reset_and_return_illegal(EILSEQ, state);
     }
     for (i = o = 0; i < nmc; i += r, o++) {
+      size_t run = utf8_ascii_prefix(*src + i, nmc - i);
+      i += run;
+      o += run;
+      if (i == nmc) {
+        break;
+      }
+      char32_t c32;
       if (static_cast<uint8_t>((*src)[i]) < 0x80) {
         // Fast path for plain ASCII characters.
         if ((*src)[i] == '\0') {
@@ -88,7 +100,9 @@ size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstat
           return reset_and_return(o, state);
         }
         r = 1;
-      } else {
+      } else if (!mbsinit(state) || (r = utf8_decode_multibyte(*src + i, nmc - i, &c32)) == 0) {
+        // Only partial or invalid characters, and ones continuing a sequence
+        // from an earlier call, need the full decoder.
         r = mbrtowc(NULL, *src + i, nmc - i, state);
         if (r == __MB_ERR_ILLEGAL_SEQUENCE) {
           return reset_and_return_illegal(EILSEQ, state);
@@ -115,6 +129,16 @@ size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstat
     return reset_and_return_illegal(EILSEQ, state);
   }
   for (i = o = 0; i < nmc && o < len; i += r, o++) {
+    size_t run = utf8_ascii_prefix(*src + i, MIN(nmc - i, len - o));
+    for (size_t k = 0; k < run; ++k) {
+      dst[o + k] = static_cast<uint8_t>((*src)[i + k]);
+    }
+    i += run;
+    o += run;
+    if (i == nmc || o == len) {
+      break;
+    }
+    char32_t c32;
     if (static_cast<uint8_t>((*src)[i]) < 0x80) {
       // Fast path for plain ASCII characters.
       dst[o] = (*src)[i];
@@ -123,6 +147,9 @@ size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstat
         *src = nullptr;
         return reset_and_return(o, state);
       }
+    } else if (mbsinit(state) && (r = utf8_decode_multibyte(*src + i, nmc - i, &c32)) != 0) {
+      // Fast path for complete, valid multibyte characters.
+      dst[o] = c32;
     } else {
       r = mbrtowc(dst + o, *src + i, nmc - i, state);
       if (r == __MB_ERR_ILLEGAL_SEQUENCE) {
@@ -167,6 +194,12 @@ size_t wcsnrtombs(char* dst, const wchar_t** src, size_t nwc, size_t len, mbstat
   size_t i, o, r;
   if (dst == NULL) {
     for (i = o = 0; i < nwc; i++, o += r) {
+      size_t run = wcs_ascii_prefix(*src + i, nwc - i);
+      i += run;
+      o += run;
+      if (i == nwc) {
+        break;
+      }
       wchar_t wc = (*src)[i];
       if (static_cast<uint32_t>(wc) < 0x80) {
         // Fast path for plain ASCII characters.
@@ -185,6 +218,15 @@ size_t wcsnrtombs(char* dst, const wchar_t** src, size_t nwc, size_t len, mbstat
   }
 
   for (i = o = 0; i < nwc && o < len; i++, o += r) {
+    size_t run = wcs_ascii_prefix(*src + i, MIN(nwc - i, len - o));
+    for (size_t k = 0; k < run; ++k) {
+      dst[o + k] = (*src)[i + k];
+    }
+    i += run;
+    o += run;
+    if (i == nwc || o == len) {
+      break;
+    }
     wchar_t wc = (*src)[i];
     if (static_cast<uint32_t>(wc) < 0x80) {
       // Fast path for plain ASCII characters.
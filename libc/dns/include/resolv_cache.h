@@ -43,7 +43,11 @@ typedef enum {
     RESOLV_CACHE_UNSUPPORTED,  /* the cache can't handle that kind of queries */
                                /* or the answer buffer is too small */
     RESOLV_CACHE_NOTFOUND,     /* the cache doesn't know about this query */
-    RESOLV_CACHE_FOUND         /* the cache found the answer */
+    RESOLV_CACHE_FOUND,        /* the cache found the answer */
+    RESOLV_CACHE_REFRESH       /* the cache found the answer, but it's expired */
+                               /* or about to, so the caller should send the */
+                               /* query again in the background and add (or */
+                               /* report the failure of) the new answer */
 } ResolvCacheStatus;
 
 __LIBC_HIDDEN__
@@ -55,8 +59,17 @@ _resolv_cache_lookup( unsigned              netid,
                       int                   answersize,
                       int                  *answerlen );
 
+/* returns 1 if _resolv_cache_lookup would answer the query from the cache
+ * right now. Unlike it, doesn't mark the query pending, wait for anyone else
+ * asking the same question, or count a hit or miss */
+__LIBC_HIDDEN__
+extern int
+_resolv_cache_has_answer( unsigned     netid,
+                          const void*  query,
+                          int          querylen );
+
 /* add a (query,answer) to the cache, only call if _resolv_cache_lookup
- * did return RESOLV_CACHE_NOTFOUND
+ * did return RESOLV_CACHE_NOTFOUND or RESOLV_CACHE_REFRESH
  */
 __LIBC_HIDDEN__
 extern void
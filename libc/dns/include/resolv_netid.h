@@ -34,6 +34,7 @@
  */
 #include <sys/cdefs.h>
 #include <netinet/in.h>
+#include <stddef.h>
 
 /*
  * Passing NETID_UNSET as the netId causes system/netd/server/DnsProxyListener.cpp to
@@ -67,6 +68,28 @@ extern void _resolv_flush_cache_for_net(unsigned netid) __used_in_netd;
 /* delete the cache associated with a certain network */
 extern void _resolv_delete_cache_for_net(unsigned netid) __used_in_netd;
 
+/* set the most memory, in bytes, the cache associated with a certain network
+ * may use; 0 restores the default (the net.dns.cache_bytes property, if set) */
+extern void _resolv_set_cache_size_for_net(unsigned netid, size_t max_bytes) __used_in_netd;
+
+struct resolv_cache_stats {
+    size_t         max_bytes;
+    size_t         bytes;        /* used by the entries now cached */
+    unsigned       entries;
+    unsigned long  hits;
+    unsigned long  misses;
+    unsigned long  expirations;  /* entries dropped because their TTL passed */
+    unsigned long  evictions;    /* live entries dropped to make room */
+    unsigned long  stale_hits;   /* expired entries served while being refreshed */
+    unsigned long  refreshes;    /* background refreshes of popular entries */
+    unsigned long  nx_hits;      /* hits on names an earlier NXDOMAIN answer ruled out */
+};
+
+/* get the statistics of the cache associated with a certain network;
+ * returns 0, or -1 if the network has no cache */
+extern int _resolv_get_cache_stats_for_net(unsigned netid,
+    struct resolv_cache_stats* stats) __used_in_netd;
+
 /* Internal use only. */
 struct hostent *android_gethostbyaddrfornet_proxy(const void *, socklen_t, int , unsigned);
 int android_getnameinfofornet(const struct sockaddr *, socklen_t, char *, size_t, char *, size_t,
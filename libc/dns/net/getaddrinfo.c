@@ -92,6 +92,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <netdb.h>
+#include <pthread.h>
 #include "NetdClientDispatch.h"
 #include "resolv_cache.h"
 #include "resolv_netid.h"
@@ -214,6 +215,13 @@ struct res_target {
 	u_char *answer;		/* buffer to put answer */
 	int anslen;		/* size of answer buffer */
 	int n;			/* result length */
+	int qlen;		/* res_nmkquery result */
+	int rlen;		/* res_nsend result */
+	int threaded;		/* sent from 'thread' */
+	pthread_t thread;
+	const char *qname;	/* name to send, for 'thread' */
+	u_long options;		/* copied from the caller's res_state */
+	unsigned netid, mark;
 };
 
 static int str2number(const char *);
@@ -2131,6 +2139,96 @@ _files_getaddrinfo(void *rv, void *cb_data, va_list ap)
 
 /* resolver logic */
 
+/* Builds the query for t in buf, returning its length or -1. */
+static int
+res_queryN_mkquery(const char *name, struct res_target *t, res_state res,
+    u_char *buf, int buflen)
+{
+	int qlen;
+
+	qlen = res_nmkquery(res, QUERY, name, t->qclass, t->qtype, NULL, 0,
+	    NULL, buf, buflen);
+#ifdef RES_USE_EDNS0
+	if (qlen > 0 && (res->_flags & RES_F_EDNS0ERR) == 0 &&
+	    (res->options & (RES_USE_EDNS0|RES_USE_DNSSEC)) != 0U)
+		qlen = res_nopt(res, qlen, buf, buflen, t->anslen);
+#endif
+	return qlen;
+}
+
+/* Returns whether res_nsend would answer t's query from the cache. */
+static int
+res_queryN_cached(const char *name, struct res_target *t, res_state res)
+{
+	u_char buf[MAXPACKET];
+	int qlen;
+
+	qlen = res_queryN_mkquery(name, t, res, buf, sizeof(buf));
+	return qlen > 0 && _resolv_cache_has_answer(res->netid, buf, qlen);
+}
+
+static void
+res_queryN_send(const char *name, struct res_target *t, res_state res)
+{
+	u_char buf[MAXPACKET];
+	HEADER *hp;
+	u_int oflags;
+
+	hp = (HEADER *)(void *)t->answer;
+	oflags = res->_flags;
+
+again:
+	hp->rcode = NOERROR;	/* default */
+	t->rlen = -1;
+
+#ifdef DEBUG
+	if (res->options & RES_DEBUG)
+		printf(";; res_nquery(%s, %d, %d)\n", name, t->qclass, t->qtype);
+#endif
+
+	t->qlen = res_queryN_mkquery(name, t, res, buf, sizeof(buf));
+	if (t->qlen <= 0) {
+#ifdef DEBUG
+		if (res->options & RES_DEBUG)
+			printf(";; res_nquery: mkquery failed\n");
+#endif
+		return;
+	}
+	t->rlen = res_nsend(res, buf, t->qlen, t->answer, t->anslen);
+#ifdef RES_USE_EDNS0
+	/* if the query choked with EDNS0, retry without EDNS0 */
+	if (t->rlen < 0 && (res->options & (RES_USE_EDNS0|RES_USE_DNSSEC)) != 0U &&
+	    ((oflags ^ res->_flags) & RES_F_EDNS0ERR) != 0) {
+#ifdef DEBUG
+		if (res->options & RES_DEBUG)
+			printf(";; res_nquery: retry without EDNS0\n");
+#endif
+		oflags = res->_flags;	/* only retry once */
+		goto again;
+	}
+#endif
+}
+
+static void *
+res_queryN_thread(void *arg)
+{
+	struct res_target *t = arg;
+	res_state res;
+
+	/* Each thread has a resolver state of its own. */
+	res = __res_get_state();
+	if (res == NULL) {
+		t->qlen = -1;
+		return NULL;
+	}
+	res->options = t->options;
+	res_setnetid(res, t->netid);
+	res_setmark(res, t->mark);
+	res_queryN_send(t->qname, t, res);
+	__res_put_state(res);
+	return NULL;
+}
+
 /*
  * Formulate a normal query, send, and await answer.
  * Returned answer is placed in supplied buffer "answer".
@@ -2140,12 +2238,17 @@ _files_getaddrinfo(void *rv, void *cb_data, va_list ap)
  * Error number is left in h_errno.
  *
  * Caller must parse answer and determine whether it answers the question.
+ *
+ * Every query after the first that the cache can't answer is sent from a
+ * thread of its own, so when getaddrinfo asks for both AAAA and A records
+ * it waits for the two answers (or timeouts) at the same time instead of
+ * one after the other. Answers from the cache aren't worth a thread, and
+ * if a thread can't be created its query is sent from this one.
  */
 static int
 res_queryN(const char *name, /* domain name */ struct res_target *target,
     res_state res)
 {
-	u_char buf[MAXPACKET];
 	HEADER *hp;
 	int n;
 	struct res_target *t;
@@ -2158,39 +2261,30 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 	rcode = NOERROR;
 	ancount = 0;
 
+	for (t = target->next; t; t = t->next) {
+		t->options = res->options;
+		t->netid = res->netid;
+		t->mark = res->_mark;
+		t->qname = name;
+		t->threaded = !res_queryN_cached(name, t, res) &&
+		    pthread_create(&t->thread, NULL, res_queryN_thread, t) == 0;
+	}
 	for (t = target; t; t = t->next) {
-		int class, type;
-		u_char *answer;
-		int anslen;
+		if (!t->threaded)
+			res_queryN_send(name, t, res);
+	}
+	for (t = target->next; t; t = t->next) {
+		if (t->threaded)
+			pthread_join(t->thread, NULL);
+	}
 
+	for (t = target; t; t = t->next) {
 		hp = (HEADER *)(void *)t->answer;
-		hp->rcode = NOERROR;	/* default */
-
-		/* make it easier... */
-		class = t->qclass;
-		type = t->qtype;
-		answer = t->answer;
-		anslen = t->anslen;
-#ifdef DEBUG
-		if (res->options & RES_DEBUG)
-			printf(";; res_nquery(%s, %d, %d)\n", name, class, type);
-#endif
-
-		n = res_nmkquery(res, QUERY, name, class, type, NULL, 0, NULL,
-		    buf, sizeof(buf));
-#ifdef RES_USE_EDNS0
-		if (n > 0 && (res->options & RES_USE_EDNS0) != 0)
-			n = res_nopt(res, n, buf, sizeof(buf), anslen);
-#endif
-		if (n <= 0) {
-#ifdef DEBUG
-			if (res->options & RES_DEBUG)
-				printf(";; res_nquery: mkquery failed\n");
-#endif
+		if (t->qlen <= 0) {
 			h_errno = NO_RECOVERY;
-			return n;
+			return t->qlen;
 		}
-		n = res_nsend(res, buf, n, answer, anslen);
+		n = t->rlen;
 #if 0
 		if (n < 0) {
 #ifdef DEBUG
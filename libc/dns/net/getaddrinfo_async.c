@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The asynchronous lookups of <android/dns_async.h>.
+ *
+ * The resolver underneath is synchronous, so a channel runs each query on
+ * one of a bounded set of worker threads: however many queries are started,
+ * at most max_running threads are blocked in getaddrinfo, and identical
+ * lookups in flight on any channel are answered once thanks to the cache's
+ * pending requests. Workers are started as queries are queued and exit when
+ * there's nothing left to run.
+ */
+
+#include <android/dns_async.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "resolv_netid.h"
+
+/* How many queries a channel runs at once if its creator doesn't say. */
+#define DEFAULT_MAX_RUNNING 8
+
+enum query_state {
+    QUERY_QUEUED,
+    QUERY_RUNNING,
+    QUERY_DONE,
+    QUERY_CANCELLED,    /* while running: the worker frees it */
+};
+
+struct android_dns_query {
+    android_dns_query_t*  prev;
+    android_dns_query_t*  next;
+    enum query_state      state;
+    char*                 node;
+    char*                 service;
+    struct addrinfo       hints;
+    int                   has_hints;
+    void*                 user_data;
+    int                   error;
+    struct addrinfo*      result;
+};
+
+struct query_list {
+    android_dns_query_t*  head;
+    android_dns_query_t*  tail;
+};
+
+struct android_dns_channel {
+    pthread_mutex_t    lock;
+    unsigned           netid;
+    unsigned           max_running;
+    unsigned           workers;
+    int                destroyed;  /* freed by the last worker to exit */
+    int                fd;         /* an eventfd, non-zero while 'done' isn't empty */
+    struct query_list  queued;
+    struct query_list  running;
+    struct query_list  done;
+};
+
+static void
+_list_append(struct query_list* list, android_dns_query_t* q)
+{
+    q->next = NULL;
+    q->prev = list->tail;
+    if (list->tail != NULL)
+        list->tail->next = q;
+    else
+        list->head = q;
+    list->tail = q;
+}
+
+static void
+_list_remove(struct query_list* list, android_dns_query_t* q)
+{
+    if (q->prev != NULL)
+        q->prev->next = q->next;
+    else
+        list->head = q->next;
+    if (q->next != NULL)
+        q->next->prev = q->prev;
+    else
+        list->tail = q->prev;
+    q->prev = q->next = NULL;
+}
+
+static void
+_query_free(android_dns_query_t* q)
+{
+    if (q->result != NULL)
+        freeaddrinfo(q->result);
+    free(q->node);
+    free(q->service);
+    free(q);
+}
+
+static void
+_query_free_list(android_dns_query_t* q)
+{
+    while (q != NULL) {
+        android_dns_query_t* next = q->next;
+        _query_free(q);
+        q = next;
+    }
+}
+
+/* Called with the lock held when a query is added to an empty 'done'. */
+static void
+_channel_signal(android_dns_channel_t* channel)
+{
+    uint64_t one = 1;
+    write(channel->fd, &one, sizeof(one));
+}
+
+/* Called with the lock held when 'done' has been emptied. */
+static void
+_channel_unsignal(android_dns_channel_t* channel)
+{
+    uint64_t count;
+    read(channel->fd, &count, sizeof(count));
+}
+
+static void
+_channel_free(android_dns_channel_t* channel)
+{
+    pthread_mutex_destroy(&channel->lock);
+    free(channel);
+}
+
+static void*
+_channel_worker(void* arg)
+{
+    android_dns_channel_t* channel = arg;
+    android_dns_query_t* q;
+    int last;
+
+    pthread_mutex_lock(&channel->lock);
+    while (!channel->destroyed && (q = channel->queued.head) != NULL) {
+        _list_remove(&channel->queued, q);
+        _list_append(&channel->running, q);
+        q->state = QUERY_RUNNING;
+        pthread_mutex_unlock(&channel->lock);
+
+        q->error = android_getaddrinfofornet(q->node, q->service,
+                q->has_hints ? &q->hints : NULL, channel->netid, MARK_UNSET, &q->result);
+
+        pthread_mutex_lock(&channel->lock);
+        if (q->state == QUERY_CANCELLED) {
+            _query_free(q);
+            continue;
+        }
+        _list_remove(&channel->running, q);
+        q->state = QUERY_DONE;
+        if (channel->done.head == NULL)
+            _channel_signal(channel);
+        _list_append(&channel->done, q);
+    }
+    last = (--channel->workers == 0 && channel->destroyed);
+    pthread_mutex_unlock(&channel->lock);
+
+    if (last)
+        _channel_free(channel);
+    return NULL;
+}
+
+android_dns_channel_t*
+android_dns_channel_create(unsigned netid, unsigned max_running)
+{
+    android_dns_channel_t* channel = calloc(1, sizeof(*channel));
+    if (channel == NULL)
+        return NULL;
+
+    channel->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (channel->fd == -1) {
+        free(channel);
+        return NULL;
+    }
+    pthread_mutex_init(&channel->lock, NULL);
+    channel->netid = netid;
+    channel->max_running = (max_running != 0) ? max_running : DEFAULT_MAX_RUNNING;
+    return channel;
+}
+
+void
+android_dns_channel_destroy(android_dns_channel_t* channel)
+{
+    android_dns_query_t* queued;
+    android_dns_query_t* done;
+    android_dns_query_t* q;
+    int free_now;
+
+    if (channel == NULL)
+        return;
+
+    pthread_mutex_lock(&channel->lock);
+    queued = channel->queued.head;
+    done = channel->done.head;
+    for (q = channel->running.head; q != NULL; q = q->next)
+        q->state = QUERY_CANCELLED;
+    channel->queued.head = channel->queued.tail = NULL;
+    channel->running.head = channel->running.tail = NULL;
+    channel->done.head = channel->done.tail = NULL;
+    channel->destroyed = 1;
+    close(channel->fd);
+    channel->fd = -1;
+    free_now = (channel->workers == 0);
+    pthread_mutex_unlock(&channel->lock);
+
+    _query_free_list(queued);
+    _query_free_list(done);
+    if (free_now)
+        _channel_free(channel);
+}
+
+int
+android_dns_channel_fd(android_dns_channel_t* channel)
+{
+    return channel->fd;
+}
+
+android_dns_query_t*
+android_dns_getaddrinfo(android_dns_channel_t* channel,
+                        const char* node, const char* service,
+                        const struct addrinfo* hints, void* user_data)
+{
+    android_dns_query_t* q;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (channel == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    q = calloc(1, sizeof(*q));
+    if (q == NULL)
+        return NULL;
+    if ((node != NULL && (q->node = strdup(node)) == NULL) ||
+        (service != NULL && (q->service = strdup(service)) == NULL)) {
+        _query_free(q);
+        return NULL;
+    }
+    if (hints != NULL) {
+        /* getaddrinfo wants everything else in the hints zeroed */
+        q->hints.ai_flags = hints->ai_flags;
+        q->hints.ai_family = hints->ai_family;
+        q->hints.ai_socktype = hints->ai_socktype;
+        q->hints.ai_protocol = hints->ai_protocol;
+        q->has_hints = 1;
+    }
+    q->user_data = user_data;
+    q->state = QUERY_QUEUED;
+
+    pthread_mutex_lock(&channel->lock);
+    _list_append(&channel->queued, q);
+    if (channel->workers < channel->max_running) {
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, _channel_worker, channel) == 0) {
+            channel->workers++;
+        } else if (channel->workers == 0) {
+            /* nobody would ever run it */
+            _list_remove(&channel->queued, q);
+            pthread_mutex_unlock(&channel->lock);
+            pthread_attr_destroy(&attr);
+            _query_free(q);
+            errno = EAGAIN;
+            return NULL;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_mutex_unlock(&channel->lock);
+    return q;
+}
+
+void
+android_dns_cancel(android_dns_channel_t* channel, android_dns_query_t* q)
+{
+    pthread_mutex_lock(&channel->lock);
+    switch (q->state) {
+    case QUERY_QUEUED:
+        _list_remove(&channel->queued, q);
+        break;
+    case QUERY_RUNNING:
+        _list_remove(&channel->running, q);
+        q->state = QUERY_CANCELLED;
+        q = NULL;
+        break;
+    case QUERY_DONE:
+        _list_remove(&channel->done, q);
+        if (channel->done.head == NULL)
+            _channel_unsignal(channel);
+        break;
+    case QUERY_CANCELLED:
+        q = NULL;
+        break;
+    }
+    pthread_mutex_unlock(&channel->lock);
+
+    if (q != NULL)
+        _query_free(q);
+}
+
+int
+android_dns_collect(android_dns_channel_t* channel, struct android_dns_result* result)
+{
+    android_dns_query_t* q;
+
+    pthread_mutex_lock(&channel->lock);
+    q = channel->done.head;
+    if (q != NULL) {
+        _list_remove(&channel->done, q);
+        if (channel->done.head == NULL)
+            _channel_unsignal(channel);
+    }
+    pthread_mutex_unlock(&channel->lock);
+
+    if (q == NULL)
+        return 0;
+
+    result->query = q;
+    result->user_data = q->user_data;
+    result->error = q->error;
+    result->addrinfo = q->result;
+    q->result = NULL;
+    _query_free(q);
+    return 1;
+}
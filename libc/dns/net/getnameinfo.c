@@ -303,7 +303,11 @@ getnameinfo_inet(const struct sockaddr* sa, socklen_t salen,
 			break;
 		}
 	} else {
-		hp = android_gethostbyaddrfornet_proxy(addr, afd->a_addrlen, afd->a_af, netid);
+		/*
+		 * Go the same way as gethostbyaddr, so that in local mode the
+		 * answer comes from (and goes into) the resolver cache.
+		 */
+		hp = android_gethostbyaddrfornet(addr, afd->a_addrlen, afd->a_af, netid, mark);
 		if (hp) {
 #if 0
 			/*
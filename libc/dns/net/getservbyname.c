@@ -40,14 +40,5 @@ getservbyname(const char *name, const char *proto)
         return NULL;
     }
 
-    rs->servent_ptr = NULL;
-    while (1) {
-        struct servent*  s = getservent_r(rs);
-        if (s == NULL)
-            break;
-        if ( !strcmp( s->s_name, name ) && !strcmp( s->s_proto, proto ) )
-            return s;
-    }
-
-    return NULL;
+    return getservent_byname_r(rs, name, proto);
 }
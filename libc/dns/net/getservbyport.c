@@ -39,14 +39,5 @@ getservbyport(int port, const char *proto)
         return NULL;
     }
 
-    rs->servent_ptr = NULL;
-    while (1) {
-        struct servent*  s = getservent_r(rs);
-        if (s == NULL)
-            break;
-        if ( s->s_port == port && !strcmp( s->s_proto, proto ) )
-            return s;
-    }
-
-    return NULL;
+    return getservent_byport_r(rs, port, proto);
 }
@@ -118,6 +118,86 @@ getservent_r( res_static  rs )
     return &rs->servent;
 }
 
+/* must match services_hash() in libc/tools/genserv.py (32-bit FNV-1a) */
+static uint32_t
+__services_hash( const char*  key, size_t  len, char  proto )
+{
+    uint32_t  h = 2166136261u;
+    size_t    nn;
+
+    for (nn = 0; nn < len; nn++)
+        h = (h ^ (unsigned char)key[nn]) * 16777619u;
+    return (h ^ (unsigned char)proto) * 16777619u;
+}
+
+/* map "tcp" or "udp" to the protocol character used in _services */
+static char
+__services_proto( const char*  proto )
+{
+    if (!strcmp(proto, "tcp"))
+        return 't';
+    if (!strcmp(proto, "udp"))
+        return 'u';
+    return 0;
+}
+
+/* decode the entry at 'offset' in _services into the thread-specific servent */
+static struct servent *
+__services_decode( res_static  rs, unsigned  offset )
+{
+    const char*      saved = rs->servent_ptr;
+    struct servent*  s;
+
+    rs->servent_ptr = _services + offset;
+    s = getservent_r(rs);
+    rs->servent_ptr = saved;
+    return s;
+}
+
+struct servent *
+getservent_byname_r( res_static  rs, const char*  name, const char*  proto )
+{
+    char      pc = __services_proto(proto);
+    size_t    namelen = strlen(name);
+    unsigned  i;
+
+    if (pc == 0)
+        return NULL;
+
+    i = __services_hash(name, namelen, pc) & (_SERVICES_HASH_SIZE - 1);
+    for ( ; _services_by_name[i] != 0; i = (i + 1) & (_SERVICES_HASH_SIZE - 1)) {
+        const char*  p = _services + _services_by_name[i] - 1;
+        if ((unsigned char)p[0] == namelen && !memcmp(p + 1, name, namelen) &&
+            p[1 + namelen + 2] == pc)
+            return __services_decode(rs, _services_by_name[i] - 1);
+    }
+    return NULL;
+}
+
+struct servent *
+getservent_byport_r( res_static  rs, int  port, const char*  proto )
+{
+    char      pc = __services_proto(proto);
+    char      key[2];
+    unsigned  i;
+
+    /* port is in network byte order, like s_port */
+    if (pc == 0 || (port & ~0xffff) != 0)
+        return NULL;
+    port = ntohs(port);
+    key[0] = (char)(port >> 8);
+    key[1] = (char)(port & 255);
+
+    i = __services_hash(key, 2, pc) & (_SERVICES_HASH_SIZE - 1);
+    for ( ; _services_by_port[i] != 0; i = (i + 1) & (_SERVICES_HASH_SIZE - 1)) {
+        const char*  p = _services + _services_by_port[i] - 1;
+        p += 1 + (unsigned char)p[0];
+        if (p[0] == key[0] && p[1] == key[1] && p[2] == pc)
+            return __services_decode(rs, _services_by_port[i] - 1);
+    }
+    return NULL;
+}
+
 struct servent *
 getservent(void)
 {
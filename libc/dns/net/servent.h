@@ -42,3 +42,8 @@
 #include "resolv_static.h"
 
 struct servent*  getservent_r(res_static rs);
+
+/* hashed lookups in the built-in services table; these leave the
+ * getservent iteration position alone */
+struct servent*  getservent_byname_r(res_static rs, const char* name, const char* proto);
+struct servent*  getservent_byport_r(res_static rs, int port, const char* proto);
@@ -478,3 +478,269 @@ static const char  _services[] = "\
 \4fido\353\23t\0\
 \0";
 
+/* hash tables over _services keyed by (name, proto) and (port, proto).
+ * each slot holds the offset of an entry plus one, or 0 if empty. */
+#define _SERVICES_HASH_SIZE  1024
+
+static const unsigned short  _services_by_name[_SERVICES_HASH_SIZE] = {
+        0,     0,  1184,     0,   585,  5022,     0,  1983,
+     1529,     0,  4313,  4501,     0,  5362,  1880,     0,
+     5561,     0,   554,  6181,     0,    74,  1764,  3900,
+     5894,     0,  2428,  6507,   210,     0,     0,     0,
+     3529,     0,  1992,  6310,     0,     0,     0,  5093,
+        0,  3661,  2073,  2811,  3636,  5435,  4831,  2374,
+        0,     0,  6079,     0,     0,     0,   885,  3767,
+        0,     0,     0,   742,     0,     0,  6283,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     2592,     0,     0,  3200,     0,     0,     0,     0,
+     2012,  4023,  5576,     0,     0,     0,     0,     0,
+     5644,     0,     0,     0,  1796,  2840,  2939,     0,
+        0,     0,     0,     0,     0,     0,  4467,   574,
+     2775,  1418,  3433,  1701,     0,  2907,  1319,   340,
+        0,  2967,  3383,  4161,  3137,     0,   482,  2693,
+     2138,  6463,     0,   861,  6239,     0,     0,     0,
+        0,     0,     0,   521,  5067,     0,     0,  2122,
+        0,     0,     0,  5698,     0,     0,     0,     0,
+     2310,  3975,     0,     0,  3873,  3095,     0,     0,
+     2618,  3328,     0,   624,  3697,  2570,  5152,     0,
+     4770,     0,     0,     0,     0,     0,     0,  2725,
+      184,     0,  4383,     0,     0,     0,     0,    30,
+        0,     0,     0,     0,  4657,  1508,  6525,     0,
+        0,  3948,  5668,  2558,  5327,     0,  6343,  3481,
+        0,  1107,     0,  1588,  3684,  4101,     0,  1263,
+     2093,     0,  5992,     0,   452,  4868,  6272,     0,
+     3721,  2635,  2977,  5121,     0,     0,     0,   926,
+     5353,  4603,     0,  5603,     0,     0,     0,     0,
+        0,  1000,  5679,     0,     0,   783,     0,   978,
+     2765,  2793,  4343,     0,  2104,  1469,     0,  2335,
+        0,     0,  3575,  4783,  4279,     0,  2047,  1600,
+     2326,  4741,     0,     0,     0,     0,     0,     0,
+     3063,     0,     0,  4933,     0,  5871,  6108,  6557,
+     1956,     0,     0,     0,  5460,  5730,  5945,  1567,
+        0,     0,     0,     0,  1368,  6371,     0,     0,
+      474,  4709,  6008,  5161,  6319,  5544,  3213,  6067,
+     1355,  2665,     0,     0,  5809,     0,     0,     0,
+     4997,  5031,  5829,     0,     0,     0,  5372,     0,
+        0,     0,  1550,  3254,     0,  3591,     0,     0,
+        0,     0,   115,  2852,  3839,     0,     0,     0,
+        0,  3285,     0,   304,     0,   360,  3459,     0,
+     2198,  3560,  5921,     0,     0,     0,     0,  5112,
+        0,     0,  4059,  4889,     0,     0,  5751,  6487,
+     1088,  5935,     0,     0,  1786,  4433,     0,     0,
+        0,     0,     0,     0,     0,     0,  5502,     0,
+     5786,     0,     0,  3853,     0,     0,     0,  3751,
+     5720,  2438,     0,  3999,     0,  1646,     0,     0,
+       91,  1852,  3051,     0,  1287,     0,     0,   690,
+      415,  4639,  6402,  6251,   378,     0,     0,  4947,
+        0,     0,     0,     0,     0,     0,     0,     0,
+      731,  3794,  4039,  5760,  1836,  1200,  5632,  5013,
+     5708,     0,  6044,  1516,     0,  4323,  4525,     0,
+        0,  1904,     0,     0,     0,     0,     0,     0,
+        0,  1752,  1742,   260,   252,  3889,  4393,  5344,
+        0,     0,  6024,     0,     0,  2002,     0,     0,
+        0,     0,     0,     0,     0,  2064,  3920,     0,
+        0,  4815,     0,     0,     0,  6089,  1216,     0,
+        0,   911,  5221,     0,     0,   231,     0,     0,
+       12,     0,  4241,     0,     0,     0,  4303,     0,
+        0,     0,     0,     0,  6156,     0,     0,     0,
+        0,     0,     0,  2021,  2483,  4015,  5859,     0,
+        0,     0,  2929,     0,     0,     0,     0,  1808,
+     2828,  2948,   150,  3029,  5839,     0,     0,     0,
+        0,  4484,     0,     0,     0,     0,     0,     0,
+        0,  1296,     0,     0,     0,  3355,  5428,  3162,
+     1716,   496,  2709,  2168,  6547,     0,     0,  6227,
+     1136,     0,     0,     0,     0,     0,     0,  5051,
+     3422,     0,     0,     0,     0,     0,  1677,     0,
+        0,     0,     0,  2318,  3967,     0,     0,  3881,
+        0,     0,  3115,     0,     0,     0,     0,     0,
+        0,     0,     0,  4757,  1169,  4353,  1622,     0,
+        0,     0,   821,   158,     0,  4373,  4986,     0,
+     1928,     0,     0,     0,     0,     0,  3008,  4675,
+        0,  6517,  2280,     0,  5531,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  3671,
+        0,     0,     0,     0,  4423,     0,     0,   430,
+      532,  2501,     0,  3736,  5132,  2987,  4191,  5965,
+     1408,  4549,  3803,  2388,     0,     0,  6426,  6203,
+        0,     0,     0,     0,  1974,     0,     0,     0,
+        0,     0,     0,  2755,  2802,  4333,     0,  2113,
+        0,     0,     0,     0,  5881,  3583,  4799,  4265,
+        0,  2030,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  3079,  5083,     0,  3651,     0,
+     3621,     0,     0,  1965,     0,     0,  5445,     0,
+        0,     0,     0,     0,  3776,     0,     0,  1383,
+        0,  5308,     0,  6216,   323,  6331,     0,     0,
+        0,  3226,  6055,  1342,  6451,     0,     0,     0,
+     3187,     0,     0,  5005,  5041,     0,  5279,     0,
+        0,  5475,     0,     0,     0,  1542,     0,  6135,
+        0,     0,  6357,     0,     0,  2862,  3825,     0,
+        0,     0,     0,  5818,   563,  1034,  1428,  2784,
+     1686,  3446,  2895,  2224,     0,  5848,  2957,  4131,
+     5515,  5907,     0,     0,     0,  4047,  6475,     0,
+      873,  6497,     0,  1080,     0,     0,     0,  1776,
+      510,  4450,     0,     0,  2130,     0,     0,     0,
+        0,  5489,     0,     0,     0,     0,     0,     0,
+        0,     0,  3105,     0,     0,     0,  3301,     0,
+      611,  3709,  2581,   103,  1866,  2872,  3039,  1278,
+     5143,  6190,     0,   400,  2740,  5742,  6391,   389,
+     6413,     0,     0,     0,    52,     0,     0,     0,
+        0,  5799,  1500,  3785,  5773,  4031,  3929,  1820,
+        0,  5620,     0,     0,  3505,  6033,  1096,   271,
+     1576,     0,  2351,  4071,  1248,  2082,  5402,  5977,
+      600,     0,  4847,     0,     0,  1732,  2650,   244,
+        0,  4403,     0,     0,   941,     0,  4585,     0,
+     5586,     0,  5387,     0,     0,     0,  2419,     0,
+        0,  3911,   802,     0,   956,     0,     0,   127,
+        0,  1232,  1438,     0,     0,  5241,     0,     0,
+        0,     0,     0,    21,   765,  1611,  4217,  4725,
+        0,  4293,     0,     0,     0,  6533,     0,     0,
+     4919,  5953,  6099,     0,     0,  2517,     0,     0,
+        0,     0,     0,     0,  1558,  2919,     0,     0,
+        0,     0,  6381,   223,     0,   142,  3019,  4693,
+     5191,     0,     0,     0,     0,  5656,  2361,     0,
+        0,     0,     0,     0,     0,     0,  5416,     0,
+        0,  3545,     1,  1724,     0,     0,     0,     0,
+     3239,     0,  2886,  1118,  3606,  5689,     0,   632,
+        0,     0,  6117,  3411,     0,     0,  3269,  2462,
+      285,  1668,  3470,     0,  6439,     0,     0,     0,
+        0,     0,     0,     0,  5103,  3126,     0,  1057,
+     1043,  4904,     0,     0,     0,     0,     0,  1154,
+     4363,  1634,     0,     0,     0,   841,  5261,     0,
+        0,  2399,  2537,  1942,  2607,  4975,     0,     0,
+     3863,  2997,     0,     0,  3759,  2250,     0,     0,
+     3983,     0,  1657,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,   649,  6146,  4621,  4413,
+     6126,     0,     0,   543,  4961,     0,     0,     0,
+        0,  4204,     0,  1398,  4567,  3814,     0,     0,
+};
+
+static const unsigned short  _services_by_port[_SERVICES_HASH_SIZE] = {
+        0,  2130,  4799,  5730,     0,  3889,     0,     0,
+     4204,  4725,     0,     0,     0,  6439,     0,  1368,
+     1500,  4757,     0,     0,  3911,   841,     0,     0,
+        0,   103,  1438,     0,     0,     0,     0,     0,
+        0,     0,   941,     0,     0,     0,   150,  3459,
+        0,     0,  6203,     0,     0,  1677,     0,     0,
+     2168,  4709,  2399,     0,  1558,     0,     0,  6067,
+      861,     0,   378,     0,     0,  3187,  2775,  3751,
+        0,  5489,     0,  6319,  5013,     0,     0,  5848,
+        0,     0,     0,     0,     0,  5031,     0,  4403,
+     2886,  6190,     0,     0,     0,     0,     0,     0,
+     6426,  3095,  2725,     0,   731,     0,  2335,  2558,
+      802,  3636,  1154,     0,  6079,     0,  1701,     0,
+     6108,     0,     0,  2872,     0,     0,     0,  3671,
+     5083,     0,  5103,     0,  1118,  6272,     0,     0,
+      360,     0,     0,     0,     0,     0,     0,  2021,
+        0,   340,     0,     0,   260,  3137,     0,     0,
+     3697,     0,     0,     0,     0,   244,  1200,  1529,
+     4467,  3721,  3863,  5005,  2082,     0,     0,  4549,
+        0,  4433,     0,     0,     0,  6557,     0,     0,
+     4919,     0,     0,   649,     0,     0,  5859,  6517,
+        0,  4947,     0,  1232,  3328,     0,     0,     0,
+        0,     0,  4847,  5279,     0,  1786,  5945,     0,
+        0,     0,  1418,  4889,     0,  1287,  4343,     0,
+        0,   554,     0,  4047,     0,     0,     0,     0,
+        0,     0,     1,     0,  2939,  2987,     0,  3929,
+        0,  2618,  3967,  4071,  4975,  3825,  6239,     0,
+     2113,  2907,     0,     0,  5632,  2755,     0,  6371,
+      510,  1752,  3433,  5668,     0,     0,  5362,     0,
+        0,     0,     0,     0,     0,     0,  5586,  2419,
+        0,     0,     0,     0,     0,  4161,  1319,  1732,
+     3239,  2318,  1965,     0,  3803,     0,  3115,  2483,
+     1808,  3269,     0,  5907,  3411,  5428,     0,     0,
+        0,     0,     0,     0,     0,     0,   742,  5544,
+        0,     0,     0,  1355,  1928,  6283,  6135,     0,
+        0,     0,  6044,     0,     0,     0,     0,  1263,
+     6391,     0,  1576,     0,  4023,  4279,   885,     0,
+        0,  3606,     0,     0,  5839,  6310,     0,     0,
+        0,     0,  4423,     0,     0,  5829,  3881,     0,
+        0,     0,     0,     0,     0,     0,  1716,     0,
+        0,  3226,  5720,     0,   632,  2635,  4383,     0,
+        0,  1820,  1096,     0,  2073,     0,   285,  1611,
+     5132,  5067,  3999,  4031,  2828,  6547,     0,     0,
+        0,     0,   127,  1880,  2862,     0,  5241,     0,
+        0,     0,  2047,  2997,     0,     0,     0,     0,
+     2581,  1542,     0,     0,     0,     0,  1974,   532,
+     4303,     0,   271,  5809,  3063,    52,  1398,     0,
+        0,     0,     0,     0,  4585,     0,     0,     0,
+        0,     0,  2693,     0,     0,  2250,  4621,    21,
+        0,  4525,   482,   611,  5308,     0,  3029,  6463,
+        0,   231,  5881,     0,     0,     0,     0,     0,
+        0,     0,     0,  4191,  4741,     0,     0,     0,
+     2002,     0,     0,  1508,     0,     0,  6156,  3920,
+        0,     0,     0,     0,   956,  6451,     0,  5387,
+      158,  6251,     0,     0,     0,   926,  5698,  6126,
+     6497,   142,  3470,     0,     0,  5992,     0,     0,
+        0,     0,  1657,  2138,  4693,  5773,     0,  1567,
+     1080,     0,  5561,   873,     0,   389,     0,     0,
+     2802,  2784,  3759,     0,  1634,  2537,     0,  2462,
+     5022,     0,  5416,     0,     0,     0,   430,     0,
+        0,     0,     0,     0,  2428,     0,     0,     0,
+     2351,  5965,  1852,  3776,     0,  2740,     0,     0,
+        0,  2326,  3621,   783,     0,  1169,     0,  6089,
+     5460,  1686,     0,  6099,     0,  6146,  6117,     0,
+     5152,  5531,  5818,  5093,     0,  5112,   415,  1136,
+        0,     0,  3051,     0,  5161,     0,     0,     0,
+     2388,     0,     0,     0,     0,     0,     0,  3162,
+        0,     0,     0,  3709,  4831,     0,     0,     0,
+        0,  1184,     0,  4484,     0,  3853,     0,  2093,
+        0,     0,   574,     0,     0,  2665,  2607,  3651,
+        0,     0,     0,  4933,  3505,  5344,  4353,     0,
+        0,     0,  3794,     0,     0,     0,     0,   210,
+     3383,     0,  2967,  3575,  4217,  4868,   585,  5689,
+     4313,     0,     0,     0,     0,  1428,  5644,     0,
+        0,  4333,  2198,  4657,  2929,     0,     0,     0,
+     5679,     0,     0,     0,     0,  5708,     0,  2948,
+     2977,     0,     0,     0,     0,  4986,     0,     0,
+        0,     0,     0,  2104,     0,  6533,  2122,  4783,
+     5261,  5620,  3900,   521,  3446,  6181,     0,     0,
+        0,     0,     0,     0,  1383,     0,  4770,     0,
+     5327,  5603,   821,  5742,     0,     0,    91,  1469,
+     6343,  1296,     0,  3254,     0,  1956,     0,  3814,
+        0,  3126,  5372,  1796,  6357,     0,     0,  3422,
+       74,     0,  1668,  5656,     0,   765,  1043,     0,
+        0,     0,     0,     0,  6055,     0,     0,  1942,
+        0,     0,  3200,     0,     0,  6033,  5502,     0,
+     6331,     0,     0,     0,     0,  1588,     0,  4015,
+        0,   911,  5041,     0,  4393,  2592,     0,     0,
+        0,     0,     0,     0,     0,  4413,  3105,     0,
+        0,  3873,  5475,     0,     0,     0,     0,     0,
+        0,  1724,     0,     0,     0,     0,     0,  4373,
+        0,  5871,     0,     0,  3684,  1107,     0,  2064,
+        0,   304,  1600,  5121,  2811,  3983,  2438,  2840,
+     4039,  5515,     0,     0,  2012,     0,     0,  2852,
+        0,  5221,  5353,     0,     0,  2030,  3008,     0,
+        0,     0,   252,  2570,  1516,  4997,  3736,     0,
+        0,  1983,     0,  4293,  4567,     0,  4450,  3079,
+        0,     0,     0,  5935,   115,     0,     0,  4603,
+      690,     0,     0,  2501,  6525,  2709,  4961,     0,
+     1216,  3301,     0,     0,     0,   496,     0,     0,
+     6024,  3019,  1776,  6475,  1057,  5894,     0,     0,
+     4904,     0,  1278,     0,     0,     0,     0,     0,
+     4059,     0,     0,  1992,     0,     0,     0,     0,
+        0,     0,     0,     0,  3948,     0,  3975,   978,
+     4101,     0,  3839,   184,  6227,     0,  2895,     0,
+        0,  6487,  2765,     0,  6381,     0,  1764,     0,
+     1034,     0,   474,     0,     0,  1646,  5760,     0,
+        0,     0,     0,  1088,     0,     0,     0,     0,
+        0,     0,  4131,  2793,  1742,  6413,  2310,   323,
+     1622,     0,     0,     0,     0,     0,  3285,     0,
+     5921,   452,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  2361,     0,  1866,  3767,     0,
+     1342,     0,     0,     0,     0,     0,     0,     0,
+        0,  5576,  6008,     0,  1248,  6402,     0,     0,
+        0,     0,  4265,  5143,     0,     0,  3591,     0,
+        0,   400,     0,  6216,     0,  3039,     0,  5191,
+        0,     0,  2517,  2374,     0,     0,     0,     0,
+     6507,     0,     0,     0,     0,     0,  3213,  4815,
+        0,     0,  2650,  5977,     0,     0,  1836,     0,
+     5402,  5799,     0,     0,     0,   563,  5051,     0,
+        0,  3661,  5786,     0,     0,     0,     0,  3481,
+     1904,  4363,  5953,     0,   600,  3785,     0,     0,
+        0,     0,     0,  3355,     0,  2957,  1550,  3583,
+     4241,     0,     0,  4323,   543,  3545,     0,     0,
+        0,  5445,    30,  1408,     0,  2224,  3560,  2919,
+     4675,     0,  5435,     0,     0,     0,     0,     0,
+        0,     0,  2280,  4639,    12,     0,  4501,  3529,
+      624,     0,  1000,     0,     0,     0,   223,     0,
+};
+
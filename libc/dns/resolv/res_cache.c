@@ -28,6 +28,7 @@
 
 #include "resolv_cache.h"
 #include <resolv.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -136,7 +137,35 @@
  * *****************************************
  */
 #define  CONFIG_MAX_ENTRIES    64 * 2 * 5
-/* name of the system property that can be used to set the cache size */
+
+/* the cache is bounded by memory rather than by entries. A typical entry
+ * (the Entry, a query and an answer with a few records) takes a couple of
+ * hundred bytes, so the default budget holds about CONFIG_MAX_ENTRIES of them.
+ */
+#define  CONFIG_ENTRY_BYTES    256
+#define  CONFIG_MAX_BYTES      (CONFIG_MAX_ENTRIES * CONFIG_ENTRY_BYTES)
+
+/* name of the system property that can be used to set the cache size, in bytes */
+#define  CONFIG_PROPERTY       "net.dns.cache_bytes"
+
+/* an entry that's looked up in the last 1/CONFIG_PREFETCH_FRACTION of its
+ * TTL is refreshed in the background, so popular names don't expire.
+ */
+#define  CONFIG_PREFETCH_FRACTION  10
+
+/* name of the system property giving how many seconds past its TTL an entry
+ * may still be served while it's refreshed in the background (RFC 8767's
+ * serve-stale). The default, 0, never serves stale answers.
+ */
+#define  CONFIG_STALE_PROPERTY "net.dns.cache_stale_seconds"
+
+/* negative answers are kept for their SOA's MINIMUM, but no longer than this
+ * (the upper end of what RFC 2308 recommends) */
+#define  CONFIG_MAX_NEGATIVE_TTL  (3*60*60)  /* 3 hours */
+
+/* how many names that don't exist each network's cache remembers, to answer
+ * queries of any type for them and for the names under them */
+#define  CONFIG_NX_NAMES  32
 
 /****************************************************************************/
 /****************************************************************************/
@@ -445,10 +474,18 @@ _time_now( void )
 #define  DNS_TYPE_PTR "\00\014"  /* big-endian decimal 12 */
 #define  DNS_TYPE_MX  "\00\017"  /* big-endian decimal 15 */
 #define  DNS_TYPE_AAAA "\00\034" /* big-endian decimal 28 */
-#define  DNS_TYPE_ALL "\00\0377" /* big-endian decimal 255 */
+#define  DNS_TYPE_ALL "\00\377" /* big-endian decimal 255 */
+#define  DNS_TYPE_IXFR "\00\373" /* big-endian decimal 251 */
+#define  DNS_TYPE_AXFR "\00\374" /* big-endian decimal 252 */
 
 #define  DNS_CLASS_IN "\00\01"   /* big-endian decimal 1 */
 
+/* an EDNS0 OPT pseudo-RR without options, as res_nopt() writes it:
+ * root NAME, TYPE, CLASS (UDP payload size), TTL (extended RCODE,
+ * version and flags) and a zero RDLENGTH */
+#define  DNS_TYPE_OPT "\00\051" /* big-endian decimal 41 */
+#define  DNS_OPT_SIZE  11
+
 typedef struct {
     const uint8_t*  base;
     const uint8_t*  end;
@@ -558,16 +595,17 @@ _dnsPacket_checkQR( DnsPacket*  packet )
     if (!_dnsPacket_checkQName(packet))
         return 0;
 
-    /* TYPE must be one of the things we support */
-    if (!_dnsPacket_checkBytes(packet, 2, DNS_TYPE_A) &&
-        !_dnsPacket_checkBytes(packet, 2, DNS_TYPE_PTR) &&
-        !_dnsPacket_checkBytes(packet, 2, DNS_TYPE_MX) &&
-        !_dnsPacket_checkBytes(packet, 2, DNS_TYPE_AAAA) &&
-        !_dnsPacket_checkBytes(packet, 2, DNS_TYPE_ALL))
+    /* TYPE can be anything but a zone transfer, whose answers span
+     * several messages, or an OPT pseudo-RR */
+    if (_dnsPacket_checkBytes(packet, 2, DNS_TYPE_IXFR) ||
+        _dnsPacket_checkBytes(packet, 2, DNS_TYPE_AXFR) ||
+        _dnsPacket_checkBytes(packet, 2, DNS_TYPE_OPT))
     {
         XLOG("unsupported TYPE");
         return 0;
     }
+    _dnsPacket_skip(packet, 2);
+
     /* CLASS must be IN */
     if (!_dnsPacket_checkBytes(packet, 2, DNS_CLASS_IN)) {
         XLOG("unsupported CLASS");
@@ -577,6 +615,28 @@ _dnsPacket_checkQR( DnsPacket*  packet )
     return 1;
 }
 
+/* parse and skip the EDNS0 OPT record of a query packet.
+ * returns 1 on success, and 0 on failure
+ */
+static int
+_dnsPacket_checkOPT( DnsPacket*  packet )
+{
+    const uint8_t*  p = packet->cursor;
+
+    if (p + DNS_OPT_SIZE > packet->end ||
+        p[0] != 0 || memcmp(p + 1, DNS_TYPE_OPT, 2) != 0) {
+        XLOG("unsupported additional record");
+        return 0;
+    }
+    /* options (cookies, client subnet...) could change the answer */
+    if (p[9] != 0 || p[10] != 0) {
+        XLOG("unsupported EDNS0 options");
+        return 0;
+    }
+    packet->cursor = p + DNS_OPT_SIZE;
+    return 1;
+}
+
 /* check the header of a DNS Query packet, return 1 if it is one
  * type of query we can cache, or 0 otherwise
  */
@@ -616,13 +676,13 @@ _dnsPacket_checkQuery( DnsPacket*  packet )
      *   comparing query packets, but not TC
      */
 
-    /* ANCOUNT, DNCOUNT and ARCOUNT must be 0 */
+    /* ANCOUNT and DNCOUNT must be 0, ARCOUNT can only count an OPT record */
     qdCount = (p[4] << 8) | p[5];
     anCount = (p[6] << 8) | p[7];
     dnCount = (p[8] << 8) | p[9];
     arCount = (p[10]<< 8) | p[11];
 
-    if (anCount != 0 || dnCount != 0 || arCount != 0) {
+    if (anCount != 0 || dnCount != 0 || arCount > 1) {
         XLOG("query packet contains non-query records");
         return 0;
     }
@@ -639,6 +699,9 @@ _dnsPacket_checkQuery( DnsPacket*  packet )
         if (!_dnsPacket_checkQR(packet))
             return 0;
 
+    if (arCount == 1 && !_dnsPacket_checkOPT(packet))
+        return 0;
+
     return 1;
 }
 
@@ -767,6 +830,7 @@ _dnsPacket_hashBytes( DnsPacket*  packet, int  numBytes, unsigned  hash )
 
     while (numBytes > 0 && p < end) {
         hash = hash*FNV_MULT ^ *p++;
+        numBytes--;
     }
     packet->cursor = p;
     return hash;
@@ -822,7 +886,7 @@ static unsigned
 _dnsPacket_hashQuery( DnsPacket*  packet )
 {
     unsigned  hash = FNV_BASIS;
-    int       count;
+    int       count, arCount;
     _dnsPacket_rewind(packet);
 
     /* we ignore the TC bit for reasons explained in
@@ -840,13 +904,18 @@ _dnsPacket_hashQuery( DnsPacket*  packet )
     /* read QDCOUNT */
     count = _dnsPacket_readInt16(packet);
 
-    /* assume: ANcount, NScount, ARcount are 0 */
-    _dnsPacket_skip(packet, 6);
+    /* assume: ANcount and NScount are 0 */
+    _dnsPacket_skip(packet, 4);
+    arCount = _dnsPacket_readInt16(packet);
 
     /* hash QDCOUNT QRs */
     for ( ; count > 0; count-- )
         hash = _dnsPacket_hashQR(packet, hash);
 
+    /* and the OPT record, whose flags and payload size can change the answer */
+    if (arCount == 1)
+        hash = _dnsPacket_hashBytes(packet, DNS_OPT_SIZE, hash);
+
     return hash;
 }
 
@@ -933,7 +1002,7 @@ _dnsPacket_isEqualQR( DnsPacket*  pack1, DnsPacket*  pack2 )
 static int
 _dnsPacket_isEqualQuery( DnsPacket*  pack1, DnsPacket*  pack2 )
 {
-    int  count1, count2;
+    int  count1, count2, arCount1, arCount2;
 
     /* compare the headers, ignore most fields */
     _dnsPacket_rewind(pack1);
@@ -957,9 +1026,15 @@ _dnsPacket_isEqualQuery( DnsPacket*  pack1, DnsPacket*  pack2 )
         return 0;
     }
 
-    /* assume: ANcount, NScount and ARcount are all 0 */
-    _dnsPacket_skip(pack1, 6);
-    _dnsPacket_skip(pack2, 6);
+    /* assume: ANcount and NScount are 0, compare ARcount */
+    _dnsPacket_skip(pack1, 4);
+    _dnsPacket_skip(pack2, 4);
+    arCount1 = _dnsPacket_readInt16(pack1);
+    arCount2 = _dnsPacket_readInt16(pack2);
+    if (arCount1 != arCount2) {
+        XLOG("different ARCOUNT");
+        return 0;
+    }
 
     /* compare the QDCOUNT QRs */
     for ( ; count1 > 0; count1-- ) {
@@ -968,6 +1043,12 @@ _dnsPacket_isEqualQuery( DnsPacket*  pack1, DnsPacket*  pack2 )
             return 0;
         }
     }
+
+    /* compare the OPT records */
+    if (arCount1 == 1 && !_dnsPacket_isEqualBytes(pack1, pack2, DNS_OPT_SIZE)) {
+        XLOG("different OPT");
+        return 0;
+    }
     return 1;
 }
 
@@ -995,12 +1076,15 @@ typedef struct Entry {
     const uint8_t*   answer;
     int              answerlen;
     time_t           expires;   /* time_t when the entry isn't valid any more */
+    u_long           ttl;       /* seconds it was valid for when added */
+    int              refreshing; /* a background refresh is in flight */
     int              id;        /* for debugging purpose */
 } Entry;
 
 /**
  * Find the TTL for a negative DNS result.  This is defined as the minimum
- * of the SOA records TTL and the MINIMUM-TTL field (RFC-2308).
+ * of the SOA records TTL and the MINIMUM-TTL field (RFC-2308), capped at
+ * CONFIG_MAX_NEGATIVE_TTL.
  *
  * Return 0 if not found.
  */
@@ -1038,11 +1122,14 @@ answer_getNegativeTTL(ns_msg handle) {
                 rec_result = ttl;
             }
             // Now that the record is read successfully, apply the new min TTL
-            if (n == 0 || rec_result < result) {
+            if (result == 0 || rec_result < result) {
                 result = rec_result;
             }
         }
     }
+    if (result > CONFIG_MAX_NEGATIVE_TTL) {
+        result = CONFIG_MAX_NEGATIVE_TTL;
+    }
     return result;
 }
 
@@ -1071,19 +1158,23 @@ answer_getTTL(const void* answer, int answerlen)
         // get number of answer records
         ancount = ns_msg_count(handle, ns_s_an);
 
-        if (ancount == 0) {
-            // a response with no answers?  Cache this negative result.
-            result = answer_getNegativeTTL(handle);
-        } else {
-            for (n = 0; n < ancount; n++) {
-                if (ns_parserr(&handle, ns_s_an, n, &rr) == 0) {
-                    ttl = ns_rr_ttl(rr);
-                    if (n == 0 || ttl < result) {
-                        result = ttl;
-                    }
-                } else {
-                    XLOG("ns_parserr failed ancount no = %d. errno = %s\n", n, strerror(errno));
+        for (n = 0; n < ancount; n++) {
+            if (ns_parserr(&handle, ns_s_an, n, &rr) == 0) {
+                ttl = ns_rr_ttl(rr);
+                if (n == 0 || ttl < result) {
+                    result = ttl;
                 }
+            } else {
+                XLOG("ns_parserr failed ancount no = %d. errno = %s\n", n, strerror(errno));
+            }
+        }
+
+        // a response with no answers, or whose CNAMEs lead to a name that
+        // doesn't exist, is negative: it's cached for as long as its SOA says
+        if (ancount == 0 || ns_msg_getflag(handle, ns_f_rcode) == ns_r_nxdomain) {
+            ttl = answer_getNegativeTTL(handle);
+            if (ancount == 0 || ttl < result) {
+                result = ttl;
             }
         }
     } else {
@@ -1152,6 +1243,13 @@ entry_init_key( Entry*  e, const void*  query, int  querylen )
     return _dnsPacket_checkQuery(pack);
 }
 
+/* the memory used by an entry allocated by entry_alloc() */
+static size_t
+entry_size( const Entry*  init, int  answerlen )
+{
+    return sizeof(*init) + init->querylen + answerlen;
+}
+
 /* allocate a new entry as a cache node */
 static Entry*
 entry_alloc( const Entry*  init, const void*  answer, int  answerlen )
@@ -1159,7 +1257,7 @@ entry_alloc( const Entry*  init, const void*  answer, int  answerlen )
     Entry*  e;
     int     size;
 
-    size = sizeof(*e) + init->querylen + answerlen;
+    size = entry_size(init, answerlen);
     e    = calloc(size, 1);
     if (e == NULL)
         return e;
@@ -1214,23 +1312,66 @@ typedef struct pending_req_info {
     struct pending_req_info*    next;
 } PendingReqInfo;
 
+/* Each network's cache is split into CACHE_SHARDS shards, picked by the
+ * query's hash. A shard has its own lock, hash table, MRU list and pending
+ * requests, so threads looking up different names don't wait for each other.
+ */
+#define CACHE_SHARDS 16
+
+/* a shard starts with this many hash buckets, and doubles them whenever it
+ * holds more than two entries per bucket */
+#define CACHE_SHARD_BUCKETS 32
+
 typedef struct resolv_cache {
-    int              max_entries;
+    pthread_mutex_t  lock;
+    struct resolv_cache_info*  info;
+    size_t           max_bytes;     /* this shard's part of the cache's budget */
+    time_t           stale_seconds; /* how long past expiry entries may be served */
+    size_t           bytes;         /* used by the entries below */
     int              num_entries;
+    int              num_buckets;
     Entry            mru_list;
     int              last_id;
-    Entry*           entries;
+    Entry**          buckets;
     PendingReqInfo   pending_requests;
+    unsigned long    hits;
+    unsigned long    misses;
+    unsigned long    expirations;   /* entries dropped because their TTL passed */
+    unsigned long    evictions;     /* live entries dropped to make room */
+    unsigned long    stale_hits;    /* expired entries served */
+    unsigned long    refreshes;     /* background refreshes started */
+    unsigned long    nx_hits;       /* answered from the names known not to exist */
 } Cache;
 
+/* A name an NXDOMAIN answer said doesn't exist. Names don't exist whatever
+ * the type asked for, nor do any names under them (RFC 8020), so one of
+ * these answers queries the cache has never seen: the AAAA query for a name
+ * whose A query failed, or every name looked up in a search domain that
+ * doesn't exist.
+ */
+typedef struct nx_name {
+    time_t   expires;               /* 0 if the slot is free */
+    int      namelen;
+    uint8_t  name[NS_MAXCDNAME];    /* uncompressed wire format, lower-cased */
+} NxName;
+
+/* The list of resolv_cache_infos is searched without a lock. So readers never
+ * see one freed, a deleted network's resolv_cache_info stays on the list with
+ * 'live' cleared, and is reused for the next new network. 'netid' and 'live'
+ * only change while every shard is locked, so a reader that finds its netid
+ * checks both again once it holds its shard's lock.
+ */
 struct resolv_cache_info {
-    unsigned                    netid;
-    Cache*                      cache;
-    struct resolv_cache_info*   next;
+    atomic_uint                 netid;
+    atomic_int                  live;
+    Cache*                      cache;  /* CACHE_SHARDS shards */
+    _Atomic(struct resolv_cache_info*) next;
     char*                       nameservers[MAXNS +1];
     struct addrinfo*            nsaddrinfo[MAXNS + 1];
     char                        defdname[256];
     int                         dnsrch_offset[MAXDNSRCH+1];  // offsets into defdname
+    pthread_mutex_t             nx_lock;  /* taken after a shard's lock, never before */
+    NxName                      nx_names[CONFIG_NX_NAMES];
 };
 
 #define  HTABLE_VALID(x)  ((x) != NULL && (x) != HTABLE_DELETED)
@@ -1238,11 +1379,126 @@ struct resolv_cache_info {
 static pthread_once_t        _res_cache_once = PTHREAD_ONCE_INIT;
 static void _res_cache_init(void);
 
-// lock protecting everything in the _resolve_cache_info structs (next ptr, etc)
+// lock serializing changes to the list of _resolve_cache_info structs, and
+// protecting their nameservers, search domains and the 'live' flags
 static pthread_mutex_t _res_cache_list_lock;
 
-/* gets cache associated with a network, or NULL if none exists */
-static struct resolv_cache* _find_named_cache_locked(unsigned netid);
+/* gets the shard of a network's cache that 'key' belongs in, locked, or NULL if none exists */
+static Cache* _cache_lock_shard(unsigned netid, const Entry* key);
+/* returns 1 if a locked shard still belongs to netid's cache */
+static int _cache_shard_is_live(Cache* cache, unsigned netid);
+/* finds the slot for key in a locked shard; see its definition */
+static Entry** _cache_lookup_p(Cache* cache, Entry* key);
+
+/* copies the QNAME of a checked query, lower-cased, into 'name' and returns
+ * its length, or returns 0 if the query doesn't have exactly one question */
+static int
+_dnsPacket_getQName(const uint8_t* query, uint8_t* name)
+{
+    const uint8_t*  p = query + DNS_HEADER_SIZE;
+    int             len = 0;
+
+    if (query[4] != 0 || query[5] != 1)
+        return 0;
+
+    for (;;) {
+        int  c = p[len];
+
+        if (len + 1 + c > NS_MAXCDNAME)
+            return 0;
+        name[len++] = c;
+        if (c == 0)
+            return len;
+        for ( ; c > 0; c--, len++) {
+            name[len] = (p[len] >= 'A' && p[len] <= 'Z') ? p[len] + ('a' - 'A') : p[len];
+        }
+    }
+}
+
+/* remembers for 'ttl' seconds that the name a query asked about doesn't exist */
+static void
+_cache_nx_add_locked(Cache* cache, const Entry* key, u_long ttl)
+{
+    struct resolv_cache_info*  info = cache->info;
+    uint8_t  name[NS_MAXCDNAME];
+    int      namelen = _dnsPacket_getQName(key->query, name);
+    NxName*  slot = NULL;
+    int      nn;
+
+    /* NXDOMAIN for the root would be a lie about every name */
+    if (namelen <= 1)
+        return;
+
+    pthread_mutex_lock(&info->nx_lock);
+    /* reuse the name's slot, or else the one that expires first */
+    for (nn = 0; nn < CONFIG_NX_NAMES; nn++) {
+        NxName*  nx = &info->nx_names[nn];
+        if (nx->namelen == namelen && memcmp(nx->name, name, namelen) == 0) {
+            slot = nx;
+            break;
+        }
+        if (slot == NULL || nx->expires < slot->expires)
+            slot = nx;
+    }
+    slot->expires = _time_now() + ttl;
+    slot->namelen = namelen;
+    memcpy(slot->name, name, namelen);
+    pthread_mutex_unlock(&info->nx_lock);
+}
+
+/* if the name a query asks about, or a name above it, is known not to exist,
+ * writes the NXDOMAIN answer to the query and returns 1. Returns 0 otherwise,
+ * or if the answer doesn't fit in 'answersize' bytes. */
+static int
+_cache_nx_answer_locked(Cache* cache, const Entry* key,
+                        uint8_t* answer, int answersize, int* answerlen)
+{
+    struct resolv_cache_info*  info = cache->info;
+    uint8_t  name[NS_MAXCDNAME];
+    int      namelen = _dnsPacket_getQName(key->query, name);
+    time_t   now = _time_now();
+    int      found = 0;
+    int      nn, len;
+
+    if (namelen <= 1)
+        return 0;
+
+    pthread_mutex_lock(&info->nx_lock);
+    for (nn = 0; nn < CONFIG_NX_NAMES && !found; nn++) {
+        const NxName*  nx = &info->nx_names[nn];
+        int            skip = namelen - nx->namelen;
+
+        if (now >= nx->expires || skip < 0 ||
+                memcmp(name + skip, nx->name, nx->namelen) != 0)
+            continue;
+        /* a matching suffix must start on a label */
+        for (len = 0; len < skip; len += name[len] + 1) {
+        }
+        found = (len == skip);
+    }
+    pthread_mutex_unlock(&info->nx_lock);
+
+    /* the answer is the query's header and question, and no records */
+    len = DNS_HEADER_SIZE + namelen + 4;
+    if (!found || len > answersize)
+        return 0;
+
+    memcpy(answer, key->query, len);
+    answer[2] = 0x80 | (key->query[2] & 0x01);  /* QR, and the query's RD */
+    answer[3] = 0x80 | ns_r_nxdomain;           /* RA */
+    memset(answer + 6, 0, 6);                   /* ANCOUNT, NSCOUNT, ARCOUNT */
+    *answerlen = len;
+    return 1;
+}
+
+/* forgets every name known not to exist. every shard must be locked */
+static void
+_cache_nx_flush_locked(struct resolv_cache_info* info)
+{
+    pthread_mutex_lock(&info->nx_lock);
+    memset(info->nx_names, 0, sizeof(info->nx_names));
+    pthread_mutex_unlock(&info->nx_lock);
+}
 
 static void
 _cache_flush_pending_requests_locked( struct resolv_cache* cache )
@@ -1296,9 +1552,12 @@ _cache_check_pending_request_locked( struct resolv_cache** cache, Entry* key, un
             struct timespec ts = {0,0};
             XLOG("Waiting for previous request");
             ts.tv_sec = _time_now() + PENDING_REQUEST_TIMEOUT;
-            pthread_cond_timedwait(&ri->cond, &_res_cache_list_lock, &ts);
-            /* Must update *cache as it could have been deleted. */
-            *cache = _find_named_cache_locked(netid);
+            pthread_cond_timedwait(&ri->cond, &(*cache)->lock, &ts);
+            /* Must check *cache as it could have been deleted. */
+            if (!_cache_shard_is_live(*cache, netid)) {
+                pthread_mutex_unlock(&(*cache)->lock);
+                *cache = NULL;
+            }
         }
     }
 
@@ -1345,15 +1604,17 @@ _resolv_cache_query_failed( unsigned    netid,
     if (!entry_init_key(key, query, querylen))
         return;
 
-    pthread_mutex_lock(&_res_cache_list_lock);
-
-    cache = _find_named_cache_locked(netid);
+    cache = _cache_lock_shard(netid, key);
 
     if (cache) {
+        /* let a later lookup try refreshing the entry again */
+        Entry*  e = *_cache_lookup_p(cache, key);
+        if (e != NULL) {
+            e->refreshing = 0;
+        }
         _cache_notify_waiting_tid_locked(cache, key);
+        pthread_mutex_unlock(&cache->lock);
     }
-
-    pthread_mutex_unlock(&_res_cache_list_lock);
 }
 
 static void
@@ -1361,9 +1622,9 @@ _cache_flush_locked( Cache*  cache )
 {
     int     nn;
 
-    for (nn = 0; nn < cache->max_entries; nn++)
+    for (nn = 0; nn < cache->num_buckets; nn++)
     {
-        Entry**  pnode = (Entry**) &cache->entries[nn];
+        Entry**  pnode = &cache->buckets[nn];
 
         while (*pnode != NULL) {
             Entry*  node = *pnode;
@@ -1377,6 +1638,7 @@ _cache_flush_locked( Cache*  cache )
 
     cache->mru_list.mru_next = cache->mru_list.mru_prev = &cache->mru_list;
     cache->num_entries       = 0;
+    cache->bytes             = 0;
     cache->last_id           = 0;
 
     XLOG("*************************\n"
@@ -1384,37 +1646,65 @@ _cache_flush_locked( Cache*  cache )
          "*************************");
 }
 
-static int
-_res_cache_get_max_entries( void )
+static size_t
+_res_cache_get_max_bytes( void )
 {
-    int cache_size = CONFIG_MAX_ENTRIES;
+    size_t cache_size = CONFIG_MAX_BYTES;
+    char   value[PROP_VALUE_MAX];
 
     const char* cache_mode = getenv("ANDROID_DNS_MODE");
     if (cache_mode == NULL || strcmp(cache_mode, "local") != 0) {
         // Don't use the cache in local mode. This is used by the proxy itself.
         cache_size = 0;
+    } else if (__system_property_get(CONFIG_PROPERTY, value) > 0) {
+        cache_size = strtoul(value, NULL, 0);
     }
 
-    XLOG("cache size: %d", cache_size);
+    XLOG("cache size: %zu bytes", cache_size);
     return cache_size;
 }
 
-static struct resolv_cache*
-_resolv_cache_create( void )
+static time_t
+_res_cache_get_stale_seconds( void )
+{
+    char   value[PROP_VALUE_MAX];
+
+    if (__system_property_get(CONFIG_STALE_PROPERTY, value) > 0) {
+        return strtoul(value, NULL, 0);
+    }
+    return 0;
+}
+
+/* creates the CACHE_SHARDS shards of a network's cache */
+static Cache*
+_resolv_cache_create( struct resolv_cache_info*  info )
 {
-    struct resolv_cache*  cache;
+    Cache*  cache;
+    size_t  max_bytes = _res_cache_get_max_bytes();
+    time_t  stale_seconds = _res_cache_get_stale_seconds();
+    int     nn;
 
-    cache = calloc(sizeof(*cache), 1);
+    cache = calloc(sizeof(*cache), CACHE_SHARDS);
     if (cache) {
-        cache->max_entries = _res_cache_get_max_entries();
-        cache->entries = calloc(sizeof(*cache->entries), cache->max_entries);
-        if (cache->entries) {
-            cache->mru_list.mru_prev = cache->mru_list.mru_next = &cache->mru_list;
-            XLOG("%s: cache created\n", __FUNCTION__);
-        } else {
-            free(cache);
-            cache = NULL;
+        for (nn = 0; nn < CACHE_SHARDS; nn++) {
+            Cache*  shard = &cache[nn];
+
+            pthread_mutex_init(&shard->lock, NULL);
+            shard->info = info;
+            shard->max_bytes = max_bytes / CACHE_SHARDS;
+            shard->stale_seconds = stale_seconds;
+            shard->num_buckets = CACHE_SHARD_BUCKETS;
+            shard->buckets = calloc(sizeof(*shard->buckets), shard->num_buckets);
+            if (shard->buckets == NULL) {
+                while (nn-- > 0) {
+                    free(cache[nn].buckets);
+                }
+                free(cache);
+                return NULL;
+            }
+            shard->mru_list.mru_prev = shard->mru_list.mru_next = &shard->mru_list;
         }
+        XLOG("%s: cache created\n", __FUNCTION__);
     }
     return cache;
 }
@@ -1506,8 +1796,9 @@ static Entry**
 _cache_lookup_p( Cache*   cache,
                  Entry*   key )
 {
-    int      index = key->hash % cache->max_entries;
-    Entry**  pnode = (Entry**) &cache->entries[ index ];
+    /* the low bits of the hash picked the shard */
+    int      index = (key->hash / CACHE_SHARDS) % cache->num_buckets;
+    Entry**  pnode = &cache->buckets[ index ];
 
     while (*pnode != NULL) {
         Entry*  node = *pnode;
@@ -1523,6 +1814,34 @@ _cache_lookup_p( Cache*   cache,
     return pnode;
 }
 
+/* Double the number of hash buckets. If that memory can't be had, the
+ * chains just get longer.
+ */
+static void
+_cache_grow( Cache*  cache )
+{
+    int      num_buckets = 2 * cache->num_buckets;
+    Entry**  buckets = calloc(sizeof(*buckets), num_buckets);
+    int      nn;
+
+    if (buckets == NULL)
+        return;
+
+    for (nn = 0; nn < cache->num_buckets; nn++) {
+        Entry*  e = cache->buckets[nn];
+        while (e != NULL) {
+            Entry*  next = e->hlink;
+            int     index = (e->hash / CACHE_SHARDS) % num_buckets;
+            e->hlink = buckets[index];
+            buckets[index] = e;
+            e = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->num_buckets = num_buckets;
+}
+
 /* Add a new entry to the hash table. 'lookup' must be the
  * result of an immediate previous failed _lookup_p() call
  * (i.e. with *lookup == NULL), and 'e' is the pointer to the
@@ -1537,9 +1856,14 @@ _cache_add_p( Cache*   cache,
     e->id = ++cache->last_id;
     entry_mru_add(e, &cache->mru_list);
     cache->num_entries += 1;
+    cache->bytes += entry_size(e, e->answerlen);
 
     XLOG("%s: entry %d added (count=%d)", __FUNCTION__,
          e->id, cache->num_entries);
+
+    if (cache->num_entries > 2 * cache->num_buckets) {
+        _cache_grow(cache);
+    }
 }
 
 /* Remove an existing entry from the hash table,
@@ -1557,6 +1881,7 @@ _cache_remove_p( Cache*   cache,
 
     entry_mru_remove(e);
     *lookup = e->hlink;
+    cache->bytes -= entry_size(e, e->answerlen);
     entry_free(e);
     cache->num_entries -= 1;
 }
@@ -1578,6 +1903,7 @@ _cache_remove_oldest( Cache*  cache )
         XLOG_QUERY(oldest->query, oldest->querylen);
     }
     _cache_remove_p(cache, lookup);
+    cache->evictions += 1;
 }
 
 /* Remove all expired entries from the hash table.
@@ -1588,7 +1914,7 @@ static void _cache_remove_expired(Cache* cache) {
 
     for (e = cache->mru_list.mru_next; e != &cache->mru_list;) {
         // Entry is old, remove
-        if (now >= e->expires) {
+        if (now >= e->expires + cache->stale_seconds) {
             Entry** lookup = _cache_lookup_p(cache, e);
             if (*lookup == NULL) { /* should not happen */
                 XLOG("%s: ENTRY NOT IN HTABLE ?", __FUNCTION__);
@@ -1596,12 +1922,28 @@ static void _cache_remove_expired(Cache* cache) {
             }
             e = e->mru_next;
             _cache_remove_p(cache, lookup);
+            cache->expirations += 1;
         } else {
             e = e->mru_next;
         }
     }
 }
 
+/* Make room for 'needed' more bytes, dropping expired entries first and
+ * then the least recently used ones.
+ */
+static void
+_cache_trim( Cache*  cache, size_t  needed )
+{
+    if (cache->bytes + needed <= cache->max_bytes)
+        return;
+
+    _cache_remove_expired(cache);
+    while (cache->bytes + needed > cache->max_bytes && cache->num_entries > 0) {
+        _cache_remove_oldest(cache);
+    }
+}
+
 ResolvCacheStatus
 _resolv_cache_lookup( unsigned              netid,
                       const void*           query,
@@ -1628,12 +1970,10 @@ _resolv_cache_lookup( unsigned              netid,
     }
     /* lookup cache */
     pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
 
-    cache = _find_named_cache_locked(netid);
+    cache = _cache_lock_shard(netid, key);
     if (cache == NULL) {
-        result = RESOLV_CACHE_UNSUPPORTED;
-        goto Exit;
+        return RESOLV_CACHE_UNSUPPORTED;
     }
 
     /* see the description of _lookup_p to understand this.
@@ -1644,6 +1984,12 @@ _resolv_cache_lookup( unsigned              netid,
 
     if (e == NULL) {
         XLOG( "NOT IN CACHE");
+        if (_cache_nx_answer_locked(cache, key, answer, answersize, answerlen)) {
+            XLOG( "NAME KNOWN NOT TO EXIST");
+            cache->nx_hits += 1;
+            result = RESOLV_CACHE_FOUND;
+            goto Exit;
+        }
         // calling thread will wait if an outstanding request is found
         // that matching this query
         if (!_cache_check_pending_request_locked(&cache, key, netid) || cache == NULL) {
@@ -1659,11 +2005,12 @@ _resolv_cache_lookup( unsigned              netid,
 
     now = _time_now();
 
-    /* remove stale entries here */
-    if (now >= e->expires) {
+    /* remove stale entries here, unless they can still be served */
+    if (now >= e->expires + cache->stale_seconds) {
         XLOG( " NOT IN CACHE (STALE ENTRY %p DISCARDED)", *lookup );
         XLOG_QUERY(e->query, e->querylen);
         _cache_remove_p(cache, lookup);
+        cache->expirations += 1;
         goto Exit;
     }
 
@@ -1686,11 +2033,63 @@ _resolv_cache_lookup( unsigned              netid,
     XLOG( "FOUND IN CACHE entry=%p", e );
     result = RESOLV_CACHE_FOUND;
 
+    if (now >= e->expires) {
+        cache->stale_hits += 1;
+    }
+
+    /* have this caller refresh an entry that's expired or about to. Only
+     * one refresh at a time: the rest keep getting the cached answer. */
+    if (!e->refreshing &&
+            now >= e->expires - (time_t)(e->ttl / CONFIG_PREFETCH_FRACTION)) {
+        XLOG( "REFRESHING entry=%p", e );
+        e->refreshing = 1;
+        cache->refreshes += 1;
+        result = RESOLV_CACHE_REFRESH;
+    }
+
 Exit:
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    if (cache != NULL) {
+        if (result == RESOLV_CACHE_FOUND || result == RESOLV_CACHE_REFRESH) {
+            cache->hits += 1;
+        } else if (result == RESOLV_CACHE_NOTFOUND) {
+            cache->misses += 1;
+        }
+        pthread_mutex_unlock(&cache->lock);
+    }
     return result;
 }
 
+int
+_resolv_cache_has_answer( unsigned     netid,
+                          const void*  query,
+                          int          querylen )
+{
+    Entry    key[1];
+    Entry*   e;
+    Cache*   cache;
+    uint8_t  nx_answer[DNS_HEADER_SIZE + NS_MAXCDNAME + 4];
+    int      nx_answerlen;
+    int      found;
+
+    if (!entry_init_key(key, query, querylen)) {
+        return 0;
+    }
+    pthread_once(&_res_cache_once, _res_cache_init);
+
+    cache = _cache_lock_shard(netid, key);
+    if (cache == NULL) {
+        return 0;
+    }
+    e = *_cache_lookup_p(cache, key);
+    if (e != NULL) {
+        found = _time_now() < e->expires + cache->stale_seconds;
+    } else {
+        found = _cache_nx_answer_locked(cache, key, nx_answer, sizeof(nx_answer),
+                                        &nx_answerlen);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return found;
+}
 
 void
 _resolv_cache_add( unsigned              netid,
@@ -1703,6 +2102,7 @@ _resolv_cache_add( unsigned              netid,
     Entry*   e;
     Entry**  lookup;
     u_long   ttl;
+    size_t   size;
     Cache*   cache = NULL;
 
     /* don't assume that the query has already been cached
@@ -1712,11 +2112,9 @@ _resolv_cache_add( unsigned              netid,
         return;
     }
 
-    pthread_mutex_lock(&_res_cache_list_lock);
-
-    cache = _find_named_cache_locked(netid);
+    cache = _cache_lock_shard(netid, key);
     if (cache == NULL) {
-        goto Exit;
+        return;
     }
 
     XLOG( "%s: query:", __FUNCTION__ );
@@ -1730,32 +2128,36 @@ _resolv_cache_add( unsigned              netid,
     lookup = _cache_lookup_p(cache, key);
     e      = *lookup;
 
-    if (e != NULL) { /* should not happen */
-        XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-             __FUNCTION__, e);
-        goto Exit;
-    }
-
-    if (cache->num_entries >= cache->max_entries) {
-        _cache_remove_expired(cache);
-        if (cache->num_entries >= cache->max_entries) {
-            _cache_remove_oldest(cache);
-        }
-        /* need to lookup again */
-        lookup = _cache_lookup_p(cache, key);
-        e      = *lookup;
-        if (e != NULL) {
+    if (e != NULL) {
+        if (!e->refreshing) { /* should not happen */
             XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-                __FUNCTION__, e);
+                 __FUNCTION__, e);
             goto Exit;
         }
+        /* the answer to a background refresh replaces the old one */
+        _cache_remove_p(cache, lookup);
+        lookup = _cache_lookup_p(cache, key);
     }
 
     ttl = answer_getTTL(answer, answerlen);
-    if (ttl > 0) {
+    /* an NXDOMAIN with answers is about the end of a CNAME chain, and the
+     * name the query asked about does exist */
+    if (ttl > 0 && answerlen >= DNS_HEADER_SIZE &&
+            (((const uint8_t*)answer)[3] & 0x0F) == ns_r_nxdomain &&
+            ((const uint8_t*)answer)[6] == 0 && ((const uint8_t*)answer)[7] == 0) {
+        _cache_nx_add_locked(cache, key, ttl);
+    }
+    size = entry_size(key, answerlen);
+    if (ttl > 0 && size <= cache->max_bytes) {
+        if (cache->bytes + size > cache->max_bytes) {
+            _cache_trim(cache, size);
+            /* need to lookup again */
+            lookup = _cache_lookup_p(cache, key);
+        }
         e = entry_alloc(key, answer, answerlen);
         if (e != NULL) {
             e->expires = ttl + _time_now();
+            e->ttl = ttl;
             _cache_add_p(cache, lookup, e);
         }
     }
@@ -1763,10 +2165,8 @@ _resolv_cache_add( unsigned              netid,
     _cache_dump_mru(cache);
 #endif
 Exit:
-    if (cache != NULL) {
-      _cache_notify_waiting_tid_locked(cache, key);
-    }
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    _cache_notify_waiting_tid_locked(cache, key);
+    pthread_mutex_unlock(&cache->lock);
 }
 
 /****************************************************************************/
@@ -1777,7 +2177,7 @@ Exit:
 /****************************************************************************/
 /****************************************************************************/
 
-// Head of the list of caches.  Protected by _res_cache_list_lock.
+// Head of the list of caches.  Changes are protected by _res_cache_list_lock.
 static struct resolv_cache_info _res_cache_list;
 
 /* insert resolv_cache_info into the list of resolv_cache_infos */
@@ -1785,9 +2185,14 @@ static void _insert_cache_info_locked(struct resolv_cache_info* cache_info);
 /* creates a resolv_cache_info */
 static struct resolv_cache_info* _create_cache_info( void );
 /* gets a resolv_cache_info associated with a network, or NULL if not found */
-static struct resolv_cache_info* _find_cache_info_locked(unsigned netid);
+static struct resolv_cache_info* _find_cache_info(unsigned netid);
 /* look up the named cache, and creates one if needed */
-static struct resolv_cache* _get_res_cache_for_net_locked(unsigned netid);
+static struct resolv_cache_info* _get_res_cache_for_net_locked(unsigned netid);
+/* lock or unlock every shard of a cache */
+static void _cache_lock_all(struct resolv_cache_info* cache_info);
+static void _cache_unlock_all(struct resolv_cache_info* cache_info);
+/* split a cache's budget between its shards, trimming them to fit; all shards must be locked */
+static void _cache_set_max_bytes_locked(struct resolv_cache_info* cache_info, size_t max_bytes);
 /* empty the named cache */
 static void _flush_cache_for_net_locked(unsigned netid);
 /* empty the nameservers set for the named cache */
@@ -1811,24 +2216,133 @@ _res_cache_init(void)
     pthread_mutex_init(&_res_cache_list_lock, NULL);
 }
 
-static struct resolv_cache*
+static struct resolv_cache_info*
 _get_res_cache_for_net_locked(unsigned netid)
 {
-    struct resolv_cache* cache = _find_named_cache_locked(netid);
-    if (!cache) {
-        struct resolv_cache_info* cache_info = _create_cache_info();
-        if (cache_info) {
-            cache = _resolv_cache_create();
-            if (cache) {
-                cache_info->cache = cache;
-                cache_info->netid = netid;
-                _insert_cache_info_locked(cache_info);
-            } else {
-                free(cache_info);
+    struct resolv_cache_info* cache_info = _find_cache_info(netid);
+    if (cache_info) {
+        return cache_info;
+    }
+
+    /* reuse a deleted network's cache if there is one */
+    for (cache_info = atomic_load_explicit(&_res_cache_list.next, memory_order_relaxed);
+         cache_info != NULL;
+         cache_info = atomic_load_explicit(&cache_info->next, memory_order_relaxed)) {
+        if (!atomic_load_explicit(&cache_info->live, memory_order_relaxed)) {
+            int nn;
+            _cache_lock_all(cache_info);
+            for (nn = 0; nn < CACHE_SHARDS; nn++) {
+                Cache* cache = &cache_info->cache[nn];
+                cache->hits = cache->misses = cache->expirations = cache->evictions = 0;
+                cache->stale_hits = cache->refreshes = cache->nx_hits = 0;
+                cache->stale_seconds = _res_cache_get_stale_seconds();
             }
+            _cache_set_max_bytes_locked(cache_info, _res_cache_get_max_bytes());
+            atomic_store_explicit(&cache_info->netid, netid, memory_order_relaxed);
+            atomic_store_explicit(&cache_info->live, 1, memory_order_relaxed);
+            _cache_unlock_all(cache_info);
+            return cache_info;
         }
     }
-    return cache;
+
+    cache_info = _create_cache_info();
+    if (cache_info) {
+        cache_info->cache = _resolv_cache_create(cache_info);
+        if (cache_info->cache) {
+            atomic_init(&cache_info->netid, netid);
+            atomic_init(&cache_info->live, 1);
+            _insert_cache_info_locked(cache_info);
+        } else {
+            free(cache_info);
+            cache_info = NULL;
+        }
+    }
+    return cache_info;
+}
+
+static void
+_cache_lock_all(struct resolv_cache_info* cache_info)
+{
+    int nn;
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        pthread_mutex_lock(&cache_info->cache[nn].lock);
+    }
+}
+
+static void
+_cache_unlock_all(struct resolv_cache_info* cache_info)
+{
+    int nn;
+    for (nn = CACHE_SHARDS; nn-- > 0; ) {
+        pthread_mutex_unlock(&cache_info->cache[nn].lock);
+    }
+}
+
+static void
+_cache_set_max_bytes_locked(struct resolv_cache_info* cache_info, size_t max_bytes)
+{
+    int nn;
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        Cache* cache = &cache_info->cache[nn];
+        cache->max_bytes = max_bytes / CACHE_SHARDS;
+        _cache_trim(cache, 0);
+    }
+}
+
+void
+_resolv_set_cache_size_for_net(unsigned netid, size_t max_bytes)
+{
+    pthread_once(&_res_cache_once, _res_cache_init);
+    pthread_mutex_lock(&_res_cache_list_lock);
+
+    // creates the cache if not created
+    struct resolv_cache_info* cache_info = _get_res_cache_for_net_locked(netid);
+
+    if (cache_info != NULL) {
+        if (max_bytes == 0) {
+            max_bytes = _res_cache_get_max_bytes();
+        }
+        _cache_lock_all(cache_info);
+        _cache_set_max_bytes_locked(cache_info, max_bytes);
+        _cache_unlock_all(cache_info);
+    }
+
+    pthread_mutex_unlock(&_res_cache_list_lock);
+}
+
+int
+_resolv_get_cache_stats_for_net(unsigned netid, struct resolv_cache_stats* stats)
+{
+    struct resolv_cache_info* cache_info;
+    int nn;
+
+    pthread_once(&_res_cache_once, _res_cache_init);
+    memset(stats, 0, sizeof(*stats));
+
+    cache_info = _find_cache_info(netid);
+    if (cache_info == NULL) {
+        return -1;
+    }
+
+    // each shard is consistent, though the totals aren't a single snapshot
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        Cache* cache = &cache_info->cache[nn];
+        pthread_mutex_lock(&cache->lock);
+        if (_cache_shard_is_live(cache, netid)) {
+            stats->max_bytes   += cache->max_bytes;
+            stats->bytes       += cache->bytes;
+            stats->entries     += cache->num_entries;
+            stats->hits        += cache->hits;
+            stats->misses      += cache->misses;
+            stats->expirations += cache->expirations;
+            stats->evictions   += cache->evictions;
+            stats->stale_hits  += cache->stale_hits;
+            stats->refreshes   += cache->refreshes;
+            stats->nx_hits     += cache->nx_hits;
+        }
+        pthread_mutex_unlock(&cache->lock);
+    }
+    return 0;
 }
 
 void
@@ -1845,9 +2359,15 @@ _resolv_flush_cache_for_net(unsigned netid)
 static void
 _flush_cache_for_net_locked(unsigned netid)
 {
-    struct resolv_cache* cache = _find_named_cache_locked(netid);
-    if (cache) {
-        _cache_flush_locked(cache);
+    struct resolv_cache_info* cache_info = _find_cache_info(netid);
+    int nn;
+    if (cache_info) {
+        _cache_lock_all(cache_info);
+        for (nn = 0; nn < CACHE_SHARDS; nn++) {
+            _cache_flush_locked(&cache_info->cache[nn]);
+        }
+        _cache_nx_flush_locked(cache_info);
+        _cache_unlock_all(cache_info);
     }
 }
 
@@ -1856,22 +2376,20 @@ void _resolv_delete_cache_for_net(unsigned netid)
     pthread_once(&_res_cache_once, _res_cache_init);
     pthread_mutex_lock(&_res_cache_list_lock);
 
-    struct resolv_cache_info* prev_cache_info = &_res_cache_list;
+    struct resolv_cache_info* cache_info = _find_cache_info(netid);
+    int nn;
 
-    while (prev_cache_info->next) {
-        struct resolv_cache_info* cache_info = prev_cache_info->next;
-
-        if (cache_info->netid == netid) {
-            prev_cache_info->next = cache_info->next;
-            _cache_flush_locked(cache_info->cache);
-            free(cache_info->cache->entries);
-            free(cache_info->cache);
-            _free_nameservers_locked(cache_info);
-            free(cache_info);
-            break;
+    if (cache_info) {
+        _cache_lock_all(cache_info);
+        for (nn = 0; nn < CACHE_SHARDS; nn++) {
+            _cache_flush_locked(&cache_info->cache[nn]);
         }
-
-        prev_cache_info = prev_cache_info->next;
+        _cache_nx_flush_locked(cache_info);
+        atomic_store_explicit(&cache_info->live, 0, memory_order_relaxed);
+        _cache_unlock_all(cache_info);
+        _free_nameservers_locked(cache_info);
+        memset(cache_info->defdname, 0, sizeof(cache_info->defdname));
+        memset(cache_info->dnsrch_offset, 0, sizeof(cache_info->dnsrch_offset));
     }
 
     pthread_mutex_unlock(&_res_cache_list_lock);
@@ -1883,45 +2401,71 @@ _create_cache_info(void)
     struct resolv_cache_info* cache_info;
 
     cache_info = calloc(sizeof(*cache_info), 1);
+    if (cache_info) {
+        pthread_mutex_init(&cache_info->nx_lock, NULL);
+    }
     return cache_info;
 }
 
 static void
 _insert_cache_info_locked(struct resolv_cache_info* cache_info)
 {
-    struct resolv_cache_info* last;
-
-    for (last = &_res_cache_list; last->next; last = last->next);
-
-    last->next = cache_info;
-
-}
+    struct resolv_cache_info* last = &_res_cache_list;
+    struct resolv_cache_info* next;
 
-static struct resolv_cache*
-_find_named_cache_locked(unsigned netid) {
-
-    struct resolv_cache_info* info = _find_cache_info_locked(netid);
-
-    if (info != NULL) return info->cache;
+    while ((next = atomic_load_explicit(&last->next, memory_order_relaxed)) != NULL) {
+        last = next;
+    }
 
-    return NULL;
+    /* publish the fully initialized cache_info to readers */
+    atomic_store_explicit(&last->next, cache_info, memory_order_release);
 }
 
 static struct resolv_cache_info*
-_find_cache_info_locked(unsigned netid)
+_find_cache_info(unsigned netid)
 {
-    struct resolv_cache_info* cache_info = _res_cache_list.next;
+    struct resolv_cache_info* cache_info =
+            atomic_load_explicit(&_res_cache_list.next, memory_order_acquire);
 
     while (cache_info) {
-        if (cache_info->netid == netid) {
+        if (atomic_load_explicit(&cache_info->live, memory_order_relaxed) &&
+                atomic_load_explicit(&cache_info->netid, memory_order_relaxed) == netid) {
             break;
         }
 
-        cache_info = cache_info->next;
+        cache_info = atomic_load_explicit(&cache_info->next, memory_order_acquire);
     }
     return cache_info;
 }
 
+static int
+_cache_shard_is_live(Cache* cache, unsigned netid)
+{
+    return atomic_load_explicit(&cache->info->live, memory_order_relaxed) &&
+            atomic_load_explicit(&cache->info->netid, memory_order_relaxed) == netid;
+}
+
+static Cache*
+_cache_lock_shard(unsigned netid, const Entry* key)
+{
+    struct resolv_cache_info* cache_info = _find_cache_info(netid);
+    Cache* cache;
+
+    if (cache_info == NULL) {
+        return NULL;
+    }
+
+    cache = &cache_info->cache[key->hash % CACHE_SHARDS];
+    pthread_mutex_lock(&cache->lock);
+
+    /* the cache may have been deleted or reused since we found it */
+    if (!_cache_shard_is_live(cache, netid)) {
+        pthread_mutex_unlock(&cache->lock);
+        return NULL;
+    }
+    return cache;
+}
+
 void
 _resolv_set_nameservers_for_net(unsigned netid, const char** servers, int numservers,
         const char *domains)
@@ -1938,7 +2482,7 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, int numser
     // creates the cache if not created
     _get_res_cache_for_net_locked(netid);
 
-    struct resolv_cache_info* cache_info = _find_cache_info_locked(netid);
+    struct resolv_cache_info* cache_info = _find_cache_info(netid);
 
     if (cache_info != NULL &&
             !_resolv_is_nameservers_equal_locked(cache_info, servers, numservers)) {
@@ -2057,7 +2601,7 @@ _resolv_populate_res_for_net(res_state statp)
     pthread_once(&_res_cache_once, _res_cache_init);
     pthread_mutex_lock(&_res_cache_list_lock);
 
-    struct resolv_cache_info* info = _find_cache_info_locked(statp->netid);
+    struct resolv_cache_info* info = _find_cache_info(statp->netid);
     if (info != NULL) {
         int nserv;
         struct addrinfo* ai;
@@ -479,6 +479,21 @@ __res_vinit(res_state statp, int preinit) {
 #endif
 	}
 
+#if defined(ANDROID_CHANGES) && defined(RES_USE_EDNS0)
+	/*
+	 * EDNS0 lets large answers come back by datagram instead of over TCP.
+	 * It's on unless net.dns.edns0 is "0"; net.dns.edns0_payload changes
+	 * the advertised size from EDNS0_PAYLOAD.
+	 */
+	if (__system_property_get("net.dns.edns0", buf) <= 0 || strcmp(buf, "0") != 0)
+		statp->options |= RES_USE_EDNS0;
+	if (statp->_u._ext.ext != NULL &&
+	    __system_property_get("net.dns.edns0_payload", buf) > 0) {
+		long payload = strtol(buf, NULL, 10);
+		if (payload >= PACKETSZ && payload <= 65535)
+			statp->_u._ext.ext->edns0_payload = (u_int16_t)payload;
+	}
+#endif
 	if ((cp = getenv("RES_OPTIONS")) != NULL)
 		res_setoptions(statp, cp, "env");
 	if (nserv > 0) {
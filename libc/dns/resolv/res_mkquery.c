@@ -95,6 +95,9 @@ __RCSID("$NetBSD: res_mkquery.c,v 1.6 2006/01/24 17:40:32 christos Exp $");
 #endif
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+#include "res_private.h"
 
 /* Options.  Leave them on. */
 #ifndef DEBUG
@@ -250,6 +253,13 @@ res_nopt(res_state statp,
 	if ((ep - cp) < 1 + RRFIXEDSZ)
 		return (-1);
 
+	/* Advertise the configured payload size, or the answer buffer if smaller. */
+	if (statp->_u._ext.ext != NULL && statp->_u._ext.ext->edns0_payload != 0) {
+		if (anslen > statp->_u._ext.ext->edns0_payload)
+			anslen = statp->_u._ext.ext->edns0_payload;
+	} else if (anslen > EDNS0_PAYLOAD)
+		anslen = EDNS0_PAYLOAD;
+
 	*cp++ = 0;	/* "." */
 
 	ns_put16(T_OPT, cp);	/* TYPE */
@@ -14,8 +14,16 @@ struct __res_state_ext {
 	} sort_list[MAXRESOLVSORT];
 	char nsuffix[64];
 	char nsuffix2[64];
+	struct timespec vctime;		/* when _vcsock was last used */
+	u_int16_t edns0_payload;	/* UDP payload size advertised with EDNS0 */
 };
 
+/*
+ * The default EDNS0 UDP payload size: bigger datagrams are likely to be
+ * fragmented, and fragments dropped.
+ */
+#define EDNS0_PAYLOAD 1232
+
 extern int
 res_ourserver_p(const res_state statp, const struct sockaddr *sa);
 
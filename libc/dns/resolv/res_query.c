@@ -168,6 +168,7 @@ again:
 		if ((statp->options & (RES_USE_EDNS0|RES_USE_DNSSEC)) != 0U &&
 		    ((oflags ^ statp->_flags) & RES_F_EDNS0ERR) != 0) {
 			statp->_flags |= RES_F_EDNS0ERR;
+			oflags = statp->_flags;	/* only retry once */
 			if (statp->options & RES_DEBUG)
 				printf(";; res_nquery: retry without EDNS0\n");
 			goto again;
@@ -101,6 +101,8 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
 #ifdef ANDROID_CHANGES
 #include "resolv_netid.h"
 #include "resolv_private.h"
@@ -137,7 +139,26 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #define EXT(res) ((res)->_u._ext)
 #define DBG 0
 
-static const int highestFD = FD_SETSIZE - 1;
+/*
+ * With more than one nameserver, the next one is sent the query if the
+ * previous ones haven't answered within this many milliseconds, and
+ * whichever answers first wins.
+ */
+#define DG_STAGGER_MS 500
+
+/*
+ * A TCP connection to a nameserver is kept for the thread's next query,
+ * unless it has been idle for longer than this.
+ */
+#define VC_IDLE_SECONDS 10
+
+/* The datagram queries of one res_nsend that are still waiting for answers. */
+struct dg_pending {
+	int		count;
+	int		waiting[MAXNS];
+	struct timespec	finish[MAXNS];
+	int		ns;		/* the nameserver that answered */
+};
 
 /* Forward. */
 
@@ -147,21 +168,21 @@ static int		send_vc(res_state, const u_char *, int,
 				u_char *, int, int *, int);
 static int		send_dg(res_state, const u_char *, int,
 				u_char *, int, int *, int,
-				int *, int *);
+				int *, int *, struct dg_pending *);
 static void		Aerror(const res_state, FILE *, const char *, int,
 			       const struct sockaddr *, int);
 static void		Perror(const res_state, FILE *, const char *, int);
 static int		sock_eq(struct sockaddr *, struct sockaddr *);
-#ifdef NEED_PSELECT
-static int		pselect(int, void *, void *, void *,
-				struct timespec *,
-				const sigset_t *);
-#endif
 void res_pquery(const res_state, const u_char *, int, FILE *);
 static int connect_with_timeout(int sock, const struct sockaddr *nsap,
 			socklen_t salen, int sec);
-static int retrying_select(const int sock, fd_set *readset, fd_set *writeset,
+static int retrying_poll(const int sock, const short events,
 			const struct timespec *finish);
+static int res_nsend_internal(res_state, const u_char *, int, u_char *, int,
+			int);
+#if USE_RESOLV_CACHE
+static void res_refresh_cache_entry(res_state, const u_char *, int);
+#endif
 
 /* BIONIC-BEGIN: implement source port randomization */
 typedef union {
@@ -363,9 +384,94 @@ res_queriesmatch(const u_char *buf1, const u_char *eom1,
 int
 res_nsend(res_state statp,
 	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+{
+	return res_nsend_internal(statp, buf, buflen, ans, anssiz, 1);
+}
+
+#if USE_RESOLV_CACHE
+/* The largest DNS message, which is what a refresh's answer buffer holds. */
+#define REFRESH_ANSWER_SIZE	(64 * 1024)
+
+/* A cached answer to fetch again in the background (RESOLV_CACHE_REFRESH). */
+struct refresh_request {
+	unsigned	netid;
+	unsigned	mark;
+	u_long		options;
+	int		buflen;
+	u_char		buf[];
+};
+
+static void *
+refresh_thread(void *arg)
+{
+	struct refresh_request *req = arg;
+	res_state statp;
+	u_char *ans;
+
+	/* Each thread has a resolver state of its own. */
+	statp = __res_get_state();
+	ans = malloc(REFRESH_ANSWER_SIZE);
+	if (statp != NULL && ans != NULL) {
+		statp->options = req->options;
+		res_setnetid(statp, req->netid);
+		res_setmark(statp, req->mark);
+		/* This adds the answer to the cache, or reports the failure. */
+		res_nsend_internal(statp, req->buf, req->buflen, ans,
+		    REFRESH_ANSWER_SIZE, 0);
+	} else {
+		_resolv_cache_query_failed(req->netid, req->buf, req->buflen);
+	}
+	if (statp != NULL)
+		__res_put_state(statp);
+	free(ans);
+	free(req);
+	return NULL;
+}
+
+/*
+ * Sends the query again from a thread of its own, so the caller can return
+ * the cached answer straight away.
+ */
+static void
+res_refresh_cache_entry(res_state statp, const u_char *buf, int buflen)
+{
+	struct refresh_request *req;
+	pthread_attr_t attr;
+	pthread_t thread;
+	int rc;
+
+	req = malloc(sizeof(*req) + buflen);
+	if (req != NULL) {
+		req->netid = statp->netid;
+		req->mark = statp->_mark;
+		req->options = statp->options;
+		req->buflen = buflen;
+		memcpy(req->buf, buf, buflen);
+
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		rc = pthread_create(&thread, &attr, refresh_thread, req);
+		pthread_attr_destroy(&attr);
+		if (rc == 0)
+			return;
+		free(req);
+	}
+	/* Let a later lookup try again. */
+	_resolv_cache_query_failed(statp->netid, buf, buflen);
+}
+#endif
+
+/*
+ * res_nsend, except that a background refresh (!use_cache) always sends the
+ * query and replaces the cached answer.
+ */
+static int
+res_nsend_internal(res_state statp,
+	  const u_char *buf, int buflen, u_char *ans, int anssiz, int use_cache)
 {
 	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
 	char abuf[NI_MAXHOST];
+	struct dg_pending pending;
 #if USE_RESOLV_CACHE
         ResolvCacheStatus     cache_status = RESOLV_CACHE_UNSUPPORTED;
 #endif
@@ -389,12 +495,20 @@ res_nsend(res_state statp,
 
 #if USE_RESOLV_CACHE
 	int  anslen = 0;
-	cache_status = _resolv_cache_lookup(
-			statp->netid, buf, buflen,
-			ans, anssiz, &anslen);
+	if (use_cache) {
+		cache_status = _resolv_cache_lookup(
+				statp->netid, buf, buflen,
+				ans, anssiz, &anslen);
+	} else {
+		cache_status = RESOLV_CACHE_REFRESH;
+	}
 
 	if (cache_status == RESOLV_CACHE_FOUND) {
 		return anslen;
+	} else if (cache_status == RESOLV_CACHE_REFRESH && use_cache) {
+		// the cached answer is still good to use, but needs fetching again
+		res_refresh_cache_entry(statp, buf, buflen);
+		return anslen;
 	} else if (cache_status != RESOLV_CACHE_UNSUPPORTED) {
 		// had a cache miss for a known network, so populate the thread private
 		// data so the normal resolve path can do its thing
@@ -501,6 +615,17 @@ res_nsend(res_state statp,
 	/*
 	 * Send request, RETRY times, or until successful.
 	 */
+	/*
+	 * Each query gets new datagram sockets, and so new random ports
+	 * from random_bind. Retries within this query share them.
+	 */
+	for (ns = 0; ns < statp->nscount; ns++) {
+		if (EXT(statp).nssocks[ns] != -1) {
+			(void) close(EXT(statp).nssocks[ns]);
+			EXT(statp).nssocks[ns] = -1;
+		}
+	}
+	memset(&pending, 0, sizeof(pending));
 	for (try = 0; try < statp->retry; try++) {
 	    for (ns = 0; ns < statp->nscount; ns++) {
 		struct sockaddr *nsap;
@@ -571,7 +696,7 @@ res_nsend(res_state statp,
 			}
 
 			n = send_dg(statp, buf, buflen, ans, anssiz, &terrno,
-				    ns, &v_circuit, &gotsomewhere);
+				    ns, &v_circuit, &gotsomewhere, &pending);
 			if (DBG) {
 				__libc_format_log(ANDROID_LOG_DEBUG, "libc", "used send_dg %d\n",n);
 			}
@@ -584,6 +709,14 @@ res_nsend(res_state statp,
 				__libc_format_log(ANDROID_LOG_DEBUG, "libc", "time=%ld\n",
                                                   time(NULL));
 			}
+			if (pending.ns != ns) {
+				/* An earlier nameserver answered first. */
+				ns = pending.ns;
+				nsap = get_nsaddr(statp, (size_t)ns);
+				nsaplen = get_salen(nsap);
+				statp->_flags &= ~RES_F_LASTMASK;
+				statp->_flags |= (ns << RES_F_LASTSHIFT);
+			}
 			if (v_circuit)
 				goto same_ns;
 			resplen = n;
@@ -600,20 +733,18 @@ res_nsend(res_state statp,
 			ans, (resplen > anssiz) ? anssiz : resplen);
 
 #if USE_RESOLV_CACHE
-                if (cache_status == RESOLV_CACHE_NOTFOUND) {
+                if (cache_status == RESOLV_CACHE_NOTFOUND ||
+                    cache_status == RESOLV_CACHE_REFRESH) {
                     _resolv_cache_add(statp->netid, buf, buflen,
                                       ans, resplen);
                 }
 #endif
 		/*
-		 * If we have temporarily opened a virtual circuit,
-		 * or if we haven't been asked to keep a socket open,
-		 * close the socket.
+		 * A virtual circuit is kept for this thread's next
+		 * query until it has been idle for VC_IDLE_SECONDS,
+		 * see send_vc. Datagram sockets are replaced by the
+		 * next query.
 		 */
-		if ((v_circuit && (statp->options & RES_USEVC) == 0U) ||
-		    (statp->options & RES_STAYOPEN) == 0U) {
-			res_nclose(statp);
-		}
 		if (statp->rhook) {
 			int done = 0, loops = 0;
 
@@ -741,8 +872,10 @@ send_vc(res_state statp,
 	HEADER *anhp = (HEADER *)(void *)ans;
 	struct sockaddr *nsap;
 	int nsaplen;
-	int truncating, connreset, resplen, n;
+	int truncating, connreset, reused, resplen, n;
 	struct iovec iov[2];
+	struct timespec now;
+	struct timeval tv;
 	u_short len;
 	u_char *cp;
 	void *tmp;
@@ -757,6 +890,7 @@ send_vc(res_state statp,
 	connreset = 0;
  same_ns:
 	truncating = 0;
+	reused = 0;
 
 	/* Are we still talking to whom we want to talk to? */
 	if (statp->_vcsock >= 0 && (statp->_flags & RES_F_VC) != 0) {
@@ -764,13 +898,19 @@ send_vc(res_state statp,
 		socklen_t size = sizeof peer;
 		unsigned old_mark;
 		socklen_t mark_size = sizeof(old_mark);
+		now = evNowTime();
 		if (getpeername(statp->_vcsock,
 				(struct sockaddr *)(void *)&peer, &size) < 0 ||
 		    !sock_eq((struct sockaddr *)(void *)&peer, nsap) ||
 			getsockopt(statp->_vcsock, SOL_SOCKET, SO_MARK, &old_mark, &mark_size) < 0 ||
-			old_mark != statp->_mark) {
+			old_mark != statp->_mark ||
+			EXT(statp).ext == NULL ||
+			evCmpTime(now, evAddTime(EXT(statp).ext->vctime,
+			    evConsTime((long)VC_IDLE_SECONDS, 0L))) > 0) {
 			res_nclose(statp);
 			statp->_flags &= ~RES_F_VC;
+		} else {
+			reused = 1;
 		}
 	}
 
@@ -779,10 +919,6 @@ send_vc(res_state statp,
 			res_nclose(statp);
 
 		statp->_vcsock = socket(nsap->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
-		if (statp->_vcsock > highestFD) {
-			res_nclose(statp);
-			errno = ENOTSOCK;
-		}
 		if (statp->_vcsock < 0) {
 			switch (errno) {
 			case EPROTONOSUPPORT:
@@ -822,6 +958,10 @@ send_vc(res_state statp,
 			res_nclose(statp);
 			return (0);
 		}
+		/* Don't wait forever on a connection the server has silently dropped. */
+		tv.tv_sec = get_timeout(statp, ns);
+		tv.tv_usec = 0;
+		setsockopt(statp->_vcsock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 		statp->_flags |= RES_F_VC;
 	}
 
@@ -836,6 +976,11 @@ send_vc(res_state statp,
 		*terrno = errno;
 		Perror(statp, stderr, "write failed", errno);
 		res_nclose(statp);
+		/* The server may have closed a connection we kept. */
+		if (reused && !connreset) {
+			connreset = 1;
+			goto same_ns;
+		}
 		return (0);
 	}
 	/*
@@ -859,10 +1004,12 @@ send_vc(res_state statp,
 		 * restarted.  Requery the server instead of
 		 * trying a new one.  When there is only one
 		 * server, this means that a query might work
-		 * instead of failing.  We only allow one reset
-		 * per query to prevent looping.
+		 * instead of failing.  The same goes for a
+		 * connection kept from an earlier query, which
+		 * the server may have closed as idle.  We only
+		 * allow one reset per query to prevent looping.
 		 */
-		if (*terrno == ECONNRESET && !connreset) {
+		if ((*terrno == ECONNRESET || reused) && !connreset) {
 			connreset = 1;
 			res_nclose(statp);
 			goto same_ns;
@@ -931,6 +1078,8 @@ send_vc(res_state statp,
 			ans, (resplen > anssiz) ? anssiz: resplen);
 		goto read_len;
 	}
+	if (EXT(statp).ext != NULL)
+		EXT(statp).ext->vctime = evNowTime();
 
 	/*
 	 * All is well, or the error is fatal.  Signal that the
@@ -944,7 +1093,6 @@ static int
 connect_with_timeout(int sock, const struct sockaddr *nsap, socklen_t salen, int sec)
 {
 	int res, origflags;
-	fd_set rset, wset;
 	struct timespec now, timeout, finish;
 
 	origflags = fcntl(sock, F_GETFL, 0);
@@ -963,7 +1111,7 @@ connect_with_timeout(int sock, const struct sockaddr *nsap, socklen_t salen, int
 			__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d send_vc\n", sock);
 		}
 
-		res = retrying_select(sock, &rset, &wset, &finish);
+		res = retrying_poll(sock, POLLIN | POLLOUT, &finish);
 		if (res <= 0) {
                         res = -1;
 		}
@@ -978,37 +1126,33 @@ done:
 }
 
 static int
-retrying_select(const int sock, fd_set *readset, fd_set *writeset, const struct timespec *finish)
+retrying_poll(const int sock, const short events, const struct timespec *finish)
 {
 	struct timespec now, timeout;
+	struct pollfd fds;
 	int n, error;
 	socklen_t len;
 
 
 retry:
 	if (DBG) {
-		__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d retying_select\n", sock);
+		__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d retrying_poll\n", sock);
 	}
 
 	now = evNowTime();
-	if (readset) {
-		FD_ZERO(readset);
-		FD_SET(sock, readset);
-	}
-	if (writeset) {
-		FD_ZERO(writeset);
-		FD_SET(sock, writeset);
-	}
 	if (evCmpTime(*finish, now) > 0)
 		timeout = evSubTime(*finish, now);
 	else
 		timeout = evConsTime(0L, 0L);
 
-	n = pselect(sock + 1, readset, writeset, NULL, &timeout, NULL);
+	fds.fd = sock;
+	fds.events = events;
+	fds.revents = 0;
+	n = ppoll(&fds, 1, &timeout, NULL);
 	if (n == 0) {
 		if (DBG) {
 			__libc_format_log(ANDROID_LOG_DEBUG, " libc",
-				"  %d retrying_select timeout\n", sock);
+				"  %d retrying_poll timeout\n", sock);
 		}
 		errno = ETIMEDOUT;
 		return 0;
@@ -1018,17 +1162,17 @@ retry:
 			goto retry;
 		if (DBG) {
 			__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-				"  %d retrying_select got error %d\n",sock, n);
+				"  %d retrying_poll got error %d\n",sock, n);
 		}
 		return n;
 	}
-	if ((readset && FD_ISSET(sock, readset)) || (writeset && FD_ISSET(sock, writeset))) {
+	if (fds.revents & (events | POLLERR | POLLHUP)) {
 		len = sizeof(error);
 		if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
 			errno = error;
 			if (DBG) {
 				__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-					"  %d retrying_select dot error2 %d\n", sock, errno);
+					"  %d retrying_poll dot error2 %d\n", sock, errno);
 			}
 
 			return -1;
@@ -1036,36 +1180,54 @@ retry:
 	}
 	if (DBG) {
 		__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-			"  %d retrying_select returning %d\n",sock, n);
+			"  %d retrying_poll returning %d\n",sock, n);
 	}
 
 	return n;
 }
 
 
+static void
+close_dg(res_state statp, struct dg_pending *pending, int ns)
+{
+	if (pending->waiting[ns]) {
+		pending->waiting[ns] = 0;
+		pending->count--;
+	}
+	if (EXT(statp).nssocks[ns] != -1) {
+		(void) close(EXT(statp).nssocks[ns]);
+		EXT(statp).nssocks[ns] = -1;
+	}
+}
+
+/*
+ * Sends the query to nameserver ns and waits for an answer from it or from
+ * any nameserver this res_nsend already sent to. Unless ns is the last
+ * nameserver, the wait ends after DG_STAGGER_MS so the caller can try the
+ * next one; the earlier ones keep being waited for until their own timeouts.
+ * On success, pending->ns is the nameserver that answered.
+ */
 static int
 send_dg(res_state statp,
 	const u_char *buf, int buflen, u_char *ans, int anssiz,
-	int *terrno, int ns, int *v_circuit, int *gotsomewhere)
+	int *terrno, int ns, int *v_circuit, int *gotsomewhere,
+	struct dg_pending *pending)
 {
 	const HEADER *hp = (const HEADER *)(const void *)buf;
 	HEADER *anhp = (HEADER *)(void *)ans;
 	const struct sockaddr *nsap;
 	int nsaplen;
 	struct timespec now, timeout, finish;
-	fd_set dsmask;
+	struct pollfd fds[MAXNS];
+	int fdns[MAXNS];
 	struct sockaddr_storage from;
 	socklen_t fromlen;
-	int resplen, seconds, n, s;
+	int resplen, seconds, n, s, i, nfds, rns;
 
 	nsap = get_nsaddr(statp, (size_t)ns);
 	nsaplen = get_salen(nsap);
 	if (EXT(statp).nssocks[ns] == -1) {
 		EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
-		if (EXT(statp).nssocks[ns] > highestFD) {
-			res_nclose(statp);
-			errno = ENOTSOCK;
-		}
 		if (EXT(statp).nssocks[ns] < 0) {
 			switch (errno) {
 			case EPROTONOSUPPORT:
@@ -1074,7 +1236,7 @@ send_dg(res_state statp,
 #endif
 			case EAFNOSUPPORT:
 				Perror(statp, stderr, "socket(dg)", errno);
-				return (0);
+				goto send_failed;
 			default:
 				*terrno = errno;
 				Perror(statp, stderr, "socket(dg)", errno);
@@ -1097,21 +1259,21 @@ send_dg(res_state statp,
 		 * ICMP port unreachable message to be returned.
 		 * If our datagram socket is "connected" to the
 		 * server, we get an ECONNREFUSED error on the next
-		 * socket operation, and select returns if the
+		 * socket operation, and poll returns if the
 		 * error message is received.  We can thus detect
 		 * the absence of a nameserver without timing out.
 		 */
 		if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
 			Aerror(statp, stderr, "bind(dg)", errno, nsap,
 			    nsaplen);
-			res_nclose(statp);
-			return (0);
+			close_dg(statp, pending, ns);
+			goto send_failed;
 		}
 		if (__connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
 			Aerror(statp, stderr, "connect(dg)", errno, nsap,
 			    nsaplen);
-			res_nclose(statp);
-			return (0);
+			close_dg(statp, pending, ns);
+			goto send_failed;
 		}
 #endif /* !CANNOT_CONNECT_DGRAM */
 		Dprint(statp->options & RES_DEBUG,
@@ -1122,27 +1284,80 @@ send_dg(res_state statp,
 #ifndef CANNOT_CONNECT_DGRAM
 	if (send(s, (const char*)buf, (size_t)buflen, 0) != buflen) {
 		Perror(statp, stderr, "send", errno);
-		res_nclose(statp);
-		return (0);
+		close_dg(statp, pending, ns);
+		goto send_failed;
 	}
 #else /* !CANNOT_CONNECT_DGRAM */
 	if (sendto(s, (const char*)buf, buflen, 0, nsap, nsaplen) != buflen)
 	{
 		Aerror(statp, stderr, "sendto", errno, nsap, nsaplen);
-		res_nclose(statp);
-		return (0);
+		close_dg(statp, pending, ns);
+		goto send_failed;
 	}
 #endif /* !CANNOT_CONNECT_DGRAM */
 
+	seconds = get_timeout(statp, ns);
+	now = evNowTime();
+	timeout = evConsTime((long)seconds, 0L);
+	if (!pending->waiting[ns]) {
+		pending->waiting[ns] = 1;
+		pending->count++;
+	}
+	pending->finish[ns] = evAddTime(now, timeout);
+	goto wait;
+
+ send_failed:
+	/* Go straight on to the next nameserver, if there is one. */
+	if (ns < statp->nscount - 1 || pending->count == 0)
+		return (0);
+
 	/*
 	 * Wait for reply.
 	 */
-	seconds = get_timeout(statp, ns);
+ wait:
 	now = evNowTime();
-	timeout = evConsTime((long)seconds, 0L);
-	finish = evAddTime(now, timeout);
-retry:
-	n = retrying_select(s, &dsmask, NULL, &finish);
+	finish = now;
+	for (i = 0; i < statp->nscount; i++) {
+		if (pending->waiting[i] && evCmpTime(pending->finish[i], finish) > 0)
+			finish = pending->finish[i];
+	}
+	if (ns < statp->nscount - 1) {
+		struct timespec stagger = evAddTime(now, evConsTime(0L, DG_STAGGER_MS * 1000000L));
+		if (evCmpTime(stagger, finish) < 0)
+			finish = stagger;
+	}
+ retry:
+	now = evNowTime();
+	nfds = 0;
+	for (i = 0; i < statp->nscount; i++) {
+		if (!pending->waiting[i])
+			continue;
+		if (EXT(statp).nssocks[i] == -1) {
+			/* Closed under us, by a res_nclose elsewhere. */
+			pending->waiting[i] = 0;
+			pending->count--;
+			continue;
+		}
+		if (evCmpTime(pending->finish[i], now) <= 0) {
+			/* Timed out, but keep the socket for this query's retries. */
+			pending->waiting[i] = 0;
+			pending->count--;
+			*gotsomewhere = 1;
+			continue;
+		}
+		fds[nfds].fd = EXT(statp).nssocks[i];
+		fds[nfds].events = POLLIN;
+		fds[nfds].revents = 0;
+		fdns[nfds] = i;
+		nfds++;
+	}
+	if (evCmpTime(finish, now) > 0)
+		timeout = evSubTime(finish, now);
+	else
+		timeout = evConsTime(0L, 0L);
+	if (nfds == 0)
+		return (0);
+	n = ppoll(fds, nfds, &timeout, NULL);
 
 	if (n == 0) {
 		Dprint(statp->options & RES_DEBUG, (stdout, ";; timeout\n"));
@@ -1150,18 +1365,30 @@ retry:
 		return (0);
 	}
 	if (n < 0) {
-		Perror(statp, stderr, "select", errno);
+		if (errno == EINTR)
+			goto retry;
+		Perror(statp, stderr, "poll", errno);
+		/* res_nclose closes every socket still waited on. */
+		memset(pending, 0, sizeof(*pending));
 		res_nclose(statp);
 		return (0);
 	}
+	for (i = 0; i < nfds && fds[i].revents == 0; i++)
+		;
+	if (i == nfds)
+		goto retry;
+	rns = fdns[i];
+	s = fds[i].fd;
 	errno = 0;
 	fromlen = sizeof(from);
-	resplen = recvfrom(s, (char*)ans, (size_t)anssiz,0,
+	resplen = recvfrom(s, (char*)ans, (size_t)anssiz, MSG_DONTWAIT,
 			   (struct sockaddr *)(void *)&from, &fromlen);
 	if (resplen <= 0) {
+		if (resplen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			goto retry;
 		Perror(statp, stderr, "recvfrom", errno);
-		res_nclose(statp);
-		return (0);
+		close_dg(statp, pending, rns);
+		goto retry;
 	}
 	*gotsomewhere = 1;
 	if (resplen < HFIXEDSZ) {
@@ -1172,8 +1399,8 @@ retry:
 		       (stdout, ";; undersized: %d\n",
 			resplen));
 		*terrno = EMSGSIZE;
-		res_nclose(statp);
-		return (0);
+		close_dg(statp, pending, rns);
+		goto retry;
 	}
 	if (hp->id != anhp->id) {
 		/*
@@ -1218,6 +1445,8 @@ retry:
 			ans, (resplen > anssiz) ? anssiz : resplen);
 		/* record the error */
 		statp->_flags |= RES_F_EDNS0ERR;
+		/* res_nclose closes every socket still waited on. */
+		memset(pending, 0, sizeof(*pending));
 		res_nclose(statp);
 		return (0);
 	}
@@ -1237,18 +1466,19 @@ retry:
 			(statp->pfcode & RES_PRF_REPLY),
 			(stdout, ";; wrong query name:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		goto retry;;
+		goto retry;
 	}
+	pending->ns = rns;
 	if (anhp->rcode == SERVFAIL ||
 	    anhp->rcode == NOTIMP ||
 	    anhp->rcode == REFUSED) {
 		DprintQ(statp->options & RES_DEBUG,
 			(stdout, "server rejected query:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		res_nclose(statp);
+		close_dg(statp, pending, rns);
 		/* don't retry if called from dig */
 		if (!statp->pfcode)
-			return (0);
+			goto retry;
 	}
 	if (!(statp->options & RES_IGNTC) && anhp->tc) {
 		/*
@@ -1258,7 +1488,6 @@ retry:
 		Dprint(statp->options & RES_DEBUG,
 		       (stdout, ";; truncated answer\n"));
 		*v_circuit = 1;
-		res_nclose(statp);
 		return (1);
 	}
 	/*
@@ -1325,29 +1554,3 @@ sock_eq(struct sockaddr *a, struct sockaddr *b) {
 		return 0;
 	}
 }
-
-#ifdef NEED_PSELECT
-/* XXX needs to move to the porting library. */
-static int
-pselect(int nfds, void *rfds, void *wfds, void *efds,
-	struct timespec *tsp, const sigset_t *sigmask)
-{
-	struct timeval tv, *tvp;
-	sigset_t sigs;
-	int n;
-
-	if (tsp) {
-		tvp = &tv;
-		tv = evTimeVal(*tsp);
-	} else
-		tvp = NULL;
-	if (sigmask)
-		sigprocmask(SIG_SETMASK, sigmask, &sigs);
-	n = select(nfds, rfds, wfds, efds, tvp);
-	if (sigmask)
-		sigprocmask(SIG_SETMASK, &sigs, NULL);
-	if (tsp)
-		*tsp = evTimeSpec(tv);
-	return (n);
-}
-#endif
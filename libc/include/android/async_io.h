@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_ASYNC_IO_H
+#define _ANDROID_ASYNC_IO_H
+
+#include <linux/aio_abi.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+struct iovec;
+struct timespec;
+
+/*
+ * Thin wrappers for the kernel's native asynchronous I/O: any number of
+ * reads, writes and syncs can be submitted with one system call and their
+ * completions collected with another. Requests are the kernel's struct iocb
+ * from <linux/aio_abi.h>, filled in by the helpers below; 'data' comes back
+ * in the completion's io_event.data, and io_event.res is what the equivalent
+ * system call would have returned, or -errno. Only files opened with
+ * O_DIRECT are guaranteed not to block on submission.
+ */
+
+/* Creates a context for up to 'max_events' requests at once. Returns 0, or -1 with errno set. */
+extern int android_aio_setup(unsigned max_events, aio_context_t* ctx);
+
+/* Destroys a context, waiting for its outstanding requests. Returns 0, or -1 with errno set. */
+extern int android_aio_destroy(aio_context_t ctx);
+
+/*
+ * Submits 'count' requests with as few system calls as the kernel allows.
+ * Returns how many were submitted, which is less than 'count' only if the
+ * next one couldn't be (with errno saying why), or -1 with errno set if
+ * none could be.
+ */
+extern int android_aio_submit(aio_context_t ctx, struct iocb** iocbs, size_t count);
+
+/*
+ * Waits up to 'timeout' (forever if NULL) for at least 'min_events'
+ * completions and collects up to 'max_events' of them. Returns how many
+ * were collected, or -1 with errno set.
+ */
+extern int android_aio_getevents(aio_context_t ctx, size_t min_events, size_t max_events,
+                                 struct io_event* events, const struct timespec* timeout);
+
+/*
+ * Cancels a request. If it was cancelled, returns 0 with its completion in
+ * 'result'; otherwise returns -1 with errno set (EAGAIN if it can't be).
+ */
+extern int android_aio_cancel(aio_context_t ctx, struct iocb* iocb, struct io_event* result);
+
+static __inline__ void android_aio_prep(struct iocb* iocb, int opcode, int fd, const void* buf,
+                                        size_t count, off64_t offset, void* data) {
+  __builtin_memset(iocb, 0, sizeof(*iocb));
+  iocb->aio_lio_opcode = opcode;
+  iocb->aio_fildes = fd;
+  iocb->aio_buf = (uintptr_t) buf;
+  iocb->aio_nbytes = count;
+  iocb->aio_offset = offset;
+  iocb->aio_data = (uintptr_t) data;
+}
+
+static __inline__ void android_aio_prep_pread(struct iocb* iocb, int fd, void* buf, size_t count,
+                                              off64_t offset, void* data) {
+  android_aio_prep(iocb, IOCB_CMD_PREAD, fd, buf, count, offset, data);
+}
+
+static __inline__ void android_aio_prep_pwrite(struct iocb* iocb, int fd, const void* buf, size_t count,
+                                               off64_t offset, void* data) {
+  android_aio_prep(iocb, IOCB_CMD_PWRITE, fd, buf, count, offset, data);
+}
+
+/* 'iov' must stay valid until the request has been submitted. */
+static __inline__ void android_aio_prep_preadv(struct iocb* iocb, int fd, const struct iovec* iov, int iovcnt,
+                                               off64_t offset, void* data) {
+  android_aio_prep(iocb, IOCB_CMD_PREADV, fd, iov, iovcnt, offset, data);
+}
+
+static __inline__ void android_aio_prep_pwritev(struct iocb* iocb, int fd, const struct iovec* iov, int iovcnt,
+                                                off64_t offset, void* data) {
+  android_aio_prep(iocb, IOCB_CMD_PWRITEV, fd, iov, iovcnt, offset, data);
+}
+
+static __inline__ void android_aio_prep_fdsync(struct iocb* iocb, int fd, void* data) {
+  android_aio_prep(iocb, IOCB_CMD_FDSYNC, fd, NULL, 0, 0, data);
+}
+
+/* Makes the request add 1 to the eventfd 'efd' when it completes, for epoll. */
+static __inline__ void android_aio_set_eventfd(struct iocb* iocb, int efd) {
+  iocb->aio_flags |= IOCB_FLAG_RESFD;
+  iocb->aio_resfd = efd;
+}
+
+__END_DECLS
+
+#endif /* _ANDROID_ASYNC_IO_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_COPY_FD_RANGE_H
+#define _ANDROID_COPY_FD_RANGE_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/*
+ * Copies up to 'count' bytes from 'in_fd' to 'out_fd' the cheapest way the
+ * kernel allows: with sendfile from a file, with splice to or from a pipe,
+ * with splice through a pipe kept per thread between sockets, and only
+ * through user space if none of those work. As with sendfile, if 'offset'
+ * is non-NULL the copy starts there and *offset is advanced, leaving in_fd's
+ * file offset alone. Retries after signals and partial transfers; may block
+ * to finish writing data it has already read even if 'out_fd' is
+ * non-blocking. Returns the number of bytes copied, which is less than
+ * 'count' only at end of file or if an error stopped it, or -1 with errno
+ * set if an error stopped it before anything was copied.
+ */
+extern ssize_t android_copy_fd_range(int in_fd, off64_t* offset, int out_fd, size_t count);
+
+__END_DECLS
+
+#endif /* _ANDROID_COPY_FD_RANGE_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_CPU_FEATURES_H
+#define _ANDROID_CPU_FEATURES_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * What the CPU we're running on can do, decoded once from AT_HWCAP and
+ * AT_HWCAP2 on ARM, or CPUID on x86, so that code choosing between
+ * implementations needn't decode them itself. Only features the kernel has
+ * enabled are reported.
+ */
+
+/* ARM and ARM64. */
+#define ANDROID_CPU_FEATURE_NEON       (1ULL << 0)  /* Advanced SIMD. */
+#define ANDROID_CPU_FEATURE_VFPV3      (1ULL << 1)
+#define ANDROID_CPU_FEATURE_VFPV4      (1ULL << 2)  /* Including fused multiply-add. */
+#define ANDROID_CPU_FEATURE_IDIV       (1ULL << 3)  /* Integer division in ARM and Thumb. */
+#define ANDROID_CPU_FEATURE_PMULL      (1ULL << 4)
+#define ANDROID_CPU_FEATURE_SHA1       (1ULL << 5)  /* Also set for x86's SHA extensions. */
+#define ANDROID_CPU_FEATURE_SHA2       (1ULL << 6)  /* Likewise; x86's only do SHA-256. */
+#define ANDROID_CPU_FEATURE_CRC32      (1ULL << 7)
+
+/* ARM, ARM64 and x86: the ARMv8 cryptography extension's or AES-NI's. */
+#define ANDROID_CPU_FEATURE_AES        (1ULL << 8)
+
+/* x86 and x86-64. */
+#define ANDROID_CPU_FEATURE_SSSE3      (1ULL << 16)
+#define ANDROID_CPU_FEATURE_SSE4_1     (1ULL << 17)
+#define ANDROID_CPU_FEATURE_SSE4_2     (1ULL << 18)
+#define ANDROID_CPU_FEATURE_POPCNT     (1ULL << 19)
+#define ANDROID_CPU_FEATURE_MOVBE      (1ULL << 20)
+#define ANDROID_CPU_FEATURE_PCLMULQDQ  (1ULL << 21)
+#define ANDROID_CPU_FEATURE_AVX        (1ULL << 22)
+#define ANDROID_CPU_FEATURE_AVX2       (1ULL << 23)
+
+struct android_cpu_features {
+  uint64_t flags;     /* ANDROID_CPU_FEATURE_* bits. */
+
+  /*
+   * ARM and ARM64: the first CPU's main ID register, as far as /proc/cpuinfo
+   * tells us. 0 if it doesn't, and on other architectures.
+   */
+  uint32_t midr;
+
+  /* x86 and x86-64: the processor signature from CPUID leaf 1. 0 elsewhere. */
+  uint32_t x86_signature;
+};
+
+#define ANDROID_CPU_MIDR_IMPLEMENTER(midr) (((midr) >> 24) & 0xff)
+#define ANDROID_CPU_MIDR_VARIANT(midr)     (((midr) >> 20) & 0xf)
+#define ANDROID_CPU_MIDR_PART(midr)        (((midr) >> 4) & 0xfff)
+#define ANDROID_CPU_MIDR_REVISION(midr)    ((midr) & 0xf)
+
+/*
+ * Returns the CPU's features. The first call decodes them; every call
+ * returns the same pointer, which stays valid for the life of the process.
+ */
+extern const struct android_cpu_features* android_cpu_features(void);
+
+__END_DECLS
+
+#endif /* _ANDROID_CPU_FEATURES_H */
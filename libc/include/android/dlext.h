@@ -60,13 +60,33 @@ enum {
 
   ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET    = 0x20,
 
+  /* When set with ANDROID_DLEXT_WRITE_RELRO or ANDROID_DLEXT_USE_RELRO, the
+   * GNU RELRO sections of all the libraries newly loaded by this call (the
+   * library itself and any of its DT_NEEDED dependencies that were not
+   * already loaded) are written to or compared against relro_fd, one after
+   * the other in the order in which they are relocated. The replaying
+   * process must load the same set of libraries at the same addresses for
+   * pages to be shared; pages that differ are simply left private.
+   */
+  ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES = 0x40,
+
+  /* When set, the constructors (DT_INIT and DT_INIT_ARRAY) of the library
+   * and of its newly loaded dependencies are not run by android_dlopen_ext.
+   * Each library is initialized, dependencies first as usual, the first
+   * time dlsym returns one of its symbols, or when android_dlinit is called
+   * on it. Loading another library that depends on it initializes it too.
+   */
+  ANDROID_DLEXT_DEFER_CONSTRUCTORS    = 0x80,
+
   /* Mask of valid bits */
   ANDROID_DLEXT_VALID_FLAG_BITS       = ANDROID_DLEXT_RESERVED_ADDRESS |
                                         ANDROID_DLEXT_RESERVED_ADDRESS_HINT |
                                         ANDROID_DLEXT_WRITE_RELRO |
                                         ANDROID_DLEXT_USE_RELRO |
                                         ANDROID_DLEXT_USE_LIBRARY_FD |
-                                        ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET,
+                                        ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET |
+                                        ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES |
+                                        ANDROID_DLEXT_DEFER_CONSTRUCTORS,
 };
 
 typedef struct {
@@ -80,6 +100,21 @@ typedef struct {
 
 extern void* android_dlopen_ext(const char* filename, int flag, const android_dlextinfo* extinfo);
 
+/* Opens 'count' libraries as if by dlopen(filename, flags) each, but loads
+ * and links the union of their dependency graphs in one pass. On success,
+ * stores a handle for each in 'handles' (dlclose each one as usual) and
+ * returns 0. On failure, none of the libraries stay loaded and -1 is
+ * returned; dlerror says why.
+ */
+extern int android_dlopen_many(const char* const filenames[], size_t count, int flags, void* handles[]);
+
+/* Runs the constructors of a library opened with
+ * ANDROID_DLEXT_DEFER_CONSTRUCTORS, and of its dependencies, if they haven't
+ * run yet. Returns 0 on success, and -1 if handle isn't a loaded library;
+ * dlerror says why.
+ */
+extern int android_dlinit(void* handle);
+
 __END_DECLS
 
 #endif /* __ANDROID_DLEXT_H__ */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_DNS_ASYNC_H
+#define _ANDROID_DNS_ASYNC_H
+
+#include <netdb.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Non-blocking name lookups for event loops. Queries are started on a
+ * channel and run in the background, at most a fixed number at a time, with
+ * the rest queued; the channel's file descriptor polls readable while there
+ * are finished queries to collect. Lookups go through getaddrinfo, so they
+ * share its cache and per-network configuration.
+ */
+
+typedef struct android_dns_channel android_dns_channel_t;
+typedef struct android_dns_query android_dns_query_t;
+
+struct android_dns_result {
+  android_dns_query_t* query; /* No longer valid, just for identification. */
+  void* user_data;            /* As passed to android_dns_getaddrinfo. */
+  int error;                  /* What getaddrinfo returned. */
+  struct addrinfo* addrinfo;  /* What getaddrinfo found, for freeaddrinfo. */
+};
+
+/*
+ * Returns a new channel that looks names up on network 'netid' (0 for the
+ * default network), running at most 'max_running' queries at once (0 for a
+ * default), or NULL with errno set on failure.
+ */
+extern android_dns_channel_t* android_dns_channel_create(unsigned netid, unsigned max_running) __LIBC_ABI_PUBLIC__;
+
+/*
+ * Cancels every query on the channel, closes its file descriptor and frees
+ * it. Doesn't wait for queries already running: they finish in the background.
+ */
+extern void android_dns_channel_destroy(android_dns_channel_t* channel) __LIBC_ABI_PUBLIC__;
+
+/*
+ * Returns the channel's file descriptor, which polls readable while there are
+ * finished queries to collect. It belongs to the channel: don't read or close it.
+ */
+extern int android_dns_channel_fd(android_dns_channel_t* channel) __LIBC_ABI_PUBLIC__;
+
+/*
+ * Starts getaddrinfo(node, service, hints) on the channel. The arguments are
+ * copied. Returns the query, or NULL with errno set on failure.
+ */
+extern android_dns_query_t* android_dns_getaddrinfo(android_dns_channel_t* channel,
+                                                    const char* node, const char* service,
+                                                    const struct addrinfo* hints,
+                                                    void* user_data) __LIBC_ABI_PUBLIC__;
+
+/*
+ * Cancels a query that hasn't been collected yet: it will never be returned
+ * by android_dns_collect, and 'query' is no longer valid.
+ */
+extern void android_dns_cancel(android_dns_channel_t* channel, android_dns_query_t* query) __LIBC_ABI_PUBLIC__;
+
+/*
+ * Collects a finished query, oldest first. Returns 1 and fills in 'result',
+ * or returns 0 if no query has finished.
+ */
+extern int android_dns_collect(android_dns_channel_t* channel, struct android_dns_result* result) __LIBC_ABI_PUBLIC__;
+
+__END_DECLS
+
+#endif /* _ANDROID_DNS_ASYNC_H */
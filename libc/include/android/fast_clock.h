@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#ifndef _ANDROID_FAST_CLOCK_H
+#define _ANDROID_FAST_CLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Clocks for code that stamps events at a high rate, such as tracing.
+ *
+ * The coarse clocks are CLOCK_MONOTONIC_COARSE and CLOCK_REALTIME_COARSE,
+ * read through the vdso. They're cheap but only advance once per kernel tick
+ * (see clock_getres).
+ */
+extern int64_t android_coarse_monotonic_ns(void);
+extern int64_t android_coarse_realtime_ns(void);
+
+/*
+ * The fast clock reads the CPU's constant-rate counter directly: cntvct_el0
+ * on arm64, or the TSC on x86-64 when cpuid says it's invariant. Reading it
+ * takes no system call and no vdso retry loop. Where there's no such
+ * counter, a tick is a CLOCK_MONOTONIC nanosecond.
+ *
+ * Stamp events with android_fast_clock_ticks and convert them later, one at
+ * a time or in batches. Conversion is calibrated against CLOCK_MONOTONIC on
+ * first use (which can take a few milliseconds on x86-64 CPUs that don't
+ * report their TSC frequency) and doesn't follow later NTP adjustments, so
+ * it can drift from CLOCK_MONOTONIC by the counter's error in parts per
+ * million.
+ */
+
+/* Returns 1 if the fast clock reads a hardware counter, 0 otherwise. */
+extern int android_fast_clock_is_counter(void);
+
+extern uint64_t android_fast_clock_ticks(void);
+
+/* Converts ticks to CLOCK_MONOTONIC nanoseconds. */
+extern int64_t android_fast_clock_ticks_to_ns(uint64_t ticks);
+
+/* Converts n ticks to CLOCK_MONOTONIC nanoseconds. 'ticks' and 'ns' may be the same array. */
+extern void android_fast_clock_ticks_to_ns_batch(const uint64_t* ticks, int64_t* ns, size_t n);
+
+/* android_fast_clock_ticks_to_ns(android_fast_clock_ticks()). */
+extern int64_t android_fast_clock_ns(void);
+
+__END_DECLS
+
+#endif /* _ANDROID_FAST_CLOCK_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_MMSG_ARENA_H
+#define _ANDROID_MMSG_ARENA_H
+
+#include <sys/cdefs.h>
+#include <sys/socket.h>
+#include <time.h>
+
+__BEGIN_DECLS
+
+/*
+ * Batched datagram I/O with recvmmsg and sendmmsg. An arena holds a fixed
+ * number of messages, each with its own buffer and address, in a single
+ * allocation, and keeps the mmsghdr vector pointing at them so that a batch
+ * can be sent or received without any per-message setup by the caller.
+ * Both go through sendmmsg and recvmmsg, so netd sees them like any other
+ * socket I/O. An arena may only be used by one thread at a time.
+ */
+
+typedef struct android_mmsg_arena android_mmsg_arena_t;
+
+/*
+ * Returns a new arena of 'count' messages of up to 'buffer_size' bytes each,
+ * or NULL with errno set on failure.
+ */
+extern android_mmsg_arena_t* android_mmsg_arena_create(size_t count, size_t buffer_size);
+
+extern void android_mmsg_arena_destroy(android_mmsg_arena_t* arena);
+
+/*
+ * Returns the arena's mmsghdr vector. After android_mmsg_arena_recv, message
+ * 'i' is msg_len bytes at android_mmsg_arena_buffer(arena, i) from the
+ * address at msg_hdr.msg_name.
+ */
+extern struct mmsghdr* android_mmsg_arena_msgs(android_mmsg_arena_t* arena);
+
+/* Returns message 'i's buffer, which is 'buffer_size' bytes long. */
+extern void* android_mmsg_arena_buffer(android_mmsg_arena_t* arena, size_t i);
+
+/*
+ * Makes message 'i' the first 'length' bytes of its buffer, to be sent to
+ * 'addr', or to the socket's peer if 'addr' is NULL. Returns 0, or -1 with
+ * errno set to EINVAL if 'length' or 'addr_length' is too long.
+ */
+extern int android_mmsg_arena_set_message(android_mmsg_arena_t* arena, size_t i, size_t length,
+                                          const struct sockaddr* addr, socklen_t addr_length);
+
+/*
+ * Receives up to the arena's count of messages with a single recvmmsg, as
+ * recvmmsg(fd, msgs, count, flags, timeout) would. Returns how many were
+ * received, or -1 with errno set.
+ */
+extern int android_mmsg_arena_recv(android_mmsg_arena_t* arena, int fd, int flags,
+                                   const struct timespec* timeout);
+
+/*
+ * Sends the first 'count' messages set with android_mmsg_arena_set_message,
+ * calling sendmmsg again after partial sends and signals. Returns how many
+ * were sent, which is less than 'count' only if an error stopped it, or -1
+ * with errno set if an error stopped it before anything was sent.
+ */
+extern int android_mmsg_arena_send(android_mmsg_arena_t* arena, int fd, size_t count, int flags);
+
+__END_DECLS
+
+#endif /* _ANDROID_MMSG_ARENA_H */
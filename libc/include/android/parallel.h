@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_PARALLEL_H
+#define _ANDROID_PARALLEL_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * A process-wide work-stealing thread pool, shared by libc and anyone else
+ * who wants to run work in parallel without starting threads of their own.
+ * The pool has one worker per online CPU (less the calling thread, which
+ * helps out while it waits) and is started the first time it's used.
+ * After fork, the child starts a pool of its own; tasks still queued in the
+ * parent when it forked aren't run in the child.
+ */
+
+typedef struct android_task_group android_task_group_t;
+
+/* Returns a new, empty task group, or NULL with errno set on failure. */
+extern android_task_group_t* android_task_group_create(void);
+
+/* Destroys a group. There must be no tasks in it still to run. */
+extern void android_task_group_destroy(android_task_group_t* group);
+
+/*
+ * Queues fn(arg) to be run on the pool as part of 'group'. Tasks may submit
+ * further tasks. If the task can't be queued it's run before returning.
+ * Returns 0, or EINVAL if 'group' or 'fn' is NULL.
+ */
+extern int android_task_submit(android_task_group_t* group, void (*fn)(void*), void* arg);
+
+/*
+ * Returns once every task submitted to 'group' has finished, running queued
+ * tasks on the calling thread in the meantime.
+ */
+extern void android_task_group_wait(android_task_group_t* group);
+
+/*
+ * Calls fn(chunk_begin, chunk_end, arg) for disjoint chunks covering
+ * [begin, end), in parallel, each at most 'grain' long (0 lets the pool
+ * choose), and returns when every chunk has been done.
+ * Returns 0, or EINVAL if 'fn' is NULL.
+ */
+extern int android_parallel_for(size_t begin, size_t end, size_t grain,
+                                void (*fn)(size_t chunk_begin, size_t chunk_end, void* arg), void* arg);
+
+__END_DECLS
+
+#endif /* _ANDROID_PARALLEL_H */
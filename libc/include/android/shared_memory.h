@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_SHARED_MEMORY_H
+#define _ANDROID_SHARED_MEMORY_H
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/*
+ * Anonymous shared memory for handing data between processes without a
+ * filesystem round trip. A region is a file descriptor, passed to peers over
+ * a unix domain socket, that each side maps with mmap(MAP_SHARED). A region's
+ * size is fixed once it has been mapped, so a peer can't shrink it out from
+ * under a mapping.
+ */
+
+/*
+ * Returns a close-on-exec file descriptor for a new zero-filled region of
+ * 'size' bytes named 'name' (which only shows up in /proc/pid/maps), or -1
+ * with errno set on failure.
+ */
+extern int android_shm_create(const char* name, size_t size);
+
+/*
+ * Permanently restricts every future mapping of the region, in any process,
+ * to at most 'prot'. PROT_READ makes it read-only for everyone. Protections
+ * can be taken away but never given back. Returns 0, or -1 with errno set.
+ */
+extern int android_shm_seal(int fd, int prot);
+
+/* Returns the region's size, or -1 with errno set. */
+extern ssize_t android_shm_size(int fd);
+
+/*
+ * A byte ring buffer in a shared region, for one process writing and one
+ * reading. Neither side blocks: they poll, or signal each other some other
+ * way (an eventfd passed alongside, say).
+ */
+typedef struct android_shm_ring android_shm_ring_t;
+
+/*
+ * Creates a ring holding up to 'capacity' bytes, which must be a power of
+ * two no bigger than 1GiB. Returns NULL with errno set on failure.
+ */
+extern android_shm_ring_t* android_shm_ring_create(const char* name, size_t capacity);
+
+/*
+ * Maps a ring created by another process, given its region. The fd is
+ * duplicated. Returns NULL with errno set to EINVAL if it isn't a ring.
+ */
+extern android_shm_ring_t* android_shm_ring_map(int fd);
+
+/* Returns the ring's region, to be passed to the peer. The ring owns it. */
+extern int android_shm_ring_fd(android_shm_ring_t* ring);
+
+/* Unmaps the ring and closes its region. */
+extern void android_shm_ring_destroy(android_shm_ring_t* ring);
+
+/*
+ * Copies as much of 'data' into the ring as there's room for. Returns the
+ * number of bytes written, which may be 0.
+ */
+extern size_t android_shm_ring_write(android_shm_ring_t* ring, const void* data, size_t length);
+
+/*
+ * Copies up to 'length' bytes out of the ring. Returns the number of bytes
+ * read, which is 0 if the ring is empty, or -1 with errno set to EIO if the
+ * peer has corrupted the ring.
+ */
+extern ssize_t android_shm_ring_read(android_shm_ring_t* ring, void* buf, size_t length);
+
+__END_DECLS
+
+#endif /* _ANDROID_SHARED_MEMORY_H */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_STARTUP_TRACE_H
+#define _ANDROID_STARTUP_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * If a process is started with LIBC_STARTUP_TRACE set in its environment,
+ * the dynamic linker and libc record a CLOCK_MONOTONIC timestamp as each
+ * phase of startup begins, which the process can read back from main on.
+ * Static executables have no linker phases: theirs are left 0.
+ */
+
+enum android_startup_phase {
+  ANDROID_STARTUP_LINKER_START,    /* The linker has relocated itself. */
+  ANDROID_STARTUP_LINKER_LOAD,     /* The linker starts loading the executable's libraries. */
+  ANDROID_STARTUP_LINKER_LINK,     /* The linker starts relocating the executable. */
+  ANDROID_STARTUP_LIBC_INIT,       /* libc starts initializing itself. */
+  ANDROID_STARTUP_LIBC_PROPERTIES, /* libc maps the system properties. */
+  ANDROID_STARTUP_LIBC_VDSO,       /* libc looks up the vDSO. */
+  ANDROID_STARTUP_CONSTRUCTORS,    /* libc is done; everyone else's constructors run. */
+  ANDROID_STARTUP_MAIN,            /* main is called. */
+  ANDROID_STARTUP_PHASE_COUNT
+};
+
+/*
+ * Copies the timestamps, in nanoseconds and indexed by phase, of the first
+ * 'count' phases to 'timestamps'. Returns ANDROID_STARTUP_PHASE_COUNT, or
+ * 0 if the process wasn't started with LIBC_STARTUP_TRACE set.
+ */
+extern size_t android_get_startup_trace(uint64_t* timestamps, size_t count);
+
+__END_DECLS
+
+#endif /* _ANDROID_STARTUP_TRACE_H */
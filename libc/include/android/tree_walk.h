@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_TREE_WALK_H
+#define _ANDROID_TREE_WALK_H
+
+#include <sys/cdefs.h>
+#include <sys/stat.h>
+
+__BEGIN_DECLS
+
+/*
+ * A parallel alternative to fts and nftw for walking big trees, such as
+ * backup and indexing jobs do. Each directory is read by a task on the
+ * <android/parallel.h> pool, so entries are visited concurrently and in no
+ * particular order. Entries are typed from the directory itself where the
+ * file system allows, so nothing is stat'd unless it's asked for. Symbolic
+ * links are never followed, except for the root.
+ */
+
+/* Flags for android_walk_tree. */
+#define ANDROID_WALK_STAT 0x1 /* Stat every entry, for android_walk_entry.st. */
+#define ANDROID_WALK_XDEV 0x2 /* Don't read directories on other file systems. */
+
+/* A callback's return value: don't read this directory. */
+#define ANDROID_WALK_SKIP 1
+
+struct android_walk_entry {
+  const char* path;     /* The root as given, then root/child/... */
+  const char* name;     /* The last component of 'path'. */
+  int depth;            /* 0 for the root. */
+  unsigned char type;   /* A DT_ value from <dirent.h>. */
+  int error;            /* An errno value if the entry couldn't be stat'd or, */
+                        /* for a directory, opened; otherwise 0. */
+  const struct stat* st; /* With ANDROID_WALK_STAT, unless 'error'; otherwise NULL. */
+};
+
+/*
+ * Calls fn(entry, cookie) for 'root' and everything under it, from several
+ * threads at once. A directory is visited before anything in it. The
+ * callback returns 0 to carry on, ANDROID_WALK_SKIP to carry on without
+ * reading the directory it was given, or anything else to stop the walk as
+ * soon as possible. Returns 0 once everything has been visited, the first
+ * value that stopped the walk, or -1 with errno set if 'root' can't be
+ * stat'd or the walk can't be started.
+ */
+extern int android_walk_tree(const char* root, int flags,
+                             int (*fn)(const struct android_walk_entry* entry, void* cookie),
+                             void* cookie);
+
+__END_DECLS
+
+#endif /* _ANDROID_TREE_WALK_H */
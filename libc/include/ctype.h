@@ -73,20 +73,60 @@ int	isxdigit(int);
 int	tolower(int);
 int	toupper(int);
 
-int isalnum_l(int, locale_t);
-int isalpha_l(int, locale_t);
-int isblank_l(int, locale_t);
-int iscntrl_l(int, locale_t);
-int isdigit_l(int, locale_t);
-int isgraph_l(int, locale_t);
-int islower_l(int, locale_t);
-int isprint_l(int, locale_t);
-int ispunct_l(int, locale_t);
-int isspace_l(int, locale_t);
-int isupper_l(int, locale_t);
-int isxdigit_l(int, locale_t);
-int tolower_l(int, locale_t);
-int toupper_l(int, locale_t);
+/*
+ * We only have the one locale, so the _l functions are inline: C++ streams
+ * call them for every character. ctype.cpp makes the out-of-line copies
+ * that existing binaries link against.
+ */
+#if !defined(__BIONIC_CTYPE_INLINE)
+#define __BIONIC_CTYPE_INLINE static __inline
+#endif
+
+#define __BIONIC_CTYPE_IS(c, mask) \
+    ((c) == -1 ? 0 : ((_ctype_ + 1)[(unsigned char)(c)] & (mask)))
+
+__BIONIC_CTYPE_INLINE int isalnum_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_U|_CTYPE_L|_CTYPE_D);
+}
+__BIONIC_CTYPE_INLINE int isalpha_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_U|_CTYPE_L);
+}
+__BIONIC_CTYPE_INLINE int isblank_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return (__c == ' ' || __c == '\t');
+}
+__BIONIC_CTYPE_INLINE int iscntrl_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_C);
+}
+__BIONIC_CTYPE_INLINE int isdigit_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_D);
+}
+__BIONIC_CTYPE_INLINE int isgraph_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_P|_CTYPE_U|_CTYPE_L|_CTYPE_D);
+}
+__BIONIC_CTYPE_INLINE int islower_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_L);
+}
+__BIONIC_CTYPE_INLINE int isprint_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_R);
+}
+__BIONIC_CTYPE_INLINE int ispunct_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_P);
+}
+__BIONIC_CTYPE_INLINE int isspace_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_S);
+}
+__BIONIC_CTYPE_INLINE int isupper_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_U);
+}
+__BIONIC_CTYPE_INLINE int isxdigit_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return __BIONIC_CTYPE_IS(__c, _CTYPE_D|_CTYPE_X);
+}
+__BIONIC_CTYPE_INLINE int tolower_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return tolower(__c);
+}
+__BIONIC_CTYPE_INLINE int toupper_l(int __c, locale_t __l __attribute__((__unused__))) {
+	return toupper(__c);
+}
 
 #if __BSD_VISIBLE || __ISO_C_VISIBLE >= 1999 || __POSIX_VISIBLE > 200112 \
     || __XPG_VISIBLE > 600
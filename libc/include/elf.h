@@ -94,10 +94,24 @@ typedef struct {
 #define DT_PREINIT_ARRAY 32
 #define DT_PREINIT_ARRAYSZ 33
 
+#define DT_GNU_HASH 0x6ffffef5
+
+/* Android compressed rel/rela sections */
+#define DT_ANDROID_REL (DT_LOOS + 2)
+#define DT_ANDROID_RELSZ (DT_LOOS + 3)
+
+#define DT_ANDROID_RELA (DT_LOOS + 4)
+#define DT_ANDROID_RELASZ (DT_LOOS + 5)
+
 #define ELFOSABI_SYSV 0 /* Synonym for ELFOSABI_NONE used by valgrind. */
 
 #define PT_GNU_RELRO 0x6474e552
 
+#define SHT_LOOS 0x60000000
+/* Android compressed rel/rela sections */
+#define SHT_ANDROID_REL (SHT_LOOS + 1)
+#define SHT_ANDROID_RELA (SHT_LOOS + 2)
+
 #define STB_LOOS      10
 #define STB_HIOS      12
 #define STB_LOPROC    13
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _EXECINFO_H
+#define _EXECINFO_H
+
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Stores up to 'size' return addresses from the calling thread's stack in
+ * 'buffer', innermost first, and returns how many it stored.
+ */
+extern int backtrace(void** buffer, int size);
+
+/*
+ * Describes each address as "library(symbol+0xoffset) [0xaddress]", or as
+ * "library(+0xoffset) [0xaddress]" with the offset from the library's load
+ * address when no exported symbol contains it. Returns a single block from
+ * malloc holding the array and the strings, for the caller to free, or NULL
+ * if out of memory.
+ */
+extern char** backtrace_symbols(void* const* buffer, int size);
+
+/*
+ * Like backtrace_symbols, but writes each description as a line to 'fd'
+ * without allocating any memory.
+ */
+extern void backtrace_symbols_fd(void* const* buffer, int size, int fd);
+
+__END_DECLS
+
+#endif /* _EXECINFO_H */
@@ -44,6 +44,11 @@ struct dl_phdr_info {
   const char* dlpi_name;
   const ElfW(Phdr)* dlpi_phdr;
   ElfW(Half) dlpi_phnum;
+  /* The number of libraries loaded and unloaded so far. Callers caching
+   * what dl_iterate_phdr reported can skip the walk while these don't change.
+   * Check the size argument of the callback before using them. */
+  unsigned long long dlpi_adds;
+  unsigned long long dlpi_subs;
 };
 
 int dl_iterate_phdr(int (*)(struct dl_phdr_info*, size_t, void*), void*);
@@ -24,6 +24,8 @@
  */
 #include <sys/cdefs.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 __BEGIN_DECLS
 
@@ -31,10 +33,25 @@ extern void* malloc(size_t byte_count) __mallocfunc __wur __attribute__((alloc_s
 extern void* calloc(size_t item_count, size_t item_size) __mallocfunc __wur __attribute__((alloc_size(1,2)));
 extern void* realloc(void* p, size_t byte_count) __wur __attribute__((alloc_size(2)));
 extern void free(void* p);
+/*
+ * Like free, for a block of exactly byte_count bytes as asked of malloc, calloc or realloc.
+ * Knowing the size saves the allocator looking it up.
+ */
+extern void free_sized(void* p, size_t byte_count);
 
 extern void* memalign(size_t alignment, size_t byte_count) __mallocfunc __wur __attribute__((alloc_size(2)));
 extern size_t malloc_usable_size(const void* p);
 
+/*
+ * Returns at least byte_count bytes of memory, aligned to 2 MiB and advised
+ * with MADV_HUGEPAGE so that the kernel can back it with huge pages. The memory
+ * must be freed with android_free_huge, not free. Freed regions are kept for
+ * reuse, up to a limit, until malloc_trim is called, so the memory returned
+ * isn't necessarily zeroed.
+ */
+extern void* android_malloc_huge(size_t byte_count) __mallocfunc __wur __attribute__((alloc_size(1)));
+extern void android_free_huge(void* p);
+
 #ifndef STRUCT_MALLINFO_DECLARED
 #define STRUCT_MALLINFO_DECLARED 1
 struct mallinfo {
@@ -53,6 +70,69 @@ struct mallinfo {
 
 extern struct mallinfo mallinfo(void);
 
+/*
+ * Allocator tuning parameters for mallopt. Not every allocator supports
+ * every parameter; mallopt returns 1 if the parameter was applied and 0
+ * otherwise.
+ */
+/* dlmalloc: trim the top of the heap once this many bytes (-1 for never) are free. */
+#define M_TRIM_THRESHOLD (-1)
+/* dlmalloc: the unit in which the heap grows, a power of two >= the page size. */
+#define M_GRANULARITY (-2)
+/* dlmalloc: allocations of at least this many bytes are mmapped directly. */
+#define M_MMAP_THRESHOLD (-3)
+/* The maximum number of arenas. jemalloc fixes its arena count at startup; dlmalloc has one. */
+#define M_ARENA_MAX (-8)
+/* Equivalent to malloc_trim(0). The value is ignored. */
+#define M_PURGE (-101)
+/*
+ * Whether small allocations are served from per-thread caches (1) or not (0).
+ * dlmalloc applies this to every thread, jemalloc to the calling thread.
+ */
+#define M_THREAD_CACHE (-102)
+/*
+ * Whether children forked after this call start out on a heap of their own (1)
+ * or not (0). Memory allocated before the fork is still usable in the child,
+ * but freeing it there doesn't write to its pages: the child leaks it rather
+ * than dirtying the pages it shares with its parent.
+ */
+#define M_SEGREGATE_ON_FORK (-103)
+
+extern int mallopt(int param, int value);
+
+/*
+ * Gives freed memory back to the kernel now: the top of the heap beyond pad
+ * bytes, and the whole pages inside free blocks elsewhere in the heap.
+ * Returns 1 if any memory was released, 0 otherwise.
+ */
+extern int malloc_trim(size_t pad);
+
+/*
+ * Writes a human-readable, allocator-specific report of the heap (totals,
+ * and counts and bytes by size class or by arena and bin) to fp. options
+ * must be 0. Returns 0 on success, -1 with errno set otherwise.
+ */
+extern int malloc_info(int options, FILE* fp);
+
+/*
+ * Stop and restart all allocation in the process, so that the heap can be
+ * walked with malloc_iterate. No thread may allocate (including the calling
+ * thread) between the two calls.
+ */
+extern void malloc_disable(void);
+extern void malloc_enable(void);
+
+/*
+ * Calls callback with the address and usable size of every allocation that
+ * starts in [base, base + size). Must be called between malloc_disable and
+ * malloc_enable, and callback must not allocate. Blocks the allocator is
+ * holding in per-thread caches count as allocations, and allocations made
+ * directly with mmap may not be reported. Returns 0 on success, or -1 with
+ * errno set to ENOTSUP if the allocator can't be walked.
+ */
+extern int malloc_iterate(uintptr_t base, size_t size,
+                          void (*callback)(uintptr_t base, size_t size, void* arg), void* arg);
+
 __END_DECLS
 
 #endif  /* LIBC_INCLUDE_MALLOC_H_ */
@@ -30,6 +30,7 @@
 
 #include <stdio.h>
 #include <sys/cdefs.h>
+#include <sys/types.h>
 #include <paths.h>  /* for _PATH_MOUNTED */
 
 #define MOUNTED _PATH_MOUNTED
@@ -51,6 +52,39 @@ struct mntent* getmntent(FILE*);
 struct mntent* getmntent_r(FILE*, struct mntent*, char*, int);
 FILE* setmntent(const char*, const char*);
 
+/*
+ * A mount, as described by a line of /proc/self/mountinfo. The strings have had the
+ * kernel's escaping of spaces and the like undone.
+ */
+struct android_mountinfo {
+  int mount_id;
+  int parent_id;
+  dev_t dev;
+  const char* root;          /* The directory within the file system that is mounted. */
+  const char* mount_point;
+  const char* mount_options; /* Per-mount options, such as "rw,noatime". */
+  const char* fs_type;
+  const char* source;
+  const char* super_options; /* Per-file-system options. */
+};
+
+/*
+ * Calls callback for each mount in /proc/self/mountinfo, which is read in large
+ * chunks and parsed in place, so it's much cheaper than getmntent for big mount
+ * tables. The strings are only valid during the call. Stops early if callback
+ * returns non-zero and returns that value. Returns 0 after the last mount, or -1
+ * with errno set if the table can't be read.
+ */
+int android_mountinfo_iterate(int (*callback)(const struct android_mountinfo*, void*), void* arg);
+
+/*
+ * Reports whether the mount table has changed, given fd open for reading on
+ * /proc/self/mounts or /proc/self/mountinfo, waiting up to timeout_ms (-1 for
+ * ever) for it to. Each change is reported once, so a monitor only needs to
+ * rescan when this returns 1. Returns 0 on timeout, -1 with errno set on error.
+ */
+int android_mounts_changed(int fd, int timeout_ms);
+
 __END_DECLS
 
 #endif
@@ -51,15 +51,19 @@ typedef struct {
 #define  __PTHREAD_MUTEX_INIT_VALUE            0
 #define  __PTHREAD_RECURSIVE_MUTEX_INIT_VALUE  0x4000
 #define  __PTHREAD_ERRORCHECK_MUTEX_INIT_VALUE 0x8000
+#define  __PTHREAD_ADAPTIVE_MUTEX_INIT_VALUE   0xc000
 
 #define  PTHREAD_MUTEX_INITIALIZER             {__PTHREAD_MUTEX_INIT_VALUE __RESERVED_INITIALIZER}
 #define  PTHREAD_RECURSIVE_MUTEX_INITIALIZER   {__PTHREAD_RECURSIVE_MUTEX_INIT_VALUE __RESERVED_INITIALIZER}
 #define  PTHREAD_ERRORCHECK_MUTEX_INITIALIZER  {__PTHREAD_ERRORCHECK_MUTEX_INIT_VALUE __RESERVED_INITIALIZER}
+#define  PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP {__PTHREAD_ADAPTIVE_MUTEX_INIT_VALUE __RESERVED_INITIALIZER}
 
 enum {
     PTHREAD_MUTEX_NORMAL = 0,
     PTHREAD_MUTEX_RECURSIVE = 1,
     PTHREAD_MUTEX_ERRORCHECK = 2,
+    /* A normal mutex that spins for a while before sleeping when contended. */
+    PTHREAD_MUTEX_ADAPTIVE_NP = 3,
 
     PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
     PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
@@ -67,6 +71,20 @@ enum {
     PTHREAD_MUTEX_DEFAULT = PTHREAD_MUTEX_NORMAL
 };
 
+enum {
+    PTHREAD_PRIO_NONE = 0,
+    PTHREAD_PRIO_INHERIT = 1,
+    PTHREAD_PRIO_PROTECT = 2
+};
+
+enum {
+    PTHREAD_MUTEX_STALLED = 0,
+    PTHREAD_MUTEX_ROBUST = 1,
+
+    PTHREAD_MUTEX_STALLED_NP = PTHREAD_MUTEX_STALLED,
+    PTHREAD_MUTEX_ROBUST_NP = PTHREAD_MUTEX_ROBUST
+};
+
 typedef struct {
   int volatile value;
 #ifdef __LP64__
@@ -98,25 +116,49 @@ typedef struct {
   pthread_mutex_t __unused_lock;
   pthread_cond_t __unused_cond;
 #endif
-  volatile int32_t state; // 0=unlock, -1=writer lock, +n=reader lock
+  volatile int32_t state; // writer bit, waiter bits and reader count
   volatile int32_t writer_thread_id;
   volatile int32_t pending_readers;
   volatile int32_t pending_writers;
   int32_t attr;
+  volatile int32_t reader_wakeup_serial;
+  volatile int32_t writer_wakeup_serial;
 #ifdef __LP64__
-  char __reserved[36];
+  char __reserved[28];
 #else
-  char __reserved[12];
+  char __reserved[4];
 #endif
 
 } pthread_rwlock_t;
 
 #ifdef __LP64__
-  #define PTHREAD_RWLOCK_INITIALIZER  { 0, 0, 0, 0, 0, { 0 } }
+  #define PTHREAD_RWLOCK_INITIALIZER  { 0, 0, 0, 0, 0, 0, 0, { 0 } }
 #else
-  #define PTHREAD_RWLOCK_INITIALIZER  { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, { 0 } }
+  #define PTHREAD_RWLOCK_INITIALIZER  { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, 0, 0, 0, { 0 } }
 #endif
 
+enum {
+  PTHREAD_RWLOCK_PREFER_READER_NP = 0,
+  PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP = 1
+};
+
+typedef int pthread_barrierattr_t;
+
+typedef struct {
+  volatile int32_t generation; // futex word, bumped when the barrier releases its waiters
+  volatile int32_t arrived;
+  volatile int32_t leaving;
+  int32_t count;
+  int32_t attr;
+#ifdef __LP64__
+  char __reserved[12];
+#endif
+} pthread_barrier_t;
+
+#define PTHREAD_BARRIER_SERIAL_THREAD (-1)
+
+typedef volatile int pthread_spinlock_t;
+
 typedef int pthread_key_t;
 typedef long pthread_t;
 
@@ -160,6 +202,15 @@ int pthread_attr_setscope(pthread_attr_t*, int) __nonnull((1));
 int pthread_attr_setstack(pthread_attr_t*, void*, size_t) __nonnull((1));
 int pthread_attr_setstacksize(pthread_attr_t*, size_t stack_size) __nonnull((1));
 
+int pthread_barrierattr_destroy(pthread_barrierattr_t*) __nonnull((1));
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t*, int*) __nonnull((1, 2));
+int pthread_barrierattr_init(pthread_barrierattr_t*) __nonnull((1));
+int pthread_barrierattr_setpshared(pthread_barrierattr_t*, int) __nonnull((1));
+
+int pthread_barrier_destroy(pthread_barrier_t*) __nonnull((1));
+int pthread_barrier_init(pthread_barrier_t*, const pthread_barrierattr_t*, unsigned) __nonnull((1));
+int pthread_barrier_wait(pthread_barrier_t*) __nonnull((1));
+
 int pthread_condattr_destroy(pthread_condattr_t*) __nonnull((1));
 int pthread_condattr_getclock(const pthread_condattr_t*, clockid_t*) __nonnull((1, 2));
 int pthread_condattr_getpshared(const pthread_condattr_t*, int*) __nonnull((1, 2));
@@ -190,6 +241,14 @@ void* pthread_getspecific(pthread_key_t);
 
 pid_t pthread_gettid_np(pthread_t);
 
+/*
+ * Reports how deep the given thread's stack has ever grown (the distance from the top
+ * of the stack to the lowest page that's resident) and the stack's size, for tuning
+ * pthread_attr_setstacksize. Stacks are reused from exited threads with the same size,
+ * so a new thread may inherit its predecessor's high-water mark. Returns 0 or an errno.
+ */
+int android_pthread_get_stack_usage(pthread_t, size_t* used, size_t* size) __nonnull((2, 3));
+
 int pthread_join(pthread_t, void**);
 
 int pthread_key_create(pthread_key_t*, void (*)(void*)) __nonnull((1));
@@ -198,12 +257,17 @@ int pthread_key_delete(pthread_key_t);
 int pthread_kill(pthread_t, int);
 
 int pthread_mutexattr_destroy(pthread_mutexattr_t*) __nonnull((1));
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t*, int*) __nonnull((1, 2));
 int pthread_mutexattr_getpshared(const pthread_mutexattr_t*, int*) __nonnull((1, 2));
+int pthread_mutexattr_getrobust(const pthread_mutexattr_t*, int*) __nonnull((1, 2));
 int pthread_mutexattr_gettype(const pthread_mutexattr_t*, int*) __nonnull((1, 2));
 int pthread_mutexattr_init(pthread_mutexattr_t*) __nonnull((1));
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t*, int) __nonnull((1));
 int pthread_mutexattr_setpshared(pthread_mutexattr_t*, int) __nonnull((1));
+int pthread_mutexattr_setrobust(pthread_mutexattr_t*, int) __nonnull((1));
 int pthread_mutexattr_settype(pthread_mutexattr_t*, int) __nonnull((1));
 
+int pthread_mutex_consistent(pthread_mutex_t*) __nonnull((1));
 int pthread_mutex_destroy(pthread_mutex_t*) __nonnull((1));
 int pthread_mutex_init(pthread_mutex_t*, const pthread_mutexattr_t*) __nonnull((1));
 int pthread_mutex_lock(pthread_mutex_t*) /* __nonnull((1)) */;
@@ -214,8 +278,10 @@ int pthread_mutex_unlock(pthread_mutex_t*) /* __nonnull((1)) */;
 int pthread_once(pthread_once_t*, void (*)(void)) __nonnull((1, 2));
 
 int pthread_rwlockattr_destroy(pthread_rwlockattr_t*) __nonnull((1));
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t*, int*) __nonnull((1, 2));
 int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t*, int*) __nonnull((1, 2));
 int pthread_rwlockattr_init(pthread_rwlockattr_t*) __nonnull((1));
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t*, int) __nonnull((1));
 int pthread_rwlockattr_setpshared(pthread_rwlockattr_t*, int) __nonnull((1));
 
 int pthread_rwlock_destroy(pthread_rwlock_t*) __nonnull((1));
@@ -237,6 +303,13 @@ int pthread_setschedparam(pthread_t, int, const struct sched_param*) __nonnull((
 int pthread_setspecific(pthread_key_t, const void*);
 
 int pthread_sigmask(int, const sigset_t*, sigset_t*);
+int pthread_sigqueue(pthread_t, int, const union sigval);
+
+int pthread_spin_destroy(pthread_spinlock_t*) __nonnull((1));
+int pthread_spin_init(pthread_spinlock_t*, int) __nonnull((1));
+int pthread_spin_lock(pthread_spinlock_t*) __nonnull((1));
+int pthread_spin_trylock(pthread_spinlock_t*) __nonnull((1));
+int pthread_spin_unlock(pthread_spinlock_t*) __nonnull((1));
 
 typedef void (*__pthread_cleanup_func_t)(void*);
 
@@ -146,6 +146,26 @@ extern void       __sched_cpufree(cpu_set_t* set);
 
 extern int __sched_cpucount(size_t setsize, cpu_set_t* set);
 
+/* CPU topology (a bionic extension). The online CPUs are grouped into clusters
+ * of CPUs that share a physical package and have the same capacity, such as the
+ * "big" and "LITTLE" clusters of a heterogeneous ARM system. The topology is
+ * read from sysfs once and then cached until a CPU is hotplugged.
+ */
+typedef struct {
+  cpu_set_t cpus;             /* The cluster's online CPUs. */
+  unsigned int capacity;      /* Relative to other clusters, 0 if unknown. */
+  unsigned int cache_level;   /* Level of the last cache shared by the cluster, 0 if none. */
+  size_t cache_size;          /* Size in bytes of that cache. */
+} sched_cpu_cluster_t;
+
+/* Copies up to 'count' clusters, least capable first, into 'clusters' and
+ * returns the total number of clusters. Returns -1 and sets errno on failure.
+ */
+extern int sched_getclusters_np(sched_cpu_cluster_t* clusters, size_t count);
+
+/* Restricts the calling thread to the CPUs of the given cluster. */
+extern int sched_setcluster_np(size_t cluster);
+
 #endif /* _GNU_SOURCE */
 
 __END_DECLS
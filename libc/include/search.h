@@ -19,16 +19,39 @@ typedef enum {
   leaf
 } VISIT;
 
+typedef enum {
+  FIND,
+  ENTER
+} ACTION;
+
+typedef struct entry {
+  char* key;
+  void* data;
+} ENTRY;
+
+struct hsearch_data {
+  struct __hsearch* __hsearch;
+};
+
 #ifdef _SEARCH_PRIVATE
 typedef struct node {
   char* key;
   struct node* llink;
   struct node* rlink;
+  int height;
 } node_t;
 #endif
 
 __BEGIN_DECLS
 
+int hcreate(size_t);
+void hdestroy(void);
+ENTRY* hsearch(ENTRY, ACTION);
+
+int hcreate_r(size_t, struct hsearch_data*);
+void hdestroy_r(struct hsearch_data*);
+int hsearch_r(ENTRY, ACTION, ENTRY**, struct hsearch_data*);
+
 void insque(void*, void*);
 void remque(void*);
 
@@ -56,6 +56,9 @@ extern int    sem_wait(sem_t *);
 struct timespec;
 extern int    sem_timedwait(sem_t *sem, const struct timespec *abs_timeout);
 
+/* Like sem_timedwait, but abs_timeout is measured against CLOCK_MONOTONIC. */
+extern int    sem_timedwait_monotonic_np(sem_t *sem, const struct timespec *abs_timeout);
+
 __END_DECLS
 
 #endif /* _SEMAPHORE_H */
@@ -326,6 +326,11 @@ int	 putchar_unlocked(int);
 
 #endif /* __BSD_VISIBLE || __POSIX_VISIBLE || __XPG_VISIBLE */
 
+#if __POSIX_VISIBLE >= 200809
+FILE	*fmemopen(void * __restrict, size_t, const char * __restrict);
+FILE	*open_memstream(char **, size_t *);
+#endif /* __POSIX_VISIBLE >= 200809 */
+
 /*
  * Routines that are purely local.
  */
@@ -351,6 +356,16 @@ FILE	*funopen(const void *,
 
 #define	fropen(cookie, fn) funopen(cookie, fn, 0, 0, 0)
 #define	fwopen(cookie, fn) funopen(cookie, 0, fn, 0, 0)
+
+/*
+ * glibc-compatible variants that don't take the stream's lock; the caller
+ * must hold it (via flockfile) or otherwise own the stream.
+ */
+int	 fflush_unlocked(FILE *);
+char	*fgets_unlocked(char * __restrict, int, FILE * __restrict);
+int	 fputc_unlocked(int, FILE *);
+size_t	 fread_unlocked(void * __restrict, size_t, size_t, FILE * __restrict);
+size_t	 fwrite_unlocked(const void * __restrict, size_t, size_t, FILE * __restrict);
 #endif /* __BSD_VISIBLE */
 
 extern char* __fgets_chk(char*, int, FILE*, size_t);
@@ -416,14 +431,10 @@ char *fgets(char* dest, int size, FILE* stream) {
         __fgets_too_small_error();
     }
 
-    // Compiler doesn't know destination size. Don't call __fgets_chk
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
-        return __fgets_real(dest, size, stream);
-    }
-
-    // Compiler can prove, at compile time, that the passed in size
-    // is always <= the actual object size. Don't call __fgets_chk
-    if (__builtin_constant_p(size) && (size <= (int) bos)) {
+    // Compiler doesn't know destination size, or can prove, at compile
+    // time, that the passed in size is always <= the actual object size.
+    // Don't call __fgets_chk
+    if (__bos_trivially_ge(bos, (size_t) size)) {
         return __fgets_real(dest, size, stream);
     }
 
@@ -68,6 +68,7 @@ extern unsigned long strtoul(const char *, char **, int);
 extern unsigned long long strtoull(const char *, char **, int);
 
 extern int posix_memalign(void **memptr, size_t alignment, size_t size);
+extern void* aligned_alloc(size_t alignment, size_t size) __mallocfunc __wur __attribute__((alloc_size(2)));
 
 extern double atof(const char*);
 
@@ -95,6 +96,9 @@ extern void * bsearch(const void *key, const void *base0,
 	int (*compar)(const void *, const void *));
 
 extern void qsort(void *, size_t, size_t, int (*)(const void *, const void *));
+#ifdef _GNU_SOURCE
+extern void qsort_r(void*, size_t, size_t, int (*)(const void*, const void*, void*), void*);
+#endif
 
 extern long jrand48(unsigned short *);
 extern long mrand48(void);
@@ -99,16 +99,129 @@ extern size_t __strlcpy_chk(char *, const char *, size_t, size_t);
 extern size_t __strlcat_real(char* __restrict, const char* __restrict, size_t) __RENAME(strlcat);
 extern size_t __strlcat_chk(char* __restrict, const char* __restrict, size_t, size_t);
 
+#if defined(__BIONIC_INLINE_SMALL_MEMOPS)
+
+/*
+ * Copies or fills of n <= __BIONIC_INLINE_SMALL_MEMOPS_MAX bytes. Each size class is
+ * covered by two fixed-size accesses, one at each end, overlapping in the middle; the
+ * compiler turns the fixed-size __builtin_memcpy calls into plain unaligned moves.
+ */
+extern __inline__ __always_inline __attribute__((gnu_inline))
+void __bionic_memcpy_small(void* __restrict dest, const void* __restrict src, size_t n) {
+    char* d = (char*) dest;
+    const char* s = (const char*) src;
+    if (n >= 16) {
+        if (n >= 32) {
+            __builtin_memcpy(d, s, 32);
+            __builtin_memcpy(d + n - 32, s + n - 32, 32);
+        } else {
+            __builtin_memcpy(d, s, 16);
+            __builtin_memcpy(d + n - 16, s + n - 16, 16);
+        }
+    } else if (n >= 8) {
+        __builtin_memcpy(d, s, 8);
+        __builtin_memcpy(d + n - 8, s + n - 8, 8);
+    } else if (n >= 4) {
+        __builtin_memcpy(d, s, 4);
+        __builtin_memcpy(d + n - 4, s + n - 4, 4);
+    } else if (n > 0) {
+        d[0] = s[0];
+        d[n / 2] = s[n / 2];
+        d[n - 1] = s[n - 1];
+    }
+}
+
+extern __inline__ __always_inline __attribute__((gnu_inline))
+void __bionic_memset_small(void* dest, int c, size_t n) {
+    char* d = (char*) dest;
+    unsigned long long v = (unsigned char) c * 0x0101010101010101ULL;
+    unsigned long long pattern[4] = { v, v, v, v };
+    if (n >= 16) {
+        if (n >= 32) {
+            __builtin_memcpy(d, pattern, 32);
+            __builtin_memcpy(d + n - 32, pattern, 32);
+        } else {
+            __builtin_memcpy(d, pattern, 16);
+            __builtin_memcpy(d + n - 16, pattern, 16);
+        }
+    } else if (n >= 8) {
+        __builtin_memcpy(d, pattern, 8);
+        __builtin_memcpy(d + n - 8, pattern, 8);
+    } else if (n >= 4) {
+        __builtin_memcpy(d, pattern, 4);
+        __builtin_memcpy(d + n - 4, pattern, 4);
+    } else if (n > 0) {
+        d[0] = (char) c;
+        d[n / 2] = (char) c;
+        d[n - 1] = (char) c;
+    }
+}
+
+/* Sizes known at compile time are left to the compiler, which expands them itself. */
+#define __bionic_inline_memop_size(n) \
+    (!__builtin_constant_p(n) && (n) <= __BIONIC_INLINE_SMALL_MEMOPS_MAX)
+
+#if !defined(__BIONIC_FORTIFY)
+
+extern __inline__ __always_inline __attribute__((gnu_inline))
+void* memcpy(void* __restrict dest, const void* __restrict src, size_t copy_amount) {
+    if (__bionic_inline_memop_size(copy_amount)) {
+        __bionic_memcpy_small(dest, src, copy_amount);
+        return dest;
+    }
+    return __builtin_memcpy(dest, src, copy_amount);
+}
+
+extern __inline__ __always_inline __attribute__((gnu_inline))
+void* memset(void *s, int c, size_t n) {
+    if (__bionic_inline_memop_size(n)) {
+        __bionic_memset_small(s, c, n);
+        return s;
+    }
+    return __builtin_memset(s, c, n);
+}
+
+#endif /* !defined(__BIONIC_FORTIFY) */
+
+#endif /* defined(__BIONIC_INLINE_SMALL_MEMOPS) */
+
 #if defined(__BIONIC_FORTIFY)
 
 __BIONIC_FORTIFY_INLINE
 void* memcpy(void* __restrict dest, const void* __restrict src, size_t copy_amount) {
-    return __builtin___memcpy_chk(dest, src, copy_amount, __bos0(dest));
+    size_t bos = __bos0(dest);
+
+#if defined(__BIONIC_INLINE_SMALL_MEMOPS)
+    if (__bionic_inline_memop_size(copy_amount) && copy_amount <= bos) {
+        __bionic_memcpy_small(dest, src, copy_amount);
+        return dest;
+    }
+#endif /* defined(__BIONIC_INLINE_SMALL_MEMOPS) */
+
+#if !defined(__clang__)
+    // Compiler can prove, at compile time, that the copy fits
+    // in the destination. Don't call __memcpy_chk
+    if (__bos_trivially_ge(bos, copy_amount)) {
+        return __builtin_memcpy(dest, src, copy_amount);
+    }
+#endif /* !defined(__clang__) */
+
+    return __builtin___memcpy_chk(dest, src, copy_amount, bos);
 }
 
 __BIONIC_FORTIFY_INLINE
 void* memmove(void *dest, const void *src, size_t len) {
-    return __builtin___memmove_chk(dest, src, len, __bos0(dest));
+    size_t bos = __bos0(dest);
+
+#if !defined(__clang__)
+    // Compiler can prove, at compile time, that the copy fits
+    // in the destination. Don't call __memmove_chk
+    if (__bos_trivially_ge(bos, len)) {
+        return __builtin_memmove(dest, src, len);
+    }
+#endif /* !defined(__clang__) */
+
+    return __builtin___memmove_chk(dest, src, len, bos);
 }
 
 __BIONIC_FORTIFY_INLINE
@@ -175,7 +288,24 @@ char *strncat(char* __restrict dest, const char* __restrict src, size_t n) {
 
 __BIONIC_FORTIFY_INLINE
 void* memset(void *s, int c, size_t n) {
-    return __builtin___memset_chk(s, c, n, __bos0(s));
+    size_t bos = __bos0(s);
+
+#if defined(__BIONIC_INLINE_SMALL_MEMOPS)
+    if (__bionic_inline_memop_size(n) && n <= bos) {
+        __bionic_memset_small(s, c, n);
+        return s;
+    }
+#endif /* defined(__BIONIC_INLINE_SMALL_MEMOPS) */
+
+#if !defined(__clang__)
+    // Compiler can prove, at compile time, that the write fits
+    // in the destination. Don't call __memset_chk
+    if (__bos_trivially_ge(bos, n)) {
+        return __builtin_memset(s, c, n);
+    }
+#endif /* !defined(__clang__) */
+
+    return __builtin___memset_chk(s, c, n, bos);
 }
 
 __BIONIC_FORTIFY_INLINE
@@ -183,14 +313,10 @@ size_t strlcpy(char* __restrict dest, const char* __restrict src, size_t size) {
     size_t bos = __bos(dest);
 
 #if !defined(__clang__)
-    // Compiler doesn't know destination size. Don't call __strlcpy_chk
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
-        return __strlcpy_real(dest, src, size);
-    }
-
-    // Compiler can prove, at compile time, that the passed in size
-    // is always <= the actual object size. Don't call __strlcpy_chk
-    if (__builtin_constant_p(size) && (size <= bos)) {
+    // Compiler doesn't know destination size, or can prove, at compile
+    // time, that the passed in size is always <= the actual object size.
+    // Don't call __strlcpy_chk
+    if (__bos_trivially_ge(bos, size)) {
         return __strlcpy_real(dest, src, size);
     }
 #endif /* !defined(__clang__) */
@@ -204,14 +330,10 @@ size_t strlcat(char* __restrict dest, const char* __restrict src, size_t size) {
     size_t bos = __bos(dest);
 
 #if !defined(__clang__)
-    // Compiler doesn't know destination size. Don't call __strlcat_chk
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
-        return __strlcat_real(dest, src, size);
-    }
-
-    // Compiler can prove, at compile time, that the passed in size
-    // is always <= the actual object size. Don't call __strlcat_chk
-    if (__builtin_constant_p(size) && (size <= bos)) {
+    // Compiler doesn't know destination size, or can prove, at compile
+    // time, that the passed in size is always <= the actual object size.
+    // Don't call __strlcat_chk
+    if (__bos_trivially_ge(bos, size)) {
         return __strlcat_real(dest, src, size);
     }
 #endif /* !defined(__clang__) */
@@ -58,6 +58,25 @@ struct prop_msg
 };
 
 #define PROP_MSG_SETPROP 1
+#define PROP_MSG_SETPROP_BATCH 2
+
+/*
+** A batch of sets is a prop_msg_batch followed by 'count' prop_msgs
+** with cmd PROP_MSG_SETPROP, at most PROP_MSG_BATCH_MAX of them.  The
+** header is the size of a prop_msg, so a property service that doesn't
+** know about batches reads it as a message with an unknown command and
+** hangs up.  One that does applies the sets in order, replies with the
+** number it applied as an unsigned, and waits on the same connection
+** for another batch until the client closes it.
+*/
+struct prop_msg_batch
+{
+    unsigned cmd;
+    unsigned count;
+    char reserved[PROP_NAME_MAX + PROP_VALUE_MAX - sizeof(unsigned)];
+};
+
+#define PROP_MSG_BATCH_MAX 256
     
 /*
 ** Rules:
@@ -102,6 +121,20 @@ int __system_property_set_filename(const char *filename);
 */
 int __system_property_area_init();
 
+/* Give the system properties whose names start with prefix an
+** area of their own, in a file named after the main area's with
+** the partition's number appended.  Readers only map a partition's
+** area once they look for a property in it, and each area has room
+** for PA_SIZE bytes of properties.  A property belongs to the
+** partition with the longest matching prefix, or to the main area
+** if there's none.  Can only be done by the process that
+** initialized the property area, before any property under the
+** prefix is added.
+**
+** Returns 0 on success, -1 on error.
+*/
+int __system_property_add_partition(const char *prefix);
+
 /* Add a new system property.  Can only be done by a single
 ** process that has write access to the property area, and
 ** that process must handle sequencing to ensure the property
@@ -135,6 +168,25 @@ unsigned int __system_property_serial(const prop_info *pi);
 ** successive call. */
 unsigned int __system_property_wait_any(unsigned int serial);
 
+/* Wait for one system property to be updated: until its serial, as
+** returned by __system_property_serial, differs from 'old_serial'.
+** Unlike __system_property_wait_any, updates to other properties
+** don't wake the caller.
+**
+** Returns the new serial number.
+*/
+unsigned int __system_property_wait(const prop_info *pi, unsigned int old_serial);
+
+/* Like __system_property_wait, but gives up once 'relative_timeout'
+** has passed.  A NULL 'relative_timeout' waits forever.
+**
+** Returns 0 and the new serial number in '*new_serial' on success,
+** -1 if the property wasn't updated in time.
+*/
+struct timespec;
+int __system_property_wait_timeout(const prop_info *pi, unsigned int old_serial,
+        const struct timespec *relative_timeout, unsigned int *new_serial);
+
 /*  Compatibility functions to support using an old init with a new libc,
  ** mostly for the OTA updater binary.  These can be deleted once OTAs from
  ** a pre-K release no longer needed to be supported. */
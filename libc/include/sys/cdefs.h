@@ -522,6 +522,29 @@
 #endif
 #define __BIONIC_FORTIFY_UNKNOWN_SIZE ((size_t) -1)
 
+/*
+ * When _BIONIC_INLINE_SMALL_MEMOPS is defined, memcpy and memset calls whose
+ * size isn't known at compile time do copies and fills of up to 64 bytes
+ * inline, with a few overlapping loads and stores, and only call out of line
+ * for bigger ones. That suits code dominated by short variable-length copies,
+ * at some cost in code size.
+ */
+#if defined(_BIONIC_INLINE_SMALL_MEMOPS) && defined(__OPTIMIZE__) && __OPTIMIZE__ > 0
+#define __BIONIC_INLINE_SMALL_MEMOPS 1
+#define __BIONIC_INLINE_SMALL_MEMOPS_MAX 64
+#endif
+
+/*
+ * True if the compiler can prove that 'n' bytes fit in an object 'bos' bytes
+ * long, so the fortified call needn't check at run time: either the object's
+ * size isn't known, or the comparison folds to true. Asking
+ * __builtin_constant_p about the comparison rather than about 'n' alone
+ * means a length that isn't a constant but is known to be small enough (one
+ * that was range-checked before the call, say) is discharged too.
+ */
+#define __bos_trivially_ge(bos, n) \
+  ((bos) == __BIONIC_FORTIFY_UNKNOWN_SIZE || (__builtin_constant_p((bos) >= (n)) && (bos) >= (n)))
+
 /* Used to tag non-static symbols that are private and never exposed by the shared library. */
 #define __LIBC_HIDDEN__ __attribute__((visibility("hidden")))
 
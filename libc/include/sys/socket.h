@@ -302,11 +302,7 @@ ssize_t recvfrom(int fd, void* buf, size_t len, int flags, const struct sockaddr
   size_t bos = __bos0(buf);
 
 #if !defined(__clang__)
-  if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
-    return __recvfrom_real(fd, buf, len, flags, src_addr, addr_len);
-  }
-
-  if (__builtin_constant_p(len) && (len <= bos)) {
+  if (__bos_trivially_ge(bos, len)) {
     return __recvfrom_real(fd, buf, len, flags, src_addr, addr_len);
   }
 
@@ -30,6 +30,7 @@
 #define _INCLUDE_SYS_SYSTEM_PROPERTIES_H
 
 #include <sys/cdefs.h>
+#include <stddef.h>
 
 __BEGIN_DECLS
 
@@ -50,6 +51,32 @@ int __system_property_get(const char *name, char *value);
 **/
 int __system_property_set(const char *key, const char *value);
 
+/* Set count system properties, in order, with one request to the
+** property service rather than one each.  A NULL value is set as "".
+** Returns 0 on success, or -1 if a key or value is too long (in which
+** case nothing is set) or the property service couldn't be reached.
+*/
+int __system_property_set_batch(const char * const *keys,
+        const char * const *values, size_t count);
+
+/* A connection to the property service that stays open between
+** batches, for callers that set properties in many of them.  A
+** connection must not be used by more than one thread at a time.
+*/
+typedef struct prop_connection prop_connection;
+
+/* Return a new connection, or NULL if there's no memory for one.  It
+** connects on first use.
+*/
+prop_connection *__system_property_connect(void);
+
+/* As __system_property_set_batch, over a connection. */
+int __system_property_connection_set_batch(prop_connection *conn,
+        const char * const *keys, const char * const *values, size_t count);
+
+/* Close a connection and free it. */
+void __system_property_disconnect(prop_connection *conn);
+
 /* Return a pointer to the system property named name, if it
 ** exists, or NULL if there is no such property.  Use 
 ** __system_property_read() to obtain the string value from
@@ -72,6 +99,33 @@ const prop_info *__system_property_find(const char *name);
 */
 int __system_property_read(const prop_info *pi, char *name, char *value);
 
+/* A handle on a system property for callers that read it often.
+** The first read through a handle finds the property; later reads
+** go straight to it, and copy its value only if it has changed
+** since the caller last read it.  Handles can be shared between
+** threads: each reader keeps its own value and serial.
+**
+**     static prop_handle debuggable = PROP_HANDLE_INIT("ro.debuggable");
+*/
+typedef struct {
+    const char *name;
+    const prop_info * volatile pi;
+} prop_handle;
+
+#define PROP_HANDLE_INIT(name) { (name), 0 }
+
+/* Read a system property through a handle.  If the property's
+** serial differs from *serial, copies its value and \0 terminator
+** into the provided value pointer, stores the new serial in
+** *serial, and returns 1.  Returns 0, leaving value alone, if the
+** value hasn't changed.  Start with *serial set to 0 and value
+** set to "".
+**
+** Returns -1 if the property doesn't exist, after setting value
+** to "" and *serial to 0.
+*/
+int __system_property_read_handle(prop_handle *handle, char *value, unsigned *serial);
+
 /* Return a prop_info for the nth system property, or NULL if 
 ** there is no nth property.  Use __system_property_read() to
 ** read the value of this property.
@@ -97,6 +151,27 @@ int __system_property_foreach(
         void (*propfn)(const prop_info *pi, void *cookie),
         void *cookie);
 
+/* Like __system_property_foreach, but only for the properties
+** whose names start with prefix, such as "ro." or "persist.sys".
+** Parts of the property tree that can't match aren't visited.
+*/
+int __system_property_foreach_prefix(const char *prefix,
+        void (*propfn)(const prop_info *pi, void *cookie),
+        void *cookie);
+
+/* Copy every system property whose name starts with prefix ("" for
+** all of them) into buf, as consecutive "name\0value\0" pairs.  The
+** copy is consistent: no property changes while it's being taken,
+** so it's as if all the properties were read at once.  If needed
+** is nonzero, the number of bytes used is stored there.
+**
+** Returns the number of properties copied, or -1 if they don't fit
+** in size bytes, in which case *needed is the size they would have
+** needed at the time.
+*/
+int __system_property_snapshot(const char *prefix, char *buf, size_t size,
+        size_t *needed);
+
 __END_DECLS
 
 #endif
@@ -213,17 +213,13 @@ ssize_t read(int fd, void* buf, size_t count) {
         __read_count_toobig_error();
     }
 
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
+    if (__bos_trivially_ge(bos, count)) {
         return __read_real(fd, buf, count);
     }
 
     if (__builtin_constant_p(count) && (count > bos)) {
         __read_dest_size_error();
     }
-
-    if (__builtin_constant_p(count) && (count <= bos)) {
-        return __read_real(fd, buf, count);
-    }
 #endif
 
     return __read_chk(fd, buf, count, bos);
@@ -33,23 +33,60 @@
 
 __BEGIN_DECLS
 
-extern int iswalnum_l(wint_t, locale_t);
-extern int iswalpha_l(wint_t, locale_t);
-extern int iswblank_l(wint_t, locale_t);
-extern int iswcntrl_l(wint_t, locale_t);
-extern int iswdigit_l(wint_t, locale_t);
-extern int iswgraph_l(wint_t, locale_t);
-extern int iswlower_l(wint_t, locale_t);
-extern int iswprint_l(wint_t, locale_t);
-extern int iswpunct_l(wint_t, locale_t);
-extern int iswspace_l(wint_t, locale_t);
-extern int iswupper_l(wint_t, locale_t);
-extern int iswxdigit_l(wint_t, locale_t);
-extern int towlower_l(int, locale_t);
-extern int towupper_l(int, locale_t);
-
-extern int iswctype_l(wint_t, wctype_t, locale_t);
-extern wctype_t wctype_l(const char*, locale_t);
+/* As in <ctype.h>, wctype.cpp makes the out-of-line copies. */
+#if !defined(__BIONIC_WCTYPE_INLINE)
+#define __BIONIC_WCTYPE_INLINE static __inline
+#endif
+
+__BIONIC_WCTYPE_INLINE int iswalnum_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswalnum(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswalpha_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswalpha(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswblank_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswblank(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswcntrl_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswcntrl(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswdigit_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswdigit(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswgraph_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswgraph(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswlower_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswlower(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswprint_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswprint(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswpunct_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswpunct(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswspace_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswspace(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswupper_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswupper(__wc);
+}
+__BIONIC_WCTYPE_INLINE int iswxdigit_l(wint_t __wc, locale_t __l __attribute__((__unused__))) {
+  return iswxdigit(__wc);
+}
+__BIONIC_WCTYPE_INLINE int towlower_l(int __wc, locale_t __l __attribute__((__unused__))) {
+  return towlower(__wc);
+}
+__BIONIC_WCTYPE_INLINE int towupper_l(int __wc, locale_t __l __attribute__((__unused__))) {
+  return towupper(__wc);
+}
+
+__BIONIC_WCTYPE_INLINE int iswctype_l(wint_t __wc, wctype_t __type, locale_t __l __attribute__((__unused__))) {
+  return iswctype(__wc, __type);
+}
+__BIONIC_WCTYPE_INLINE wctype_t wctype_l(const char* __property, locale_t __l __attribute__((__unused__))) {
+  return wctype(__property);
+}
 
 __END_DECLS
 
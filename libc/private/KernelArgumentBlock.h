@@ -25,6 +25,8 @@
 #include "private/bionic_macros.h"
 
 struct abort_msg_t;
+struct StartupTrace;
+struct TlsModules;
 
 // When the kernel starts the dynamic linker, it passes a pointer to a block
 // of memory containing argc, the argv array, the environment variable array,
@@ -47,6 +49,9 @@ class KernelArgumentBlock {
     ++p; // Skip second NULL;
 
     auxv = reinterpret_cast<ElfW(auxv_t)*>(p);
+
+    tls_modules = NULL;
+    startup_trace = NULL;
   }
 
   // Similar to ::getauxval but doesn't require the libc global variables to be set up,
@@ -74,6 +79,12 @@ class KernelArgumentBlock {
 
   abort_msg_t** abort_message_ptr;
 
+  // The ELF TLS module table, if there are any TLS modules.
+  TlsModules* tls_modules;
+
+  // The linker's startup timestamps, for libc.so to pick up.
+  StartupTrace* startup_trace;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(KernelArgumentBlock);
 };
@@ -26,6 +26,8 @@ struct NetdClientDispatch {
     int (*accept4)(int, struct sockaddr*, socklen_t*, int);
     int (*connect)(int, const struct sockaddr*, socklen_t);
     int (*socket)(int, int, int);
+    int (*sendmmsg)(int, const struct mmsghdr*, unsigned int, int);
+    int (*recvmmsg)(int, struct mmsghdr*, unsigned int, int, const struct timespec*);
     unsigned (*netIdForResolv)(unsigned);
 };
 
@@ -28,6 +28,10 @@
  * void ANDROID_MEMBAR_FULL()
  *   Full memory barrier.  Provides a compiler reordering barrier, and
  *   on SMP systems emits an appropriate instruction.
+ *
+ * void __bionic_cpu_relax()
+ *   Tells the CPU we're spinning, so it can save power or give way to
+ *   another hardware thread. Also a compiler reordering barrier.
  */
 
 #if !defined(ANDROID_SMP)
@@ -58,6 +62,16 @@ extern "C" {
 
 #define ANDROID_MEMBAR_FULL  __bionic_memory_barrier
 
+__ATOMIC_INLINE__ void __bionic_cpu_relax(void) {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7A__)
+  __asm__ __volatile__("yield" ::: "memory");
+#else
+  __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -36,6 +36,9 @@ __BEGIN_DECLS
 
 extern ElfW(auxv_t)* __libc_auxv;
 
+/* Remembers the auxv, and indexes it so getauxval needn't search it. */
+__LIBC_HIDDEN__ extern void __libc_init_auxv(ElfW(auxv_t)* auxv);
+
 __END_DECLS
 
 #endif /* _PRIVATE_BIONIC_AUXV_H_ */
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _PRIVATE_BIONIC_ELF_TLS_H
+#define _PRIVATE_BIONIC_ELF_TLS_H
+
+#include <link.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// Support for ELF TLS (PT_TLS segments, __thread and thread_local) shared by
+// the dynamic linker and libc. The linker gives each module with a TLS segment
+// an id and lays out the static TLS area; libc uses the resulting table to
+// implement __tls_get_addr and to set up each new thread's static TLS.
+//
+// On x86 and x86-64 the static TLS area sits just below the thread pointer
+// ("variant II" in Drepper's "ELF Handling For Thread-Local Storage"), so the
+// executable and the libraries loaded with it get blocks at fixed offsets
+// that the initial-exec and local-exec models can use. On the other
+// architectures the compiler expects those blocks just above the thread
+// pointer, which is where bionic keeps its TLS slots, so only the dynamic
+// models (__tls_get_addr and, on AArch64, TLS descriptors) are supported.
+#if defined(__i386__) || defined(__x86_64__)
+#define BIONIC_STATIC_TLS 1
+#endif
+
+struct TlsSegment {
+  size_t size;
+  size_t alignment;
+  const void* init_ptr;
+  size_t init_size;
+};
+
+struct TlsModule {
+  TlsSegment segment;
+
+  // The TlsModules generation in which the module was registered, or 0 if
+  // this slot is free.
+  size_t generation;
+
+  // Modules loaded at startup have a block in the static TLS area at this
+  // offset from the thread pointer.
+  bool is_static;
+  intptr_t static_offset;
+};
+
+// The argument to __tls_get_addr, as laid out in the GOT by the static linker.
+struct TlsIndex {
+  size_t module;  // Module ids start at 1.
+  size_t offset;
+};
+
+struct TlsModules {
+  // Bumped whenever a module is registered or unregistered. A thread whose
+  // DTV has an older generation has to catch up before trusting it.
+  // (This must come first: the AArch64 TLSDESC resolver reads it directly.)
+  volatile size_t generation;
+
+  // Installed by libc, so that the linker's TLSDESC resolver can call it.
+  void* (*get_addr)(const TlsIndex*);
+
+  // Guards everything below.
+  pthread_mutex_t lock;
+
+  TlsModule* modules;
+  size_t module_count;  // Including free slots.
+  size_t module_capacity;
+
+  // The static TLS area, below the thread pointer.
+  size_t static_size;
+  size_t static_alignment;
+};
+
+// Each thread's dynamic thread vector, hung off TLS_SLOT_DTV and allocated the
+// first time the thread needs it. blocks[i] is the thread's block for module
+// i + 1, or NULL if it hasn't touched that module's variables yet.
+struct TlsDtv {
+  size_t count;
+  size_t generation;
+  void* blocks[0];
+};
+
+__BEGIN_DECLS
+
+// The table is owned by the dynamic linker, or by libc itself in static executables.
+__LIBC_HIDDEN__ extern TlsModules* __libc_tls_modules;
+
+// Finds the PT_TLS segment of an ELF image, if it has one.
+__LIBC_HIDDEN__ bool __bionic_get_tls_segment(const ElfW(Phdr)* phdr, size_t phnum,
+                                              ElfW(Addr) load_bias, TlsSegment* out);
+
+// Gives a module a block in the static TLS area. This is only possible at
+// startup, before any thread but the main thread exists.
+__LIBC_HIDDEN__ void __bionic_add_static_tls_module(TlsModules* modules, TlsModule* module);
+
+// Decides where a thread's TLS slots go given the top of the memory set aside
+// for them, leaving room for the static TLS area below. *bottom is set to the
+// lowest address used, which is suitably aligned to be the top of the stack.
+__LIBC_HIDDEN__ void** __bionic_layout_thread_tls(uint8_t* top, uint8_t** bottom);
+
+// Copies the initialization images into a thread's static TLS area.
+__LIBC_HIDDEN__ void __bionic_init_static_tls(void** tls);
+
+// Moves the main thread's TLS slots somewhere with room for the static TLS
+// area below them. Called once the static modules are known and relocated,
+// before any of their code runs.
+__LIBC_HIDDEN__ bool __bionic_init_main_thread_static_tls();
+
+// Frees the calling thread's DTV and dynamically allocated TLS blocks.
+__LIBC_HIDDEN__ void __bionic_free_dynamic_tls();
+
+void* __tls_get_addr(const TlsIndex* ti);
+
+__END_DECLS
+
+#if defined(__cplusplus)
+class KernelArgumentBlock;
+// Sets up the TLS segment of a static executable, if it has one. The load
+// bias is non-zero for static-PIE executables.
+__LIBC_HIDDEN__ void __libc_init_static_tls(KernelArgumentBlock& args, ElfW(Addr) load_bias);
+#endif
+
+#endif
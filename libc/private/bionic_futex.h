@@ -28,26 +28,21 @@
 #ifndef _BIONIC_FUTEX_H
 #define _BIONIC_FUTEX_H
 
-#include <errno.h>
 #include <linux/futex.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <sys/cdefs.h>
-#include <sys/syscall.h>
+
+#include "bionic_inline_syscalls.h"
 
 __BEGIN_DECLS
 
 struct timespec;
 
+// Our callers (pthread functions) don't want errno set, so these use the
+// inline system call, which returns -errno on failure.
 static inline __always_inline int __futex(volatile void* ftx, int op, int value, const struct timespec* timeout) {
-  // Our generated syscall assembler sets errno, but our callers (pthread functions) don't want to.
-  int saved_errno = errno;
-  int result = syscall(__NR_futex, ftx, op, value, timeout);
-  if (__predict_false(result == -1)) {
-    result = -errno;
-    errno = saved_errno;
-  }
-  return result;
+  return __inline_futex(ftx, op, value, timeout, NULL, 0);
 }
 
 static inline int __futex_wake(volatile void* ftx, int count) {
@@ -66,6 +61,27 @@ static inline int __futex_wait_ex(volatile void* ftx, bool shared, int value, co
   return __futex(ftx, shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, value, timeout);
 }
 
+// Like __futex_wait_ex, but 'abs_timeout' is an absolute time on CLOCK_REALTIME if
+// 'use_realtime_clock' is true and on CLOCK_MONOTONIC otherwise, so that the kernel
+// rather than the caller tracks the deadline. A NULL 'abs_timeout' waits forever.
+static inline int __futex_wait_abs_ex(volatile void* ftx, bool shared, int value,
+                                      bool use_realtime_clock, const struct timespec* abs_timeout) {
+  int op = shared ? FUTEX_WAIT_BITSET : FUTEX_WAIT_BITSET_PRIVATE;
+  if (use_realtime_clock) {
+    op |= FUTEX_CLOCK_REALTIME;
+  }
+  return __inline_futex(ftx, op, value, abs_timeout, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+// If *ftx is still 'value', wakes up to 'wake_count' waiters and moves up to 'requeue_count'
+// of the rest onto ftx2. Returns the number of waiters woken or moved.
+static inline int __futex_cmp_requeue_ex(volatile void* ftx, bool shared, int wake_count,
+                                         int requeue_count, volatile void* ftx2, int value) {
+  // The requeue count goes where the timeout usually does.
+  return __inline_futex(ftx, shared ? FUTEX_CMP_REQUEUE : FUTEX_CMP_REQUEUE_PRIVATE, wake_count,
+                        (const struct timespec*) (long) requeue_count, ftx2, value);
+}
+
 __END_DECLS
 
 #endif /* _BIONIC_FUTEX_H */
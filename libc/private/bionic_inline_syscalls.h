@@ -0,0 +1,17 @@
+/* Generated by gensyscalls.py. Do not edit. */
+#ifndef _PRIVATE_BIONIC_INLINE_SYSCALLS_H_
+#define _PRIVATE_BIONIC_INLINE_SYSCALLS_H_
+
+#include "bionic_raw_syscall.h"
+
+__BEGIN_DECLS
+
+struct timespec;
+
+static inline __always_inline int __inline_futex(volatile void* a0, int a1, int a2, const struct timespec* a3, volatile void* a4, int a5) {
+  return (int) __raw_syscall6(__NR_futex, (long) a0, (long) a1, (long) a2, (long) a3, (long) a4, (long) a5);
+}
+
+__END_DECLS
+
+#endif /* _PRIVATE_BIONIC_INLINE_SYSCALLS_H_ */
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _PRIVATE_BIONIC_PERCPU_H
+#define _PRIVATE_BIONIC_PERCPU_H
+
+#include <sys/cdefs.h>
+
+// Threads find their CPU through the rseq area the kernel keeps up to date
+// (see bionic_rseq.h), falling back to getcpu(2) on kernels without rseq. A
+// thread can be migrated at any moment, so the CPU is only a hint.
+
+__LIBC_HIDDEN__ void __rseq_register_current_thread();
+__LIBC_HIDDEN__ void __rseq_unregister_current_thread();
+
+// Returns the calling thread's current CPU, or -1 with errno set on failure.
+__LIBC_HIDDEN__ int __bionic_getcpu();
+
+// The getcpu(2) fallback, using the vdso where there is one (see bionic/vdso.cpp).
+__LIBC_HIDDEN__ int __libc_getcpu();
+
+#endif // _PRIVATE_BIONIC_PERCPU_H
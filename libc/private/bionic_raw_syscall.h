@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_RAW_SYSCALL_H_
+#define _PRIVATE_BIONIC_RAW_SYSCALL_H_
+
+#include <errno.h>
+#include <sys/cdefs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * System calls made inline, for libc's own hot paths. These return what the
+ * kernel returns, -errno on failure, and never touch errno. The inline
+ * wrappers generated into bionic_inline_syscalls.h are built on these.
+ *
+ * Only arm64 and x86_64 have a calling convention simple enough to spell out
+ * in inline assembler: 32-bit arm may need r7 as its frame pointer, x86 needs
+ * ebx and ebp, and mips returns errors in a separate register and passes
+ * some arguments on the stack. Those go through syscall(3) instead.
+ */
+
+#if defined(__aarch64__)
+
+static inline __always_inline long __raw_syscall6(long n, long a0, long a1, long a2, long a3,
+                                                  long a4, long a5) {
+  register long x8 __asm__("x8") = n;
+  register long x0 __asm__("x0") = a0;
+  register long x1 __asm__("x1") = a1;
+  register long x2 __asm__("x2") = a2;
+  register long x3 __asm__("x3") = a3;
+  register long x4 __asm__("x4") = a4;
+  register long x5 __asm__("x5") = a5;
+  __asm__ __volatile__("svc #0"
+                       : "+r"(x0)
+                       : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+                       : "memory");
+  return x0;
+}
+
+#elif defined(__x86_64__)
+
+static inline __always_inline long __raw_syscall6(long n, long a0, long a1, long a2, long a3,
+                                                  long a4, long a5) {
+  register long r10 __asm__("r10") = a3;
+  register long r8 __asm__("r8") = a4;
+  register long r9 __asm__("r9") = a5;
+  long result;
+  __asm__ __volatile__("syscall"
+                       : "=a"(result)
+                       : "a"(n), "D"(a0), "S"(a1), "d"(a2), "r"(r10), "r"(r8), "r"(r9)
+                       : "rcx", "r11", "memory");
+  return result;
+}
+
+#else
+
+static inline __always_inline long __raw_syscall6(long n, long a0, long a1, long a2, long a3,
+                                                  long a4, long a5) {
+  int saved_errno = errno;
+  long result = syscall(n, a0, a1, a2, a3, a4, a5);
+  if (__predict_false(result == -1)) {
+    result = -errno;
+    errno = saved_errno;
+  }
+  return result;
+}
+
+#endif
+
+/* The kernel ignores the arguments a system call doesn't take. */
+#define __raw_syscall0(n) __raw_syscall6(n, 0, 0, 0, 0, 0, 0)
+#define __raw_syscall1(n, a0) __raw_syscall6(n, a0, 0, 0, 0, 0, 0)
+#define __raw_syscall2(n, a0, a1) __raw_syscall6(n, a0, a1, 0, 0, 0, 0)
+#define __raw_syscall3(n, a0, a1, a2) __raw_syscall6(n, a0, a1, a2, 0, 0, 0)
+#define __raw_syscall4(n, a0, a1, a2, a3) __raw_syscall6(n, a0, a1, a2, a3, 0, 0)
+#define __raw_syscall5(n, a0, a1, a2, a3, a4) __raw_syscall6(n, a0, a1, a2, a3, a4, 0)
+
+#endif /* _PRIVATE_BIONIC_RAW_SYSCALL_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _PRIVATE_BIONIC_RSEQ_H
+#define _PRIVATE_BIONIC_RSEQ_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/syscall.h>
+
+// Restartable sequences (rseq, Linux 4.18). Each thread registers an area
+// with the kernel, which then keeps the cpu_id field up to date whenever the
+// thread is scheduled, so finding out which CPU we're on is a plain load.
+// Our kernel headers predate rseq, so the ABI is spelled out here.
+
+#if !defined(__NR_rseq)
+#if defined(__aarch64__)
+#define __NR_rseq 293
+#elif defined(__arm__)
+#define __NR_rseq 398
+#elif defined(__i386__)
+#define __NR_rseq 386
+#elif defined(__x86_64__)
+#define __NR_rseq 334
+#elif defined(__mips__) && defined(__LP64__)
+#define __NR_rseq 5327
+#elif defined(__mips__)
+#define __NR_rseq 4367
+#endif
+#endif
+
+// The signature the kernel checks before jumping to an abort handler. We don't
+// have any critical sections yet, but it's fixed at registration time, so use the
+// values the rest of the world has settled on.
+#if defined(__aarch64__)
+#define BIONIC_RSEQ_SIG 0xd428bc00
+#elif defined(__arm__)
+#define BIONIC_RSEQ_SIG 0xe7f5def3
+#elif defined(__mips__)
+#define BIONIC_RSEQ_SIG 0x0350004d
+#else
+#define BIONIC_RSEQ_SIG 0x53053053
+#endif
+
+#define BIONIC_RSEQ_FLAG_UNREGISTER 1
+
+// cpu_id before registration, or if registration failed.
+#define BIONIC_RSEQ_CPU_ID_UNINITIALIZED (-1)
+
+struct bionic_rseq {
+  uint32_t cpu_id_start;
+  int32_t cpu_id;
+  uint64_t rseq_cs;
+  uint32_t flags;
+} __attribute__((aligned(32)));
+
+#endif // _PRIVATE_BIONIC_RSEQ_H
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_SHA_H_
+#define _BIONIC_SHA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// SHA-1 and SHA-256 for libc's own use. The block functions use the ARMv8
+// cryptography extension on arm64 and the SHA extensions on x86, when the
+// CPU has them, and portable C otherwise.
+
+#define BIONIC_SHA1_DIGEST_LENGTH 20
+#define BIONIC_SHA256_DIGEST_LENGTH 32
+
+struct bionic_sha1_t {
+  uint32_t state[5];
+  uint64_t length;  // In bytes.
+  uint8_t buffer[64];
+};
+
+struct bionic_sha256_t {
+  uint32_t state[8];
+  uint64_t length;  // In bytes.
+  uint8_t buffer[64];
+};
+
+__LIBC_HIDDEN__ void __sha1_init(bionic_sha1_t* ctx);
+__LIBC_HIDDEN__ void __sha1_update(bionic_sha1_t* ctx, const void* data, size_t length);
+__LIBC_HIDDEN__ void __sha1_final(bionic_sha1_t* ctx, uint8_t digest[BIONIC_SHA1_DIGEST_LENGTH]);
+__LIBC_HIDDEN__ void __sha1(const void* data, size_t length,
+                            uint8_t digest[BIONIC_SHA1_DIGEST_LENGTH]);
+
+__LIBC_HIDDEN__ void __sha256_init(bionic_sha256_t* ctx);
+__LIBC_HIDDEN__ void __sha256_update(bionic_sha256_t* ctx, const void* data, size_t length);
+__LIBC_HIDDEN__ void __sha256_final(bionic_sha256_t* ctx,
+                                    uint8_t digest[BIONIC_SHA256_DIGEST_LENGTH]);
+__LIBC_HIDDEN__ void __sha256(const void* data, size_t length,
+                              uint8_t digest[BIONIC_SHA256_DIGEST_LENGTH]);
+
+#endif  // _BIONIC_SHA_H_
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_STARTUP_TRACE_H
+#define _PRIVATE_BIONIC_STARTUP_TRACE_H
+
+#include <android/startup_trace.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+class KernelArgumentBlock;
+
+// The timestamps of <android/startup_trace.h>. The linker and libc.so each
+// have their own copy: the linker points KernelArgumentBlock::startup_trace
+// at its copy, and libc.so picks up what the linker recorded from there.
+struct StartupTrace {
+  bool enabled;
+  uint64_t timestamps[ANDROID_STARTUP_PHASE_COUNT];
+};
+
+extern __LIBC_HIDDEN__ StartupTrace __libc_startup_trace;
+
+// Turns tracing on if LIBC_STARTUP_TRACE is set, inheriting the linker's
+// timestamps if 'args' has them. Needs TLS, but nothing else.
+__LIBC_HIDDEN__ void __libc_startup_trace_init(KernelArgumentBlock& args);
+
+__LIBC_HIDDEN__ void __libc_startup_trace_record(android_startup_phase phase);
+
+static inline void __libc_startup_trace_mark(android_startup_phase phase) {
+  if (__predict_false(__libc_startup_trace.enabled)) {
+    __libc_startup_trace_record(phase);
+  }
+}
+
+#endif // _PRIVATE_BIONIC_STARTUP_TRACE_H
@@ -48,6 +48,8 @@ __BEGIN_DECLS
  **/
 
 // Well-known TLS slots. What data goes in which slot is arbitrary unless otherwise noted.
+// The TLS array is cache-line aligned, and the slots in its first line are the ones touched
+// most often: errno, pthread_self(3), gettid(2) and getpid(2) between them need no other memory.
 enum {
   TLS_SLOT_SELF = 0, // The kernel requires this specific slot for x86.
   TLS_SLOT_THREAD_ID,
@@ -65,6 +67,26 @@ enum {
   TLS_SLOT_BIONIC_PREINIT = TLS_SLOT_OPENGL_API,
 
   TLS_SLOT_STACK_GUARD = 5, // GCC requires this specific slot for x86.
+
+  // The calling thread's copy of its pthread_internal_t's tid, which stays the one the
+  // kernel writes and other threads read.
+  TLS_SLOT_TID,
+
+  // The calling thread's cached pid, or 0 while it's forking or cloning (see bionic/getpid.cpp).
+  TLS_SLOT_CACHED_PID,
+
+  // The calling thread's dlmalloc cache (see bionic/malloc_thread_cache.cpp).
+  TLS_SLOT_MALLOC_CACHE,
+
+  // The calling thread's dynamic thread vector for ELF TLS (see bionic/elf_tls.cpp).
+  TLS_SLOT_DTV = 9, // linker/arch/arm64/tlsdesc_resolver.S requires this specific slot.
+
+  // The calling thread's values for keys beyond the TLS array (see bionic/pthread_key.cpp).
+  TLS_SLOT_PTHREAD_KEY_DATA,
+
+  // The calling thread's uselocale(3) locale, or NULL if it never called it (see bionic/locale.cpp).
+  TLS_SLOT_LOCALE,
+
   TLS_SLOT_DLERROR,
 
   TLS_SLOT_FIRST_USER_SLOT // Must come last!
@@ -85,12 +107,26 @@ enum {
 #define BIONIC_TLS_RESERVED_SLOTS GLOBAL_INIT_THREAD_LOCAL_BUFFER_COUNT
 #endif
 
+/* The TLS array starts on a cache line boundary. */
+#define BIONIC_TLS_ALIGNMENT 64
+
 /*
  * Maximum number of elements in the TLS array.
  * This includes space for pthread keys and our own internal slots.
- * We need to round up to maintain stack alignment.
+ * We round up to a whole number of cache lines, which also maintains stack alignment.
+ */
+#define BIONIC_TLS_SLOTS \
+  BIONIC_ALIGN(PTHREAD_KEYS_MAX + TLS_SLOT_FIRST_USER_SLOT + BIONIC_TLS_RESERVED_SLOTS, \
+               BIONIC_TLS_ALIGNMENT / __SIZEOF_POINTER__)
+
+/*
+ * Keys that don't fit in the TLS array are numbered from BIONIC_TLS_SLOTS upwards, and their
+ * values live in a per-thread table that is only allocated once the thread first sets one.
+ * This brings the total number of user keys up to glibc's 1024.
  */
-#define BIONIC_TLS_SLOTS BIONIC_ALIGN(PTHREAD_KEYS_MAX + TLS_SLOT_FIRST_USER_SLOT + BIONIC_TLS_RESERVED_SLOTS, 4)
+#define BIONIC_DYNAMIC_KEY_BLOCK_SIZE 32
+#define BIONIC_DYNAMIC_KEY_BLOCKS 28
+#define BIONIC_DYNAMIC_KEYS (BIONIC_DYNAMIC_KEY_BLOCK_SIZE * BIONIC_DYNAMIC_KEY_BLOCKS)
 
 __END_DECLS
 
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_TWO_WAY_H_
+#define _BIONIC_TWO_WAY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Crochemore and Perrin's Two-Way string matching, used by memmem, strstr,
+// strcasestr and wcsstr. It finds a needle of length l in a haystack of
+// length hl in O(hl + l) time, however repetitive the two are, where the
+// obvious loop can take O(hl * l).
+//
+// Characters are compared as fold(c): pass IdentityFold, or a functor such
+// as tolower for a case-insensitive search. CharT must order the way the
+// characters should; use unsigned char rather than char.
+//
+// Each step also skips ahead by the last position of the haystack's
+// current end character in the needle (Horspool's bad character rule).
+// The table is indexed by the character's low byte, so wide characters
+// can share a slot; the table then holds the last position of any of them,
+// which only makes the skips shorter.
+
+template <typename CharT>
+struct IdentityFold {
+  CharT operator()(CharT c) const { return c; }
+};
+
+// Returns the position before the maximal suffix of n (SIZE_MAX if it's all
+// of n) under the usual ordering, or the opposite one if reverse is true,
+// and sets *period to the suffix's period.
+template <typename CharT, typename Fold>
+static size_t two_way_maximal_suffix(const CharT* n, size_t l, Fold fold, bool reverse,
+                                     size_t* period) {
+  size_t ip = SIZE_MAX;
+  size_t jp = 0;
+  size_t k = 1;
+  size_t p = 1;
+  while (jp + k < l) {
+    CharT a = fold(n[ip + k]);
+    CharT b = fold(n[jp + k]);
+    if (a == b) {
+      if (k == p) {
+        jp += p;
+        k = 1;
+      } else {
+        ++k;
+      }
+    } else if (reverse ? (a < b) : (a > b)) {
+      jp += k;
+      k = 1;
+      p = jp - ip;
+    } else {
+      ip = jp++;
+      k = p = 1;
+    }
+  }
+  *period = p;
+  return ip;
+}
+
+// A haystack whose length is known.
+template <typename CharT>
+struct TwoWayKnownEnd {
+  const CharT* end;
+
+  // Returns whether there are at least l characters from h.
+  bool Has(const CharT* h, size_t l) { return static_cast<size_t>(end - h) >= l; }
+};
+
+// A NUL-terminated haystack, whose end is only looked for as far as the
+// search gets, so that an early match doesn't cost a scan of the rest.
+struct TwoWayStringEnd {
+  const unsigned char* end;  // No NUL before here.
+
+  bool Has(const unsigned char* h, size_t l) {
+    if (static_cast<size_t>(end - h) >= l) {
+      return true;
+    }
+    // Look somewhat further than needed, so each short step doesn't cost
+    // a call.
+    size_t grow = l | 63;
+    const unsigned char* nul = static_cast<const unsigned char*>(memchr(end, 0, grow));
+    if (nul != NULL) {
+      end = nul;
+      return static_cast<size_t>(end - h) >= l;
+    }
+    end += grow;
+    return true;
+  }
+};
+
+template <typename CharT, typename End, typename Fold>
+static const CharT* two_way_search_to(const CharT* h, End end, const CharT* n, size_t l,
+                                      Fold fold) {
+  if (!end.Has(h, l)) {
+    return NULL;
+  }
+
+  // The longer of the two maximal suffixes gives a critical factorization
+  // n[0..ms] n[ms+1..l) of the needle.
+  size_t p0, p1;
+  size_t ms0 = two_way_maximal_suffix(n, l, fold, false, &p0);
+  size_t ms1 = two_way_maximal_suffix(n, l, fold, true, &p1);
+  size_t ms = (ms1 + 1 > ms0 + 1) ? ms1 : ms0;
+  size_t p = (ms1 + 1 > ms0 + 1) ? p1 : p0;
+
+  // If the left half repeats with the period of the whole needle, a match
+  // of the right half after a shift by p means the first l - p characters
+  // are already known to match (mem). Otherwise nothing can be remembered,
+  // but a longer shift is safe.
+  size_t mem0 = l - p;
+  for (size_t i = 0; i < ms + 1; ++i) {
+    if (fold(n[i]) != fold(n[i + p])) {
+      mem0 = 0;
+      p = ((ms > l - ms - 1) ? ms : l - ms - 1) + 1;
+      break;
+    }
+  }
+
+  // shift[c] is one more than the last position of c in the needle, or 0.
+  size_t shift[256];
+  memset(shift, 0, sizeof(shift));
+  for (size_t i = 0; i < l; ++i) {
+    shift[static_cast<unsigned char>(fold(n[i]))] = i + 1;
+  }
+
+  size_t mem = 0;
+  while (end.Has(h, l)) {
+    size_t k = shift[static_cast<unsigned char>(fold(h[l - 1]))];
+    if (k == 0) {
+      h += l;
+      mem = 0;
+      continue;
+    }
+    k = l - k;
+    if (k != 0) {
+      h += (k < mem) ? mem : k;
+      mem = 0;
+      continue;
+    }
+
+    // Match the right half, then the left half down to what's remembered.
+    for (k = (ms + 1 > mem) ? ms + 1 : mem; k < l && fold(n[k]) == fold(h[k]); ++k) {
+    }
+    if (k < l) {
+      h += k - ms;
+      mem = 0;
+      continue;
+    }
+    for (k = ms + 1; k > mem && fold(n[k - 1]) == fold(h[k - 1]); --k) {
+    }
+    if (k <= mem) {
+      return h;
+    }
+    h += p;
+    mem = mem0;
+  }
+  return NULL;
+}
+
+// Returns the first occurrence of n[0..l) in h[0..hl), or NULL. l must not be 0.
+template <typename CharT, typename Fold>
+const CharT* two_way_search(const CharT* h, size_t hl, const CharT* n, size_t l, Fold fold) {
+  TwoWayKnownEnd<CharT> end = { h + hl };
+  return two_way_search_to(h, end, n, l, fold);
+}
+
+// Returns the first occurrence of n[0..l) in the NUL-terminated h, or NULL.
+// l must not be 0.
+template <typename Fold>
+const unsigned char* two_way_search_string(const unsigned char* h, const unsigned char* n,
+                                           size_t l, Fold fold) {
+  TwoWayStringEnd end = { h };
+  return two_way_search_to(h, end, n, l, fold);
+}
+
+#endif // _BIONIC_TWO_WAY_H_
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_UTF8_H_
+#define _BIONIC_UTF8_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <uchar.h>
+#include <wchar.h>
+
+// Bulk helpers for the multibyte conversions in wchar.cpp and mbrtoc32.cpp.
+// Most text is mostly ASCII, so the conversions skip whole runs of it with
+// these and only go through the mbstate_t machinery for the rest.
+//
+// Loads of more than one character are aligned to their own size, so they
+// never cross into a page the string doesn't reach: callers may pass
+// SIZE_MAX as the length of a NUL-terminated string.
+
+// Returns the length of the run of non-NUL ASCII bytes at s, looking at no
+// more than n bytes.
+static inline size_t utf8_ascii_prefix(const char* s, size_t n) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+  const size_t kOnes = SIZE_MAX / 0xff;
+  const size_t kHighs = kOnes * 0x80;
+  size_t i = 0;
+
+  // A byte is in the run if b - 1 < 0x7f: NUL wraps around.
+  while (i < n && (reinterpret_cast<uintptr_t>(p + i) & (2 * sizeof(size_t) - 1)) != 0) {
+    if (p[i] - 1u >= 0x7f) {
+      return i;
+    }
+    ++i;
+  }
+  // Two words at a time. w | (w - kOnes) has a byte's high bit set if the
+  // byte is NUL or non-ASCII (or a borrow came from such a byte below it).
+  while (n - i >= 2 * sizeof(size_t)) {
+    size_t w0, w1;
+    memcpy(&w0, p + i, sizeof(w0));
+    memcpy(&w1, p + i + sizeof(w0), sizeof(w1));
+    if (((w0 | (w0 - kOnes) | w1 | (w1 - kOnes)) & kHighs) != 0) {
+      break;
+    }
+    i += 2 * sizeof(size_t);
+  }
+  while (i < n && p[i] - 1u < 0x7f) {
+    ++i;
+  }
+  return i;
+}
+
+// Returns the length of the run of wide characters in [1, 0x7f] at s,
+// looking at no more than n of them.
+static inline size_t wcs_ascii_prefix(const wchar_t* s, size_t n) {
+  const size_t kBlock = 8;
+  size_t i = 0;
+
+  while (i < n && (reinterpret_cast<uintptr_t>(s + i) & (kBlock * sizeof(wchar_t) - 1)) != 0) {
+    if (static_cast<uint32_t>(s[i]) - 1 >= 0x7f) {
+      return i;
+    }
+    ++i;
+  }
+  // A block at a time, with no early exit, so the test vectorizes. As for
+  // bytes, c | (c - 1) is above 0x7f if c is NUL or non-ASCII.
+  while (n - i >= kBlock) {
+    uint32_t bits = 0;
+    for (size_t k = 0; k < kBlock; ++k) {
+      uint32_t c = static_cast<uint32_t>(s[i + k]);
+      bits |= c | (c - 1);
+    }
+    if ((bits & ~0x7fu) != 0) {
+      break;
+    }
+    i += kBlock;
+  }
+  while (i < n && static_cast<uint32_t>(s[i]) - 1 < 0x7f) {
+    ++i;
+  }
+  return i;
+}
+
+// Decodes the multibyte character at s, which is no more than n bytes long,
+// in the initial conversion state. Returns its length, or 0 if s doesn't
+// start with a complete, valid sequence of two to four bytes: the caller
+// should then use mbrtoc32, which handles partial sequences and errors.
+// Accepts exactly what mbrtoc32 does.
+static inline size_t utf8_decode_multibyte(const char* s, size_t n, char32_t* pc32) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+  char32_t c32;
+
+  if (p[0] < 0xc0) {
+    return 0;
+  }
+  if (p[0] < 0xe0) {
+    if (n < 2 || (p[1] & 0xc0) != 0x80) {
+      return 0;
+    }
+    c32 = ((p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+    if (c32 < 0x80) {
+      return 0;
+    }
+    *pc32 = c32;
+    return 2;
+  }
+  if (p[0] < 0xf0) {
+    if (n < 3 || (p[1] & 0xc0) != 0x80 || (p[2] & 0xc0) != 0x80) {
+      return 0;
+    }
+    c32 = ((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+    if (c32 < 0x800 || (c32 >= 0xd800 && c32 <= 0xdfff) || c32 >= 0xfffe) {
+      return 0;
+    }
+    *pc32 = c32;
+    return 3;
+  }
+  if (p[0] < 0xf8) {
+    if (n < 4 || (p[1] & 0xc0) != 0x80 || (p[2] & 0xc0) != 0x80 || (p[3] & 0xc0) != 0x80) {
+      return 0;
+    }
+    c32 = ((p[0] & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+    if (c32 < 0x10000) {
+      return 0;
+    }
+    *pc32 = c32;
+    return 4;
+  }
+  return 0;
+}
+
+#endif // _BIONIC_UTF8_H_
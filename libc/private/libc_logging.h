@@ -101,6 +101,14 @@ __LIBC_HIDDEN__ int __libc_format_log(int priority, const char* tag, const char*
 __LIBC_HIDDEN__ int __libc_format_log_va_list(int priority, const char* tag, const char* format,
                                               va_list ap);
 
+//
+// Asynchronous logging (libc.debug.async_log), for libc.so's constructor and
+// destructor. Neither does anything unless it's been asked for.
+//
+
+__LIBC_HIDDEN__ void __libc_async_log_init();
+__LIBC_HIDDEN__ void __libc_async_log_fini();
+
 //
 // Event logging.
 //
@@ -42,8 +42,11 @@
  * Return first argument, or NULL if no characters were read.
  * Do not return NULL if n == 1.
  */
+// BEGIN android-changed
+// The work is done by fgets_unlocked, which fgets wraps in the stream lock.
 char *
-fgets(char *buf, int n, FILE *fp)
+fgets_unlocked(char *buf, int n, FILE *fp)
+// END android-changed
 {
 	size_t len;
 	char *s;
@@ -54,7 +57,6 @@ fgets(char *buf, int n, FILE *fp)
 		return (NULL);
 	}
 
-	FLOCKFILE(fp);
 	_SET_ORIENTATION(fp, -1);
 	s = buf;
 	n--;			/* leave space for NUL */
@@ -65,10 +67,8 @@ fgets(char *buf, int n, FILE *fp)
 		if (fp->_r <= 0) {
 			if (__srefill(fp)) {
 				/* EOF/error: stop with partial or no line */
-				if (s == buf) {
-					FUNLOCKFILE(fp);
+				if (s == buf)
 					return (NULL);
-				}
 				break;
 			}
 		}
@@ -81,7 +81,7 @@ fgets(char *buf, int n, FILE *fp)
 		 * newline, and stop.  Otherwise, copy entire chunk
 		 * and loop.
 		 */
-		if (len > n)
+		if (len > (size_t)n)
 			len = n;
 		t = memchr((void *)p, '\n', len);
 		if (t != NULL) {
@@ -90,7 +90,6 @@ fgets(char *buf, int n, FILE *fp)
 			fp->_p = t;
 			(void)memcpy((void *)s, (void *)p, len);
 			s[len] = '\0';
-			FUNLOCKFILE(fp);
 			return (buf);
 		}
 		fp->_r -= len;
@@ -100,6 +99,18 @@ fgets(char *buf, int n, FILE *fp)
 		n -= len;
 	}
 	*s = '\0';
-	FUNLOCKFILE(fp);
 	return (buf);
 }
+
+// BEGIN android-added
+char *
+fgets(char *buf, int n, FILE *fp)
+{
+	char *s;
+
+	FLOCKFILE(fp);
+	s = fgets_unlocked(buf, n, fp);
+	FUNLOCKFILE(fp);
+	return (s);
+}
+// END android-added
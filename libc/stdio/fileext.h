@@ -43,9 +43,15 @@ struct __sfileext {
 	struct	__sbuf _ub; /* ungetc buffer */
 	struct wchar_io_data _wcio;	/* wide char io status */
 	pthread_mutex_t _lock; /* file lock */
+	struct __sFILE *_next_free; /* next on __sfp's free list */
+	int _on_free_list;
+	struct __sFILE *_next_writing; /* on the list of streams written to */
+	struct __sFILE *_prev_writing;
+	int _on_writing_list;
+	int _caller_handles_locking; /* __fsetlocking(FSETLOCKING_BYCALLER) */
 };
 
-#define _FILEEXT_INITIALIZER  {{NULL,0},{0},PTHREAD_RECURSIVE_MUTEX_INITIALIZER}
+#define _FILEEXT_INITIALIZER  {{NULL,0},{0},PTHREAD_RECURSIVE_MUTEX_INITIALIZER,NULL,0,NULL,NULL,0,0}
 
 #define _EXT(fp) ((struct __sfileext *)((fp)->_ext._base))
 #define _UB(fp) _EXT(fp)->_ub
@@ -57,6 +63,7 @@ do { \
 	_UB(fp)._size = 0; \
 	WCIO_INIT(fp); \
         _FLOCK(fp).value = __PTHREAD_RECURSIVE_MUTEX_INIT_VALUE; \
+	_EXT(fp)->_caller_handles_locking = 0; \
 } while (0)
 
 #define _FILEEXT_SETUP(f, fext) \
@@ -50,7 +50,8 @@
 
 int	__sdidinit;
 
-#define	NDYNAMIC 10		/* add ten more whenever necessary */
+#define	NDYNAMIC 10		/* add at least ten more whenever necessary */
+#define	MAXDYNAMIC 1024		/* but no more than this many at a time */
 
 #define	std(flags, file) \
 	{0,0,0,flags,file,{0},0,__sF+file,__sclose,__sread,__sseek,__swrite, \
@@ -63,6 +64,148 @@ static struct glue uglue = { 0, FOPEN_MAX - 3, usual };
 static struct glue *lastglue = &uglue;
 _THREAD_PRIVATE_MUTEX(__sfp_mutex);
 
+/*
+ * Released FILEs wait on a free list, linked through their extensions, so
+ * that __sfp doesn't have to search every glue block for one. All of this
+ * is protected by __sfp_mutex.
+ */
+static FILE *freelist;
+static FILE *lastfp;		/* the FILE most recently handed out */
+static int nglued = FOPEN_MAX;	/* the number of FILEs in all the glue */
+
+static void
+pushfree(FILE *fp)
+{
+	if (_EXT(fp)->_on_free_list)
+		return;
+	_EXT(fp)->_next_free = freelist;
+	_EXT(fp)->_on_free_list = 1;
+	freelist = fp;
+}
+
+static FILE *
+popfree(void)
+{
+	FILE *fp;
+
+	while ((fp = freelist) != NULL) {
+		freelist = _EXT(fp)->_next_free;
+		_EXT(fp)->_on_free_list = 0;
+		/* freopen may have picked it up again since it was released */
+		if (fp->_flags == 0)
+			return (fp);
+	}
+	return (NULL);
+}
+
+/*
+ * Streams that have been set up for writing are also on a list of their
+ * own, so that fflush(NULL), exit and the line-buffered flush before a
+ * read cost O(streams written to) rather than O(FILEs ever allocated).
+ * A FILE joins when __swsetup (or setvbuf, or fmemopen) first readies it
+ * for output and leaves when it's released or handed out again. Also under __sfp_mutex.
+ */
+static FILE *writing;
+static int nwriting;
+
+static void
+unlink_writing(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+
+	if (!ext->_on_writing_list)
+		return;
+	if (ext->_prev_writing != NULL)
+		_EXT(ext->_prev_writing)->_next_writing = ext->_next_writing;
+	else
+		writing = ext->_next_writing;
+	if (ext->_next_writing != NULL)
+		_EXT(ext->_next_writing)->_prev_writing = ext->_prev_writing;
+	ext->_on_writing_list = 0;
+	nwriting--;
+}
+
+void
+__sfp_writing(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+
+	/* Only the stream's owner or fclose can change this. */
+	if (ext->_on_writing_list)
+		return;
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	if (!ext->_on_writing_list) {
+		ext->_prev_writing = NULL;
+		ext->_next_writing = writing;
+		if (writing != NULL)
+			_EXT(writing)->_prev_writing = fp;
+		writing = fp;
+		ext->_on_writing_list = 1;
+		nwriting++;
+	}
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+}
+
+/*
+ * Like _fwalk, but only over the streams that have been written to.
+ * function may lock the FILE, and a thread holding a FILE's lock may be
+ * waiting in __sfp_writing, so we take a copy of the list and call
+ * function without __sfp_mutex held. FILEs are never freed, so one that
+ * is closed meanwhile is just skipped or harmlessly flushed, as with
+ * _fwalk.
+ */
+int
+_fwalk_writing(int (*function)(FILE *))
+{
+	FILE *small[64], **fps, *fp;
+	int i, n, ret;
+
+	fps = small;
+	n = sizeof(small) / sizeof(small[0]);
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	while (nwriting > n) {
+		/* leave room for a few more to turn up while we're unlocked */
+		n = nwriting + 16;
+		_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+		if (fps != small)
+			free(fps);
+		if ((fps = malloc(n * sizeof(*fps))) == NULL)
+			return (_fwalk(function));
+		_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	}
+	for (i = 0, fp = writing; fp != NULL; fp = _EXT(fp)->_next_writing)
+		fps[i++] = fp;
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+
+	ret = 0;
+	while (--i >= 0) {
+		fp = fps[i];
+		if ((fp->_flags != 0) && ((fp->_flags & __SIGN) == 0))
+			ret |= (*function)(fp);
+	}
+	if (fps != small)
+		free(fps);
+	return (ret);
+}
+
+/*
+ * The error paths of fopen, freopen and the like release FILEs by
+ * clearing their flags without telling us. Find any such FILEs.
+ */
+static void
+reclaim(void)
+{
+	FILE *fp;
+	int n;
+	struct glue *g;
+
+	for (g = &__sglue; g != NULL; g = g->next) {
+		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
+			if (fp->_flags == 0)
+				pushfree(fp);
+	}
+}
+
 static struct __sfileext __sFext[3];
 FILE __sF[3] = {
 	std(__SRD, STDIN_FILENO),		/* stdin */
@@ -97,6 +240,9 @@ moreglue(int n)
 	while (--n >= 0) {
 		*p = empty;
 		_FILEEXT_SETUP(p, pext);
+		pext->_next_free = NULL;
+		pext->_on_free_list = 0;
+		pext->_on_writing_list = 0;
 		p++;
 		pext++;
 	}
@@ -117,22 +263,36 @@ __sfp(void)
 		__sinit();
 
 	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
-	for (g = &__sglue; g != NULL; g = g->next) {
-		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
-			if (fp->_flags == 0)
-				goto found;
-	}
+	/* The usual unannounced release is of a FILE fopen just failed to use. */
+	if (lastfp != NULL && lastfp->_flags == 0 && !_EXT(lastfp)->_on_free_list)
+		goto found;
+	if ((lastfp = popfree()) != NULL)
+		goto found;
+	reclaim();
+	if ((lastfp = popfree()) != NULL)
+		goto found;
 
+	/* Grow geometrically, so the reclaim scans cost O(1) per FILE. */
+	n = nglued;
+	if (n > MAXDYNAMIC)
+		n = MAXDYNAMIC;
+	else if (n < NDYNAMIC)
+		n = NDYNAMIC;
 	/* release lock while mallocing */
 	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
-	if ((g = moreglue(NDYNAMIC)) == NULL)
+	if ((g = moreglue(n)) == NULL)
 		return (NULL);
 	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
 	lastglue->next = g;
 	lastglue = g;
-	fp = g->iobs;
+	nglued += n;
+	while (--n > 0)
+		pushfree(&g->iobs[n]);
+	lastfp = g->iobs;
 found:
+	fp = lastfp;
 	fp->_flags = 1;		/* reserve this slot; caller sets real flags */
+	unlink_writing(fp);
 	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	fp->_p = NULL;		/* no current pointer */
 	fp->_w = 0;		/* nothing to read or write */
@@ -148,6 +308,20 @@ found:
 	return (fp);
 }
 
+/*
+ * Release a FILE for reuse. Taking the lock also makes sure that we're done
+ * with the FILE before it's considered available.
+ */
+void
+__sfp_release(FILE *fp)
+{
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	fp->_flags = 0;
+	pushfree(fp);
+	unlink_writing(fp);
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+}
+
 /*
  * exit() and abort() call _cleanup() through the callback registered
  * with __atexit_register_cleanup(), set whenever we open or buffer a
@@ -160,7 +334,7 @@ void
 _cleanup(void)
 {
 	/* (void) _fwalk(fclose); */
-	(void) _fwalk(__sflush);		/* `cheating' */
+	(void) _fwalk_writing(__sflush);	/* `cheating' */
 }
 
 /*
@@ -186,6 +360,11 @@ __sinit(void)
 	for (size_t i = 0; i < FOPEN_MAX - 3; ++i) {
 		_FILEEXT_SETUP(usual+i, usualext+i);
 	}
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	for (size_t i = FOPEN_MAX - 3; i > 0; --i) {
+		pushfree(usual+i-1);
+	}
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 
 	/* make sure we clean up on exit */
 	__atexit_register_cleanup(_cleanup); /* conservative */
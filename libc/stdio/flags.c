@@ -30,11 +30,7 @@
  * SUCH DAMAGE.
  */
 
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)flags.c	8.1 (Berkeley) 6/4/93";
-#endif /* LIBC_SCCS and not lint */
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
+/*	$FreeBSD$ */
 
 #include <sys/types.h>
 #include <sys/file.h>
@@ -103,9 +99,14 @@ __sflags(const char *mode, int *optr)
 		o |= O_EXCL;
 	}
 
-	/* set close-on-exec */
-	if (*mode == 'e')
-		o |= O_CLOEXEC;
+	// BEGIN android-changed
+	// 'e' (close-on-exec) and 'm' (serve reads from an mmap of the file,
+	// which fopen deals with) may come in either order.
+	for (; *mode == 'e' || *mode == 'm'; mode++) {
+		if (*mode == 'e')
+			o |= O_CLOEXEC;
+	}
+	// END android-changed
 
 	*optr = m | o;
 	return (ret);
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "local.h"
+
+/*
+ * Rather than copying through a FILE buffer of its own, a memory stream's
+ * FILE buffer is a window onto the caller's memory starting where the next
+ * write will land. putc and vfprintf then store straight into the
+ * destination, the write callback made by __sflush only has to account for
+ * bytes that are already in place, and __srefill is handed the unread data
+ * where it lies. The callbacks move the window whenever the position
+ * changes. Once the memory is full the window is a small spill area whose
+ * flush fails with ENOSPC.
+ *
+ * If the caller replaces the buffer with setvbuf, the window is abandoned
+ * and the callbacks copy like any other funopen stream's would.
+ */
+
+struct fmem {
+	FILE *fp;
+	char *buf;
+	size_t size;	/* capacity of buf */
+	size_t len;	/* bytes of valid data */
+	size_t pos;	/* current position */
+	int append;	/* writes go to the end */
+	int allocated;	/* we own buf */
+	int windowed;	/* the FILE buffer is our window */
+	unsigned char *window;
+	unsigned char spill[16];
+};
+
+static void
+fmem_rebase(struct fmem *fm, size_t off)
+{
+	FILE *fp = fm->fp;
+	size_t size;
+
+	if (!fm->windowed)
+		return;
+	if (fp->_bf._base != fm->window) {
+		/* setvbuf took over */
+		fm->windowed = 0;
+		return;
+	}
+	if (off < fm->size) {
+		fm->window = (unsigned char *)fm->buf + off;
+		size = fm->size - off;
+	} else {
+		fm->window = fm->spill;
+		size = sizeof(fm->spill);
+	}
+	if (size > INT_MAX)
+		size = INT_MAX;
+	fp->_bf._base = fp->_p = fm->window;
+	fp->_bf._size = size;
+	fp->_w = (fp->_flags & __SWR) ? (int)size : 0;
+}
+
+static int
+fmem_read(void *cookie, char *data, int n)
+{
+	struct fmem *fm = cookie;
+	size_t avail;
+
+	avail = fm->pos < fm->len ? fm->len - fm->pos : 0;
+	if (fm->windowed && data == (char *)fm->fp->_bf._base) {
+		/* __srefill: leave the data where it is */
+		fmem_rebase(fm, fm->pos);
+		n = avail > INT_MAX ? INT_MAX : (int)avail;
+	} else {
+		if ((size_t)n > avail)
+			n = avail;
+		memcpy(data, fm->buf + fm->pos, n);
+	}
+	fm->pos += n;
+	return (n);
+}
+
+static int
+fmem_write(void *cookie, const char *data, int n)
+{
+	struct fmem *fm = cookie;
+	size_t off, avail;
+
+	off = fm->append ? fm->len : fm->pos;
+	avail = fm->size - off;
+	if (avail == 0) {
+		errno = ENOSPC;
+		return (-1);
+	}
+	if ((size_t)n > avail)
+		n = avail;
+	if (data != fm->buf + off)
+		memmove(fm->buf + off, data, n);
+	fm->pos = off + n;
+	if (fm->pos > fm->len) {
+		fm->len = fm->pos;
+		if (fm->len < fm->size)
+			fm->buf[fm->len] = '\0';
+	}
+	fmem_rebase(fm, fm->pos);
+	return (n);
+}
+
+static fpos_t
+fmem_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct fmem *fm = cookie;
+	size_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		/* ftell and fseek ask first; don't disturb a read buffer */
+		if (offset == 0)
+			return (fm->pos);
+		base = fm->pos;
+		break;
+	case SEEK_END:
+		base = fm->len;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < 0 ? (size_t)-offset > base :
+	    (size_t)offset > fm->size - base) {
+		errno = EINVAL;
+		return (-1);
+	}
+	fm->pos = base + offset;
+	fmem_rebase(fm, fm->append ? fm->len : fm->pos);
+	return (fm->pos);
+}
+
+static int
+fmem_close(void *cookie)
+{
+	struct fmem *fm = cookie;
+
+	if (fm->allocated)
+		free(fm->buf);
+	free(fm);
+	return (0);
+}
+
+FILE *
+fmemopen(void *buf, size_t size, const char *mode)
+{
+	struct fmem *fm;
+	FILE *fp;
+	int flags, oflags;
+
+	if ((flags = __sflags(mode, &oflags)) == 0)
+		return (NULL);
+	if (size == 0 || size > (size_t)LONG_MAX) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((fm = calloc(1, sizeof(*fm))) == NULL)
+		return (NULL);
+	if (buf == NULL) {
+		if ((buf = calloc(1, size)) == NULL) {
+			free(fm);
+			return (NULL);
+		}
+		fm->allocated = 1;
+	}
+	fm->buf = buf;
+	fm->size = size;
+	if (oflags & O_TRUNC) {
+		fm->buf[0] = '\0';
+	} else if (oflags & O_APPEND) {
+		fm->append = 1;
+		fm->len = fm->pos = strnlen(fm->buf, size);
+	} else {
+		fm->len = size;
+	}
+
+	fp = funopen(fm, (flags & __SWR) ? NULL : fmem_read,
+	    (flags & __SRD) ? NULL : fmem_write, fmem_seek, fmem_close);
+	if (fp == NULL) {
+		fmem_close(fm);
+		return (NULL);
+	}
+	fm->fp = fp;
+	fm->windowed = 1;
+	fmem_rebase(fm, fm->pos);
+	/* the window is writable without going through __swsetup */
+	if (flags & __SWR)
+		__sfp_writing(fp);
+	return (fp);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "local.h"
+
+/*
+ * fopen's 'm' mode: a regular file opened read-only is read from an mmap
+ * of the file rather than with read(2). As with fmemopen, the FILE buffer
+ * is a window onto the mapping starting at the current position, so
+ * __srefill just moves the window on and getc, fgets and getline take
+ * their bytes straight from the page cache. Seeks only move the position.
+ *
+ * The mapping is advised MADV_SEQUENTIAL until the first seek that moves
+ * the position, after which the kernel's default readahead applies.
+ *
+ * The stream sees the file as it was when it was opened: data appended
+ * later is not read, and truncating the file under it raises SIGBUS as
+ * with any mapping. If the caller replaces the buffer with setvbuf, the
+ * window is abandoned and reads copy out of the mapping.
+ */
+
+struct fmmap {
+	FILE *fp;
+	unsigned char *map;
+	size_t size;	/* length of the mapping */
+	size_t pos;	/* current position */
+	int windowed;	/* the FILE buffer is our window */
+	int advised;	/* MADV_SEQUENTIAL is still in effect */
+	unsigned char *window;
+};
+
+static void
+fmmap_rebase(struct fmmap *mm)
+{
+	FILE *fp = mm->fp;
+	size_t off, size;
+
+	if (!mm->windowed)
+		return;
+	if (fp->_bf._base != mm->window) {
+		/* setvbuf took over */
+		mm->windowed = 0;
+		return;
+	}
+	off = mm->pos < mm->size ? mm->pos : mm->size;
+	size = mm->size - off;
+	if (size > INT_MAX)
+		size = INT_MAX;
+	mm->window = mm->map + off;
+	fp->_bf._base = fp->_p = mm->window;
+	fp->_bf._size = size;
+}
+
+static int
+fmmap_read(void *cookie, char *data, int n)
+{
+	struct fmmap *mm = cookie;
+	size_t avail;
+
+	avail = mm->pos < mm->size ? mm->size - mm->pos : 0;
+	if (mm->windowed && data == (char *)mm->window) {
+		/* __srefill: leave the data where it is */
+		fmmap_rebase(mm);
+		n = avail > INT_MAX ? INT_MAX : (int)avail;
+	} else {
+		if ((size_t)n > avail)
+			n = avail;
+		memcpy(data, mm->map + mm->pos, n);
+	}
+	mm->pos += n;
+	return (n);
+}
+
+static fpos_t
+fmmap_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct fmmap *mm = cookie;
+	size_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		/* ftell and fseek ask first; don't disturb a read buffer */
+		if (offset == 0)
+			return (mm->pos);
+		base = mm->pos;
+		break;
+	case SEEK_END:
+		base = mm->size;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < 0 ? (size_t)-offset > base :
+	    (size_t)offset > (size_t)LONG_MAX - base) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if (base + offset != mm->pos && mm->advised) {
+		(void)madvise(mm->map, mm->size, MADV_NORMAL);
+		mm->advised = 0;
+	}
+	mm->pos = base + offset;
+	fmmap_rebase(mm);
+	return (mm->pos);
+}
+
+static int
+fmmap_close(void *cookie)
+{
+	struct fmmap *mm = cookie;
+	int r;
+
+	munmap(mm->map, mm->size);
+	r = close(mm->fp->_file);
+	free(mm);
+	return (r);
+}
+
+/*
+ * Switch a freshly opened read-only stream over to reading from an mmap
+ * of its file. Returns -1, leaving the stream as it was, if the file isn't
+ * a non-empty regular file or can't be mapped.
+ */
+int
+__smmap(FILE *fp)
+{
+	struct fmmap *mm;
+	struct stat st;
+	void *map;
+
+	if (fstat(fp->_file, &st) == -1 || !S_ISREG(st.st_mode) ||
+	    st.st_size <= 0 || (uintmax_t)st.st_size > SIZE_MAX)
+		return (-1);
+	if ((mm = calloc(1, sizeof(*mm))) == NULL)
+		return (-1);
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fp->_file, 0);
+	if (map == MAP_FAILED) {
+		free(mm);
+		return (-1);
+	}
+	(void)madvise(map, st.st_size, MADV_SEQUENTIAL);
+	mm->fp = fp;
+	mm->map = map;
+	mm->size = st.st_size;
+	mm->windowed = 1;
+	mm->advised = 1;
+
+	fp->_cookie = mm;
+	fp->_read = fmmap_read;
+	fp->_write = NULL;
+	fp->_seek = fmmap_seek;
+	fp->_close = fmmap_close;
+	fp->_bf._base = mm->window = mm->map;
+	fmmap_rebase(mm);
+	fp->_r = 0;
+	return (0);
+}
@@ -30,13 +30,8 @@
  * SUCH DAMAGE.
  */
 
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)fopen.c	8.1 (Berkeley) 6/4/93";
-#endif /* LIBC_SCCS and not lint */
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
+/*	$FreeBSD$ */
 
-#include "namespace.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -44,7 +39,7 @@ __FBSDID("$FreeBSD$");
 #include <stdio.h>
 #include <errno.h>
 #include <limits.h>
-#include "un-namespace.h"
+#include <string.h>
 
 #include "local.h"
 
@@ -59,7 +54,7 @@ fopen(const char * __restrict file, const char * __restrict mode)
 		return (NULL);
 	if ((fp = __sfp()) == NULL)
 		return (NULL);
-	if ((f = _open(file, oflags, DEFFILEMODE)) < 0) {
+	if ((f = open(file, oflags, DEFFILEMODE)) < 0) {
 		fp->_flags = 0;			/* release */
 		return (NULL);
 	}
@@ -72,7 +67,7 @@ fopen(const char * __restrict file, const char * __restrict mode)
 	 */
 	if (f > SHRT_MAX) {
 		fp->_flags = 0;			/* release */
-		_close(f);
+		close(f);
 		errno = EMFILE;
 		return (NULL);
 	}
@@ -92,6 +87,12 @@ fopen(const char * __restrict file, const char * __restrict mode)
 	 * fseek and ftell.)
 	 */
 	if (oflags & O_APPEND)
-		(void)_sseek(fp, (fpos_t)0, SEEK_END);
+		(void)__sseek(fp, (fpos_t)0, SEEK_END);
+	// BEGIN android-added
+	// A read-only stream opened with 'm' reads from an mmap of the file
+	// where it can; otherwise it carries on as an ordinary stream.
+	if (flags == __SRD && strchr(mode, 'm') != NULL)
+		(void)__smmap(fp);
+	// END android-added
 	return (fp);
 }
@@ -35,12 +35,66 @@
 #include <string.h>
 #include <stdint.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
 #include "local.h"
 
 #define MUL_NO_OVERFLOW	(1UL << (sizeof(size_t) * 4))
 
+// BEGIN android-added
+/*
+ * Read 'resid' bytes straight into the caller's buffer, once the stream's
+ * own buffer has been drained. For plain file descriptors the same readv(2)
+ * also refills the stream's buffer with whatever follows. Returns the
+ * number of bytes it couldn't read, setting __SEOF or __SERR as __srefill
+ * would have.
+ */
+static size_t
+__fread_direct(FILE *fp, char *p, size_t resid)
+{
+	struct iovec iov[2];
+	ssize_t n;
+
+	fp->_r = 0;
+	fp->_p = fp->_bf._base;
+	while (resid > 0) {
+		if (fp->_read == __sread) {
+			iov[0].iov_base = p;
+			iov[0].iov_len = resid;
+			iov[1].iov_base = fp->_bf._base;
+			iov[1].iov_len = fp->_bf._size;
+			n = readv(fp->_file, iov, 2);
+			/* what __sread would do */
+			if (n >= 0)
+				fp->_offset += n;
+			else
+				fp->_flags &= ~__SOFF;
+		} else {
+			n = (*fp->_read)(fp->_cookie, p,
+			    resid > INT_MAX ? INT_MAX : (int)resid);
+		}
+		if (n <= 0) {
+			fp->_flags |= (n == 0) ? __SEOF : __SERR;
+			break;
+		}
+		if ((size_t)n > resid) {
+			/* the rest went into our buffer */
+			fp->_r = n - resid;
+			fp->_flags &= ~__SMOD;
+			return (0);
+		}
+		p += n;
+		resid -= n;
+	}
+	return (resid);
+}
+// END android-added
+
+// BEGIN android-changed
+// The work is done by fread_unlocked, which fread wraps in the stream lock.
 size_t
-fread(void *buf, size_t size, size_t count, FILE *fp)
+fread_unlocked(void *buf, size_t size, size_t count, FILE *fp)
+// END android-changed
 {
 	size_t resid;
 	char *p;
@@ -62,7 +116,6 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
 	 */
 	if ((resid = count * size) == 0)
 		return (0);
-	FLOCKFILE(fp);
 	_SET_ORIENTATION(fp, -1);
 	if (fp->_r < 0)
 		fp->_r = 0;
@@ -79,7 +132,6 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
 			p += r;
 			resid -= r;
 		}
-		FUNLOCKFILE(fp);
 		return ((total - resid) / size);
 	}
 	// END android-added
@@ -90,15 +142,37 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
 		/* fp->_r = 0 ... done in __srefill */
 		p += r;
 		resid -= r;
+		// BEGIN android-added
+		// Rather than copy big reads through the buffer a buffer's worth
+		// at a time, read them directly. This is only for streams that
+		// __srefill would simply read from: already reading, no ungetc
+		// buffer, and not line buffered (which would mean flushing output).
+		if (resid >= (size_t)fp->_bf._size && fp->_bf._base != NULL &&
+		    (fp->_flags & (__SRD|__SLBF|__SEOF)) == __SRD && !HASUB(fp)) {
+			resid = __fread_direct(fp, p, resid);
+			return ((total - resid) / size);
+		}
+		// END android-added
 		if (__srefill(fp)) {
 			/* no more input: return partial result */
-			FUNLOCKFILE(fp);
 			return ((total - resid) / size);
 		}
 	}
 	(void)memcpy((void *)p, (void *)fp->_p, resid);
 	fp->_r -= resid;
 	fp->_p += resid;
-	FUNLOCKFILE(fp);
 	return (count);
 }
+
+// BEGIN android-added
+size_t
+fread(void *buf, size_t size, size_t count, FILE *fp)
+{
+	size_t r;
+
+	FLOCKFILE(fp);
+	r = fread_unlocked(buf, size, count, fp);
+	FUNLOCKFILE(fp);
+	return (r);
+}
+// END android-added
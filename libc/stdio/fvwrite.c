@@ -35,8 +35,50 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include "local.h"
-#include "fvwrite.h"
+#include "../upstream-openbsd/lib/libc/stdio/fvwrite.h"
+
+// BEGIN android-added
+/*
+ * Write out the partly full buffer of a fully buffered stream followed
+ * by 'len' bytes from 'p' with one writev(2), instead of topping up the
+ * buffer with a copy of the start of 'p' and then flushing it. Returns
+ * how many bytes of 'p' were written, or -1 with the buffered data
+ * dropped, as __sflush does.
+ */
+static int
+__swritev_buffered(FILE *fp, const char *p, size_t len)
+{
+	struct iovec iov[2];
+	unsigned char *base = fp->_bf._base;
+	size_t n = fp->_p - base;
+	ssize_t w;
+
+	fp->_p = fp->_bf._base;
+	fp->_w = fp->_bf._size;
+	while (n > 0) {
+		iov[0].iov_base = base;
+		iov[0].iov_len = n;
+		iov[1].iov_base = (void *)p;
+		iov[1].iov_len = len;
+		/* what __swrite would do */
+		if (fp->_flags & __SAPP)
+			(void) lseek(fp->_file, (off_t)0, SEEK_END);
+		fp->_flags &= ~__SOFF;
+		w = writev(fp->_file, iov, 2);
+		if (w <= 0)
+			return (-1);
+		if ((size_t)w >= n)
+			return (w - n);
+		base += w;
+		n -= w;
+	}
+	return (0);
+}
+// END android-added
 
 /*
  * Write some memory regions.  Return zero on success, EOF on error.
@@ -103,7 +145,7 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 		do {
 			GETIOV(;);
 			if ((fp->_flags & (__SALC | __SSTR)) ==
-			    (__SALC | __SSTR) && fp->_w < len) {
+			    (__SALC | __SSTR) && (size_t)fp->_w < len) {
 				size_t blen = fp->_p - fp->_bf._base;
 				unsigned char *_base;
 				int _size;
@@ -112,7 +154,7 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 				_size = fp->_bf._size;
 				do {
 					_size = (_size << 1) + 1;
-				} while (_size < blen + len);
+				} while ((size_t)_size < blen + len);
 				_base = realloc(fp->_bf._base, _size + 1);
 				if (_base == NULL)
 					goto err;
@@ -123,22 +165,33 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 			}
 			w = fp->_w;
 			if (fp->_flags & __SSTR) {
-				if (len < w)
+				if (len < (size_t)w)
 					w = len;
 				COPY(w);	/* copy MIN(fp->_w,len), */
 				fp->_w -= w;
 				fp->_p += w;
 				w = len;	/* but pretend copied all */
-			} else if (fp->_p > fp->_bf._base && len > w) {
+			// BEGIN android-added
+			} else if (fp->_p > fp->_bf._base &&
+			    len >= (size_t)fp->_bf._size && fp->_write == __swrite) {
+				/* flush and write directly, in one go */
+				w = __swritev_buffered(fp, p, MIN(len, INT_MAX));
+				if (w < 0)
+					goto err;
+			// END android-added
+			} else if (fp->_p > fp->_bf._base && len > (size_t)w) {
 				/* fill and flush */
 				COPY(w);
 				/* fp->_w -= w; */ /* unneeded */
 				fp->_p += w;
 				if (__sflush(fp))
 					goto err;
-			} else if (len >= (w = fp->_bf._size)) {
+			} else if (len >= (size_t)(w = fp->_bf._size)) {
 				/* write directly */
-				w = (*fp->_write)(fp->_cookie, p, w);
+				// BEGIN android-changed
+				// All of it, not just a buffer's worth at a time.
+				w = (*fp->_write)(fp->_cookie, p, MIN(len, INT_MAX));
+				// END android-changed
 				if (w <= 0)
 					goto err;
 			} else {
@@ -165,10 +218,10 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 			GETIOV(nlknown = 0);
 			if (!nlknown) {
 				nl = memchr((void *)p, '\n', len);
-				nldist = nl ? nl + 1 - p : len + 1;
+				nldist = nl ? nl + 1 - p : (int)len + 1;
 				nlknown = 1;
 			}
-			s = MIN(len, nldist);
+			s = MIN((int)len, nldist);
 			w = fp->_w + fp->_bf._size;
 			if (fp->_p > fp->_bf._base && s > w) {
 				COPY(w);
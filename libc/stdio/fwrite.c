@@ -36,7 +36,7 @@
 #include <stdint.h>
 #include <errno.h>
 #include "local.h"
-#include "fvwrite.h"
+#include "../upstream-openbsd/lib/libc/stdio/fvwrite.h"
 
 #define MUL_NO_OVERFLOW	(1UL << (sizeof(size_t) * 4))
 
@@ -44,8 +44,11 @@
  * Write `count' objects (each size `size') from memory to the given file.
  * Return the number of whole objects written.
  */
+// BEGIN android-changed
+// The work is done by fwrite_unlocked, which fwrite wraps in the stream lock.
 size_t
-fwrite(const void *buf, size_t size, size_t count, FILE *fp)
+fwrite_unlocked(const void *buf, size_t size, size_t count, FILE *fp)
+// END android-changed
 {
 	size_t n;
 	struct __suio uio;
@@ -78,11 +81,22 @@ fwrite(const void *buf, size_t size, size_t count, FILE *fp)
 	 * skip the divide if this happens, since divides are
 	 * generally slow and since this occurs whenever size==0.
 	 */
-	FLOCKFILE(fp);
 	_SET_ORIENTATION(fp, -1);
 	ret = __sfvwrite(fp, &uio);
-	FUNLOCKFILE(fp);
 	if (ret == 0)
 		return (count);
 	return ((n - uio.uio_resid) / size);
 }
+
+// BEGIN android-added
+size_t
+fwrite(const void *buf, size_t size, size_t count, FILE *fp)
+{
+	size_t r;
+
+	FLOCKFILE(fp);
+	r = fwrite_unlocked(buf, size, count, fp);
+	FUNLOCKFILE(fp);
+	return (r);
+}
+// END android-added
@@ -73,11 +73,17 @@ __LIBC64_HIDDEN__ int _fwalk(int (*)(FILE *));
 #pragma GCC visibility push(hidden)
 
 int	__sflush_locked(FILE *);
+void	__sfp_release(FILE *);
+void	__sfp_writing(FILE *);
+int	_fwalk_writing(int (*)(FILE *));
+int	__smmap(FILE *);
 void	_cleanup(void);
 int	__swhatbuf(FILE *, size_t *, int *);
 wint_t __fgetwc_unlock(FILE *);
 wint_t	__ungetwc(wint_t, FILE *);
 int	__vfprintf(FILE *, const char *, __va_list);
+int	__vfprintf_fast(FILE *, const char *, __va_list);
+int	__printf_is_simple(const char *);
 int	__svfscanf(FILE * __restrict, const char * __restrict, __va_list);
 int	__vfwprintf(FILE * __restrict, const wchar_t * __restrict, __va_list);
 int	__vfwscanf(FILE * __restrict, const wchar_t * __restrict, __va_list);
@@ -111,8 +117,14 @@ extern void __atexit_register_cleanup(void (*)(void));
 	(fp)->_lb._base = NULL; \
 }
 
-#define FLOCKFILE(fp)   flockfile(fp)
-#define FUNLOCKFILE(fp) funlockfile(fp)
+/*
+ * Streams handed over to the caller with __fsetlocking(FSETLOCKING_BYCALLER)
+ * skip the implicit locking; flockfile and funlockfile themselves still lock.
+ */
+#define FLOCKFILE(fp) \
+	do { if (!_EXT(fp)->_caller_handles_locking) flockfile(fp); } while (0)
+#define FUNLOCKFILE(fp) \
+	do { if (!_EXT(fp)->_caller_handles_locking) funlockfile(fp); } while (0)
 
 #define FLOATING_POINT
 #define PRINTF_WIDE_CHAR
@@ -33,11 +33,52 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/system_properties.h>
 #include <unistd.h>
+#include <limits.h>
+#include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "local.h"
 
+// BEGIN android-added
+/*
+ * Regular files get a buffer of at least this size, rather than just
+ * st_blksize (often 4KiB), to cut the number of read and write calls
+ * made by sequential I/O. Setting LIBC_STDIO_BUFSIZE in the environment,
+ * or the libc.stdio.bufsize property, overrides it for a process.
+ * Pipes, sockets and ttys keep their st_blksize buffers.
+ */
+#define	DEFAULT_FILE_BUFSIZE	(16 * 1024)
+#define	MAX_FILE_BUFSIZE	(1024 * 1024)
+
+static size_t
+__sfile_bufsize(void)
+{
+	static size_t cached_size;
+	char value[PROP_VALUE_MAX];
+	const char *s;
+	unsigned long size;
+
+	/* Racing callers all come up with the same answer. */
+	if (cached_size != 0)
+		return (cached_size);
+	size = DEFAULT_FILE_BUFSIZE;
+	s = getenv("LIBC_STDIO_BUFSIZE");
+	if (s == NULL && __system_property_get("libc.stdio.bufsize", value) > 0)
+		s = value;
+	if (s != NULL) {
+		size = strtoul(s, NULL, 0);
+		if (size < BUFSIZ)
+			size = BUFSIZ;
+		else if (size > MAX_FILE_BUFSIZE)
+			size = MAX_FILE_BUFSIZE;
+	}
+	cached_size = size;
+	return (size);
+}
+// END android-added
+
 /*
  * Allocate a file buffer, or switch to unbuffered I/O.
  * Per the ANSI C standard, ALL tty devices default to line buffered.
@@ -59,7 +100,14 @@ __smakebuf(FILE *fp)
 		return;
 	}
 	flags = __swhatbuf(fp, &size, &couldbetty);
-	if ((p = malloc(size)) == NULL) {
+	// BEGIN android-changed
+	// Page-aligned buffers let the kernel copy whole pages in and out.
+	if (size >= PAGE_SIZE)
+		p = memalign(PAGE_SIZE, size);
+	else
+		p = malloc(size);
+	if (p == NULL) {
+	// END android-changed
 		fp->_flags |= __SNBF;
 		fp->_bf._base = fp->_p = fp->_nbuf;
 		fp->_bf._size = 1;
@@ -102,6 +150,10 @@ __swhatbuf(FILE *fp, size_t *bufsize, int *couldbetty)
 	 */
 	*bufsize = st.st_blksize;
 	fp->_blksize = st.st_blksize;
+	// BEGIN android-added
+	if (S_ISREG(st.st_mode) && *bufsize < __sfile_bufsize())
+		*bufsize = __sfile_bufsize();
+	// END android-added
 	return ((st.st_mode & S_IFMT) == S_IFREG && fp->_seek == __sseek ?
 	    __SOPT : __SNPT);
 }
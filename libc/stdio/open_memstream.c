@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "local.h"
+
+/*
+ * Like fmemopen (see fmemopen.c), the FILE buffer is a window onto the
+ * growing buffer itself, so output is formatted straight into the memory
+ * the caller gets back. Whenever a flush fills the window the buffer
+ * doubles. Positions past the end of the buffer (after a seek) get the
+ * spill area as their window until the next flush grows the buffer to
+ * cover them.
+ */
+
+#define	MEMSTREAM_INITIAL_SIZE	BUFSIZ
+
+struct memstream {
+	FILE *fp;
+	char **bufp;
+	size_t *sizep;
+	char *buf;
+	size_t cap;	/* capacity of buf, including the NUL */
+	size_t len;	/* bytes written */
+	size_t pos;	/* current position */
+	int windowed;	/* the FILE buffer is our window */
+	unsigned char *window;
+	unsigned char spill[64];
+};
+
+static int
+memstream_grow(struct memstream *ms, size_t need)
+{
+	size_t cap;
+	char *buf;
+
+	if (need <= ms->cap)
+		return (0);
+	for (cap = ms->cap; cap < need; cap *= 2) {
+		if (cap > SIZE_MAX / 2) {
+			cap = need;
+			break;
+		}
+	}
+	if ((buf = realloc(ms->buf, cap)) == NULL)
+		return (-1);
+	ms->buf = buf;
+	ms->cap = cap;
+	return (0);
+}
+
+static void
+memstream_update(struct memstream *ms)
+{
+	*ms->bufp = ms->buf;
+	*ms->sizep = ms->pos < ms->len ? ms->pos : ms->len;
+}
+
+static void
+memstream_rebase(struct memstream *ms)
+{
+	FILE *fp = ms->fp;
+	size_t size;
+
+	if (!ms->windowed)
+		return;
+	if (fp->_bf._base != ms->window) {
+		/* setvbuf took over */
+		ms->windowed = 0;
+		return;
+	}
+	if (ms->pos < ms->cap - 1) {
+		ms->window = (unsigned char *)ms->buf + ms->pos;
+		size = ms->cap - 1 - ms->pos;
+	} else {
+		ms->window = ms->spill;
+		size = sizeof(ms->spill);
+	}
+	if (size > INT_MAX)
+		size = INT_MAX;
+	fp->_bf._base = fp->_p = ms->window;
+	fp->_bf._size = size;
+	fp->_w = size;
+}
+
+static int
+memstream_write(void *cookie, const char *data, int n)
+{
+	struct memstream *ms = cookie;
+
+	if (ms->pos > SIZE_MAX - 2 - n) {
+		errno = EFBIG;
+		return (-1);
+	}
+	if (data != ms->buf + ms->pos) {
+		/* not already in place: spilled, or written directly */
+		if (memstream_grow(ms, ms->pos + n + 1) == -1)
+			return (-1);
+		memmove(ms->buf + ms->pos, data, n);
+	}
+	if (ms->pos > ms->len)
+		memset(ms->buf + ms->len, 0, ms->pos - ms->len);
+	ms->pos += n;
+	if (ms->pos > ms->len) {
+		ms->len = ms->pos;
+		ms->buf[ms->len] = '\0';
+	}
+	/* Keep the window open; if this fails, we'll spill and retry. */
+	if (ms->pos + 1 >= ms->cap)
+		(void)memstream_grow(ms, ms->pos + 2);
+	memstream_rebase(ms);
+	memstream_update(ms);
+	return (n);
+}
+
+static fpos_t
+memstream_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct memstream *ms = cookie;
+	size_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		if (offset == 0)
+			return (ms->pos);
+		base = ms->pos;
+		break;
+	case SEEK_END:
+		base = ms->len;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < 0 ? (size_t)-offset > base :
+	    (size_t)offset > (size_t)LONG_MAX - base) {
+		errno = offset < 0 ? EINVAL : EOVERFLOW;
+		return (-1);
+	}
+	ms->pos = base + offset;
+	memstream_rebase(ms);
+	memstream_update(ms);
+	return (ms->pos);
+}
+
+static int
+memstream_close(void *cookie)
+{
+	struct memstream *ms = cookie;
+
+	memstream_update(ms);
+	free(ms);
+	return (0);
+}
+
+FILE *
+open_memstream(char **bufp, size_t *sizep)
+{
+	struct memstream *ms;
+	FILE *fp;
+
+	if (bufp == NULL || sizep == NULL) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((ms = calloc(1, sizeof(*ms))) == NULL)
+		return (NULL);
+	if ((ms->buf = malloc(MEMSTREAM_INITIAL_SIZE)) == NULL) {
+		free(ms);
+		return (NULL);
+	}
+	ms->buf[0] = '\0';
+	ms->cap = MEMSTREAM_INITIAL_SIZE;
+	ms->bufp = bufp;
+	ms->sizep = sizep;
+
+	fp = funopen(ms, NULL, memstream_write, memstream_seek,
+	    memstream_close);
+	if (fp == NULL) {
+		free(ms->buf);
+		free(ms);
+		return (NULL);
+	}
+	ms->fp = fp;
+	ms->windowed = 1;
+	memstream_rebase(ms);
+	memstream_update(ms);
+	/* the window is writable without going through __swsetup */
+	__sfp_writing(fp);
+	return (fp);
+}
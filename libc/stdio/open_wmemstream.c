@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "local.h"
+
+/*
+ * Wide output reaches a FILE as multibyte characters, so unlike
+ * open_memstream this can't format in place: the write callback decodes
+ * the FILE's buffer into the wide buffer, which doubles as needed.
+ * Positions are counted in wide characters.
+ */
+
+#define	WMEMSTREAM_INITIAL_SIZE	(BUFSIZ / sizeof(wchar_t))
+
+struct wmemstream {
+	wchar_t **bufp;
+	size_t *sizep;
+	wchar_t *buf;
+	size_t cap;	/* capacity of buf in wide chars, including the NUL */
+	size_t len;	/* wide chars written */
+	size_t pos;	/* current position */
+	mbstate_t mbs;
+};
+
+static int
+wmemstream_grow(struct wmemstream *ms, size_t need)
+{
+	size_t cap;
+	wchar_t *buf;
+
+	if (need <= ms->cap)
+		return (0);
+	for (cap = ms->cap; cap < need; cap *= 2) {
+		if (cap > SIZE_MAX / sizeof(wchar_t) / 2) {
+			if (need > SIZE_MAX / sizeof(wchar_t)) {
+				errno = ENOMEM;
+				return (-1);
+			}
+			cap = need;
+			break;
+		}
+	}
+	if ((buf = realloc(ms->buf, cap * sizeof(wchar_t))) == NULL)
+		return (-1);
+	ms->buf = buf;
+	ms->cap = cap;
+	return (0);
+}
+
+static void
+wmemstream_update(struct wmemstream *ms)
+{
+	*ms->bufp = ms->buf;
+	*ms->sizep = ms->pos < ms->len ? ms->pos : ms->len;
+}
+
+static int
+wmemstream_write(void *cookie, const char *data, int n)
+{
+	struct wmemstream *ms = cookie;
+	wchar_t wc;
+	size_t r;
+	int i;
+
+	/* Worst case, every byte is a character. */
+	if (ms->pos > SIZE_MAX - 1 - n) {
+		errno = EFBIG;
+		return (-1);
+	}
+	if (wmemstream_grow(ms, ms->pos + n + 1) == -1)
+		return (-1);
+	if (ms->pos > ms->len)
+		wmemset(ms->buf + ms->len, L'\0', ms->pos - ms->len);
+	for (i = 0; i < n; i += r) {
+		if ((unsigned char)data[i] < 0x80 && mbsinit(&ms->mbs)) {
+			wc = (unsigned char)data[i];
+			r = 1;
+		} else {
+			r = mbrtowc(&wc, data + i, n - i, &ms->mbs);
+			if (r == (size_t)-2)
+				break;	/* the rest is in mbs */
+			if (r == (size_t)-1) {
+				memset(&ms->mbs, 0, sizeof(ms->mbs));
+				return (-1);
+			}
+			if (r == 0)
+				r = 1;
+		}
+		ms->buf[ms->pos++] = wc;
+	}
+	if (ms->pos > ms->len) {
+		ms->len = ms->pos;
+		ms->buf[ms->len] = L'\0';
+	}
+	wmemstream_update(ms);
+	return (n);
+}
+
+static fpos_t
+wmemstream_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct wmemstream *ms = cookie;
+	size_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = ms->pos;
+		break;
+	case SEEK_END:
+		base = ms->len;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < 0 ? (size_t)-offset > base :
+	    (size_t)offset > (size_t)LONG_MAX - base) {
+		errno = offset < 0 ? EINVAL : EOVERFLOW;
+		return (-1);
+	}
+	ms->pos = base + offset;
+	memset(&ms->mbs, 0, sizeof(ms->mbs));
+	wmemstream_update(ms);
+	return (ms->pos);
+}
+
+static int
+wmemstream_close(void *cookie)
+{
+	struct wmemstream *ms = cookie;
+
+	wmemstream_update(ms);
+	free(ms);
+	return (0);
+}
+
+FILE *
+open_wmemstream(wchar_t **bufp, size_t *sizep)
+{
+	struct wmemstream *ms;
+	FILE *fp;
+
+	if (bufp == NULL || sizep == NULL) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((ms = calloc(1, sizeof(*ms))) == NULL)
+		return (NULL);
+	ms->buf = malloc(WMEMSTREAM_INITIAL_SIZE * sizeof(wchar_t));
+	if (ms->buf == NULL) {
+		free(ms);
+		return (NULL);
+	}
+	ms->buf[0] = L'\0';
+	ms->cap = WMEMSTREAM_INITIAL_SIZE;
+	ms->bufp = bufp;
+	ms->sizep = sizep;
+
+	fp = funopen(ms, NULL, wmemstream_write, wmemstream_seek,
+	    wmemstream_close);
+	if (fp == NULL) {
+		free(ms->buf);
+		free(ms);
+		return (NULL);
+	}
+	fwide(fp, 1);
+	wmemstream_update(ms);
+	return (fp);
+}
@@ -103,9 +103,9 @@ __srefill(FILE *fp)
 	 * standard.
 	 */
 	if (fp->_flags & (__SLBF|__SNBF)) {
-		/* Ignore this file in _fwalk to avoid potential deadlock. */
+		/* Ignore this file in _fwalk_writing to avoid potential deadlock. */
 		fp->_flags |= __SIGN;
-		(void) _fwalk(lflush);
+		(void) _fwalk_writing(lflush);	/* android-changed */
 		fp->_flags &= ~__SIGN;
 
 		/* Now flush this file without locking it. */
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include "local.h"
+#include "../upstream-openbsd/lib/libc/stdio/fvwrite.h"
+
+/*
+ * Most formats are plain %d, %s and %x conversions with no flags, width
+ * or precision. __vfprintf_fast handles just those, generating decimal
+ * digits two at a time and storing straight into the FILE buffer rather
+ * than collecting output in a uio for __sfvwrite. Its output is exactly
+ * what __vfprintf would produce.
+ *
+ * __printf_is_simple vets the whole format first: once the fast path has
+ * taken an argument it can't hand over to __vfprintf. Literal text must
+ * be ASCII, for which __vfprintf's mbrtowc scan changes nothing.
+ */
+
+/* Length modifiers, as in __vfprintf. */
+#define	LONGINT		0x0010		/* long integer */
+#define	LLONGINT	0x0020		/* long long integer */
+#define	SHORTINT	0x0040		/* short integer */
+#define	PTRINT		0x0200		/* (unsigned) ptrdiff_t */
+#define	SIZEINT		0x0400		/* (signed) size_t */
+#define	CHARINT		0x0800		/* 8 bit integer */
+#define	MAXINT		0x1000		/* largest integer size (intmax_t) */
+
+/* Enough for the decimal digits of a uintmax_t, or 0x and its hex digits. */
+#define	BUF		24
+
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char xdigs_lower[16] = "0123456789abcdef";
+static const char xdigs_upper[16] = "0123456789ABCDEF";
+
+/*
+ * Skip a length modifier, returning its flags.
+ */
+static int
+lengthmod(const char **fmtp)
+{
+	const char *fmt = *fmtp;
+	int flags;
+
+	switch (*fmt++) {
+	case 'h':
+		if (*fmt == 'h') {
+			fmt++;
+			flags = CHARINT;
+		} else
+			flags = SHORTINT;
+		break;
+	case 'l':
+		if (*fmt == 'l') {
+			fmt++;
+			flags = LLONGINT;
+		} else
+			flags = LONGINT;
+		break;
+	case 'q':
+		flags = LLONGINT;
+		break;
+	case 'j':
+		flags = MAXINT;
+		break;
+	case 't':
+		flags = PTRINT;
+		break;
+	case 'z':
+		flags = SIZEINT;
+		break;
+	default:
+		return (0);
+	}
+	*fmtp = fmt;
+	return (flags);
+}
+
+int
+__printf_is_simple(const char *fmt)
+{
+	unsigned char ch;
+
+	while ((ch = *fmt++) != '\0') {
+		if (ch >= 0x80)
+			return (0);
+		if (ch != '%')
+			continue;
+		switch (*fmt++) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c':
+		case 's':
+		case 'p':
+		case '%':
+			break;
+		default:
+			/* only integers take a length modifier */
+			fmt--;
+			if (lengthmod(&fmt) == 0)
+				return (0);
+			switch (*fmt++) {
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'x':
+			case 'X':
+				break;
+			default:
+				return (0);
+			}
+		}
+	}
+	return (1);
+}
+
+struct fastout {
+	FILE	*fp;
+	size_t	ret;		/* bytes output so far */
+	int	lbf;		/* line buffered */
+	int	newline;	/* a '\n' was stored without flushing */
+};
+
+/*
+ * Output len bytes, storing them straight into the FILE buffer if they
+ * fit and giving them to __sfvwrite if not. A line buffered stream has
+ * no _w to go by; it is flushed at the end if a newline went in.
+ */
+static int
+__fast_print(struct fastout *out, const char *p, size_t len)
+{
+	FILE *fp = out->fp;
+	struct __suio uio;
+	struct __siov iov;
+	size_t room;
+
+	if (len > INT_MAX - out->ret) {
+		errno = ENOMEM;
+		return (EOF);
+	}
+	out->ret += len;
+	if (out->lbf)
+		room = fp->_bf._base + fp->_bf._size - fp->_p;
+	else
+		room = fp->_w > 0 ? fp->_w : 0;
+	if (len <= room) {
+		memcpy(fp->_p, p, len);
+		fp->_p += len;
+		/*
+		 * A line buffered stream's _w counts down from 0 as its
+		 * buffer fills; __sfvwrite relies on that to know how much
+		 * room is left.
+		 */
+		fp->_w -= len;
+		if (out->lbf && memchr(p, '\n', len) != NULL)
+			out->newline = 1;
+		return (0);
+	}
+	iov.iov_base = (void *)p;
+	iov.iov_len = len;
+	uio.uio_iov = &iov;
+	uio.uio_iovcnt = 1;
+	uio.uio_resid = len;
+	return (__sfvwrite(fp, &uio));
+}
+
+/*
+ * Convert val to decimal, ending just before cp; return the first digit.
+ */
+static char *
+__fast_utoa10(char *cp, uintmax_t val)
+{
+	unsigned int n, r;
+
+	/* 64-bit division is a library call on LP32 */
+	while (val > UINT_MAX) {
+		r = val % 100;
+		val /= 100;
+		cp -= 2;
+		memcpy(cp, &digit_pairs[r * 2], 2);
+	}
+	n = val;
+	while (n >= 100) {
+		r = n % 100;
+		n /= 100;
+		cp -= 2;
+		memcpy(cp, &digit_pairs[r * 2], 2);
+	}
+	if (n >= 10) {
+		cp -= 2;
+		memcpy(cp, &digit_pairs[n * 2], 2);
+	} else
+		*--cp = '0' + n;
+	return (cp);
+}
+
+int
+__vfprintf_fast(FILE *fp, const char *fmt, __va_list ap)
+{
+	struct fastout out;
+	char buf[BUF];
+	char *ep = buf + BUF;
+	char *p;
+	const char *cp, *xdigs;
+	intmax_t smax;
+	uintmax_t umax;
+	size_t size;
+	int flags;
+
+#define	SARG() \
+	(flags&MAXINT ? va_arg(ap, intmax_t) : \
+	    flags&LLONGINT ? va_arg(ap, long long) : \
+	    flags&LONGINT ? va_arg(ap, long) : \
+	    flags&PTRINT ? va_arg(ap, ptrdiff_t) : \
+	    flags&SIZEINT ? va_arg(ap, ssize_t) : \
+	    flags&SHORTINT ? (short)va_arg(ap, int) : \
+	    flags&CHARINT ? (signed char)va_arg(ap, int) : \
+	    va_arg(ap, int))
+#define	UARG() \
+	(flags&MAXINT ? va_arg(ap, uintmax_t) : \
+	    flags&LLONGINT ? va_arg(ap, unsigned long long) : \
+	    flags&LONGINT ? va_arg(ap, unsigned long) : \
+	    flags&PTRINT ? (uintptr_t)va_arg(ap, ptrdiff_t) : \
+	    flags&SIZEINT ? va_arg(ap, size_t) : \
+	    flags&SHORTINT ? (unsigned short)va_arg(ap, int) : \
+	    flags&CHARINT ? (unsigned char)va_arg(ap, int) : \
+	    va_arg(ap, unsigned int))
+#define	PRINT(ptr, len) do { \
+	if (__fast_print(&out, (ptr), (len))) \
+		return (-1); \
+} while (0)
+
+	out.fp = fp;
+	out.ret = 0;
+	out.lbf = (fp->_flags & __SLBF) != 0;
+	out.newline = 0;
+
+	for (;;) {
+		for (cp = fmt; *fmt != '\0' && *fmt != '%'; fmt++)
+			continue;
+		if (fmt != cp)
+			PRINT(cp, fmt - cp);
+		if (*fmt == '\0')
+			break;
+		fmt++;
+
+		flags = lengthmod(&fmt);
+		switch (*fmt++) {
+		case 'd':
+		case 'i':
+			smax = SARG();
+			if (smax < 0) {
+				p = __fast_utoa10(ep, -(uintmax_t)smax);
+				*--p = '-';
+			} else
+				p = __fast_utoa10(ep, smax);
+			PRINT(p, ep - p);
+			break;
+		case 'u':
+			p = __fast_utoa10(ep, UARG());
+			PRINT(p, ep - p);
+			break;
+		case 'x':
+		case 'X':
+		case 'p':
+			if (fmt[-1] == 'p') {
+				umax = (unsigned long)va_arg(ap, void *);
+				xdigs = xdigs_lower;
+			} else {
+				umax = UARG();
+				xdigs = fmt[-1] == 'x' ? xdigs_lower :
+				    xdigs_upper;
+			}
+			p = ep;
+			do {
+				*--p = xdigs[umax & 15];
+				umax >>= 4;
+			} while (umax);
+			if (fmt[-1] == 'p') {
+				*--p = 'x';
+				*--p = '0';
+			}
+			PRINT(p, ep - p);
+			break;
+		case 'c':
+			buf[0] = va_arg(ap, int);
+			PRINT(buf, 1);
+			break;
+		case 's':
+			if ((cp = va_arg(ap, char *)) == NULL)
+				cp = "(null)";
+			if ((size = strlen(cp)) > 0)
+				PRINT(cp, size);
+			break;
+		case '%':
+			PRINT("%", 1);
+			break;
+		}
+	}
+	if (out.newline)
+		(void)__sflush(fp);
+	return (__sferror(fp) ? -1 : (int)out.ret);
+}
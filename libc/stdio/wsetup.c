@@ -82,5 +82,12 @@ __swsetup(FILE *fp)
 		fp->_lbfsize = -fp->_bf._size;
 	} else
 		fp->_w = fp->_flags & __SNBF ? 0 : fp->_bf._size;
+	// BEGIN android-added
+	// Let fflush(NULL) and exit know about it. String FILEs are on the
+	// stack; so are the FILEs __sbprintf and vdprintf set up, but those
+	// come with a buffer and never get here.
+	if ((fp->_flags & __SSTR) == 0)
+		__sfp_writing(fp);
+	// END android-added
 	return (0);
 }
@@ -49,7 +49,7 @@ class SysCallsTxtParser:
         """ parse a syscall spec line.
 
         line processing, format is
-           return type    func_name[|alias_list][:syscall_name[:socketcall_id]] ( [paramlist] ) architecture_list
+           return type    func_name[|alias_list][:syscall_name[:socketcall_id]] ( [paramlist] ) architecture_list [flags]
         """
         pos_lparen = line.find('(')
         E          = self.E
@@ -120,8 +120,19 @@ class SysCallsTxtParser:
               "socketcall_id" : socketcall_id
         }
 
-        # Parse the architecture list.
-        arch_list = line[pos_rparen+1:].strip()
+        # Parse the architecture list and any flags after it.
+        fields = line[pos_rparen+1:].split()
+        if len(fields) < 1:
+            E("missing architecture list in '%s'" % line)
+            return
+        arch_list = fields[0]
+        t["inline"] = False
+        for flag in fields[1:]:
+            if flag == "inline":
+                t["inline"] = True
+            else:
+                E("invalid syscall flag '%s' in '%s'" % (flag, line))
+                return
         if arch_list == "all":
             for arch in all_arches:
                 t[arch] = True
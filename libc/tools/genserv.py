@@ -5,7 +5,7 @@ import sys, os, string, re
 
 def usage():
     print """\
-  usage:  genserv < /etc/services > libc/netbsd/net/services.h
+  usage:  genserv < /etc/services > libc/dns/net/services.h
 
   this program is used to generate the hard-coded internet service list for the
   Bionic C library.
@@ -66,9 +66,66 @@ def parse(f):
 
     return result
 
+# must match __services_hash() in libc/dns/net/getservent.c (32-bit FNV-1a)
+def services_hash(key):
+    h = 2166136261
+    for c in key:
+        h = ((h ^ ord(c)) * 16777619) & 0xffffffff
+    return h
+
+def name_key(s):
+    return s.name + s.proto[0]
+
+def port_key(s):
+    return chr((s.port >> 8) & 255) + chr(s.port & 255) + s.proto[0]
+
+def gen_index(services, offsets, size, key):
+    """ open-addressed table of (offset + 1) into _services, 0 for an empty
+        slot. the first entry with a given key wins, as in a linear scan. """
+    slots = [0] * size
+    seen  = {}
+    for s, offset in zip(services, offsets):
+        k = key(s)
+        if k in seen:
+            continue
+        seen[k] = 1
+        i = services_hash(k) & (size - 1)
+        while slots[i] != 0:
+            i = (i + 1) & (size - 1)
+        slots[i] = offset + 1
+    return slots
+
+def gen_table(name, slots):
+    result = "static const unsigned short  %s[_SERVICES_HASH_SIZE] = {\n" % name
+    for i in range(0, len(slots), 8):
+        result += "   " + "".join([" %5d," % n for n in slots[i:i+8]]) + "\n"
+    result += "};\n"
+    return result
+
 services = parse(sys.stdin)
 line = '/* generated by genserv.py - do not edit */\nstatic const char  _services[] = "\\\n'
+offsets = []
+offset  = 0
 for s in services:
+    offsets.append(offset)
+    offset += 1 + len(s.name) + 4 + sum([1 + len(a) for a in s.aliases])
     line += str(s)+"\\\n"
 line += '\\0";\n'
+
+if offset + 1 > 65535:
+    sys.stderr.write("too many services for 16-bit offsets\n")
+    sys.exit(1)
+
+# keep the tables at most half full, so probe sequences stay short
+size = 16
+while size < 2 * len(services):
+    size *= 2
+
+line += "\n"
+line += "/* hash tables over _services keyed by (name, proto) and (port, proto).\n"
+line += " * each slot holds the offset of an entry plus one, or 0 if empty. */\n"
+line += "#define _SERVICES_HASH_SIZE  %d\n\n" % size
+line += gen_table("_services_by_name", gen_index(services, offsets, size, name_key))
+line += "\n"
+line += gen_table("_services_by_port", gen_index(services, offsets, size, port_key))
 print line
@@ -380,6 +380,51 @@ def x86_64_genstub(syscall):
     return result
 
 
+# Inline system calls go through __raw_syscall6, so each parameter must fit in
+# one register. They must be unnamed, since we name them ourselves.
+def inline_params(syscall):
+    params = [param.strip() for param in syscall["params"]]
+    if params == ["void"]:
+        return []
+    return params
+
+
+def check_inline_syscall(syscall):
+    params = inline_params(syscall)
+    if syscall["socketcall_id"] >= 0 or syscall["aliases"] or len(params) > 6 or \
+            [param for param in params if param_uses_64bits(param)]:
+        print "can't inline '%s'" % syscall["func"]
+        return False
+    return True
+
+
+arch_defines = {
+    "arm": "defined(__arm__)",
+    "arm64": "defined(__aarch64__)",
+    "mips": "(defined(__mips__) && !defined(__LP64__))",
+    "mips64": "(defined(__mips__) && defined(__LP64__))",
+    "x86": "defined(__i386__)",
+    "x86_64": "defined(__x86_64__)",
+}
+
+
+def inline_syscall_function(syscall):
+    params = inline_params(syscall)
+    args = ", ".join("%s a%d" % (param, i) for i, param in enumerate(params)) or "void"
+    values = "".join(", (long) a%d" % i for i in range(len(params)))
+    return_type = syscall["decl"].split(syscall["func"])[0].strip()
+    arches = [arch for arch in all_arches if syscall.has_key(arch)]
+    result = ""
+    if len(arches) != len(all_arches):
+        result += "#if %s\n" % " || ".join(arch_defines[arch] for arch in arches)
+    result += "static inline __always_inline %s __inline_%s(%s) {\n" % (return_type, syscall["func"], args)
+    result += "  return (%s) __raw_syscall%d(%s%s);\n" % (return_type, len(params), syscall["__NR_name"], values)
+    result += "}\n"
+    if len(arches) != len(all_arches):
+        result += "#endif\n"
+    return result
+
+
 class State:
     def __init__(self):
         self.old_stubs = []
@@ -397,6 +442,11 @@ class State:
         for syscall in self.syscalls:
             syscall["__NR_name"] = make__NR_name(syscall["name"])
 
+            if syscall["inline"]:
+                if not check_inline_syscall(syscall):
+                    return
+                continue
+
             if syscall.has_key("arm"):
                 syscall["asm-arm"] = add_footer(32, arm_eabi_genstub(syscall), syscall)
 
@@ -460,6 +510,25 @@ class State:
         self.other_files.append(glibc_syscalls_h_path)
 
 
+    def gen_inline_syscalls_h(self):
+        inline_syscalls_h_path = "private/bionic_inline_syscalls.h"
+        D("generating " + inline_syscalls_h_path)
+        fp = create_file(inline_syscalls_h_path)
+        fp.write("/* %s */\n" % warning)
+        fp.write("#ifndef _PRIVATE_BIONIC_INLINE_SYSCALLS_H_\n")
+        fp.write("#define _PRIVATE_BIONIC_INLINE_SYSCALLS_H_\n\n")
+        fp.write("#include \"bionic_raw_syscall.h\"\n\n")
+        fp.write("__BEGIN_DECLS\n\n")
+        fp.write("struct timespec;\n\n")
+        for syscall in self.syscalls:
+            if syscall["inline"]:
+                fp.write(inline_syscall_function(syscall))
+        fp.write("\n__END_DECLS\n\n")
+        fp.write("#endif /* _PRIVATE_BIONIC_INLINE_SYSCALLS_H_ */\n")
+        fp.close()
+        self.other_files.append(inline_syscalls_h_path)
+
+
     # Write each syscall stub.
     def gen_syscall_stubs(self):
         for syscall in self.syscalls:
@@ -494,6 +563,7 @@ class State:
         D("re-generating stubs and support files...")
 
         self.gen_glibc_syscalls_h()
+        self.gen_inline_syscalls_h()
         self.gen_syscall_stubs()
 
         D("comparing files...")
@@ -0,0 +1,293 @@
+#!/usr/bin/python
+#
+# Packs the dynamic relocations of a linked shared library into the
+# DT_ANDROID_REL/DT_ANDROID_RELA ("APS2") format understood by the bionic
+# dynamic linker (see linker/linker_reloc_iterators.h).
+#
+# Usage: pack-relocations.py INPUT.so OUTPUT.so
+#
+# The packed stream is written over the start of the existing .rel.dyn or
+# .rela.dyn contents and the dynamic section is retagged to point at it.
+# The file does not shrink, but the linker only ever touches the (much
+# smaller) packed prefix, so far fewer pages are read in and faulted when
+# the library is loaded. PLT relocations are left alone.
+
+import struct
+import sys
+
+PT_LOAD = 1
+PT_DYNAMIC = 2
+
+DT_NULL = 0
+DT_RELA = 7
+DT_RELASZ = 8
+DT_REL = 17
+DT_RELSZ = 18
+DT_JMPREL = 23
+DT_RELACOUNT = 0x6ffffff9
+DT_RELCOUNT = 0x6ffffffa
+
+DT_LOOS = 0x6000000d
+DT_ANDROID_REL = DT_LOOS + 2
+DT_ANDROID_RELSZ = DT_LOOS + 3
+DT_ANDROID_RELA = DT_LOOS + 4
+DT_ANDROID_RELASZ = DT_LOOS + 5
+
+SHT_LOOS = 0x60000000
+SHT_ANDROID_REL = SHT_LOOS + 1
+SHT_ANDROID_RELA = SHT_LOOS + 2
+
+RELOCATION_GROUPED_BY_INFO_FLAG = 1
+RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG = 2
+RELOCATION_GROUPED_BY_ADDEND_FLAG = 4
+RELOCATION_GROUP_HAS_ADDEND_FLAG = 8
+
+# Runs shorter than this are cheaper to encode as ungrouped relocations.
+MIN_GROUP_SIZE = 3
+
+
+class ElfFile(object):
+  def __init__(self, data):
+    if data[0:4] != b'\x7fELF':
+      raise Exception('not an ELF file')
+    if bytearray(data[5:6])[0] != 1:
+      raise Exception('only little-endian ELF files are supported')
+    self.data = data
+    self.is64 = bytearray(data[4:5])[0] == 2
+    if self.is64:
+      self.word = 'Q'
+      self.sword = 'q'
+      (self.e_phoff, self.e_shoff) = struct.unpack_from('<QQ', data, 0x20)
+      (self.e_phentsize, self.e_phnum, self.e_shentsize, self.e_shnum) = \
+          struct.unpack_from('<HHHH', data, 0x36)
+    else:
+      self.word = 'I'
+      self.sword = 'i'
+      (self.e_phoff, self.e_shoff) = struct.unpack_from('<II', data, 0x1c)
+      (self.e_phentsize, self.e_phnum, self.e_shentsize, self.e_shnum) = \
+          struct.unpack_from('<HHHH', data, 0x2a)
+    self.wordsize = struct.calcsize('<' + self.word)
+
+  def phdrs(self):
+    for i in range(self.e_phnum):
+      off = self.e_phoff + i * self.e_phentsize
+      if self.is64:
+        (p_type, p_flags, p_offset, p_vaddr, p_paddr, p_filesz) = \
+            struct.unpack_from('<IIQQQQ', self.data, off)
+      else:
+        (p_type, p_offset, p_vaddr, p_paddr, p_filesz) = \
+            struct.unpack_from('<IIIII', self.data, off)
+      yield (p_type, p_offset, p_vaddr, p_filesz)
+
+  def vaddr_to_offset(self, vaddr):
+    for (p_type, p_offset, p_vaddr, p_filesz) in self.phdrs():
+      if p_type == PT_LOAD and p_vaddr <= vaddr < p_vaddr + p_filesz:
+        return vaddr - p_vaddr + p_offset
+    raise Exception('address 0x%x is not in a loaded segment' % vaddr)
+
+  def dynamic_offset(self):
+    for (p_type, p_offset, p_vaddr, p_filesz) in self.phdrs():
+      if p_type == PT_DYNAMIC:
+        return (p_offset, p_filesz)
+    raise Exception('no PT_DYNAMIC segment')
+
+  def read_dynamic(self):
+    (offset, size) = self.dynamic_offset()
+    entry_size = 2 * self.wordsize
+    entries = []
+    for i in range(size // entry_size):
+      (tag, val) = struct.unpack_from('<' + self.sword + self.word, self.data,
+                                      offset + i * entry_size)
+      entries.append((tag, val))
+      if tag == DT_NULL:
+        break
+    return entries
+
+  def write_dynamic(self, entries):
+    (offset, size) = self.dynamic_offset()
+    entry_size = 2 * self.wordsize
+    # Removed entries leave DT_NULL padding at the end of the array.
+    count = size // entry_size
+    entries = entries + [(DT_NULL, 0)] * (count - len(entries))
+    for i in range(count):
+      struct.pack_into('<' + self.sword + self.word, self.data,
+                       offset + i * entry_size, entries[i][0], entries[i][1])
+
+  def find_section(self, file_offset):
+    for i in range(self.e_shnum):
+      off = self.e_shoff + i * self.e_shentsize
+      if self.is64:
+        (sh_offset,) = struct.unpack_from('<Q', self.data, off + 0x18)
+      else:
+        (sh_offset,) = struct.unpack_from('<I', self.data, off + 0x10)
+      if sh_offset == file_offset:
+        return off
+    return None
+
+  def update_section(self, shdr, sh_type, sh_size):
+    struct.pack_into('<I', self.data, shdr + 4, sh_type)
+    if self.is64:
+      struct.pack_into('<Q', self.data, shdr + 0x20, sh_size)
+      struct.pack_into('<Q', self.data, shdr + 0x38, 1)
+    else:
+      struct.pack_into('<I', self.data, shdr + 0x14, sh_size)
+      struct.pack_into('<I', self.data, shdr + 0x24, 1)
+
+
+def sleb128(value):
+  out = bytearray()
+  while True:
+    byte = value & 0x7f
+    value >>= 7
+    if (value == 0 and (byte & 0x40) == 0) or (value == -1 and (byte & 0x40) != 0):
+      out.append(byte)
+      return out
+    out.append(byte | 0x80)
+
+
+def to_signed(value, bits):
+  if value >= 1 << (bits - 1):
+    return value - (1 << bits)
+  return value
+
+
+def encode(relocs, is_rela, bits):
+  """Returns the APS2 encoding of relocs, a list of (offset, info, addend)."""
+  out = bytearray(b'APS2')
+  out += sleb128(len(relocs))
+  out += sleb128(0)
+
+  prev_offset = 0
+  prev_addend = 0
+  i = 0
+  while i < len(relocs):
+    # Find the run of relocations sharing r_info and the r_offset stride.
+    (offset, info, addend) = relocs[i]
+    delta = offset - prev_offset
+    run = 1
+    while i + run < len(relocs):
+      (next_offset, next_info, next_addend) = relocs[i + run]
+      if next_info != info or next_offset - relocs[i + run - 1][0] != delta:
+        break
+      run += 1
+
+    if run >= MIN_GROUP_SIZE:
+      group = relocs[i:i + run]
+      flags = RELOCATION_GROUPED_BY_INFO_FLAG | RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG
+    else:
+      # Gather relocations until the next groupable run starts.
+      end = i + run
+      while end < len(relocs):
+        start_delta = relocs[end][0] - relocs[end - 1][0]
+        n = 1
+        while (end + n < len(relocs) and n < MIN_GROUP_SIZE and
+               relocs[end + n][1] == relocs[end][1] and
+               relocs[end + n][0] - relocs[end + n - 1][0] == start_delta):
+          n += 1
+        if n >= MIN_GROUP_SIZE:
+          break
+        end += n
+      group = relocs[i:end]
+      flags = 0
+
+    has_addend = is_rela and any(r[2] != 0 for r in group)
+    if has_addend:
+      flags |= RELOCATION_GROUP_HAS_ADDEND_FLAG
+
+    out += sleb128(len(group))
+    out += sleb128(flags)
+    if flags & RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG:
+      out += sleb128(to_signed(delta, bits))
+    if flags & RELOCATION_GROUPED_BY_INFO_FLAG:
+      out += sleb128(to_signed(info, bits))
+    if not has_addend:
+      # The decoder resets r_addend for groups without addends.
+      prev_addend = 0
+
+    for (r_offset, r_info, r_addend) in group:
+      if not flags & RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG:
+        out += sleb128(to_signed((r_offset - prev_offset) % (1 << bits), bits))
+      if not flags & RELOCATION_GROUPED_BY_INFO_FLAG:
+        out += sleb128(to_signed(r_info, bits))
+      if has_addend:
+        out += sleb128(to_signed((r_addend - prev_addend) % (1 << bits), bits))
+        prev_addend = r_addend
+      prev_offset = r_offset
+
+    i += len(group)
+
+  return out
+
+
+def main():
+  if len(sys.argv) != 3:
+    sys.stderr.write('usage: %s INPUT.so OUTPUT.so\n' % sys.argv[0])
+    return 1
+
+  with open(sys.argv[1], 'rb') as f:
+    elf = ElfFile(bytearray(f.read()))
+
+  dynamic = elf.read_dynamic()
+  tags = dict(dynamic)
+  if DT_RELA in tags:
+    is_rela = True
+    (table_tag, size_tag, count_tag) = (DT_RELA, DT_RELASZ, DT_RELACOUNT)
+    (packed_tag, packed_size_tag, sh_type) = (DT_ANDROID_RELA, DT_ANDROID_RELASZ, SHT_ANDROID_RELA)
+  elif DT_REL in tags:
+    is_rela = False
+    (table_tag, size_tag, count_tag) = (DT_REL, DT_RELSZ, DT_RELCOUNT)
+    (packed_tag, packed_size_tag, sh_type) = (DT_ANDROID_REL, DT_ANDROID_RELSZ, SHT_ANDROID_REL)
+  else:
+    sys.stderr.write('%s: no dynamic relocations to pack\n' % sys.argv[1])
+    return 1
+
+  table_vaddr = tags[table_tag]
+  table_size = tags[size_tag]
+  # Some static linkers make DT_RELASZ cover the PLT relocations too.
+  if DT_JMPREL in tags and table_vaddr <= tags[DT_JMPREL] < table_vaddr + table_size:
+    table_size = tags[DT_JMPREL] - table_vaddr
+
+  bits = 8 * elf.wordsize
+  entry_format = '<' + elf.word * (3 if is_rela else 2)
+  entry_size = struct.calcsize(entry_format)
+  table_offset = elf.vaddr_to_offset(table_vaddr)
+  relocs = []
+  for i in range(table_size // entry_size):
+    fields = struct.unpack_from(entry_format, elf.data, table_offset + i * entry_size)
+    relocs.append((fields[0], fields[1], fields[2] if is_rela else 0))
+
+  packed = encode(relocs, is_rela, bits)
+  if len(packed) >= table_size:
+    sys.stderr.write('%s: packing would not save any space\n' % sys.argv[1])
+    return 1
+
+  elf.data[table_offset:table_offset + len(packed)] = packed
+  elf.data[table_offset + len(packed):table_offset + table_size] = \
+      bytearray(table_size - len(packed))
+
+  new_dynamic = []
+  for (tag, val) in dynamic:
+    if tag == table_tag:
+      new_dynamic.append((packed_tag, val))
+    elif tag == size_tag:
+      new_dynamic.append((packed_size_tag, len(packed)))
+    elif tag == count_tag:
+      continue
+    else:
+      new_dynamic.append((tag, val))
+  elf.write_dynamic(new_dynamic)
+
+  shdr = elf.find_section(table_offset)
+  if shdr is not None:
+    elf.update_section(shdr, sh_type, len(packed))
+
+  with open(sys.argv[2], 'wb') as f:
+    f.write(elf.data)
+
+  sys.stdout.write('%s: packed %d relocations from %d to %d bytes\n' %
+                   (sys.argv[1], len(relocs), table_size, len(packed)))
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
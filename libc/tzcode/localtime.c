@@ -145,7 +145,8 @@ struct rule {
 
 /* NOTE: all internal functions assume that _tzLock() was already called */
 
-static int __bionic_open_tzdata(const char*, int*);
+static const char * __bionic_find_tzdata(const char*, int*);
+static int __bionic_tzload_cached_locked(const char*, struct state*, int);
 static int_fast32_t detzcode(const char * codep);
 static int_fast64_t detzcode64(const char * codep);
 static int      differ_by_repeat(time_t t1, time_t t0);
@@ -216,6 +217,58 @@ static char lcl_TZname[TZ_STRLEN_MAX + 1];
 static int  lcl_is_set;
 static int  gmt_is_set;
 
+// BEGIN android-added: lock-free localtime_r.
+//
+// The zone in lclptr, and the lcl_TZname and lcl_is_set that say which zone
+// it is, only change in tz_publish, with the lock held and tz_sequence odd.
+// localtime_r reads them without the lock and only keeps its answer if
+// tz_sequence was even and the same before and after; otherwise it goes
+// round again with the lock. A reader that races with tz_publish can see a
+// mix of two whole zones but never a half-loaded one, so all its indexes stay
+// in bounds.
+//
+// When the zone came from persist.sys.timezone, tz_property_serial is that
+// property's serial at the time, so readers don't have to reread its value.
+#include <stdatomic.h>
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h> // For __system_property_serial.
+static atomic_uint tz_sequence;
+static atomic_int tz_from_property;
+static atomic_uint tz_property_serial;
+static const prop_info* _Atomic tz_property;
+
+static struct state* tz_scratch_state(void) {
+    return calloc(1, sizeof(struct state));
+}
+
+static void tz_publish(const struct state* sp, const char* name,
+                       int from_property, unsigned int property_serial) {
+#ifdef ALL_STATE
+    if (lclptr == NULL) {
+        lclptr = malloc(sizeof *lclptr);
+        if (lclptr == NULL)
+            return;
+    }
+#endif /* defined ALL_STATE */
+    unsigned int sequence = atomic_load_explicit(&tz_sequence, memory_order_relaxed);
+    atomic_store_explicit(&tz_sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    *lclptr = *sp;
+    if (name == NULL) {
+        lcl_is_set = -1;
+    } else {
+        lcl_is_set = strlen(name) < sizeof lcl_TZname;
+        if (lcl_is_set)
+            (void) strcpy(lcl_TZname, name);
+    }
+    atomic_store_explicit(&tz_from_property, from_property, memory_order_relaxed);
+    atomic_store_explicit(&tz_property_serial, property_serial, memory_order_relaxed);
+
+    atomic_store_explicit(&tz_sequence, sequence + 2, memory_order_release);
+}
+// END android-added
+
 char * tzname[2] = {
     (char *) wildabbr,
     (char *) wildabbr
@@ -344,7 +397,6 @@ tzload(register const char* name, register struct state* const sp,
 {
     register const char * p;
     register int          i;
-    register int          fid;
     register int          stored;
     register int          nread;
     typedef union {
@@ -392,13 +444,14 @@ tzload(register const char* name, register struct state* const sp,
     }
 
     int toread;
-    fid = __bionic_open_tzdata(name, &toread);
-    if (fid < 0)
+    const char* zone_data = __bionic_find_tzdata(name, &toread);
+    if (zone_data == NULL)
         goto oops;
 
-    nread = read(fid, up->buf, sizeof up->buf);
-    if (close(fid) < 0 || nread <= 0)
+    nread = (toread < (int) sizeof up->buf) ? toread : (int) sizeof up->buf;
+    if (nread <= 0)
         goto oops;
+    memcpy(up->buf, zone_data, nread);
     for (stored = 4; stored <= 8; stored *= 2) {
         int ttisstdcnt;
         int ttisgmtcnt;
@@ -1195,24 +1248,21 @@ tzsetwall(void)
 {
     if (lcl_is_set < 0)
         return;
-    lcl_is_set = -1;
 
-#ifdef ALL_STATE
-    if (lclptr == NULL) {
-        lclptr = malloc(sizeof *lclptr);
-        if (lclptr == NULL) {
-            settzname();    /* all we can do */
-            return;
-        }
+    // BEGIN android-changed: load into scratch space and publish (see tz_publish).
+    struct state* sp = tz_scratch_state();
+    if (sp == NULL) {
+        settzname();    /* all we can do */
+        return;
     }
-#endif /* defined ALL_STATE */
-    if (tzload(NULL, lclptr, TRUE) != 0)
-        gmtload(lclptr);
+    if (tzload(NULL, sp, TRUE) != 0)
+        gmtload(sp);
+    tz_publish(sp, NULL, FALSE, 0);
+    free(sp);
+    // END android-changed
     settzname();
 }
 
-#include <sys/system_properties.h> // For __system_property_get.
-
 static void
 tzset_locked(void)
 {
@@ -1221,9 +1271,23 @@ tzset_locked(void)
     name = getenv("TZ");
 
     // try the "persist.sys.timezone" system property first
+    // android-changed: remember its serial, so localtime_r can tell it hasn't changed.
     static char buf[PROP_VALUE_MAX];
-    if (name == NULL && __system_property_get("persist.sys.timezone", buf) > 0) {
-        name = buf;
+    int from_property = FALSE;
+    unsigned int property_serial = 0;
+    if (name == NULL) {
+        const prop_info* pi = atomic_load_explicit(&tz_property, memory_order_relaxed);
+        if (pi == NULL) {
+            pi = __system_property_find("persist.sys.timezone");
+            atomic_store_explicit(&tz_property, pi, memory_order_relaxed);
+        }
+        if (pi != NULL) {
+            property_serial = __system_property_serial(pi);
+            if (__system_property_read(pi, NULL, buf) > 0) {
+                name = buf;
+                from_property = TRUE;
+            }
+        }
     }
 
     if (name == NULL) {
@@ -1231,35 +1295,36 @@ tzset_locked(void)
         return;
     }
 
-    if (lcl_is_set > 0 && strcmp(lcl_TZname, name) == 0)
+    if (lcl_is_set > 0 && strcmp(lcl_TZname, name) == 0) {
+        // android-added: the zone hasn't changed, so it goes with this serial too.
+        atomic_store_explicit(&tz_from_property, from_property, memory_order_relaxed);
+        atomic_store_explicit(&tz_property_serial, property_serial, memory_order_relaxed);
         return;
-    lcl_is_set = strlen(name) < sizeof lcl_TZname;
-    if (lcl_is_set)
-        (void) strcpy(lcl_TZname, name);
+    }
 
-#ifdef ALL_STATE
-    if (lclptr == NULL) {
-        lclptr = malloc(sizeof *lclptr);
-        if (lclptr == NULL) {
-            settzname();    /* all we can do */
-            return;
-        }
+    // BEGIN android-changed: load into scratch space and publish (see tz_publish).
+    struct state* sp = tz_scratch_state();
+    if (sp == NULL) {
+        settzname();    /* all we can do */
+        return;
     }
-#endif /* defined ALL_STATE */
     if (*name == '\0') {
         /*
         ** User wants it fast rather than right.
         */
-        lclptr->leapcnt = 0;        /* so, we're off a little */
-        lclptr->timecnt = 0;
-        lclptr->typecnt = 0;
-        lclptr->ttis[0].tt_isdst = 0;
-        lclptr->ttis[0].tt_gmtoff = 0;
-        lclptr->ttis[0].tt_abbrind = 0;
-        (void) strcpy(lclptr->chars, gmt);
-    } else if (tzload(name, lclptr, TRUE) != 0)
-        if (name[0] == ':' || tzparse(name, lclptr, FALSE) != 0)
-            (void) gmtload(lclptr);
+        sp->leapcnt = 0;        /* so, we're off a little */
+        sp->timecnt = 0;
+        sp->typecnt = 0;
+        sp->ttis[0].tt_isdst = 0;
+        sp->ttis[0].tt_gmtoff = 0;
+        sp->ttis[0].tt_abbrind = 0;
+        (void) strcpy(sp->chars, gmt);
+    } else if (__bionic_tzload_cached_locked(name, sp, TRUE) != 0)
+        if (name[0] == ':' || tzparse(name, sp, FALSE) != 0)
+            (void) gmtload(sp);
+    tz_publish(sp, name, from_property, property_serial);
+    free(sp);
+    // END android-changed
     settzname();
 }
 
@@ -1280,12 +1345,77 @@ tzset(void)
 ** The unused offset argument is for the benefit of mktime variants.
 */
 
+// BEGIN android-added: localsub in pieces, for localtime_r's fast path.
+
+/*
+** The ttinfo index for t, outside the goback and goahead cases, and optionally
+** the interval [*startp, *endp) over which that doesn't change.
+*/
+static int
+localsub_type(const struct state * const sp, const time_t t,
+              time_t * const startp, time_t * const endp)
+{
+    time_t start = time_t_min;
+    time_t end = time_t_max;
+    int i;
+
+    if (sp->timecnt == 0 || t < sp->ats[0]) {
+        i = sp->defaulttype;
+        if (sp->timecnt != 0)
+            end = sp->ats[0];
+    } else {
+        register int lo = 1;
+        register int hi = sp->timecnt;
+
+        while (lo < hi) {
+            register int    mid = (lo + hi) >> 1;
+
+            if (t < sp->ats[mid])
+                hi = mid;
+            else    lo = mid + 1;
+        }
+        i = (int) sp->types[lo - 1];
+        start = sp->ats[lo - 1];
+        if (lo < sp->timecnt)
+            end = sp->ats[lo];
+    }
+    if (startp != NULL) {
+        *startp = start;
+        *endp = end;
+    }
+    return i;
+}
+
+static struct tm *
+localsub_finish(const time_t * const timep, struct tm * const tmp,
+                const struct state * const sp, const int i)
+{
+    register const struct ttinfo * ttisp;
+    register struct tm * result;
+
+    ttisp = &sp->ttis[i];
+    /*
+    ** To get (wrong) behavior that's compatible with System V Release 2.0
+    ** you'd replace the statement below with
+    **  t += ttisp->tt_gmtoff;
+    **  timesub(&t, 0L, sp, tmp);
+    */
+    result = timesub(timep, ttisp->tt_gmtoff, sp, tmp);
+    tmp->tm_isdst = ttisp->tt_isdst;
+    tzname[tmp->tm_isdst] = (char *) &sp->chars[ttisp->tt_abbrind];
+#ifdef TM_ZONE
+    tmp->TM_ZONE = &sp->chars[ttisp->tt_abbrind];
+#endif /* defined TM_ZONE */
+    return result;
+}
+
+// END android-added
+
 /*ARGSUSED*/
 static struct tm *
 localsub(const time_t * const timep, const int_fast32_t offset,
          struct tm * const tmp, struct state * sp) // android-changed: added sp.
 {
-    register const struct ttinfo * ttisp;
     register int         i;
     register struct tm * result;
     const time_t         t = *timep;
@@ -1329,35 +1459,8 @@ localsub(const time_t * const timep, const int_fast32_t offset,
             }
             return result;
     }
-    if (sp->timecnt == 0 || t < sp->ats[0]) {
-        i = sp->defaulttype;
-    } else {
-        register int lo = 1;
-        register int hi = sp->timecnt;
-
-        while (lo < hi) {
-            register int    mid = (lo + hi) >> 1;
-
-            if (t < sp->ats[mid])
-                hi = mid;
-            else    lo = mid + 1;
-        }
-        i = (int) sp->types[lo - 1];
-    }
-    ttisp = &sp->ttis[i];
-    /*
-    ** To get (wrong) behavior that's compatible with System V Release 2.0
-    ** you'd replace the statement below with
-    **  t += ttisp->tt_gmtoff;
-    **  timesub(&t, 0L, sp, tmp);
-    */
-    result = timesub(&t, ttisp->tt_gmtoff, sp, tmp);
-    tmp->tm_isdst = ttisp->tt_isdst;
-    tzname[tmp->tm_isdst] = &sp->chars[ttisp->tt_abbrind];
-#ifdef TM_ZONE
-    tmp->TM_ZONE = &sp->chars[ttisp->tt_abbrind];
-#endif /* defined TM_ZONE */
-    return result;
+    i = localsub_type(sp, t, NULL, NULL); // android-changed: moved into localsub_type.
+    return localsub_finish(timep, tmp, sp, i); // android-changed: moved into localsub_finish.
 }
 
 struct tm *
@@ -1370,11 +1473,101 @@ localtime(const time_t * const timep)
 ** Re-entrant version of localtime.
 */
 
+// BEGIN android-added: lock-free localtime_r (see tz_sequence).
+
+// Each thread remembers the last transition interval it looked up, so a run
+// of nearby timestamps doesn't repeat the binary search.
+struct tz_thread_cache {
+    unsigned int sequence;
+    time_t start;
+    time_t end;
+    int type;
+};
+
+static pthread_key_t tz_thread_cache_key;
+static pthread_once_t tz_thread_cache_once = PTHREAD_ONCE_INIT;
+
+static void tz_thread_cache_key_init(void) {
+    pthread_key_create(&tz_thread_cache_key, free);
+}
+
+static struct tz_thread_cache* tz_thread_cache_get(void) {
+    pthread_once(&tz_thread_cache_once, tz_thread_cache_key_init);
+    struct tz_thread_cache* cache = pthread_getspecific(tz_thread_cache_key);
+    if (cache == NULL) {
+        cache = calloc(1, sizeof(*cache));
+        if (cache != NULL)
+            pthread_setspecific(tz_thread_cache_key, cache);
+    }
+    return cache;
+}
+
+// Returns FALSE if the caller has to take the lock and call tzset_locked.
+static int localtime_r_unlocked(const time_t* const timep, struct tm* tmp,
+                                struct tm** resultp) {
+    unsigned int sequence = atomic_load_explicit(&tz_sequence, memory_order_acquire);
+    if ((sequence & 1) != 0)
+        return FALSE;
+
+    // Is the zone we have still the one tzset_locked would choose?
+    const char* name = getenv("TZ");
+    if (name != NULL) {
+        if (lcl_is_set <= 0 || strcmp(lcl_TZname, name) != 0)
+            return FALSE;
+    } else {
+        const prop_info* pi = atomic_load_explicit(&tz_property, memory_order_relaxed);
+        if (pi == NULL || lcl_is_set <= 0 ||
+            !atomic_load_explicit(&tz_from_property, memory_order_relaxed) ||
+            __system_property_serial(pi) !=
+                atomic_load_explicit(&tz_property_serial, memory_order_relaxed))
+            return FALSE;
+    }
+
+    const struct state* sp = lclptr;
+    const time_t t = *timep;
+    struct tz_thread_cache* cache = tz_thread_cache_get();
+    struct tm* result;
+    time_t start = 0;
+    time_t end = 0;
+    int type = -1;
+    if ((sp->goback && t < sp->ats[0]) ||
+        (sp->goahead && t > sp->ats[sp->timecnt - 1])) {
+        result = localsub(timep, 0L, tmp, (struct state*) sp);
+    } else {
+        if (cache != NULL && cache->sequence == sequence &&
+            t >= cache->start && t < cache->end) {
+            type = cache->type;
+        } else {
+            type = localsub_type(sp, t, &start, &end);
+        }
+        result = localsub_finish(timep, tmp, sp, type);
+    }
+
+    // Did tz_publish change anything while we were reading?
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&tz_sequence, memory_order_relaxed) != sequence)
+        return FALSE;
+    if (cache != NULL && start != end) {
+        cache->sequence = sequence;
+        cache->start = start;
+        cache->end = end;
+        cache->type = type;
+    }
+    *resultp = result;
+    return TRUE;
+}
+
+// END android-added
+
 struct tm *
 localtime_r(const time_t * const timep, struct tm * tmp)
 {
     struct tm* result;
 
+    // android-added: without the lock if nothing has changed.
+    if (localtime_r_unlocked(timep, tmp, &result))
+        return result;
+
     _tzLock();
     tzset_locked();
     result = localsub(timep, 0L, tmp, NULL); // android-changed: extra parameter.
@@ -1709,6 +1902,111 @@ tmcomp(register const struct tm * const atmp,
     return result;
 }
 
+// BEGIN android-added: mktime without the binary search.
+
+/*
+** Days from 1970-01-01 to the given proleptic Gregorian date, where year is
+** an actual year number, mon is in [0, 11] and mday is within the month.
+*/
+static int_fast64_t
+days_from_civil(int_fast64_t year, const int mon, const int mday)
+{
+    int_fast64_t era;
+    int_fast64_t yoe;
+    int_fast64_t doy;
+
+    if (mon < 2)
+        --year;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (mon + (mon < 2 ? 10 : -2)) + 2) / 5 + mday - 1;
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+/*
+** Finds the time_t for the normalized *yourtm directly, by inverting the
+** zone's transition table: the local time, less the UT offset in force at
+** the answer. Returns FALSE, leaving time2sub to search, for local times
+** that are skipped or repeated at a transition, times beyond the table that
+** localsub handles by shifting by whole cycles of years, zones with leap
+** seconds, and anything whose answer doesn't check out.
+*/
+static int
+time2sub_direct(const struct tm * const yourtm,
+                struct tm *(*const funcp)(const time_t*, int_fast32_t, struct tm*, struct state*),
+                const int_fast32_t offset, struct state * sp, time_t * const tp)
+{
+    int_fast64_t local;
+    time_t       t;
+    time_t       start;
+    time_t       end;
+    int          i;
+    int          pass;
+    struct tm    mytm;
+
+    local = days_from_civil((int_fast64_t) yourtm->tm_year + TM_YEAR_BASE,
+                            yourtm->tm_mon, yourtm->tm_mday);
+    if (local < -(INT_FAST64_MAX / SECSPERDAY) + 1 ||
+        local > INT_FAST64_MAX / SECSPERDAY - 1)
+        return FALSE;
+    local = local * SECSPERDAY + yourtm->tm_hour * SECSPERHOUR +
+            yourtm->tm_min * SECSPERMIN + yourtm->tm_sec;
+
+    if (funcp == gmtsub) {
+        t = (time_t) (local - offset);
+        if (t != local - offset)
+            return FALSE;
+    } else if (funcp == localsub) {
+        if (sp == NULL)
+            sp = lclptr;
+        if (sp == NULL || sp->leapcnt != 0)
+            return FALSE;
+        /*
+        ** Guess with the offset in force at the local time read as UT,
+        ** then if need be with the offset in force at that guess. The
+        ** answer must lie in the interval whose offset gave it.
+        */
+        t = (time_t) local;
+        if (t != local)
+            return FALSE;
+        for (pass = 0; ; ++pass) {
+            if (pass == 2)
+                return FALSE;    /* probably a gap */
+            if ((sp->goback && t < sp->ats[0]) ||
+                (sp->goahead && t > sp->ats[sp->timecnt - 1]))
+                return FALSE;
+            i = localsub_type(sp, t, &start, &end);
+            t = (time_t) (local - sp->ttis[i].tt_gmtoff);
+            if (t != local - sp->ttis[i].tt_gmtoff)
+                return FALSE;
+            if (t >= start && t < end)
+                break;
+        }
+        if ((sp->goback && t < sp->ats[0]) ||
+            (sp->goahead && t > sp->ats[sp->timecnt - 1]))
+            return FALSE;
+        /* Would the neighbouring intervals' offsets give an answer too? */
+        if (start != time_t_min &&
+            local - sp->ttis[localsub_type(sp, start - 1, NULL, NULL)].tt_gmtoff < start)
+            return FALSE;
+        if (end != time_t_max &&
+            local - sp->ttis[localsub_type(sp, end, NULL, NULL)].tt_gmtoff >= end)
+            return FALSE;
+        /* Leave the hunt for the requested isdst to time2sub. */
+        if (yourtm->tm_isdst >= 0 && sp->ttis[i].tt_isdst != yourtm->tm_isdst)
+            return FALSE;
+    } else {
+        return FALSE;
+    }
+
+    if ((*funcp)(&t, offset, &mytm, sp) == NULL || tmcomp(&mytm, yourtm) != 0)
+        return FALSE;
+    *tp = t;
+    return TRUE;
+}
+
+// END android-added
+
 static time_t
 time2sub(struct tm * const tmp,
          struct tm *(*const funcp)(const time_t*, int_fast32_t, struct tm*, struct state*),
@@ -1794,6 +2092,9 @@ time2sub(struct tm * const tmp,
         saved_seconds = yourtm.tm_sec;
         yourtm.tm_sec = 0;
     }
+    // android-added: most local times have exactly one answer we can compute.
+    if (time2sub_direct(&yourtm, funcp, offset, sp, &t))
+        goto label;
     /*
     ** Do a binary search (this works whatever time_t's type is).
     */
@@ -2121,9 +2422,45 @@ posix2time(time_t t)
 #include <assert.h>
 #include <stdint.h>
 #include <arpa/inet.h> // For ntohl(3).
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The tzdata file, mapped once per process:
+//
+// byte[12] tzdata_version  -- "tzdata2012f\0"
+// int index_offset
+// int data_offset
+// int zonetab_offset
+// index_entry_t[] index    -- at index_offset, up to data_offset
+// byte[] data              -- at data_offset, the TZif data for each zone
+struct bionic_tzdata_header {
+  char tzdata_version[12];
+  int32_t index_offset;
+  int32_t data_offset;
+  int32_t zonetab_offset;
+};
+
+#define NAME_LENGTH 40
+struct index_entry_t {
+  char buf[NAME_LENGTH];
+  int32_t start;
+  int32_t length;
+  int32_t unused; // Was raw GMT offset; always 0 since tzdata2014f (L).
+};
+
+static const char* g_tzdata;
+static size_t g_tzdata_size;
+static const struct index_entry_t* g_tzdata_index;
+static size_t g_tzdata_id_count;
+static int32_t g_tzdata_data_offset;
+static int g_tzdata_index_sorted;
+
+static int __bionic_index_compare(const char* olson_id, const struct index_entry_t* entry) {
+  return strncmp(olson_id, entry->buf, NAME_LENGTH);
+}
 
-static int __bionic_open_tzdata_path(const char* path_prefix_variable, const char* path_suffix,
-                                     const char* olson_id, int* data_size) {
+// Returns 0 on success, -1 if the file is bad, and -2 if there's no file at all.
+static int __bionic_map_tzdata_path(const char* path_prefix_variable, const char* path_suffix) {
   const char* path_prefix = getenv(path_prefix_variable);
   if (path_prefix == NULL) {
     fprintf(stderr, "%s: %s not set!\n", __FUNCTION__, path_prefix_variable);
@@ -2136,155 +2473,185 @@ static int __bionic_open_tzdata_path(const char* path_prefix_variable, const cha
     return -1;
   }
   snprintf(path, path_length, "%s/%s", path_prefix, path_suffix);
-  int fd = TEMP_FAILURE_RETRY(open(path, OPEN_MODE));
+  int fd = TEMP_FAILURE_RETRY(open(path, OPEN_MODE | O_CLOEXEC));
   if (fd == -1) {
     XLOG(("%s: could not open \"%s\": %s\n", __FUNCTION__, path, strerror(errno)));
     free(path);
     return -2; // Distinguish failure to find any data from failure to find a specific id.
   }
 
-  // byte[12] tzdata_version  -- "tzdata2012f\0"
-  // int index_offset
-  // int data_offset
-  // int zonetab_offset
-  struct bionic_tzdata_header {
-    char tzdata_version[12];
-    int32_t index_offset;
-    int32_t data_offset;
-    int32_t zonetab_offset;
-  } header;
-  memset(&header, 0, sizeof(header));
-  ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, &header, sizeof(header)));
-  if (bytes_read != sizeof(header)) {
-    fprintf(stderr, "%s: could not read header of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    fprintf(stderr, "%s: could not stat \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
     free(path);
     close(fd);
     return -1;
   }
-
-  if (strncmp(header.tzdata_version, "tzdata", 6) != 0 || header.tzdata_version[11] != 0) {
-    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n",
-            __FUNCTION__, path, header.tzdata_version);
+  size_t size = sb.st_size;
+  if (size < sizeof(struct bionic_tzdata_header)) {
+    fprintf(stderr, "%s: could not read header of \"%s\": short file\n", __FUNCTION__, path);
     free(path);
     close(fd);
     return -1;
   }
-
-#if 0
-  fprintf(stderr, "version: %s\n", header.tzdata_version);
-  fprintf(stderr, "index_offset = %d\n", ntohl(header.index_offset));
-  fprintf(stderr, "data_offset = %d\n", ntohl(header.data_offset));
-  fprintf(stderr, "zonetab_offset = %d\n", ntohl(header.zonetab_offset));
-#endif
-
-  if (TEMP_FAILURE_RETRY(lseek(fd, ntohl(header.index_offset), SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: couldn't seek to index in \"%s\": %s\n",
-            __FUNCTION__, path, strerror(errno));
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "%s: could not map \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
     free(path);
-    close(fd);
     return -1;
   }
 
-  off_t specific_zone_offset = -1;
-  ssize_t index_size = ntohl(header.data_offset) - ntohl(header.index_offset);
-  char* index = malloc(index_size);
-  if (index == NULL) {
-    fprintf(stderr, "%s: couldn't allocate %zd-byte index for \"%s\"\n",
-            __FUNCTION__, index_size, path);
+  const struct bionic_tzdata_header* header = (const struct bionic_tzdata_header*) map;
+  if (strncmp(header->tzdata_version, "tzdata", 6) != 0 || header->tzdata_version[11] != 0) {
+    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n",
+            __FUNCTION__, path, header->tzdata_version);
     free(path);
-    close(fd);
+    munmap(map, size);
     return -1;
   }
-  if (TEMP_FAILURE_RETRY(read(fd, index, index_size)) != index_size) {
-    fprintf(stderr, "%s: could not read index of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
+
+  uint32_t index_offset = ntohl(header->index_offset);
+  uint32_t data_offset = ntohl(header->data_offset);
+  if (index_offset > data_offset || data_offset > size) {
+    fprintf(stderr, "%s: bad index in \"%s\"\n", __FUNCTION__, path);
     free(path);
-    free(index);
-    close(fd);
+    munmap(map, size);
     return -1;
   }
+  free(path);
 
-  static const size_t NAME_LENGTH = 40;
-  struct index_entry_t {
-    char buf[NAME_LENGTH];
-    int32_t start;
-    int32_t length;
-    int32_t unused; // Was raw GMT offset; always 0 since tzdata2014f (L).
-  };
-
-  size_t id_count = (ntohl(header.data_offset) - ntohl(header.index_offset)) / sizeof(struct index_entry_t);
-  struct index_entry_t* entry = (struct index_entry_t*) index;
-  for (size_t i = 0; i < id_count; ++i) {
-    char this_id[NAME_LENGTH + 1];
-    memcpy(this_id, entry->buf, NAME_LENGTH);
-    this_id[NAME_LENGTH] = '\0';
-
-    if (strcmp(this_id, olson_id) == 0) {
-      specific_zone_offset = ntohl(entry->start) + ntohl(header.data_offset);
-      *data_size = ntohl(entry->length);
+  g_tzdata = (const char*) map;
+  g_tzdata_size = size;
+  g_tzdata_index = (const struct index_entry_t*) (g_tzdata + index_offset);
+  g_tzdata_id_count = (data_offset - index_offset) / sizeof(struct index_entry_t);
+  g_tzdata_data_offset = data_offset;
+
+  // ZoneCompactor writes the index in order, but don't rely on that.
+  g_tzdata_index_sorted = 1;
+  for (size_t i = 1; i < g_tzdata_id_count; ++i) {
+    if (__bionic_index_compare(g_tzdata_index[i].buf, &g_tzdata_index[i - 1]) <= 0) {
+      g_tzdata_index_sorted = 0;
       break;
     }
+  }
+  return 0;
+}
+
+// Returns the TZif data for 'olson_id' within the mapped tzdata, or NULL.
+static const char* __bionic_find_tzdata(const char* olson_id, int* data_size) {
+  if (g_tzdata == NULL) {
+    int rc = __bionic_map_tzdata_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata");
+    if (rc == -2) {
+      // The first thing that 'recovery' does is try to format the current time. It doesn't have
+      // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
+      fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
+    }
+    if (rc != 0) {
+      return NULL;
+    }
+  }
 
-    ++entry;
+  // Longer names can't be in the index; shorter ones are NUL-padded there.
+  if (strlen(olson_id) > NAME_LENGTH) {
+    return NULL;
   }
-  free(index);
 
-  if (specific_zone_offset == -1) {
+  const struct index_entry_t* entry = NULL;
+  if (g_tzdata_index_sorted) {
+    size_t lo = 0;
+    size_t hi = g_tzdata_id_count;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      int cmp = __bionic_index_compare(olson_id, &g_tzdata_index[mid]);
+      if (cmp == 0) {
+        entry = &g_tzdata_index[mid];
+        break;
+      }
+      if (cmp < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+  } else {
+    for (size_t i = 0; i < g_tzdata_id_count; ++i) {
+      if (__bionic_index_compare(olson_id, &g_tzdata_index[i]) == 0) {
+        entry = &g_tzdata_index[i];
+        break;
+      }
+    }
+  }
+  if (entry == NULL) {
     XLOG(("%s: couldn't find zone \"%s\"\n", __FUNCTION__, olson_id));
-    free(path);
-    close(fd);
-    return -1;
+    return NULL;
   }
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, specific_zone_offset, SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: could not seek to %ld in \"%s\": %s\n",
-            __FUNCTION__, specific_zone_offset, path, strerror(errno));
-    free(path);
-    close(fd);
-    return -1;
+  size_t start = (size_t) g_tzdata_data_offset + ntohl(entry->start);
+  size_t length = ntohl(entry->length);
+  if (start > g_tzdata_size || length > g_tzdata_size - start) {
+    fprintf(stderr, "%s: bad index entry for \"%s\"\n", __FUNCTION__, olson_id);
+    return NULL;
   }
 
   // TODO: check that there's TZ_MAGIC at this offset, so we can fall back to the other file if not.
-
-  free(path);
-  return fd;
+  *data_size = length;
+  return g_tzdata + start;
 }
 
-static int __bionic_open_tzdata(const char* olson_id, int* data_size) {
-  int fd = __bionic_open_tzdata_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata", olson_id, data_size);
-  if (fd == -2) {
-    // The first thing that 'recovery' does is try to format the current time. It doesn't have
-    // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
-    fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
-  }
-  return fd;
-}
+// Caches the most recently used time zones (http://b/8270865), so switching
+// between a few of them doesn't reparse their data each time.
+#define TZ_CACHE_SIZE 8
 
-// Caches the most recent timezone (http://b/8270865).
-static int __bionic_tzload_cached(const char* name, struct state* const sp, const int doextend) {
-  _tzLock();
-
-  // Our single-item cache.
-  static char* g_cached_time_zone_name;
-  static struct state g_cached_time_zone;
+struct tz_cache_entry {
+  char* name;
+  int doextend;
+  unsigned last_used;
+  struct state* st;
+};
 
-  // Do we already have this timezone cached?
-  if (g_cached_time_zone_name != NULL && strcmp(name, g_cached_time_zone_name) == 0) {
-    *sp = g_cached_time_zone;
-    _tzUnlock();
-    return 0;
+static int __bionic_tzload_cached_locked(const char* name, struct state* const sp, const int doextend) {
+  static struct tz_cache_entry g_tz_cache[TZ_CACHE_SIZE];
+  static unsigned g_tz_cache_clock;
+
+  // Do we already have this time zone cached?
+  struct tz_cache_entry* victim = &g_tz_cache[0];
+  for (size_t i = 0; i < TZ_CACHE_SIZE; ++i) {
+    struct tz_cache_entry* entry = &g_tz_cache[i];
+    if (entry->name != NULL && entry->doextend == doextend && strcmp(name, entry->name) == 0) {
+      entry->last_used = ++g_tz_cache_clock;
+      *sp = *entry->st;
+      return 0;
+    }
+    if (entry->last_used < victim->last_used) {
+      victim = entry;
+    }
   }
 
   // Can we load it?
   int rc = tzload(name, sp, doextend);
   if (rc == 0) {
-    // Update the cache.
-    free(g_cached_time_zone_name);
-    g_cached_time_zone_name = strdup(name);
-    g_cached_time_zone = *sp;
+    // Update the cache, replacing the least recently used entry.
+    if (victim->st == NULL) {
+      victim->st = malloc(sizeof(*victim->st));
+    }
+    char* name_copy = strdup(name);
+    if (victim->st != NULL && name_copy != NULL) {
+      free(victim->name);
+      victim->name = name_copy;
+      victim->doextend = doextend;
+      victim->last_used = ++g_tz_cache_clock;
+      *victim->st = *sp;
+    } else {
+      free(name_copy);
+    }
   }
+  return rc;
+}
 
+static int __bionic_tzload_cached(const char* name, struct state* const sp, const int doextend) {
+  _tzLock();
+  int rc = __bionic_tzload_cached_locked(name, sp, doextend);
   _tzUnlock();
   return rc;
 }
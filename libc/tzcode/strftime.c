@@ -640,16 +640,66 @@ label:
     return pt;
 }
 
+// BEGIN android-changed: format the number ourselves rather than with snprintf.
+// Every format passed here is "%d" with an optional '0' flag and a one-digit
+// width, so digits go out two at a time from a table.
+
+static const char conv_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 static char *
 _conv(const int n, const char *const format, char *const pt,
         const char *const ptlim)
 {
-    char    buf[INT_STRLEN_MAXIMUM(int) + 1];
+    char    buf[INT_STRLEN_MAXIMUM(int) + 1 + 10];
+    char *  p = buf + sizeof(buf) - 1;
+    const char * f = format + 1;
+    char    pad = ' ';
+    int     width = 0;
+    unsigned int u = (n < 0) ? -(unsigned int) n : (unsigned int) n;
+
+    if (*f == '0') {
+        pad = '0';
+        ++f;
+    }
+    if (*f >= '1' && *f <= '9')
+        width = *f - '0';
 
-    (void) snprintf(buf, sizeof(buf), format, n);
-    return _add(buf, pt, ptlim, 0);
+    *p = '\0';
+    while (u >= 10) {
+        p -= 2;
+        memcpy(p, &conv_digit_pairs[2 * (u % 100)], 2);
+        u /= 100;
+    }
+    if (u != 0 || p == buf + sizeof(buf) - 1)
+        *--p = '0' + u;
+
+    width -= (buf + sizeof(buf) - 1 - p) + (n < 0);
+    if (pad == '0') {
+        while (width-- > 0)
+            *--p = '0';
+        if (n < 0)
+            *--p = '-';
+    } else {
+        if (n < 0)
+            *--p = '-';
+        while (width-- > 0)
+            *--p = ' ';
+    }
+    return _add(p, pt, ptlim, 0);
 }
 
+// END android-changed
+
 static char *
 _add(const char *str, char *pt, const char *const ptlim, int modifier)
 {
@@ -96,12 +96,21 @@ struct century_relyear {
 static  int _conv_num(const unsigned char **, int *, int, int);
 static  unsigned char *_strptime(const unsigned char *, const char *, struct tm *,
         struct century_relyear *);
+static  const unsigned char *_strptime_iso8601(const unsigned char *, const char *,
+        struct tm *);
 
 
 char *
 strptime(const char *buf, const char *fmt, struct tm *tm)
 {
     struct century_relyear cr;
+    const unsigned char *end;
+
+    /* android-added: the common ISO 8601 formats without the general parser. */
+    end = _strptime_iso8601((const unsigned char*)buf, fmt, tm);
+    if (end != NULL)
+        return (char*)end;
+
     cr.century = TM_YEAR_BASE;
     cr.relyear = -1;
     return (char*)(_strptime((const unsigned char*)buf, fmt, tm, &cr));
@@ -430,3 +439,53 @@ _conv_num(const unsigned char **buf, int *dest, int llim, int ulim)
     *dest = result;
     return (1);
 }
+
+/*
+ * android-added: "%Y-%m-%dT%H:%M:%S" and "%Y-%m-%d %H:%M:%S", for input with
+ * every field at its full width. Returns NULL for anything else, including
+ * out-of-range fields, and leaves it to _strptime to parse or reject, so the
+ * results are always the same as _strptime's.
+ */
+static int
+_iso8601_num(const unsigned char *bp, int digits, int llim, int ulim)
+{
+    int result = 0;
+
+    while (digits-- > 0) {
+        if (*bp < '0' || *bp > '9')
+            return (-1);
+        result = result * 10 + (*bp++ - '0');
+    }
+    return ((result < llim || result > ulim) ? -1 : result);
+}
+
+static const unsigned char *
+_strptime_iso8601(const unsigned char *bp, const char *fmt, struct tm *tm)
+{
+    unsigned char sep;
+    int year, mon, mday, hour, min, sec;
+
+    if (strcmp(fmt, "%Y-%m-%dT%H:%M:%S") == 0)
+        sep = 'T';
+    else if (strcmp(fmt, "%Y-%m-%d %H:%M:%S") == 0)
+        sep = ' ';
+    else
+        return (NULL);
+
+    /* "YYYY-MM-DDxHH:MM:SS", checked in order so we never read past a NUL. */
+    if ((year = _iso8601_num(bp, 4, 0, 9999)) < 0 || bp[4] != '-' ||
+        (mon = _iso8601_num(bp + 5, 2, 1, 12)) < 0 || bp[7] != '-' ||
+        (mday = _iso8601_num(bp + 8, 2, 1, 31)) < 0 || bp[10] != sep ||
+        (hour = _iso8601_num(bp + 11, 2, 0, 23)) < 0 || bp[13] != ':' ||
+        (min = _iso8601_num(bp + 14, 2, 0, 59)) < 0 || bp[16] != ':' ||
+        (sec = _iso8601_num(bp + 17, 2, 0, 61)) < 0)
+        return (NULL);
+
+    tm->tm_year = year - TM_YEAR_BASE;
+    tm->tm_mon = mon - 1;
+    tm->tm_mday = mday;
+    tm->tm_hour = hour;
+    tm->tm_min = min;
+    tm->tm_sec = sec;
+    return (bp + 19);
+}
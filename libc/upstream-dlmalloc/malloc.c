@@ -3094,7 +3094,9 @@ static size_t traverse_and_check(mstate m);
 #if LOCK_AT_FORK
 static void pre_fork(void)         { ACQUIRE_LOCK(&(gm)->mutex); }
 static void post_fork_parent(void) { RELEASE_LOCK(&(gm)->mutex); }
-static void post_fork_child(void)  { INITIAL_LOCK(&(gm)->mutex); }
+/* BEGIN android-changed: start the heap afresh for M_SEGREGATE_ON_FORK */
+static void post_fork_child(void)  { INITIAL_LOCK(&(gm)->mutex); segregate_heap_after_fork(); }
+/* END android-changed */
 #endif /* LOCK_AT_FORK */
 
 /* Initialize mparams */
@@ -37,6 +37,9 @@
 #define __sleep sleep
 #define __usleep usleep
 
+/* bionic's realpath (see bionic/realpath.cpp) falls back to FreeBSD's. */
+#define realpath __freebsd_realpath
+
 /* Redirect internal C library calls to the public function. */
 #define _close close
 #define _fcntl fcntl
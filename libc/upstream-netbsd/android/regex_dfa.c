@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "../lib/libc/regex/utils.h"
+#include "../lib/libc/regex/regex2.h"
+
+/*
+ * The DFA cache behind the engine's dfast(). A DFA state is a set of the
+ * engine's states, in whichever representation its matcher uses, plus the
+ * kind of character that led to it when the strip has anchors or word
+ * boundaries that care. Its transitions are indexed by character class:
+ * the strip's own categories, split further by the kinds. States are only
+ * made as matching reaches them, and are all thrown away when they use too
+ * much memory, so patterns whose DFA would blow up still work, just at the
+ * engine's usual speed.
+ *
+ * A regexec takes the cache with a trylock; one that finds it busy just
+ * runs the engine without it.
+ */
+
+/* Throw the states away rather than use more than this. */
+#define	DFA_MAX_MEMORY	(256 * 1024)
+
+struct re_dfa_state __regex_dfa_match;
+
+/* Does the strip have anything that looks at the characters either side? */
+static int
+uses_context(struct re_guts *g)
+{
+	sopno pc;
+
+	for (pc = g->firststate; pc < g->laststate; pc++) {
+		switch (OP(g->strip[pc])) {
+		case OBOL:
+		case OEOL:
+		case OBOW:
+		case OEOW:
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Find the literal that every match starts with, if any. */
+static int
+find_prefix(struct re_dfa *dfa, struct re_guts *g)
+{
+	sopno pc;
+	size_t n = 0;
+
+	dfa->prefix = malloc((size_t)g->nstates + 1);
+	if (dfa->prefix == NULL)
+		return 0;
+	for (pc = g->firststate + 1; pc < g->laststate; pc++) {
+		sop s = g->strip[pc];
+		if (OP(s) == OCHAR)
+			dfa->prefix[n++] = (char)OPND(s);
+		else if (OP(s) != OLPAREN && OP(s) != ORPAREN)
+			break;
+	}
+	dfa->prefixlen = n;
+	return 1;
+}
+
+struct re_dfa *
+__regex_dfa_create(struct re_guts *g)
+{
+	struct re_dfa *dfa;
+	unsigned short ids[NC * 4];
+	int context;
+	int c;
+
+	if (g->backrefs)
+		return NULL;
+	dfa = calloc(1, sizeof(*dfa));
+	if (dfa == NULL)
+		return NULL;
+
+	/*
+	 * Without anchors or word boundaries, the characters either side of
+	 * a position don't matter, and characters only need telling apart
+	 * when the strip does.
+	 */
+	context = uses_context(g);
+	memset(ids, 0, sizeof(ids));
+	for (c = CHAR_MIN; c <= CHAR_MAX; c++) {
+		size_t id = (size_t)g->categories[c] * 4;
+		int kind = DFA_KIND_OTHER;
+
+		if (context) {
+			if (c == '\n' && (g->cflags&REG_NEWLINE))
+				kind = DFA_KIND_NEWLINE;
+			else if (ISWORD(c))
+				kind = DFA_KIND_WORD;
+		}
+		id += kind;
+		if (ids[id] == 0) {
+			ids[id] = (unsigned short)++dfa->nclasses;
+			dfa->kinds[dfa->nclasses - 1] = (uch)kind;
+		}
+		dfa->classes[(uch)c] = (uch)(ids[id] - 1);
+	}
+
+	/* Skipping ahead to a prefix would lose track of the context. */
+	if (!context && !find_prefix(dfa, g)) {
+		free(dfa);
+		return NULL;
+	}
+	dfa->large = -1;
+	pthread_mutex_init(&dfa->lock, NULL);
+	return dfa;
+}
+
+static void
+flush(struct re_dfa *dfa)
+{
+	size_t i;
+
+	for (i = 0; i < dfa->nbuckets; i++) {
+		struct re_dfa_state *s = dfa->buckets[i];
+		while (s != NULL) {
+			struct re_dfa_state *link = s->link;
+			free(s);
+			s = link;
+		}
+		dfa->buckets[i] = NULL;
+	}
+	dfa->nstates = 0;
+	dfa->memory = 0;
+	dfa->generation++;
+}
+
+void
+__regex_dfa_destroy(struct re_dfa *dfa)
+{
+	if (dfa == NULL)
+		return;
+	flush(dfa);
+	free(dfa->buckets);
+	free(dfa->prefix);
+	pthread_mutex_destroy(&dfa->lock);
+	free(dfa);
+}
+
+int
+__regex_dfa_acquire(struct re_dfa *dfa, int large, size_t keylen)
+{
+	if (pthread_mutex_trylock(&dfa->lock) != 0)
+		return 0;
+	if (dfa->large == -1) {
+		dfa->large = large;
+		dfa->keylen = keylen;
+	}
+	if (dfa->large != large) {
+		/* REG_LARGE; never mind */
+		pthread_mutex_unlock(&dfa->lock);
+		return 0;
+	}
+	return 1;
+}
+
+void
+__regex_dfa_release(struct re_dfa *dfa)
+{
+	pthread_mutex_unlock(&dfa->lock);
+}
+
+static unsigned
+hash_states(const void *key, size_t len, int kind)
+{
+	const uch *p = key;
+	unsigned h = 2166136261u ^ (unsigned)kind;	/* FNV-1a */
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+static int
+grow_buckets(struct re_dfa *dfa)
+{
+	size_t nbuckets = (dfa->nbuckets == 0) ? 64 : dfa->nbuckets * 2;
+	struct re_dfa_state **buckets;
+	size_t i;
+
+	buckets = calloc(nbuckets, sizeof(*buckets));
+	if (buckets == NULL)
+		return 0;
+	for (i = 0; i < dfa->nbuckets; i++) {
+		struct re_dfa_state *s = dfa->buckets[i];
+		while (s != NULL) {
+			struct re_dfa_state *link = s->link;
+			s->link = buckets[s->hash & (nbuckets - 1)];
+			buckets[s->hash & (nbuckets - 1)] = s;
+			s = link;
+		}
+	}
+	free(dfa->buckets);
+	dfa->buckets = buckets;
+	dfa->nbuckets = nbuckets;
+	return 1;
+}
+
+/*
+ * Returns the DFA state for the given engine states reached through a
+ * character of the given kind, making it if it's new. Making one may throw
+ * all the others away, which changes the generation. Returns NULL if
+ * there's no memory for it.
+ */
+struct re_dfa_state *
+__regex_dfa_intern(struct re_dfa *dfa, const void *key, int kind, int fresh)
+{
+	unsigned h = hash_states(key, dfa->keylen, kind);
+	size_t size = sizeof(struct re_dfa_state) +
+	    (dfa->nclasses - 1) * sizeof(struct re_dfa_state *) + dfa->keylen;
+	struct re_dfa_state *s;
+
+	if (dfa->nbuckets != 0) {
+		for (s = dfa->buckets[h & (dfa->nbuckets - 1)]; s != NULL;
+		    s = s->link) {
+			if (s->hash == h && s->kind == kind &&
+			    memcmp(DFA_STATES(dfa, s), key, dfa->keylen) == 0)
+				return s;
+		}
+	}
+
+	if (dfa->memory + size > DFA_MAX_MEMORY)
+		flush(dfa);
+	if (dfa->nstates >= dfa->nbuckets && !grow_buckets(dfa))
+		return NULL;
+	s = calloc(1, size);
+	if (s == NULL)
+		return NULL;
+	s->hash = h;
+	s->kind = (uch)kind;
+	s->fresh = (uch)fresh;
+	memcpy(DFA_STATES(dfa, s), key, dfa->keylen);
+	s->link = dfa->buckets[h & (dfa->nbuckets - 1)];
+	dfa->buckets[h & (dfa->nbuckets - 1)] = s;
+	dfa->nstates++;
+	dfa->memory += size;
+	return s;
+}
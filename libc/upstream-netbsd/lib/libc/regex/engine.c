@@ -89,6 +89,9 @@
 #define	at	sat
 #define	match	smat
 #define	nope	snope
+// BEGIN android-added
+#define	dfast	sdfast
+// END android-added
 #endif
 #ifdef LNAMES
 #define	matcher	lmatcher
@@ -101,6 +104,9 @@
 #define	at	lat
 #define	match	lmat
 #define	nope	lnope
+// BEGIN android-added
+#define	dfast	ldfast
+// END android-added
 #endif
 
 /* another structure passed up and down to avoid zillions of parameters */
@@ -132,6 +138,9 @@ static const char *backref(struct match *m, const char *start, const char *stop,
 static const char *fast(struct match *m, const char *start, const char *stop, sopno startst, sopno stopst);
 static const char *slow(struct match *m, const char *start, const char *stop, sopno startst, sopno stopst);
 static states step(struct re_guts *g, sopno start, sopno stop, states bef, int ch, states aft);
+// BEGIN android-added
+static const char *dfast(struct match *m, const char *start, const char *stop, sopno startst, sopno stopst);
+// END android-added
 #define	BOL	(OUT+1)
 #define	EOL	(BOL+1)
 #define	BOLEOL	(BOL+2)
@@ -211,12 +220,10 @@ matcher(
 
 	/* prescreening; this does wonders for this rather slow code */
 	if (g->must != NULL) {
-		for (dp = start; dp < stop; dp++)
-			if (*dp == g->must[0] && (size_t)(stop - dp) >= g->mlen &&
-				memcmp(dp, g->must, g->mlen) == 0)
-				break;
-		if (dp == stop)		/* we didn't find g->must */
+		// BEGIN android-changed: memmem is much quicker than this loop.
+		if (memmem(start, (size_t)(stop - start), g->must, g->mlen) == NULL)
 			return(REG_NOMATCH);
+		// END android-changed
 	}
 
 	/* match struct setup */
@@ -236,7 +243,9 @@ matcher(
 
 	/* this loop does only one repetition except for backrefs */
 	for (;;) {
-		endp = fast(m, start, stop, gf, gl);
+		// BEGIN android-changed
+		endp = dfast(m, start, stop, gf, gl);
+		// END android-changed
 		if (endp == NULL) {		/* a miss */
 			error = REG_NOMATCH;
 			goto done;
@@ -858,6 +867,155 @@ fast(
 		return(NULL);
 }
 
+// BEGIN android-added
+/*
+ - dfast - fast(), remembering the sets of states it meets as a DFA
+ == static const char *dfast(struct match *m, const char *start, \
+ ==	const char *stop, sopno startst, sopno stopst);
+ *
+ * Each step that fast() takes is still taken here the first time, and
+ * then remembered: the next time the same set of states meets the same
+ * class of character, the cached transition is followed instead. Only
+ * the first position and the last, where the ends of the string can
+ * matter, always take the long way.
+ */
+static const char *
+dfast(
+    struct match *m,
+    const char *start,
+    const char *stop,
+    sopno startst,
+    sopno stopst)
+{
+	struct re_dfa *dfa = m->g->dfa;
+	states st = m->st;
+	states fresh = m->fresh;
+	states tmp = m->tmp;
+	const char *p = start;
+	int c = (start == m->beginp) ? OUT : *(start-1);
+	int lastc;	/* previous c */
+	int flagch;
+	size_t i;
+	const char *coldp; /* last p after which no match was underway */
+	struct re_dfa_state *d = NULL;	/* the DFA's idea of st, if known */
+	struct re_dfa_state *nd;
+	unsigned generation;
+	uch cl;
+
+	if (dfa == NULL || !__regex_dfa_acquire(dfa, STATELARGE, STATEKEYLEN))
+		return(fast(m, start, stop, startst, stopst));
+
+	CLEAR(st);
+	SET1(st, startst);
+	st = step(m->g, startst, stopst, st, NOTHING, st);
+	ASSIGN(fresh, st);
+	coldp = NULL;
+	for (;;) {
+		/* follow the DFA for as long as it knows the way */
+		if (d != NULL && p < stop) {
+			for (;;) {
+				if (d->fresh) {
+					coldp = p;
+					/* a match can't start before the prefix */
+					if (dfa->prefixlen > 0) {
+						p = memmem(p, (size_t)(stop - p),
+						    dfa->prefix, dfa->prefixlen);
+						if (p == NULL) {
+							m->coldp = coldp;
+							__regex_dfa_release(dfa);
+							return(NULL);
+						}
+						coldp = p;
+					}
+				}
+				nd = d->next[dfa->classes[(uch)*p]];
+				if (nd == NULL)
+					break;
+				if (nd == DFA_MATCH) {
+					m->coldp = coldp;
+					__regex_dfa_release(dfa);
+					return(p+1);
+				}
+				d = nd;
+				if (++p == stop)
+					break;
+			}
+			memcpy(STATEKEY(st), DFA_STATES(dfa, d), STATEKEYLEN);
+			c = *(p-1);
+		}
+
+		/* next character */
+		lastc = c;
+		c = (p == m->endp) ? OUT : *p;
+		if (EQ(st, fresh))
+			coldp = p;
+
+		/* is there an EOL and/or BOL between lastc and c? */
+		flagch = '\0';
+		i = 0;
+		if ( (lastc == '\n' && m->g->cflags&REG_NEWLINE) ||
+				(lastc == OUT && !(m->eflags&REG_NOTBOL)) ) {
+			flagch = BOL;
+			i = m->g->nbol;
+		}
+		if ( (c == '\n' && m->g->cflags&REG_NEWLINE) ||
+				(c == OUT && !(m->eflags&REG_NOTEOL)) ) {
+			flagch = (flagch == BOL) ? BOLEOL : EOL;
+			i += m->g->neol;
+		}
+		if (i != 0) {
+			for (; i > 0; i--)
+				st = step(m->g, startst, stopst, st, flagch, st);
+		}
+
+		/* how about a word boundary? */
+		if ( (flagch == BOL || (lastc != OUT && !ISWORD(lastc))) &&
+					(c != OUT && ISWORD(c)) ) {
+			flagch = BOW;
+		}
+		if ( (lastc != OUT && ISWORD(lastc)) &&
+				(flagch == EOL || (c != OUT && !ISWORD(c))) ) {
+			flagch = EOW;
+		}
+		if (flagch == BOW || flagch == EOW)
+			st = step(m->g, startst, stopst, st, flagch, st);
+
+		/* are we done? */
+		if (p == stop)
+			break;		/* NOTE BREAK OUT */
+		cl = dfa->classes[(uch)c];
+		if (ISSET(st, stopst)) {
+			if (d != NULL)
+				d->next[cl] = DFA_MATCH;
+			break;		/* NOTE BREAK OUT */
+		}
+
+		/* no, we must deal with this character */
+		ASSIGN(tmp, st);
+		ASSIGN(st, fresh);
+		assert(c != OUT);
+		st = step(m->g, startst, stopst, tmp, c, st);
+		p++;
+
+		/* and remember where it went */
+		generation = dfa->generation;
+		nd = __regex_dfa_intern(dfa, STATEKEY(st), dfa->kinds[cl],
+		    EQ(st, fresh));
+		if (d != NULL && nd != NULL && dfa->generation == generation)
+			d->next[cl] = nd;
+		d = nd;
+	}
+
+	assert(coldp != NULL);
+	m->coldp = coldp;
+	__regex_dfa_release(dfa);
+	if (ISSET(st, stopst))
+		return(p+1);
+	else
+		return(NULL);
+}
+// END android-added
+
 /*
  - slow - step through the string more deliberately
  == static const char *slow(struct match *m, const char *start, \
@@ -1186,3 +1344,6 @@ pchar(
 #undef	at
 #undef	match
 #undef	nope
+// BEGIN android-added
+#undef	dfast
+// END android-added
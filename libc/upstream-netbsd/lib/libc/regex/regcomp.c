@@ -299,6 +299,9 @@ regcomp(
 	g->categories = &g->catspace[-(CHAR_MIN)];
 	(void) memset((char *)g->catspace, 0, NC*sizeof(cat_t));
 	g->backrefs = 0;
+	// BEGIN android-added
+	g->dfa = NULL;
+	// END android-added
 
 	/* do it */
 	EMIT(OEND, 0);
@@ -327,6 +330,12 @@ regcomp(
 		SETERROR(REG_ASSERT);
 #endif
 
+	// BEGIN android-added
+	/* NULL (back references, or no memory) just means no DFA */
+	if (p->error == 0)
+		g->dfa = __regex_dfa_create(g);
+	// END android-added
+
 	/* win or lose, we're done */
 	if (p->error != 0)	/* lose */
 		regfree(preg);
@@ -200,6 +200,9 @@ struct re_guts {
 	size_t nsub;		/* copy of re_nsub */
 	int backrefs;		/* does it use back references? */
 	sopno nplus;		/* how deep does it nest +s? */
+	// BEGIN android-added
+	struct re_dfa *dfa;	/* cached DFA, if it can have one */
+	// END android-added
 	/* catspace must be last */
 	cat_t catspace[1];	/* actually [NC] */
 };
@@ -207,3 +210,52 @@ struct re_guts {
 /* misc utilities */
 #define	OUT	(CHAR_MAX+1)	/* a non-character value */
 #define	ISWORD(c)	(isalnum((unsigned char)c) || (c) == '_')
+
+// BEGIN android-added
+#include <limits.h>
+#include <pthread.h>
+
+/*
+ * Without back references, fast() just runs an NFA over the strip, and
+ * the same sets of states keep turning up. The DFA caches each set it
+ * meets along with where each class of character takes it, building
+ * itself lazily as regexec is called; see android/regex_dfa.c.
+ */
+struct re_dfa_state {
+	struct re_dfa_state *link;	/* next in hash chain */
+	unsigned hash;
+	uch kind;		/* DFA_KIND_* of the previous character */
+	uch fresh;		/* states are those of a fresh start */
+	struct re_dfa_state *next[1];	/* actually [nclasses]; states follow */
+};
+#define	DFA_STATES(dfa, s)	((void *)&(s)->next[(dfa)->nclasses])
+#define	DFA_MATCH	(&__regex_dfa_match)	/* a transition to a match */
+
+#define	DFA_KIND_OTHER	0
+#define	DFA_KIND_WORD	1	/* ISWORD */
+#define	DFA_KIND_NEWLINE 2	/* '\n' with REG_NEWLINE */
+
+struct re_dfa {
+	pthread_mutex_t lock;	/* held by the regexec using it */
+	int large;		/* which matcher it's for, -1 for neither yet */
+	size_t keylen;		/* bytes in a set of states */
+	size_t nclasses;	/* characters the strip can't tell apart */
+	uch classes[NC];	/* class of each character, by (uch) */
+	uch kinds[NC];		/* DFA_KIND_* of each class */
+	char *prefix;		/* every match starts with this */
+	size_t prefixlen;
+	unsigned generation;	/* bumped whenever the states are thrown away */
+	size_t memory;		/* bytes of states */
+	size_t nstates;
+	size_t nbuckets;
+	struct re_dfa_state **buckets;
+};
+
+__LIBC_HIDDEN__ extern struct re_dfa_state __regex_dfa_match;
+__LIBC_HIDDEN__ struct re_dfa *__regex_dfa_create(struct re_guts *);
+__LIBC_HIDDEN__ void __regex_dfa_destroy(struct re_dfa *);
+__LIBC_HIDDEN__ int __regex_dfa_acquire(struct re_dfa *, int, size_t);
+__LIBC_HIDDEN__ void __regex_dfa_release(struct re_dfa *);
+__LIBC_HIDDEN__ struct re_dfa_state *__regex_dfa_intern(struct re_dfa *,
+    const void *, int, int);
+// END android-added
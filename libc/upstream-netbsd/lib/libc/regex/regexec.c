@@ -127,6 +127,12 @@ __weak_alias(regexec,_regexec)
 #define	FWD(dst, src, n)	((dst) |= ((unsigned long)(src)&(here)) << (n))
 #define	BACK(dst, src, n)	((dst) |= ((unsigned long)(src)&(here)) >> (n))
 #define	ISSETBACK(v, n)	(((v) & ((unsigned long)here >> (n))) != 0)
+// BEGIN android-added
+/* the bytes of a set of states, for the DFA */
+#define	STATEKEY(v)	((void *)&(v))
+#define	STATEKEYLEN	sizeof(unsigned long)
+#define	STATELARGE	0
+// END android-added
 /* function names */
 #define SNAMES			/* engine.c looks after details */
 
@@ -152,6 +158,11 @@ __weak_alias(regexec,_regexec)
 #undef	BACK
 #undef	ISSETBACK
 #undef	SNAMES
+// BEGIN android-added
+#undef	STATEKEY
+#undef	STATEKEYLEN
+#undef	STATELARGE
+// END android-added
 
 /* macros for manipulating states, large version */
 #define	states	char *
@@ -179,6 +190,12 @@ __weak_alias(regexec,_regexec)
 #define	FWD(dst, src, n)	((dst)[here+(n)] |= (src)[here])
 #define	BACK(dst, src, n)	((dst)[here-(n)] |= (src)[here])
 #define	ISSETBACK(v, n)	((v)[here - (n)])
+// BEGIN android-added
+/* the bytes of a set of states, for the DFA */
+#define	STATEKEY(v)	((void *)(v))
+#define	STATEKEYLEN	((size_t)m->g->nstates)
+#define	STATELARGE	1
+// END android-added
 /* function names */
 #define	LNAMES			/* flag */
 
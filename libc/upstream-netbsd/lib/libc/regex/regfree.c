@@ -125,5 +125,8 @@ regfree(
 		free(g->setbits);
 	if (g->must != NULL)
 		free(g->must);
+	// BEGIN android-added
+	__regex_dfa_destroy(g->dfa);
+	// END android-added
 	free(g);
 }
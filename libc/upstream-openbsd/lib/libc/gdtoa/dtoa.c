@@ -183,6 +183,13 @@ dtoa
 		return nrv_alloc("0", rve, 1);
 		}
 
+	// BEGIN android-added
+#ifdef __SIZEOF_INT128__
+	if ((s0 = dtoa_fast(dval(&d), mode, ndigits, decpt, rve)) != NULL)
+		return s0;
+#endif
+	// END android-added
+
 #ifdef SET_INEXACT
 	try_quick = oldinexact = get_inexact();
 	inexact = 1;
@@ -566,6 +566,11 @@ extern void memcpy_D2A ANSI((void*, const void*, size_t));
 #define tinytens __tinytens_D2A
 #define trailz __trailz_D2A
 #define ulp __ulp_D2A
+// BEGIN android-added
+#define dtoa_fast __dtoa_fast_D2A
+#define strtod_fast __strtod_fast_D2A
+#define strtof_fast __strtof_fast_D2A
+// END android-added
 
  extern char *dtoa_result;
  extern CONST double bigtens[], tens[], tinytens[];
@@ -614,6 +619,13 @@ extern void memcpy_D2A ANSI((void*, const void*, size_t));
  extern Bigint *sum ANSI((Bigint*, Bigint*));
  extern int trailz ANSI((Bigint*));
  extern double ulp ANSI((U*));
+// BEGIN android-added
+#ifdef __SIZEOF_INT128__
+ extern char *dtoa_fast ANSI((double, int, int, int*, char**));
+#endif
+ extern int strtod_fast ANSI((CONST char*, char**, double*));
+ extern int strtof_fast ANSI((CONST char*, char**, float*));
+// END android-added
 
 #ifdef __cplusplus
 }
@@ -140,6 +140,11 @@ strtod
 #endif /*}}*/
 #endif /*}*/
 
+	// BEGIN android-added
+	if (strtod_fast(s00, se, &dval(&rv)))
+		return dval(&rv);
+	// END android-added
+
 	sign = nz0 = nz = decpt = 0;
 	dval(&rv) = 0.;
 	for(s = s00;;s++) switch(*s) {
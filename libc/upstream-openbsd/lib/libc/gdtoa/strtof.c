@@ -49,6 +49,11 @@ strtof(CONST char *s, char **sp)
 #define fpi &fpi0
 #endif
 
+	// BEGIN android-added
+	if (strtof_fast(s, sp, &u.f))
+		return u.f;
+	// END android-added
+
 	k = strtodg(s, sp, fpi, &exp, bits);
 	switch(k & STRTOG_Retmask) {
 	  case STRTOG_NoNumber:
@@ -143,6 +143,11 @@ nbf:
 			fp->_lbfsize = -fp->_bf._size;
 		} else
 			fp->_w = size;
+		// BEGIN android-added
+		// __swsetup won't see this stream now it has a buffer, so
+		// fflush(NULL) and exit wouldn't either.
+		__sfp_writing(fp);
+		// END android-added
 	} else {
 		/* begin/continue reading, or stay in intermediate state */
 		fp->_w = 0;
@@ -468,6 +468,12 @@ __vfprintf(FILE *fp, const char *fmt0, __va_list ap)
 	    fp->_file >= 0)
 		return (__sbprintf(fp, fmt0, ap));
 
+	// BEGIN android-added
+	// Formats with only plain conversions take a faster path.
+	if (__printf_is_simple(fmt0))
+		return (__vfprintf_fast(fp, fmt0, ap));
+	// END android-added
+
 	fmt = (char *)fmt0;
 	argtable = NULL;
 	nextarg = 1;
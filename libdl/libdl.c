@@ -38,3 +38,5 @@ void android_get_LD_LIBRARY_PATH(char* buffer __unused, size_t buffer_size __unu
 void android_update_LD_LIBRARY_PATH(const char* ld_library_path __unused) { }
 
 void* android_dlopen_ext(const char* filename __unused, int flag __unused, const android_dlextinfo* extinfo __unused) { return 0; }
+int android_dlopen_many(const char* const filenames[] __unused, size_t count __unused, int flag __unused, void* handles[] __unused) { return 0; }
+int android_dlinit(void* handle __unused) { return 0; }
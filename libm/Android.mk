@@ -29,7 +29,6 @@ LOCAL_SRC_FILES := \
     upstream-freebsd/lib/msun/src/e_atanh.c \
     upstream-freebsd/lib/msun/src/e_atanhf.c \
     upstream-freebsd/lib/msun/src/e_coshf.c \
-    upstream-freebsd/lib/msun/src/e_expf.c \
     upstream-freebsd/lib/msun/src/e_fmod.c \
     upstream-freebsd/lib/msun/src/e_fmodf.c \
     upstream-freebsd/lib/msun/src/e_gamma.c \
@@ -50,8 +49,6 @@ LOCAL_SRC_FILES := \
     upstream-freebsd/lib/msun/src/e_log10f.c \
     upstream-freebsd/lib/msun/src/e_log2.c \
     upstream-freebsd/lib/msun/src/e_log2f.c \
-    upstream-freebsd/lib/msun/src/e_logf.c \
-    upstream-freebsd/lib/msun/src/e_powf.c \
     upstream-freebsd/lib/msun/src/e_remainder.c \
     upstream-freebsd/lib/msun/src/e_remainderf.c \
     upstream-freebsd/lib/msun/src/e_rem_pio2f.c \
@@ -86,7 +83,6 @@ LOCAL_SRC_FILES := \
     upstream-freebsd/lib/msun/src/s_conjl.c \
     upstream-freebsd/lib/msun/src/s_copysign.c \
     upstream-freebsd/lib/msun/src/s_copysignf.c \
-    upstream-freebsd/lib/msun/src/s_cosf.c \
     upstream-freebsd/lib/msun/src/s_cproj.c \
     upstream-freebsd/lib/msun/src/s_cprojf.c \
     upstream-freebsd/lib/msun/src/s_cprojl.c \
@@ -128,7 +124,6 @@ LOCAL_SRC_FILES := \
     upstream-freebsd/lib/msun/src/s_signgam.c \
     upstream-freebsd/lib/msun/src/s_significand.c \
     upstream-freebsd/lib/msun/src/s_significandf.c \
-    upstream-freebsd/lib/msun/src/s_sinf.c \
     upstream-freebsd/lib/msun/src/s_tanf.c \
     upstream-freebsd/lib/msun/src/s_tanhf.c \
     upstream-freebsd/lib/msun/src/s_tgammaf.c \
@@ -194,9 +189,13 @@ LOCAL_SRC_FILES_64 += \
     upstream-freebsd/lib/msun/ld128/s_erfl.c \
     upstream-freebsd/lib/msun/ld128/s_exp2l.c \
     upstream-freebsd/lib/msun/ld128/s_expl.c \
-    upstream-freebsd/lib/msun/ld128/s_logl.c \
     upstream-freebsd/lib/msun/ld128/s_nanl.c \
 
+# powl.c also builds ld128/s_logl.c, to get at its static k_logl.
+LOCAL_SRC_FILES_64 += \
+    powl.c \
+    sincosl.c \
+
 # TODO: this comes from from upstream's libc, not libm, but it's an
 # implementation detail that should have hidden visibility, so it needs
 # to be in whatever library the math code is in.
@@ -205,6 +204,7 @@ LOCAL_SRC_FILES += \
 
 # Functionality not in the BSDs.
 LOCAL_SRC_FILES += \
+    array_math.c \
     significandl.c \
     sincos.c \
 
@@ -212,6 +212,16 @@ LOCAL_SRC_FILES += \
 LOCAL_SRC_FILES += \
     signbit.c \
 
+# Table-driven float functions that replace msun's e_expf.c, e_logf.c,
+# e_powf.c, s_sinf.c and s_cosf.c.
+LOCAL_SRC_FILES += \
+    cosf.c \
+    expf.c \
+    float_tables.c \
+    logf.c \
+    powf.c \
+    sinf.c \
+
 # Arch specific optimizations.
 
 # -----------------------------------------------------------------------------
@@ -292,12 +302,17 @@ LOCAL_SRC_FILES_arm64 += \
     arm64/log.S \
     arm64/lrint.S \
     arm64/lround.S \
+    arm64/pow.c \
     arm64/rem_pio2.S \
     arm64/rem_pio2_kernel.S \
+    arm64/rem_pio2_large.c \
     arm64/rint.S \
     arm64/round.S \
+    arm64/sin.c \
     arm64/sqrt.S \
+    arm64/tan.c \
     arm64/trunc.S \
+    arm64/vector_math.c \
     upstream-freebsd/lib/msun/src/e_acos.c \
     upstream-freebsd/lib/msun/src/e_asin.c \
     upstream-freebsd/lib/msun/src/e_atan2.c \
@@ -306,13 +321,9 @@ LOCAL_SRC_FILES_arm64 += \
     upstream-freebsd/lib/msun/src/e_log10.c \
     upstream-freebsd/lib/msun/src/e_sinh.c \
     upstream-freebsd/lib/msun/src/s_cbrt.c \
-    upstream-freebsd/lib/msun/src/s_cos.c \
     upstream-freebsd/lib/msun/src/s_expm1.c \
     upstream-freebsd/lib/msun/src/s_log1p.c \
     upstream-freebsd/lib/msun/src/s_modf.c \
-    upstream-freebsd/lib/msun/src/e_pow.c \
-    upstream-freebsd/lib/msun/src/e_sin.c \
-    upstream-freebsd/lib/msun/src/s_tan.c \
     upstream-freebsd/lib/msun/src/s_tanh.c \
 
 # -----------------------------------------------------------------------------
@@ -496,6 +507,10 @@ LOCAL_SRC_FILES_x86_64 += \
     x86_64/s_sin.S \
     x86_64/s_tanh.S \
     x86_64/s_tan.S \
+    x86_64/array_math.c \
+    x86_64/vector_math_avx.c \
+    x86_64/vector_math_avx2.c \
+    x86_64/vector_math_sse2.c \
 
 ifeq ($(ARCH_X86_HAVE_SSE4_1),true)
 LOCAL_SRC_FILES_x86_64 += \
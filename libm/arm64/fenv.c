@@ -26,50 +26,19 @@
  * $FreeBSD: libm/aarch64/fenv.c $
  */
 
-#include <fenv.h>
+// Emit the inline functions of <machine/fenv.h> as the exported copies.
+#include <sys/cdefs.h>
+#define __fenv_static __LIBC_ABI_PUBLIC__
 
-#define FPCR_EXCEPT_SHIFT 8
-#define FPCR_EXCEPT_MASK  (FE_ALL_EXCEPT << FPCR_EXCEPT_SHIFT)
+#include <fenv.h>
 
-#define FPCR_RMODE_SHIFT 22
+#define FPCR_EXCEPT_MASK (FE_ALL_EXCEPT << __FPCR_EXCEPT_SHIFT)
 
 const fenv_t __fe_dfl_env = { 0 /* control */, 0 /* status */};
 
 typedef __uint32_t fpu_control_t;   // FPCR, Floating-point Control Register.
 typedef __uint32_t fpu_status_t;    // FPSR, Floating-point Status Register.
 
-#define __get_fpcr(__fpcr) __asm__ __volatile__("mrs %0,fpcr" : "=r" (__fpcr))
-#define __get_fpsr(__fpsr) __asm__ __volatile__("mrs %0,fpsr" : "=r" (__fpsr))
-#define __set_fpcr(__fpcr) __asm__ __volatile__("msr fpcr,%0" : :"ri" (__fpcr))
-#define __set_fpsr(__fpsr) __asm__ __volatile__("msr fpsr,%0" : :"ri" (__fpsr))
-
-int fegetenv(fenv_t* envp) {
-  __get_fpcr(envp->__control);
-  __get_fpsr(envp->__status);
-  return 0;
-}
-
-int fesetenv(const fenv_t* envp) {
-  fpu_control_t fpcr;
-
-  __get_fpcr(fpcr);
-  if (envp->__control != fpcr) {
-    __set_fpcr(envp->__control);
-  }
-  __set_fpsr(envp->__status);
-  return 0;
-}
-
-int feclearexcept(int excepts) {
-  fpu_status_t fpsr;
-
-  excepts &= FE_ALL_EXCEPT;
-  __get_fpsr(fpsr);
-  fpsr &= ~excepts;
-  __set_fpsr(fpsr);
-  return 0;
-}
-
 int fegetexceptflag(fexcept_t* flagp, int excepts) {
   fpu_status_t fpsr;
 
@@ -80,13 +49,14 @@ int fegetexceptflag(fexcept_t* flagp, int excepts) {
 }
 
 int fesetexceptflag(const fexcept_t* flagp, int excepts) {
-  fpu_status_t fpsr;
+  fpu_status_t fpsr, new_fpsr;
 
   excepts &= FE_ALL_EXCEPT;
   __get_fpsr(fpsr);
-  fpsr &= ~excepts;
-  fpsr |= *flagp & excepts;
-  __set_fpsr(fpsr);
+  new_fpsr = (fpsr & ~excepts) | (*flagp & excepts);
+  if (new_fpsr != fpsr) {
+    __set_fpsr(new_fpsr);
+  }
   return 0;
 }
 
@@ -97,99 +67,31 @@ int feraiseexcept(int excepts) {
   return 0;
 }
 
-int fetestexcept(int excepts) {
-  fpu_status_t fpsr;
-
-  excepts &= FE_ALL_EXCEPT;
-  __get_fpsr(fpsr);
-  return (fpsr & excepts);
-}
-
-int fegetround(void) {
-  fpu_control_t fpcr;
-
-  __get_fpcr(fpcr);
-  return ((fpcr >> FPCR_RMODE_SHIFT) & FE_TOWARDZERO);
-}
-
-int fesetround(int round) {
-  fpu_control_t fpcr, new_fpcr;
-
-  round &= FE_TOWARDZERO;
-  __get_fpcr(fpcr);
-  new_fpcr = fpcr & ~(FE_TOWARDZERO << FPCR_RMODE_SHIFT);
-  new_fpcr |= (round << FPCR_RMODE_SHIFT);
-  if (new_fpcr != fpcr) {
-    __set_fpcr(new_fpcr);
-  }
-  return 0;
-}
-
-int feholdexcept(fenv_t* envp) {
-  fenv_t env;
-  fpu_status_t fpsr;
-  fpu_control_t fpcr, new_fpcr;
-
-  __get_fpsr(fpsr);
-  __get_fpcr(fpcr);
-  env.__status = fpsr;
-  env.__control = fpcr;
-  *envp = env;
-
-  // Set exceptions to untrapped.
-  new_fpcr = fpcr & ~(FE_ALL_EXCEPT << FPCR_EXCEPT_SHIFT);
-  if (new_fpcr != fpcr) {
-    __set_fpcr(new_fpcr);
-  }
-
-  // Clear all exceptions.
-  fpsr &= ~FE_ALL_EXCEPT;
-  __set_fpsr(fpsr);
-  return 0;
-}
-
-int feupdateenv(const fenv_t* envp) {
-  fpu_status_t fpsr;
-  fpu_control_t fpcr;
-
-  // Set FPU Control register.
-  __get_fpcr(fpcr);
-  if (envp->__control != fpcr) {
-    __set_fpcr(envp->__control);
-  }
-
-  // Set FPU Status register to status | currently raised exceptions.
-  __get_fpsr(fpsr);
-  fpsr = envp->__status | (fpsr & FE_ALL_EXCEPT);
-  __set_fpsr(fpsr);
-  return 0;
-}
-
 int feenableexcept(int mask) {
   fpu_control_t old_fpcr, new_fpcr;
 
   __get_fpcr(old_fpcr);
-  new_fpcr = old_fpcr | ((mask & FE_ALL_EXCEPT) << FPCR_EXCEPT_SHIFT);
+  new_fpcr = old_fpcr | ((mask & FE_ALL_EXCEPT) << __FPCR_EXCEPT_SHIFT);
   if (new_fpcr != old_fpcr) {
     __set_fpcr(new_fpcr);
   }
-  return ((old_fpcr >> FPCR_EXCEPT_SHIFT) & FE_ALL_EXCEPT);
+  return ((old_fpcr >> __FPCR_EXCEPT_SHIFT) & FE_ALL_EXCEPT);
 }
 
 int fedisableexcept(int mask) {
   fpu_control_t old_fpcr, new_fpcr;
 
   __get_fpcr(old_fpcr);
-  new_fpcr = old_fpcr & ~((mask & FE_ALL_EXCEPT) << FPCR_EXCEPT_SHIFT);
+  new_fpcr = old_fpcr & ~((mask & FE_ALL_EXCEPT) << __FPCR_EXCEPT_SHIFT);
   if (new_fpcr != old_fpcr) {
     __set_fpcr(new_fpcr);
   }
-  return ((old_fpcr >> FPCR_EXCEPT_SHIFT) & FE_ALL_EXCEPT);
+  return ((old_fpcr >> __FPCR_EXCEPT_SHIFT) & FE_ALL_EXCEPT);
 }
 
 int fegetexcept(void) {
   fpu_control_t fpcr;
 
   __get_fpcr(fpcr);
-  return ((fpcr & FPCR_EXCEPT_MASK) >> FPCR_EXCEPT_SHIFT);
+  return ((fpcr & FPCR_EXCEPT_MASK) >> __FPCR_EXCEPT_SHIFT);
 }
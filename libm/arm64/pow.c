@@ -0,0 +1,575 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * pow(x, y) = exp(y * log(x)), with log(x) to about 2^-66 relative as a
+ * double-double and exp taking that double-double. Errors are a little over
+ * half an ulp.
+ *
+ * log(x): x = 2^k * z with z in [OFF, 2 * OFF), and for z in the i-th of N
+ * subintervals, log(x) = k*ln2 + log(c) + log1p(z/c - 1) where the table
+ * holds 1/c and log(c) split so that k*ln2 + log(c) is exact. r = z/c - 1 is
+ * computed exactly as a double-double with a fused multiply-add, and
+ * log1p(r) comes from its Taylor series.
+ *
+ * exp(x): x = k*ln2/N + r with |r| <= ln2/2N, and
+ * exp(x) = 2^(k/N) * exp(r) with 2^(k/N) from a table as a double and the
+ * relative error of that double.
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "math_private.h"
+
+#define	LOG_TABLE_BITS	7
+#define	LOG_N		(1 << LOG_TABLE_BITS)
+#define	LOG_OFF		0x3fe6955500000000ULL
+#define	EXP_TABLE_BITS	7
+#define	EXP_N		(1 << EXP_TABLE_BITS)
+
+static const struct {
+	double invc;
+	double logc;	/* A multiple of 2^-42. */
+	double logctail;
+} log_table[LOG_N] = {
+	{ 0x1.69be8c81fb00cp+0, -0x1.620ef9ac6b000p-2, 0x1.6117d5edf2436p-44 },
+	{ 0x1.67c22fe4dcddap+0, -0x1.5c6bfa1132000p-2, 0x1.1dd5accf53e10p-44 },
+	{ 0x1.65cb6049c63c4p+0, -0x1.56d0e0c69c000p-2, -0x1.d163900cb789bp-45 },
+	{ 0x1.63da068aeb033p+0, -0x1.513d97c719000p-2, 0x1.823ba36760a44p-46 },
+	{ 0x1.61ee0c0281abbp+0, -0x1.4bb20968ac000p-2, -0x1.f824e3bdf1815p-44 },
+	{ 0x1.60075a87531dbp+0, -0x1.462e205af9000p-2, 0x1.977ff66cd4ac3p-44 },
+	{ 0x1.5e25dc6966c26p+0, -0x1.40b1c7a550000p-2, -0x1.07bb51dd08a7bp-45 },
+	{ 0x1.5c497c6ec9c1ap+0, -0x1.3b3ceaa4d9000p-2, 0x1.ff7f7452f35fcp-45 },
+	{ 0x1.5a7225d070680p+0, -0x1.35cf750ab9000p-2, -0x1.c34ee5e4991c1p-46 },
+	{ 0x1.589fc43730bf1p+0, -0x1.306952da53000p-2, -0x1.1e1bf85e2d1f1p-44 },
+	{ 0x1.56d243b8d56c2p+0, -0x1.2b0a70678b000p-2, -0x1.cf956aa709e8fp-46 },
+	{ 0x1.550990d547f30p+0, -0x1.25b2ba5518000p-2, -0x1.0dd02bf5b567dp-45 },
+	{ 0x1.53459873d182dp+0, -0x1.20621d92e3000p-2, 0x1.c8ae8672018dfp-44 },
+	{ 0x1.518647e0717edp+0, -0x1.1b18875c6b000p-2, -0x1.4ba1c08d8a1a2p-45 },
+	{ 0x1.4fcb8cc948f96p+0, -0x1.15d5e5373e000p-2, 0x1.75ae5c8e40f16p-44 },
+	{ 0x1.4e15553c1a639p+0, -0x1.109a24f16d000p-2, -0x1.c23478c3f6d46p-47 },
+	{ 0x1.4c638fa3dcb8ep+0, -0x1.0b6534a01a000p-2, -0x1.0a04df048e3a3p-44 },
+	{ 0x1.4ab62ac66176cp+0, -0x1.0637029e04000p-2, 0x1.01f5ea517f0ddp-44 },
+	{ 0x1.490d15c20cb76p+0, -0x1.010f7d8a1f000p-2, 0x1.31a0e695636d3p-45 },
+	{ 0x1.4768400b9ecd3p+0, -0x1.f7dd288c74000p-3, 0x1.c159546ca73aep-46 },
+	{ 0x1.45c7996c0ec27p+0, -0x1.eda86beb4e000p-3, -0x1.96140ffc2a7e7p-47 },
+	{ 0x1.442b11fe75285p+0, -0x1.e380a3f7e0000p-3, 0x1.2cd9e776dff18p-44 },
+	{ 0x1.42929a2e06a4dp+0, -0x1.d965aff720000p-3, 0x1.eaa3105bbbfb3p-48 },
+	{ 0x1.40fe22b41db5ep+0, -0x1.cf576fa974000p-3, -0x1.871fccfea63fcp-45 },
+	{ 0x1.3f6d9c965323ep+0, -0x1.c555c34844000p-3, -0x1.855782b790e0ap-45 },
+	{ 0x1.3de0f924a4a53p+0, -0x1.bb608b83a0000p-3, -0x1.844c8ffe9fcbcp-50 },
+	{ 0x1.3c5829f7a9375p+0, -0x1.b177a97ff4000p-3, 0x1.27e592ff43c51p-46 },
+	{ 0x1.3ad320eed2b70p+0, -0x1.a79afed3cc000p-3, 0x1.9a6b7647aa4cep-44 },
+	{ 0x1.3951d02ebc479p+0, -0x1.9dca6d85a0000p-3, -0x1.2ded1e85911c5p-49 },
+	{ 0x1.37d42a1f851a3p+0, -0x1.9405d809b8000p-3, -0x1.3135a7e3af5eap-45 },
+	{ 0x1.365a216b372dap+0, -0x1.8a4d214010000p-3, -0x1.4cc5ae06399a9p-45 },
+	{ 0x1.34e3a8fc39a0ap+0, -0x1.80a02c7252000p-3, 0x1.9b24bcfb52e90p-45 },
+	{ 0x1.3370b3fbce360p+0, -0x1.76fedd51d6000p-3, 0x1.40415847e5e13p-50 },
+	{ 0x1.320135d099ac2p+0, -0x1.6d6917f5b6000p-3, -0x1.9a400aa4d3263p-44 },
+	{ 0x1.3095221d368ecp+0, -0x1.63dec0d8e8000p-3, 0x1.2de6f97f8c685p-44 },
+	{ 0x1.2f2c6cbed22b0p+0, -0x1.5a5fbcd85c000p-3, 0x1.af5b194009ce5p-44 },
+	{ 0x1.2dc709cbd3534p+0, -0x1.50ebf13136000p-3, -0x1.7dbdecf81e855p-46 },
+	{ 0x1.2c64ed928aa10p+0, -0x1.4783437f08000p-3, -0x1.d19ee15e6e525p-44 },
+	{ 0x1.2b060c97ebe82p+0, -0x1.3e2599ba16000p-3, 0x1.5bac8a45fc6e7p-46 },
+	{ 0x1.29aa5b9650907p+0, -0x1.34d2da35a2000p-3, 0x1.2177d8e31cf24p-44 },
+	{ 0x1.2851cf7c428cdp+0, -0x1.2b8aeb9e4c000p-3, 0x1.218fb464413d8p-46 },
+	{ 0x1.26fc5d6b4fab4p+0, -0x1.224db4f874000p-3, -0x1.7a863bc5d7588p-47 },
+	{ 0x1.25a9fab6e4facp+0, -0x1.191b1d9ea4000p-3, -0x1.d80c812bc8c61p-45 },
+	{ 0x1.245a9ce332056p+0, -0x1.0ff30d4008000p-3, -0x1.aeeb202c1e4c5p-47 },
+	{ 0x1.230e39a413a1bp+0, -0x1.06d56bdeea000p-3, 0x1.78dc3a7702567p-44 },
+	{ 0x1.21c4c6dc061e2p+0, -0x1.fb84439e70000p-4, -0x1.686480962d7e7p-47 },
+	{ 0x1.207e3a9b1e8d3p+0, -0x1.e9722f6a34000p-4, 0x1.bb4e137a90e82p-46 },
+	{ 0x1.1f3a8b1e0af9dp+0, -0x1.d7746d0700000p-4, 0x1.36c0eab1bb505p-46 },
+	{ 0x1.1df9aecd194e9p+0, -0x1.c58acef590000p-4, 0x1.97125188427bfp-44 },
+	{ 0x1.1cbb9c3b44badp+0, -0x1.b3b5284ec0000p-4, 0x1.fbca639701f3bp-44 },
+	{ 0x1.1b804a2549645p+0, -0x1.a1f34cc0ec000p-4, -0x1.e38b52ed526c1p-44 },
+	{ 0x1.1a47af70be33ap+0, -0x1.9045108d68000p-4, -0x1.9c5f6aa7f052dp-44 },
+	{ 0x1.1911c32b348dcp+0, -0x1.7eaa4885e4000p-4, 0x1.a1e36ab7f9ba8p-44 },
+	{ 0x1.17de7c895dcc0p+0, -0x1.6d22ca09f8000p-4, 0x1.e05f0a2653f96p-44 },
+	{ 0x1.16add2e63647fp+0, -0x1.5bae6b04c4000p-4, -0x1.4b718a47c84f1p-46 },
+	{ 0x1.157fbdc235cffp+0, -0x1.4a4d01ea90000p-4, 0x1.26b8f9a6f2553p-46 },
+	{ 0x1.145434c2855c5p+0, -0x1.38fe65b66c000p-4, -0x1.f64436881f151p-45 },
+	{ 0x1.132b2fb039dc6p+0, -0x1.27c26de7fc000p-4, -0x1.dc638027a279cp-44 },
+	{ 0x1.1204a67793f6ap+0, -0x1.1698f28138000p-4, -0x1.ae82028c29c1cp-46 },
+	{ 0x1.10e0912744966p+0, -0x1.0581cc043c000p-4, 0x1.c6d4a9b2e731fp-44 },
+	{ 0x1.0fbee7efb622ep+0, -0x1.e8f9a6e250000p-5, 0x1.ee856ea41126bp-45 },
+	{ 0x1.0e9fa3225a3e1p+0, -0x1.c713c48828000p-5, 0x1.2db423b44fae4p-44 },
+	{ 0x1.0d82bb30fbe96p+0, -0x1.a551a4e5f0000p-5, 0x1.3b13cd29cefcfp-44 },
+	{ 0x1.0c6828ad15f01p+0, -0x1.83b2fcd760000p-5, -0x1.0224dc52cd4c3p-44 },
+	{ 0x1.0b4fe4472d780p+0, -0x1.6237822420000p-5, 0x1.2e4c7a0172e5cp-44 },
+	{ 0x1.0a39e6ce309acp+0, -0x1.40deeb7bc0000p-5, -0x1.0bc16ada9c0fcp-44 },
+	{ 0x1.0926292ed8e9ep+0, -0x1.1fa8f07238000p-5, 0x1.8273ba3a8d4ecp-44 },
+	{ 0x1.0814a47311c1ap+0, -0x1.fd2a92f7e0000p-6, -0x1.c604def673fddp-52 },
+	{ 0x1.070551c1624f2p+0, -0x1.bb475fd4d0000p-6, 0x1.e79fd06f9753bp-44 },
+	{ 0x1.05f82a5c5b2f9p+0, -0x1.79a7bbd0e0000p-6, 0x1.e35fc1b1e1da2p-47 },
+	{ 0x1.04ed27a2078e3p+0, -0x1.384b1cedd0000p-6, 0x1.96be668efd665p-44 },
+	{ 0x1.03e4430b61a92p+0, -0x1.ee61f5a4a0000p-7, 0x1.714a2f15aa824p-44 },
+	{ 0x1.02dd762bcaa3fp+0, -0x1.6cb19d8720000p-7, -0x1.299f2233d6b80p-44 },
+	{ 0x1.01d8bab085916p+0, -0x1.d7084e7b00000p-8, -0x1.5da1e3085dd59p-44 },
+	{ 0x1.00d60a60359dbp+0, -0x1.ab622e9400000p-9, 0x1.8cdaa8d01017ap-44 },
+	{ 0x1.0000000000000p+0, 0.0, 0.0 },
+	{ 0x1.fb602a2f91e1fp-1, 0x1.294daebc00000p-7, 0x1.564029748a3f1p-47 },
+	{ 0x1.f77a4dd695191p-1, 0x1.1301d448a0000p-6, 0x1.5ff90a13b6ed6p-47 },
+	{ 0x1.f3a3a89273f9ep-1, 0x1.906542de60000p-6, 0x1.d3e4ac8ccc237p-44 },
+	{ 0x1.efdbe1f975defp-1, 0x1.066a72e470000p-5, 0x1.39f71e0a614c4p-44 },
+	{ 0x1.ec22a449beb96p-1, 0x1.442a34f660000p-5, 0x1.7bbeca642a7c6p-46 },
+	{ 0x1.e8779c4ff8ee3p-1, 0x1.8173b38840000p-5, 0x1.75156ea89931dp-45 },
+	{ 0x1.e4da794f1f1e5p-1, 0x1.be48b03e90000p-5, 0x1.ee1cfae3ac248p-46 },
+	{ 0x1.e14aece9570c6p-1, 0x1.faaae2cc58000p-5, 0x1.00bbe33c43a6dp-44 },
+	{ 0x1.ddc8ab09cfb09p-1, 0x1.1b4dfc9edc000p-4, -0x1.b02bd1d04e299p-45 },
+	{ 0x1.da5369cf9557bp-1, 0x1.390ecc1fcc000p-4, 0x1.4741a1cb77c49p-44 },
+	{ 0x1.d6eae1794f6f3p-1, 0x1.5698adb284000p-4, 0x1.bd3b8d4da5bd6p-44 },
+	{ 0x1.d38ecc51dc50bp-1, 0x1.73ec6ab4ec000p-4, 0x1.8f1a12ccb19ebp-46 },
+	{ 0x1.d03ee69dc00cap-1, 0x1.910ac8397c000p-4, 0x1.7f37dcb27c8d1p-46 },
+	{ 0x1.ccfaee895bcefp-1, 0x1.adf4872650000p-4, -0x1.94d20a8706d7bp-45 },
+	{ 0x1.c9c2a417e40ffp-1, 0x1.caaa645310000p-4, 0x1.5325d748c0104p-44 },
+	{ 0x1.c695c9130c4d5p-1, 0x1.e72d18a5ec000p-4, -0x1.25e2f81c779bcp-46 },
+	{ 0x1.c37420fb5f8a6p-1, 0x1.01beac97b6000p-3, 0x1.c1868af548400p-44 },
+	{ 0x1.c05d70f93d515p-1, 0x1.0fcdeba2c0000p-3, 0x1.c46011c7f0788p-44 },
+	{ 0x1.bd517fce73629p-1, 0x1.1dc4a04ebc000p-3, -0x1.b9d7951f450f1p-44 },
+	{ 0x1.ba5015c86caaap-1, 0x1.2ba31fb292000p-3, 0x1.a0af524b0a3fcp-44 },
+	{ 0x1.b758fcb2ee7e3p-1, 0x1.3969bd2da2000p-3, 0x1.00c28de8a2423p-44 },
+	{ 0x1.b46bffcb5d798p-1, 0x1.4718ca7372000p-3, -0x1.eae94a8b63f66p-46 },
+	{ 0x1.b188ebb483bc1p-1, 0x1.54b0979710000p-3, 0x1.bb7177c3a2affp-44 },
+	{ 0x1.aeaf8e6ad28c6p-1, 0x1.6231731614000p-3, 0x1.65cd7d69ae30ep-44 },
+	{ 0x1.abdfb73919c0fp-1, 0x1.6f9ba9e336000p-3, 0x1.0d4aa267d501dp-44 },
+	{ 0x1.a91936adaf945p-1, 0x1.7cef87709c000p-3, -0x1.66582693dafa8p-44 },
+	{ 0x1.a65bde9003d33p-1, 0x1.8a2d55b9c6000p-3, -0x1.e8d8684043044p-47 },
+	{ 0x1.a3a781d69993ap-1, 0x1.97555d4d38000p-3, -0x1.0c17ec214f679p-44 },
+	{ 0x1.a0fbf49d62e51p-1, 0x1.a467e555c2000p-3, -0x1.2479e457b3c7bp-44 },
+	{ 0x1.9e590c1c7a228p-1, 0x1.b16533a38c000p-3, -0x1.51fc52fe8e80ap-44 },
+	{ 0x1.9bbe9e9f34c91p-1, 0x1.be4d8cb4d0000p-3, 0x1.98881b9d6aa50p-45 },
+	{ 0x1.992c837b8be99p-1, 0x1.cb2133be56000p-3, 0x1.479d621c1479ap-44 },
+	{ 0x1.96a29309d67c9p-1, 0x1.d7e06ab3a2000p-3, 0x1.84a2478047b69p-44 },
+	{ 0x1.9420a69cd210dp-1, 0x1.e48b724eea000p-3, 0x1.f721cf3eb9b50p-44 },
+	{ 0x1.91a69879f676ap-1, 0x1.f1228a18cc000p-3, -0x1.34cbadf628bc8p-44 },
+	{ 0x1.8f3443d211372p-1, 0x1.fda5f06fbe000p-3, 0x1.0fe2c45b6fa25p-51 },
+	{ 0x1.8cc984ba25cabp-1, 0x1.050af147ac000p-2, 0x1.78fe340939e73p-44 },
+	{ 0x1.8a6638248faa5p-1, 0x1.0b394e4baa000p-2, -0x1.fc19c1f9e095fp-45 },
+	{ 0x1.880a3bda6379bp-1, 0x1.115e2cc92c000p-2, 0x1.34d333289bc6ap-45 },
+	{ 0x1.85b56e750ca95p-1, 0x1.1779a9be50000p-2, -0x1.6284b5e3e3dcap-44 },
+	{ 0x1.8367af582510cp-1, 0x1.1d8be1a52c000p-2, 0x1.9f5147ddea1d5p-44 },
+	{ 0x1.8120deab841dcp-1, 0x1.2394f076f3000p-2, 0x1.8617607913960p-44 },
+	{ 0x1.7ee0dd558352dp-1, 0x1.2994f1aef4000p-2, -0x1.7aea1b29da930p-45 },
+	{ 0x1.7ca78cf575ea8p-1, 0x1.2f8c004d8a000p-2, 0x1.a62b21951b9d2p-46 },
+	{ 0x1.7a74cfde518dap-1, 0x1.357a36daf9000p-2, -0x1.48276c8efad87p-47 },
+	{ 0x1.7848891186241p-1, 0x1.3b5faf6a2e000p-2, -0x1.abff6c89875bbp-44 },
+	{ 0x1.76229c3a02dd9p-1, 0x1.413c839b70000p-2, -0x1.d4de6471c3e17p-44 },
+	{ 0x1.7402eda766a7bp-1, 0x1.4710cc9efd000p-2, 0x1.8cfaca96c35d4p-46 },
+	{ 0x1.71e962495a585p-1, 0x1.4cdca33795000p-2, -0x1.a71938c5cdb44p-44 },
+	{ 0x1.6fd5dfab12e9ep-1, 0x1.52a01fbcec000p-2, -0x1.c333a9dabd3e6p-44 },
+	{ 0x1.6dc84beefa396p-1, 0x1.585b5a1e14000p-2, 0x1.c67e06f3cdd0bp-45 },
+	{ 0x1.6bc08dca7cc53p-1, 0x1.5e0e69e3d2000p-2, -0x1.53177b180c1a8p-45 },
+};
+
+/* 2^(i/N), and the relative error of that double. */
+static const struct {
+	uint64_t bits;
+	double tail;
+} exp_table[EXP_N] = {
+	{ 0x3ff0000000000000ULL, 0.0 },
+	{ 0x3ff0163da9fb3335ULL, 0x1.b3b4f1a88bf6ep-54 },
+	{ 0x3ff02c9a3e778061ULL, -0x1.160139cd8dc5dp-56 },
+	{ 0x3ff04315e86e7f85ULL, -0x1.05e7a108766d1p-54 },
+	{ 0x3ff059b0d3158574ULL, 0x1.cd2523567f613p-55 },
+	{ 0x3ff0706b29ddf6deULL, -0x1.bce8023f98efap-55 },
+	{ 0x3ff0874518759bc8ULL, 0x1.0f74e61e6c861p-57 },
+	{ 0x3ff09e3ecac6f383ULL, 0x1.0a3e45b33d399p-54 },
+	{ 0x3ff0b5586cf9890fULL, 0x1.79aa65d837b6dp-54 },
+	{ 0x3ff0cc922b7247f7ULL, 0x1.eb51a92fdeffcp-55 },
+	{ 0x3ff0e3ec32d3d1a2ULL, 0x1.ebe3d702f9cd1p-60 },
+	{ 0x3ff0fb66affed31bULL, -0x1.a033489906e0bp-57 },
+	{ 0x3ff11301d0125b51ULL, -0x1.556522a2fbd0ep-54 },
+	{ 0x3ff12abdc06c31ccULL, -0x1.080ef8c4eea55p-58 },
+	{ 0x3ff1429aaea92de0ULL, -0x1.1c923b9d5f416p-54 },
+	{ 0x3ff15a98c8a58e51ULL, 0x1.0d3e3e95c55afp-55 },
+	{ 0x3ff172b83c7d517bULL, -0x1.01b15eaa59348p-55 },
+	{ 0x3ff18af9388c8deaULL, -0x1.f1ff055de323dp-55 },
+	{ 0x3ff1a35beb6fcb75ULL, 0x1.b898c3f1353bfp-55 },
+	{ 0x3ff1bbe084045cd4ULL, -0x1.6d99c7611eb26p-54 },
+	{ 0x3ff1d4873168b9aaULL, 0x1.aecf73e3a2f60p-54 },
+	{ 0x3ff1ed5022fcd91dULL, -0x1.fe782cb86389dp-55 },
+	{ 0x3ff2063b88628cd6ULL, 0x1.a6f4144a6c38dp-55 },
+	{ 0x3ff21f49917ddc96ULL, 0x1.07a05b0e4047dp-55 },
+	{ 0x3ff2387a6e756238ULL, 0x1.68efde3a8a894p-54 },
+	{ 0x3ff251ce4fb2a63fULL, 0x1.75e18f274487dp-55 },
+	{ 0x3ff26b4565e27cddULL, 0x1.0472b981fe7f2p-55 },
+	{ 0x3ff284dfe1f56381ULL, -0x1.6b87b3f71085ep-54 },
+	{ 0x3ff29e9df51fdee1ULL, 0x1.2f7e16d09ab31p-55 },
+	{ 0x3ff2b87fd0dad990ULL, -0x1.d219b1a6fbffap-60 },
+	{ 0x3ff2d285a6e4030bULL, 0x1.b3782720c0ab4p-55 },
+	{ 0x3ff2ecafa93e2f56ULL, 0x1.e149289cecb8fp-57 },
+	{ 0x3ff306fe0a31b715ULL, 0x1.34d754db0abb6p-55 },
+	{ 0x3ff32170fc4cd831ULL, 0x1.64201e2ac744cp-55 },
+	{ 0x3ff33c08b26416ffULL, 0x1.fdd395dd3f84ap-55 },
+	{ 0x3ff356c55f929ff1ULL, -0x1.6a3803b8e5b04p-55 },
+	{ 0x3ff371a7373aa9cbULL, -0x1.24aedcc4b5068p-54 },
+	{ 0x3ff38cae6d05d866ULL, -0x1.907f81b512d8ep-54 },
+	{ 0x3ff3a7db34e59ff7ULL, -0x1.1d1e83e9436d2p-56 },
+	{ 0x3ff3c32dc313a8e5ULL, -0x1.91919b3ce1b15p-54 },
+	{ 0x3ff3dea64c123422ULL, 0x1.59f48a72a4c6dp-55 },
+	{ 0x3ff3fa4504ac801cULL, -0x1.312607a28698ap-54 },
+	{ 0x3ff4160a21f72e2aULL, -0x1.8a78f4817895bp-58 },
+	{ 0x3ff431f5d950a897ULL, -0x1.c2c9b67499a1bp-56 },
+	{ 0x3ff44e086061892dULL, 0x1.363ed60c2ac11p-59 },
+	{ 0x3ff46a41ed1d0057ULL, 0x1.666093b0664efp-54 },
+	{ 0x3ff486a2b5c13cd0ULL, 0x1.ecce1daa10379p-57 },
+	{ 0x3ff4a32af0d7d3deULL, 0x1.3ff8e3f0f1230p-54 },
+	{ 0x3ff4bfdad5362a27ULL, 0x1.690cebb7aafb0p-56 },
+	{ 0x3ff4dcb299fddd0dULL, 0x1.31dbdeb54e077p-54 },
+	{ 0x3ff4f9b2769d2ca7ULL, -0x1.f94340071a38ep-55 },
+	{ 0x3ff516daa2cf6642ULL, -0x1.7deccdc93a349p-55 },
+	{ 0x3ff5342b569d4f82ULL, -0x1.8dec6bd0f385fp-56 },
+	{ 0x3ff551a4ca5d920fULL, -0x1.61246ec7b5cf6p-55 },
+	{ 0x3ff56f4736b527daULL, 0x1.3350518fdd78ep-54 },
+	{ 0x3ff58d12d497c7fdULL, 0x1.b98b72f8a9b05p-56 },
+	{ 0x3ff5ab07dd485429ULL, 0x1.063e1e21c5409p-54 },
+	{ 0x3ff5c9268a5946b7ULL, 0x1.4c7855019c6eap-60 },
+	{ 0x3ff5e76f15ad2148ULL, 0x1.432e62b64c035p-54 },
+	{ 0x3ff605e1b976dc09ULL, -0x1.ce44a6199769fp-55 },
+	{ 0x3ff6247eb03a5585ULL, -0x1.c33c53bef4da8p-55 },
+	{ 0x3ff6434634ccc320ULL, -0x1.45378892be9aep-55 },
+	{ 0x3ff6623882552225ULL, -0x1.3cedd78565858p-54 },
+	{ 0x3ff68155d44ca973ULL, 0x1.710aa807e1964p-58 },
+	{ 0x3ff6a09e667f3bcdULL, -0x1.3b3efbf5e2228p-54 },
+	{ 0x3ff6c012750bdabfULL, -0x1.a12ad8734b982p-57 },
+	{ 0x3ff6dfb23c651a2fULL, -0x1.367efb86da9eep-57 },
+	{ 0x3ff6ff7df9519484ULL, -0x1.0dc3d54e08851p-55 },
+	{ 0x3ff71f75e8ec5f74ULL, -0x1.81f647e5a3ecfp-56 },
+	{ 0x3ff73f9a48a58174ULL, -0x1.6ee4ac08b7db0p-55 },
+	{ 0x3ff75feb564267c9ULL, -0x1.619321e55e68ap-55 },
+	{ 0x3ff780694fde5d3fULL, 0x1.09ccb5e09d4d3p-54 },
+	{ 0x3ff7a11473eb0187ULL, -0x1.b32dcb94da51dp-56 },
+	{ 0x3ff7c1ed0130c132ULL, 0x1.4ecfd5467c06bp-54 },
+	{ 0x3ff7e2f336cf4e62ULL, 0x1.5ebe1abd66c55p-57 },
+	{ 0x3ff80427543e1a12ULL, -0x1.8a1c52fb3cf42p-55 },
+	{ 0x3ff82589994cce13ULL, -0x1.369b6f13b3734p-54 },
+	{ 0x3ff8471a4623c7adULL, -0x1.05e843a19ff1ep-55 },
+	{ 0x3ff868d99b4492edULL, -0x1.4d450d872576ep-54 },
+	{ 0x3ff88ac7d98a6699ULL, 0x1.0ad675b0e8a00p-54 },
+	{ 0x3ff8ace5422aa0dbULL, 0x1.db72fc1f0eab4p-55 },
+	{ 0x3ff8cf3216b5448cULL, -0x1.5b6609cc5e7ffp-57 },
+	{ 0x3ff8f1ae99157736ULL, 0x1.bf68359f35f44p-56 },
+	{ 0x3ff9145b0b91ffc6ULL, -0x1.3091fa71e3d83p-54 },
+	{ 0x3ff93737b0cdc5e5ULL, -0x1.da9b88b6c1e29p-58 },
+	{ 0x3ff95a44cbc8520fULL, -0x1.c23f97c90b959p-57 },
+	{ 0x3ff97d829fde4e50ULL, -0x1.2434322f4f9aap-54 },
+	{ 0x3ff9a0f170ca07baULL, -0x1.5ca6cd7668e4bp-55 },
+	{ 0x3ff9c49182a3f090ULL, 0x1.1affc2b91ce27p-56 },
+	{ 0x3ff9e86319e32323ULL, 0x1.dd235e10a73bbp-57 },
+	{ 0x3ffa0c667b5de565ULL, -0x1.7c50422622263p-55 },
+	{ 0x3ffa309bec4a2d33ULL, 0x1.b1c86e3e231d5p-55 },
+	{ 0x3ffa5503b23e255dULL, -0x1.1bbd1d3bcbb15p-54 },
+	{ 0x3ffa799e1330b358ULL, 0x1.0cc319cee31d2p-54 },
+	{ 0x3ffa9e6b5579fdbfULL, 0x1.469846e735ab3p-55 },
+	{ 0x3ffac36bbfd3f37aULL, -0x1.2dfcd978e9db4p-55 },
+	{ 0x3ffae89f995ad3adULL, 0x1.c1a7792cb3387p-55 },
+	{ 0x3ffb0e07298db666ULL, -0x1.07b8f4ad1d9fap-54 },
+	{ 0x3ffb33a2b84f15fbULL, -0x1.5c3d956dcaebap-58 },
+	{ 0x3ffb59728de5593aULL, -0x1.0a40e3da6f640p-54 },
+	{ 0x3ffb7f76f2fb5e47ULL, -0x1.8d6f438ad9334p-57 },
+	{ 0x3ffba5b030a1064aULL, -0x1.1eee26b588a35p-54 },
+	{ 0x3ffbcc1e904bc1d2ULL, 0x1.4ffd70a5fddcdp-56 },
+	{ 0x3ffbf2c25bd71e09ULL, -0x1.1bdfbfa9298acp-54 },
+	{ 0x3ffc199bdd85529cULL, 0x1.36eae30af0cb3p-56 },
+	{ 0x3ffc40ab5fffd07aULL, 0x1.ee3325c9ffd94p-55 },
+	{ 0x3ffc67f12e57d14bULL, 0x1.4e08fd10959acp-55 },
+	{ 0x3ffc8f6d9406e7b5ULL, 0x1.3cdaf384e1a67p-57 },
+	{ 0x3ffcb720dcef9069ULL, 0x1.76b2c6c921968p-57 },
+	{ 0x3ffcdf0b555dc3faULL, -0x1.08a1883ccb5d2p-55 },
+	{ 0x3ffd072d4a07897cULL, -0x1.fad5d3ffffa6fp-55 },
+	{ 0x3ffd2f87080d89f2ULL, -0x1.00dae3875a949p-54 },
+	{ 0x3ffd5818dcfba487ULL, 0x1.4a385a63d07a7p-56 },
+	{ 0x3ffd80e316c98398ULL, -0x1.2919e2040220fp-55 },
+	{ 0x3ffda9e603db3285ULL, 0x1.e5a50d5c192acp-55 },
+	{ 0x3ffdd321f301b460ULL, 0x1.43a59ac016b4bp-55 },
+	{ 0x3ffdfc97337b9b5fULL, -0x1.2d52107b43e1fp-55 },
+	{ 0x3ffe264614f5a129ULL, -0x1.92ab93b470dc9p-55 },
+	{ 0x3ffe502ee78b3ff6ULL, 0x1.4b604603a88d3p-56 },
+	{ 0x3ffe7a51fbc74c83ULL, 0x1.3c5ec519d7271p-55 },
+	{ 0x3ffea4afa2a490daULL, -0x1.ff7128fd391f0p-55 },
+	{ 0x3ffecf482d8e67f1ULL, -0x1.dae98e223747dp-55 },
+	{ 0x3ffefa1bee615a27ULL, 0x1.ec3bc41aa2008p-55 },
+	{ 0x3fff252b376bba97ULL, 0x1.42b94c3a9eb32p-55 },
+	{ 0x3fff50765b6e4540ULL, 0x1.a64a931d185eep-55 },
+	{ 0x3fff7bfdad9cbe14ULL, -0x1.e37bae43be3edp-55 },
+	{ 0x3fffa7c1819e90d8ULL, 0x1.7893b4d91cd9dp-56 },
+	{ 0x3fffd3c22b8f71f1ULL, 0x1.305c14160cc89p-58 },
+};
+
+static const double
+ln2hi = 0x1.62e42fefa3800p-1,		/* A multiple of 2^-42. */
+ln2lo = 0x1.ef35793c76730p-45,
+/* log1p(r) - r + r^2/2. */
+L3 = 1.0 / 3,
+L4 = -1.0 / 4,
+L5 = 1.0 / 5,
+L6 = -1.0 / 6,
+L7 = 1.0 / 7,
+L8 = -1.0 / 8,
+L9 = 1.0 / 9,
+invln2N = 0x1.71547652b82fep+7,
+ln2hiN = 0x1.62e42fefa0000p-8,		/* Low 17 bits zero. */
+ln2loN = 0x1.cf79abc9e3b3ap-47,
+/* exp(r) - 1 - r. */
+E2 = 1.0 / 2,
+E3 = 1.0 / 6,
+E4 = 1.0 / 24,
+E5 = 1.0 / 120;
+
+static volatile double
+huge = 1.0e300,
+tiny = 1.0e-300;
+
+/* log(x) for positive normal x, in bits, as hi + *lo. */
+static inline double
+log_inline(uint64_t ix, double *lo)
+{
+	double z, invc, p, rh, rl, kd, t1, t2, hi, ar, ar2, r2, poly, lsum, y;
+	uint64_t tmp, iz;
+	int i, k;
+
+	tmp = ix - LOG_OFF;
+	i = (tmp >> (52 - LOG_TABLE_BITS)) % LOG_N;
+	k = (int64_t)tmp >> 52;
+	iz = ix - (tmp & 0xfffULL << 52);
+	INSERT_WORD64(z, iz);
+	kd = k;
+
+	/* rh + rl = z * invc - 1 exactly: z * invc is near 1. */
+	invc = log_table[i].invc;
+	p = z * invc;
+	rl = __builtin_fma(z, invc, -p);
+	rh = p - 1.0;
+
+	/* k*ln2 + log(c) + rh, with the rounding error of the sum in lsum. */
+	t1 = kd * ln2hi + log_table[i].logc;
+	t2 = t1 + rh;
+	lsum = kd * ln2lo + log_table[i].logctail +
+	    ((t1 - (t2 - (t2 - t1))) + (rh - (t2 - t1)));
+
+	/* Then -rh^2/2, again keeping the rounding errors. */
+	ar = -0.5 * rh;
+	ar2 = rh * ar;
+	hi = t2 + ar2;
+	lsum += __builtin_fma(ar, rh, -ar2) + ((t2 - hi) + ar2);
+
+	/* The rest of log1p(rh), and rl/(1 + rh). */
+	r2 = rh * rh;
+	poly = r2 * rh * (L3 + rh * L4 + r2 * (L5 + rh * L6) +
+	    r2 * r2 * (L7 + rh * L8 + r2 * L9));
+	lsum += poly + rl * (1.0 - rh + r2);
+
+	y = hi + lsum;
+	*lo = (hi - y) + lsum;
+	return (y);
+}
+
+/*
+ * exp(x + xtail) when k = round(x * N / ln2) is too big for the exponent
+ * field: scale the other way, then undo it with a multiply that overflows
+ * or underflows correctly.
+ */
+static inline double
+exp_special(double tmp, uint64_t sbits, double kd)
+{
+	volatile double underflow;
+	double scale, y, one, hi, lo;
+
+	if (kd > 0) {
+		sbits -= 1009ULL << 52;
+		INSERT_WORD64(scale, sbits);
+		return (0x1p1009 * __builtin_fma(scale, tmp, scale));
+	}
+	sbits += 1022ULL << 52;
+	INSERT_WORD64(scale, sbits);
+	y = __builtin_fma(scale, tmp, scale);
+	if (fabs(y) < 1.0) {
+		/*
+		 * The result is subnormal: round y once, at the precision
+		 * it'll have after scaling, by adding it to 1. The scaling
+		 * is then exact, so raise underflow by hand.
+		 */
+		one = y < 0.0 ? -1.0 : 1.0;
+		lo = __builtin_fma(scale, tmp, scale - y);
+		hi = one + y;
+		lo = one - hi + y + lo;
+		y = (hi + lo) - one;
+		if (y == 0.0)
+			y = 0.0 * scale;	/* Keep the sign. */
+		underflow = tiny * tiny;
+		(void)underflow;
+	}
+	return (0x1p-1022 * y);
+}
+
+/* exp(x + xtail), negated if sign is set. */
+static inline double
+exp_inline(double x, double xtail, uint32_t sign)
+{
+	double kd, r, tmp, scale, r2;
+	uint64_t ix, ki, sbits;
+	uint32_t abstop;
+	int idx;
+
+	EXTRACT_WORD64(ix, x);
+	abstop = (ix >> 52) & 0x7ff;
+	if (abstop - 0x3c9 >= 0x408 - 0x3c9) {
+		if (abstop < 0x3c9) {
+			/* |x| < 2^-54: exp(x) rounds to 1 (or its neighbor). */
+			return (sign ? -(1.0 + x) : 1.0 + x);
+		}
+		if (abstop >= 0x409) {
+			/* |x| >= 1024: certain overflow or underflow. */
+			if ((int64_t)ix < 0)
+				return (sign ? -tiny * tiny : tiny * tiny);
+			return (sign ? -huge * huge : huge * huge);
+		}
+		/* 512 <= |x| < 1024: maybe over- or underflow. */
+		abstop = 0;
+	}
+
+	kd = __builtin_fma(x, invln2N, 0x1.8p52);
+	EXTRACT_WORD64(ki, kd);
+	kd -= 0x1.8p52;
+	/* Exact: r is small and on the grid of the finer of the two terms. */
+	r = __builtin_fma(-kd, ln2hiN, x);
+	r = __builtin_fma(-kd, ln2loN, r) + xtail;
+
+	/* The low bits of ki are k, so this adds k / N to the exponent. */
+	idx = ki % EXP_N;
+	sbits = exp_table[idx].bits + ((ki >> EXP_TABLE_BITS) << 52) +
+	    ((uint64_t)sign << 63);
+	r2 = r * r;
+	tmp = exp_table[idx].tail + r + r2 * (E2 + r * E3) +
+	    r2 * r2 * (E4 + r * E5);
+	if (abstop == 0)
+		return (exp_special(tmp, sbits, kd));
+	INSERT_WORD64(scale, sbits);
+	return (__builtin_fma(scale, tmp, scale));
+}
+
+/* 0 if y isn't an integer, 1 if it's odd, 2 if it's even. */
+static inline int
+checkint(uint64_t iy)
+{
+	int e = (iy >> 52) & 0x7ff;
+
+	if (e < 0x3ff)
+		return (0);
+	if (e > 0x3ff + 52)
+		return (2);
+	if (iy & ((1ULL << (0x3ff + 52 - e)) - 1))
+		return (0);
+	if (iy & (1ULL << (0x3ff + 52 - e)))
+		return (1);
+	return (2);
+}
+
+/* Is x (in bits) zero, infinite or NaN? */
+static inline int
+zeroinfnan(uint64_t i)
+{
+	return (2 * i - 1 >= 2 * 0x7ff0000000000000ULL - 1);
+}
+
+double
+pow(double x, double y)
+{
+	double lhi, llo, ehi, elo;
+	uint64_t ix, iy;
+	uint32_t sign = 0, topx, topy;
+	int yint;
+
+	EXTRACT_WORD64(ix, x);
+	EXTRACT_WORD64(iy, y);
+	topx = ix >> 52;
+	topy = (iy >> 52) & 0x7ff;
+	if (topx - 0x001 >= 0x7ff - 0x001 || topy - 0x3be >= 0x43e - 0x3be) {
+		/*
+		 * x is zero, subnormal, negative, infinite or NaN, or |y| is
+		 * below 2^-65, at least 2^63, infinite or NaN.
+		 */
+		if (zeroinfnan(iy)) {
+			if (2 * iy == 0)
+				return (1.0);	/* pow(x, +-0) = 1, even for NaN */
+			if (ix == 0x3ff0000000000000ULL)
+				return (1.0);	/* pow(1, y) = 1, even for NaN */
+			if (2 * ix > 2 * 0x7ff0000000000000ULL ||
+			    2 * iy > 2 * 0x7ff0000000000000ULL)
+				return (x + y);
+			if (2 * ix == 2 * 0x3ff0000000000000ULL)
+				return (1.0);	/* pow(-1, +-inf) = 1 */
+			if ((2 * ix < 2 * 0x3ff0000000000000ULL) == !(iy >> 63))
+				return (0.0);	/* |x| < 1 and y = inf, etc. */
+			return (y * y);
+		}
+		if (zeroinfnan(ix)) {
+			double x2 = x * x;
+			if ((ix >> 63) && checkint(iy) == 1)
+				x2 = -x2;
+			/* Divide by zero for pow(+-0, negative). */
+			return ((iy >> 63) ? 1 / x2 : x2);
+		}
+		if (ix >> 63) {
+			/* Finite x < 0. */
+			yint = checkint(iy);
+			if (yint == 0)
+				return ((x - x) / (x - x));
+			if (yint == 1)
+				sign = 1;
+			ix &= 0x7fffffffffffffffULL;
+			topx &= 0x7ff;
+		}
+		if (topy - 0x3be >= 0x43e - 0x3be) {
+			if (ix == 0x3ff0000000000000ULL)
+				return (1.0);
+			if (topy < 0x3be) {
+				/* |y| < 2^-65: the result rounds to 1. */
+				return (ix > 0x3ff0000000000000ULL ? 1.0 + y :
+				    1.0 - y);
+			}
+			/* |y| >= 2^63: the result over- or underflows. */
+			if ((ix > 0x3ff0000000000000ULL) == !(iy >> 63))
+				return (huge * huge);
+			return (tiny * tiny);
+		}
+		if (topx == 0) {
+			/* Subnormal x: normalize it. */
+			INSERT_WORD64(x, ix);
+			x *= 0x1p52;
+			EXTRACT_WORD64(ix, x);
+			ix -= 52ULL << 52;
+		}
+	}
+
+	lhi = log_inline(ix, &llo);
+	ehi = y * lhi;
+	elo = __builtin_fma(y, lhi, -ehi) + y * llo;
+	return (exp_inline(ehi, elo, sign));
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _BIONIC_LIBM_ARM64_REM_PIO2_H_included
+#define _BIONIC_LIBM_ARM64_REM_PIO2_H_included
+
+/*
+ * Argument reduction for sin, cos, sincos and tan: y[0] + y[1] = x - n*pi/2
+ * with |y[0] + y[1]| <= pi/4, returning n. Arguments below 2^20 * pi/2 use
+ * the Cody-Waite scheme of msun's e_rem_pio2.c with fused multiply-adds;
+ * larger ones go to __rem_pio2_large. x must be finite.
+ */
+
+#include <stdint.h>
+
+#include "math_private.h"
+
+int __rem_pio2_large(double x, double *y);
+
+static const double
+invpio2 = 6.36619772367581382433e-01,	/* 0x3FE45F30, 0x6DC9C883 */
+pio2_1  = 1.57079632673412561417e+00,	/* 0x3FF921FB, 0x54400000 */
+pio2_1t = 6.07710050650619224932e-11,	/* 0x3DD0B461, 0x1A626331 */
+pio2_2  = 6.07710050630396597660e-11,	/* 0x3DD0B461, 0x1A600000 */
+pio2_2t = 2.02226624879595063154e-21,	/* 0x3BA3198A, 0x2E037073 */
+pio2_3  = 2.02226624871116645580e-21,	/* 0x3BA3198A, 0x2E000000 */
+pio2_3t = 8.47842766036889956997e-32;	/* 0x397B839A, 0x252049C1 */
+
+static inline int
+__rem_pio2_fast(double x, double *y)
+{
+	double fn, r, t, w;
+	uint64_t ix;
+	int j;
+
+	EXTRACT_WORD64(ix, x);
+	j = (ix >> 52) & 0x7ff;
+	if ((ix & 0x7fffffffffffffffULL) >= 0x413921fb54442d18ULL)
+		return (__rem_pio2_large(x, y));
+
+	fn = __builtin_fma(x, invpio2, 0x1.8p52) - 0x1.8p52;
+	r = __builtin_fma(-fn, pio2_1, x);	/* exact: pio2_1 has 33 bits */
+	w = fn * pio2_1t;
+	y[0] = r - w;
+	EXTRACT_WORD64(ix, y[0]);
+	if (j - (int)((ix >> 52) & 0x7ff) > 16) {
+		/* Cancellation: take another 33 bits of pi/2, then another. */
+		t = r;
+		r = __builtin_fma(-fn, pio2_2, t);
+		w = __builtin_fma(fn, pio2_2t, -((t - r) - fn * pio2_2));
+		y[0] = r - w;
+		EXTRACT_WORD64(ix, y[0]);
+		if (j - (int)((ix >> 52) & 0x7ff) > 49) {
+			t = r;
+			r = __builtin_fma(-fn, pio2_3, t);
+			w = __builtin_fma(fn, pio2_3t, -((t - r) - fn * pio2_3));
+			y[0] = r - w;
+		}
+	}
+	y[1] = (r - y[0]) - w;
+	return ((int)fn);
+}
+
+#endif
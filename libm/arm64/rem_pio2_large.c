@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Payne-Hanek reduction of |x| >= 2^20 * pi/2 for rem_pio2.h. Of the bits
+ * of 2/pi, those that would only add a multiple of 4 to x * 2/pi can be
+ * skipped, so three 64-bit words starting just above the binary point of
+ * x * 2/pi are enough: two bits of n and 190 bits of fraction.
+ */
+
+#include <stdint.h>
+
+#include "math_private.h"
+
+#include "rem_pio2.h"
+
+typedef __uint128_t uint128_t;
+
+/* The integer part of 2/pi, then its fraction bits, 64 to a word. */
+static const uint64_t two_over_pi[20] = {
+	0x0000000000000000ULL, 0xa2f9836e4e441529ULL,
+	0xfc2757d1f534ddc0ULL, 0xdb6295993c439041ULL,
+	0xfe5163abdebbc561ULL, 0xb7246e3a424dd2e0ULL,
+	0x06492eea09d1921cULL, 0xfe1deb1cb129a73eULL,
+	0xe88235f52ebb4484ULL, 0xe99c7026b45f7e41ULL,
+	0x3991d639835339f4ULL, 0x9c845f8bbdf9283bULL,
+	0x1ff897ffde05980fULL, 0xef2f118b5a0a6d1fULL,
+	0x6d367ecf27cb09b7ULL, 0x4f463f669e5fea2dULL,
+	0x7527bac7ebe5f17bULL, 0x3d0739f78a5292eaULL,
+	0x6bfb5fb11f8d5d08ULL, 0x56033046fc7b6babULL,
+};
+
+static const double
+pio2_hi = 0x1.921fb54442d18p0,
+pio2_lo = 0x1.1a62633145c07p-54;
+
+static inline uint64_t
+bits_at(int k, int sh)
+{
+	if (sh == 0)
+		return (two_over_pi[k]);
+	return ((two_over_pi[k] << sh) | (two_over_pi[k + 1] >> (64 - sh)));
+}
+
+int
+__rem_pio2_large(double x, double *y)
+{
+	uint64_t ix, m, w0, w1, w2, hi, mid, lo, a, b;
+	uint128_t p1, p2, sum;
+	double fh, fl, scale, rh, rl;
+	int e, j, n, neg, z;
+
+	EXTRACT_WORD64(ix, x);
+	m = (ix & 0x000fffffffffffffULL) | 0x0010000000000000ULL;
+	e = (int)((ix >> 52) & 0x7ff) - 1075;	/* |x| = m * 2^e, e > -32 */
+
+	/*
+	 * Bit j of the table has weight 2^(63 - j), and bits above weight
+	 * 2^(1 - e) only contribute multiples of 4.
+	 */
+	j = e + 62;
+	w0 = bits_at(j >> 6, j & 63);
+	w1 = bits_at((j >> 6) + 1, j & 63);
+	w2 = bits_at((j >> 6) + 2, j & 63);
+
+	/* m * (w0:w1:w2), keeping the low 192 bits, has its point at bit 190. */
+	p2 = (uint128_t)m * w2;
+	p1 = (uint128_t)m * w1;
+	lo = (uint64_t)p2;
+	sum = (p2 >> 64) + (uint64_t)p1;
+	mid = (uint64_t)sum;
+	hi = m * w0 + (uint64_t)(p1 >> 64) + (uint64_t)(sum >> 64);
+
+	/* Round to the nearest n, leaving a fraction in [-1/2, 1/2). */
+	n = (int)((hi + (1ULL << 61)) >> 62);
+	hi -= (uint64_t)n << 62;
+	neg = (int64_t)hi < 0;
+	if (neg) {
+		/* One's complement is within 2^-190 of the negation. */
+		hi = ~hi;
+		mid = ~mid;
+		lo = ~lo;
+	}
+
+	/* Normalize. For any double the fraction is above 2^-63. */
+	e = -62;
+	if (hi == 0) {
+		hi = mid;
+		mid = lo;
+		lo = 0;
+		e -= 64;
+	}
+	z = __builtin_clzll(hi);
+	a = hi;
+	b = mid;
+	if (z != 0) {
+		a = (hi << z) | (mid >> (64 - z));
+		b = (mid << z) | (lo >> (64 - z));
+	}
+	e -= z;
+
+	/* fh + fl = a * 2^e + b * 2^(e - 64), to about 2^-117 relative. */
+	INSERT_WORD64(scale, (uint64_t)(e + 11 + 1023) << 52);
+	fh = (double)(a >> 11) * scale;
+	INSERT_WORD64(scale, (uint64_t)(e - 53 + 1023) << 52);
+	fl = (double)(((a & 0x7ff) << 53) | (b >> 11)) * scale;
+
+	/* Multiply by pi/2 as a double-double. */
+	rh = fh * pio2_hi;
+	rl = __builtin_fma(fh, pio2_hi, -rh);
+	rl = __builtin_fma(fh, pio2_lo, __builtin_fma(fl, pio2_hi, rl));
+	y[0] = rh + rl;
+	y[1] = (rh - y[0]) + rl;
+
+	if (neg) {
+		y[0] = -y[0];
+		y[1] = -y[1];
+	}
+	if ((int64_t)ix < 0) {
+		y[0] = -y[0];
+		y[1] = -y[1];
+		return (-n);
+	}
+	return (n);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * sin, cos and sincos with msun's kernels and the reduction in rem_pio2.h.
+ * sincos reduces its argument once for both results.
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "math_private.h"
+
+#include "rem_pio2.h"
+
+double
+sin(double x)
+{
+	double y[2];
+	int32_t ix;
+	int n;
+
+	GET_HIGH_WORD(ix, x);
+	ix &= 0x7fffffff;
+	if (ix <= 0x3fe921fb) {			/* |x| ~<= pi/4 */
+		if (ix < 0x3e500000 && (int)x == 0)	/* |x| < 2^-26 */
+			return (x);		/* with inexact if x != 0 */
+		return (__kernel_sin(x, 0.0, 0));
+	}
+	if (ix >= 0x7ff00000)			/* Inf or NaN */
+		return (x - x);
+
+	n = __rem_pio2_fast(x, y);
+	switch (n & 3) {
+	case 0:
+		return (__kernel_sin(y[0], y[1], 1));
+	case 1:
+		return (__kernel_cos(y[0], y[1]));
+	case 2:
+		return (-__kernel_sin(y[0], y[1], 1));
+	default:
+		return (-__kernel_cos(y[0], y[1]));
+	}
+}
+
+double
+cos(double x)
+{
+	double y[2];
+	int32_t ix;
+	int n;
+
+	GET_HIGH_WORD(ix, x);
+	ix &= 0x7fffffff;
+	if (ix <= 0x3fe921fb) {
+		if (ix < 0x3e46a09e && (int)x == 0)	/* |x| < 2^-27 * sqrt(2) */
+			return (1.0);
+		return (__kernel_cos(x, 0.0));
+	}
+	if (ix >= 0x7ff00000)
+		return (x - x);
+
+	n = __rem_pio2_fast(x, y);
+	switch (n & 3) {
+	case 0:
+		return (__kernel_cos(y[0], y[1]));
+	case 1:
+		return (-__kernel_sin(y[0], y[1], 1));
+	case 2:
+		return (-__kernel_cos(y[0], y[1]));
+	default:
+		return (__kernel_sin(y[0], y[1], 1));
+	}
+}
+
+void
+sincos(double x, double *s, double *c)
+{
+	double y[2], sy, cy;
+	int32_t ix;
+	int n;
+
+	GET_HIGH_WORD(ix, x);
+	ix &= 0x7fffffff;
+	if (ix <= 0x3fe921fb) {
+		if (ix < 0x3e46a09e && (int)x == 0) {
+			*s = x;
+			*c = 1.0;
+			return;
+		}
+		*s = __kernel_sin(x, 0.0, 0);
+		*c = __kernel_cos(x, 0.0);
+		return;
+	}
+	if (ix >= 0x7ff00000) {
+		*s = *c = x - x;
+		return;
+	}
+
+	n = __rem_pio2_fast(x, y);
+	sy = __kernel_sin(y[0], y[1], 1);
+	cy = __kernel_cos(y[0], y[1]);
+	switch (n & 3) {
+	case 0:
+		*s = sy;
+		*c = cy;
+		break;
+	case 1:
+		*s = cy;
+		*c = -sy;
+		break;
+	case 2:
+		*s = -sy;
+		*c = -cy;
+		break;
+	default:
+		*s = -cy;
+		*c = sy;
+		break;
+	}
+}
@@ -0,0 +1,77 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Advanced SIMD: the vector ABI's "n" variants, two doubles or four floats
+ * per call, plus the two-float variants on 64-bit vectors that GCC also
+ * calls. These use the vector procedure call standard. The array functions
+ * of <android/array_math.h> are here too.
+ */
+
+#include <android/array_math.h>
+#include <arm_neon.h>
+
+#define	VEC_BYTES		16
+#define	VEC_TARGET
+#define	VEC_ABI			__attribute__((__aarch64_vector_pcs__))
+#define	DOUBLE_NAME(params, name)	_ZGVnN2 ## params ## _ ## name
+#define	FLOAT_NAME(params, name)	_ZGVnN4 ## params ## _ ## name ## f
+
+#define	vec_any(m)		(vmaxvq_u32((uint32x4_t)(m)) != 0)
+#define	vec_widen_lo(x)		((vd_t)vcvt_f64_f32(vget_low_f32((float32x4_t)(x))))
+#define	vec_widen_hi(x)		((vd_t)vcvt_high_f64_f32((float32x4_t)(x)))
+#define	vec_narrow(lo, hi)	\
+	((vf_t)vcvt_high_f32_f64(vcvt_f32_f64((float64x2_t)(lo)), (float64x2_t)(hi)))
+
+#include "../vector_math.h"
+
+#define	vec_sqrt_f(x)		((vf_t)vsqrtq_f32((float32x4_t)(x)))
+#define	ARRAY_NAME(name)	android_math_ ## name ## _array
+
+#include "../array_math.h"
+
+#define	FLOAT2_V(name)							\
+VEC_PUBLIC float32x2_t							\
+_ZGVnN2v_ ## name ## f(float32x2_t x)					\
+{									\
+	return (vget_low_f32((float32x4_t)FLOAT_NAME(v, name)(		\
+	    (vf_t)vcombine_f32(x, x))));				\
+}
+
+#define	FLOAT2_VV(name)							\
+VEC_PUBLIC float32x2_t							\
+_ZGVnN2vv_ ## name ## f(float32x2_t x, float32x2_t y)			\
+{									\
+	return (vget_low_f32((float32x4_t)FLOAT_NAME(vv, name)(	\
+	    (vf_t)vcombine_f32(x, x), (vf_t)vcombine_f32(y, y))));	\
+}
+
+FLOAT2_V(exp)
+FLOAT2_V(log)
+FLOAT2_VV(pow)
+FLOAT2_V(sin)
+FLOAT2_V(cos)
+FLOAT2_V(tanh)
@@ -1,8 +1,5 @@
-/*	$OpenBSD: wcsstr.c,v 1.3 2005/08/08 08:05:37 espie Exp $	*/
-/*	$NetBSD: wcsstr.c,v 1.3 2003/03/05 20:18:17 tshiozak Exp $	*/
-
 /*-
- * Copyright (c)1999 Citrus Project,
+ * Copyright (C) 2014 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -25,46 +22,35 @@
  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
  * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
- *
- *	citrus Id: wcsstr.c,v 1.2 2000/12/21 05:07:25 itojun Exp
  */
 
-#include <wchar.h>
 
-wchar_t *
-#ifdef WCSWCS
-wcswcs(const wchar_t *big, const wchar_t *little)
-#else
-wcsstr(const wchar_t *big, const wchar_t *little)
-#endif
-{
-	const wchar_t *p;
-	const wchar_t *q;
-	const wchar_t *r;
+/*
+ * The array functions of <android/array_math.h> for architectures without
+ * vector versions of the functions: arm64 and x86_64 build them from
+ * vector_math.h (see array_math.h).
+ */
 
-	if (!*little) {
-		/* LINTED interface specification */
-		return (wchar_t *)big;
-	}
-	if (wcslen(big) < wcslen(little))
-		return NULL;
+#include <android/array_math.h>
+#include <math.h>
 
-	p = big;
-	q = little;
-	while (*p) {
-		q = little;
-		r = p;
-		while (*q) {
-			if (*r != *q)
-				break;
-			q++;
-			r++;
-		}
-		if (!*q) {
-			/* LINTED interface specification */
-			return (wchar_t *)p;
-		}
-		p++;
-	}
-	return NULL;
+#if !defined(__aarch64__) && !defined(__x86_64__)
+
+#define	ARRAY_F(name)							\
+void									\
+android_math_ ## name ## _array(const float *in, float *out, size_t n)	\
+{									\
+	size_t i;							\
+									\
+	for (i = 0; i < n; i++)						\
+		out[i] = name(in[i]);					\
 }
+
+ARRAY_F(expf)
+ARRAY_F(logf)
+ARRAY_F(sinf)
+ARRAY_F(cosf)
+ARRAY_F(sqrtf)
+ARRAY_F(tanhf)
+
+#endif
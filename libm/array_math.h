@@ -0,0 +1,73 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The android_math_*f_array functions of <android/array_math.h>, on top of
+ * the vector functions of vector_math.h. The including file defines
+ * ARRAY_NAME(name) to name the functions and vec_sqrt_f(x), and includes
+ * this after vector_math.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+VEC_INLINE vf_t
+sqrt_f(vf_t x)
+{
+	return (vec_sqrt_f(x));
+}
+
+/*
+ * Whole vectors go straight through. The last partial vector is padded
+ * with ones, which every function takes without a special case.
+ */
+#define	ARRAY_F(name, vec_f)						\
+VEC_TARGET void								\
+ARRAY_NAME(name)(const float *in, float *out, size_t n)			\
+{									\
+	vf_t x;								\
+	size_t i, j;							\
+									\
+	for (i = 0; i + VF_LANES <= n; i += VF_LANES) {			\
+		memcpy(&x, in + i, sizeof(x));				\
+		x = vec_f(x);						\
+		memcpy(out + i, &x, sizeof(x));				\
+	}								\
+	if (i == n)							\
+		return;							\
+	for (j = 0; j < VF_LANES; j++)					\
+		x[j] = (i + j < n) ? in[i + j] : 1.0f;			\
+	x = vec_f(x);							\
+	for (j = 0; i + j < n; j++)					\
+		out[i + j] = x[j];					\
+}
+
+ARRAY_F(expf, FLOAT_NAME(v, exp))
+ARRAY_F(logf, FLOAT_NAME(v, log))
+ARRAY_F(sinf, FLOAT_NAME(v, sin))
+ARRAY_F(cosf, FLOAT_NAME(v, cos))
+ARRAY_F(sqrtf, sqrt_f)
+ARRAY_F(tanhf, FLOAT_NAME(v, tanh))
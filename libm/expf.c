@@ -1,11 +1,7 @@
-/*	$OpenBSD: strstr.c,v 1.5 2005/08/08 08:05:37 espie Exp $ */
-/*-
- * Copyright (c) 1990 The Regents of the University of California.
+/*
+ * Copyright (C) 2014 The Android Open Source Project
  * All rights reserved.
  *
- * This code is derived from software contributed to Berkeley by
- * Chris Torek.
- *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions
  * are met:
@@ -14,14 +10,11 @@
  * 2. Redistributions in binary form must reproduce the above copyright
  *    notice, this list of conditions and the following disclaimer in the
  *    documentation and/or other materials provided with the distribution.
- * 3. Neither the name of the University nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
  *
- * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
  * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
  * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
  * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
  * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
  * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
@@ -29,28 +22,38 @@
  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
  * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
+ *
  */
 
-#include <string.h>
+#include "float_tables.h"
+
+static const double
+invln2N	= 0x1.71547652b82fep+5;		/* N/ln2 */
+
+static volatile float
+huge	= 1.0e+30,
+twom100 = 7.8886090522e-31;		/* 2**-100=0x0d800000 */
 
 /*
- * Find the first occurrence of find in s.
+ * exp(x) = 2**(x * N/ln2 / N), in double throughout: the product needs no
+ * extra precision because |x * N/ln2| < 2**12 leaves 41 bits for the
+ * fraction, and the result is within 0.51 ulp.
  */
-char *
-strstr(const char *s, const char *find)
+float
+expf(float x)
 {
-	char c, sc;
-	size_t len;
+	uint32_t hx;
 
-	if ((c = *find++) != 0) {
-		len = strlen(find);
-		do {
-			do {
-				if ((sc = *s++) == 0)
-					return (NULL);
-			} while (sc != c);
-		} while (strncmp(s, find, len) != 0);
-		s--;
+	GET_FLOAT_WORD(hx, x);
+	if ((hx & 0x7fffffff) >= 0x42b00000) {	/* |x| >= 88, or NaN */
+		if (hx == 0xff800000)
+			return (0.0f);			/* exp(-inf) = 0 */
+		if ((hx & 0x7fffffff) >= 0x7f800000)
+			return (x + x);			/* exp(inf) = inf, NaN */
+		if (x > 0x1.62e42ep6f)
+			return (huge * huge);		/* overflow */
+		if (x < -0x1.9fe368p6f)
+			return (twom100 * twom100);	/* underflow */
 	}
-	return ((char *)s);
+	return (__exp2f_scaled(invln2N * x));
 }
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "float_tables.h"
+
+/* Each entry is the nearest double to the exact value. */
+
+const uint64_t __exp2f_table[EXP2F_N] = {
+	0x3ff0000000000000ULL,
+	0x3fefd9b0d3158574ULL,
+	0x3fefb5586cf9890fULL,
+	0x3fef9301d0125b51ULL,
+	0x3fef72b83c7d517bULL,
+	0x3fef54873168b9aaULL,
+	0x3fef387a6e756238ULL,
+	0x3fef1e9df51fdee1ULL,
+	0x3fef06fe0a31b715ULL,
+	0x3feef1a7373aa9cbULL,
+	0x3feedea64c123422ULL,
+	0x3feece086061892dULL,
+	0x3feebfdad5362a27ULL,
+	0x3feeb42b569d4f82ULL,
+	0x3feeab07dd485429ULL,
+	0x3feea47eb03a5585ULL,
+	0x3feea09e667f3bcdULL,
+	0x3fee9f75e8ec5f74ULL,
+	0x3feea11473eb0187ULL,
+	0x3feea589994cce13ULL,
+	0x3feeace5422aa0dbULL,
+	0x3feeb737b0cdc5e5ULL,
+	0x3feec49182a3f090ULL,
+	0x3feed503b23e255dULL,
+	0x3feee89f995ad3adULL,
+	0x3feeff76f2fb5e47ULL,
+	0x3fef199bdd85529cULL,
+	0x3fef3720dcef9069ULL,
+	0x3fef5818dcfba487ULL,
+	0x3fef7c97337b9b5fULL,
+	0x3fefa4afa2a490daULL,
+	0x3fefd0765b6e4540ULL,
+};
+
+const struct logf_entry __logf_table[1 << LOGF_TABLE_BITS] = {
+	{ 0x1.661ec6a5122f9p+0, -0x1.57bf753c8d1fbp-2 },
+	{ 0x1.571ed3c506b3ap+0, -0x1.2bef07cdc9355p-2 },
+	{ 0x1.49539e3b2d067p+0, -0x1.01eae5626c691p-2 },
+	{ 0x1.3c995a47babe7p+0, -0x1.b31d8575bce3bp-3 },
+	{ 0x1.30d190130d19p+0, -0x1.6574ebe8c1339p-3 },
+	{ 0x1.25e22708092f1p+0, -0x1.1aa2b7e23f729p-3 },
+	{ 0x1.1bb4a4046ed29p+0, -0x1.a4e7640b1bc38p-4 },
+	{ 0x1.12358e75d3033p+0, -0x1.1973bd1465561p-4 },
+	{ 0x1.0953f39010954p+0, -0x1.252f32f8d184p-5 },
+	{ 0x1p+0, 0.0 },
+	{ 0x1.e573ac901e574p-1, 0x1.b42dd711971b9p-5 },
+	{ 0x1.ca4b3055ee191p-1, 0x1.c5e548f5bc743p-4 },
+	{ 0x1.b2036406c80d9p-1, 0x1.526e5e3a1b438p-3 },
+	{ 0x1.9c2d14ee4a102p-1, 0x1.bc286742d8cd4p-3 },
+	{ 0x1.886e5f0abb04ap-1, 0x1.1058bf9ae4ad4p-2 },
+	{ 0x1.767dce434a9b1p-1, 0x1.404308686a7e4p-2 },
+};
+
+const struct logf_entry __powf_log2_table[1 << POWF_LOG2_TABLE_BITS] = {
+	{ 0x1.6c16c16c16c17p+0, -0x1.042bd4b9a7c99p-1 },
+	{ 0x1.6816816816817p+0, -0x1.f804ae8d0cd04p-2 },
+	{ 0x1.642c8590b2164p+0, -0x1.e7df5fe538ab3p-2 },
+	{ 0x1.6058160581606p+0, -0x1.d7e6c0abc357bp-2 },
+	{ 0x1.5c9882b931057p+0, -0x1.c819dc2d45fe4p-2 },
+	{ 0x1.58ed2308158edp+0, -0x1.b877c57b1b06fp-2 },
+	{ 0x1.5555555555555p+0, -0x1.a8ff971810a5dp-2 },
+	{ 0x1.51d07eae2f815p+0, -0x1.99b072a96c6b2p-2 },
+	{ 0x1.4e5e0a72f0539p+0, -0x1.8a8980abfbd3p-2 },
+	{ 0x1.4afd6a052bf5bp+0, -0x1.7b89f02cf2aafp-2 },
+	{ 0x1.47ae147ae147bp+0, -0x1.6cb0f6865c8ebp-2 },
+	{ 0x1.446f86562d9fbp+0, -0x1.5dfdcf1eeae0fp-2 },
+	{ 0x1.4141414141414p+0, -0x1.4f6fbb2cec598p-2 },
+	{ 0x1.3e22cbce4a902p+0, -0x1.4106017c3ecap-2 },
+	{ 0x1.3b13b13b13b14p+0, -0x1.32bfee370ee6ap-2 },
+	{ 0x1.3813813813814p+0, -0x1.249cd2b13cd6fp-2 },
+	{ 0x1.3521cfb2b78c1p+0, -0x1.169c05363f157p-2 },
+	{ 0x1.323e34a2b10bfp+0, -0x1.08bce0d95fa36p-2 },
+	{ 0x1.2f684bda12f68p+0, -0x1.f5fd8a9063e32p-3 },
+	{ 0x1.2c9fb4d812cap+0, -0x1.dac22d3e441d6p-3 },
+	{ 0x1.29e4129e4129ep+0, -0x1.bfc67a7fff4cap-3 },
+	{ 0x1.27350b8812735p+0, -0x1.a5094b54d2828p-3 },
+	{ 0x1.2492492492492p+0, -0x1.8a8980abfbd3p-3 },
+	{ 0x1.21fb78121fb78p+0, -0x1.7046031c79f84p-3 },
+	{ 0x1.1f7047dc11f7p+0, -0x1.563dc29ffacafp-3 },
+	{ 0x1.1cf06ada2811dp+0, -0x1.3c6fb650cde51p-3 },
+	{ 0x1.1a7b9611a7b96p+0, -0x1.22dadc2ab3496p-3 },
+	{ 0x1.1811811811812p+0, -0x1.097e38ce6064ep-3 },
+	{ 0x1.15b1e5f75270dp+0, -0x1.e0b1ae8f2fd56p-4 },
+	{ 0x1.135c81135c811p+0, -0x1.aed391ab6674ap-4 },
+	{ 0x1.1111111111111p+0, -0x1.7d60496cfbb4bp-4 },
+	{ 0x1.0ecf56be69c9p+0, -0x1.4c560fe68af8bp-4 },
+	{ 0x1.0c9714fbcda3bp+0, -0x1.1bb32a60054a2p-4 },
+	{ 0x1.0a6810a6810a7p+0, -0x1.d6ebd1f1fec14p-5 },
+	{ 0x1.0842108421084p+0, -0x1.77394c9d958dp-5 },
+	{ 0x1.0624dd2f1a9fcp+0, -0x1.184b8e4c56afcp-5 },
+	{ 0x1.041041041041p+0, -0x1.743ee861f353fp-6 },
+	{ 0x1.0204081020408p+0, -0x1.72c7ba20f731cp-7 },
+	{ 0x1p+0, 0.0 },
+	{ 0x1.f81f81f81f82p-1, 0x1.6e79685c2d212p-6 },
+	{ 0x1.f07c1f07c1f08p-1, 0x1.6bad3758efd81p-5 },
+	{ 0x1.e9131abf0b767p-1, 0x1.0eb389fa29f9dp-4 },
+	{ 0x1.e1e1e1e1e1e1ep-1, 0x1.663f6fac91318p-4 },
+	{ 0x1.dae6076b981dbp-1, 0x1.bc84240adabb9p-4 },
+	{ 0x1.d41d41d41d41dp-1, 0x1.08c588cda79e5p-3 },
+	{ 0x1.cd85689039b0bp-1, 0x1.32ae9e278ae19p-3 },
+	{ 0x1.c71c71c71c71cp-1, 0x1.5c01a39fbd68bp-3 },
+	{ 0x1.c0e070381c0ep-1, 0x1.84c2bd02f03b6p-3 },
+	{ 0x1.bacf914c1badp-1, 0x1.acf5e2db4ec91p-3 },
+	{ 0x1.b4e81b4e81b4fp-1, 0x1.d49ee4c32596cp-3 },
+	{ 0x1.af286bca1af28p-1, 0x1.fbc16b902680dp-3 },
+	{ 0x1.a98ef606a63bep-1, 0x1.11307dad30b74p-2 },
+	{ 0x1.a41a41a41a41ap-1, 0x1.24407ab0e073ap-2 },
+	{ 0x1.9ec8e951033d9p-1, 0x1.37124cea4cdedp-2 },
+	{ 0x1.999999999999ap-1, 0x1.49a784bcd1b8ap-2 },
+	{ 0x1.948b0fcd6e9ep-1, 0x1.5c01a39fbd689p-2 },
+	{ 0x1.8f9c18f9c18fap-1, 0x1.6e221cd9d0cddp-2 },
+	{ 0x1.8acb90f6bf3aap-1, 0x1.800a563161c53p-2 },
+	{ 0x1.8618618618618p-1, 0x1.91bba891f170ap-2 },
+	{ 0x1.8181818181818p-1, 0x1.a33760a7f6051p-2 },
+	{ 0x1.7d05f417d05f4p-1, 0x1.b47ebf73882a1p-2 },
+	{ 0x1.78a4c8178a4c8p-1, 0x1.c592fad295b57p-2 },
+	{ 0x1.745d1745d1746p-1, 0x1.d6753e032ea0ep-2 },
+	{ 0x1.702e05c0b817p-1, 0x1.e726aa1e754d3p-2 },
+};
+
+const uint32_t __two_over_pi_bits[7] = {
+	0xa2f9836e, 0x4e441529, 0xfc2757d1, 0xf534ddc0,
+	0xdb629599, 0x3c439041, 0xfe5163ab,
+};
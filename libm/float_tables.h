@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _BIONIC_LIBM_FLOAT_TABLES_H_included
+#define _BIONIC_LIBM_FLOAT_TABLES_H_included
+
+/*
+ * Tables and helpers shared by expf, logf, powf, sinf and cosf, which do
+ * all their arithmetic in double: a small table lookup leaves only a short
+ * polynomial to evaluate, with error far below a float ulp.
+ */
+
+#include <stdint.h>
+
+#include "math_private.h"
+
+/* 2**(i/N) for i in [0, N), less i << (52 - EXP2F_TABLE_BITS). */
+#define	EXP2F_TABLE_BITS	5
+#define	EXP2F_N			(1 << EXP2F_TABLE_BITS)
+extern const uint64_t __exp2f_table[EXP2F_N];
+
+/*
+ * 1/c and -log(c) (-log2(c) for powf) for each of N subintervals of
+ * [LOGF_OFF, 2 * LOGF_OFF) as float bit patterns. The subinterval holding
+ * 1.0 has c = 1, so there's no cancellation in log(x) for x near 1.
+ */
+#define	LOGF_OFF		0x3f330000
+#define	LOGF_TABLE_BITS		4
+#define	POWF_LOG2_TABLE_BITS	6
+struct logf_entry {
+	double invc;
+	double logc;
+};
+extern const struct logf_entry __logf_table[1 << LOGF_TABLE_BITS];
+extern const struct logf_entry __powf_log2_table[1 << POWF_LOG2_TABLE_BITS];
+
+/* The bits of 2/pi, enough for the reduction of any float. */
+extern const uint32_t __two_over_pi_bits[7];
+
+/*
+ * 2**(z/N) for |z| <= 150 * N: the table gives 2**(k/N) for the nearest
+ * integer k, and a cubic 2**(r/N) for |r| <= 1/2, within 2**-30.
+ */
+static inline double
+__exp2f_scaled(double z)
+{
+	static const double
+	shift	= 0x1.8p52,
+	C0	= 0x1.c6b08d704a0cp-20,		/* (ln2/N)**3/6 */
+	C1	= 0x1.ebfbdff82c58fp-13,	/* (ln2/N)**2/2 */
+	C2	= 0x1.62e42fefa39efp-6;		/* ln2/N */
+	double kd, r, s, y;
+	uint64_t ki, t;
+
+	kd = z + shift;
+	EXTRACT_WORD64(ki, kd);
+	kd -= shift;
+	r = z - kd;
+	t = __exp2f_table[ki % EXP2F_N] + (ki << (52 - EXP2F_TABLE_BITS));
+	INSERT_WORD64(s, t);
+	y = (C0 * r + C1) * (r * r) + (C2 * r + 1);
+	return (y * s);
+}
+
+/*
+ * x - n*pi/2 for the nearest integer n, returning n. Below 2**28*(pi/2) this
+ * is e_rem_pio2f.c's medium case. Above, x = m * 2**e with m an integer, so
+ * the bits of 2/pi worth more than 2**-e * 4 drop out of x*2/pi mod 4 and
+ * those worth less than 2**-e * 2**-94 don't matter: m times the 96 bits
+ * between them gives the quadrant and 62 bits of fraction, in integers.
+ */
+static inline int
+__rem_pio2f_fast(float x, int32_t hx, double *y)
+{
+	static const double
+	invpio2	= 6.36619772367581382433e-01,	/* 0x3FE45F30, 0x6DC9C883 */
+	pio2_1	= 1.57079631090164184570e+00,	/* 0x3FF921FB, 0x50000000 */
+	pio2_1t	= 1.58932547735281966916e-08,	/* 0x3E5110b4, 0x611A6263 */
+	pio2_2m62 = 0x1.921fb54442d18p-62;	/* pi/2 * 2**-62 */
+	const uint32_t *w;
+	uint64_t m, hi, lo, res, n;
+	double fn;
+	int p, sh;
+
+	if ((hx & 0x7fffffff) < 0x4dc90fdb) {
+		STRICT_ASSIGN(double, fn, x * invpio2 + 0x1.8p52);
+		fn = fn - 0x1.8p52;
+		*y = (x - fn * pio2_1) - fn * pio2_1t;
+		return ((int32_t)fn);
+	}
+
+	/* Bit p (from 0) of 2/pi is worth 2**-e * 2 here. */
+	p = ((hx >> 23) & 0xff) - 152;
+	w = &__two_over_pi_bits[p / 32];
+	sh = p % 32;
+	hi = (uint64_t)w[0] << 32 | w[1];
+	lo = (uint64_t)w[2] << 32 | w[3];
+	if (sh != 0) {
+		hi = hi << sh | lo >> (64 - sh);
+		lo <<= sh;
+	}
+	m = (hx & 0x7fffff) | 0x800000;
+	res = m * hi + ((m * (lo >> 32)) >> 32);
+	n = (res + (1ULL << 61)) >> 62;
+	res -= n << 62;
+	*y = (int64_t)res * pio2_2m62;
+	if (hx < 0) {
+		*y = -*y;
+		return (-(int)n);
+	}
+	return ((int)n);
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_ARRAY_MATH_H
+#define _ANDROID_ARRAY_MATH_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+#pragma GCC visibility push(default)
+
+/*
+ * Bulk versions of expf, logf, sinf, cosf, sqrtf and tanhf: each sets
+ * out[i] to the function of in[i] for i in [0, n), using the widest SIMD
+ * code the CPU has. 'out' may be 'in', but the two mustn't otherwise
+ * overlap.
+ *
+ * Special values (NaN, infinities, zeros, results that overflow or
+ * underflow, huge trig arguments) give the same results as the scalar
+ * functions. Other results are within 1 ulp of the exact result (sqrtf
+ * is correctly rounded; tanhf, like the scalar tanhf, is within 2.3 ulp),
+ * but may differ from the scalar function's in the last bit. errno is
+ * never set.
+ */
+extern void android_math_expf_array(const float* in, float* out, size_t n);
+extern void android_math_logf_array(const float* in, float* out, size_t n);
+extern void android_math_sinf_array(const float* in, float* out, size_t n);
+extern void android_math_cosf_array(const float* in, float* out, size_t n);
+extern void android_math_sqrtf_array(const float* in, float* out, size_t n);
+extern void android_math_tanhf_array(const float* in, float* out, size_t n);
+
+#pragma GCC visibility pop
+__END_DECLS
+
+#endif /* _ANDROID_ARRAY_MATH_H */
@@ -58,6 +58,98 @@ typedef __uint32_t fexcept_t;
 #define FE_DOWNWARD   0x2
 #define FE_TOWARDZERO 0x3
 
+/*
+ * The functions numeric code wraps its kernels in are inline, so they cost
+ * a few FPSCR accesses rather than a call. Writing the FPSCR is much slower
+ * than reading it, so it's only written when its value changes. libm's
+ * fenv.c defines __fenv_static to get the out-of-line copies.
+ */
+#ifndef __fenv_static
+#define __fenv_static static __inline
+#endif
+
+#define __FPSCR_ENABLE_SHIFT 8
+#define __FPSCR_ENABLE_MASK  (FE_ALL_EXCEPT << __FPSCR_ENABLE_SHIFT)
+#define __FPSCR_RMODE_SHIFT  22
+
+#define __get_fpscr(__fpscr) __asm__ __volatile__("vmrs %0,fpscr" : "=r" (__fpscr))
+#define __set_fpscr(__fpscr) __asm__ __volatile__("vmsr fpscr,%0" : :"ri" (__fpscr))
+
+__fenv_static int fegetenv(fenv_t* __envp) {
+  __get_fpscr(*__envp);
+  return 0;
+}
+
+__fenv_static int fesetenv(const fenv_t* __envp) {
+  fenv_t __fpscr;
+
+  __get_fpscr(__fpscr);
+  if (*__envp != __fpscr) {
+    __set_fpscr(*__envp);
+  }
+  return 0;
+}
+
+__fenv_static int feclearexcept(int __excepts) {
+  fenv_t __fpscr;
+
+  __get_fpscr(__fpscr);
+  if ((__fpscr & __excepts & FE_ALL_EXCEPT) != 0) {
+    __set_fpscr(__fpscr & ~(__excepts & FE_ALL_EXCEPT));
+  }
+  return 0;
+}
+
+__fenv_static int fetestexcept(int __excepts) {
+  fenv_t __fpscr;
+
+  __get_fpscr(__fpscr);
+  return (__fpscr & __excepts & FE_ALL_EXCEPT);
+}
+
+__fenv_static int fegetround(void) {
+  fenv_t __fpscr;
+
+  __get_fpscr(__fpscr);
+  return ((__fpscr >> __FPSCR_RMODE_SHIFT) & FE_TOWARDZERO);
+}
+
+__fenv_static int fesetround(int __round) {
+  fenv_t __fpscr, __new_fpscr;
+
+  __get_fpscr(__fpscr);
+  __new_fpscr = __fpscr & ~(FE_TOWARDZERO << __FPSCR_RMODE_SHIFT);
+  __new_fpscr |= (__round & FE_TOWARDZERO) << __FPSCR_RMODE_SHIFT;
+  if (__new_fpscr != __fpscr) {
+    __set_fpscr(__new_fpscr);
+  }
+  return 0;
+}
+
+/* Saves the environment, then clears the exceptions and untraps them. */
+__fenv_static int feholdexcept(fenv_t* __envp) {
+  fenv_t __fpscr;
+
+  __get_fpscr(__fpscr);
+  *__envp = __fpscr;
+  if ((__fpscr & (FE_ALL_EXCEPT | __FPSCR_ENABLE_MASK)) != 0) {
+    __set_fpscr(__fpscr & ~(FE_ALL_EXCEPT | __FPSCR_ENABLE_MASK));
+  }
+  return 0;
+}
+
+/* Restores the environment, keeping the exceptions raised since. */
+__fenv_static int feupdateenv(const fenv_t* __envp) {
+  fenv_t __fpscr, __new_fpscr;
+
+  __get_fpscr(__fpscr);
+  __new_fpscr = *__envp | (__fpscr & FE_ALL_EXCEPT);
+  if (__new_fpscr != __fpscr) {
+    __set_fpscr(__new_fpscr);
+  }
+  return 0;
+}
+
 __END_DECLS
 
 #endif /* !_ARM_FENV_H_ */
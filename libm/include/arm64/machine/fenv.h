@@ -97,6 +97,114 @@ typedef __uint32_t fexcept_t;
 #define FE_DOWNWARD   0x2
 #define FE_TOWARDZERO 0x3
 
+/*
+ * The functions numeric code wraps its kernels in are inline, so they cost
+ * a few system register accesses rather than a call. Writing FPCR or FPSR
+ * is much slower than reading them, so nothing is written unless its value
+ * changes. libm's fenv.c defines __fenv_static to get the out-of-line
+ * copies.
+ */
+#ifndef __fenv_static
+#define __fenv_static static __inline
+#endif
+
+#define __FPCR_EXCEPT_SHIFT 8
+#define __FPCR_RMODE_SHIFT  22
+
+#define __get_fpcr(__fpcr) __asm__ __volatile__("mrs %0,fpcr" : "=r" (__fpcr))
+#define __get_fpsr(__fpsr) __asm__ __volatile__("mrs %0,fpsr" : "=r" (__fpsr))
+#define __set_fpcr(__fpcr) __asm__ __volatile__("msr fpcr,%0" : :"ri" (__fpcr))
+#define __set_fpsr(__fpsr) __asm__ __volatile__("msr fpsr,%0" : :"ri" (__fpsr))
+
+__fenv_static int fegetenv(fenv_t* __envp) {
+  __get_fpcr(__envp->__control);
+  __get_fpsr(__envp->__status);
+  return 0;
+}
+
+__fenv_static int fesetenv(const fenv_t* __envp) {
+  __uint32_t __fpcr, __fpsr;
+
+  __get_fpcr(__fpcr);
+  if (__envp->__control != __fpcr) {
+    __set_fpcr(__envp->__control);
+  }
+  __get_fpsr(__fpsr);
+  if (__envp->__status != __fpsr) {
+    __set_fpsr(__envp->__status);
+  }
+  return 0;
+}
+
+__fenv_static int feclearexcept(int __excepts) {
+  __uint32_t __fpsr;
+
+  __get_fpsr(__fpsr);
+  if ((__fpsr & __excepts & FE_ALL_EXCEPT) != 0) {
+    __set_fpsr(__fpsr & ~(__excepts & FE_ALL_EXCEPT));
+  }
+  return 0;
+}
+
+__fenv_static int fetestexcept(int __excepts) {
+  __uint32_t __fpsr;
+
+  __get_fpsr(__fpsr);
+  return (__fpsr & __excepts & FE_ALL_EXCEPT);
+}
+
+__fenv_static int fegetround(void) {
+  __uint32_t __fpcr;
+
+  __get_fpcr(__fpcr);
+  return ((__fpcr >> __FPCR_RMODE_SHIFT) & FE_TOWARDZERO);
+}
+
+__fenv_static int fesetround(int __round) {
+  __uint32_t __fpcr, __new_fpcr;
+
+  __get_fpcr(__fpcr);
+  __new_fpcr = __fpcr & ~(FE_TOWARDZERO << __FPCR_RMODE_SHIFT);
+  __new_fpcr |= (__round & FE_TOWARDZERO) << __FPCR_RMODE_SHIFT;
+  if (__new_fpcr != __fpcr) {
+    __set_fpcr(__new_fpcr);
+  }
+  return 0;
+}
+
+/* Saves the environment, then clears the exceptions and untraps them. */
+__fenv_static int feholdexcept(fenv_t* __envp) {
+  __uint32_t __fpcr, __fpsr;
+
+  __get_fpcr(__fpcr);
+  __get_fpsr(__fpsr);
+  __envp->__control = __fpcr;
+  __envp->__status = __fpsr;
+  if ((__fpcr & (FE_ALL_EXCEPT << __FPCR_EXCEPT_SHIFT)) != 0) {
+    __set_fpcr(__fpcr & ~(FE_ALL_EXCEPT << __FPCR_EXCEPT_SHIFT));
+  }
+  if ((__fpsr & FE_ALL_EXCEPT) != 0) {
+    __set_fpsr(__fpsr & ~FE_ALL_EXCEPT);
+  }
+  return 0;
+}
+
+/* Restores the environment, keeping the exceptions raised since. */
+__fenv_static int feupdateenv(const fenv_t* __envp) {
+  __uint32_t __fpcr, __fpsr, __new_fpsr;
+
+  __get_fpcr(__fpcr);
+  if (__envp->__control != __fpcr) {
+    __set_fpcr(__envp->__control);
+  }
+  __get_fpsr(__fpsr);
+  __new_fpsr = __envp->__status | (__fpsr & FE_ALL_EXCEPT);
+  if (__new_fpsr != __fpsr) {
+    __set_fpsr(__new_fpsr);
+  }
+  return 0;
+}
+
 __END_DECLS
 
 #endif /* !_ARM64_FENV_H_ */
@@ -163,6 +163,20 @@ extern int signgam;
 #endif
 #endif /* __BSD_VISIBLE */
 
+/*
+ * libm has vector versions of some functions (see vector_math.h) that GCC
+ * may call from vectorized loops when -ffast-math says the results needn't
+ * be exactly those of the scalar functions. There are no AVX-512 or SVE
+ * versions, so don't let the compiler ask for them.
+ */
+#if defined(__FAST_MATH__) && !defined(__clang__) && \
+    ((defined(__x86_64__) && !defined(__AVX512F__) && __GNUC_PREREQ(6, 0)) || \
+     (defined(__aarch64__) && !defined(__ARM_FEATURE_SVE) && __GNUC_PREREQ(9, 0)))
+#define	__vector_variant	__attribute__((__simd__("notinbranch")))
+#else
+#define	__vector_variant
+#endif
+
 /*
  * Most of these functions depend on the rounding mode and have the side
  * effect of raising floating-point exceptions, so they are not declared
@@ -193,22 +207,22 @@ double	acos(double);
 double	asin(double);
 double	atan(double);
 double	atan2(double, double);
-double	cos(double);
-double	sin(double);
+double	cos(double) __vector_variant;
+double	sin(double) __vector_variant;
 double	tan(double);
 
 double	cosh(double);
 double	sinh(double);
-double	tanh(double);
+double	tanh(double) __vector_variant;
 
-double	exp(double);
+double	exp(double) __vector_variant;
 double	frexp(double, int *);	/* fundamentally !__pure2 */
 double	ldexp(double, int);
-double	log(double);
+double	log(double) __vector_variant;
 double	log10(double);
 double	modf(double, double *);	/* fundamentally !__pure2 */
 
-double	pow(double, double);
+double	pow(double, double) __vector_variant;
 double	sqrt(double);
 
 double	ceil(double);
@@ -306,16 +320,16 @@ float	acosf(float);
 float	asinf(float);
 float	atanf(float);
 float	atan2f(float, float);
-float	cosf(float);
-float	sinf(float);
+float	cosf(float) __vector_variant;
+float	sinf(float) __vector_variant;
 float	tanf(float);
 
 float	coshf(float);
 float	sinhf(float);
-float	tanhf(float);
+float	tanhf(float) __vector_variant;
 
 float	exp2f(float);
-float	expf(float);
+float	expf(float) __vector_variant;
 float	expm1f(float);
 float	frexpf(float, int *);	/* fundamentally !__pure2 */
 int	ilogbf(float) __pure2;
@@ -323,10 +337,10 @@ float	ldexpf(float, int);
 float	log10f(float);
 float	log1pf(float);
 float	log2f(float);
-float	logf(float);
+float	logf(float) __vector_variant;
 float	modff(float, float *);	/* fundamentally !__pure2 */
 
-float	powf(float, float);
+float	powf(float, float) __vector_variant;
 float	sqrtf(float);
 
 float	ceilf(float);
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "float_tables.h"
+
+#define	N	(1 << LOGF_TABLE_BITS)
+
+static const double
+ln2	= 0x1.62e42fefa39efp-1,
+/* log(1+r) - r over r**2 for |r| <= 0.0305, within 2**-31 of log(1+r) */
+A0	= -0x1.fffffcfba9642p-2,
+A1	= 0x1.55555193fdba2p-2,
+A2	= -0x1.0032c9c708267p-2,
+A3	= 0x1.99fc4a9c9c4f4p-3;
+
+static const float zero = 0.0;
+static volatile float vzero = 0.0;
+
+/*
+ * log(x) = k*ln2 + log(c) + log(z/c) for x = 2**k * z, with z in one of N
+ * subintervals around c: the table gives 1/c and log(c), and z/c - 1 is
+ * small enough for a quintic. The result is within 0.51 ulp.
+ */
+float
+logf(float x)
+{
+	double z, r, r2, y, y0;
+	uint32_t ix, iz, tmp;
+	int32_t k;
+	int i;
+
+	GET_FLOAT_WORD(ix, x);
+	if (ix - 0x00800000 >= 0x7f800000 - 0x00800000) {
+		/* x is negative, zero, subnormal, inf or NaN. */
+		if ((ix & 0x7fffffff) == 0)
+			return (-1.0f / vzero);		/* log(+-0) = -inf */
+		if (ix == 0x7f800000)
+			return (x);			/* log(inf) = inf */
+		if ((ix & 0x7fffffff) > 0x7f800000)
+			return (x + x);			/* NaN */
+		if (ix & 0x80000000)
+			return ((x - x) / zero);	/* log(-#) = NaN */
+		/* Subnormal: normalize. */
+		GET_FLOAT_WORD(ix, x * 0x1p23f);
+		ix -= 23 << 23;
+	}
+
+	tmp = ix - LOGF_OFF;
+	i = (tmp >> (23 - LOGF_TABLE_BITS)) % N;
+	k = (int32_t)tmp >> 23;
+	iz = ix - (tmp & 0xff800000);
+	SET_FLOAT_WORD(x, iz);
+	z = x;
+
+	r = z * __logf_table[i].invc - 1;
+	y0 = __logf_table[i].logc + k * ln2;
+	r2 = r * r;
+	y = A0 + A1 * r + r2 * (A2 + A3 * r);
+	return (y * r2 + (y0 + r));
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "float_tables.h"
+
+#define	N	(1 << POWF_LOG2_TABLE_BITS)
+
+static const double
+/* log2(1+r)/r for |r| <= 0.0079, within 2**-41 */
+B0	= 0x1.71547652b8304p+0,
+B1	= -0x1.71547650348d4p-1,
+B2	= 0x1.ec709dbc714acp-2,
+B3	= -0x1.71596137350f8p-2,
+B4	= 0x1.277baff486351p-2;
+
+static volatile float
+huge	= 1.0e+30,
+tiny	= 1.0e-30;
+
+/* 0 if y isn't an integer, 1 if it's odd and 2 if it's even. */
+static inline int
+checkint(uint32_t iy)
+{
+	int e = (iy >> 23) & 0xff;
+
+	if (e < 0x7f)
+		return (0);
+	if (e > 0x7f + 23)
+		return (2);
+	if (iy & ((1U << (0x7f + 23 - e)) - 1))
+		return (0);
+	if (iy & (1U << (0x7f + 23 - e)))
+		return (1);
+	return (2);
+}
+
+/* Is the float with bits ix zero, inf or NaN? */
+static inline int
+zeroinfnan(uint32_t ix)
+{
+	return (2 * ix - 1 >= 2U * 0x7f800000 - 1);
+}
+
+/*
+ * log2(x) for positive normal x, as logf() does log(x) but with a bigger
+ * table: the result is multiplied by y, so it needs a relative error of
+ * about 2**-36, not 2**-24.
+ */
+static inline double
+log2_inline(uint32_t ix)
+{
+	double z, r, r2;
+	uint32_t iz, tmp;
+	int32_t k;
+	float f;
+	int i;
+
+	tmp = ix - LOGF_OFF;
+	i = (tmp >> (23 - POWF_LOG2_TABLE_BITS)) % N;
+	k = (int32_t)tmp >> 23;
+	iz = ix - (tmp & 0xff800000);
+	SET_FLOAT_WORD(f, iz);
+	z = f;
+
+	r = z * __powf_log2_table[i].invc - 1;
+	r2 = r * r;
+	return (r * (B0 + B1 * r + r2 * (B2 + B3 * r + r2 * B4)) +
+	    (__powf_log2_table[i].logc + k));
+}
+
+/*
+ * x**y = 2**(y * log2(x)), all in double. The special cases are those of
+ * e_powf.c; the result is within 0.51 ulp.
+ */
+float
+powf(float x, float y)
+{
+	uint32_t ix, iy;
+	double ylogx, z;
+	int sign = 0;
+
+	GET_FLOAT_WORD(ix, x);
+	GET_FLOAT_WORD(iy, y);
+	if (ix - 0x00800000 >= 0x7f800000 - 0x00800000 || zeroinfnan(iy)) {
+		/* x isn't positive and normal, or y is zero, inf or NaN. */
+		if (zeroinfnan(iy)) {
+			if (2 * iy == 0)
+				return (1.0f);	/* x**+-0 = 1, even for NaN x */
+			if (ix == 0x3f800000)
+				return (1.0f);	/* 1**y = 1, even for NaN y */
+			if (2 * ix > 2U * 0x7f800000 ||
+			    2 * iy > 2U * 0x7f800000)
+				return (x + y);	/* NaN */
+			if (2 * ix == 2U * 0x3f800000)
+				return (1.0f);	/* (-1)**+-inf = 1 */
+			if ((2 * ix < 2U * 0x3f800000) == !(iy & 0x80000000))
+				return (0.0f);	/* (|x|<1)**inf, (|x|>1)**-inf */
+			return (y * y);		/* (|x|<1)**-inf, (|x|>1)**inf */
+		}
+		if (zeroinfnan(ix)) {
+			float x2 = x * x;
+
+			if ((ix & 0x80000000) && checkint(iy) == 1)
+				x2 = -x2;
+			/* Division by zero for 0**-y. */
+			return ((iy & 0x80000000) ? 1 / x2 : x2);
+		}
+		/* x and y are finite and non-zero. */
+		if (ix & 0x80000000) {
+			switch (checkint(iy)) {
+			case 0:
+				return ((x - x) / (x - x)); /* (-#)**non-int */
+			case 1:
+				sign = 1;
+				break;
+			}
+			ix &= 0x7fffffff;
+		}
+		if (ix < 0x00800000) {
+			/* Subnormal: normalize. */
+			GET_FLOAT_WORD(ix, x * 0x1p23f);
+			ix &= 0x7fffffff;
+			ix -= 23 << 23;
+		}
+	}
+
+	ylogx = y * log2_inline(ix);
+	if (ylogx >= 128)
+		return (sign ? -huge * huge : huge * huge);	/* overflow */
+	if (ylogx <= -150)
+		return (sign ? -tiny * tiny : tiny * tiny);	/* underflow */
+	z = __exp2f_scaled(ylogx * EXP2F_N);
+	return (sign ? -z : z);
+}
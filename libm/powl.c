@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * powl for the 128-bit long double of LP64 Android, in place of the
+ * imprecise one that calls pow.
+ *
+ * x**y = exp(y * log(x)). log(|x|) comes from s_logl.c's k_logl as hi + lo
+ * with about 15 bits to spare, and y * (hi + lo) is formed as zhi + zlo
+ * with an exact product of y and hi. exp(zhi) comes from k_expl.h's kernel
+ * as (hi + lo) * 2**k, and zlo, which is below 2**-99, is folded in as
+ * exp(zhi) * zlo. The error grows with |y * log(x)|, from 0.5 ulp for
+ * results near 1 to about 2 ulp for results near the overflow and
+ * underflow thresholds.
+ *
+ * k_logl is static, so this file builds s_logl.c too and replaces it in
+ * Android.mk.
+ */
+
+#include "upstream-freebsd/lib/msun/ld128/s_logl.c"
+#include "k_expl.h"
+
+static const volatile long double
+huge = 0x1p10000L,
+tiny = 0x1p-10000L;
+
+static const long double
+twom10000 = 0x1p-10000L,
+/* 2**57 + 1, to split a long double into two 56-bit halves. */
+split = 0x1p57L + 1,
+/* log(2**16384 - 0.5) rounded towards zero, as in s_expl.c: */
+o_threshold =  11356.523406294143949491931077970763428L,
+/* log(2**(-16381-64-1)) rounded towards zero: */
+u_threshold = -11433.462743336297878837243843452621503L;
+
+/* 0 if y isn't an integer, 1 if it's odd and 2 if it's even. */
+static int
+checkint(const union IEEEl2bits *u)
+{
+	unsigned __int128 m;
+	int e, f;
+
+	e = u->bits.exp - BIAS;
+	if (e < 0)
+		return (0);
+	if (e >= LDBL_MANT_DIG)
+		return (2);
+	/* The significand, with f fraction bits. */
+	m = ((unsigned __int128)(u->bits.manh | (1ULL << LDBL_MANH_SIZE)) <<
+	    LDBL_MANL_SIZE) | u->bits.manl;
+	f = LDBL_MANT_DIG - 1 - e;
+	if ((m & (((unsigned __int128)1 << f) - 1)) != 0)
+		return (0);
+	return (((m >> f) & 1) ? 1 : 2);
+}
+
+long double
+powl(long double x, long double y)
+{
+	union IEEEl2bits ux, uy;
+	struct ld r;
+	long double ax, hi, lo, t, twopk, xh, xl, yh, yl, zhi, zlo;
+	int k, sign, sx, yint;
+	uint16_t ix, iy;
+
+	ux.e = x;
+	uy.e = y;
+	ix = ux.bits.exp;
+	iy = uy.bits.exp;
+
+	/* x**0 and 1**y are 1, even for NaNs. */
+	if ((iy | uy.bits.manh | uy.bits.manl) == 0)
+		return (1);
+	if (ux.bits.sign == 0 && ix == BIAS && (ux.bits.manh | ux.bits.manl) == 0)
+		return (1);
+	if ((ix == 0x7fff && (ux.bits.manh | ux.bits.manl) != 0) ||
+	    (iy == 0x7fff && (uy.bits.manh | uy.bits.manl) != 0))
+		return (x + y);
+
+	/* y = +-Inf: +Inf or +0, except (-1)**+-Inf = 1. */
+	if (iy == 0x7fff) {
+		if (ix == BIAS && (ux.bits.manh | ux.bits.manl) == 0)
+			return (1);
+		return ((ix < BIAS) == uy.bits.sign ? y * y : 0);
+	}
+
+	yint = checkint(&uy);
+	sx = ux.bits.sign;
+	ux.bits.sign = 0;
+	ax = ux.e;
+
+	/* x = +-0 or +-Inf. */
+	if ((ix | ux.bits.manh | ux.bits.manl) == 0 || ix == 0x7fff) {
+		if (uy.bits.sign)
+			ax = 1 / ax;	/* raises divide-by-zero for 0 */
+		return (sx && yint == 1 ? -ax : ax);
+	}
+
+	sign = 1;
+	if (sx) {
+		if (yint == 0)
+			return ((x - x) / (x - x));
+		if (yint == 1)
+			sign = -1;
+	}
+	if (ix == BIAS && (ux.bits.manh | ux.bits.manl) == 0)
+		return (sign);		/* (-1)**integer */
+
+	/* With |y| >= 2**128 and |x| != 1, |y * log(|x|)| > 2**15. */
+	if (iy >= BIAS + 128) {
+		if ((ix < BIAS) == uy.bits.sign)
+			return (sign * huge * huge);
+		return (sign * tiny * tiny);
+	}
+
+	k_logl(ax, &r);
+	if (!r.lo_set)
+		r.lo = 0;	/* not reached: |x| is finite, nonzero and not 1 */
+	_2sumF(r.hi, r.lo);
+
+	/* zhi + zlo = y * (r.hi + r.lo), with y * r.hi exact. */
+	t = split * y;
+	yh = t - (t - y);
+	yl = y - yh;
+	t = split * r.hi;
+	xh = t - (t - r.hi);
+	xl = r.hi - xh;
+	zhi = y * r.hi;
+	zlo = (((yh * xh - zhi) + yh * xl + yl * xh) + yl * xl) + y * r.lo;
+	_2sumF(zhi, zlo);
+
+	if (zhi > o_threshold)
+		return (sign * huge * huge);
+	if (zhi < u_threshold)
+		return (sign * tiny * tiny);
+	if (fabsl(zhi) < 0x1p-114L)
+		return (sign * (1 + zhi));	/* 1 with inexact */
+
+	__k_expl(zhi, &hi, &lo, &k);
+	lo += (hi + lo) * zlo;
+	t = hi + lo;
+
+	/* Scale by 2**k, as in s_expl.c. */
+	twopk = 1;
+	if (k >= LDBL_MIN_EXP) {
+		if (k == LDBL_MAX_EXP)
+			return (sign * t * 2 * 0x1p16383L);
+		SET_LDBL_EXPSIGN(twopk, BIAS + k);
+		return (sign * t * twopk);
+	}
+	SET_LDBL_EXPSIGN(twopk, BIAS + k + 10000);
+	return (sign * t * twopk * twom10000);
+}
@@ -24,28 +24,95 @@
  * SUCH DAMAGE.
  *
  */
+
+/*
+ * sincos with a single argument reduction for both results, for the
+ * architectures whose sin and cos come from msun (arm64/sin.c has its own).
+ * On x86 and x86_64, sin and cos are assembler with nothing to share, so
+ * sincos just calls them, which keeps its results identical to theirs.
+ * sincosf is in sinf.c, next to the float kernels, and sincosl for 128-bit
+ * long double in sincosl.c.
+ */
+
 #define _GNU_SOURCE 1
+#include <float.h>
 #include <math.h>
 
-// Disable sincos optimization for all functions in this file,
-// otherwise gcc would generate infinite calls.
-// Refer to gcc PR46926.
-// -fno-builtin-sin or -fno-builtin-cos can disable sincos optimization,
-// but these two options do not work inside optimize pragma in-file.
-// Thus we just enforce -O0 when compiling this file.
-#pragma GCC optimize ("O0")
-
-void sincos(double x, double* p_sin, double* p_cos) {
-  *p_sin = sin(x);
-  *p_cos = cos(x);
+#if defined(__i386__) || defined(__x86_64__)
+/*
+ * Declared under other names so gcc doesn't recognize a sin and cos pair
+ * and turn it back into a call to sincos (gcc PR46926).
+ */
+extern double __sincos_sin(double) __asm__("sin");
+extern double __sincos_cos(double) __asm__("cos");
+
+void
+sincos(double x, double *s, double *c)
+{
+	*s = __sincos_sin(x);
+	*c = __sincos_cos(x);
 }
+#elif !defined(__aarch64__)
+#define INLINE_REM_PIO2
+#include "math_private.h"
+#include "e_rem_pio2.c"
+
+void
+sincos(double x, double *s, double *c)
+{
+	double y[2], sy, cy;
+	int32_t ix;
+	int n;
 
-void sincosf(float x, float* p_sinf, float* p_cosf) {
-  *p_sinf = sinf(x);
-  *p_cosf = cosf(x);
+	GET_HIGH_WORD(ix, x);
+	ix &= 0x7fffffff;
+	if (ix <= 0x3fe921fb) {		/* |x| ~<= pi/4 */
+		if (ix < 0x3e46a09e && (int)x == 0) {	/* |x| < 2^-27 * sqrt(2) */
+			*s = x;
+			*c = 1.0;
+			return;
+		}
+		*s = __kernel_sin(x, 0.0, 0);
+		*c = __kernel_cos(x, 0.0);
+		return;
+	}
+	if (ix >= 0x7ff00000) {		/* sin and cos of Inf or NaN are NaN */
+		*s = *c = x - x;
+		return;
+	}
+
+	n = __ieee754_rem_pio2(x, y);
+	sy = __kernel_sin(y[0], y[1], 1);
+	cy = __kernel_cos(y[0], y[1]);
+	switch (n & 3) {
+	case 0:
+		*s = sy;
+		*c = cy;
+		break;
+	case 1:
+		*s = cy;
+		*c = -sy;
+		break;
+	case 2:
+		*s = -sy;
+		*c = -cy;
+		break;
+	default:
+		*s = -cy;
+		*c = sy;
+		break;
+	}
 }
+#endif
+
+#if LDBL_MANT_DIG == 53
+void
+sincosl(long double x, long double *s, long double *c)
+{
+	double ds, dc;
 
-void sincosl(long double x, long double* p_sinl, long double* p_cosl) {
-  *p_sinl = sinl(x);
-  *p_cosl = cosl(x);
+	sincos(x, &ds, &dc);
+	*s = ds;
+	*c = dc;
 }
+#endif
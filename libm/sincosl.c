@@ -0,0 +1,90 @@
+/*-
+ * Copyright (C) 2010 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * sincosl for 128-bit long double: s_sinl.c and s_cosl.c with one argument
+ * reduction for both results. It can't share a file with sincos because
+ * e_rem_pio2l.h and e_rem_pio2.c define constants with the same names.
+ */
+
+#define _GNU_SOURCE 1
+#include <float.h>
+
+#include "math.h"
+#include "math_private.h"
+#include "e_rem_pio2l.h"
+
+void
+sincosl(long double x, long double *s, long double *c)
+{
+	union IEEEl2bits z;
+	long double y[2], sy, cy;
+	int n;
+
+	z.e = x;
+	z.bits.sign = 0;
+
+	/* sin(x) = x and cos(x) = 1 for +-0 and subnormal x. */
+	if (z.bits.exp == 0) {
+		*s = x;
+		*c = 1;
+		return;
+	}
+
+	/* sin and cos of NaN or Inf are NaN. */
+	if (z.bits.exp == 32767) {
+		*s = *c = (x - x) / (x - x);
+		return;
+	}
+
+	if (z.e < M_PI_4) {
+		*s = __kernel_sinl(x, 0, 0);
+		*c = __kernel_cosl(z.e, 0);
+		return;
+	}
+
+	n = __ieee754_rem_pio2l(x, y);
+	sy = __kernel_sinl(y[0], y[1], 1);
+	cy = __kernel_cosl(y[0], y[1]);
+	switch (n & 3) {
+	case 0:
+		*s = sy;
+		*c = cy;
+		break;
+	case 1:
+		*s = cy;
+		*c = -sy;
+		break;
+	case 2:
+		*s = -sy;
+		*c = -cy;
+		break;
+	default:
+		*s = -cy;
+		*c = sy;
+		break;
+	}
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#define	_GNU_SOURCE	1	/* for sincosf */
+#define	INLINE_KERNEL_COSDF
+#define	INLINE_KERNEL_SINDF
+#include "float_tables.h"
+#include "k_cosf.c"
+#include "k_sinf.c"
+
+/*
+ * s_sinf.c's kernels after a single argument reduction for every |x| > pi/4,
+ * with no more than three integer multiplications for huge x.
+ */
+float
+sinf(float x)
+{
+	double y;
+	int32_t hx, ix;
+	int n;
+
+	GET_FLOAT_WORD(hx, x);
+	ix = hx & 0x7fffffff;
+
+	if (ix <= 0x3f490fda) {		/* |x| ~<= pi/4 */
+		if (ix < 0x39800000)	/* |x| < 2**-12 */
+			if (((int)x) == 0)
+				return (x);	/* x with inexact if x != 0 */
+		return (__kernel_sindf(x));
+	}
+	if (ix >= 0x7f800000)		/* sin(Inf or NaN) is NaN */
+		return (x - x);
+
+	n = __rem_pio2f_fast(x, hx, &y);
+	switch (n & 3) {
+	case 0:
+		return (__kernel_sindf(y));
+	case 1:
+		return (__kernel_cosdf(y));
+	case 2:
+		return (__kernel_sindf(-y));
+	default:
+		return (-__kernel_cosdf(y));
+	}
+}
+
+/*
+ * Both kernels at once, sharing x*x and x**4, with the same results as
+ * __kernel_sindf and __kernel_cosdf.
+ */
+static inline void
+__kernel_sincosdf(double x, float *s, float *c)
+{
+	double r, t, w, z;
+
+	z = x*x;
+	w = z*z;
+	r = S3+z*S4;
+	t = z*x;
+	*s = (x + t*(S1+z*S2)) + t*w*r;
+	r = C2+z*C3;
+	*c = ((one+z*C0) + w*C1) + (w*z)*r;
+}
+
+void
+sincosf(float x, float *s, float *c)
+{
+	double y;
+	float sy, cy;
+	int32_t hx, ix;
+	int n;
+
+	GET_FLOAT_WORD(hx, x);
+	ix = hx & 0x7fffffff;
+
+	if (ix <= 0x3f490fda) {		/* |x| ~<= pi/4 */
+		if (ix < 0x39800000) {	/* |x| < 2**-12 */
+			if (((int)x) == 0) {
+				*s = x;		/* x with inexact if x != 0 */
+				*c = 1.0f;
+				return;
+			}
+		}
+		__kernel_sincosdf(x, s, c);
+		return;
+	}
+	if (ix >= 0x7f800000) {		/* sin and cos of Inf or NaN are NaN */
+		*s = *c = x - x;
+		return;
+	}
+
+	n = __rem_pio2f_fast(x, hx, &y);
+	__kernel_sincosdf(y, &sy, &cy);
+	switch (n & 3) {
+	case 0:
+		*s = sy;
+		*c = cy;
+		break;
+	case 1:
+		*s = cy;
+		*c = -sy;
+		break;
+	case 2:
+		*s = -sy;
+		*c = -cy;
+		break;
+	default:
+		*s = -cy;
+		*c = sy;
+		break;
+	}
+}
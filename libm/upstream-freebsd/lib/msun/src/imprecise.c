@@ -48,6 +48,8 @@
 	__weak_reference(imprecise_## x, x);\
 	WARN_IMPRECISE(x)
 
+#if (LDBL_MANT_DIG == 53)
+/* Android: 128-bit long double gets a real powl from powl.c. */
 long double
 imprecise_powl(long double x, long double y)
 {
@@ -55,6 +57,7 @@ imprecise_powl(long double x, long double y)
 	return pow(x, y);
 }
 DECLARE_WEAK(powl);
+#endif
 
 #define DECLARE_IMPRECISE(f) \
 	long double imprecise_ ## f ## l(long double v) { return f(v); }\
@@ -0,0 +1,754 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * The arithmetic is msun's:
+ *
+ * ====================================================
+ * Copyright (C) 1993 by Sun Microsystems, Inc. All rights reserved.
+ *
+ * Developed at SunPro, a Sun Microsystems, Inc. business.
+ * Permission to use, copy, modify, and distribute this
+ * software is freely granted, provided that this notice
+ * is preserved.
+ * ====================================================
+ */
+
+/*
+ * exp, log, pow, sin, cos and tanh and their float versions for the
+ * vector function ABI, written once for any vector width. The including
+ * file defines VEC_BYTES, VEC_TARGET (for every function), VEC_ABI (for
+ * the exported ones), DOUBLE_NAME(params, name) and FLOAT_NAME(params,
+ * name) to give the functions their mangled names, and:
+ *
+ *	vec_any(m)		is any lane of the comparison result m set?
+ *	vec_widen_lo(x)		the low/high halves of float vector x as
+ *	vec_widen_hi(x)		double vectors
+ *	vec_narrow(lo, hi)	the inverse of the two above
+ *
+ * Each function is the vector form of the msun code named above it, with
+ * its branches on the size of the argument turned into selects. Lanes
+ * outside the range the vector code handles -- NaNs, infinities, and
+ * arguments whose results overflow, underflow or need a slower argument
+ * reduction -- are recomputed with the scalar function, so every lane is
+ * as accurate as msun's scalar code.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+#define	VF_LANES	(VEC_BYTES / 4)
+#define	VD_LANES	(VEC_BYTES / 8)
+
+typedef float vf_t __attribute__((__vector_size__(VEC_BYTES)));
+typedef int32_t vi_t __attribute__((__vector_size__(VEC_BYTES)));
+typedef uint32_t vu_t __attribute__((__vector_size__(VEC_BYTES)));
+typedef double vd_t __attribute__((__vector_size__(VEC_BYTES)));
+typedef int64_t vl_t __attribute__((__vector_size__(VEC_BYTES)));
+typedef uint64_t vul_t __attribute__((__vector_size__(VEC_BYTES)));
+
+#define	VEC_INLINE	static inline VEC_TARGET
+#define	VEC_PUBLIC	__attribute__((__visibility__("default"))) VEC_ABI VEC_TARGET
+
+#define	SIGN_D		0x8000000000000000ULL
+#define	SIGN_F		0x80000000U
+
+/*
+ * Round to the nearest integer. The integer is also left in the low bits
+ * of *bits, which is where the exponent arithmetic below wants it.
+ */
+VEC_INLINE vd_t
+rint_d(vd_t x, vul_t *bits)
+{
+	vd_t z = x + 0x1.8p52;
+
+	*bits = (vul_t)z;
+	return (z - 0x1.8p52);
+}
+
+VEC_INLINE vf_t
+rint_f(vf_t x, vu_t *bits)
+{
+	vf_t z = x + 0x1.8p23f;
+
+	*bits = (vu_t)z;
+	return (z - 0x1.8p23f);
+}
+
+/* A small signed integer in each lane of n, as a double. */
+VEC_INLINE vd_t
+int_to_d(vul_t n)
+{
+	return ((vd_t)(n + 0x4338000000000000ULL) - 0x1.8p52);
+}
+
+VEC_INLINE vf_t
+int_to_f(vu_t n)
+{
+	return ((vf_t)(n + 0x4b400000U) - 0x1.8p23f);
+}
+
+VEC_INLINE vd_t
+fabs_d(vd_t x)
+{
+	return ((vd_t)((vul_t)x & ~SIGN_D));
+}
+
+VEC_INLINE vf_t
+fabs_f(vf_t x)
+{
+	return ((vf_t)((vu_t)x & ~SIGN_F));
+}
+
+/* x with its low word cleared, as SET_LOW_WORD(x, 0). */
+VEC_INLINE vd_t
+high_word_d(vd_t x)
+{
+	return ((vd_t)((vul_t)x & 0xffffffff00000000ULL));
+}
+
+VEC_INLINE vd_t
+select_d(vl_t m, vd_t a, vd_t b)
+{
+	return ((vd_t)(((vl_t)a & m) | ((vl_t)b & ~m)));
+}
+
+VEC_INLINE vf_t
+select_f(vi_t m, vf_t a, vf_t b)
+{
+	return ((vf_t)(((vi_t)a & m) | ((vi_t)b & ~m)));
+}
+
+VEC_INLINE vd_t
+special_d(vd_t x, vd_t r, vl_t special, double (*f)(double))
+{
+	int i;
+
+	for (i = 0; i < VD_LANES; i++)
+		if (special[i])
+			r[i] = f(x[i]);
+	return (r);
+}
+
+VEC_INLINE vd_t
+special_dd(vd_t x, vd_t y, vd_t r, vl_t special, double (*f)(double, double))
+{
+	int i;
+
+	for (i = 0; i < VD_LANES; i++)
+		if (special[i])
+			r[i] = f(x[i], y[i]);
+	return (r);
+}
+
+VEC_INLINE vf_t
+special_f(vf_t x, vf_t r, vi_t special, float (*f)(float))
+{
+	int i;
+
+	for (i = 0; i < VF_LANES; i++)
+		if (special[i])
+			r[i] = f(x[i]);
+	return (r);
+}
+
+VEC_INLINE vf_t
+special_ff(vf_t x, vf_t y, vf_t r, vi_t special, float (*f)(float, float))
+{
+	int i;
+
+	for (i = 0; i < VF_LANES; i++)
+		if (special[i])
+			r[i] = f(x[i], y[i]);
+	return (r);
+}
+
+/*
+ * e_exp.c, for |x| <= 708.
+ */
+VEC_INLINE vd_t
+exp_d(vd_t x)
+{
+	const double
+	ln2HI	= 6.93147180369123816490e-01,	/* 0x3fe62e42, 0xfee00000 */
+	ln2LO	= 1.90821492927058770002e-10,	/* 0x3dea39ef, 0x35793c76 */
+	invln2	= 1.44269504088896338700e+00,	/* 0x3ff71547, 0x652b82fe */
+	P1	= 1.66666666666666019037e-01,	/* 0x3FC55555, 0x5555553E */
+	P2	= -2.77777777770155933842e-03,	/* 0xBF66C16C, 0x16BEBD93 */
+	P3	= 6.61375632143793436117e-05,	/* 0x3F11566A, 0xAF25DE2C */
+	P4	= -1.65339022054652515390e-06,	/* 0xBEBBBD41, 0xC5D26BF1 */
+	P5	= 4.13813679705723846039e-08;	/* 0x3E663769, 0x72BEA4D0 */
+	vd_t hi, lo, c, t, k, y, twopk;
+	vul_t kbits;
+
+	k = rint_d(x * invln2, &kbits);
+	hi = x - k * ln2HI;		/* k*ln2HI is exact here */
+	lo = k * ln2LO;
+	x = hi - lo;
+	t = x * x;
+	c = x - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+	y = 1.0 - ((lo - (x * c) / (2.0 - c)) - hi);
+	twopk = (vd_t)((kbits << 52) + 0x3ff0000000000000ULL);
+	return (y * twopk);
+}
+
+VEC_PUBLIC vd_t
+DOUBLE_NAME(v, exp)(vd_t x)
+{
+	vl_t special = ~(vl_t)(fabs_d(x) <= 708.0);
+	vd_t r = exp_d(x);
+
+	if (vec_any(special))
+		r = special_d(x, r, special, exp);
+	return (r);
+}
+
+/*
+ * e_expf.c, for |x| <= 87.
+ */
+VEC_INLINE vf_t
+expf_f(vf_t x)
+{
+	const float
+	ln2HI	= 6.9314575195e-01f,		/* 0x3f317200 */
+	ln2LO	= 1.4286067653e-06f,		/* 0x35bfbe8e */
+	invln2	= 1.4426950216e+00f,		/* 0x3fb8aa3b */
+	P1	= 1.6666625440e-1f,		/*  0xaaaa8f.0p-26 */
+	P2	= -2.7667332906e-3f;		/* -0xb55215.0p-32 */
+	vf_t hi, lo, c, t, k, y, twopk;
+	vu_t kbits;
+
+	k = rint_f(x * invln2, &kbits);
+	hi = x - k * ln2HI;		/* k*ln2HI is exact here */
+	lo = k * ln2LO;
+	x = hi - lo;
+	t = x * x;
+	c = x - t * (P1 + t * P2);
+	y = 1.0f - ((lo - (x * c) / (2.0f - c)) - hi);
+	twopk = (vf_t)((kbits << 23) + 0x3f800000U);
+	return (y * twopk);
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(v, exp)(vf_t x)
+{
+	vi_t special = ~(vi_t)(fabs_f(x) <= 87.0f);
+	vf_t r = expf_f(x);
+
+	if (vec_any(special))
+		r = special_f(x, r, special, expf);
+	return (r);
+}
+
+/*
+ * e_log.c, for positive normal x. 1+f is x scaled into [sqrt(2)/2,
+ * sqrt(2)) as there; the more accurate of the two final steps is used
+ * throughout.
+ */
+VEC_INLINE vd_t
+log_d(vd_t x)
+{
+	const double
+	ln2_hi	= 6.93147180369123816490e-01,	/* 3fe62e42 fee00000 */
+	ln2_lo	= 1.90821492927058770002e-10,	/* 3dea39ef 35793c76 */
+	Lg1	= 6.666666666666735130e-01,	/* 3FE55555 55555593 */
+	Lg2	= 3.999999999940941908e-01,	/* 3FD99999 9997FA04 */
+	Lg3	= 2.857142874366239149e-01,	/* 3FD24924 94229359 */
+	Lg4	= 2.222219843214978396e-01,	/* 3FCC71C5 1D8E78AF */
+	Lg5	= 1.818357216161805012e-01,	/* 3FC74664 96CB03DE */
+	Lg6	= 1.531383769920937332e-01,	/* 3FC39A09 D078C69F */
+	Lg7	= 1.479819860511658591e-01;	/* 3FC2F112 DF3E5244 */
+	const uint64_t sqrt1_2 = 0x3fe6a09e667f3bcdULL;
+	vd_t hfsq, f, s, z, R, w, t1, t2, dk;
+	vul_t ix;
+
+	ix = (vul_t)x + (0x3ff0000000000000ULL - sqrt1_2);
+	dk = int_to_d((ix >> 52) - 0x3ff);
+	f = (vd_t)((ix & 0x000fffffffffffffULL) + sqrt1_2) - 1.0;
+	hfsq = 0.5 * f * f;
+	s = f / (2.0 + f);
+	z = s * s;
+	w = z * z;
+	t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+	t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+	R = t2 + t1;
+	return (dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f));
+}
+
+VEC_PUBLIC vd_t
+DOUBLE_NAME(v, log)(vd_t x)
+{
+	vl_t special = ~((vl_t)(x >= DBL_MIN) & (vl_t)(x <= DBL_MAX));
+	vd_t r = log_d(x);
+
+	if (vec_any(special))
+		r = special_d(x, r, special, log);
+	return (r);
+}
+
+/*
+ * e_logf.c, for positive normal x.
+ */
+VEC_INLINE vf_t
+logf_f(vf_t x)
+{
+	const float
+	ln2_hi	= 6.9313812256e-01f,		/* 0x3f317180 */
+	ln2_lo	= 9.0580006145e-06f,		/* 0x3717f7d1 */
+	Lg1	= 0xaaaaaa.0p-24f,		/* 0.66666662693 */
+	Lg2	= 0xccce13.0p-25f,		/* 0.40000972152 */
+	Lg3	= 0x91e9ee.0p-25f,		/* 0.28498786688 */
+	Lg4	= 0xf89e26.0p-26f;		/* 0.24279078841 */
+	const uint32_t sqrt1_2 = 0x3f3504f3U;
+	vf_t hfsq, f, s, z, R, w, t1, t2, dk;
+	vu_t ix;
+
+	ix = (vu_t)x + (0x3f800000U - sqrt1_2);
+	dk = int_to_f((ix >> 23) - 0x7f);
+	f = (vf_t)((ix & 0x007fffffU) + sqrt1_2) - 1.0f;
+	hfsq = 0.5f * f * f;
+	s = f / (2.0f + f);
+	z = s * s;
+	w = z * z;
+	t1 = w * (Lg2 + w * Lg4);
+	t2 = z * (Lg1 + w * Lg3);
+	R = t2 + t1;
+	return (dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f));
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(v, log)(vf_t x)
+{
+	vi_t special = ~((vi_t)(x >= FLT_MIN) & (vi_t)(x <= FLT_MAX));
+	vf_t r = logf_f(x);
+
+	if (vec_any(special))
+		r = special_f(x, r, special, logf);
+	return (r);
+}
+
+/*
+ * e_pow.c, for positive normal x and |y| <= 2**31 whose x**y is normal.
+ */
+VEC_PUBLIC vd_t
+DOUBLE_NAME(vv, pow)(vd_t x, vd_t y)
+{
+	const double
+	bp1	= 1.5,
+	dp_h1	= 5.84962487220764160156e-01,	/* 0x3FE2B803, 0x40000000 */
+	dp_l1	= 1.35003920212974897128e-08,	/* 0x3E4CFDEB, 0x43CFD006 */
+	L1	= 5.99999999999994648725e-01,	/* 0x3FE33333, 0x33333303 */
+	L2	= 4.28571428578550184252e-01,	/* 0x3FDB6DB6, 0xDB6FABFF */
+	L3	= 3.33333329818377432918e-01,	/* 0x3FD55555, 0x518F264D */
+	L4	= 2.72728123808534006489e-01,	/* 0x3FD17460, 0xA91D4101 */
+	L5	= 2.30660745775561754067e-01,	/* 0x3FCD864A, 0x93C9DB65 */
+	L6	= 2.06975017800338417784e-01,	/* 0x3FCA7E28, 0x4A454EEF */
+	P1	= 1.66666666666666019037e-01,	/* 0x3FC55555, 0x5555553E */
+	P2	= -2.77777777770155933842e-03,	/* 0xBF66C16C, 0x16BEBD93 */
+	P3	= 6.61375632143793436117e-05,	/* 0x3F11566A, 0xAF25DE2C */
+	P4	= -1.65339022054652515390e-06,	/* 0xBEBBBD41, 0xC5D26BF1 */
+	P5	= 4.13813679705723846039e-08,	/* 0x3E663769, 0x72BEA4D0 */
+	lg2	= 6.93147180559945286227e-01,	/* 0x3FE62E42, 0xFEFA39EF */
+	lg2_h	= 6.93147182464599609375e-01,	/* 0x3FE62E43, 0x00000000 */
+	lg2_l	= -1.90465429995776804525e-09,	/* 0xBE205C61, 0x0CA86C39 */
+	cp	= 9.61796693925975554329e-01,	/* 0x3FEEC709, 0xDC3A03FD =2/(3ln2) */
+	cp_h	= 9.61796700954437255859e-01,	/* 0x3FEEC709, 0xE0000000 =(float)cp */
+	cp_l	= -7.02846165095275826516e-09;	/* 0xBE3E2FE0, 0x145B01F5 =tail of cp_h*/
+	vd_t ax, bp, dp_h, dp_l, z, z_h, z_l, p_h, p_l;
+	vd_t y1, t1, t2, r, t, u, v, w;
+	vd_t ss, s2, s_h, s_l, t_h, t_l;
+	vul_t ix, j, n, k;
+	vl_t special, big;
+	vl_t k1;
+
+	special = ~((vl_t)(x >= DBL_MIN) & (vl_t)(x <= DBL_MAX) &
+	    (vl_t)(fabs_d(y) <= 0x1p31));
+
+	/* determine interval */
+	ix = (vul_t)x >> 32;
+	n = (ix >> 20) - 0x3ff;
+	j = ix & 0x000fffff;
+	big = (vl_t)(j >= 0xBB67A);		/* |x|>=sqrt(3) */
+	k1 = (vl_t)(j > 0x3988E) & ~big;	/* sqrt(3/2)<|x|<sqrt(3) */
+	n -= (vul_t)big;
+	ix = (j | 0x3ff00000) - ((vul_t)big & 0x00100000);
+	k = (vul_t)k1 & 1;
+	ax = (vd_t)((ix << 32) | ((vul_t)x & 0xffffffff));
+	bp = select_d(k1, (vd_t){} + bp1, (vd_t){} + 1.0);
+	dp_h = (vd_t)((vl_t)((vd_t){} + dp_h1) & k1);
+	dp_l = (vd_t)((vl_t)((vd_t){} + dp_l1) & k1);
+
+	/* compute ss = s_h+s_l = (x-1)/(x+1) or (x-1.5)/(x+1.5) */
+	u = ax - bp;
+	v = 1.0 / (ax + bp);
+	ss = u * v;
+	s_h = high_word_d(ss);
+	/* t_h=ax+bp[k] High */
+	t_h = (vd_t)((((ix >> 1) | 0x20000000) + 0x00080000 + (k << 18)) << 32);
+	t_l = ax - (t_h - bp);
+	s_l = v * ((u - s_h * t_h) - s_h * t_l);
+	/* compute log(ax) */
+	s2 = ss * ss;
+	r = s2 * s2 * (L1 + s2 * (L2 + s2 * (L3 + s2 * (L4 + s2 * (L5 + s2 * L6)))));
+	r += s_l * (s_h + ss);
+	s2 = s_h * s_h;
+	t_h = high_word_d(3.0 + s2 + r);
+	t_l = r - ((t_h - 3.0) - s2);
+	/* u+v = ss*(1+...) */
+	u = s_h * t_h;
+	v = s_l * t_h + t_l * ss;
+	/* 2/(3log2)*(ss+...) */
+	p_h = high_word_d(u + v);
+	p_l = v - (p_h - u);
+	z_h = cp_h * p_h;		/* cp_h+cp_l = 2/(3*log2) */
+	z_l = cp_l * p_h + p_l * cp + dp_l;
+	/* log2(ax) = (ss+..)*2/(3*log2) = n + dp_h + z_h + z_l */
+	t = int_to_d(n);
+	t1 = high_word_d(((z_h + z_l) + dp_h) + t);
+	t2 = z_l - (((t1 - t) - dp_h) - z_h);
+
+	/* split up y into y1+y2 and compute (y1+y2)*(t1+t2) */
+	y1 = high_word_d(y);
+	p_l = (y - y1) * t1 + y * t2;
+	p_h = y1 * t1;
+	z = p_l + p_h;
+	special |= ~((vl_t)(z > -1021.0) & (vl_t)(z < 1022.0));
+
+	/*
+	 * compute 2**(p_h+p_l)
+	 */
+	t = rint_d(z, &n);
+	p_h -= t;
+	t = high_word_d(p_l + p_h);
+	u = t * lg2_h;
+	v = (p_l - (t - p_h)) * lg2 + t * lg2_l;
+	z = u + v;
+	w = v - (z - u);
+	t = z * z;
+	t1 = z - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+	r = (z * t1) / (t1 - 2.0) - (w + z * w);
+	z = 1.0 - (r - z);
+	z = (vd_t)((vul_t)z + (n << 52));
+
+	if (vec_any(special))
+		z = special_dd(x, y, z, special, pow);
+	return (z);
+}
+
+/*
+ * powf as exp(y * log(x)) in double, which leaves a float result
+ * correctly rounded almost always. Clamping y * log(x) to where the
+ * double exp works still overflows or underflows the float result.
+ */
+VEC_INLINE vd_t
+powf_d(vd_t x, vd_t y)
+{
+	vd_t z = y * log_d(x);
+
+	z = select_d((vl_t)(z > 200.0), (vd_t){} + 200.0, z);
+	z = select_d((vl_t)(z < -200.0), (vd_t){} - 200.0, z);
+	return (exp_d(z));
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(vv, pow)(vf_t x, vf_t y)
+{
+	vi_t special;
+	vf_t r;
+
+	/* Subnormal x is fine: it is normal as a double. */
+	special = ~((vi_t)(x > 0.0f) & (vi_t)(x <= FLT_MAX) &
+	    (vi_t)(fabs_f(y) <= FLT_MAX));
+	r = vec_narrow(powf_d(vec_widen_lo(x), vec_widen_lo(y)),
+	    powf_d(vec_widen_hi(x), vec_widen_hi(y)));
+	if (vec_any(special))
+		r = special_ff(x, y, r, special, powf);
+	return (r);
+}
+
+/*
+ * k_sin.c and k_cos.c, with the tail y of the reduced argument.
+ */
+VEC_INLINE vd_t
+kernel_sin_d(vd_t x, vd_t y)
+{
+	const double
+	S1	= -1.66666666666666324348e-01,	/* 0xBFC55555, 0x55555549 */
+	S2	= 8.33333333332248946124e-03,	/* 0x3F811111, 0x1110F8A6 */
+	S3	= -1.98412698298579493134e-04,	/* 0xBF2A01A0, 0x19C161D5 */
+	S4	= 2.75573137070700676789e-06,	/* 0x3EC71DE3, 0x57B1FE7D */
+	S5	= -2.50507602534068634195e-08,	/* 0xBE5AE5E6, 0x8A2B9CEB */
+	S6	= 1.58969099521155010221e-10;	/* 0x3DE5D93A, 0x5ACFD57C */
+	vd_t z, r, v, w;
+
+	z = x * x;
+	w = z * z;
+	r = S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6);
+	v = z * x;
+	return (x - ((z * (0.5 * y - v * r) - y) - v * S1));
+}
+
+VEC_INLINE vd_t
+kernel_cos_d(vd_t x, vd_t y)
+{
+	const double
+	C1	= 4.16666666666666019037e-02,	/* 0x3FA55555, 0x5555554C */
+	C2	= -1.38888888888741095749e-03,	/* 0xBF56C16C, 0x16C15177 */
+	C3	= 2.48015872894767294178e-05,	/* 0x3EFA01A0, 0x19CB1590 */
+	C4	= -2.75573143513906633035e-07,	/* 0xBE927E4F, 0x809C52AD */
+	C5	= 2.08757232129817482790e-09,	/* 0x3E21EE9E, 0xBDB4B1C4 */
+	C6	= -1.13596475577881948265e-11;	/* 0xBDA8FAE9, 0xBE8838D4 */
+	vd_t hz, z, r, w;
+
+	z = x * x;
+	w = z * z;
+	r = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+	hz = 0.5 * z;
+	w = 1.0 - hz;
+	return (w + (((1.0 - w) - hz) + (z * r - x * y)));
+}
+
+/*
+ * sin(x + quadrant * pi/2), reducing x as e_rem_pio2.c's medium case
+ * (always taking all three rounds) for |x| < 2**20 * pi/2.
+ */
+VEC_INLINE vd_t
+sin_d(vd_t x, uint64_t quadrant)
+{
+	const double
+	invpio2	= 6.36619772367581382433e-01,	/* 0x3FE45F30, 0x6DC9C883 */
+	pio2_1	= 1.57079632673412561417e+00,	/* 0x3FF921FB, 0x54400000 */
+	pio2_2	= 6.07710050630396597660e-11,	/* 0x3DD0B461, 0x1A600000 */
+	pio2_2t	= 2.02226624879595063154e-21,	/* 0x3BA3198A, 0x2E037073 */
+	pio2_3	= 2.02226624871116645580e-21,	/* 0x3BA3198A, 0x2E000000 */
+	pio2_3t	= 8.47842766036889956997e-32;	/* 0x397B839A, 0x252049C1 */
+	vd_t fn, r, t, w, y0, y1, s, c;
+	vul_t n;
+
+	fn = rint_d(x * invpio2, &n);
+	r = x - fn * pio2_1;
+	t = r;				/* 2nd round, good to 118 bits */
+	w = fn * pio2_2;
+	r = t - w;
+	w = fn * pio2_2t - ((t - r) - w);
+	t = r;				/* 3rd round, good to 151 bits */
+	w = fn * pio2_3;
+	r = t - w;
+	w = fn * pio2_3t - ((t - r) - w);
+	y0 = r - w;
+	y1 = (r - y0) - w;
+
+	s = kernel_sin_d(y0, y1);
+	c = kernel_cos_d(y0, y1);
+	n += quadrant;
+	r = select_d(-(vl_t)(n & 1), c, s);
+	return ((vd_t)((vul_t)r ^ ((n & 2) << 62)));
+}
+
+VEC_PUBLIC vd_t
+DOUBLE_NAME(v, sin)(vd_t x)
+{
+	vl_t special = ~(vl_t)(fabs_d(x) < 0x1.921fbp20);
+	vd_t r = sin_d(x, 0);
+
+	r = select_d((vl_t)(x == 0.0), x, r);	/* sin(-0) is -0 */
+	if (vec_any(special))
+		r = special_d(x, r, special, sin);
+	return (r);
+}
+
+VEC_PUBLIC vd_t
+DOUBLE_NAME(v, cos)(vd_t x)
+{
+	vl_t special = ~(vl_t)(fabs_d(x) < 0x1.921fbp20);
+	vd_t r = sin_d(x, 1);
+
+	if (vec_any(special))
+		r = special_d(x, r, special, cos);
+	return (r);
+}
+
+/*
+ * k_sinf.c and k_cosf.c, and e_rem_pio2f.c's medium case: sinf and cosf
+ * work in double, so this is the whole computation.
+ */
+VEC_INLINE vd_t
+sinf_d(vd_t x, uint64_t quadrant)
+{
+	const double
+	invpio2	= 6.36619772367581382433e-01,	/* 0x3FE45F30, 0x6DC9C883 */
+	pio2_1	= 1.57079631090164184570e+00,	/* 0x3FF921FB, 0x50000000 */
+	pio2_1t	= 1.58932547735281966916e-08,	/* 0x3E5110b4, 0x611A6263 */
+	S1	= -0x15555554cbac77.0p-55,	/* -0.166666666416265235595 */
+	S2	= 0x111110896efbb2.0p-59,	/*  0.0083333293858894631756 */
+	S3	= -0x1a00f9e2cae774.0p-65,	/* -0.000198393348360966317347 */
+	S4	= 0x16cd878c3b46a7.0p-71,	/*  0.0000027183114939898219064 */
+	C0	= -0x1ffffffd0c5e81.0p-54,	/* -0.499999997251031003120 */
+	C1	= 0x155553e1053a42.0p-57,	/*  0.0416666233237390631894 */
+	C2	= -0x16c087e80f1e27.0p-62,	/* -0.00138867637746099294692 */
+	C3	= 0x199342e0ee5069.0p-68;	/*  0.0000243904487962774090654 */
+	vd_t fn, y, z, w, s, c, r;
+	vul_t n;
+
+	fn = rint_d(x * invpio2, &n);
+	y = (x - fn * pio2_1) - fn * pio2_1t;
+	z = y * y;
+	w = z * z;
+	s = (y + z * y * (S1 + z * S2)) + z * y * w * (S3 + z * S4);
+	c = ((1.0 + z * C0) + w * C1) + (w * z) * (C2 + z * C3);
+	n += quadrant;
+	r = select_d(-(vl_t)(n & 1), c, s);
+	return ((vd_t)((vul_t)r ^ ((n & 2) << 62)));
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(v, sin)(vf_t x)
+{
+	vi_t special = ~(vi_t)(fabs_f(x) < 0x1.921fb6p28f);
+	vf_t r;
+
+	r = vec_narrow(sinf_d(vec_widen_lo(x), 0), sinf_d(vec_widen_hi(x), 0));
+	r = select_f((vi_t)(x == 0.0f), x, r);	/* sinf(-0) is -0 */
+	if (vec_any(special))
+		r = special_f(x, r, special, sinf);
+	return (r);
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(v, cos)(vf_t x)
+{
+	vi_t special = ~(vi_t)(fabs_f(x) < 0x1.921fb6p28f);
+	vf_t r;
+
+	r = vec_narrow(sinf_d(vec_widen_lo(x), 1), sinf_d(vec_widen_hi(x), 1));
+	if (vec_any(special))
+		r = special_f(x, r, special, cosf);
+	return (r);
+}
+
+/*
+ * s_expm1.c, for -44 <= x <= 0, where k is 0, -1 or at most -2.
+ */
+VEC_INLINE vd_t
+expm1_d(vd_t x)
+{
+	const double
+	ln2_hi	= 6.93147180369123816490e-01,	/* 0x3fe62e42, 0xfee00000 */
+	ln2_lo	= 1.90821492927058770002e-10,	/* 0x3dea39ef, 0x35793c76 */
+	invln2	= 1.44269504088896338700e+00,	/* 0x3ff71547, 0x652b82fe */
+	Q1	= -3.33333333333331316428e-02,	/* BFA11111 111110F4 */
+	Q2	= 1.58730158725481460165e-03,	/* 3F5A01A0 19FE5585 */
+	Q3	= -7.93650757867487942473e-05,	/* BF14CE19 9EAADBB7 */
+	Q4	= 4.00821782732936239552e-06,	/* 3ED0CFCA 86E65239 */
+	Q5	= -2.01099218183624371326e-07;	/* BE8AFDB7 6E09C32D */
+	vd_t hi, lo, c, t, e, hxs, hfx, r1, twopk, k, y0, y1, y2;
+	vul_t kbits;
+
+	k = rint_d(x * invln2, &kbits);
+	hi = x - k * ln2_hi;		/* k*ln2_hi is exact here */
+	lo = k * ln2_lo;
+	x = hi - lo;
+	c = (hi - x) - lo;
+	hfx = 0.5 * x;
+	hxs = x * hfx;
+	r1 = 1.0 + hxs * (Q1 + hxs * (Q2 + hxs * (Q3 + hxs * (Q4 + hxs * Q5))));
+	t = 3.0 - r1 * hfx;
+	e = hxs * ((r1 - t) / (6.0 - x * t));
+	y0 = x - (x * e - hxs);		/* k == 0, where c is 0 */
+	e = (x * (e - c) - c);
+	e -= hxs;
+	y1 = 0.5 * (x - e) - 0.5;	/* k == -1 */
+	twopk = (vd_t)((kbits << 52) + 0x3ff0000000000000ULL);
+	y2 = (1.0 - (e - x)) * twopk - 1.0;
+	return (select_d((vl_t)(k == 0.0), y0, select_d((vl_t)(k == -1.0), y1, y2)));
+}
+
+/*
+ * s_tanh.c for |x| <= 22, from the single t = expm1(-2|x|): -t/(t+2) for
+ * small |x| and 1-2(t+1)/(t+2) from where t+1 <= 1/3 (and so is exact).
+ */
+VEC_PUBLIC vd_t
+DOUBLE_NAME(v, tanh)(vd_t x)
+{
+	vl_t special = ~(vl_t)(fabs_d(x) <= 22.0);
+	vd_t t, r;
+
+	t = expm1_d(-2.0 * fabs_d(x));
+	r = select_d((vl_t)(fabs_d(x) < 0.5493), -t / (t + 2.0),
+	    1.0 - (2.0 * (t + 1.0)) / (t + 2.0));
+	r = (vd_t)(((vul_t)r & ~SIGN_D) | ((vul_t)x & SIGN_D));
+	if (vec_any(special))
+		r = special_d(x, r, special, tanh);
+	return (r);
+}
+
+/*
+ * s_expm1f.c, for -18 <= x <= 0.
+ */
+VEC_INLINE vf_t
+expm1f_f(vf_t x)
+{
+	const float
+	ln2_hi	= 6.9313812256e-01f,		/* 0x3f317180 */
+	ln2_lo	= 9.0580006145e-06f,		/* 0x3717f7d1 */
+	invln2	= 1.4426950216e+00f,		/* 0x3fb8aa3b */
+	Q1	= -3.3333212137e-2f,		/* -0x888868.0p-28 */
+	Q2	= 1.5807170421e-3f;		/*  0xcf3010.0p-33 */
+	vf_t hi, lo, c, t, e, hxs, hfx, r1, twopk, k, y0, y1, y2;
+	vu_t kbits;
+
+	k = rint_f(x * invln2, &kbits);
+	hi = x - k * ln2_hi;		/* k*ln2_hi is exact here */
+	lo = k * ln2_lo;
+	x = hi - lo;
+	c = (hi - x) - lo;
+	hfx = 0.5f * x;
+	hxs = x * hfx;
+	r1 = 1.0f + hxs * (Q1 + hxs * Q2);
+	t = 3.0f - r1 * hfx;
+	e = hxs * ((r1 - t) / (6.0f - x * t));
+	y0 = x - (x * e - hxs);		/* k == 0, where c is 0 */
+	e = (x * (e - c) - c);
+	e -= hxs;
+	y1 = 0.5f * (x - e) - 0.5f;	/* k == -1 */
+	twopk = (vf_t)((kbits << 23) + 0x3f800000U);
+	y2 = (1.0f - (e - x)) * twopk - 1.0f;
+	return (select_f((vi_t)(k == 0.0f), y0, select_f((vi_t)(k == -1.0f), y1, y2)));
+}
+
+VEC_PUBLIC vf_t
+FLOAT_NAME(v, tanh)(vf_t x)
+{
+	vi_t special = ~(vi_t)(fabs_f(x) <= 9.0f);
+	vf_t t, r;
+
+	t = expm1f_f(-2.0f * fabs_f(x));
+	r = select_f((vi_t)(fabs_f(x) < 0.5493f), -t / (t + 2.0f),
+	    1.0f - (2.0f * (t + 1.0f)) / (t + 2.0f));
+	r = (vf_t)(((vu_t)r & ~SIGN_F) | ((vu_t)x & SIGN_F));
+	if (vec_any(special))
+		r = special_f(x, r, special, tanhf);
+	return (r);
+}
@@ -0,0 +1,83 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * The array functions of <android/array_math.h>, which use the AVX2 code
+ * in vector_math_avx2.c if the CPU and kernel support it and the SSE2
+ * code in vector_math_sse2.c otherwise. libm is also a static library, so
+ * rather than IFUNCs this checks CPUID on the first call.
+ */
+
+#include <android/array_math.h>
+#include <cpuid.h>
+#include <stddef.h>
+
+static int avx2_state;	/* 0 unknown, 1 no AVX2, 2 AVX2 */
+
+static int
+detect_avx2(void)
+{
+	unsigned int eax, ebx, ecx, edx, xcr0_lo, xcr0_hi;
+
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 ||
+	    (ecx & (bit_OSXSAVE | bit_AVX)) != (bit_OSXSAVE | bit_AVX))
+		return (0);
+	/* The kernel has to be saving the YMM registers too. */
+	__asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	if ((xcr0_lo & 6) != 6 || __get_cpuid_max(0, NULL) < 7)
+		return (0);
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return ((ebx & bit_AVX2) != 0);
+}
+
+static int
+have_avx2(void)
+{
+	if (avx2_state == 0)
+		avx2_state = detect_avx2() ? 2 : 1;
+	return (avx2_state == 2);
+}
+
+#define	ARRAY_F(name)							\
+void __android_math_ ## name ## _array_sse2(const float *, float *, size_t);	\
+void __android_math_ ## name ## _array_avx2(const float *, float *, size_t);	\
+									\
+void									\
+android_math_ ## name ## _array(const float *in, float *out, size_t n)	\
+{									\
+	if (have_avx2())						\
+		__android_math_ ## name ## _array_avx2(in, out, n);	\
+	else								\
+		__android_math_ ## name ## _array_sse2(in, out, n);	\
+}
+
+ARRAY_F(expf)
+ARRAY_F(logf)
+ARRAY_F(sinf)
+ARRAY_F(cosf)
+ARRAY_F(sqrtf)
+ARRAY_F(tanhf)
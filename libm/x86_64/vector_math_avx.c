@@ -0,0 +1,49 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * AVX: the vector ABI's "c" variants, four doubles or eight floats per call.
+ * The integer lane arithmetic is split into 128-bit halves by the compiler.
+ */
+
+#include <immintrin.h>
+
+#define	VEC_BYTES		32
+#define	VEC_TARGET		__attribute__((__target__("avx")))
+#define	VEC_ABI
+#define	DOUBLE_NAME(params, name)	_ZGVcN4 ## params ## _ ## name
+#define	FLOAT_NAME(params, name)	_ZGVcN8 ## params ## _ ## name ## f
+
+#define	vec_any(m)		(!_mm256_testz_si256((__m256i)(m), (__m256i)(m)))
+#define	vec_widen_lo(x)		\
+	((vd_t)_mm256_cvtps_pd(_mm256_castps256_ps128((__m256)(x))))
+#define	vec_widen_hi(x)		\
+	((vd_t)_mm256_cvtps_pd(_mm256_extractf128_ps((__m256)(x), 1)))
+#define	vec_narrow(lo, hi)	\
+	((vf_t)_mm256_insertf128_ps(_mm256_castps128_ps256(\
+	    _mm256_cvtpd_ps((__m256d)(lo))), _mm256_cvtpd_ps((__m256d)(hi)), 1))
+
+#include "../vector_math.h"
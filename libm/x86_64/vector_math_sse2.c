@@ -0,0 +1,53 @@
+/*-
+ * Copyright (C) 2014 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * SSE2, the x86_64 baseline: the vector ABI's "b" variants, two doubles or
+ * four floats per call, and the array functions for CPUs without AVX2
+ * (see array_math.c).
+ */
+
+#include <immintrin.h>
+
+#define	VEC_BYTES		16
+#define	VEC_TARGET
+#define	VEC_ABI
+#define	DOUBLE_NAME(params, name)	_ZGVbN2 ## params ## _ ## name
+#define	FLOAT_NAME(params, name)	_ZGVbN4 ## params ## _ ## name ## f
+
+#define	vec_any(m)		(_mm_movemask_epi8((__m128i)(m)) != 0)
+#define	vec_widen_lo(x)		((vd_t)_mm_cvtps_pd((__m128)(x)))
+#define	vec_widen_hi(x)		\
+	((vd_t)_mm_cvtps_pd(_mm_movehl_ps((__m128)(x), (__m128)(x))))
+#define	vec_narrow(lo, hi)	\
+	((vf_t)_mm_movelh_ps(_mm_cvtpd_ps((__m128d)(lo)), _mm_cvtpd_ps((__m128d)(hi))))
+
+#include "../vector_math.h"
+
+#define	vec_sqrt_f(x)		((vf_t)_mm_sqrt_ps((__m128)(x)))
+#define	ARRAY_NAME(name)	__android_math_ ## name ## _array_sse2
+
+#include "../array_math.h"
@@ -6,14 +6,19 @@ LOCAL_SRC_FILES:= \
     debugger.cpp \
     dlfcn.cpp \
     linker.cpp \
+    linker_address_index.cpp \
     linker_allocator.cpp \
     linker_environ.cpp \
     linker_libc_support.c \
+    linker_load_stats.cpp \
     linker_phdr.cpp \
+    linker_relocation_cache.cpp \
+    linker_tls.cpp \
+    linker_zip.cpp \
     rt.cpp \
 
 LOCAL_SRC_FILES_arm     := arch/arm/begin.S
-LOCAL_SRC_FILES_arm64   := arch/arm64/begin.S
+LOCAL_SRC_FILES_arm64   := arch/arm64/begin.S arch/arm64/tlsdesc_resolver.S
 LOCAL_SRC_FILES_x86     := arch/x86/begin.c
 LOCAL_SRC_FILES_x86_64  := arch/x86_64/begin.S
 LOCAL_SRC_FILES_mips    := arch/mips/begin.S
@@ -27,6 +27,7 @@
  */
 
 #include "linker.h"
+#include "linker_environ.h"
 
 #include <errno.h>
 #include <inttypes.h>
@@ -36,6 +37,9 @@
 #include <sys/mman.h>
 #include <sys/prctl.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/ucontext.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
@@ -72,6 +76,15 @@ struct debugger_msg_t {
 // see man(2) prctl, specifically the section about PR_GET_NAME
 #define MAX_TASK_NAME_LEN (16)
 
+// With DEBUGGERD_MINIMAL=1 in its environment, a crashing process doesn't
+// wait while debuggerd attaches and writes a tombstone, which can take
+// seconds. It logs its registers and the top of its stack itself, and
+// dies straight away so that whoever restarts it can do so sooner.
+static bool g_minimal_crash_reports = false;
+
+// How much of the stack the minimal report shows.
+static const size_t kStackSnapshotWords = 16;
+
 static int socket_abstract_client(const char* name, int type) {
   sockaddr_un addr;
 
@@ -180,6 +193,60 @@ static void log_signal_summary(int signum, const siginfo_t* info) {
                     signum, signal_name, code_desc, addr_desc, gettid(), thread_name);
 }
 
+/*
+ * Logs the crashing thread's pc, sp and (where there is one) link register,
+ * the top of its stack, and which library the pc is in. Like
+ * log_signal_summary, this mustn't allocate or take locks.
+ */
+static void log_crash_snapshot(const ucontext_t* uc) {
+  uintptr_t pc;
+  uintptr_t sp;
+  uintptr_t lr = 0;
+#if defined(__arm__)
+  pc = uc->uc_mcontext.arm_pc;
+  sp = uc->uc_mcontext.arm_sp;
+  lr = uc->uc_mcontext.arm_lr;
+#elif defined(__aarch64__)
+  pc = uc->uc_mcontext.pc;
+  sp = uc->uc_mcontext.sp;
+  lr = uc->uc_mcontext.regs[30];
+#elif defined(__i386__)
+  pc = uc->uc_mcontext.gregs[REG_EIP];
+  sp = uc->uc_mcontext.gregs[REG_ESP];
+#elif defined(__mips__)
+  pc = uc->uc_mcontext.pc;
+  sp = uc->uc_mcontext.gregs[29];
+  lr = uc->uc_mcontext.gregs[31];
+#elif defined(__x86_64__)
+  pc = uc->uc_mcontext.gregs[REG_RIP];
+  sp = uc->uc_mcontext.gregs[REG_RSP];
+#endif
+  __libc_format_log(ANDROID_LOG_FATAL, "libc", "    pc %p  sp %p  lr %p",
+                    reinterpret_cast<void*>(pc), reinterpret_cast<void*>(sp),
+                    reinterpret_cast<void*>(lr));
+
+  // A stack overflow or a corrupt sp is a common reason to be here, so read
+  // the stack in a way that fails rather than faulting again.
+  uintptr_t words[kStackSnapshotWords];
+  iovec local = { words, sizeof(words) };
+  iovec remote = { reinterpret_cast<void*>(sp), sizeof(words) };
+  ssize_t bytes = syscall(__NR_process_vm_readv, getpid(), &local, 1, &remote, 1, 0);
+  size_t count = (bytes > 0) ? bytes / sizeof(uintptr_t) : 0;
+  for (size_t i = 0; i + 4 <= count; i += 4) {
+    __libc_format_log(ANDROID_LOG_FATAL, "libc", "    %p  %p %p %p %p",
+                      reinterpret_cast<void*>(sp + i * sizeof(uintptr_t)),
+                      reinterpret_cast<void*>(words[i]), reinterpret_cast<void*>(words[i + 1]),
+                      reinterpret_cast<void*>(words[i + 2]), reinterpret_cast<void*>(words[i + 3]));
+  }
+
+  // Last, since the linker's own state is one of the things that might be broken.
+  soinfo* si = find_containing_library(reinterpret_cast<void*>(pc));
+  if (si != nullptr) {
+    __libc_format_log(ANDROID_LOG_FATAL, "libc", "    pc %p is in %s",
+                      reinterpret_cast<void*>(pc - si->load_bias), si->name);
+  }
+}
+
 /*
  * Returns true if the handler for signal "signum" has SA_SIGINFO set.
  */
@@ -251,16 +318,22 @@ static void send_debuggerd_packet(siginfo_t* info) {
  * Catches fatal signals so we can ask debuggerd to ptrace us before
  * we crash.
  */
-static void debuggerd_signal_handler(int signal_number, siginfo_t* info, void*) {
+static void debuggerd_signal_handler(int signal_number, siginfo_t* info, void* context) {
   // It's possible somebody cleared the SA_SIGINFO flag, which would mean
-  // our "info" arg holds an undefined value.
+  // our "info" and "context" args hold undefined values.
   if (!have_siginfo(signal_number)) {
     info = nullptr;
+    context = nullptr;
   }
 
   log_signal_summary(signal_number, info);
 
-  send_debuggerd_packet(info);
+  if (!g_minimal_crash_reports) {
+    send_debuggerd_packet(info);
+  } else if (context != nullptr && prctl(PR_GET_DUMPABLE, 0, 0, 0, 0) != 0) {
+    // As with debuggerd, a process that isn't dumpable doesn't want its state shown.
+    log_crash_snapshot(reinterpret_cast<ucontext_t*>(context));
+  }
 
   // Remove our net so we fault for real when we return.
   signal(signal_number, SIG_DFL);
@@ -287,6 +360,9 @@ static void debuggerd_signal_handler(int signal_number, siginfo_t* info, void*)
 }
 
 __LIBC_HIDDEN__ void debuggerd_init() {
+  const char* minimal = linker_env_get("DEBUGGERD_MINIMAL");
+  g_minimal_crash_reports = (minimal != nullptr && atoi(minimal) != 0);
+
   struct sigaction action;
   memset(&action, 0, sizeof(action));
   sigemptyset(&action.sa_mask);
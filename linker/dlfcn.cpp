@@ -15,6 +15,7 @@
  */
 
 #include "linker.h"
+#include "linker_address_index.h"
 
 #include <dlfcn.h>
 #include <pthread.h>
@@ -25,10 +26,14 @@
 #include <bionic/pthread_internal.h>
 #include "private/bionic_tls.h"
 #include "private/ScopedPthreadMutexLocker.h"
+#include "private/ScopedRWLock.h"
 #include "private/ThreadLocalBuffer.h"
 
 /* This file hijacks the symbols stubbed out in libdl.so. */
 
+// Serializes dlopen(3), dlclose(3) and LD_LIBRARY_PATH updates. Lookups
+// (dlsym(3) and dladdr(3)) only take g_soinfo_list_lock for reading, so
+// they don't wait for a slow dlopen(3) to finish.
 static pthread_mutex_t g_dl_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
 
 static const char* __bionic_set_dlerror(char* new_value) {
@@ -83,9 +88,7 @@ void* dlopen(const char* filename, int flags) {
   return dlopen_ext(filename, flags, nullptr);
 }
 
-void* dlsym(void* handle, const char* symbol) {
-  ScopedPthreadMutexLocker locker(&g_dl_mutex);
-
+static void* dlsym_locked(void* handle, const char* symbol, void* caller_addr, soinfo** found_out) {
 #if !defined(__LP64__)
   if (handle == nullptr) {
     __bionic_format_dlerror("dlsym library handle is null", nullptr);
@@ -103,7 +106,6 @@ void* dlsym(void* handle, const char* symbol) {
   if (handle == RTLD_DEFAULT) {
     sym = dlsym_linear_lookup(symbol, &found, nullptr);
   } else if (handle == RTLD_NEXT) {
-    void* caller_addr = __builtin_return_address(0);
     soinfo* si = find_containing_library(caller_addr);
 
     sym = nullptr;
@@ -118,6 +120,7 @@ void* dlsym(void* handle, const char* symbol) {
     unsigned bind = ELF_ST_BIND(sym->st_info);
 
     if ((bind == STB_GLOBAL || bind == STB_WEAK) && sym->st_shndx != 0) {
+      *found_out = found;
       return reinterpret_cast<void*>(found->resolve_symbol_address(sym));
     }
 
@@ -129,11 +132,60 @@ void* dlsym(void* handle, const char* symbol) {
   }
 }
 
-int dladdr(const void* addr, Dl_info* info) {
+void* dlsym(void* handle, const char* symbol) {
+  void* caller_addr = __builtin_return_address(0);
+  soinfo* uninitialized = nullptr;
+  void* result;
+  {
+    ScopedReadLock locker(&g_soinfo_list_lock);
+    soinfo* found = nullptr;
+    result = dlsym_locked(handle, symbol, caller_addr, &found);
+    if (result != nullptr && !found->constructors_called) {
+      uninitialized = found;
+    }
+  }
+
+  // A library loaded with ANDROID_DLEXT_DEFER_CONSTRUCTORS is initialized
+  // when a symbol is first looked up in it. Not under the read lock: the
+  // constructors may well call dlopen(3). That means it may also have been
+  // dlclose(3)d in the meantime, so look it up again before touching it.
+  if (uninitialized != nullptr) {
+    ScopedPthreadMutexLocker locker(&g_dl_mutex);
+    soinfo* si = soinfo_from_handle(uninitialized);
+    if (si != nullptr) {
+      do_dlinit(si);
+    }
+  }
+  return result;
+}
+
+int android_dlopen_many(const char* const filenames[], size_t count, int flags, void* handles[]) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  if (!do_dlopen_many(filenames, count, flags, reinterpret_cast<soinfo**>(handles))) {
+    __bionic_format_dlerror("dlopen failed", linker_get_error_buffer());
+    return -1;
+  }
+  return 0;
+}
+
+int android_dlinit(void* handle) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  soinfo* si = soinfo_from_handle(handle);
+  if (si == nullptr) {
+    __bionic_format_dlerror("android_dlinit failed", "invalid handle");
+    return -1;
+  }
+  do_dlinit(si);
+  return 0;
+}
+
+int dladdr(const void* addr, Dl_info* info) {
+  ScopedReadLock locker(&g_soinfo_list_lock);
 
-  // Determine if this address can be found in any library currently mapped.
-  soinfo* si = find_containing_library(addr);
+  // Determine if this address can be found in any library currently mapped,
+  // and if any symbol in the library contains it.
+  soinfo* si;
+  ElfW(Sym)* sym = address_index_find_symbol(addr, &si);
   if (si == nullptr) {
     return 0;
   }
@@ -144,8 +196,6 @@ int dladdr(const void* addr, Dl_info* info) {
   // Address at which the shared object is loaded.
   info->dli_fbase = reinterpret_cast<void*>(si->base);
 
-  // Determine if any symbol in the library contains the specified address.
-  ElfW(Sym)* sym = dladdr_find_symbol(si, addr);
   if (sym != nullptr) {
     info->dli_sname = si->get_string(sym->st_name);
     info->dli_saddr = reinterpret_cast<void*>(si->resolve_symbol_address(sym));
@@ -181,15 +231,15 @@ int dlclose(void* handle) {
     }
 
 #if defined(__arm__)
-  // 0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888888899999 9999900000000001 1111111112222222222 333333333344444444445
-  // 0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345678901234 5678901234567890 1234567890123456789 012345678901234567890
+  // 0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888888899999 9999900000000001 1111111112222222222 333333333344444 44444555555555566666 666667777777777888888
+  // 0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345678901234 5678901234567890 1234567890123456789 012345678901234 56789012345678901234 567890123456789012345
 #  define ANDROID_LIBDL_STRTAB \
-    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_get_LD_LIBRARY_PATH\0dl_iterate_phdr\0android_dlopen_ext\0dl_unwind_find_exidx\0"
+    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_get_LD_LIBRARY_PATH\0dl_iterate_phdr\0android_dlopen_ext\0android_dlinit\0android_dlopen_many\0dl_unwind_find_exidx\0"
 #elif defined(__aarch64__) || defined(__i386__) || defined(__mips__) || defined(__x86_64__)
-  // 0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888888899999 9999900000000001 1111111112222222222
-  // 0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345678901234 5678901234567890 1234567890123456789
+  // 0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888888899999 9999900000000001 1111111112222222222 333333333344444 44444555555555566666
+  // 0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345678901234 5678901234567890 1234567890123456789 012345678901234 56789012345678901234
 #  define ANDROID_LIBDL_STRTAB \
-    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_get_LD_LIBRARY_PATH\0dl_iterate_phdr\0android_dlopen_ext\0"
+    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_get_LD_LIBRARY_PATH\0dl_iterate_phdr\0android_dlopen_ext\0android_dlinit\0android_dlopen_many\0"
 #else
 #  error Unsupported architecture. Only arm, arm64, mips, mips64, x86 and x86_64 are presently supported.
 #endif
@@ -209,8 +259,10 @@ static ElfW(Sym) g_libdl_symtab[] = {
   ELFW(SYM_INITIALIZER)( 67, &android_get_LD_LIBRARY_PATH, 1),
   ELFW(SYM_INITIALIZER)( 95, &dl_iterate_phdr, 1),
   ELFW(SYM_INITIALIZER)(111, &android_dlopen_ext, 1),
+  ELFW(SYM_INITIALIZER)(130, &android_dlinit, 1),
+  ELFW(SYM_INITIALIZER)(145, &android_dlopen_many, 1),
 #if defined(__arm__)
-  ELFW(SYM_INITIALIZER)(130, &dl_unwind_find_exidx, 1),
+  ELFW(SYM_INITIALIZER)(165, &dl_unwind_find_exidx, 1),
 #endif
 };
 
@@ -222,14 +274,14 @@ static ElfW(Sym) g_libdl_symtab[] = {
 //
 // That is, g_libdl_chains should look like { 0, 2, 3, ... N, 0 } where N is the number
 // of actual symbols, or nelems(g_libdl_symtab)-1 (since the first element of g_libdl_symtab is not
-// a real symbol). (See soinfo_elf_lookup().)
+// a real symbol). (See soinfo::elf_lookup().)
 //
 // Note that adding any new symbols here requires stubbing them out in libdl.
 static unsigned g_libdl_buckets[1] = { 1 };
 #if defined(__arm__)
-static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0 };
+static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0 };
 #else
-static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 0 };
+static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0 };
 #endif
 
 static soinfo __libdl_info("libdl.so", nullptr, 0);
@@ -26,6 +26,7 @@
  * SUCH DAMAGE.
  */
 
+#include <dirent.h>
 #include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -34,24 +35,37 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/auxv.h>
 #include <sys/mman.h>
+#include <sys/param.h>
 #include <unistd.h>
 
 #include <new>
 
 // Private C library headers.
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_ifunc.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
 #include "private/ScopedPthreadMutexLocker.h"
 #include "private/ScopedFd.h"
+#include "private/ScopedRWLock.h"
 #include "private/ScopeGuard.h"
 #include "private/UniquePtr.h"
 
 #include "linker.h"
+#include "linker_address_index.h"
 #include "linker_debug.h"
 #include "linker_environ.h"
+#include "linker_load_stats.h"
 #include "linker_phdr.h"
 #include "linker_allocator.h"
+#include "linker_reloc_iterators.h"
+#include "linker_relocation_cache.h"
+#include "linker_sleb128.h"
+#include "linker_tls.h"
+#include "linker_zip.h"
 
 /* >>> IMPORTANT NOTE - READ ME BEFORE MODIFYING <<<
  *
@@ -83,8 +97,44 @@ static const char* get_base_name(const char* name) {
 
 static ElfW(Addr) get_elf_exec_load_bias(const ElfW(Ehdr)* elf);
 
-static LinkerAllocator<soinfo> g_soinfo_allocator;
-static LinkerAllocator<LinkedListEntry<soinfo>> g_soinfo_links_allocator;
+// The pages of every allocator whose data protect_data() makes read-only.
+static LinkerPageAllocator g_protected_page_allocator;
+
+static LinkerAllocator<soinfo> g_soinfo_allocator(&g_protected_page_allocator);
+static LinkerAllocator<LinkedListEntry<soinfo>> g_soinfo_links_allocator(&g_protected_page_allocator);
+
+// An entry in the global scope symbol cache; see global_scope_lookup().
+struct SymbolCacheEntry {
+  SymbolCacheEntry* next;
+  uint32_t hash;
+  const char* name;
+  // The library whose string table 'name' points into.
+  soinfo* name_owner;
+  // Where the symbol was found, or nullptr for a cached miss.
+  soinfo* lsi;
+  ElfW(Sym)* s;
+};
+
+static LinkerAllocator<SymbolCacheEntry> g_symbol_cache_allocator(&g_protected_page_allocator);
+static LinkerAllocator<LinkedListEntry<soinfo>> g_soinfo_index_allocator(&g_protected_page_allocator);
+
+// A directory of the library search path; see library_directory_may_contain().
+struct LibraryDirectory {
+  LibraryDirectory* next;
+  const char* path;
+  // False if the directory couldn't be listed, in which case every name
+  // has to be tried.
+  bool listed;
+};
+
+struct LibraryDirectoryEntry {
+  LibraryDirectoryEntry* next;
+  const LibraryDirectory* directory;
+  uint32_t hash;
+};
+
+static LinkerAllocator<LibraryDirectory> g_library_directory_allocator(&g_protected_page_allocator);
+static LinkerAllocator<LibraryDirectoryEntry> g_library_directory_entry_allocator(&g_protected_page_allocator);
 
 static soinfo* solist;
 static soinfo* sonext;
@@ -117,6 +167,12 @@ static soinfo* g_ld_preloads[LDPRELOAD_MAX + 1];
 
 __LIBC_HIDDEN__ int g_ld_debug_verbosity;
 
+__LIBC_HIDDEN__ pthread_rwlock_t g_soinfo_list_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Reported by dl_iterate_phdr; only changed with g_soinfo_list_lock held for writing.
+static unsigned long long g_dlpi_adds;
+static unsigned long long g_dlpi_subs;
+
 __LIBC_HIDDEN__ abort_msg_t* g_abort_message = nullptr; // For debuggerd.
 
 enum RelocationKind {
@@ -278,8 +334,118 @@ void SoinfoListAllocator::free(LinkedListEntry<soinfo>* entry) {
 }
 
 static void protect_data(int protection) {
-  g_soinfo_allocator.protect_all(protection);
-  g_soinfo_links_allocator.protect_all(protection);
+  g_protected_page_allocator.protect_all(protection);
+}
+
+static void symbol_cache_purge(soinfo* si);
+
+// soinfo_free doesn't unmap libraries itself. dlclose(3) often unloads a
+// whole tree of libraries, which were mostly mapped next to each other, and
+// every munmap costs a TLB shootdown on each core the process runs on; so
+// the ranges are collected here and unmapped together, adjacent ones as one
+// range, once the unload is over. By then nothing refers to them.
+struct PendingUnmap {
+  ElfW(Addr) start;
+  size_t size;
+};
+
+#define PENDING_UNMAP_MAX 64
+
+static PendingUnmap g_pending_unmaps[PENDING_UNMAP_MAX];
+static size_t g_pending_unmap_count;
+
+static void flush_pending_unmaps() {
+  // Sort by address (there are rarely more than a handful).
+  for (size_t i = 1; i < g_pending_unmap_count; ++i) {
+    PendingUnmap range = g_pending_unmaps[i];
+    size_t j = i;
+    for (; j > 0 && g_pending_unmaps[j - 1].start > range.start; --j) {
+      g_pending_unmaps[j] = g_pending_unmaps[j - 1];
+    }
+    g_pending_unmaps[j] = range;
+  }
+
+  size_t i = 0;
+  while (i < g_pending_unmap_count) {
+    ElfW(Addr) start = g_pending_unmaps[i].start;
+    ElfW(Addr) end = start + g_pending_unmaps[i].size;
+    for (++i; i < g_pending_unmap_count && g_pending_unmaps[i].start == end; ++i) {
+      end += g_pending_unmaps[i].size;
+    }
+    TRACE("unmapping [%p, %p)", reinterpret_cast<void*>(start), reinterpret_cast<void*>(end));
+    munmap(reinterpret_cast<void*>(start), end - start);
+  }
+  g_pending_unmap_count = 0;
+}
+
+static void defer_unmap(ElfW(Addr) start, size_t size) {
+  if (g_pending_unmap_count == PENDING_UNMAP_MAX) {
+    flush_pending_unmaps();
+  }
+  g_pending_unmaps[g_pending_unmap_count].start = start;
+  g_pending_unmaps[g_pending_unmap_count].size = size;
+  ++g_pending_unmap_count;
+}
+
+// Every loaded library is indexed both by name and by the identity of the
+// file it was loaded from, so that dlopen(3) and DT_NEEDED processing don't
+// have to walk the whole of solist to find out whether a library is
+// already loaded. Chains keep solist order (new entries go at the end), so
+// lookups find the same soinfo a linear search of solist would.
+#define SOINFO_INDEX_BUCKETS 512
+
+static LinkedListEntry<soinfo>* g_soinfo_name_index[SOINFO_INDEX_BUCKETS];
+static LinkedListEntry<soinfo>* g_soinfo_file_index[SOINFO_INDEX_BUCKETS];
+
+static size_t soinfo_name_bucket(const char* name) {
+  return SymbolName(name).gnu_hash() % SOINFO_INDEX_BUCKETS;
+}
+
+static size_t soinfo_file_bucket(dev_t dev, ino_t ino, off64_t offset) {
+  uint64_t h = static_cast<uint64_t>(dev) * 31 + static_cast<uint64_t>(ino);
+  h = h * 31 + static_cast<uint64_t>(offset);
+  return (h ^ (h >> 32)) % SOINFO_INDEX_BUCKETS;
+}
+
+static bool soinfo_has_file_identity(soinfo* si) {
+  return si->get_st_dev() != 0 && si->get_st_ino() != 0;
+}
+
+static void soinfo_index_insert(LinkedListEntry<soinfo>** bucket, soinfo* si) {
+  LinkedListEntry<soinfo>* entry = g_soinfo_index_allocator.alloc();
+  entry->next = nullptr;
+  entry->element = si;
+  while (*bucket != nullptr) {
+    bucket = &(*bucket)->next;
+  }
+  *bucket = entry;
+}
+
+static void soinfo_index_remove(LinkedListEntry<soinfo>** bucket, soinfo* si) {
+  for (; *bucket != nullptr; bucket = &(*bucket)->next) {
+    LinkedListEntry<soinfo>* entry = *bucket;
+    if (entry->element == si) {
+      *bucket = entry->next;
+      g_soinfo_index_allocator.free(entry);
+      return;
+    }
+  }
+}
+
+static void soinfo_index_add(soinfo* si) {
+  soinfo_index_insert(&g_soinfo_name_index[soinfo_name_bucket(si->name)], si);
+  if (soinfo_has_file_identity(si)) {
+    size_t bucket = soinfo_file_bucket(si->get_st_dev(), si->get_st_ino(), si->get_file_offset());
+    soinfo_index_insert(&g_soinfo_file_index[bucket], si);
+  }
+}
+
+static void soinfo_index_del(soinfo* si) {
+  soinfo_index_remove(&g_soinfo_name_index[soinfo_name_bucket(si->name)], si);
+  if (soinfo_has_file_identity(si)) {
+    size_t bucket = soinfo_file_bucket(si->get_st_dev(), si->get_st_ino(), si->get_file_offset());
+    soinfo_index_remove(&g_soinfo_file_index[bucket], si);
+  }
 }
 
 static soinfo* soinfo_alloc(const char* name, struct stat* file_stat, off64_t file_offset) {
@@ -290,20 +456,40 @@ static soinfo* soinfo_alloc(const char* name, struct stat* file_stat, off64_t fi
 
   soinfo* si = new (g_soinfo_allocator.alloc()) soinfo(name, file_stat, file_offset);
 
-  sonext->next = si;
-  sonext = si;
+  {
+    ScopedWriteLock locker(&g_soinfo_list_lock);
+    sonext->next = si;
+    sonext = si;
+    soinfo_index_add(si);
+  }
 
   TRACE("name %s: allocated soinfo @ %p", name, si);
   return si;
 }
 
+static void phdr_snapshot_invalidate();
+static void symbol_filter_invalidate(bool library_removed);
+
+// Makes a library visible to lookups that only take g_soinfo_list_lock for
+// reading.
+static void soinfo_set_linked(soinfo* si) {
+  ScopedWriteLock locker(&g_soinfo_list_lock);
+  si->flags |= FLAG_LINKED;
+  address_index_add(si);
+  ++g_dlpi_adds;
+  phdr_snapshot_invalidate();
+  symbol_filter_invalidate(false);
+}
+
 static void soinfo_free(soinfo* si) {
   if (si == nullptr) {
     return;
   }
 
+  ScopedWriteLock locker(&g_soinfo_list_lock);
+
   if (si->base != 0 && si->size != 0) {
-    munmap(reinterpret_cast<void*>(si->base), si->size);
+    defer_unmap(si->base, si->size);
   }
 
   soinfo *prev = nullptr, *trav;
@@ -325,6 +511,18 @@ static void soinfo_free(soinfo* si) {
   // clear links to/from si
   si->remove_all_links();
 
+  linker_tls_unregister(si);
+
+  // forget any cached lookups that refer to si
+  symbol_cache_purge(si);
+  soinfo_index_del(si);
+  address_index_remove(si);
+  if ((si->flags & FLAG_LINKED) != 0) {
+    ++g_dlpi_subs;
+    phdr_snapshot_invalidate();
+    symbol_filter_invalidate(true);
+  }
+
   // prev will never be null, because the first entry in solist is
   // always the static libdl_info.
   prev->next = si->next;
@@ -385,11 +583,11 @@ static void parse_LD_PRELOAD(const char* path) {
 _Unwind_Ptr dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
   unsigned addr = (unsigned)pc;
 
-  for (soinfo* si = solist; si != 0; si = si->next) {
-    if ((addr >= si->base) && (addr < (si->base + si->size))) {
-        *pcount = si->ARM_exidx_count;
-        return (_Unwind_Ptr)si->ARM_exidx;
-    }
+  ScopedReadLock locker(&g_soinfo_list_lock);
+  soinfo* si = find_containing_library(reinterpret_cast<void*>(addr));
+  if (si != nullptr) {
+    *pcount = si->ARM_exidx_count;
+    return (_Unwind_Ptr)si->ARM_exidx;
   }
   *pcount = 0;
   return nullptr;
@@ -397,57 +595,225 @@ _Unwind_Ptr dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
 
 #endif
 
+// What dl_iterate_phdr reports, in one array rather than spread over the
+// soinfos, since unwinders call it for every frame. Changes to the list
+// (under the write lock) invalidate it, and the next dl_iterate_phdr
+// rebuilds it. The callbacks run without the lock, since they may dlopen(3)
+// or dlclose(3), so a snapshot isn't changed once published: each caller
+// takes a reference on it under the read lock, and the last one to drop it
+// unmaps it. g_phdr_snapshot itself holds a reference, and only changes
+// with the read lock and g_phdr_snapshot_mutex held.
+struct PhdrSnapshot {
+  size_t refs;
+  size_t capacity;
+  size_t count;
+  dl_phdr_info info[0];
+};
+
+static PhdrSnapshot* g_phdr_snapshot;
+static bool g_phdr_snapshot_valid;
+static pthread_mutex_t g_phdr_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void phdr_snapshot_invalidate() {
+  __atomic_store_n(&g_phdr_snapshot_valid, false, __ATOMIC_RELAXED);
+}
+
+static size_t phdr_snapshot_size(size_t capacity) {
+  return sizeof(PhdrSnapshot) + capacity * sizeof(dl_phdr_info);
+}
+
+static void phdr_snapshot_release(PhdrSnapshot* snapshot) {
+  if (__atomic_sub_fetch(&snapshot->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    munmap(snapshot, phdr_snapshot_size(snapshot->capacity));
+  }
+}
+
+static bool phdr_snapshot_rebuild() {
+  size_t count = 0;
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    if ((si->flags & FLAG_LINKED) != 0) {
+      ++count;
+    }
+  }
+
+  // The old snapshot can be reused if nobody's iterating over it.
+  PhdrSnapshot* snapshot = g_phdr_snapshot;
+  if (snapshot == nullptr || snapshot->capacity < count ||
+      __atomic_load_n(&snapshot->refs, __ATOMIC_ACQUIRE) != 1) {
+    size_t size = (phdr_snapshot_size(count) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      return false;
+    }
+    snapshot = reinterpret_cast<PhdrSnapshot*>(map);
+    snapshot->refs = 1;
+    snapshot->capacity = (size - sizeof(PhdrSnapshot)) / sizeof(dl_phdr_info);
+  }
+
+  dl_phdr_info* info = snapshot->info;
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    if ((si->flags & FLAG_LINKED) == 0) {
+      continue;
+    }
+    info->dlpi_addr = si->link_map_head.l_addr;
+    info->dlpi_name = si->link_map_head.l_name;
+    info->dlpi_phdr = si->phdr;
+    info->dlpi_phnum = si->phnum;
+    info->dlpi_adds = g_dlpi_adds;
+    info->dlpi_subs = g_dlpi_subs;
+    ++info;
+  }
+  snapshot->count = count;
+
+  if (snapshot != g_phdr_snapshot) {
+    if (g_phdr_snapshot != nullptr) {
+      phdr_snapshot_release(g_phdr_snapshot);
+    }
+    g_phdr_snapshot = snapshot;
+  }
+  __atomic_store_n(&g_phdr_snapshot_valid, true, __ATOMIC_RELEASE);
+  return true;
+}
+
 // Here, we only have to provide a callback to iterate across all the
 // loaded libraries. gcc_eh does the rest.
 int dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
+  PhdrSnapshot* snapshot;
+  {
+    ScopedReadLock locker(&g_soinfo_list_lock);
+    if (!__atomic_load_n(&g_phdr_snapshot_valid, __ATOMIC_ACQUIRE)) {
+      ScopedPthreadMutexLocker snapshot_locker(&g_phdr_snapshot_mutex);
+      if (!g_phdr_snapshot_valid && !phdr_snapshot_rebuild()) {
+        return -1;
+      }
+    }
+    snapshot = g_phdr_snapshot;
+    __atomic_add_fetch(&snapshot->refs, 1, __ATOMIC_RELAXED);
+  }
+
+  // Libraries dlclose(3)d from here on may still be reported, as if they'd
+  // been unloaded just after dl_iterate_phdr returned.
   int rv = 0;
-  for (soinfo* si = solist; si != nullptr; si = si->next) {
-    dl_phdr_info dl_info;
-    dl_info.dlpi_addr = si->link_map_head.l_addr;
-    dl_info.dlpi_name = si->link_map_head.l_name;
-    dl_info.dlpi_phdr = si->phdr;
-    dl_info.dlpi_phnum = si->phnum;
+  for (size_t i = 0; i < snapshot->count; ++i) {
+    // The callback gets its own copy: it's allowed to scribble on it.
+    dl_phdr_info dl_info = snapshot->info[i];
     rv = cb(&dl_info, sizeof(dl_phdr_info), data);
     if (rv != 0) {
       break;
     }
   }
+  phdr_snapshot_release(snapshot);
   return rv;
 }
 
-static ElfW(Sym)* soinfo_elf_lookup(soinfo* si, unsigned hash, const char* name) {
-  ElfW(Sym)* symtab = si->symtab;
+static bool is_symbol_global_and_defined(const soinfo* si, const ElfW(Sym)* s) {
+  // only concern ourselves with global and weak symbol definitions
+  switch (ELF_ST_BIND(s->st_info)) {
+    case STB_GLOBAL:
+    case STB_WEAK:
+      return s->st_shndx != SHN_UNDEF;
+    case STB_LOCAL:
+      return false;
+    default:
+      __libc_fatal("ERROR: Unexpected ST_BIND value: %d for '%s' in '%s'",
+          ELF_ST_BIND(s->st_info), si->get_string(s->st_name), si->name);
+  }
+}
+
+static bool symbol_matches_soaddr(const ElfW(Sym)* sym, ElfW(Addr) soaddr) {
+  return sym->st_shndx != SHN_UNDEF &&
+      soaddr >= sym->st_value &&
+      soaddr < sym->st_value + sym->st_size;
+}
 
-  TRACE_TYPE(LOOKUP, "SEARCH %s in %s@%p %x %zd",
-             name, si->name, reinterpret_cast<void*>(si->base), hash, hash % si->nbucket);
+bool soinfo::is_gnu_hash() const {
+  return (flags & FLAG_GNU_HASH) != 0;
+}
+
+size_t soinfo::get_symbol_count() {
+  if (!is_gnu_hash()) {
+    return nchain;
+  }
+
+  // DT_GNU_HASH has no symbol count: find the last chain.
+  uint32_t last = 0;
+  for (size_t i = 0; i < gnu_nbucket; ++i) {
+    last = MAX(last, gnu_bucket[i]);
+  }
+  if (last == 0) {
+    return 0;
+  }
+  while ((gnu_chain[last] & 1) == 0) {
+    ++last;
+  }
+  return last + 1;
+}
+
+ElfW(Sym)* soinfo::find_symbol_by_name(SymbolName& symbol_name) {
+  return is_gnu_hash() ? gnu_lookup(symbol_name) : elf_lookup(symbol_name);
+}
+
+ElfW(Sym)* soinfo::gnu_lookup(SymbolName& symbol_name) {
+  uint32_t hash = symbol_name.gnu_hash();
+  uint32_t h2 = hash >> gnu_shift2;
+
+  uint32_t bloom_mask_bits = sizeof(ElfW(Addr))*8;
+  uint32_t word_num = (hash / bloom_mask_bits) & gnu_maskwords;
+  ElfW(Addr) bloom_word = gnu_bloom_filter[word_num];
+
+  // test against bloom filter
+  if ((1 & (bloom_word >> (hash % bloom_mask_bits)) & (bloom_word >> (h2 % bloom_mask_bits))) == 0) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p (gnu, bloom)",
+               symbol_name.get_name(), name, reinterpret_cast<void*>(base));
+    return nullptr;
+  }
+
+  // bloom test says "probably yes"...
+  uint32_t n = gnu_bucket[hash % gnu_nbucket];
+
+  if (n == 0) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p (gnu)",
+               symbol_name.get_name(), name, reinterpret_cast<void*>(base));
+    return nullptr;
+  }
 
-  for (unsigned n = si->bucket[hash % si->nbucket]; n != 0; n = si->chain[n]) {
+  do {
     ElfW(Sym)* s = symtab + n;
-    if (strcmp(si->get_string(s->st_name), name)) continue;
-
-    // only concern ourselves with global and weak symbol definitions
-    switch (ELF_ST_BIND(s->st_info)) {
-      case STB_GLOBAL:
-      case STB_WEAK:
-        if (s->st_shndx == SHN_UNDEF) {
-          continue;
-        }
+    if (((gnu_chain[n] ^ hash) >> 1) == 0 &&
+        strcmp(get_string(s->st_name), symbol_name.get_name()) == 0 &&
+        is_symbol_global_and_defined(this, s)) {
+      TRACE_TYPE(LOOKUP, "FOUND %s in %s (%p) %zd",
+                 symbol_name.get_name(), name, reinterpret_cast<void*>(s->st_value),
+                 static_cast<size_t>(s->st_size));
+      return s;
+    }
+  } while ((gnu_chain[n++] & 1) == 0);
+
+  TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p (gnu)",
+             symbol_name.get_name(), name, reinterpret_cast<void*>(base));
+
+  return nullptr;
+}
+
+ElfW(Sym)* soinfo::elf_lookup(SymbolName& symbol_name) {
+  uint32_t hash = symbol_name.elf_hash();
 
-        TRACE_TYPE(LOOKUP, "FOUND %s in %s (%p) %zd",
-                 name, si->name, reinterpret_cast<void*>(s->st_value),
+  TRACE_TYPE(LOOKUP, "SEARCH %s in %s@%p h=%x(elf) %zd",
+             symbol_name.get_name(), name, reinterpret_cast<void*>(base), hash, hash % nbucket);
+
+  for (uint32_t n = bucket[hash % nbucket]; n != 0; n = chain[n]) {
+    ElfW(Sym)* s = symtab + n;
+    if (strcmp(get_string(s->st_name), symbol_name.get_name()) == 0 &&
+        is_symbol_global_and_defined(this, s)) {
+      TRACE_TYPE(LOOKUP, "FOUND %s in %s (%p) %zd",
+                 symbol_name.get_name(), name, reinterpret_cast<void*>(s->st_value),
                  static_cast<size_t>(s->st_size));
-        return s;
-      case STB_LOCAL:
-        continue;
-      default:
-        __libc_fatal("ERROR: Unexpected ST_BIND value: %d for '%s' in '%s'",
-            ELF_ST_BIND(s->st_info), name, si->name);
+      return s;
     }
   }
 
   TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p %x %zd",
-             name, si->name, reinterpret_cast<void*>(si->base), hash, hash % si->nbucket);
-
+             symbol_name.get_name(), name, reinterpret_cast<void*>(base), hash, hash % nbucket);
 
   return nullptr;
 }
@@ -463,24 +829,114 @@ soinfo::soinfo(const char* name, const struct stat* file_stat, off64_t file_offs
     this->st_dev = file_stat->st_dev;
     this->st_ino = file_stat->st_ino;
     this->file_offset = file_offset;
+    this->file_mtime = file_stat->st_mtime;
+  }
+}
+
+uint32_t SymbolName::elf_hash() {
+  if (!has_elf_hash_) {
+    const unsigned char* name = reinterpret_cast<const unsigned char*>(name_);
+    uint32_t h = 0, g;
+
+    while (*name) {
+      h = (h << 4) + *name++;
+      g = h & 0xf0000000;
+      h ^= g;
+      h ^= g >> 24;
+    }
+
+    elf_hash_ = h;
+    has_elf_hash_ = true;
   }
+
+  return elf_hash_;
 }
 
-static unsigned elfhash(const char* _name) {
-  const unsigned char* name = reinterpret_cast<const unsigned char*>(_name);
-  unsigned h = 0, g;
+uint32_t SymbolName::gnu_hash() {
+  if (!has_gnu_hash_) {
+    uint32_t h = 5381;
+    const unsigned char* name = reinterpret_cast<const unsigned char*>(name_);
+    while (*name != 0) {
+      h += (h << 5) + *name++; // h*33 + c = h + h * 32 + c = h + h << 5 + c
+    }
 
-  while (*name) {
-    h = (h << 4) + *name++;
-    g = h & 0xf0000000;
-    h ^= g;
-    h ^= g >> 24;
+    gnu_hash_ = h;
+    has_gnu_hash_ = true;
+  }
+
+  return gnu_hash_;
+}
+
+// The global scope (the main executable followed by the LD_PRELOADs) is
+// searched first on behalf of every library, so the result of searching it
+// for a given name is the same whoever asks. Cache it, including misses,
+// which are the common case: most imports are satisfied by DT_NEEDED
+// libraries rather than by the executable.
+#define SYMBOL_CACHE_BUCKETS 1024
+#define SYMBOL_CACHE_MAX_ENTRIES 16384
+
+static SymbolCacheEntry* g_symbol_cache[SYMBOL_CACHE_BUCKETS];
+static size_t g_symbol_cache_size;
+
+static ElfW(Sym)* global_scope_lookup(soinfo* si, SymbolName& symbol_name, soinfo** lsi) {
+  uint32_t hash = symbol_name.gnu_hash();
+  SymbolCacheEntry** head = &g_symbol_cache[hash % SYMBOL_CACHE_BUCKETS];
+  for (SymbolCacheEntry* e = *head; e != nullptr; e = e->next) {
+    if (e->hash == hash && strcmp(e->name, symbol_name.get_name()) == 0) {
+      if (e->s != nullptr) {
+        *lsi = e->lsi;
+      }
+      return e->s;
+    }
+  }
+
+  DEBUG("%s: looking up %s in executable %s",
+        si->name, symbol_name.get_name(), somain->name);
+  soinfo* found = somain;
+  ElfW(Sym)* s = somain->find_symbol_by_name(symbol_name);
+  for (int i = 0; s == nullptr && g_ld_preloads[i] != nullptr; i++) {
+    found = g_ld_preloads[i];
+    s = found->find_symbol_by_name(symbol_name);
+  }
+
+  if (g_symbol_cache_size < SYMBOL_CACHE_MAX_ENTRIES) {
+    SymbolCacheEntry* e = g_symbol_cache_allocator.alloc();
+    e->next = *head;
+    e->hash = hash;
+    e->name = symbol_name.get_name();
+    e->name_owner = si;
+    e->lsi = (s != nullptr) ? found : nullptr;
+    e->s = s;
+    *head = e;
+    ++g_symbol_cache_size;
+  }
+
+  if (s != nullptr) {
+    *lsi = found;
+  }
+  return s;
+}
+
+// Drops every cache entry that refers to 'si', either as the library a symbol
+// was found in or as the owner of the string table holding the cached name.
+static void symbol_cache_purge(soinfo* si) {
+  for (size_t i = 0; i < SYMBOL_CACHE_BUCKETS; ++i) {
+    SymbolCacheEntry** p = &g_symbol_cache[i];
+    while (*p != nullptr) {
+      SymbolCacheEntry* e = *p;
+      if (e->name_owner == si || e->lsi == si) {
+        *p = e->next;
+        g_symbol_cache_allocator.free(e);
+        --g_symbol_cache_size;
+      } else {
+        p = &e->next;
+      }
+    }
   }
-  return h;
 }
 
 static ElfW(Sym)* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi) {
-  unsigned elf_hash = elfhash(name);
+  SymbolName symbol_name(name);
   ElfW(Sym)* s = nullptr;
 
   /* "This element's presence in a shared object library alters the dynamic linker's
@@ -496,31 +952,22 @@ static ElfW(Sym)* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi) {
    */
   if (si->has_DT_SYMBOLIC) {
     DEBUG("%s: looking up %s in local scope (DT_SYMBOLIC)", si->name, name);
-    s = soinfo_elf_lookup(si, elf_hash, name);
+    s = si->find_symbol_by_name(symbol_name);
     if (s != nullptr) {
       *lsi = si;
     }
   }
 
-  if (s == nullptr && somain != nullptr) {
-    // 1. Look for it in the main executable unless we already did.
-    if (si != somain || !si->has_DT_SYMBOLIC) {
-      DEBUG("%s: looking up %s in executable %s",
-            si->name, name, somain->name);
-      s = soinfo_elf_lookup(somain, elf_hash, name);
+  if (s == nullptr && somain != nullptr && (si != somain || !si->has_DT_SYMBOLIC)) {
+    // 1. and 2. Look for it in the main executable and the ld_preloads.
+    s = global_scope_lookup(si, symbol_name, lsi);
+  } else if (s == nullptr && somain != nullptr) {
+    // The main executable was already searched (DT_SYMBOLIC); look for it in the ld_preloads.
+    for (int i = 0; g_ld_preloads[i] != nullptr; i++) {
+      s = g_ld_preloads[i]->find_symbol_by_name(symbol_name);
       if (s != nullptr) {
-        *lsi = somain;
-      }
-    }
-
-    // 2. Look for it in the ld_preloads
-    if (s == nullptr) {
-      for (int i = 0; g_ld_preloads[i] != NULL; i++) {
-        s = soinfo_elf_lookup(g_ld_preloads[i], elf_hash, name);
-        if (s != nullptr) {
-          *lsi = g_ld_preloads[i];
-          break;
-        }
+        *lsi = g_ld_preloads[i];
+        break;
       }
     }
   }
@@ -537,7 +984,7 @@ static ElfW(Sym)* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi) {
 
   if (s == nullptr && !si->has_DT_SYMBOLIC) {
     DEBUG("%s: looking up %s in local scope", si->name, name);
-    s = soinfo_elf_lookup(si, elf_hash, name);
+    s = si->find_symbol_by_name(symbol_name);
     if (s != nullptr) {
       *lsi = si;
     }
@@ -546,7 +993,7 @@ static ElfW(Sym)* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi) {
   if (s == nullptr) {
     si->get_children().visit([&](soinfo* child) {
       DEBUG("%s: looking up %s in %s", si->name, name, child->name);
-      s = soinfo_elf_lookup(child, elf_hash, name);
+      s = child->find_symbol_by_name(symbol_name);
       if (s != nullptr) {
         *lsi = child;
         return false;
@@ -566,6 +1013,9 @@ static ElfW(Sym)* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi) {
   return s;
 }
 
+// The pages of the allocators below, which are never protected.
+static LinkerPageAllocator g_load_task_page_allocator;
+
 // Each size has it's own allocator.
 template<size_t size>
 class SizeBasedAllocator {
@@ -583,7 +1033,7 @@ class SizeBasedAllocator {
 };
 
 template<size_t size>
-LinkerBlockAllocator SizeBasedAllocator<size>::allocator_(size);
+LinkerBlockAllocator SizeBasedAllocator<size>::allocator_(size, &g_load_task_page_allocator);
 
 template<typename T>
 class TypeBasedAllocator {
@@ -601,6 +1051,7 @@ class LoadTask {
  public:
   struct deleter_t {
     void operator()(LoadTask* t) {
+      t->~LoadTask();
       TypeBasedAllocator<LoadTask>::free(t);
     }
   };
@@ -621,12 +1072,41 @@ class LoadTask {
   soinfo* get_needed_by() const {
     return needed_by_;
   }
+
+  // The library file opened ahead of time by prefetch_load_tasks, or -1,
+  // and the offset of the library in it.
+  int get_fd() const {
+    return fd_;
+  }
+
+  off64_t get_file_offset() const {
+    return file_offset_;
+  }
+
+  bool is_prefetched() const {
+    return prefetched_;
+  }
+
+  void set_prefetched(int fd, off64_t file_offset) {
+    fd_ = fd;
+    file_offset_ = file_offset;
+    prefetched_ = true;
+  }
  private:
   LoadTask(const char* name, soinfo* needed_by)
-    : name_(name), needed_by_(needed_by) {}
+    : name_(name), needed_by_(needed_by), fd_(-1), file_offset_(0), prefetched_(false) {}
+
+  ~LoadTask() {
+    if (fd_ != -1) {
+      close(fd_);
+    }
+  }
 
   const char* name_;
   soinfo* needed_by_;
+  int fd_;
+  off64_t file_offset_;
+  bool prefetched_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(LoadTask);
 };
@@ -643,40 +1123,176 @@ typedef linked_list_t<LoadTask> LoadTaskList;
 
 // This is used by dlsym(3).  It performs symbol lookup only within the
 // specified soinfo object and its dependencies in breadth first order.
+//
+// The caller holds g_soinfo_list_lock for reading, possibly concurrently with
+// other readers, so this mustn't touch the (unsynchronized) linker allocators.
+// Each library is queued at most once, so the queue lives on the stack and is
+// bounded by the number of loaded libraries.
 ElfW(Sym)* dlsym_handle_lookup(soinfo* si, soinfo** found, const char* name) {
-  SoinfoLinkedList visit_list;
-  SoinfoLinkedList visited;
+  SymbolName symbol_name(name);
 
-  visit_list.push_back(si);
-  soinfo* current_soinfo;
-  while ((current_soinfo = visit_list.pop_front()) != nullptr) {
-    if (visited.contains(current_soinfo)) {
-      continue;
-    }
+  size_t max_queue_size = 1;
+  for (soinfo* s = solist; s != nullptr; s = s->next) {
+    ++max_queue_size;
+  }
+
+  soinfo* queue[max_queue_size];
+  size_t queue_head = 0;
+  size_t queue_tail = 0;
 
-    ElfW(Sym)* result = soinfo_elf_lookup(current_soinfo, elfhash(name), name);
+  queue[queue_tail++] = si;
+  while (queue_head < queue_tail) {
+    soinfo* current_soinfo = queue[queue_head++];
+
+    ElfW(Sym)* result = current_soinfo->find_symbol_by_name(symbol_name);
 
     if (result != nullptr) {
       *found = current_soinfo;
       return result;
     }
-    visited.push_back(current_soinfo);
 
     current_soinfo->get_children().for_each([&](soinfo* child) {
-      visit_list.push_back(child);
+      for (size_t i = 0; i < queue_tail; ++i) {
+        if (queue[i] == child) {
+          return;
+        }
+      }
+      if (queue_tail < max_queue_size) {
+        queue[queue_tail++] = child;
+      }
     });
   }
 
   return nullptr;
 }
 
+// A Bloom filter over the names of the defined global symbols of every
+// linked library, so that dlsym(RTLD_DEFAULT) and dlsym(RTLD_NEXT) can give
+// up on a name no library defines after one probe, rather than after a
+// lookup in each library. Like the phdr snapshot, readers bring it up to
+// date under g_symbol_filter_mutex: libraries linked since the last update
+// are added, and unloading a library rebuilds it, since a Bloom filter can't
+// forget. A library is in the filter if its epoch matches
+// g_symbol_filter_epoch.
+static uint64_t* g_symbol_filter;
+static size_t g_symbol_filter_words;    // A power of two.
+static size_t g_symbol_filter_symbols;  // Added since the last rebuild.
+static uint32_t g_symbol_filter_epoch = 1;
+static bool g_symbol_filter_stale = true;
+static bool g_symbol_filter_needs_rebuild;
+static pthread_mutex_t g_symbol_filter_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Enough for about 16 bits per symbol, which with two bits set per symbol
+// makes for a false positive rate of a couple of percent.
+static const size_t kSymbolFilterSymbolsPerWord = 4;
+
+// Called with g_soinfo_list_lock held for writing.
+static void symbol_filter_invalidate(bool library_removed) {
+  if (library_removed) {
+    g_symbol_filter_needs_rebuild = true;
+  }
+  __atomic_store_n(&g_symbol_filter_stale, true, __ATOMIC_RELAXED);
+}
+
+// Both bits come from the same word, so a probe touches one cache line.
+static size_t symbol_filter_word(uint32_t hash) {
+  return (hash >> 6) & (g_symbol_filter_words - 1);
+}
+
+static uint64_t symbol_filter_bits(uint32_t hash) {
+  return (1ULL << (hash & 63)) | (1ULL << ((hash >> 26) & 63));
+}
+
+static void symbol_filter_add(soinfo* si) {
+  size_t count = si->get_symbol_count();
+  for (size_t i = 1; i < count; ++i) {
+    const ElfW(Sym)* s = si->symtab + i;
+    unsigned bind = ELF_ST_BIND(s->st_info);
+    if ((bind != STB_GLOBAL && bind != STB_WEAK) || s->st_shndx == SHN_UNDEF) {
+      continue;
+    }
+    SymbolName symbol_name(si->get_string(s->st_name));
+    uint32_t hash = symbol_name.gnu_hash();
+    g_symbol_filter[symbol_filter_word(hash)] |= symbol_filter_bits(hash);
+  }
+  g_symbol_filter_symbols += count;
+  si->set_symbol_filter_epoch(g_symbol_filter_epoch);
+}
+
+// Called with g_symbol_filter_mutex held, and g_soinfo_list_lock held for reading.
+static bool symbol_filter_update() {
+  size_t symbols = g_symbol_filter_needs_rebuild ? 0 : g_symbol_filter_symbols;
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    if ((si->flags & FLAG_LINKED) != 0 &&
+        (g_symbol_filter_needs_rebuild || si->get_symbol_filter_epoch() != g_symbol_filter_epoch)) {
+      symbols += si->get_symbol_count();
+    }
+  }
+
+  size_t words = PAGE_SIZE / sizeof(uint64_t);
+  while (words * kSymbolFilterSymbolsPerWord < symbols) {
+    words *= 2;
+  }
+
+  if (words > g_symbol_filter_words) {
+    void* map = mmap(nullptr, words * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      return false;
+    }
+    if (g_symbol_filter != nullptr) {
+      munmap(g_symbol_filter, g_symbol_filter_words * sizeof(uint64_t));
+    }
+    g_symbol_filter = reinterpret_cast<uint64_t*>(map);
+    g_symbol_filter_words = words;
+    g_symbol_filter_needs_rebuild = true;
+  } else if (g_symbol_filter_needs_rebuild) {
+    memset(g_symbol_filter, 0, g_symbol_filter_words * sizeof(uint64_t));
+  }
+
+  if (g_symbol_filter_needs_rebuild) {
+    // Forget which libraries were in the old filter.
+    ++g_symbol_filter_epoch;
+    g_symbol_filter_symbols = 0;
+    g_symbol_filter_needs_rebuild = false;
+  }
+
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    if ((si->flags & FLAG_LINKED) != 0 && si->get_symbol_filter_epoch() != g_symbol_filter_epoch) {
+      symbol_filter_add(si);
+    }
+  }
+  __atomic_store_n(&g_symbol_filter_stale, false, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Returns false if no linked library can define the symbol. The caller holds
+// g_soinfo_list_lock for reading, so the filter can't go stale while it's
+// being probed.
+static bool symbol_filter_may_contain(SymbolName& symbol_name) {
+  if (__atomic_load_n(&g_symbol_filter_stale, __ATOMIC_ACQUIRE)) {
+    ScopedPthreadMutexLocker locker(&g_symbol_filter_mutex);
+    if (g_symbol_filter_stale && !symbol_filter_update()) {
+      return true;
+    }
+  }
+  uint32_t hash = symbol_name.gnu_hash();
+  uint64_t bits = symbol_filter_bits(hash);
+  return (g_symbol_filter[symbol_filter_word(hash)] & bits) == bits;
+}
+
 /* This is used by dlsym(3) to performs a global symbol lookup. If the
    start value is null (for RTLD_DEFAULT), the search starts at the
    beginning of the global solist. Otherwise the search starts at the
    specified soinfo (for RTLD_NEXT).
  */
 ElfW(Sym)* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start) {
-  unsigned elf_hash = elfhash(name);
+  SymbolName symbol_name(name);
+
+  if (!symbol_filter_may_contain(symbol_name)) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in any library (filter)", name);
+    return nullptr;
+  }
 
   if (start == nullptr) {
     start = solist;
@@ -684,7 +1300,10 @@ ElfW(Sym)* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start)
 
   ElfW(Sym)* s = nullptr;
   for (soinfo* si = start; (s == nullptr) && (si != nullptr); si = si->next) {
-    s = soinfo_elf_lookup(si, elf_hash, name);
+    if ((si->flags & FLAG_LINKED) == 0) {
+      continue;
+    }
+    s = si->find_symbol_by_name(symbol_name);
     if (s != nullptr) {
       *found = si;
       break;
@@ -700,25 +1319,42 @@ ElfW(Sym)* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start)
 }
 
 soinfo* find_containing_library(const void* p) {
-  ElfW(Addr) address = reinterpret_cast<ElfW(Addr)>(p);
-  for (soinfo* si = solist; si != nullptr; si = si->next) {
-    if (address >= si->base && address - si->base < si->size) {
-      return si;
+  return address_index_find_library(p);
+}
+
+ElfW(Sym)* soinfo::find_symbol_by_address(const void* addr) {
+  return is_gnu_hash() ? gnu_addr_lookup(addr) : elf_addr_lookup(addr);
+}
+
+ElfW(Sym)* soinfo::gnu_addr_lookup(const void* addr) {
+  ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - base;
+
+  for (size_t i = 0; i < gnu_nbucket; ++i) {
+    uint32_t n = gnu_bucket[i];
+
+    if (n == 0) {
+      continue;
     }
+
+    do {
+      ElfW(Sym)* sym = symtab + n;
+      if (symbol_matches_soaddr(sym, soaddr)) {
+        return sym;
+      }
+    } while ((gnu_chain[n++] & 1) == 0);
   }
+
   return nullptr;
 }
 
-ElfW(Sym)* dladdr_find_symbol(soinfo* si, const void* addr) {
-  ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - si->base;
+ElfW(Sym)* soinfo::elf_addr_lookup(const void* addr) {
+  ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - base;
 
   // Search the library's symbol table for any defined symbol which
   // contains this address.
-  for (size_t i = 0; i < si->nchain; ++i) {
-    ElfW(Sym)* sym = &si->symtab[i];
-    if (sym->st_shndx != SHN_UNDEF &&
-        soaddr >= sym->st_value &&
-        soaddr < sym->st_value + sym->st_size) {
+  for (size_t i = 0; i < nchain; ++i) {
+    ElfW(Sym)* sym = symtab + i;
+    if (symbol_matches_soaddr(sym, soaddr)) {
       return sym;
     }
   }
@@ -726,15 +1362,138 @@ ElfW(Sym)* dladdr_find_symbol(soinfo* si, const void* addr) {
   return nullptr;
 }
 
-static int open_library_on_path(const char* name, const char* const paths[]) {
+extern "C" int __getdents64(unsigned int, dirent*, unsigned int);
+
+// With LD_LIBRARY_DIRECTORY_CACHE=1, each directory of the search path is
+// listed the first time it is searched, and names it doesn't contain are
+// rejected without an open(2) that would fail with ENOENT. Only hashes of
+// the names are kept: a collision just costs the open(2) we would have
+// made anyway. Files added to a directory after it was listed are not
+// found, so the listings are dropped by android_update_LD_LIBRARY_PATH.
+#define LIBRARY_DIRECTORY_CACHE_BUCKETS 256
+
+static bool g_library_directory_cache_enabled;
+static LibraryDirectory* g_library_directories;
+static LibraryDirectoryEntry* g_library_directory_entries[LIBRARY_DIRECTORY_CACHE_BUCKETS];
+
+static void library_directory_cache_purge() {
+  for (size_t i = 0; i < LIBRARY_DIRECTORY_CACHE_BUCKETS; ++i) {
+    LibraryDirectoryEntry* entry = g_library_directory_entries[i];
+    while (entry != nullptr) {
+      LibraryDirectoryEntry* next = entry->next;
+      g_library_directory_entry_allocator.free(entry);
+      entry = next;
+    }
+    g_library_directory_entries[i] = nullptr;
+  }
+  while (g_library_directories != nullptr) {
+    LibraryDirectory* next = g_library_directories->next;
+    g_library_directory_allocator.free(g_library_directories);
+    g_library_directories = next;
+  }
+}
+
+static uint32_t library_directory_hash(const char* name) {
+  SymbolName symbol_name(name);
+  return symbol_name.gnu_hash();
+}
+
+static void list_library_directory(LibraryDirectory* directory) {
+  int fd = TEMP_FAILURE_RETRY(open(directory->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  if (fd == -1) {
+    // A directory that doesn't exist contains nothing; otherwise (EACCES
+    // on an execute-only directory, say) we have to try each name.
+    directory->listed = (errno == ENOENT || errno == ENOTDIR);
+    return;
+  }
+  ScopedFd fd_guard(fd);
+
+  char buf[4096] __attribute__((aligned(8)));
+  int rc;
+  while ((rc = TEMP_FAILURE_RETRY(__getdents64(fd, reinterpret_cast<dirent*>(buf), sizeof(buf)))) > 0) {
+    for (int offset = 0; offset < rc; ) {
+      dirent* d = reinterpret_cast<dirent*>(buf + offset);
+      offset += d->d_reclen;
+      if (d->d_type == DT_DIR) {
+        continue;
+      }
+      LibraryDirectoryEntry* entry = g_library_directory_entry_allocator.alloc();
+      entry->directory = directory;
+      entry->hash = library_directory_hash(d->d_name);
+      LibraryDirectoryEntry** bucket =
+          &g_library_directory_entries[entry->hash % LIBRARY_DIRECTORY_CACHE_BUCKETS];
+      entry->next = *bucket;
+      *bucket = entry;
+    }
+  }
+  // On a read error, the partial listing is ignored.
+  directory->listed = (rc == 0);
+}
+
+// Returns false if 'name' is known not to be in the directory 'path'.
+static bool library_directory_may_contain(const char* path, const char* name) {
+  // A directory inside a zip archive ("archive.zip!/lib") can't be listed.
+  if (!g_library_directory_cache_enabled || strstr(path, "!/") != nullptr) {
+    return true;
+  }
+
+  LibraryDirectory* directory = g_library_directories;
+  while (directory != nullptr && strcmp(directory->path, path) != 0) {
+    directory = directory->next;
+  }
+  if (directory == nullptr) {
+    directory = g_library_directory_allocator.alloc();
+    directory->path = path;
+    directory->next = g_library_directories;
+    g_library_directories = directory;
+    list_library_directory(directory);
+  }
+  if (!directory->listed) {
+    return true;
+  }
+
+  uint32_t hash = library_directory_hash(name);
+  for (LibraryDirectoryEntry* entry = g_library_directory_entries[hash % LIBRARY_DIRECTORY_CACHE_BUCKETS];
+       entry != nullptr; entry = entry->next) {
+    if (entry->hash == hash && entry->directory == directory) {
+      return true;
+    }
+  }
+  TRACE("[ \"%s\" is not in %s ]", name, path);
+  return false;
+}
+
+// Opens a library file, which may be an entry of a zip archive named as
+// "archive.zip!/path/in/archive.so", in which case *file_offset is set to
+// where the library starts in the archive.
+static int open_library_file(const char* path, off64_t* file_offset) {
+  *file_offset = 0;
+  const char* separator = strstr(path, "!/");
+  if (separator == nullptr) {
+    return TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+  }
+  char archive_path[PATH_MAX];
+  size_t archive_path_length = separator - path;
+  if (archive_path_length >= sizeof(archive_path)) {
+    return -1;
+  }
+  memcpy(archive_path, path, archive_path_length);
+  archive_path[archive_path_length] = '\0';
+  return open_zip_entry(archive_path, separator + 2, file_offset);
+}
+
+static int open_library_on_path(const char* name, const char* const paths[], off64_t* file_offset) {
   char buf[512];
   for (size_t i = 0; paths[i] != nullptr; ++i) {
+    if (!library_directory_may_contain(paths[i], name)) {
+      continue;
+    }
     int n = __libc_format_buffer(buf, sizeof(buf), "%s/%s", paths[i], name);
     if (n < 0 || n >= static_cast<int>(sizeof(buf))) {
       PRINT("Warning: ignoring very long library path: %s/%s", paths[i], name);
       continue;
     }
-    int fd = TEMP_FAILURE_RETRY(open(buf, O_RDONLY | O_CLOEXEC));
+    int fd = open_library_file(buf, file_offset);
     if (fd != -1) {
       return fd;
     }
@@ -742,12 +1501,12 @@ static int open_library_on_path(const char* name, const char* const paths[]) {
   return -1;
 }
 
-static int open_library(const char* name) {
+static int open_library(const char* name, off64_t* file_offset) {
   TRACE("[ opening %s ]", name);
 
   // If the name contains a slash, we should attempt to open it directly and not search the paths.
   if (strchr(name, '/') != nullptr) {
-    int fd = TEMP_FAILURE_RETRY(open(name, O_RDONLY | O_CLOEXEC));
+    int fd = open_library_file(name, file_offset);
     if (fd != -1) {
       return fd;
     }
@@ -758,9 +1517,9 @@ static int open_library(const char* name) {
   }
 
   // Otherwise we try LD_LIBRARY_PATH first, and fall back to the built-in well known paths.
-  int fd = open_library_on_path(name, g_ld_library_paths);
+  int fd = open_library_on_path(name, g_ld_library_paths, file_offset);
   if (fd == -1) {
-    fd = open_library_on_path(name, kDefaultLdPaths);
+    fd = open_library_on_path(name, kDefaultLdPaths, file_offset);
   }
   return fd;
 }
@@ -774,19 +1533,30 @@ static void for_each_dt_needed(const soinfo* si, F action) {
   }
 }
 
-static soinfo* load_library(LoadTaskList& load_tasks, const char* name, int dlflags, const android_dlextinfo* extinfo) {
+static soinfo* load_library(LoadTaskList& load_tasks, const LoadTask* task,
+                            int dlflags, const android_dlextinfo* extinfo) {
+  const char* name = task->get_name();
   int fd = -1;
   off64_t file_offset = 0;
   ScopedFd file_guard(-1);
+  uint64_t search_ns = 0;
+  uint64_t load_ns = 0;
 
   if (extinfo != nullptr && (extinfo->flags & ANDROID_DLEXT_USE_LIBRARY_FD) != 0) {
     fd = extinfo->library_fd;
     if ((extinfo->flags & ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET) != 0) {
       file_offset = extinfo->library_fd_offset;
     }
+  } else if (task->get_fd() != -1) {
+    // Owned by the LoadTask.
+    fd = task->get_fd();
+    file_offset = task->get_file_offset();
   } else {
     // Open the file.
-    fd = open_library(name);
+    {
+      LoadStatsTimer timer(&search_ns);
+      fd = open_library(name, &file_offset);
+    }
     if (fd == -1) {
       DL_ERR("library \"%s\" not found", name);
       return nullptr;
@@ -808,10 +1578,10 @@ static soinfo* load_library(LoadTaskList& load_tasks, const char* name, int dlfl
 
   // Check for symlink and other situations where
   // file can have different names.
-  for (soinfo* si = solist; si != nullptr; si = si->next) {
-    if (si->get_st_dev() != 0 &&
-        si->get_st_ino() != 0 &&
-        si->get_st_dev() == file_stat.st_dev &&
+  size_t bucket = soinfo_file_bucket(file_stat.st_dev, file_stat.st_ino, file_offset);
+  for (LinkedListEntry<soinfo>* e = g_soinfo_file_index[bucket]; e != nullptr; e = e->next) {
+    soinfo* si = e->element;
+    if (si->get_st_dev() == file_stat.st_dev &&
         si->get_st_ino() == file_stat.st_ino &&
         si->get_file_offset() == file_offset) {
       TRACE("library \"%s\" is already loaded under different name/path \"%s\" - will return existing soinfo", name, si->name);
@@ -826,7 +1596,12 @@ static soinfo* load_library(LoadTaskList& load_tasks, const char* name, int dlfl
 
   // Read the ELF header and load the segments.
   ElfReader elf_reader(name, fd, file_offset);
-  if (!elf_reader.Load(extinfo)) {
+  bool loaded;
+  {
+    LoadStatsTimer timer(&load_ns);
+    loaded = elf_reader.Load(extinfo);
+  }
+  if (!loaded) {
     return nullptr;
   }
 
@@ -834,13 +1609,15 @@ static soinfo* load_library(LoadTaskList& load_tasks, const char* name, int dlfl
   if (si == nullptr) {
     return nullptr;
   }
+  si->get_load_stats().search_ns = search_ns;
+  si->get_load_stats().load_ns = load_ns;
   si->base = elf_reader.load_start();
   si->size = elf_reader.load_size();
   si->load_bias = elf_reader.load_bias();
   si->phnum = elf_reader.phdr_count();
   si->phdr = elf_reader.loaded_phdr();
 
-  if (!si->PrelinkImage()) {
+  if (!si->PrelinkImage() || !linker_tls_register(si)) {
     soinfo_free(si);
     return nullptr;
   }
@@ -852,17 +1629,115 @@ static soinfo* load_library(LoadTaskList& load_tasks, const char* name, int dlfl
   return si;
 }
 
-static soinfo *find_loaded_library_by_name(const char* name) {
-  const char* search_name = SEARCH_NAME(name);
-  for (soinfo* si = solist; si != nullptr; si = si->next) {
-    if (!strcmp(search_name, si->name)) {
-      return si;
+static soinfo *find_loaded_library_by_name(const char* name) {
+  const char* search_name = SEARCH_NAME(name);
+  for (LinkedListEntry<soinfo>* e = g_soinfo_name_index[soinfo_name_bucket(search_name)];
+       e != nullptr; e = e->next) {
+    if (!strcmp(search_name, e->element->name)) {
+      return e->element;
+    }
+  }
+  return nullptr;
+}
+
+// How much of each DT_NEEDED library prefetch_load_tasks asks the kernel to
+// start reading: enough for the ELF and program headers and, for most
+// libraries, the dynamic section and symbol tables.
+static const size_t kPrefetchSize = 64 * 1024;
+
+// Opens the libraries of the load tasks that haven't been opened yet, and
+// starts asynchronous reads of their headers, so that the I/O for a whole
+// breadth-first frontier of DT_NEEDED libraries overlaps instead of being
+// waited for one library at a time. The search itself is unchanged: each
+// name is opened with open_library() exactly as load_library() would.
+static void prefetch_load_tasks(LoadTaskList& load_tasks) {
+  load_tasks.for_each([](LoadTask* task) {
+    if (task->is_prefetched() || task->get_needed_by() == nullptr) {
+      return;
+    }
+    int fd = -1;
+    off64_t file_offset = 0;
+    if (find_loaded_library_by_name(task->get_name()) == nullptr) {
+      fd = open_library(task->get_name(), &file_offset);
+      if (fd != -1) {
+        posix_fadvise64(fd, file_offset, kPrefetchSize, POSIX_FADV_WILLNEED);
+      }
+    }
+    task->set_prefetched(fd, file_offset);
+  });
+}
+
+// LD_PREFETCH_MANIFEST names a file listing the libraries an earlier run of
+// the program loaded, one per line, each optionally followed by the
+// "offset+length" byte ranges of it that are worth reading ahead (the whole
+// file otherwise). Lines starting with '#' are ignored. Names are searched
+// for like DT_NEEDED names. Reads of all of them are started before the
+// executable's dependencies are loaded, so the page-in of a cold start
+// overlaps with linking instead of happening one fault at a time.
+static void prefetch_manifest(const char* path) {
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC)));
+  struct stat sb;
+  if (fd.get() == -1 || fstat(fd.get(), &sb) == -1 || sb.st_size <= 0) {
+    return;
+  }
+  void* map = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (map == MAP_FAILED) {
+    return;
+  }
+
+  const char* p = reinterpret_cast<const char*>(map);
+  const char* end = p + sb.st_size;
+  for (size_t line_number = 1; p < end; ++line_number) {
+    const char* eol = reinterpret_cast<const char*>(memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    char line[PATH_MAX + 256];
+    size_t length = eol - p;
+    if (length >= sizeof(line)) {
+      // Skip the whole line rather than prefetch whatever part of it fits.
+      DL_WARN("%s:%zu: ignoring line longer than %zu bytes", path, line_number, sizeof(line) - 1);
+      p = eol + 1;
+      continue;
+    }
+    memcpy(line, p, length);
+    line[length] = '\0';
+    p = eol + 1;
+
+    char* save_ptr;
+    const char* name = strtok_r(line, " \t", &save_ptr);
+    if (name == nullptr || name[0] == '#') {
+      continue;
+    }
+    off64_t file_offset;
+    int lib_fd = open_library(name, &file_offset);
+    if (lib_fd == -1) {
+      continue;
     }
+    bool have_ranges = false;
+    for (const char* range = strtok_r(nullptr, " \t", &save_ptr); range != nullptr;
+         range = strtok_r(nullptr, " \t", &save_ptr)) {
+      char* plus;
+      off64_t offset = strtoull(range, &plus, 0);
+      if (*plus != '+') {
+        continue;
+      }
+      off64_t range_length = strtoull(plus + 1, nullptr, 0);
+      posix_fadvise64(lib_fd, file_offset + offset, range_length, POSIX_FADV_WILLNEED);
+      have_ranges = true;
+    }
+    if (!have_ranges) {
+      posix_fadvise64(lib_fd, file_offset, 0, POSIX_FADV_WILLNEED);
+    }
+    close(lib_fd);
   }
-  return nullptr;
+
+  munmap(map, sb.st_size);
 }
 
-static soinfo* find_library_internal(LoadTaskList& load_tasks, const char* name, int dlflags, const android_dlextinfo* extinfo) {
+static soinfo* find_library_internal(LoadTaskList& load_tasks, const LoadTask* task, int dlflags,
+                                     const android_dlextinfo* extinfo) {
+  const char* name = task->get_name();
 
   soinfo* si = find_loaded_library_by_name(name);
 
@@ -870,7 +1745,7 @@ static soinfo* find_library_internal(LoadTaskList& load_tasks, const char* name,
   // of this fact is done by load_library.
   if (si == nullptr) {
     TRACE("[ '%s' has not been found by name.  Trying harder...]", name);
-    si = load_library(load_tasks, name, dlflags, extinfo);
+    si = load_library(load_tasks, task, dlflags, extinfo);
   }
 
   return si;
@@ -893,6 +1768,25 @@ static bool is_recursive(soinfo* si, soinfo* parent) {
   });
 }
 
+static bool share_gnu_relro(soinfo* si, const android_dlextinfo* extinfo, size_t* relro_file_offset) {
+  if ((extinfo->flags & ANDROID_DLEXT_WRITE_RELRO) != 0) {
+    if (phdr_table_serialize_gnu_relro(si->phdr, si->phnum, si->load_bias,
+                                       extinfo->relro_fd, relro_file_offset) < 0) {
+      DL_ERR("failed serializing GNU RELRO section for \"%s\": %s",
+             si->name, strerror(errno));
+      return false;
+    }
+  } else if ((extinfo->flags & ANDROID_DLEXT_USE_RELRO) != 0) {
+    if (phdr_table_map_gnu_relro(si->phdr, si->phnum, si->load_bias,
+                                 extinfo->relro_fd, relro_file_offset) < 0) {
+      DL_ERR("failed mapping GNU RELRO section for \"%s\": %s",
+             si->name, strerror(errno));
+      return false;
+    }
+  }
+  return true;
+}
+
 static bool find_libraries(const char* const library_names[], size_t library_names_size, soinfo* soinfos[],
     soinfo* ld_preloads[], size_t ld_preloads_size, int dlflags, const android_dlextinfo* extinfo) {
   // Step 0: prepare.
@@ -916,16 +1810,20 @@ static bool find_libraries(const char* const library_names[], size_t library_nam
     for (size_t i = 0; i<soinfos_size; ++i) {
       soinfo_unload(soinfos[i]);
     }
+    flush_pending_unmaps();
   });
 
   // Step 1: load and pre-link all DT_NEEDED libraries in breadth first order.
+  // The extinfo load options (reserved address, library fd) only apply to
+  // the requested libraries.
   for (LoadTask::unique_ptr task(load_tasks.pop_front()); task.get() != nullptr; task.reset(load_tasks.pop_front())) {
-    soinfo* si = find_library_internal(load_tasks, task->get_name(), dlflags, extinfo);
+    soinfo* needed_by = task->get_needed_by();
+    soinfo* si = find_library_internal(load_tasks, task.get(), dlflags,
+                                       needed_by == nullptr ? extinfo : nullptr);
     if (si == nullptr) {
       return false;
     }
-
-    soinfo* needed_by = task->get_needed_by();
+    prefetch_load_tasks(load_tasks);
 
     if (is_recursive(si, needed_by)) {
       return false;
@@ -948,14 +1846,26 @@ static bool find_libraries(const char* const library_names[], size_t library_nam
     }
   }
 
-  // Step 2: link libraries.
+  // Step 2: link libraries. The RELRO of the requested libraries is shared
+  // if asked for; dependencies are only included on request, in which case
+  // they are appended to the same file in link order.
+  bool relro_include_dependencies = extinfo != nullptr &&
+      (extinfo->flags & ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES) != 0;
+  size_t relro_file_offset = 0;
   soinfo* si;
   while ((si = found_libs.pop_front()) != nullptr) {
     if ((si->flags & FLAG_LINKED) == 0) {
-      if (!si->LinkImage(extinfo)) {
+      if (!si->LinkImage()) {
+        return false;
+      }
+      bool share_relro = relro_include_dependencies;
+      for (size_t i = 0; extinfo != nullptr && !share_relro && i < library_names_size; ++i) {
+        share_relro = (soinfos[i] == si);
+      }
+      if (share_relro && !share_gnu_relro(si, extinfo, &relro_file_offset)) {
         return false;
       }
-      si->flags |= FLAG_LINKED;
+      soinfo_set_linked(si);
     }
   }
 
@@ -1035,6 +1945,25 @@ void do_android_get_LD_LIBRARY_PATH(char* buffer, size_t buffer_size) {
 void do_android_update_LD_LIBRARY_PATH(const char* ld_library_path) {
   if (!get_AT_SECURE()) {
     parse_LD_LIBRARY_PATH(ld_library_path);
+    protect_data(PROT_READ | PROT_WRITE);
+    library_directory_cache_purge();
+    protect_data(PROT_READ);
+  }
+}
+
+// Writes out the statistics of every library that has been initialized since
+// the last call. Libraries whose constructors are deferred are reported once
+// they have run.
+static void write_load_stats() {
+  if (!load_stats_enabled()) {
+    return;
+  }
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    LoadStats& stats = si->get_load_stats();
+    if (si->constructors_called && !stats.reported) {
+      stats.reported = true;
+      load_stats_write(si->name, stats);
+    }
   }
 }
 
@@ -1053,34 +1982,195 @@ soinfo* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo)
       DL_ERR("invalid extended flag combination (ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET without ANDROID_DLEXT_USE_LIBRARY_FD): 0x%" PRIx64, extinfo->flags);
       return nullptr;
     }
+    if ((extinfo->flags & (ANDROID_DLEXT_WRITE_RELRO | ANDROID_DLEXT_USE_RELRO)) == 0 &&
+        (extinfo->flags & ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES) != 0) {
+      DL_ERR("invalid extended flag combination (ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES without ANDROID_DLEXT_WRITE_RELRO or ANDROID_DLEXT_USE_RELRO): 0x%" PRIx64, extinfo->flags);
+      return nullptr;
+    }
   }
   protect_data(PROT_READ | PROT_WRITE);
   soinfo* si = find_library(name, flags, extinfo);
-  if (si != nullptr) {
+  if (si != nullptr &&
+      (extinfo == nullptr || (extinfo->flags & ANDROID_DLEXT_DEFER_CONSTRUCTORS) == 0)) {
     si->CallConstructors();
   }
+  write_load_stats();
   protect_data(PROT_READ);
   return si;
 }
 
+bool do_dlopen_many(const char* const names[], size_t count, int flags, soinfo* soinfos[]) {
+  if ((flags & ~(RTLD_NOW|RTLD_LAZY|RTLD_LOCAL|RTLD_GLOBAL|RTLD_NOLOAD)) != 0) {
+    DL_ERR("invalid flags to dlopen: %x", flags);
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (names[i] == nullptr) {
+      DL_ERR("null library name at index %zd", i);
+      return false;
+    }
+  }
+  if (count == 0) {
+    return true;
+  }
+  protect_data(PROT_READ | PROT_WRITE);
+  bool success = find_libraries(names, count, soinfos, nullptr, 0, flags, nullptr);
+  if (success) {
+    for (size_t i = 0; i < count; ++i) {
+      soinfos[i]->CallConstructors();
+    }
+  }
+  write_load_stats();
+  protect_data(PROT_READ);
+  return success;
+}
+
+// Called with the dlfcn mutex held, so solist can't change under us.
+soinfo* soinfo_from_handle(void* handle) {
+  for (soinfo* si = solist; si != nullptr; si = si->next) {
+    if (si == handle) {
+      return (si->flags & FLAG_LINKED) != 0 ? si : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+void do_dlinit(soinfo* si) {
+  if (si->constructors_called) {
+    return;
+  }
+  protect_data(PROT_READ | PROT_WRITE);
+  si->CallConstructors();
+  write_load_stats();
+  protect_data(PROT_READ);
+}
+
 void do_dlclose(soinfo* si) {
   protect_data(PROT_READ | PROT_WRITE);
   soinfo_unload(si);
+  flush_pending_unmaps();
   protect_data(PROT_READ);
 }
 
 static ElfW(Addr) call_ifunc_resolver(ElfW(Addr) resolver_addr) {
-  typedef ElfW(Addr) (*ifunc_resolver_t)(void);
-  ifunc_resolver_t ifunc_resolver = reinterpret_cast<ifunc_resolver_t>(resolver_addr);
-  ElfW(Addr) ifunc_addr = ifunc_resolver();
-  TRACE_TYPE(RELO, "Called ifunc_resolver@%p. The result is %p", ifunc_resolver, reinterpret_cast<void*>(ifunc_addr));
+  ElfW(Addr) ifunc_addr = __bionic_call_ifunc_resolver(resolver_addr, getauxval(AT_HWCAP));
+  TRACE_TYPE(RELO, "Called ifunc_resolver@%p. The result is %p",
+             reinterpret_cast<void*>(resolver_addr), reinterpret_cast<void*>(ifunc_addr));
 
   return ifunc_addr;
 }
 
+#if defined(__aarch64__)
+#define R_GENERIC_RELATIVE R_AARCH64_RELATIVE
+#elif defined(__x86_64__)
+#define R_GENERIC_RELATIVE R_X86_64_RELATIVE
+#elif defined(__arm__)
+#define R_GENERIC_RELATIVE R_ARM_RELATIVE
+#elif defined(__i386__)
+#define R_GENERIC_RELATIVE R_386_RELATIVE
+#endif
+
+// The static linker sorts RELATIVE relocations to the front of the table and
+// says how many there are with DT_RELACOUNT/DT_RELCOUNT. They need neither a
+// symbol lookup nor the big switch in Relocate(), so apply the run in a tight
+// loop. Returns the number applied, stopping early at anything unexpected so
+// that Relocate() gets to deal with (and report) it.
+#if defined(R_GENERIC_RELATIVE)
+#if defined(USE_RELA)
+static size_t relocate_relative(const ElfW(Rela)* rela, size_t count,
+                                ElfW(Addr) load_bias, ElfW(Addr) base) {
+  size_t idx = 0;
+  for (; idx < count; ++idx, ++rela) {
+    // A RELATIVE relocation has no symbol, so r_info is just the type.
+    if (rela->r_info != R_GENERIC_RELATIVE) {
+      break;
+    }
+    count_relocation(kRelocRelative);
+    MARK(rela->r_offset);
+    *reinterpret_cast<ElfW(Addr)*>(rela->r_offset + load_bias) = base + rela->r_addend;
+  }
+  return idx;
+}
+#else
+static size_t relocate_relative(const ElfW(Rel)* rel, size_t count,
+                                ElfW(Addr) load_bias, ElfW(Addr) base) {
+  size_t idx = 0;
+  for (; idx < count; ++idx, ++rel) {
+    // A RELATIVE relocation has no symbol, so r_info is just the type.
+    if (rel->r_info != R_GENERIC_RELATIVE) {
+      break;
+    }
+    count_relocation(kRelocRelative);
+    MARK(rel->r_offset);
+    *reinterpret_cast<ElfW(Addr)*>(rel->r_offset + load_bias) += base;
+  }
+  return idx;
+}
+#endif
+#else
+template<typename ElfRelT>
+static size_t relocate_relative(const ElfRelT*, size_t, ElfW(Addr), ElfW(Addr)) {
+  return 0;
+}
+#endif
+
+static ElfW(Sym)* relocation_lookup(soinfo* si, RelocationCache* cache, unsigned sym,
+                                    const char* name, soinfo** lsi) {
+  ElfW(Sym)* s;
+  if (cache == nullptr || !cache->find(sym, name, &s, lsi)) {
+    s = soinfo_do_lookup(si, name, lsi);
+    ++si->get_load_stats().symbol_lookup_count;
+  }
+  if (cache != nullptr) {
+    cache->record(sym, s, *lsi);
+  }
+  return s;
+}
+
+#if !defined(__mips__)
+// TLS relocations refer to the module that defines the variable, which is the
+// library being relocated itself when there's no symbol.
+static bool tls_relocation_module(soinfo* si, soinfo* lsi, size_t* module_id) {
+  soinfo* target = (lsi != nullptr) ? lsi : si;
+  *module_id = target->get_tls_module_id();
+  if (*module_id == 0) {
+    DL_ERR("TLS relocation in \"%s\" refers to \"%s\", which has no TLS segment",
+           si->name, target->name);
+    return false;
+  }
+  return true;
+}
+
+// The variable's offset within its module's block.
+static ElfW(Addr) tls_relocation_offset(const ElfW(Sym)* s, soinfo* lsi) {
+  return (lsi != nullptr) ? s->st_value : 0;
+}
+#endif
+
+#if defined(BIONIC_STATIC_TLS)
+// For the initial-exec model: the variable's offset from the thread pointer.
+static bool tls_relocation_static_offset(soinfo* si, soinfo* lsi, const ElfW(Sym)* s,
+                                         intptr_t* offset) {
+  soinfo* target = (lsi != nullptr) ? lsi : si;
+  if (!linker_tls_get_static_offset(target, offset)) {
+    DL_ERR("\"%s\" uses static TLS in \"%s\", which was loaded too late to have any",
+           si->name, target->name);
+    return false;
+  }
+  *offset += tls_relocation_offset(s, lsi);
+  return true;
+}
+#endif
+
 #if defined(USE_RELA)
-int soinfo::Relocate(ElfW(Rela)* rela, unsigned count) {
-  for (size_t idx = 0; idx < count; ++idx, ++rela) {
+template<typename ElfRelIteratorT>
+int soinfo::Relocate(ElfRelIteratorT&& rel_iterator, RelocationCache* cache) {
+  for (size_t idx = 0; rel_iterator.has_next(); ++idx) {
+    const auto rela = rel_iterator.next();
+    if (rela == nullptr) {
+      return -1;
+    }
+
     unsigned type = ELFW(R_TYPE)(rela->r_info);
     unsigned sym = ELFW(R_SYM)(rela->r_info);
     ElfW(Addr) reloc = static_cast<ElfW(Addr)>(rela->r_offset + load_bias);
@@ -1091,13 +2181,14 @@ int soinfo::Relocate(ElfW(Rela)* rela, unsigned count) {
     if (type == 0) { // R_*_NONE
       continue;
     }
+    ++load_stats.relocation_count;
 
     ElfW(Sym)* s = nullptr;
     soinfo* lsi = nullptr;
 
     if (sym != 0) {
       sym_name = get_string(symtab[sym].st_name);
-      s = soinfo_do_lookup(this, sym_name, &lsi);
+      s = relocation_lookup(this, cache, sym, sym_name, &lsi);
       if (s == nullptr) {
         // We only allow an undefined symbol if this is a weak reference...
         s = &symtab[sym];
@@ -1283,14 +2374,51 @@ int soinfo::Relocate(ElfW(Rela)* rela, unsigned count) {
          */
         DL_ERR("%s R_AARCH64_COPY relocations are not supported", name);
         return -1;
-      case R_AARCH64_TLS_TPREL64:
-        TRACE_TYPE(RELO, "RELO TLS_TPREL64 *** %16llx <- %16llx - %16llx\n",
-                   reloc, (sym_addr + rela->r_addend), rela->r_offset);
+      case R_AARCH64_TLS_DTPMOD64:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        {
+          size_t module_id;
+          if (!tls_relocation_module(this, lsi, &module_id)) {
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_DTPMOD64 %16llx <- %zu %s\n", reloc, module_id, sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = module_id;
+        }
+        break;
+      case R_AARCH64_TLS_DTPREL64:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        TRACE_TYPE(RELO, "RELO TLS_DTPREL64 %16llx <- %16llx %s\n",
+                   reloc, (tls_relocation_offset(s, lsi) + rela->r_addend), sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) = tls_relocation_offset(s, lsi) + rela->r_addend;
         break;
-      case R_AARCH64_TLS_DTPREL32:
-        TRACE_TYPE(RELO, "RELO TLS_DTPREL32 *** %16llx <- %16llx - %16llx\n",
-                   reloc, (sym_addr + rela->r_addend), rela->r_offset);
+      case R_AARCH64_TLSDESC:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        {
+          size_t module_id;
+          if (!tls_relocation_module(this, lsi, &module_id)) {
+            return -1;
+          }
+          ElfW(Addr) offset = tls_relocation_offset(s, lsi) + rela->r_addend;
+          if (module_id >> (64 - TLSDESC_MODULE_SHIFT) != 0 ||
+              offset >> TLSDESC_MODULE_SHIFT != 0) {
+            DL_ERR("TLS descriptor in \"%s\" is out of range", name);
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO TLSDESC %16llx <- %zu:%16llx %s\n",
+                     reloc, module_id, offset, sym_name);
+          ElfW(Addr)* desc = reinterpret_cast<ElfW(Addr)*>(reloc);
+          desc[0] = reinterpret_cast<ElfW(Addr)>(tlsdesc_resolver_dynamic);
+          desc[1] = (static_cast<ElfW(Addr)>(module_id) << TLSDESC_MODULE_SHIFT) | offset;
+        }
         break;
+      case R_AARCH64_TLS_TPREL64:
+        // The thread pointer points at bionic's TLS slots, which leave no
+        // room for a static TLS area.
+        DL_ERR("\"%s\" uses static TLS, which isn't supported on this architecture", name);
+        return -1;
 #elif defined(__x86_64__)
       case R_X86_64_JUMP_SLOT:
         count_relocation(kRelocAbsolute);
@@ -1323,6 +2451,39 @@ int soinfo::Relocate(ElfW(Rela)* rela, unsigned count) {
         TRACE_TYPE(RELO, "RELO IRELATIVE %16llx <- %16llx\n", reloc, (base + rela->r_addend));
         *reinterpret_cast<ElfW(Addr)*>(reloc) = call_ifunc_resolver(base + rela->r_addend);
         break;
+      case R_X86_64_DTPMOD64:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        {
+          size_t module_id;
+          if (!tls_relocation_module(this, lsi, &module_id)) {
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO DTPMOD64 %08zx <- %zu %s", static_cast<size_t>(reloc),
+                     module_id, sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = module_id;
+        }
+        break;
+      case R_X86_64_DTPOFF64:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        TRACE_TYPE(RELO, "RELO DTPOFF64 %08zx <- %08zx %s", static_cast<size_t>(reloc),
+                   static_cast<size_t>(tls_relocation_offset(s, lsi) + rela->r_addend), sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) = tls_relocation_offset(s, lsi) + rela->r_addend;
+        break;
+      case R_X86_64_TPOFF64:
+        count_relocation(kRelocAbsolute);
+        MARK(rela->r_offset);
+        {
+          intptr_t offset;
+          if (!tls_relocation_static_offset(this, lsi, s, &offset)) {
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO TPOFF64 %08zx <- %08zx %s", static_cast<size_t>(reloc),
+                     static_cast<size_t>(offset + rela->r_addend), sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = offset + rela->r_addend;
+        }
+        break;
       case R_X86_64_32:
         count_relocation(kRelocRelative);
         MARK(rela->r_offset);
@@ -1356,8 +2517,14 @@ int soinfo::Relocate(ElfW(Rela)* rela, unsigned count) {
 }
 
 #else // REL, not RELA.
-int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
-  for (size_t idx = 0; idx < count; ++idx, ++rel) {
+template<typename ElfRelIteratorT>
+int soinfo::Relocate(ElfRelIteratorT&& rel_iterator, RelocationCache* cache) {
+  for (size_t idx = 0; rel_iterator.has_next(); ++idx) {
+    const auto rel = rel_iterator.next();
+    if (rel == nullptr) {
+      return -1;
+    }
+
     unsigned type = ELFW(R_TYPE)(rel->r_info);
     // TODO: don't use unsigned for 'sym'. Use uint32_t or ElfW(Addr) instead.
     unsigned sym = ELFW(R_SYM)(rel->r_info);
@@ -1369,13 +2536,14 @@ int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
     if (type == 0) { // R_*_NONE
       continue;
     }
+    ++load_stats.relocation_count;
 
     ElfW(Sym)* s = nullptr;
     soinfo* lsi = nullptr;
 
     if (sym != 0) {
       sym_name = get_string(symtab[sym].st_name);
-      s = soinfo_do_lookup(this, sym_name, &lsi);
+      s = relocation_lookup(this, cache, sym, sym_name, &lsi);
       if (s == nullptr) {
         // We only allow an undefined symbol if this is a weak reference...
         s = &symtab[sym];
@@ -1403,6 +2571,7 @@ int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
           case R_ARM_GLOB_DAT:
           case R_ARM_ABS32:
           case R_ARM_RELATIVE:    /* Don't care. */
+          case R_ARM_IRELATIVE:
             // sym_addr was initialized to be zero above or relocation
             // code below does not care about value of sym_addr.
             // No need to do anything.
@@ -1476,6 +2645,30 @@ int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
          */
         DL_ERR("%s R_ARM_COPY relocations are not supported", name);
         return -1;
+      case R_ARM_TLS_DTPMOD32:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          size_t module_id;
+          if (!tls_relocation_module(this, lsi, &module_id)) {
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_DTPMOD32 %08x <- %zu %s", reloc, module_id, sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = module_id;
+        }
+        break;
+      case R_ARM_TLS_DTPOFF32:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        TRACE_TYPE(RELO, "RELO TLS_DTPOFF32 %08x <- +%08x %s",
+                   reloc, tls_relocation_offset(s, lsi), sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) += tls_relocation_offset(s, lsi);
+        break;
+      case R_ARM_TLS_TPOFF32:
+        // The thread pointer points at bionic's TLS slots, which leave no
+        // room for a static TLS area.
+        DL_ERR("\"%s\" uses static TLS, which isn't supported on this architecture", name);
+        return -1;
 #elif defined(__i386__)
       case R_386_JMP_SLOT:
         count_relocation(kRelocAbsolute);
@@ -1502,6 +2695,42 @@ int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
                    reloc, (sym_addr - reloc), sym_addr, reloc, sym_name);
         *reinterpret_cast<ElfW(Addr)*>(reloc) += (sym_addr - reloc);
         break;
+      case R_386_TLS_DTPMOD32:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          size_t module_id;
+          if (!tls_relocation_module(this, lsi, &module_id)) {
+            return -1;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_DTPMOD32 %08x <- %zu %s", reloc, module_id, sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = module_id;
+        }
+        break;
+      case R_386_TLS_DTPOFF32:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        TRACE_TYPE(RELO, "RELO TLS_DTPOFF32 %08x <- +%08x %s",
+                   reloc, tls_relocation_offset(s, lsi), sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) += tls_relocation_offset(s, lsi);
+        break;
+      case R_386_TLS_TPOFF:
+      case R_386_TLS_TPOFF32:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          intptr_t offset;
+          if (!tls_relocation_static_offset(this, lsi, s, &offset)) {
+            return -1;
+          }
+          // TPOFF32 wants the negated offset, for code that subtracts it.
+          if (type == R_386_TLS_TPOFF32) {
+            offset = -offset;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_TPOFF %08x <- +%08x %s", reloc, offset, sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) += offset;
+        }
+        break;
 #elif defined(__mips__)
       case R_MIPS_REL32:
 #if defined(__LP64__)
@@ -1542,14 +2771,16 @@ int soinfo::Relocate(ElfW(Rel)* rel, unsigned count) {
                    reinterpret_cast<void*>(reloc), reinterpret_cast<void*>(base));
         *reinterpret_cast<ElfW(Addr)*>(reloc) += base;
         break;
-#if defined(__i386__)
+#if defined(__arm__)
+      case R_ARM_IRELATIVE:
+#elif defined(__i386__)
       case R_386_IRELATIVE:
+#endif
         count_relocation(kRelocRelative);
         MARK(rel->r_offset);
         TRACE_TYPE(RELO, "RELO IRELATIVE %p <- %p", reinterpret_cast<void*>(reloc), reinterpret_cast<void*>(base));
         *reinterpret_cast<ElfW(Addr)*>(reloc) = call_ifunc_resolver(base + *reinterpret_cast<ElfW(Addr)*>(reloc));
         break;
-#endif
 
       default:
         DL_ERR("unknown reloc type %d @ %p (%zu)", type, rel, idx);
@@ -1682,6 +2913,7 @@ void soinfo::CallConstructors() {
 
   TRACE("\"%s\": calling constructors", name);
 
+  LoadStatsTimer timer(&get_load_stats().constructors_ns);
   // DT_INIT should be called before DT_INIT_ARRAY if both are present.
   CallFunction("DT_INIT", init_func);
   CallArray("DT_INIT_ARRAY", init_array, init_array_count, false);
@@ -1758,6 +2990,47 @@ off64_t soinfo::get_file_offset() {
   return 0;
 }
 
+time_t soinfo::get_file_mtime() {
+  if (has_min_version(2)) {
+    return file_mtime;
+  }
+
+  return 0;
+}
+
+LoadStats& soinfo::get_load_stats() {
+  if (has_min_version(2)) {
+    return load_stats;
+  }
+
+  static LoadStats g_ignored_load_stats;
+  return g_ignored_load_stats;
+}
+
+size_t soinfo::get_tls_module_id() {
+  if (has_min_version(2)) {
+    return tls_module_id;
+  }
+
+  return 0;
+}
+
+void soinfo::set_tls_module_id(size_t module_id) {
+  tls_module_id = module_id;
+}
+
+uint32_t soinfo::get_symbol_filter_epoch() {
+  if (has_min_version(2)) {
+    return symbol_filter_epoch;
+  }
+
+  return 0;
+}
+
+void soinfo::set_symbol_filter_epoch(uint32_t epoch) {
+  symbol_filter_epoch = epoch;
+}
+
 // This is a return on get_children()/get_parents() if
 // 'this->flags' does not have FLAG_NEW_SOINFO set.
 static soinfo::soinfo_list_t g_empty_list;
@@ -1901,6 +3174,26 @@ bool soinfo::PrelinkImage() {
         chain = reinterpret_cast<uint32_t*>(load_bias + d->d_un.d_ptr + 8 + nbucket * 4);
         break;
 
+      case DT_GNU_HASH:
+        gnu_nbucket = reinterpret_cast<uint32_t*>(load_bias + d->d_un.d_ptr)[0];
+        // skip symndx
+        gnu_maskwords = reinterpret_cast<uint32_t*>(load_bias + d->d_un.d_ptr)[2];
+        gnu_shift2 = reinterpret_cast<uint32_t*>(load_bias + d->d_un.d_ptr)[3];
+
+        gnu_bloom_filter = reinterpret_cast<ElfW(Addr)*>(load_bias + d->d_un.d_ptr + 16);
+        gnu_bucket = reinterpret_cast<uint32_t*>(gnu_bloom_filter + gnu_maskwords);
+        // amend chain for symndx = header[1]
+        gnu_chain = gnu_bucket + gnu_nbucket - reinterpret_cast<uint32_t*>(load_bias + d->d_un.d_ptr)[1];
+
+        if (!powerof2(gnu_maskwords)) {
+          DL_ERR("invalid maskwords for gnu_hash = 0x%x, in \"%s\" expecting power of two", gnu_maskwords, name);
+          return false;
+        }
+        --gnu_maskwords;
+
+        flags |= FLAG_GNU_HASH;
+        break;
+
       case DT_STRTAB:
         strtab = reinterpret_cast<const char*>(load_bias + d->d_un.d_ptr);
         break;
@@ -1987,10 +3280,27 @@ bool soinfo::PrelinkImage() {
         }
         break;
 
-      // ignored (see DT_RELCOUNT comments for details)
+      // See DT_RELCOUNT comments for details.
       case DT_RELACOUNT:
+        relative_reloc_count = d->d_un.d_val;
+        break;
+
+      case DT_ANDROID_RELA:
+        android_relocs = reinterpret_cast<uint8_t*>(load_bias + d->d_un.d_ptr);
+        break;
+
+      case DT_ANDROID_RELASZ:
+        android_relocs_size = d->d_un.d_val;
         break;
 
+      case DT_ANDROID_REL:
+        DL_ERR("unsupported DT_ANDROID_REL in \"%s\"", name);
+        return false;
+
+      case DT_ANDROID_RELSZ:
+        DL_ERR("unsupported DT_ANDROID_RELSZ in \"%s\"", name);
+        return false;
+
       case DT_REL:
         DL_ERR("unsupported DT_REL in \"%s\"", name);
         return false;
@@ -2017,10 +3327,27 @@ bool soinfo::PrelinkImage() {
       // "Indicates that all RELATIVE relocations have been concatenated together,
       // and specifies the RELATIVE relocation count."
       //
-      // TODO: Spec also mentions that this can be used to optimize relocation process;
-      // Not currently used by bionic linker - ignored.
+      // These are applied up front by relocate_relative().
       case DT_RELCOUNT:
+        relative_reloc_count = d->d_un.d_val;
+        break;
+
+      case DT_ANDROID_REL:
+        android_relocs = reinterpret_cast<uint8_t*>(load_bias + d->d_un.d_ptr);
+        break;
+
+      case DT_ANDROID_RELSZ:
+        android_relocs_size = d->d_un.d_val;
         break;
+
+      case DT_ANDROID_RELA:
+        DL_ERR("unsupported DT_ANDROID_RELA in \"%s\"", name);
+        return false;
+
+      case DT_ANDROID_RELASZ:
+        DL_ERR("unsupported DT_ANDROID_RELASZ in \"%s\"", name);
+        return false;
+
       case DT_RELA:
         DL_ERR("unsupported DT_RELA in \"%s\"", name);
         return false;
@@ -2157,8 +3484,8 @@ bool soinfo::PrelinkImage() {
     DL_ERR("linker cannot have DT_NEEDED dependencies on other libraries");
     return false;
   }
-  if (nbucket == 0) {
-    DL_ERR("empty/missing DT_HASH in \"%s\" (built with --hash-style=gnu?)", name);
+  if (nbucket == 0 && gnu_nbucket == 0) {
+    DL_ERR("empty/missing DT_HASH/DT_GNU_HASH in \"%s\" (new hash type from the future?)", name);
     return false;
   }
   if (strtab == 0) {
@@ -2172,7 +3499,8 @@ bool soinfo::PrelinkImage() {
   return true;
 }
 
-bool soinfo::LinkImage(const android_dlextinfo* extinfo) {
+bool soinfo::LinkImage() {
+  LoadStatsTimer timer(&load_stats.link_ns);
 
 #if !defined(__LP64__)
   if (has_text_relocations) {
@@ -2188,29 +3516,78 @@ bool soinfo::LinkImage(const android_dlextinfo* extinfo) {
   }
 #endif
 
+  // Everything soinfo_do_lookup may search, for the relocation cache.
+  size_t children_count = 0;
+  get_children().for_each([&](soinfo*) { ++children_count; });
+  soinfo* lookup_scope[2 + LDPRELOAD_MAX + children_count];
+  size_t lookup_scope_size = 0;
+  if (somain != nullptr) {
+    lookup_scope[lookup_scope_size++] = somain;
+  }
+  for (size_t i = 0; g_ld_preloads[i] != nullptr; ++i) {
+    lookup_scope[lookup_scope_size++] = g_ld_preloads[i];
+  }
+  lookup_scope[lookup_scope_size++] = this;
+  get_children().for_each([&](soinfo* child) {
+    lookup_scope[lookup_scope_size++] = child;
+  });
+  RelocationCache relocation_cache(this, lookup_scope, lookup_scope_size);
+
+  if (android_relocs != nullptr) {
+    // check signature
+    if (android_relocs_size > 3 &&
+        android_relocs[0] == 'A' &&
+        android_relocs[1] == 'P' &&
+        android_relocs[2] == 'S' &&
+        android_relocs[3] == '2') {
+      DEBUG("[ android relocating %s ]", name);
+
+      const uint8_t* packed_relocs = android_relocs + 4;
+      const size_t packed_relocs_size = android_relocs_size - 4;
+
+      if (Relocate(packed_reloc_iterator<sleb128_decoder>(
+            sleb128_decoder(packed_relocs, packed_relocs_size)), &relocation_cache)) {
+        return false;
+      }
+    } else {
+      DL_ERR("bad android relocation header in \"%s\"", name);
+      return false;
+    }
+  }
+
 #if defined(USE_RELA)
   if (rela != nullptr) {
     DEBUG("[ relocating %s ]", name);
-    if (Relocate(rela, rela_count)) {
+    size_t relative_count = relocate_relative(rela, MIN(relative_reloc_count, rela_count),
+                                              load_bias, base);
+    DEBUG("[ applied %zd of %zd relocations as RELATIVE ]", relative_count, rela_count);
+    load_stats.relocation_count += relative_count;
+    if (Relocate(plain_reloc_iterator(rela + relative_count, rela_count - relative_count),
+                 &relocation_cache)) {
       return false;
     }
   }
   if (plt_rela != nullptr) {
     DEBUG("[ relocating %s plt ]", name);
-    if (Relocate(plt_rela, plt_rela_count)) {
+    if (Relocate(plain_reloc_iterator(plt_rela, plt_rela_count), &relocation_cache)) {
       return false;
     }
   }
 #else
   if (rel != nullptr) {
     DEBUG("[ relocating %s ]", name);
-    if (Relocate(rel, rel_count)) {
+    size_t relative_count = relocate_relative(rel, MIN(relative_reloc_count, rel_count),
+                                              load_bias, base);
+    DEBUG("[ applied %zd of %zd relocations as RELATIVE ]", relative_count, rel_count);
+    load_stats.relocation_count += relative_count;
+    if (Relocate(plain_reloc_iterator(rel + relative_count, rel_count - relative_count),
+                 &relocation_cache)) {
       return false;
     }
   }
   if (plt_rel != nullptr) {
     DEBUG("[ relocating %s plt ]", name);
-    if (Relocate(plt_rel, plt_rel_count)) {
+    if (Relocate(plain_reloc_iterator(plt_rel, plt_rel_count), &relocation_cache)) {
       return false;
     }
   }
@@ -2222,6 +3599,8 @@ bool soinfo::LinkImage(const android_dlextinfo* extinfo) {
   }
 #endif
 
+  relocation_cache.finish();
+
   DEBUG("[ finished linking %s ]", name);
 
 #if !defined(__LP64__)
@@ -2242,23 +3621,6 @@ bool soinfo::LinkImage(const android_dlextinfo* extinfo) {
     return false;
   }
 
-  /* Handle serializing/sharing the RELRO segment */
-  if (extinfo && (extinfo->flags & ANDROID_DLEXT_WRITE_RELRO)) {
-    if (phdr_table_serialize_gnu_relro(phdr, phnum, load_bias,
-                                       extinfo->relro_fd) < 0) {
-      DL_ERR("failed serializing GNU RELRO section for \"%s\": %s",
-             name, strerror(errno));
-      return false;
-    }
-  } else if (extinfo && (extinfo->flags & ANDROID_DLEXT_USE_RELRO)) {
-    if (phdr_table_map_gnu_relro(phdr, phnum, load_bias,
-                                 extinfo->relro_fd) < 0) {
-      DL_ERR("failed mapping GNU RELRO section for \"%s\": %s",
-             name, strerror(errno));
-      return false;
-    }
-  }
-
   notify_gdb_of_load(this);
   return true;
 }
@@ -2284,7 +3646,8 @@ static void add_vdso(KernelArgumentBlock& args __unused) {
   si->load_bias = get_elf_exec_load_bias(ehdr_vdso);
 
   si->PrelinkImage();
-  si->LinkImage(nullptr);
+  si->LinkImage();
+  soinfo_set_linked(si);
 #endif
 }
 
@@ -2353,9 +3716,21 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
   // doesn't cost us anything.
   const char* ldpath_env = nullptr;
   const char* ldpreload_env = nullptr;
+  const char* ld_prefetch_manifest_env = nullptr;
   if (!get_AT_SECURE()) {
     ldpath_env = linker_env_get("LD_LIBRARY_PATH");
     ldpreload_env = linker_env_get("LD_PRELOAD");
+    relocation_cache_init(linker_env_get("LD_RELOCATION_CACHE"));
+    load_stats_init(linker_env_get("LD_LOAD_STATS"));
+    ld_prefetch_manifest_env = linker_env_get("LD_PREFETCH_MANIFEST");
+  }
+  const char* ld_library_directory_cache_env = linker_env_get("LD_LIBRARY_DIRECTORY_CACHE");
+  if (ld_library_directory_cache_env != nullptr) {
+    g_library_directory_cache_enabled = atoi(ld_library_directory_cache_env) != 0;
+  }
+  const char* ld_hugepage_text_env = linker_env_get("LD_HUGEPAGE_TEXT");
+  if (ld_hugepage_text_env != nullptr) {
+    phdr_set_huge_page_text_mode(atoi(ld_hugepage_text_env));
   }
 
   INFO("[ android linker & debugger ]");
@@ -2410,10 +3785,15 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
   // Use LD_LIBRARY_PATH and LD_PRELOAD (but only if we aren't setuid/setgid).
   parse_LD_LIBRARY_PATH(ldpath_env);
   parse_LD_PRELOAD(ldpreload_env);
+  if (ld_prefetch_manifest_env != nullptr) {
+    prefetch_manifest(ld_prefetch_manifest_env);
+  }
 
   somain = si;
 
-  if (!si->PrelinkImage()) {
+  // The executable registers first so that its TLS block is the one nearest
+  // the thread pointer, where its local-exec code expects it.
+  if (!si->PrelinkImage() || !linker_tls_register(si)) {
     __libc_format_fd(2, "CANNOT LINK EXECUTABLE: %s\n", linker_get_error_buffer());
     exit(EXIT_FAILURE);
   }
@@ -2438,6 +3818,7 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
   memset(needed_library_names, 0, sizeof(needed_library_names));
   needed_library_name_list.copy_to_array(needed_library_names, needed_libraries_count);
 
+  __libc_startup_trace_mark(ANDROID_STARTUP_LINKER_LOAD);
   if (needed_libraries_count > 0 && !find_libraries(needed_library_names, needed_libraries_count, needed_library_si, g_ld_preloads, ld_preloads_count, 0, nullptr)) {
     __libc_format_fd(2, "CANNOT LINK EXECUTABLE DEPENDENCIES: %s\n", linker_get_error_buffer());
     exit(EXIT_FAILURE);
@@ -2447,7 +3828,14 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
     si->add_child(needed_library_si[i]);
   }
 
-  if (!si->LinkImage(nullptr)) {
+  __libc_startup_trace_mark(ANDROID_STARTUP_LINKER_LINK);
+  if (!si->LinkImage()) {
+    __libc_format_fd(2, "CANNOT LINK EXECUTABLE: %s\n", linker_get_error_buffer());
+    exit(EXIT_FAILURE);
+  }
+  soinfo_set_linked(si);
+
+  if (!linker_tls_finish_startup()) {
     __libc_format_fd(2, "CANNOT LINK EXECUTABLE: %s\n", linker_get_error_buffer());
     exit(EXIT_FAILURE);
   }
@@ -2462,7 +3850,9 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
    * for some arch like x86 could work correctly within so exe.
    */
   map->l_addr = si->load_bias;
+  phdr_snapshot_invalidate();
   si->CallConstructors();
+  write_load_stats();
 
 #if TIMING
   gettimeofday(&t1, nullptr);
@@ -2571,7 +3961,7 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
   linker_so.phnum = elf_hdr->e_phnum;
   linker_so.flags |= FLAG_LINKER;
 
-  if (!(linker_so.PrelinkImage() && linker_so.LinkImage(nullptr))) {
+  if (!(linker_so.PrelinkImage() && linker_so.LinkImage())) {
     // It would be nice to print an error message, but if the linker
     // can't link itself, there's no guarantee that we'll be able to
     // call write() (because it involves a GOT reference). We may as
@@ -2584,6 +3974,8 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
   }
 
   __libc_init_tls(args);
+  __libc_startup_trace_init(args);
+  __libc_startup_trace_mark(ANDROID_STARTUP_LINKER_START);
 
   // Initialize the linker's own global variables
   linker_so.CallConstructors();
@@ -2593,10 +3985,13 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
   // before get_libdl_info().
   solist = get_libdl_info();
   sonext = get_libdl_info();
+  soinfo_index_add(solist);
 
   // We have successfully fixed our own relocations. It's safe to run
   // the main part of the linker now.
   args.abort_message_ptr = &g_abort_message;
+  args.startup_trace = &__libc_startup_trace;
+  linker_tls_init(args);
   ElfW(Addr) start_address = __linker_init_post_relocation(args, linker_addr);
 
   protect_data(PROT_READ);
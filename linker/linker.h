@@ -32,12 +32,14 @@
 #include <elf.h>
 #include <inttypes.h>
 #include <link.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <android/dlext.h>
 #include <sys/stat.h>
 
 #include "private/libc_logging.h"
 #include "linked_list.h"
+#include "linker_load_stats.h"
 
 #define DL_ERR(fmt, x...) \
     do { \
@@ -87,9 +89,10 @@
 #define FLAG_LINKED     0x00000001
 #define FLAG_EXE        0x00000004 // The main executable
 #define FLAG_LINKER     0x00000010 // The linker itself
+#define FLAG_GNU_HASH   0x00000040 // uses gnu hash
 #define FLAG_NEW_SOINFO 0x40000000 // new soinfo format
 
-#define SOINFO_VERSION 0
+#define SOINFO_VERSION 2
 
 #define SOINFO_NAME_LEN 128
 
@@ -101,6 +104,7 @@ typedef void (*linker_function_t)();
 #endif
 
 struct soinfo;
+class RelocationCache;
 
 class SoinfoListAllocator {
 public:
@@ -111,6 +115,29 @@ private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(SoinfoListAllocator);
 };
 
+class SymbolName {
+ public:
+  explicit SymbolName(const char* name)
+      : name_(name), has_elf_hash_(false), has_gnu_hash_(false),
+        elf_hash_(0), gnu_hash_(0) { }
+
+  const char* get_name() {
+    return name_;
+  }
+
+  uint32_t elf_hash();
+  uint32_t gnu_hash();
+
+ private:
+  const char* name_;
+  bool has_elf_hash_;
+  bool has_gnu_hash_;
+  uint32_t elf_hash_;
+  uint32_t gnu_hash_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(SymbolName);
+};
+
 struct soinfo {
  public:
   typedef LinkedList<soinfo, SoinfoListAllocator> soinfo_list_t;
@@ -207,7 +234,7 @@ struct soinfo {
   void CallDestructors();
   void CallPreInitConstructors();
   bool PrelinkImage();
-  bool LinkImage(const android_dlextinfo* extinfo);
+  bool LinkImage();
 
   void add_child(soinfo* child);
   void remove_all_links();
@@ -215,6 +242,12 @@ struct soinfo {
   ino_t get_st_ino();
   dev_t get_st_dev();
   off64_t get_file_offset();
+  time_t get_file_mtime();
+  LoadStats& get_load_stats();
+  size_t get_tls_module_id();
+  void set_tls_module_id(size_t module_id);
+  uint32_t get_symbol_filter_epoch();
+  void set_symbol_filter_epoch(uint32_t epoch);
 
   soinfo_list_t& get_children();
   soinfo_list_t& get_parents();
@@ -223,17 +256,25 @@ struct soinfo {
 
   const char* get_string(ElfW(Word) index) const;
 
+  ElfW(Sym)* find_symbol_by_name(SymbolName& symbol_name);
+  ElfW(Sym)* find_symbol_by_address(const void* addr);
+
+  bool is_gnu_hash() const;
+  size_t get_symbol_count();
+
   bool inline has_min_version(uint32_t min_version) const {
     return (flags & FLAG_NEW_SOINFO) != 0 && version >= min_version;
   }
  private:
   void CallArray(const char* array_name, linker_function_t* functions, size_t count, bool reverse);
   void CallFunction(const char* function_name, linker_function_t function);
-#if defined(USE_RELA)
-  int Relocate(ElfW(Rela)* rela, unsigned count);
-#else
-  int Relocate(ElfW(Rel)* rel, unsigned count);
-#endif
+
+  ElfW(Sym)* elf_lookup(SymbolName& symbol_name);
+  ElfW(Sym)* elf_addr_lookup(const void* addr);
+  ElfW(Sym)* gnu_lookup(SymbolName& symbol_name);
+  ElfW(Sym)* gnu_addr_lookup(const void* addr);
+  template<typename ElfRelIteratorT>
+  int Relocate(ElfRelIteratorT&& rel_iterator, RelocationCache* cache);
 
  private:
   // This part of the structure is only available
@@ -253,6 +294,31 @@ struct soinfo {
   int rtld_flags;
   size_t strtab_size;
 
+  // version >= 2
+  size_t gnu_nbucket;
+  uint32_t* gnu_bucket;
+  uint32_t* gnu_chain;
+  uint32_t gnu_maskwords;
+  uint32_t gnu_shift2;
+  ElfW(Addr)* gnu_bloom_filter;
+
+  uint8_t* android_relocs;
+  size_t android_relocs_size;
+
+  // DT_RELACOUNT/DT_RELCOUNT: the number of RELATIVE relocations at the start of rela/rel.
+  size_t relative_reloc_count;
+
+  time_t file_mtime;
+
+  LoadStats load_stats;
+
+  // The ELF TLS module id (see linker_tls.h), or 0 without a TLS segment.
+  size_t tls_module_id;
+
+  // Which build of the default scope symbol filter this library's symbols
+  // were added to (see dlsym_linear_lookup()).
+  uint32_t symbol_filter_epoch;
+
   friend soinfo* get_libdl_info();
 };
 
@@ -261,14 +327,25 @@ extern soinfo* get_libdl_info();
 void do_android_get_LD_LIBRARY_PATH(char*, size_t);
 void do_android_update_LD_LIBRARY_PATH(const char* ld_library_path);
 soinfo* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo);
+// Loads all of the libraries in one pass, or none of them.
+bool do_dlopen_many(const char* const names[], size_t count, int flags, soinfo* soinfos[]);
 void do_dlclose(soinfo* si);
+// Runs the constructors of a library loaded with ANDROID_DLEXT_DEFER_CONSTRUCTORS.
+void do_dlinit(soinfo* si);
+// Returns the library a dlopen(3) handle refers to, or null if it isn't loaded.
+soinfo* soinfo_from_handle(void* handle);
 
 ElfW(Sym)* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start);
 soinfo* find_containing_library(const void* addr);
 
-ElfW(Sym)* dladdr_find_symbol(soinfo* si, const void* addr);
 ElfW(Sym)* dlsym_handle_lookup(soinfo* si, soinfo** found, const char* name);
 
+// Guards solist and the soinfo fields that lookups read. dlsym(3), dladdr(3)
+// and dl_iterate_phdr(3) take it for reading, and only ever see libraries
+// with FLAG_LINKED set; the loader takes it for writing just long enough to
+// publish or retire a library, never while doing I/O or running constructors.
+extern pthread_rwlock_t g_soinfo_list_lock;
+
 void debuggerd_init();
 extern "C" abort_msg_t* g_abort_message;
 extern "C" void notify_gdb_of_libraries();
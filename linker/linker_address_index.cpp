@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "linker_address_index.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "linker.h"
+#include "linker_debug.h"
+
+#include "private/ScopedPthreadMutexLocker.h"
+#include "private/bionic_prctl.h"
+
+struct SymbolAddress {
+  ElfW(Addr) start;
+  ElfW(Addr) end;
+  // The largest 'end' of this and every preceding entry, so that a search
+  // can stop going back once no earlier symbol can contain the address.
+  ElfW(Addr) max_end;
+  size_t index;
+};
+
+struct LibraryAddress {
+  ElfW(Addr) base;
+  size_t size;
+  soinfo* si;
+  // Built on first use, under g_symbol_index_mutex: readers only hold the
+  // soinfo list lock for reading. Published with release semantics.
+  SymbolAddress* symbols;
+  size_t symbol_count;
+  size_t symbols_map_size;
+};
+
+static LibraryAddress* g_libraries;
+static size_t g_library_count;
+static size_t g_library_capacity;
+
+static pthread_mutex_t g_symbol_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Stands in for the symbol array of a library without any sized symbols.
+static SymbolAddress g_no_symbols[1];
+
+static void* map_pages(size_t size) {
+  void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return nullptr;
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, size, "linker_address_index");
+  return map;
+}
+
+static size_t page_round_up(size_t size) {
+  return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+}
+
+// Returns the index of the first library with a base above addr.
+static size_t library_upper_bound(ElfW(Addr) addr) {
+  size_t lo = 0;
+  size_t hi = g_library_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (g_libraries[mid].base <= addr) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void address_index_add(soinfo* si) {
+  if (si->size == 0) {
+    return;
+  }
+  if (g_library_count == g_library_capacity) {
+    size_t new_capacity = g_library_capacity == 0 ? PAGE_SIZE / sizeof(LibraryAddress)
+                                                  : g_library_capacity * 2;
+    LibraryAddress* libraries =
+        reinterpret_cast<LibraryAddress*>(map_pages(new_capacity * sizeof(LibraryAddress)));
+    if (libraries == nullptr) {
+      abort(); // oom
+    }
+    if (g_libraries != nullptr) {
+      memcpy(libraries, g_libraries, g_library_count * sizeof(LibraryAddress));
+      munmap(g_libraries, g_library_capacity * sizeof(LibraryAddress));
+    }
+    g_libraries = libraries;
+    g_library_capacity = new_capacity;
+  }
+
+  size_t i = library_upper_bound(si->base);
+  memmove(&g_libraries[i + 1], &g_libraries[i], (g_library_count - i) * sizeof(LibraryAddress));
+  LibraryAddress& library = g_libraries[i];
+  library.base = si->base;
+  library.size = si->size;
+  library.si = si;
+  library.symbols = nullptr;
+  library.symbol_count = 0;
+  library.symbols_map_size = 0;
+  ++g_library_count;
+}
+
+void address_index_remove(soinfo* si) {
+  for (size_t i = 0; i < g_library_count; ++i) {
+    if (g_libraries[i].si == si) {
+      if (g_libraries[i].symbols_map_size != 0) {
+        munmap(g_libraries[i].symbols, g_libraries[i].symbols_map_size);
+      }
+      memmove(&g_libraries[i], &g_libraries[i + 1],
+              (g_library_count - i - 1) * sizeof(LibraryAddress));
+      --g_library_count;
+      return;
+    }
+  }
+}
+
+static LibraryAddress* find_library(const void* p) {
+  ElfW(Addr) addr = reinterpret_cast<ElfW(Addr)>(p);
+  size_t i = library_upper_bound(addr);
+  if (i == 0) {
+    return nullptr;
+  }
+  LibraryAddress* library = &g_libraries[i - 1];
+  return (addr - library->base < library->size) ? library : nullptr;
+}
+
+soinfo* address_index_find_library(const void* addr) {
+  LibraryAddress* library = find_library(addr);
+  return library != nullptr ? library->si : nullptr;
+}
+
+static int compare_symbol_addresses(const void* lhs, const void* rhs) {
+  const SymbolAddress* a = reinterpret_cast<const SymbolAddress*>(lhs);
+  const SymbolAddress* b = reinterpret_cast<const SymbolAddress*>(rhs);
+  if (a->start != b->start) {
+    return a->start < b->start ? -1 : 1;
+  }
+  // Among symbols at the same address, the search (which goes backwards)
+  // should meet the first one in the symbol table first.
+  return a->index > b->index ? -1 : (a->index < b->index ? 1 : 0);
+}
+
+static void build_symbols(LibraryAddress* library) {
+  soinfo* si = library->si;
+  size_t symbol_count = si->get_symbol_count();
+
+  size_t count = 0;
+  for (size_t i = 0; i < symbol_count; ++i) {
+    const ElfW(Sym)* sym = &si->symtab[i];
+    if (sym->st_shndx != SHN_UNDEF && sym->st_size != 0) {
+      ++count;
+    }
+  }
+
+  SymbolAddress* symbols = g_no_symbols;
+  size_t map_size = 0;
+  if (count != 0) {
+    map_size = page_round_up(count * sizeof(SymbolAddress));
+    symbols = reinterpret_cast<SymbolAddress*>(map_pages(map_size));
+    if (symbols == nullptr) {
+      return;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < symbol_count; ++i) {
+      const ElfW(Sym)* sym = &si->symtab[i];
+      if (sym->st_shndx != SHN_UNDEF && sym->st_size != 0) {
+        symbols[n].start = sym->st_value;
+        symbols[n].end = sym->st_value + sym->st_size;
+        symbols[n].index = i;
+        ++n;
+      }
+    }
+    qsort(symbols, count, sizeof(SymbolAddress), compare_symbol_addresses);
+    ElfW(Addr) max_end = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (symbols[i].end > max_end) {
+        max_end = symbols[i].end;
+      }
+      symbols[i].max_end = max_end;
+    }
+  }
+
+  library->symbol_count = count;
+  library->symbols_map_size = map_size;
+  __atomic_store_n(&library->symbols, symbols, __ATOMIC_RELEASE);
+}
+
+ElfW(Sym)* address_index_find_symbol(const void* addr, soinfo** si) {
+  LibraryAddress* library = find_library(addr);
+  *si = library != nullptr ? library->si : nullptr;
+  if (library == nullptr) {
+    return nullptr;
+  }
+
+  SymbolAddress* symbols = __atomic_load_n(&library->symbols, __ATOMIC_ACQUIRE);
+  if (symbols == nullptr) {
+    ScopedPthreadMutexLocker locker(&g_symbol_index_mutex);
+    if (library->symbols == nullptr) {
+      build_symbols(library);
+    }
+    symbols = library->symbols;
+    if (symbols == nullptr) {
+      // Out of memory: do it the slow way.
+      return library->si->find_symbol_by_address(addr);
+    }
+  }
+
+  // Find the last symbol starting at or before addr, then walk back over
+  // the ones that might still contain it.
+  ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - library->base;
+  size_t lo = 0;
+  size_t hi = library->symbol_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (symbols[mid].start <= soaddr) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  for (size_t i = lo; i > 0 && symbols[i - 1].max_end > soaddr; --i) {
+    if (soaddr < symbols[i - 1].end) {
+      return &library->si->symtab[symbols[i - 1].index];
+    }
+  }
+  return nullptr;
+}
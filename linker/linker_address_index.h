@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LINKER_ADDRESS_INDEX_H
+#define _LINKER_ADDRESS_INDEX_H
+
+#include <link.h>
+
+struct soinfo;
+
+// The address ranges of the linked libraries, sorted by base address, so
+// that finding the library containing an address is a binary search. Each
+// library also gets an array of its defined symbols sorted by address, built
+// the first time it's needed, so that dladdr(3) doesn't have to scan the
+// symbol table either.
+//
+// Add and remove with g_soinfo_list_lock held for writing; look up with it
+// held for reading (or writing). The memory comes straight from mmap, not
+// from the linker allocators, since readers build the symbol arrays while
+// the soinfos are write-protected.
+
+void address_index_add(soinfo* si);
+void address_index_remove(soinfo* si);
+
+// Returns the library mapped at addr, or null.
+soinfo* address_index_find_library(const void* addr);
+
+// Returns the defined symbol of the library mapped at addr that contains
+// addr, or null. Sets *si to the library, or null if there isn't one.
+ElfW(Sym)* address_index_find_symbol(const void* addr, soinfo** si);
+
+#endif
@@ -15,6 +15,7 @@
  */
 #include "linker_allocator.h"
 #include <inttypes.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -22,16 +23,66 @@
 
 struct LinkerAllocatorPage {
   LinkerAllocatorPage* next;
-  uint8_t bytes[PAGE_SIZE-sizeof(LinkerAllocatorPage*)];
+  LinkerBlockAllocator* owner;
+  uint8_t bytes[PAGE_SIZE-2*sizeof(void*)];
 };
 
+static LinkerAllocatorPage* page_of(void* ptr) {
+  return reinterpret_cast<LinkerAllocatorPage*>(reinterpret_cast<uintptr_t>(ptr) & ~(PAGE_SIZE-1));
+}
+
+// The first page of each region holds its header.
+struct LinkerPageRegion {
+  LinkerPageRegion* next;
+  size_t size;
+  size_t used;
+};
+
+static const size_t kPageRegionSize = 256*PAGE_SIZE;
+
+void* LinkerPageAllocator::alloc_page() {
+  LinkerPageRegion* region = region_list_;
+  if (region == nullptr || region->used == region->size) {
+    // Untouched pages of the region cost nothing but address space.
+    void* map = mmap(nullptr, kPageRegionSize, PROT_READ|PROT_WRITE,
+                     MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+      abort(); // oom
+    }
+
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, kPageRegionSize, "linker_alloc");
+
+    region = reinterpret_cast<LinkerPageRegion*>(map);
+    region->next = region_list_;
+    region->size = kPageRegionSize;
+    region->used = PAGE_SIZE;
+    region_list_ = region;
+  }
+
+  void* page = reinterpret_cast<uint8_t*>(region) + region->used;
+  region->used += PAGE_SIZE;
+  return page;
+}
+
+void LinkerPageAllocator::protect_all(int prot) {
+  for (LinkerPageRegion* region = region_list_; region != nullptr; ) {
+    // Read the link before the header can become unreadable.
+    LinkerPageRegion* next = region->next;
+    if (mprotect(region, region->used, prot) == -1) {
+      abort();
+    }
+    region = next;
+  }
+}
+
 struct FreeBlockInfo {
   void* next_block;
   size_t num_free_blocks;
 };
 
-LinkerBlockAllocator::LinkerBlockAllocator(size_t block_size)
+LinkerBlockAllocator::LinkerBlockAllocator(size_t block_size, LinkerPageAllocator* page_allocator)
   : block_size_(block_size < sizeof(FreeBlockInfo) ? sizeof(FreeBlockInfo) : block_size),
+    page_allocator_(page_allocator),
     page_list_(nullptr),
     free_block_list_(nullptr)
 {}
@@ -64,10 +115,6 @@ void LinkerBlockAllocator::free(void* block) {
 
   LinkerAllocatorPage* page = find_page(block);
 
-  if (page == nullptr) {
-    abort();
-  }
-
   ssize_t offset = reinterpret_cast<uint8_t*>(block) - page->bytes;
 
   if (offset % block_size_ != 0) {
@@ -93,23 +140,19 @@ void LinkerBlockAllocator::protect_all(int prot) {
 }
 
 void LinkerBlockAllocator::create_new_page() {
-  LinkerAllocatorPage* page = reinterpret_cast<LinkerAllocatorPage*>(mmap(nullptr, PAGE_SIZE,
-      PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0));
-  if (page == MAP_FAILED) {
-    abort(); // oom
-  }
-
-  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, page, PAGE_SIZE, "linker_alloc");
+  LinkerAllocatorPage* page = reinterpret_cast<LinkerAllocatorPage*>(
+      page_allocator_->alloc_page());
 
   memset(page, 0, PAGE_SIZE);
 
   FreeBlockInfo* first_block = reinterpret_cast<FreeBlockInfo*>(page->bytes);
   first_block->next_block = free_block_list_;
-  first_block->num_free_blocks = (PAGE_SIZE - sizeof(LinkerAllocatorPage*))/block_size_;
+  first_block->num_free_blocks = sizeof(page->bytes)/block_size_;
 
   free_block_list_ = first_block;
 
   page->next = page_list_;
+  page->owner = this;
   page_list_ = page;
 }
 
@@ -118,15 +161,10 @@ LinkerAllocatorPage* LinkerBlockAllocator::find_page(void* block) {
     abort();
   }
 
-  LinkerAllocatorPage* page = page_list_;
-  while (page != nullptr) {
-    const uint8_t* page_ptr = reinterpret_cast<const uint8_t*>(page);
-    if (block >= (page_ptr + sizeof(page->next)) && block < (page_ptr + PAGE_SIZE)) {
-      return page;
-    }
-
-    page = page->next;
+  LinkerAllocatorPage* page = page_of(block);
+  if (page->owner != this || block < page->bytes) {
+    abort();
   }
 
-  abort();
+  return page;
 }
@@ -22,6 +22,31 @@
 #include "private/bionic_macros.h"
 
 struct LinkerAllocatorPage;
+struct LinkerPageRegion;
+
+/*
+ * Hands out the pages used by linker allocators from large regions of
+ * address space mapped up front, so that their data lives in a few VMAs
+ * instead of one per page, and protect_all() costs one mprotect(2) per
+ * region. Pages are never given back: allocators reuse their free blocks.
+ *
+ * Only allocators whose data should be protected together may share a
+ * LinkerPageAllocator.
+ */
+class LinkerPageAllocator {
+ public:
+  constexpr LinkerPageAllocator() : region_list_(nullptr) {}
+
+  void* alloc_page();
+
+  // Changes the protection of every page handed out so far.
+  void protect_all(int prot);
+
+ private:
+  LinkerPageRegion* region_list_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkerPageAllocator);
+};
 
 /*
  * This class is a non-template version of the LinkerAllocator
@@ -32,7 +57,7 @@ struct LinkerAllocatorPage;
  */
 class LinkerBlockAllocator {
  public:
-  explicit LinkerBlockAllocator(size_t block_size);
+  LinkerBlockAllocator(size_t block_size, LinkerPageAllocator* page_allocator);
 
   void* alloc();
   void free(void* block);
@@ -43,6 +68,7 @@ class LinkerBlockAllocator {
   LinkerAllocatorPage* find_page(void* block);
 
   size_t block_size_;
+  LinkerPageAllocator* page_allocator_;
   LinkerAllocatorPage* page_list_;
   void* free_block_list_;
 
@@ -59,7 +85,8 @@ class LinkerBlockAllocator {
 template<typename T>
 class LinkerAllocator {
  public:
-  LinkerAllocator() : block_allocator_(sizeof(T)) {}
+  explicit LinkerAllocator(LinkerPageAllocator* page_allocator)
+      : block_allocator_(sizeof(T), page_allocator) {}
   T* alloc() { return reinterpret_cast<T*>(block_allocator_.alloc()); }
   void free(T* t) { block_allocator_.free(t); }
   void protect_all(int prot) { block_allocator_.protect_all(prot); }
@@ -67,4 +94,5 @@ class LinkerAllocator {
   LinkerBlockAllocator block_allocator_;
   DISALLOW_COPY_AND_ASSIGN(LinkerAllocator);
 };
+
 #endif // __LINKER_ALLOCATOR_H
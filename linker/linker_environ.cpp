@@ -121,9 +121,12 @@ static bool __is_unsafe_environment_variable(const char* name) {
       "LD_DEBUG_OUTPUT",
       "LD_DYNAMIC_WEAK",
       "LD_LIBRARY_PATH",
+      "LD_LOAD_STATS",
       "LD_ORIGIN_PATH",
+      "LD_PREFETCH_MANIFEST",
       "LD_PRELOAD",
       "LD_PROFILE",
+      "LD_RELOCATION_CACHE",
       "LD_SHOW_AUXV",
       "LD_USE_LOAD_BIAS",
       "LOCALDOMAIN",
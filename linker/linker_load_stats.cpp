@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "linker_load_stats.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "private/ScopedFd.h"
+#include "private/libc_logging.h"
+
+static char g_load_stats_path[PATH_MAX];
+
+void load_stats_init(const char* path) {
+  if (path == nullptr || path[0] != '/' || strlen(path) >= sizeof(g_load_stats_path)) {
+    return;
+  }
+  strlcpy(g_load_stats_path, path, sizeof(g_load_stats_path));
+}
+
+bool load_stats_enabled() {
+  return g_load_stats_path[0] != '\0';
+}
+
+static uint64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void load_stats_write(const char* name, const LoadStats& stats) {
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(g_load_stats_path,
+                                      O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600)));
+  if (fd.get() == -1) {
+    return;
+  }
+  // Times are in microseconds. Each line goes out in a single write(2), so
+  // that processes starting at the same time can share one file.
+  char line[PATH_MAX + 256];
+  int length = __libc_format_buffer(line, sizeof(line),
+                                    "%d %s search=%" PRIu64 " load=%" PRIu64 " link=%" PRIu64
+                                    " constructors=%" PRIu64 " relocations=%zu lookups=%zu\n",
+                                    getpid(), name, stats.search_ns / 1000, stats.load_ns / 1000,
+                                    stats.link_ns / 1000, stats.constructors_ns / 1000,
+                                    stats.relocation_count, stats.symbol_lookup_count);
+  if (length > 0 && static_cast<size_t>(length) < sizeof(line)) {
+    TEMP_FAILURE_RETRY(write(fd.get(), line, length));
+  }
+}
+
+LoadStatsTimer::LoadStatsTimer(uint64_t* ns) : ns_(ns), start_ns_(0) {
+  if (load_stats_enabled()) {
+    start_ns_ = now_ns();
+  }
+}
+
+LoadStatsTimer::~LoadStatsTimer() {
+  if (start_ns_ != 0) {
+    *ns_ += now_ns() - start_ns_;
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LINKER_LOAD_STATS_H
+#define _LINKER_LOAD_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private/bionic_macros.h"
+
+// Where the time went while loading one library. Times are in nanoseconds
+// and are only measured when LD_LOAD_STATS is set; the counts are always
+// kept.
+struct LoadStats {
+  uint64_t search_ns;        // Finding and opening the file.
+  uint64_t load_ns;          // ElfReader: reading the headers, mapping the segments.
+  uint64_t link_ns;          // LinkImage: relocation, RELRO.
+  uint64_t constructors_ns;  // DT_INIT and DT_INIT_ARRAY, not counting dependencies.
+  size_t relocation_count;
+  size_t symbol_lookup_count;
+  bool reported;
+};
+
+// Enables the statistics, appended to the given file. Called once at
+// startup with the value of LD_LOAD_STATS.
+void load_stats_init(const char* path);
+
+bool load_stats_enabled();
+
+// Appends one line for the library to the statistics file.
+void load_stats_write(const char* name, const LoadStats& stats);
+
+// Adds the time until it goes out of scope to *ns, when enabled.
+class LoadStatsTimer {
+ public:
+  explicit LoadStatsTimer(uint64_t* ns);
+  ~LoadStatsTimer();
+
+ private:
+  uint64_t* ns_;
+  uint64_t start_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadStatsTimer);
+};
+
+#endif
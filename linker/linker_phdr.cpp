@@ -289,6 +289,29 @@ size_t phdr_table_get_load_size(const ElfW(Phdr)* phdr_table, size_t phdr_count,
 // Reserve a virtual address range big enough to hold all loadable
 // segments of a program header table. This is done by creating a
 // private anonymous mmap() with PROT_NONE.
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+static int g_huge_page_text_mode = 0;
+
+void phdr_set_huge_page_text_mode(int mode) {
+  g_huge_page_text_mode = mode;
+}
+
+// Returns the executable segment worth backing with huge pages, if
+// LD_HUGEPAGE_TEXT asks for that and there is one.
+const ElfW(Phdr)* ElfReader::FindHugePageText() {
+  if (g_huge_page_text_mode == 0) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < phdr_num_; ++i) {
+    const ElfW(Phdr)* phdr = &phdr_table_[i];
+    if (phdr->p_type == PT_LOAD && (phdr->p_flags & PF_X) != 0 && phdr->p_filesz >= kHugePageSize) {
+      return phdr;
+    }
+  }
+  return nullptr;
+}
+
 bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
   ElfW(Addr) min_vaddr;
   load_size_ = phdr_table_get_load_size(phdr_table_, phdr_num_, &min_vaddr);
@@ -318,10 +341,35 @@ bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
       return false;
     }
     int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS;
-    start = mmap(addr, load_size_, PROT_NONE, mmap_flags, -1, 0);
-    if (start == MAP_FAILED) {
-      DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", load_size_, name_);
-      return false;
+    const ElfW(Phdr)* text = (addr == nullptr) ? FindHugePageText() : nullptr;
+    if (text != nullptr) {
+      // The page cache only uses a huge page for a 2MiB-aligned range of
+      // the file, so the text has to be mapped at an address with the same
+      // offset into a 2MiB block as its file offset. Over-reserve by 2MiB,
+      // then trim the reservation to the start that achieves that.
+      size_t reserve_size = load_size_ + kHugePageSize;
+      start = mmap(nullptr, reserve_size, PROT_NONE, mmap_flags, -1, 0);
+      if (start == MAP_FAILED) {
+        DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", reserve_size, name_);
+        return false;
+      }
+      ElfW(Addr) reserve_start = reinterpret_cast<ElfW(Addr)>(start);
+      ElfW(Addr) wanted = file_offset_ + text->p_offset - (text->p_vaddr - min_vaddr);
+      ElfW(Addr) aligned_start = reserve_start + ((wanted - reserve_start) & (kHugePageSize - 1));
+      if (aligned_start > reserve_start) {
+        munmap(start, aligned_start - reserve_start);
+      }
+      if (aligned_start + load_size_ < reserve_start + reserve_size) {
+        munmap(reinterpret_cast<void*>(aligned_start + load_size_),
+               reserve_start + reserve_size - (aligned_start + load_size_));
+      }
+      start = reinterpret_cast<void*>(aligned_start);
+    } else {
+      start = mmap(addr, load_size_, PROT_NONE, mmap_flags, -1, 0);
+      if (start == MAP_FAILED) {
+        DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", load_size_, name_);
+        return false;
+      }
     }
   } else {
     start = extinfo->reserved_addr;
@@ -332,6 +380,20 @@ bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
   return true;
 }
 
+// Asks for the huge-page-sized blocks of a text mapping to be backed by
+// huge pages. Kernels without (file) THP just say no, which is fine.
+static void AdviseHugePageText(ElfW(Addr) start, ElfW(Addr) end) {
+  ElfW(Addr) huge_start = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  ElfW(Addr) huge_end = end & ~(kHugePageSize - 1);
+  if (huge_start < huge_end &&
+      madvise(reinterpret_cast<void*>(huge_start), huge_end - huge_start, MADV_HUGEPAGE) == -1) {
+    DEBUG("madvise(MADV_HUGEPAGE) failed: %s", strerror(errno));
+  }
+  if (g_huge_page_text_mode >= 2) {
+    madvise(reinterpret_cast<void*>(start), PAGE_END(end) - start, MADV_WILLNEED);
+  }
+}
+
 bool ElfReader::LoadSegments() {
   for (size_t i = 0; i < phdr_num_; ++i) {
     const ElfW(Phdr)* phdr = &phdr_table_[i];
@@ -367,6 +429,10 @@ bool ElfReader::LoadSegments() {
         DL_ERR("couldn't map \"%s\" segment %zd: %s", name_, i, strerror(errno));
         return false;
       }
+
+      if (phdr == FindHugePageText()) {
+        AdviseHugePageText(seg_page_start, seg_file_end);
+      }
     }
 
     // if the segment is writable, and does not end on a page boundary,
@@ -530,14 +596,16 @@ int phdr_table_protect_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count
  *   phdr_count  -> number of entries in tables
  *   load_bias   -> load bias
  *   fd          -> writable file descriptor to use
+ *   file_offset -> current offset of fd; advanced past the data written, so
+ *                  that the segments of several libraries can be appended to
+ *                  the same file
  * Return:
  *   0 on error, -1 on failure (error code in errno).
  */
 int phdr_table_serialize_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias,
-                                   int fd) {
+                                   int fd, size_t* file_offset) {
   const ElfW(Phdr)* phdr = phdr_table;
   const ElfW(Phdr)* phdr_limit = phdr + phdr_count;
-  ssize_t file_offset = 0;
 
   for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
     if (phdr->p_type != PT_GNU_RELRO) {
@@ -553,11 +621,11 @@ int phdr_table_serialize_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_cou
       return -1;
     }
     void* map = mmap(reinterpret_cast<void*>(seg_page_start), size, PROT_READ,
-                     MAP_PRIVATE|MAP_FIXED, fd, file_offset);
+                     MAP_PRIVATE|MAP_FIXED, fd, *file_offset);
     if (map == MAP_FAILED) {
       return -1;
     }
-    file_offset += size;
+    *file_offset += size;
   }
   return 0;
 }
@@ -575,11 +643,13 @@ int phdr_table_serialize_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_cou
  *   phdr_count  -> number of entries in tables
  *   load_bias   -> load bias
  *   fd          -> readable file descriptor to use
+ *   file_offset -> offset in fd of this library's segments; advanced past
+ *                  them, as for phdr_table_serialize_gnu_relro
  * Return:
  *   0 on error, -1 on failure (error code in errno).
  */
 int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias,
-                             int fd) {
+                             int fd, size_t* file_offset) {
   // Map the file at a temporary location so we can compare its contents.
   struct stat file_stat;
   if (TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0) {
@@ -593,7 +663,6 @@ int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, El
       return -1;
     }
   }
-  size_t file_offset = 0;
 
   // Iterate over the relro segments and compare/remap the pages.
   const ElfW(Phdr)* phdr = phdr_table;
@@ -607,12 +676,13 @@ int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, El
     ElfW(Addr) seg_page_start = PAGE_START(phdr->p_vaddr) + load_bias;
     ElfW(Addr) seg_page_end   = PAGE_END(phdr->p_vaddr + phdr->p_memsz) + load_bias;
 
-    char* file_base = static_cast<char*>(temp_mapping) + file_offset;
+    char* file_base = static_cast<char*>(temp_mapping) + *file_offset;
     char* mem_base = reinterpret_cast<char*>(seg_page_start);
     size_t match_offset = 0;
     size_t size = seg_page_end - seg_page_start;
 
-    if (file_size - file_offset < size) {
+    if (static_cast<size_t>(file_size) < *file_offset ||
+        static_cast<size_t>(file_size) - *file_offset < size) {
       // File is too short to compare to this segment. The contents are likely
       // different as well (it's probably for a different library version) so
       // just don't bother checking.
@@ -636,7 +706,7 @@ int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, El
       // Map over similar pages.
       if (mismatch_offset > match_offset) {
         void* map = mmap(mem_base + match_offset, mismatch_offset - match_offset,
-                         PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, match_offset);
+                         PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, *file_offset + match_offset);
         if (map == MAP_FAILED) {
           munmap(temp_mapping, file_size);
           return -1;
@@ -647,7 +717,7 @@ int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, El
     }
 
     // Add to the base file offset in case there are multiple relro segments.
-    file_offset += size;
+    *file_offset += size;
   }
   munmap(temp_mapping, file_size);
   return 0;
@@ -56,6 +56,7 @@ class ElfReader {
   bool ReadProgramHeader();
   bool ReserveAddressSpace(const android_dlextinfo* extinfo);
   bool LoadSegments();
+  const ElfW(Phdr)* FindHugePageText();
   bool FindPhdr();
   bool CheckPhdr(ElfW(Addr));
 
@@ -81,6 +82,14 @@ class ElfReader {
   const ElfW(Phdr)* loaded_phdr_;
 };
 
+// Called at startup with the value of LD_HUGEPAGE_TEXT. 0, the default, maps
+// every segment at page granularity. 1 places executable segments of at
+// least 2MiB so that their addresses and file offsets are congruent modulo
+// 2MiB, which lets the kernel back them with huge pages (given file THP),
+// and asks for that with MADV_HUGEPAGE. 2 also asks for the text to be read
+// in ahead with MADV_WILLNEED.
+void phdr_set_huge_page_text_mode(int mode);
+
 size_t phdr_table_get_load_size(const ElfW(Phdr)* phdr_table, size_t phdr_count,
                                 ElfW(Addr)* min_vaddr = nullptr, ElfW(Addr)* max_vaddr = nullptr);
 
@@ -91,10 +100,10 @@ int phdr_table_unprotect_segments(const ElfW(Phdr)* phdr_table, size_t phdr_coun
 int phdr_table_protect_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias);
 
 int phdr_table_serialize_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias,
-                                   int fd);
+                                   int fd, size_t* file_offset);
 
 int phdr_table_map_gnu_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias,
-                             int fd);
+                             int fd, size_t* file_offset);
 
 #if defined(__arm__)
 int phdr_table_get_arm_exidx(const ElfW(Phdr)* phdr_table, size_t phdr_count, ElfW(Addr) load_bias,
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "linker_relocation_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "linker.h"
+#include "linker_debug.h"
+
+#include "private/ScopedFd.h"
+#include "private/libc_logging.h"
+
+// On-disk format, native endian:
+//
+//   Header
+//   Identity[scope_size]   the lookup scope, in order
+//   Entry[entry_count]     one per symbol lookup, in relocation order
+
+struct RelocationCache::Header {
+  char magic[4];
+  uint32_t scope_size;
+  uint32_t entry_count;
+  uint32_t reserved;
+};
+
+struct RelocationCache::Identity {
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t file_offset;
+  int64_t mtime;
+};
+
+struct RelocationCache::Entry {
+  uint32_t ref_index;    // The referring symbol, in the relocated library's symbol table.
+  uint32_t scope_index;  // kUnresolved for an undefined weak reference.
+  uint32_t sym_index;
+};
+
+static const char kMagic[4] = { 'R', 'L', 'C', '2' };
+static const uint32_t kUnresolved = UINT32_MAX;
+
+static char g_relocation_cache_dir[PATH_MAX];
+
+void relocation_cache_init(const char* dir) {
+  if (dir == nullptr || dir[0] != '/' || strlen(dir) >= sizeof(g_relocation_cache_dir)) {
+    return;
+  }
+  strlcpy(g_relocation_cache_dir, dir, sizeof(g_relocation_cache_dir));
+}
+
+RelocationCache::RelocationCache(soinfo* si, soinfo* const scope[], size_t scope_size)
+    : si_(si), scope_(scope), scope_size_(scope_size), enabled_(false),
+      file_map_(nullptr), file_size_(0), file_entries_(nullptr), file_entry_count_(0),
+      symbol_counts_(nullptr), entries_(nullptr), entry_count_(0), entry_capacity_(0) {
+  Identity identity;
+  if (g_relocation_cache_dir[0] == '\0' || !get_identity(si_, &identity) || identity.ino == 0) {
+    return;
+  }
+  int length = __libc_format_buffer(path_, sizeof(path_),
+                                    "%s/%" PRIx64 "-%" PRIx64 "-%" PRIx64 ".relocs",
+                                    g_relocation_cache_dir, identity.dev, identity.ino,
+                                    identity.file_offset);
+  if (length <= 0 || static_cast<size_t>(length) >= sizeof(path_)) {
+    return;
+  }
+  enabled_ = true;
+  load();
+}
+
+RelocationCache::~RelocationCache() {
+  drop_file();
+  if (entries_ != nullptr) {
+    munmap(entries_, entry_capacity_ * sizeof(Entry));
+  }
+}
+
+bool RelocationCache::get_identity(soinfo* si, Identity* identity) {
+  memset(identity, 0, sizeof(*identity));
+  if ((si->flags & FLAG_EXE) != 0) {
+    // The kernel mapped the main executable, so we never had its fd. It's
+    // part of every scope, and it can't change under us, so stat it once.
+    static bool exe_stat_done = false;
+    static bool exe_stat_ok = false;
+    static struct stat exe_stat;
+    if (!exe_stat_done) {
+      exe_stat_ok = TEMP_FAILURE_RETRY(stat("/proc/self/exe", &exe_stat)) == 0;
+      exe_stat_done = true;
+    }
+    if (!exe_stat_ok) {
+      return false;
+    }
+    identity->dev = exe_stat.st_dev;
+    identity->ino = exe_stat.st_ino;
+    identity->mtime = exe_stat.st_mtime;
+  } else {
+    // The vdso and libdl have no file and are all-zero; symbols bound to
+    // them are still checked by name in find().
+    identity->dev = si->get_st_dev();
+    identity->ino = si->get_st_ino();
+    identity->file_offset = si->get_file_offset();
+    identity->mtime = si->get_file_mtime();
+  }
+  return true;
+}
+
+void RelocationCache::load() {
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(path_, O_RDONLY | O_CLOEXEC)));
+  if (fd.get() == -1) {
+    return;
+  }
+  struct stat file_stat;
+  if (TEMP_FAILURE_RETRY(fstat(fd.get(), &file_stat)) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(Header)) {
+    return;
+  }
+  void* map = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (map == MAP_FAILED) {
+    return;
+  }
+  file_map_ = map;
+  file_size_ = file_stat.st_size;
+
+  const Header* header = reinterpret_cast<const Header*>(file_map_);
+  const Identity* identities = reinterpret_cast<const Identity*>(header + 1);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->scope_size != scope_size_ ||
+      file_size_ != sizeof(Header) + scope_size_ * sizeof(Identity) +
+                    header->entry_count * sizeof(Entry)) {
+    DEBUG("%s: ignoring malformed relocation cache %s", si_->name, path_);
+    drop_file();
+    return;
+  }
+  for (size_t i = 0; i < scope_size_; ++i) {
+    Identity identity;
+    if (!get_identity(scope_[i], &identity) ||
+        memcmp(&identity, &identities[i], sizeof(identity)) != 0) {
+      DEBUG("%s: relocation cache %s is stale (\"%s\" changed)", si_->name, path_, scope_[i]->name);
+      drop_file();
+      return;
+    }
+  }
+
+  void* counts = mmap(nullptr, scope_size_ * sizeof(size_t), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (counts == MAP_FAILED) {
+    drop_file();
+    return;
+  }
+  symbol_counts_ = reinterpret_cast<size_t*>(counts);
+  for (size_t i = 0; i < scope_size_; ++i) {
+    symbol_counts_[i] = scope_[i]->get_symbol_count();
+  }
+
+  file_entries_ = reinterpret_cast<const Entry*>(identities + scope_size_);
+  file_entry_count_ = header->entry_count;
+  TRACE("[ using relocation cache %s for \"%s\" ]", path_, si_->name);
+}
+
+void RelocationCache::drop_file() {
+  if (file_map_ != nullptr) {
+    munmap(file_map_, file_size_);
+    file_map_ = nullptr;
+  }
+  if (symbol_counts_ != nullptr) {
+    munmap(symbol_counts_, scope_size_ * sizeof(size_t));
+    symbol_counts_ = nullptr;
+  }
+  file_entries_ = nullptr;
+  file_entry_count_ = 0;
+}
+
+bool RelocationCache::find(uint32_t ref_index, const char* sym_name, ElfW(Sym)** s, soinfo** lsi) {
+  if (file_entries_ == nullptr) {
+    return false;
+  }
+  if (entry_count_ >= file_entry_count_) {
+    drop_file();
+    return false;
+  }
+
+  const Entry& entry = file_entries_[entry_count_];
+  if (entry.ref_index != ref_index) {
+    DEBUG("%s: relocation cache %s is stale at \"%s\"", si_->name, path_, sym_name);
+    drop_file();
+    return false;
+  }
+  if (entry.scope_index == kUnresolved) {
+    // The scope is unchanged, so the lookup would fail again.
+    *s = nullptr;
+    *lsi = nullptr;
+    return true;
+  }
+  if (entry.scope_index < scope_size_ && entry.sym_index < symbol_counts_[entry.scope_index]) {
+    soinfo* def = scope_[entry.scope_index];
+    ElfW(Sym)* sym = def->symtab + entry.sym_index;
+    // Only accept what soinfo_do_lookup could have returned: a global or
+    // weak definition with this name. (Symbol versions are ignored by the
+    // linker, so there's no version to check.)
+    unsigned bind = ELF_ST_BIND(sym->st_info);
+    if ((bind == STB_GLOBAL || bind == STB_WEAK) && sym->st_shndx != SHN_UNDEF &&
+        strcmp(def->get_string(sym->st_name), sym_name) == 0) {
+      *s = sym;
+      *lsi = def;
+      return true;
+    }
+  }
+
+  DEBUG("%s: relocation cache %s is stale at \"%s\"", si_->name, path_, sym_name);
+  drop_file();
+  return false;
+}
+
+void RelocationCache::record(uint32_t ref_index, ElfW(Sym)* s, soinfo* lsi) {
+  if (!enabled_) {
+    return;
+  }
+  Entry entry = { ref_index, kUnresolved, 0 };
+  if (s != nullptr) {
+    for (size_t i = 0; i < scope_size_; ++i) {
+      if (scope_[i] == lsi) {
+        entry.scope_index = i;
+        break;
+      }
+    }
+    if (entry.scope_index == kUnresolved) {
+      // Found outside of the scope we can validate; don't cache anything.
+      enabled_ = false;
+      return;
+    }
+    entry.sym_index = s - lsi->symtab;
+  }
+
+  if (entry_count_ == entry_capacity_) {
+    size_t new_capacity = entry_capacity_ == 0 ? PAGE_SIZE / sizeof(Entry) : entry_capacity_ * 2;
+    void* map = mmap(nullptr, new_capacity * sizeof(Entry), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      enabled_ = false;
+      return;
+    }
+    if (entries_ != nullptr) {
+      memcpy(map, entries_, entry_count_ * sizeof(Entry));
+      munmap(entries_, entry_capacity_ * sizeof(Entry));
+    }
+    entries_ = reinterpret_cast<Entry*>(map);
+    entry_capacity_ = new_capacity;
+  }
+  entries_[entry_count_++] = entry;
+}
+
+void RelocationCache::finish() {
+  if (!enabled_ || (file_entries_ != nullptr && entry_count_ == file_entry_count_)) {
+    // Disabled, or the file on disk was used and is up to date.
+    return;
+  }
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.scope_size = scope_size_;
+  header.entry_count = entry_count_;
+  header.reserved = 0;
+
+  // Write to a temporary file and rename it into place, so that concurrent
+  // readers only ever see complete files.
+  char tmp_path[PATH_MAX];
+  int length = __libc_format_buffer(tmp_path, sizeof(tmp_path), "%s.%d", path_, getpid());
+  if (length <= 0 || static_cast<size_t>(length) >= sizeof(tmp_path)) {
+    return;
+  }
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)));
+  if (fd.get() == -1) {
+    DEBUG("%s: couldn't create relocation cache %s: %s", si_->name, tmp_path, strerror(errno));
+    return;
+  }
+
+  bool ok = write_fully(fd.get(), &header, sizeof(header));
+  for (size_t i = 0; ok && i < scope_size_; ++i) {
+    Identity identity;
+    ok = get_identity(scope_[i], &identity) && write_fully(fd.get(), &identity, sizeof(identity));
+  }
+  ok = ok && write_fully(fd.get(), entries_, entry_count_ * sizeof(Entry));
+  if (!ok || rename(tmp_path, path_) != 0) {
+    DEBUG("%s: couldn't write relocation cache %s: %s", si_->name, path_, strerror(errno));
+    unlink(tmp_path);
+    return;
+  }
+  TRACE("[ wrote relocation cache %s for \"%s\" ]", path_, si_->name);
+}
+
+bool RelocationCache::write_fully(int fd, const void* data, size_t size) {
+  const char* p = reinterpret_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = TEMP_FAILURE_RETRY(write(fd, p, size));
+    if (written <= 0) {
+      return false;
+    }
+    p += written;
+    size -= written;
+  }
+  return true;
+}
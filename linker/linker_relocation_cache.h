@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LINKER_RELOCATION_CACHE_H
+#define _LINKER_RELOCATION_CACHE_H
+
+#include <limits.h>
+#include <link.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private/bionic_macros.h"
+
+struct soinfo;
+
+// Enables the cache, kept in the given directory. Called once at startup
+// with the value of LD_RELOCATION_CACHE.
+void relocation_cache_init(const char* dir);
+
+// Remembers what each symbol lookup made while relocating a library
+// resolved to, so that later processes loading the same library with the
+// same lookup scope can skip the lookups.
+//
+// Lookups are recorded in relocation order as (referring symbol, position
+// of the defining library in the scope, index of the symbol in its symbol
+// table). The file is only replayed if every library in the scope is still
+// the same file (device, inode, offset and mtime), each lookup's referring
+// symbol matches, and every replayed symbol is checked by name and binding,
+// so a stale cache costs lookups but never binds a wrong symbol.
+// Nothing recorded depends on load addresses.
+class RelocationCache {
+ public:
+  // 'scope' lists the libraries soinfo_do_lookup may search for 'si', 'si'
+  // itself included.
+  RelocationCache(soinfo* si, soinfo* const scope[], size_t scope_size);
+  ~RelocationCache();
+
+  // Returns true and sets *s and *lsi (*s may be null for an unresolved
+  // weak reference) if the cache has the result of the next lookup, for
+  // the symbol at 'ref_index' in the relocated library's symbol table.
+  bool find(uint32_t ref_index, const char* sym_name, ElfW(Sym)** s, soinfo** lsi);
+
+  // Records the result of the next lookup, made by soinfo_do_lookup or
+  // returned by find().
+  void record(uint32_t ref_index, ElfW(Sym)* s, soinfo* lsi);
+
+  // Writes the cache file if the one on disk was missing or stale.
+  void finish();
+
+ private:
+  struct Header;
+  struct Identity;
+  struct Entry;
+
+  static bool get_identity(soinfo* si, Identity* identity);
+  static bool write_fully(int fd, const void* data, size_t size);
+  void load();
+  void drop_file();
+
+  soinfo* si_;
+  soinfo* const* scope_;
+  size_t scope_size_;
+  // False if there is no cache directory, or if a lookup was made that
+  // can't be recorded.
+  bool enabled_;
+  char path_[PATH_MAX];
+
+  // The mmapped cache file, while it still agrees with the lookups made.
+  void* file_map_;
+  size_t file_size_;
+  const Entry* file_entries_;
+  size_t file_entry_count_;
+  size_t* symbol_counts_;
+
+  // The lookups made so far.
+  Entry* entries_;
+  size_t entry_count_;
+  size_t entry_capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(RelocationCache);
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "linker_tls.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_macros.h"
+#include "private/bionic_tls.h"
+#include "private/KernelArgumentBlock.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+#include "linker.h"
+#include "linker_debug.h"
+
+// Not static, so that the TLSDESC resolver can get to it.
+extern "C" __LIBC_HIDDEN__ TlsModules g_tls_modules;
+TlsModules g_tls_modules;
+
+#if defined(__aarch64__)
+// tlsdesc_resolver.S depends on these.
+static_assert(offsetof(TlsModules, generation) == 0, "tlsdesc_resolver.S is out of date");
+static_assert(offsetof(TlsModules, get_addr) == 8, "tlsdesc_resolver.S is out of date");
+static_assert(offsetof(TlsDtv, count) == 0, "tlsdesc_resolver.S is out of date");
+static_assert(offsetof(TlsDtv, generation) == 8, "tlsdesc_resolver.S is out of date");
+static_assert(offsetof(TlsDtv, blocks) == 16, "tlsdesc_resolver.S is out of date");
+static_assert(TLS_SLOT_DTV == 9, "tlsdesc_resolver.S is out of date");
+#endif
+
+// Set once the startup libraries are in place; anything registered later
+// only gets dynamic TLS.
+static bool g_tls_startup_finished;
+
+void linker_tls_init(KernelArgumentBlock& args) {
+  // The linker's own copy of libc lays out the main thread's static TLS.
+  __libc_tls_modules = &g_tls_modules;
+  args.tls_modules = &g_tls_modules;
+}
+
+static size_t modules_mmap_size(size_t capacity) {
+  return BIONIC_ALIGN(capacity * sizeof(TlsModule), PAGE_SIZE);
+}
+
+// libc only looks at the table with the lock held, so it can move.
+static bool grow_modules_locked() {
+  size_t capacity = (g_tls_modules.module_capacity == 0) ? PAGE_SIZE / sizeof(TlsModule)
+                                                         : g_tls_modules.module_capacity * 2;
+  void* modules = mmap(nullptr, modules_mmap_size(capacity), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (modules == MAP_FAILED) {
+    return false;
+  }
+
+  if (g_tls_modules.modules != nullptr) {
+    memcpy(modules, g_tls_modules.modules, g_tls_modules.module_count * sizeof(TlsModule));
+    munmap(g_tls_modules.modules, modules_mmap_size(g_tls_modules.module_capacity));
+  }
+  g_tls_modules.modules = reinterpret_cast<TlsModule*>(modules);
+  g_tls_modules.module_capacity = capacity;
+  return true;
+}
+
+bool linker_tls_register(soinfo* si) {
+  TlsModule module;
+  memset(&module, 0, sizeof(module));
+  if (!__bionic_get_tls_segment(si->phdr, si->phnum, si->load_bias, &module.segment)) {
+    return true;
+  }
+
+  size_t alignment = module.segment.alignment;
+  if ((alignment & (alignment - 1)) != 0 || module.segment.init_size > module.segment.size) {
+    DL_ERR("\"%s\" has an invalid TLS segment", si->name);
+    return false;
+  }
+
+#if !defined(BIONIC_STATIC_TLS)
+  // The executable's code expects its variables at a fixed offset from the
+  // thread pointer, which we can't provide here.
+  if ((si->flags & FLAG_EXE) != 0) {
+    DL_ERR("\"%s\": executables with a TLS segment aren't supported on this architecture",
+           si->name);
+    return false;
+  }
+#endif
+
+  ScopedPthreadMutexLocker locker(&g_tls_modules.lock);
+
+  // Reuse the slot of a library that has been unloaded, if there is one.
+  size_t index = 0;
+  while (index < g_tls_modules.module_count && g_tls_modules.modules[index].generation != 0) {
+    ++index;
+  }
+  if (index == g_tls_modules.module_count) {
+    if (index == g_tls_modules.module_capacity && !grow_modules_locked()) {
+      DL_ERR("couldn't allocate a TLS module for \"%s\": %s", si->name, strerror(errno));
+      return false;
+    }
+    ++g_tls_modules.module_count;
+  }
+
+#if defined(BIONIC_STATIC_TLS)
+  if (!g_tls_startup_finished) {
+    __bionic_add_static_tls_module(&g_tls_modules, &module);
+  }
+#endif
+
+  module.generation = g_tls_modules.generation + 1;
+  g_tls_modules.modules[index] = module;
+  g_tls_modules.generation = module.generation;
+  si->set_tls_module_id(index + 1);
+
+  TRACE("\"%s\" is TLS module %zu (%zu bytes%s)", si->name, index + 1, module.segment.size,
+        module.is_static ? ", static" : "");
+  return true;
+}
+
+void linker_tls_unregister(soinfo* si) {
+  size_t module_id = si->get_tls_module_id();
+  if (module_id == 0) {
+    return;
+  }
+
+  // Each thread frees its block the next time it catches up with the table.
+  ScopedPthreadMutexLocker locker(&g_tls_modules.lock);
+  memset(&g_tls_modules.modules[module_id - 1], 0, sizeof(TlsModule));
+  g_tls_modules.generation = g_tls_modules.generation + 1;
+  si->set_tls_module_id(0);
+}
+
+bool linker_tls_get_static_offset(soinfo* si, intptr_t* offset) {
+  size_t module_id = si->get_tls_module_id();
+  if (module_id == 0) {
+    return false;
+  }
+
+  ScopedPthreadMutexLocker locker(&g_tls_modules.lock);
+  const TlsModule& module = g_tls_modules.modules[module_id - 1];
+  if (!module.is_static) {
+    return false;
+  }
+  *offset = module.static_offset;
+  return true;
+}
+
+bool linker_tls_finish_startup() {
+  g_tls_startup_finished = true;
+  if (!__bionic_init_main_thread_static_tls()) {
+    DL_ERR("couldn't allocate the main thread's static TLS: %s", strerror(errno));
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LINKER_TLS_H
+#define _LINKER_TLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class KernelArgumentBlock;
+struct soinfo;
+
+// Publishes the ELF TLS module table (see private/bionic_elf_tls.h) to libc.
+void linker_tls_init(KernelArgumentBlock& args);
+
+// Gives a library a module id if it has a TLS segment. Libraries registered
+// before linker_tls_finish_startup are also given a block in the static TLS
+// area, on the architectures that have one.
+bool linker_tls_register(soinfo* si);
+void linker_tls_unregister(soinfo* si);
+
+// Returns the offset of a library's static TLS block from the thread pointer.
+// Fails for libraries without one.
+bool linker_tls_get_static_offset(soinfo* si, intptr_t* offset);
+
+// Called once the executable and the libraries loaded with it have been
+// relocated, before any of their code runs.
+bool linker_tls_finish_startup();
+
+#if defined(__aarch64__)
+// A TLS descriptor's argument holds the module id in its top bits and the
+// variable's offset within the module's block in the rest.
+#define TLSDESC_MODULE_SHIFT 48
+
+// The resolver for TLS descriptors (see arch/arm64/tlsdesc_resolver.S).
+extern "C" void tlsdesc_resolver_dynamic();
+#endif
+
+#endif
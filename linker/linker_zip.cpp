@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "linker_zip.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "linker.h"
+#include "linker_debug.h"
+
+#include "private/ScopedFd.h"
+
+// Just enough of the zip format (no zip64, no multi-disk archives) to find
+// where a stored entry's data starts.
+static const uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+static const uint32_t kCentralDirectoryEntrySignature = 0x02014b50;
+static const uint32_t kLocalFileHeaderSignature = 0x04034b50;
+
+static const size_t kEndOfCentralDirectorySize = 22;
+static const size_t kCentralDirectoryEntrySize = 46;
+static const size_t kLocalFileHeaderSize = 30;
+static const size_t kMaxCommentSize = 0xffff;
+
+static const uint16_t kCompressionStored = 0;
+
+static uint16_t get_u16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// A read-only mapping of part of the archive.
+class ZipMapping {
+ public:
+  ZipMapping() : map_(MAP_FAILED), map_size_(0), data_(nullptr) {}
+
+  ~ZipMapping() {
+    if (map_ != MAP_FAILED) {
+      munmap(map_, map_size_);
+    }
+  }
+
+  bool map(int fd, off64_t offset, size_t size) {
+    off64_t page_offset = offset & ~static_cast<off64_t>(PAGE_SIZE - 1);
+    map_size_ = size + (offset - page_offset);
+    map_ = mmap64(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, page_offset);
+    if (map_ == MAP_FAILED) {
+      return false;
+    }
+    data_ = reinterpret_cast<const uint8_t*>(map_) + (offset - page_offset);
+    return true;
+  }
+
+  const uint8_t* data() const {
+    return data_;
+  }
+
+ private:
+  void* map_;
+  size_t map_size_;
+  const uint8_t* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(ZipMapping);
+};
+
+int open_zip_entry(const char* archive_path, const char* entry_name, off64_t* entry_offset) {
+  ScopedFd fd(TEMP_FAILURE_RETRY(open(archive_path, O_RDONLY | O_CLOEXEC)));
+  struct stat file_stat;
+  if (fd.get() == -1 || TEMP_FAILURE_RETRY(fstat(fd.get(), &file_stat)) != 0 ||
+      file_stat.st_size < static_cast<off64_t>(kEndOfCentralDirectorySize)) {
+    return -1;
+  }
+
+  // The end of central directory record is at the very end, followed only
+  // by the archive comment.
+  off64_t file_size = file_stat.st_size;
+  size_t tail_size = kEndOfCentralDirectorySize + kMaxCommentSize;
+  if (static_cast<off64_t>(tail_size) > file_size) {
+    tail_size = file_size;
+  }
+  ZipMapping tail;
+  if (!tail.map(fd.get(), file_size - tail_size, tail_size)) {
+    return -1;
+  }
+  const uint8_t* eocd = nullptr;
+  for (size_t i = tail_size - kEndOfCentralDirectorySize + 1; i-- > 0; ) {
+    if (get_u32(tail.data() + i) == kEndOfCentralDirectorySignature) {
+      eocd = tail.data() + i;
+      break;
+    }
+  }
+  if (eocd == nullptr) {
+    PRINT("\"%s\" is not a zip archive", archive_path);
+    return -1;
+  }
+  uint16_t entry_count = get_u16(eocd + 10);
+  uint32_t cd_size = get_u32(eocd + 12);
+  uint32_t cd_offset = get_u32(eocd + 16);
+  if (static_cast<off64_t>(cd_offset) + cd_size > file_size) {
+    PRINT("\"%s\" has a bad central directory", archive_path);
+    return -1;
+  }
+
+  ZipMapping central_directory;
+  if (cd_size == 0 || !central_directory.map(fd.get(), cd_offset, cd_size)) {
+    return -1;
+  }
+  size_t entry_name_length = strlen(entry_name);
+  const uint8_t* p = central_directory.data();
+  const uint8_t* end = p + cd_size;
+  for (uint16_t i = 0; i < entry_count; ++i) {
+    if (end - p < static_cast<ptrdiff_t>(kCentralDirectoryEntrySize) ||
+        get_u32(p) != kCentralDirectoryEntrySignature) {
+      PRINT("\"%s\" has a bad central directory", archive_path);
+      return -1;
+    }
+    uint16_t method = get_u16(p + 10);
+    uint32_t compressed_size = get_u32(p + 20);
+    uint32_t uncompressed_size = get_u32(p + 24);
+    uint16_t name_length = get_u16(p + 28);
+    uint16_t extra_length = get_u16(p + 30);
+    uint16_t comment_length = get_u16(p + 32);
+    uint32_t local_header_offset = get_u32(p + 42);
+    const uint8_t* name = p + kCentralDirectoryEntrySize;
+    p = name + name_length + extra_length + comment_length;
+    if (p > end) {
+      PRINT("\"%s\" has a bad central directory", archive_path);
+      return -1;
+    }
+    if (name_length != entry_name_length || memcmp(name, entry_name, name_length) != 0) {
+      continue;
+    }
+
+    if (method != kCompressionStored || compressed_size != uncompressed_size) {
+      PRINT("\"%s\" in \"%s\" is compressed", entry_name, archive_path);
+      return -1;
+    }
+    uint8_t local_header[kLocalFileHeaderSize];
+    if (TEMP_FAILURE_RETRY(pread64(fd.get(), local_header, sizeof(local_header),
+                                   local_header_offset)) != sizeof(local_header) ||
+        get_u32(local_header) != kLocalFileHeaderSignature) {
+      PRINT("\"%s\" in \"%s\" has a bad local header", entry_name, archive_path);
+      return -1;
+    }
+    off64_t data_offset = static_cast<off64_t>(local_header_offset) + kLocalFileHeaderSize +
+        get_u16(local_header + 26) + get_u16(local_header + 28);
+    if ((data_offset % PAGE_SIZE) != 0) {
+      PRINT("\"%s\" in \"%s\" is not page-aligned: %" PRId64, entry_name, archive_path, data_offset);
+      return -1;
+    }
+    if (data_offset + uncompressed_size > file_size) {
+      PRINT("\"%s\" in \"%s\" is truncated", entry_name, archive_path);
+      return -1;
+    }
+
+    *entry_offset = data_offset;
+    return fd.release();
+  }
+  return -1;
+}
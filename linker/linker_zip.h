@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _LINKER_ZIP_H
+#define _LINKER_ZIP_H
+
+#include <sys/types.h>
+
+// Opens a library stored in a zip archive (an APK, typically), named
+// "archive.zip!/path/in/archive.so". The entry has to be stored
+// uncompressed at a page-aligned offset, as `zipalign -p` arranges, so
+// that its segments can be mapped straight from the archive and share the
+// archive's page cache.
+//
+// Returns a descriptor for the archive and sets *entry_offset to the
+// offset of the library in it, or returns -1 if the archive or the entry
+// can't be used.
+int open_zip_entry(const char* archive_path, const char* entry_name, off64_t* entry_offset);
+
+#endif
@@ -46,10 +46,12 @@ struct test_struct_larger {
 };
 
 static size_t kPageSize = sysconf(_SC_PAGE_SIZE);
+
+static LinkerPageAllocator g_page_allocator;
 };
 
 TEST(linker_allocator, test_nominal) {
-  LinkerAllocator<test_struct_nominal> allocator;
+  LinkerAllocator<test_struct_nominal> allocator(&g_page_allocator);
 
   test_struct_nominal* ptr1 = allocator.alloc();
   ASSERT_TRUE(ptr1 != nullptr);
@@ -65,7 +67,7 @@ TEST(linker_allocator, test_nominal) {
 }
 
 TEST(linker_allocator, test_small) {
-  LinkerAllocator<test_struct_small> allocator;
+  LinkerAllocator<test_struct_small> allocator(&g_page_allocator);
 
   char* ptr1 = reinterpret_cast<char*>(allocator.alloc());
   char* ptr2 = reinterpret_cast<char*>(allocator.alloc());
@@ -76,7 +78,7 @@ TEST(linker_allocator, test_small) {
 }
 
 TEST(linker_allocator, test_larger) {
-  LinkerAllocator<test_struct_larger> allocator;
+  LinkerAllocator<test_struct_larger> allocator(&g_page_allocator);
 
   test_struct_larger* ptr1 = allocator.alloc();
   test_struct_larger* ptr2 = allocator.alloc();
@@ -99,7 +101,7 @@ TEST(linker_allocator, test_larger) {
 }
 
 static void protect_all() {
-  LinkerAllocator<test_struct_larger> allocator;
+  LinkerAllocator<test_struct_larger> allocator(&g_page_allocator);
 
   // number of allocs to reach the end of first page
   size_t n = kPageSize/sizeof(test_struct_larger) - 1;
@@ -128,3 +130,35 @@ TEST(linker_allocator, test_protect) {
   ASSERT_EXIT(protect_all(), testing::KilledBySignal(SIGSEGV), "trying to access protected page");
 }
 
+static void protect_all_pages() {
+  LinkerPageAllocator page_allocator;
+  LinkerAllocator<test_struct_nominal> allocator1(&page_allocator);
+  LinkerAllocator<test_struct_larger> allocator2(&page_allocator);
+  LinkerPageAllocator other_page_allocator;
+  LinkerAllocator<test_struct_nominal> allocator3(&other_page_allocator);
+
+  test_struct_nominal* ptr1 = allocator1.alloc();
+  test_struct_larger* ptr2 = allocator2.alloc();
+  test_struct_nominal* ptr3 = allocator3.alloc();
+
+  page_allocator.protect_all(PROT_READ);
+  page_allocator.protect_all(PROT_READ | PROT_WRITE);
+  // check access
+  ptr1->value = 1;
+  ptr2->dummy_str[99] = 2;
+
+  page_allocator.protect_all(PROT_READ);
+  ASSERT_EQ(1, ptr1->value);
+  ASSERT_EQ(2, ptr2->dummy_str[99]);
+  // Another page allocator's pages aren't affected.
+  ptr3->value = 3;
+  fprintf(stderr, "trying to access protected page");
+
+  // this should result in segmentation fault
+  ptr2->dummy_str[98] = 7;
+}
+
+TEST(linker_allocator, test_protect_all_pages) {
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  ASSERT_EXIT(protect_all_pages(), testing::KilledBySignal(SIGSEGV), "trying to access protected page");
+}
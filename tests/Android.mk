@@ -53,11 +53,17 @@ test_cppflags = \
 
 libBionicStandardTests_src_files := \
     arpa_inet_test.cpp \
+    array_math_test.cpp \
+    async_io_test.cpp \
     buffer_tests.cpp \
     complex_test.cpp \
+    copy_fd_range_test.cpp \
+    cpu_features_test.cpp \
     ctype_test.cpp \
     dirent_test.cpp \
+    dns_async_test.cpp \
     eventfd_test.cpp \
+    fast_clock_test.cpp \
     fcntl_test.cpp \
     fenv_test.cpp \
     ftw_test.cpp \
@@ -66,6 +72,7 @@ libBionicStandardTests_src_files := \
     inttypes_test.cpp \
     libc_logging_test.cpp \
     libgen_test.cpp \
+    link_test.cpp \
     locale_test.cpp \
     malloc_test.cpp \
     math_cos_test.cpp \
@@ -83,20 +90,28 @@ libBionicStandardTests_src_files := \
     math_tan_test.cpp \
     math_tanf_test.cpp \
     math_test.cpp \
+    mmsg_arena_test.cpp \
     mntent_test.cpp \
     netdb_test.cpp \
+    parallel_test.cpp \
     pthread_test.cpp \
     pty_test.cpp \
     regex_test.cpp \
     sched_test.cpp \
     search_test.cpp \
+    semaphore_test.cpp \
+    sha_test.cpp \
+    shared_memory_test.cpp \
     signal_test.cpp \
+    spawn_test.cpp \
     stack_protector_test.cpp \
     stack_unwinding_test.cpp \
+    startup_trace_test.cpp \
     stdatomic_test.cpp \
     stdint_test.cpp \
     stdio_test.cpp \
     stdlib_test.cpp \
+    string_inline_test.cpp \
     string_test.cpp \
     strings_test.cpp \
     stubs_test.cpp \
@@ -112,9 +127,11 @@ libBionicStandardTests_src_files := \
     sys_syscall_test.cpp \
     sys_time_test.cpp \
     sys_types_test.cpp \
+    sys_uio_test.cpp \
     sys_vfs_test.cpp \
     system_properties_test.cpp \
     time_test.cpp \
+    tree_walk_test.cpp \
     uchar_test.cpp \
     uniqueptr_test.cpp \
     unistd_test.cpp \
@@ -230,6 +247,7 @@ bionic-unit-tests_src_files := \
     atexit_test.cpp \
     dlext_test.cpp \
     dlfcn_test.cpp \
+    execinfo_test.cpp \
 
 bionic-unit-tests_cflags := $(test_cflags)
 
@@ -279,6 +297,29 @@ build_type := target
 build_target := NATIVE_TEST
 include $(LOCAL_PATH)/Android.build.mk
 
+# -----------------------------------------------------------------------------
+# The same tests as a static-PIE executable. Run with:
+#   adb shell /data/nativetest/bionic-unit-tests-static-pie/bionic-unit-tests-static-pie32
+#   adb shell /data/nativetest/bionic-unit-tests-static-pie/bionic-unit-tests-static-pie64
+# -----------------------------------------------------------------------------
+ifeq ($(filter mips mips64,$(TARGET_ARCH)),)
+bionic-unit-tests-static-pie_whole_static_libraries := \
+    $(bionic-unit-tests-static_whole_static_libraries) \
+
+bionic-unit-tests-static-pie_static_libraries := \
+    $(bionic-unit-tests-static_static_libraries) \
+
+bionic-unit-tests-static-pie_cflags := -fPIE
+bionic-unit-tests-static-pie_ldflags := -pie -Wl,--no-dynamic-linker
+bionic-unit-tests-static-pie_force_static_executable := true
+
+module := bionic-unit-tests-static-pie
+module_tag := optional
+build_type := target
+build_target := NATIVE_TEST
+include $(LOCAL_PATH)/Android.build.mk
+endif
+
 # -----------------------------------------------------------------------------
 # Tests to run on the host and linked against glibc. Run with:
 #   cd bionic/tests; mm bionic-unit-tests-glibc-run
@@ -289,6 +330,7 @@ ifeq ($(HOST_OS)-$(HOST_ARCH),$(filter $(HOST_OS)-$(HOST_ARCH),linux-x86 linux-x
 bionic-unit-tests-glibc_src_files := \
     atexit_test.cpp \
     dlfcn_test.cpp \
+    execinfo_test.cpp \
 
 bionic-unit-tests-glibc_whole_static_libraries := \
     libBionicStandardTests \
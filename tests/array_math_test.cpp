@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/array_math.h>
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#if defined(__BIONIC__)
+struct ArrayFunction {
+  const char* name;
+  void (*array)(const float*, float*, size_t);
+  float (*scalar)(float);
+  float lo;
+  float hi;
+};
+
+static const ArrayFunction kArrayFunctions[] = {
+  { "expf", android_math_expf_array, expf, -110.0f, 100.0f },
+  { "logf", android_math_logf_array, logf, 0.0f, 1e6f },
+  { "sinf", android_math_sinf_array, sinf, -1e5f, 1e5f },
+  { "cosf", android_math_cosf_array, cosf, -1e5f, 1e5f },
+  { "sqrtf", android_math_sqrtf_array, sqrtf, 0.0f, 1e30f },
+  { "tanhf", android_math_tanhf_array, tanhf, -12.0f, 12.0f },
+};
+
+static const float kSpecialValues[] = {
+  NAN, INFINITY, -INFINITY, 0.0f, -0.0f, 1.0f, -1.0f, 0x1p-149f, 1e30f, -1e30f, 3e38f,
+};
+
+static void CheckArray(const ArrayFunction& f, const std::vector<float>& in,
+                       const std::vector<float>& out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    float expected = f.scalar(in[i]);
+    if (isnan(expected)) {
+      ASSERT_TRUE(isnan(out[i])) << f.name << "(" << in[i] << ")";
+    } else {
+      ASSERT_FLOAT_EQ(expected, out[i]) << f.name << "(" << in[i] << ")";
+    }
+  }
+}
+#endif
+
+TEST(array_math, matches_scalar) {
+#if defined(__BIONIC__)
+  // Every length up to a few vectors, then a block with a partial vector at the end.
+  std::vector<size_t> lengths;
+  for (size_t n = 0; n <= 40; ++n) {
+    lengths.push_back(n);
+  }
+  lengths.push_back(4099);
+  srand(1);
+  for (size_t f = 0; f < sizeof(kArrayFunctions)/sizeof(kArrayFunctions[0]); ++f) {
+    const ArrayFunction& function = kArrayFunctions[f];
+    for (size_t l = 0; l < lengths.size(); ++l) {
+      size_t n = lengths[l];
+      std::vector<float> in(n + 1);
+      std::vector<float> out(n + 1, 123.0f);
+      for (size_t i = 0; i < n; ++i) {
+        if (rand() % 8 == 0) {
+          in[i] = kSpecialValues[rand() % (sizeof(kSpecialValues)/sizeof(kSpecialValues[0]))];
+        } else {
+          in[i] = function.lo + (function.hi - function.lo) * (rand() / static_cast<float>(RAND_MAX));
+        }
+      }
+      function.array(&in[0], &out[0], n);
+      CheckArray(function, in, out, n);
+      ASSERT_EQ(123.0f, out[n]) << function.name << " wrote past " << n << " elements";
+    }
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(array_math, in_place) {
+#if defined(__BIONIC__)
+  for (size_t f = 0; f < sizeof(kArrayFunctions)/sizeof(kArrayFunctions[0]); ++f) {
+    const ArrayFunction& function = kArrayFunctions[f];
+    std::vector<float> in(1000);
+    for (size_t i = 0; i < in.size(); ++i) {
+      in[i] = function.lo + (function.hi - function.lo) * i / in.size();
+    }
+    std::vector<float> out(in);
+    function.array(&out[0], &out[0], out.size());
+    CheckArray(function, in, out, out.size());
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/async_io.h>
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "TemporaryFile.h"
+
+TEST(async_io, batched_reads_and_writes) {
+#if defined(__BIONIC__)
+  aio_context_t ctx;
+  ASSERT_EQ(0, android_aio_setup(128, &ctx));
+
+  TemporaryFile tf;
+  const size_t kCount = 100;
+  const size_t kBlock = 512;
+
+  // All the writes with one submission...
+  std::vector<char> out(kCount * kBlock);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = i / kBlock;
+  }
+  std::vector<iocb> iocbs(kCount);
+  std::vector<iocb*> pointers(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    android_aio_prep_pwrite(&iocbs[i], tf.fd, &out[i * kBlock], kBlock, i * kBlock,
+                            reinterpret_cast<void*>(i));
+    pointers[i] = &iocbs[i];
+  }
+  ASSERT_EQ(static_cast<int>(kCount), android_aio_submit(ctx, &pointers[0], kCount));
+
+  std::vector<io_event> events(kCount);
+  size_t done = 0;
+  while (done < kCount) {
+    int rc = android_aio_getevents(ctx, 1, kCount - done, &events[done], NULL);
+    ASSERT_GT(rc, 0);
+    done += rc;
+  }
+  std::vector<int> seen(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(static_cast<int64_t>(kBlock), events[i].res);
+    ++seen[events[i].data];
+  }
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(1, seen[i]) << i;
+  }
+
+  // ...and read back, vectored, with a completion on an eventfd.
+  std::vector<char> in(out.size());
+  iovec iov[2] = { { &in[0], in.size() / 2 }, { &in[in.size() / 2], in.size() / 2 } };
+  int efd = eventfd(0, EFD_CLOEXEC);
+  ASSERT_NE(-1, efd);
+  android_aio_prep_preadv(&iocbs[0], tf.fd, iov, 2, 0, NULL);
+  android_aio_set_eventfd(&iocbs[0], efd);
+  ASSERT_EQ(1, android_aio_submit(ctx, &pointers[0], 1));
+  uint64_t count;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(count)), read(efd, &count, sizeof(count)));
+  ASSERT_EQ(1U, count);
+  ASSERT_EQ(1, android_aio_getevents(ctx, 0, 1, &events[0], NULL));
+  ASSERT_EQ(static_cast<int64_t>(in.size()), events[0].res);
+  ASSERT_EQ(out, in);
+  close(efd);
+
+  // Short reads come back in the completion.
+  android_aio_prep_pread(&iocbs[0], tf.fd, &in[0], kBlock, out.size() - 10, NULL);
+  ASSERT_EQ(1, android_aio_submit(ctx, &pointers[0], 1));
+  ASSERT_EQ(1, android_aio_getevents(ctx, 1, 1, &events[0], NULL));
+  ASSERT_EQ(10, events[0].res);
+
+  // Nothing to collect, and no waiting.
+  timespec zero = { 0, 0 };
+  ASSERT_EQ(0, android_aio_getevents(ctx, 1, 1, &events[0], &zero));
+
+  ASSERT_EQ(0, android_aio_destroy(ctx));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(async_io, submit_errors) {
+#if defined(__BIONIC__)
+  aio_context_t ctx;
+  ASSERT_EQ(0, android_aio_setup(8, &ctx));
+
+  TemporaryFile tf;
+  char buf[16];
+  iocb iocbs[3];
+  iocb* pointers[3] = { &iocbs[0], &iocbs[1], &iocbs[2] };
+  android_aio_prep_pread(&iocbs[0], tf.fd, buf, sizeof(buf), 0, NULL);
+  android_aio_prep_pread(&iocbs[1], -1, buf, sizeof(buf), 0, NULL);
+  android_aio_prep_pread(&iocbs[2], tf.fd, buf, sizeof(buf), 0, NULL);
+
+  // Stops at the bad one, saying why.
+  errno = 0;
+  ASSERT_EQ(1, android_aio_submit(ctx, pointers, 3));
+  ASSERT_EQ(EBADF, errno);
+
+  errno = 0;
+  ASSERT_EQ(-1, android_aio_submit(ctx, &pointers[1], 2));
+  ASSERT_EQ(EBADF, errno);
+
+  ASSERT_EQ(0, android_aio_submit(ctx, pointers, 0));
+
+  io_event event;
+  ASSERT_EQ(1, android_aio_getevents(ctx, 1, 1, &event, NULL));
+  ASSERT_EQ(0, android_aio_destroy(ctx));
+
+  aio_context_t bad = 0;
+  ASSERT_EQ(-1, android_aio_destroy(bad));
+  ASSERT_EQ(EINVAL, errno);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
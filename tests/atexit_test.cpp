@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 TEST(atexit, dlclose) {
   std::string atexit_call_sequence;
@@ -94,3 +95,60 @@ TEST(atexit, exit) {
   ASSERT_EXIT(atexit_main(), testing::ExitedWithCode(0), "123456");
 }
 
+
+extern "C" int __cxa_atexit(void (*)(void*), void*, void*);
+extern "C" void __cxa_finalize(void*);
+
+static std::string cxa_sequence;
+
+static void cxa_append(void* arg) {
+  cxa_sequence += static_cast<const char*>(arg);
+}
+
+// Stand-ins for the __dso_handle of a few libraries.
+static char fake_dso_handles[3][sizeof(void*)] __attribute__((aligned(sizeof(void*))));
+
+static void cxa_register_more(void* arg) {
+  cxa_sequence += "+";
+  __cxa_atexit(cxa_append, const_cast<char*>("d"), arg);
+}
+
+TEST(atexit, cxa_finalize_per_dso) {
+  void* a = fake_dso_handles[0];
+  void* b = fake_dso_handles[1];
+  cxa_sequence.clear();
+  ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("a"), a));
+  ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("b"), b));
+  ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("c"), a));
+  ASSERT_EQ(0, __cxa_atexit(cxa_register_more, a, a));
+  ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("e"), b));
+
+  // Only a's handlers run, newest first, including the one registered late.
+  __cxa_finalize(a);
+  ASSERT_EQ("+dca", cxa_sequence);
+
+  // They only ever run once.
+  __cxa_finalize(a);
+  ASSERT_EQ("+dca", cxa_sequence);
+
+  __cxa_finalize(b);
+  ASSERT_EQ("+dcaeb", cxa_sequence);
+}
+
+TEST(atexit, cxa_finalize_many_dsos) {
+  // A plugin host loading and unloading many libraries.
+  const size_t kCount = 1000;
+  std::vector<char> handles(kCount * sizeof(void*));
+  for (size_t round = 0; round < 3; ++round) {
+    cxa_sequence.clear();
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("x"), &handles[i * sizeof(void*)]));
+      ASSERT_EQ(0, __cxa_atexit(cxa_append, const_cast<char*>("y"), &handles[i * sizeof(void*)]));
+    }
+    for (size_t i = 0; i < kCount; ++i) {
+      __cxa_finalize(&handles[i * sizeof(void*)]);
+      ASSERT_EQ(2 * (i + 1), cxa_sequence.size());
+      ASSERT_EQ("yx", cxa_sequence.substr(2 * i));
+    }
+  }
+}
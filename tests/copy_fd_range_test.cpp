@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/copy_fd_range.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "TemporaryFile.h"
+
+#if defined(__BIONIC__)
+// Fills a file with more than one chunk's worth of recognizable bytes.
+static std::string FillFile(int fd, size_t size) {
+  std::string data;
+  for (size_t i = 0; i < size; ++i) {
+    data += static_cast<char>('a' + (i * 7) % 26);
+  }
+  EXPECT_EQ(static_cast<ssize_t>(size), write(fd, data.data(), size));
+  return data;
+}
+
+static std::string ReadFully(int fd, size_t size) {
+  std::string result(size, '\0');
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = read(fd, &result[done], size - done);
+    if (n <= 0) {
+      break;
+    }
+    done += n;
+  }
+  result.resize(done);
+  return result;
+}
+#endif
+
+TEST(copy_fd_range, file_to_file) {
+#if defined(__BIONIC__)
+  TemporaryFile in;
+  TemporaryFile out;
+  const size_t kSize = 200 * 1024 + 3;
+  std::string data = FillFile(in.fd, kSize);
+
+  // With an offset, in's file offset is left alone.
+  off64_t offset = 3;
+  ASSERT_EQ(static_cast<ssize_t>(kSize - 3), android_copy_fd_range(in.fd, &offset, out.fd, kSize));
+  ASSERT_EQ(static_cast<off64_t>(kSize), offset);
+  ASSERT_EQ(static_cast<off_t>(kSize), lseek(in.fd, 0, SEEK_CUR));
+  ASSERT_EQ(0, lseek(out.fd, 0, SEEK_SET));
+  ASSERT_EQ(data.substr(3), ReadFully(out.fd, kSize));
+
+  // Without one, in's file offset is used and advanced.
+  ASSERT_EQ(10, lseek(in.fd, 10, SEEK_SET));
+  ASSERT_EQ(0, ftruncate(out.fd, 0));
+  ASSERT_EQ(0, lseek(out.fd, 0, SEEK_SET));
+  ASSERT_EQ(100, android_copy_fd_range(in.fd, NULL, out.fd, 100));
+  ASSERT_EQ(110, lseek(in.fd, 0, SEEK_CUR));
+  ASSERT_EQ(0, lseek(out.fd, 0, SEEK_SET));
+  ASSERT_EQ(data.substr(10, 100), ReadFully(out.fd, 1000));
+
+  // At end of file there's nothing to copy.
+  offset = kSize;
+  ASSERT_EQ(0, android_copy_fd_range(in.fd, &offset, out.fd, 10));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(copy_fd_range, pipe_to_file) {
+#if defined(__BIONIC__)
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(5, write(fds[1], "hello", 5));
+  close(fds[1]);
+
+  TemporaryFile out;
+  ASSERT_EQ(5, android_copy_fd_range(fds[0], NULL, out.fd, 100));
+  close(fds[0]);
+  ASSERT_EQ(0, lseek(out.fd, 0, SEEK_SET));
+  ASSERT_EQ("hello", ReadFully(out.fd, 100));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(copy_fd_range, socket_to_socket) {
+#if defined(__BIONIC__)
+  // Neither end is a file or a pipe, so this goes through the thread's pipe.
+  int in[2];
+  int out[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+  const char kData[] = "spliced through a pipe";
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(kData)), write(in[1], kData, sizeof(kData)));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(kData)), android_copy_fd_range(in[0], NULL, out[0], sizeof(kData)));
+  ASSERT_EQ(std::string(kData, sizeof(kData)), ReadFully(out[1], sizeof(kData)));
+
+  // The pipe is reused, and holds nothing from last time.
+  ASSERT_EQ(3, write(in[1], "abc", 3));
+  ASSERT_EQ(3, android_copy_fd_range(in[0], NULL, out[0], 3));
+  ASSERT_EQ("abc", ReadFully(out[1], 3));
+
+  // A short copy at end of file.
+  ASSERT_EQ(2, write(in[1], "de", 2));
+  close(in[1]);
+  ASSERT_EQ(2, android_copy_fd_range(in[0], NULL, out[0], 100));
+  ASSERT_EQ("de", ReadFully(out[1], 2));
+
+  close(in[0]);
+  close(out[0]);
+  close(out[1]);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(copy_fd_range, errors) {
+#if defined(__BIONIC__)
+  TemporaryFile in;
+  FillFile(in.fd, 10);
+  off64_t offset = 0;
+  errno = 0;
+  ASSERT_EQ(-1, android_copy_fd_range(in.fd, &offset, -1, 10));
+  ASSERT_EQ(EBADF, errno);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/cpu_features.h>
+#endif
+
+TEST(cpu_features, same_every_time) {
+#if defined(__BIONIC__)
+  const struct android_cpu_features* features = android_cpu_features();
+  ASSERT_TRUE(features != NULL);
+  ASSERT_EQ(features, android_cpu_features());
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(cpu_features, matches_the_compiler) {
+#if defined(__BIONIC__)
+  const struct android_cpu_features* features = android_cpu_features();
+#if defined(__aarch64__)
+  // Every ARMv8 CPU we support has Advanced SIMD.
+  ASSERT_NE(0U, features->flags & ANDROID_CPU_FEATURE_NEON);
+  ASSERT_EQ(0U, features->x86_signature);
+#elif defined(__arm__)
+#if defined(__ARM_NEON__)
+  ASSERT_NE(0U, features->flags & ANDROID_CPU_FEATURE_NEON);
+#endif
+  ASSERT_EQ(0U, features->x86_signature);
+#elif defined(__i386__) || defined(__x86_64__)
+  __builtin_cpu_init();
+  ASSERT_EQ(__builtin_cpu_supports("ssse3") != 0,
+            (features->flags & ANDROID_CPU_FEATURE_SSSE3) != 0);
+  ASSERT_EQ(__builtin_cpu_supports("sse4.2") != 0,
+            (features->flags & ANDROID_CPU_FEATURE_SSE4_2) != 0);
+  ASSERT_EQ(__builtin_cpu_supports("popcnt") != 0,
+            (features->flags & ANDROID_CPU_FEATURE_POPCNT) != 0);
+  ASSERT_EQ(__builtin_cpu_supports("avx2") != 0,
+            (features->flags & ANDROID_CPU_FEATURE_AVX2) != 0);
+  ASSERT_NE(0U, features->x86_signature);
+  ASSERT_EQ(0U, features->midr);
+#endif
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(cpu_features, midr) {
+#if defined(__BIONIC__) && (defined(__arm__) || defined(__aarch64__))
+  // Not every kernel says, but if it does the fields should be plausible.
+  uint32_t midr = android_cpu_features()->midr;
+  if (midr != 0) {
+    ASSERT_NE(0U, ANDROID_CPU_MIDR_IMPLEMENTER(midr));
+    ASSERT_NE(0U, ANDROID_CPU_MIDR_PART(midr));
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
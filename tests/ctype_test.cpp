@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include <ctype.h>
+#include <locale.h>
 
 TEST(ctype, isalnum) {
   EXPECT_TRUE(isalnum('1'));
@@ -136,3 +137,25 @@ TEST(ctype, _toupper) {
   // _toupper may mangle characters for which islower is false.
   EXPECT_EQ('A', _toupper('a'));
 }
+
+TEST(ctype, _l_functions_match) {
+  locale_t l = newlocale(LC_ALL, "C", 0);
+  ASSERT_TRUE(l != NULL);
+  for (int c = -1; c <= 255; ++c) {
+    EXPECT_EQ(!!isalnum(c), !!isalnum_l(c, l)) << c;
+    EXPECT_EQ(!!isalpha(c), !!isalpha_l(c, l)) << c;
+    EXPECT_EQ(!!isblank(c), !!isblank_l(c, l)) << c;
+    EXPECT_EQ(!!iscntrl(c), !!iscntrl_l(c, l)) << c;
+    EXPECT_EQ(!!isdigit(c), !!isdigit_l(c, l)) << c;
+    EXPECT_EQ(!!isgraph(c), !!isgraph_l(c, l)) << c;
+    EXPECT_EQ(!!islower(c), !!islower_l(c, l)) << c;
+    EXPECT_EQ(!!isprint(c), !!isprint_l(c, l)) << c;
+    EXPECT_EQ(!!ispunct(c), !!ispunct_l(c, l)) << c;
+    EXPECT_EQ(!!isspace(c), !!isspace_l(c, l)) << c;
+    EXPECT_EQ(!!isupper(c), !!isupper_l(c, l)) << c;
+    EXPECT_EQ(!!isxdigit(c), !!isxdigit_l(c, l)) << c;
+    EXPECT_EQ(tolower(c), tolower_l(c, l)) << c;
+    EXPECT_EQ(toupper(c), toupper_l(c, l)) << c;
+  }
+  freelocale(l);
+}
@@ -28,6 +28,8 @@
 #include <set>
 #include <string>
 
+#include "TemporaryFile.h"
+
 static void CheckProcSelf(std::set<std::string>& names) {
   // We have a good idea of what should be in /proc/self.
   ASSERT_TRUE(names.find(".") != names.end());
@@ -231,3 +233,52 @@ TEST(dirent, rewinddir) {
     ASSERT_EQ(pass1[i], pass2[i]);
   }
 }
+
+TEST(dirent, readdir_big_directory) {
+  // Enough long names to need several reads, and bigger buffers.
+  TemporaryDir td;
+  const size_t kCount = 5000;
+  std::set<std::string> expected;
+  for (size_t i = 0; i < kCount; ++i) {
+    char name[NAME_MAX];
+    snprintf(name, sizeof(name), "a_long_name_like_a_media_scanner_sees_%06zu.jpg", i);
+    std::string path = std::string(td.dirname) + "/" + name;
+    int fd = open(path.c_str(), O_CREAT | O_WRONLY, 0644);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    expected.insert(name);
+  }
+  expected.insert(".");
+  expected.insert("..");
+
+  DIR* d = opendir(td.dirname);
+  ASSERT_TRUE(d != NULL);
+  for (size_t pass = 0; pass < 2; ++pass) {
+    std::set<std::string> names;
+    size_t entry_count = 0;
+    dirent* e;
+    while ((e = readdir(d)) != NULL) {
+      names.insert(e->d_name);
+      ++entry_count;
+    }
+    ASSERT_EQ(expected.size(), entry_count);
+    ASSERT_EQ(expected, names);
+    rewinddir(d);
+  }
+  ASSERT_EQ(closedir(d), 0);
+
+  dirent** entries;
+  int entry_count = scandir(td.dirname, &entries, NULL, alphasort);
+  ASSERT_EQ(static_cast<int>(expected.size()), entry_count);
+  std::set<std::string> name_set;
+  std::vector<std::string> name_list;
+  ScanEntries(entries, entry_count, name_set, name_list);
+  ASSERT_EQ(expected, name_set);
+  ASSERT_TRUE(std::is_sorted(name_list.begin(), name_list.end()));
+
+  for (std::set<std::string>::iterator it = expected.begin(); it != expected.end(); ++it) {
+    if (*it != "." && *it != "..") {
+      unlink((std::string(td.dirname) + "/" + *it).c_str());
+    }
+  }
+}
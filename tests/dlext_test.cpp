@@ -43,6 +43,7 @@
 typedef int (*fn)(void);
 #define LIBNAME "libdlext_test.so"
 #define LIBNAME_NORELRO "libdlext_test_norelro.so"
+#define LIBNAME_WITH_DEPENDENCY "libtest_with_dependency.so"
 #define LIBSIZE 1024*1024 // how much address space to reserve for it
 
 #if defined(__LP64__)
@@ -133,6 +134,21 @@ TEST_F(DlExtTest, ExtInfoUseFdWithOffset) {
   EXPECT_EQ(4, f());
 }
 
+TEST_F(DlExtTest, DlopenZipEntry) {
+  const char* android_data = getenv("ANDROID_DATA");
+  ASSERT_TRUE(android_data != nullptr);
+
+  char lib_path[PATH_MAX];
+  snprintf(lib_path, sizeof(lib_path), LIBZIPPATH "!/libdlext_test_fd.so", android_data);
+
+  handle_ = dlopen(lib_path, RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle_);
+
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_EQ(4, f());
+}
+
 TEST_F(DlExtTest, ExtInfoUseFdWithInvalidOffset) {
   const char* android_data = getenv("ANDROID_DATA");
   ASSERT_TRUE(android_data != nullptr);
@@ -169,6 +185,74 @@ TEST_F(DlExtTest, ExtInfoUseOffsetWihtoutFd) {
   ASSERT_STREQ("dlopen failed: invalid extended flag combination (ANDROID_DLEXT_USE_LIBRARY_FD_OFFSET without ANDROID_DLEXT_USE_LIBRARY_FD): 0x20", dlerror());
 }
 
+TEST_F(DlExtTest, ExtInfoRelroDependenciesWithoutRelro) {
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES;
+
+  handle_ = android_dlopen_ext(LIBNAME_WITH_DEPENDENCY, RTLD_NOW, &extinfo);
+  ASSERT_TRUE(handle_ == nullptr);
+  ASSERT_STREQ("dlopen failed: invalid extended flag combination (ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES without ANDROID_DLEXT_WRITE_RELRO or ANDROID_DLEXT_USE_RELRO): 0x40", dlerror());
+}
+
+TEST_F(DlExtTest, DeferConstructorsUntilDlsym) {
+  unsetenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN");
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_DEFER_CONSTRUCTORS;
+
+  handle_ = android_dlopen_ext("libdlext_test_deferred_ctor.so", RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  ASSERT_TRUE(getenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN") == nullptr);
+
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "dlext_testlib_deferred_ctor_fn"));
+  ASSERT_DL_NOTNULL(f);
+  ASSERT_STREQ("1", getenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN"));
+  EXPECT_EQ(42, f());
+}
+
+TEST_F(DlExtTest, DeferConstructorsUntilDlinit) {
+  unsetenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN");
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_DEFER_CONSTRUCTORS;
+
+  handle_ = android_dlopen_ext("libdlext_test_deferred_ctor.so", RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  ASSERT_TRUE(getenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN") == nullptr);
+
+  ASSERT_DL_ZERO(android_dlinit(handle_));
+  ASSERT_STREQ("1", getenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN"));
+}
+
+TEST(dlext, android_dlinit_invalid_handle) {
+  int not_a_library;
+  ASSERT_EQ(-1, android_dlinit(&not_a_library));
+  ASSERT_STREQ("android_dlinit failed: invalid handle", dlerror());
+}
+
+TEST(dlext, android_dlopen_many) {
+  const char* names[] = { LIBNAME, LIBNAME_WITH_DEPENDENCY };
+  void* handles[2];
+  ASSERT_DL_ZERO(android_dlopen_many(names, 2, RTLD_NOW, handles));
+
+  void* handle = dlopen(LIBNAME_WITH_DEPENDENCY, RTLD_NOW | RTLD_NOLOAD);
+  ASSERT_DL_NOTNULL(handle);
+  ASSERT_EQ(handles[1], handle);
+  fn f = reinterpret_cast<fn>(dlsym(handles[0], "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_EQ(4, f());
+
+  dlclose(handle);
+  dlclose(handles[0]);
+  dlclose(handles[1]);
+}
+
+TEST(dlext, android_dlopen_many_all_or_nothing) {
+  const char* names[] = { "libtest_dlsym_weak_func.so", "libdoes_not_exist.so" };
+  void* handles[2];
+  ASSERT_EQ(-1, android_dlopen_many(names, 2, RTLD_NOW, handles));
+  ASSERT_STREQ("dlopen failed: library \"libdoes_not_exist.so\" not found", dlerror());
+  ASSERT_TRUE(dlopen("libtest_dlsym_weak_func.so", RTLD_NOW | RTLD_NOLOAD) == nullptr);
+}
+
 TEST_F(DlExtTest, Reserved) {
   void* start = mmap(nullptr, LIBSIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
                      -1, 0);
@@ -314,6 +398,12 @@ TEST_F(DlExtRelroSharingTest, ChildWritesNoRelro) {
   ASSERT_NO_FATAL_FAILURE(TryUsingRelro(LIBNAME_NORELRO));
 }
 
+TEST_F(DlExtRelroSharingTest, ChildWritesGoodDataWithDependencies) {
+  extinfo_.flags |= ANDROID_DLEXT_RELRO_INCLUDE_DEPENDENCIES;
+  ASSERT_NO_FATAL_FAILURE(CreateRelroFile(LIBNAME_WITH_DEPENDENCY));
+  ASSERT_NO_FATAL_FAILURE(TryUsingRelro(LIBNAME_WITH_DEPENDENCY));
+}
+
 TEST_F(DlExtRelroSharingTest, RelroFileEmpty) {
   int relro_fd = open(relro_file_, O_CREAT | O_RDWR | O_TRUNC, 0644);
   ASSERT_NOERROR(relro_fd);
@@ -19,8 +19,12 @@
 #include <dlfcn.h>
 #include <libgen.h>
 #include <limits.h>
+#include <link.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include "private/ScopeGuard.h"
 
@@ -89,6 +93,22 @@ TEST(dlfcn, dlopen_noload) {
   ASSERT_EQ(0, dlclose(handle2));
 }
 
+TEST(dlfcn, dlsym_default_follows_dlopen_and_dlclose) {
+  // A miss, then a hit once the library that defines the symbol is loaded,
+  // then a miss again once it's gone, whatever the linker has cached.
+  ASSERT_TRUE(dlsym(RTLD_DEFAULT, "dlopen_testlib_taxicab_number") == nullptr);
+  for (int i = 0; i < 2; ++i) {
+    void* handle = dlopen("libtest_simple.so", RTLD_NOW);
+    ASSERT_TRUE(handle != nullptr) << dlerror();
+    uint32_t* taxicab_number =
+        reinterpret_cast<uint32_t*>(dlsym(RTLD_DEFAULT, "dlopen_testlib_taxicab_number"));
+    ASSERT_TRUE(taxicab_number != nullptr) << dlerror();
+    ASSERT_EQ(1729U, *taxicab_number);
+    ASSERT_EQ(0, dlclose(handle));
+    ASSERT_TRUE(dlsym(RTLD_DEFAULT, "dlopen_testlib_taxicab_number") == nullptr);
+  }
+}
+
 // ifuncs are only supported on intel and arm64 for now
 #if defined(__i386__) || defined(__x86_64__)
 TEST(dlfcn, ifunc) {
@@ -362,19 +382,33 @@ TEST(dlfcn, dladdr_invalid) {
   ASSERT_TRUE(dlerror() == NULL); // dladdr(3) doesn't set dlerror(3).
 }
 
-// Our dynamic linker doesn't support GNU hash tables.
-#if defined(__BIONIC__)
 // GNU-style ELF hash tables are incompatible with the MIPS ABI.
 // MIPS requires .dynsym to be sorted to match the GOT but GNU-style requires sorting by hash code.
 #if !defined(__mips__)
 TEST(dlfcn, dlopen_library_with_only_gnu_hash) {
   dlerror(); // Clear any pending errors.
-  void* handle = dlopen("no-elf-hash-table-library.so", RTLD_NOW);
-  ASSERT_TRUE(handle == NULL);
-  ASSERT_STREQ("dlopen failed: empty/missing DT_HASH in \"no-elf-hash-table-library.so\" (built with --hash-style=gnu?)", dlerror());
+  void* handle = dlopen("libgnu-hash-table-library.so", RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+  auto guard = make_scope_guard([&]() {
+    dlclose(handle);
+  });
+  void* sym = dlsym(handle, "getRandomNumber");
+  ASSERT_TRUE(sym != nullptr) << dlerror();
+  int (*fn)(void);
+  fn = reinterpret_cast<int (*)(void)>(sym);
+  EXPECT_EQ(4, fn());
+
+  // A name that is not in the table should be rejected (usually by the bloom filter).
+  ASSERT_TRUE(dlsym(handle, "ThisSymbolDoesNotExist") == nullptr);
+
+  Dl_info dlinfo;
+  ASSERT_TRUE(0 != dladdr(reinterpret_cast<void*>(fn), &dlinfo));
+
+  ASSERT_TRUE(fn == dlinfo.dli_saddr);
+  ASSERT_STREQ("getRandomNumber", dlinfo.dli_sname);
+  ASSERT_SUBSTR("libgnu-hash-table-library.so", dlinfo.dli_fname);
 }
 #endif
-#endif
 
 TEST(dlfcn, dlopen_bad_flags) {
   dlerror(); // Clear any pending errors.
@@ -436,3 +470,151 @@ TEST(dlfcn, dlopen_symlink) {
   ASSERT_TRUE(handle2 != NULL);
   ASSERT_EQ(handle1, handle2);
 }
+
+static void* DlopenSlowCtorFn(void*) {
+  return dlopen("libtest_dlopen_slow_ctor.so", RTLD_NOW);
+}
+
+static int CountPhdrCallback(dl_phdr_info*, size_t, void* data) {
+  ++*reinterpret_cast<size_t*>(data);
+  return 0;
+}
+
+// Lookups must not wait for a dlopen that is stuck in a constructor.
+TEST(dlfcn, dlsym_dladdr_dl_iterate_phdr_during_dlopen) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  char fd[16];
+  snprintf(fd, sizeof(fd), "%d", fds[0]);
+  ASSERT_EQ(0, setenv("DLOPEN_TESTLIB_SLOW_CTOR_FD", fd, 1));
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, DlopenSlowCtorFn, NULL));
+
+  void* sym = dlsym(RTLD_DEFAULT, "fopen");
+  ASSERT_TRUE(sym != NULL);
+  Dl_info info;
+  ASSERT_TRUE(dladdr(sym, &info) != 0);
+  ASSERT_STREQ("fopen", info.dli_sname);
+  size_t count = 0;
+  dl_iterate_phdr(CountPhdrCallback, &count);
+  ASSERT_NE(0U, count);
+
+  ASSERT_EQ(1, write(fds[1], "x", 1));
+  void* handle;
+  ASSERT_EQ(0, pthread_join(t, &handle));
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  typedef int (*fn_t)();
+  fn_t fn = reinterpret_cast<fn_t>(dlsym(handle, "dlopen_testlib_slow_ctor_fn"));
+  ASSERT_TRUE(fn != NULL);
+  ASSERT_EQ(42, fn());
+
+  unsetenv("DLOPEN_TESTLIB_SLOW_CTOR_FD");
+  close(fds[0]);
+  close(fds[1]);
+  dlclose(handle);
+}
+
+struct PhdrCounts {
+  size_t size;
+  unsigned long long adds;
+  unsigned long long subs;
+};
+
+static int GetPhdrCountsCallback(dl_phdr_info* info, size_t size, void* data) {
+  PhdrCounts* counts = reinterpret_cast<PhdrCounts*>(data);
+  counts->size = size;
+  counts->adds = info->dlpi_adds;
+  counts->subs = info->dlpi_subs;
+  return 1;
+}
+
+TEST(dlfcn, dl_iterate_phdr_adds_subs) {
+  PhdrCounts before;
+  ASSERT_EQ(1, dl_iterate_phdr(GetPhdrCountsCallback, &before));
+  ASSERT_EQ(sizeof(dl_phdr_info), before.size);
+
+  void* handle = dlopen("libtest_dlsym_weak_func.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+  PhdrCounts loaded;
+  ASSERT_EQ(1, dl_iterate_phdr(GetPhdrCountsCallback, &loaded));
+  ASSERT_LT(before.adds, loaded.adds);
+  ASSERT_EQ(before.subs, loaded.subs);
+
+  ASSERT_EQ(0, dlclose(handle));
+  PhdrCounts unloaded;
+  ASSERT_EQ(1, dl_iterate_phdr(GetPhdrCountsCallback, &unloaded));
+  ASSERT_EQ(loaded.adds, unloaded.adds);
+  ASSERT_LT(loaded.subs, unloaded.subs);
+}
+
+static int DlopenDlclosePhdrCallback(dl_phdr_info*, size_t, void* data) {
+  // Unwinders and the like may load libraries from here.
+  void* handle = dlopen("libtest_dlsym_weak_func.so", RTLD_NOW);
+  if (handle == NULL || dlclose(handle) != 0) {
+    return -1;
+  }
+  ++*reinterpret_cast<size_t*>(data);
+  return 0;
+}
+
+TEST(dlfcn, dl_iterate_phdr_callback_dlopen_dlclose) {
+  size_t count = 0;
+  ASSERT_EQ(0, dl_iterate_phdr(DlopenDlclosePhdrCallback, &count));
+  ASSERT_NE(0U, count);
+}
+
+typedef int* (*ElfTlsIntFn)();
+
+static void* ElfTlsThreadFn(void* arg) {
+  int* p = reinterpret_cast<ElfTlsIntFn>(arg)();
+  // A new thread gets the initial value, whatever other threads have done.
+  if (*p != 42) {
+    return NULL;
+  }
+  *p = 1;
+  return p;
+}
+
+TEST(dlfcn, dlopen_elf_tls) {
+  void* handle = dlopen("libtest_elf_tls.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+  ElfTlsIntFn initialized =
+      reinterpret_cast<ElfTlsIntFn>(dlsym(handle, "dlopen_testlib_elf_tls_initialized"));
+  ASSERT_TRUE(initialized != NULL);
+  typedef char* (*ElfTlsCharFn)();
+  ElfTlsCharFn zeroed = reinterpret_cast<ElfTlsCharFn>(dlsym(handle, "dlopen_testlib_elf_tls_zeroed"));
+  ASSERT_TRUE(zeroed != NULL);
+  ElfTlsIntFn aligned =
+      reinterpret_cast<ElfTlsIntFn>(dlsym(handle, "dlopen_testlib_elf_tls_aligned"));
+  ASSERT_TRUE(aligned != NULL);
+
+  int* p = initialized();
+  ASSERT_EQ(42, *p);
+  ASSERT_EQ(p, initialized());
+  *p = 7;
+  char* z = zeroed();
+  for (size_t i = 0; i < 128; ++i) {
+    ASSERT_EQ(0, z[i]);
+  }
+  ASSERT_EQ(1, *aligned());
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(aligned()) % 64);
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ElfTlsThreadFn, reinterpret_cast<void*>(initialized)));
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_TRUE(result != NULL);
+  ASSERT_NE(p, result);
+  ASSERT_EQ(7, *p);
+
+  // Reloading the library starts from the initial values again.
+  ASSERT_EQ(0, dlclose(handle));
+  handle = dlopen("libtest_elf_tls.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+  initialized = reinterpret_cast<ElfTlsIntFn>(dlsym(handle, "dlopen_testlib_elf_tls_initialized"));
+  ASSERT_TRUE(initialized != NULL);
+  ASSERT_EQ(42, *initialized());
+  ASSERT_EQ(0, dlclose(handle));
+}
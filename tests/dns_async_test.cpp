@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/dns_async.h>
+#endif
+
+#include <netdb.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <vector>
+
+#if defined(__BIONIC__)
+// Waits for the channel's fd to poll readable, then collects one result.
+static bool WaitAndCollect(android_dns_channel_t* channel, android_dns_result* result) {
+  pollfd fds = { android_dns_channel_fd(channel), POLLIN, 0 };
+  if (poll(&fds, 1, 10000) != 1) {
+    return false;
+  }
+  return android_dns_collect(channel, result) == 1;
+}
+#endif
+
+TEST(dns_async, getaddrinfo) {
+#if defined(__BIONIC__)
+  android_dns_channel_t* channel = android_dns_channel_create(0, 0);
+  ASSERT_TRUE(channel != NULL);
+
+  android_dns_query_t* query = android_dns_getaddrinfo(channel, "localhost", "9999", NULL,
+                                                       reinterpret_cast<void*>(42));
+  ASSERT_TRUE(query != NULL);
+
+  android_dns_result result;
+  ASSERT_TRUE(WaitAndCollect(channel, &result));
+  ASSERT_EQ(query, result.query);
+  ASSERT_EQ(reinterpret_cast<void*>(42), result.user_data);
+  ASSERT_EQ(0, result.error);
+  ASSERT_TRUE(result.addrinfo != NULL);
+  freeaddrinfo(result.addrinfo);
+
+  // Nothing left, and the fd says so.
+  ASSERT_EQ(0, android_dns_collect(channel, &result));
+  pollfd fds = { android_dns_channel_fd(channel), POLLIN, 0 };
+  ASSERT_EQ(0, poll(&fds, 1, 0));
+
+  // Errors come back in the result.
+  ASSERT_TRUE(android_dns_getaddrinfo(channel, NULL, NULL, NULL, NULL) != NULL);
+  ASSERT_TRUE(WaitAndCollect(channel, &result));
+  ASSERT_EQ(EAI_NONAME, result.error);
+  ASSERT_TRUE(result.addrinfo == NULL);
+
+  android_dns_channel_destroy(channel);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(dns_async, many_queries) {
+#if defined(__BIONIC__)
+  // Far more queries than may run at once.
+  android_dns_channel_t* channel = android_dns_channel_create(0, 2);
+  ASSERT_TRUE(channel != NULL);
+
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_flags = AI_NUMERICHOST;
+  hints.ai_socktype = SOCK_STREAM;
+  const size_t kCount = 200;
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_TRUE(android_dns_getaddrinfo(channel, "127.0.0.1", NULL, &hints,
+                                        reinterpret_cast<void*>(i)) != NULL);
+  }
+
+  std::vector<int> seen(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    android_dns_result result;
+    ASSERT_TRUE(WaitAndCollect(channel, &result));
+    ASSERT_EQ(0, result.error);
+    ASSERT_EQ(SOCK_STREAM, result.addrinfo->ai_socktype);
+    ++seen[reinterpret_cast<uintptr_t>(result.user_data)];
+    freeaddrinfo(result.addrinfo);
+  }
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(1, seen[i]) << i;
+  }
+
+  android_dns_channel_destroy(channel);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(dns_async, cancel) {
+#if defined(__BIONIC__)
+  android_dns_channel_t* channel = android_dns_channel_create(0, 1);
+  ASSERT_TRUE(channel != NULL);
+
+  // Cancel every other query, whether it's queued, running or done.
+  const size_t kCount = 100;
+  std::vector<android_dns_query_t*> queries;
+  for (size_t i = 0; i < kCount; ++i) {
+    queries.push_back(android_dns_getaddrinfo(channel, "localhost", NULL, NULL,
+                                              reinterpret_cast<void*>(i)));
+    ASSERT_TRUE(queries.back() != NULL);
+  }
+  for (size_t i = 1; i < kCount; i += 2) {
+    android_dns_cancel(channel, queries[i]);
+  }
+
+  std::vector<int> seen(kCount);
+  for (size_t i = 0; i < kCount / 2; ++i) {
+    android_dns_result result;
+    ASSERT_TRUE(WaitAndCollect(channel, &result));
+    ++seen[reinterpret_cast<uintptr_t>(result.user_data)];
+    freeaddrinfo(result.addrinfo);
+  }
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ((i % 2 == 0) ? 1 : 0, seen[i]) << i;
+  }
+
+  android_dns_result result;
+  ASSERT_EQ(0, android_dns_collect(channel, &result));
+  android_dns_channel_destroy(channel);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(dns_async, destroy_with_queries_outstanding) {
+#if defined(__BIONIC__)
+  for (size_t i = 0; i < 20; ++i) {
+    android_dns_channel_t* channel = android_dns_channel_create(0, 4);
+    ASSERT_TRUE(channel != NULL);
+    for (size_t j = 0; j < 50; ++j) {
+      ASSERT_TRUE(android_dns_getaddrinfo(channel, "localhost", NULL, NULL, NULL) != NULL);
+    }
+    android_dns_channel_destroy(channel);
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
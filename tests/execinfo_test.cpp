@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "TemporaryFile.h"
+
+// Exported (the tests are linked with --export-dynamic) so that dladdr can
+// name it, and written so that the call to backtrace isn't a tail call.
+extern "C" __attribute__((noinline)) int ExecinfoTestFunction(void** frames, int size) {
+  volatile int frame_count = backtrace(frames, size);
+  return frame_count;
+}
+
+TEST(execinfo, backtrace) {
+  void* frames[64];
+  int frame_count = ExecinfoTestFunction(frames, 64);
+  ASSERT_GT(frame_count, 1);
+  ASSERT_LE(frame_count, 64);
+
+  // The innermost frame is our caller, not backtrace itself.
+  Dl_info info;
+  ASSERT_NE(0, dladdr(frames[0], &info));
+  ASSERT_STREQ("ExecinfoTestFunction", info.dli_sname);
+}
+
+TEST(execinfo, backtrace_limit) {
+  void* frames[2] = { NULL, NULL };
+  ASSERT_EQ(0, backtrace(frames, 0));
+  ASSERT_EQ(1, ExecinfoTestFunction(frames, 1));
+  ASSERT_TRUE(frames[0] != NULL);
+  ASSERT_TRUE(frames[1] == NULL);
+}
+
+TEST(execinfo, backtrace_symbols) {
+  void* frames[64];
+  int frame_count = ExecinfoTestFunction(frames, 64);
+  ASSERT_GT(frame_count, 1);
+
+  char** symbols = backtrace_symbols(frames, frame_count);
+  ASSERT_TRUE(symbols != NULL);
+  ASSERT_TRUE(strstr(symbols[0], "(ExecinfoTestFunction+0x") != NULL) << symbols[0];
+  for (int i = 0; i < frame_count; ++i) {
+    ASSERT_TRUE(symbols[i] != NULL);
+    ASSERT_EQ(']', symbols[i][strlen(symbols[i]) - 1]) << symbols[i];
+  }
+  free(symbols);
+}
+
+TEST(execinfo, backtrace_symbols_unknown_address) {
+  void* frames[] = { reinterpret_cast<void*>(0x1) };
+  char** symbols = backtrace_symbols(frames, 1);
+  ASSERT_TRUE(symbols != NULL);
+  ASSERT_STREQ("[0x1]", symbols[0]);
+  free(symbols);
+}
+
+TEST(execinfo, backtrace_symbols_fd) {
+  void* frames[64];
+  int frame_count = ExecinfoTestFunction(frames, 64);
+  ASSERT_GT(frame_count, 1);
+
+  TemporaryFile tf;
+  backtrace_symbols_fd(frames, frame_count, tf.fd);
+  ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_SET));
+
+  std::string output;
+  char buf[BUFSIZ];
+  ssize_t n;
+  while ((n = read(tf.fd, buf, sizeof(buf))) > 0) {
+    output.append(buf, n);
+  }
+  ASSERT_EQ(frame_count, std::count(output.begin(), output.end(), '\n'));
+  ASSERT_NE(std::string::npos, output.find("(ExecinfoTestFunction+0x")) << output;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/fast_clock.h>
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+static int64_t NanoTime(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+TEST(fast_clock, android_coarse_clocks) {
+#if defined(__BIONIC__)
+  timespec res;
+  ASSERT_EQ(0, clock_getres(CLOCK_MONOTONIC_COARSE, &res));
+  int64_t tick_ns = static_cast<int64_t>(res.tv_sec) * 1000000000LL + res.tv_nsec;
+
+  int64_t before = NanoTime(CLOCK_MONOTONIC_COARSE);
+  int64_t coarse = android_coarse_monotonic_ns();
+  int64_t after = NanoTime(CLOCK_MONOTONIC_COARSE);
+  ASSERT_LE(before, coarse);
+  ASSERT_LE(coarse, after);
+
+  before = NanoTime(CLOCK_REALTIME_COARSE);
+  coarse = android_coarse_realtime_ns();
+  ASSERT_LE(before - tick_ns, coarse);
+  ASSERT_LE(coarse, NanoTime(CLOCK_REALTIME_COARSE) + tick_ns);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(fast_clock, android_fast_clock_ns) {
+#if defined(__BIONIC__)
+  // Within a millisecond of CLOCK_MONOTONIC, allowing for calibration error.
+  for (int i = 0; i < 10; ++i) {
+    int64_t before = NanoTime(CLOCK_MONOTONIC);
+    int64_t fast = android_fast_clock_ns();
+    int64_t after = NanoTime(CLOCK_MONOTONIC);
+    ASSERT_LE(before - 1000000, fast);
+    ASSERT_LE(fast, after + 1000000);
+    usleep(10000);
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(fast_clock, android_fast_clock_ticks_to_ns_batch) {
+#if defined(__BIONIC__)
+  const size_t kCount = 64;
+  uint64_t ticks[kCount];
+  for (size_t i = 0; i < kCount; ++i) {
+    ticks[i] = android_fast_clock_ticks();
+  }
+
+  // The batch agrees with one at a time, and the stamps never go backwards.
+  int64_t ns[kCount];
+  android_fast_clock_ticks_to_ns_batch(ticks, ns, kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(android_fast_clock_ticks_to_ns(ticks[i]), ns[i]);
+    if (i > 0) {
+      ASSERT_LE(ns[i - 1], ns[i]);
+    }
+  }
+
+  // In place.
+  int64_t* in_place = reinterpret_cast<int64_t*>(ticks);
+  android_fast_clock_ticks_to_ns_batch(ticks, in_place, kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(ns[i], in_place[i]);
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
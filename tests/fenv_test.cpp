@@ -83,3 +83,56 @@ TEST(fenv, feclearexcept_fetestexcept) {
 TEST(fenv, FE_DFL_ENV_macro) {
   ASSERT_EQ(0, fesetenv(FE_DFL_ENV));
 }
+
+TEST(fenv, feholdexcept_feupdateenv) {
+  // Start with FE_DIVBYZERO raised and rounding towards zero.
+  fesetround(FE_TOWARDZERO);
+  feclearexcept(FE_ALL_EXCEPT);
+  DivideByZero();
+
+  // feholdexcept saves the environment and clears the exceptions...
+  fenv_t env;
+  ASSERT_EQ(0, feholdexcept(&env));
+  ASSERT_EQ(0, fetestexcept(FE_ALL_EXCEPT));
+  ASSERT_EQ(FE_TOWARDZERO, fegetround());
+
+  // ...so exceptions raised now are the kernel's own...
+  fesetround(FE_UPWARD);
+  volatile float big = 0x1p127f;
+  volatile float result __attribute__((unused)) = big * big;
+  ASSERT_TRUE((fetestexcept(FE_ALL_EXCEPT) & FE_OVERFLOW) != 0);
+  ASSERT_TRUE((fetestexcept(FE_ALL_EXCEPT) & FE_DIVBYZERO) == 0);
+
+  // ...and feupdateenv restores the rounding mode and adds them to the saved ones.
+  ASSERT_EQ(0, feupdateenv(&env));
+  ASSERT_EQ(FE_TOWARDZERO, fegetround());
+  ASSERT_TRUE((fetestexcept(FE_ALL_EXCEPT) & FE_OVERFLOW) != 0);
+  ASSERT_TRUE((fetestexcept(FE_ALL_EXCEPT) & FE_DIVBYZERO) != 0);
+
+  fesetround(FE_TONEAREST);
+  feclearexcept(FE_ALL_EXCEPT);
+}
+
+TEST(fenv, fegetenv_fesetenv) {
+  fesetround(FE_DOWNWARD);
+  feclearexcept(FE_ALL_EXCEPT);
+  DivideByZero();
+  fenv_t env;
+  ASSERT_EQ(0, fegetenv(&env));
+
+  // Setting the same environment again changes nothing.
+  ASSERT_EQ(0, fesetenv(&env));
+  ASSERT_EQ(FE_DOWNWARD, fegetround());
+  ASSERT_EQ(FE_DIVBYZERO, fetestexcept(FE_ALL_EXCEPT));
+
+  // Setting a different one replaces both the mode and the exceptions.
+  ASSERT_EQ(0, fesetenv(FE_DFL_ENV));
+  ASSERT_EQ(FE_TONEAREST, fegetround());
+  ASSERT_EQ(0, fetestexcept(FE_ALL_EXCEPT));
+
+  ASSERT_EQ(0, fesetenv(&env));
+  ASSERT_EQ(FE_DOWNWARD, fegetround());
+  ASSERT_EQ(FE_DIVBYZERO, fetestexcept(FE_ALL_EXCEPT));
+
+  fesetenv(FE_DFL_ENV);
+}
@@ -18,6 +18,8 @@
 #include <features.h>
 #include <gtest/gtest.h>
 
+#include <stdio.h>
+
 // getauxval() was only added as of glibc version 2.16.
 // See: http://lwn.net/Articles/519085/
 // Don't try to compile this code on older glibc versions.
@@ -59,3 +61,22 @@ TEST(getauxval, unexpected_values) {
   GTEST_LOG_(INFO) << "This test does nothing.\n";
 #endif
 }
+
+TEST(getauxval, matches_proc_self_auxv) {
+#if defined(__BIONIC__)
+  // However getauxval finds them, it should agree with what the kernel passed.
+  // (glibc substitutes its own AT_HWCAP on x86.)
+  FILE* fp = fopen("/proc/self/auxv", "re");
+  ASSERT_TRUE(fp != NULL);
+  unsigned long int entry[2];
+  size_t count = 0;
+  while (fread(entry, sizeof(entry), 1, fp) == 1 && entry[0] != AT_NULL) {
+    ASSERT_EQ(entry[1], getauxval(entry[0])) << entry[0];
+    ++count;
+  }
+  fclose(fp);
+  ASSERT_NE(0U, count);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -28,13 +28,13 @@ common_additional_dependencies := \
 # Library used by dlfcn tests.
 # -----------------------------------------------------------------------------
 ifneq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),mips mips64))
-no-elf-hash-table-library_src_files := \
-    empty.cpp \
+libgnu-hash-table-library_src_files := \
+    dlext_test_library.cpp \
 
-no-elf-hash-table-library_ldflags := \
+libgnu-hash-table-library_ldflags := \
     -Wl,--hash-style=gnu \
 
-module := no-elf-hash-table-library
+module := libgnu-hash-table-library
 module_tag := optional
 include $(LOCAL_PATH)/Android.build.testlib.mk
 endif
@@ -325,3 +325,30 @@ libtest_dlsym_weak_func_src_files := \
 
 module := libtest_dlsym_weak_func
 include $(LOCAL_PATH)/Android.build.testlib.mk
+
+# -----------------------------------------------------------------------------
+# Library whose constructor blocks until the test releases it
+# -----------------------------------------------------------------------------
+libtest_dlopen_slow_ctor_src_files := \
+    dlopen_testlib_slow_ctor.cpp
+
+module := libtest_dlopen_slow_ctor
+include $(LOCAL_PATH)/Android.build.testlib.mk
+
+# -----------------------------------------------------------------------------
+# Library whose constructor leaves a trace in the environment
+# -----------------------------------------------------------------------------
+libdlext_test_deferred_ctor_src_files := \
+    dlext_testlib_deferred_ctor.cpp
+
+module := libdlext_test_deferred_ctor
+include $(LOCAL_PATH)/Android.build.testlib.mk
+
+# -----------------------------------------------------------------------------
+# Library with thread-local variables
+# -----------------------------------------------------------------------------
+libtest_elf_tls_src_files := \
+    dlopen_testlib_elf_tls.cpp
+
+module := libtest_elf_tls
+include $(LOCAL_PATH)/Android.build.testlib.mk
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdlib.h>
+
+// Records that the constructor ran somewhere the test can see without
+// looking up a symbol in this library (which would run the constructor).
+static void __attribute__((constructor)) record_constructor() {
+  setenv("DLEXT_TESTLIB_DEFERRED_CTOR_RAN", "1", 1);
+}
+
+extern "C" int dlext_testlib_deferred_ctor_fn() {
+  return 42;
+}
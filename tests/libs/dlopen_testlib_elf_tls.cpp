@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+// Thread-local variables in a dlopen()ed library, so reached through
+// __tls_get_addr (or TLS descriptors) rather than static TLS.
+static __thread int tls_initialized = 42;
+static __thread char tls_zeroed[128];
+static __thread int tls_aligned __attribute__((aligned(64))) = 1;
+
+extern "C" int* dlopen_testlib_elf_tls_initialized() {
+  return &tls_initialized;
+}
+
+extern "C" char* dlopen_testlib_elf_tls_zeroed() {
+  return tls_zeroed;
+}
+
+extern "C" int* dlopen_testlib_elf_tls_aligned() {
+  return &tls_aligned;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+// Blocks in its constructor until a byte can be read from the pipe named by
+// DLOPEN_TESTLIB_SLOW_CTOR_FD, so the test can observe the linker mid-dlopen.
+static void __attribute__((constructor)) wait_for_release() {
+  const char* fd = getenv("DLOPEN_TESTLIB_SLOW_CTOR_FD");
+  if (fd != nullptr) {
+    char c;
+    read(atoi(fd), &c, 1);
+  }
+}
+
+extern "C" int dlopen_testlib_slow_ctor_fn() {
+  return 42;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <link.h>
+
+// Reports whether the object 'info' describes has 'address' (a pointer to an
+// ElfW(Addr)) in one of its loaded segments.
+static int ContainsAddress(dl_phdr_info* info, size_t, void* data) {
+  ElfW(Addr) address = *reinterpret_cast<ElfW(Addr)*>(data);
+  for (size_t i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    ElfW(Addr) start = info->dlpi_addr + phdr.p_vaddr;
+    if (phdr.p_type == PT_LOAD && address >= start && address < start + phdr.p_memsz) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+TEST(link, dl_iterate_phdr_finds_code) {
+  // This is how unwinders find the code they're unwinding, wherever it was
+  // loaded: static-PIE executables too.
+  ElfW(Addr) address = reinterpret_cast<ElfW(Addr)>(&ContainsAddress);
+  ASSERT_EQ(1, dl_iterate_phdr(ContainsAddress, &address));
+}
+
+// The dynamic linker only supports IFUNCs on these, and so does gcc.
+#if defined(__aarch64__) || defined(__i386__) || defined(__x86_64__)
+static int answer_impl() {
+  return 42;
+}
+
+typedef int (*answer_fn)();
+
+extern "C" answer_fn resolve_answer() {
+  return answer_impl;
+}
+
+static int answer() __attribute__((ifunc("resolve_answer")));
+#endif
+
+TEST(link, ifunc) {
+#if defined(__aarch64__) || defined(__i386__) || defined(__x86_64__)
+  // In a static executable, it's libc's startup rather than the dynamic
+  // linker that resolved this.
+  ASSERT_EQ(42, answer());
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <locale.h>
+#include <pthread.h>
 
 TEST(locale, localeconv) {
   EXPECT_STREQ(".", localeconv()->decimal_point);
@@ -123,3 +124,29 @@ TEST(locale, mb_cur_max) {
   freelocale(cloc);
   freelocale(cloc_utf8);
 }
+
+static void* UseLocaleThreadFn(void* arg) {
+  // A new thread starts with the global locale, whatever its creator uses.
+  EXPECT_EQ(LC_GLOBAL_LOCALE, uselocale(NULL));
+  uselocale(reinterpret_cast<locale_t>(arg));
+  EXPECT_EQ(1U, MB_CUR_MAX);
+  return NULL;
+}
+
+TEST(locale, uselocale_is_per_thread) {
+  locale_t cloc = newlocale(LC_ALL, "C", 0);
+  locale_t cloc_utf8 = newlocale(LC_ALL, "C.UTF-8", 0);
+
+  locale_t old_locale = uselocale(cloc_utf8);
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, UseLocaleThreadFn, cloc));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  // The other thread's uselocale(3) didn't touch ours.
+  ASSERT_EQ(cloc_utf8, uselocale(NULL));
+  ASSERT_EQ(4U, MB_CUR_MAX);
+
+  uselocale(old_locale);
+  freelocale(cloc);
+  freelocale(cloc_utf8);
+}
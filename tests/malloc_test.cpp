@@ -16,10 +16,14 @@
 
 #include <gtest/gtest.h>
 
+#include <errno.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "private/bionic_config.h"
@@ -108,6 +112,80 @@ TEST(malloc, posix_memalign_overflow) {
   ASSERT_NE(0, posix_memalign(&ptr, 16, SIZE_MAX));
 }
 
+TEST(malloc, aligned_alloc) {
+  for (size_t align = 1; align <= 4096; align <<= 1) {
+    void* ptr = aligned_alloc(align, 100);
+    ASSERT_TRUE(ptr != NULL) << "Failed at align " << align;
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % align) << "Failed at align " << align;
+    ASSERT_LE(100U, malloc_usable_size(ptr));
+    free(ptr);
+  }
+}
+
+TEST(malloc, aligned_alloc_non_power2) {
+#if defined(__BIONIC__)
+  errno = 0;
+  ASSERT_EQ(NULL, aligned_alloc(17, 1024));
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_EQ(NULL, aligned_alloc(0, 1024));
+  ASSERT_EQ(EINVAL, errno);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(malloc, aligned_alloc_overflow) {
+  ASSERT_EQ(NULL, aligned_alloc(16, SIZE_MAX));
+}
+
+TEST(malloc, android_malloc_huge) {
+#if defined(__BIONIC__)
+  const size_t kHugePageSize = 2 * 1024 * 1024;
+  void* ptr = android_malloc_huge(1);
+  ASSERT_TRUE(ptr != NULL);
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % kHugePageSize);
+  memset(ptr, 'x', kHugePageSize);
+  android_free_huge(ptr);
+
+  ptr = android_malloc_huge(3 * kHugePageSize + 1);
+  ASSERT_TRUE(ptr != NULL);
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % kHugePageSize);
+  memset(ptr, 'y', 4 * kHugePageSize);
+  android_free_huge(ptr);
+
+  android_free_huge(NULL);
+
+  errno = 0;
+  ASSERT_EQ(NULL, android_malloc_huge(SIZE_MAX));
+  ASSERT_EQ(ENOMEM, errno);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(malloc, android_malloc_huge_reuse) {
+#if defined(__BIONIC__)
+  const size_t kSize = 4 * 1024 * 1024;
+  malloc_trim(0);
+  void* ptr = android_malloc_huge(kSize);
+  ASSERT_TRUE(ptr != NULL);
+  android_free_huge(ptr);
+  // A freed region of the same size comes straight back...
+  void* again = android_malloc_huge(kSize);
+  ASSERT_EQ(ptr, again);
+  android_free_huge(again);
+  // ...but one much bigger than needed doesn't.
+  void* small = android_malloc_huge(1);
+  ASSERT_TRUE(small != NULL);
+  ASSERT_NE(ptr, small);
+  android_free_huge(small);
+  malloc_trim(0);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(malloc, memalign_realloc) {
   // Memalign and then realloc the pointer a couple of times.
   for (size_t alignment = 1; alignment <= 4096; alignment <<= 1) {
@@ -293,6 +371,293 @@ TEST(malloc, realloc_overflow) {
   free(ptr);
 }
 
+TEST(malloc, realloc_large_doubling) {
+  // Blocks this big are mmapped, and grown by moving their pages rather than
+  // by copying them. Either way their contents have to come along.
+  char* ptr = NULL;
+  size_t old_size = 0;
+  for (size_t size = 4096; size <= 64 * 1024 * 1024; size *= 2) {
+    ptr = reinterpret_cast<char*>(realloc(ptr, size));
+    ASSERT_TRUE(ptr != NULL);
+    ASSERT_LE(size, malloc_usable_size(ptr));
+    for (size_t i = 0; i < old_size; i += 4096) {
+      ASSERT_EQ(static_cast<char>(i / 4096), ptr[i]);
+    }
+    if (old_size != 0) {
+      ASSERT_EQ(static_cast<char>(0xa5), ptr[old_size - 1]);
+    }
+    for (size_t i = old_size; i < size; i += 4096) {
+      ptr[i] = static_cast<char>(i / 4096);
+    }
+    ptr[size - 1] = static_cast<char>(0xa5);
+    old_size = size;
+  }
+  free(ptr);
+}
+
+TEST(malloc, calloc_large_zeroed) {
+  for (size_t size = 64 * 1024; size <= 4 * 1024 * 1024; size *= 2) {
+    void* dirty = malloc(size);
+    ASSERT_TRUE(dirty != NULL);
+    memset(dirty, 0xa5, size);
+    free(dirty);
+    char* ptr = reinterpret_cast<char*>(calloc(1, size));
+    ASSERT_TRUE(ptr != NULL);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(0, ptr[i]);
+    }
+    free(ptr);
+  }
+}
+
+TEST(malloc, calloc_reuses_freed_memory_zeroed) {
+  // Small blocks are recycled through a per-thread cache; calloc must still clear them.
+  for (size_t size = 1; size <= 256; ++size) {
+    void* dirty = malloc(size);
+    ASSERT_TRUE(dirty != NULL);
+    memset(dirty, 0xa5, malloc_usable_size(dirty));
+    free(dirty);
+    char* ptr = reinterpret_cast<char*>(calloc(1, size));
+    ASSERT_TRUE(ptr != NULL);
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_EQ(0, ptr[i]);
+    }
+    free(ptr);
+  }
+}
+
+static void* malloc_free_small_blocks(void* arg) {
+  void** blocks = reinterpret_cast<void**>(arg);
+  for (size_t i = 0; i < 1024; ++i) {
+    size_t size = i % 200;
+    blocks[i] = malloc(size);
+    if (blocks[i] == NULL || malloc_usable_size(blocks[i]) < size) {
+      return blocks;
+    }
+    memset(blocks[i], 0xa5, size);
+    // Free half here, and leave the other half for another thread to free.
+    if (i % 2 == 0) {
+      free(blocks[i]);
+      blocks[i] = NULL;
+    }
+  }
+  return NULL;
+}
+
+TEST(malloc, small_blocks_freed_by_other_threads) {
+  static const size_t kThreadCount = 8;
+  void* blocks[kThreadCount][1024];
+  for (size_t round = 0; round < 16; ++round) {
+    pthread_t threads[kThreadCount];
+    for (size_t i = 0; i < kThreadCount; ++i) {
+      ASSERT_EQ(0, pthread_create(&threads[i], NULL, malloc_free_small_blocks, blocks[i]));
+    }
+    for (size_t i = 0; i < kThreadCount; ++i) {
+      void* result;
+      ASSERT_EQ(0, pthread_join(threads[i], &result));
+      ASSERT_EQ(NULL, result);
+    }
+    for (size_t i = 0; i < kThreadCount; ++i) {
+      for (size_t j = 0; j < 1024; ++j) {
+        free(blocks[i][j]);
+      }
+    }
+  }
+}
+
+TEST(malloc, free_sized) {
+#if defined(__BIONIC__)
+  ASSERT_NO_FATAL_FAILURE(free_sized(NULL, 0));
+  // Blocks freed with their sizes go back into use, and must still be big enough.
+  for (size_t round = 0; round < 4; ++round) {
+    void* ptrs[512];
+    for (size_t size = 0; size < 512; ++size) {
+      ptrs[size] = malloc(size);
+      ASSERT_TRUE(ptrs[size] != NULL);
+      ASSERT_LE(size, malloc_usable_size(ptrs[size]));
+      memset(ptrs[size], 0xa5, size);
+    }
+    for (size_t size = 0; size < 512; ++size) {
+      free_sized(ptrs[size], size);
+    }
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(malloc, free_sized_calloc_realloc) {
+#if defined(__BIONIC__)
+  for (size_t size = 1; size < 256; ++size) {
+    void* ptr = calloc(1, size);
+    ASSERT_TRUE(ptr != NULL);
+    free_sized(ptr, size);
+
+    ptr = malloc(256);
+    ASSERT_TRUE(ptr != NULL);
+    ptr = realloc(ptr, size);
+    ASSERT_TRUE(ptr != NULL);
+    free_sized(ptr, size);
+
+    ptr = malloc(size);
+    ASSERT_TRUE(ptr != NULL);
+    ASSERT_LE(size, malloc_usable_size(ptr));
+    memset(ptr, 0xa5, size);
+    free(ptr);
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(malloc, malloc_info) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(0, malloc_info(0, fp));
+  ASSERT_GT(ftell(fp), 0);
+  fclose(fp);
+
+  errno = 0;
+  ASSERT_EQ(-1, malloc_info(1, stdout));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+struct IterateState {
+  uintptr_t wanted;
+  size_t size;
+  size_t count;
+};
+
+static IterateState g_iterate_state;
+
+static void iterate_callback(uintptr_t base, size_t size, void*) {
+  g_iterate_state.count++;
+  if (base == g_iterate_state.wanted) {
+    g_iterate_state.size = size;
+  }
+}
+
+TEST(malloc, malloc_iterate) {
+  void* ptr = malloc(1000);
+  ASSERT_TRUE(ptr != NULL);
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+
+  g_iterate_state.wanted = address;
+  g_iterate_state.size = 0;
+  g_iterate_state.count = 0;
+  malloc_disable();
+  int result = malloc_iterate(address, 1, iterate_callback, NULL);
+  int saved_errno = errno;
+  malloc_enable();
+
+  if (result == -1) {
+    // Not every allocator can be walked.
+    ASSERT_EQ(ENOTSUP, saved_errno);
+  } else {
+    ASSERT_EQ(0, result);
+    ASSERT_EQ(1U, g_iterate_state.count);
+    ASSERT_EQ(malloc_usable_size(ptr), g_iterate_state.size);
+  }
+  free(ptr);
+}
+
+TEST(malloc, malloc_trim) {
+  // Free every other block so that the free space can't all merge into the top of the heap.
+  static const size_t kBlockCount = 64;
+  static const size_t kBlockSize = 32 * 1024;
+  char* blocks[kBlockCount];
+  for (size_t i = 0; i < kBlockCount; ++i) {
+    blocks[i] = reinterpret_cast<char*>(malloc(kBlockSize));
+    ASSERT_TRUE(blocks[i] != NULL);
+    memset(blocks[i], i, kBlockSize);
+  }
+  for (size_t i = 0; i < kBlockCount; i += 2) {
+    free(blocks[i]);
+  }
+
+  ASSERT_EQ(1, malloc_trim(0));
+
+  // The blocks still in use are untouched.
+  for (size_t i = 1; i < kBlockCount; i += 2) {
+    for (size_t j = 0; j < kBlockSize; ++j) {
+      ASSERT_EQ(static_cast<char>(i), blocks[i][j]);
+    }
+    free(blocks[i]);
+  }
+}
+
+TEST(malloc, mallopt_purge) {
+  void* ptr = malloc(1024 * 1024);
+  ASSERT_TRUE(ptr != NULL);
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_PURGE, 0));
+}
+
+TEST(malloc, mallopt_thread_cache) {
+  int disabled = mallopt(M_THREAD_CACHE, 0);
+  void* ptrs[64];
+  for (size_t i = 0; i < 64; ++i) {
+    ptrs[i] = malloc(i + 1);
+    ASSERT_TRUE(ptrs[i] != NULL);
+  }
+  for (size_t i = 0; i < 64; ++i) {
+    free(ptrs[i]);
+  }
+  ASSERT_EQ(disabled, mallopt(M_THREAD_CACHE, 1));
+}
+
+TEST(malloc, mallopt_segregate_on_fork) {
+  ASSERT_EQ(1, mallopt(M_SEGREGATE_ON_FORK, 1));
+  char* parent_ptrs[64];
+  for (size_t i = 0; i < 64; ++i) {
+    parent_ptrs[i] = reinterpret_cast<char*>(malloc(i * 64 + 1));
+    ASSERT_TRUE(parent_ptrs[i] != NULL);
+    memset(parent_ptrs[i], 'p', i * 64 + 1);
+  }
+  // Free some first, so that the child has holes it could have reused.
+  for (size_t i = 0; i < 64; i += 2) {
+    free(parent_ptrs[i]);
+  }
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid) << strerror(errno);
+  if (pid == 0) {
+    // The parent's blocks are still there, and can be reallocated and freed.
+    for (size_t i = 1; i < 64; i += 2) {
+      if (parent_ptrs[i][i * 64] != 'p') {
+        _exit(1);
+      }
+      char* ptr = reinterpret_cast<char*>(realloc(parent_ptrs[i], i * 64 + 2));
+      if (ptr == NULL || ptr[i * 64] != 'p') {
+        _exit(2);
+      }
+      free(ptr);
+    }
+    for (size_t i = 0; i < 64; ++i) {
+      char* ptr = reinterpret_cast<char*>(malloc(i * 64 + 1));
+      if (ptr == NULL) {
+        _exit(3);
+      }
+      memset(ptr, 'c', i * 64 + 1);
+      free(ptr);
+    }
+    _exit(0);
+  }
+
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  for (size_t i = 1; i < 64; i += 2) {
+    free(parent_ptrs[i]);
+  }
+  ASSERT_EQ(1, mallopt(M_SEGREGATE_ON_FORK, 0));
+}
+
+TEST(malloc, mallopt_unknown) {
+  ASSERT_EQ(0, mallopt(12345, 0));
+}
+
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 extern "C" void* pvalloc(size_t);
 extern "C" void* valloc(size_t);
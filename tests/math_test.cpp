@@ -52,6 +52,7 @@ template<typename T> inline int test_capture_isinf(const T in) {
 #include <float.h>
 #include <limits.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <private/ScopeGuard.h>
 
@@ -371,10 +372,23 @@ TEST(math, atan2l) {
 
 TEST(math, cos) {
   ASSERT_DOUBLE_EQ(1.0, cos(0.0));
+  ASSERT_DOUBLE_EQ(0x1.1ff026793f1bbp-1, cos(1000.0));
+  // Arguments too big for the usual reduction.
+  ASSERT_DOUBLE_EQ(0x1.0be2cef01c8f4p-1, cos(1e22));
+  ASSERT_DOUBLE_EQ(0x1.f9785160c8815p-1, cos(0x1p1000));
+  ASSERT_DOUBLE_EQ(-0x1.fffe62ecfab75p-1, cos(-DBL_MAX));
+  // The double closest to a multiple of pi/2.
+  ASSERT_DOUBLE_EQ(-0x1.14ae72e6ba22fp-61, cos(0x1.6ac5b262ca1ffp+849));
+  ASSERT_TRUE(isnan(cos(HUGE_VAL)));
 }
 
 TEST(math, cosf) {
   ASSERT_FLOAT_EQ(1.0f, cosf(0.0f));
+  ASSERT_FLOAT_EQ(0x1.b981dcp-1f, cosf(100.0f));
+  // Arguments too big for the usual reduction.
+  ASSERT_FLOAT_EQ(0x1.f4eb4p-2f, cosf(0x1p100f));
+  ASSERT_FLOAT_EQ(-0x1.efeaf8p-2f, cosf(-0x1.c363ccp+127f));
+  ASSERT_TRUE(isnanf(cosf(HUGE_VALF)));
 }
 
 TEST(math, cosl) {
@@ -383,10 +397,73 @@ TEST(math, cosl) {
 
 TEST(math, sin) {
   ASSERT_DOUBLE_EQ(0.0, sin(0.0));
+  ASSERT_TRUE(signbit(sin(-0.0)));
+  ASSERT_DOUBLE_EQ(0x1.a75cc150a206bp-1, sin(1000.0));
+  // Arguments too big for the usual reduction.
+  ASSERT_DOUBLE_EQ(-0x1.b453ab76bf397p-1, sin(1e22));
+  ASSERT_DOUBLE_EQ(-0x1.460b8ae1c886ep-3, sin(0x1p1000));
+  ASSERT_DOUBLE_EQ(-0x1.452fc98b34e97p-8, sin(-DBL_MAX));
+  ASSERT_TRUE(isnan(sin(-HUGE_VAL)));
+}
+
+TEST(math, sincos) {
+  double s, c;
+  sincos(0.0, &s, &c);
+  ASSERT_DOUBLE_EQ(0.0, s);
+  ASSERT_DOUBLE_EQ(1.0, c);
+  // sincos uses the same kernels as sin and cos, so the results are identical.
+  const double values[] = { 1e-10, 0.5, -2.0, 1000.0, 1e22, -0x1p1000, DBL_MAX };
+  for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); ++i) {
+    sincos(values[i], &s, &c);
+    ASSERT_EQ(sin(values[i]), s) << values[i];
+    ASSERT_EQ(cos(values[i]), c) << values[i];
+  }
+  sincos(nan(""), &s, &c);
+  ASSERT_TRUE(isnan(s));
+  ASSERT_TRUE(isnan(c));
+}
+
+TEST(math, sincosf) {
+  float s, c;
+  sincosf(-0.0f, &s, &c);
+  ASSERT_TRUE(signbit(s));
+  ASSERT_FLOAT_EQ(1.0f, c);
+  // sincosf shares sinf's and cosf's kernels, so the results are identical.
+  const float values[] = { 1e-10f, 0.5f, -2.0f, 100.0f, 0x1p100f, -0x1.c363ccp+127f, FLT_MAX };
+  for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); ++i) {
+    sincosf(values[i], &s, &c);
+    ASSERT_EQ(sinf(values[i]), s) << values[i];
+    ASSERT_EQ(cosf(values[i]), c) << values[i];
+  }
+  sincosf(HUGE_VALF, &s, &c);
+  ASSERT_TRUE(isnanf(s));
+  ASSERT_TRUE(isnanf(c));
+}
+
+TEST(math, sincosl) {
+  long double s, c;
+  sincosl(0.0L, &s, &c);
+  ASSERT_DOUBLE_EQ(0.0L, s);
+  ASSERT_DOUBLE_EQ(1.0L, c);
+  const long double values[] = { 1e-10L, 0.5L, -2.0L, 1000.0L, 1e22L, LDBL_MAX };
+  for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); ++i) {
+    sincosl(values[i], &s, &c);
+    ASSERT_DOUBLE_EQ(sinl(values[i]), s) << static_cast<double>(values[i]);
+    ASSERT_DOUBLE_EQ(cosl(values[i]), c) << static_cast<double>(values[i]);
+  }
+  sincosl(nanl(""), &s, &c);
+  ASSERT_TRUE(__isnanl(s));
+  ASSERT_TRUE(__isnanl(c));
 }
 
 TEST(math, sinf) {
   ASSERT_FLOAT_EQ(0.0f, sinf(0.0f));
+  ASSERT_TRUE(signbit(sinf(-0.0f)));
+  ASSERT_FLOAT_EQ(-0x1.03425cp-1f, sinf(100.0f));
+  // Arguments too big for the usual reduction.
+  ASSERT_FLOAT_EQ(-0x1.be8edap-1f, sinf(0x1p100f));
+  ASSERT_FLOAT_EQ(-0x1.bff388p-1f, sinf(-0x1.c363ccp+127f));
+  ASSERT_TRUE(isnanf(sinf(-HUGE_VALF)));
 }
 
 TEST(math, sinl) {
@@ -395,6 +472,12 @@ TEST(math, sinl) {
 
 TEST(math, tan) {
   ASSERT_DOUBLE_EQ(0.0, tan(0.0));
+  ASSERT_DOUBLE_EQ(0x1.786729f34311ap+0, tan(1000.0));
+  // Arguments too big for the usual reduction.
+  ASSERT_DOUBLE_EQ(-0x1.a0f79c1b6b257p+0, tan(1e22));
+  ASSERT_DOUBLE_EQ(0x1.4530cfe729484p-8, tan(-DBL_MAX));
+  ASSERT_DOUBLE_EQ(-0x1.d9ba9a7975636p+60, tan(0x1.6ac5b262ca1ffp+849));
+  ASSERT_TRUE(isnan(tan(HUGE_VAL)));
 }
 
 TEST(math, tanf) {
@@ -483,6 +566,11 @@ TEST(math, log) {
 
 TEST(math, logf) {
   ASSERT_FLOAT_EQ(1.0f, logf(static_cast<float>(M_E)));
+  ASSERT_FLOAT_EQ(0.0f, logf(1.0f));
+  ASSERT_FLOAT_EQ(-0x1.842994p+6f, logf(0x1p-140f));
+  ASSERT_EQ(-HUGE_VALF, logf(0.0f));
+  ASSERT_EQ(HUGE_VALF, logf(HUGE_VALF));
+  ASSERT_TRUE(isnanf(logf(-1.0f)));
 }
 
 TEST(math, logl) {
@@ -545,6 +633,11 @@ TEST(math, exp) {
 TEST(math, expf) {
   ASSERT_FLOAT_EQ(1.0f, expf(0.0f));
   ASSERT_FLOAT_EQ(static_cast<float>(M_E), expf(1.0f));
+  ASSERT_FLOAT_EQ(0x1.ffff08p+127f, expf(0x1.62e42ep6f));
+  ASSERT_EQ(HUGE_VALF, expf(0x1.62e430p6f));
+  ASSERT_EQ(0.0f, expf(-0x1.9fe36ap6f));
+  ASSERT_EQ(0.0f, expf(-HUGE_VALF));
+  ASSERT_EQ(HUGE_VALF, expf(HUGE_VALF));
 }
 
 TEST(math, expl) {
@@ -581,6 +674,19 @@ TEST(math, pow) {
   ASSERT_DOUBLE_EQ(1.0, (pow(1.0, nan(""))));
   ASSERT_TRUE(isnan(pow(2.0, nan(""))));
   ASSERT_DOUBLE_EQ(8.0, pow(2.0, 3.0));
+  ASSERT_DOUBLE_EQ(1.0, pow(nan(""), 0.0));
+  ASSERT_DOUBLE_EQ(-8.0, pow(-2.0, 3.0));
+  ASSERT_TRUE(isnan(pow(-2.0, 0.5)));
+  ASSERT_DOUBLE_EQ(1.0, pow(-1.0, HUGE_VAL));
+  ASSERT_EQ(-HUGE_VAL, pow(-0.0, -3.0));
+  ASSERT_EQ(HUGE_VAL, pow(10.0, 309.0));
+  ASSERT_DOUBLE_EQ(0x1.56e1fc2f8f359p-997, pow(10.0, -300.0));
+  ASSERT_DOUBLE_EQ(0x1.ee23904251a5ap+761, pow(0x1.0168ca6d93db2p+0, 0x1.77c68b71840c2p+16));
+  // Subnormal results.
+  ASSERT_EQ(0x1p-1074, pow(2.0, -1074.0));
+  ASSERT_EQ(0x0.b504f333f9de6p-1022, pow(0.5, 1022.5));
+  ASSERT_EQ(0.0, pow(2.0, -1076.0));
+  ASSERT_TRUE(signbit(pow(-2.0, -1075.0)));
 }
 
 TEST(math, powf) {
@@ -588,6 +694,19 @@ TEST(math, powf) {
   ASSERT_FLOAT_EQ(1.0f, (powf(1.0f, nanf(""))));
   ASSERT_TRUE(isnanf(powf(2.0f, nanf(""))));
   ASSERT_FLOAT_EQ(8.0f, powf(2.0f, 3.0f));
+  ASSERT_FLOAT_EQ(1.0f, powf(nanf(""), 0.0f));
+  ASSERT_FLOAT_EQ(-8.0f, powf(-2.0f, 3.0f));
+  ASSERT_FLOAT_EQ(0.25f, powf(-2.0f, -2.0f));
+  ASSERT_TRUE(isnanf(powf(-2.0f, 0.5f)));
+  ASSERT_FLOAT_EQ(1.0f, powf(-1.0f, HUGE_VALF));
+  ASSERT_EQ(0.0f, powf(0.5f, HUGE_VALF));
+  ASSERT_EQ(HUGE_VALF, powf(0.5f, -HUGE_VALF));
+  ASSERT_EQ(-HUGE_VALF, powf(-0.0f, -3.0f));
+  ASSERT_EQ(HUGE_VALF, powf(0.0f, -0.5f));
+  ASSERT_TRUE(signbit(powf(-HUGE_VALF, -3.0f)));
+  ASSERT_FLOAT_EQ(0x1p-70f, powf(0x1p-140f, 0.5f));
+  ASSERT_EQ(HUGE_VALF, powf(10.0f, 39.0f));
+  ASSERT_EQ(0.0f, powf(10.0f, -46.0f));
 }
 
 TEST(math, powl) {
@@ -595,6 +714,19 @@ TEST(math, powl) {
   ASSERT_DOUBLE_EQ(1.0L, (powl(1.0L, nanl(""))));
   ASSERT_TRUE(__isnanl(powl(2.0L, nanl(""))));
   ASSERT_DOUBLE_EQ(8.0L, powl(2.0L, 3.0L));
+  ASSERT_DOUBLE_EQ(-8.0L, powl(-2.0L, 3.0L));
+  ASSERT_TRUE(__isnanl(powl(-2.0L, 0.5L)));
+  ASSERT_DOUBLE_EQ(1.0L, powl(-1.0L, HUGE_VALL));
+  ASSERT_TRUE(signbit(powl(-0.0L, 3.0L)));
+  ASSERT_EQ(-HUGE_VALL, powl(-0.0L, -3.0L));
+  ASSERT_EQ(HUGE_VALL, powl(2.0L, 20000.0L));
+  ASSERT_EQ(0.0L, powl(2.0L, -20000.0L));
+
+  // Where long double is wider than double, the result should be too.
+  long double three_to_70 = 2503155504993241601315571986085849.0L;
+  ASSERT_LE(fabsl(powl(3.0L, 70.0L) - three_to_70), three_to_70 * LDBL_EPSILON);
+  ASSERT_LE(fabsl(powl(2.0L, 0.5L) - sqrtl(2.0L)), 2 * LDBL_EPSILON);
+  ASSERT_LE(fabsl(powl(10.0L, -3.0L) - 0.001L), 0.001L * LDBL_EPSILON);
 }
 
 TEST(math, ceil) {
@@ -1386,3 +1518,112 @@ TEST(math, nextafterl_OpenBSD_bug) {
   ASSERT_TRUE(nextafterf(1.0f, 0.0f) - 1.0f < 0.0f);
   ASSERT_TRUE(nextafterl(1.0L, 0.0L) - 1.0L < 0.0L);
 }
+
+#if defined(__BIONIC__) && (defined(__x86_64__) || defined(__aarch64__))
+typedef double vector_double __attribute__((__vector_size__(16)));
+typedef float vector_float __attribute__((__vector_size__(16)));
+
+#if defined(__x86_64__)
+#define VECTOR_VARIANT(lanes, params, name) _ZGVbN ## lanes ## params ## _ ## name
+#define VECTOR_ABI
+#else
+#define VECTOR_VARIANT(lanes, params, name) _ZGVnN ## lanes ## params ## _ ## name
+#define VECTOR_ABI __attribute__((__aarch64_vector_pcs__))
+#endif
+
+#define DECLARE_VECTOR_VARIANTS(name) \
+  extern "C" vector_double VECTOR_VARIANT(2, v, name)(vector_double) VECTOR_ABI; \
+  extern "C" vector_float VECTOR_VARIANT(4, v, name ## f)(vector_float) VECTOR_ABI;
+DECLARE_VECTOR_VARIANTS(exp)
+DECLARE_VECTOR_VARIANTS(log)
+DECLARE_VECTOR_VARIANTS(sin)
+DECLARE_VECTOR_VARIANTS(cos)
+DECLARE_VECTOR_VARIANTS(tanh)
+extern "C" vector_double VECTOR_VARIANT(2, vv, pow)(vector_double, vector_double) VECTOR_ABI;
+extern "C" vector_float VECTOR_VARIANT(4, vv, powf)(vector_float, vector_float) VECTOR_ABI;
+
+// The vector variants are allowed to differ from the scalar functions by an
+// ulp or two, but must agree on NaNs, infinities, zeroes and signs.
+static int64_t ulp_distance(double a, double b) {
+  int64_t ia, ib;
+  memcpy(&ia, &a, sizeof(a));
+  memcpy(&ib, &b, sizeof(b));
+  if (ia < 0) ia = INT64_MIN - ia;
+  if (ib < 0) ib = INT64_MIN - ib;
+  return (ia > ib) ? ia - ib : ib - ia;
+}
+
+static int32_t ulp_distance(float a, float b) {
+  int32_t ia, ib;
+  memcpy(&ia, &a, sizeof(a));
+  memcpy(&ib, &b, sizeof(b));
+  if (ia < 0) ia = INT32_MIN - ia;
+  if (ib < 0) ib = INT32_MIN - ib;
+  return (ia > ib) ? ia - ib : ib - ia;
+}
+
+#define EXPECT_VECTOR_VARIANT_D(scalar, vector, x) \
+  for (size_t i = 0; i < 2; ++i) { \
+    if (isnan(scalar)) ASSERT_TRUE(isnan(vector[i])) << x[i]; \
+    else ASSERT_LE(ulp_distance(scalar, vector[i]), 4) << x[i]; \
+  }
+
+#define EXPECT_VECTOR_VARIANT_F(scalar, vector, x) \
+  for (size_t i = 0; i < 4; ++i) { \
+    if (isnan(scalar)) ASSERT_TRUE(isnan(vector[i])) << x[i]; \
+    else ASSERT_LE(ulp_distance(scalar, vector[i]), 4) << x[i]; \
+  }
+
+static const double kVectorInputs[] = {
+  0.0, -0.0, 1e-310, 1e-300, 1e-8, 0.1, 0.5, 0.75, 1.0, 1.5, 2.0, 3.0, 10.0, 21.9,
+  88.5, 100.0, 700.0, 710.0, 1e6, 2e6, 1e30, HUGE_VAL, nan(""),
+};
+
+TEST(math, vector_variants_double) {
+  const size_t count = sizeof(kVectorInputs)/sizeof(kVectorInputs[0]);
+  for (size_t a = 0; a < count; ++a) {
+    for (size_t b = 0; b < count; ++b) {
+      vector_double x = { kVectorInputs[a], -kVectorInputs[b] };
+      vector_double y = { kVectorInputs[b] - 5.0, kVectorInputs[a] };
+      vector_double r;
+      r = VECTOR_VARIANT(2, v, exp)(x);
+      EXPECT_VECTOR_VARIANT_D(exp(x[i]), r, x);
+      r = VECTOR_VARIANT(2, v, log)(x);
+      EXPECT_VECTOR_VARIANT_D(log(x[i]), r, x);
+      r = VECTOR_VARIANT(2, v, sin)(x);
+      EXPECT_VECTOR_VARIANT_D(sin(x[i]), r, x);
+      r = VECTOR_VARIANT(2, v, cos)(x);
+      EXPECT_VECTOR_VARIANT_D(cos(x[i]), r, x);
+      r = VECTOR_VARIANT(2, v, tanh)(x);
+      EXPECT_VECTOR_VARIANT_D(tanh(x[i]), r, x);
+      r = VECTOR_VARIANT(2, vv, pow)(x, y);
+      EXPECT_VECTOR_VARIANT_D(pow(x[i], y[i]), r, x);
+    }
+  }
+}
+
+TEST(math, vector_variants_float) {
+  const size_t count = sizeof(kVectorInputs)/sizeof(kVectorInputs[0]);
+  for (size_t a = 0; a < count; ++a) {
+    for (size_t b = 0; b < count; ++b) {
+      float fa = kVectorInputs[a];
+      float fb = kVectorInputs[b];
+      vector_float x = { fa, -fb, fb * 0.25f, fa * 3.0f };
+      vector_float y = { fb - 5.0f, fa, -2.5f, 0.5f };
+      vector_float r;
+      r = VECTOR_VARIANT(4, v, expf)(x);
+      EXPECT_VECTOR_VARIANT_F(expf(x[i]), r, x);
+      r = VECTOR_VARIANT(4, v, logf)(x);
+      EXPECT_VECTOR_VARIANT_F(logf(x[i]), r, x);
+      r = VECTOR_VARIANT(4, v, sinf)(x);
+      EXPECT_VECTOR_VARIANT_F(sinf(x[i]), r, x);
+      r = VECTOR_VARIANT(4, v, cosf)(x);
+      EXPECT_VECTOR_VARIANT_F(cosf(x[i]), r, x);
+      r = VECTOR_VARIANT(4, v, tanhf)(x);
+      EXPECT_VECTOR_VARIANT_F(tanhf(x[i]), r, x);
+      r = VECTOR_VARIANT(4, vv, powf)(x, y);
+      EXPECT_VECTOR_VARIANT_F(powf(x[i], y[i]), r, x);
+    }
+  }
+}
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/mmsg_arena.h>
+#endif
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#if defined(__BIONIC__)
+// Returns a UDP socket bound to an ephemeral loopback port, and its address.
+static int BoundUdpSocket(sockaddr_in* addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_length = sizeof(*addr);
+  if (fd == -1 || bind(fd, reinterpret_cast<sockaddr*>(addr), sizeof(*addr)) == -1 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(addr), &addr_length) == -1) {
+    return -1;
+  }
+  return fd;
+}
+#endif
+
+TEST(mmsg_arena, send_and_recv) {
+#if defined(__BIONIC__)
+  sockaddr_in server_addr;
+  int server = BoundUdpSocket(&server_addr);
+  ASSERT_NE(-1, server);
+  sockaddr_in client_addr;
+  int client = BoundUdpSocket(&client_addr);
+  ASSERT_NE(-1, client);
+
+  const size_t kCount = 16;
+  android_mmsg_arena_t* out = android_mmsg_arena_create(kCount, 64);
+  ASSERT_TRUE(out != NULL);
+  for (size_t i = 0; i < kCount; ++i) {
+    char* buf = reinterpret_cast<char*>(android_mmsg_arena_buffer(out, i));
+    int length = snprintf(buf, 64, "message %zu", i);
+    ASSERT_EQ(0, android_mmsg_arena_set_message(out, i, length,
+                                                reinterpret_cast<sockaddr*>(&server_addr),
+                                                sizeof(server_addr)));
+  }
+  ASSERT_EQ(static_cast<int>(kCount), android_mmsg_arena_send(out, client, kCount, 0));
+
+  // A bigger arena than needed only gets what's there.
+  android_mmsg_arena_t* in = android_mmsg_arena_create(kCount * 2, 64);
+  ASSERT_TRUE(in != NULL);
+  ASSERT_EQ(static_cast<int>(kCount), android_mmsg_arena_recv(in, server, MSG_DONTWAIT, NULL));
+  mmsghdr* msgs = android_mmsg_arena_msgs(in);
+  for (size_t i = 0; i < kCount; ++i) {
+    char expected[64];
+    snprintf(expected, sizeof(expected), "message %zu", i);
+    ASSERT_EQ(expected, std::string(reinterpret_cast<char*>(android_mmsg_arena_buffer(in, i)),
+                                    msgs[i].msg_len));
+    sockaddr_in* from = reinterpret_cast<sockaddr_in*>(msgs[i].msg_hdr.msg_name);
+    ASSERT_EQ(client_addr.sin_port, from->sin_port);
+  }
+
+  // The arena can be reused, and full lengths are restored each time.
+  ASSERT_EQ(0, android_mmsg_arena_set_message(out, 0, 64, reinterpret_cast<sockaddr*>(&server_addr),
+                                              sizeof(server_addr)));
+  ASSERT_EQ(1, android_mmsg_arena_send(out, client, 1, 0));
+  ASSERT_EQ(1, android_mmsg_arena_recv(in, server, MSG_DONTWAIT, NULL));
+  ASSERT_EQ(64U, msgs[0].msg_len);
+
+  errno = 0;
+  ASSERT_EQ(-1, android_mmsg_arena_recv(in, server, MSG_DONTWAIT, NULL));
+  ASSERT_EQ(EAGAIN, errno);
+
+  android_mmsg_arena_destroy(in);
+  android_mmsg_arena_destroy(out);
+  close(client);
+  close(server);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(mmsg_arena, errors) {
+#if defined(__BIONIC__)
+  errno = 0;
+  ASSERT_TRUE(android_mmsg_arena_create(0, 64) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_TRUE(android_mmsg_arena_create(SIZE_MAX / 2, 64) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+
+  android_mmsg_arena_t* arena = android_mmsg_arena_create(2, 16);
+  ASSERT_TRUE(arena != NULL);
+  errno = 0;
+  ASSERT_EQ(-1, android_mmsg_arena_set_message(arena, 2, 1, NULL, 0));
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_EQ(-1, android_mmsg_arena_set_message(arena, 0, 17, NULL, 0));
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_EQ(-1, android_mmsg_arena_send(arena, -1, 3, 0));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(0, android_mmsg_arena_set_message(arena, 0, 1, NULL, 0));
+  errno = 0;
+  ASSERT_EQ(-1, android_mmsg_arena_send(arena, -1, 1, 0));
+  ASSERT_EQ(EBADF, errno);
+  android_mmsg_arena_destroy(arena);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
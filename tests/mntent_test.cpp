@@ -18,6 +18,12 @@
 
 #include <mntent.h>
 
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "TemporaryFile.h"
+
 TEST(mntent, mntent_smoke) {
   FILE* fp = setmntent("/no/mnt/tab/on/android", "r");
   ASSERT_TRUE(fp == NULL);
@@ -32,3 +38,108 @@ TEST(mntent, mntent_smoke) {
 
   ASSERT_EQ(1, endmntent(fp));
 }
+
+TEST(mntent, getmntent_r) {
+  TemporaryFile tf;
+  const char* kTable =
+      "# A comment.\n"
+      "\n"
+      "/dev/block/sda1 / ext4 rw,noatime 1 2\n"
+      "  tmpfs   /with\\040space\ttmpfs rw\n"
+      "none /missing/fields\n"
+      "proc /proc proc rw 0\n";
+  ASSERT_EQ(static_cast<ssize_t>(strlen(kTable)), write(tf.fd, kTable, strlen(kTable)));
+
+  FILE* fp = setmntent(tf.filename, "r");
+  ASSERT_TRUE(fp != NULL);
+  mntent entry;
+  char buf[256];
+  ASSERT_EQ(&entry, getmntent_r(fp, &entry, buf, sizeof(buf)));
+  ASSERT_STREQ("/dev/block/sda1", entry.mnt_fsname);
+  ASSERT_STREQ("/", entry.mnt_dir);
+  ASSERT_STREQ("ext4", entry.mnt_type);
+  ASSERT_STREQ("rw,noatime", entry.mnt_opts);
+  ASSERT_EQ(1, entry.mnt_freq);
+  ASSERT_EQ(2, entry.mnt_passno);
+
+  ASSERT_EQ(&entry, getmntent_r(fp, &entry, buf, sizeof(buf)));
+  ASSERT_STREQ("tmpfs", entry.mnt_fsname);
+  ASSERT_STREQ("/with space", entry.mnt_dir);
+  ASSERT_STREQ("tmpfs", entry.mnt_type);
+  ASSERT_STREQ("rw", entry.mnt_opts);
+  ASSERT_EQ(0, entry.mnt_freq);
+  ASSERT_EQ(0, entry.mnt_passno);
+
+  mntent* e = getmntent(fp);
+  ASSERT_TRUE(e != NULL);
+  ASSERT_STREQ("proc", e->mnt_fsname);
+  ASSERT_STREQ("/proc", e->mnt_dir);
+
+  ASSERT_TRUE(getmntent(fp) == NULL);
+  ASSERT_EQ(1, endmntent(fp));
+}
+
+TEST(mntent, getmntent_proc_mounts) {
+  FILE* fp = setmntent("/proc/mounts", "r");
+  ASSERT_TRUE(fp != NULL);
+  bool found_root = false;
+  mntent* e;
+  while ((e = getmntent(fp)) != NULL) {
+    if (strcmp(e->mnt_dir, "/") == 0) {
+      found_root = true;
+    }
+  }
+  ASSERT_TRUE(found_root);
+  ASSERT_EQ(1, endmntent(fp));
+}
+
+#if defined(__BIONIC__)
+static int FindRootMount(const android_mountinfo* info, void* arg) {
+  if (strcmp(info->mount_point, "/") == 0) {
+    *reinterpret_cast<android_mountinfo*>(arg) = *info;
+    return 1;
+  }
+  return 0;
+}
+
+static int CountMounts(const android_mountinfo*, void* arg) {
+  ++*reinterpret_cast<int*>(arg);
+  return 0;
+}
+#endif
+
+TEST(mntent, android_mountinfo_iterate) {
+#if defined(__BIONIC__)
+  android_mountinfo root;
+  ASSERT_EQ(1, android_mountinfo_iterate(FindRootMount, &root));
+  ASSERT_GT(root.mount_id, 0);
+
+  int count = 0;
+  ASSERT_EQ(0, android_mountinfo_iterate(CountMounts, &count));
+  ASSERT_GT(count, 0);
+
+  // There's a line in /proc/mounts for every mount.
+  FILE* fp = setmntent("/proc/mounts", "r");
+  ASSERT_TRUE(fp != NULL);
+  int mntent_count = 0;
+  while (getmntent(fp) != NULL) {
+    ++mntent_count;
+  }
+  ASSERT_EQ(1, endmntent(fp));
+  ASSERT_EQ(mntent_count, count);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(mntent, android_mounts_changed) {
+#if defined(__BIONIC__)
+  int fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(-1, fd);
+  // Nothing has changed since we opened it.
+  ASSERT_EQ(0, android_mounts_changed(fd, 0));
+  close(fd);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
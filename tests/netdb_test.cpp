@@ -21,6 +21,8 @@
 #include <netdb.h>
 #include <netinet/in.h>
 
+#include <string>
+
 TEST(netdb, getaddrinfo_NULL_hints) {
   addrinfo* ai = NULL;
   ASSERT_EQ(0, getaddrinfo("localhost", "9999", NULL, &ai));
@@ -55,3 +57,59 @@ TEST(netdb, getnameinfo_salen) {
   ASSERT_STREQ("::", tmp);
   ASSERT_EQ(EAI_FAMILY, getnameinfo(sa, too_little, tmp, sizeof(tmp), NULL, 0, NI_NUMERICHOST));
 }
+
+TEST(netdb, getservbyname) {
+  servent* s = getservbyname("smtp", "tcp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("smtp", s->s_name);
+  ASSERT_STREQ("tcp", s->s_proto);
+  ASSERT_EQ(htons(25), s->s_port);
+
+  s = getservbyname("https", "udp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("udp", s->s_proto);
+  ASSERT_EQ(htons(443), s->s_port);
+
+  ASSERT_TRUE(getservbyname("no-such-service", "tcp") == NULL);
+  ASSERT_TRUE(getservbyname("smtp", "no-such-protocol") == NULL);
+}
+
+TEST(netdb, getservbyport) {
+  servent* s = getservbyport(htons(22), "tcp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("ssh", s->s_name);
+  ASSERT_STREQ("tcp", s->s_proto);
+  ASSERT_EQ(htons(22), s->s_port);
+
+  ASSERT_TRUE(getservbyport(htons(25), "no-such-protocol") == NULL);
+}
+
+TEST(netdb, getservbyname_matches_getservent) {
+#if defined(__BIONIC__)
+  // Every entry getservent returns should be found again by name and by
+  // port, unless an earlier entry has the same key.
+  setservent(0);
+  size_t count = 0;
+  servent* s;
+  while ((s = getservent()) != NULL) {
+    std::string name(s->s_name);
+    std::string proto(s->s_proto);
+    int port = s->s_port;
+
+    servent* by_name = getservbyname(name.c_str(), proto.c_str());
+    ASSERT_TRUE(by_name != NULL) << name;
+    ASSERT_EQ(name, by_name->s_name);
+    ASSERT_EQ(proto, by_name->s_proto);
+
+    servent* by_port = getservbyport(port, proto.c_str());
+    ASSERT_TRUE(by_port != NULL) << name;
+    ASSERT_EQ(port, by_port->s_port);
+    ASSERT_EQ(proto, by_port->s_proto);
+    ++count;
+  }
+  endservent();
+  ASSERT_GT(count, 0U);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/parallel.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
+
+#if defined(__BIONIC__)
+static void MarkChunk(size_t begin, size_t end, void* arg) {
+  uint8_t* marks = reinterpret_cast<uint8_t*>(arg);
+  for (size_t i = begin; i < end; ++i) {
+    __sync_fetch_and_add(&marks[i], 1);
+  }
+}
+#endif
+
+TEST(parallel, android_parallel_for) {
+#if defined(__BIONIC__)
+  // Every index is visited exactly once, whatever the grain.
+  const size_t kCount = 100003;
+  std::vector<uint8_t> marks(kCount);
+  size_t grains[] = { 0, 1, 7, 4096, kCount * 2 };
+  for (size_t i = 0; i < sizeof(grains)/sizeof(grains[0]); ++i) {
+    memset(&marks[0], 0, kCount);
+    ASSERT_EQ(0, android_parallel_for(0, kCount, grains[i], MarkChunk, &marks[0]));
+    for (size_t j = 0; j < kCount; ++j) {
+      ASSERT_EQ(1, marks[j]) << "grain " << grains[i] << " index " << j;
+    }
+  }
+
+  ASSERT_EQ(0, android_parallel_for(10, 10, 0, MarkChunk, &marks[0]));
+  ASSERT_EQ(EINVAL, android_parallel_for(0, 10, 0, NULL, NULL));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+struct NestedTaskArgs {
+  android_task_group_t* group;
+  int depth;
+  volatile int* leaves;
+};
+
+static void NestedTask(void* arg) {
+  NestedTaskArgs* args = reinterpret_cast<NestedTaskArgs*>(arg);
+  if (args->depth == 0) {
+    __sync_fetch_and_add(args->leaves, 1);
+    delete args;
+    return;
+  }
+  // Each task fans out into two more, submitted from whichever thread runs it.
+  for (int i = 0; i < 2; ++i) {
+    NestedTaskArgs* child = new NestedTaskArgs;
+    child->group = args->group;
+    child->depth = args->depth - 1;
+    child->leaves = args->leaves;
+    ASSERT_EQ(0, android_task_submit(args->group, NestedTask, child));
+  }
+  delete args;
+}
+#endif
+
+TEST(parallel, android_task_submit_nested) {
+#if defined(__BIONIC__)
+  android_task_group_t* group = android_task_group_create();
+  ASSERT_TRUE(group != NULL);
+
+  volatile int leaves = 0;
+  NestedTaskArgs* root = new NestedTaskArgs;
+  root->group = group;
+  root->depth = 12;
+  root->leaves = &leaves;
+  ASSERT_EQ(0, android_task_submit(group, NestedTask, root));
+  android_task_group_wait(group);
+  ASSERT_EQ(1 << 12, leaves);
+
+  // Waiting on an empty group returns straight away.
+  android_task_group_wait(group);
+  ASSERT_EQ(EINVAL, android_task_submit(group, NULL, NULL));
+  android_task_group_destroy(group);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+static void* ParallelForThreadFn(void*) {
+  const size_t kCount = 10000;
+  std::vector<uint8_t> marks(kCount);
+  for (int i = 0; i < 50; ++i) {
+    memset(&marks[0], 0, kCount);
+    android_parallel_for(0, kCount, 100, MarkChunk, &marks[0]);
+    for (size_t j = 0; j < kCount; ++j) {
+      if (marks[j] != 1) {
+        return reinterpret_cast<void*>(1);
+      }
+    }
+  }
+  return NULL;
+}
+#endif
+
+TEST(parallel, android_parallel_for_concurrent_callers) {
+#if defined(__BIONIC__)
+  // Several threads share the pool at once.
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, ParallelForThreadFn, NULL));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_EQ(NULL, result);
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(parallel, android_parallel_for_after_fork) {
+#if defined(__BIONIC__)
+  // Start the pool, then check that a child gets a working pool of its own.
+  ASSERT_EQ(NULL, ParallelForThreadFn(NULL));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    _exit(ParallelForThreadFn(NULL) == NULL ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+static void ForkInChunk(size_t begin, size_t, void* arg) {
+  if (begin != 0) {
+    return;
+  }
+  // The pool is busy, and this may well be one of its workers.
+  pid_t pid = fork();
+  if (pid == 0) {
+    _exit(ParallelForThreadFn(NULL) == NULL ? 0 : 1);
+  }
+  int status = -1;
+  if (pid == -1 || waitpid(pid, &status, 0) != pid) {
+    status = -1;
+  }
+  *reinterpret_cast<int*>(arg) = status;
+}
+#endif
+
+TEST(parallel, android_parallel_for_fork_while_busy) {
+#if defined(__BIONIC__)
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, NULL, ParallelForThreadFn, NULL));
+  int status = -1;
+  ASSERT_EQ(0, android_parallel_for(0, 64, 1, ForkInChunk, &status));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  void* result;
+  ASSERT_EQ(0, pthread_join(thread, &result));
+  ASSERT_EQ(NULL, result);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <alloca.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -24,6 +25,7 @@
 #include <signal.h>
 #include <sys/mman.h>
 #include <sys/syscall.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -135,6 +137,82 @@ TEST(pthread, pthread_key_dirty) {
   ASSERT_EQ(0, munmap(stack, stack_size));
 }
 
+static void* SetKeyFn(void* key) {
+  pthread_setspecific(*reinterpret_cast<pthread_key_t*>(key), reinterpret_cast<void*>(~0));
+  return NULL;
+}
+
+TEST(pthread, pthread_key_dirty__reused_stack) {
+  // New threads may be given the stacks of threads that have exited. They
+  // still have to start with clean TLS.
+  pthread_key_t key;
+  ASSERT_EQ(0, pthread_key_create(&key, NULL));
+
+  for (size_t i = 0; i < 8; ++i) {
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, NULL, SetKeyFn, &key));
+    ASSERT_EQ(0, pthread_join(t, NULL));
+
+    ASSERT_EQ(0, pthread_create(&t, NULL, DirtyKeyFn, &key));
+    void* result;
+    ASSERT_EQ(0, pthread_join(t, &result));
+    ASSERT_EQ(nullptr, result);
+  }
+
+  ASSERT_EQ(0, pthread_key_delete(key));
+}
+
+static size_t g_key_destructor_calls;
+
+static void CountingKeyDestructor(void*) {
+  ++g_key_destructor_calls;
+}
+
+static void* SetAllKeysFn(void* arg) {
+  std::vector<pthread_key_t>& keys = *reinterpret_cast<std::vector<pthread_key_t>*>(arg);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (pthread_setspecific(keys[i], &keys[i]) != 0) {
+      return NULL;
+    }
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (pthread_getspecific(keys[i]) != &keys[i]) {
+      return NULL;
+    }
+  }
+  return arg;
+}
+
+TEST(pthread, pthread_key_lots__destructors) {
+  // Well past PTHREAD_KEYS_MAX, so most of these don't fit in the TLS array.
+  std::vector<pthread_key_t> keys;
+  for (size_t i = 0; i < 1000; ++i) {
+    pthread_key_t key;
+    ASSERT_EQ(0, pthread_key_create(&key, CountingKeyDestructor)) << i;
+    keys.push_back(key);
+  }
+
+  g_key_destructor_calls = 0;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, SetAllKeysFn, &keys));
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(&keys, result);
+  ASSERT_EQ(keys.size(), g_key_destructor_calls);
+
+  // A value stored under a deleted key isn't visible through its replacement.
+  ASSERT_EQ(0, pthread_setspecific(keys.back(), &keys));
+  ASSERT_EQ(0, pthread_key_delete(keys.back()));
+  ASSERT_EQ(NULL, pthread_getspecific(keys.back()));
+  ASSERT_EQ(EINVAL, pthread_setspecific(keys.back(), &keys));
+  ASSERT_EQ(0, pthread_key_create(&keys.back(), NULL));
+  ASSERT_EQ(NULL, pthread_getspecific(keys.back()));
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(0, pthread_key_delete(keys[i]));
+  }
+}
+
 static void* IdFn(void* arg) {
   return arg;
 }
@@ -394,6 +472,81 @@ TEST(pthread, pthread_kill__in_signal_handler) {
   ASSERT_EQ(0, pthread_kill(pthread_self(), SIGALRM));
 }
 
+TEST(pthread, pthread_sigqueue__self) {
+  sigset_t set, old_set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  ASSERT_EQ(0, pthread_sigmask(SIG_BLOCK, &set, &old_set));
+
+  union sigval value;
+  value.sival_int = 1234;
+  ASSERT_EQ(0, pthread_sigqueue(pthread_self(), SIGUSR1, value));
+
+  siginfo_t info;
+  ASSERT_EQ(SIGUSR1, sigwaitinfo(&set, &info));
+  ASSERT_EQ(SI_QUEUE, info.si_code);
+  ASSERT_EQ(getpid(), info.si_pid);
+  ASSERT_EQ(1234, info.si_value.sival_int);
+
+  ASSERT_EQ(0, pthread_sigmask(SIG_SETMASK, &old_set, NULL));
+}
+
+static void* pthread_sigqueue__other_thread_fn(void* arg) {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  siginfo_t* info = reinterpret_cast<siginfo_t*>(arg);
+  return reinterpret_cast<void*>(sigwaitinfo(&set, info));
+}
+
+TEST(pthread, pthread_sigqueue__other_thread) {
+  // The new thread inherits our signal mask, so SIGUSR1 stays pending for sigwaitinfo.
+  sigset_t set, old_set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  ASSERT_EQ(0, pthread_sigmask(SIG_BLOCK, &set, &old_set));
+
+  siginfo_t info;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, pthread_sigqueue__other_thread_fn, &info));
+
+  union sigval value;
+  value.sival_int = 5678;
+  ASSERT_EQ(0, pthread_sigqueue(t, SIGUSR1, value));
+
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(SIGUSR1, reinterpret_cast<intptr_t>(result));
+  ASSERT_EQ(SI_QUEUE, info.si_code);
+  ASSERT_EQ(5678, info.si_value.sival_int);
+
+  // The signal went to that thread, not to the process, so none is left for us.
+  sigset_t pending;
+  ASSERT_EQ(0, sigpending(&pending));
+  ASSERT_FALSE(sigismember(&pending, SIGUSR1));
+
+  ASSERT_EQ(0, pthread_sigmask(SIG_SETMASK, &old_set, NULL));
+}
+
+TEST(pthread, pthread_sigqueue__invalid_signal) {
+  union sigval value;
+  value.sival_int = 0;
+  ASSERT_EQ(EINVAL, pthread_sigqueue(pthread_self(), -1, value));
+}
+
+TEST(pthread, pthread_sigqueue__no_such_thread) {
+#if defined(__BIONIC__) // glibc doesn't check the pthread_t.
+  pthread_t dead_thread;
+  MakeDeadThread(dead_thread);
+
+  union sigval value;
+  value.sival_int = 0;
+  ASSERT_EQ(ESRCH, pthread_sigqueue(dead_thread, SIGUSR1, value));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(pthread, pthread_detach__no_such_thread) {
   pthread_t dead_thread;
   MakeDeadThread(dead_thread);
@@ -672,6 +825,112 @@ TEST(pthread, pthread_rwlock_smoke) {
   ASSERT_EQ(0, pthread_rwlock_destroy(&l));
 }
 
+TEST(pthread, pthread_rwlockattr_kind) {
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  int kind;
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_PREFER_READER_NP, kind);
+
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP));
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP, kind);
+
+  // The kind and pshared attributes are independent.
+  ASSERT_EQ(0, pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED));
+  int pshared;
+  ASSERT_EQ(0, pthread_rwlockattr_getpshared(&attr, &pshared));
+  ASSERT_EQ(PTHREAD_PROCESS_SHARED, pshared);
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP, kind);
+
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+}
+
+static void* RwlockWrlockFn(void* arg) {
+  pthread_rwlock_t* l = reinterpret_cast<pthread_rwlock_t*>(arg);
+  pthread_rwlock_wrlock(l);
+  pthread_rwlock_unlock(l);
+  return NULL;
+}
+
+TEST(pthread, pthread_rwlock_PREFER_WRITER_NONRECURSIVE_NP) {
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP));
+  pthread_rwlock_t l;
+  ASSERT_EQ(0, pthread_rwlock_init(&l, &attr));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, RwlockWrlockFn, &l));
+
+  // Once the writer is waiting, new readers have to wait too.
+  for (size_t i = 0; i < 1000 && pthread_rwlock_tryrdlock(&l) == 0; ++i) {
+    ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+    usleep(1000);
+  }
+  ASSERT_EQ(EBUSY, pthread_rwlock_tryrdlock(&l));
+
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_EQ(0, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+}
+
+struct RwlockCounter {
+  pthread_rwlock_t lock;
+  int value;
+  volatile int readers;
+};
+
+static void* RwlockCounterFn(void* arg) {
+  RwlockCounter* counter = reinterpret_cast<RwlockCounter*>(arg);
+  for (size_t i = 0; i < 10000; ++i) {
+    if (i % 8 == 0) {
+      pthread_rwlock_wrlock(&counter->lock);
+      if (counter->readers != 0) {
+        abort();
+      }
+      ++counter->value;
+    } else {
+      pthread_rwlock_rdlock(&counter->lock);
+      __sync_fetch_and_add(&counter->readers, 1);
+      __sync_fetch_and_sub(&counter->readers, 1);
+    }
+    pthread_rwlock_unlock(&counter->lock);
+  }
+  return NULL;
+}
+
+static void TestRwlockContended(int kind) {
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, kind));
+  RwlockCounter counter;
+  ASSERT_EQ(0, pthread_rwlock_init(&counter.lock, &attr));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+  counter.value = 0;
+  counter.readers = 0;
+
+  pthread_t threads[8];
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, RwlockCounterFn, &counter));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(8 * 1250, counter.value);
+  ASSERT_EQ(0, pthread_rwlock_destroy(&counter.lock));
+}
+
+TEST(pthread, pthread_rwlock_contended) {
+  TestRwlockContended(PTHREAD_RWLOCK_PREFER_READER_NP);
+  TestRwlockContended(PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+}
+
 static int g_once_fn_call_count = 0;
 static void OnceFn() {
   ++g_once_fn_call_count;
@@ -704,6 +963,40 @@ TEST(pthread, pthread_once_1934122) {
   ASSERT_EQ("12", pthread_once_1934122_result);
 }
 
+static pthread_once_t g_contended_once = PTHREAD_ONCE_INIT;
+static int g_contended_once_calls = 0;
+
+static void ContendedOnceFn() {
+  // Give the other threads time to pile up behind us.
+  usleep(100000);
+  ++g_contended_once_calls;
+}
+
+static int ContendedStaticInit() {
+  usleep(100000);
+  return 42;
+}
+
+static void* ContendedOnceThreadFn(void*) {
+  pthread_once(&g_contended_once, ContendedOnceFn);
+  static int contended_static = ContendedStaticInit();
+  return reinterpret_cast<void*>(g_contended_once_calls * contended_static);
+}
+
+TEST(pthread, pthread_once_and_static_init_contended) {
+  pthread_t threads[8];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, ContendedOnceThreadFn, NULL));
+  }
+  // Every thread must wait for the initialization to finish, and it must
+  // only run once.
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_EQ(42, reinterpret_cast<intptr_t>(result));
+  }
+}
+
 static int g_atfork_prepare_calls = 0;
 static void AtForkPrepare1() { g_atfork_prepare_calls = (g_atfork_prepare_calls << 4) | 1; }
 static void AtForkPrepare2() { g_atfork_prepare_calls = (g_atfork_prepare_calls << 4) | 2; }
@@ -732,6 +1025,54 @@ TEST(pthread, pthread_atfork) {
   ASSERT_EQ(0x21, g_atfork_prepare_calls);
 }
 
+static int g_atfork_late_calls = 0;
+static void AtForkLate() { ++g_atfork_late_calls; }
+static bool g_atfork_registered_late = false;
+static void AtForkPrepareRegisters() {
+  if (!g_atfork_registered_late) {
+    g_atfork_registered_late = true;
+    pthread_atfork(AtForkLate, AtForkLate, AtForkLate);
+  }
+}
+
+TEST(pthread, pthread_atfork_from_prepare_handler) {
+#if defined(__BIONIC__)
+  // Registering a handler during a fork mustn't deadlock, and the new handler
+  // only runs for later forks.
+  ASSERT_EQ(0, pthread_atfork(AtForkPrepareRegisters, NULL, NULL));
+
+  int pid = fork();
+  ASSERT_NE(-1, pid) << strerror(errno);
+  if (pid == 0) {
+    _exit(g_atfork_late_calls == 0 ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  ASSERT_EQ(0, g_atfork_late_calls);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+static int g_atfork_many_calls = 0;
+static void AtForkMany() { ++g_atfork_many_calls; }
+
+TEST(pthread, pthread_atfork_many) {
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(0, pthread_atfork(AtForkMany, NULL, NULL));
+  }
+  int pid = fork();
+  ASSERT_NE(-1, pid) << strerror(errno);
+  if (pid == 0) {
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_EQ(100, g_atfork_many_calls);
+}
+
 TEST(pthread, pthread_attr_getscope) {
   pthread_attr_t attr;
   ASSERT_EQ(0, pthread_attr_init(&attr));
@@ -796,6 +1137,214 @@ TEST(pthread, pthread_cond_broadcast__preserves_condattr_flags) {
 #endif // __BIONIC__
 }
 
+struct CondBroadcastState {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int waiting;
+  int woken;
+  bool go;
+};
+
+static void* CondBroadcastWaiterFn(void* arg) {
+  CondBroadcastState* state = reinterpret_cast<CondBroadcastState*>(arg);
+  pthread_mutex_lock(&state->mutex);
+  ++state->waiting;
+  while (!state->go) {
+    pthread_cond_wait(&state->cond, &state->mutex);
+  }
+  ++state->woken;
+  pthread_mutex_unlock(&state->mutex);
+  return NULL;
+}
+
+static void TestCondBroadcastWakesAll(int mutex_type) {
+  CondBroadcastState state;
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, mutex_type));
+  ASSERT_EQ(0, pthread_mutex_init(&state.mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+  ASSERT_EQ(0, pthread_cond_init(&state.cond, NULL));
+  state.waiting = 0;
+  state.woken = 0;
+  state.go = false;
+
+  const size_t kThreadCount = 32;
+  pthread_t threads[kThreadCount];
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, CondBroadcastWaiterFn, &state));
+  }
+
+  // Wait for every thread to be waiting, then release them all at once.
+  while (true) {
+    ASSERT_EQ(0, pthread_mutex_lock(&state.mutex));
+    if (state.waiting == static_cast<int>(kThreadCount)) {
+      break;
+    }
+    ASSERT_EQ(0, pthread_mutex_unlock(&state.mutex));
+    usleep(1000);
+  }
+  state.go = true;
+  ASSERT_EQ(0, pthread_cond_broadcast(&state.cond));
+  ASSERT_EQ(0, pthread_mutex_unlock(&state.mutex));
+
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(static_cast<int>(kThreadCount), state.woken);
+  ASSERT_EQ(0, pthread_cond_destroy(&state.cond));
+  ASSERT_EQ(0, pthread_mutex_destroy(&state.mutex));
+}
+
+TEST(pthread, pthread_cond_broadcast__wakes_all_waiters) {
+  TestCondBroadcastWakesAll(PTHREAD_MUTEX_NORMAL);
+  TestCondBroadcastWakesAll(PTHREAD_MUTEX_RECURSIVE);
+  TestCondBroadcastWakesAll(PTHREAD_MUTEX_ERRORCHECK);
+}
+
+TEST(pthread, pthread_cond_broadcast__after_mutex_unmapped) {
+  // A waiter that timed out leaves nothing behind for a later broadcast to
+  // requeue onto, so its mutex can be destroyed and its memory unmapped.
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  void* map = mmap(NULL, sizeof(pthread_mutex_t), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, map);
+  pthread_mutex_t* mutex = reinterpret_cast<pthread_mutex_t*>(map);
+  ASSERT_EQ(0, pthread_mutex_init(mutex, NULL));
+  ASSERT_EQ(0, pthread_mutex_lock(mutex));
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  ts.tv_nsec += 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  ASSERT_EQ(ETIMEDOUT, pthread_cond_timedwait(&cond, mutex, &ts));
+  ASSERT_EQ(0, pthread_mutex_unlock(mutex));
+  ASSERT_EQ(0, pthread_mutex_destroy(mutex));
+  ASSERT_EQ(0, munmap(map, sizeof(pthread_mutex_t)));
+
+  ASSERT_EQ(0, pthread_cond_broadcast(&cond));
+  ASSERT_EQ(0, pthread_cond_signal(&cond));
+  ASSERT_EQ(0, pthread_cond_destroy(&cond));
+}
+
+TEST(pthread, pthread_barrierattr_smoke) {
+  pthread_barrierattr_t attr;
+  ASSERT_EQ(0, pthread_barrierattr_init(&attr));
+  int pshared;
+  ASSERT_EQ(0, pthread_barrierattr_getpshared(&attr, &pshared));
+  ASSERT_EQ(PTHREAD_PROCESS_PRIVATE, pshared);
+  ASSERT_EQ(0, pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED));
+  ASSERT_EQ(0, pthread_barrierattr_getpshared(&attr, &pshared));
+  ASSERT_EQ(PTHREAD_PROCESS_SHARED, pshared);
+  ASSERT_EQ(EINVAL, pthread_barrierattr_setpshared(&attr, 123));
+  ASSERT_EQ(0, pthread_barrierattr_destroy(&attr));
+}
+
+struct BarrierTestState {
+  pthread_barrier_t barrier;
+  volatile int arrivals[100];
+  volatile int serial_count;
+  int thread_count;
+};
+
+static void* BarrierTestFn(void* arg) {
+  BarrierTestState* state = reinterpret_cast<BarrierTestState*>(arg);
+  for (size_t i = 0; i < 100; ++i) {
+    __sync_fetch_and_add(&state->arrivals[i], 1);
+    int result = pthread_barrier_wait(&state->barrier);
+    if (result == PTHREAD_BARRIER_SERIAL_THREAD) {
+      __sync_fetch_and_add(&state->serial_count, 1);
+    } else if (result != 0) {
+      return reinterpret_cast<void*>(1);
+    }
+    // Nobody gets past the barrier until everybody has reached it.
+    if (state->arrivals[i] != state->thread_count) {
+      return reinterpret_cast<void*>(1);
+    }
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_barrier_init__zero_count) {
+  pthread_barrier_t barrier;
+  ASSERT_EQ(EINVAL, pthread_barrier_init(&barrier, NULL, 0));
+}
+
+TEST(pthread, pthread_barrier_smoke) {
+  BarrierTestState state;
+  state.thread_count = 8;
+  state.serial_count = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    state.arrivals[i] = 0;
+  }
+  ASSERT_EQ(0, pthread_barrier_init(&state.barrier, NULL, state.thread_count));
+
+  pthread_t threads[8];
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, BarrierTestFn, &state));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_EQ(NULL, result);
+  }
+  // Exactly one thread per round is told it was the last.
+  ASSERT_EQ(100, state.serial_count);
+  ASSERT_EQ(0, pthread_barrier_destroy(&state.barrier));
+}
+
+TEST(pthread, pthread_barrier_single_thread) {
+  pthread_barrier_t barrier;
+  ASSERT_EQ(0, pthread_barrier_init(&barrier, NULL, 1));
+  ASSERT_EQ(PTHREAD_BARRIER_SERIAL_THREAD, pthread_barrier_wait(&barrier));
+  ASSERT_EQ(PTHREAD_BARRIER_SERIAL_THREAD, pthread_barrier_wait(&barrier));
+  ASSERT_EQ(0, pthread_barrier_destroy(&barrier));
+}
+
+TEST(pthread, pthread_spin_smoke) {
+  pthread_spinlock_t lock;
+  ASSERT_EQ(0, pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE));
+  ASSERT_EQ(0, pthread_spin_lock(&lock));
+  ASSERT_EQ(EBUSY, pthread_spin_trylock(&lock));
+  ASSERT_EQ(0, pthread_spin_unlock(&lock));
+  ASSERT_EQ(0, pthread_spin_trylock(&lock));
+  ASSERT_EQ(0, pthread_spin_unlock(&lock));
+  ASSERT_EQ(0, pthread_spin_destroy(&lock));
+}
+
+struct SpinlockCounter {
+  pthread_spinlock_t lock;
+  int count;
+};
+
+static void* SpinlockIncrementFn(void* arg) {
+  SpinlockCounter* counter = reinterpret_cast<SpinlockCounter*>(arg);
+  for (size_t i = 0; i < 10000; ++i) {
+    pthread_spin_lock(&counter->lock);
+    ++counter->count;
+    pthread_spin_unlock(&counter->lock);
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_spin_contended) {
+  SpinlockCounter counter;
+  ASSERT_EQ(0, pthread_spin_init(&counter.lock, PTHREAD_PROCESS_PRIVATE));
+  counter.count = 0;
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, SpinlockIncrementFn, &counter));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(40000, counter.count);
+  ASSERT_EQ(0, pthread_spin_destroy(&counter.lock));
+}
+
 TEST(pthread, pthread_mutex_timedlock) {
   pthread_mutex_t m;
   ASSERT_EQ(0, pthread_mutex_init(&m, NULL));
@@ -819,6 +1368,318 @@ TEST(pthread, pthread_mutex_timedlock) {
   ASSERT_EQ(0, pthread_mutex_destroy(&m));
 }
 
+struct AdaptiveMutexCounter {
+  pthread_mutex_t mutex;
+  int count;
+};
+
+static void* AdaptiveMutexIncrementFn(void* arg) {
+  AdaptiveMutexCounter* counter = reinterpret_cast<AdaptiveMutexCounter*>(arg);
+  for (int i = 0; i < 10000; ++i) {
+    pthread_mutex_lock(&counter->mutex);
+    ++counter->count;
+    pthread_mutex_unlock(&counter->mutex);
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_NP) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP));
+  int type;
+  ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &type));
+  ASSERT_EQ(PTHREAD_MUTEX_ADAPTIVE_NP, type);
+
+  AdaptiveMutexCounter counter;
+  ASSERT_EQ(0, pthread_mutex_init(&counter.mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+  counter.count = 0;
+
+  ASSERT_EQ(0, pthread_mutex_lock(&counter.mutex));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&counter.mutex));
+  ASSERT_EQ(0, pthread_mutex_unlock(&counter.mutex));
+  ASSERT_EQ(0, pthread_mutex_trylock(&counter.mutex));
+  ASSERT_EQ(0, pthread_mutex_unlock(&counter.mutex));
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, AdaptiveMutexIncrementFn, &counter));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(40000, counter.count);
+  ASSERT_EQ(0, pthread_mutex_destroy(&counter.mutex));
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_NP_initializer) {
+  pthread_mutex_t m = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  ts.tv_nsec += 1;
+  ASSERT_EQ(ETIMEDOUT, pthread_mutex_timedlock(&m, &ts));
+
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutexattr_protocol) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  int protocol;
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_NONE, protocol);
+
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_INHERIT, protocol);
+
+  ASSERT_EQ(EINVAL, pthread_mutexattr_setprotocol(&attr, 123));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+static void InitPiMutex(pthread_mutex_t* mutex, int type) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, type));
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+  ASSERT_EQ(0, pthread_mutex_init(mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+static void* PiMutexUnlockFn(void* arg) {
+  return reinterpret_cast<void*>(pthread_mutex_unlock(reinterpret_cast<pthread_mutex_t*>(arg)));
+}
+
+static void* PiMutexTimedlockFn(void* arg) {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_nsec += 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  return reinterpret_cast<void*>(pthread_mutex_timedlock(reinterpret_cast<pthread_mutex_t*>(arg), &ts));
+}
+
+TEST(pthread, pthread_mutex_PRIO_INHERIT) {
+  pthread_mutex_t m;
+  InitPiMutex(&m, PTHREAD_MUTEX_NORMAL);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+
+  // Only the owner may unlock, and others time out waiting.
+  void* result;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, PiMutexUnlockFn, &m));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(EPERM, reinterpret_cast<intptr_t>(result));
+  ASSERT_EQ(0, pthread_create(&t, NULL, PiMutexTimedlockFn, &m));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(ETIMEDOUT, reinterpret_cast<intptr_t>(result));
+
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_PRIO_INHERIT_ERRORCHECK) {
+  pthread_mutex_t m;
+  InitPiMutex(&m, PTHREAD_MUTEX_ERRORCHECK);
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+  ASSERT_EQ(EDEADLK, pthread_mutex_lock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(EPERM, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_PRIO_INHERIT_RECURSIVE) {
+  pthread_mutex_t m;
+  InitPiMutex(&m, PTHREAD_MUTEX_RECURSIVE);
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+
+  // Still held once.
+  void* result;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, PiMutexTimedlockFn, &m));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(ETIMEDOUT, reinterpret_cast<intptr_t>(result));
+
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(EPERM, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_PRIO_INHERIT_contended) {
+  AdaptiveMutexCounter counter;
+  InitPiMutex(&counter.mutex, PTHREAD_MUTEX_NORMAL);
+  counter.count = 0;
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, AdaptiveMutexIncrementFn, &counter));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(40000, counter.count);
+  ASSERT_EQ(0, pthread_mutex_destroy(&counter.mutex));
+}
+
+TEST(pthread, pthread_mutexattr_robust) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  int robust;
+  ASSERT_EQ(0, pthread_mutexattr_getrobust(&attr, &robust));
+  ASSERT_EQ(PTHREAD_MUTEX_STALLED, robust);
+
+  ASSERT_EQ(0, pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST));
+  ASSERT_EQ(0, pthread_mutexattr_getrobust(&attr, &robust));
+  ASSERT_EQ(PTHREAD_MUTEX_ROBUST, robust);
+
+  ASSERT_EQ(EINVAL, pthread_mutexattr_setrobust(&attr, 123));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+static void InitRobustMutex(pthread_mutex_t* mutex, int pshared, int protocol) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST));
+  ASSERT_EQ(0, pthread_mutexattr_setpshared(&attr, pshared));
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, protocol));
+  ASSERT_EQ(0, pthread_mutex_init(mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+static void* RobustMutexLockAndExitFn(void* arg) {
+  return reinterpret_cast<void*>(pthread_mutex_lock(reinterpret_cast<pthread_mutex_t*>(arg)));
+}
+
+static void RobustMutexOwnerDies(pthread_mutex_t* m) {
+  void* result;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, RobustMutexLockAndExitFn, m));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(0, reinterpret_cast<intptr_t>(result));
+}
+
+static void TestRobustMutexRecovery(int protocol) {
+  pthread_mutex_t m;
+  InitRobustMutex(&m, PTHREAD_PROCESS_PRIVATE, protocol);
+
+  // A robust mutex works like any other while its owners live.
+  ASSERT_EQ(EINVAL, pthread_mutex_consistent(&m));
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+
+  // The next owner of a mutex whose owner exited holding it is told so,
+  // and may repair the damage.
+  RobustMutexOwnerDies(&m);
+  ASSERT_EQ(EOWNERDEAD, pthread_mutex_lock(&m));
+  ASSERT_EQ(0, pthread_mutex_consistent(&m));
+  ASSERT_EQ(EINVAL, pthread_mutex_consistent(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+
+  // trylock reports a dead owner too.
+  RobustMutexOwnerDies(&m);
+  ASSERT_EQ(EOWNERDEAD, pthread_mutex_trylock(&m));
+
+  // Unlocking without pthread_mutex_consistent makes the mutex unusable.
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(ENOTRECOVERABLE, pthread_mutex_lock(&m));
+  ASSERT_EQ(ENOTRECOVERABLE, pthread_mutex_trylock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_ROBUST) {
+  TestRobustMutexRecovery(PTHREAD_PRIO_NONE);
+}
+
+TEST(pthread, pthread_mutex_ROBUST_PRIO_INHERIT) {
+  TestRobustMutexRecovery(PTHREAD_PRIO_INHERIT);
+}
+
+TEST(pthread, pthread_mutex_ROBUST_timedlock) {
+  pthread_mutex_t m;
+  InitRobustMutex(&m, PTHREAD_PROCESS_PRIVATE, PTHREAD_PRIO_NONE);
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+
+  void* result;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, PiMutexTimedlockFn, &m));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(ETIMEDOUT, reinterpret_cast<intptr_t>(result));
+
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_ROBUST_contended) {
+  AdaptiveMutexCounter counter;
+  InitRobustMutex(&counter.mutex, PTHREAD_PROCESS_PRIVATE, PTHREAD_PRIO_NONE);
+  counter.count = 0;
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, AdaptiveMutexIncrementFn, &counter));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(40000, counter.count);
+  ASSERT_EQ(0, pthread_mutex_destroy(&counter.mutex));
+}
+
+TEST(pthread, pthread_mutex_ROBUST_process_shared) {
+  void* map = mmap(NULL, sizeof(pthread_mutex_t), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, map);
+  pthread_mutex_t* m = reinterpret_cast<pthread_mutex_t*>(map);
+
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST));
+  ASSERT_EQ(0, pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED));
+  int error = pthread_mutex_init(m, &attr);
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+#if defined(__BIONIC__) && !defined(__LP64__)
+  // 32-bit robust mutexes keep their state in a process-local table.
+  ASSERT_EQ(ENOTSUP, error);
+#else
+  ASSERT_EQ(0, error);
+
+  // The kernel releases the mutex when the process holding it dies.
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    if (pthread_mutex_lock(m) != 0) {
+      _exit(1);
+    }
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  ASSERT_EQ(EOWNERDEAD, pthread_mutex_lock(m));
+  ASSERT_EQ(0, pthread_mutex_consistent(m));
+  ASSERT_EQ(0, pthread_mutex_unlock(m));
+  ASSERT_EQ(0, pthread_mutex_destroy(m));
+#endif
+  ASSERT_EQ(0, munmap(map, sizeof(pthread_mutex_t)));
+}
+
 TEST(pthread, pthread_attr_getstack__main_thread) {
   // This test is only meaningful for the main thread, so make sure we're running on it!
   ASSERT_EQ(getpid(), syscall(__NR_gettid));
@@ -907,3 +1768,97 @@ TEST(pthread, pthread_attr_getstack__main_thread) {
   EXPECT_EQ(stack_size, stack_size2);
   ASSERT_EQ(6666U, stack_size);
 }
+
+#if defined(__BIONIC__)
+static void* GetAlternateSignalStackFn(void* arg) {
+  stack_t* ss = reinterpret_cast<stack_t*>(arg);
+  sigaltstack(NULL, ss);
+  return NULL;
+}
+#endif
+
+TEST(pthread, alternate_signal_stack_below_guard) {
+#if defined(__BIONIC__)
+  pthread_attr_t attributes;
+  ASSERT_EQ(0, pthread_attr_init(&attributes));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attributes, 64 * 1024));
+
+  stack_t ss;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, &attributes, GetAlternateSignalStackFn, &ss));
+  void* stack_base;
+  size_t stack_size;
+  ASSERT_EQ(0, pthread_getattr_np(t, &attributes));
+  ASSERT_EQ(0, pthread_attr_getstack(&attributes, &stack_base, &stack_size));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  // The signal stack shares the thread's mapping, just below its guard.
+  ASSERT_EQ(0, ss.ss_flags);
+  ASSERT_EQ(static_cast<size_t>(SIGSTKSZ), ss.ss_size);
+  ASSERT_EQ(stack_base, reinterpret_cast<uint8_t*>(ss.ss_sp) + ss.ss_size);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+#if defined(__BIONIC__)
+struct StackUsageArg {
+  size_t depth;
+  int result;
+  size_t used;
+  size_t size;
+};
+
+static void* GetStackUsageFn(void* arg) {
+  StackUsageArg* a = reinterpret_cast<StackUsageArg*>(arg);
+  volatile char* buf = reinterpret_cast<volatile char*>(alloca(a->depth));
+  for (size_t i = 0; i < a->depth; i += 64) {
+    buf[i] = 1;
+  }
+  a->result = android_pthread_get_stack_usage(pthread_self(), &a->used, &a->size);
+  return NULL;
+}
+
+static void GetStackUsage(size_t stack_size, StackUsageArg* arg) {
+  pthread_attr_t attributes;
+  ASSERT_EQ(0, pthread_attr_init(&attributes));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attributes, stack_size));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, &attributes, GetStackUsageFn, arg));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+}
+#endif
+
+TEST(pthread, android_pthread_get_stack_usage) {
+#if defined(__BIONIC__)
+  // Odd stack sizes, so that neither thread gets a stack some other test has used.
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  StackUsageArg deep = { 256 * 1024, -1, 0, 0 };
+  GetStackUsage(1024 * 1024 + 7 * page_size, &deep);
+  ASSERT_EQ(0, deep.result);
+  ASSERT_EQ(1024 * 1024 + 7 * page_size, deep.size);
+  ASSERT_GE(deep.used, deep.depth);
+  ASSERT_LT(deep.used, deep.size);
+
+  StackUsageArg shallow = { 1024, -1, 0, 0 };
+  GetStackUsage(1024 * 1024 + 11 * page_size, &shallow);
+  ASSERT_EQ(0, shallow.result);
+  ASSERT_GE(shallow.used, shallow.depth);
+  ASSERT_LT(shallow.used, deep.depth);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(pthread, android_pthread_get_stack_usage__main_thread) {
+#if defined(__BIONIC__)
+  ASSERT_EQ(getpid(), syscall(__NR_gettid));
+  size_t used;
+  size_t size;
+  ASSERT_EQ(0, android_pthread_get_stack_usage(pthread_self(), &used, &size));
+  ASSERT_GT(used, 0U);
+  ASSERT_LE(used, size);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <pthread.h>
 #include <sys/types.h>
 #include <regex.h>
 
@@ -36,3 +37,113 @@ TEST(regex, smoke) {
 
   regfree(&re);
 }
+
+static void ExpectMatch(const regex_t* re, const char* s, regoff_t so, regoff_t eo) {
+  regmatch_t m;
+  ASSERT_EQ(0, regexec(re, s, 1, &m, 0)) << s;
+  ASSERT_EQ(so, m.rm_so) << s;
+  ASSERT_EQ(eo, m.rm_eo) << s;
+}
+
+TEST(regex, repeated_matching) {
+  // The same expression against many strings, as when filtering lines.
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "(foo|ba[rz])+[0-9]*x", REG_EXTENDED));
+  for (size_t i = 0; i < 100; ++i) {
+    ExpectMatch(&re, "foox", 0, 4);
+    ExpectMatch(&re, "--barbaz12x--", 2, 11);
+    ExpectMatch(&re, "fobarfoo9xx", 2, 10);
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "foo bar 12 x", 0, NULL, 0));
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "", 0, NULL, 0));
+  }
+  regfree(&re);
+}
+
+TEST(regex, literal_prefix) {
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "timeout after [0-9]+ms", REG_EXTENDED));
+  ExpectMatch(&re, "timeout after timeout after 50ms", 14, 32);
+  ExpectMatch(&re, "ttimeout after 7ms", 1, 18);
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "timeout after ms, timeout after 5", 0, NULL, 0));
+  regfree(&re);
+}
+
+TEST(regex, anchors_and_word_boundaries) {
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "^ab$", REG_EXTENDED | REG_NEWLINE));
+  ExpectMatch(&re, "xab\nab\nabc", 4, 6);
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "xab\nabc", 0, NULL, 0));
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "ab", 0, NULL, REG_NOTBOL));
+  regfree(&re);
+
+  ASSERT_EQ(0, regcomp(&re, "^ab", REG_EXTENDED));
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "x\nab", 0, NULL, 0));
+  regfree(&re);
+
+#if defined(__BIONIC__)
+  // glibc doesn't have these.
+  ASSERT_EQ(0, regcomp(&re, "[[:<:]]ab[[:>:]]", REG_EXTENDED));
+  for (size_t i = 0; i < 10; ++i) {
+    ExpectMatch(&re, "cab abc ab.", 8, 10);
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "cab abc _ab", 0, NULL, 0));
+  }
+  regfree(&re);
+#endif // __BIONIC__
+}
+
+TEST(regex, subexpressions) {
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "([a-z]+)@([a-z]+)\\.com", REG_EXTENDED));
+  regmatch_t m[3];
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_EQ(0, regexec(&re, "mail someone@example.com now", 3, m, 0));
+    ASSERT_EQ(5, m[1].rm_so);
+    ASSERT_EQ(12, m[1].rm_eo);
+    ASSERT_EQ(13, m[2].rm_so);
+    ASSERT_EQ(20, m[2].rm_eo);
+  }
+  regfree(&re);
+}
+
+TEST(regex, back_references) {
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "\\(a*\\)b\\1", 0));
+  ExpectMatch(&re, "xaabaa", 1, 6);
+  ExpectMatch(&re, "aaba", 1, 4);
+  regfree(&re);
+}
+
+struct RegexThreadArg {
+  regex_t* re;
+  bool ok;
+};
+
+static void* RegexThread(void* arg) {
+  RegexThreadArg* a = reinterpret_cast<RegexThreadArg*>(arg);
+  a->ok = true;
+  for (size_t i = 0; i < 2000; ++i) {
+    regmatch_t m;
+    if (regexec(a->re, "xx bazbar7x", 1, &m, 0) != 0 || m.rm_so != 3 || m.rm_eo != 11 ||
+        regexec(a->re, "foo bar", 0, NULL, 0) != REG_NOMATCH) {
+      a->ok = false;
+    }
+  }
+  return NULL;
+}
+
+TEST(regex, threads) {
+  // regexec may be called on the same expression from several threads.
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "(foo|ba[rz])+[0-9]*x", REG_EXTENDED));
+  pthread_t threads[4];
+  RegexThreadArg args[4];
+  for (size_t i = 0; i < 4; ++i) {
+    args[i].re = &re;
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, RegexThread, &args[i]));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    ASSERT_TRUE(args[i].ok);
+  }
+  regfree(&re);
+}
@@ -20,6 +20,7 @@
 #include <sched.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
 #if defined(__BIONIC__)
 static int child_fn(void* i_ptr) {
@@ -262,3 +263,74 @@ TEST(sched, cpu_equal_s) {
   CPU_FREE(set1);
   CPU_FREE(set2);
 }
+
+TEST(sched, sched_getclusters_np) {
+#if defined(__BIONIC__)
+  int count = sched_getclusters_np(NULL, 0);
+  ASSERT_GE(count, 1);
+
+  sched_cpu_cluster_t* clusters = new sched_cpu_cluster_t[count];
+  ASSERT_EQ(count, sched_getclusters_np(clusters, count));
+
+  // Every online CPU is in exactly one cluster, least capable clusters first.
+  cpu_set_t all;
+  CPU_ZERO(&all);
+  for (int i = 0; i < count; ++i) {
+    ASSERT_GT(CPU_COUNT(&clusters[i].cpus), 0);
+    cpu_set_t overlap;
+    CPU_AND(&overlap, &all, &clusters[i].cpus);
+    ASSERT_EQ(0, CPU_COUNT(&overlap));
+    CPU_OR(&all, &all, &clusters[i].cpus);
+    if (i > 0) {
+      ASSERT_LE(clusters[i - 1].capacity, clusters[i].capacity);
+    }
+  }
+  ASSERT_EQ(sysconf(_SC_NPROCESSORS_ONLN), CPU_COUNT(&all));
+  delete[] clusters;
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(sched, sched_setcluster_np) {
+#if defined(__BIONIC__)
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+  sched_cpu_cluster_t cluster;
+  ASSERT_GE(sched_getclusters_np(&cluster, 1), 1);
+  ASSERT_EQ(0, sched_setcluster_np(0));
+
+  cpu_set_t current;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(current), &current));
+  ASSERT_TRUE(CPU_EQUAL(&cluster.cpus, &current));
+  ASSERT_TRUE(CPU_ISSET(sched_getcpu(), &cluster.cpus));
+
+  errno = 0;
+  ASSERT_EQ(-1, sched_setcluster_np(CPU_SETSIZE));
+  ASSERT_EQ(EINVAL, errno);
+
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(sched, sched_getcpu_follows_affinity) {
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+  // Pin ourselves to each CPU in turn; the cached CPU must follow the migration.
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &original)) {
+      continue;
+    }
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(cpu, &pinned);
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(pinned), &pinned));
+    ASSERT_EQ(cpu, sched_getcpu());
+  }
+
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+}
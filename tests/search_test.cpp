@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <errno.h>
 #include <search.h>
 
 static int int_cmp(const void* lhs, const void* rhs) {
@@ -208,3 +209,170 @@ TEST(search, insque_remque) {
 
   remque(&zero);
 }
+
+static int g_max_level;
+static std::vector<int> g_walked;
+
+static void int_walk(const void* p, VISIT order, int level) {
+  if (level > g_max_level) {
+    g_max_level = level;
+  }
+  if (order == postorder || order == leaf) {
+    g_walked.push_back(**reinterpret_cast<int* const*>(p));
+  }
+}
+
+static int int_less(const void* lhs, const void* rhs) {
+  int l = *reinterpret_cast<const int*>(lhs);
+  int r = *reinterpret_cast<const int*>(rhs);
+  return (l < r) ? -1 : (l > r);
+}
+
+static void no_free(void*) {
+}
+
+TEST(search, tsearch_sorted_insertions) {
+  // Keys inserted in order mustn't make a tree that's really a list.
+  const int kCount = 10000;
+  std::vector<int> keys(kCount);
+  void* root = nullptr;
+  for (int i = 0; i < kCount; ++i) {
+    keys[i] = i;
+    void* node = tsearch(&keys[i], &root, int_less);
+    ASSERT_NE(nullptr, node);
+    ASSERT_EQ(&keys[i], *reinterpret_cast<int**>(node));
+  }
+  for (int i = 0; i < kCount; ++i) {
+    void* node = tfind(&i, &root, int_less);
+    ASSERT_NE(nullptr, node);
+    ASSERT_EQ(&keys[i], *reinterpret_cast<int**>(node));
+  }
+
+  g_max_level = 0;
+  g_walked.clear();
+  twalk(root, int_walk);
+  ASSERT_EQ(static_cast<size_t>(kCount), g_walked.size());
+  for (int i = 0; i < kCount; ++i) {
+    ASSERT_EQ(i, g_walked[i]);
+  }
+  ASSERT_LT(g_max_level, 28);  // Twice log2(kCount).
+
+  tdestroy(root, no_free);
+}
+
+TEST(search, tdelete_keeps_other_nodes) {
+  const int kCount = 2000;
+  std::vector<int> keys(kCount);
+  std::vector<void*> nodes(kCount);
+  void* root = nullptr;
+  for (int i = 0; i < kCount; ++i) {
+    keys[i] = i;
+    nodes[i] = tsearch(&keys[i], &root, int_less);
+    ASSERT_NE(nullptr, nodes[i]);
+  }
+
+  // Delete every third key, in a scrambled order.
+  for (int i = 0; i < kCount; ++i) {
+    int key = (i * 7919) % kCount;
+    if (key % 3 == 0) {
+      ASSERT_NE(nullptr, tdelete(&key, &root, int_less)) << key;
+      ASSERT_EQ(nullptr, tfind(&key, &root, int_less)) << key;
+    }
+  }
+
+  // The survivors are still there. Ours are even in the same nodes.
+  for (int i = 0; i < kCount; ++i) {
+    void* node = tfind(&i, &root, int_less);
+    if (i % 3 == 0) {
+      ASSERT_EQ(nullptr, node) << i;
+    } else {
+      ASSERT_NE(nullptr, node) << i;
+      ASSERT_EQ(&keys[i], *reinterpret_cast<int**>(node)) << i;
+#if defined(__BIONIC__)
+      ASSERT_EQ(nodes[i], node) << i;
+#endif
+    }
+  }
+
+  g_max_level = 0;
+  g_walked.clear();
+  twalk(root, int_walk);
+  ASSERT_EQ(static_cast<size_t>(kCount - (kCount + 2) / 3), g_walked.size());
+  for (size_t i = 1; i < g_walked.size(); ++i) {
+    ASSERT_LT(g_walked[i - 1], g_walked[i]);
+  }
+  ASSERT_LT(g_max_level, 22);  // Twice log2(kCount).
+
+  tdestroy(root, no_free);
+}
+
+TEST(search, hcreate_hsearch_hdestroy) {
+  ASSERT_NE(0, hcreate(4));
+
+  ENTRY e;
+  e.key = const_cast<char*>("one");
+  e.data = reinterpret_cast<void*>(1);
+  ENTRY* one = hsearch(e, ENTER);
+  ASSERT_TRUE(one != NULL);
+  ASSERT_STREQ("one", one->key);
+  ASSERT_EQ(reinterpret_cast<void*>(1), one->data);
+
+  // Entering an existing key returns the existing entry.
+  e.data = reinterpret_cast<void*>(2);
+  ASSERT_EQ(one, hsearch(e, ENTER));
+  ASSERT_EQ(reinterpret_cast<void*>(1), one->data);
+  ASSERT_EQ(one, hsearch(e, FIND));
+
+  e.key = const_cast<char*>("two");
+  ASSERT_TRUE(hsearch(e, FIND) == NULL);
+  ASSERT_EQ(ESRCH, errno);
+
+  hdestroy();
+}
+
+TEST(search, hsearch_r_grows) {
+  hsearch_data htab;
+  memset(&htab, 0, sizeof(htab));
+  ASSERT_NE(0, hcreate_r(1, &htab));
+
+#if defined(__BIONIC__)
+  // Far more entries than we asked for room for.
+  const size_t kCount = 10000;
+#else
+  // glibc's tables don't grow.
+  const size_t kCount = 1;
+#endif
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kCount; ++i) {
+    keys.push_back(std::to_string(i));
+  }
+  std::vector<ENTRY*> entries;
+  for (size_t i = 0; i < kCount; ++i) {
+    ENTRY e;
+    e.key = const_cast<char*>(keys[i].c_str());
+    e.data = reinterpret_cast<void*>(i);
+    ENTRY* result;
+    ASSERT_NE(0, hsearch_r(e, ENTER, &result, &htab)) << i;
+    entries.push_back(result);
+  }
+
+  // Entries don't move as the table grows.
+  for (size_t i = 0; i < kCount; ++i) {
+    ENTRY e;
+    e.key = const_cast<char*>(keys[i].c_str());
+    e.data = NULL;
+    ENTRY* result;
+    ASSERT_NE(0, hsearch_r(e, FIND, &result, &htab)) << i;
+    ASSERT_EQ(entries[i], result);
+    ASSERT_EQ(reinterpret_cast<void*>(i), result->data);
+  }
+
+  ENTRY e;
+  e.key = const_cast<char*>("missing");
+  ENTRY* result;
+  ASSERT_EQ(0, hsearch_r(e, FIND, &result, &htab));
+  ASSERT_TRUE(result == NULL);
+  ASSERT_EQ(ESRCH, errno);
+
+  hdestroy_r(&htab);
+}
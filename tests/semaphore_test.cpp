@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+static void* sem_post_fn(void* arg) {
+  usleep(10000);
+  sem_post(reinterpret_cast<sem_t*>(arg));
+  return NULL;
+}
+
+TEST(semaphore, sem_post_wakes_waiter) {
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 0));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, sem_post_fn, &s));
+  ASSERT_EQ(0, sem_wait(&s));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  int value;
+  ASSERT_EQ(0, sem_getvalue(&s, &value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(0, sem_destroy(&s));
+}
+
+TEST(semaphore, sem_init_SEM_VALUE_MAX) {
+  sem_t s;
+  long max = sysconf(_SC_SEM_VALUE_MAX);
+  ASSERT_EQ(0, sem_init(&s, 0, max));
+  errno = 0;
+  ASSERT_EQ(-1, sem_post(&s));
+  ASSERT_EQ(EOVERFLOW, errno);
+  ASSERT_EQ(0, sem_destroy(&s));
+
+  errno = 0;
+  ASSERT_EQ(-1, sem_init(&s, 0, max + 1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(semaphore, sem_timedwait) {
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 1));
+
+  // An expired timeout doesn't stop us taking an available semaphore...
+  timespec ts = { 0, 0 };
+  ASSERT_EQ(0, sem_timedwait(&s, &ts));
+
+  // ...but does once it's taken.
+  errno = 0;
+  ASSERT_EQ(-1, sem_timedwait(&s, &ts));
+  ASSERT_EQ(ETIMEDOUT, errno);
+
+  ts.tv_nsec = -1;
+  errno = 0;
+  ASSERT_EQ(-1, sem_timedwait(&s, &ts));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(0, sem_destroy(&s));
+}
+
+TEST(semaphore, sem_timedwait_monotonic_np) {
+#if defined(__BIONIC__)
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 0));
+
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &ts));
+  ts.tv_nsec += 10000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  errno = 0;
+  ASSERT_EQ(-1, sem_timedwait_monotonic_np(&s, &ts));
+  ASSERT_EQ(ETIMEDOUT, errno);
+
+  // A timed-out waiter doesn't stay counted as waiting.
+  ASSERT_EQ(0, sem_destroy(&s));
+  ASSERT_EQ(0, sem_init(&s, 0, 0));
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, sem_post_fn, &s));
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &ts));
+  ts.tv_sec += 10;
+  ASSERT_EQ(0, sem_timedwait_monotonic_np(&s, &ts));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_EQ(0, sem_destroy(&s));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
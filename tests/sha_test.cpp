@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#if defined(__BIONIC__)
+#include "../libc/bionic/sha.cpp"
+
+static std::string ToHex(const uint8_t* digest, size_t length) {
+  std::string result;
+  for (size_t i = 0; i < length; ++i) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", digest[i]);
+    result += hex;
+  }
+  return result;
+}
+
+static std::string Sha1(const std::string& s) {
+  uint8_t digest[BIONIC_SHA1_DIGEST_LENGTH];
+  __sha1(s.data(), s.size(), digest);
+  return ToHex(digest, sizeof(digest));
+}
+
+static std::string Sha256(const std::string& s) {
+  uint8_t digest[BIONIC_SHA256_DIGEST_LENGTH];
+  __sha256(s.data(), s.size(), digest);
+  return ToHex(digest, sizeof(digest));
+}
+#endif // __BIONIC__
+
+TEST(sha, sha1) {
+#if defined(__BIONIC__)
+  // The FIPS 180-2 examples.
+  ASSERT_EQ("da39a3ee5e6b4b0d3255bfef95601890afd80709", Sha1(""));
+  ASSERT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", Sha1("abc"));
+  ASSERT_EQ("84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+            Sha1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+  ASSERT_EQ("34aa973cd4c4daa4f61eeb2bdbad27316534016f", Sha1(std::string(1000000, 'a')));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(sha, sha256) {
+#if defined(__BIONIC__)
+  ASSERT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", Sha256(""));
+  ASSERT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", Sha256("abc"));
+  ASSERT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+            Sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+  ASSERT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+            Sha256(std::string(1000000, 'a')));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(sha, incremental) {
+#if defined(__BIONIC__)
+  // Feed every length up to a few blocks in pieces that straddle block boundaries.
+  std::string data;
+  for (size_t i = 0; i < 300; ++i) {
+    data += static_cast<char>(i * 7);
+  }
+  for (size_t length = 0; length <= data.size(); ++length) {
+    bionic_sha1_t sha1;
+    bionic_sha256_t sha256;
+    __sha1_init(&sha1);
+    __sha256_init(&sha256);
+    for (size_t i = 0; i < length; i += 13) {
+      size_t n = (length - i < 13) ? length - i : 13;
+      __sha1_update(&sha1, data.data() + i, n);
+      __sha256_update(&sha256, data.data() + i, n);
+    }
+    uint8_t sha1_digest[BIONIC_SHA1_DIGEST_LENGTH];
+    uint8_t sha256_digest[BIONIC_SHA256_DIGEST_LENGTH];
+    __sha1_final(&sha1, sha1_digest);
+    __sha256_final(&sha256, sha256_digest);
+    ASSERT_EQ(Sha1(data.substr(0, length)), ToHex(sha1_digest, sizeof(sha1_digest))) << length;
+    ASSERT_EQ(Sha256(data.substr(0, length)), ToHex(sha256_digest, sizeof(sha256_digest))) << length;
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(sha, accelerated_matches_portable) {
+#if defined(__BIONIC__)
+  // Whichever block functions this CPU gets must agree with the portable ones.
+  bionic_sha1_t init;
+  __sha1_init(&init);
+
+  uint8_t data[64 * 5];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(random());
+  }
+  for (size_t blocks = 1; blocks <= 5; ++blocks) {
+    uint32_t expected1[5] = { 1, 2, 3, 4, 5 };
+    uint32_t actual1[5] = { 1, 2, 3, 4, 5 };
+    sha1_blocks_c(expected1, data, blocks);
+    g_sha1_blocks(actual1, data, blocks);
+    ASSERT_EQ(0, memcmp(expected1, actual1, sizeof(expected1))) << blocks;
+
+    uint32_t expected256[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint32_t actual256[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    sha256_blocks_c(expected256, data, blocks);
+    g_sha256_blocks(actual256, data, blocks);
+    ASSERT_EQ(0, memcmp(expected256, actual256, sizeof(expected256))) << blocks;
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/shared_memory.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+TEST(shared_memory, create_and_seal) {
+#if defined(__BIONIC__)
+  int fd = android_shm_create("shared_memory_test", 8192);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(8192, android_shm_size(fd));
+
+  char* p = reinterpret_cast<char*>(mmap(NULL, 8192, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  ASSERT_NE(MAP_FAILED, p);
+  ASSERT_EQ(0, p[4096]);
+  strcpy(p, "hello");
+
+  // Once sealed read-only, nobody can map it writable, but it can be read.
+  ASSERT_EQ(0, android_shm_seal(fd, PROT_READ));
+  ASSERT_EQ(MAP_FAILED, mmap(NULL, 8192, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  char* q = reinterpret_cast<char*>(mmap(NULL, 8192, PROT_READ, MAP_SHARED, fd, 0));
+  ASSERT_NE(MAP_FAILED, q);
+  ASSERT_STREQ("hello", q);
+
+  // Seals can't be undone.
+  ASSERT_EQ(-1, android_shm_seal(fd, PROT_READ | PROT_WRITE));
+
+  munmap(q, 8192);
+  munmap(p, 8192);
+  close(fd);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(shared_memory, ring) {
+#if defined(__BIONIC__)
+  errno = 0;
+  ASSERT_TRUE(android_shm_ring_create("bad", 1000) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+
+  android_shm_ring_t* writer = android_shm_ring_create("shared_memory_test", 16);
+  ASSERT_TRUE(writer != NULL);
+  android_shm_ring_t* reader = android_shm_ring_map(android_shm_ring_fd(writer));
+  ASSERT_TRUE(reader != NULL);
+
+  char buf[32];
+  ASSERT_EQ(0, android_shm_ring_read(reader, buf, sizeof(buf)));
+  ASSERT_EQ(10U, android_shm_ring_write(writer, "0123456789", 10));
+  ASSERT_EQ(4, android_shm_ring_read(reader, buf, 4));
+  ASSERT_EQ("0123", std::string(buf, 4));
+
+  // Only as much as there's room for goes in, wrapping around the end.
+  ASSERT_EQ(10U, android_shm_ring_write(writer, "abcdefghijklmnop", 16));
+  ASSERT_EQ(0U, android_shm_ring_write(writer, "x", 1));
+  ASSERT_EQ(16, android_shm_ring_read(reader, buf, sizeof(buf)));
+  ASSERT_EQ("456789abcdefghij", std::string(buf, 16));
+
+  android_shm_ring_destroy(reader);
+  android_shm_ring_destroy(writer);
+
+  // Regions that aren't rings are rejected.
+  int fd = android_shm_create("not a ring", 4 * 4096);
+  ASSERT_NE(-1, fd);
+  errno = 0;
+  ASSERT_TRUE(android_shm_ring_map(fd) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+  close(fd);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(shared_memory, ring_across_fork) {
+#if defined(__BIONIC__)
+  android_shm_ring_t* ring = android_shm_ring_create("shared_memory_test", 4096);
+  ASSERT_TRUE(ring != NULL);
+
+  const size_t kTotal = 1024 * 1024;
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    android_shm_ring_t* child = android_shm_ring_map(android_shm_ring_fd(ring));
+    if (child == NULL) {
+      _exit(1);
+    }
+    char buf[1000];
+    for (size_t sent = 0; sent < kTotal; ) {
+      size_t n = kTotal - sent < sizeof(buf) ? kTotal - sent : sizeof(buf);
+      for (size_t i = 0; i < n; ++i) {
+        buf[i] = static_cast<char>((sent + i) % 251);
+      }
+      size_t written = android_shm_ring_write(child, buf, n);
+      sent += written;
+      if (written == 0) {
+        sched_yield();
+      }
+    }
+    _exit(0);
+  }
+
+  char buf[777];
+  size_t received = 0;
+  while (received < kTotal) {
+    ssize_t n = android_shm_ring_read(ring, buf, sizeof(buf));
+    ASSERT_NE(-1, n);
+    for (ssize_t i = 0; i < n; ++i) {
+      ASSERT_EQ(static_cast<char>((received + i) % 251), buf[i]) << received + i;
+    }
+    received += n;
+    if (n == 0) {
+      sched_yield();
+    }
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  android_shm_ring_destroy(ring);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
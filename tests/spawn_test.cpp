@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static void AssertChildExited(pid_t pid, int expected_status) {
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(expected_status, WEXITSTATUS(status));
+}
+
+TEST(spawn, posix_spawnp_exit_status) {
+  char* const argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"),
+                         const_cast<char*>("exit 7"), NULL };
+  pid_t pid;
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", NULL, NULL, argv, environ));
+  AssertChildExited(pid, 7);
+}
+
+TEST(spawn, posix_spawn_ENOENT) {
+  char* const argv[] = { const_cast<char*>("does-not-exist"), NULL };
+  errno = 0;
+  pid_t pid;
+  ASSERT_EQ(ENOENT, posix_spawn(&pid, "/does/not/exist", NULL, NULL, argv, environ));
+#if defined(__BIONIC__)
+  // The error comes back as the result, not in errno.
+  ASSERT_EQ(0, errno);
+#endif
+  // posix_spawnp doesn't search PATH for names containing a '/'.
+  ASSERT_EQ(ENOENT, posix_spawnp(&pid, "/does/not/exist", NULL, NULL, argv, environ));
+}
+
+TEST(spawn, posix_spawn_file_actions) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(0, posix_spawn_file_actions_addclose(&actions, fds[0]));
+  ASSERT_EQ(0, posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO));
+  ASSERT_EQ(0, posix_spawn_file_actions_addclose(&actions, fds[1]));
+  ASSERT_EQ(0, posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0));
+  ASSERT_EQ(EBADF, posix_spawn_file_actions_addclose(&actions, -1));
+
+  char* const argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"),
+                         const_cast<char*>("cat; echo hello"), NULL };
+  pid_t pid;
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", &actions, NULL, argv, environ));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+  close(fds[1]);
+
+  char buf[32];
+  ssize_t n = TEMP_FAILURE_RETRY(read(fds[0], buf, sizeof(buf)));
+  ASSERT_EQ(6, n);
+  ASSERT_EQ(0, memcmp("hello\n", buf, 6));
+  close(fds[0]);
+  AssertChildExited(pid, 0);
+}
+
+TEST(spawn, posix_spawnattr) {
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+
+  short flags;
+  ASSERT_EQ(0, posix_spawnattr_getflags(&attr, &flags));
+  ASSERT_EQ(0, flags);
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK));
+  ASSERT_EQ(0, posix_spawnattr_getflags(&attr, &flags));
+  ASSERT_EQ(POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK, flags);
+
+  ASSERT_EQ(0, posix_spawnattr_setpgroup(&attr, 0));
+  sigset_t mask;
+  sigemptyset(&mask);
+  ASSERT_EQ(0, posix_spawnattr_setsigmask(&attr, &mask));
+
+  // The child gets a process group of its own.
+  char* const argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"),
+                         const_cast<char*>("exit 0"), NULL };
+  pid_t pid;
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", NULL, &attr, argv, environ));
+  // Look at the pgid while the child's still a zombie, then reap it.
+  siginfo_t info;
+  ASSERT_EQ(0, TEMP_FAILURE_RETRY(waitid(P_PID, pid, &info, WEXITED | WNOWAIT)));
+  ASSERT_EQ(pid, getpgid(pid));
+  AssertChildExited(pid, 0);
+
+  ASSERT_EQ(EINVAL, posix_spawnattr_setflags(&attr, 0x4000));
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/startup_trace.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST(startup_trace, disabled) {
+#if defined(__BIONIC__)
+  if (getenv("LIBC_STARTUP_TRACE") != NULL) {
+    GTEST_LOG_(INFO) << "Started with LIBC_STARTUP_TRACE set; skipping.\n";
+    return;
+  }
+  uint64_t timestamps[ANDROID_STARTUP_PHASE_COUNT];
+  ASSERT_EQ(0U, android_get_startup_trace(timestamps, ANDROID_STARTUP_PHASE_COUNT));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(startup_trace, enabled) {
+#if defined(__BIONIC__)
+  if (getenv("LIBC_STARTUP_TRACE") == NULL) {
+    // Run just this test again in a process started with tracing on.
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+      setenv("LIBC_STARTUP_TRACE", "1", 1);
+      execl("/proc/self/exe", "/proc/self/exe", "--gtest_filter=startup_trace.enabled", NULL);
+      _exit(127);
+    }
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+    return;
+  }
+
+  uint64_t timestamps[ANDROID_STARTUP_PHASE_COUNT];
+  ASSERT_EQ(static_cast<size_t>(ANDROID_STARTUP_PHASE_COUNT),
+            android_get_startup_trace(timestamps, ANDROID_STARTUP_PHASE_COUNT));
+
+  // Static executables have no linker phases; everything else is in order.
+  uint64_t previous = 0;
+  for (size_t i = 0; i < ANDROID_STARTUP_PHASE_COUNT; ++i) {
+    if (timestamps[i] == 0) {
+      ASSERT_LT(i, static_cast<size_t>(ANDROID_STARTUP_LIBC_INIT));
+      continue;
+    }
+    ASSERT_LE(previous, timestamps[i]) << i;
+    previous = timestamps[i];
+  }
+
+  // A short buffer gets the first phases only.
+  uint64_t first;
+  ASSERT_EQ(static_cast<size_t>(ANDROID_STARTUP_PHASE_COUNT), android_get_startup_trace(&first, 1));
+  ASSERT_EQ(timestamps[0], first);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
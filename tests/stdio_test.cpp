@@ -20,13 +20,21 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdio_ext.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <wchar.h>
 #include <locale.h>
 
+#include <set>
+#include <string>
+#include <vector>
+
 #include "TemporaryFile.h"
 
 TEST(stdio, flockfile_18208568_stderr) {
@@ -71,6 +79,18 @@ TEST(stdio, tmpfile_fileno_fprintf_rewind_fgets) {
   fclose(fp);
 }
 
+TEST(stdio, tmpfile_has_no_name) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+
+  // Whether it was made without a name or unlinked afterwards, nothing links to the file.
+  struct stat sb;
+  ASSERT_EQ(0, fstat(fileno(fp), &sb));
+  ASSERT_EQ(0U, sb.st_nlink);
+
+  fclose(fp);
+}
+
 TEST(stdio, dprintf) {
   TemporaryFile tf;
 
@@ -426,6 +446,81 @@ TEST(stdio, snprintf_lld_LLONG_MIN) {
   EXPECT_STREQ("-9223372036854775808", buf);
 }
 
+TEST(stdio, snprintf_plain_conversions) {
+  // Formats without flags, width or precision take a separate path.
+  char buf[BUFSIZ];
+  EXPECT_EQ(90, snprintf(buf, sizeof(buf), "%d %i %u %x %X %c%% %s %hd %hhu %ld %lld %llx %zu %jd",
+                         INT_MIN, 0, UINT_MAX, 0xdeadU, 0xbeefU, 'c', "str", 65537, 257,
+                         -10L, LLONG_MAX, 0x123456789abcULL, static_cast<size_t>(100),
+                         static_cast<intmax_t>(-99)));
+  EXPECT_STREQ("-2147483648 0 4294967295 dead BEEF c% str 1 1 -10 9223372036854775807 123456789abc 100 -99", buf);
+
+#if defined(__BIONIC__) // glibc prints "(nil)".
+  EXPECT_EQ(3, snprintf(buf, sizeof(buf), "%p", reinterpret_cast<void*>(0)));
+  EXPECT_STREQ("0x0", buf);
+#endif
+  EXPECT_EQ(6, snprintf(buf, sizeof(buf), "%p", reinterpret_cast<void*>(0x1234)));
+  EXPECT_STREQ("0x1234", buf);
+  EXPECT_EQ(8, snprintf(buf, sizeof(buf), "<%s>", static_cast<const char*>(NULL)));
+  EXPECT_STREQ("<(null)>", buf);
+
+  // Truncated output still reports the full length.
+  EXPECT_EQ(13, snprintf(buf, 6, "%s=%d", "value", 1234567));
+  EXPECT_STREQ("value", buf);
+  EXPECT_EQ(10, snprintf(NULL, 0, "%d", 1234567890));
+}
+
+TEST(stdio, fprintf_plain_conversions_line_buffered) {
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(0, setvbuf(fp, NULL, _IOLBF, BUFSIZ));
+  char buf[16];
+  ASSERT_EQ(5, fprintf(fp, "%d", 12345));
+  ASSERT_EQ(0, pread(tf.fd, buf, sizeof(buf), 0));
+  // A newline sends the line on its way.
+  ASSERT_EQ(5, fprintf(fp, "%s\n%d", "ab", 99));
+  ASSERT_LE(8, pread(tf.fd, buf, sizeof(buf), 0));
+  ASSERT_EQ(0, memcmp("12345ab\n", buf, 8));
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ(10, pread(tf.fd, buf, sizeof(buf), 0));
+  ASSERT_EQ(0, memcmp("12345ab\n99", buf, 10));
+}
+
+TEST(stdio, fprintf_and_fputs_line_buffered) {
+  // The fast path and __sfvwrite have to agree on how full the buffer is,
+  // or the latter writes past its end. Guard bytes follow our buffer.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "w");
+  ASSERT_TRUE(fp != NULL);
+  char stream_buf[64 + 16];
+  memset(stream_buf, 'G', sizeof(stream_buf));
+  ASSERT_EQ(0, setvbuf(fp, stream_buf, _IOLBF, 64));
+
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    char number[16];
+    snprintf(number, sizeof(number), "%d", i);
+    ASSERT_EQ(static_cast<int>(strlen(number)), fprintf(fp, "%d", i));
+    ASSERT_LE(0, fputs("abcdefghij", fp));
+    expected += number;
+    expected += "abcdefghij";
+    if (i % 10 == 9) {
+      ASSERT_EQ(1, fprintf(fp, "\n"));
+      expected += "\n";
+    }
+  }
+  for (size_t i = 64; i < sizeof(stream_buf); ++i) {
+    ASSERT_EQ('G', stream_buf[i]) << i;
+  }
+  ASSERT_EQ(0, fclose(fp));
+
+  std::vector<char> contents(expected.size() + 1);
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()),
+            pread(tf.fd, &contents[0], contents.size(), 0));
+  ASSERT_EQ(expected, std::string(&contents[0], expected.size()));
+}
+
 TEST(stdio, snprintf_e) {
   char buf[BUFSIZ];
 
@@ -436,6 +531,20 @@ TEST(stdio, snprintf_e) {
   EXPECT_STREQ("1.500000e+00", buf);
 }
 
+TEST(stdio, snprintf_floating_point_rounding) {
+  char buf[BUFSIZ];
+
+  // Exact binary values, rounded half to even.
+  snprintf(buf, sizeof(buf), "%.17g %.20f %.15g", 0.1, 0.1, 1.0/3);
+  EXPECT_STREQ("0.10000000000000001 0.10000000000000000555 0.333333333333333", buf);
+  snprintf(buf, sizeof(buf), "%.0f %.0f %.0f %.1f %.2f", 0.5, 1.5, 2.5, 0.25, 2.675);
+  EXPECT_STREQ("0 2 2 0.2 2.67", buf);
+  snprintf(buf, sizeof(buf), "%.3f %.2f %.3e", 0.0005, 0.001, 9.9995);
+  EXPECT_STREQ("0.001 0.00 9.999e+00", buf);
+  snprintf(buf, sizeof(buf), "%e %g %g %g", 1e23, 123456789.0, 1e-5, 0.3);
+  EXPECT_STREQ("1.000000e+23 1.23457e+08 1e-05 0.3", buf);
+}
+
 TEST(stdio, snprintf_negative_zero_5084292) {
   char buf[BUFSIZ];
 
@@ -502,6 +611,69 @@ TEST(stdio, popen) {
   ASSERT_EQ(0, pclose(fp));
 }
 
+TEST(stdio, popen_write_and_status) {
+  TemporaryFile tf;
+  std::string command = "cat > " + std::string(tf.filename) + "; exit 3";
+  FILE* fp = popen(command.c_str(), "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  int status = pclose(fp);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(3, WEXITSTATUS(status));
+
+  char buf[16];
+  ASSERT_EQ(5, read(tf.fd, buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp("hello", buf, 5));
+}
+
+TEST(stdio, popen_cloexec_and_isolation) {
+  FILE* fp1 = popen("cat > /dev/null", "w");
+  ASSERT_TRUE(fp1 != NULL);
+  ASSERT_EQ(0, fcntl(fileno(fp1), F_GETFD) & FD_CLOEXEC);
+  FILE* fp2 = popen("cat", "re");
+  ASSERT_TRUE(fp2 != NULL);
+  ASSERT_EQ(FD_CLOEXEC, fcntl(fileno(fp2), F_GETFD) & FD_CLOEXEC);
+  ASSERT_EQ(0, pclose(fp2));
+
+  // Later children don't inherit earlier streams.
+  char command[64];
+  snprintf(command, sizeof(command), "test -e /proc/self/fd/%d && echo leaked", fileno(fp1));
+  FILE* fp3 = popen(command, "r");
+  ASSERT_TRUE(fp3 != NULL);
+  char buf[16];
+  ASSERT_TRUE(fgets(buf, sizeof(buf), fp3) == NULL);
+  pclose(fp3);
+
+  ASSERT_EQ(0, pclose(fp1));
+}
+
+TEST(stdio, popen_two_way) {
+  FILE* fp = popen("read line; echo \"got $line\"", "r+");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(6, fprintf(fp, "hello\n"));
+  ASSERT_EQ(0, fflush(fp));
+  char buf[16];
+  ASSERT_TRUE(fgets(buf, sizeof(buf), fp) != NULL);
+  ASSERT_STREQ("got hello\n", buf);
+  ASSERT_EQ(0, pclose(fp));
+}
+
+TEST(stdio, popen_bad_type) {
+  const char* types[] = { "", "x", "rw", "wr", "rx" };
+  for (size_t i = 0; i < sizeof(types)/sizeof(types[0]); ++i) {
+    errno = 0;
+    ASSERT_TRUE(popen("true", types[i]) == NULL) << types[i];
+    ASSERT_EQ(EINVAL, errno) << types[i];
+  }
+}
+
+TEST(stdio, pclose_not_popened) {
+  FILE* fp = fopen("/proc/version", "r");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(-1, pclose(fp));
+  fclose(fp);
+}
+
 TEST(stdio, getc) {
   FILE* fp = fopen("/proc/version", "r");
   ASSERT_TRUE(fp != NULL);
@@ -725,3 +897,429 @@ TEST(stdio, fread_unbuffered_pathological_performance) {
     ASSERT_EQ('\xff', buf[i]);
   }
 }
+
+TEST(stdio, fread_large_buffered) {
+  // Large reads from a buffered stream bypass the buffer; mix them with
+  // small reads, ungetc and ftell to check nothing gets lost or reordered.
+  TemporaryFile tf;
+  std::vector<char> data(1024 * 1024 + 123);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), write(tf.fd, &data[0], data.size()));
+
+  FILE* fp = fopen(tf.filename, "r");
+  ASSERT_TRUE(fp != NULL);
+  std::vector<char> buf(data.size());
+  size_t pos = 0;
+
+  ASSERT_EQ(10U, fread(&buf[pos], 1, 10, fp));
+  pos += 10;
+  ASSERT_EQ(300000U, fread(&buf[pos], 1, 300000, fp));
+  pos += 300000;
+  ASSERT_EQ(static_cast<long>(pos), ftell(fp));
+
+  ASSERT_EQ(data[pos], static_cast<char>(fgetc(fp)));
+  ASSERT_EQ(static_cast<unsigned char>(data[pos]), ungetc(data[pos], fp));
+  ASSERT_EQ(200000U, fread(&buf[pos], 1, 200000, fp));
+  pos += 200000;
+  ASSERT_EQ(5U, fread(&buf[pos], 1, 5, fp));
+  pos += 5;
+
+  // Ask for more than is left.
+  ASSERT_EQ(data.size() - pos, fread(&buf[pos], 1, data.size(), fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_FALSE(ferror(fp));
+  ASSERT_EQ(static_cast<long>(data.size()), ftell(fp));
+  ASSERT_TRUE(data == buf);
+
+  fclose(fp);
+}
+
+static void CheckLargeBufferedWrites(const char* mode) {
+  // Large writes to a stream with pending output skip the copy into the
+  // buffer; the file should look exactly as if they hadn't.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, mode);
+  ASSERT_TRUE(fp != NULL);
+  std::vector<char> record(64 * 1024 + 7);
+  std::string expected;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < record.size(); ++j) {
+      record[j] = static_cast<char>('a' + (i + j) % 26);
+    }
+    ASSERT_NE(EOF, fputs("header\n", fp));
+    ASSERT_EQ(record.size(), fwrite(&record[0], 1, record.size(), fp));
+    expected += "header\n";
+    expected.append(record.begin(), record.end());
+  }
+  ASSERT_NE(EOF, fputs("trailer\n", fp));
+  expected += "trailer\n";
+  ASSERT_EQ(static_cast<long>(expected.size()), ftell(fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  std::vector<char> actual(expected.size() + 1);
+  int fd = open(tf.filename, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), read(fd, &actual[0], actual.size()));
+  close(fd);
+  ASSERT_EQ(0, memcmp(expected.data(), &actual[0], expected.size()));
+}
+
+TEST(stdio, fwrite_large_buffered) {
+  CheckLargeBufferedWrites("w");
+}
+
+TEST(stdio, fwrite_large_buffered_append) {
+  CheckLargeBufferedWrites("a");
+}
+
+TEST(stdio, fopen_fclose_many_streams) {
+  std::vector<FILE*> streams;
+  for (size_t i = 0; i < 500; ++i) {
+    FILE* fp = fopen("/dev/null", "w");
+    ASSERT_TRUE(fp != NULL);
+    ASSERT_EQ(1, fprintf(fp, "x"));
+    streams.push_back(fp);
+  }
+
+  // Closed FILEs get reused, even when opens fail in between.
+  std::set<FILE*> closed;
+  for (size_t i = 0; i < streams.size(); i += 2) {
+    closed.insert(streams[i]);
+    ASSERT_EQ(0, fclose(streams[i]));
+  }
+  for (size_t i = 0; i < streams.size(); i += 2) {
+    ASSERT_TRUE(fopen("/does-not-exist", "r") == NULL);
+    streams[i] = fopen("/dev/null", "w");
+    ASSERT_TRUE(streams[i] != NULL);
+#if defined(__BIONIC__)
+    ASSERT_EQ(1U, closed.erase(streams[i]));
+#endif
+  }
+
+  for (size_t i = 0; i < streams.size(); ++i) {
+    ASSERT_EQ(0, fclose(streams[i]));
+  }
+}
+
+TEST(stdio, fopen_mmap) {
+  TemporaryFile tf;
+  std::string data;
+  for (size_t i = 0; data.size() < 256 * 1024; ++i) {
+    data += "line " + std::to_string(i) + "\n";
+  }
+  data += "no newline";
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), write(tf.fd, data.data(), data.size()));
+
+  FILE* fp = fopen(tf.filename, "rem");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(FD_CLOEXEC, fcntl(fileno(fp), F_GETFD) & FD_CLOEXEC);
+
+  char line[64];
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_STREQ("line 0\n", line);
+  ASSERT_EQ(7, ftell(fp));
+  ASSERT_EQ('l', getc(fp));
+  ASSERT_EQ('Z', ungetc('Z', fp));
+  ASSERT_EQ('Z', getc(fp));
+
+  // Read the rest line by line.
+  char* buf = NULL;
+  size_t size = 0;
+  std::string rest;
+  ssize_t n;
+  while ((n = getline(&buf, &size, fp)) != -1) {
+    rest.append(buf, n);
+  }
+  free(buf);
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(data.substr(8), rest);
+  ASSERT_EQ(static_cast<long>(data.size()), ftell(fp));
+
+  // Seeks anywhere, including past the end.
+  ASSERT_EQ(0, fseek(fp, -10, SEEK_END));
+  ASSERT_FALSE(feof(fp));
+  ASSERT_EQ(10U, fread(line, 1, sizeof(line), fp));
+  ASSERT_EQ(0, memcmp("no newline", line, 10));
+  ASSERT_EQ(0, fseek(fp, 100, SEEK_SET));
+  ASSERT_EQ(data[100], static_cast<char>(getc(fp)));
+  ASSERT_EQ(0, fseek(fp, 50, SEEK_END));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_EQ(-1, fseek(fp, -1, SEEK_SET));
+  ASSERT_EQ(EINVAL, errno);
+
+  // Large reads and a replacement buffer.
+  rewind(fp);
+  std::vector<char> all(data.size());
+  ASSERT_EQ(all.size(), fread(&all[0], 1, all.size(), fp));
+  ASSERT_EQ(0, memcmp(data.data(), &all[0], all.size()));
+  rewind(fp);
+  ASSERT_EQ(0, setvbuf(fp, NULL, _IOFBF, 1024));
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_STREQ("line 0\n", line);
+
+  ASSERT_EQ(EOF, fputc('x', fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(stdio, fopen_mmap_not_mappable) {
+  // Files that can't be mapped are read the ordinary way.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "rm");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  fp = fopen("/proc/self/maps", "rm");
+  ASSERT_TRUE(fp != NULL);
+  char line[256];
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  // 'm' is ignored for streams that can be written.
+  fp = fopen(tf.filename, "r+m");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  rewind(fp);
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_STREQ("hello", line);
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(stdio, unlocked_functions) {
+  TemporaryFile tf;
+  FILE* fp = fdopen(tf.fd, "w+");
+  ASSERT_TRUE(fp != NULL);
+
+  flockfile(fp);
+  ASSERT_EQ('a', fputc_unlocked('a', fp));
+  ASSERT_EQ(5U, fwrite_unlocked("bcde\n", 1, 5, fp));
+  ASSERT_EQ(0, fflush_unlocked(fp));
+  rewind(fp);
+  char buf[16];
+  ASSERT_EQ(buf, fgets_unlocked(buf, sizeof(buf), fp));
+  ASSERT_STREQ("abcde\n", buf);
+  rewind(fp);
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(3U, fread_unlocked(buf, 1, 3, fp));
+  ASSERT_STREQ("abc", buf);
+  funlockfile(fp);
+
+  ASSERT_EQ(0, fclose(fp));
+}
+
+static void* LockAndWait(void* arg) {
+  FILE* fp = reinterpret_cast<FILE*>(arg);
+  flockfile(fp);
+  sleep(1);
+  funlockfile(fp);
+  return NULL;
+}
+
+TEST(stdio, __fsetlocking) {
+  FILE* fp = fopen("/dev/null", "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(FSETLOCKING_INTERNAL, __fsetlocking(fp, FSETLOCKING_QUERY));
+  ASSERT_EQ(FSETLOCKING_INTERNAL, __fsetlocking(fp, FSETLOCKING_BYCALLER));
+  ASSERT_EQ(FSETLOCKING_BYCALLER, __fsetlocking(fp, FSETLOCKING_QUERY));
+
+  // With the caller in charge of locking, stdio doesn't wait for the lock
+  // another thread is holding.
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, LockAndWait, fp));
+  while (ftrylockfile(fp) == 0) {
+    funlockfile(fp);
+    usleep(1000);
+  }
+  timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ASSERT_EQ(1, fprintf(fp, "x"));
+  ASSERT_EQ(0, fflush(fp));
+  timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  int64_t elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+  ASSERT_LT(elapsed_ms, 500);
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  ASSERT_EQ(FSETLOCKING_BYCALLER, __fsetlocking(fp, FSETLOCKING_INTERNAL));
+  ASSERT_EQ(FSETLOCKING_INTERNAL, __fsetlocking(fp, FSETLOCKING_QUERY));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(stdio, fflush_NULL) {
+  // Lots of streams that were written to and closed.
+  for (int i = 0; i < 100; ++i) {
+    FILE* fp = fopen("/dev/null", "w");
+    ASSERT_TRUE(fp != NULL);
+    ASSERT_EQ('x', fputc('x', fp));
+    ASSERT_EQ(0, fclose(fp));
+  }
+  FILE* idle = fopen("/dev/null", "r");
+  ASSERT_TRUE(idle != NULL);
+
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  char* buf = NULL;
+  size_t size = 0;
+  FILE* ms = open_memstream(&buf, &size);
+  ASSERT_TRUE(ms != NULL);
+  ASSERT_EQ(5, fprintf(ms, "world"));
+
+  ASSERT_EQ(0, fflush(NULL));
+  char data[8];
+  ASSERT_EQ(5, pread(tf.fd, data, sizeof(data), 0));
+  ASSERT_EQ(0, memcmp("hello", data, 5));
+  ASSERT_EQ(5U, size);
+  ASSERT_STREQ("world", buf);
+
+  ASSERT_EQ(0, fclose(ms));
+  free(buf);
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ(0, fclose(idle));
+}
+
+TEST(stdio, fflush_NULL_setvbuf) {
+  // A "w" stream given its buffer by setvbuf never goes through __swsetup.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "w");
+  ASSERT_TRUE(fp != NULL);
+  char buf[64];
+  ASSERT_EQ(0, setvbuf(fp, buf, _IOFBF, sizeof(buf)));
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+
+  ASSERT_EQ(0, fflush(NULL));
+  char data[8];
+  ASSERT_EQ(5, pread(tf.fd, data, sizeof(data), 0));
+  ASSERT_EQ(0, memcmp("hello", data, 5));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(stdio, open_memstream) {
+  char* buf = NULL;
+  size_t size = 0;
+  FILE* fp = open_memstream(&buf, &size);
+  ASSERT_TRUE(fp != NULL);
+
+  std::string expected;
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_GT(fprintf(fp, "%d,", i), 0);
+    expected += std::to_string(i) + ",";
+  }
+  std::vector<char> big(256 * 1024, 'x');
+  ASSERT_EQ(big.size(), fwrite(&big[0], 1, big.size(), fp));
+  expected.append(big.begin(), big.end());
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(expected.size(), size);
+  ASSERT_EQ(expected, std::string(buf, size));
+  ASSERT_EQ('\0', buf[size]);
+
+  // The size is the position, even after seeking backwards.
+  ASSERT_EQ(0, fseek(fp, 2, SEEK_SET));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(2U, size);
+
+  // Writing past the end fills the gap with NULs.
+  ASSERT_EQ(0, fseek(fp, expected.size() + 4, SEEK_SET));
+  ASSERT_EQ(1, fprintf(fp, "!"));
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ(expected.size() + 5, size);
+  ASSERT_EQ(0, memcmp(buf + expected.size(), "\0\0\0\0!", 6));
+  free(buf);
+}
+
+TEST(stdio, open_memstream_EINVAL) {
+#if defined(__BIONIC__) // glibc doesn't check.
+  char* buf;
+  size_t size;
+  errno = 0;
+  ASSERT_TRUE(open_memstream(NULL, &size) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_TRUE(open_memstream(&buf, NULL) == NULL);
+  ASSERT_EQ(EINVAL, errno);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(stdio, fmemopen_write) {
+  char buf[16];
+  memset(buf, 'x', sizeof(buf));
+  FILE* fp = fmemopen(buf, sizeof(buf), "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_STREQ("hello", buf);
+  ASSERT_EQ(5, ftell(fp));
+
+  // Only what fits gets written.
+  fprintf(fp, " world, and then some");
+  ASSERT_EQ(EOF, fflush(fp));
+  ASSERT_TRUE(ferror(fp));
+#if defined(__BIONIC__) // glibc keeps the last byte for a NUL.
+  ASSERT_EQ(0, memcmp("hello world, and", buf, sizeof(buf)));
+#endif
+  fclose(fp);
+}
+
+TEST(stdio, fmemopen_read) {
+  char buf[] = "line one\nline two\nthree";
+  FILE* fp = fmemopen(buf, strlen(buf), "r");
+  ASSERT_TRUE(fp != NULL);
+  char line[64];
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_STREQ("line one\n", line);
+  ASSERT_EQ(9, ftell(fp));
+  ASSERT_EQ('l', getc(fp));
+  ASSERT_EQ('Z', ungetc('Z', fp));
+  ASSERT_EQ('Z', getc(fp));
+  ASSERT_EQ(0, fseek(fp, -5, SEEK_END));
+  ASSERT_EQ(5U, fread(line, 1, sizeof(line), fp));
+  ASSERT_EQ(0, memcmp("three", line, 5));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(0, fclose(fp));
+  // Reading never touches the buffer.
+  ASSERT_STREQ("line one\nline two\nthree", buf);
+}
+
+TEST(stdio, fmemopen_read_write) {
+  FILE* fp = fmemopen(NULL, 64, "w+");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(8, fprintf(fp, "abc\ndef\n"));
+  rewind(fp);
+  char line[64];
+  ASSERT_EQ(line, fgets(line, sizeof(line), fp));
+  ASSERT_STREQ("abc\n", line);
+  ASSERT_EQ(0, fseek(fp, 0, SEEK_CUR));
+  ASSERT_EQ(2, fprintf(fp, "XY"));
+  rewind(fp);
+  ASSERT_EQ(8U, fread(line, 1, sizeof(line), fp));
+  ASSERT_EQ(0, memcmp("abc\nXYf\n", line, 8));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(stdio, fmemopen_append) {
+  char buf[32] = "start";
+  FILE* fp = fmemopen(buf, sizeof(buf), "a");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, ftell(fp));
+  ASSERT_EQ(5, fprintf(fp, "-more"));
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_STREQ("start-more", buf);
+}
+
+TEST(stdio, fmemopen_EINVAL) {
+  char buf[16];
+#if defined(__BIONIC__) // glibc allows empty buffers.
+  errno = 0;
+  ASSERT_TRUE(fmemopen(buf, 0, "r") == NULL);
+  ASSERT_EQ(EINVAL, errno);
+#endif
+  errno = 0;
+  ASSERT_TRUE(fmemopen(buf, sizeof(buf), "q") == NULL);
+  ASSERT_EQ(EINVAL, errno);
+}
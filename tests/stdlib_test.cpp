@@ -20,12 +20,20 @@
 #include <errno.h>
 #include <libgen.h>
 #include <limits.h>
+#include <math.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
 
 TEST(stdlib, drand48) {
   srand48(0x01020304);
@@ -115,6 +123,54 @@ TEST(stdlib, realpath) {
   free(p);
 }
 
+TEST(stdlib, realpath__symlinks_and_dots) {
+  TemporaryDir td;
+  char old_cwd[PATH_MAX];
+  ASSERT_TRUE(getcwd(old_cwd, sizeof(old_cwd)) != NULL);
+  ASSERT_EQ(0, chdir(td.dirname));
+  // The temporary directory may itself be reached through a symbolic link.
+  char base[PATH_MAX];
+  ASSERT_TRUE(getcwd(base, sizeof(base)) != NULL);
+
+  ASSERT_EQ(0, mkdir("a", 0700));
+  ASSERT_EQ(0, mkdir("a/b", 0700));
+  int fd = open("a/b/file", O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  ASSERT_EQ(0, symlink("a/b", "link"));
+  ASSERT_EQ(0, symlink("../b/file", "a/b/rel"));
+  ASSERT_EQ(0, symlink("loop", "loop"));
+
+  std::string expected_a = std::string(base) + "/a";
+  std::string expected_file = std::string(base) + "/a/b/file";
+
+  char buf[PATH_MAX];
+  EXPECT_STREQ(expected_file.c_str(), realpath("link/file", buf));
+  EXPECT_STREQ(expected_file.c_str(), realpath("./a/../link/./rel", buf));
+  EXPECT_STREQ(expected_a.c_str(), realpath("link/..", buf));
+  char* p = realpath("link//rel", NULL);
+  EXPECT_STREQ(expected_file.c_str(), p);
+  free(p);
+
+  errno = 0;
+  EXPECT_TRUE(realpath("a/b/file/", buf) == NULL);
+  EXPECT_EQ(ENOTDIR, errno);
+  errno = 0;
+  EXPECT_TRUE(realpath("a/missing", buf) == NULL);
+  EXPECT_EQ(ENOENT, errno);
+  errno = 0;
+  EXPECT_TRUE(realpath("loop", buf) == NULL);
+  EXPECT_EQ(ELOOP, errno);
+
+  ASSERT_EQ(0, unlink("loop"));
+  ASSERT_EQ(0, unlink("a/b/rel"));
+  ASSERT_EQ(0, unlink("link"));
+  ASSERT_EQ(0, unlink("a/b/file"));
+  ASSERT_EQ(0, rmdir("a/b"));
+  ASSERT_EQ(0, rmdir("a"));
+  ASSERT_EQ(0, chdir(old_cwd));
+}
+
 TEST(stdlib, qsort) {
   struct s {
     char name[16];
@@ -138,6 +194,100 @@ TEST(stdlib, qsort) {
   ASSERT_STREQ("charlie", entries[2].name);
 }
 
+template <size_t kSize>
+struct QsortElement {
+  int key;
+  char payload[kSize - sizeof(int)];
+  static int comparator(const void* lhs, const void* rhs) {
+    int l = reinterpret_cast<const QsortElement*>(lhs)->key;
+    int r = reinterpret_cast<const QsortElement*>(rhs)->key;
+    return (l < r) ? -1 : (l > r);
+  }
+};
+
+// Sorts arrays in the patterns that trouble quicksorts, checking that the
+// keys come out in order and each key keeps its payload.
+template <size_t kSize>
+static void DoQsortTest() {
+  const size_t kCount = 2000;
+  QsortElement<kSize>* a = new QsortElement<kSize>[kCount];
+  for (int pattern = 0; pattern < 6; ++pattern) {
+    for (size_t n = 0; n <= kCount; n = (n < 40) ? n + 1 : n * 3) {
+      for (size_t i = 0; i < n; ++i) {
+        switch (pattern) {
+          case 0: a[i].key = random(); break;
+          case 1: a[i].key = i; break;
+          case 2: a[i].key = n - i; break;
+          case 3: a[i].key = i % 3; break;
+          case 4: a[i].key = (i < n / 2) ? i : n - i; break;
+          case 5: a[i].key = (i % 64 == 0) ? random() : i; break;
+        }
+        memset(a[i].payload, a[i].key, sizeof(a[i].payload));
+      }
+      qsort(a, n, kSize, QsortElement<kSize>::comparator);
+      for (size_t i = 0; i < n; ++i) {
+        if (i > 0) {
+          ASSERT_LE(a[i - 1].key, a[i].key) << "size " << kSize << " pattern " << pattern;
+        }
+        ASSERT_EQ(static_cast<char>(a[i].key), a[i].payload[sizeof(a[i].payload) - 1]);
+      }
+    }
+  }
+  delete[] a;
+}
+
+TEST(stdlib, qsort_sizes_and_patterns) {
+  DoQsortTest<8>();
+  DoQsortTest<16>();
+  DoQsortTest<12>();
+  DoQsortTest<40>();
+}
+
+static int qsort_r_compare(const void* lhs, const void* rhs, void* arg) {
+  ++*reinterpret_cast<size_t*>(arg);
+  int l = *reinterpret_cast<const int*>(lhs);
+  int r = *reinterpret_cast<const int*>(rhs);
+  return (l < r) ? -1 : (l > r);
+}
+
+TEST(stdlib, qsort_r) {
+  int a[1000];
+  for (size_t i = 0; i < 1000; ++i) {
+    a[i] = (i * 7919) % 1000;
+  }
+  size_t comparisons = 0;
+  qsort_r(a, 1000, sizeof(int), qsort_r_compare, &comparisons);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(static_cast<int>(i), a[i]);
+  }
+  ASSERT_GT(comparisons, 0U);
+}
+
+static int qsort_random_compare(const void*, const void*) {
+  return static_cast<int>(random() % 3) - 1;
+}
+
+// A comparator that isn't a consistent ordering gets a shuffled array back,
+// but mustn't make qsort touch anything outside it.
+TEST(stdlib, qsort_inconsistent_comparator) {
+  const size_t kCount = 1000;
+  int* buf = new int[kCount + 2];
+  for (int round = 0; round < 100; ++round) {
+    buf[0] = buf[kCount + 1] = -1;
+    for (size_t i = 0; i < kCount; ++i) {
+      buf[i + 1] = i;
+    }
+    qsort(buf + 1, kCount, sizeof(int), qsort_random_compare);
+    ASSERT_EQ(-1, buf[0]);
+    ASSERT_EQ(-1, buf[kCount + 1]);
+    std::sort(buf + 1, buf + kCount + 1);
+    for (size_t i = 0; i < kCount; ++i) {
+      ASSERT_EQ(static_cast<int>(i), buf[i + 1]);
+    }
+  }
+  delete[] buf;
+}
+
 static void* TestBug57421_child(void* arg) {
   pthread_t main_thread = reinterpret_cast<pthread_t>(arg);
   pthread_join(main_thread, NULL);
@@ -162,6 +312,96 @@ TEST(stdlib_DeathTest, getenv_after_main_thread_exits) {
   ASSERT_EXIT(TestBug57421_main(), ::testing::ExitedWithCode(0), "");
 }
 
+// Enough variables for getenv to look them up through an index.
+static const size_t kLargeEnvironmentCount = 200;
+
+TEST(stdlib, getenv_large_environment) {
+  char name[32];
+  char value[32];
+  for (size_t i = 0; i < kLargeEnvironmentCount; ++i) {
+    snprintf(name, sizeof(name), "GETENV_TEST_%zu", i);
+    snprintf(value, sizeof(value), "%zu", i);
+    ASSERT_EQ(0, setenv(name, value, 1));
+  }
+  for (size_t i = 0; i < kLargeEnvironmentCount; ++i) {
+    snprintf(name, sizeof(name), "GETENV_TEST_%zu", i);
+    snprintf(value, sizeof(value), "%zu", i);
+    ASSERT_STREQ(value, getenv(name)) << name;
+  }
+  ASSERT_TRUE(getenv("GETENV_TEST_NONE") == NULL);
+
+  // Every way of changing the environment is seen by the next getenv.
+  ASSERT_EQ(0, setenv("GETENV_TEST_7", "seven", 1));
+  ASSERT_STREQ("seven", getenv("GETENV_TEST_7"));
+  ASSERT_EQ(0, setenv("GETENV_TEST_7", "not this", 0));
+  ASSERT_STREQ("seven", getenv("GETENV_TEST_7"));
+  ASSERT_EQ(0, unsetenv("GETENV_TEST_7"));
+  ASSERT_TRUE(getenv("GETENV_TEST_7") == NULL);
+
+  char putenv_string[] = "GETENV_TEST_PUT=one";
+  ASSERT_EQ(0, putenv(putenv_string));
+  ASSERT_STREQ("one", getenv("GETENV_TEST_PUT"));
+  // The string itself is part of the environment.
+  putenv_string[sizeof(putenv_string) - 2] = 'x';
+  ASSERT_STREQ("onx", getenv("GETENV_TEST_PUT"));
+  ASSERT_EQ(0, unsetenv("GETENV_TEST_PUT"));
+
+  for (size_t i = 0; i < kLargeEnvironmentCount; ++i) {
+    snprintf(name, sizeof(name), "GETENV_TEST_%zu", i);
+    ASSERT_EQ(0, unsetenv(name));
+    ASSERT_TRUE(getenv(name) == NULL) << name;
+  }
+}
+
+TEST(stdlib, getenv_replaced_environ) {
+  char* entries[kLargeEnvironmentCount + 2];
+  char buffers[kLargeEnvironmentCount][32];
+  for (size_t i = 0; i < kLargeEnvironmentCount; ++i) {
+    snprintf(buffers[i], sizeof(buffers[i]), "REPLACED_%zu=%zu", i, i);
+    entries[i] = buffers[i];
+  }
+  char duplicate[] = "REPLACED_1=duplicate";
+  entries[kLargeEnvironmentCount] = duplicate;
+  entries[kLargeEnvironmentCount + 1] = NULL;
+
+  char** old_environ = environ;
+  environ = entries;
+  // The first definition wins.
+  EXPECT_STREQ("1", getenv("REPLACED_1"));
+  EXPECT_STREQ("150", getenv("REPLACED_150"));
+  EXPECT_TRUE(getenv("PATH") == NULL);
+
+  ASSERT_EQ(0, clearenv());
+  EXPECT_TRUE(getenv("REPLACED_1") == NULL);
+  environ = old_environ;
+}
+
+TEST(stdlib, getenv_environ_changed_in_place) {
+  char* entries[kLargeEnvironmentCount + 1];
+  char buffers[kLargeEnvironmentCount][32];
+  for (size_t i = 0; i < kLargeEnvironmentCount; ++i) {
+    snprintf(buffers[i], sizeof(buffers[i]), "IN_PLACE_%zu=%zu", i, i);
+    entries[i] = buffers[i];
+  }
+  entries[kLargeEnvironmentCount] = NULL;
+
+  char** old_environ = environ;
+  environ = entries;
+  EXPECT_STREQ("150", getenv("IN_PLACE_150"));
+
+  // Truncating the array hides the entries after the new end.
+  entries[100] = NULL;
+  EXPECT_TRUE(getenv("IN_PLACE_150") == NULL);
+  EXPECT_STREQ("99", getenv("IN_PLACE_99"));
+
+  // A new entry stored over an old one is found, and the old one isn't.
+  char replacement[] = "IN_PLACE_NEW=new";
+  entries[5] = replacement;
+  EXPECT_STREQ("new", getenv("IN_PLACE_NEW"));
+  EXPECT_TRUE(getenv("IN_PLACE_5") == NULL);
+  environ = old_environ;
+}
+
 TEST(stdlib, mkstemp) {
   TemporaryFile tf;
   struct stat sb;
@@ -187,6 +427,70 @@ TEST(stdlib, system) {
   ASSERT_EQ(1, WEXITSTATUS(status));
 }
 
+#if defined(__BIONIC__)
+static void* ArcRandomFill(void* arg) {
+  arc4random_buf(arg, 64);
+  return NULL;
+}
+#endif
+
+TEST(stdlib, arc4random_threads) {
+#if defined(__BIONIC__)
+  // Each thread has its own generator, and they mustn't share a seed.
+  const size_t kThreads = 8;
+  uint8_t bufs[kThreads][64];
+  pthread_t threads[kThreads];
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, ArcRandomFill, bufs[i]));
+  }
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  uint8_t main_buf[64];
+  arc4random_buf(main_buf, sizeof(main_buf));
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_NE(0, memcmp(main_buf, bufs[i], sizeof(main_buf))) << i;
+    for (size_t j = i + 1; j < kThreads; ++j) {
+      ASSERT_NE(0, memcmp(bufs[i], bufs[j], sizeof(bufs[i]))) << i << " " << j;
+    }
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(stdlib, arc4random_fork) {
+#if defined(__BIONIC__)
+  // Make sure this thread's generator is seeded before the fork.
+  arc4random();
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    uint8_t buf[32];
+    arc4random_buf(buf, sizeof(buf));
+    _exit(write(fds[1], buf, sizeof(buf)) == sizeof(buf) ? 0 : 1);
+  }
+  close(fds[1]);
+
+  uint8_t parent_buf[32];
+  arc4random_buf(parent_buf, sizeof(parent_buf));
+  uint8_t child_buf[32];
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(child_buf)), read(fds[0], child_buf, sizeof(child_buf)));
+  close(fds[0]);
+
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  ASSERT_NE(0, memcmp(parent_buf, child_buf, sizeof(parent_buf)));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(stdlib, atof) {
   ASSERT_DOUBLE_EQ(1.23, atof("1.23"));
 }
@@ -199,10 +503,106 @@ TEST(stdlib, strtof) {
   ASSERT_FLOAT_EQ(1.23, strtof("1.23", NULL));
 }
 
+TEST(stdlib, strtod_correctly_rounded) {
+  char* end;
+  ASSERT_EQ(0.1, strtod("0.1", NULL));
+  ASSERT_EQ(2.2250738585072014e-308, strtod("2.2250738585072014e-308", NULL));
+  ASSERT_EQ(1.7976931348623157e308, strtod("1.7976931348623157e308", NULL));
+  // Halfway between two doubles: ties go to even.
+  ASSERT_EQ(9007199254740992.0, strtod("9007199254740993", NULL));
+  ASSERT_EQ(9007199254740996.0, strtod("9007199254740995", NULL));
+  ASSERT_EQ(-1.5e-3, strtod(" \t-1.5E-3x", &end));
+  ASSERT_EQ('x', *end);
+  // An 'e' with no exponent digits isn't part of the number.
+  const char* s = "12e+";
+  ASSERT_EQ(12.0, strtod(s, &end));
+  ASSERT_EQ(s + 2, end);
+  ASSERT_EQ(0.0, strtod("0.000e99", NULL));
+  ASSERT_TRUE(signbit(strtod("-0.0", NULL)));
+
+  errno = 0;
+  ASSERT_EQ(HUGE_VAL, strtod("1e400", NULL));
+  ASSERT_EQ(ERANGE, errno);
+}
+
+TEST(stdlib, strtof_correctly_rounded) {
+  ASSERT_EQ(0.1f, strtof("0.1", NULL));
+  ASSERT_EQ(16777216.0f, strtof("16777217", NULL));
+  ASSERT_EQ(3.4028235e38f, strtof("3.4028235e38", NULL));
+  ASSERT_EQ(1.17549435e-38f, strtof("1.17549435e-38", NULL));
+  // Rounding the decimal straight to float, not via double.
+  ASSERT_EQ(1.0000001f, strtof("1.00000005960464477550", NULL));
+
+  errno = 0;
+  ASSERT_EQ(HUGE_VALF, strtof("1e39", NULL));
+  ASSERT_EQ(ERANGE, errno);
+}
+
 TEST(stdlib, strtold) {
   ASSERT_DOUBLE_EQ(1.23, strtold("1.23", NULL));
 }
 
+TEST(stdlib, strtol_base10) {
+  char* end;
+  const char* s = "  -12345678901x";
+  ASSERT_EQ(-12345678901LL, strtoll(s, &end, 10));
+  ASSERT_EQ('x', *end);
+  // Leading zeros don't count towards overflow.
+  ASSERT_EQ(12345, strtoll("0000000000000000000000000000000012345", NULL, 10));
+  ASSERT_EQ(1234567812345678LL, strtoll("1234567812345678", NULL, 0));
+  // No digits: endptr is the start of the string, not of the digits.
+  s = " +x";
+  ASSERT_EQ(0, strtol(s, &end, 10));
+  ASSERT_EQ(s, end);
+
+  errno = 0;
+  ASSERT_EQ(LLONG_MAX, strtoll("9223372036854775807", NULL, 10));
+  ASSERT_EQ(LLONG_MIN, strtoll("-9223372036854775808", NULL, 10));
+  ASSERT_EQ(0, errno);
+  s = "9223372036854775808123x";
+  ASSERT_EQ(LLONG_MAX, strtoll(s, &end, 10));
+  ASSERT_EQ(ERANGE, errno);
+  ASSERT_EQ('x', *end);
+  errno = 0;
+  ASSERT_EQ(LLONG_MIN, strtoll("-9223372036854775809", NULL, 10));
+  ASSERT_EQ(ERANGE, errno);
+}
+
+TEST(stdlib, strtoul_base10) {
+  errno = 0;
+  ASSERT_EQ(ULLONG_MAX, strtoull("18446744073709551615", NULL, 10));
+  ASSERT_EQ(0, errno);
+  ASSERT_EQ(ULLONG_MAX, strtoull("18446744073709551616", NULL, 10));
+  ASSERT_EQ(ERANGE, errno);
+  // A minus sign negates the value in the unsigned type.
+  errno = 0;
+  ASSERT_EQ(ULLONG_MAX, strtoull("-1", NULL, 10));
+  ASSERT_EQ(ULONG_MAX, strtoul("-1", NULL, 10));
+  ASSERT_EQ(0, errno);
+}
+
+TEST(stdlib, strtol_other_bases) {
+  char* end;
+  ASSERT_EQ(0x7fL, strtol("0x7f", NULL, 0));
+  ASSERT_EQ(0x7fL, strtol("0X7F", NULL, 16));
+  ASSERT_EQ(077L, strtol("077", NULL, 0));
+  ASSERT_EQ(35L, strtol("z", NULL, 36));
+  const char* s = "1010102";
+  ASSERT_EQ(42L, strtol(s, &end, 2));
+  ASSERT_EQ('2', *end);
+
+  errno = 0;
+  ASSERT_EQ(0, strtol("1", &end, 37));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(stdlib, atoi) {
+  ASSERT_EQ(123, atoi(" 123abc"));
+  ASSERT_EQ(-42, atoi("-42"));
+  ASSERT_EQ(-1234567890123LL, atoll("-1234567890123"));
+  ASSERT_EQ(0, atoi("abc"));
+}
+
 TEST(stdlib, quick_exit) {
   pid_t pid = fork();
   ASSERT_NE(-1, pid) << strerror(errno);
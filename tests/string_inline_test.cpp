@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Before any header can include <string.h>.
+#define _BIONIC_INLINE_SMALL_MEMOPS 1
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+// Check each size either side of the inline limit, at every alignment, against
+// byte-at-a-time reference results. Sizes go through a volatile so that the
+// compiler can't see them.
+
+static const size_t kMaxSize = 80;
+static const size_t kMaxAlign = 16;
+static const size_t kBufSize = kMaxAlign + kMaxSize + kMaxAlign;
+
+TEST(string_inline, memcpy) {
+  char src[kBufSize];
+  for (size_t i = 0; i < kBufSize; ++i) {
+    src[i] = static_cast<char>(i * 7 + 1);
+  }
+  for (size_t align = 0; align < kMaxAlign; ++align) {
+    for (volatile size_t n = 0; n <= kMaxSize; ++n) {
+      char dst[kBufSize];
+      memset(dst, 0xee, sizeof(dst));
+      ASSERT_EQ(dst + align, memcpy(dst + align, src + kMaxAlign - align, n));
+      for (size_t i = 0; i < kBufSize; ++i) {
+        bool copied = i >= align && i < align + n;
+        char expected = copied ? src[kMaxAlign - align + i - align] : static_cast<char>(0xee);
+        ASSERT_EQ(expected, dst[i]) << "align " << align << " size " << n << " at " << i;
+      }
+    }
+  }
+}
+
+TEST(string_inline, memset) {
+  for (size_t align = 0; align < kMaxAlign; ++align) {
+    for (volatile size_t n = 0; n <= kMaxSize; ++n) {
+      char dst[kBufSize];
+      memset(dst, 0xee, sizeof(dst));
+      ASSERT_EQ(dst + align, memset(dst + align, 0x1a5, n));
+      for (size_t i = 0; i < kBufSize; ++i) {
+        bool set = i >= align && i < align + n;
+        char expected = set ? static_cast<char>(0xa5) : static_cast<char>(0xee);
+        ASSERT_EQ(expected, dst[i]) << "align " << align << " size " << n << " at " << i;
+      }
+    }
+  }
+}
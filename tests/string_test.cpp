@@ -19,7 +19,10 @@
 #include <errno.h>
 #include <malloc.h>
 #include <math.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "buffer_tests.h"
 
@@ -794,6 +797,102 @@ TEST(string, memrchr) {
   }
 }
 
+static const char* NaiveMemmem(const char* haystack, size_t n, const char* needle, size_t m) {
+  for (size_t i = 0; m != 0 && i + m <= n; ++i) {
+    if (memcmp(haystack + i, needle, m) == 0) {
+      return haystack + i;
+    }
+  }
+  return NULL;
+}
+
+TEST(string, memmem) {
+  // A small alphabet makes for lots of near misses.
+  char haystack[1024];
+  char needle[64];
+  for (size_t iter = 0; iter < 20000; ++iter) {
+    size_t n = random() % sizeof(haystack);
+    size_t m = 1 + random() % sizeof(needle);
+    int alphabet = 1 + random() % 3;
+    for (size_t i = 0; i < n; ++i) {
+      haystack[i] = "a\xff!"[random() % alphabet];
+    }
+    for (size_t i = 0; i < m; ++i) {
+      needle[i] = "a\xff!"[random() % alphabet];
+    }
+    if (m <= n && (random() & 1) != 0) {
+      memcpy(haystack + random() % (n - m + 1), needle, m);
+    }
+    ASSERT_EQ(NaiveMemmem(haystack, n, needle, m), memmem(haystack, n, needle, m));
+  }
+}
+
+TEST(string, memmem_repetitive) {
+  const size_t n = 64 * 1024;
+  char* haystack = new char[n];
+  memset(haystack, 'a', n);
+  ASSERT_EQ(NULL, memmem(haystack, n, "aaaaaaaaaaaaaaab", 16));
+  ASSERT_EQ(NULL, memmem(haystack, n, "baaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 44));
+  haystack[n - 1] = 'b';
+  ASSERT_EQ(haystack + n - 16, memmem(haystack, n, "aaaaaaaaaaaaaaab", 16));
+  ASSERT_EQ(haystack, memmem(haystack, n, "aaaa", 4));
+  delete[] haystack;
+}
+
+TEST(string, strstr) {
+  ASSERT_STREQ("hello world", strstr("hello world", ""));
+  ASSERT_STREQ("world", strstr("hello world", "world"));
+  ASSERT_STREQ("o world", strstr("hello world", "o"));
+  ASSERT_EQ(NULL, strstr("hello world", "worlds"));
+  ASSERT_EQ(NULL, strstr("", "a"));
+
+  char haystack[512];
+  char needle[48];
+  for (size_t iter = 0; iter < 20000; ++iter) {
+    size_t n = random() % sizeof(haystack);
+    size_t m = random() % sizeof(needle);
+    for (size_t i = 0; i < n; ++i) {
+      haystack[i] = "ab"[random() % 2];
+    }
+    haystack[n] = '\0';
+    for (size_t i = 0; i < m; ++i) {
+      needle[i] = "ab"[random() % 2];
+    }
+    needle[m] = '\0';
+    const char* expected = (m == 0) ? haystack : NaiveMemmem(haystack, n, needle, m);
+    ASSERT_EQ(expected, strstr(haystack, needle));
+  }
+}
+
+// strstr shouldn't read the whole haystack when the match is near the start.
+TEST(string, strstr_unterminated_after_match) {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  char* map = reinterpret_cast<char*>(mmap(NULL, 2 * page_size, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(MAP_FAILED, map);
+  ASSERT_EQ(0, mprotect(map + page_size, page_size, PROT_NONE));
+  memset(map, 'x', page_size);
+  memcpy(map + 16, "needle", 6);
+  ASSERT_EQ(map + 16, strstr(map, "needle"));
+  ASSERT_EQ(map + 16, strstr(map, "xxneedlexxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx") + 2);
+  ASSERT_EQ(0, munmap(map, 2 * page_size));
+}
+
+TEST(string, strcasestr) {
+  ASSERT_STREQ("Hello World", strcasestr("Hello World", ""));
+  ASSERT_STREQ("World", strcasestr("Hello World", "wORLD"));
+  ASSERT_STREQ("lo World", strcasestr("Hello World", "LO w"));
+  ASSERT_EQ(NULL, strcasestr("Hello World", "worlds"));
+
+  char haystack[256];
+  for (size_t i = 0; i < sizeof(haystack) - 1; ++i) {
+    haystack[i] = (i % 2 == 0) ? 'a' : 'A';
+  }
+  haystack[sizeof(haystack) - 1] = '\0';
+  ASSERT_EQ(NULL, strcasestr(haystack, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaab"));
+  ASSERT_EQ(haystack, strcasestr(haystack, "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"));
+}
+
 TEST(string, memcmp) {
   StringTestState<char> state(SMALL);
   for (size_t i = 0; i < state.n; i++) {
@@ -934,6 +1033,37 @@ TEST(string, memmove_cache_size) {
   free(glob_ptr2);
 }
 
+// Bigger than the last level cache of most CPUs, so memcpy and memset use
+// their non-temporal paths.
+TEST(string, memcpy_memset_larger_than_cache) {
+  const size_t len = 64 * 1024 * 1024;
+  char* src = reinterpret_cast<char*>(malloc(len + 64));
+  char* dst = reinterpret_cast<char*>(malloc(len + 64));
+  ASSERT_TRUE(src != NULL);
+  ASSERT_TRUE(dst != NULL);
+
+  for (size_t i = 0; i < len + 64; ++i) {
+    src[i] = static_cast<char>(i * 7);
+  }
+  int alignments[] = {0, 1, 15, 33};
+  for (size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); ++i) {
+    size_t n = len - alignments[i];
+    memset(dst, 0, len + 64);
+    ASSERT_EQ(dst + alignments[i], memcpy(dst + alignments[i], src + 3, n));
+    ASSERT_EQ(0, memcmp(dst + alignments[i], src + 3, n));
+    ASSERT_EQ(0, dst[alignments[i] + n]);
+
+    ASSERT_EQ(dst + alignments[i], memset(dst + alignments[i], 0x5a, n));
+    for (size_t j = 0; j < n; j += 4093) {
+      ASSERT_EQ(0x5a, dst[alignments[i] + j]);
+    }
+    ASSERT_EQ(0x5a, dst[alignments[i] + n - 1]);
+    ASSERT_EQ(0, dst[alignments[i] + n]);
+  }
+  free(src);
+  free(dst);
+}
+
 static void verify_memmove(char* src_copy, char* dst, char* src, size_t size) {
   memset(dst, 0, size);
   memcpy(src, src_copy, size);
@@ -1287,3 +1417,105 @@ TEST(string, strchr_align) {
 TEST(string, strchr_overread) {
   RunSingleBufferOverreadTest(DoStrchrTest);
 }
+
+static void DoStrrchrTest(uint8_t* buf, size_t len) {
+  if (len >= 1) {
+    char value = 32 + (len % 96);
+    char search_value = 33 + (len % 96);
+    memset(buf, value, len - 1);
+    buf[len-1] = '\0';
+    ASSERT_EQ(NULL, strrchr(reinterpret_cast<char*>(buf), search_value));
+    ASSERT_EQ(reinterpret_cast<char*>(&buf[len-1]), strrchr(reinterpret_cast<char*>(buf), '\0'));
+    if (len >= 2) {
+      buf[0] = search_value;
+      ASSERT_EQ(reinterpret_cast<char*>(&buf[0]), strrchr(reinterpret_cast<char*>(buf), search_value));
+      buf[len-2] = search_value;
+      ASSERT_EQ(reinterpret_cast<char*>(&buf[len-2]), strrchr(reinterpret_cast<char*>(buf), search_value));
+    }
+  }
+}
+
+TEST(string, strrchr_align) {
+  RunSingleBufferAlignTest(MEDIUM, DoStrrchrTest);
+}
+
+TEST(string, strrchr_overread) {
+  RunSingleBufferOverreadTest(DoStrrchrTest);
+}
+
+static void DoMemchrTest(uint8_t* buf, size_t len) {
+  if (len >= 1) {
+    int value = len % 128;
+    int search_value = (len % 128) + 1;
+    memset(buf, value, len);
+    ASSERT_EQ(NULL, memchr(buf, search_value, len));
+    ASSERT_EQ(NULL, memrchr(buf, search_value, len));
+    buf[len-1] = search_value;
+    ASSERT_EQ(&buf[len-1], memchr(buf, search_value, len));
+    ASSERT_EQ(&buf[len-1], memrchr(buf, search_value, len));
+    ASSERT_EQ(NULL, memchr(buf, search_value, len - 1));
+    buf[0] = search_value;
+    ASSERT_EQ(&buf[0], memchr(buf, search_value, len));
+    ASSERT_EQ(&buf[len-1], memrchr(buf, search_value, len));
+    ASSERT_EQ(NULL, memrchr(buf + 1, search_value, (len >= 2) ? len - 2 : 0));
+  }
+}
+
+TEST(string, memchr_align) {
+  RunSingleBufferAlignTest(MEDIUM, DoMemchrTest);
+}
+
+TEST(string, memchr_overread) {
+  RunSingleBufferOverreadTest(DoMemchrTest);
+}
+
+static void DoStrnlenTest(uint8_t* buf, size_t len) {
+  if (len >= 1) {
+    memset(buf, (32 + (len % 96)), len - 1);
+    buf[len-1] = '\0';
+    ASSERT_EQ(len-1, strnlen(reinterpret_cast<char*>(buf), len));
+    ASSERT_EQ(len-1, strnlen(reinterpret_cast<char*>(buf), SIZE_MAX));
+    ASSERT_EQ(len/2, strnlen(reinterpret_cast<char*>(buf), len/2));
+  }
+}
+
+TEST(string, strnlen_align) {
+  RunSingleBufferAlignTest(LARGE, DoStrnlenTest);
+}
+
+TEST(string, strnlen_overread) {
+  RunSingleBufferOverreadTest(DoStrnlenTest);
+}
+
+static void DoStrspnTest(uint8_t* buf, size_t len) {
+  if (len >= 1) {
+    memset(buf, 'a' + (len % 3), len - 1);
+    buf[len-1] = '\0';
+    char* s = reinterpret_cast<char*>(buf);
+    ASSERT_EQ(len-1, strspn(s, "abc"));
+    ASSERT_EQ(0U, strcspn(s, "abc"));
+    ASSERT_EQ(len-1, strcspn(s, "xyz"));
+    ASSERT_EQ(len-1, strspn(s, "0123456789abcdefghij"));
+    ASSERT_EQ(NULL, strpbrk(s, "xyz"));
+    if (len >= 2) {
+      buf[len-2] = 'x';
+      ASSERT_EQ(len-2, strspn(s, "abc"));
+      ASSERT_EQ(len-2, strcspn(s, "xyz"));
+      ASSERT_EQ(len-2, strcspn(s, "0123456789xyzXYZ!?"));
+      ASSERT_EQ(&s[len-2], strpbrk(s, "xyz"));
+      buf[len-2] = '\xff';
+      ASSERT_EQ(len-2, strspn(s, "abc"));
+      ASSERT_EQ(len-1, strspn(s, "abc\xff"));
+      ASSERT_EQ(len-2, strcspn(s, "\x80\xff"));
+      ASSERT_EQ(&s[len-2], strpbrk(s, "\xff"));
+    }
+  }
+}
+
+TEST(string, strspn_align) {
+  RunSingleBufferAlignTest(MEDIUM, DoStrspnTest);
+}
+
+TEST(string, strspn_overread) {
+  RunSingleBufferOverreadTest(DoStrspnTest);
+}
@@ -17,6 +17,8 @@
 #include <gtest/gtest.h>
 
 #include <errno.h>
+#include <locale.h>
+#include <string.h>
 #include <strings.h>
 
 TEST(strings, ffs) {
@@ -30,3 +32,62 @@ TEST(strings, ffs) {
   ASSERT_EQ(27, ffs(0x04000000));
   ASSERT_EQ(32, ffs(0x80000000));
 }
+
+TEST(strings, strcasecmp) {
+  ASSERT_EQ(0, strcasecmp("hello", "HELLO"));
+  ASSERT_LT(strcasecmp("hello1", "hello2"), 0);
+  ASSERT_GT(strcasecmp("hello2", "hello1"), 0);
+  ASSERT_GT(strcasecmp("hello", "HELL"), 0);
+  ASSERT_LT(strcasecmp("[", "a"), 0);  // '[' is between 'Z' and 'a'.
+  ASSERT_LT(strcasecmp("\xc0", "\xe0"), 0);  // Only ASCII is folded.
+}
+
+TEST(strings, strncasecmp) {
+  ASSERT_EQ(0, strncasecmp("content-length: 12", "Content-Length", 14));
+  ASSERT_LT(strncasecmp("content-lengsh", "Content-Length", 14), 0);
+  ASSERT_EQ(0, strncasecmp("hello1", "HELLO2", 5));
+  ASSERT_LT(strncasecmp("hello1", "HELLO2", 6), 0);
+  ASSERT_EQ(0, strncasecmp("a", "b", 0));
+}
+
+// Every alignment and length through the first few vectors, with a
+// difference at every position.
+TEST(strings, strcasecmp_strncasecmp_alignment) {
+  const size_t kMaxLen = 100;
+  char buf1[kMaxLen + 64];
+  char buf2[kMaxLen + 64];
+
+  for (size_t align = 0; align < 32; ++align) {
+    for (size_t len = 0; len < kMaxLen; ++len) {
+      char* s1 = buf1 + align;
+      char* s2 = buf2 + (31 - align);
+      for (size_t i = 0; i < len; ++i) {
+        s1[i] = 'a' + (i % 26);
+        s2[i] = 'A' + (i % 26);
+      }
+      s1[len] = s2[len] = '\0';
+      ASSERT_EQ(0, strcasecmp(s1, s2));
+      ASSERT_EQ(0, strncasecmp(s1, s2, len));
+      ASSERT_EQ(0, strncasecmp(s1, s2, kMaxLen));
+
+      for (size_t pos = 0; pos < len; ++pos) {
+        char saved = s1[pos];
+        s1[pos] = '~';
+        ASSERT_GT(strcasecmp(s1, s2), 0);
+        ASSERT_LT(strcasecmp(s2, s1), 0);
+        ASSERT_GT(strncasecmp(s1, s2, pos + 1), 0);
+        ASSERT_EQ(0, strncasecmp(s1, s2, pos));
+        s1[pos] = saved;
+      }
+    }
+  }
+}
+
+TEST(strings, strcasecmp_l) {
+  locale_t l = newlocale(LC_ALL, "C.UTF-8", 0);
+  ASSERT_EQ(0, strcasecmp_l("Host", "HOST", l));
+  ASSERT_GT(strcasecmp_l("hosts", "HOST", l), 0);
+  ASSERT_EQ(0, strncasecmp_l("Hostname", "HOST", 4, l));
+  ASSERT_LT(strncasecmp_l("Hosa", "HOST", 4, l), 0);
+  freelocale(l);
+}
@@ -18,6 +18,7 @@
 
 #include <sys/types.h>
 #include <sys/cdefs.h>
+#include <grp.h>
 #include <pwd.h>
 #include <errno.h>
 #include <limits.h>
@@ -39,6 +40,10 @@ static void check_getpwnam(const char* username, uid_t uid, uid_type_t uid_type)
   ASSERT_TRUE(pwd != NULL);
   ASSERT_EQ(0, errno);
   EXPECT_STREQ(username, pwd->pw_name);
+
+  // A repeated lookup gets the same answer.
+  ASSERT_EQ(pwd, getpwuid(uid));
+  EXPECT_STREQ(username, pwd->pw_name);
   EXPECT_EQ(uid, pwd->pw_uid);
   EXPECT_EQ(uid, pwd->pw_gid);
   ASSERT_EQ(NULL, pwd->pw_passwd);
@@ -111,3 +116,75 @@ TEST(getpwnam, app_id_u1_a0) {
 TEST(getpwnam, app_id_u1_i0) {
   CHECK_GETPWNAM_FOR("u1_i0", 199000, TYPE_APP);
 }
+
+TEST(getpwnam, by_name) {
+#if defined(__BIONIC__)
+  passwd* pwd = getpwnam("radio");
+  ASSERT_TRUE(pwd != NULL);
+  ASSERT_EQ(1001U, pwd->pw_uid);
+
+  pwd = getpwnam("u1_radio");
+  ASSERT_TRUE(pwd != NULL);
+  ASSERT_EQ(101001U, pwd->pw_uid);
+
+  pwd = getpwnam("u2_a1234");
+  ASSERT_TRUE(pwd != NULL);
+  ASSERT_EQ(211234U, pwd->pw_uid);
+  ASSERT_STREQ("/data", pwd->pw_dir);
+
+  pwd = getpwnam("u1_i0");
+  ASSERT_TRUE(pwd != NULL);
+  ASSERT_EQ(199000U, pwd->pw_uid);
+
+  // And that's still what's returned after a getpwuid of something else.
+  ASSERT_TRUE(getpwuid(0) != NULL);
+  pwd = getpwnam("u1_i0");
+  ASSERT_TRUE(pwd != NULL);
+  ASSERT_STREQ("u1_i0", pwd->pw_name);
+  ASSERT_EQ(pwd, getpwuid(199000));
+  ASSERT_STREQ("u1_i0", pwd->pw_name);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(getpwnam, bad_names) {
+#if defined(__BIONIC__)
+  const char* names[] = {
+    "u0_", "u_a1", "x0_a1", "u0_a1x", "u0_no_such_user", "no_such_user",
+    "u1001_a0", "u0_a90000", "u0_i1000", "u0_a18446744073709561616",
+  };
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+    errno = 0;
+    ASSERT_TRUE(getpwnam(names[i]) == NULL) << names[i];
+    ASSERT_EQ(ENOENT, errno) << names[i];
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(getgrnam, groups) {
+#if defined(__BIONIC__)
+  group* grp = getgrgid(1001);
+  ASSERT_TRUE(grp != NULL);
+  ASSERT_STREQ("radio", grp->gr_name);
+  ASSERT_STREQ("radio", grp->gr_mem[0]);
+  ASSERT_TRUE(grp->gr_mem[1] == NULL);
+  ASSERT_EQ(grp, getgrgid(1001));
+
+  grp = getgrnam("system");
+  ASSERT_TRUE(grp != NULL);
+  ASSERT_EQ(1000U, grp->gr_gid);
+
+  grp = getgrgid(10007);
+  ASSERT_TRUE(grp != NULL);
+  ASSERT_STREQ("u0_a7", grp->gr_name);
+
+  grp = getgrnam("u1_a7");
+  ASSERT_TRUE(grp != NULL);
+  ASSERT_EQ(110007U, grp->gr_gid);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
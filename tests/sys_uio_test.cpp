@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "TemporaryFile.h"
+
+TEST(sys_uio, preadv_pwritev) {
+  TemporaryFile tf;
+
+  char buf[] = "world";
+  iovec ios[] = { { buf, 5 } };
+  ASSERT_EQ(5, pwritev(tf.fd, ios, 1, 5));
+  ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_CUR));
+
+  strcpy(buf, "hello");
+  ASSERT_EQ(5, pwritev(tf.fd, ios, 1, 0));
+  ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_CUR));
+
+  char buf1[7];
+  char buf2[3];
+  iovec two[] = { { buf1, 7 }, { buf2, 3 } };
+  ASSERT_EQ(10, preadv(tf.fd, two, 2, 0));
+  ASSERT_EQ(0, memcmp("hellowo", buf1, 7));
+  ASSERT_EQ(0, memcmp("rld", buf2, 3));
+  ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_CUR));
+
+  ASSERT_EQ(-1, preadv(tf.fd, two, 2, -1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(sys_uio, preadv64_pwritev64) {
+  TemporaryFile tf;
+
+  // Beyond 4GiB, so the high half of the offset has to get to the kernel.
+  const off64_t kOffset = 0x100000000LL + 3;
+  char buf[] = "hello";
+  iovec ios[] = { { buf, 5 } };
+  int rc = pwritev64(tf.fd, ios, 1, kOffset);
+  if (rc == -1 && errno == EFBIG) {
+    GTEST_LOG_(INFO) << "This file system can't hold a 4GiB file.\n";
+    return;
+  }
+  ASSERT_EQ(5, rc);
+  ASSERT_EQ(kOffset + 5, lseek64(tf.fd, 0, SEEK_END));
+
+  char in[5];
+  iovec in_ios[] = { { in, 5 } };
+  ASSERT_EQ(5, preadv64(tf.fd, in_ios, 1, kOffset));
+  ASSERT_EQ(0, memcmp("hello", in, 5));
+
+  // Nothing was written at the truncated offset.
+  ASSERT_EQ(0, preadv64(tf.fd, in_ios, 1, kOffset + 5));
+  ASSERT_EQ(5, preadv64(tf.fd, in_ios, 1, 3));
+  ASSERT_EQ(0, memcmp("\0\0\0\0\0", in, 5));
+}
@@ -18,6 +18,7 @@
 #include <sys/wait.h>
 #include <errno.h>
 #include <unistd.h>
+#include <algorithm>
 #include <string>
 
 #if defined(__BIONIC__)
@@ -59,6 +60,9 @@ struct LocalPropertyTestState {
 
         __system_property_set_filename(PROP_FILENAME);
         unlink(pa_filename.c_str());
+        for (int i = 0; i < 16; i++) {
+            unlink((pa_filename + "." + std::to_string(i)).c_str());
+        }
         rmdir(pa_dirname.c_str());
     }
 public:
@@ -221,6 +225,42 @@ TEST(properties, fill) {
 #endif // __BIONIC__
 }
 
+TEST(properties, fill_short_names) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    char prop_name[PROP_NAME_MAX];
+    char prop_value[PROP_VALUE_MAX];
+    char prop_value_ret[PROP_VALUE_MAX];
+    int count = 0;
+
+    // Short names fit more properties in than the index of names holds,
+    // so some are only in the trie.
+    while (true) {
+        snprintf(prop_name, sizeof(prop_name), "p%d", count);
+        snprintf(prop_value, sizeof(prop_value), "v%d", count);
+        if (__system_property_add(prop_name, strlen(prop_name), prop_value, strlen(prop_value)) < 0)
+            break;
+        count++;
+    }
+    ASSERT_GE(count, 768);
+
+    for (int i = 0; i < count; i++) {
+        snprintf(prop_name, sizeof(prop_name), "p%d", i);
+        snprintf(prop_value, sizeof(prop_value), "v%d", i);
+        ASSERT_EQ(static_cast<int>(strlen(prop_value)), __system_property_get(prop_name, prop_value_ret));
+        ASSERT_STREQ(prop_value, prop_value_ret);
+    }
+
+    snprintf(prop_name, sizeof(prop_name), "p%d", count);
+    ASSERT_TRUE(__system_property_find(prop_name) == NULL);
+    ASSERT_TRUE(__system_property_find("p") == NULL);
+    ASSERT_TRUE(__system_property_find("p0.") == NULL);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, foreach) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -238,6 +278,102 @@ TEST(properties, foreach) {
 #endif // __BIONIC__
 }
 
+static void prefix_test_callback(const prop_info *pi, void* cookie) {
+    std::string *names = static_cast<std::string *>(cookie);
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+
+    __system_property_read(pi, name, value);
+    names->append(name);
+    names->append(" ");
+}
+
+static std::string PrefixNames(const char *prefix) {
+    std::string names;
+    EXPECT_EQ(0, __system_property_foreach_prefix(prefix, prefix_test_callback, &names));
+    return names;
+}
+
+TEST(properties, foreach_prefix) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("ro", 2, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.build", 8, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.build.id", 11, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.bu", 5, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.secure", 9, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.a.b", 6, "value", 5));
+    ASSERT_EQ(0, __system_property_add("rom", 3, "value", 5));
+    ASSERT_EQ(0, __system_property_add("net.dns1", 8, "value", 5));
+
+    size_t count = 0;
+    ASSERT_EQ(0, __system_property_foreach_prefix("", foreach_test_callback, &count));
+    ASSERT_EQ(8U, count);
+
+    // Order may change, but the same properties must come back.
+    std::string names = PrefixNames("ro.");
+    ASSERT_EQ(5U, std::count(names.begin(), names.end(), ' ')) << names;
+    ASSERT_EQ(std::string::npos, names.find("ro ")) << names;
+    ASSERT_EQ(std::string::npos, names.find("rom ")) << names;
+
+    names = PrefixNames("ro");
+    ASSERT_EQ(7U, std::count(names.begin(), names.end(), ' ')) << names;
+
+    names = PrefixNames("ro.bu");
+    ASSERT_EQ(3U, std::count(names.begin(), names.end(), ' ')) << names;
+    ASSERT_NE(std::string::npos, names.find("ro.build.id ")) << names;
+
+    ASSERT_EQ("ro.build.id ", PrefixNames("ro.build."));
+    ASSERT_EQ("ro.build.id ", PrefixNames("ro.build.id"));
+    ASSERT_EQ("ro.a.b ", PrefixNames("ro.a"));
+    ASSERT_EQ("net.dns1 ", PrefixNames("n"));
+    ASSERT_EQ("", PrefixNames("ro.build.idx"));
+    ASSERT_EQ("", PrefixNames("sys."));
+    ASSERT_EQ("", PrefixNames("ro..build"));
+    ASSERT_EQ("", PrefixNames(".ro"));
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, snapshot) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("ro.build.id", 11, "abc", 3));
+    ASSERT_EQ(0, __system_property_add("ro.secure", 9, "1", 1));
+    ASSERT_EQ(0, __system_property_add("net.dns1", 8, "", 0));
+
+    char buf[128];
+    size_t needed;
+    ASSERT_EQ(3, __system_property_snapshot("", buf, sizeof(buf), &needed));
+    ASSERT_EQ(12U + 4U + 10U + 2U + 9U + 1U, needed);
+
+    ASSERT_EQ(1, __system_property_snapshot("ro.b", buf, sizeof(buf), &needed));
+    ASSERT_EQ(16U, needed);
+    ASSERT_STREQ("ro.build.id", buf);
+    ASSERT_STREQ("abc", buf + 12);
+
+    ASSERT_EQ(2, __system_property_snapshot("ro.", buf, sizeof(buf), &needed));
+    std::string pairs(buf, needed);
+    ASSERT_NE(std::string::npos, pairs.find(std::string("ro.secure\0001\0", 12)));
+
+    // Too small: nothing past the end is touched, and the caller learns how much is needed.
+    memset(buf, 'x', sizeof(buf));
+    ASSERT_EQ(-1, __system_property_snapshot("", buf, 20, &needed));
+    ASSERT_EQ(38U, needed);
+    ASSERT_EQ('x', buf[20]);
+
+    ASSERT_EQ(0, __system_property_snapshot("sys.", buf, sizeof(buf), &needed));
+    ASSERT_EQ(0U, needed);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, find_nth) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -319,6 +455,52 @@ TEST(properties, fill_hierarchical) {
 #endif // __BIONIC__
 }
 
+TEST(properties, read_handle) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    prop_handle handle = PROP_HANDLE_INIT("property");
+    char propvalue[PROP_VALUE_MAX] = "";
+    unsigned serial = 0;
+
+    // Not there yet.
+    ASSERT_EQ(-1, __system_property_read_handle(&handle, propvalue, &serial));
+    ASSERT_STREQ("", propvalue);
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(1, __system_property_read_handle(&handle, propvalue, &serial));
+    ASSERT_STREQ("value1", propvalue);
+
+    // Unchanged values aren't copied again.
+    strcpy(propvalue, "untouched");
+    ASSERT_EQ(0, __system_property_read_handle(&handle, propvalue, &serial));
+    ASSERT_STREQ("untouched", propvalue);
+
+    // Another reader of the same handle has its own serial.
+    char other_value[PROP_VALUE_MAX] = "";
+    unsigned other_serial = 0;
+    ASSERT_EQ(1, __system_property_read_handle(&handle, other_value, &other_serial));
+    ASSERT_STREQ("value1", other_value);
+
+    prop_info* pi = const_cast<prop_info*>(__system_property_find("property"));
+    ASSERT_EQ(0, __system_property_update(pi, "value2", 6));
+    ASSERT_EQ(1, __system_property_read_handle(&handle, propvalue, &serial));
+    ASSERT_STREQ("value2", propvalue);
+    ASSERT_EQ(__system_property_serial(pi), serial);
+    ASSERT_EQ(0, __system_property_read_handle(&handle, propvalue, &serial));
+
+    // An empty value matches the starting state.
+    prop_handle empty_handle = PROP_HANDLE_INIT("empty");
+    ASSERT_EQ(0, __system_property_add("empty", 5, "", 0));
+    propvalue[0] = '\0';
+    serial = 0;
+    ASSERT_EQ(0, __system_property_read_handle(&empty_handle, propvalue, &serial));
+    ASSERT_STREQ("", propvalue);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, errors) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -385,6 +567,108 @@ TEST(properties, wait) {
 #endif // __BIONIC__
 }
 
+TEST(properties, wait_one) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    pthread_t t;
+    int flag = 0;
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("other", 5, "value1", 6));
+    prop_info *pi = (prop_info *)__system_property_find("property");
+    ASSERT_NE((prop_info *)NULL, pi);
+    prop_info *other = (prop_info *)__system_property_find("other");
+    ASSERT_NE((prop_info *)NULL, other);
+    unsigned int serial = __system_property_serial(pi);
+
+    // Updates to other properties don't count.
+    ASSERT_EQ(0, __system_property_update(other, "value2", 6));
+    unsigned int new_serial = 0;
+    timespec timeout = { 0, 10000000 };
+    ASSERT_EQ(-1, __system_property_wait_timeout(pi, serial, &timeout, &new_serial));
+    ASSERT_EQ(0U, new_serial);
+
+    // An update that's already happened returns straight away.
+    ASSERT_EQ(0, __system_property_update(pi, "value2", 6));
+    ASSERT_EQ(0, __system_property_wait_timeout(pi, serial, &timeout, &new_serial));
+    ASSERT_EQ(__system_property_serial(pi), new_serial);
+    serial = new_serial;
+
+    ASSERT_EQ(0, pthread_create(&t, NULL, PropertyWaitHelperFn, &flag));
+    ASSERT_EQ(flag, 0);
+    new_serial = __system_property_wait(pi, serial);
+    ASSERT_EQ(flag, 1);
+    ASSERT_NE(serial, new_serial);
+    char value[PROP_VALUE_MAX];
+    ASSERT_EQ(6, __system_property_read(pi, NULL, value));
+    ASSERT_STREQ("value3", value);
+
+    void* result;
+    ASSERT_EQ(0, pthread_join(t, &result));
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, partitions) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("ro.secure", 9, "1", 1));
+    ASSERT_EQ(0, __system_property_add_partition("persist."));
+    ASSERT_EQ(0, __system_property_add_partition("persist.sys."));
+    ASSERT_EQ(-1, __system_property_add_partition("persist."));
+    ASSERT_EQ(-1, __system_property_add_partition(""));
+    // It would hide ro.secure.
+    ASSERT_EQ(-1, __system_property_add_partition("ro."));
+
+    // Fill the main area: the partitions still have room.
+    char name[PROP_NAME_MAX];
+    for (int i = 0; ; i++) {
+        snprintf(name, sizeof(name), "property_%d", i);
+        if (__system_property_add(name, strlen(name), "value", 5) < 0) {
+            ASSERT_GT(i, 100);
+            break;
+        }
+    }
+    ASSERT_EQ(0, __system_property_add("persist.a", 9, "value_a", 7));
+    ASSERT_EQ(0, __system_property_add("persist.sys.b", 13, "value_b", 7));
+
+    char value[PROP_VALUE_MAX];
+    ASSERT_EQ(7, __system_property_get("persist.a", value));
+    ASSERT_STREQ("value_a", value);
+    ASSERT_EQ(7, __system_property_get("persist.sys.b", value));
+    ASSERT_STREQ("value_b", value);
+    ASSERT_EQ(1, __system_property_get("ro.secure", value));
+    ASSERT_EQ(0, __system_property_get("persist.sys.c", value));
+
+    ASSERT_EQ("persist.a persist.sys.b ", PrefixNames("persist."));
+    ASSERT_EQ("persist.sys.b ", PrefixNames("persist.sys"));
+    ASSERT_EQ("persist.a persist.sys.b ", PrefixNames("pers"));
+    ASSERT_EQ("ro.secure ", PrefixNames("ro."));
+
+    size_t all = 0;
+    ASSERT_EQ(0, __system_property_foreach(foreach_test_callback, &all));
+    size_t main_count = 0;
+    ASSERT_EQ(0, __system_property_foreach_prefix("property_", foreach_test_callback,
+                                                  &main_count));
+    ASSERT_EQ(main_count + 3, all);
+
+    // Updates in partitions count as updates for __system_property_wait_any.
+    unsigned int serial = __system_property_wait_any(0);
+    prop_info *pi = (prop_info *)__system_property_find("persist.sys.b");
+    ASSERT_NE((prop_info *)NULL, pi);
+    ASSERT_EQ(0, __system_property_update(pi, "value_c", 7));
+    ASSERT_NE(serial, __system_property_wait_any(serial));
+    ASSERT_EQ(7, __system_property_get("persist.sys.b", value));
+    ASSERT_STREQ("value_c", value);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 class KilledByFault {
     public:
         explicit KilledByFault() {};
@@ -25,6 +25,8 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <vector>
+
 #include "ScopedSignalHandler.h"
 
 TEST(time, gmtime) {
@@ -94,6 +96,142 @@ TEST(time, mktime_10310929) {
 #endif
 }
 
+TEST(time, mktime_transitions) {
+  const char* original_tz = getenv("TZ");
+  setenv("TZ", "America/Los_Angeles", 1);
+  tzset();
+
+  struct tm t;
+  memset(&t, 0, sizeof(tm));
+  t.tm_year = 114;
+  t.tm_mon = 5;
+  t.tm_mday = 15;
+  t.tm_hour = 12;
+  t.tm_isdst = -1;
+  ASSERT_EQ(static_cast<time_t>(1402858800), mktime(&t)); // 2014-06-15T19:00:00Z.
+  ASSERT_EQ(1, t.tm_isdst);
+  ASSERT_EQ(0, t.tm_wday);
+
+  // Out-of-range fields are normalized: the day before 2014-03-01 is 02-28.
+  memset(&t, 0, sizeof(tm));
+  t.tm_year = 114;
+  t.tm_mon = 2;
+  t.tm_mday = 0;
+  t.tm_isdst = -1;
+  ASSERT_EQ(static_cast<time_t>(1393574400), mktime(&t)); // 2014-02-28T08:00:00Z.
+  ASSERT_EQ(1, t.tm_mon);
+  ASSERT_EQ(28, t.tm_mday);
+
+  // 01:30 happens twice on 2014-11-02; tm_isdst says which.
+  memset(&t, 0, sizeof(tm));
+  t.tm_year = 114;
+  t.tm_mon = 10;
+  t.tm_mday = 2;
+  t.tm_hour = 1;
+  t.tm_min = 30;
+  t.tm_isdst = 1;
+  ASSERT_EQ(static_cast<time_t>(1414917000), mktime(&t)); // 2014-11-02T08:30:00Z.
+  t.tm_hour = 1;
+  t.tm_min = 30;
+  t.tm_isdst = 0;
+  ASSERT_EQ(static_cast<time_t>(1414920600), mktime(&t)); // 2014-11-02T09:30:00Z.
+
+  if (original_tz != NULL) {
+    setenv("TZ", original_tz, 1);
+  } else {
+    unsetenv("TZ");
+  }
+  tzset();
+}
+
+TEST(time, localtime_r_switching_zones) {
+  // More zones than the parsed-zone cache holds, loaded over and over, and
+  // including the first and last names in the tzdata index.
+  static const struct {
+    const char* name;
+    long gmtoff;
+  } zones[] = {
+    { "Africa/Abidjan", 0 },
+    { "America/Los_Angeles", -8 * 60 * 60 },
+    { "America/New_York", -5 * 60 * 60 },
+    { "Asia/Kolkata", 5 * 60 * 60 + 30 * 60 },
+    { "Asia/Tokyo", 9 * 60 * 60 },
+    { "Australia/Lord_Howe", 11 * 60 * 60 },
+    { "Europe/London", 0 },
+    { "Europe/Paris", 1 * 60 * 60 },
+    { "Pacific/Chatham", 13 * 60 * 60 + 45 * 60 },
+    { "UTC", 0 },
+    { "Zulu", 0 },
+  };
+  const char* original_tz = getenv("TZ");
+  time_t t = 1388534400; // 2014-01-01T00:00:00Z.
+  for (size_t i = 0; i < 3 * sizeof(zones)/sizeof(zones[0]); ++i) {
+    size_t j = (i * 7) % (sizeof(zones)/sizeof(zones[0]));
+    setenv("TZ", zones[j].name, 1);
+    tzset();
+    tm broken_down;
+    ASSERT_TRUE(localtime_r(&t, &broken_down) != NULL);
+    ASSERT_EQ(zones[j].gmtoff, broken_down.tm_gmtoff) << zones[j].name;
+  }
+  if (original_tz != NULL) {
+    setenv("TZ", original_tz, 1);
+  } else {
+    unsetenv("TZ");
+  }
+  tzset();
+}
+
+static void* localtime_r_many_threads_fn(void*) {
+  time_t t = 1388534400; // 2014-01-01T00:00:00Z.
+  for (int i = 0; i < 100000; ++i, t += 15 * 60) {
+    tm broken_down;
+    if (localtime_r(&t, &broken_down) == NULL) {
+      return NULL;
+    }
+    // Paris is UTC+1 in winter and UTC+2 in summer.
+    long gmtoff = broken_down.tm_isdst ? 2 * 60 * 60 : 1 * 60 * 60;
+    time_t local = t + gmtoff;
+    if (broken_down.tm_gmtoff != gmtoff ||
+        broken_down.tm_hour != (local / (60 * 60)) % 24 ||
+        broken_down.tm_min != (local / 60) % 60) {
+      return NULL;
+    }
+  }
+  return reinterpret_cast<void*>(1);
+}
+
+TEST(time, localtime_r_many_threads) {
+  const char* original_tz = getenv("TZ");
+  setenv("TZ", "Europe/Paris", 1);
+  tzset();
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, localtime_r_many_threads_fn, NULL));
+  }
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_TRUE(result != NULL);
+  }
+
+#if defined(__BIONIC__)
+  // bionic's localtime_r notices a change to TZ even without a call to tzset.
+  setenv("TZ", "Asia/Tokyo", 1);
+  time_t t = 1388534400;
+  tm broken_down;
+  ASSERT_TRUE(localtime_r(&t, &broken_down) != NULL);
+  ASSERT_EQ(9 * 60 * 60, broken_down.tm_gmtoff);
+#endif
+
+  if (original_tz != NULL) {
+    setenv("TZ", original_tz, 1);
+  } else {
+    unsetenv("TZ");
+  }
+  tzset();
+}
+
 TEST(time, strftime) {
   setenv("TZ", "UTC", 1);
 
@@ -114,6 +252,25 @@ TEST(time, strftime) {
   // Date and time as text.
   EXPECT_EQ(24U, strftime(buf, sizeof(buf), "%c", &t));
   EXPECT_STREQ("Sun Mar 10 00:00:00 2100", buf);
+
+  // Numeric fields, with and without padding.
+  t.tm_hour = 7;
+  t.tm_min = 5;
+  t.tm_sec = 9;
+  t.tm_yday = 68;
+  EXPECT_EQ(19U, strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &t));
+  EXPECT_STREQ("2100-03-10T07:05:09", buf);
+  EXPECT_EQ(12U, strftime(buf, sizeof(buf), "%j|%k|%e|%l", &t));
+  EXPECT_STREQ("069| 7|10| 7", buf);
+#if defined(__BIONIC__)
+  EXPECT_EQ(7U, strftime(buf, sizeof(buf), "%-j|%-H|%_M", &t));
+  EXPECT_STREQ("69|7| 5", buf);
+#endif
+
+  // Years after 9999.
+  t.tm_year = 12345 - 1900;
+  EXPECT_EQ(5U, strftime(buf, sizeof(buf), "%Y", &t));
+  EXPECT_STREQ("12345", buf);
 }
 
 TEST(time, strptime) {
@@ -133,6 +290,39 @@ TEST(time, strptime) {
   EXPECT_STREQ("09:41:53", buf);
 }
 
+TEST(time, strptime_iso8601) {
+  struct tm t;
+  memset(&t, 0, sizeof(t));
+  const char* s = "2014-01-05T12:34:56Z";
+  ASSERT_EQ(s + 19, strptime(s, "%Y-%m-%dT%H:%M:%S", &t));
+  EXPECT_EQ(114, t.tm_year);
+  EXPECT_EQ(0, t.tm_mon);
+  EXPECT_EQ(5, t.tm_mday);
+  EXPECT_EQ(12, t.tm_hour);
+  EXPECT_EQ(34, t.tm_min);
+  EXPECT_EQ(56, t.tm_sec);
+
+  memset(&t, 0, sizeof(t));
+  s = "1999-12-31 23:59:60";
+  ASSERT_EQ(s + 19, strptime(s, "%Y-%m-%d %H:%M:%S", &t));
+  EXPECT_EQ(99, t.tm_year);
+  EXPECT_EQ(11, t.tm_mon);
+  EXPECT_EQ(60, t.tm_sec);
+
+  // Fields that aren't full width still parse.
+  memset(&t, 0, sizeof(t));
+  s = "2014-1-5T2:3:4";
+  ASSERT_EQ(s + 14, strptime(s, "%Y-%m-%dT%H:%M:%S", &t));
+  EXPECT_EQ(0, t.tm_mon);
+  EXPECT_EQ(5, t.tm_mday);
+  EXPECT_EQ(4, t.tm_sec);
+
+  // Out-of-range fields and truncated input don't.
+  ASSERT_EQ(NULL, strptime("2014-13-05T12:34:56", "%Y-%m-%dT%H:%M:%S", &t));
+  ASSERT_EQ(NULL, strptime("2014-01-05T24:00:00", "%Y-%m-%dT%H:%M:%S", &t));
+  ASSERT_EQ(NULL, strptime("2014-01-05T12:34", "%Y-%m-%dT%H:%M:%S", &t));
+}
+
 void SetTime(timer_t t, time_t value_s, time_t value_ns, time_t interval_s, time_t interval_ns) {
   itimerspec ts;
   ts.it_value.tv_sec = value_s;
@@ -396,8 +586,34 @@ TEST(time, timer_delete_from_timer_thread) {
   while (!tdd.complete && (time(NULL) - cur_time) < 5);
   ASSERT_TRUE(tdd.complete);
 
+  ASSERT_FALSE(pthread_equal(pthread_self(), tdd.thread_id));
+}
+
+TEST(time, timer_delete_from_timer_thread_with_attributes) {
+  TimerDeleteData tdd;
+  sigevent_t se;
+
+  // A timer with thread attributes gets a thread of its own.
+  pthread_attr_t attributes;
+  ASSERT_EQ(0, pthread_attr_init(&attributes));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attributes, 128 * 1024));
+
+  memset(&se, 0, sizeof(se));
+  se.sigev_notify = SIGEV_THREAD;
+  se.sigev_notify_function = TimerDeleteCallback;
+  se.sigev_notify_attributes = &attributes;
+  se.sigev_value.sival_ptr = &tdd;
+
+  tdd.complete = false;
+  ASSERT_EQ(0, timer_create(CLOCK_REALTIME, &se, &tdd.timer_id));
+  SetTime(tdd.timer_id, 0, 1, 0, 0);
+
+  time_t cur_time = time(NULL);
+  while (!tdd.complete && (time(NULL) - cur_time) < 5);
+  ASSERT_TRUE(tdd.complete);
+
 #if defined(__BIONIC__)
-  // Since bionic timers are implemented by creating a thread to handle the
+  // Since bionic implements such a timer by creating a thread to handle the
   // callback, verify that the thread actually completes.
   cur_time = time(NULL);
   while (pthread_detach(tdd.thread_id) != ESRCH && (time(NULL) - cur_time) < 5);
@@ -405,6 +621,39 @@ TEST(time, timer_delete_from_timer_thread) {
 #endif
 }
 
+static volatile int timer_create_many_count;
+
+static void CountManyNotifyFunction(sigval_t) {
+  __sync_fetch_and_add(&timer_create_many_count, 1);
+}
+
+TEST(time, timer_create_many_SIGEV_THREAD) {
+  // Far more timers than a process could have threads if each needed one.
+  const size_t timer_count = 1000;
+  std::vector<timer_t> timers(timer_count);
+
+  sigevent_t se;
+  memset(&se, 0, sizeof(se));
+  se.sigev_notify = SIGEV_THREAD;
+  se.sigev_notify_function = CountManyNotifyFunction;
+
+  timer_create_many_count = 0;
+  for (size_t i = 0; i < timer_count; ++i) {
+    ASSERT_EQ(0, timer_create(CLOCK_MONOTONIC, &se, &timers[i]));
+  }
+  for (size_t i = 0; i < timer_count; ++i) {
+    SetTime(timers[i], 0, 1, 0, 0);
+  }
+
+  time_t cur_time = time(NULL);
+  while (timer_create_many_count < static_cast<int>(timer_count) && (time(NULL) - cur_time) < 5);
+  ASSERT_EQ(static_cast<int>(timer_count), timer_create_many_count);
+
+  for (size_t i = 0; i < timer_count; ++i) {
+    ASSERT_EQ(0, timer_delete(timers[i]));
+  }
+}
+
 TEST(time, clock_gettime) {
   // Try to ensure that our vdso clock_gettime is working.
   timespec ts1;
@@ -423,6 +672,36 @@ TEST(time, clock_gettime) {
   // Should be less than (a very generous, to try to avoid flakiness) 1000000ns.
   ASSERT_EQ(0, ts2.tv_sec);
   ASSERT_LT(ts2.tv_nsec, 1000000);
+
+  // Errors come back in errno, vdso or not.
+  errno = 0;
+  ASSERT_EQ(-1, clock_gettime(-1, &ts1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(time, clock_getres) {
+  timespec res1;
+  ASSERT_EQ(0, clock_getres(CLOCK_MONOTONIC, &res1));
+  timespec res2;
+  ASSERT_EQ(0, syscall(__NR_clock_getres, CLOCK_MONOTONIC, &res2));
+  ASSERT_EQ(res2.tv_sec, res1.tv_sec);
+  ASSERT_EQ(res2.tv_nsec, res1.tv_nsec);
+
+  errno = 0;
+  ASSERT_EQ(-1, clock_getres(-1, &res1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(time, time) {
+  // time reads the coarse clock, so it can only lag the syscall by a tick.
+  time_t t1;
+  time_t t2 = time(&t1);
+  ASSERT_EQ(t1, t2);
+  timespec ts;
+  ASSERT_EQ(0, syscall(__NR_clock_gettime, CLOCK_REALTIME, &ts));
+  ASSERT_LE(t1, ts.tv_sec);
+  ASSERT_GE(t1, ts.tv_sec - 1);
+  ASSERT_LE(t1, time(NULL));
 }
 
 // Test to verify that disarming a repeatable timer disables the
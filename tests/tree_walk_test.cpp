@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+#include <android/tree_walk.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include "TemporaryFile.h"
+
+#if defined(__BIONIC__)
+struct WalkResults {
+  pthread_mutex_t lock;
+  std::map<std::string, unsigned char> types;
+  std::string skip;
+  std::string stop;
+  bool saw_stat;
+};
+
+static int Record(const android_walk_entry* entry, void* cookie) {
+  WalkResults* results = reinterpret_cast<WalkResults*>(cookie);
+  pthread_mutex_lock(&results->lock);
+  results->types[entry->path] = entry->type;
+  if (entry->st != NULL) {
+    results->saw_stat = true;
+  }
+  pthread_mutex_unlock(&results->lock);
+  if (results->stop == entry->name) {
+    return 42;
+  }
+  return (results->skip == entry->name) ? ANDROID_WALK_SKIP : 0;
+}
+
+static int RemoveEntry(const char* path, const struct stat*, int, struct FTW*) {
+  return remove(path);
+}
+
+// Makes a tree of 'width' directories, each with 'width' files and a
+// directory of 'width' files.
+static void MakeTree(const std::string& root, int width) {
+  for (int i = 0; i < width; ++i) {
+    std::string dir = root + "/d" + std::to_string(i);
+    ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+    ASSERT_EQ(0, mkdir((dir + "/sub").c_str(), 0755));
+    for (int j = 0; j < width; ++j) {
+      close(open((dir + "/f" + std::to_string(j)).c_str(), O_CREAT | O_WRONLY, 0644));
+      close(open((dir + "/sub/f" + std::to_string(j)).c_str(), O_CREAT | O_WRONLY, 0644));
+    }
+  }
+  // Not to be followed.
+  ASSERT_EQ(0, symlink(root.c_str(), (root + "/loop").c_str()));
+}
+#endif
+
+TEST(tree_walk, android_walk_tree) {
+#if defined(__BIONIC__)
+  TemporaryDir td;
+  std::string root(td.dirname);
+  const int kWidth = 20;
+  MakeTree(root, kWidth);
+
+  WalkResults results;
+  pthread_mutex_init(&results.lock, NULL);
+  results.saw_stat = false;
+  ASSERT_EQ(0, android_walk_tree(td.dirname, 0, Record, &results));
+
+  // The root, the link, and per directory itself, its subdirectory and their files.
+  ASSERT_EQ(2U + kWidth * (2 + 2 * kWidth), results.types.size());
+  ASSERT_EQ(DT_DIR, results.types[root]);
+  ASSERT_EQ(DT_LNK, results.types[root + "/loop"]);
+  ASSERT_EQ(DT_DIR, results.types[root + "/d3/sub"]);
+  ASSERT_EQ(DT_REG, results.types[root + "/d3/sub/f7"]);
+  ASSERT_FALSE(results.saw_stat);
+
+  // Stats if asked, and skips what it's told to.
+  results.types.clear();
+  results.skip = "sub";
+  ASSERT_EQ(0, android_walk_tree(td.dirname, ANDROID_WALK_STAT, Record, &results));
+  ASSERT_EQ(2U + kWidth * (2 + kWidth), results.types.size());
+  ASSERT_TRUE(results.saw_stat);
+
+  // Stops when it's told to, with what it was told.
+  results.types.clear();
+  results.skip.clear();
+  results.stop = "d0";
+  ASSERT_EQ(42, android_walk_tree(td.dirname, 0, Record, &results));
+  ASSERT_LT(results.types.size(), 2U + kWidth * (2 + 2 * kWidth));
+
+  // A file is just visited.
+  results.types.clear();
+  results.stop.clear();
+  ASSERT_EQ(0, android_walk_tree((root + "/d0/f0").c_str(), 0, Record, &results));
+  ASSERT_EQ(1U, results.types.size());
+
+  errno = 0;
+  ASSERT_EQ(-1, android_walk_tree((root + "/missing").c_str(), 0, Record, &results));
+  ASSERT_EQ(ENOENT, errno);
+
+  ASSERT_EQ(0, nftw(td.dirname, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
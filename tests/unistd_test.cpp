@@ -22,6 +22,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -31,6 +32,40 @@ TEST(unistd, sysconf_SC_MONOTONIC_CLOCK) {
   ASSERT_GT(sysconf(_SC_MONOTONIC_CLOCK), 0);
 }
 
+TEST(unistd, sysconf_SC_NPROCESSORS) {
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  ASSERT_GE(online, 1);
+  ASSERT_LE(online, sysconf(_SC_NPROCESSORS_CONF));
+  // Asking again soon after must not cost (or change) anything.
+  ASSERT_EQ(online, sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+static long MemInfoPages(const char* pattern) {
+  FILE* fp = fopen("/proc/meminfo", "re");
+  long result = -1;
+  char line[256];
+  while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+    long kb;
+    if (sscanf(line, pattern, &kb) == 1) {
+      result = kb / (sysconf(_SC_PAGE_SIZE) / 1024);
+      break;
+    }
+  }
+  if (fp != NULL) {
+    fclose(fp);
+  }
+  return result;
+}
+
+TEST(unistd, sysconf_SC_PHYS_PAGES) {
+  long pages = sysconf(_SC_PHYS_PAGES);
+  ASSERT_GT(pages, 0);
+  ASSERT_EQ(MemInfoPages("MemTotal: %ld kB"), pages);
+
+  ASSERT_GT(sysconf(_SC_AVPHYS_PAGES), 0);
+  ASSERT_LE(sysconf(_SC_AVPHYS_PAGES), pages);
+}
+
 static void* get_brk() {
   return sbrk(0);
 }
@@ -462,3 +497,57 @@ TEST(unistd, getpid_caching_and_pthread_create) {
   ASSERT_EQ(0, pthread_join(t, &result));
   ASSERT_EQ(NULL, result);
 }
+
+#if defined(__BIONIC__)
+static void AssertGetTidCorrect() {
+  pid_t gettid_syscall_result = syscall(__NR_gettid);
+  for (size_t i = 0; i < 128; ++i) {
+    ASSERT_EQ(gettid_syscall_result, gettid());
+  }
+}
+
+static void* GetTidCachingPthreadStartRoutine(void*) {
+  AssertGetTidCorrect();
+  return NULL;
+}
+#endif // __BIONIC__
+
+TEST(unistd, gettid_caching_and_fork) {
+#if defined(__BIONIC__)
+  AssertGetTidCorrect();
+
+  pid_t fork_result = fork();
+  ASSERT_NE(fork_result, -1);
+  if (fork_result == 0) {
+    // We're the child.
+    AssertGetTidCorrect();
+    ASSERT_EQ(getpid(), gettid());
+    _exit(123);
+  }
+
+  AssertGetTidCorrect();
+  int status;
+  ASSERT_EQ(fork_result, waitpid(fork_result, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(123, WEXITSTATUS(status));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(unistd, gettid_caching_and_pthread_create) {
+#if defined(__BIONIC__)
+  pid_t parent_tid = gettid();
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, GetTidCachingPthreadStartRoutine, NULL));
+
+  ASSERT_EQ(parent_tid, gettid());
+
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(NULL, result);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -20,6 +20,9 @@
 #include <limits.h>
 #include <locale.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
 TEST(wchar, sizeof_wchar_t) {
@@ -489,3 +492,139 @@ TEST(wchar, mbrtowc_15439554) {
   EXPECT_EQ(4U, n);
   EXPECT_EQ(L'𤭢', wc);
 }
+
+TEST(wchar, open_wmemstream) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  wchar_t* buf = NULL;
+  size_t size = 0;
+  FILE* fp = open_wmemstream(&buf, &size);
+  ASSERT_TRUE(fp != NULL);
+
+  const wchar_t* s = L"héllo 世界 \U0001f600!";
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_GE(fputws(s, fp), 0);
+  }
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(1000 * wcslen(s), size);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(0, wmemcmp(s, buf + i * wcslen(s), wcslen(s)));
+  }
+  ASSERT_EQ(L'\0', buf[size]);
+
+  // Positions count wide characters.
+  ASSERT_EQ(0, fseek(fp, 1, SEEK_SET));
+  ASSERT_EQ(static_cast<wint_t>(L'É'), fputwc(L'É', fp));
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ(2U, size);
+  ASSERT_EQ(L'É', buf[1]);
+  free(buf);
+}
+
+// Every alignment and length through the first few vectors, with the
+// interesting character at every position.
+TEST(wchar, wcs_functions_alignment) {
+  const size_t kMaxLen = 80;
+  wchar_t buf1[kMaxLen + 16];
+  wchar_t buf2[kMaxLen + 16];
+  wchar_t dst[kMaxLen + 16];
+
+  for (size_t align = 0; align < 8; ++align) {
+    for (size_t len = 0; len < kMaxLen; ++len) {
+      wchar_t* s1 = buf1 + align;
+      wchar_t* s2 = buf2 + (7 - align);
+      for (size_t i = 0; i < len; ++i) {
+        s1[i] = s2[i] = L'a' + (i % 20);
+      }
+      s1[len] = s2[len] = L'\0';
+      s1[len + 1] = s2[len + 1] = L'z';
+
+      ASSERT_EQ(len, wcslen(s1));
+      ASSERT_EQ(len, wcsnlen(s1, kMaxLen));
+      ASSERT_EQ(len / 2, wcsnlen(s1, len / 2));
+      ASSERT_EQ(s1 + len, wcschr(s1, L'\0'));
+      ASSERT_EQ(NULL, wcschr(s1, L'z'));
+      ASSERT_EQ(0, wcscmp(s1, s2));
+      ASSERT_EQ(0, wcsncmp(s1, s2, kMaxLen));
+      ASSERT_EQ(0, wmemcmp(s1, s2, len));
+      ASSERT_EQ(NULL, wmemchr(s1, L'z', len));
+      ASSERT_EQ(s1 + len, wmemchr(s1, L'\0', len + 1));
+      ASSERT_EQ(dst, wcscpy(dst, s1));
+      ASSERT_EQ(0, wmemcmp(dst, s1, len + 1));
+
+      for (size_t pos = 0; pos < len; ++pos) {
+        s1[pos] = L'z';
+        ASSERT_EQ(s1 + pos, wcschr(s1, L'z'));
+        ASSERT_EQ(s1 + pos, wmemchr(s1, L'z', len));
+        ASSERT_EQ(NULL, wmemchr(s1, L'z', pos));
+        ASSERT_GT(wcscmp(s1, s2), 0);
+        ASSERT_LT(wcscmp(s2, s1), 0);
+        ASSERT_GT(wcsncmp(s1, s2, pos + 1), 0);
+        ASSERT_EQ(0, wcsncmp(s1, s2, pos));
+        ASSERT_EQ(1, wmemcmp(s1, s2, len));
+        ASSERT_EQ(-1, wmemcmp(s2, s1, len));
+        ASSERT_EQ(0, wmemcmp(s1, s2, pos));
+        s1[pos] = L'\0';
+        ASSERT_EQ(pos, wcslen(s1));
+        ASSERT_EQ(pos, wcsnlen(s1, len));
+        ASSERT_LT(wcscmp(s1, s2), 0);
+        s1[pos] = s2[pos];
+      }
+    }
+  }
+}
+
+// Long runs of ASCII between multibyte characters, at every alignment, and
+// with the output buffer running out in the middle of a run.
+TEST(wchar, mbsrtowcs_wcsrtombs_ascii_runs) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  char mbs[128];
+  wchar_t wcs[128];
+  char back[128];
+  for (size_t align = 0; align < 16; ++align) {
+    char* s = mbs + align;
+    memset(s, 'a', 80);
+    memcpy(s + 40, "\xe2\x82\xac", 3);  // €
+    memcpy(s + 60, "\xc2\xa2", 2);  // ¢
+    s[80] = '\0';
+
+    const char* src = s;
+    mbstate_t ps = {};
+    ASSERT_EQ(77U, mbsrtowcs(wcs, &src, 128, &ps));
+    ASSERT_EQ(NULL, src);
+    ASSERT_EQ(L'a', wcs[39]);
+    ASSERT_EQ(L'€', wcs[40]);
+    ASSERT_EQ(L'a', wcs[41]);
+    ASSERT_EQ(L'¢', wcs[58]);
+    ASSERT_EQ(L'a', wcs[76]);
+    ASSERT_EQ(L'\0', wcs[77]);
+
+    src = s;
+    ASSERT_EQ(30U, mbsrtowcs(wcs, &src, 30, &ps));
+    ASSERT_EQ(s + 30, src);
+
+    const wchar_t* wsrc = wcs;
+    ASSERT_EQ(80U, wcsrtombs(NULL, &wsrc, 0, &ps));
+    ASSERT_EQ(80U, wcsrtombs(back, &wsrc, sizeof(back), &ps));
+    ASSERT_EQ(NULL, wsrc);
+    ASSERT_STREQ(s, back);
+
+    wsrc = wcs;
+    ASSERT_EQ(40U, wcsrtombs(back, &wsrc, 42, &ps));
+    ASSERT_EQ(wcs + 40, wsrc);
+  }
+
+  // A bad byte after a run of ASCII.
+  memset(mbs, 'a', 64);
+  mbs[50] = '\xff';
+  mbs[64] = '\0';
+  const char* src = mbs;
+  mbstate_t ps = {};
+  errno = 0;
+  ASSERT_EQ(static_cast<size_t>(-1), mbsrtowcs(wcs, &src, 128, &ps));
+  ASSERT_EQ(EILSEQ, errno);
+  ASSERT_EQ(mbs + 50, src);
+}